@@ -135,6 +135,12 @@
     }];
 }
 
+- (id)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path resumingFrom:(id)cursor maxPaths:(NSUInteger)maxPaths {
+    // The mock prunes everything at once
+    [self pruneCache:pruneForest atPath:path];
+    return nil;
+}
+
 - (NSArray *)loadTrackedQueries {
     return self.trackedQueries.allValues;
 }
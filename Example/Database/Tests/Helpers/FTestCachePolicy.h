@@ -24,4 +24,6 @@
 
 - (void)pruneOnNextCheck;
 
+@property (nonatomic) NSUInteger maxPathsToPrunePerUpdate;
+
 @end
@@ -138,4 +138,27 @@ static FCompoundHashSplitStrategy NEVER_SPLIT_STRATEGY = ^BOOL(FCompoundHashBuil
     XCTAssertEqualWithAccuracy(hash1M.hashes.count, 150, 10);
 }
 
+- (void)testCachedSubtreesHashLikeFreshOnes {
+    NSMutableDictionary *dict = [NSMutableDictionary dictionary];
+    for (int i = 0; i < 200; i++) {
+        dict[[NSString stringWithFormat:@"user%d", i]] = @{@"name": @"value", @"age": @(i), @"tags": @{@"a": @YES, @".priority": @(i)}};
+    }
+    id<FNode> node = NODE(dict);
+
+    FCompoundHash *first = [FCompoundHash fromNode:node];
+    XCTAssertGreaterThan(first.hashes.count, 2);
+    FCompoundHash *second = [FCompoundHash fromNode:node];
+    XCTAssertEqualObjects(second.posts, first.posts);
+    XCTAssertEqualObjects(second.hashes, first.hashes);
+
+    // Untouched subtrees keep their cached representation after a write
+    id<FNode> updated = [node updateChild:PATH(@"user42/name") withNewChild:NODE(@"other")];
+    dict[@"user42"] = @{@"name": @"other", @"age": @42, @"tags": @{@"a": @YES, @".priority": @42}};
+    FCompoundHash *updatedHash = [FCompoundHash fromNode:updated];
+    FCompoundHash *freshHash = [FCompoundHash fromNode:NODE(dict)];
+    XCTAssertEqualObjects(updatedHash.posts, freshHash.posts);
+    XCTAssertEqualObjects(updatedHash.hashes, freshHash.hashes);
+    XCTAssertNotEqualObjects(updatedHash.hashes, first.hashes);
+}
+
 @end
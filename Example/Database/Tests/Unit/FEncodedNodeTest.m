@@ -0,0 +1,122 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+
+#import "FEncodedNode.h"
+#import "FEmptyNode.h"
+#import "FLeafNode.h"
+#import "FSnapshotUtilities.h"
+#import "FTestHelpers.h"
+
+@interface FEncodedNodeTest : XCTestCase
+
+@end
+
+@implementation FEncodedNodeTest
+
+- (NSDictionary *)sampleValue {
+    return @{
+        @"string": @"héllo",
+        @"integer": @(-9007199254740993LL),
+        @"double": @2.2e-308,
+        @"true": @YES,
+        @"false": @NO,
+        @"withPriority": @{ @".value": @"leaf", @".priority": @42 },
+        @"nested": @{
+            @".priority": @"p",
+            @"10": @"ten",
+            @"9": @"nine",
+            @"a": @{ @"b": @{ @"c": @1.5 } }
+        }
+    };
+}
+
+- (void)testNodesRoundTrip {
+    id<FNode> node = [FSnapshotUtilities nodeFrom:[self sampleValue]];
+    id<FNode> decoded = [FEncodedNode nodeWithEncodedData:[FEncodedNode encodedDataForNode:node]];
+
+    XCTAssertTrue([decoded isKindOfClass:[FEncodedNode class]]);
+    XCTAssertEqualObjects(decoded, node);
+    XCTAssertEqualObjects([decoded valForExport:YES], [node valForExport:YES]);
+    XCTAssertEqualObjects([decoded dataHash], [node dataHash]);
+    XCTAssertEqual(decoded.hash, node.hash);
+}
+
+- (void)testValuesDecodeLikeNodeFrom {
+    NSDictionary *value = [self sampleValue];
+    XCTAssertEqualObjects([FEncodedNode nodeWithValue:value], [FSnapshotUtilities nodeFrom:value]);
+    XCTAssertEqualObjects([[FEncodedNode nodeWithValue:value] valForExport:YES],
+                          [[FSnapshotUtilities nodeFrom:value] valForExport:YES]);
+
+    // Null and empty children are left out, like nodeFrom does
+    NSDictionary *sparse = @{ @"a": [NSNull null], @"b": @{}, @"c": @{ @"d": [NSNull null] }, @"e": @5 };
+    XCTAssertEqualObjects([FEncodedNode nodeWithValue:sparse], [FSnapshotUtilities nodeFrom:sparse]);
+    XCTAssertEqual([[FEncodedNode nodeWithValue:sparse] numChildren], 1);
+
+    NSArray *array = @[ @"zero", [NSNull null], @"two" ];
+    XCTAssertEqualObjects([FEncodedNode nodeWithValue:array], [FSnapshotUtilities nodeFrom:array]);
+}
+
+- (void)testEmptyValuesDecodeToEmptyNode {
+    XCTAssertEqualObjects([FEncodedNode nodeWithValue:nil], [FEmptyNode emptyNode]);
+    XCTAssertEqualObjects([FEncodedNode nodeWithValue:[NSNull null]], [FEmptyNode emptyNode]);
+    XCTAssertEqualObjects([FEncodedNode nodeWithValue:@{}], [FEmptyNode emptyNode]);
+    XCTAssertEqualObjects([FEncodedNode nodeWithValue:@{ @".priority": @1 }], [FEmptyNode emptyNode]);
+    XCTAssertNil([FEncodedNode encodedDataForNode:[FEmptyNode emptyNode]]);
+}
+
+- (void)testLeavesDecodeToLeafNodes {
+    id<FNode> leaf = [FEncodedNode nodeWithValue:@{ @".value": @"leaf", @".priority": @"p" }];
+    XCTAssertTrue([leaf isKindOfClass:[FLeafNode class]]);
+    XCTAssertEqualObjects([leaf val], @"leaf");
+    XCTAssertEqualObjects([[leaf getPriority] val], @"p");
+}
+
+- (void)testChildLookupsDoNotMaterializeChildren {
+    FEncodedNode *node = (FEncodedNode *)[FEncodedNode nodeWithValue:[self sampleValue]];
+    XCTAssertEqual([node numChildren], 7);
+    XCTAssertFalse([node isEmpty]);
+
+    XCTAssertEqualObjects([[node getChild:PATH(@"nested/a/b/c")] val], @1.5);
+    XCTAssertEqualObjects([[node getImmediateChild:@"string"] val], @"héllo");
+    XCTAssertEqualObjects([[node getImmediateChild:@"integer"] val], @(-9007199254740993LL));
+    XCTAssertTrue([node hasChild:@"true"]);
+    XCTAssertFalse([node hasChild:@"missing"]);
+    XCTAssertEqualObjects([[[node getImmediateChild:@"nested"] getPriority] val], @"p");
+
+    NSMutableArray *keys = [NSMutableArray array];
+    [[node getImmediateChild:@"nested"] enumerateChildrenUsingBlock:^(NSString *key, id<FNode> child, BOOL *stop) {
+        [keys addObject:key];
+    }];
+    XCTAssertEqualObjects(keys, (@[ @"9", @"10", @"a" ]));
+    XCTAssertFalse(node.isMaterialized);
+
+    id<FNode> updated = [node updateImmediateChild:@"string" withNewChild:[FSnapshotUtilities nodeFrom:@"bye"]];
+    XCTAssertTrue(node.isMaterialized);
+    XCTAssertEqualObjects([[updated getImmediateChild:@"string"] val], @"bye");
+    XCTAssertEqualObjects([[updated getImmediateChild:@"double"] val], @2.2e-308);
+}
+
+- (void)testEncodedNodesAreReencodedAsIs {
+    NSData *data = [FEncodedNode encodedDataForValue:[self sampleValue]];
+    id<FNode> node = [FEncodedNode nodeWithEncodedData:data];
+    XCTAssertEqualObjects([FEncodedNode encodedDataForNode:node], data);
+    XCTAssertEqualObjects([FEncodedNode encodedDataForNode:[FSnapshotUtilities nodeFrom:[self sampleValue]]], data);
+}
+
+@end
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "FChange.h"
+#import "FChildChangeAccumulator.h"
+#import "FDataEvent.h"
+#import "FEventRegistration.h"
+#import "FIndexedFilter.h"
+#import "FIndexedNode.h"
+#import "FIRDataSnapshot_Private.h"
+#import "FIRDatabaseReference_Private.h"
+#import "FListenProvider.h"
+#import "FPath.h"
+#import "FPathIndex.h"
+#import "FQueryParams.h"
+#import "FQuerySpec.h"
+#import "FSnapshotUtilities.h"
+#import "FSyncTree.h"
+
+// Counts the events raised for it, without firing them.
+@interface FCountingEventRegistration : NSObject<FEventRegistration>
+@property (nonatomic) NSUInteger eventCount;
+@end
+
+@implementation FCountingEventRegistration
+
+- (BOOL) responseTo:(FIRDataEventType)eventType {
+    return YES;
+}
+
+- (FDataEvent *) createEventFrom:(FChange *)change query:(FQuerySpec *)query {
+    self.eventCount++;
+    FIRDatabaseReference *ref = [[FIRDatabaseReference alloc] initWithRepo:nil path:query.path];
+    FIRDataSnapshot *snap = [[FIRDataSnapshot alloc] initWithRef:ref indexedNode:change.indexedNode];
+    return [[FDataEvent alloc] initWithEventType:change.type eventRegistration:self dataSnapshot:snap prevName:change.prevKey];
+}
+
+- (BOOL) matches:(id<FEventRegistration>)other {
+    return other == self;
+}
+
+- (void) fireEvent:(id<FEvent>)event queue:(dispatch_queue_t)queue {
+}
+
+- (FCancelEvent *) createCancelEventFromError:(NSError *)error path:(FPath *)path {
+    return nil;
+}
+
+- (FIRDatabaseHandle) handle {
+    return 0;
+}
+
+@end
+
+@interface FIndexedFilterTests : XCTestCase
+@end
+
+@implementation FIndexedFilterTests
+
+- (NSDictionary *) membersWithCount:(NSUInteger)count changedMember:(NSUInteger)changed score:(NSInteger)score {
+    NSMutableDictionary *members = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSInteger memberScore = (i == changed) ? score : (NSInteger)((i * 7) % count);
+        members[[NSString stringWithFormat:@"member%lu", (unsigned long)i]] = @{@"score": @(memberScore)};
+    }
+    return members;
+}
+
+- (NSArray<NSString *> *) keysInIndexOrder:(FIndexedNode *)node {
+    NSMutableArray<NSString *> *keys = [NSMutableArray array];
+    [node enumerateChildrenReverse:NO usingBlock:^(NSString *key, id<FNode> child, BOOL *stop) {
+        [keys addObject:key];
+    }];
+    return keys;
+}
+
+- (void) testFullNodeUpdateKeepsIndexInOrder {
+    id<FIndex> index = [[FPathIndex alloc] initWithPath:[FPath pathWithString:@"score"]];
+    FIndexedFilter *filter = [[FIndexedFilter alloc] initWithIndex:index];
+
+    NSMutableDictionary *oldData = [[self membersWithCount:50 changedMember:0 score:0] mutableCopy];
+    FIndexedNode *oldSnap = [FIndexedNode indexedNodeWithNode:[FSnapshotUtilities nodeFrom:oldData] index:index];
+    // Sort children of the old node, so that there is an index to carry over.
+    [oldSnap firstChild];
+
+    NSMutableDictionary *newData = [[self membersWithCount:50 changedMember:3 score:100] mutableCopy];
+    [newData removeObjectForKey:@"member10"];
+    newData[@"member99"] = @{@"score": @(-1)};
+    FIndexedNode *newSnap = [FIndexedNode indexedNodeWithNode:[FSnapshotUtilities nodeFrom:newData] index:index];
+
+    FChildChangeAccumulator *accumulator = [[FChildChangeAccumulator alloc] init];
+    FIndexedNode *result = [filter updateFullNode:oldSnap withNewNode:newSnap accumulator:accumulator];
+
+    XCTAssertEqualObjects(result.node, newSnap.node);
+    FIndexedNode *fresh = [FIndexedNode indexedNodeWithNode:newSnap.node index:index];
+    XCTAssertEqualObjects([self keysInIndexOrder:result], [self keysInIndexOrder:fresh]);
+
+    NSMutableDictionary<NSString *, NSNumber *> *changeTypes = [NSMutableDictionary dictionary];
+    for (FChange *change in [accumulator changes]) {
+        changeTypes[change.childKey] = @(change.type);
+    }
+    NSDictionary *expected = @{
+        @"member3": @(FIRDataEventTypeChildChanged),
+        @"member10": @(FIRDataEventTypeChildRemoved),
+        @"member99": @(FIRDataEventTypeChildAdded)
+    };
+    XCTAssertEqualObjects(changeTypes, expected);
+}
+
+- (void) testPerformanceOfOverwritesWithManyListeners {
+    FListenProvider *listenProvider = [[FListenProvider alloc] init];
+    listenProvider.startListening = ^(FQuerySpec *query, NSNumber *tagId, id<FSyncTreeHash> hash, fbt_nsarray_nsstring onComplete) {
+        return @[];
+    };
+    listenProvider.stopListening = ^(FQuerySpec *query, NSNumber *tagId) {
+    };
+    FSyncTree *syncTree = [[FSyncTree alloc] initWithListenProvider:listenProvider];
+
+    const NSUInteger roomCount = 20;
+    const NSUInteger memberCount = 200;
+    NSMutableDictionary *rooms = [NSMutableDictionary dictionary];
+    for (NSUInteger i = 0; i < roomCount; i++) {
+        rooms[[NSString stringWithFormat:@"room%lu", (unsigned long)i]] =
+            [self membersWithCount:memberCount changedMember:0 score:0];
+    }
+    FPath *roomsPath = [FPath pathWithString:@"rooms"];
+    __block id<FNode> data = [FSnapshotUtilities nodeFrom:rooms];
+    [syncTree applyServerOverwriteAtPath:roomsPath newData:data];
+
+    // A listener ordered by key and one ordered by score on every room.
+    id<FIndex> scoreIndex = [[FPathIndex alloc] initWithPath:[FPath pathWithString:@"score"]];
+    NSMutableArray<FCountingEventRegistration *> *registrations = [NSMutableArray array];
+    for (NSUInteger i = 0; i < roomCount; i++) {
+        FPath *roomPath = [roomsPath childFromString:[NSString stringWithFormat:@"room%lu", (unsigned long)i]];
+        for (FQueryParams *params in @[[FQueryParams defaultInstance],
+                                       [[FQueryParams defaultInstance] orderBy:scoreIndex]]) {
+            FCountingEventRegistration *registration = [[FCountingEventRegistration alloc] init];
+            [syncTree addEventRegistration:registration forQuery:[[FQuerySpec alloc] initWithPath:roomPath
+                                                                                           params:params]];
+            [registrations addObject:registration];
+        }
+    }
+
+    __block NSInteger round = 0;
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 50; i++) {
+            // Overwrite all the rooms, with only one member's score changed.
+            round++;
+            NSString *score = [NSString stringWithFormat:@"room%lu/member%lu/score",
+                                                         (unsigned long)(round % roomCount),
+                                                         (unsigned long)(round % memberCount)];
+            data = [data updateChild:[FPath pathWithString:score] withNewChild:[FSnapshotUtilities nodeFrom:@(-round)]];
+            [syncTree applyServerOverwriteAtPath:roomsPath newData:data];
+        }
+    }];
+
+    NSUInteger eventCount = 0;
+    for (FCountingEventRegistration *registration in registrations) {
+        eventCount += registration.eventCount;
+    }
+    XCTAssertGreaterThan(eventCount, (NSUInteger)0);
+}
+
+@end
@@ -24,6 +24,7 @@
 #import "FWriteRecord.h"
 #import "FTestHelpers.h"
 #import "FEmptyNode.h"
+#import "FPruneForest.h"
 
 @interface FLevelDBStorageEngineTests : XCTestCase
 
@@ -433,22 +434,22 @@
     XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], NODE((@{@"deep": @"deep-value"})));
 }
 
-// Well this is awkward, but NSJSONSerialization fails to deserialize JSON with tiny/huge doubles
-// It is kind of bad we raise "invalid" data, but at least we don't crash *trollface*
 - (void)testExtremeDoublesAsServerCache {
-#ifdef TARGET_OS_IOS
-    if ([[NSProcessInfo processInfo] operatingSystemVersion].majorVersion == 11) {
-        // NSJSONSerialization on iOS 11 correctly serializes small and large doubles.
-        return;
-    }
-#endif
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    id<FNode> node = NODE((@{@"tiny": @(2.225073858507201e-308), @"huge": @(1.7976931348623157e308)}));
+    [engine updateServerCache:node atPath:PATH(@"foo") merge:NO];
 
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], node);
+}
+
+- (void)testLeafNodesOfAllTypesArePersisted {
+    id<FNode> node = NODE((@{@"true": @YES, @"false": @NO, @"empty": @"", @"unicode": @"ünï©ødé 🔥",
+                             @"negative": @(-42), @"double": @(-0.5)}));
     FLevelDBStorageEngine *engine = [self cleanStorageEngine];
-    [engine updateServerCache:NODE((@{@"works": @"value", @"fails": @(2.225073858507201e-308)})) atPath:PATH(@"foo") merge:NO];
+    [engine updateServerCache:node atPath:PATH(@"foo") merge:NO];
 
-    // Will drop the tiny double
-    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], NODE(@{@"works": @"value"}));
-    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/fails")], [FEmptyNode emptyNode]);
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], node);
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/unicode")], NODE(@"ünï©ødé 🔥"));
 }
 
 - (void)testLongValuesDontLosePrecision {
@@ -494,8 +495,49 @@
     XCTAssertEqual(CFNumberGetType((CFNumberRef)actualDouble), kCFNumberFloat64Type);
 }
 
-// TODO[offline]: Somehow test estimated server size?
-// TODO[offline]: Test pruning!
+- (void)testEstimatedSizeFollowsServerCacheUpdates {
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    XCTAssertEqual([engine serverCacheEstimatedSizeInBytes], 0);
+
+    // A tag byte per leaf node, followed by 6 bytes for "string" and 8 for each number
+    [engine updateServerCache:SAMPLE_NODE atPath:PATH(@"foo") merge:NO];
+    XCTAssertEqual([engine serverCacheEstimatedSizeInBytes], 26);
+
+    [engine updateServerCache:NODE(@"x") atPath:PATH(@"foo/foo") merge:NO];
+    XCTAssertEqual([engine serverCacheEstimatedSizeInBytes], 20);
+
+    [engine updateServerCache:NODE(@{@"qux": @"abc"}) atPath:PATH(@"foo") merge:YES];
+    XCTAssertEqual([engine serverCacheEstimatedSizeInBytes], 15);
+
+    [engine updateServerCache:NODE(@"leaf") atPath:PATH(@"foo") merge:NO];
+    XCTAssertEqual([engine serverCacheEstimatedSizeInBytes], 5);
+
+    [engine updateServerCache:SAMPLE_NODE atPath:PATH(@"foo/bar") merge:NO];
+    [engine pruneCache:[[FPruneForest empty] prunePath:PATH(@"foo")] atPath:[FPath empty]];
+    XCTAssertEqual([engine serverCacheEstimatedSizeInBytes], 0);
+    XCTAssertEqualObjects([engine serverCacheAtPath:[FPath empty]], [FEmptyNode emptyNode]);
+}
+
+- (void)testPruningInSlices {
+    FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+    id<FNode> node = NODE((@{@"a": @1, @"b": @2, @"c": @{@"d": @3, @"e": @4}, @"keep": @{@"f": @5, @"g": @6}}));
+    [engine updateServerCache:node atPath:[FPath empty] merge:NO];
+    FPruneForest *forest = [[[FPruneForest empty] prunePath:[FPath empty]] keepPath:PATH(@"keep")];
+
+    NSUInteger slices = 0;
+    id cursor = nil;
+    do {
+        cursor = [engine pruneCache:forest atPath:[FPath empty] resumingFrom:cursor maxPaths:2];
+        slices++;
+        if (slices == 1) {
+            XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"c")], NODE((@{@"d": @3, @"e": @4})));
+        }
+    } while (cursor != nil && slices < 10);
+
+    XCTAssertEqual(slices, 3);
+    XCTAssertEqualObjects([engine serverCacheAtPath:[FPath empty]], NODE((@{@"keep": @{@"f": @5, @"g": @6}})));
+    XCTAssertEqual([engine serverCacheEstimatedSizeInBytes], 18);
+}
 
 - (void)testSaveAndLoadTrackedQueries {
     FLevelDBStorageEngine *engine = [self cleanStorageEngine];
@@ -24,6 +24,7 @@
 #import "FPathIndex.h"
 #import "FIndexedNode.h"
 #import "FEmptyNode.h"
+#import "FWriteBehindStorageEngine.h"
 
 @interface FPersistenceManagerTest : XCTestCase
 
@@ -103,4 +104,40 @@
     XCTAssertEqualObjects(actual, expected);
 }
 
+- (void)testWriteBehindReadsSeeQueuedWrites {
+    FMockStorageEngine *engine = [[FMockStorageEngine alloc] init];
+    FWriteBehindStorageEngine *writeBehind = [[FWriteBehindStorageEngine alloc] initWithStorageEngine:engine];
+    FPersistenceManager *manager = [[FPersistenceManager alloc] initWithStorageEngine:writeBehind
+                                                                          cachePolicy:[FNoCachePolicy noCachePolicy]];
+
+    FQuerySpec *limit2FooQuery = [[FQuerySpec alloc] initWithPath:PATH(@"foo") params:[[FQueryParams defaultInstance] limitToFirst:2]];
+    FQuerySpec *limit3FooQuery = [[FQuerySpec alloc] initWithPath:PATH(@"foo") params:[[FQueryParams defaultInstance] limitToFirst:3]];
+
+    [manager setQueryActive:limit2FooQuery];
+    [manager updateServerCacheWithNode:NODE((@{@"a": @1, @"b": @2, @"c": @3, @"d": @4})) forQuery:limit2FooQuery];
+    [manager setTrackedQueryKeys:[NSSet setWithArray:@[@"a", @"b"]] forQuery:limit2FooQuery];
+
+    FCacheNode *cache = [manager serverCacheForQuery:limit3FooQuery];
+    XCTAssertFalse(cache.isFullyInitialized);
+    XCTAssertEqualObjects(cache.node, NODE((@{@"a": @1, @"b": @2})));
+
+    [writeBehind flush];
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], NODE((@{@"a": @1, @"b": @2, @"c": @3, @"d": @4})));
+}
+
+- (void)testWriteBehindUserWritesWaitForQueuedWrites {
+    FMockStorageEngine *engine = [[FMockStorageEngine alloc] init];
+    FWriteBehindStorageEngine *writeBehind = [[FWriteBehindStorageEngine alloc] initWithStorageEngine:engine];
+
+    [writeBehind updateServerCache:NODE(@"server-value") atPath:PATH(@"foo") merge:NO];
+    [writeBehind saveUserOverwrite:NODE(@"user-value") atPath:PATH(@"bar") writeId:1];
+
+    // Without flushing, both the user write and the server cache write before it are already in the engine.
+    XCTAssertEqual([engine userWrites].count, (NSUInteger)1);
+    XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], NODE(@"server-value"));
+
+    [writeBehind removeUserWrite:1];
+    XCTAssertEqual([engine userWrites].count, (NSUInteger)0);
+}
+
 @end
@@ -571,4 +571,38 @@
     }
 }
 
+- (void) testFromSortedKeys {
+    int N = 100;
+    NSMutableArray* keys = [[NSMutableArray alloc] initWithCapacity:N];
+    NSMutableArray* values = [[NSMutableArray alloc] initWithCapacity:N];
+    for(int i = 0; i < N; i++) {
+        [keys addObject:[NSNumber numberWithInt:i]];
+        [values addObject:[NSString stringWithFormat:@"value%d", i]];
+    }
+
+    FImmutableSortedDictionary *map = [FImmutableSortedDictionary fromSortedKeys:keys values:values withComparator:[self defaultComparator]];
+    XCTAssertTrue([map isKindOfClass:[FTreeSortedDictionary class]], @"Large dictionaries are tree backed");
+    XCTAssertTrue([(FLLRBValueNode *)((FTreeSortedDictionary *)map).root checkMaxDepth], @"Checking valid depth and tree structure");
+    XCTAssertTrue([map count] == N, @"Check if all N objects are in the map");
+
+    __block int correctValue = 0;
+    [map enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+        XCTAssertEqualObjects(key, [NSNumber numberWithInt:correctValue], @"Correct key");
+        XCTAssertEqualObjects(value, values[correctValue], @"Correct value");
+        correctValue = correctValue + 1;
+    }];
+    XCTAssertEqual(correctValue, N);
+
+    NSDictionary* dictionary = [NSDictionary dictionaryWithObjects:values forKeys:keys];
+    XCTAssertEqualObjects(map, [FImmutableSortedDictionary fromDictionary:dictionary withComparator:[self defaultComparator]]);
+
+    FImmutableSortedDictionary *small = [FImmutableSortedDictionary fromSortedKeys:@[@1, @2, @3] values:@[@"a", @"b", @"c"] withComparator:[self defaultComparator]];
+    XCTAssertFalse([small isKindOfClass:[FTreeSortedDictionary class]], @"Small dictionaries are array backed");
+    XCTAssertEqualObjects([small get:@2], @"b");
+    XCTAssertTrue([[FImmutableSortedDictionary fromSortedKeys:@[] values:@[] withComparator:[self defaultComparator]] isEmpty]);
+
+    XCTAssertThrows([FImmutableSortedDictionary fromSortedKeys:@[@2, @1] values:@[@"a", @"b"] withComparator:[self defaultComparator]], @"Keys must be sorted");
+    XCTAssertThrows([FImmutableSortedDictionary fromSortedKeys:@[@1, @1] values:@[@"a", @"b"] withComparator:[self defaultComparator]], @"Keys must be unique");
+}
+
 @end
@@ -26,6 +26,7 @@
 
 @interface FWebSocketConnection (Tests)
 - (NSString*)userAgent;
++ (NSArray<NSString *> *)framesForMessage:(NSDictionary *)message;
 @end
 
 @interface FUtilitiesTest : XCTestCase
@@ -87,6 +88,23 @@
 
 }
 
+- (void)testWebsocketFramesForMessage {
+    NSArray *small = [FWebSocketConnection framesForMessage:@{@"t": @"d"}];
+    XCTAssertEqualObjects(small, @[@"{\"t\":\"d\"}"]);
+
+    NSString *value = [@"" stringByPaddingToLength:(NSUInteger)kWebsocketMaxFrameSize * 2
+                                        withString:@"a"
+                                   startingAtIndex:0];
+    NSArray *large = [FWebSocketConnection framesForMessage:@{@"v": value}];
+    XCTAssertEqual(large.count, (NSUInteger)4);
+    XCTAssertEqualObjects(large[0], @"3");
+    NSString *joined = [[large subarrayWithRange:NSMakeRange(1, 3)] componentsJoinedByString:@""];
+    NSDictionary *decoded = [NSJSONSerialization JSONObjectWithData:[joined dataUsingEncoding:NSUTF8StringEncoding]
+                                                            options:kNilOptions
+                                                              error:nil];
+    XCTAssertEqualObjects(decoded, @{@"v": value});
+}
+
 - (void)testKeyComparison {
     NSArray *order = @[
       @"-2147483648", @"0", @"1", @"2", @"10", @"2147483647", // Treated as integers
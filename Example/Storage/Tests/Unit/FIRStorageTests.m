@@ -18,6 +18,7 @@
 #import "FIRStorageComponent.h"
 #import "FIRStorageReference.h"
 #import "FIRStorageReference_Private.h"
+#import "FIRStorageUploadTask_Private.h"
 #import "FIRStorage_Private.h"
 
 @interface FIRStorageTests : XCTestCase
@@ -212,4 +213,34 @@
   XCTAssertEqual([storage hash], [copy hash]);
 }
 
+- (void)testCopyKeepsUploadChunkSize {
+  FIRStorage *storage = [FIRStorage storageForApp:self.app];
+  XCTAssertEqual(storage.uploadChunkSizeBytes, 5 * 1024 * 1024);
+  storage.uploadChunkSizeBytes = 1024 * 1024;
+  FIRStorage *copy = [storage copy];
+  XCTAssertEqual(copy.uploadChunkSizeBytes, 1024 * 1024);
+}
+
+- (void)testCopyKeepsDownloadRanges {
+  FIRStorage *storage = [FIRStorage storageForApp:self.app];
+  XCTAssertEqual(storage.downloadRangeSizeBytes, 0);
+  XCTAssertEqual(storage.maxParallelDownloadRanges, 4);
+  storage.downloadRangeSizeBytes = 8 * 1024 * 1024;
+  storage.maxParallelDownloadRanges = 2;
+  FIRStorage *copy = [storage copy];
+  XCTAssertEqual(copy.downloadRangeSizeBytes, 8 * 1024 * 1024);
+  XCTAssertEqual(copy.maxParallelDownloadRanges, 2);
+}
+
+- (void)testUploadChunkSizeIsRoundedToGranularity {
+  int64_t granularity = 256 * 1024;
+  XCTAssertEqual([FIRStorageUploadTask uploadChunkSizeForChunkSize:0], granularity);
+  XCTAssertEqual([FIRStorageUploadTask uploadChunkSizeForChunkSize:1], granularity);
+  XCTAssertEqual([FIRStorageUploadTask uploadChunkSizeForChunkSize:granularity], granularity);
+  XCTAssertEqual([FIRStorageUploadTask uploadChunkSizeForChunkSize:granularity + 1],
+                 2 * granularity);
+  XCTAssertEqual([FIRStorageUploadTask uploadChunkSizeForChunkSize:8 * granularity],
+                 8 * granularity);
+}
+
 @end
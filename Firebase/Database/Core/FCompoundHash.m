@@ -24,6 +24,10 @@
 
 @property (nonatomic, strong) FCompoundHashSplitStrategy splitStrategy;
 
+// The hash length above which the split strategy splits after a leaf, if known. Lets subtrees whose
+// cached representation fits in the current range be appended without visiting them.
+@property (nonatomic) NSUInteger splitThreshold;
+
 @property (nonatomic, strong) NSMutableArray *currentPaths;
 @property (nonatomic, strong) NSMutableArray *currentHashes;
 
@@ -68,6 +72,42 @@
     return self->optHashValueBuilder.length;
 }
 
+- (NSUInteger)rangeCount {
+    return self.currentHashes.count;
+}
+
+- (NSInteger)currentPathDepth {
+    return self->currentPathDepth;
+}
+
+- (BOOL)canAppendRepresentationOfLength:(NSUInteger)length {
+    // No leaf of the subtree could make the range longer than the threshold, so none would split it
+    return self.splitThreshold > 0 && [self isBuildingRange] && [self currentHashLength] + length <= self.splitThreshold;
+}
+
+- (void)appendRepresentation:(NSString *)representation lastLeafPath:(NSArray<NSString *> *)lastLeafPath {
+    [self->optHashValueBuilder appendString:representation];
+    // Leave the path as though the leaves of the subtree had been visited
+    [lastLeafPath enumerateObjectsUsingBlock:^(NSString *key, NSUInteger idx, BOOL *stop) {
+        NSUInteger depth = self->currentPathDepth + idx;
+        if (depth == self->currentPath.count) {
+            [self->currentPath addObject:key];
+        } else {
+            self->currentPath[depth] = key;
+        }
+    }];
+    self->lastLeafDepth = self->currentPathDepth + lastLeafPath.count;
+    self->needsComma = YES;
+}
+
+- (NSString *)representationFromOffset:(NSUInteger)offset {
+    return [self->optHashValueBuilder substringFromIndex:offset];
+}
+
+- (NSArray<NSString *> *)lastLeafPathFromDepth:(NSInteger)depth {
+    return [self->currentPath subarrayWithRange:NSMakeRange(depth, self->lastLeafDepth - depth)];
+}
+
 - (FPath *)currentPath {
     return [self currentPathWithDepth:self->currentPathDepth];
 }
@@ -187,7 +227,7 @@
     return self;
 }
 
-+ (FCompoundHashSplitStrategy)simpleSizeSplitStrategyForNode:(id<FNode>)node {
++ (NSUInteger)simpleSizeSplitThresholdForNode:(id<FNode>)node {
     NSUInteger estimatedSize = [FSnapshotUtilities estimateSerializedNodeSize:node];
 
     // Splits for
@@ -196,8 +236,10 @@
     // 100k -> 3.2k (32 parts)
     // 500k -> 7k (71 parts)
     // 5M -> 23k (228 parts)
-    NSUInteger splitThreshold = MAX(512, (NSUInteger)sqrt(estimatedSize * 100));
+    return MAX(512, (NSUInteger)sqrt(estimatedSize * 100));
+}
 
++ (FCompoundHashSplitStrategy)simpleSizeSplitStrategyWithThreshold:(NSUInteger)splitThreshold {
     return ^BOOL(FCompoundHashBuilder *builder) {
         // Never split on priorities
         return [builder currentHashLength] > splitThreshold && ![[[builder currentPath] getBack] isEqualToString:@".priority"];
@@ -205,14 +247,25 @@
 }
 
 + (FCompoundHash *)fromNode:(id<FNode>)node {
-    return [FCompoundHash fromNode:node splitStrategy:[FCompoundHash simpleSizeSplitStrategyForNode:node]];
+    if ([node isEmpty]) {
+        return [[FCompoundHash alloc] initWithPosts:@[] hashes:@[@""]];
+    }
+    NSUInteger splitThreshold = [FCompoundHash simpleSizeSplitThresholdForNode:node];
+    return [FCompoundHash fromNode:node
+                     splitStrategy:[FCompoundHash simpleSizeSplitStrategyWithThreshold:splitThreshold]
+                    splitThreshold:splitThreshold];
 }
 
 + (FCompoundHash *)fromNode:(id<FNode>)node splitStrategy:(FCompoundHashSplitStrategy)strategy {
+    return [FCompoundHash fromNode:node splitStrategy:strategy splitThreshold:0];
+}
+
++ (FCompoundHash *)fromNode:(id<FNode>)node splitStrategy:(FCompoundHashSplitStrategy)strategy splitThreshold:(NSUInteger)splitThreshold {
     if ([node isEmpty]) {
         return [[FCompoundHash alloc] initWithPosts:@[] hashes:@[@""]];
     } else {
         FCompoundHashBuilder *builder = [[FCompoundHashBuilder alloc] initWithSplitStrategy:strategy];
+        builder.splitThreshold = splitThreshold;
         [FCompoundHash processNode:node builder:builder];
         [builder finishHashing];
         return [[FCompoundHash alloc] initWithPosts:builder.currentPaths hashes:builder.currentHashes];
@@ -227,10 +280,34 @@
         FChildrenNode *childrenNode = (FChildrenNode *)node;
         [childrenNode enumerateChildrenAndPriorityUsingBlock:^(NSString *key, id<FNode> node, BOOL *stop) {
             [builder startChild:key];
-            [self processNode:node builder:builder];
+            [self processChild:node builder:builder];
             [builder endChild];
         }];
     }
 }
 
++ (void)processChild:(id<FNode>)node builder:(FCompoundHashBuilder *)builder {
+    if ([node isLeafNode]) {
+        [builder processLeaf:node];
+        return;
+    }
+
+    FChildrenNode *childrenNode = (FChildrenNode *)node;
+    NSString *representation = childrenNode.compoundHashRepresentation;
+    if (representation != nil && [builder canAppendRepresentationOfLength:representation.length]) {
+        [builder appendRepresentation:representation lastLeafPath:childrenNode.compoundHashLastLeafPath];
+        return;
+    }
+
+    NSUInteger rangeCount = [builder rangeCount];
+    NSUInteger offset = [builder currentHashLength];
+    NSInteger depth = [builder currentPathDepth];
+    [self processNode:node builder:builder];
+    // The subtree can only be appended as a whole later if none of its leaves ended a range
+    if ([builder rangeCount] == rangeCount) {
+        childrenNode.compoundHashRepresentation = [builder representationFromOffset:offset];
+        childrenNode.compoundHashLastLeafPath = [builder lastLeafPathFromDepth:depth];
+    }
+}
+
 @end
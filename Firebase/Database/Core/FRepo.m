@@ -37,6 +37,7 @@
 #import "FSnapshotHolder.h"
 #import "FIRDatabaseConfig_Private.h"
 #import "FLevelDBStorageEngine.h"
+#import "FWriteBehindStorageEngine.h"
 #import "FPersistenceManager.h"
 #import "FWriteRecord.h"
 #import "FCachePolicy.h"
@@ -120,7 +121,8 @@
         NSString* repoHashString = [NSString stringWithFormat:@"%@_%@", self.repoInfo.host, self.repoInfo.namespace];
         NSString* persistencePrefix = [NSString stringWithFormat:@"%@/%@", self.config.sessionIdentifier, repoHashString];
 
-        id<FCachePolicy> cachePolicy = [[FLRUCachePolicy alloc] initWithMaxSize:self.config.persistenceCacheSizeBytes];
+        id<FCachePolicy> cachePolicy = [[FLRUCachePolicy alloc] initWithMaxSize:self.config.persistenceCacheSizeBytes
+                                                        maxPathsToPrunePerUpdate:self.config.persistencePrunePathsPerUpdate];
 
         id<FStorageEngine> engine;
         if (self.config.forceStorageEngine != nil) {
@@ -132,6 +134,9 @@
             [levelDBEngine runLegacyMigration:self.repoInfo];
             engine = levelDBEngine;
         }
+        if (self.config.persistenceWriteBehindEnabled) {
+            engine = [[FWriteBehindStorageEngine alloc] initWithStorageEngine:engine];
+        }
 
         self.persistenceManager = [[FPersistenceManager alloc] initWithStorageEngine:engine cachePolicy:cachePolicy];
     } else {
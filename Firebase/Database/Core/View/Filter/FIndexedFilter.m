@@ -23,6 +23,7 @@
 #import "FKeyIndex.h"
 #import "FEmptyNode.h"
 #import "FIndexedNode.h"
+#import "FUtilities.h"
 
 @interface FIndexedFilter ()
 @property (nonatomic, strong, readwrite) id<FIndex> index;
@@ -96,35 +97,72 @@
                      withNewNode:(FIndexedNode *)newSnap
                      accumulator:(FChildChangeAccumulator *)optChangeAccumulator
 {
-    if (optChangeAccumulator) {
-        [oldSnap.node enumerateChildrenUsingBlock:^(NSString *childKey, id<FNode> childNode, BOOL *stop) {
-            if (![newSnap.node hasChild:childKey]) {
-                FChange *change = [[FChange alloc] initWithType:FIRDataEventTypeChildRemoved
-                                                    indexedNode:[FIndexedNode indexedNodeWithNode:childNode]
-                                                       childKey:childKey];
-                [optChangeAccumulator trackChildChange:change];
-            }
-        }];
+    BOOL reuseIndex = [oldSnap hasSortedChildren] && [oldSnap hasIndex:self.index] && [newSnap hasIndex:self.index];
+    if (oldSnap.node == newSnap.node) {
+        // Nothing changed
+        return reuseIndex ? oldSnap : newSnap;
+    } else if (!optChangeAccumulator && !reuseIndex) {
+        return newSnap;
+    }
 
-        [newSnap.node enumerateChildrenUsingBlock:^(NSString *childKey, id<FNode> childNode, BOOL *stop) {
-            if ([oldSnap.node hasChild:childKey]) {
-                id<FNode> oldChildSnap = [oldSnap.node getImmediateChild:childKey];
-                if (![oldChildSnap isEqual:childNode]) {
+    // Both nodes enumerate their children in key order, so a single walk over the two finds the children that were
+    // removed, added or changed. Children the nodes share are the same objects and compare equal right away.
+    NSMutableArray<FNamedNode *> *removedChildren = [NSMutableArray array];
+    NSMutableArray<FNamedNode *> *addedChildren = [NSMutableArray array];
+    NSComparator keyComparator = [FUtilities keyComparator];
+    NSEnumerator *oldChildren = [oldSnap.node childEnumerator];
+    __block FNamedNode *oldChild = [oldChildren nextObject];
+    [newSnap.node enumerateChildrenUsingBlock:^(NSString *childKey, id<FNode> childNode, BOOL *stop) {
+        while (oldChild != nil && keyComparator(oldChild.name, childKey) == NSOrderedAscending) {
+            [self trackRemovedChild:oldChild into:removedChildren accumulator:optChangeAccumulator];
+            oldChild = [oldChildren nextObject];
+        }
+        if (oldChild != nil && [oldChild.name isEqualToString:childKey]) {
+            if (![oldChild.node isEqual:childNode]) {
+                if (optChangeAccumulator) {
                     FChange *change = [[FChange alloc] initWithType:FIRDataEventTypeChildChanged
                                                         indexedNode:[FIndexedNode indexedNodeWithNode:childNode]
                                                            childKey:childKey
-                                                     oldIndexedNode:[FIndexedNode indexedNodeWithNode:oldChildSnap]];
+                                                     oldIndexedNode:[FIndexedNode indexedNodeWithNode:oldChild.node]];
                     [optChangeAccumulator trackChildChange:change];
                 }
-            } else {
+                [removedChildren addObject:oldChild];
+                [addedChildren addObject:[FNamedNode nodeWithName:childKey node:childNode]];
+            }
+            oldChild = [oldChildren nextObject];
+        } else {
+            if (optChangeAccumulator) {
                 FChange *change = [[FChange alloc] initWithType:FIRDataEventTypeChildAdded
                                                     indexedNode:[FIndexedNode indexedNodeWithNode:childNode]
                                                        childKey:childKey];
                 [optChangeAccumulator trackChildChange:change];
             }
-        }];
+            [addedChildren addObject:[FNamedNode nodeWithName:childKey node:childNode]];
+        }
+    }];
+    while (oldChild != nil) {
+        [self trackRemovedChild:oldChild into:removedChildren accumulator:optChangeAccumulator];
+        oldChild = [oldChildren nextObject];
+    }
+
+    if (reuseIndex) {
+        return [oldSnap updateNode:newSnap.node removedChildren:removedChildren addedChildren:addedChildren];
+    } else {
+        return newSnap;
+    }
+}
+
+- (void)trackRemovedChild:(FNamedNode *)child
+                     into:(NSMutableArray<FNamedNode *> *)removedChildren
+              accumulator:(FChildChangeAccumulator *)optChangeAccumulator
+{
+    if (optChangeAccumulator) {
+        FChange *change = [[FChange alloc] initWithType:FIRDataEventTypeChildRemoved
+                                            indexedNode:[FIndexedNode indexedNodeWithNode:child.node]
+                                               childKey:child.name];
+        [optChangeAccumulator trackChildChange:change];
     }
-    return newSnap;
+    [removedChildren addObject:child];
 }
 
 - (FIndexedNode *)updatePriority:(id<FNode>)priority forNode:(FIndexedNode *)oldSnap
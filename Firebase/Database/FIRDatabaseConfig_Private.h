@@ -25,6 +25,12 @@
 @property (nonatomic, strong, readonly) NSString *sessionIdentifier;
 @property (nonatomic, strong) id<FAuthTokenProvider> authTokenProvider;
 @property (nonatomic, strong) id<FStorageEngine> forceStorageEngine;
+// When pruning the persisted cache, prune at most this many stored paths after each server update instead of pruning
+// it all at once. Zero, the default, prunes it all at once.
+@property (nonatomic) NSUInteger persistencePrunePathsPerUpdate;
+// Apply server cache and tracked query writes to disk on a queue of their own instead of the repo queue, see
+// FWriteBehindStorageEngine. User writes are still on disk before saving them returns. Defaults to NO.
+@property (nonatomic) BOOL persistenceWriteBehindEnabled;
 
 - (void)freeze;
 
@@ -22,6 +22,9 @@
 - (BOOL)shouldCheckCacheSize:(NSUInteger)serverUpdatesSinceLastCheck;
 - (float)percentOfQueriesToPruneAtOnce;
 - (NSUInteger)maxNumberOfQueriesToKeep;
+// The number of stored paths to scan at most after each server update while pruning, or 0 to prune the whole cache at
+// once.
+- (NSUInteger)maxPathsToPrunePerUpdate;
 
 @end
 
@@ -31,6 +34,7 @@
 @property (nonatomic, readonly) NSUInteger maxSize;
 
 - (id)initWithMaxSize:(NSUInteger)maxSize;
+- (id)initWithMaxSize:(NSUInteger)maxSize maxPathsToPrunePerUpdate:(NSUInteger)maxPathsToPrunePerUpdate;
 
 @end
 
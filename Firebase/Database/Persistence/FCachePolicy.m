@@ -19,6 +19,7 @@
 @interface FLRUCachePolicy ()
 
 @property (nonatomic, readwrite) NSUInteger maxSize;
+@property (nonatomic) NSUInteger maxPathsToPrunePerUpdate;
 
 @end
 
@@ -29,9 +30,14 @@ static const float kFPercentOfQueriesToPruneAtOnce = 0.2f;
 @implementation FLRUCachePolicy
 
 - (id)initWithMaxSize:(NSUInteger)maxSize {
+    return [self initWithMaxSize:maxSize maxPathsToPrunePerUpdate:0];
+}
+
+- (id)initWithMaxSize:(NSUInteger)maxSize maxPathsToPrunePerUpdate:(NSUInteger)maxPathsToPrunePerUpdate {
     self = [super init];
     if (self != nil) {
         self->_maxSize = maxSize;
+        self->_maxPathsToPrunePerUpdate = maxPathsToPrunePerUpdate;
     }
     return self;
 }
@@ -76,4 +82,8 @@ static const float kFPercentOfQueriesToPruneAtOnce = 0.2f;
     return NSUIntegerMax;
 }
 
+- (NSUInteger)maxPathsToPrunePerUpdate {
+    return 0;
+}
+
 @end
@@ -25,8 +25,10 @@
 #import "FTrackedQuery.h"
 #import "FQueryParams.h"
 #import "FEmptyNode.h"
+#import "FEncodedNode.h"
 #import "FPruneForest.h"
 #import "FUtilities.h"
+#import "FConstants.h"
 #import "FPendingPut.h" // For legacy migration
 
 @interface FLevelDBStorageEngine ()
@@ -34,11 +36,78 @@
 @property (nonatomic, strong) NSString *basePath;
 @property (nonatomic, strong) APLevelDB *writesDB;
 @property (nonatomic, strong) APLevelDB *serverCacheDB;
+// The size of the values stored in the server cache, kept up to date as the cache is written to and pruned once it
+// has been computed, so that prune checks don't need to read the whole cache.
+@property (nonatomic) NSUInteger serverCacheSize;
+@property (nonatomic) BOOL serverCacheSizeKnown;
+
+@end
+
+// A write batch for the server cache that keeps track of how much the size of the values stored changes once it is
+// committed.
+@interface FServerCacheWriteBatch : NSObject
+
+@property (nonatomic, readonly) NSInteger sizeChange;
+
+- (id)initWithDatabase:(APLevelDB *)database;
+- (void)setData:(NSData *)data forKey:(NSString *)key;
+// Removes a single key, reading the size of its value.
+- (void)removeKey:(NSString *)key;
+// Removes a key found while enumerating the database, whose value is already known. Enumerations must not overlap
+// each other.
+- (void)removeKey:(NSString *)key withStoredSize:(NSUInteger)size;
+- (BOOL)commit;
+
+@end
+
+@implementation FServerCacheWriteBatch {
+    APLevelDB *_database;
+    id<APLevelDBWriteBatch> _batch;
+    NSMutableSet *_removedKeys;
+}
+
+- (id)initWithDatabase:(APLevelDB *)database {
+    self = [super init];
+    if (self != nil) {
+        self->_database = database;
+        self->_batch = [database beginWriteBatch];
+        self->_removedKeys = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (void)setData:(NSData *)data forKey:(NSString *)key {
+    // Keys are only written after whatever was stored at them has been removed in the same batch.
+    [self->_batch setData:data forKey:key];
+    self->_sizeChange += data.length;
+}
+
+- (void)removeKey:(NSString *)key {
+    if (![self->_removedKeys containsObject:key]) {
+        [self->_removedKeys addObject:key];
+        self->_sizeChange -= [self->_database dataForKey:key].length;
+    }
+    [self->_batch removeKey:key];
+}
+
+- (void)removeKey:(NSString *)key withStoredSize:(NSUInteger)size {
+    if (![self->_removedKeys containsObject:key]) {
+        self->_sizeChange -= size;
+    }
+    [self->_batch removeKey:key];
+}
+
+- (BOOL)commit {
+    return [self->_batch commit];
+}
 
 @end
 
 // WARNING: If you change this, you need to write a migration script
-static NSString * const kFPersistenceVersion = @"1";
+static NSString * const kFPersistenceVersion = @"2";
+// Version 1 stored the leaf nodes of the server cache as JSON. Version 2 stores them in the binary
+// form below, and still reads the JSON ones.
+static NSString * const kFPersistenceVersionJSONLeafNodes = @"1";
 
 static NSString * const kFServerDBPath = @"server_data";
 static NSString * const kFWritesDBPath = @"writes";
@@ -65,6 +134,29 @@ static NSString * const kFTrackedQueryKeysPrefix = @"/tracked_query_keys/";
 // Failed to load JSON because a valid JSON turns out to be NaN while deserializing
 static const NSInteger kFNanFailureCode = 3840;
 
+// Leaf nodes of the server cache are stored as one of these bytes followed by the value: UTF-8
+// bytes for strings, 8 little-endian bytes for integers and for the bits of doubles, nothing for
+// the others. None of these bytes can start a JSON value, which tells leaf nodes stored by version
+// 1 apart.
+typedef NS_ENUM(uint8_t, FLeafNodeTag) {
+    FLeafNodeTagString = 0x01,
+    FLeafNodeTagInteger = 0x02,
+    FLeafNodeTagDouble = 0x03,
+    FLeafNodeTagTrue = 0x04,
+    FLeafNodeTagFalse = 0x05,
+    FLeafNodeTagNull = 0x06,
+};
+
+static NSData* leafNodeData(FLeafNodeTag tag, const void *bytes, NSUInteger length) {
+    NSMutableData *data = [NSMutableData dataWithCapacity:length + 1];
+    uint8_t tagByte = tag;
+    [data appendBytes:&tagByte length:1];
+    if (length > 0) {
+        [data appendBytes:bytes length:length];
+    }
+    return data;
+}
+
 static NSString* writeRecordKey(NSUInteger writeId) {
     return [NSString stringWithFormat:@"%lu", (unsigned long)(writeId)];
 }
@@ -117,6 +209,12 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
         }
     } else if ([oldVersion isEqualToString:kFPersistenceVersion]) {
         // Everythings fine no need for migration
+    } else if ([oldVersion isEqualToString:kFPersistenceVersionJSONLeafNodes]) {
+        // JSON leaf nodes are still read, and get replaced as the cache is updated
+        BOOL success = [kFPersistenceVersion writeToFile:versionFile atomically:NO encoding:NSUTF8StringEncoding error:&error];
+        if (!success) {
+            FFWarn(@"I-RDB076001", @"Failed to write version for database: %@", error);
+        }
     } else {
         // If we add more versions in the future, we need to run migration here
         [NSException raise:NSInternalInconsistencyException format:@"Unrecognized database version: %@", oldVersion];
@@ -177,6 +275,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 - (void)openDatabases {
     self.serverCacheDB = [self createDB:kFServerDBPath];
+    self.serverCacheSizeKnown = NO;
     self.writesDB = [self createDB:kFWritesDBPath];
 }
 
@@ -335,7 +434,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 - (id<FNode>)serverCacheAtPath:(FPath *)path {
     NSDate *start = [NSDate date];
     id data = [self internalNestedDataForPath:path];
-    id<FNode> node = [FSnapshotUtilities nodeFrom:data];
+    id<FNode> node = [FEncodedNode nodeWithValue:data];
     FFDebug(@"I-RDB076015", @"Loaded node with %d children at %@ in %fms", [node numChildren], path, [start timeIntervalSinceNow]*-1000);
     return node;
 }
@@ -345,7 +444,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     __block id<FNode> node = [FEmptyNode emptyNode];
     [keys enumerateObjectsUsingBlock:^(NSString *key, BOOL *stop) {
         id data = [self internalNestedDataForPath:[path childFromString:key]];
-        node = [node updateImmediateChild:key withNewChild:[FSnapshotUtilities nodeFrom:data]];
+        node = [node updateImmediateChild:key withNewChild:[FEncodedNode nodeWithValue:data]];
     }];
     FFDebug(@"I-RDB076016", @"Loaded node with %d children for %lu keys at %@ in %fms", [node numChildren], (unsigned long)keys.count, path, [start timeIntervalSinceNow]*-1000);
     return node;
@@ -353,7 +452,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 - (void)updateServerCache:(id<FNode>)node atPath:(FPath *)path merge:(BOOL)merge {
     NSDate *start = [NSDate date];
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    FServerCacheWriteBatch *batch = [[FServerCacheWriteBatch alloc] initWithDatabase:self.serverCacheDB];
     // Remove any leaf nodes that might be higher up
     [self removeAllLeafNodesOnPath:path batch:batch];
     __block NSUInteger counter = 0;
@@ -361,15 +460,15 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
         // remove any children that exist
         [node enumerateChildrenUsingBlock:^(NSString *childKey, id<FNode> childNode, BOOL *stop) {
             FPath *childPath = [path childFromString:childKey];
-            [self removeAllWithPrefix:serverCacheKey(childPath) batch:batch database:self.serverCacheDB];
+            [self removeAllWithPrefix:serverCacheKey(childPath) batch:batch];
             [self saveNodeInternal:childNode atPath:childPath batch:batch counter:&counter];
         }];
     } else {
         // remove everything
-        [self removeAllWithPrefix:serverCacheKey(path) batch:batch database:self.serverCacheDB];
+        [self removeAllWithPrefix:serverCacheKey(path) batch:batch];
         [self saveNodeInternal:node atPath:path batch:batch counter:&counter];
     }
-    BOOL success = [batch commit];
+    BOOL success = [self commitServerCacheBatch:batch];
     if (!success) {
         FFWarn(@"I-RDB076017", @"Failed to update server cache on disk!");
     } else {
@@ -380,15 +479,15 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 - (void)updateServerCacheWithMerge:(FCompoundWrite *)merge atPath:(FPath *)path {
     NSDate *start = [NSDate date];
     __block NSUInteger counter = 0;
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    FServerCacheWriteBatch *batch = [[FServerCacheWriteBatch alloc] initWithDatabase:self.serverCacheDB];
     // Remove any leaf nodes that might be higher up
     [self removeAllLeafNodesOnPath:path batch:batch];
     [merge enumerateWrites:^(FPath *relativePath, id<FNode> node, BOOL *stop) {
         FPath *childPath = [path child:relativePath];
-        [self removeAllWithPrefix:serverCacheKey(childPath) batch:batch database:self.serverCacheDB];
+        [self removeAllWithPrefix:serverCacheKey(childPath) batch:batch];
         [self saveNodeInternal:node atPath:childPath batch:batch counter:&counter];
     }];
-    BOOL success = [batch commit];
+    BOOL success = [self commitServerCacheBatch:batch];
     if (!success) {
         FFWarn(@"I-RDB076019", @"Failed to update server cache on disk!");
     } else {
@@ -396,7 +495,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     }
 }
 
-- (void)saveNodeInternal:(id<FNode>)node atPath:(FPath *)path batch:(id<APLevelDBWriteBatch>)batch counter:(NSUInteger *)counter {
+- (void)saveNodeInternal:(id<FNode>)node atPath:(FPath *)path batch:(FServerCacheWriteBatch *)batch counter:(NSUInteger *)counter {
     id data = [node valForExport:YES];
     if(data != nil && ![data isKindOfClass:[NSNull class]]) {
         [self internalSetNestedData:data forKey:serverCacheKey(path) withBatch:batch counter:counter];
@@ -406,35 +505,66 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 - (NSUInteger)serverCacheEstimatedSizeInBytes {
     // Use the exact size, because for pruning the approximate size can lead to weird situations where we prune everything
     // because no compaction is ever run
-    return [self.serverCacheDB exactSizeFrom:kFServerCachePrefix to:kFServerCacheRangeEnd];
+    if (!self.serverCacheSizeKnown) {
+        self.serverCacheSize = [self.serverCacheDB exactSizeFrom:kFServerCachePrefix to:kFServerCacheRangeEnd];
+        self.serverCacheSizeKnown = YES;
+    }
+    return self.serverCacheSize;
 }
 
 - (void)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path {
-    // TODO: be more intelligent, don't scan entire database...
+    [self pruneCache:pruneForest atPath:path resumingFrom:nil maxPaths:NSUIntegerMax];
+}
 
+- (id)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path resumingFrom:(id)cursor maxPaths:(NSUInteger)maxPaths {
+    NSAssert(maxPaths > 0, @"Can't prune without scanning any paths");
     __block NSUInteger pruned = 0;
     __block NSUInteger kept = 0;
     NSDate *start = [NSDate date];
 
     NSString *prefix = serverCacheKey(path);
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    NSString *nextKey = nil;
+    FServerCacheWriteBatch *batch = [[FServerCacheWriteBatch alloc] initWithDatabase:self.serverCacheDB];
 
-    [self.serverCacheDB enumerateKeysWithPrefix:prefix usingBlock:^(NSString *dbKey, BOOL *stop) {
-        NSString *pathStr = [dbKey substringFromIndex:prefix.length];
-        FPath *relativePath = [[FPath alloc] initWith:pathStr];
-        if ([pruneForest shouldPruneUnkeptDescendantsAtPath:relativePath]) {
-            pruned++;
-            [batch removeKey:dbKey];
-        } else {
-            kept++;
+    // The cursor is the first key that hasn't been scanned yet
+    @autoreleasepool {
+        APLevelDBIterator *iter = [APLevelDBIterator iteratorWithLevelDB:self.serverCacheDB];
+        NSString *dbKey = nil;
+        if (iter != nil && [iter seekToKey:(cursor != nil ? cursor : prefix)]) {
+            dbKey = iter.key;
         }
-    }];
-    BOOL success = [batch commit];
+        while (dbKey != nil && [dbKey hasPrefix:prefix]) {
+            if (pruned + kept == maxPaths) {
+                nextKey = dbKey;
+                break;
+            }
+            NSString *pathStr = [dbKey substringFromIndex:prefix.length];
+            FPath *relativePath = [[FPath alloc] initWith:pathStr];
+            if ([pruneForest shouldPruneUnkeptDescendantsAtPath:relativePath]) {
+                pruned++;
+                [batch removeKey:dbKey withStoredSize:iter.valueAsData.length];
+            } else {
+                kept++;
+            }
+            dbKey = [iter nextKey];
+        }
+    }
+    BOOL success = [self commitServerCacheBatch:batch];
     if (!success) {
         FFWarn(@"I-RDB076021", @"Failed to prune cache on disk!");
     } else {
         FFDebug(@"I-RDB076022", @"Pruned %lu paths, kept %lu paths in %fms", (unsigned long)pruned, (unsigned long)kept, [start timeIntervalSinceNow]*-1000);
     }
+    return nextKey;
+}
+
+- (BOOL)commitServerCacheBatch:(FServerCacheWriteBatch *)batch {
+    BOOL success = [batch commit];
+    if (success && self.serverCacheSizeKnown) {
+        NSInteger size = (NSInteger)self.serverCacheSize + batch.sizeChange;
+        self.serverCacheSize = size > 0 ? (NSUInteger)size : 0;
+    }
+    return success;
 }
 
 #pragma mark - Tracked Queries
@@ -583,7 +713,7 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 #pragma mark - Internal methods
 
-- (void)removeAllLeafNodesOnPath:(FPath *)path batch:(id<APLevelDBWriteBatch>)batch {
+- (void)removeAllLeafNodesOnPath:(FPath *)path batch:(FServerCacheWriteBatch *)batch {
     while (!path.isEmpty) {
         [batch removeKey:serverCacheKey(path)];
         path = [path parent];
@@ -592,17 +722,17 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     [batch removeKey:serverCacheKey([FPath empty])];
 }
 
-- (void)removeAllWithPrefix:(NSString *)prefix batch:(id<APLevelDBWriteBatch>)batch database:(APLevelDB *)database {
+- (void)removeAllWithPrefix:(NSString *)prefix batch:(FServerCacheWriteBatch *)batch {
     assert(prefix != nil);
 
-    [database enumerateKeysWithPrefix:prefix usingBlock:^(NSString *key, BOOL *stop) {
-        [batch removeKey:key];
+    [self.serverCacheDB enumerateKeysWithPrefix:prefix asData:^(NSString *key, NSData *value, BOOL *stop) {
+        [batch removeKey:key withStoredSize:value.length];
     }];
 }
 
 #pragma mark - Internal helper methods
 
-- (void)internalSetNestedData:(id)value forKey:(NSString *)key withBatch:(id<APLevelDBWriteBatch>)batch counter:(NSUInteger *)counter {
+- (void)internalSetNestedData:(id)value forKey:(NSString *)key withBatch:(FServerCacheWriteBatch *)batch counter:(NSUInteger *)counter {
     if([value isKindOfClass:[NSDictionary class]]) {
         NSDictionary* dictionary = value;
         [dictionary enumerateKeysAndObjectsUsingBlock:^(id childKey, id obj, BOOL *stop) {
@@ -663,13 +793,65 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 
 
 - (NSData*) serializePrimitive:(id)value {
-    // HACK: The built-in serialization only works on dicts and arrays.  So we create an array and then strip off
-    // the leading / trailing byte (the [ and ]).
-    NSError *error = nil;
-    NSData *data = [NSJSONSerialization dataWithJSONObject:@[value] options:0 error:&error];
-    NSAssert(data, @"Failed to serialize primitive: %@", error);
+    if ([value isKindOfClass:[NSString class]]) {
+        NSData *utf8 = [value dataUsingEncoding:NSUTF8StringEncoding];
+        return leafNodeData(FLeafNodeTagString, utf8.bytes, utf8.length);
+    } else if ([value isKindOfClass:[NSNumber class]]) {
+        NSNumber *number = value;
+        if ([[FUtilities getJavascriptType:number] isEqualToString:kJavaScriptBoolean]) {
+            return leafNodeData(number.boolValue ? FLeafNodeTagTrue : FLeafNodeTagFalse, NULL, 0);
+        }
+        // Unsigned integers too large for int64_t are kept as doubles, like the server does
+        BOOL isHugeUnsigned = strcmp(number.objCType, @encode(unsigned long long)) == 0 &&
+                              number.unsignedLongLongValue > INT64_MAX;
+        if (CFNumberIsFloatType((CFNumberRef)number) || isHugeUnsigned) {
+            double doubleValue = number.doubleValue;
+            uint64_t bits;
+            memcpy(&bits, &doubleValue, sizeof(bits));
+            bits = CFSwapInt64HostToLittle(bits);
+            return leafNodeData(FLeafNodeTagDouble, &bits, sizeof(bits));
+        } else {
+            uint64_t bits = CFSwapInt64HostToLittle((uint64_t)number.longLongValue);
+            return leafNodeData(FLeafNodeTagInteger, &bits, sizeof(bits));
+        }
+    } else if ([value isKindOfClass:[NSNull class]]) {
+        return leafNodeData(FLeafNodeTagNull, NULL, 0);
+    }
+
+    [NSException raise:NSInternalInconsistencyException format:@"Failed to serialize primitive: %@", value];
+    return nil;
+}
 
-    return [data subdataWithRange:NSMakeRange(1, data.length - 2)];
+- (id)decodeLeafNode:(NSData *)data {
+    const uint8_t *bytes = data.bytes;
+    NSUInteger length = data.length - 1;
+    switch (bytes[0]) {
+        case FLeafNodeTagString:
+            return [[NSString alloc] initWithBytes:bytes + 1 length:length encoding:NSUTF8StringEncoding];
+        case FLeafNodeTagInteger:
+        case FLeafNodeTagDouble: {
+            if (length != sizeof(uint64_t)) {
+                break;
+            }
+            uint64_t bits;
+            memcpy(&bits, bytes + 1, sizeof(bits));
+            bits = CFSwapInt64LittleToHost(bits);
+            if (bytes[0] == FLeafNodeTagInteger) {
+                return [NSNumber numberWithLongLong:(int64_t)bits];
+            }
+            double doubleValue;
+            memcpy(&doubleValue, &bits, sizeof(doubleValue));
+            return [NSNumber numberWithDouble:doubleValue];
+        }
+        case FLeafNodeTagTrue:
+            return @YES;
+        case FLeafNodeTagFalse:
+            return @NO;
+        case FLeafNodeTagNull:
+            return [NSNull null];
+    }
+    [NSException raise:NSInternalInconsistencyException format:@"Failed to deserialize primitive: %@", data];
+    return nil;
 }
 
 - (id)fixDoubleParsing:(id)value __attribute__((no_sanitize("float-cast-overflow"))) {
@@ -695,6 +877,11 @@ static NSString* trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 }
 
 - (id) deserializePrimitive:(NSData*)data {
+    if (data.length > 0 && ((const uint8_t *)data.bytes)[0] <= FLeafNodeTagNull) {
+        return [self decodeLeafNode:data];
+    }
+
+    // Written by version 1
     NSError *error = nil;
     id result = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:&error];
     if (result != nil) {
@@ -31,6 +31,11 @@
 @property (nonatomic, strong) id<FCachePolicy> cachePolicy;
 @property (nonatomic, strong) FTrackedQueryManager *trackedQueryManager;
 @property (nonatomic) NSUInteger serverCacheUpdatesSinceLastPruneCheck;
+// While the cache is pruned a few paths per server update, the paths being pruned and where to resume. Paths that are
+// written to or listened to in the meantime are kept.
+@property (nonatomic, strong) FPruneForest *pendingPruneForest;
+@property (nonatomic, strong) id pruneCursor;
+@property (nonatomic) BOOL checkCacheSizeOnNextUpdate;
 
 @end
 
@@ -103,12 +108,14 @@
 
 - (void)updateServerCacheWithNode:(id<FNode>)node forQuery:(FQuerySpec *)query {
     BOOL merge = !query.loadsAllData;
+    [self keepPathFromPendingPrune:query.path];
     [self.storageEngine updateServerCache:node atPath:query.path merge:merge];
     [self setQueryComplete:query];
     [self doPruneCheckAfterServerUpdate];
 }
 
 - (void)updateServerCacheWithMerge:(FCompoundWrite *)merge atPath:(FPath *)path {
+    [self keepPathFromPendingPrune:path];
     [self.storageEngine updateServerCacheWithMerge:merge atPath:path];
     [self doPruneCheckAfterServerUpdate];
 }
@@ -129,6 +136,7 @@
     // that we wrote a ServerValue.TIMESTAMP and the server resolved it to a different value).
     // TODO[offline]: Consider reworking.
     if (![self.trackedQueryManager hasActiveDefaultQueryAtPath:path]) {
+        [self keepPathFromPendingPrune:path];
         [self.storageEngine updateServerCache:write atPath:path merge:NO];
         [self.trackedQueryManager ensureCompleteTrackedQueryAtPath:path];
     }
@@ -143,6 +151,7 @@
 }
 
 - (void)setQueryActive:(FQuerySpec *)spec {
+    [self keepPathFromPendingPrune:spec.path];
     [self.trackedQueryManager setQueryActive:spec];
 }
 
@@ -151,21 +160,32 @@
 }
 
 - (void)doPruneCheckAfterServerUpdate {
+    if (self.pendingPruneForest != nil) {
+        [self pruneNextSlice];
+        return;
+    }
     self.serverCacheUpdatesSinceLastPruneCheck++;
-    if ([self.cachePolicy shouldCheckCacheSize:self.serverCacheUpdatesSinceLastPruneCheck]) {
+    if (self.checkCacheSizeOnNextUpdate || [self.cachePolicy shouldCheckCacheSize:self.serverCacheUpdatesSinceLastPruneCheck]) {
         FFDebug(@"I-RDB078001", @"Reached prune check threshold. Checking...");
         NSDate *date = [NSDate date];
         self.serverCacheUpdatesSinceLastPruneCheck = 0;
+        self.checkCacheSizeOnNextUpdate = NO;
         BOOL canPrune = YES;
         NSUInteger cacheSize = [self.storageEngine serverCacheEstimatedSizeInBytes];
         FFDebug(@"I-RDB078002", @"Server cache size: %lu", (unsigned long)cacheSize);
         while (canPrune && [self.cachePolicy shouldPruneCacheWithSize:cacheSize
                                                numberOfTrackedQueries:self.trackedQueryManager.numberOfPrunableQueries]) {
             FPruneForest *pruneForest = [self.trackedQueryManager pruneOldQueries:self.cachePolicy];
-            if (pruneForest.prunesAnything) {
-                [self.storageEngine pruneCache:pruneForest atPath:[FPath empty]];
-            } else {
+            if (!pruneForest.prunesAnything) {
                 canPrune = NO;
+            } else if ([self.cachePolicy maxPathsToPrunePerUpdate] > 0) {
+                // Prune the cache bit by bit over the next updates instead of blocking until it is all done
+                self.pendingPruneForest = pruneForest;
+                self.pruneCursor = nil;
+                [self pruneNextSlice];
+                break;
+            } else {
+                [self.storageEngine pruneCache:pruneForest atPath:[FPath empty]];
             }
             cacheSize = [self.storageEngine serverCacheEstimatedSizeInBytes];
             FFDebug(@"I-RDB078003", @"Cache size after pruning: %lu", (unsigned long)cacheSize);
@@ -174,6 +194,26 @@
     }
 }
 
+- (void)pruneNextSlice {
+    self.pruneCursor = [self.storageEngine pruneCache:self.pendingPruneForest
+                                               atPath:[FPath empty]
+                                         resumingFrom:self.pruneCursor
+                                             maxPaths:[self.cachePolicy maxPathsToPrunePerUpdate]];
+    if (self.pruneCursor == nil) {
+        FFDebug(@"I-RDB078005", @"Cache size after pruning: %lu",
+                (unsigned long)[self.storageEngine serverCacheEstimatedSizeInBytes]);
+        self.pendingPruneForest = nil;
+        // Pruning may not have freed enough space yet
+        self.checkCacheSizeOnNextUpdate = YES;
+    }
+}
+
+- (void)keepPathFromPendingPrune:(FPath *)path {
+    if (self.pendingPruneForest != nil && [self.pendingPruneForest affectsPath:path]) {
+        self.pendingPruneForest = [self.pendingPruneForest keepPath:path];
+    }
+}
+
 - (void)setTrackedQueryKeys:(NSSet *)keys forQuery:(FQuerySpec *)query {
     NSAssert(!query.loadsAllData, @"We should only track keys for filtered queries");
     FTrackedQuery *trackedQuery = [self.trackedQueryManager findTrackedQuery:query];
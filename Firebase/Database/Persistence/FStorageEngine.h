@@ -40,6 +40,11 @@
 - (NSUInteger)serverCacheEstimatedSizeInBytes;
 
 - (void)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path;
+/**
+ * Prunes part of the cache, scanning at most maxPaths of the paths stored under path. Returns nil once every path has
+ * been scanned, or otherwise a cursor to pass in to prune the rest. Start with a nil cursor.
+ */
+- (id)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path resumingFrom:(id)cursor maxPaths:(NSUInteger)maxPaths;
 
 - (NSArray *)loadTrackedQueries;
 - (void)removeTrackedQuery:(NSUInteger)queryId;
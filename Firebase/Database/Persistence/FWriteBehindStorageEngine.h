@@ -0,0 +1,42 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "FStorageEngine.h"
+
+/**
+ * A storage engine that applies server cache and tracked query writes to another storage engine on a queue of its own,
+ * so that large server updates don't hold up the repo queue, and with it the events raised to listeners, while they
+ * are written to disk. Writes made in a burst are applied together by a single block on that queue.
+ *
+ * Writes are applied in the order they were made. Reads wait for the writes queued before them, so they see them. User
+ * writes are barriers: saving or removing one waits for all the writes queued before it and then for the user write
+ * itself, so once it returns the user write is on disk, as it is without write-behind.
+ *
+ * If the app is killed, the writes still queued are lost. Since writes are applied in order, what's on disk is always
+ * the state after some prefix of them, like after a crash slightly earlier. No saved user write is lost, but the
+ * server cache and tracked queries may be older than they were in memory, which only costs fetching that data from the
+ * server again.
+ */
+@interface FWriteBehindStorageEngine : NSObject<FStorageEngine>
+
+- (id)initWithStorageEngine:(id<FStorageEngine>)storageEngine;
+
+/** Waits until all the writes queued so far have been applied. */
+- (void)flush;
+
+@end
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FWriteBehindStorageEngine.h"
+
+@interface FWriteBehindStorageEngine ()
+
+@property (nonatomic, strong) id<FStorageEngine> storageEngine;
+@property (nonatomic, strong) dispatch_queue_t writeQueue;
+/**
+ * The writes not yet picked up by the write queue, guarded by synchronizing on self. The storage engine itself is only
+ * ever used on the write queue.
+ */
+@property (nonatomic, strong) NSMutableArray<dispatch_block_t> *pendingWrites;
+
+@end
+
+@implementation FWriteBehindStorageEngine
+
+- (id)initWithStorageEngine:(id<FStorageEngine>)storageEngine {
+    self = [super init];
+    if (self != nil) {
+        self->_storageEngine = storageEngine;
+        self->_writeQueue = dispatch_queue_create("com.firebase.database.persistence", DISPATCH_QUEUE_SERIAL);
+        self->_pendingWrites = [NSMutableArray array];
+    }
+    return self;
+}
+
+#pragma mark -
+#pragma mark Write queue
+
+- (void)enqueueWrite:(dispatch_block_t)write {
+    BOOL scheduleWrites;
+    @synchronized (self) {
+        // A block is already scheduled to apply the writes unless there are none pending
+        scheduleWrites = self.pendingWrites.count == 0;
+        [self.pendingWrites addObject:write];
+    }
+    if (scheduleWrites) {
+        dispatch_async(self.writeQueue, ^{
+            [self applyPendingWrites];
+        });
+    }
+}
+
+- (void)applyPendingWrites {
+    NSArray<dispatch_block_t> *writes;
+    @synchronized (self) {
+        writes = self.pendingWrites;
+        self.pendingWrites = [NSMutableArray array];
+    }
+    for (dispatch_block_t write in writes) {
+        @autoreleasepool {
+            write();
+        }
+    }
+}
+
+/** Runs the block on the write queue once all the writes queued before it have been applied. */
+- (void)runAfterPendingWrites:(dispatch_block_t)block {
+    dispatch_sync(self.writeQueue, ^{
+        [self applyPendingWrites];
+        block();
+    });
+}
+
+- (void)flush {
+    [self runAfterPendingWrites:^{}];
+}
+
+#pragma mark -
+#pragma mark FStorageEngine implementation
+
+- (void)close {
+    [self runAfterPendingWrites:^{
+        [self.storageEngine close];
+    }];
+}
+
+- (void)saveUserOverwrite:(id<FNode>)node atPath:(FPath *)path writeId:(NSUInteger)writeId {
+    [self runAfterPendingWrites:^{
+        [self.storageEngine saveUserOverwrite:node atPath:path writeId:writeId];
+    }];
+}
+
+- (void)saveUserMerge:(FCompoundWrite *)merge atPath:(FPath *)path writeId:(NSUInteger)writeId {
+    [self runAfterPendingWrites:^{
+        [self.storageEngine saveUserMerge:merge atPath:path writeId:writeId];
+    }];
+}
+
+- (void)removeUserWrite:(NSUInteger)writeId {
+    [self runAfterPendingWrites:^{
+        [self.storageEngine removeUserWrite:writeId];
+    }];
+}
+
+- (void)removeAllUserWrites {
+    [self runAfterPendingWrites:^{
+        [self.storageEngine removeAllUserWrites];
+    }];
+}
+
+- (NSArray *)userWrites {
+    __block NSArray *userWrites;
+    [self runAfterPendingWrites:^{
+        userWrites = [self.storageEngine userWrites];
+    }];
+    return userWrites;
+}
+
+- (id<FNode>)serverCacheAtPath:(FPath *)path {
+    __block id<FNode> node;
+    [self runAfterPendingWrites:^{
+        node = [self.storageEngine serverCacheAtPath:path];
+    }];
+    return node;
+}
+
+- (id<FNode>)serverCacheForKeys:(NSSet *)keys atPath:(FPath *)path {
+    __block id<FNode> node;
+    [self runAfterPendingWrites:^{
+        node = [self.storageEngine serverCacheForKeys:keys atPath:path];
+    }];
+    return node;
+}
+
+- (void)updateServerCache:(id<FNode>)node atPath:(FPath *)path merge:(BOOL)merge {
+    [self enqueueWrite:^{
+        [self.storageEngine updateServerCache:node atPath:path merge:merge];
+    }];
+}
+
+- (void)updateServerCacheWithMerge:(FCompoundWrite *)merge atPath:(FPath *)path {
+    [self enqueueWrite:^{
+        [self.storageEngine updateServerCacheWithMerge:merge atPath:path];
+    }];
+}
+
+- (NSUInteger)serverCacheEstimatedSizeInBytes {
+    __block NSUInteger size;
+    [self runAfterPendingWrites:^{
+        size = [self.storageEngine serverCacheEstimatedSizeInBytes];
+    }];
+    return size;
+}
+
+- (void)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path {
+    [self enqueueWrite:^{
+        [self.storageEngine pruneCache:pruneForest atPath:path];
+    }];
+}
+
+- (id)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path resumingFrom:(id)cursor maxPaths:(NSUInteger)maxPaths {
+    __block id nextCursor;
+    [self runAfterPendingWrites:^{
+        nextCursor = [self.storageEngine pruneCache:pruneForest atPath:path resumingFrom:cursor maxPaths:maxPaths];
+    }];
+    return nextCursor;
+}
+
+- (NSArray *)loadTrackedQueries {
+    __block NSArray *trackedQueries;
+    [self runAfterPendingWrites:^{
+        trackedQueries = [self.storageEngine loadTrackedQueries];
+    }];
+    return trackedQueries;
+}
+
+- (void)removeTrackedQuery:(NSUInteger)queryId {
+    [self enqueueWrite:^{
+        [self.storageEngine removeTrackedQuery:queryId];
+    }];
+}
+
+- (void)saveTrackedQuery:(FTrackedQuery *)query {
+    [self enqueueWrite:^{
+        [self.storageEngine saveTrackedQuery:query];
+    }];
+}
+
+- (void)setTrackedQueryKeys:(NSSet *)keys forQueryId:(NSUInteger)queryId {
+    NSSet *keysCopy = [keys copy];
+    [self enqueueWrite:^{
+        [self.storageEngine setTrackedQueryKeys:keysCopy forQueryId:queryId];
+    }];
+}
+
+- (void)updateTrackedQueryKeysWithAddedKeys:(NSSet *)added removedKeys:(NSSet *)removed forQueryId:(NSUInteger)queryId {
+    NSSet *addedCopy = [added copy];
+    NSSet *removedCopy = [removed copy];
+    [self enqueueWrite:^{
+        [self.storageEngine updateTrackedQueryKeysWithAddedKeys:addedCopy removedKeys:removedCopy forQueryId:queryId];
+    }];
+}
+
+- (NSSet *)trackedQueryKeysForQuery:(NSUInteger)queryId {
+    __block NSSet *keys;
+    [self runAfterPendingWrites:^{
+        keys = [self.storageEngine trackedQueryKeysForQuery:queryId];
+    }];
+    return keys;
+}
+
+@end
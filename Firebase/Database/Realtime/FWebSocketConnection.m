@@ -34,10 +34,13 @@
     BOOL everConnected;
     BOOL isClosed;
     NSTimer* keepAlive;
+    NSMutableArray<NSDictionary *>* pendingMessages;
+    BOOL flushScheduled;
 }
 
 - (void) shutdown;
 - (void) onClosed;
+- (void) flushPendingMessages;
 - (void) closeIfNeverConnected;
 
 @property (nonatomic, strong) FSRWebSocket* webSocket;
@@ -46,6 +49,7 @@
 @property (nonatomic, readonly) BOOL buffering;
 @property (nonatomic, readonly) NSString* userAgent;
 @property (nonatomic) dispatch_queue_t dispatchQueue;
+@property (nonatomic) dispatch_queue_t serializationQueue;
 
 - (void)nop:(NSTimer *)timer;
 
@@ -65,7 +69,10 @@
         self.connectionId = [FUtilities LUIDGenerator];
         self.totalFrames = 0;
         self.dispatchQueue = queue;
+        self.serializationQueue = dispatch_queue_create("com.firebase.database.websocket.serialization", DISPATCH_QUEUE_SERIAL);
         frame = nil;
+        pendingMessages = [NSMutableArray array];
+        flushScheduled = NO;
 
         NSString* connectionUrl = [repoInfo connectionURLWithLastSessionID:lastSessionID];
         NSString* ua = [self userAgent];
@@ -133,17 +140,57 @@
 - (void) close {
     FFLog(@"I-RDB083003", @"(wsc:%@) FWebSocketConnection is being closed.", self.connectionId);
     isClosed = YES;
-    [self.webSocket close];
+    // Let the messages sent so far go out before the websocket closes.
+    [self flushPendingMessages];
+    FSRWebSocket* socket = self.webSocket;
+    dispatch_async(self.serializationQueue, ^{
+        [socket close];
+    });
 }
 
 - (void) start {
     // Start is a no-op for websockets.
 }
 
+/**
+ * Messages sent during one turn of the dispatch queue, such as a burst of writes from the persistent connection,
+ * are coalesced: they are serialized together by one block on a background queue, which then writes their frames
+ * in order. Each message still goes out as its own frames, since the server expects one JSON message per frame.
+ */
 - (void) send:(NSDictionary *)dictionary {
 
     [self resetKeepAlive];
 
+    [pendingMessages addObject:dictionary];
+    if (!flushScheduled) {
+        flushScheduled = YES;
+        dispatch_async(self.dispatchQueue, ^{
+            [self flushPendingMessages];
+        });
+    }
+}
+
+- (void) flushPendingMessages {
+    flushScheduled = NO;
+    if (pendingMessages.count == 0) {
+        return;
+    }
+
+    NSArray<NSDictionary *>* messages = pendingMessages;
+    pendingMessages = [NSMutableArray array];
+    FSRWebSocket* socket = self.webSocket;
+    dispatch_async(self.serializationQueue, ^{
+        for (NSDictionary* message in messages) {
+            @autoreleasepool {
+                for (NSString* segment in [FWebSocketConnection framesForMessage:message]) {
+                    [socket send:segment];
+                }
+            }
+        }
+    });
+}
+
++ (NSArray<NSString *> *) framesForMessage:(NSDictionary *)dictionary {
     NSData* jsonData = [NSJSONSerialization dataWithJSONObject:dictionary
                                                        options:kNilOptions error:nil];
 
@@ -151,16 +198,15 @@
                                            encoding:NSUTF8StringEncoding];
 
     NSArray* dataSegs = [FUtilities splitString:data intoMaxSize:kWebsocketMaxFrameSize];
-
-    // First send the header so the server knows how many segments are forthcoming
-    if (dataSegs.count > 1) {
-        [self.webSocket send:[NSString stringWithFormat:@"%u", (unsigned int)dataSegs.count]];
+    if (dataSegs.count <= 1) {
+        return dataSegs;
     }
 
-    // Then, actually send the segments.
-    for(NSString * segment in dataSegs) {
-        [self.webSocket send:segment];
-    }
+    // First send the header so the server knows how many segments are forthcoming
+    NSMutableArray<NSString *>* frames = [NSMutableArray arrayWithCapacity:dataSegs.count + 1];
+    [frames addObject:[NSString stringWithFormat:@"%u", (unsigned int)dataSegs.count]];
+    [frames addObjectsFromArray:dataSegs];
+    return frames;
 }
 
 - (void) nop:(NSTimer *)timer {
@@ -37,4 +37,15 @@
 @property (nonatomic, strong) FImmutableSortedDictionary* children;
 @property (nonatomic, strong) id<FNode> priorityNode;
 
+// Caches kept on the node because it is immutable: a write builds new nodes along its path, and the
+// untouched subtrees keep theirs.
+
+// The hash representation of the subtree as FCompoundHash builds it, and the path of its last leaf,
+// or nil until the subtree has been hashed without being split into several ranges.
+@property (nonatomic, strong) NSString *compoundHashRepresentation;
+@property (nonatomic, strong) NSArray<NSString *> *compoundHashLastLeafPath;
+
+// The size estimated by [FSnapshotUtilities estimateSerializedNodeSize:], or 0 until estimated.
+@property (nonatomic) NSUInteger estimatedSerializedSize;
+
 @end
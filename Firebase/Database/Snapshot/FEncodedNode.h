@@ -0,0 +1,63 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import "FChildrenNode.h"
+
+/**
+ * A node with children that keeps its subtree in a compact binary encoding, and only decodes
+ * what is accessed. Looking up a child decodes just that child, and the sorted dictionary of all
+ * children is built the first time something needs it, such as enumerating or updating the node.
+ *
+ * The encoding of a node is a tag byte, with the high bit set if the node has a priority, followed
+ * by:
+ *  - for strings, a varint length and the UTF-8 bytes;
+ *  - for integers and doubles, 8 little-endian bytes of the value or of its IEEE bits;
+ *  - for booleans, nothing;
+ *  - for children, a varint count, the priority, and for each child in key order a varint length
+ *    and the UTF-8 bytes of its key, then a varint length and the encoding of the child.
+ * The priority of a leaf follows its value. Priorities are encoded as leaves without a priority.
+ */
+@interface FEncodedNode : FChildrenNode
+
+/**
+ * Returns the encoding of the given node, or nil if it is empty.
+ */
++ (NSData *)encodedDataForNode:(id<FNode>)node;
+
+/**
+ * Returns the encoding of the node nodeFrom: would build out of the given value, as written to the
+ * server cache, or nil if it is empty. Unlike nodeFrom:, the value is not validated.
+ */
++ (NSData *)encodedDataForValue:(id)value;
+
+/**
+ * Returns the node that the given encoding represents: an empty node for nil, a leaf node for a
+ * leaf, or an FEncodedNode for a node with children.
+ */
++ (id<FNode>)nodeWithEncodedData:(NSData *)data;
+
+/**
+ * Shorthand for decoding the encoding of the given value, see encodedDataForValue:.
+ */
++ (id<FNode>)nodeWithValue:(id)value;
+
+/**
+ * Whether the sorted dictionary of the children has been built.
+ */
+@property (nonatomic, readonly) BOOL isMaterialized;
+
+@end
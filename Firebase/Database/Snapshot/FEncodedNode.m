@@ -0,0 +1,421 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "FEncodedNode.h"
+#import "FConstants.h"
+#import "FEmptyNode.h"
+#import "FLeafNode.h"
+#import "FUtilities.h"
+
+typedef NS_ENUM(uint8_t, FEncodedNodeTag) {
+    FEncodedNodeTagString = 0x01,
+    FEncodedNodeTagInteger = 0x02,
+    FEncodedNodeTagDouble = 0x03,
+    FEncodedNodeTagTrue = 0x04,
+    FEncodedNodeTagFalse = 0x05,
+    FEncodedNodeTagChildren = 0x06,
+};
+
+static const uint8_t kFEncodedNodeHasPriority = 0x80;
+
+@interface FEncodedNode ()
+// The buffer holding the encoding, which is shared with the nodes of the subtree
+@property (nonatomic, strong, readonly) NSData *data;
+// The range of the encoding of this node in data
+@property (nonatomic, readonly) NSRange range;
+- (id)initWithData:(NSData *)data range:(NSRange)range;
+@end
+
+#pragma mark -
+#pragma mark Writing
+
+static void appendVarint(NSMutableData *data, uint64_t value) {
+    uint8_t bytes[10];
+    size_t length = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        bytes[length++] = value ? (byte | 0x80) : byte;
+    } while (value);
+    [data appendBytes:bytes length:length];
+}
+
+static void appendUInt64(NSMutableData *data, uint64_t value) {
+    value = CFSwapInt64HostToLittle(value);
+    [data appendBytes:&value length:sizeof(value)];
+}
+
+static void appendString(NSMutableData *data, NSString *string) {
+    NSData *utf8 = [string dataUsingEncoding:NSUTF8StringEncoding];
+    appendVarint(data, utf8.length);
+    [data appendData:utf8];
+}
+
+static void appendTag(NSMutableData *data, FEncodedNodeTag tag, BOOL hasPriority) {
+    uint8_t byte = tag | (hasPriority ? kFEncodedNodeHasPriority : 0);
+    [data appendBytes:&byte length:1];
+}
+
+static BOOL isLeafValue(id value) {
+    return [value isKindOfClass:[NSString class]] || [value isKindOfClass:[NSNumber class]];
+}
+
+static void appendLeafValue(NSMutableData *data, id value, BOOL hasPriority) {
+    if ([value isKindOfClass:[NSString class]]) {
+        appendTag(data, FEncodedNodeTagString, hasPriority);
+        appendString(data, value);
+        return;
+    }
+
+    NSNumber *number = value;
+    if ([[FUtilities getJavascriptType:number] isEqualToString:kJavaScriptBoolean]) {
+        appendTag(data, number.boolValue ? FEncodedNodeTagTrue : FEncodedNodeTagFalse, hasPriority);
+        return;
+    }
+    // Unsigned integers too large for int64_t are kept as doubles, like the server does
+    BOOL isHugeUnsigned = strcmp(number.objCType, @encode(unsigned long long)) == 0 &&
+                          number.unsignedLongLongValue > INT64_MAX;
+    if (CFNumberIsFloatType((CFNumberRef)number) || isHugeUnsigned) {
+        double doubleValue = number.doubleValue;
+        uint64_t bits;
+        memcpy(&bits, &doubleValue, sizeof(bits));
+        appendTag(data, FEncodedNodeTagDouble, hasPriority);
+        appendUInt64(data, bits);
+    } else {
+        appendTag(data, FEncodedNodeTagInteger, hasPriority);
+        appendUInt64(data, (uint64_t)number.longLongValue);
+    }
+}
+
+static void appendChildren(NSMutableData *data, NSArray<NSString *> *keys, NSArray<NSData *> *children, id priority) {
+    appendTag(data, FEncodedNodeTagChildren, priority != nil);
+    appendVarint(data, keys.count);
+    if (priority != nil) {
+        appendLeafValue(data, priority, NO);
+    }
+    [keys enumerateObjectsUsingBlock:^(NSString *key, NSUInteger idx, BOOL *stop) {
+        appendString(data, key);
+        appendVarint(data, children[idx].length);
+        [data appendData:children[idx]];
+    }];
+}
+
+static BOOL appendNode(NSMutableData *data, id<FNode> node) {
+    if ([node isEmpty]) {
+        return NO;
+    }
+    if ([node isKindOfClass:[FEncodedNode class]]) {
+        FEncodedNode *encodedNode = (FEncodedNode *)node;
+        [data appendBytes:(const uint8_t *)encodedNode.data.bytes + encodedNode.range.location length:encodedNode.range.length];
+        return YES;
+    }
+
+    id<FNode> priorityNode = [node getPriority];
+    id priority = [priorityNode isEmpty] ? nil : [priorityNode val];
+    if ([node isLeafNode]) {
+        appendLeafValue(data, [node val], priority != nil);
+        if (priority != nil) {
+            appendLeafValue(data, priority, NO);
+        }
+        return YES;
+    }
+
+    NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:[node numChildren]];
+    NSMutableArray<NSData *> *children = [NSMutableArray arrayWithCapacity:[node numChildren]];
+    [node enumerateChildrenUsingBlock:^(NSString *key, id<FNode> child, BOOL *stop) {
+        NSMutableData *childData = [NSMutableData data];
+        if (appendNode(childData, child)) {
+            [keys addObject:key];
+            [children addObject:childData];
+        }
+    }];
+    appendChildren(data, keys, children, priority);
+    return YES;
+}
+
+// Mirrors [FSnapshotUtilities nodeFrom:] for the values written to the server cache
+static BOOL appendValue(NSMutableData *data, id value) {
+    id priority = nil;
+    if ([value isKindOfClass:[NSDictionary class]]) {
+        NSDictionary *dict = value;
+        priority = isLeafValue(dict[kPayloadPriority]) ? dict[kPayloadPriority] : nil;
+        if (dict[kPayloadValue] != nil) {
+            value = dict[kPayloadValue];
+        }
+    }
+
+    if (isLeafValue(value)) {
+        appendLeafValue(data, value, priority != nil);
+        if (priority != nil) {
+            appendLeafValue(data, priority, NO);
+        }
+        return YES;
+    }
+
+    NSMutableDictionary *childValues = nil;
+    if ([value isKindOfClass:[NSDictionary class]]) {
+        childValues = value;
+    } else if ([value isKindOfClass:[NSArray class]]) {
+        NSArray *array = value;
+        childValues = [NSMutableDictionary dictionaryWithCapacity:array.count];
+        [array enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+            childValues[[NSString stringWithFormat:@"%lu", (unsigned long)idx]] = obj;
+        }];
+    } else {
+        return NO;
+    }
+
+    NSArray<NSString *> *sortedKeys = [[childValues allKeys] sortedArrayUsingComparator:[FUtilities keyComparator]];
+    NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:sortedKeys.count];
+    NSMutableArray<NSData *> *children = [NSMutableArray arrayWithCapacity:sortedKeys.count];
+    for (NSString *key in sortedKeys) {
+        if ([key hasPrefix:kPayloadMetadataPrefix]) {
+            continue;
+        }
+        NSMutableData *childData = [NSMutableData data];
+        if (appendValue(childData, childValues[key])) {
+            [keys addObject:key];
+            [children addObject:childData];
+        }
+    }
+    if (keys.count == 0) {
+        return NO;
+    }
+    appendChildren(data, keys, children, priority);
+    return YES;
+}
+
+#pragma mark -
+#pragma mark Reading
+
+typedef struct {
+    const uint8_t *bytes;
+    NSUInteger offset;
+    NSUInteger end;
+} FEncodedNodeReader;
+
+static FEncodedNodeReader readerForRange(NSData *data, NSRange range) {
+    FEncodedNodeReader reader = {data.bytes, range.location, NSMaxRange(range)};
+    return reader;
+}
+
+static void failDecoding(void) {
+    [NSException raise:NSInternalInconsistencyException format:@"Failed to decode encoded node"];
+}
+
+static uint8_t readByte(FEncodedNodeReader *reader) {
+    if (reader->offset >= reader->end) {
+        failDecoding();
+    }
+    return reader->bytes[reader->offset++];
+}
+
+static uint64_t readVarint(FEncodedNodeReader *reader) {
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = readByte(reader);
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    failDecoding();
+    return 0;
+}
+
+// Returns the range of the next length-prefixed field, and moves past it
+static NSRange readLengthPrefixedRange(FEncodedNodeReader *reader) {
+    uint64_t length = readVarint(reader);
+    if (length > reader->end - reader->offset) {
+        failDecoding();
+    }
+    NSRange range = NSMakeRange(reader->offset, (NSUInteger)length);
+    reader->offset += (NSUInteger)length;
+    return range;
+}
+
+static uint64_t readUInt64(FEncodedNodeReader *reader) {
+    if (reader->end - reader->offset < sizeof(uint64_t)) {
+        failDecoding();
+    }
+    uint64_t value;
+    memcpy(&value, reader->bytes + reader->offset, sizeof(value));
+    reader->offset += sizeof(value);
+    return CFSwapInt64LittleToHost(value);
+}
+
+static id readLeafValue(FEncodedNodeReader *reader, uint8_t tag) {
+    switch (tag) {
+        case FEncodedNodeTagString: {
+            NSRange range = readLengthPrefixedRange(reader);
+            return [[NSString alloc] initWithBytes:reader->bytes + range.location length:range.length encoding:NSUTF8StringEncoding];
+        }
+        case FEncodedNodeTagInteger:
+            return [NSNumber numberWithLongLong:(int64_t)readUInt64(reader)];
+        case FEncodedNodeTagDouble: {
+            uint64_t bits = readUInt64(reader);
+            double doubleValue;
+            memcpy(&doubleValue, &bits, sizeof(doubleValue));
+            return [NSNumber numberWithDouble:doubleValue];
+        }
+        case FEncodedNodeTagTrue:
+            return @YES;
+        case FEncodedNodeTagFalse:
+            return @NO;
+    }
+    failDecoding();
+    return nil;
+}
+
+static id<FNode> readPriority(FEncodedNodeReader *reader) {
+    return [[FLeafNode alloc] initWithValue:readLeafValue(reader, readByte(reader))];
+}
+
+static id<FNode> nodeForRange(NSData *data, NSRange range) {
+    FEncodedNodeReader reader = readerForRange(data, range);
+    uint8_t tag = readByte(&reader);
+    if ((tag & ~kFEncodedNodeHasPriority) == FEncodedNodeTagChildren) {
+        return [[FEncodedNode alloc] initWithData:data range:range];
+    }
+    id value = readLeafValue(&reader, tag & ~kFEncodedNodeHasPriority);
+    id<FNode> priority = (tag & kFEncodedNodeHasPriority) ? readPriority(&reader) : [FEmptyNode emptyNode];
+    return [[FLeafNode alloc] initWithValue:value withPriority:priority];
+}
+
+@implementation FEncodedNode {
+    // The number of children, and the offset in data of the entry of the first one
+    int _count;
+    NSUInteger _entriesOffset;
+    FImmutableSortedDictionary *_materializedChildren;
+}
+
++ (NSData *)encodedDataForNode:(id<FNode>)node {
+    NSMutableData *data = [NSMutableData data];
+    return appendNode(data, node) ? data : nil;
+}
+
++ (NSData *)encodedDataForValue:(id)value {
+    NSMutableData *data = [NSMutableData data];
+    return appendValue(data, value) ? data : nil;
+}
+
++ (id<FNode>)nodeWithEncodedData:(NSData *)data {
+    if (data.length == 0) {
+        return [FEmptyNode emptyNode];
+    }
+    return nodeForRange(data, NSMakeRange(0, data.length));
+}
+
++ (id<FNode>)nodeWithValue:(id)value {
+    return [self nodeWithEncodedData:[self encodedDataForValue:value]];
+}
+
+- (id)initWithData:(NSData *)data range:(NSRange)range {
+    FEncodedNodeReader reader = readerForRange(data, range);
+    uint8_t tag = readByte(&reader);
+    uint64_t count = readVarint(&reader);
+    if (count == 0 || count > INT_MAX) {
+        failDecoding();
+    }
+    id<FNode> priority = (tag & kFEncodedNodeHasPriority) ? readPriority(&reader) : nil;
+
+    self = [super initWithPriority:priority children:nil];
+    if (self) {
+        _data = data;
+        _range = range;
+        _count = (int)count;
+        _entriesOffset = reader.offset;
+    }
+    return self;
+}
+
+// Calls the block with the key and the range of the encoding of each child, in key order
+- (void)enumerateEntriesUsingBlock:(void (^)(NSRange keyRange, NSRange childRange, BOOL *stop))block {
+    FEncodedNodeReader reader = readerForRange(self.data, self.range);
+    reader.offset = _entriesOffset;
+    BOOL stop = NO;
+    for (int i = 0; i < _count && !stop; i++) {
+        NSRange keyRange = readLengthPrefixedRange(&reader);
+        NSRange childRange = readLengthPrefixedRange(&reader);
+        block(keyRange, childRange, &stop);
+    }
+}
+
+- (NSString *)keyForRange:(NSRange)keyRange {
+    return [[NSString alloc] initWithBytes:(const uint8_t *)self.data.bytes + keyRange.location length:keyRange.length encoding:NSUTF8StringEncoding];
+}
+
+- (BOOL)isMaterialized {
+    return _materializedChildren != nil;
+}
+
+#pragma mark -
+#pragma mark FChildrenNode overrides
+
+- (FImmutableSortedDictionary *)children {
+    if (_materializedChildren == nil) {
+        // Entries are encoded in key order, so the dictionary can be built without sorting them again
+        NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:_count];
+        NSMutableArray<id<FNode>> *children = [NSMutableArray arrayWithCapacity:_count];
+        [self enumerateEntriesUsingBlock:^(NSRange keyRange, NSRange childRange, BOOL *stop) {
+            [keys addObject:[self keyForRange:keyRange]];
+            [children addObject:nodeForRange(self.data, childRange)];
+        }];
+        _materializedChildren = [FImmutableSortedDictionary fromSortedKeys:keys values:children withComparator:[FUtilities keyComparator]];
+    }
+    return _materializedChildren;
+}
+
+- (void)setChildren:(FImmutableSortedDictionary *)children {
+    _materializedChildren = children;
+}
+
+- (id<FNode>)getImmediateChild:(NSString *)childName {
+    if (_materializedChildren != nil || [childName isEqualToString:@".priority"]) {
+        return [super getImmediateChild:childName];
+    }
+
+    NSData *utf8 = [childName dataUsingEncoding:NSUTF8StringEncoding];
+    const uint8_t *bytes = self.data.bytes;
+    __block id<FNode> child = nil;
+    [self enumerateEntriesUsingBlock:^(NSRange keyRange, NSRange childRange, BOOL *stop) {
+        if (keyRange.length == utf8.length && memcmp(bytes + keyRange.location, utf8.bytes, utf8.length) == 0) {
+            child = nodeForRange(self.data, childRange);
+            *stop = YES;
+        }
+    }];
+    return child ?: [FEmptyNode emptyNode];
+}
+
+- (BOOL)isEmpty {
+    return _count == 0;
+}
+
+- (int)numChildren {
+    return _count;
+}
+
+- (void)enumerateChildrenUsingBlock:(void (^)(NSString *, id<FNode>, BOOL *))block {
+    if (_materializedChildren != nil) {
+        [super enumerateChildrenUsingBlock:block];
+        return;
+    }
+    [self enumerateEntriesUsingBlock:^(NSRange keyRange, NSRange childRange, BOOL *stop) {
+        block([self keyForRange:keyRange], nodeForRange(self.data, childRange), stop);
+    }];
+}
+
+@end
@@ -37,6 +37,21 @@
 - (FIndexedNode *)updateChild:(NSString *)key withNewChild:(id<FNode>)newChildNode;
 - (FIndexedNode *)updatePriority:(id<FNode>)priority;
 
+/**
+ * Returns an indexed node for newNode, which must differ from this node only in the children given, with changed
+ * children listed as both removed (with their old value) and added. Rather than sorting all the children of newNode
+ * again, the index of this node is carried over with just those children removed and added.
+ */
+- (FIndexedNode *)updateNode:(id<FNode>)newNode
+             removedChildren:(NSArray<FNamedNode *> *)removedChildren
+               addedChildren:(NSArray<FNamedNode *> *)addedChildren;
+
+/**
+ * Whether the children of this node have already been sorted by its index, in which case updateNode:... is cheaper
+ * than indexing the new node from scratch.
+ */
+- (BOOL)hasSortedChildren;
+
 - (FNamedNode *)firstChild;
 - (FNamedNode *)lastChild;
 
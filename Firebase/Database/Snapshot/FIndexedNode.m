@@ -128,6 +128,39 @@ static FImmutableSortedSet *FALLBACK_INDEX;
     }
 }
 
+- (FIndexedNode *)updateNode:(id<FNode>)newNode
+             removedChildren:(NSArray<FNamedNode *> *)removedChildren
+               addedChildren:(NSArray<FNamedNode *> *)addedChildren
+{
+    if (self.indexed == [FIndexedNode fallbackIndex]) {
+        for (FNamedNode *child in addedChildren) {
+            if ([self.index isDefinedOn:child.node]) {
+                // The new children may need an index, index lazily
+                return [[FIndexedNode alloc] initWithNode:newNode index:self.index];
+            }
+        }
+        // None of the new children affect the index, no need to create one
+        return [[FIndexedNode alloc] initWithNode:newNode index:self.index indexed:[FIndexedNode fallbackIndex]];
+    } else if (!self.indexed) {
+        // No need to index yet, index lazily
+        return [[FIndexedNode alloc] initWithNode:newNode index:self.index];
+    } else {
+        FImmutableSortedSet *newIndexed = self.indexed;
+        for (FNamedNode *child in removedChildren) {
+            newIndexed = [newIndexed removeObject:child];
+        }
+        for (FNamedNode *child in addedChildren) {
+            newIndexed = [newIndexed addObject:child];
+        }
+        return [[FIndexedNode alloc] initWithNode:newNode index:self.index indexed:newIndexed];
+    }
+}
+
+- (BOOL)hasSortedChildren
+{
+    return self.indexed != nil && self.indexed != [FIndexedNode fallbackIndex];
+}
+
 - (FIndexedNode *)updatePriority:(id<FNode>)priority
 {
     return [[FIndexedNode alloc] initWithNode:[self.node updatePriority:priority]
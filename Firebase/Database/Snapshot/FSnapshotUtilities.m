@@ -288,12 +288,17 @@
         return [FSnapshotUtilities estimateLeafNodeSize:node];
     } else {
         NSAssert([node isKindOfClass:[FChildrenNode class]], @"Unexpected node type: %@", [node class]);
+        FChildrenNode *childrenNode = (FChildrenNode *)node;
+        if (childrenNode.estimatedSerializedSize > 0) {
+            return childrenNode.estimatedSerializedSize;
+        }
         __block NSUInteger sum = 1; // opening brackets
-        [((FChildrenNode *)node) enumerateChildrenAndPriorityUsingBlock:^(NSString *key, id<FNode>child, BOOL *stop) {
+        [childrenNode enumerateChildrenAndPriorityUsingBlock:^(NSString *key, id<FNode>child, BOOL *stop) {
             sum += key.length;
             sum += 4; // quotes around key and colon and (comma or closing bracket)
             sum += [FSnapshotUtilities estimateSerializedNodeSize:child];
         }];
+        childrenNode.estimatedSerializedSize = sum;
         return sum;
     }
 }
@@ -12,6 +12,7 @@
 + (FArraySortedDictionary *)fromDictionary:(NSDictionary *)dictionary withComparator:(NSComparator)comparator;
 
 - (id)initWithComparator:(NSComparator)comparator;
+- (id)initWithComparator:(NSComparator)comparator keys:(NSArray *)keys values:(NSArray *)values;
 
 #pragma mark -
 #pragma mark Properties
@@ -26,6 +26,11 @@
 
 + (FImmutableSortedDictionary *)dictionaryWithComparator:(NSComparator)comparator;
 + (FImmutableSortedDictionary *)fromDictionary:(NSDictionary *)dictionary withComparator:(NSComparator)comparator;
+/**
+ * Builds a dictionary from keys that are already in ascending order according to the comparator, and the values at the
+ * same positions, without sorting them again. Throws if the keys are out of order or contain duplicates.
+ */
++ (FImmutableSortedDictionary *)fromSortedKeys:(NSArray *)keys values:(NSArray *)values withComparator:(NSComparator)comparator;
 
 - (FImmutableSortedDictionary *) insertKey:(id)aKey withValue:(id)aValue;
 - (FImmutableSortedDictionary *) removeKey:(id)aKey;
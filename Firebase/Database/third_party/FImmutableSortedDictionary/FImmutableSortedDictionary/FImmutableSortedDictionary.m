@@ -24,6 +24,23 @@
     }
 }
 
++ (FImmutableSortedDictionary *)fromSortedKeys:(NSArray *)keys values:(NSArray *)values withComparator:(NSComparator)comparator
+{
+    NSAssert(keys.count == values.count, @"Need as many values as keys");
+    [keys enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+        if (idx > 0) {
+            if (comparator(keys[idx - 1], obj) != NSOrderedAscending) {
+                [NSException raise:NSInvalidArgumentException format:@"Can't create FImmutableSortedDictionary with keys with same ordering!"];
+            }
+        }
+    }];
+    if (keys.count <= SORTED_DICTIONARY_ARRAY_TO_RB_TREE_SIZE_THRESHOLD) {
+        return [[FArraySortedDictionary alloc] initWithComparator:comparator keys:[keys copy] values:[values copy]];
+    } else {
+        return [FTreeSortedDictionary fromSortedKeys:keys values:values withComparator:comparator];
+    }
+}
+
 - (FImmutableSortedDictionary *) insertKey:(id)aKey withValue:(id)aValue {
     THROW_ABSTRACT_METHOD_EXCEPTION(@selector(insertKey:withValue:));
 }
@@ -23,6 +23,11 @@
 
 - (id)initWithComparator:(NSComparator)aComparator;
 
+/**
+ * Builds a balanced tree from keys in ascending order and the values at the same positions. Doesn't check the order.
+ */
++ (FTreeSortedDictionary *)fromSortedKeys:(NSArray *)keys values:(NSArray *)values withComparator:(NSComparator)comparator;
+
 // Override methods to return subtype
 - (FTreeSortedDictionary *) insertKey:(id)aKey withValue:(id)aValue;
 - (FTreeSortedDictionary *) removeKey:(id)aKey;
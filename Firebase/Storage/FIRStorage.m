@@ -30,6 +30,7 @@
 
 #import <GTMSessionFetcher/GTMSessionFetcher.h>
 #import <GTMSessionFetcher/GTMSessionFetcherLogging.h>
+#import <GTMSessionFetcher/GTMSessionUploadFetcher.h>
 
 static NSMutableDictionary<
     NSString * /* app name */,
@@ -154,6 +155,8 @@ static GTMSessionFetcherRetryBlock _retryWhenOffline;
     _maxDownloadRetryTime = 600.0;
     _maxOperationRetryTime = 120.0;
     _maxUploadRetryTime = 600.0;
+    _uploadChunkSizeBytes = kGTMSessionUploadFetcherStandardChunkSize;
+    _maxParallelDownloadRanges = 4;
   }
   return self;
 }
@@ -171,6 +174,9 @@ static GTMSessionFetcherRetryBlock _retryWhenOffline;
                                                                 bucket:_storageBucket
                                                                   auth:_auth];
   storage.callbackQueue = _callbackQueue;
+  storage.uploadChunkSizeBytes = _uploadChunkSizeBytes;
+  storage.downloadRangeSizeBytes = _downloadRangeSizeBytes;
+  storage.maxParallelDownloadRanges = _maxParallelDownloadRanges;
   return storage;
 }
 
@@ -19,7 +19,25 @@
 #import "FIRStorageObservableTask_Private.h"
 #import "FIRStorageTask_Private.h"
 
-@implementation FIRStorageDownloadTask
+/** The extension of the file next to a ranged download recording the ranges written so far. */
+static NSString *const kFIRStorageRangedDownloadStateExtension = @"firdownload";
+
+static NSString *const kFIRStorageRangedDownloadTotalLengthKey = @"totalLength";
+static NSString *const kFIRStorageRangedDownloadRangeSizeKey = @"rangeSize";
+static NSString *const kFIRStorageRangedDownloadETagKey = @"etag";
+static NSString *const kFIRStorageRangedDownloadCompletedRangesKey = @"completedRanges";
+
+@implementation FIRStorageDownloadTask {
+  // State of a download split into byte ranges, see FIRStorage#downloadRangeSizeBytes. Only
+  // accessed on the dispatch queue.
+  int64_t _rangeSize;
+  // The size of the object, or -1 until the first range response arrives.
+  int64_t _rangeTotalLength;
+  NSString *_rangeETag;
+  NSMutableIndexSet *_completedRanges;
+  NSMutableDictionary<NSNumber *, GTMSessionFetcher *> *_rangeFetchers;
+  NSMutableDictionary<NSNumber *, NSNumber *> *_rangeBytesReceived;
+}
 
 @synthesize progress = _progress;
 @synthesize fetcher = _fetcher;
@@ -39,6 +57,9 @@
 
 - (void)dealloc {
   [_fetcher stopFetching];
+  for (GTMSessionFetcher *fetcher in [_rangeFetchers allValues]) {
+    [fetcher stopFetching];
+  }
 }
 
 - (void)enqueue {
@@ -56,13 +77,13 @@
     }
 
     strongSelf.state = FIRStorageTaskStateQueueing;
-    NSMutableURLRequest *request = [strongSelf.baseRequest mutableCopy];
-    request.HTTPMethod = @"GET";
-    request.timeoutInterval = strongSelf.reference.storage.maxDownloadRetryTime;
-    NSURLComponents *components = [NSURLComponents componentsWithURL:request.URL
-                                             resolvingAgainstBaseURL:NO];
-    [components setQuery:@"alt=media"];
-    request.URL = components.URL;
+
+    if (strongSelf->_fileURL && strongSelf.reference.storage.downloadRangeSizeBytes > 0) {
+      [strongSelf enqueueRanges];
+      return;
+    }
+
+    NSMutableURLRequest *request = [strongSelf mediaRequest];
 
     GTMSessionFetcher *fetcher;
     if (resumeData) {
@@ -145,6 +166,329 @@
   }];
 }
 
+- (NSMutableURLRequest *)mediaRequest {
+  NSMutableURLRequest *request = [self.baseRequest mutableCopy];
+  request.HTTPMethod = @"GET";
+  request.timeoutInterval = self.reference.storage.maxDownloadRetryTime;
+  NSURLComponents *components = [NSURLComponents componentsWithURL:request.URL
+                                           resolvingAgainstBaseURL:NO];
+  [components setQuery:@"alt=media"];
+  request.URL = components.URL;
+  return request;
+}
+
+#pragma mark - Ranged Downloads
+
+- (void)enqueueRanges {
+  if (!_completedRanges) {
+    [self loadRangeState];
+  }
+  self.state = FIRStorageTaskStateRunning;
+  [self fetchMissingRanges];
+}
+
+- (NSURL *)rangeStateURL {
+  return [_fileURL URLByAppendingPathExtension:kFIRStorageRangedDownloadStateExtension];
+}
+
+// Picks up the ranges an earlier download of the same file wrote, if it used the same range size.
+- (void)loadRangeState {
+  _rangeSize = self.reference.storage.downloadRangeSizeBytes;
+  _rangeTotalLength = -1;
+  _rangeETag = nil;
+  _completedRanges = [NSMutableIndexSet indexSet];
+  _rangeFetchers = [NSMutableDictionary dictionary];
+  _rangeBytesReceived = [NSMutableDictionary dictionary];
+
+  NSDictionary *state = [NSDictionary dictionaryWithContentsOfURL:[self rangeStateURL]];
+  NSNumber *totalLength = state[kFIRStorageRangedDownloadTotalLengthKey];
+  if ([state[kFIRStorageRangedDownloadRangeSizeKey] longLongValue] != _rangeSize ||
+      !totalLength) {
+    return;
+  }
+  NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:_fileURL.path
+                                                                              error:NULL];
+  if ([attributes fileSize] != [totalLength unsignedLongLongValue]) {
+    return;
+  }
+
+  _rangeTotalLength = [totalLength longLongValue];
+  _rangeETag = state[kFIRStorageRangedDownloadETagKey];
+  NSUInteger rangeCount = [self rangeCount];
+  for (NSNumber *index in state[kFIRStorageRangedDownloadCompletedRangesKey]) {
+    if ([index unsignedIntegerValue] < rangeCount) {
+      [_completedRanges addIndex:[index unsignedIntegerValue]];
+    }
+  }
+}
+
+- (void)saveRangeState {
+  NSMutableArray<NSNumber *> *completedRanges = [NSMutableArray array];
+  [_completedRanges enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+    [completedRanges addObject:@(index)];
+  }];
+  NSMutableDictionary *state = [@{
+    kFIRStorageRangedDownloadTotalLengthKey : @(_rangeTotalLength),
+    kFIRStorageRangedDownloadRangeSizeKey : @(_rangeSize),
+    kFIRStorageRangedDownloadCompletedRangesKey : completedRanges,
+  } mutableCopy];
+  state[kFIRStorageRangedDownloadETagKey] = _rangeETag;
+  [state writeToURL:[self rangeStateURL] atomically:YES];
+}
+
+// Forgets all ranges written so far, because the object changed while it was being downloaded.
+- (void)resetRanges {
+  [self stopRangeFetchers];
+  [[NSFileManager defaultManager] removeItemAtURL:[self rangeStateURL] error:NULL];
+  _rangeTotalLength = -1;
+  _rangeETag = nil;
+  [_completedRanges removeAllIndexes];
+}
+
+- (NSUInteger)rangeCount {
+  if (_rangeTotalLength < 0) {
+    return 1;
+  }
+  return (NSUInteger)((_rangeTotalLength + _rangeSize - 1) / _rangeSize);
+}
+
+- (int64_t)rangeLengthAtIndex:(NSUInteger)index {
+  int64_t start = (int64_t)index * _rangeSize;
+  return MIN(_rangeSize, _rangeTotalLength - start);
+}
+
+- (void)stopRangeFetchers {
+  for (GTMSessionFetcher *fetcher in [_rangeFetchers allValues]) {
+    [fetcher stopFetching];
+  }
+  [_rangeFetchers removeAllObjects];
+  [_rangeBytesReceived removeAllObjects];
+}
+
+- (void)fetchMissingRanges {
+  if (self.state != FIRStorageTaskStateRunning) {
+    return;
+  }
+
+  // Until the first response tells the size of the object, only its first range is requested.
+  NSUInteger rangeCount = [self rangeCount];
+  NSUInteger maxInFlight = 1;
+  if (_rangeTotalLength >= 0) {
+    maxInFlight = (NSUInteger)MAX(1, self.reference.storage.maxParallelDownloadRanges);
+  }
+  for (NSUInteger index = 0; index < rangeCount && _rangeFetchers.count < maxInFlight; index++) {
+    if (![_completedRanges containsIndex:index] && !_rangeFetchers[@(index)]) {
+      [self fetchRangeAtIndex:index];
+    }
+  }
+
+  if (_rangeFetchers.count == 0 && _completedRanges.count == rangeCount) {
+    [self finishRangedDownload];
+  }
+}
+
+- (void)fetchRangeAtIndex:(NSUInteger)index {
+  int64_t start = (int64_t)index * _rangeSize;
+  int64_t end = start + _rangeSize - 1;
+  if (_rangeTotalLength >= 0) {
+    end = MIN(end, _rangeTotalLength - 1);
+  }
+
+  NSMutableURLRequest *request = [self mediaRequest];
+  NSString *range = [NSString stringWithFormat:@"bytes=%lld-%lld", start, end];
+  [request setValue:range forHTTPHeaderField:@"Range"];
+
+  GTMSessionFetcher *fetcher = [self.fetcherService fetcherWithRequest:request];
+  fetcher.comment = @"Ranged DownloadTask";
+  fetcher.maxRetryInterval = self.reference.storage.maxDownloadRetryTime;
+
+  __weak FIRStorageDownloadTask *weakSelf = self;
+  [fetcher setReceivedProgressBlock:^(int64_t bytesWritten, int64_t totalBytesWritten) {
+    [weakSelf dispatchAsync:^() {
+      [weakSelf updateRangeAtIndex:index bytesReceived:totalBytesWritten];
+    }];
+  }];
+
+  _rangeFetchers[@(index)] = fetcher;
+  [fetcher beginFetchWithCompletionHandler:^(NSData *data, NSError *error) {
+    [weakSelf dispatchAsync:^() {
+      [weakSelf completeRangeAtIndex:index fetcher:fetcher data:data error:error];
+    }];
+  }];
+}
+
+- (void)updateRangeAtIndex:(NSUInteger)index bytesReceived:(int64_t)bytesReceived {
+  if (!_rangeFetchers[@(index)]) {
+    return;
+  }
+  _rangeBytesReceived[@(index)] = @(bytesReceived);
+  [self fireRangeProgress];
+}
+
+- (void)fireRangeProgress {
+  int64_t completedBytes = 0;
+  if (_rangeTotalLength >= 0) {
+    completedBytes = (int64_t)_completedRanges.count * _rangeSize;
+    if ([_completedRanges containsIndex:[self rangeCount] - 1]) {
+      completedBytes -= _rangeSize - [self rangeLengthAtIndex:[self rangeCount] - 1];
+    }
+  }
+  for (NSNumber *bytesReceived in [_rangeBytesReceived allValues]) {
+    completedBytes += [bytesReceived longLongValue];
+  }
+
+  self.state = FIRStorageTaskStateProgress;
+  self.progress.completedUnitCount = completedBytes;
+  self.progress.totalUnitCount = MAX(_rangeTotalLength, 0);
+  [self fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:self.snapshot];
+  self.state = FIRStorageTaskStateRunning;
+}
+
+- (void)completeRangeAtIndex:(NSUInteger)index
+                     fetcher:(GTMSessionFetcher *)fetcher
+                        data:(NSData *)data
+                       error:(NSError *)error {
+  // Fetchers stopped by a pause or cancellation are no longer tracked.
+  if (_rangeFetchers[@(index)] != fetcher) {
+    return;
+  }
+  [_rangeFetchers removeObjectForKey:@(index)];
+  [_rangeBytesReceived removeObjectForKey:@(index)];
+
+  NSHTTPURLResponse *response = (NSHTTPURLResponse *)fetcher.response;
+  if (error) {
+    // An empty object has no range to satisfy the first request.
+    if (_rangeTotalLength < 0 && fetcher.statusCode == 416) {
+      [self writeWholeFileWithData:[NSData data]];
+      return;
+    }
+    [self failRangedDownloadWithError:error];
+    return;
+  }
+
+  NSString *etag = response.allHeaderFields[@"ETag"];
+  if (_rangeETag && etag && ![etag isEqualToString:_rangeETag]) {
+    [self resetRanges];
+    [self fetchMissingRanges];
+    return;
+  }
+
+  // A server that ignores the Range header sends the whole object.
+  if (fetcher.statusCode != 206) {
+    [self writeWholeFileWithData:data];
+    return;
+  }
+
+  NSError *fileError;
+  if (_rangeTotalLength < 0) {
+    NSString *contentRange = response.allHeaderFields[@"Content-Range"];
+    int64_t totalLength = [self totalLengthFromContentRange:contentRange];
+    if (totalLength < 0) {
+      [self failRangedDownloadWithError:[FIRStorageErrors errorWithInvalidRequest:data]];
+      return;
+    }
+    if (![self prepareFileWithLength:totalLength error:&fileError]) {
+      [self failRangedDownloadWithError:fileError];
+      return;
+    }
+    _rangeTotalLength = totalLength;
+    _rangeETag = etag;
+  }
+
+  if (![self writeData:data atOffset:(int64_t)index * _rangeSize error:&fileError]) {
+    [self failRangedDownloadWithError:fileError];
+    return;
+  }
+  [_completedRanges addIndex:index];
+  [self saveRangeState];
+
+  [self fireRangeProgress];
+  [self fetchMissingRanges];
+}
+
+// Parses the total length out of a Content-Range header of the form "bytes 0-99/1234".
+- (int64_t)totalLengthFromContentRange:(NSString *)contentRange {
+  NSRange slash = [contentRange rangeOfString:@"/" options:NSBackwardsSearch];
+  if (slash.location == NSNotFound) {
+    return -1;
+  }
+  NSString *total = [contentRange substringFromIndex:NSMaxRange(slash)];
+  NSScanner *scanner = [NSScanner scannerWithString:total];
+  long long totalLength;
+  if (![scanner scanLongLong:&totalLength] || !scanner.isAtEnd || totalLength < 0) {
+    return -1;
+  }
+  return totalLength;
+}
+
+- (BOOL)prepareFileWithLength:(int64_t)length error:(NSError **)error {
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  if (![fileManager createDirectoryAtURL:[_fileURL URLByDeletingLastPathComponent]
+             withIntermediateDirectories:YES
+                              attributes:nil
+                                   error:error]) {
+    return NO;
+  }
+  if (![fileManager createFileAtPath:_fileURL.path contents:nil attributes:nil]) {
+    if (error) {
+      NSString *message =
+          [NSString stringWithFormat:@"Unable to create file at URL: %@.", _fileURL.absoluteString];
+      *error = [FIRStorageErrors errorWithCustomMessage:message];
+    }
+    return NO;
+  }
+  NSFileHandle *handle = [NSFileHandle fileHandleForWritingToURL:_fileURL error:error];
+  if (!handle) {
+    return NO;
+  }
+  [handle truncateFileAtOffset:(unsigned long long)length];
+  [handle closeFile];
+  return YES;
+}
+
+- (BOOL)writeData:(NSData *)data atOffset:(int64_t)offset error:(NSError **)error {
+  NSFileHandle *handle = [NSFileHandle fileHandleForWritingToURL:_fileURL error:error];
+  if (!handle) {
+    return NO;
+  }
+  [handle seekToFileOffset:(unsigned long long)offset];
+  [handle writeData:data];
+  [handle closeFile];
+  return YES;
+}
+
+- (void)writeWholeFileWithData:(NSData *)data {
+  NSError *fileError;
+  if (![self prepareFileWithLength:0 error:&fileError] ||
+      ![self writeData:data atOffset:0 error:&fileError]) {
+    [self failRangedDownloadWithError:fileError];
+    return;
+  }
+  [self stopRangeFetchers];
+  _rangeTotalLength = (int64_t)data.length;
+  [self finishRangedDownload];
+}
+
+- (void)finishRangedDownload {
+  [[NSFileManager defaultManager] removeItemAtURL:[self rangeStateURL] error:NULL];
+  self.progress.completedUnitCount = _rangeTotalLength;
+  self.progress.totalUnitCount = _rangeTotalLength;
+  [self fireHandlersForStatus:FIRStorageTaskStatusProgress snapshot:self.snapshot];
+
+  self.state = FIRStorageTaskStateSuccess;
+  [self fireHandlersForStatus:FIRStorageTaskStatusSuccess snapshot:self.snapshot];
+  [self removeAllObservers];
+}
+
+// Keeps the ranges written so far, so that a later download of the same file continues them.
+- (void)failRangedDownloadWithError:(NSError *)error {
+  [self stopRangeFetchers];
+  self.state = FIRStorageTaskStateFailed;
+  self.error = [FIRStorageErrors errorWithServerError:error reference:self.reference];
+  [self fireHandlersForStatus:FIRStorageTaskStatusFailure snapshot:self.snapshot];
+  [self removeAllObservers];
+}
+
 #pragma mark - Download Management
 
 - (void)cancel {
@@ -157,6 +501,7 @@
   [self dispatchAsync:^() {
     weakSelf.state = FIRStorageTaskStateCancelled;
     [weakSelf.fetcher stopFetching];
+    [weakSelf stopRangeFetchers];
     weakSelf.error = error;
     [weakSelf fireHandlersForStatus:FIRStorageTaskStatusFailure snapshot:weakSelf.snapshot];
   }];
@@ -167,6 +512,7 @@
   [self dispatchAsync:^() {
     weakSelf.state = FIRStorageTaskStatePausing;
     [weakSelf.fetcher stopFetching];
+    [weakSelf stopRangeFetchers];
     // Give the resume callback a chance to run (if scheduled)
     [weakSelf.fetcher waitForCompletionWithTimeout:0.001];
     weakSelf.state = FIRStorageTaskStatePaused;
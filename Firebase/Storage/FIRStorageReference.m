@@ -196,17 +196,9 @@
   return task;
 }
 
-- (FIRStorageUploadTask *)putFile:(NSURL *)fileURL {
-  return [self putFile:fileURL metadata:nil completion:nil];
-}
-
-- (FIRStorageUploadTask *)putFile:(NSURL *)fileURL
-                         metadata:(nullable FIRStorageMetadata *)metadata {
-  return [self putFile:fileURL metadata:metadata completion:nil];
-}
-
 - (FIRStorageUploadTask *)putFile:(NSURL *)fileURL
                          metadata:(nullable FIRStorageMetadata *)metadata
+                 uploadSessionURL:(nullable NSURL *)uploadSessionURL
                        completion:(nullable FIRStorageVoidMetadataError)completion {
   if (!metadata) {
     metadata = [[FIRStorageMetadata alloc] init];
@@ -219,7 +211,8 @@
                                        fetcherService:_storage.fetcherServiceForApp
                                         dispatchQueue:_storage.dispatchQueue
                                                  file:fileURL
-                                             metadata:metadata];
+                                             metadata:metadata
+                                     uploadSessionURL:uploadSessionURL];
 
   if (completion) {
     dispatch_queue_t callbackQueue = _storage.fetcherServiceForApp.callbackQueue;
@@ -244,6 +237,31 @@
   return task;
 }
 
+- (FIRStorageUploadTask *)putFile:(NSURL *)fileURL {
+  return [self putFile:fileURL metadata:nil completion:nil];
+}
+
+- (FIRStorageUploadTask *)putFile:(NSURL *)fileURL
+                         metadata:(nullable FIRStorageMetadata *)metadata {
+  return [self putFile:fileURL metadata:metadata completion:nil];
+}
+
+- (FIRStorageUploadTask *)putFile:(NSURL *)fileURL
+                         metadata:(nullable FIRStorageMetadata *)metadata
+                       completion:(nullable FIRStorageVoidMetadataError)completion {
+  return [self putFile:fileURL metadata:metadata uploadSessionURL:nil completion:completion];
+}
+
+- (FIRStorageUploadTask *)putFile:(NSURL *)fileURL
+                         metadata:(nullable FIRStorageMetadata *)metadata
+            resumingUploadSession:(NSURL *)uploadSessionURL
+                       completion:(nullable FIRStorageVoidMetadataError)completion {
+  return [self putFile:fileURL
+              metadata:metadata
+      uploadSessionURL:uploadSessionURL
+            completion:completion];
+}
+
 #pragma mark - Downloads
 
 - (FIRStorageDownloadTask *)dataWithMaxSize:(int64_t)size
@@ -22,7 +22,13 @@
 
 #import <GTMSessionFetcher/GTMSessionUploadFetcher.h>
 
-@implementation FIRStorageUploadTask
+/** Resumable uploads must send whole multiples of this many bytes in every chunk but the last. */
+static const int64_t kFIRStorageUploadChunkGranularity = 256 * 1024;
+
+@implementation FIRStorageUploadTask {
+  // The session to continue instead of starting a new upload, if any.
+  NSURL *_resumedUploadSessionURL;
+}
 
 @synthesize progress = _progress;
 @synthesize fetcherCompletion = _fetcherCompletion;
@@ -50,10 +56,25 @@
                     dispatchQueue:(dispatch_queue_t)queue
                              file:(NSURL *)fileURL
                          metadata:(FIRStorageMetadata *)metadata {
+  return [self initWithReference:reference
+                  fetcherService:service
+                   dispatchQueue:queue
+                            file:fileURL
+                        metadata:metadata
+                uploadSessionURL:nil];
+}
+
+- (instancetype)initWithReference:(FIRStorageReference *)reference
+                   fetcherService:(GTMSessionFetcherService *)service
+                    dispatchQueue:(dispatch_queue_t)queue
+                             file:(NSURL *)fileURL
+                         metadata:(FIRStorageMetadata *)metadata
+                 uploadSessionURL:(nullable NSURL *)uploadSessionURL {
   self = [super initWithReference:reference fetcherService:service dispatchQueue:queue];
   if (self) {
     _uploadMetadata = [metadata copy];
     _fileURL = [fileURL copy];
+    _resumedUploadSessionURL = [uploadSessionURL copy];
     _progress = [NSProgress progressWithTotalUnitCount:0];
 
     NSString *mimeType = [FIRStorageUtils MIMETypeForExtension:[_fileURL pathExtension]];
@@ -69,6 +90,18 @@
   [_uploadFetcher stopFetching];
 }
 
++ (int64_t)uploadChunkSizeForChunkSize:(int64_t)chunkSize {
+  if (chunkSize <= kFIRStorageUploadChunkGranularity) {
+    return kFIRStorageUploadChunkGranularity;
+  }
+  int64_t remainder = chunkSize % kFIRStorageUploadChunkGranularity;
+  return remainder == 0 ? chunkSize : chunkSize + kFIRStorageUploadChunkGranularity - remainder;
+}
+
+- (NSURL *)uploadSessionURL {
+  return self.uploadFetcher.uploadLocationURL ?: _resumedUploadSessionURL;
+}
+
 - (void)enqueue {
   __weak FIRStorageUploadTask *weakSelf = self;
 
@@ -110,11 +143,23 @@
     [components setPercentEncodedQuery:[FIRStorageUtils queryStringForDictionary:queryParams]];
     request.URL = components.URL;
 
-    GTMSessionUploadFetcher *uploadFetcher =
-        [GTMSessionUploadFetcher uploadFetcherWithRequest:request
-                                           uploadMIMEType:strongSelf->_uploadMetadata.contentType
-                                                chunkSize:kGTMSessionUploadFetcherStandardChunkSize
-                                           fetcherService:self.fetcherService];
+    int64_t chunkSize = [FIRStorageUploadTask
+        uploadChunkSizeForChunkSize:strongSelf.reference.storage.uploadChunkSizeBytes];
+    GTMSessionUploadFetcher *uploadFetcher;
+    if (strongSelf->_resumedUploadSessionURL) {
+      // The fetcher asks the server how many bytes it has and continues from there.
+      uploadFetcher =
+          [GTMSessionUploadFetcher uploadFetcherWithLocation:strongSelf->_resumedUploadSessionURL
+                                              uploadMIMEType:strongSelf->_uploadMetadata.contentType
+                                                   chunkSize:chunkSize
+                                              fetcherService:self.fetcherService];
+    } else {
+      uploadFetcher =
+          [GTMSessionUploadFetcher uploadFetcherWithRequest:request
+                                             uploadMIMEType:strongSelf->_uploadMetadata.contentType
+                                                  chunkSize:chunkSize
+                                             fetcherService:self.fetcherService];
+    }
 
     if (strongSelf->_uploadData) {
       [uploadFetcher setUploadData:strongSelf->_uploadData];
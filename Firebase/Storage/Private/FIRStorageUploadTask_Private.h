@@ -68,6 +68,28 @@ NS_ASSUME_NONNULL_BEGIN
                              file:(NSURL *)fileURL
                          metadata:(FIRStorageMetadata *)metadata;
 
+/**
+ * Initializes an upload task that continues an existing upload session of a file.
+ * @param reference The base FIRStorageReference which fetchers use for configuration.
+ * @param service The GTMSessionFetcherService which will create fetchers.
+ * @param queue The shared queue to use for all Storage operations.
+ * @param fileURL The system file URL to upload from.
+ * @param uploadSessionURL The session URL of the upload to resume, or nil to start a new one.
+ * @return Returns an instance of FIRStorageUploadTask.
+ */
+- (instancetype)initWithReference:(FIRStorageReference *)reference
+                   fetcherService:(GTMSessionFetcherService *)service
+                    dispatchQueue:(dispatch_queue_t)queue
+                             file:(NSURL *)fileURL
+                         metadata:(FIRStorageMetadata *)metadata
+                 uploadSessionURL:(nullable NSURL *)uploadSessionURL;
+
+/**
+ * Returns the chunk size to upload with: `chunkSize` rounded up to the 256 KiB granularity of
+ * resumable uploads.
+ */
++ (int64_t)uploadChunkSizeForChunkSize:(int64_t)chunkSize;
+
 @end
 
 NS_ASSUME_NONNULL_END
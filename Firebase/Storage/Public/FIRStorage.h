@@ -94,6 +94,28 @@ NS_SWIFT_NAME(Storage)
  */
 @property NSTimeInterval maxOperationRetryTime;
 
+/**
+ * The number of bytes sent in each request of a resumable upload. Larger chunks need fewer
+ * round trips on fast networks, smaller ones lose less progress when a request fails on a flaky
+ * network. Rounded up to a multiple of 256 KiB, as required by the upload protocol.
+ * Defaults to 5 MiB.
+ */
+@property int64_t uploadChunkSizeBytes;
+
+/**
+ * When greater than zero, downloads to a file are split into requests for ranges of this many
+ * bytes, which are fetched in parallel and written to the file at their offsets. A download
+ * that was paused, failed or was interrupted by an app restart then continues with the ranges
+ * still missing instead of starting over. Defaults to 0, which downloads a file in one request.
+ */
+@property int64_t downloadRangeSizeBytes;
+
+/**
+ * The number of range requests a download to a file keeps in flight when
+ * downloadRangeSizeBytes is set. Defaults to 4.
+ */
+@property NSInteger maxParallelDownloadRanges;
+
 /**
  * Queue that all developer callbacks are fired on. Defaults to the main queue.
  */
@@ -172,6 +172,27 @@ NS_SWIFT_NAME(putData(_:metadata:));
            NS_SWIFT_NAME(putFile(from:metadata:completion:));
 // clang-format on
 
+/**
+ * Asynchronously continues uploading a file to the currently specified FIRStorageReference
+ * from the last byte the server received in an earlier upload session, for instance one that
+ * was interrupted when the app was terminated.
+ * @param fileURL A URL representing the system file path of the object to be uploaded.
+ * @param metadata FIRStorageMetadata containing additional information (MIME type, etc.)
+ * about the object being uploaded.
+ * @param uploadSessionURL The FIRStorageUploadTask#uploadSessionURL of the earlier upload.
+ * @param completion A completion block that either returns the object metadata on success,
+ * or an error on failure.
+ * @return An instance of FIRStorageUploadTask, which can be used to monitor or manage the upload.
+ */
+// clang-format off
+- (FIRStorageUploadTask *)putFile:(NSURL *)fileURL
+                         metadata:(nullable FIRStorageMetadata *)metadata
+            resumingUploadSession:(NSURL *)uploadSessionURL
+                       completion:(nullable void (^)(FIRStorageMetadata *_Nullable metadata,
+                                                     NSError *_Nullable error))completion
+           NS_SWIFT_NAME(putFile(from:metadata:resumingUploadSession:completion:));
+// clang-format on
+
 #pragma mark - Downloads
 
 /**
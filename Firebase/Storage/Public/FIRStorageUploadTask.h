@@ -33,6 +33,13 @@ NS_ASSUME_NONNULL_BEGIN
 NS_SWIFT_NAME(StorageUploadTask)
 @interface FIRStorageUploadTask : FIRStorageObservableTask <FIRStorageTaskManagement>
 
+/**
+ * The URL of the upload session on the server, available once the upload has started.
+ * Persist it to resume a file upload from the last byte the server confirmed after the app
+ * restarts, using FIRStorageReference#putFile:metadata:resumingUploadSession:completion:.
+ */
+@property(readonly, nullable) NSURL *uploadSessionURL;
+
 @end
 
 NS_ASSUME_NONNULL_END
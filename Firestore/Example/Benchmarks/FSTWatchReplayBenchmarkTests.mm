@@ -0,0 +1,509 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+
+#include <algorithm>
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <utility>
+#include <vector>
+
+#import "Firestore/Protos/objc/google/firestore/v1/Document.pbobjc.h"
+#import "Firestore/Protos/objc/google/firestore/v1/Firestore.pbobjc.h"
+#import "Firestore/Source/Core/FSTEventManager.h"
+#import "Firestore/Source/Core/FSTQuery.h"
+#import "Firestore/Source/Core/FSTSyncEngine.h"
+#import "Firestore/Source/Local/FSTLocalStore.h"
+#import "Firestore/Source/Local/FSTMemoryPersistence.h"
+#import "Firestore/Source/Remote/FSTSerializerBeta.h"
+
+#include "Firestore/core/src/firebase/firestore/auth/empty_credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/core/query_listener.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "Firestore/core/test/firebase/firestore/util/create_noop_connectivity_monitor.h"
+#include "Firestore/core/test/firebase/firestore/util/grpc_stream_tester.h"
+#include "absl/memory/memory.h"
+#include "benchmark/benchmark.h"
+#include "grpcpp/client_context.h"
+#include "grpcpp/support/byte_buffer.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace util = firebase::firestore::util;
+using firebase::firestore::auth::CredentialsProvider;
+using firebase::firestore::auth::EmptyCredentialsProvider;
+using firebase::firestore::auth::Token;
+using firebase::firestore::auth::User;
+using firebase::firestore::core::DatabaseInfo;
+using firebase::firestore::core::QueryListener;
+using firebase::firestore::core::ViewSnapshot;
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::OnlineState;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::model::TargetId;
+using firebase::firestore::remote::ConnectivityMonitor;
+using firebase::firestore::remote::Datastore;
+using firebase::firestore::remote::GrpcCompletion;
+using firebase::firestore::remote::GrpcConnection;
+using firebase::firestore::remote::GrpcStream;
+using firebase::firestore::remote::RemoteStore;
+using firebase::firestore::remote::WatchStream;
+using firebase::firestore::remote::WatchStreamCallback;
+using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::ExecutorLibdispatch;
+using firebase::firestore::util::GrpcStreamTester;
+using firebase::firestore::util::StatusOr;
+using firebase::firestore::util::StringFormat;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * The `ListenResponse`s to replay, split into steps. Each step ends with a
+ * response that raises a consistent snapshot, upon which `expected_snapshots`
+ * listeners receive a new snapshot.
+ *
+ * A step is only replayed once the snapshots of the previous one have all
+ * been delivered, so the latency of a step is the time from its last response
+ * coming off the stream to its last snapshot reaching a listener.
+ */
+struct WatchReplayScript {
+  struct Step {
+    std::vector<grpc::ByteBuffer> responses;
+    int expected_snapshots = 0;
+  };
+
+  std::vector<Step> steps;
+};
+
+grpc::ByteBuffer MakeByteBuffer(GPBMessage *message) {
+  NSData *data = [message data];
+  grpc::Slice slice{[data bytes], [data length]};
+  return grpc::ByteBuffer{&slice, 1};
+}
+
+GPBTimestamp *MakeTimestamp(int64_t version) {
+  GPBTimestamp *timestamp = [GPBTimestamp message];
+  timestamp.seconds = version;
+  return timestamp;
+}
+
+GCFSListenResponse *MakeTargetChange(GCFSTargetChange_TargetChangeType type, TargetId target_id) {
+  GCFSListenResponse *response = [GCFSListenResponse message];
+  response.targetChange.targetChangeType = type;
+  [response.targetChange.targetIdsArray addValue:target_id];
+  if (type == GCFSTargetChange_TargetChangeType_Current) {
+    response.targetChange.resumeToken = [@"resume" dataUsingEncoding:NSUTF8StringEncoding];
+  }
+  return response;
+}
+
+/** A response for no target in particular, which raises a snapshot at `version`. */
+GCFSListenResponse *MakeGlobalSnapshot(int64_t version) {
+  GCFSListenResponse *response = [GCFSListenResponse message];
+  response.targetChange.targetChangeType = GCFSTargetChange_TargetChangeType_NoChange;
+  response.targetChange.readTime = MakeTimestamp(version);
+  return response;
+}
+
+GCFSListenResponse *MakeDocumentChange(const std::string &collection,
+                                       int64_t doc_index,
+                                       int64_t value,
+                                       int64_t version,
+                                       TargetId target_id) {
+  GCFSDocument *doc = [GCFSDocument message];
+  doc.name = util::MakeNSString(StringFormat("projects/p/databases/d/documents/%s/doc%s",
+                                             collection, doc_index));
+  GCFSValue *number = [GCFSValue message];
+  number.integerValue = value;
+  GCFSValue *text = [GCFSValue message];
+  text.stringValue = @"a moderately long string field of a replayed document";
+  [doc.fields addEntriesFromDictionary:@{@"value" : number, @"text" : text}];
+  doc.createTime = MakeTimestamp(1);
+  doc.updateTime = MakeTimestamp(version);
+
+  GCFSListenResponse *response = [GCFSListenResponse message];
+  response.documentChange.document = doc;
+  [response.documentChange.targetIdsArray addValue:target_id];
+  return response;
+}
+
+/**
+ * Generates a script that first loads `doc_count` documents into each target,
+ * then runs `update_count` steps that each modify one document of every
+ * target.
+ */
+WatchReplayScript MakeSyntheticScript(const std::vector<std::string> &collections,
+                                      const std::vector<TargetId> &target_ids,
+                                      int64_t doc_count,
+                                      int64_t update_count) {
+  WatchReplayScript script;
+  int64_t version = 1;
+
+  WatchReplayScript::Step initial;
+  for (size_t i = 0; i < target_ids.size(); ++i) {
+    initial.responses.push_back(
+        MakeByteBuffer(MakeTargetChange(GCFSTargetChange_TargetChangeType_Add, target_ids[i])));
+    for (int64_t doc = 0; doc < doc_count; ++doc) {
+      initial.responses.push_back(
+          MakeByteBuffer(MakeDocumentChange(collections[i], doc, 0, version, target_ids[i])));
+    }
+    initial.responses.push_back(
+        MakeByteBuffer(MakeTargetChange(GCFSTargetChange_TargetChangeType_Current, target_ids[i])));
+  }
+  initial.responses.push_back(MakeByteBuffer(MakeGlobalSnapshot(version)));
+  initial.expected_snapshots = static_cast<int>(target_ids.size());
+  script.steps.push_back(std::move(initial));
+
+  for (int64_t update = 1; update <= update_count; ++update) {
+    ++version;
+    WatchReplayScript::Step step;
+    for (size_t i = 0; i < target_ids.size(); ++i) {
+      step.responses.push_back(MakeByteBuffer(
+          MakeDocumentChange(collections[i], update % doc_count, update, version, target_ids[i])));
+    }
+    step.responses.push_back(MakeByteBuffer(MakeGlobalSnapshot(version)));
+    step.expected_snapshots = static_cast<int>(target_ids.size());
+    script.steps.push_back(std::move(step));
+  }
+  return script;
+}
+
+/** A real `WatchStream` that exposes the context of its gRPC call. */
+class ReplayWatchStream : public WatchStream {
+ public:
+  using WatchStream::WatchStream;
+
+  grpc::ClientContext *_Nullable context() const {
+    return context_;
+  }
+
+ private:
+  std::unique_ptr<GrpcStream> CreateGrpcStream(GrpcConnection *grpc_connection,
+                                                const Token &token) override {
+    auto result = grpc_connection->CreateStream("/google.firestore.v1.Firestore/Listen",
+                                                GrpcConnection::StreamKind::Watch, token, this);
+    context_ = result->context();
+    return result;
+  }
+
+  grpc::ClientContext *_Nullable context_ = nullptr;
+};
+
+/** A `Datastore` whose watch streams run on the connection of a `GrpcStreamTester`. */
+class ReplayDatastore : public Datastore {
+ public:
+  ReplayDatastore(const DatabaseInfo &database_info,
+                  const std::shared_ptr<AsyncQueue> &worker_queue,
+                  CredentialsProvider *credentials,
+                  GrpcStreamTester *tester)
+      : Datastore{database_info, worker_queue, credentials},
+        worker_queue_{worker_queue},
+        credentials_{credentials},
+        tester_{tester},
+        serializer_{[[FSTSerializerBeta alloc] initWithDatabaseID:database_info.database_id()]} {
+  }
+
+  std::shared_ptr<WatchStream> CreateWatchStream(WatchStreamCallback *callback) override {
+    watch_stream_ = std::make_shared<ReplayWatchStream>(worker_queue_, credentials_, serializer_,
+                                                        tester_->grpc_connection(), callback);
+    return watch_stream_;
+  }
+
+  ReplayWatchStream *_Nullable watch_stream() {
+    return watch_stream_.get();
+  }
+
+ private:
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  CredentialsProvider *credentials_ = nullptr;
+  GrpcStreamTester *tester_ = nullptr;
+  FSTSerializerBeta *serializer_;
+  std::shared_ptr<ReplayWatchStream> watch_stream_;
+};
+
+/**
+ * A client backed by memory persistence whose watch stream is fed from a
+ * `WatchReplayScript` instead of the backend. `ListenResponse`s go through the
+ * whole sync pipeline: `WatchStream`, `RemoteStore`, `FSTSyncEngine` and
+ * `FSTEventManager`, up to `QueryListener`s.
+ */
+class WatchReplayHarness {
+ public:
+  WatchReplayHarness()
+      : worker_queue_{std::make_shared<AsyncQueue>(absl::make_unique<ExecutorLibdispatch>(
+            dispatch_queue_create("watch_replay_benchmark", DISPATCH_QUEUE_SERIAL)))},
+        connectivity_monitor_{util::CreateNoOpConnectivityMonitor()},
+        tester_{worker_queue_, connectivity_monitor_.get()},
+        database_info_{DatabaseId{"p", "d"}, "replay", "localhost", false},
+        datastore_{std::make_shared<ReplayDatastore>(database_info_, worker_queue_, &credentials_,
+                                                     &tester_)} {
+    persistence_ = [FSTMemoryPersistence persistenceWithEagerGC];
+    local_store_ = [[FSTLocalStore alloc] initWithPersistence:persistence_
+                                                  initialUser:User::Unauthenticated()];
+    remote_store_ = absl::make_unique<RemoteStore>(
+        local_store_, datastore_, worker_queue_, [this](OnlineState online_state) {
+          [sync_engine_ applyChangedOnlineState:online_state];
+          [event_manager_ applyChangedOnlineState:online_state];
+        });
+    sync_engine_ = [[FSTSyncEngine alloc] initWithLocalStore:local_store_
+                                                 remoteStore:remote_store_.get()
+                                                 initialUser:User::Unauthenticated()];
+    remote_store_->set_sync_engine(sync_engine_);
+    event_manager_ = [FSTEventManager eventManagerWithSyncEngine:sync_engine_
+                                                     workerQueue:worker_queue_];
+
+    worker_queue_->EnqueueBlocking([&] {
+      [local_store_ start];
+      remote_store_->Start();
+    });
+  }
+
+  ~WatchReplayHarness() {
+    worker_queue_->EnqueueBlocking([&] {
+      // Stopping the stream finishes its gRPC call, which needs the queue
+      // polled to complete.
+      tester_.KeepPollingGrpcQueue();
+      remote_store_->Shutdown();
+      [persistence_ shutdown];
+    });
+    tester_.Shutdown();
+  }
+
+  /** Listens to each of `collections` and returns the target IDs assigned to them. */
+  std::vector<TargetId> Listen(const std::vector<std::string> &collections) {
+    std::vector<TargetId> target_ids;
+    worker_queue_->EnqueueBlocking([&] {
+      for (const std::string &collection : collections) {
+        FSTQuery *query = [FSTQuery queryWithPath:ResourcePath::FromString(collection)];
+        auto listener =
+            QueryListener::Create(query, [this](const StatusOr<ViewSnapshot> &maybe_snapshot) {
+              HARD_ASSERT(maybe_snapshot.ok(), "Replayed listen failed: %s",
+                          maybe_snapshot.status().ToString());
+              OnSnapshot();
+            });
+        target_ids.push_back([event_manager_ addListener:listener]);
+        listeners_.push_back(std::move(listener));
+      }
+    });
+    return target_ids;
+  }
+
+  /**
+   * Replays `script` as fast as the pipeline delivers its snapshots, returning
+   * the latency of each step.
+   */
+  std::vector<Clock::duration> Replay(const WatchReplayScript &script) {
+    grpc::ClientContext *context = WaitForWatchStream();
+    // Cancelling the call makes every operation come off the completion queue
+    // right away, so that the harness can complete them as it wishes.
+    context->TryCancel();
+
+    std::vector<Clock::duration> latencies;
+    size_t step_index = 0;
+    size_t response_index = 0;
+    std::future<void> done = tester_.ForceFinishAsync([&](GrpcCompletion *completion) {
+      if (completion->type() != GrpcCompletion::Type::Read) {
+        // Starting the stream and sending listen requests always succeed.
+        completion->Complete(true);
+        return false;
+      }
+
+      const WatchReplayScript::Step &step = script.steps[step_index];
+      bool ends_step = response_index + 1 == step.responses.size();
+      if (ends_step) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        expected_snapshots_ += step.expected_snapshots;
+        step_ended_ = Clock::now();
+      }
+
+      *completion->message() = step.responses[response_index];
+      completion->Complete(true);
+      if (!ends_step) {
+        ++response_index;
+        return false;
+      }
+
+      std::unique_lock<std::mutex> lock{mutex_};
+      delivered_.wait(lock, [&] { return delivered_snapshots_ >= expected_snapshots_; });
+      latencies.push_back(last_delivery_ - step_ended_);
+
+      ++step_index;
+      response_index = 0;
+      return step_index == script.steps.size();
+    });
+    done.wait();
+
+    return latencies;
+  }
+
+ private:
+  grpc::ClientContext *WaitForWatchStream() {
+    // Starting the stream takes a few hops through the worker queue to get
+    // credentials and create the gRPC call.
+    for (int attempt = 0; attempt < 100; ++attempt) {
+      grpc::ClientContext *context = nullptr;
+      worker_queue_->EnqueueBlocking([&] {
+        ReplayWatchStream *stream = datastore_->watch_stream();
+        context = stream ? stream->context() : nullptr;
+      });
+      if (context) {
+        return context;
+      }
+    }
+    HARD_FAIL("The watch stream never started");
+  }
+
+  void OnSnapshot() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    ++delivered_snapshots_;
+    last_delivery_ = Clock::now();
+    delivered_.notify_one();
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor_;
+  GrpcStreamTester tester_;
+
+  DatabaseInfo database_info_;
+  EmptyCredentialsProvider credentials_;
+  std::shared_ptr<ReplayDatastore> datastore_;
+
+  id<FSTPersistence> persistence_;
+  FSTLocalStore *local_store_;
+  std::unique_ptr<RemoteStore> remote_store_;
+  FSTSyncEngine *sync_engine_;
+  FSTEventManager *event_manager_;
+  std::vector<std::shared_ptr<QueryListener>> listeners_;
+
+  std::mutex mutex_;
+  std::condition_variable delivered_;
+  int expected_snapshots_ = 0;
+  int delivered_snapshots_ = 0;
+  Clock::time_point step_ended_;
+  Clock::time_point last_delivery_;
+};
+
+double ToMicros(Clock::duration duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+/** Returns the latency below which `percentile` percent of `sorted` fall. */
+double Percentile(const std::vector<Clock::duration> &sorted, double percentile) {
+  size_t index = static_cast<size_t>(percentile / 100 * (sorted.size() - 1));
+  return ToMicros(sorted[index]);
+}
+
+}  // namespace
+
+/**
+ * Replays a synthetic watch stream for `state.range(0)` listeners of
+ * `state.range(1)` documents each, then `kUpdateSteps` snapshots that each
+ * modify one document of every listener. Reports snapshot throughput and the
+ * distribution of step latencies in microseconds.
+ */
+static void BM_ReplayWatchStream(benchmark::State &state) {  // NOLINT
+  constexpr int64_t kUpdateSteps = 100;
+  int64_t listener_count = state.range(0);
+  int64_t doc_count = state.range(1);
+
+  std::vector<std::string> collections;
+  for (int64_t i = 0; i < listener_count; ++i) {
+    collections.push_back(StringFormat("collection%s", i));
+  }
+
+  std::vector<Clock::duration> latencies;
+  int64_t snapshots = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto harness = absl::make_unique<WatchReplayHarness>();
+    std::vector<TargetId> target_ids = harness->Listen(collections);
+    WatchReplayScript script =
+        MakeSyntheticScript(collections, target_ids, doc_count, kUpdateSteps);
+    state.ResumeTiming();
+
+    std::vector<Clock::duration> run = harness->Replay(script);
+
+    state.PauseTiming();
+    latencies.insert(latencies.end(), run.begin(), run.end());
+    for (const WatchReplayScript::Step &step : script.steps) {
+      snapshots += step.expected_snapshots;
+    }
+    harness.reset();
+    state.ResumeTiming();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  state.counters["snapshots"] = benchmark::Counter(snapshots, benchmark::Counter::kIsRate);
+  state.counters["p50_us"] = Percentile(latencies, 50);
+  state.counters["p99_us"] = Percentile(latencies, 99);
+  state.counters["max_us"] = ToMicros(latencies.back());
+}
+
+/** Listener counts in the outer loop, documents per listener in the inner one. */
+static void ReplayCases(benchmark::internal::Benchmark *b) {
+  for (int listeners = 1; listeners <= 100; listeners *= 10) {
+    for (int docs = 10; docs <= 1000; docs *= 10) {
+      b->Args({listeners, docs});
+    }
+  }
+}
+
+BENCHMARK(BM_ReplayWatchStream)
+    ->Apply(ReplayCases)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+@interface FSTWatchReplayBenchmarkTests : XCTestCase
+@end
+
+@implementation FSTWatchReplayBenchmarkTests
+
+- (void)testRunBenchmarks {
+  // Enable to run benchmarks.
+  char *argv[3] = {const_cast<char *>("Benchmarks"),
+                   const_cast<char *>("--benchmark_out=/tmp/watch_replay_benchmark"),
+                   const_cast<char *>("--benchmark_out_format=json")};
+  int argc = 3;
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
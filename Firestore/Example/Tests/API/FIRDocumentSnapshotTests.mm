@@ -15,6 +15,8 @@
  */
 
 #import <FirebaseFirestore/FIRDocumentSnapshot.h>
+#import <FirebaseFirestore/FIRFieldPath.h>
+#import <FirebaseFirestore/FIRTimestamp.h>
 
 #import <XCTest/XCTest.h>
 
@@ -54,6 +56,62 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNotEqual([base hash], [fromCache hash]);
 }
 
+- (void)testDataMatchesDocumentContents {
+  NSDictionary<NSString *, id> *contents =
+      @{@"a" : @1, @"b" : @"two", @"c" : @{@"d" : @[ @3, @4 ]}};
+  FIRDocumentSnapshot *snapshot = FSTTestDocSnapshot("rooms/foo", 1, contents, NO, NO);
+
+  NSDictionary<NSString *, id> *data = [snapshot data];
+  XCTAssertEqual(data.count, 3);
+  XCTAssertEqualObjects(data[@"b"], @"two");
+  XCTAssertEqualObjects(data[@"c"], (@{@"d" : @[ @3, @4 ]}));
+  XCTAssertNil(data[@"missing"]);
+  XCTAssertEqualObjects(data, contents);
+  XCTAssertEqualObjects([data copy], contents);
+
+  XCTAssertEqualObjects([snapshot valueForField:@"c.d"], (@[ @3, @4 ]));
+  XCTAssertNil([snapshot valueForField:@"c.missing"]);
+  XCTAssertThrows([snapshot valueForField:@"c..d"]);
+}
+
+- (void)testTypedAccessorsReadMatchingFields {
+  FIRTimestamp *timestamp = [FIRTimestamp timestampWithSeconds:100 nanoseconds:5];
+  NSDictionary<NSString *, id> *contents = @{
+    @"count" : @7,
+    @"ratio" : @0.5,
+    @"name" : @"seven",
+    @"at" : timestamp,
+    @"nested" : @{@"count" : @-3, @"name" : @"inner"}
+  };
+  FIRDocumentSnapshot *snapshot = FSTTestDocSnapshot("rooms/foo", 1, contents, NO, NO);
+
+  XCTAssertEqual([snapshot int64ForField:@"count"], 7);
+  XCTAssertEqual([snapshot int64ForField:@"nested.count"], -3);
+  XCTAssertEqual([snapshot doubleForField:@"ratio"], 0.5);
+  XCTAssertEqual([snapshot doubleForField:@"count"], 7.0);
+  XCTAssertEqualObjects([snapshot stringForField:@"name"], @"seven");
+  XCTAssertEqualObjects([snapshot stringForField:[[FIRFieldPath alloc]
+                                                     initWithFields:@[ @"nested", @"name" ]]],
+                        @"inner");
+  XCTAssertEqualObjects([snapshot timestampForField:@"at"], timestamp);
+}
+
+- (void)testTypedAccessorsIgnoreMissingAndMismatchedFields {
+  NSDictionary<NSString *, id> *contents = @{@"count" : @7, @"ratio" : @0.5, @"name" : @"seven"};
+  FIRDocumentSnapshot *snapshot = FSTTestDocSnapshot("rooms/foo", 1, contents, NO, NO);
+  FIRDocumentSnapshot *missing = FSTTestDocSnapshot("rooms/foo", 1, nil, NO, NO);
+
+  XCTAssertEqual([snapshot int64ForField:@"missing"], 0);
+  XCTAssertEqual([snapshot int64ForField:@"ratio"], 0);
+  XCTAssertEqual([snapshot doubleForField:@"name"], 0);
+  XCTAssertNil([snapshot stringForField:@"count"]);
+  XCTAssertNil([snapshot timestampForField:@"name"]);
+  XCTAssertNil([snapshot stringForField:@"name.inner"]);
+  XCTAssertEqual([missing int64ForField:@"count"], 0);
+  XCTAssertNil([missing stringForField:@"name"]);
+  XCTAssertThrows([snapshot int64ForField:@"count..x"]);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -79,6 +79,25 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNotEqual([foo hash], [fromCache hash]);
 }
 
+- (void)testDocumentsAreCreatedOnAccess {
+  FIRQuerySnapshot *snapshot = FSTTestQuerySnapshot(
+      "foo", @{}, @{@"a" : @{@"a" : @1}, @"b" : @{@"b" : @2}}, false, false);
+
+  NSArray<FIRQueryDocumentSnapshot *> *documents = snapshot.documents;
+  XCTAssertEqual(documents.count, 2);
+  XCTAssertEqualObjects(documents[1].documentID, @"b");
+  XCTAssertEqual(documents[1], documents[1]);
+  XCTAssertEqual(documents, snapshot.documents);
+  XCTAssertThrows(documents[2]);
+
+  NSMutableArray<NSString *> *ids = [NSMutableArray array];
+  for (FIRQueryDocumentSnapshot *document in documents) {
+    [ids addObject:document.documentID];
+  }
+  XCTAssertEqualObjects(ids, (@[ @"a", @"b" ]));
+  XCTAssertEqualObjects(documents[0].data, (@{@"a" : @1}));
+}
+
 - (void)testIncludeMetadataChanges {
   FSTDocument *doc1Old = FSTTestDoc("foo/bar", 1, @{@"a" : @"b"}, DocumentState::kLocalMutations);
   FSTDocument *doc1New = FSTTestDoc("foo/bar", 1, @{@"a" : @"b"}, DocumentState::kSynced);
@@ -25,6 +25,7 @@
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Core/FSTSyncEngine.h"
+#import "Firestore/Source/Model/FSTDocument.h"
 
 #import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
@@ -32,16 +33,25 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_batching.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "Firestore/core/test/firebase/firestore/testutil/xcgmock.h"
 
+namespace testutil = firebase::firestore::testutil;
+using firebase::firestore::core::AsyncEventListener;
+using firebase::firestore::core::DocumentViewChange;
 using firebase::firestore::core::EventListener;
 using firebase::firestore::core::ListenOptions;
 using firebase::firestore::core::QueryListener;
 using firebase::firestore::core::ViewSnapshot;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentSet;
+using firebase::firestore::model::DocumentState;
 using firebase::firestore::model::OnlineState;
+using firebase::firestore::util::ExecutorBatching;
+using firebase::firestore::util::ExecutorLibdispatch;
 using firebase::firestore::util::StatusOr;
 using firebase::firestore::util::StatusOrCallback;
 using testing::ElementsAre;
@@ -58,6 +68,19 @@ std::shared_ptr<QueryListener> NoopQueryListener(FSTQuery *query) {
   return QueryListener::Create(query, ListenOptions::DefaultOptions(), NoopViewSnapshotHandler());
 }
 
+// Counts the operations it's asked to execute.
+class CountingExecutor : public ExecutorLibdispatch {
+ public:
+  using ExecutorLibdispatch::ExecutorLibdispatch;
+
+  void Execute(Operation &&operation) override {
+    ++executed;
+    ExecutorLibdispatch::Execute(std::move(operation));
+  }
+
+  int executed = 0;
+};
+
 }  // namespace
 
 // FSTEventManager implements this delegate privately
@@ -140,6 +163,97 @@ std::shared_ptr<QueryListener> NoopQueryListener(FSTQuery *query) {
   XCTAssertEqualObjects(eventOrder, expected);
 }
 
+- (void)testBatchesSnapshotsOfOneRoundOfChanges {
+  FSTQuery *query1 = FSTTestQuery("foo/bar");
+  FSTQuery *query2 = FSTTestQuery("bar/baz");
+  NSMutableArray *eventOrder = [NSMutableArray array];
+
+  auto underlying = std::make_shared<CountingExecutor>(
+      dispatch_queue_create("FSTEventManagerTests", DISPATCH_QUEUE_SERIAL));
+  auto executor = std::make_shared<ExecutorBatching>(underlying);
+  auto asyncListener = [&](NSString *name) {
+    return AsyncEventListener<ViewSnapshot>::Create(
+        executor, EventListener<ViewSnapshot>::Create(
+                      [eventOrder, name](StatusOr<ViewSnapshot>) { [eventOrder addObject:name]; }));
+  };
+  auto listener1 = QueryListener::Create(query1, asyncListener(@"listener1"));
+  auto listener2 = QueryListener::Create(query2, asyncListener(@"listener2"));
+
+  FSTSyncEngine *syncEngineMock = OCMClassMock([FSTSyncEngine class]);
+  FSTEventManager *eventManager = [FSTEventManager eventManagerWithSyncEngine:syncEngineMock];
+  [eventManager setSnapshotBatchingExecutor:executor];
+  [eventManager addListener:listener1];
+  [eventManager addListener:listener2];
+
+  ViewSnapshot snapshot1 = [self makeEmptyViewSnapshotWithQuery:query1];
+  ViewSnapshot snapshot2 = [self makeEmptyViewSnapshotWithQuery:query2];
+  [eventManager handleViewSnapshots:{snapshot1, snapshot2}];
+  XCTAssertEqual(underlying->executed, 1);
+
+  underlying->ExecuteBlocking([] {});
+  NSArray *expected = @[ @"listener1", @"listener2" ];
+  XCTAssertEqualObjects(eventOrder, expected);
+}
+
+- (void)testDerivesSnapshotsOfCoveredQueries {
+  FSTQuery *query = FSTTestQuery("foo");
+  FSTQuery *filtered = [query queryByAddingFilter:testutil::Filter("a", "==", 1)];
+  FSTDocument *doc1 = FSTTestDoc("foo/1", 1, @{@"a" : @1}, DocumentState::kSynced);
+  FSTDocument *doc2 = FSTTestDoc("foo/2", 1, @{@"a" : @2}, DocumentState::kSynced);
+
+  auto listener = NoopQueryListener(query);
+  std::vector<ViewSnapshot> filteredSnapshots;
+  auto filteredListener =
+      QueryListener::Create(filtered, [&filteredSnapshots](StatusOr<ViewSnapshot> maybeSnapshot) {
+        filteredSnapshots.push_back(maybeSnapshot.ValueOrDie());
+      });
+
+  FSTSyncEngine *syncEngineMock = OCMStrictClassMock([FSTSyncEngine class]);
+  OCMExpect([syncEngineMock setSyncEngineDelegate:[OCMArg any]]);
+  FSTEventManager *eventManager = [FSTEventManager eventManagerWithSyncEngine:syncEngineMock];
+  eventManager.sharedQueryExecutionEnabled = YES;
+
+  // Only the broader query gets a target.
+  OCMExpect([syncEngineMock listenToQuery:query]);
+  [eventManager addListener:listener];
+  [eventManager addListener:filteredListener];
+  OCMVerifyAll((id)syncEngineMock);
+
+  DocumentSet docs = DocumentSet{query.comparator}.insert(doc1).insert(doc2);
+  [eventManager handleViewSnapshots:{ViewSnapshot::FromInitialDocuments(
+                                        query, docs, DocumentKeySet{}, false, false)}];
+  XCTAssertEqual(filteredSnapshots.size(), 1);
+  XCTAssertEqual(filteredSnapshots[0].query(), filtered);
+  XCTAssertEqual(filteredSnapshots[0].documents().size(), 1);
+  XCTAssertTrue(filteredSnapshots[0].documents().ContainsKey(doc1.key));
+  XCTAssertFalse(filteredSnapshots[0].from_cache());
+
+  // A change in the broader results that brings a doc into the filtered ones.
+  FSTDocument *doc2Prime = FSTTestDoc("foo/2", 2, @{@"a" : @1}, DocumentState::kSynced);
+  DocumentSet newDocs = docs.insert(doc2Prime);
+  [eventManager
+      handleViewSnapshots:{ViewSnapshot{
+                              query,
+                              newDocs,
+                              docs,
+                              {DocumentViewChange{doc2Prime, DocumentViewChange::Type::kModified}},
+                              DocumentKeySet{},
+                              false,
+                              false,
+                              false}}];
+  XCTAssertEqual(filteredSnapshots.size(), 2);
+  XC_ASSERT_THAT(filteredSnapshots[1].document_changes(),
+                 ElementsAre(DocumentViewChange{doc2Prime, DocumentViewChange::Type::kAdded}));
+
+  // The target is kept for as long as anything is derived from it.
+  [eventManager removeListener:listener];
+  OCMVerifyAll((id)syncEngineMock);
+
+  OCMExpect([syncEngineMock stopListeningToQuery:query]);
+  [eventManager removeListener:filteredListener];
+  OCMVerifyAll((id)syncEngineMock);
+}
+
 - (void)testWillForwardOnlineStateChanges {
   FSTQuery *query = FSTTestQuery("foo/bar");
 
@@ -16,6 +16,7 @@
 
 #import <XCTest/XCTest.h>
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <utility>
 #include <vector>
@@ -501,6 +502,49 @@ ViewSnapshot::Listener Accumulating(std::vector<ViewSnapshot> *values) {
   XC_ASSERT_THAT(events, ElementsAre(expectedSnap));
 }
 
+- (void)testMergesSnapshotsWithinTheMinimumEventInterval {
+  std::vector<ViewSnapshot> events;
+
+  FSTQuery *query = FSTTestQuery("rooms");
+  FSTDocument *doc1 = FSTTestDoc("rooms/Eros", 1, @{@"name" : @"Eros"}, DocumentState::kSynced);
+  FSTDocument *doc1prime = FSTTestDoc("rooms/Eros", 2, @{@"name" : @"Eros", @"owner" : @"Jonny"},
+                                      DocumentState::kSynced);
+  FSTDocument *doc2 = FSTTestDoc("rooms/Hades", 2, @{@"name" : @"Hades"}, DocumentState::kSynced);
+  FSTDocument *doc2prime = FSTTestDoc("rooms/Hades", 3, @{@"name" : @"Hades", @"owner" : @"Jonny"},
+                                      DocumentState::kSynced);
+
+  ListenOptions options =
+      ListenOptions::DefaultOptions().WithMinEventInterval(std::chrono::hours(1));
+  auto listener = QueryListener::Create(query, options, Accumulating(&events));
+
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+  ViewSnapshot snap1 = FSTTestApplyChanges(view, @[ doc1 ], absl::nullopt).value();
+  ViewSnapshot snap2 = FSTTestApplyChanges(view, @[ doc2 ], absl::nullopt).value();
+  ViewSnapshot snap3 = FSTTestApplyChanges(view, @[ doc1prime, doc2prime ], absl::nullopt).value();
+
+  listener->OnViewSnapshot(snap1);  // event
+  listener->OnViewSnapshot(snap2);  // held back
+  listener->OnViewSnapshot(snap3);  // held back
+  XCTAssertEqual(events.size(), 1);
+  XCTAssertTrue(listener->pending_event_time().has_value());
+
+  listener->RaisePendingEvent();
+  XCTAssertFalse(listener->pending_event_time().has_value());
+
+  DocumentViewChange change1{doc2prime, DocumentViewChange::Type::kAdded};
+  DocumentViewChange change2{doc1prime, DocumentViewChange::Type::kModified};
+  ViewSnapshot expectedSnap{query,
+                            /*documents=*/snap3.documents(),
+                            /*old_documents=*/snap1.documents(),
+                            /*document_changes=*/{change1, change2},
+                            snap3.mutated_keys(),
+                            /*from_cache=*/true,
+                            /*sync_state_changed=*/false,
+                            /*excludes_metadata_changes=*/true};
+  XCTAssertEqual(events.size(), 2);
+  XCTAssertTrue(events[1] == expectedSnap);
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
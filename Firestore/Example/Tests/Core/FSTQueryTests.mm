@@ -434,6 +434,26 @@ NS_ASSUME_NONNULL_BEGIN
   [self assertCorrectComparisonsWithArray:docs comparator:query.comparator];
 }
 
+- (void)testSortsDocumentsSharedWithQueriesOrderedDifferently {
+  FSTQuery *query1 = [FSTTestQuery("collection")
+      queryByAddingSortOrder:OrderBy(Field("sort1"), Direction::Ascending)];
+  FSTQuery *query2 = [FSTTestQuery("collection")
+      queryByAddingSortOrder:OrderBy(Field("sort2"), Direction::Ascending)];
+
+  FSTDocument *doc1 =
+      FSTTestDoc("collection/1", 0, @{@"sort1" : @1, @"sort2" : @3}, DocumentState::kSynced);
+  FSTDocument *doc2 =
+      FSTTestDoc("collection/2", 0, @{@"sort1" : @2, @"sort2" : @2}, DocumentState::kSynced);
+  FSTDocument *doc3 =
+      FSTTestDoc("collection/3", 0, @{@"sort1" : @3, @"sort2" : @1}, DocumentState::kSynced);
+
+  // Alternate between the queries, so that each finds sort keys cached for the other.
+  for (int i = 0; i < 2; ++i) {
+    [self assertCorrectComparisonsWithArray:@[ doc1, doc2, doc3 ] comparator:query1.comparator];
+    [self assertCorrectComparisonsWithArray:@[ doc3, doc2, doc1 ] comparator:query2.comparator];
+  }
+}
+
 - (void)testEquality {
   FSTQuery *q11 = FSTTestQuery("foo");
   q11 = [q11 queryByAddingFilter:Filter("i1", "<", 2)];
@@ -101,6 +101,36 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqual(changes[6].type(), DocumentViewChange::Type::kModified);
 }
 
+- (void)testTrackFromAddedDocuments {
+  FSTDocument *doc1 = FSTTestDoc("a/1", 0, @{}, DocumentState::kSynced);
+  FSTDocument *doc2 = FSTTestDoc("a/2", 0, @{}, DocumentState::kSynced);
+  FSTDocument *doc3 = FSTTestDoc("a/3", 0, @{}, DocumentState::kSynced);
+  DocumentSet documents = DocumentSet{DocumentComparator::ByKey()};
+  documents = documents.insert(doc2).insert(doc1);
+
+  DocumentViewChangeSet set = DocumentViewChangeSet::FromAddedDocuments(documents);
+  XCTAssertTrue(set.all_added());
+
+  std::vector<DocumentViewChange> changes = set.GetChanges();
+  XCTAssertEqual(changes.size(), 2);
+  XCTAssertEqual(changes[0].document(), doc1);
+  XCTAssertEqual(changes[0].type(), DocumentViewChange::Type::kAdded);
+  XCTAssertEqual(changes[1].document(), doc2);
+  XCTAssertEqual(changes[1].type(), DocumentViewChange::Type::kAdded);
+
+  // Further changes merge with the added documents as usual.
+  set.AddChange(DocumentViewChange{doc1, DocumentViewChange::Type::kRemoved});
+  set.AddChange(DocumentViewChange{doc3, DocumentViewChange::Type::kAdded});
+  XCTAssertFalse(set.all_added());
+
+  changes = set.GetChanges();
+  XCTAssertEqual(changes.size(), 2);
+  XCTAssertEqual(changes[0].document(), doc2);
+  XCTAssertEqual(changes[0].type(), DocumentViewChange::Type::kAdded);
+  XCTAssertEqual(changes[1].document(), doc3);
+  XCTAssertEqual(changes[1].type(), DocumentViewChange::Type::kAdded);
+}
+
 - (void)testViewSnapshotConstructor {
   FSTQuery *query = FSTTestQuery("a");
   DocumentSet documents = DocumentSet{DocumentComparator::ByKey()};
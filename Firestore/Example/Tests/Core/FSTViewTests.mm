@@ -48,6 +48,7 @@ using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentSet;
 using firebase::firestore::model::DocumentState;
 using firebase::firestore::model::FieldValue;
+using firebase::firestore::model::OnlineState;
 
 using testing::ElementsAre;
 using testutil::Field;
@@ -460,6 +461,119 @@ inline ContainsDocsMatcherP<std::vector<FSTDocument *>> ContainsDocs(
   [view applyChangesToDocuments:changes];
 }
 
+- (void)testServesRefillOnDeleteFromPrefetchedDocuments {
+  FSTQuery *query = [[self queryForMessages] queryBySettingLimit:2];
+  FSTDocument *doc1 = FSTTestDoc("rooms/eros/messages/0", 0, @{}, DocumentState::kSynced);
+  FSTDocument *doc2 = FSTTestDoc("rooms/eros/messages/1", 0, @{}, DocumentState::kSynced);
+  FSTDocument *doc3 = FSTTestDoc("rooms/eros/messages/2", 0, @{}, DocumentState::kSynced);
+  FSTDocument *doc4 = FSTTestDoc("rooms/eros/messages/3", 0, @{}, DocumentState::kSynced);
+  FSTDocument *doc5 = FSTTestDoc("rooms/eros/messages/4", 0, @{}, DocumentState::kSynced);
+  FSTView *view = [[FSTView alloc] initWithQuery:query
+                                 remoteDocuments:DocumentKeySet{}
+                                    prefetchSize:2];
+  XCTAssertEqual(5, view.fillQuery.limit);
+
+  // Start with a full view, and two documents past it.
+  FSTViewDocumentChanges *changes =
+      [view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc1, doc2, doc3, doc4, doc5 ])];
+  XC_ASSERT_THAT(changes.documentSet, ContainsDocs({doc1, doc2}));
+  XCTAssertFalse(changes.needsRefill);
+  XCTAssertEqual(2, changes.changeSet.GetChanges().size());
+  [view applyChangesToDocuments:changes];
+
+  // Removing docs pulls in the prefetched ones.
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ FSTTestDeletedDoc(
+                                                  "rooms/eros/messages/0", 0, NO) ])];
+  XC_ASSERT_THAT(changes.documentSet, ContainsDocs({doc2, doc3}));
+  XCTAssertFalse(changes.needsRefill);
+  XCTAssertEqual(2, changes.changeSet.GetChanges().size());
+  [view applyChangesToDocuments:changes];
+
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ FSTTestDeletedDoc(
+                                                  "rooms/eros/messages/1", 0, NO) ])];
+  XC_ASSERT_THAT(changes.documentSet, ContainsDocs({doc3, doc4}));
+  XCTAssertFalse(changes.needsRefill);
+  [view applyChangesToDocuments:changes];
+
+  // The view doesn't know about doc5 anymore, since it was past the prefetched docs.
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ FSTTestDeletedDoc(
+                                                  "rooms/eros/messages/2", 0, NO) ])];
+  XC_ASSERT_THAT(changes.documentSet, ContainsDocs({doc4}));
+  XCTAssertTrue(changes.needsRefill);
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc4, doc5 ])
+                              previousChanges:changes];
+  XC_ASSERT_THAT(changes.documentSet, ContainsDocs({doc4, doc5}));
+  XCTAssertFalse(changes.needsRefill);
+  [view applyChangesToDocuments:changes];
+}
+
+- (void)testServesRefillOnReorderFromPrefetchedDocuments {
+  FSTQuery *query = [self queryForMessages];
+  query = [query queryByAddingSortOrder:OrderBy("order")];
+  query = [query queryBySettingLimit:2];
+  FSTDocument *doc1 =
+      FSTTestDoc("rooms/eros/messages/0", 0, @{@"order" : @1}, DocumentState::kSynced);
+  FSTDocument *doc2 =
+      FSTTestDoc("rooms/eros/messages/1", 0, @{@"order" : @2}, DocumentState::kSynced);
+  FSTDocument *doc3 =
+      FSTTestDoc("rooms/eros/messages/2", 0, @{@"order" : @3}, DocumentState::kSynced);
+  FSTView *view = [[FSTView alloc] initWithQuery:query
+                                 remoteDocuments:DocumentKeySet{}
+                                    prefetchSize:2];
+
+  // Start with a full view. The cache has no more docs than the view can hold.
+  FSTViewDocumentChanges *changes =
+      [view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc1, doc2, doc3 ])];
+  XC_ASSERT_THAT(changes.documentSet, ContainsDocs({doc1, doc2}));
+  XCTAssertFalse(changes.needsRefill);
+  [view applyChangesToDocuments:changes];
+
+  // Move one of the docs past the prefetched one.
+  doc2 = FSTTestDoc("rooms/eros/messages/1", 1, @{@"order" : @2000}, DocumentState::kSynced);
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc2 ])];
+  XC_ASSERT_THAT(changes.documentSet, ContainsDocs({doc1, doc3}));
+  XCTAssertFalse(changes.needsRefill);
+  XC_ASSERT_THAT(changes.changeSet.GetChanges(),
+                 ElementsAre(DocumentViewChange{doc2, DocumentViewChange::Type::kRemoved},
+                             DocumentViewChange{doc3, DocumentViewChange::Type::kAdded}));
+  [view applyChangesToDocuments:changes];
+
+  // And back.
+  doc2 = FSTTestDoc("rooms/eros/messages/1", 2, @{@"order" : @2}, DocumentState::kSynced);
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc2 ])];
+  XC_ASSERT_THAT(changes.documentSet, ContainsDocs({doc1, doc2}));
+  XCTAssertFalse(changes.needsRefill);
+  [view applyChangesToDocuments:changes];
+}
+
+- (void)testPrefetchedDocumentsTrackChanges {
+  FSTQuery *query = [[self queryForMessages] queryBySettingLimit:2];
+  FSTDocument *doc1 = FSTTestDoc("rooms/eros/messages/0", 0, @{}, DocumentState::kSynced);
+  FSTDocument *doc2 = FSTTestDoc("rooms/eros/messages/1", 0, @{}, DocumentState::kSynced);
+  FSTDocument *doc3 = FSTTestDoc("rooms/eros/messages/2", 0, @{}, DocumentState::kSynced);
+  FSTDocument *doc4 = FSTTestDoc("rooms/eros/messages/3", 0, @{}, DocumentState::kSynced);
+  FSTView *view = [[FSTView alloc] initWithQuery:query
+                                 remoteDocuments:DocumentKeySet{}
+                                    prefetchSize:1];
+  FSTViewDocumentChanges *changes =
+      [view computeChangesWithDocuments:FSTTestDocUpdates(@[ doc1, doc2, doc3, doc4 ])];
+  [view applyChangesToDocuments:changes];
+
+  // Deleting the prefetched doc doesn't change the view.
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ FSTTestDeletedDoc(
+                                                  "rooms/eros/messages/2", 0, NO) ])];
+  XC_ASSERT_THAT(changes.documentSet, ContainsDocs({doc1, doc2}));
+  XCTAssertFalse(changes.needsRefill);
+  XCTAssertEqual(0, changes.changeSet.GetChanges().size());
+  [view applyChangesToDocuments:changes];
+
+  // But nothing is left to replace a doc in the view with.
+  changes = [view computeChangesWithDocuments:FSTTestDocUpdates(@[ FSTTestDeletedDoc(
+                                                  "rooms/eros/messages/0", 0, NO) ])];
+  XC_ASSERT_THAT(changes.documentSet, ContainsDocs({doc2}));
+  XCTAssertTrue(changes.needsRefill);
+}
+
 - (void)testDoesntNeedRefillOnReorderWithinLimit {
   FSTQuery *query = [self queryForMessages];
   query = [query queryByAddingSortOrder:OrderBy("order")];
@@ -682,6 +796,31 @@ inline ContainsDocsMatcherP<std::vector<FSTDocument *>> ContainsDocs(
   XCTAssertFalse(viewChange.snapshot.value().has_pending_writes());
 }
 
+- (void)testGoingOfflineRaisesSnapshotSharingTheDocuments {
+  FSTQuery *query = [self queryForMessages];
+  FSTView *view = [[FSTView alloc] initWithQuery:query remoteDocuments:DocumentKeySet{}];
+  FSTDocument *doc1 = FSTTestDoc("rooms/eros/messages/1", 0, @{}, DocumentState::kSynced);
+  FSTDocument *doc2 = FSTTestDoc("rooms/eros/messages/2", 0, @{}, DocumentState::kSynced);
+  ViewSnapshot synced =
+      FSTTestApplyChanges(view, @[ doc1, doc2 ],
+                          FSTTestTargetChangeAckDocuments({doc1.key, doc2.key}))
+          .value();
+  XCTAssertFalse(synced.from_cache());
+
+  FSTViewChange *viewChange = [view applyChangedOnlineState:OnlineState::Offline];
+  XCTAssertEqual(viewChange.limboChanges.count, 0);
+  ViewSnapshot offline = viewChange.snapshot.value();
+  XC_ASSERT_THAT(offline.documents(), ElementsAre(doc1, doc2));
+  XCTAssertTrue(offline.old_documents() == offline.documents());
+  XCTAssertTrue(offline.document_changes().empty());
+  XCTAssertTrue(offline.from_cache());
+  XCTAssertTrue(offline.sync_state_changed());
+
+  // Already from the cache, so going offline again has no effect.
+  viewChange = [view applyChangedOnlineState:OnlineState::Offline];
+  XCTAssertFalse(viewChange.snapshot.has_value());
+}
+
 - (void)testSuppressesWriteAcknowledgementIfWatchHasNotCaughtUp {
   // This test verifies that we don't get three events for an FSTServerTimestamp mutation. We
   // suppress the event generated by the write acknowledgement and instead wait for Watch to catch
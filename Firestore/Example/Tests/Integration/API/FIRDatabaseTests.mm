@@ -21,8 +21,21 @@
 
 #import "Firestore/Example/Tests/Util/FSTEventAccumulator.h"
 #import "Firestore/Example/Tests/Util/FSTIntegrationTestCase.h"
+#import "Firestore/Source/API/FIRDocumentReference+Internal.h"
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
 
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/api/document_reference.h"
+#include "Firestore/core/src/firebase/firestore/api/document_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/api/firestore.h"
+#include "Firestore/core/src/firebase/firestore/api/source.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+
+namespace api = firebase::firestore::api;
+using firebase::firestore::Error;
+using firebase::firestore::util::StatusOr;
 using firebase::firestore::util::TimerId;
 
 @interface FIRDatabaseTests : FSTIntegrationTestCase
@@ -1315,4 +1328,81 @@ using firebase::firestore::util::TimerId;
   [self awaitExpectations];
 }
 
+- (void)testGetsDocumentsInOneRead {
+  FIRCollectionReference *collRef = [self collectionRefWithDocuments:@{
+    @"a" : @{@"k" : @"a"},
+    @"b" : @{@"k" : @"b"}
+  }];
+  std::vector<api::DocumentReference> refs{
+      [collRef documentWithPath:@"b"].internalReference,
+      [collRef documentWithPath:@"missing"].internalReference,
+      [collRef documentWithPath:@"a"].internalReference};
+  std::shared_ptr<api::Firestore> firestore = collRef.firestore.wrapped;
+
+  for (api::Source source : {api::Source::Default, api::Source::Server}) {
+    StatusOr<std::vector<api::DocumentSnapshot>> result;
+    XCTestExpectation *expectation = [self expectationWithDescription:@"getDocuments"];
+    firestore->GetDocuments(refs, source,
+                            [&](StatusOr<std::vector<api::DocumentSnapshot>> maybe_snapshots) {
+                              result = std::move(maybe_snapshots);
+                              [expectation fulfill];
+                            });
+    [self awaitExpectations];
+
+    XCTAssertTrue(result.ok());
+    const std::vector<api::DocumentSnapshot> &snapshots = result.ValueOrDie();
+    XCTAssertEqual(snapshots.size(), 3);
+    XCTAssertEqual(snapshots[0].document_id(), "b");
+    XCTAssertTrue(snapshots[0].exists());
+    XCTAssertFalse(snapshots[0].metadata().from_cache());
+    XCTAssertEqual(snapshots[1].document_id(), "missing");
+    XCTAssertFalse(snapshots[1].exists());
+    XCTAssertEqual(snapshots[2].document_id(), "a");
+    XCTAssertTrue(snapshots[2].exists());
+  }
+}
+
+- (void)testGetsDocumentsFromTheCacheInOneRead {
+  FIRCollectionReference *collRef = [self collectionRefWithDocuments:@{
+    @"a" : @{@"k" : @"a"},
+    @"b" : @{@"k" : @"b"}
+  }];
+  // Get the documents into the cache.
+  [self readDocumentSetForRef:collRef];
+  std::vector<api::DocumentReference> refs{[collRef documentWithPath:@"b"].internalReference,
+                                           [collRef documentWithPath:@"a"].internalReference};
+  std::shared_ptr<api::Firestore> firestore = collRef.firestore.wrapped;
+
+  StatusOr<std::vector<api::DocumentSnapshot>> result;
+  XCTestExpectation *cached = [self expectationWithDescription:@"cached"];
+  firestore->GetDocuments(refs, api::Source::Cache,
+                          [&](StatusOr<std::vector<api::DocumentSnapshot>> maybe_snapshots) {
+                            result = std::move(maybe_snapshots);
+                            [cached fulfill];
+                          });
+  [self awaitExpectations];
+
+  XCTAssertTrue(result.ok());
+  const std::vector<api::DocumentSnapshot> &snapshots = result.ValueOrDie();
+  XCTAssertEqual(snapshots.size(), 2);
+  XCTAssertEqual(snapshots[0].document_id(), "b");
+  XCTAssertTrue(snapshots[0].exists());
+  XCTAssertTrue(snapshots[0].metadata().from_cache());
+  XCTAssertEqual(snapshots[1].document_id(), "a");
+  XCTAssertTrue(snapshots[1].exists());
+
+  // A document that was never read isn't in the cache.
+  refs.push_back([collRef documentWithPath:@"missing"].internalReference);
+  XCTestExpectation *missing = [self expectationWithDescription:@"missing"];
+  firestore->GetDocuments(refs, api::Source::Cache,
+                          [&](StatusOr<std::vector<api::DocumentSnapshot>> maybe_snapshots) {
+                            result = std::move(maybe_snapshots);
+                            [missing fulfill];
+                          });
+  [self awaitExpectations];
+
+  XCTAssertFalse(result.ok());
+  XCTAssertEqual(result.status().code(), Error::Unavailable);
+}
+
 @end
@@ -20,6 +20,15 @@
 
 #import "Firestore/Example/Tests/Util/FSTEventAccumulator.h"
 #import "Firestore/Example/Tests/Util/FSTIntegrationTestCase.h"
+#import "Firestore/Source/API/FIRQuery+Internal.h"
+
+#include "Firestore/core/src/firebase/firestore/api/firestore.h"
+#include "Firestore/core/src/firebase/firestore/api/query_core.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
+
+namespace api = firebase::firestore::api;
+using firebase::firestore::local::QueryProfile;
+using firebase::firestore::util::Status;
 
 @interface FIRQueryTests : FSTIntegrationTestCase
 @end
@@ -431,4 +440,59 @@
   XCTAssertEqualObjects(ids, (@[ @"cg-doc2" ]));
 }
 
+- (void)testProfilesQueriesAgainstTheCache {
+  FIRCollectionReference *collRef = [self collectionRefWithDocuments:@{
+    @"a" : @{@"k" : @"a"},
+    @"b" : @{@"k" : @"b"},
+    @"c" : @{@"k" : @"c"}
+  }];
+  FIRQuery *query = [collRef queryWhereField:@"k" isEqualTo:@"b"];
+  api::Query apiQuery = query.apiQuery;
+
+  QueryProfile profile;
+  size_t documentCount = 0;
+  XCTestExpectation *expectation = [self expectationWithDescription:@"profiled"];
+  apiQuery.ProfileDocumentsFromCache(
+      [&](api::QuerySnapshot snapshot, QueryProfile queryProfile) {
+        documentCount = snapshot.size();
+        profile = queryProfile;
+        [expectation fulfill];
+      });
+  [self awaitExpectations];
+
+  XCTAssertEqual(documentCount, 1);
+  XCTAssertEqual(profile.documents_matched, 1);
+  XCTAssertGreaterThanOrEqual(profile.documents_scanned, profile.documents_matched);
+  XCTAssertEqual(profile.collection_parents_visited, 0);
+
+  QueryProfile aggregate = apiQuery.AggregateProfile();
+  XCTAssertGreaterThanOrEqual(aggregate.documents_matched, profile.documents_matched);
+  XCTAssertGreaterThanOrEqual(aggregate.documents_scanned, profile.documents_scanned);
+}
+
+- (void)testPreloadsQueriesFromTheCache {
+  FIRCollectionReference *collRef = [self collectionRefWithDocuments:@{
+    @"a" : @{@"k" : @"a"},
+    @"b" : @{@"k" : @"b"}
+  }];
+  api::Query apiQuery = collRef.apiQuery;
+
+  XCTestExpectation *preloaded = [self expectationWithDescription:@"preloaded"];
+  apiQuery.firestore()->PreloadQueries({apiQuery}, [&](Status status) {
+    XCTAssertTrue(status.ok());
+    [preloaded fulfill];
+  });
+  [self awaitExpectations];
+
+  size_t documentCount = 0;
+  XCTestExpectation *read = [self expectationWithDescription:@"read"];
+  apiQuery.ProfileDocumentsFromCache([&](api::QuerySnapshot snapshot, QueryProfile) {
+    documentCount = snapshot.size();
+    [read fulfill];
+  });
+  [self awaitExpectations];
+
+  XCTAssertEqual(documentCount, 2);
+}
+
 @end
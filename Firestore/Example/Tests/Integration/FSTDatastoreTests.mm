@@ -130,6 +130,12 @@ NS_ASSUME_NONNULL_BEGIN
   [expectation fulfill];
 }
 
+- (void)applySuccessfulWritesWithResults:(const std::vector<FSTMutationBatchResult *> &)batchResults {
+  for (FSTMutationBatchResult *batchResult : batchResults) {
+    [self applySuccessfulWriteWithResult:batchResult];
+  }
+}
+
 - (void)rejectFailedWriteWithBatchID:(BatchId)batchID error:(NSError *)error {
   HARD_FAIL("Not implemented");
 }
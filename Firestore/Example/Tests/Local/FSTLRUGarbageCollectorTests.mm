@@ -223,7 +223,7 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (FSTDocument *)cacheADocumentInTransaction {
   FSTDocument *doc = [self nextTestDocument];
-  _documentCache->Add(doc);
+  _documentCache->Add(doc, doc.version);
   return doc;
 }
 
@@ -631,7 +631,7 @@ NS_ASSUME_NONNULL_BEGIN
                                                  key:middleDocToUpdate
                                              version:testutil::Version(version)
                                                state:DocumentState::kSynced];
-    _documentCache->Add(doc);
+    _documentCache->Add(doc, doc.version);
     [self updateTargetInTransaction:middleTarget];
   });
 
@@ -771,6 +771,45 @@ NS_ASSUME_NONNULL_BEGIN
   [_persistence shutdown];
 }
 
+- (void)testIncrementalGCRunsInSlices {
+  if ([self isTestBaseClass]) return;
+
+  LruParams params = LruParams::Default();
+  // Set a low threshold so we will definitely run
+  params.minBytesThreshold = 100;
+  params.maximumSequenceNumbersPerSlice = 4;
+  [self newTestResourcesWithLruParams:params];
+
+  // Add 100 targets and 10 documents to each
+  for (int i = 0; i < 100; i++) {
+    // Use separate transactions so that each target and associated documents get their own
+    // sequence number.
+    _persistence.run("Add a target and some documents", [&]() {
+      FSTQueryData *queryData = [self addNextQueryInTransaction];
+      for (int j = 0; j < 10; j++) {
+        FSTDocument *doc = [self cacheADocumentInTransaction];
+        [self addDocument:doc.key toTarget:queryData.targetID];
+      }
+    });
+  }
+
+  // The 10 sequence numbers to collect are split up into slices of 4, 4 and 2.
+  std::vector<int> targetsRemoved;
+  int documentsRemoved = 0;
+  LruResults results;
+  do {
+    results = _persistence.run(
+        "GC slice", [&]() -> LruResults { return [_gc collectSliceWithLiveTargets:{}]; });
+    XCTAssertTrue(results.didRun);
+    targetsRemoved.push_back(results.targetsRemoved);
+    documentsRemoved += results.documentsRemoved;
+  } while (results.hasMoreSlices && targetsRemoved.size() < 10);
+
+  XCTAssertTrue(targetsRemoved == (std::vector<int>{4, 4, 2}));
+  XCTAssertEqual(100, documentsRemoved);
+  [_persistence shutdown];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
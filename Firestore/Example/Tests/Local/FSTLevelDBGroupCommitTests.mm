@@ -0,0 +1,143 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <memory>
+#include <string>
+
+#import "Firestore/Source/Local/FSTLevelDB.h"
+
+#import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
+#include "absl/memory/memory.h"
+#include "leveldb/db.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::ExecutorLibdispatch;
+using firebase::firestore::util::Path;
+using leveldb::ReadOptions;
+
+@interface FSTLevelDBGroupCommitTests : XCTestCase
+@end
+
+@implementation FSTLevelDBGroupCommitTests {
+  std::shared_ptr<AsyncQueue> _queue;
+  Path _dir;
+  FSTLevelDB *_db;
+}
+
+- (void)setUp {
+  [super setUp];
+  dispatch_queue_t queue = dispatch_queue_create(
+      "com.google.firestore.FSTLevelDBGroupCommitTestsQueue", DISPATCH_QUEUE_SERIAL);
+  _queue = std::make_shared<AsyncQueue>(absl::make_unique<ExecutorLibdispatch>(queue));
+  _dir = [FSTPersistenceTestHelpers levelDBDir];
+  _db = [FSTPersistenceTestHelpers levelDBPersistenceWithDir:_dir];
+  // A window long enough that the group is only written when flushed explicitly.
+  _queue->EnqueueBlocking([&] {
+    [self->_db enableGroupCommitWithWindow:std::chrono::hours(1) queue:self->_queue];
+  });
+}
+
+- (void)tearDown {
+  _queue->EnqueueBlocking([&] { [self->_db shutdown]; });
+  _db = nil;
+  [super tearDown];
+}
+
+- (void)testGroupedTransactionsAreVisibleBeforeTheyAreWritten {
+  _queue->EnqueueBlocking([&] {
+    self->_db.run("Put", [&] { self->_db.currentTransaction->Put("key", "value"); });
+
+    std::string value;
+    XCTAssertTrue(self->_db.ptr->Get(ReadOptions(), "key", &value).IsNotFound());
+    self->_db.run("Get", [&] {
+      XCTAssertTrue(self->_db.currentTransaction->Get("key", &value).ok());
+    });
+    XCTAssertEqual(value, "value");
+
+    [self->_db flushPendingCommits];
+    XCTAssertTrue(self->_db.ptr->Get(ReadOptions(), "key", &value).ok());
+    XCTAssertEqual(value, "value");
+  });
+}
+
+- (void)testLaterTransactionsInAGroupOverwriteEarlierOnes {
+  _queue->EnqueueBlocking([&] {
+    self->_db.run("Put first", [&] { self->_db.currentTransaction->Put("key", "first"); });
+    self->_db.run("Put second", [&] { self->_db.currentTransaction->Put("key", "second"); });
+    self->_db.run("Put and delete", [&] {
+      self->_db.currentTransaction->Put("deleted", "value");
+      self->_db.currentTransaction->Delete("deleted");
+    });
+    [self->_db flushPendingCommits];
+
+    std::string value;
+    XCTAssertTrue(self->_db.ptr->Get(ReadOptions(), "key", &value).ok());
+    XCTAssertEqual(value, "second");
+    XCTAssertTrue(self->_db.ptr->Get(ReadOptions(), "deleted", &value).IsNotFound());
+  });
+}
+
+- (void)testSnapshotReadsWaitForPendingGroup {
+  dispatch_queue_t readers = dispatch_queue_create(
+      "com.google.firestore.FSTLevelDBGroupCommitTestsReaders", DISPATCH_QUEUE_CONCURRENT);
+  XCTestExpectation *read = [self expectationWithDescription:@"read"];
+  _queue->EnqueueBlocking([&] {
+    self->_db.run("Put", [&] { self->_db.currentTransaction->Put("key", "value"); });
+    XCTAssertFalse([self->_db runSnapshotRead:"Held back"
+                                      onQueue:readers
+                                        block:[] {}]);
+
+    [self->_db flushPendingCommits];
+    BOOL started = [self->_db runSnapshotRead:"Flushed"
+                                      onQueue:readers
+                                        block:[self, read] {
+                                          std::string value;
+                                          self->_db.run("Get", [&] {
+                                            XCTAssertTrue(
+                                                self->_db.currentTransaction->Get("key", &value)
+                                                    .ok());
+                                          });
+                                          XCTAssertEqual(value, "value");
+                                          [read fulfill];
+                                        }];
+    XCTAssertTrue(started);
+  });
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+}
+
+- (void)testShutdownWritesPendingGroup {
+  _queue->EnqueueBlocking([&] {
+    self->_db.run("Put", [&] { self->_db.currentTransaction->Put("key", "value"); });
+    [self->_db shutdown];
+  });
+
+  _db = [FSTPersistenceTestHelpers levelDBPersistenceWithDir:_dir];
+  std::string value;
+  XCTAssertTrue(_db.ptr->Get(ReadOptions(), "key", &value).ok());
+  XCTAssertEqual(value, "value");
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -19,6 +19,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
@@ -37,16 +38,22 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+using firebase::Timestamp;
 using firebase::firestore::Error;
+using firebase::firestore::local::LevelDbCollectionGroupDocumentKey;
+using firebase::firestore::local::LevelDbCollectionMutationKey;
 using firebase::firestore::local::LevelDbCollectionParentKey;
 using firebase::firestore::local::LevelDbDocumentMutationKey;
+using firebase::firestore::local::LevelDbDocumentReadTimeKey;
 using firebase::firestore::local::LevelDbDocumentTargetKey;
+using firebase::firestore::local::LevelDbMigrationProgressKey;
 using firebase::firestore::local::LevelDbMigrations;
 using firebase::firestore::local::LevelDbMutationKey;
 using firebase::firestore::local::LevelDbMutationQueueKey;
 using firebase::firestore::local::LevelDbQueryCache;
 using firebase::firestore::local::LevelDbQueryTargetKey;
 using firebase::firestore::local::LevelDbRemoteDocumentKey;
+using firebase::firestore::local::LevelDbRemoteDocumentReadTimeKey;
 using firebase::firestore::local::LevelDbTargetDocumentKey;
 using firebase::firestore::local::LevelDbTargetGlobalKey;
 using firebase::firestore::local::LevelDbTargetKey;
@@ -54,6 +61,8 @@ using firebase::firestore::local::LevelDbTransaction;
 using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::ListenSequenceNumber;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
 using firebase::firestore::testutil::Key;
 using firebase::firestore::util::OrderedCode;
@@ -415,6 +424,198 @@ using SchemaVersion = LevelDbMigrations::SchemaVersion;
   }
 }
 
+- (void)testCreateCollectionMutationsIndex {
+  // This test creates a database with schema version 7 that has a few
+  // mutations and then ensures that appropriate entries are written to the
+  // collection mutations index.
+  std::vector<std::pair<std::string, BatchId>> writes{
+      {"coll/a", 1}, {"coll/b", 1}, {"coll/a/sub/a", 2}, {"coll/c", 3}, {"other/a", 3}};
+  std::map<std::string, std::vector<BatchId>> expected_batches{
+      {"coll", {1, 3}}, {"coll/a/sub", {2}}, {"other", {3}}};
+
+  std::string empty_buffer;
+  LevelDbMigrations::RunMigrations(_db.get(), 7);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write Mutations");
+    for (const auto &write : writes) {
+      // We "cheat" and only write the DbDocumentMutation index entries, since
+      // that's all the migration uses.
+      DocumentKey key = DocumentKey::FromPathString(write.first);
+      transaction.Put(LevelDbDocumentMutationKey::Key("dummy-uid", key, write.second),
+                      empty_buffer);
+    }
+
+    // Write a stale entry, as if left behind by a downgrade.
+    transaction.Put(LevelDbCollectionMutationKey::Key("dummy-uid", ResourcePath{"stale"}, 4),
+                    empty_buffer);
+
+    transaction.Commit();
+  }
+
+  // Migrate to v8 and verify index entries.
+  LevelDbMigrations::RunMigrations(_db.get(), 8);
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify");
+
+    std::map<std::string, std::vector<BatchId>> actual_batches;
+    auto index_iterator = transaction.NewIterator();
+    std::string index_prefix = LevelDbCollectionMutationKey::KeyPrefix("dummy-uid");
+    LevelDbCollectionMutationKey row_key;
+    for (index_iterator->Seek(index_prefix); index_iterator->Valid(); index_iterator->Next()) {
+      if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
+          !row_key.Decode(index_iterator->key()))
+        break;
+
+      std::vector<BatchId> &batches = actual_batches[row_key.collection_path().CanonicalString()];
+      batches.push_back(row_key.batch_id());
+    }
+
+    XCTAssertEqual(actual_batches, expected_batches);
+  }
+}
+
+- (void)testCreateCollectionGroupDocumentsIndex {
+  // This test creates a database with schema version 8 that has a few remote
+  // documents and then ensures that appropriate entries are written to the
+  // collection group documents index.
+  std::vector<std::string> remote_doc_paths{"cg1/a", "cg1/a/cg2/b", "x/y/cg1/c", "cg2/d"};
+  std::map<std::string, std::vector<std::string>> expected_docs{
+      {"cg1", {"cg1/a", "x/y/cg1/c"}}, {"cg2", {"cg1/a/cg2/b", "cg2/d"}}};
+
+  std::string empty_buffer;
+  LevelDbMigrations::RunMigrations(_db.get(), 8);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write Remote Documents");
+    for (const auto &remote_doc_path : remote_doc_paths) {
+      DocumentKey key = DocumentKey::FromPathString(remote_doc_path);
+      transaction.Put(LevelDbRemoteDocumentKey::Key(key), empty_buffer);
+    }
+
+    // Write a stale entry, as if left behind by a downgrade.
+    transaction.Put(
+        LevelDbCollectionGroupDocumentKey::Key(DocumentKey::FromPathString("cg1/stale")),
+        empty_buffer);
+
+    transaction.Commit();
+  }
+
+  // Migrate to v9 and verify index entries.
+  LevelDbMigrations::RunMigrations(_db.get(), 9);
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify");
+
+    std::map<std::string, std::vector<std::string>> actual_docs;
+    auto index_iterator = transaction.NewIterator();
+    std::string index_prefix = LevelDbCollectionGroupDocumentKey::KeyPrefix();
+    LevelDbCollectionGroupDocumentKey row_key;
+    for (index_iterator->Seek(index_prefix); index_iterator->Valid(); index_iterator->Next()) {
+      if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
+          !row_key.Decode(index_iterator->key()))
+        break;
+
+      std::vector<std::string> &docs = actual_docs[row_key.collection_id()];
+      docs.push_back(row_key.document_key().path().CanonicalString());
+    }
+
+    XCTAssertEqual(actual_docs, expected_docs);
+  }
+}
+
+- (void)testResumesInterruptedMigration {
+  // This test creates a database with schema version 8 in which the migration to
+  // version 9 wrote a chunk of the collection group documents index, up to and
+  // including cg1/b, and was then interrupted.
+  std::string empty_buffer;
+  LevelDbMigrations::RunMigrations(_db.get(), 8);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write interrupted migration");
+    for (const char *path : {"cg1/a", "cg1/b", "cg1/c"}) {
+      DocumentKey key = DocumentKey::FromPathString(path);
+      transaction.Put(LevelDbRemoteDocumentKey::Key(key), empty_buffer);
+    }
+    for (const char *path : {"cg1/a", "cg1/b"}) {
+      DocumentKey key = DocumentKey::FromPathString(path);
+      transaction.Put(LevelDbCollectionGroupDocumentKey::Key(key), empty_buffer);
+    }
+
+    std::string lastKey = LevelDbRemoteDocumentKey::Key(DocumentKey::FromPathString("cg1/b"));
+    transaction.Put(LevelDbMigrationProgressKey::Key(),
+                    LevelDbMigrationProgressKey::EncodeProgress(9, 0, lastKey));
+    transaction.Commit();
+  }
+
+  // The index written before the interruption is kept, and the migration carries on after cg1/b.
+  LevelDbMigrations::RunMigrations(_db.get(), 9);
+  XCTAssertEqual(LevelDbMigrations::ReadSchemaVersion(_db.get()), 9);
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify");
+
+    std::vector<std::string> actual_docs;
+    auto index_iterator = transaction.NewIterator();
+    std::string index_prefix = LevelDbCollectionGroupDocumentKey::KeyPrefix();
+    LevelDbCollectionGroupDocumentKey row_key;
+    for (index_iterator->Seek(index_prefix); index_iterator->Valid(); index_iterator->Next()) {
+      if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
+          !row_key.Decode(index_iterator->key()))
+        break;
+
+      actual_docs.push_back(row_key.document_key().path().CanonicalString());
+    }
+    std::vector<std::string> expected_docs{"cg1/a", "cg1/b", "cg1/c"};
+    XCTAssertEqual(actual_docs, expected_docs);
+
+    std::string progress;
+    XCTAssertTrue(transaction.Get(LevelDbMigrationProgressKey::Key(), &progress).IsNotFound());
+  }
+}
+
+- (void)testCreatesRemoteDocumentReadTimes {
+  // This test creates a database with schema version 9 that has a few cached documents and a
+  // last remote snapshot version. After the migration every document is taken to have been read at
+  // that version.
+  std::string empty_buffer;
+  LevelDbMigrations::RunMigrations(_db.get(), 9);
+  {
+    LevelDbTransaction transaction(_db.get(), "Write documents");
+    FSTPBTargetGlobal *metadata = LevelDbQueryCache::ReadMetadata(_db.get());
+    metadata.lastRemoteSnapshotVersion.seconds = 5;
+    metadata.lastRemoteSnapshotVersion.nanos = 6000;
+    transaction.Put(LevelDbTargetGlobalKey::Key(), metadata);
+
+    for (const char *path : {"coll/a", "coll/b", "coll/a/sub/c"}) {
+      transaction.Put(LevelDbRemoteDocumentKey::Key(DocumentKey::FromPathString(path)),
+                      empty_buffer);
+    }
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(_db.get(), 10);
+  {
+    LevelDbTransaction transaction(_db.get(), "Verify");
+    SnapshotVersion expected_read_time{Timestamp{5, 6000}};
+
+    std::vector<std::string> actual_docs;
+    auto index_iterator = transaction.NewIterator();
+    std::string index_prefix = LevelDbRemoteDocumentReadTimeKey::KeyPrefix();
+    LevelDbRemoteDocumentReadTimeKey row_key;
+    for (index_iterator->Seek(index_prefix); index_iterator->Valid(); index_iterator->Next()) {
+      if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
+          !row_key.Decode(index_iterator->key()))
+        break;
+
+      XCTAssertEqual(row_key.read_time(), expected_read_time);
+      actual_docs.push_back(row_key.document_key().path().CanonicalString());
+
+      std::string value;
+      XCTAssertTrue(
+          transaction.Get(LevelDbDocumentReadTimeKey::Key(row_key.document_key()), &value).ok());
+      XCTAssertEqual(LevelDbDocumentReadTimeKey::DecodeReadTime(value), expected_read_time);
+    }
+    std::vector<std::string> expected_docs{"coll/a", "coll/b", "coll/a/sub/c"};
+    XCTAssertEqual(actual_docs, expected_docs);
+  }
+}
+
 - (void)testCanDowngrade {
   // First, run all of the migrations
   LevelDbMigrations::RunMigrations(_db.get());
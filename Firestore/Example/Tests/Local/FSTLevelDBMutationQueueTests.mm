@@ -16,13 +16,16 @@
 
 #import <XCTest/XCTest.h>
 
+#include <cstring>
 #include <string>
 #include <vector>
 
 #import "Firestore/Example/Tests/Local/FSTMutationQueueTests.h"
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Model/FSTMutation.h"
 
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
@@ -34,10 +37,12 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+using firebase::Timestamp;
 using firebase::firestore::auth::User;
 using firebase::firestore::local::LevelDbMutationKey;
 using firebase::firestore::local::LevelDbMutationQueue;
 using firebase::firestore::local::LoadNextBatchIdFromDb;
+using firebase::firestore::local::PendingWrites;
 using firebase::firestore::local::ReferenceSet;
 using firebase::firestore::model::BatchId;
 using firebase::firestore::util::OrderedCode;
@@ -140,6 +145,39 @@ std::string MutationLikeKey(absl::string_view table, absl::string_view userID, B
   XCTAssertEqual(LoadNextBatchIdFromDb(_db.ptr), 4);
 }
 
+- (void)testPersistsPendingWrites {
+  self.persistence.run("Add batches", [&]() {
+    for (NSString *key : {@"foo/bar", @"foo/baz"}) {
+      self.mutationQueue->AddMutationBatch(Timestamp::Now(), {},
+                                           {FSTTestSetMutation(key, @{@"a" : @1})});
+    }
+  });
+  PendingWrites written =
+      self.persistence.run("Get", [&]() { return self.mutationQueue->GetPendingWrites(); });
+  XCTAssertEqual(written.batch_count, 2);
+  XCTAssertGreaterThan(written.byte_size, 0);
+
+  self.mutationQueue = [_db mutationQueueForUser:User("user")];
+  PendingWrites loaded = self.persistence.run("Restart", [&]() {
+    self.mutationQueue->Start();
+    return self.mutationQueue->GetPendingWrites();
+  });
+  XCTAssertEqual(loaded, written);
+}
+
+- (void)testCountsPendingWritesMissingFromMetadata {
+  // Batches written by a version that didn't count them.
+  [self setDummyValueForKey:LevelDbMutationKey::Key("user", 1)];
+  [self setDummyValueForKey:LevelDbMutationKey::Key("user", 2)];
+
+  PendingWrites pending = self.persistence.run("Restart", [&]() {
+    self.mutationQueue->Start();
+    return self.mutationQueue->GetPendingWrites();
+  });
+  XCTAssertEqual(pending.batch_count, 2);
+  XCTAssertEqual(pending.byte_size, static_cast<int64_t>(2 * strlen(kDummy)));
+}
+
 - (void)testEmptyProtoCanBeUpgraded {
   // An empty protocol buffer serializes to a zero-length byte buffer.
   GPBEmpty *empty = [GPBEmpty message];
@@ -16,21 +16,35 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
 #import "Firestore/Example/Tests/Local/FSTRemoteDocumentCacheTests.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
+#import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/memory/memory.h"
 #include "leveldb/db.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+namespace testutil = firebase::firestore::testutil;
 using leveldb::WriteOptions;
+using firebase::firestore::api::Settings;
 using firebase::firestore::local::LevelDbRemoteDocumentCache;
+using firebase::firestore::local::LevelDbRemoteDocumentKey;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentMap;
+using firebase::firestore::model::DocumentState;
 using firebase::firestore::local::RemoteDocumentCache;
 using firebase::firestore::util::OrderedCode;
 
@@ -55,7 +69,8 @@ static const char *kDummy = "1";
   _db = [FSTPersistenceTestHelpers levelDBPersistence];
   self.persistence = _db;
   HARD_ASSERT(!_cache, "Previous cache not torn down");
-  _cache = absl::make_unique<LevelDbRemoteDocumentCache>(_db, _db.serializer);
+  _cache = absl::make_unique<LevelDbRemoteDocumentCache>(
+      _db, _db.serializer, Settings::DefaultDocumentCacheSizeBytes);
 
   // Write a couple dummy rows that should appear before/after the remote_documents table to make
   // sure the tests are unaffected.
@@ -75,6 +90,48 @@ static const char *kDummy = "1";
   _db = nil;
 }
 
+- (void)testReadsRowsChangedBehindDecodedDocuments {
+  FSTDocument *updated = FSTTestDoc("a/b", 2, @{@"a" : @2}, DocumentState::kSynced);
+
+  self.persistence.run("testReadsRowsChangedBehindDecodedDocuments", [&]() {
+    FSTDocument *original = FSTTestDoc("a/b", 1, @{@"a" : @1}, DocumentState::kSynced);
+    _cache->Add(original, original.version);
+    XCTAssertEqualObjects(_cache->Get(testutil::Key("a/b")), original);
+  });
+
+  // Rewrite the row without going through the cache, as another instance would.
+  NSData *data = [[_db.serializer encodedMaybeDocument:updated] data];
+  _db.ptr->Put(WriteOptions(), LevelDbRemoteDocumentKey::Key(testutil::Key("a/b")),
+               leveldb::Slice(static_cast<const char *>(data.bytes), data.length));
+
+  self.persistence.run("testReadsRowsChangedBehindDecodedDocuments", [&]() {
+    XCTAssertEqualObjects(_cache->Get(testutil::Key("a/b")), updated);
+  });
+}
+
+- (void)testGetsDocumentsReadSinceAVersion {
+  self.persistence.run("testGetsDocumentsReadSinceAVersion", [&]() {
+    _cache->Add(FSTTestDoc("a/1", 1, @{}, DocumentState::kSynced), testutil::Version(1));
+    _cache->Add(FSTTestDoc("a/2", 1, @{}, DocumentState::kSynced), testutil::Version(1));
+    _cache->Add(FSTTestDoc("a/3", 1, @{}, DocumentState::kSynced), testutil::Version(2));
+    _cache->Add(FSTTestDoc("a/4", 1, @{}, DocumentState::kSynced), testutil::Version(3));
+    _cache->Add(FSTTestDoc("a/1/b/1", 1, @{}, DocumentState::kSynced), testutil::Version(3));
+    _cache->Add(FSTTestDoc("c/1", 1, @{}, DocumentState::kSynced), testutil::Version(3));
+
+    // Documents written again move to their new read time; removed ones drop out.
+    _cache->Add(FSTTestDoc("a/2", 2, @{}, DocumentState::kSynced), testutil::Version(3));
+    _cache->Remove(testutil::Key("a/4"));
+
+    DocumentMap results = _cache->GetReadSince(FSTTestQuery("a"), testutil::Version(2));
+    std::vector<DocumentKey> keys;
+    for (const auto &kv : results.underlying_map()) {
+      keys.push_back(kv.first);
+    }
+    std::vector<DocumentKey> expected{testutil::Key("a/2"), testutil::Key("a/3")};
+    XCTAssertEqual(keys, expected);
+  });
+}
+
 - (void)writeDummyRowWithSegments:(NSArray<NSString *> *)segments {
   std::string key;
   for (NSString *segment in segments) {
@@ -29,12 +29,15 @@
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_snapshot.h"
 #include "absl/strings/string_view.h"
 #include "leveldb/db.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 using firebase::firestore::local::LevelDbMutationKey;
+using firebase::firestore::local::LevelDbSnapshot;
+using firebase::firestore::local::LevelDbSnapshotScope;
 using firebase::firestore::local::LevelDbTransaction;
 using firebase::firestore::util::Path;
 using leveldb::DB;
@@ -256,6 +259,78 @@ using leveldb::WriteOptions;
   XCTAssertFalse(it->Valid());
 }
 
+- (void)testScanReadOptionsIterateMergedView {
+  Status status = _db->Put(LevelDbTransaction::DefaultWriteOptions(), "key_0", "value_0");
+  XCTAssertTrue(status.ok());
+
+  LevelDbTransaction transaction(_db.get(), "testScanReadOptionsIterateMergedView");
+  transaction.Put("key_1", "value_1");
+  for (const ReadOptions &options :
+       {LevelDbTransaction::FastScanReadOptions(), LevelDbTransaction::OneOffScanReadOptions()}) {
+    auto it = transaction.NewIterator(options);
+    it->Seek("key_0");
+    XCTAssertTrue(it->Valid());
+    XCTAssertEqual("value_0", it->value());
+    it->Next();
+    XCTAssertTrue(it->Valid());
+    XCTAssertEqual("value_1", it->value());
+    it->Next();
+    XCTAssertFalse(it->Valid());
+  }
+}
+
+- (void)testCountsChangedBytes {
+  LevelDbTransaction transaction(_db.get(), "testCountsChangedBytes");
+  XCTAssertEqual(transaction.changed_bytes(), 0u);
+
+  transaction.Put("a", "bc");
+  XCTAssertEqual(transaction.changed_bytes(), 3u);
+  transaction.Put("a", "b");
+  XCTAssertEqual(transaction.changed_bytes(), 2u);
+  transaction.Delete("a");
+  XCTAssertEqual(transaction.changed_bytes(), 1u);
+  transaction.Put("dd", "");
+  XCTAssertEqual(transaction.changed_bytes(), 3u);
+  transaction.Delete("zz");
+  transaction.Delete("zz");
+  XCTAssertEqual(transaction.changed_bytes(), 5u);
+  // Deleting a key that was put swaps its value for the deletion of the key.
+  transaction.Delete("dd");
+  XCTAssertEqual(transaction.changed_bytes(), 5u);
+
+  XCTAssertEqual(transaction.peak_changed_bytes(), 5u);
+}
+
+- (void)testCommitChunkIfLarger {
+  LevelDbTransaction transaction(_db.get(), "testCommitChunkIfLarger");
+  transaction.Put("key_0", "value_0");
+  auto it = transaction.NewIterator();
+
+  std::string value;
+  transaction.CommitChunkIfLarger(1000);
+  XCTAssertTrue(_db->Get(ReadOptions(), "key_0", &value).IsNotFound());
+
+  size_t pending = transaction.changed_bytes();
+  transaction.CommitChunkIfLarger(pending);
+  XCTAssertTrue(_db->Get(ReadOptions(), "key_0", &value).ok());
+  XCTAssertEqual(transaction.changed_bytes(), 0u);
+  XCTAssertEqual(transaction.peak_changed_bytes(), pending);
+
+  // The iterator still sees the changes written in the chunk, merged with the pending ones.
+  transaction.Put("key_1", "value_1");
+  it->Seek("key_0");
+  XCTAssertTrue(it->Valid());
+  XCTAssertEqual("value_0", it->value());
+  it->Next();
+  XCTAssertTrue(it->Valid());
+  XCTAssertEqual("value_1", it->value());
+  it->Next();
+  XCTAssertFalse(it->Valid());
+
+  transaction.Commit();
+  XCTAssertTrue(_db->Get(ReadOptions(), "key_1", &value).ok());
+}
+
 - (void)testDeletingAheadOfAnIterator {
   // Write keys
   for (int i = 0; i < 4; ++i) {
@@ -282,6 +357,43 @@ using leveldb::WriteOptions;
   XCTAssertFalse(it->Valid());
 }
 
+- (void)testSnapshotIgnoresLaterWrites {
+  const WriteOptions &writeOptions = LevelDbTransaction::DefaultWriteOptions();
+  XCTAssertTrue(_db->Put(writeOptions, "key1", "before").ok());
+
+  LevelDbSnapshot snapshot(_db.get(), "testSnapshotIgnoresLaterWrites");
+  XCTAssertTrue(_db->Put(writeOptions, "key1", "after").ok());
+  XCTAssertTrue(_db->Put(writeOptions, "key2", "after").ok());
+
+  std::string value;
+  XCTAssertTrue(snapshot.transaction()->Get("key1", &value).ok());
+  XCTAssertEqual(value, "before");
+  XCTAssertTrue(snapshot.transaction()->Get("key2", &value).IsNotFound());
+
+  // Iterators read at the snapshot whatever options they are created with.
+  auto it = snapshot.transaction()->NewIterator(LevelDbTransaction::FastScanReadOptions());
+  it->Seek("key1");
+  XCTAssertTrue(it->Valid());
+  XCTAssertEqual(it->value(), "before");
+  it->Next();
+  XCTAssertFalse(it->Valid());
+}
+
+- (void)testSnapshotScopesNest {
+  XCTAssertTrue(LevelDbSnapshot::current() == nullptr);
+  LevelDbSnapshot outer(_db.get(), "outer");
+  LevelDbSnapshot inner(_db.get(), "inner");
+  {
+    LevelDbSnapshotScope outerScope(&outer);
+    {
+      LevelDbSnapshotScope innerScope(&inner);
+      XCTAssertTrue(LevelDbSnapshot::current() == &inner);
+    }
+    XCTAssertTrue(LevelDbSnapshot::current() == &outer);
+  }
+  XCTAssertTrue(LevelDbSnapshot::current() == nullptr);
+}
+
 - (void)testToString {
   std::string key = LevelDbMutationKey::Key("user1", 42);
   FSTPBWriteBatch *message = [FSTPBWriteBatch message];
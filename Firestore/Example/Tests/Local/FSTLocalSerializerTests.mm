@@ -155,6 +155,47 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertEqualObjects(decoded, doc);
 }
 
+- (void)testDecodesDocumentFieldsOnDemand {
+  FSTDocument *doc = FSTTestDoc("some/path", 42, @{@"a" : @1, @"b" : @{@"c" : @"d"}},
+                                DocumentState::kSynced);
+  FSTPBMaybeDocument *maybeDocProto = [self.serializer encodedMaybeDocument:doc];
+
+  FSTDocument *decoded = (FSTDocument *)[self.serializer decodedMaybeDocument:maybeDocProto];
+  XCTAssertEqual([decoded fieldForPath:Field("a")], [doc fieldForPath:Field("a")]);
+  XCTAssertEqual([decoded fieldForPath:Field("b")], [doc fieldForPath:Field("b")]);
+  XCTAssertEqual([decoded fieldForPath:Field("b.c")], [doc fieldForPath:Field("b.c")]);
+  XCTAssertEqual([decoded fieldForPath:Field("a.c")], absl::nullopt);
+  XCTAssertEqual([decoded fieldForPath:Field("missing")], absl::nullopt);
+
+  XCTAssertEqualObjects(decoded, doc);
+  XCTAssertEqual([decoded fieldForPath:Field("b.c")], [doc fieldForPath:Field("b.c")]);
+  XCTAssertEqualObjects([self.serializer encodedMaybeDocument:decoded], maybeDocProto);
+}
+
+- (void)testEncodesRelativeDocumentNames {
+  FSTLocalSerializer *serializer =
+      [[FSTLocalSerializer alloc] initWithRemoteSerializer:self.remoteSerializer
+                                     relativeDocumentNames:YES];
+  FSTDocument *doc = FSTTestDoc("some/path", 42, @{@"ref" : FSTTestRef("p", "d", @"other/doc")},
+                                DocumentState::kSynced);
+
+  FSTPBMaybeDocument *maybeDocProto = [serializer encodedMaybeDocument:doc];
+  XCTAssertEqualObjects(maybeDocProto.document.name, @"documents/some/path");
+  XCTAssertEqualObjects(maybeDocProto.document.fields[@"ref"].referenceValue,
+                        @"documents/other/doc");
+  XCTAssertEqualObjects([serializer decodedMaybeDocument:maybeDocProto], doc);
+
+  // Fully qualified names remain readable, and relative ones can be read without relative names.
+  FSTPBMaybeDocument *qualifiedProto = [self.serializer encodedMaybeDocument:doc];
+  XCTAssertEqualObjects([serializer decodedMaybeDocument:qualifiedProto], doc);
+  XCTAssertEqualObjects([self.serializer decodedMaybeDocument:maybeDocProto], doc);
+
+  FSTDeletedDocument *deletedDoc = FSTTestDeletedDoc("some/path", 42, false);
+  maybeDocProto = [serializer encodedMaybeDocument:deletedDoc];
+  XCTAssertEqualObjects(maybeDocProto.noDocument.name, @"documents/some/path");
+  XCTAssertEqualObjects([serializer decodedMaybeDocument:maybeDocProto], deletedDoc);
+}
+
 - (void)testEncodesUnknownDocumentAsMaybeDocument {
   FSTUnknownDocument *doc = FSTTestUnknownDoc("some/path", 42);
 
@@ -42,6 +42,7 @@
 #include "Firestore/core/src/firebase/firestore/local/local_write_result.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
@@ -52,10 +53,12 @@ using firebase::Timestamp;
 using firebase::firestore::auth::User;
 using firebase::firestore::local::LocalViewChanges;
 using firebase::firestore::local::LocalWriteResult;
+using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentState;
 using firebase::firestore::model::FieldValue;
+using firebase::firestore::model::kBatchIdUnknown;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::DocumentMap;
 using firebase::firestore::model::MaybeDocumentMap;
@@ -275,6 +278,58 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
+- (void)testDeferredMutationQueueStartsBeforeFirstWrite {
+  if ([self isTestBaseClass]) return;
+
+  [self writeMutation:FSTTestSetMutation(@"foo/bar", @{@"foo" : @"bar"})];
+  BatchId firstBatchID = [self.batches lastObject].batchID;
+
+  self.localStore = [[FSTLocalStore alloc] initWithPersistence:self.localStorePersistence
+                                                   initialUser:User::Unauthenticated()];
+  [self.localStore startDeferringMutationQueue:YES];
+  XCTAssertTrue(self.localStore.startupProfile.mutation_queue_deferred);
+  FSTAssertContains(FSTTestDoc("foo/bar", 0, @{@"foo" : @"bar"}, DocumentState::kLocalMutations));
+
+  [self writeMutation:FSTTestSetMutation(@"foo/baz", @{@"foo" : @"baz"})];
+  XCTAssertGreaterThan([self.batches lastObject].batchID, firstBatchID);
+  FSTAssertContains(FSTTestDoc("foo/baz", 0, @{@"foo" : @"baz"}, DocumentState::kLocalMutations));
+
+  // Finishing the start once the queue has started is a no-op.
+  [self.localStore finishStart];
+  [self acknowledgeMutationWithVersion:1];
+  [self acknowledgeMutationWithVersion:2];
+  XCTAssertEqual(0u, self.batches.count);
+}
+
+- (void)testMergesWritesIntoPendingBatches {
+  if ([self isTestBaseClass]) return;
+
+  self.localStore.mutationCompactionEnabled = YES;
+  LocalWriteResult first =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/bar", @{@"n" : @1})}];
+  LocalWriteResult second = [self.localStore
+      locallyWriteMutations:{FSTTestPatchMutation("foo/bar", @{@"n" : @2}, {})}];
+  XCTAssertEqual(second.merged_batch_id(), first.batch_id());
+  FSTAssertContains(FSTTestDoc("foo/bar", 0, @{@"n" : @2}, DocumentState::kLocalMutations));
+
+  FSTMutationBatch *batch = [self.localStore nextMutationBatchAfterBatchID:kBatchIdUnknown];
+  XCTAssertEqual(batch.batchID, second.batch_id());
+  XCTAssertEqual(batch.mutations.size(), 1u);
+  XCTAssertEqualObjects(batch.mutations[0], FSTTestSetMutation(@"foo/bar", @{@"n" : @2}));
+  XCTAssertNil([self.localStore nextMutationBatchAfterBatchID:batch.batchID]);
+
+  // The batch may have been sent now, so later writes get batches of their own.
+  LocalWriteResult third = [self.localStore
+      locallyWriteMutations:{FSTTestPatchMutation("foo/bar", @{@"n" : @3}, {})}];
+  XCTAssertEqual(third.merged_batch_id(), kBatchIdUnknown);
+
+  // Writes to other documents aren't merged either.
+  LocalWriteResult fourth =
+      [self.localStore locallyWriteMutations:{FSTTestSetMutation(@"foo/baz", @{@"n" : @1})}];
+  XCTAssertEqual(fourth.merged_batch_id(), kBatchIdUnknown);
+  FSTAssertContains(FSTTestDoc("foo/bar", 0, @{@"n" : @3}, DocumentState::kLocalMutations));
+}
+
 - (void)testHandlesSetMutationThenDocument {
   if ([self isTestBaseClass]) return;
 
@@ -474,6 +529,36 @@ NS_ASSUME_NONNULL_BEGIN
       FSTTestDoc("foo/bar", 2, @{@"foo" : @"bar", @"it" : @"base"}, DocumentState::kSynced));
 }
 
+- (void)testRecomputesLocalViewsWhenTheRemoteDocumentChanges {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  TargetId targetID = [self allocateQuery:query];
+  [self applyRemoteEvent:FSTTestAddedRemoteEvent(
+                             FSTTestDoc("foo/bar", 1, @{@"it" : @"base"}, DocumentState::kSynced),
+                             {targetID})];
+
+  [self writeMutation:FSTTestPatchMutation("foo/bar", @{@"a" : @1}, {})];
+  [self writeMutation:FSTTestPatchMutation("foo/bar", @{@"b" : @2}, {})];
+  FSTAssertContains(FSTTestDoc("foo/bar", 1, @{@"it" : @"base", @"a" : @1, @"b" : @2},
+                               DocumentState::kLocalMutations));
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/bar", 3, @{@"it" : @"new"}, DocumentState::kSynced),
+                             {targetID}, {})];
+  FSTMaybeDocument *expected = FSTTestDoc("foo/bar", 3, @{@"it" : @"new", @"a" : @1, @"b" : @2},
+                                          DocumentState::kLocalMutations);
+  FSTAssertChanged(@[ expected ]);
+  FSTAssertContains(expected);
+  XCTAssertEqualObjects(docMapToArray([self.localStore executeQuery:query]), @[ expected ]);
+
+  [self rejectMutation];
+  expected = FSTTestDoc("foo/bar", 3, @{@"it" : @"new", @"b" : @2}, DocumentState::kLocalMutations);
+  FSTAssertChanged(@[ expected ]);
+  FSTAssertContains(expected);
+  XCTAssertEqualObjects(docMapToArray([self.localStore executeQuery:query]), @[ expected ]);
+}
+
 - (void)testHandlesPatchMutationThenAckThenDocument {
   if ([self isTestBaseClass]) return;
 
@@ -639,6 +724,52 @@ NS_ASSUME_NONNULL_BEGIN
   }
 }
 
+- (void)testAppliesPendingBatchesToAcknowledgedDocuments {
+  if ([self isTestBaseClass]) return;
+
+  [self writeMutations:{
+    FSTTestSetMutation(@"foo/bar", @{@"foo" : @"old"}),
+        FSTTestSetMutation(@"foo/baz", @{@"foo" : @"baz"})
+  }];
+  [self writeMutation:FSTTestPatchMutation("foo/bar", @{@"foo" : @"bar"}, {})];
+
+  [self acknowledgeMutationWithVersion:1];
+  FSTAssertChanged((@[
+    FSTTestDoc("foo/bar", 1, @{@"foo" : @"bar"}, DocumentState::kLocalMutations),
+    FSTTestDoc("foo/baz", 1, @{@"foo" : @"baz"}, DocumentState::kCommittedMutations)
+  ]));
+  FSTAssertContains(FSTTestDoc("foo/bar", 1, @{@"foo" : @"bar"}, DocumentState::kLocalMutations));
+
+  [self acknowledgeMutationWithVersion:2];
+  FSTAssertChanged(
+      @[ FSTTestDoc("foo/bar", 2, @{@"foo" : @"bar"}, DocumentState::kCommittedMutations) ]);
+}
+
+- (void)testAcknowledgesSeveralBatchesTogether {
+  if ([self isTestBaseClass]) return;
+
+  [self writeMutation:FSTTestSetMutation(@"foo/bar", @{@"foo" : @"old"})];
+  [self writeMutation:FSTTestPatchMutation("foo/bar", @{@"foo" : @"bar"}, {})];
+  [self writeMutation:FSTTestSetMutation(@"foo/baz", @{@"foo" : @"baz"})];
+
+  std::vector<FSTMutationBatchResult *> results;
+  for (FSTTestSnapshotVersion version : {1, 2}) {
+    FSTMutationBatch *batch = [self.batches firstObject];
+    [self.batches removeObjectAtIndex:0];
+    FSTMutationResult *mutationResult =
+        [[FSTMutationResult alloc] initWithVersion:testutil::Version(version)
+                                  transformResults:absl::nullopt];
+    results.push_back([FSTMutationBatchResult resultWithBatch:batch
+                                                commitVersion:testutil::Version(2)
+                                              mutationResults:{mutationResult}
+                                                  streamToken:nil]);
+  }
+  _lastChanges = [self.localStore acknowledgeBatchesWithResults:results];
+  FSTAssertChanged(
+      @[ FSTTestDoc("foo/bar", 2, @{@"foo" : @"bar"}, DocumentState::kCommittedMutations) ]);
+  FSTAssertContains(FSTTestDoc("foo/baz", 0, @{@"foo" : @"baz"}, DocumentState::kLocalMutations));
+}
+
 - (void)testHandlesSetMutationAndPatchMutationTogether {
   if ([self isTestBaseClass]) return;
 
@@ -920,6 +1051,194 @@ NS_ASSUME_NONNULL_BEGIN
                         ]));
 }
 
+- (void)testAppliesRemoteEventsWithManyDocuments {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/old", 20, @{@"a" : @"b"}, DocumentState::kSynced), {2},
+                             {})];
+
+  // More updates than are read from the cache at once, with an outdated one in the middle.
+  RemoteEvent::DocumentUpdates updates;
+  const size_t count = 2500;
+  for (size_t i = 0; i < count; ++i) {
+    NSString *path = [NSString stringWithFormat:@"foo/doc%zu", i];
+    FSTDocument *doc = FSTTestDoc(path.UTF8String, 30, @{@"i" : @(i)}, DocumentState::kSynced);
+    updates[doc.key] = doc;
+  }
+  FSTDocument *outdated = FSTTestDoc("foo/old", 10, @{@"a" : @"c"}, DocumentState::kSynced);
+  updates[outdated.key] = outdated;
+
+  [self applyRemoteEvent:RemoteEvent{testutil::Version(30), /*target_changes=*/{},
+                                     /*target_mismatches=*/{}, std::move(updates),
+                                     /*limbo_document_changes=*/{}}];
+  XCTAssertEqual(_lastChanges.size(), count);
+  XCTAssertTrue(_lastChanges.find(outdated.key) == _lastChanges.end());
+  FSTAssertContains(FSTTestDoc("foo/doc0", 30, @{@"i" : @0}, DocumentState::kSynced));
+  FSTAssertContains(FSTTestDoc("foo/doc2499", 30, @{@"i" : @2499}, DocumentState::kSynced));
+  FSTAssertContains(FSTTestDoc("foo/old", 20, @{@"a" : @"b"}, DocumentState::kSynced));
+}
+
+- (void)testCanExecuteLimitQueriesInKeyOrder {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = [FSTTestQuery("foo") queryBySettingLimit:2];
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/a", 10, @{@"a" : @"b"}, DocumentState::kSynced), {2},
+                             {})];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/b", 10, @{@"a" : @"b"}, DocumentState::kSynced), {2},
+                             {})];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/c", 10, @{@"a" : @"b"}, DocumentState::kSynced), {2},
+                             {})];
+
+  // A local write ahead of the remote documents, and a local delete of one of them.
+  [self.localStore locallyWriteMutations:{ FSTTestSetMutation(@"foo/0", @{@"a" : @"b"}) }];
+  [self.localStore locallyWriteMutations:{ FSTTestDeleteMutation(@"foo/a") }];
+
+  DocumentMap docs = [self.localStore executeQuery:query];
+  XCTAssertEqualObjects(docMapToArray(docs), (@[
+                          FSTTestDoc("foo/0", 0, @{@"a" : @"b"}, DocumentState::kLocalMutations),
+                          FSTTestDoc("foo/b", 10, @{@"a" : @"b"}, DocumentState::kSynced)
+                        ]));
+}
+
+- (void)testCanExecuteLimitQueriesInFieldOrder {
+  if ([self isTestBaseClass]) return;
+
+  [self.localStore locallyWriteMutations:{
+    FSTTestSetMutation(@"foo/a", @{@"n" : @1}), FSTTestSetMutation(@"foo/b", @{@"n" : @3}),
+        FSTTestSetMutation(@"foo/c", @{@"n" : @2}), FSTTestSetMutation(@"foo/d", @{@"n" : @0})
+  }];
+  FSTQuery *query = [[FSTTestQuery("foo") queryByAddingSortOrder:testutil::OrderBy("n", "desc")]
+      queryBySettingLimit:2];
+
+  DocumentMap docs = [self.localStore executeQuery:query];
+  XCTAssertEqualObjects(
+      docMapToArray(docs), (@[
+        FSTTestDoc("foo/b", 0, @{@"n" : @3}, DocumentState::kLocalMutations),
+        FSTTestDoc("foo/c", 0, @{@"n" : @2}, DocumentState::kLocalMutations)
+      ]));
+}
+
+- (void)testCanExecuteQueriesInPages {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/a", 10, @{@"a" : @"b"}, DocumentState::kSynced), {2},
+                             {})];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/b", 10, @{@"a" : @"b"}, DocumentState::kSynced), {2},
+                             {})];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/c", 10, @{@"a" : @"b"}, DocumentState::kSynced), {2},
+                             {})];
+  [self.localStore locallyWriteMutations:{ FSTTestSetMutation(@"foo/0", @{@"a" : @"b"}) }];
+  [self.localStore locallyWriteMutations:{ FSTTestDeleteMutation(@"foo/a") }];
+
+  DocumentMap docs = [self.localStore executeQuery:query startAfter:absl::nullopt pageSize:2];
+  XCTAssertEqualObjects(docMapToArray(docs), (@[
+                          FSTTestDoc("foo/0", 0, @{@"a" : @"b"}, DocumentState::kLocalMutations),
+                          FSTTestDoc("foo/b", 10, @{@"a" : @"b"}, DocumentState::kSynced)
+                        ]));
+
+  docs = [self.localStore executeQuery:query startAfter:testutil::Key("foo/b") pageSize:2];
+  XCTAssertEqualObjects(docMapToArray(docs), (@[ FSTTestDoc("foo/c", 10, @{@"a" : @"b"},
+                                                            DocumentState::kSynced) ]));
+
+  docs = [self.localStore executeQuery:query startAfter:testutil::Key("foo/c") pageSize:2];
+  XCTAssertEqual(docs.size(), 0u);
+}
+
+- (void)testExecutesQueriesFromTargetKeys {
+  if ([self isTestBaseClass]) return;
+  // This test only works in the absence of the FSTEagerGarbageCollector.
+  if ([self gcIsEager]) return;
+
+  self.localStore.queryFromTargetKeysEnabled = YES;
+
+  FSTQuery *query = FSTTestQuery("foo");
+  TargetId targetID = [self allocateQuery:query];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/a", 10, @{@"a" : @"b"}, DocumentState::kSynced),
+                             {targetID}, {})];
+
+  WatchTargetChange watchChange{WatchTargetChangeState::Current, {targetID},
+                                FSTTestResumeTokenFromSnapshotVersion(20)};
+  auto metadataProvider = TestTargetMetadataProvider::CreateSingleResultProvider(
+      testutil::Key("foo/a"), std::vector<TargetId>{targetID});
+  WatchChangeAggregator aggregator{&metadataProvider};
+  aggregator.HandleTargetChange(watchChange);
+  [self applyRemoteEvent:aggregator.CreateRemoteEvent(testutil::Version(20))];
+  [self.localStore releaseQuery:query];
+
+  // While the query isn't listened to, another target reads a document that now matches it, and a
+  // document is written locally.
+  TargetId otherTargetID = [self allocateQuery:FSTTestQuery("foo/b")];
+  [self applyRemoteEvent:FSTTestUpdateRemoteEvent(
+                             FSTTestDoc("foo/b", 30, @{@"a" : @"b"}, DocumentState::kSynced),
+                             {otherTargetID}, {})];
+  [self.localStore locallyWriteMutations:{ FSTTestSetMutation(@"foo/c", @{@"a" : @"b"}) }];
+
+  [self allocateQuery:query];
+  DocumentMap docs = [self.localStore executeQuery:query];
+  XCTAssertEqualObjects(docMapToArray(docs), (@[
+                          FSTTestDoc("foo/a", 10, @{@"a" : @"b"}, DocumentState::kSynced),
+                          FSTTestDoc("foo/b", 30, @{@"a" : @"b"}, DocumentState::kSynced),
+                          FSTTestDoc("foo/c", 0, @{@"a" : @"b"}, DocumentState::kLocalMutations)
+                        ]));
+}
+
+- (void)testCanExecuteLimitQueriesInAscendingFieldOrderRepeatedly {
+  if ([self isTestBaseClass]) return;
+
+  FSTQuery *query = [[FSTTestQuery("foo") queryByAddingSortOrder:testutil::OrderBy("n", "asc")]
+      queryBySettingLimit:3];
+  [self allocateQuery:query];
+  FSTAssertTargetID(2);
+
+  for (FSTDocument *doc : {FSTTestDoc("foo/a", 10, @{@"n" : @1}, DocumentState::kSynced),
+                           FSTTestDoc("foo/b", 10, @{@"n" : @3}, DocumentState::kSynced),
+                           FSTTestDoc("foo/c", 10, @{@"n" : @2}, DocumentState::kSynced),
+                           FSTTestDoc("foo/d", 10, @{@"n" : @2}, DocumentState::kSynced),
+                           FSTTestDoc("foo/e", 10, @{@"n" : @5}, DocumentState::kSynced)}) {
+    [self applyRemoteEvent:FSTTestUpdateRemoteEvent(doc, {2}, {})];
+  }
+
+  // The first run may build an index on `n`, which the second one reads in order. The limit ends
+  // between two documents with the same value.
+  for (int run = 0; run < 2; ++run) {
+    DocumentMap docs = [self.localStore executeQuery:query];
+    XCTAssertEqualObjects(docMapToArray(docs), (@[
+                            FSTTestDoc("foo/a", 10, @{@"n" : @1}, DocumentState::kSynced),
+                            FSTTestDoc("foo/c", 10, @{@"n" : @2}, DocumentState::kSynced),
+                            FSTTestDoc("foo/d", 10, @{@"n" : @2}, DocumentState::kSynced)
+                          ]));
+  }
+
+  // A local write that moves the last remote document to the front.
+  [self.localStore locallyWriteMutations:{ FSTTestSetMutation(@"foo/e", @{@"n" : @0}) }];
+
+  DocumentMap docs = [self.localStore executeQuery:query];
+  XCTAssertEqualObjects(docMapToArray(docs), (@[
+                          FSTTestDoc("foo/a", 10, @{@"n" : @1}, DocumentState::kSynced),
+                          FSTTestDoc("foo/c", 10, @{@"n" : @2}, DocumentState::kSynced),
+                          FSTTestDoc("foo/e", 10, @{@"n" : @0}, DocumentState::kLocalMutations)
+                        ]));
+}
+
 - (void)testPersistsResumeTokens {
   if ([self isTestBaseClass]) return;
   // This test only works in the absence of the FSTEagerGarbageCollector.
@@ -951,6 +1270,35 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertGreaterThan(newSequenceNumber, initialSequenceNumber);
 }
 
+- (void)testDefersPersistingResumeTokens {
+  if ([self isTestBaseClass]) return;
+  // This test only works in the absence of the FSTEagerGarbageCollector.
+  if ([self gcIsEager]) return;
+
+  self.localStore.targetPersistenceDeferred = YES;
+  FSTQuery *query = FSTTestQuery("foo/bar");
+  TargetId targetID = [self.localStore allocateQuery:query].targetID;
+  NSData *resumeToken = FSTTestResumeTokenFromSnapshotVersion(1000);
+
+  WatchTargetChange watchChange{WatchTargetChangeState::Current, {targetID}, resumeToken};
+  auto metadataProvider = TestTargetMetadataProvider::CreateSingleResultProvider(
+      testutil::Key("foo/bar"), std::vector<TargetId>{targetID});
+  WatchChangeAggregator aggregator{&metadataProvider};
+  aggregator.HandleTargetChange(watchChange);
+  [self applyRemoteEvent:aggregator.CreateRemoteEvent(testutil::Version(1000))];
+
+  id<FSTPersistence> persistence = self.localStorePersistence;
+  auto persistedResumeToken = [&]() -> NSData * {
+    return persistence.run("Read target", [&]() -> NSData * {
+      return [persistence queryCache]->GetTarget(query).resumeToken;
+    });
+  };
+  XCTAssertEqual(persistedResumeToken().length, 0);
+
+  [self.localStore persistPendingTargets];
+  XCTAssertEqualObjects(persistedResumeToken(), resumeToken);
+}
+
 - (void)testRemoteDocumentKeysForTarget {
   if ([self isTestBaseClass]) return;
 
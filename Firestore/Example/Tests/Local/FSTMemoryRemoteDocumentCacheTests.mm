@@ -16,16 +16,26 @@
 
 #include <memory>
 
+#import "Firestore/Source/Local/FSTLocalSerializer.h"
 #import "Firestore/Source/Local/FSTMemoryPersistence.h"
+#import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Remote/FSTSerializerBeta.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "absl/memory/memory.h"
 
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
 #import "Firestore/Example/Tests/Local/FSTRemoteDocumentCacheTests.h"
+#import "Firestore/Example/Tests/Util/FSTHelpers.h"
+
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 
 using firebase::firestore::local::MemoryRemoteDocumentCache;
 using firebase::firestore::local::RemoteDocumentCache;
+using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::DocumentState;
+using firebase::firestore::testutil::Key;
 
 @interface FSTMemoryRemoteDocumentCacheTests : FSTRemoteDocumentCacheTests
 @end
@@ -51,6 +61,31 @@ using firebase::firestore::local::RemoteDocumentCache;
   return _cache.get();
 }
 
+- (void)testKeepsByteSizeUpToDate {
+  auto remoteSerializer = [[FSTSerializerBeta alloc] initWithDatabaseID:DatabaseId("p", "d")];
+  auto serializer = [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
+
+  self.persistence.run("testKeepsByteSizeUpToDate", [&]() {
+    XCTAssertEqual(_cache->CalculateByteSize(serializer), (size_t)0);
+
+    FSTDocument *doc1 = FSTTestDoc("a/1", 1, @{@"a" : @1}, DocumentState::kSynced);
+    _cache->Add(doc1, doc1.version);
+    size_t oneDoc = _cache->CalculateByteSize(serializer);
+    XCTAssertGreaterThan(oneDoc, (size_t)0);
+
+    FSTDocument *doc2 = FSTTestDoc("a/2", 1, @{@"a" : @1}, DocumentState::kSynced);
+    _cache->Add(doc2, doc2.version);
+    XCTAssertEqual(_cache->CalculateByteSize(serializer), 2 * oneDoc);
+
+    FSTDocument *longerDoc2 = FSTTestDoc("a/2", 2, @{@"a" : @"longer"}, DocumentState::kSynced);
+    _cache->Add(longerDoc2, longerDoc2.version);
+    XCTAssertGreaterThan(_cache->CalculateByteSize(serializer), 2 * oneDoc);
+
+    _cache->Remove(Key("a/2"));
+    XCTAssertEqual(_cache->CalculateByteSize(serializer), oneDoc);
+  });
+}
+
 - (void)tearDown {
   _cache.reset();
   self.persistence = nil;
@@ -38,6 +38,7 @@
 namespace testutil = firebase::firestore::testutil;
 using firebase::Timestamp;
 using firebase::firestore::auth::User;
+using firebase::firestore::local::PendingWrites;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::kBatchIdUnknown;
@@ -84,6 +85,29 @@ NS_ASSUME_NONNULL_BEGIN
   });
 }
 
+- (void)testPendingWrites {
+  if ([self isTestBaseClass]) return;
+
+  self.persistence.run("testPendingWrites", [&]() {
+    XCTAssertEqual(self.mutationQueue->GetPendingWrites(), PendingWrites{});
+
+    FSTMutationBatch *batch1 = [self addMutationBatch];
+    PendingWrites afterOne = self.mutationQueue->GetPendingWrites();
+    XCTAssertEqual(afterOne.batch_count, 1);
+
+    FSTMutationBatch *batch2 = [self addMutationBatch];
+    PendingWrites afterTwo = self.mutationQueue->GetPendingWrites();
+    XCTAssertEqual(afterTwo.batch_count, 2);
+    XCTAssertGreaterThanOrEqual(afterTwo.byte_size, afterOne.byte_size);
+
+    self.mutationQueue->RemoveMutationBatch(batch1);
+    XCTAssertEqual(self.mutationQueue->GetPendingWrites().batch_count, 1);
+
+    self.mutationQueue->RemoveMutationBatch(batch2);
+    XCTAssertEqual(self.mutationQueue->GetPendingWrites(), PendingWrites{});
+  });
+}
+
 - (void)testAcknowledgeBatchID {
   if ([self isTestBaseClass]) return;
 
@@ -187,6 +211,41 @@ NS_ASSUME_NONNULL_BEGIN
   });
 }
 
+- (void)testNextMutationBatchesAfterBatchID {
+  if ([self isTestBaseClass]) return;
+
+  self.persistence.run("testNextMutationBatchesAfterBatchID", [&]() {
+    std::vector<FSTMutationBatch *> batches = [self createBatches:10];
+    std::vector<FSTMutationBatch *> removed = [self removeFirstBatches:3 inBatches:&batches];
+
+    std::vector<FSTMutationBatch *> found =
+        self.mutationQueue->NextMutationBatchesAfterBatchId(kBatchIdUnknown, 3, 0);
+    XCTAssertEqual(found.size(), 3);
+    for (size_t i = 0; i < found.size(); i++) {
+      XCTAssertEqual(found[i].batchID, batches[i].batchID);
+    }
+
+    // Starting after a removed batch, and asking for more than there are.
+    found = self.mutationQueue->NextMutationBatchesAfterBatchId(removed[0].batchID, 100, 0);
+    XCTAssertEqual(found.size(), batches.size());
+    for (size_t i = 0; i < found.size(); i++) {
+      XCTAssertEqual(found[i].batchID, batches[i].batchID);
+    }
+
+    found = self.mutationQueue->NextMutationBatchesAfterBatchId(batches[5].batchID, 100, 0);
+    XCTAssertEqual(found.size(), 1);
+    XCTAssertEqual(found[0].batchID, batches[6].batchID);
+
+    // A byte limit stops the read once reached, but always lets one batch through.
+    found = self.mutationQueue->NextMutationBatchesAfterBatchId(kBatchIdUnknown, 100, 1);
+    XCTAssertGreaterThanOrEqual(found.size(), 1);
+    XCTAssertEqual(found[0].batchID, batches[0].batchID);
+
+    XCTAssertTrue(
+        self.mutationQueue->NextMutationBatchesAfterBatchId(batches.back().batchID, 100, 0).empty());
+  });
+}
+
 - (void)testAllMutationBatchesAffectingDocumentKey {
   if ([self isTestBaseClass]) return;
 
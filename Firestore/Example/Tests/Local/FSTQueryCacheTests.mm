@@ -164,6 +164,33 @@ NS_ASSUME_NONNULL_BEGIN
   });
 }
 
+- (void)testGetQueryAfterChangesFollowingLookups {
+  if ([self isTestBaseClass]) return;
+
+  self.persistence.run("testGetQueryAfterChangesFollowingLookups", [&]() {
+    XCTAssertNil(self.queryCache->GetTarget(_queryRooms));
+
+    FSTQueryData *queryData1 = [self queryDataWithQuery:_queryRooms
+                                               targetID:1
+                                   listenSequenceNumber:10
+                                                version:1];
+    self.queryCache->AddTarget(queryData1);
+    XCTAssertEqualObjects(self.queryCache->GetTarget(_queryRooms), queryData1);
+
+    FSTQueryData *queryData2 = [self queryDataWithQuery:_queryRooms
+                                               targetID:1
+                                   listenSequenceNumber:11
+                                                version:2];
+    self.queryCache->UpdateTarget(queryData2);
+    FSTQueryData *result = self.queryCache->GetTarget(_queryRooms);
+    XCTAssertEqualObjects(result.resumeToken, queryData2.resumeToken);
+    XCTAssertEqual(result.sequenceNumber, queryData2.sequenceNumber);
+
+    self.queryCache->RemoveTarget(queryData2);
+    XCTAssertNil(self.queryCache->GetTarget(_queryRooms));
+  });
+}
+
 - (void)testRemoveNonExistentQuery {
   if ([self isTestBaseClass]) return;
 
@@ -17,6 +17,7 @@
 #import "Firestore/Example/Tests/Local/FSTRemoteDocumentCacheTests.h"
 
 #include <memory>
+#include <string>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTPersistence.h"
@@ -29,7 +30,9 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/strings/string_view.h"
 
@@ -41,6 +44,7 @@ using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
 using firebase::firestore::model::DocumentState;
 using firebase::firestore::model::MaybeDocumentMap;
+using firebase::firestore::model::ResourcePath;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -116,6 +120,35 @@ static const int kVersion = 42;
   });
 }
 
+- (void)testSetAndReadManyDocumentsWithGaps {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testSetAndReadManyDocumentsWithGaps", [=]() {
+    NSMutableArray<FSTDocument *> *written = [NSMutableArray array];
+    DocumentKeySet keys;
+    for (int i = 0; i < 100; ++i) {
+      std::string path = util::StringFormat("a/%s", i);
+      keys = keys.insert(testutil::Key(path));
+      // Skip some documents and add unrequested ones in between so that the
+      // read has to both step over and seek past rows.
+      if (i % 7 == 0) continue;
+      [written addObject:[self setTestDocumentAtPath:path]];
+      if (i % 5 == 0) {
+        [self setTestDocumentAtPath:util::StringFormat("%s/sub/x", path)];
+      }
+    }
+
+    MaybeDocumentMap read = self.remoteDocumentCache->GetAll(keys);
+    XCTAssertEqual(read.size(), keys.size());
+    [self expectMap:read hasDocsInArray:written exactly:NO];
+    for (int i = 0; i < 100; i += 7) {
+      auto found = read.find(testutil::Key(util::StringFormat("a/%s", i)));
+      XCTAssertTrue(found != read.end());
+      XCTAssertNil(found->second);
+    }
+  });
+}
+
 - (void)testSetAndReadADocumentAtDeepPath {
   if (!self.remoteDocumentCache) return;
 
@@ -127,7 +160,7 @@ static const int kVersion = 42;
 
   self.persistence.run("testSetAndReadDeletedDocument", [&]() {
     FSTDeletedDocument *deletedDoc = FSTTestDeletedDoc(kDocPath, kVersion, NO);
-    self.remoteDocumentCache->Add(deletedDoc);
+    self.remoteDocumentCache->Add(deletedDoc, deletedDoc.version);
 
     XCTAssertEqualObjects(self.remoteDocumentCache->Get(testutil::Key(kDocPath)), deletedDoc);
   });
@@ -139,7 +172,7 @@ static const int kVersion = 42;
   self.persistence.run("testSetDocumentToNewValue", [&]() {
     [self setTestDocumentAtPath:kDocPath];
     FSTDocument *newDoc = FSTTestDoc(kDocPath, kVersion, @{@"data" : @2}, DocumentState::kSynced);
-    self.remoteDocumentCache->Add(newDoc);
+    self.remoteDocumentCache->Add(newDoc, newDoc.version);
     XCTAssertEqualObjects(self.remoteDocumentCache->Get(testutil::Key(kDocPath)), newDoc);
   });
 }
@@ -188,10 +221,101 @@ static const int kVersion = 42;
   });
 }
 
+- (void)testDocumentsMatchingQuerySkipsSubcollections {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testDocumentsMatchingQuerySkipsSubcollections", [&]() {
+    [self setTestDocumentAtPath:"b/0/z/1"];
+    [self setTestDocumentAtPath:"b/1"];
+    [self setTestDocumentAtPath:"b/1/y/1"];
+    [self setTestDocumentAtPath:"b/1/z/1/x/1"];
+    [self setTestDocumentAtPath:"b/1/z/2"];
+    [self setTestDocumentAtPath:"b/10"];
+    [self setTestDocumentAtPath:"b/2/z/1"];
+    [self setTestDocumentAtPath:"b/3"];
+    [self setTestDocumentAtPath:"c/1"];
+
+    FSTQuery *query = FSTTestQuery("b");
+    DocumentMap results = self.remoteDocumentCache->GetMatching(query);
+    [self expectMap:results.underlying_map()
+        hasDocsInArray:@[
+          FSTTestDoc("b/1", kVersion, _kDocData, DocumentState::kSynced),
+          FSTTestDoc("b/10", kVersion, _kDocData, DocumentState::kSynced),
+          FSTTestDoc("b/3", kVersion, _kDocData, DocumentState::kSynced)
+        ]
+               exactly:YES];
+  });
+}
+
+- (void)testDocumentsMatchingCollectionGroupQuery {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testDocumentsMatchingCollectionGroupQuery", [&]() {
+    [self setTestDocumentAtPath:"a/1/messages/1"];
+    [self setTestDocumentAtPath:"a/1/messages/1/other/1"];
+    [self setTestDocumentAtPath:"b/2/messages/3"];
+    [self setTestDocumentAtPath:"messages/2"];
+    [self setTestDocumentAtPath:"messages/2/messages/4"];
+    [self setTestDocumentAtPath:"messages/5"];
+    [self setTestDocumentAtPath:"messagesx/1"];
+    self.remoteDocumentCache->Add(FSTTestDeletedDoc("messages/6", kVersion, NO),
+                                  testutil::Version(kVersion));
+    self.remoteDocumentCache->Remove(testutil::Key("messages/5"));
+
+    FSTQuery *query = [FSTQuery queryWithPath:ResourcePath::Empty()
+                              collectionGroup:std::make_shared<const std::string>("messages")];
+    DocumentMap results = self.remoteDocumentCache->GetMatching(query);
+    [self expectMap:results.underlying_map()
+        hasDocsInArray:@[
+          FSTTestDoc("a/1/messages/1", kVersion, _kDocData, DocumentState::kSynced),
+          FSTTestDoc("b/2/messages/3", kVersion, _kDocData, DocumentState::kSynced),
+          FSTTestDoc("messages/2", kVersion, _kDocData, DocumentState::kSynced),
+          FSTTestDoc("messages/2/messages/4", kVersion, _kDocData, DocumentState::kSynced)
+        ]
+               exactly:YES];
+  });
+}
+
+- (void)testFirstDocumentsMatchingQuery {
+  if (!self.remoteDocumentCache) return;
+
+  self.persistence.run("testFirstDocumentsMatchingQuery", [&]() {
+    [self setTestDocumentAtPath:"b/1"];
+    [self setTestDocumentAtPath:"b/1/z/1"];
+    [self setTestDocumentAtPath:"b/2"];
+    [self setTestDocumentAtPath:"b/3"];
+    [self setTestDocumentAtPath:"c/1"];
+
+    FSTQuery *query = FSTTestQuery("b");
+    DocumentMap results = self.remoteDocumentCache->GetFirstMatching(query, absl::nullopt, 2);
+    [self expectMap:results.underlying_map()
+        hasDocsInArray:@[
+          FSTTestDoc("b/1", kVersion, _kDocData, DocumentState::kSynced),
+          FSTTestDoc("b/2", kVersion, _kDocData, DocumentState::kSynced)
+        ]
+               exactly:YES];
+
+    results = self.remoteDocumentCache->GetFirstMatching(query, absl::nullopt, 10);
+    XCTAssertEqual(results.size(), 3u);
+
+    // Starting after a document skips its subcollections too.
+    results = self.remoteDocumentCache->GetFirstMatching(query, testutil::Key("b/1"), 10);
+    [self expectMap:results.underlying_map()
+        hasDocsInArray:@[
+          FSTTestDoc("b/2", kVersion, _kDocData, DocumentState::kSynced),
+          FSTTestDoc("b/3", kVersion, _kDocData, DocumentState::kSynced)
+        ]
+               exactly:YES];
+
+    results = self.remoteDocumentCache->GetFirstMatching(query, testutil::Key("b/3"), 10);
+    XCTAssertEqual(results.size(), 0u);
+  });
+}
+
 #pragma mark - Helpers
 - (FSTDocument *)setTestDocumentAtPath:(const absl::string_view)path {
   FSTDocument *doc = FSTTestDoc(path, kVersion, _kDocData, DocumentState::kSynced);
-  self.remoteDocumentCache->Add(doc);
+  self.remoteDocumentCache->Add(doc, doc.version);
   return doc;
 }
 
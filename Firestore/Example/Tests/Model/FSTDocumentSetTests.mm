@@ -116,6 +116,30 @@ NS_ASSUME_NONNULL_BEGIN
   XC_ASSERT_THAT(set, ElementsAre(_doc3, _doc1, doc2Prime));
 }
 
+- (void)testEditorAppliesChangesWithoutAffectingOriginal {
+  DocumentSet set = FSTTestDocSet(*_comp, @[ _doc1, _doc2 ]);
+
+  FSTDocument *doc2Prime = FSTTestDoc("docs/2", 0, @{@"sort" : @0}, DocumentState::kSynced);
+
+  DocumentSet::Editor editor{set};
+  editor.insert(_doc3);
+  editor.insert(doc2Prime);
+  editor.erase(_doc1.key);
+  editor.erase(_doc1.key);
+  XC_ASSERT_THAT(editor.set(), ElementsAre(doc2Prime, _doc3));
+
+  DocumentSet edited = editor.Build();
+  editor.erase(_doc3.key);
+  XC_ASSERT_THAT(editor.set(), ElementsAre(doc2Prime));
+
+  XCTAssertEqual(edited.size(), 2);
+  XCTAssertEqualObjects(edited.GetDocument(doc2Prime.key), doc2Prime);
+  XC_ASSERT_THAT(edited, ElementsAre(doc2Prime, _doc3));
+
+  // Original remains unchanged
+  XC_ASSERT_THAT(set, ElementsAre(_doc1, _doc2));
+}
+
 - (void)testAddsDocsWithEqualComparisonValues {
   FSTDocument *doc4 = FSTTestDoc("docs/4", 0, @{@"sort" : @2}, DocumentState::kSynced);
 
@@ -20,16 +20,19 @@
 #import <FirebaseFirestore/FIRTimestamp.h>
 #import <XCTest/XCTest.h>
 
+#include <algorithm>
 #include <vector>
 
 #import "Firestore/Source/API/FIRFieldValue+Internal.h"
 #import "Firestore/Source/API/converters.h"
 #import "Firestore/Source/Model/FSTDocument.h"
+#import "Firestore/Source/Model/FSTMutationBatch.h"
 
 #import "Firestore/Example/Tests/Util/FSTHelpers.h"
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/field_transform.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
@@ -47,6 +50,7 @@ using firebase::firestore::model::FieldMask;
 using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::FieldTransform;
 using firebase::firestore::model::FieldValue;
+using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::ObjectValue;
 using firebase::firestore::model::Precondition;
 using firebase::firestore::model::TransformOperation;
@@ -144,6 +148,67 @@ static std::vector<FieldValue> FieldValueVector(Args... values) {
   XCTAssertEqualObjects(patchedDoc, baseDoc);
 }
 
+- (void)testCombinesSetWithLaterPatch {
+  FSTMutation *set = FSTTestSetMutation(@"collection/key", @{@"foo" : @"foo-value", @"n" : @1});
+  FSTMutation *patch = FSTTestPatchMutation("collection/key", @{@"n" : @2, @"bar.baz" : @3}, {});
+
+  FSTMutation *combined = [set mutationByCombiningWith:patch];
+  XCTAssertEqualObjects(combined, FSTTestSetMutation(@"collection/key", @{
+                          @"foo" : @"foo-value",
+                          @"n" : @2,
+                          @"bar" : @{@"baz" : @3}
+                        }));
+}
+
+- (void)testCombinesPatches {
+  NSDictionary *docData = @{@"foo" : @{@"bar" : @"bar-value", @"baz" : @"baz-value"}, @"n" : @0};
+  FSTDocument *baseDoc = FSTTestDoc("collection/key", 0, docData, DocumentState::kSynced);
+
+  FSTMutation *first = FSTTestPatchMutation("collection/key", @{@"foo.bar" : @1, @"n" : @1}, {});
+  FSTMutation *second = FSTTestPatchMutation("collection/key", @{@"n" : @2},
+                                             {Field("n"), Field("foo.baz")});
+  FSTMutation *combined = [first mutationByCombiningWith:second];
+  XCTAssertNotNil(combined);
+  XCTAssertEqual(combined.precondition, Precondition::Exists(true));
+
+  FSTMaybeDocument *expected = [second
+      applyToLocalDocument:[first applyToLocalDocument:baseDoc
+                                          baseDocument:baseDoc
+                                        localWriteTime:_timestamp]
+              baseDocument:baseDoc
+            localWriteTime:_timestamp];
+  FSTMaybeDocument *actual = [combined applyToLocalDocument:baseDoc
+                                               baseDocument:baseDoc
+                                             localWriteTime:_timestamp];
+  XCTAssertEqualObjects(actual, expected);
+  NSDictionary *expectedData = @{@"foo" : @{@"bar" : @1}, @"n" : @2};
+  XCTAssertEqualObjects(
+      actual, FSTTestDoc("collection/key", 0, expectedData, DocumentState::kLocalMutations));
+}
+
+- (void)testCombinesWithLaterSetOrDelete {
+  FSTMutation *set = FSTTestSetMutation(@"collection/key", @{@"foo" : @"foo-value"});
+  FSTMutation *patch = FSTTestPatchMutation("collection/key", @{@"foo" : @"bar"}, {});
+  FSTMutation *deleteMutation = FSTTestDeleteMutation(@"collection/key");
+
+  XCTAssertEqualObjects([set mutationByCombiningWith:deleteMutation], deleteMutation);
+  XCTAssertEqualObjects([deleteMutation mutationByCombiningWith:set], set);
+
+  // The patch fails if the document doesn't exist, so it can't be dropped.
+  XCTAssertNil([patch mutationByCombiningWith:set]);
+  XCTAssertNil([patch mutationByCombiningWith:deleteMutation]);
+  XCTAssertNil([deleteMutation mutationByCombiningWith:patch]);
+}
+
+- (void)testDoesNotCombineTransforms {
+  FSTMutation *set = FSTTestSetMutation(@"collection/key", @{@"foo" : @"foo-value"});
+  FSTMutation *transform = FSTTestTransformMutation(
+      @"collection/key", @{@"foo" : [FIRFieldValue fieldValueForServerTimestamp]});
+
+  XCTAssertNil([set mutationByCombiningWith:transform]);
+  XCTAssertNil([transform mutationByCombiningWith:set]);
+}
+
 - (void)testAppliesLocalServerTimestampTransformToDocuments {
   NSDictionary *docData = @{@"foo" : @{@"bar" : @"bar-value"}, @"baz" : @"baz-value"};
   FSTDocument *baseDoc = FSTTestDoc("collection/key", 0, docData, DocumentState::kSynced);
@@ -400,6 +465,14 @@ static std::vector<FieldValue> FieldValueVector(Args... values) {
   [self transformBaseDoc:baseDoc applyTransform:transform expecting:expected];
 }
 
+- (void)testAppliesLocalArrayRemoveTransformWithDuplicateElements {
+  // Each removed element takes out the first of its occurrences that's left.
+  auto baseDoc = @{@"array" : @[ @1, @2, @1, @3, @1 ]};
+  auto transform = @{@"array" : [FIRFieldValue fieldValueForArrayRemove:@[ @1, @3, @1 ]]};
+  auto expected = @{@"array" : @[ @2, @1 ]};
+  [self transformBaseDoc:baseDoc applyTransform:transform expecting:expected];
+}
+
 // Helper to test a particular transform scenario.
 - (void)transformBaseDoc:(NSDictionary<NSString *, id> *)baseData
          applyTransforms:(NSArray<NSDictionary<NSString *, id> *> *)transforms
@@ -643,4 +716,38 @@ static std::vector<FieldValue> FieldValueVector(Args... values) {
 
 #undef ASSERT_TRANSITION
 
+- (void)testAppliesBatchToDocumentSet {
+  FSTDocument *docA = FSTTestDoc("collection/a", 1, @{@"a" : @1}, DocumentState::kSynced);
+  FSTDocument *docC = FSTTestDoc("collection/c", 1, @{@"c" : @1}, DocumentState::kSynced);
+  FSTDocument *docD = FSTTestDoc("collection/d", 1, @{@"d" : @1}, DocumentState::kSynced);
+  MaybeDocumentMap docs;
+  docs = docs.insert(docA.key, docA).insert(docC.key, docC).insert(docD.key, docD);
+
+  FSTMutationBatch *batch = [[FSTMutationBatch alloc]
+      initWithBatchID:1
+       localWriteTime:_timestamp
+        baseMutations:{}
+            mutations:{FSTTestPatchMutation("collection/d", @{@"e" : @2}, {}),
+                       FSTTestSetMutation(@"collection/b", @{@"b" : @2}),
+                       FSTTestPatchMutation("collection/e", @{@"e" : @2}, {}),
+                       FSTTestPatchMutation("collection/d", @{@"f" : @3}, {})}];
+  XCTAssertTrue([batch hasMutationsForKey:Key("collection/d")]);
+  XCTAssertFalse([batch hasMutationsForKey:Key("collection/c")]);
+
+  MaybeDocumentMap result = [batch applyToLocalDocumentSet:docs];
+
+  std::vector<FSTMaybeDocument *> expected = {
+      docA, FSTTestDoc("collection/b", 0, @{@"b" : @2}, DocumentState::kLocalMutations), docC,
+      FSTTestDoc("collection/d", 1, @{@"d" : @1, @"e" : @2, @"f" : @3},
+                 DocumentState::kLocalMutations)};
+  std::vector<FSTMaybeDocument *> actual;
+  for (const auto &kv : result) {
+    actual.push_back(kv.second);
+  }
+  XCTAssertEqual(actual.size(), expected.size());
+  for (size_t i = 0; i < std::min(actual.size(), expected.size()); i++) {
+    XCTAssertEqualObjects(actual[i], expected[i]);
+  }
+}
+
 @end
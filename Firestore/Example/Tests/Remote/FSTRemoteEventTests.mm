@@ -35,6 +35,7 @@
 
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 
 namespace testutil = firebase::firestore::testutil;
 using firebase::firestore::model::DocumentKey;
@@ -42,6 +43,7 @@ using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentState;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::remote::BloomFilter;
 using firebase::firestore::remote::DocumentWatchChange;
 using firebase::firestore::remote::ExistenceFilter;
 using firebase::firestore::remote::ExistenceFilterWatchChange;
@@ -560,6 +562,36 @@ std::unique_ptr<WatchTargetChange> MakeTargetChange(WatchTargetChangeState state
   XCTAssertEqual(event.document_updates().size(), 0);
 }
 
+- (void)testExistenceFilterMismatchWithBloomFilterRemovesMissingDocuments {
+  std::unordered_map<TargetId, FSTQueryData *> targetMap{[self queryDataForTargets:{1}]};
+
+  FSTDocument *doc1 = FSTTestDoc("docs/1", 1, @{@"value" : @1}, DocumentState::kSynced);
+  FSTDocument *doc2 = FSTTestDoc("docs/2", 2, @{@"value" : @2}, DocumentState::kSynced);
+
+  WatchChangeAggregator aggregator =
+      [self aggregatorWithTargetMap:targetMap
+               outstandingResponses:_noOutstandingResponses
+                       existingKeys:DocumentKeySet{doc1.key, doc2.key}
+                            changes:{}];
+
+  // A filter with 16 bits and 3 hashes that only holds "docs/1".
+  BloomFilter unchangedNames{{0x1C, 0x00}, 0, 3};
+  ExistenceFilterWatchChange existenceFilter{ExistenceFilter{1, unchangedNames}, 1};
+  aggregator.HandleExistenceFilter(existenceFilter);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  // Removing the document missing from the Bloom filter accounts for the mismatch, so the target
+  // doesn't need to be reset.
+  XCTAssertEqual(event.target_mismatches().size(), 0);
+  XCTAssertEqual(event.document_updates().size(), 0);
+  XCTAssertEqual(event.target_changes().size(), 1);
+
+  TargetChange targetChange1{
+      [NSData data], false, DocumentKeySet{}, DocumentKeySet{}, DocumentKeySet{doc2.key}};
+  XCTAssertTrue(event.target_changes().at(1) == targetChange1);
+}
+
 - (void)testExistenceFilterMismatchRemovesCurrentChanges {
   std::unordered_map<TargetId, FSTQueryData *> targetMap{[self queryDataForTargets:{1}]};
 
@@ -821,6 +853,40 @@ std::unique_ptr<WatchTargetChange> MakeTargetChange(WatchTargetChangeState state
   XCTAssertFalse(limboDocChanges.contains(doc3.key));
 }
 
+- (void)testPerformanceOfLargeInitialSync {
+  const size_t documentCount = 50000;
+  std::unordered_map<TargetId, FSTQueryData *> targetMap = [self queryDataForTargets:{1, 2}];
+
+  // Every document matches target 1, and every tenth also matches target 2.
+  std::vector<DocumentWatchChange> docChanges;
+  docChanges.reserve(documentCount);
+  for (size_t i = 0; i < documentCount; ++i) {
+    FSTDocument *doc = FSTTestDoc(absl::StrCat("coll/doc", i), 1, @{@"value" : @(i)},
+                                  DocumentState::kSynced);
+    std::vector<TargetId> targets = i % 10 == 0 ? std::vector<TargetId>{1, 2}
+                                                : std::vector<TargetId>{1};
+    docChanges.emplace_back(std::move(targets), std::vector<TargetId>{}, doc.key, doc);
+  }
+  const std::vector<DocumentWatchChange> *changes = &docChanges;
+
+  [self measureBlock:^{
+    WatchChangeAggregator aggregator = [self aggregatorWithTargetMap:targetMap
+                                                outstandingResponses:self->_noOutstandingResponses
+                                                        existingKeys:DocumentKeySet{}
+                                                             changes:Changes()];
+    for (const DocumentWatchChange &change : *changes) {
+      aggregator.HandleDocumentChange(change);
+    }
+    aggregator.HandleTargetChange(
+        WatchTargetChange{WatchTargetChangeState::Current, {1, 2}, self->_resumeToken1});
+
+    RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(3));
+    XCTAssertEqual(event.document_updates().size(), documentCount);
+    XCTAssertEqual(event.target_changes().at(1).added_documents().size(), documentCount);
+    XCTAssertEqual(event.target_changes().at(2).added_documents().size(), documentCount / 10);
+  }];
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
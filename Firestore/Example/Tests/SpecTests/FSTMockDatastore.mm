@@ -20,6 +20,7 @@
 #include <memory>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
@@ -110,6 +111,12 @@ class MockWatchStream : public WatchStream {
     active_targets_[query.targetID] = sentQueryData;
   }
 
+  void WatchQueries(const std::vector<FSTQueryData*>& queries) override {
+    for (FSTQueryData* query : queries) {
+      WatchQuery(query);
+    }
+  }
+
   void UnwatchTargetId(model::TargetId target_id) override {
     LOG_DEBUG("UnwatchTargetId: %s", target_id);
     active_targets_.erase(target_id);
@@ -192,7 +192,8 @@ NS_ASSUME_NONNULL_BEGIN
                                                 remoteStore:_remoteStore.get()
                                                 initialUser:initialUser];
     _remoteStore->set_sync_engine(_syncEngine);
-    _eventManager = [FSTEventManager eventManagerWithSyncEngine:_syncEngine];
+    _eventManager = [FSTEventManager eventManagerWithSyncEngine:_syncEngine
+                                                    workerQueue:_workerQueue];
 
     // Set up internal event tracking for the spec tests.
     NSMutableArray<FSTQueryEvent *> *events = [NSMutableArray array];
@@ -29,9 +29,11 @@ namespace firestore {
 
 
 
-const pb_field_t firestore_client_MutationQueue_fields[3] = {
+const pb_field_t firestore_client_MutationQueue_fields[5] = {
     PB_FIELD(  1, INT32   , SINGULAR, STATIC  , FIRST, firestore_client_MutationQueue, last_acknowledged_batch_id, last_acknowledged_batch_id, 0),
     PB_FIELD(  2, BYTES   , SINGULAR, POINTER , OTHER, firestore_client_MutationQueue, last_stream_token, last_acknowledged_batch_id, 0),
+    PB_FIELD(  3, INT64   , SINGULAR, STATIC  , OTHER, firestore_client_MutationQueue, pending_batch_count, last_stream_token, 0),
+    PB_FIELD(  4, INT64   , SINGULAR, STATIC  , OTHER, firestore_client_MutationQueue, pending_bytes, pending_batch_count, 0),
     PB_LAST_FIELD
 };
 
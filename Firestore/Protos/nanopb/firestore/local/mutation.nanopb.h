@@ -38,6 +38,8 @@ namespace firestore {
 typedef struct _firestore_client_MutationQueue {
     int32_t last_acknowledged_batch_id;
     pb_bytes_array_t *last_stream_token;
+    int64_t pending_batch_count;
+    int64_t pending_bytes;
 /* @@protoc_insertion_point(struct:firestore_client_MutationQueue) */
 } firestore_client_MutationQueue;
 
@@ -54,21 +56,23 @@ typedef struct _firestore_client_WriteBatch {
 /* Default values for struct fields */
 
 /* Initializer values for message structs */
-#define firestore_client_MutationQueue_init_default {0, NULL}
+#define firestore_client_MutationQueue_init_default {0, NULL, 0, 0}
 #define firestore_client_WriteBatch_init_default {0, 0, NULL, google_protobuf_Timestamp_init_default, 0, NULL}
-#define firestore_client_MutationQueue_init_zero {0, NULL}
+#define firestore_client_MutationQueue_init_zero {0, NULL, 0, 0}
 #define firestore_client_WriteBatch_init_zero    {0, 0, NULL, google_protobuf_Timestamp_init_zero, 0, NULL}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define firestore_client_MutationQueue_last_acknowledged_batch_id_tag 1
 #define firestore_client_MutationQueue_last_stream_token_tag 2
+#define firestore_client_MutationQueue_pending_batch_count_tag 3
+#define firestore_client_MutationQueue_pending_bytes_tag 4
 #define firestore_client_WriteBatch_batch_id_tag 1
 #define firestore_client_WriteBatch_writes_tag   2
 #define firestore_client_WriteBatch_local_write_time_tag 3
 #define firestore_client_WriteBatch_base_writes_tag 4
 
 /* Struct field encoding specification for nanopb */
-extern const pb_field_t firestore_client_MutationQueue_fields[3];
+extern const pb_field_t firestore_client_MutationQueue_fields[5];
 extern const pb_field_t firestore_client_WriteBatch_fields[5];
 
 /* Maximum encoded size of messages (where known) */
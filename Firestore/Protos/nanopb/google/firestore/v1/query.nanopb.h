@@ -61,11 +61,13 @@ typedef enum _google_firestore_v1_StructuredQuery_FieldFilter_Operator {
     google_firestore_v1_StructuredQuery_FieldFilter_Operator_GREATER_THAN = 3,
     google_firestore_v1_StructuredQuery_FieldFilter_Operator_GREATER_THAN_OR_EQUAL = 4,
     google_firestore_v1_StructuredQuery_FieldFilter_Operator_EQUAL = 5,
-    google_firestore_v1_StructuredQuery_FieldFilter_Operator_ARRAY_CONTAINS = 7
+    google_firestore_v1_StructuredQuery_FieldFilter_Operator_ARRAY_CONTAINS = 7,
+    google_firestore_v1_StructuredQuery_FieldFilter_Operator_IN = 8,
+    google_firestore_v1_StructuredQuery_FieldFilter_Operator_ARRAY_CONTAINS_ANY = 9
 } google_firestore_v1_StructuredQuery_FieldFilter_Operator;
 #define _google_firestore_v1_StructuredQuery_FieldFilter_Operator_MIN google_firestore_v1_StructuredQuery_FieldFilter_Operator_OPERATOR_UNSPECIFIED
-#define _google_firestore_v1_StructuredQuery_FieldFilter_Operator_MAX google_firestore_v1_StructuredQuery_FieldFilter_Operator_ARRAY_CONTAINS
-#define _google_firestore_v1_StructuredQuery_FieldFilter_Operator_ARRAYSIZE ((google_firestore_v1_StructuredQuery_FieldFilter_Operator)(google_firestore_v1_StructuredQuery_FieldFilter_Operator_ARRAY_CONTAINS+1))
+#define _google_firestore_v1_StructuredQuery_FieldFilter_Operator_MAX google_firestore_v1_StructuredQuery_FieldFilter_Operator_ARRAY_CONTAINS_ANY
+#define _google_firestore_v1_StructuredQuery_FieldFilter_Operator_ARRAYSIZE ((google_firestore_v1_StructuredQuery_FieldFilter_Operator)(google_firestore_v1_StructuredQuery_FieldFilter_Operator_ARRAY_CONTAINS_ANY+1))
 
 typedef enum _google_firestore_v1_StructuredQuery_UnaryFilter_Operator {
     google_firestore_v1_StructuredQuery_UnaryFilter_Operator_OPERATOR_UNSPECIFIED = 0,
@@ -68,6 +68,8 @@ NS_ASSUME_NONNULL_BEGIN
 typedef GPB_ENUM(FSTPBMutationQueue_FieldNumber) {
   FSTPBMutationQueue_FieldNumber_LastAcknowledgedBatchId = 1,
   FSTPBMutationQueue_FieldNumber_LastStreamToken = 2,
+  FSTPBMutationQueue_FieldNumber_PendingBatchCount = 3,
+  FSTPBMutationQueue_FieldNumber_PendingBytes = 4,
 };
 
 /**
@@ -94,6 +96,15 @@ typedef GPB_ENUM(FSTPBMutationQueue_FieldNumber) {
  **/
 @property(nonatomic, readwrite, copy, null_resettable) NSData *lastStreamToken;
 
+/**
+ * The number of WriteBatches in this queue, kept up to date as batches are
+ * added and removed so that the backlog can be checked without reading them.
+ **/
+@property(nonatomic, readwrite) int64_t pendingBatchCount;
+
+/** The total size in bytes of the encoded WriteBatches in this queue. */
+@property(nonatomic, readwrite) int64_t pendingBytes;
+
 @end
 
 #pragma mark - FSTPBWriteBatch
@@ -71,11 +71,15 @@ static GPBFileDescriptor *FSTPBMutationRoot_FileDescriptor(void) {
 
 @dynamic lastAcknowledgedBatchId;
 @dynamic lastStreamToken;
+@dynamic pendingBatchCount;
+@dynamic pendingBytes;
 
 typedef struct FSTPBMutationQueue__storage_ {
   uint32_t _has_storage_[1];
   int32_t lastAcknowledgedBatchId;
   NSData *lastStreamToken;
+  int64_t pendingBatchCount;
+  int64_t pendingBytes;
 } FSTPBMutationQueue__storage_;
 
 // This method is threadsafe because it is initially called
@@ -102,6 +106,24 @@ typedef struct FSTPBMutationQueue__storage_ {
         .flags = GPBFieldOptional,
         .dataType = GPBDataTypeBytes,
       },
+      {
+        .name = "pendingBatchCount",
+        .dataTypeSpecific.className = NULL,
+        .number = FSTPBMutationQueue_FieldNumber_PendingBatchCount,
+        .hasIndex = 2,
+        .offset = (uint32_t)offsetof(FSTPBMutationQueue__storage_, pendingBatchCount),
+        .flags = GPBFieldOptional,
+        .dataType = GPBDataTypeInt64,
+      },
+      {
+        .name = "pendingBytes",
+        .dataTypeSpecific.className = NULL,
+        .number = FSTPBMutationQueue_FieldNumber_PendingBytes,
+        .hasIndex = 3,
+        .offset = (uint32_t)offsetof(FSTPBMutationQueue__storage_, pendingBytes),
+        .flags = GPBFieldOptional,
+        .dataType = GPBDataTypeInt64,
+      },
     };
     GPBDescriptor *localDescriptor =
         [GPBDescriptor allocDescriptorForClass:[FSTPBMutationQueue class]
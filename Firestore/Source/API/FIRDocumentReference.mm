@@ -156,6 +156,17 @@ NS_ASSUME_NONNULL_BEGIN
           merge:(BOOL)merge
      completion:(nullable void (^)(NSError *_Nullable error))completion {
   auto dataConverter = self.firestore.dataConverter;
+  if ([self defersUserDataParsing]) {
+    NSDictionary<NSString *, id> *data = [documentData copy];
+    _documentReference.SetData(
+        [dataConverter, data, merge] {
+          return merge ? [dataConverter parsedMergeData:data fieldMask:nil]
+                       : [dataConverter parsedSetData:data];
+        },
+        util::MakeCallback(completion));
+    return;
+  }
+
   ParsedSetData parsed = merge ? [dataConverter parsedMergeData:documentData fieldMask:nil]
                                : [dataConverter parsedSetData:documentData];
   _documentReference.SetData(std::move(parsed), util::MakeCallback(completion));
@@ -164,6 +175,18 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)setData:(NSDictionary<NSString *, id> *)documentData
     mergeFields:(NSArray<id> *)mergeFields
      completion:(nullable void (^)(NSError *_Nullable error))completion {
+  if ([self defersUserDataParsing]) {
+    auto dataConverter = self.firestore.dataConverter;
+    NSDictionary<NSString *, id> *data = [documentData copy];
+    NSArray<id> *fields = [mergeFields copy];
+    _documentReference.SetData(
+        [dataConverter, data, fields] {
+          return [dataConverter parsedMergeData:data fieldMask:fields];
+        },
+        util::MakeCallback(completion));
+    return;
+  }
+
   ParsedSetData parsed = [self.firestore.dataConverter parsedMergeData:documentData
                                                              fieldMask:mergeFields];
   _documentReference.SetData(std::move(parsed), util::MakeCallback(completion));
@@ -175,10 +198,27 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)updateData:(NSDictionary<id, id> *)fields
         completion:(nullable void (^)(NSError *_Nullable error))completion {
+  if ([self defersUserDataParsing]) {
+    auto dataConverter = self.firestore.dataConverter;
+    NSDictionary<id, id> *data = [fields copy];
+    _documentReference.UpdateData(
+        [dataConverter, data] { return [dataConverter parsedUpdateData:data]; },
+        util::MakeCallback(completion));
+    return;
+  }
+
   ParsedUpdateData parsed = [self.firestore.dataConverter parsedUpdateData:fields];
   _documentReference.UpdateData(std::move(parsed), util::MakeCallback(completion));
 }
 
+/**
+ * Whether writes parse their data on the worker queue. Only the top-level collection of the data
+ * is copied, so that parsing stays off the calling thread.
+ */
+- (BOOL)defersUserDataParsing {
+  return self.firestore.wrapped->settings().deferred_user_data_parsing_enabled();
+}
+
 - (void)deleteDocument {
   [self deleteDocumentWithCompletion:nil];
 }
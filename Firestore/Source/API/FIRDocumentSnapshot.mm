@@ -36,6 +36,8 @@
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value_options.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
@@ -54,6 +56,8 @@ using firebase::firestore::api::SnapshotMetadata;
 using firebase::firestore::api::ThrowInvalidArgument;
 using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::FieldPath;
+using firebase::firestore::model::FieldPathCache;
 using firebase::firestore::model::FieldValue;
 using firebase::firestore::model::FieldValueOptions;
 using firebase::firestore::model::ObjectValue;
@@ -82,6 +86,35 @@ ServerTimestampBehavior InternalServerTimestampBehavior(FIRServerTimestampBehavi
 
 }  // namespace
 
+@interface FIRDocumentSnapshot ()
+
+/**
+ * Returns the model value of the given field, which can be an NSString or a FIRFieldPath, or
+ * nullopt if the document or the field doesn't exist.
+ */
+- (absl::optional<FieldValue>)internalValueForField:(id)field;
+
+- (FieldValueOptions)optionsForServerTimestampBehavior:
+    (FIRServerTimestampBehavior)serverTimestampBehavior;
+
+- (id)convertedValue:(FieldValue)value options:(const FieldValueOptions &)options;
+
+@end
+
+/**
+ * The data of a document, as returned by `-[FIRDocumentSnapshot data]`. Rather than converting the
+ * whole document up front, each top-level field is converted to its Objective-C equivalent the
+ * first time it is read, so that callers that only look at a few fields of a large document don't
+ * pay for the rest.
+ */
+@interface FSTDocumentDataDictionary : NSDictionary<NSString *, id>
+
+- (instancetype)initWithSnapshot:(FIRDocumentSnapshot *)snapshot
+                            data:(ObjectValue)data
+         serverTimestampBehavior:(FIRServerTimestampBehavior)serverTimestampBehavior;
+
+@end
+
 @implementation FIRDocumentSnapshot {
   DocumentSnapshot _snapshot;
 
@@ -160,11 +193,12 @@ ServerTimestampBehavior InternalServerTimestampBehavior(FIRServerTimestampBehavi
 
 - (nullable NSDictionary<NSString *, id> *)dataWithServerTimestampBehavior:
     (FIRServerTimestampBehavior)serverTimestampBehavior {
-  FieldValueOptions options = [self optionsForServerTimestampBehavior:serverTimestampBehavior];
   absl::optional<ObjectValue> data = _snapshot.GetData();
   if (!data) return nil;
 
-  return [self convertedObject:data->GetInternalValue() options:options];
+  return [[FSTDocumentDataDictionary alloc] initWithSnapshot:self
+                                                        data:std::move(*data)
+                                     serverTimestampBehavior:serverTimestampBehavior];
 }
 
 - (nullable id)valueForField:(id)field {
@@ -173,16 +207,7 @@ ServerTimestampBehavior InternalServerTimestampBehavior(FIRServerTimestampBehavi
 
 - (nullable id)valueForField:(id)field
      serverTimestampBehavior:(FIRServerTimestampBehavior)serverTimestampBehavior {
-  FIRFieldPath *fieldPath;
-  if ([field isKindOfClass:[NSString class]]) {
-    fieldPath = [FIRFieldPath pathWithDotSeparatedString:field];
-  } else if ([field isKindOfClass:[FIRFieldPath class]]) {
-    fieldPath = field;
-  } else {
-    ThrowInvalidArgument("Subscript key must be an NSString or FIRFieldPath.");
-  }
-
-  absl::optional<FieldValue> fieldValue = _snapshot.GetValue(fieldPath.internalValue);
+  absl::optional<FieldValue> fieldValue = [self internalValueForField:field];
   FieldValueOptions options = [self optionsForServerTimestampBehavior:serverTimestampBehavior];
   return !fieldValue ? nil : [self convertedValue:*fieldValue options:options];
 }
@@ -191,6 +216,83 @@ ServerTimestampBehavior InternalServerTimestampBehavior(FIRServerTimestampBehavi
   return [self valueForField:key];
 }
 
+- (int64_t)int64ForField:(id)field {
+  absl::optional<FieldValue> fieldValue = [self internalValueForField:field];
+  if (!fieldValue || fieldValue->type() != FieldValue::Type::Integer) {
+    return 0;
+  }
+  return fieldValue->integer_value();
+}
+
+- (double)doubleForField:(id)field {
+  absl::optional<FieldValue> fieldValue = [self internalValueForField:field];
+  if (!fieldValue) {
+    return 0;
+  }
+  switch (fieldValue->type()) {
+    case FieldValue::Type::Integer:
+      return static_cast<double>(fieldValue->integer_value());
+    case FieldValue::Type::Double:
+      return fieldValue->double_value();
+    default:
+      return 0;
+  }
+}
+
+- (nullable NSString *)stringForField:(id)field {
+  absl::optional<FieldValue> fieldValue = [self internalValueForField:field];
+  if (!fieldValue || fieldValue->type() != FieldValue::Type::String) {
+    return nil;
+  }
+  return util::MakeNSString(fieldValue->string_value());
+}
+
+- (nullable FIRTimestamp *)timestampForField:(id)field {
+  return [self timestampForField:field serverTimestampBehavior:FIRServerTimestampBehaviorNone];
+}
+
+- (nullable FIRTimestamp *)timestampForField:(id)field
+                     serverTimestampBehavior:(FIRServerTimestampBehavior)serverTimestampBehavior {
+  absl::optional<FieldValue> fieldValue = [self internalValueForField:field];
+  if (!fieldValue) {
+    return nil;
+  }
+
+  const FieldValue *value = &*fieldValue;
+  if (value->type() == FieldValue::Type::ServerTimestamp) {
+    const auto &sts = value->server_timestamp_value();
+    switch (InternalServerTimestampBehavior(serverTimestampBehavior)) {
+      case ServerTimestampBehavior::kNone:
+        return nil;
+      case ServerTimestampBehavior::kEstimate:
+        return MakeFIRTimestamp(sts.local_write_time());
+      case ServerTimestampBehavior::kPrevious:
+        if (!sts.previous_value()) {
+          return nil;
+        }
+        value = &*sts.previous_value();
+        break;
+    }
+  }
+
+  return value->type() == FieldValue::Type::Timestamp ? MakeFIRTimestamp(value->timestamp_value())
+                                                      : nil;
+}
+
+- (absl::optional<FieldValue>)internalValueForField:(id)field {
+  // Parse string keys straight into a model path; there's no need for a FIRFieldPath in between.
+  FieldPath fieldPath;
+  if ([field isKindOfClass:[NSString class]]) {
+    fieldPath = FieldPathCache::Shared().FromDotSeparatedString(util::MakeString(field));
+  } else if ([field isKindOfClass:[FIRFieldPath class]]) {
+    fieldPath = static_cast<FIRFieldPath *>(field).internalValue;
+  } else {
+    ThrowInvalidArgument("Subscript key must be an NSString or FIRFieldPath.");
+  }
+
+  return _snapshot.GetValue(fieldPath);
+}
+
 - (FieldValueOptions)optionsForServerTimestampBehavior:
     (FIRServerTimestampBehavior)serverTimestampBehavior {
   SUPPRESS_DEPRECATED_DECLARATIONS_BEGIN()
@@ -295,6 +397,66 @@ ServerTimestampBehavior InternalServerTimestampBehavior(FIRServerTimestampBehavi
 
 @end
 
+@implementation FSTDocumentDataDictionary {
+  FIRDocumentSnapshot *_snapshot;
+  ObjectValue _data;
+  FIRServerTimestampBehavior _serverTimestampBehavior;
+
+  // The fields converted so far, keyed by field name.
+  NSMutableDictionary<NSString *, id> *_convertedFields;
+}
+
+- (instancetype)initWithSnapshot:(FIRDocumentSnapshot *)snapshot
+                            data:(ObjectValue)data
+         serverTimestampBehavior:(FIRServerTimestampBehavior)serverTimestampBehavior {
+  if (self = [super init]) {
+    _snapshot = snapshot;
+    _data = std::move(data);
+    _serverTimestampBehavior = serverTimestampBehavior;
+    _convertedFields = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+- (NSUInteger)count {
+  return _data.GetInternalValue().size();
+}
+
+- (nullable id)objectForKey:(id)key {
+  if (![key isKindOfClass:[NSString class]]) return nil;
+
+  @synchronized(self) {
+    id converted = _convertedFields[key];
+    if (converted) return converted;
+
+    const FieldValue::Map &fields = _data.GetInternalValue();
+    auto found = fields.find(util::MakeString(key));
+    if (found == fields.end()) return nil;
+
+    FieldValueOptions options =
+        [_snapshot optionsForServerTimestampBehavior:_serverTimestampBehavior];
+    converted = [_snapshot convertedValue:found->second options:options];
+    _convertedFields[key] = converted;
+    return converted;
+  }
+}
+
+- (NSEnumerator<NSString *> *)keyEnumerator {
+  const FieldValue::Map &fields = _data.GetInternalValue();
+  NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:fields.size()];
+  for (const auto &kv : fields) {
+    [keys addObject:util::MakeNSString(kv.first)];
+  }
+  return [keys objectEnumerator];
+}
+
+- (id)copyWithZone:(nullable NSZone *)zone {
+  // Immutable, so there's no need to copy.
+  return self;
+}
+
+@end
+
 @implementation FIRQueryDocumentSnapshot
 
 - (NSDictionary<NSString *, id> *)data {
@@ -25,12 +25,14 @@
 
 #include "Firestore/core/src/firebase/firestore/api/input_validation.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path_cache.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 
 namespace util = firebase::firestore::util;
 using firebase::firestore::api::ThrowInvalidArgument;
 using firebase::firestore::model::FieldPath;
+using firebase::firestore::model::FieldPathCache;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -69,8 +71,8 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 + (instancetype)pathWithDotSeparatedString:(NSString *)path {
-  return
-      [[FIRFieldPath alloc] initPrivate:FieldPath::FromDotSeparatedString(util::MakeString(path))];
+  FieldPath fieldPath = FieldPathCache::Shared().FromDotSeparatedString(util::MakeString(path));
+  return [[FIRFieldPath alloc] initPrivate:std::move(fieldPath)];
 }
 
 /** Matches any characters in a field path string that are reserved. */
@@ -61,6 +61,16 @@ using firebase::firestore::util::AsyncQueue;
 
 NS_ASSUME_NONNULL_BEGIN
 
+#if TARGET_OS_IOS || TARGET_OS_TV
+// The value of `UIApplicationDidReceiveMemoryWarningNotification`, spelled out to avoid linking
+// against UIKit.
+static NSString *const kDidReceiveMemoryWarningNotification =
+    @"UIApplicationDidReceiveMemoryWarningNotification";
+// Likewise for `UIApplicationDidEnterBackgroundNotification`.
+static NSString *const kDidEnterBackgroundNotification =
+    @"UIApplicationDidEnterBackgroundNotification";
+#endif
+
 #pragma mark - FIRFirestore
 
 @interface FIRFirestore ()
@@ -72,6 +82,8 @@ NS_ASSUME_NONNULL_BEGIN
 @implementation FIRFirestore {
   std::shared_ptr<Firestore> _firestore;
   FIRFirestoreSettings *_settings;
+  id<NSObject> _memoryWarningObserver;
+  id<NSObject> _backgroundObserver;
 }
 
 + (instancetype)firestore {
@@ -130,10 +142,41 @@ NS_ASSUME_NONNULL_BEGIN
                                                          preConverter:block];
     // Use the property setter so the default settings get plumbed into _firestoreClient.
     self.settings = [[FIRFirestoreSettings alloc] init];
+
+#if TARGET_OS_IOS || TARGET_OS_TV
+    std::weak_ptr<Firestore> weakFirestore = _firestore;
+    _memoryWarningObserver = [[NSNotificationCenter defaultCenter]
+        addObserverForName:kDidReceiveMemoryWarningNotification
+                    object:nil
+                     queue:nil
+                usingBlock:^(NSNotification *) {
+                  if (std::shared_ptr<Firestore> firestore = weakFirestore.lock()) {
+                    firestore->HandleMemoryPressure();
+                  }
+                }];
+    _backgroundObserver = [[NSNotificationCenter defaultCenter]
+        addObserverForName:kDidEnterBackgroundNotification
+                    object:nil
+                     queue:nil
+                usingBlock:^(NSNotification *) {
+                  if (std::shared_ptr<Firestore> firestore = weakFirestore.lock()) {
+                    firestore->HandleBackgrounding();
+                  }
+                }];
+#endif
   }
   return self;
 }
 
+- (void)dealloc {
+  if (_memoryWarningObserver) {
+    [[NSNotificationCenter defaultCenter] removeObserver:_memoryWarningObserver];
+  }
+  if (_backgroundObserver) {
+    [[NSNotificationCenter defaultCenter] removeObserver:_backgroundObserver];
+  }
+}
+
 - (FIRFirestoreSettings *)settings {
   // Disallow mutation of our internal settings
   return [_settings copy];
@@ -46,6 +46,7 @@
 #include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
@@ -73,6 +74,7 @@ using firebase::firestore::core::QueryListener;
 using firebase::firestore::core::ViewSnapshot;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::FieldPath;
+using firebase::firestore::model::FieldPathCache;
 using firebase::firestore::model::FieldValue;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::util::MakeNSError;
@@ -83,7 +85,7 @@ NS_ASSUME_NONNULL_BEGIN
 namespace {
 
 FieldPath MakeFieldPath(NSString *field) {
-  return FieldPath::FromDotSeparatedString(util::MakeString(field));
+  return FieldPathCache::Shared().FromDotSeparatedString(util::MakeString(field));
 }
 
 FIRQuery *Wrap(Query &&query) {
@@ -236,6 +238,24 @@ FIRQuery *Wrap(Query &&query) {
                                  value:value];
 }
 
+- (FIRQuery *)queryWhereField:(NSString *)field in:(NSArray *)values {
+  return [self queryWithFilterOperator:Filter::Operator::In field:field value:values];
+}
+
+- (FIRQuery *)queryWhereFieldPath:(FIRFieldPath *)path in:(NSArray *)values {
+  return [self queryWithFilterOperator:Filter::Operator::In path:path.internalValue value:values];
+}
+
+- (FIRQuery *)queryWhereField:(NSString *)field arrayContainsAny:(NSArray *)values {
+  return [self queryWithFilterOperator:Filter::Operator::ArrayContainsAny field:field value:values];
+}
+
+- (FIRQuery *)queryWhereFieldPath:(FIRFieldPath *)path arrayContainsAny:(NSArray *)values {
+  return [self queryWithFilterOperator:Filter::Operator::ArrayContainsAny
+                                  path:path.internalValue
+                                 value:values];
+}
+
 - (FIRQuery *)queryWhereField:(NSString *)field isGreaterThanOrEqualTo:(id)value {
   return [self queryWithFilterOperator:Filter::Operator::GreaterThanOrEqual
                                  field:field
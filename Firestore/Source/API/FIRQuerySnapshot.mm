@@ -15,6 +15,7 @@
  */
 
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/API/FIRQuerySnapshot+Internal.h"
 
@@ -42,6 +43,61 @@ using firebase::firestore::util::DelayedConstructor;
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * The documents of a query snapshot, as returned by `-[FIRQuerySnapshot documents]`. The
+ * FIRQueryDocumentSnapshot for each document is only created the first time it is accessed, so
+ * that callers that look at a few documents of a large snapshot don't pay for the rest.
+ */
+@interface FSTQueryDocumentsArray : NSArray<FIRQueryDocumentSnapshot *>
+
+- (instancetype)initWithSnapshots:(std::vector<DocumentSnapshot> &&)snapshots;
+
+@end
+
+@implementation FSTQueryDocumentsArray {
+  std::vector<DocumentSnapshot> _snapshots;
+
+  // The wrappers created so far, indexed like _snapshots.
+  std::vector<FIRQueryDocumentSnapshot *> _documents;
+}
+
+- (instancetype)initWithSnapshots:(std::vector<DocumentSnapshot> &&)snapshots {
+  if (self = [super init]) {
+    _snapshots = std::move(snapshots);
+    _documents.resize(_snapshots.size());
+  }
+  return self;
+}
+
+- (NSUInteger)count {
+  return _snapshots.size();
+}
+
+- (FIRQueryDocumentSnapshot *)objectAtIndex:(NSUInteger)index {
+  if (index >= _snapshots.size()) {
+    [NSException raise:NSRangeException
+                format:@"Index %lu beyond bounds [0 .. %lu]", static_cast<unsigned long>(index),
+                       static_cast<unsigned long>(_snapshots.size())];
+  }
+
+  @synchronized(self) {
+    FIRQueryDocumentSnapshot *document = _documents[index];
+    if (!document) {
+      DocumentSnapshot snapshot = _snapshots[index];
+      document = [[FIRQueryDocumentSnapshot alloc] initWithSnapshot:std::move(snapshot)];
+      _documents[index] = document;
+    }
+    return document;
+  }
+}
+
+- (id)copyWithZone:(nullable NSZone *)zone {
+  // Immutable, so there's no need to copy.
+  return self;
+}
+
+@end
+
 @implementation FIRQuerySnapshot {
   DelayedConstructor<QuerySnapshot> _snapshot;
 
@@ -50,9 +106,9 @@ NS_ASSUME_NONNULL_BEGIN
   // Cached value of the documents property.
   NSArray<FIRQueryDocumentSnapshot *> *_documents;
 
-  // Cached value of the documentChanges property.
+  // Cached values of documentChangesWithIncludeMetadataChanges:, for NO and YES respectively.
   NSArray<FIRDocumentChange *> *_documentChanges;
-  BOOL _documentChangesIncludeMetadataChanges;
+  NSArray<FIRDocumentChange *> *_documentChangesWithMetadataChanges;
 }
 
 - (instancetype)initWithSnapshot:(QuerySnapshot &&)snapshot {
@@ -108,12 +164,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSArray<FIRQueryDocumentSnapshot *> *)documents {
   if (!_documents) {
-    NSMutableArray<FIRQueryDocumentSnapshot *> *result = [NSMutableArray array];
-    _snapshot->ForEachDocument([&result](DocumentSnapshot snapshot) {
-      [result addObject:[[FIRQueryDocumentSnapshot alloc] initWithSnapshot:std::move(snapshot)]];
+    std::vector<DocumentSnapshot> snapshots;
+    snapshots.reserve(_snapshot->size());
+    _snapshot->ForEachDocument([&snapshots](DocumentSnapshot snapshot) {
+      snapshots.push_back(std::move(snapshot));
     });
 
-    _documents = result;
+    _documents = [[FSTQueryDocumentsArray alloc] initWithSnapshots:std::move(snapshots)];
   }
   return _documents;
 }
@@ -124,7 +181,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSArray<FIRDocumentChange *> *)documentChangesWithIncludeMetadataChanges:
     (BOOL)includeMetadataChanges {
-  if (!_documentChanges || _documentChangesIncludeMetadataChanges != includeMetadataChanges) {
+  NSArray<FIRDocumentChange *> *__strong &cached =
+      includeMetadataChanges ? _documentChangesWithMetadataChanges : _documentChanges;
+  if (!cached) {
     NSMutableArray *documentChanges = [NSMutableArray array];
     _snapshot->ForEachChange(
         static_cast<bool>(includeMetadataChanges), [&documentChanges](DocumentChange change) {
@@ -132,10 +191,9 @@ NS_ASSUME_NONNULL_BEGIN
               addObject:[[FIRDocumentChange alloc] initWithDocumentChange:std::move(change)]];
         });
 
-    _documentChanges = documentChanges;
-    _documentChangesIncludeMetadataChanges = includeMetadataChanges;
+    cached = documentChanges;
   }
-  return _documentChanges;
+  return cached;
 }
 
 @end
@@ -16,7 +16,9 @@
 
 #import "Firestore/Source/API/FSTUserDataConverter.h"
 
+#include <cstdint>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <set>
 #include <string>
 #include <utility>
@@ -39,9 +41,11 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/field_transform.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/precondition.h"
+#include "Firestore/core/src/firebase/firestore/model/string_interner.h"
 #include "Firestore/core/src/firebase/firestore/model/transform_operations.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
 #include "Firestore/core/src/firebase/firestore/timestamp_internal.h"
@@ -66,12 +70,14 @@ using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::FieldMask;
 using firebase::firestore::model::FieldPath;
+using firebase::firestore::model::FieldPathCache;
 using firebase::firestore::model::FieldTransform;
 using firebase::firestore::model::FieldValue;
 using firebase::firestore::model::NumericIncrementTransform;
 using firebase::firestore::model::ObjectValue;
 using firebase::firestore::model::Precondition;
 using firebase::firestore::model::ServerTimestampTransform;
+using firebase::firestore::model::StringInterner;
 using firebase::firestore::model::TransformOperation;
 using firebase::firestore::nanopb::MakeByteString;
 
@@ -105,6 +111,46 @@ NS_ASSUME_NONNULL_BEGIN
 
 #pragma mark - Conversion helpers
 
+namespace {
+
+/**
+ * Remembers the UTF-8 form of the dictionary keys converted most recently, so
+ * that parsing many dictionaries with the same keys (such as documents written
+ * in a loop using literal keys) converts each key only once.
+ *
+ * Entries are found by the identity of the key, which the cache retains, so
+ * a hit can't be a different string that happens to reuse the address. Keys
+ * of dictionaries are copied when inserted, so they can't change either.
+ */
+class FieldNameCache {
+ public:
+  std::string Get(NSString *name) {
+    uintptr_t address = reinterpret_cast<uintptr_t>((__bridge void *)name);
+    // Objects are at least 16-byte aligned, so the low bits don't vary.
+    Entry &entry = entries_[(address >> 4) % kSize];
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (entry.name != name) {
+      entry.name = name;
+      entry.utf8 = util::MakeString(name);
+    }
+    return entry.utf8;
+  }
+
+ private:
+  static constexpr size_t kSize = 64;
+
+  struct Entry {
+    NSString *name = nil;
+    std::string utf8;
+  };
+
+  std::mutex mutex_;
+  Entry entries_[kSize];
+};
+
+}  // namespace
+
 #pragma mark - FSTUserDataConverter
 
 @interface FSTUserDataConverter ()
@@ -113,6 +159,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 @implementation FSTUserDataConverter {
   DatabaseId _databaseID;
+  FieldNameCache _fieldNames;
 }
 
 - (instancetype)initWithDatabaseID:(DatabaseId)databaseID
@@ -159,7 +206,7 @@ NS_ASSUME_NONNULL_BEGIN
       FieldPath path;
 
       if ([fieldPath isKindOfClass:[NSString class]]) {
-        path = FieldPath::FromDotSeparatedString(util::MakeString(fieldPath));
+        path = FieldPathCache::Shared().FromDotSeparatedString(util::MakeString(fieldPath));
       } else if ([fieldPath isKindOfClass:[FIRFieldPath class]]) {
         path = static_cast<FIRFieldPath *>(fieldPath).internalValue;
       } else {
@@ -289,10 +336,11 @@ NS_ASSUME_NONNULL_BEGIN
     __block ObjectValue result = ObjectValue::Empty();
 
     [dict enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
+      std::string fieldName = self->_fieldNames.Get(key);
       absl::optional<FieldValue> parsedValue =
-          [self parseData:value context:context.ChildContext(util::MakeString(key))];
+          [self parseData:value context:context.ChildContext(fieldName)];
       if (parsedValue) {
-        FieldPath path = FieldPath{util::MakeString(key)};
+        FieldPath path = FieldPath{fieldName};
         result = result.Set(path, *parsedValue);
       }
     }];
@@ -460,7 +508,7 @@ NS_ASSUME_NONNULL_BEGIN
     }
 
   } else if ([input isKindOfClass:[NSString class]]) {
-    return FieldValue::FromString(util::MakeString(input));
+    return StringInterner::Shared().Intern(util::MakeString(input));
 
   } else if ([input isKindOfClass:[NSDate class]]) {
     NSDate *inputDate = input;
@@ -21,6 +21,8 @@
 #include "Firestore/core/src/firebase/firestore/core/query_listener.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_batching.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 
 @class FSTQuery;
@@ -28,6 +30,7 @@
 
 namespace core = firebase::firestore::core;
 namespace model = firebase::firestore::model;
+namespace util = firebase::firestore::util;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -41,6 +44,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)eventManagerWithSyncEngine:(FSTSyncEngine *)syncEngine;
 
+/**
+ * Creates an event manager that uses the given worker queue to raise the events held back by
+ * listeners with a minimum event interval once they are due.
+ */
++ (instancetype)eventManagerWithSyncEngine:(FSTSyncEngine *)syncEngine
+                               workerQueue:(std::shared_ptr<util::AsyncQueue>)workerQueue;
+
 - (instancetype)init NS_UNAVAILABLE;
 
 - (model::TargetId)addListener:(std::shared_ptr<core::QueryListener>)listener;
@@ -48,6 +58,19 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)applyChangedOnlineState:(model::OnlineState)onlineState;
 
+/**
+ * Sets the executor that listeners deliver their snapshots to, so that the snapshots raised by one
+ * round of changes are delivered in a single operation.
+ */
+- (void)setSnapshotBatchingExecutor:(std::shared_ptr<util::ExecutorBatching>)executor;
+
+/**
+ * Whether listeners for a query whose results can be computed from those of a query that is
+ * already listened to share its target. Their snapshots are then derived in memory from the
+ * snapshots of the broader query. Only affects queries listened to after it is set.
+ */
+@property(nonatomic, assign) BOOL sharedQueryExecutionEnabled;
+
 @end
 
 NS_ASSUME_NONNULL_END
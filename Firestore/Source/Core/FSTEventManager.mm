@@ -16,15 +16,23 @@
 
 #import "Firestore/Source/Core/FSTEventManager.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Core/FSTSyncEngine.h"
+#import "Firestore/Source/Core/FSTView.h"
+#import "Firestore/Source/Model/FSTDocument.h"
 
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_compatibility.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
@@ -37,10 +45,17 @@ namespace objc = firebase::firestore::objc;
 using firebase::firestore::core::DocumentViewChange;
 using firebase::firestore::core::QueryListener;
 using firebase::firestore::core::ViewSnapshot;
+using firebase::firestore::model::DocumentKeySet;
+using firebase::firestore::model::DocumentSet;
+using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::OnlineState;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::DelayedOperation;
+using firebase::firestore::util::ExecutorBatching;
 using firebase::firestore::util::MakeStatus;
 using firebase::firestore::util::Status;
+using firebase::firestore::util::TimerId;
 
 #pragma mark - FSTQueryListenersInfo
 
@@ -54,6 +69,14 @@ struct QueryListenersInfo {
   TargetId target_id;
   std::vector<std::shared_ptr<QueryListener>> listeners;
 
+  // Set if the query has no target of its own, in which case its snapshots are derived by
+  // `derived_view` from those of the `superset` query.
+  FSTQuery *_Nullable superset = nil;
+  FSTView *_Nullable derived_view = nil;
+
+  // The queries whose snapshots are derived from the snapshots of this one.
+  std::vector<FSTQuery *> derived_queries;
+
   void Erase(const std::shared_ptr<QueryListener> &listener) {
     auto found = absl::c_find(listeners, listener);
     if (found != listeners.end()) {
@@ -61,6 +84,17 @@ struct QueryListenersInfo {
     }
   }
 
+  void EraseDerived(FSTQuery *query) {
+    auto found = absl::c_find_if(derived_queries, [&](FSTQuery *q) { return [q isEqual:query]; });
+    if (found != derived_queries.end()) {
+      derived_queries.erase(found);
+    }
+  }
+
+  bool InUse() const {
+    return !listeners.empty() || !derived_queries.empty();
+  }
+
   const absl::optional<ViewSnapshot> &view_snapshot() const {
     return snapshot_;
   }
@@ -81,7 +115,9 @@ struct QueryListenersInfo {
 
 @interface FSTEventManager () <FSTSyncEngineDelegate>
 
-- (instancetype)initWithSyncEngine:(FSTSyncEngine *)syncEngine NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithSyncEngine:(FSTSyncEngine *)syncEngine
+                       workerQueue:(std::shared_ptr<AsyncQueue>)workerQueue
+    NS_DESIGNATED_INITIALIZER;
 
 @property(nonatomic, strong, readonly) FSTSyncEngine *syncEngine;
 @property(nonatomic, assign) OnlineState onlineState;
@@ -90,20 +126,40 @@ struct QueryListenersInfo {
 
 @implementation FSTEventManager {
   objc::unordered_map<FSTQuery *, QueryListenersInfo> _queries;
+
+  std::shared_ptr<AsyncQueue> _workerQueue;
+
+  /** Raises the events held back by listeners, once the first of them is due. */
+  DelayedOperation _pendingEventsTimer;
+  QueryListener::Clock::time_point _pendingEventsTime;
+
+  /** If set, the executor to batch the snapshots raised together on. */
+  std::shared_ptr<ExecutorBatching> _snapshotBatchingExecutor;
 }
 
 + (instancetype)eventManagerWithSyncEngine:(FSTSyncEngine *)syncEngine {
-  return [[FSTEventManager alloc] initWithSyncEngine:syncEngine];
+  return [[FSTEventManager alloc] initWithSyncEngine:syncEngine workerQueue:nullptr];
+}
+
++ (instancetype)eventManagerWithSyncEngine:(FSTSyncEngine *)syncEngine
+                               workerQueue:(std::shared_ptr<AsyncQueue>)workerQueue {
+  return [[FSTEventManager alloc] initWithSyncEngine:syncEngine workerQueue:std::move(workerQueue)];
 }
 
-- (instancetype)initWithSyncEngine:(FSTSyncEngine *)syncEngine {
+- (instancetype)initWithSyncEngine:(FSTSyncEngine *)syncEngine
+                       workerQueue:(std::shared_ptr<AsyncQueue>)workerQueue {
   if (self = [super init]) {
     _syncEngine = syncEngine;
     _syncEngine.syncEngineDelegate = self;
+    _workerQueue = std::move(workerQueue);
   }
   return self;
 }
 
+- (void)setSnapshotBatchingExecutor:(std::shared_ptr<ExecutorBatching>)executor {
+  _snapshotBatchingExecutor = std::move(executor);
+}
+
 - (TargetId)addListener:(std::shared_ptr<QueryListener>)listener {
   FSTQuery *query = listener->query();
 
@@ -111,10 +167,29 @@ struct QueryListenersInfo {
   bool first_listen = inserted.second;
   QueryListenersInfo &query_info = inserted.first->second;
 
+  HARD_ASSERT(_workerQueue || listener->options().min_event_interval().count() == 0,
+              "Listeners with a minimum event interval need an event manager with a worker queue");
   query_info.listeners.push_back(listener);
 
   listener->OnOnlineStateChanged(self.onlineState);
 
+  FSTQuery *_Nullable superset =
+      first_listen && self.sharedQueryExecutionEnabled ? [self supersetForQuery:query] : nil;
+  if (superset) {
+    QueryListenersInfo &superset_info = _queries.find(superset)->second;
+    superset_info.derived_queries.push_back(query);
+
+    query_info.target_id = superset_info.target_id;
+    query_info.superset = superset;
+    query_info.derived_view = [[FSTView alloc] initWithQuery:query
+                                             remoteDocuments:DocumentKeySet{}];
+    if (superset_info.view_snapshot().has_value()) {
+      [self deriveSnapshotForQueryInfo:query_info
+                          fromSnapshot:superset_info.view_snapshot().value()];
+    }
+    return query_info.target_id;
+  }
+
   if (query_info.view_snapshot().has_value()) {
     listener->OnViewSnapshot(query_info.view_snapshot().value());
   }
@@ -127,33 +202,180 @@ struct QueryListenersInfo {
 
 - (void)removeListener:(const std::shared_ptr<QueryListener> &)listener {
   FSTQuery *query = listener->query();
-  bool last_listen = false;
 
   auto found_iter = _queries.find(query);
   if (found_iter != _queries.end()) {
-    QueryListenersInfo &query_info = found_iter->second;
-    query_info.Erase(listener);
-    last_listen = query_info.listeners.empty();
+    found_iter->second.Erase(listener);
+    [self stopTrackingQueryIfUnused:query];
   }
+}
 
-  if (last_listen) {
-    _queries.erase(found_iter);
+/**
+ * Forgets about the query if it has neither listeners nor queries derived from it anymore, and
+ * stops listening to it or to its superset as appropriate.
+ */
+- (void)stopTrackingQueryIfUnused:(FSTQuery *)query {
+  auto found_iter = _queries.find(query);
+  if (found_iter->second.InUse()) {
+    return;
+  }
+
+  FSTQuery *_Nullable superset = found_iter->second.superset;
+  _queries.erase(found_iter);
+
+  if (superset) {
+    _queries.find(superset)->second.EraseDerived(query);
+    [self stopTrackingQueryIfUnused:superset];
+  } else {
     [self.syncEngine stopListeningToQuery:query];
   }
 }
 
+/**
+ * Returns a query with a target of its own whose results contain those of the given query, if
+ * there is one.
+ */
+- (nullable FSTQuery *)supersetForQuery:(FSTQuery *)query {
+  for (const auto &kv : _queries) {
+    FSTQuery *candidate = kv.first;
+    if (!kv.second.superset && ![candidate isEqual:query] && candidate.query.Covers(query.query)) {
+      return candidate;
+    }
+  }
+  return nil;
+}
+
+/**
+ * Computes the next snapshot of a derived query from the latest snapshot of its superset and
+ * raises it to the listeners of the derived query.
+ */
+- (void)deriveSnapshotForQueryInfo:(QueryListenersInfo &)query_info
+                      fromSnapshot:(const ViewSnapshot &)snapshot {
+  auto allDocuments = [&] {
+    MaybeDocumentMap documents;
+    for (FSTDocument *doc : snapshot.documents()) {
+      documents = documents.insert(doc.key, doc);
+    }
+    return documents;
+  };
+
+  FSTView *view = query_info.derived_view;
+  const absl::optional<ViewSnapshot> &previous = query_info.view_snapshot();
+  FSTViewDocumentChanges *docChanges;
+  if (!previous.has_value()) {
+    docChanges = [view computeChangesWithDocuments:allDocuments()];
+  } else {
+    // Documents removed from the superset can't match the derived query either.
+    MaybeDocumentMap changedDocuments;
+    for (const DocumentViewChange &change : snapshot.document_changes()) {
+      FSTDocument *doc = change.document();
+      FSTMaybeDocument *maybeDoc = doc;
+      if (change.type() == DocumentViewChange::Type::kRemoved) {
+        maybeDoc = [FSTDeletedDocument documentWithKey:doc.key
+                                               version:doc.version
+                                 hasCommittedMutations:false];
+      }
+      changedDocuments = changedDocuments.insert(doc.key, maybeDoc);
+    }
+    docChanges = [view computeChangesWithDocuments:changedDocuments];
+    if (docChanges.needsRefill) {
+      docChanges = [view computeChangesWithDocuments:allDocuments() previousChanges:docChanges];
+    }
+  }
+
+  // The derived view has no target, so take whether the results are from the cache from the
+  // superset instead.
+  FSTViewChange *viewChange = [view applyChangesToDocuments:docChanges];
+  const absl::optional<ViewSnapshot> &derived = viewChange.snapshot;
+  bool fromCacheChanged = !previous.has_value() || previous->from_cache() != snapshot.from_cache();
+  if (!derived.has_value() && !fromCacheChanged) {
+    return;
+  }
+
+  const ViewSnapshot &current = derived.has_value() ? derived.value() : previous.value();
+  ViewSnapshot result{current.query(),
+                      current.documents(),
+                      derived.has_value() ? current.old_documents() : current.documents(),
+                      derived.has_value() ? current.document_changes()
+                                          : std::vector<DocumentViewChange>{},
+                      current.mutated_keys(),
+                      snapshot.from_cache(),
+                      fromCacheChanged,
+                      /*excludes_metadata_changes=*/false};
+  [self raiseSnapshot:result toListeners:query_info.listeners];
+  query_info.set_view_snapshot(std::move(result));
+}
+
 - (void)handleViewSnapshots:(std::vector<ViewSnapshot> &&)viewSnapshots {
+  [self beginSnapshotBatch];
   for (ViewSnapshot &viewSnapshot : viewSnapshots) {
     FSTQuery *query = viewSnapshot.query();
     auto found_iter = _queries.find(query);
     if (found_iter != _queries.end()) {
       QueryListenersInfo &query_info = found_iter->second;
-      for (const auto &listener : query_info.listeners) {
-        listener->OnViewSnapshot(viewSnapshot);
-      }
+      [self raiseSnapshot:viewSnapshot toListeners:query_info.listeners];
       query_info.set_view_snapshot(std::move(viewSnapshot));
+
+      for (FSTQuery *derived : query_info.derived_queries) {
+        [self deriveSnapshotForQueryInfo:_queries.find(derived)->second
+                            fromSnapshot:query_info.view_snapshot().value()];
+      }
     }
   }
+  [self endSnapshotBatch];
+}
+
+- (void)beginSnapshotBatch {
+  if (_snapshotBatchingExecutor) {
+    _snapshotBatchingExecutor->BeginBatch();
+  }
+}
+
+- (void)endSnapshotBatch {
+  if (_snapshotBatchingExecutor) {
+    _snapshotBatchingExecutor->EndBatch();
+  }
+}
+
+- (void)raiseSnapshot:(const ViewSnapshot &)snapshot
+          toListeners:(const std::vector<std::shared_ptr<QueryListener>> &)listeners {
+  for (const auto &listener : listeners) {
+    listener->OnViewSnapshot(snapshot);
+    [self schedulePendingEventOfListener:*listener];
+  }
+}
+
+/** Makes sure that the event the listener is holding back, if any, gets raised when it is due. */
+- (void)schedulePendingEventOfListener:(const QueryListener &)listener {
+  absl::optional<QueryListener::Clock::time_point> time = listener.pending_event_time();
+  if (!time || (_pendingEventsTimer && _pendingEventsTime <= *time)) {
+    return;
+  }
+
+  _pendingEventsTimer.Cancel();
+  _pendingEventsTime = *time;
+  auto delay = std::chrono::duration_cast<AsyncQueue::Milliseconds>(
+      *time - QueryListener::Clock::now());
+  _pendingEventsTimer = _workerQueue->EnqueueAfterDelay(
+      std::max(delay, AsyncQueue::Milliseconds::zero()), TimerId::ListenerEventCoalescing,
+      [self] { [self raisePendingEvents]; });
+}
+
+/** Raises the events held back by listeners that are due, and schedules the ones that aren't. */
+- (void)raisePendingEvents {
+  _pendingEventsTimer = DelayedOperation{};
+  QueryListener::Clock::time_point now = QueryListener::Clock::now();
+  [self beginSnapshotBatch];
+  for (const auto &kv : _queries) {
+    for (const auto &listener : kv.second.listeners) {
+      absl::optional<QueryListener::Clock::time_point> time = listener->pending_event_time();
+      if (time && *time <= now) {
+        listener->RaisePendingEvent();
+      }
+      [self schedulePendingEventOfListener:*listener];
+    }
+  }
+  [self endSnapshotBatch];
 }
 
 - (void)handleError:(NSError *)error forQuery:(FSTQuery *)query {
@@ -163,6 +385,13 @@ struct QueryListenersInfo {
     for (const auto &listener : query_info.listeners) {
       listener->OnError(Status::FromNSError(error));
     }
+    for (FSTQuery *derived : query_info.derived_queries) {
+      auto derived_iter = _queries.find(derived);
+      for (const auto &listener : derived_iter->second.listeners) {
+        listener->OnError(Status::FromNSError(error));
+      }
+      _queries.erase(derived_iter);
+    }
 
     // Remove all listeners. NOTE: We don't need to call [FSTSyncEngine stopListening] after an
     // error.
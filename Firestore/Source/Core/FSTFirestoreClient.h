@@ -16,6 +16,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -31,10 +32,16 @@
 #include "Firestore/core/src/firebase/firestore/core/query_listener.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/local/pending_writes.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
+#include "Firestore/core/src/firebase/firestore/local/startup_profile.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
+#include "absl/types/optional.h"
 
 @class FIRDocumentReference;
 @class FIRDocumentSnapshot;
@@ -49,6 +56,7 @@
 namespace api = firebase::firestore::api;
 namespace auth = firebase::firestore::auth;
 namespace core = firebase::firestore::core;
+namespace local = firebase::firestore::local;
 namespace model = firebase::firestore::model;
 namespace util = firebase::firestore::util;
 
@@ -100,6 +108,16 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)getDocumentFromLocalCache:(const api::DocumentReference &)doc
                          callback:(api::DocumentSnapshot::Listener &&)callback;
 
+/**
+ * Retrieves the given documents from the cache with a single read, and delivers their snapshots to
+ * the callback in the order of `docs`. If any of them isn't in the cache, an error is delivered
+ * instead, as by `getDocumentFromLocalCache:callback:`.
+ */
+- (void)getDocumentReferencesFromLocalCache:(const std::vector<api::DocumentReference> &)docs
+                                   callback:
+                                       (util::StatusOrCallback<std::vector<api::DocumentSnapshot>>)
+                                           callback;
+
 /**
  * Retrieves a (possibly empty) set of documents from the cache via the
  * indicated completion.
@@ -107,10 +125,96 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)getDocumentsFromLocalCache:(const api::Query &)query
                           callback:(api::QuerySnapshot::Listener &&)callback;
 
+/**
+ * Runs the query once on the backend, without listening to it, and delivers the results to the
+ * callback. If `cacheResults` is YES, the results are also written to the local cache, which updates
+ * the active listeners they affect, and the snapshot reflects pending writes.
+ */
+- (void)getDocumentsFromServer:(const api::Query &)query
+                  cacheResults:(BOOL)cacheResults
+                      callback:(api::QuerySnapshot::Listener &&)callback;
+
+/**
+ * Looks up the given documents on the backend with a single request, without listening to them, and
+ * delivers their snapshots to the callback in the order of `docs`. If `cacheResults` is YES, the
+ * results are also written to the local cache, as by the query variant above, and the snapshots
+ * reflect pending writes.
+ */
+- (void)getDocumentReferencesFromServer:(const std::vector<api::DocumentReference> &)docs
+                           cacheResults:(BOOL)cacheResults
+                               callback:
+                                   (util::StatusOrCallback<std::vector<api::DocumentSnapshot>>)
+                                       callback;
+
+/**
+ * Like `getDocumentsFromLocalCache:callback:`, but also reports to the callback how much work
+ * executing the query took.
+ */
+- (void)profileDocumentsFromLocalCache:(const api::Query &)query
+                              callback:(api::Query::ProfileListener &&)callback;
+
+/**
+ * Retrieves one page of the results of a collection query from the cache: the first `pageSize`
+ * matching documents in key order after `startAfter`, if given. The query's own limit and sort
+ * order are ignored. Passing the last key of each page as the start of the next lets very large
+ * results be read without holding all of them in memory.
+ */
+- (void)getDocumentsPageFromLocalCache:(const api::Query &)query
+                            startAfter:(const absl::optional<model::DocumentKey> &)startAfter
+                              pageSize:(size_t)pageSize
+                              callback:(std::function<void(model::DocumentMap)>)callback;
+
+/** Returns the work done by all queries executed against the local cache so far. */
+- (local::QueryProfile)aggregateQueryProfile;
+
+/**
+ * Reports how long the steps of starting the local store took. If starting the mutation queue was
+ * deferred, the callback is invoked once it has started.
+ */
+- (void)startupProfileWithCallback:(std::function<void(local::StartupProfile)>)callback;
+
+/**
+ * Reads the results of the given queries from the local cache on the background lane of the
+ * worker queue, warming the decoded document cache and the underlying storage's caches. The
+ * callback, if any, is notified once all of them have been read.
+ */
+- (void)preloadQueries:(std::vector<api::Query>)queries callback:(util::StatusCallback)callback;
+
+/**
+ * Trims the in-memory caches of persistence and the model down to the memory pressure budget of
+ * the settings, then runs garbage collection without waiting for its next scheduled run.
+ */
+- (void)handleMemoryPressure;
+
+/**
+ * Writes the targets whose resume tokens the local store holds back, if the settings defer target
+ * persistence, since the app may be terminated while in the background.
+ */
+- (void)handleBackgrounding;
+
+/** Reports the backlog of writes waiting to be acknowledged by the backend. */
+- (void)pendingWritesWithCallback:(std::function<void(local::PendingWrites)>)callback;
+
+/**
+ * Notifies the listener whenever the backlog of pending writes reaches the threshold, and again
+ * when it drops back below it, along with which of the two happened. Replaces any listener set
+ * before; an empty listener just removes it.
+ */
+- (void)setPendingWritesThreshold:(local::PendingWrites)threshold
+                         listener:(std::function<void(local::PendingWrites, bool)>)listener;
+
 /** Write mutations. callback will be notified when it's written to the backend. */
 - (void)writeMutations:(std::vector<FSTMutation *> &&)mutations
               callback:(util::StatusCallback)callback;
 
+/**
+ * Writes the mutations returned by the given block, which is called on the worker queue so that
+ * writes stay in order. If the block throws an invalid argument exception, the callback is given
+ * the error and nothing is written.
+ */
+- (void)writeMutationsFromBlock:(std::function<std::vector<FSTMutation *>()>)block
+                       callback:(util::StatusCallback)callback;
+
 /** Tries to execute the transaction in updateCallback up to retries times. */
 - (void)transactionWithRetries:(int)retries
                 updateCallback:(core::TransactionUpdateCallback)updateCallback
@@ -17,9 +17,11 @@
 #import "Firestore/Source/Core/FSTFirestoreClient.h"
 
 #include <chrono>  // NOLINT(build/c++11)
+#include <functional>
 #include <future>  // NOLINT(build/c++11)
 #include <memory>
 #include <utility>
+#include <vector>
 
 #import "FIRFirestoreErrors.h"
 #import "Firestore/Source/API/FIRDocumentReference+Internal.h"
@@ -44,17 +46,25 @@
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/local/pending_writes.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
+#include "Firestore/core/src/firebase/firestore/local/startup_profile.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/string_interner.h"
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_batching.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
 
 namespace util = firebase::firestore::util;
 using firebase::firestore::Error;
@@ -70,17 +80,31 @@ using firebase::firestore::core::ListenOptions;
 using firebase::firestore::core::QueryListener;
 using firebase::firestore::core::ViewSnapshot;
 using firebase::firestore::local::LruParams;
+using firebase::firestore::local::LruResults;
+using firebase::firestore::local::PendingWrites;
+using firebase::firestore::local::QueryProfile;
+using firebase::firestore::local::QueryProfileScope;
+using firebase::firestore::local::QueryProfileTotals;
+using firebase::firestore::local::StartupProfile;
 using firebase::firestore::model::DatabaseId;
+using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
+using firebase::firestore::model::FieldPathCache;
 using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::OnlineState;
+using firebase::firestore::model::SnapshotVersion;
+using firebase::firestore::model::StringInterner;
 using firebase::firestore::remote::Datastore;
+using firebase::firestore::remote::RemoteEvent;
 using firebase::firestore::remote::RemoteStore;
+using firebase::firestore::remote::TargetChange;
+using firebase::firestore::remote::WritePipelineWindow;
 using firebase::firestore::util::Path;
 using firebase::firestore::util::AsyncQueue;
 using firebase::firestore::util::DelayedOperation;
 using firebase::firestore::util::Executor;
+using firebase::firestore::util::ExecutorBatching;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StatusOr;
 using firebase::firestore::util::StatusOrCallback;
@@ -125,14 +149,36 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
   std::shared_ptr<AsyncQueue> _workerQueue;
 
   std::unique_ptr<RemoteStore> _remoteStore;
+  /** The datastore of `_remoteStore`, for the calls made without it. */
+  std::shared_ptr<Datastore> _datastore;
 
   std::shared_ptr<Executor> _userExecutor;
+  /** With snapshot batching enabled, the executor wrapping the user executor. */
+  std::shared_ptr<ExecutorBatching> _snapshotBatchingExecutor;
   std::chrono::milliseconds _initialGcDelay;
   std::chrono::milliseconds _regularGcDelay;
   bool _gcHasRun;
   std::atomic<bool> _isShutdown;
   _Nullable id<FSTLRUDelegate> _lruDelegate;
   DelayedOperation _lruCallback;
+  size_t _memoryPressureBudgetBytes;
+
+  /** If positive, how often the targets held back by the local store are written. */
+  std::chrono::milliseconds _targetPersistenceInterval;
+  DelayedOperation _targetPersistenceCallback;
+
+  /** Whether the pending writes listener was last told the backlog reached its threshold. */
+  BOOL _pendingWritesThresholdReached;
+
+  /** With snapshot reads enabled, the persistence to read from and the queue to read on. */
+  FSTLevelDB *_Nullable _snapshotReadPersistence;
+  dispatch_queue_t _Nullable _snapshotReadQueue;
+
+  /** The work done by all queries executed against the local cache. */
+  QueryProfileTotals _queryProfileTotals;
+
+  /** How long starting persistence took; the local store adds its own steps. */
+  StartupProfile _persistenceStartupProfile;
 }
 
 - (const std::shared_ptr<util::Executor> &)userExecutor {
@@ -169,7 +215,12 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
   if (self = [super init]) {
     _databaseInfo = databaseInfo;
     _credentialsProvider = credentialsProvider;
-    _userExecutor = std::move(userExecutor);
+    if (settings.snapshot_batching_enabled()) {
+      _snapshotBatchingExecutor = std::make_shared<ExecutorBatching>(std::move(userExecutor));
+      _userExecutor = _snapshotBatchingExecutor;
+    } else {
+      _userExecutor = std::move(userExecutor);
+    }
     _workerQueue = std::move(workerQueue);
     _gcHasRun = false;
     _isShutdown = false;
@@ -214,19 +265,23 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
   // Note: The initialization work must all be synchronous (we can't dispatch more work) since
   // external write/listen operations could get queued to run before that subsequent work
   // completes.
+  _memoryPressureBudgetBytes = static_cast<size_t>(settings.memory_pressure_budget_bytes());
   if (settings.persistence_enabled()) {
     Path dir = [FSTLevelDB storageDirectoryForDatabaseInfo:*self.databaseInfo
                                         documentsDirectory:[FSTLevelDB documentsDirectory]];
 
     FSTSerializerBeta *remoteSerializer =
         [[FSTSerializerBeta alloc] initWithDatabaseID:self.databaseInfo->database_id()];
-    FSTLocalSerializer *serializer =
-        [[FSTLocalSerializer alloc] initWithRemoteSerializer:remoteSerializer];
+    FSTLocalSerializer *serializer = [[FSTLocalSerializer alloc]
+        initWithRemoteSerializer:remoteSerializer
+           relativeDocumentNames:settings.persistence_tuning().relative_document_names_enabled];
     FSTLevelDB *ldb;
     Status levelDbStatus =
         [FSTLevelDB dbWithDirectory:std::move(dir)
                          serializer:serializer
                           lruParams:LruParams::WithCacheSize(settings.cache_size_bytes())
+             documentCacheSizeBytes:static_cast<size_t>(settings.document_cache_size_bytes())
+                  persistenceTuning:settings.persistence_tuning()
                                 ptr:&ldb];
     if (!levelDbStatus.ok()) {
       // If leveldb fails to start then just throw up our hands: the error is unrecoverable.
@@ -236,8 +291,20 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
       [NSException raise:NSInternalInconsistencyException
                   format:@"Failed to open DB: %s", levelDbStatus.ToString().c_str()];
     }
+    int64_t groupCommitWindowMs = settings.persistence_tuning().group_commit_window_ms;
+    if (groupCommitWindowMs > 0) {
+      [ldb enableGroupCommitWithWindow:std::chrono::milliseconds(groupCommitWindowMs)
+                                 queue:_workerQueue];
+    }
+    [ldb enableIdleCompactionWithQueue:_workerQueue];
+    if (settings.snapshot_reads_enabled()) {
+      _snapshotReadPersistence = ldb;
+      _snapshotReadQueue = dispatch_queue_create("com.google.firebase.firestore.snapshotReads",
+                                                 DISPATCH_QUEUE_CONCURRENT);
+    }
     _lruDelegate = ldb.referenceDelegate;
     _persistence = ldb;
+    _persistenceStartupProfile = ldb.startupProfile;
     if (settings.gc_enabled()) {
       [self scheduleLruGarbageCollection];
     }
@@ -246,27 +313,164 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
   }
 
   _localStore = [[FSTLocalStore alloc] initWithPersistence:_persistence initialUser:user];
+  _localStore.queryFromTargetKeysEnabled = settings.query_from_target_keys_enabled();
+  _localStore.mutationCompactionEnabled = settings.mutation_compaction_enabled();
+  _localStore.resumeTokenMaxAgeSeconds = settings.resume_token_max_age_seconds();
+  _targetPersistenceInterval =
+      std::chrono::milliseconds(settings.target_persistence_interval_ms());
+  if (_targetPersistenceInterval.count() > 0) {
+    _localStore.targetPersistenceDeferred = YES;
+    [self scheduleTargetPersistence];
+  }
 
-  auto datastore =
-      std::make_shared<Datastore>(*self.databaseInfo, _workerQueue, _credentialsProvider);
+  auto datastore = std::make_shared<Datastore>(
+      *self.databaseInfo, _workerQueue, _credentialsProvider,
+      settings.separate_watch_channel_enabled(),
+      settings.shared_grpc_runtime_enabled() ? Datastore::SharedGrpcRuntime() : nullptr);
+  datastore->set_watch_stream_backoff_policy(settings.watch_stream_backoff_policy());
+  datastore->set_write_stream_backoff_policy(settings.write_stream_backoff_policy());
+  datastore->set_watch_stream_idle_timeout(
+      std::chrono::milliseconds(settings.watch_stream_idle_timeout_ms()));
+  datastore->set_write_stream_idle_timeout(
+      std::chrono::milliseconds(settings.write_stream_idle_timeout_ms()));
+  datastore->set_keepalive_policy(settings.keepalive_policy());
+  datastore->set_compression_policy(settings.compression_policy());
+  _datastore = datastore;
 
   _remoteStore = absl::make_unique<RemoteStore>(
       _localStore, std::move(datastore), _workerQueue,
-      [self](OnlineState onlineState) { [self.syncEngine applyChangedOnlineState:onlineState]; });
+      [self](OnlineState onlineState) { [self.syncEngine applyChangedOnlineState:onlineState]; },
+      WritePipelineWindow{settings.max_pending_writes(),
+                          settings.adaptive_write_pipeline_enabled()},
+      settings.write_batch_coalescing_enabled(), settings.write_ack_coalescing_enabled());
 
   _syncEngine = [[FSTSyncEngine alloc] initWithLocalStore:_localStore
                                               remoteStore:_remoteStore.get()
                                               initialUser:user];
+  _syncEngine.limitPrefetchSize = settings.limit_prefetch_size();
+  _syncEngine.parallelViewComputationEnabled = settings.parallel_view_computation_enabled();
+  _syncEngine.transactionPrefetchEnabled = settings.transaction_prefetch_enabled();
+  _syncEngine.maxConcurrentLimboResolutions = settings.max_concurrent_limbo_resolutions();
 
-  _eventManager = [FSTEventManager eventManagerWithSyncEngine:_syncEngine];
+  _eventManager = [FSTEventManager eventManagerWithSyncEngine:_syncEngine workerQueue:_workerQueue];
+  _eventManager.sharedQueryExecutionEnabled = settings.shared_query_execution_enabled();
+  [_eventManager setSnapshotBatchingExecutor:_snapshotBatchingExecutor];
 
   // Setup wiring for remote store.
   _remoteStore->set_sync_engine(_syncEngine);
 
   // NOTE: RemoteStore depends on LocalStore (for persisting stream tokens, refilling mutation
   // queue, etc.) so must be started after LocalStore.
-  [_localStore start];
+  BOOL deferMutationQueue = settings.lazy_local_store_start_enabled();
+  [_localStore startDeferringMutationQueue:deferMutationQueue];
   _remoteStore->Start();
+
+  if (deferMutationQueue) {
+    // Operations the user enqueued while initialization ran, such as the first listens, go first.
+    // Any of them that need the mutation queue start it themselves.
+    _workerQueue->EnqueueRelaxed([self] {
+      if (self->_isShutdown) return;
+      [self->_localStore finishStart];
+      LOG_DEBUG("Finished deferred start: %s", [self startupProfile].ToString());
+    });
+  } else {
+    LOG_DEBUG("Started: %s", [self startupProfile].ToString());
+  }
+}
+
+/** Combines the startup profiles of the persistence layer and the local store. */
+- (StartupProfile)startupProfile {
+  StartupProfile profile = _persistenceStartupProfile;
+  const StartupProfile &localStoreProfile = _localStore.startupProfile;
+  profile.mutation_queue_start_time = localStoreProfile.mutation_queue_start_time;
+  profile.local_store_start_time = localStoreProfile.local_store_start_time;
+  profile.mutation_queue_deferred = localStoreProfile.mutation_queue_deferred;
+  return profile;
+}
+
+- (void)startupProfileWithCallback:(std::function<void(StartupProfile)>)callback {
+  [self verifyNotShutdown];
+  _workerQueue->Enqueue([self, callback] {
+    // The deferred start, if any, was enqueued during initialization and so has already run.
+    StartupProfile profile = [self startupProfile];
+    self->_userExecutor->Execute([=] { callback(profile); });
+  });
+}
+
+- (void)preloadQueries:(std::vector<api::Query>)queries callback:(util::StatusCallback)callback {
+  [self verifyNotShutdown];
+  // Each query is read in an operation of its own, so that user operations enqueued meanwhile
+  // only ever wait for one of them.
+  for (const api::Query &query : queries) {
+    FSTQuery *localQuery = query.query();
+    _workerQueue->EnqueueBackground([self, localQuery] {
+      if (self->_isShutdown) {
+        return;
+      }
+      [self.localStore executeQuery:localQuery];
+    });
+  }
+  if (callback) {
+    _workerQueue->EnqueueBackground(
+        [self, callback] { self->_userExecutor->Execute([=] { callback(Status::OK()); }); });
+  }
+}
+
+- (void)handleBackgrounding {
+  _workerQueue->Enqueue([self] {
+    if (self->_isShutdown) {
+      return;
+    }
+    // The app may not get to run again before it's terminated.
+    [self.localStore persistPendingTargets];
+  });
+}
+
+- (void)handleMemoryPressure {
+  _workerQueue->Enqueue([self] {
+    if (self->_isShutdown) {
+      return;
+    }
+    [self.persistence trimMemoryToBudget:self->_memoryPressureBudgetBytes];
+    StringInterner::Shared().Clear();
+    FieldPathCache::Shared().Clear();
+
+    // Memory persistence collects garbage eagerly, so only LRU collection has anything left to do.
+    if (self->_lruDelegate) {
+      [self.localStore collectGarbage:self->_lruDelegate.gc];
+    }
+  });
+}
+
+- (void)pendingWritesWithCallback:(std::function<void(PendingWrites)>)callback {
+  [self verifyNotShutdown];
+  _workerQueue->Enqueue([self, callback] {
+    PendingWrites pending = [self.localStore pendingWrites];
+    self->_userExecutor->Execute([=] { callback(pending); });
+  });
+}
+
+- (void)setPendingWritesThreshold:(PendingWrites)threshold
+                         listener:(std::function<void(PendingWrites, bool)>)listener {
+  [self verifyNotShutdown];
+  _workerQueue->Enqueue([self, threshold, listener] {
+    self->_pendingWritesThresholdReached = NO;
+    if (!listener) {
+      [self.localStore setPendingWritesObserver:{}];
+      return;
+    }
+
+    auto observer = [self, threshold, listener](const PendingWrites &pending) {
+      BOOL reached = pending.Reaches(threshold);
+      if (reached != self->_pendingWritesThresholdReached) {
+        self->_pendingWritesThresholdReached = reached;
+        self->_userExecutor->Execute([=] { listener(pending, reached); });
+      }
+    };
+    // A backlog that has already reached the threshold is reported right away.
+    observer([self.localStore pendingWrites]);
+    [self.localStore setPendingWritesObserver:std::move(observer)];
+  });
 }
 
 /**
@@ -275,10 +479,41 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
  */
 - (void)scheduleLruGarbageCollection {
   std::chrono::milliseconds delay = _gcHasRun ? _regularGcDelay : _initialGcDelay;
-  _lruCallback = _workerQueue->EnqueueAfterDelay(delay, TimerId::GarbageCollectionDelay, [self]() {
-    [self->_localStore collectGarbage:self->_lruDelegate.gc];
-    self->_gcHasRun = true;
-    [self scheduleLruGarbageCollection];
+  _lruCallback = _workerQueue->EnqueueAfterDelay(delay, TimerId::GarbageCollectionDelay,
+                                                 [self]() { [self collectLruGarbageSlice]; });
+}
+
+- (void)scheduleTargetPersistence {
+  _targetPersistenceCallback = _workerQueue->EnqueueAfterDelay(
+      _targetPersistenceInterval, TimerId::TargetPersistence, [self] {
+        // Writing the targets can wait until any pending user operations have run.
+        self->_workerQueue->EnqueueBackground([self] {
+          if (self->_isShutdown) {
+            return;
+          }
+          [self.localStore persistPendingTargets];
+        });
+        [self scheduleTargetPersistence];
+      });
+}
+
+/**
+ * Runs the next slice of LRU garbage collection on the background lane of the worker queue, so
+ * that any pending user operations go first. Schedules the slice after that, or the next
+ * collection once this one is done.
+ */
+- (void)collectLruGarbageSlice {
+  _workerQueue->EnqueueBackground([self] {
+    if (self->_isShutdown) {
+      return;
+    }
+    LruResults results = [self->_localStore collectGarbageSlice:self->_lruDelegate.gc];
+    if (results.hasMoreSlices) {
+      [self collectLruGarbageSlice];
+    } else {
+      self->_gcHasRun = true;
+      [self scheduleLruGarbageCollection];
+    }
   });
 }
 
@@ -318,6 +553,8 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
       if (self->_lruCallback) {
         self->_lruCallback.Cancel();
       }
+      self->_targetPersistenceCallback.Cancel();
+      [self.localStore persistPendingTargets];
       _remoteStore->Shutdown();
       [self.persistence shutdown];
       self->_isShutdown = true;
@@ -339,14 +576,30 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
                                        listener:(ViewSnapshot::SharedListener &&)listener {
   auto query_listener = QueryListener::Create(query, std::move(options), std::move(listener));
 
-  _workerQueue->Enqueue([self, query_listener] { [self.eventManager addListener:query_listener]; });
+  _workerQueue->Enqueue("Listen",
+                        [self, query_listener] { [self.eventManager addListener:query_listener]; });
 
   return query_listener;
 }
 
 - (void)removeListener:(const std::shared_ptr<QueryListener> &)listener {
   [self verifyNotShutdown];
-  _workerQueue->Enqueue([self, listener] { [self.eventManager removeListener:listener]; });
+  _workerQueue->Enqueue("Unlisten",
+                        [self, listener] { [self.eventManager removeListener:listener]; });
+}
+
+/**
+ * Runs `block`, which only reads from the local store, in a snapshot read on the snapshot read
+ * queue if possible, so that it doesn't wait for the writes and remote events enqueued after it.
+ * Otherwise runs it right away. Must be called on the worker queue.
+ */
+- (void)readFromLocalStore:(absl::string_view)label block:(std::function<void()>)block {
+  if (_snapshotReadPersistence && [_snapshotReadPersistence runSnapshotRead:label
+                                                                    onQueue:_snapshotReadQueue
+                                                                      block:block]) {
+    return;
+  }
+  block();
 }
 
 - (void)getDocumentFromLocalCache:(const DocumentReference &)doc
@@ -355,82 +608,384 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
 
   // TODO(c++14): move `callback` into lambda.
   auto shared_callback = absl::ShareUniquePtr(std::move(callback));
-  _workerQueue->Enqueue([self, doc, shared_callback] {
-    FSTMaybeDocument *maybeDoc = [self.localStore readDocument:doc.key()];
-    StatusOr<DocumentSnapshot> maybe_snapshot;
+  _workerQueue->Enqueue("GetDocumentFromCache", [self, doc, shared_callback] {
+    [self readFromLocalStore:"GetDocumentFromCache"
+                       block:[self, doc, shared_callback] {
+                         FSTMaybeDocument *maybeDoc = [self.localStore readDocument:doc.key()];
+                         StatusOr<DocumentSnapshot> maybe_snapshot;
+
+                         if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
+                           FSTDocument *document = (FSTDocument *)maybeDoc;
+                           maybe_snapshot = DocumentSnapshot{
+                               doc.firestore(), doc.key(), document,
+                               /*from_cache=*/true,
+                               /*has_pending_writes=*/document.hasLocalMutations};
+                         } else if ([maybeDoc isKindOfClass:[FSTDeletedDocument class]]) {
+                           maybe_snapshot = DocumentSnapshot{doc.firestore(), doc.key(), nil,
+                                                             /*from_cache=*/true,
+                                                             /*has_pending_writes=*/false};
+                         } else {
+                           maybe_snapshot = Status{
+                               Error::Unavailable,
+                               "Failed to get document from cache. (However, this document may "
+                               "exist on the server. Run again without setting source to "
+                               "FirestoreSourceCache to attempt to retrieve the document "};
+                         }
+
+                         if (shared_callback) {
+                           self->_userExecutor->Execute(
+                               [=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
+                         }
+                       }];
+  });
+}
+
+- (void)getDocumentReferencesFromLocalCache:(const std::vector<DocumentReference> &)docs
+                                   callback:
+                                       (StatusOrCallback<std::vector<DocumentSnapshot>>)callback {
+  [self verifyNotShutdown];
+
+  _workerQueue->Enqueue("GetDocumentReferencesFromCache", [self, docs, callback] {
+    [self readFromLocalStore:"GetDocumentReferencesFromCache"
+                       block:[self, docs, callback] {
+                         StatusOr<std::vector<DocumentSnapshot>> result =
+                             [self snapshotsOfCachedDocuments:docs];
+                         if (callback) {
+                           self->_userExecutor->Execute([=] { callback(std::move(result)); });
+                         }
+                       }];
+  });
+}
+
+/**
+ * Reads the given documents from the local store in one go and turns them into snapshots, in the
+ * order of `docs`, failing if any of them isn't cached.
+ */
+- (StatusOr<std::vector<DocumentSnapshot>>)snapshotsOfCachedDocuments:
+    (const std::vector<DocumentReference> &)docs {
+  DocumentKeySet keys;
+  for (const DocumentReference &doc : docs) {
+    keys = keys.insert(doc.key());
+  }
+  MaybeDocumentMap maybeDocs = [self.localStore readDocuments:keys];
+
+  std::vector<DocumentSnapshot> snapshots;
+  snapshots.reserve(docs.size());
+  for (const DocumentReference &doc : docs) {
+    auto found = maybeDocs.find(doc.key());
+    FSTMaybeDocument *maybeDoc = found != maybeDocs.end() ? found->second : nil;
+    if ([maybeDoc isKindOfClass:[FSTDeletedDocument class]] &&
+        maybeDoc.version == SnapshotVersion::None()) {
+      // The batch read reports documents it doesn't have as deleted at version zero, like the ones
+      // deleted by a pending write, so only the single read can tell which of these it is.
+      maybeDoc = [self.localStore readDocument:doc.key()];
+    }
 
     if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
       FSTDocument *document = (FSTDocument *)maybeDoc;
-      maybe_snapshot = DocumentSnapshot{doc.firestore(), doc.key(), document,
-                                        /*from_cache=*/true,
-                                        /*has_pending_writes=*/document.hasLocalMutations};
+      snapshots.emplace_back(doc.firestore(), doc.key(), document, /*from_cache=*/true,
+                             /*has_pending_writes=*/document.hasLocalMutations);
     } else if ([maybeDoc isKindOfClass:[FSTDeletedDocument class]]) {
-      maybe_snapshot = DocumentSnapshot{doc.firestore(), doc.key(), nil,
-                                        /*from_cache=*/true,
-                                        /*has_pending_writes=*/false};
+      snapshots.emplace_back(doc.firestore(), doc.key(), nil, /*from_cache=*/true,
+                             /*has_pending_writes=*/false);
     } else {
-      maybe_snapshot =
-          Status{Error::Unavailable, "Failed to get document from cache. (However, this document "
-                                     "may exist on the server. Run again without setting source to "
-                                     "FirestoreSourceCache to attempt to retrieve the document "};
+      return Status{Error::Unavailable,
+                    "Failed to get documents from cache. (However, these documents may exist on "
+                    "the server. Run again without setting source to FirestoreSourceCache to "
+                    "attempt to retrieve them.)"};
     }
+  }
+  return snapshots;
+}
+
+- (void)getDocumentsFromLocalCache:(const api::Query &)query
+                          callback:(api::QuerySnapshot::Listener &&)callback {
+  [self verifyNotShutdown];
 
-    if (shared_callback) {
-      self->_userExecutor->Execute([=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
+  // TODO(c++14): move `callback` into lambda.
+  auto shared_callback = absl::ShareUniquePtr(std::move(callback));
+  _workerQueue->Enqueue("GetDocumentsFromCache", [self, query, shared_callback] {
+    auto execute = [self, query, shared_callback] {
+      QueryProfile profile;
+      api::QuerySnapshot result = [self executeQueryFromLocalCache:query profile:&profile];
+
+      if (shared_callback) {
+        self->_userExecutor->Execute([=] { shared_callback->OnEvent(std::move(result)); });
+      }
+    };
+    if ([self.localStore canExecuteQueryInSnapshot:query.query()]) {
+      [self readFromLocalStore:"GetDocumentsFromCache" block:execute];
+    } else {
+      execute();
     }
   });
 }
 
-- (void)getDocumentsFromLocalCache:(const api::Query &)query
-                          callback:(api::QuerySnapshot::Listener &&)callback {
+- (void)getDocumentsFromServer:(const api::Query &)query
+                  cacheResults:(BOOL)cacheResults
+                      callback:(api::QuerySnapshot::Listener &&)callback {
   [self verifyNotShutdown];
 
   // TODO(c++14): move `callback` into lambda.
   auto shared_callback = absl::ShareUniquePtr(std::move(callback));
-  _workerQueue->Enqueue([self, query, shared_callback] {
-    DocumentMap docs = [self.localStore executeQuery:query.query()];
+  _workerQueue->Enqueue("GetDocumentsFromServer", [self, query, cacheResults, shared_callback] {
+    self->_datastore->RunQuery(
+        query.query(), [self, query, cacheResults, shared_callback](
+                           const std::vector<FSTDocument *> &documents, const Status &status) {
+          if (!shared_callback) {
+            return;
+          }
+          if (!status.ok()) {
+            self->_userExecutor->Execute([=] { shared_callback->OnEvent(status); });
+            return;
+          }
+          api::QuerySnapshot result = [self snapshotOfServerResults:documents
+                                                           forQuery:query
+                                                       cacheResults:cacheResults];
+          self->_userExecutor->Execute([=] { shared_callback->OnEvent(std::move(result)); });
+        });
+  });
+}
 
-    FSTView *view = [[FSTView alloc] initWithQuery:query.query() remoteDocuments:DocumentKeySet{}];
-    FSTViewDocumentChanges *viewDocChanges =
-        [view computeChangesWithDocuments:docs.underlying_map()];
-    FSTViewChange *viewChange = [view applyChangesToDocuments:viewDocChanges];
-    HARD_ASSERT(viewChange.limboChanges.count == 0,
-                "View returned limbo documents during local-only query execution.");
-    HARD_ASSERT(viewChange.snapshot.has_value(), "Expected a snapshot");
+/** Turns the results of a query run once on the backend into a snapshot, caching them if asked. */
+- (api::QuerySnapshot)snapshotOfServerResults:(const std::vector<FSTDocument *> &)documents
+                                     forQuery:(const api::Query &)query
+                                 cacheResults:(BOOL)cacheResults {
+  MaybeDocumentMap docs;
+  DocumentKeySet keys;
+  for (FSTDocument *doc : documents) {
+    docs = docs.insert(doc.key, doc);
+    keys = keys.insert(doc.key);
+  }
 
-    ViewSnapshot snapshot = std::move(viewChange.snapshot).value();
-    SnapshotMetadata metadata(snapshot.has_pending_writes(), snapshot.from_cache());
+  if (cacheResults) {
+    // The results don't belong to a target, so the local store only keeps the ones that are newer
+    // than what it has, and the remote snapshot version is left alone.
+    RemoteEvent::DocumentUpdates updates;
+    for (FSTDocument *doc : documents) {
+      updates[doc.key] = doc;
+    }
+    RemoteEvent event{SnapshotVersion::None(), /*target_changes=*/{}, /*target_mismatches=*/{},
+                      std::move(updates), /*limbo_document_changes=*/{}};
+    [self.syncEngine applyRemoteEvent:event];
 
-    api::QuerySnapshot result(query.firestore(), query.query(), std::move(snapshot),
-                              std::move(metadata));
+    // Read the results back to apply the pending writes to them.
+    docs = [self.localStore readDocuments:keys];
+  }
 
-    if (shared_callback) {
-      self->_userExecutor->Execute([=] { shared_callback->OnEvent(std::move(result)); });
+  // Every result is known to the backend, so none of them is in limbo and the view is current.
+  FSTView *view = [[FSTView alloc] initWithQuery:query.query() remoteDocuments:keys];
+  FSTViewDocumentChanges *viewDocChanges = [view computeChangesWithDocuments:docs];
+  TargetChange markCurrent{[NSData data], /*current=*/true, DocumentKeySet{}, DocumentKeySet{},
+                           DocumentKeySet{}};
+  FSTViewChange *viewChange = [view applyChangesToDocuments:viewDocChanges
+                                               targetChange:markCurrent];
+  HARD_ASSERT(viewChange.snapshot.has_value(), "Expected a snapshot");
+
+  ViewSnapshot snapshot = std::move(viewChange.snapshot).value();
+  SnapshotMetadata metadata(snapshot.has_pending_writes(), snapshot.from_cache());
+  return api::QuerySnapshot(query.firestore(), query.query(), std::move(snapshot),
+                            std::move(metadata));
+}
+
+- (void)getDocumentReferencesFromServer:(const std::vector<DocumentReference> &)docs
+                           cacheResults:(BOOL)cacheResults
+                               callback:
+                                   (StatusOrCallback<std::vector<DocumentSnapshot>>)callback {
+  [self verifyNotShutdown];
+
+  _workerQueue->Enqueue("GetDocumentReferencesFromServer", [self, docs, cacheResults, callback] {
+    // Each document is only looked up once, however many times it's referred to.
+    DocumentKeySet uniqueKeys;
+    for (const DocumentReference &doc : docs) {
+      uniqueKeys = uniqueKeys.insert(doc.key());
     }
+    std::vector<DocumentKey> keys{uniqueKeys.begin(), uniqueKeys.end()};
+
+    self->_datastore->LookupDocuments(
+        keys, [self, docs, cacheResults, callback](const std::vector<FSTMaybeDocument *> &documents,
+                                                   const Status &status) {
+          if (!callback) {
+            return;
+          }
+          if (!status.ok()) {
+            self->_userExecutor->Execute([=] { callback(status); });
+            return;
+          }
+          std::vector<DocumentSnapshot> result = [self snapshotsOfServerDocuments:documents
+                                                                     forReferences:docs
+                                                                      cacheResults:cacheResults];
+          self->_userExecutor->Execute([=] { callback(std::move(result)); });
+        });
   });
 }
 
+/**
+ * Turns the documents looked up once on the backend into snapshots, in the order of `docs`, caching
+ * them if asked.
+ */
+- (std::vector<DocumentSnapshot>)
+    snapshotsOfServerDocuments:(const std::vector<FSTMaybeDocument *> &)documents
+                 forReferences:(const std::vector<DocumentReference> &)docs
+                  cacheResults:(BOOL)cacheResults {
+  MaybeDocumentMap maybeDocs;
+  DocumentKeySet keys;
+  for (FSTMaybeDocument *doc : documents) {
+    maybeDocs = maybeDocs.insert(doc.key, doc);
+    keys = keys.insert(doc.key);
+  }
+
+  if (cacheResults) {
+    // As for queries run once, the local store only keeps the results that are newer than what it
+    // has. Reading them back applies the pending writes to them.
+    RemoteEvent::DocumentUpdates updates;
+    for (FSTMaybeDocument *doc : documents) {
+      updates[doc.key] = doc;
+    }
+    RemoteEvent event{SnapshotVersion::None(), /*target_changes=*/{}, /*target_mismatches=*/{},
+                      std::move(updates), /*limbo_document_changes=*/{}};
+    [self.syncEngine applyRemoteEvent:event];
+    maybeDocs = [self.localStore readDocuments:keys];
+  }
+
+  std::vector<DocumentSnapshot> snapshots;
+  snapshots.reserve(docs.size());
+  for (const DocumentReference &doc : docs) {
+    auto found = maybeDocs.find(doc.key());
+    FSTMaybeDocument *maybeDoc = found != maybeDocs.end() ? found->second : nil;
+    if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
+      FSTDocument *document = (FSTDocument *)maybeDoc;
+      snapshots.emplace_back(doc.firestore(), doc.key(), document, /*from_cache=*/false,
+                             /*has_pending_writes=*/document.hasLocalMutations);
+    } else {
+      snapshots.emplace_back(doc.firestore(), doc.key(), nil, /*from_cache=*/false,
+                             /*has_pending_writes=*/false);
+    }
+  }
+  return snapshots;
+}
+
+- (void)profileDocumentsFromLocalCache:(const api::Query &)query
+                              callback:(api::Query::ProfileListener &&)callback {
+  [self verifyNotShutdown];
+
+  // TODO(c++14): move `callback` into lambda.
+  auto shared_callback = std::make_shared<api::Query::ProfileListener>(std::move(callback));
+  _workerQueue->Enqueue([self, query, shared_callback] {
+    QueryProfile profile;
+    api::QuerySnapshot result = [self executeQueryFromLocalCache:query profile:&profile];
+
+    if (*shared_callback) {
+      self->_userExecutor->Execute(
+          [=] { (*shared_callback)(std::move(result), std::move(profile)); });
+    }
+  });
+}
+
+- (void)getDocumentsPageFromLocalCache:(const api::Query &)query
+                            startAfter:(const absl::optional<DocumentKey> &)startAfter
+                              pageSize:(size_t)pageSize
+                              callback:(std::function<void(DocumentMap)>)callback {
+  [self verifyNotShutdown];
+  _workerQueue->Enqueue([self, query, startAfter, pageSize, callback] {
+    QueryProfile profile;
+    DocumentMap docs;
+    {
+      QueryProfileScope scope(&profile);
+      docs = [self.localStore executeQuery:query.query() startAfter:startAfter pageSize:pageSize];
+    }
+    self->_queryProfileTotals.Add(profile);
+
+    if (callback) {
+      self->_userExecutor->Execute([=] { callback(docs); });
+    }
+  });
+}
+
+- (QueryProfile)aggregateQueryProfile {
+  return _queryProfileTotals.Get();
+}
+
+/**
+ * Runs the given query against the local cache, recording the work it took into `profile` and
+ * the aggregate totals. Must be called on the worker queue.
+ */
+- (api::QuerySnapshot)executeQueryFromLocalCache:(const api::Query &)query
+                                         profile:(QueryProfile *)profile {
+  using Clock = std::chrono::steady_clock;
+
+  DocumentMap docs;
+  {
+    QueryProfileScope scope(profile);
+    docs = [self.localStore executeQuery:query.query()];
+  }
+
+  Clock::time_point viewStart = Clock::now();
+  FSTView *view = [[FSTView alloc] initWithQuery:query.query() remoteDocuments:DocumentKeySet{}];
+  FSTViewDocumentChanges *viewDocChanges = [view computeChangesWithDocuments:docs.underlying_map()];
+  FSTViewChange *viewChange = [view applyChangesToDocuments:viewDocChanges];
+  HARD_ASSERT(viewChange.limboChanges.count == 0,
+              "View returned limbo documents during local-only query execution.");
+  HARD_ASSERT(viewChange.snapshot.has_value(), "Expected a snapshot");
+  profile->view_diff_time +=
+      std::chrono::duration_cast<QueryProfile::Duration>(Clock::now() - viewStart);
+  _queryProfileTotals.Add(*profile);
+
+  ViewSnapshot snapshot = std::move(viewChange.snapshot).value();
+  SnapshotMetadata metadata(snapshot.has_pending_writes(), snapshot.from_cache());
+
+  return api::QuerySnapshot(query.firestore(), query.query(), std::move(snapshot),
+                            std::move(metadata));
+}
+
 - (void)writeMutations:(std::vector<FSTMutation *> &&)mutations
               callback:(util::StatusCallback)callback {
   // TODO(c++14): move `mutations` into lambda (C++14).
-  _workerQueue->Enqueue([self, mutations, callback]() mutable {
+  _workerQueue->Enqueue("WriteMutations", [self, mutations, callback]() mutable {
     [self verifyNotShutdown];
-    if (mutations.empty()) {
+    [self writeMutationsOnWorkerQueue:std::move(mutations) callback:callback];
+  });
+};
+
+- (void)writeMutationsFromBlock:(std::function<std::vector<FSTMutation *>()>)block
+                       callback:(util::StatusCallback)callback {
+  _workerQueue->Enqueue("WriteMutations", [self, block, callback] {
+    [self verifyNotShutdown];
+    std::vector<FSTMutation *> mutations;
+    @try {
+      mutations = block();
+    } @catch (NSException *exception) {
+      // Only invalid user data is reported to the callback; anything else is a bug.
+      if (![exception.name isEqualToString:@"FIRInvalidArgumentException"]) {
+        @throw;  // NOLINT
+      }
       if (callback) {
-        self->_userExecutor->Execute([=] { callback(Status::OK()); });
+        Status status{Error::InvalidArgument, util::MakeString(exception.reason)};
+        self->_userExecutor->Execute([=] { callback(status); });
       }
-    } else {
-      [self.syncEngine
-          writeMutations:std::move(mutations)
-              completion:^(NSError *error) {
-                // Dispatch the result back onto the user dispatch queue.
-                if (callback) {
-                  self->_userExecutor->Execute([=] { callback(Status::FromNSError(error)); });
-                }
-              }];
+      return;
     }
+    [self writeMutationsOnWorkerQueue:std::move(mutations) callback:callback];
   });
-};
+}
+
+- (void)writeMutationsOnWorkerQueue:(std::vector<FSTMutation *> &&)mutations
+                           callback:(const util::StatusCallback &)callback {
+  if (mutations.empty()) {
+    if (callback) {
+      _userExecutor->Execute([=] { callback(Status::OK()); });
+    }
+  } else {
+    [self.syncEngine writeMutations:std::move(mutations)
+                         completion:^(NSError *error) {
+                           // Dispatch the result back onto the user dispatch queue.
+                           if (callback) {
+                             self->_userExecutor->Execute(
+                                 [=] { callback(Status::FromNSError(error)); });
+                           }
+                         }];
+  }
+}
 
 - (void)transactionWithRetries:(int)retries
                 updateCallback:(core::TransactionUpdateCallback)update_callback
@@ -443,7 +998,7 @@ static const std::chrono::milliseconds FSTLruGcRegularDelay = std::chrono::minut
     }
   };
 
-  _workerQueue->Enqueue([self, retries, update_callback, async_callback] {
+  _workerQueue->Enqueue("Transaction", [self, retries, update_callback, async_callback] {
     [self.syncEngine transactionWithRetries:retries
                                 workerQueue:_workerQueue
                              updateCallback:std::move(update_callback)
@@ -152,6 +152,9 @@ NS_ASSUME_NONNULL_BEGIN
 /** Returns the first field in an order-by constraint, or nullptr if none. */
 - (nullable const model::FieldPath *)firstSortOrderField;
 
+/** The underlying C++ query. */
+- (const core::Query &)query;
+
 /** The base path of the query. */
 - (const model::ResourcePath &)path;
 
@@ -170,6 +173,9 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, strong, readonly) NSString *canonicalID;
 
+/** The canonicalID as a UTF-8 string, the way the local cache indexes queries. */
+@property(nonatomic, readonly) const std::string &canonicalIDString;
+
 /** An optional bound to start the query at. */
 - (const std::shared_ptr<core::Bound> &)startAt;
 
@@ -16,8 +16,10 @@
 
 #import "Firestore/Source/Core/FSTQuery.h"
 
+#include <atomic>
 #include <limits>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <utility>
 #include <vector>
@@ -33,6 +35,7 @@
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
 #include "Firestore/core/src/firebase/firestore/core/order_by.h"
 #include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/core/query_matcher.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
@@ -44,6 +47,8 @@
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "absl/algorithm/container.h"
+#include "absl/memory/memory.h"
+#include "absl/types/optional.h"
 
 namespace core = firebase::firestore::core;
 namespace objc = firebase::firestore::objc;
@@ -54,6 +59,7 @@ using firebase::firestore::core::Direction;
 using firebase::firestore::core::Filter;
 using firebase::firestore::core::OrderBy;
 using firebase::firestore::core::Query;
+using firebase::firestore::core::QueryMatcher;
 using firebase::firestore::model::Document;
 using firebase::firestore::model::DocumentComparator;
 using firebase::firestore::model::DocumentKey;
@@ -64,14 +70,38 @@ using firebase::firestore::util::ComparisonResult;
 
 NS_ASSUME_NONNULL_BEGIN
 
+namespace {
+
+/** Identifies the sort orders of each comparator to the sort keys documents cache. */
+std::atomic<uint64_t> nextSortKeyID{1};
+
+/** What a comparator needs to know about the sort orders of its query. */
+struct SortOrdersInfo {
+  Query::OrderByList sortOrders;
+
+  // The fields of the sort orders other than the key, which make up the sort key of a document.
+  std::vector<FieldPath> sortKeyFields;
+  uint64_t sortKeyID = 0;
+};
+
+}  // namespace
+
 #pragma mark - FSTQuery
 
 @interface FSTQuery () {
-  // Cached value of the canonicalID property.
+  // Cached values of the canonicalID and canonicalIDString properties.
   NSString *_canonicalID;
+  std::string _canonicalIDString;
 
   // The C++ implementation of this query to which FSTQuery delegates.
   Query _query;
+
+  // Lazily compiled form of _query, reused by every call to matchesDocument:.
+  std::unique_ptr<QueryMatcher> _matcher;
+
+  // Lazily created on the first call to comparator, which may come from any thread.
+  std::once_flag _comparatorOnce;
+  absl::optional<DocumentComparator> _comparator;
 }
 
 @end
@@ -184,26 +214,57 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (BOOL)matchesDocument:(FSTDocument *)document {
+  if (!_matcher) {
+    _matcher = absl::make_unique<QueryMatcher>(_query);
+  }
   Document converted(document);
-  return _query.Matches(converted);
+  return _matcher->Matches(converted);
 }
 
 - (DocumentComparator)comparator {
-  Query::OrderByList sortOrders = self.sortOrders;
-
-  return DocumentComparator([sortOrders](FSTDocument *document1, FSTDocument *document2) {
-    bool didCompareOnKeyField = false;
-    Document convertedDoc1(document1);
-    Document converetdDoc2(document2);
-    for (const OrderBy &orderBy : sortOrders) {
-      ComparisonResult comp = orderBy.Compare(convertedDoc1, converetdDoc2);
-      if (!util::Same(comp)) return comp;
-
-      didCompareOnKeyField = didCompareOnKeyField || orderBy.field() == FieldPath::KeyFieldPath();
+  std::call_once(_comparatorOnce, [self] {
+    auto info = std::make_shared<SortOrdersInfo>();
+    info->sortOrders = self.sortOrders;
+    for (const OrderBy &orderBy : info->sortOrders) {
+      if (!orderBy.field().IsKeyFieldPath()) {
+        info->sortKeyFields.push_back(orderBy.field());
+      }
     }
-    HARD_ASSERT(didCompareOnKeyField, "sortOrder of query did not include key ordering");
-    return ComparisonResult::Same;
+    info->sortKeyID = nextSortKeyID++;
+
+    self->_comparator = DocumentComparator([info](FSTDocument *document1, FSTDocument *document2) {
+      // Documents only ordered by key need no sort key.
+      std::shared_ptr<const FSTDocumentSortKey> sortKey1;
+      std::shared_ptr<const FSTDocumentSortKey> sortKey2;
+      if (!info->sortKeyFields.empty()) {
+        sortKey1 = [document1 sortKeyForFields:info->sortKeyFields sortKeyID:info->sortKeyID];
+        sortKey2 = [document2 sortKeyForFields:info->sortKeyFields sortKeyID:info->sortKeyID];
+      }
+
+      bool didCompareOnKeyField = false;
+      size_t fieldIndex = 0;
+      for (const OrderBy &orderBy : info->sortOrders) {
+        ComparisonResult comp;
+        if (orderBy.field().IsKeyFieldPath()) {
+          comp = document1.key.CompareTo(document2.key);
+          didCompareOnKeyField = true;
+        } else {
+          const absl::optional<FieldValue> &value1 = (*sortKey1)[fieldIndex];
+          const absl::optional<FieldValue> &value2 = (*sortKey2)[fieldIndex];
+          ++fieldIndex;
+          HARD_ASSERT(value1.has_value() && value2.has_value(),
+                      "Trying to compare documents on fields that don't exist.");
+          comp = value1->CompareTo(*value2);
+        }
+
+        comp = orderBy.direction().ApplyTo(comp);
+        if (!util::Same(comp)) return comp;
+      }
+      HARD_ASSERT(didCompareOnKeyField, "sortOrder of query did not include key ordering");
+      return ComparisonResult::Same;
+    });
   });
+  return *_comparator;
 }
 
 - (nullable const FieldPath *)inequalityFilterField {
@@ -218,6 +279,10 @@ NS_ASSUME_NONNULL_BEGIN
   return _query.FirstOrderByField();
 }
 
+- (const Query &)query {
+  return _query;
+}
+
 /** The base path of the query. */
 - (const ResourcePath &)path {
   return _query.path();
@@ -266,10 +331,16 @@ NS_ASSUME_NONNULL_BEGIN
     [canonicalID appendFormat:@"|ub:%s", self.endAt->CanonicalId().c_str()];
   }
 
+  _canonicalIDString = util::MakeString(canonicalID);
   _canonicalID = canonicalID;
   return canonicalID;
 }
 
+- (const std::string &)canonicalIDString {
+  [self canonicalID];
+  return _canonicalIDString;
+}
+
 #pragma mark - Private methods
 
 - (BOOL)isEqualToQuery:(FSTQuery *)other {
@@ -78,6 +78,32 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, weak) id<FSTSyncEngineDelegate> syncEngineDelegate;
 
+/**
+ * The number of documents past the limit that views of limit queries keep, so that they can
+ * replace documents dropping out of them without re-running the query. Only affects views created
+ * after it is set.
+ */
+@property(nonatomic, assign) int32_t limitPrefetchSize;
+
+/**
+ * How many documents in limbo are resolved at a time, each with its own listen. Documents that go
+ * into limbo while that many resolutions are active wait in line, in the order they went into
+ * limbo. Zero or less resolves all of them at once.
+ */
+@property(nonatomic, assign) int32_t maxConcurrentLimboResolutions;
+
+/**
+ * Whether view changes are computed concurrently across views when many queries are active.
+ * Refills and everything that touches sync engine state still happen serially, in view order.
+ */
+@property(nonatomic, assign) BOOL parallelViewComputationEnabled;
+
+/**
+ * Whether a retried transaction starts fetching the documents the failed attempt read before the
+ * update block runs again, instead of waiting for the update block to look each of them up.
+ */
+@property(nonatomic, assign, getter=isTransactionPrefetchEnabled) BOOL transactionPrefetchEnabled;
+
 /**
  * Initiates a new listen. The FSTLocalStore will be queried for initial data and the listen will
  * be sent to the `RemoteStore` to get remote data. The registered FSTSyncEngineDelegate will be
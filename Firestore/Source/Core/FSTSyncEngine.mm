@@ -16,6 +16,7 @@
 
 #import "Firestore/Source/Core/FSTSyncEngine.h"
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <set>
@@ -33,6 +34,7 @@
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/query_routing_index.h"
 #include "Firestore/core/src/firebase/firestore/core/target_id_generator.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
@@ -42,17 +44,20 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
 #include "absl/types/optional.h"
 
 using firebase::firestore::Error;
 using firebase::firestore::auth::HashUser;
 using firebase::firestore::auth::User;
+using firebase::firestore::core::QueryRoutingIndex;
 using firebase::firestore::core::TargetIdGenerator;
 using firebase::firestore::core::Transaction;
 using firebase::firestore::core::ViewSnapshot;
@@ -63,6 +68,7 @@ using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
+using firebase::firestore::model::kBatchIdUnknown;
 using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::OnlineState;
@@ -82,6 +88,9 @@ NS_ASSUME_NONNULL_BEGIN
 // real sequence numbers.
 static const ListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
+// Below this many views, handing view computation to other threads costs more than it saves.
+static const size_t kMinViewsForParallelComputation = 4;
+
 #pragma mark - FSTQueryView
 
 /**
@@ -184,6 +193,9 @@ class LimboResolution {
   /** FSTQueryViews for all active queries, indexed by target ID. */
   std::unordered_map<TargetId, FSTQueryView *> _queryViewsByTarget;
 
+  /** The target IDs of all active queries, indexed by the locations their queries read from. */
+  QueryRoutingIndex _queryRoutingIndex;
+
   /**
    * When a document is in limbo, we create a special listen to resolve it. This maps the
    * DocumentKey of each limbo document to the TargetId of the listen resolving it.
@@ -196,6 +208,16 @@ class LimboResolution {
    */
   std::map<TargetId, LimboResolution> _limboResolutionsByTarget;
 
+  /**
+   * The documents in limbo that are waiting for a resolution to start, because
+   * `maxConcurrentLimboResolutions` resolutions are already active, in the order they went into
+   * limbo. Documents that got out of limbo while waiting are skipped when their turn comes.
+   */
+  std::deque<DocumentKey> _enqueuedLimboResolutions;
+
+  /** The documents in `_enqueuedLimboResolutions` that are still in limbo. */
+  std::set<DocumentKey> _enqueuedLimboKeys;
+
   User _currentUser;
 
   /** Used to track any documents that are currently in limbo. */
@@ -230,11 +252,12 @@ class LimboResolution {
 }
 
 - (ViewSnapshot)initializeViewAndComputeSnapshotForQueryData:(FSTQueryData *)queryData {
-  DocumentMap docs = [self.localStore executeQuery:queryData.query];
   DocumentKeySet remoteKeys = [self.localStore remoteDocumentKeysForTarget:queryData.targetID];
 
   FSTView *view = [[FSTView alloc] initWithQuery:queryData.query
-                                 remoteDocuments:std::move(remoteKeys)];
+                                 remoteDocuments:std::move(remoteKeys)
+                                    prefetchSize:self.limitPrefetchSize];
+  DocumentMap docs = [self.localStore executeQuery:view.fillQuery];
   FSTViewDocumentChanges *viewDocChanges = [view computeChangesWithDocuments:docs.underlying_map()];
   FSTViewChange *viewChange = [view applyChangesToDocuments:viewDocChanges];
   HARD_ASSERT(viewChange.limboChanges.count == 0,
@@ -246,6 +269,7 @@ class LimboResolution {
                                                            view:view];
   self.queryViewsByQuery[queryData.query] = queryView;
   _queryViewsByTarget[queryData.targetID] = queryView;
+  _queryRoutingIndex.AddQuery(queryData.query.query, queryData.targetID);
 
   HARD_ASSERT(viewChange.snapshot.has_value(),
               "applyChangesToDocuments for new view should always return a snapshot");
@@ -268,6 +292,10 @@ class LimboResolution {
   [self assertDelegateExistsForSelector:_cmd];
 
   LocalWriteResult result = [self.localStore locallyWriteMutations:std::move(mutations)];
+  if (result.merged_batch_id() != kBatchIdUnknown) {
+    completion = [self completionBlock:completion
+                 afterBlockOfMergedBatchID:result.merged_batch_id()];
+  }
   [self addMutationCompletionBlock:completion batchID:result.batch_id()];
 
   [self emitNewSnapshotsAndNotifyLocalStoreWithChanges:result.changes() remoteEvent:absl::nullopt];
@@ -284,6 +312,26 @@ class LimboResolution {
   [completionBlocks setObject:completion forKey:@(batchID)];
 }
 
+/**
+ * Returns a block that calls the completion block of a batch that the local store merged into a
+ * new one, if it had one, and then `completion`, so that both run when the new batch completes.
+ */
+- (FSTVoidErrorBlock)completionBlock:(FSTVoidErrorBlock)completion
+           afterBlockOfMergedBatchID:(BatchId)mergedBatchID {
+  NSMutableDictionary<NSNumber *, FSTVoidErrorBlock> *completionBlocks =
+      _mutationCompletionBlocks[_currentUser];
+  FSTVoidErrorBlock mergedCompletion = completionBlocks[@(mergedBatchID)];
+  if (!mergedCompletion) {
+    return completion;
+  }
+
+  [completionBlocks removeObjectForKey:@(mergedBatchID)];
+  return ^(NSError *_Nullable error) {
+    mergedCompletion(error);
+    completion(error);
+  };
+}
+
 /**
  * Takes an updateCallback in which a set of reads and writes can be performed atomically. In the
  * updateCallback, user code can read and write values using a transaction object. After the
@@ -300,10 +348,31 @@ class LimboResolution {
                    workerQueue:(const std::shared_ptr<AsyncQueue> &)workerQueue
                 updateCallback:(core::TransactionUpdateCallback)updateCallback
                 resultCallback:(core::TransactionResultCallback)resultCallback {
+  [self transactionWithRetries:retries
+                   workerQueue:workerQueue
+                  prefetchKeys:{}
+                updateCallback:std::move(updateCallback)
+                resultCallback:std::move(resultCallback)];
+}
+
+/**
+ * Runs the transaction like `transactionWithRetries:workerQueue:updateCallback:resultCallback:`,
+ * first prefetching the given documents if transaction prefetching is enabled.
+ */
+- (void)transactionWithRetries:(int)retries
+                   workerQueue:(const std::shared_ptr<AsyncQueue> &)workerQueue
+                  prefetchKeys:(const std::vector<DocumentKey> &)prefetchKeys
+                updateCallback:(core::TransactionUpdateCallback)updateCallback
+                resultCallback:(core::TransactionResultCallback)resultCallback {
   workerQueue->VerifyIsCurrentQueue();
   HARD_ASSERT(retries >= 0, "Got negative number of retries for transaction");
 
   std::shared_ptr<Transaction> transaction = _remoteStore->CreateTransaction();
+  if (self.isTransactionPrefetchEnabled) {
+    // A retry most likely reads what the failed attempt read, so start reading it right away
+    // rather than one round trip at a time as the update block asks for it.
+    transaction->Prefetch(prefetchKeys);
+  }
   updateCallback(transaction, [=](util::StatusOr<absl::any> maybe_result) {
     workerQueue->Enqueue(
         [self, retries, workerQueue, updateCallback, resultCallback, transaction, maybe_result] {
@@ -312,6 +381,7 @@ class LimboResolution {
                 !transaction->IsPermanentlyFailed()) {
               return [self transactionWithRetries:(retries - 1)
                                       workerQueue:workerQueue
+                                     prefetchKeys:transaction->read_keys()
                                    updateCallback:updateCallback
                                    resultCallback:resultCallback];
             } else {
@@ -330,6 +400,7 @@ class LimboResolution {
                 workerQueue->VerifyIsCurrentQueue();
                 return [self transactionWithRetries:(retries - 1)
                                         workerQueue:workerQueue
+                                       prefetchKeys:transaction->read_keys()
                                      updateCallback:updateCallback
                                      resultCallback:resultCallback];
               }
@@ -341,6 +412,7 @@ class LimboResolution {
 }
 
 - (void)applyRemoteEvent:(const RemoteEvent &)remoteEvent {
+  FIRESTORE_TRACE_SPAN("-[FSTSyncEngine applyRemoteEvent:]");
   [self assertDelegateExistsForSelector:_cmd];
 
   // Update `receivedDocument` as appropriate for any limbo targets.
@@ -415,6 +487,7 @@ class LimboResolution {
     RemoteEvent event{SnapshotVersion::None(), /*target_changes=*/{}, /*target_mismatches=*/{},
                       /*document_updates=*/{{limboKey, doc}}, std::move(limboDocuments)};
     [self applyRemoteEvent:event];
+    [self pumpEnqueuedLimboResolutions];
   } else {
     auto found = _queryViewsByTarget.find(targetID);
     HARD_ASSERT(found != _queryViewsByTarget.end(), "Unknown targetId: %s", targetID);
@@ -442,6 +515,18 @@ class LimboResolution {
   [self emitNewSnapshotsAndNotifyLocalStoreWithChanges:changes remoteEvent:absl::nullopt];
 }
 
+- (void)applySuccessfulWritesWithResults:
+    (const std::vector<FSTMutationBatchResult *> &)batchResults {
+  [self assertDelegateExistsForSelector:_cmd];
+
+  for (FSTMutationBatchResult *batchResult : batchResults) {
+    [self processUserCallbacksForBatchID:batchResult.batch.batchID error:nil];
+  }
+
+  MaybeDocumentMap changes = [self.localStore acknowledgeBatchesWithResults:batchResults];
+  [self emitNewSnapshotsAndNotifyLocalStoreWithChanges:changes remoteEvent:absl::nullopt];
+}
+
 - (void)rejectFailedWriteWithBatchID:(BatchId)batchID error:(NSError *)error {
   [self assertDelegateExistsForSelector:_cmd];
   MaybeDocumentMap changes = [self.localStore rejectBatchID:batchID];
@@ -483,6 +568,7 @@ class LimboResolution {
 - (void)removeAndCleanupQuery:(FSTQueryView *)queryView {
   [self.queryViewsByQuery removeObjectForKey:queryView.query];
   _queryViewsByTarget.erase(queryView.targetID);
+  _queryRoutingIndex.RemoveQuery(queryView.query.query, queryView.targetID);
 
   DocumentKeySet limboKeys = _limboDocumentRefs.ReferencedKeys(queryView.targetID);
   _limboDocumentRefs.RemoveReferences(queryView.targetID);
@@ -500,48 +586,104 @@ class LimboResolution {
 - (void)emitNewSnapshotsAndNotifyLocalStoreWithChanges:(const MaybeDocumentMap &)changes
                                            remoteEvent:(const absl::optional<RemoteEvent> &)
                                                            maybeRemoteEvent {
-  __block std::vector<ViewSnapshot> newSnapshots;
-  __block std::vector<LocalViewChanges> documentChangesInAllViews;
-
-  [self.queryViewsByQuery
-      enumerateKeysAndObjectsUsingBlock:^(FSTQuery *query, FSTQueryView *queryView, BOOL *stop) {
-        FSTView *view = queryView.view;
-        FSTViewDocumentChanges *viewDocChanges = [view computeChangesWithDocuments:changes];
-        if (viewDocChanges.needsRefill) {
-          // The query has a limit and some docs were removed/updated, so we need to re-run the
-          // query against the local store to make sure we didn't lose any good docs that had been
-          // past the limit.
-          DocumentMap docs = [self.localStore executeQuery:queryView.query];
-          viewDocChanges = [view computeChangesWithDocuments:docs.underlying_map()
-                                             previousChanges:viewDocChanges];
-        }
-
-        absl::optional<TargetChange> targetChange;
-        if (maybeRemoteEvent.has_value()) {
-          const RemoteEvent &remoteEvent = maybeRemoteEvent.value();
-          auto it = remoteEvent.target_changes().find(queryView.targetID);
-          if (it != remoteEvent.target_changes().end()) {
-            targetChange = it->second;
-          }
-        }
-        FSTViewChange *viewChange = [queryView.view applyChangesToDocuments:viewDocChanges
-                                                               targetChange:targetChange];
-
-        [self updateTrackedLimboDocumentsWithChanges:viewChange.limboChanges
-                                            targetID:queryView.targetID];
+  NSArray<FSTQueryView *> *queryViews = self.queryViewsByQuery.allValues;
+  const size_t viewCount = queryViews.count;
+
+  // Offer each view only the changed documents its query could contain, rather than having every
+  // view match every document.
+  std::unordered_map<TargetId, MaybeDocumentMap> changesByTarget;
+  for (const auto &kv : changes) {
+    _queryRoutingIndex.ForEachTarget(kv.first, [&](TargetId targetID) {
+      MaybeDocumentMap &targetChanges = changesByTarget[targetID];
+      targetChanges = targetChanges.insert(kv.first, kv.second);
+    });
+  }
+  std::vector<MaybeDocumentMap> allViewChangedDocs(viewCount);
+  for (size_t i = 0; i < viewCount; ++i) {
+    auto found = changesByTarget.find(queryViews[i].targetID);
+    if (found != changesByTarget.end()) {
+      allViewChangedDocs[i] = std::move(found->second);
+    }
+  }
+  const MaybeDocumentMap *viewChangedDocsByIndex = allViewChangedDocs.data();
+
+  // Computing the changes to a view only reads its changed documents and state owned by that
+  // view, so it can happen for all views at once. The refills go through the local store and stay
+  // serial.
+  std::vector<FSTViewDocumentChanges *> allViewDocChanges(viewCount);
+  FSTViewDocumentChanges *__strong *viewDocChangesByIndex = allViewDocChanges.data();
+  [self forEachViewIndex:viewCount
+                   apply:^(size_t i) {
+                     viewDocChangesByIndex[i] = [queryViews[i].view
+                         computeChangesWithDocuments:viewChangedDocsByIndex[i]];
+                   }];
+
+  for (size_t i = 0; i < viewCount; ++i) {
+    if (allViewDocChanges[i].needsRefill) {
+      // The query has a limit and some docs were removed/updated, so we need to re-run the
+      // query against the local store to make sure we didn't lose any good docs that had been
+      // past the limit.
+      FSTView *view = queryViews[i].view;
+      DocumentMap docs = [self.localStore executeQuery:view.fillQuery];
+      allViewDocChanges[i] = [view computeChangesWithDocuments:docs.underlying_map()
+                                               previousChanges:allViewDocChanges[i]];
+    }
+  }
 
-        if (viewChange.snapshot.has_value()) {
-          newSnapshots.push_back(viewChange.snapshot.value());
-          LocalViewChanges docChanges =
-              LocalViewChanges::FromViewSnapshot(viewChange.snapshot.value(), queryView.targetID);
-          documentChangesInAllViews.push_back(std::move(docChanges));
-        }
-      }];
+  std::vector<FSTViewChange *> allViewChanges(viewCount);
+  FSTViewChange *__strong *viewChangesByIndex = allViewChanges.data();
+  [self forEachViewIndex:viewCount
+                   apply:^(size_t i) {
+                     FSTQueryView *queryView = queryViews[i];
+                     absl::optional<TargetChange> targetChange;
+                     if (maybeRemoteEvent.has_value()) {
+                       const RemoteEvent &remoteEvent = maybeRemoteEvent.value();
+                       auto it = remoteEvent.target_changes().find(queryView.targetID);
+                       if (it != remoteEvent.target_changes().end()) {
+                         targetChange = it->second;
+                       }
+                     }
+                     viewChangesByIndex[i] =
+                         [queryView.view applyChangesToDocuments:viewDocChangesByIndex[i]
+                                                    targetChange:targetChange];
+                   }];
+
+  std::vector<ViewSnapshot> newSnapshots;
+  std::vector<LocalViewChanges> documentChangesInAllViews;
+  for (size_t i = 0; i < viewCount; ++i) {
+    FSTQueryView *queryView = queryViews[i];
+    FSTViewChange *viewChange = allViewChanges[i];
+
+    [self updateTrackedLimboDocumentsWithChanges:viewChange.limboChanges
+                                        targetID:queryView.targetID];
+
+    if (viewChange.snapshot.has_value()) {
+      newSnapshots.push_back(viewChange.snapshot.value());
+      LocalViewChanges docChanges =
+          LocalViewChanges::FromViewSnapshot(viewChange.snapshot.value(), queryView.targetID);
+      documentChangesInAllViews.push_back(std::move(docChanges));
+    }
+  }
 
   [self.syncEngineDelegate handleViewSnapshots:std::move(newSnapshots)];
   [self.localStore notifyLocalViewChanges:documentChangesInAllViews];
 }
 
+/**
+ * Calls `block` with every index below `viewCount`. If parallel view computation is enabled and
+ * there are enough views to make it worthwhile, the calls are spread over the global concurrent
+ * queue and may run at the same time; either way, all of them have returned when this does.
+ */
+- (void)forEachViewIndex:(size_t)viewCount apply:(void (^)(size_t))block {
+  if (self.parallelViewComputationEnabled && viewCount >= kMinViewsForParallelComputation) {
+    dispatch_apply(viewCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), block);
+  } else {
+    for (size_t i = 0; i < viewCount; ++i) {
+      block(i);
+    }
+  }
+}
+
 /** Updates the limbo document state for the given targetID. */
 - (void)updateTrackedLimboDocumentsWithChanges:(NSArray<FSTLimboDocumentChange *> *)limboChanges
                                       targetID:(TargetId)targetID {
@@ -570,8 +712,30 @@ class LimboResolution {
 - (void)trackLimboChange:(FSTLimboDocumentChange *)limboChange {
   DocumentKey key{limboChange.key};
 
-  if (_limboTargetsByKey.find(key) == _limboTargetsByKey.end()) {
+  if (_limboTargetsByKey.find(key) == _limboTargetsByKey.end() &&
+      _enqueuedLimboKeys.find(key) == _enqueuedLimboKeys.end()) {
     LOG_DEBUG("New document in limbo: %s", key.ToString());
+    _enqueuedLimboResolutions.push_back(key);
+    _enqueuedLimboKeys.insert(key);
+    [self pumpEnqueuedLimboResolutions];
+  }
+}
+
+/**
+ * Starts resolving the enqueued limbo documents, in order, until `maxConcurrentLimboResolutions`
+ * resolutions are active.
+ */
+- (void)pumpEnqueuedLimboResolutions {
+  while (!_enqueuedLimboResolutions.empty() &&
+         (self.maxConcurrentLimboResolutions <= 0 ||
+          _limboTargetsByKey.size() < static_cast<size_t>(self.maxConcurrentLimboResolutions))) {
+    DocumentKey key = std::move(_enqueuedLimboResolutions.front());
+    _enqueuedLimboResolutions.pop_front();
+    if (_enqueuedLimboKeys.erase(key) == 0) {
+      // The document got out of limbo while waiting.
+      continue;
+    }
+
     TargetId limboTargetID = _targetIdGenerator.NextId();
     FSTQuery *query = [FSTQuery queryWithPath:key.path()];
     FSTQueryData *queryData = [[FSTQueryData alloc] initWithQuery:query
@@ -585,6 +749,9 @@ class LimboResolution {
 }
 
 - (void)removeLimboTargetForKey:(const DocumentKey &)key {
+  // The document may still be waiting for its resolution to start.
+  _enqueuedLimboKeys.erase(key);
+
   const auto iter = _limboTargetsByKey.find(key);
   if (iter == _limboTargetsByKey.end()) {
     // This target already got removed, because the query failed.
@@ -594,6 +761,7 @@ class LimboResolution {
   _remoteStore->StopListening(limboTargetID);
   _limboTargetsByKey.erase(key);
   _limboResolutionsByTarget.erase(limboTargetID);
+  [self pumpEnqueuedLimboResolutions];
 }
 
 // Used for testing
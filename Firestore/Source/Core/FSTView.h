@@ -106,7 +106,22 @@ typedef NS_ENUM(NSInteger, FSTLimboDocumentChangeType) {
 - (instancetype)init NS_UNAVAILABLE;
 
 - (instancetype)initWithQuery:(FSTQuery *)query
-              remoteDocuments:(model::DocumentKeySet)remoteDocuments NS_DESIGNATED_INITIALIZER;
+              remoteDocuments:(model::DocumentKeySet)remoteDocuments;
+
+/**
+ * Creates a view that, for a limit query, also keeps up to `prefetchSize` of the documents that
+ * sort right after its last one. When a document drops out of the full view, it is replaced by the
+ * first of those instead of the query being re-run against the local cache.
+ */
+- (instancetype)initWithQuery:(FSTQuery *)query
+              remoteDocuments:(model::DocumentKeySet)remoteDocuments
+                 prefetchSize:(int32_t)prefetchSize NS_DESIGNATED_INITIALIZER;
+
+/**
+ * The query to run against the local cache for the documents to fill the view with, either
+ * initially or when `needsRefill` is set. It reaches past the limit when the view prefetches.
+ */
+- (FSTQuery *)fillQuery;
 
 /**
  * Iterates over a set of doc changes, applies the query limit, and computes what the new results
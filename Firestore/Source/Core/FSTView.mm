@@ -31,6 +31,7 @@
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/util/delayed_constructor.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
 
 namespace util = firebase::firestore::util;
 using firebase::firestore::core::DocumentViewChange;
@@ -78,7 +79,15 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 - (instancetype)initWithDocumentSet:(DocumentSet)documentSet
                           changeSet:(DocumentViewChangeSet &&)changeSet
                         needsRefill:(BOOL)needsRefill
-                        mutatedKeys:(DocumentKeySet)mutatedKeys NS_DESIGNATED_INITIALIZER;
+                        mutatedKeys:(DocumentKeySet)mutatedKeys
+                prefetchedDocuments:(DocumentSet)prefetchedDocuments
+                   prefetchBoundary:(nullable FSTDocument *)prefetchBoundary
+    NS_DESIGNATED_INITIALIZER;
+
+/** The documents past the limit that the view keeps, as described on FSTView. */
+- (const DocumentSet &)prefetchedDocuments;
+
+@property(nonatomic, strong, readonly, nullable) FSTDocument *prefetchBoundary;
 
 @end
 
@@ -86,18 +95,23 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   DelayedConstructor<DocumentSet> _documentSet;
   DocumentKeySet _mutatedKeys;
   DocumentViewChangeSet _changeSet;
+  DelayedConstructor<DocumentSet> _prefetchedDocuments;
 }
 
 - (instancetype)initWithDocumentSet:(DocumentSet)documentSet
                           changeSet:(DocumentViewChangeSet &&)changeSet
                         needsRefill:(BOOL)needsRefill
-                        mutatedKeys:(DocumentKeySet)mutatedKeys {
+                        mutatedKeys:(DocumentKeySet)mutatedKeys
+                prefetchedDocuments:(DocumentSet)prefetchedDocuments
+                   prefetchBoundary:(nullable FSTDocument *)prefetchBoundary {
   self = [super init];
   if (self) {
     _documentSet.Init(std::move(documentSet));
     _changeSet = std::move(changeSet);
     _needsRefill = needsRefill;
     _mutatedKeys = std::move(mutatedKeys);
+    _prefetchedDocuments.Init(std::move(prefetchedDocuments));
+    _prefetchBoundary = prefetchBoundary;
   }
   return self;
 }
@@ -114,6 +128,10 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   return _changeSet;
 }
 
+- (const DocumentSet &)prefetchedDocuments {
+  return *_prefetchedDocuments;
+}
+
 @end
 
 #pragma mark - FSTLimboDocumentChange
@@ -233,18 +251,56 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 
   /** Document Keys that have local changes. */
   DocumentKeySet _mutatedKeys;
+
+  /** The maximum number of documents past the limit the view keeps. */
+  int32_t _prefetchSize;
+
+  /**
+   * The documents that match the query and sort right after the last document in the view, up to
+   * `_prefetchBoundary`. Always empty unless the view is full.
+   */
+  DelayedConstructor<DocumentSet> _prefetchedDocuments;
+
+  /**
+   * The position up to which `_prefetchedDocuments` holds every matching document in the local
+   * cache, or nil if it holds all of them.
+   */
+  FSTDocument *_Nullable _prefetchBoundary;
 }
 
 - (instancetype)initWithQuery:(FSTQuery *)query remoteDocuments:(DocumentKeySet)remoteDocuments {
+  return [self initWithQuery:query remoteDocuments:std::move(remoteDocuments) prefetchSize:0];
+}
+
+- (instancetype)initWithQuery:(FSTQuery *)query
+              remoteDocuments:(DocumentKeySet)remoteDocuments
+                 prefetchSize:(int32_t)prefetchSize {
   self = [super init];
   if (self) {
     _query = query;
     _documentSet.Init(query.comparator);
     _syncedDocuments = std::move(remoteDocuments);
+    _prefetchSize = prefetchSize;
+    _prefetchedDocuments.Init(query.comparator);
   }
   return self;
 }
 
+- (FSTQuery *)fillQuery {
+  if (![self isPrefetching]) {
+    return self.query;
+  }
+  // Ask for one more document than the view and its buffer can hold: if the local cache has it,
+  // the buffer is not exhaustive.
+  int64_t limit = int64_t{self.query.limit} + _prefetchSize + 1;
+  return [self.query queryBySettingLimit:limit < Query::kNoLimit ? static_cast<int32_t>(limit)
+                                                                 : Query::kNoLimit];
+}
+
+- (BOOL)isPrefetching {
+  return self.query.limit != Query::kNoLimit && _prefetchSize > 0;
+}
+
 - (ComparisonResult)compare:(FSTDocument *)document with:(FSTDocument *)otherDocument {
   return self.query.comparator.Compare(document, otherDocument);
 }
@@ -260,6 +316,7 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 - (FSTViewDocumentChanges *)computeChangesWithDocuments:(const MaybeDocumentMap &)docChanges
                                         previousChanges:
                                             (nullable FSTViewDocumentChanges *)previousChanges {
+  FIRESTORE_TRACE_SPAN("-[FSTView computeChangesWithDocuments:previousChanges:]");
   DocumentViewChangeSet changeSet;
   if (previousChanges) {
     changeSet = previousChanges.changeSet;
@@ -268,9 +325,32 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 
   DocumentKeySet newMutatedKeys = previousChanges ? previousChanges.mutatedKeys : _mutatedKeys;
   DocumentKeySet oldMutatedKeys = _mutatedKeys;
-  DocumentSet newDocumentSet = oldDocumentSet;
+  // Apply all the changes to a single transient copy so that each tree node is copied at most
+  // once.
+  DocumentSet::Editor newDocumentSet{oldDocumentSet};
   BOOL needsRefill = NO;
 
+  // Every change to an empty view adds a document the view ends up with, so rather than tracking
+  // each change, derive them from the resulting documents.
+  BOOL allAdded = !previousChanges && oldDocumentSet.empty();
+  auto recordChange = [&](DocumentViewChange &&change) {
+    if (!allAdded) {
+      changeSet.AddChange(std::move(change));
+    }
+  };
+
+  // A refill reads the documents past the limit along with the ones within it, so the prefetch
+  // buffer starts over.
+  BOOL prefetching = [self isPrefetching];
+  DocumentSet::Editor newPrefetchedDocuments{previousChanges ? DocumentSet{self.query.comparator}
+                                                             : *_prefetchedDocuments};
+  FSTDocument *_Nullable prefetchBoundary = previousChanges ? nil : _prefetchBoundary;
+  auto prefetch = [&](FSTDocument *doc) {
+    if (!prefetchBoundary || !util::Descending([self compare:doc with:prefetchBoundary])) {
+      newPrefetchedDocuments.insert(doc);
+    }
+  };
+
   // Track the last doc in a (full) limit. This is necessary, because some update (a delete, or an
   // update moving a doc past the old limit) might mean there is some other document in the local
   // cache that either should come (1) between the old last limit doc and the new last document,
@@ -288,6 +368,12 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
     const DocumentKey &key = kv.first;
     FSTMaybeDocument *maybeNewDoc = kv.second;
 
+    if (prefetching) {
+      // A changed document that still sorts past the end of the view makes its way back into the
+      // buffer when the view is trimmed to the limit below.
+      newPrefetchedDocuments.erase(key);
+    }
+
     FSTDocument *_Nullable oldDoc = oldDocumentSet.GetDocument(key);
     FSTDocument *_Nullable newDoc = nil;
     if ([maybeNewDoc isKindOfClass:[FSTDocument class]]) {
@@ -315,7 +401,7 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
       BOOL docsEqual = oldDoc.data == newDoc.data;
       if (!docsEqual) {
         if (![self shouldWaitForSyncedDocument:newDoc oldDocument:oldDoc]) {
-          changeSet.AddChange(DocumentViewChange{newDoc, DocumentViewChange::Type::kModified});
+          recordChange(DocumentViewChange{newDoc, DocumentViewChange::Type::kModified});
           changeApplied = YES;
 
           if (lastDocInLimit && util::Descending([self compare:newDoc with:lastDocInLimit])) {
@@ -325,15 +411,15 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
           }
         }
       } else if (oldDocHadPendingMutations != newDocHasPendingMutations) {
-        changeSet.AddChange(DocumentViewChange{newDoc, DocumentViewChange::Type::kMetadata});
+        recordChange(DocumentViewChange{newDoc, DocumentViewChange::Type::kMetadata});
         changeApplied = YES;
       }
 
     } else if (!oldDoc && newDoc) {
-      changeSet.AddChange(DocumentViewChange{newDoc, DocumentViewChange::Type::kAdded});
+      recordChange(DocumentViewChange{newDoc, DocumentViewChange::Type::kAdded});
       changeApplied = YES;
     } else if (oldDoc && !newDoc) {
-      changeSet.AddChange(DocumentViewChange{oldDoc, DocumentViewChange::Type::kRemoved});
+      recordChange(DocumentViewChange{oldDoc, DocumentViewChange::Type::kRemoved});
       changeApplied = YES;
 
       if (lastDocInLimit) {
@@ -345,35 +431,85 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 
     if (changeApplied) {
       if (newDoc) {
-        newDocumentSet = newDocumentSet.insert(newDoc);
+        newDocumentSet.insert(newDoc);
         if (newDoc.hasLocalMutations) {
-          newMutatedKeys = newMutatedKeys.insert(key);
+          newMutatedKeys.InsertInPlace(key);
         } else {
-          newMutatedKeys = newMutatedKeys.erase(key);
+          newMutatedKeys.EraseInPlace(key);
         }
       } else {
-        newDocumentSet = newDocumentSet.erase(key);
-        newMutatedKeys = newMutatedKeys.erase(key);
+        newDocumentSet.erase(key);
+        newMutatedKeys.EraseInPlace(key);
       }
     }
   }
 
-  if (self.query.limit != Query::kNoLimit && newDocumentSet.size() > self.query.limit) {
-    for (size_t i = newDocumentSet.size() - self.query.limit; i > 0; --i) {
-      FSTDocument *oldDoc = newDocumentSet.GetLastDocument();
-      newDocumentSet = newDocumentSet.erase(oldDoc.key);
-      newMutatedKeys = newMutatedKeys.erase(oldDoc.key);
-      changeSet.AddChange(DocumentViewChange{oldDoc, DocumentViewChange::Type::kRemoved});
+  if (self.query.limit != Query::kNoLimit && newDocumentSet.set().size() > self.query.limit) {
+    for (size_t i = newDocumentSet.set().size() - self.query.limit; i > 0; --i) {
+      FSTDocument *oldDoc = newDocumentSet.set().GetLastDocument();
+      newDocumentSet.erase(oldDoc.key);
+      newMutatedKeys.EraseInPlace(oldDoc.key);
+      recordChange(DocumentViewChange{oldDoc, DocumentViewChange::Type::kRemoved});
+      if (prefetching) {
+        prefetch(oldDoc);
+      }
+    }
+  }
+
+  if (prefetching && needsRefill) {
+    // Serve the refill from the buffer, which holds every matching document that sorts between
+    // the end of the view and the prefetch boundary.
+    while (!newPrefetchedDocuments.set().empty()) {
+      FSTDocument *nextDoc = newPrefetchedDocuments.set().GetFirstDocument();
+      if (newDocumentSet.set().size() == self.query.limit) {
+        // The view may still be full if a document in it moved past the end of the view.
+        FSTDocument *lastDoc = newDocumentSet.set().GetLastDocument();
+        if (!util::Descending([self compare:lastDoc with:nextDoc])) {
+          break;
+        }
+        newDocumentSet.erase(lastDoc.key);
+        newMutatedKeys.EraseInPlace(lastDoc.key);
+        recordChange(DocumentViewChange{lastDoc, DocumentViewChange::Type::kRemoved});
+        prefetch(lastDoc);
+      }
+
+      newPrefetchedDocuments.erase(nextDoc.key);
+      newDocumentSet.insert(nextDoc);
+      if (nextDoc.hasLocalMutations) {
+        newMutatedKeys.InsertInPlace(nextDoc.key);
+      }
+      recordChange(DocumentViewChange{nextDoc, DocumentViewChange::Type::kAdded});
+    }
+
+    // Only re-run the query if the view could now be missing a document the buffer doesn't know
+    // about.
+    FSTDocument *_Nullable lastDoc = newDocumentSet.set().GetLastDocument();
+    needsRefill = prefetchBoundary &&
+                  (newDocumentSet.set().size() < self.query.limit ||
+                   util::Descending([self compare:lastDoc with:prefetchBoundary]));
+  }
+
+  if (prefetching) {
+    while (newPrefetchedDocuments.set().size() > static_cast<size_t>(_prefetchSize)) {
+      newPrefetchedDocuments.erase(newPrefetchedDocuments.set().GetLastDocument().key);
+      prefetchBoundary = newPrefetchedDocuments.set().GetLastDocument();
     }
   }
 
   HARD_ASSERT(!needsRefill || !previousChanges,
               "View was refilled using docs that themselves needed refilling.");
 
-  return [[FSTViewDocumentChanges alloc] initWithDocumentSet:std::move(newDocumentSet)
+  DocumentSet documentSet = newDocumentSet.Build();
+  if (allAdded) {
+    changeSet = DocumentViewChangeSet::FromAddedDocuments(documentSet);
+  }
+
+  return [[FSTViewDocumentChanges alloc] initWithDocumentSet:std::move(documentSet)
                                                    changeSet:std::move(changeSet)
                                                  needsRefill:needsRefill
-                                                 mutatedKeys:newMutatedKeys];
+                                                 mutatedKeys:newMutatedKeys
+                                         prefetchedDocuments:newPrefetchedDocuments.Build()
+                                            prefetchBoundary:prefetchBoundary];
 }
 
 - (BOOL)shouldWaitForSyncedDocument:(FSTDocument *)newDoc oldDocument:(FSTDocument *)oldDoc {
@@ -392,23 +528,29 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 
 - (FSTViewChange *)applyChangesToDocuments:(FSTViewDocumentChanges *)docChanges
                               targetChange:(const absl::optional<TargetChange> &)targetChange {
+  FIRESTORE_TRACE_SPAN("-[FSTView applyChangesToDocuments:targetChange:]");
   HARD_ASSERT(!docChanges.needsRefill, "Cannot apply changes that need a refill");
 
   DocumentSet oldDocuments = *_documentSet;
   *_documentSet = docChanges.documentSet;
   _mutatedKeys = docChanges.mutatedKeys;
+  *_prefetchedDocuments = docChanges.prefetchedDocuments;
+  _prefetchBoundary = docChanges.prefetchBoundary;
 
-  // Sort changes based on type and query comparator.
+  // Sort changes based on type and query comparator. Changes that are all additions already come
+  // in query order.
   std::vector<DocumentViewChange> changes = docChanges.changeSet.GetChanges();
-  std::sort(changes.begin(), changes.end(),
-            [self](const DocumentViewChange &lhs, const DocumentViewChange &rhs) {
-              int pos1 = GetDocumentViewChangeTypePosition(lhs.type());
-              int pos2 = GetDocumentViewChangeTypePosition(rhs.type());
-              if (pos1 != pos2) {
-                return pos1 < pos2;
-              }
-              return util::Ascending([self compare:lhs.document() with:rhs.document()]);
-            });
+  if (!docChanges.changeSet.all_added()) {
+    std::sort(changes.begin(), changes.end(),
+              [self](const DocumentViewChange &lhs, const DocumentViewChange &rhs) {
+                int pos1 = GetDocumentViewChangeTypePosition(lhs.type());
+                int pos2 = GetDocumentViewChangeTypePosition(rhs.type());
+                if (pos1 != pos2) {
+                  return pos1 < pos2;
+                }
+                return util::Ascending([self compare:lhs.document() with:rhs.document()]);
+              });
+  }
 
   [self applyTargetChange:targetChange];
   NSArray<FSTLimboDocumentChange *> *limboChanges = [self updateLimboDocuments];
@@ -436,19 +578,24 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
 
 - (FSTViewChange *)applyChangedOnlineState:(OnlineState)onlineState {
   if (self.isCurrent && onlineState == OnlineState::Offline) {
-    // If we're offline, set `current` to NO and then call applyChanges to refresh our syncState
-    // and generate an FSTViewChange as appropriate. We are guaranteed to get a new `TargetChange`
-    // that sets `current` back to YES once the client is back online.
+    // If we're offline, set `current` to NO, which makes the view's results come from the cache.
+    // We are guaranteed to get a new `TargetChange` that sets `current` back to YES once the client
+    // is back online.
     self.current = NO;
-    return [self applyChangesToDocuments:[[FSTViewDocumentChanges alloc]
-                                             initWithDocumentSet:*_documentSet
-                                                       changeSet:DocumentViewChangeSet {}
-                                                     needsRefill:NO
-                                                     mutatedKeys:_mutatedKeys]];
-  } else {
-    // No effect, just return a no-op FSTViewChange.
-    return [[FSTViewChange alloc] initWithSnapshot:absl::nullopt limboChanges:@[]];
+
+    // No document and no limbo document changes, so rather than applying an empty set of changes,
+    // raise a snapshot that shares the documents of the view and only flips `from_cache`.
+    if (self.syncState == SyncState::Synced) {
+      self.syncState = SyncState::Local;
+      return [FSTViewChange
+          changeWithSnapshot:ViewSnapshot::FromSyncStateChange(self.query, *_documentSet,
+                                                               _mutatedKeys, /*from_cache=*/true)
+                limboChanges:@[]];
+    }
   }
+
+  // No effect, just return a no-op FSTViewChange.
+  return [[FSTViewChange alloc] initWithSnapshot:absl::nullopt limboChanges:@[]];
 }
 
 #pragma mark - Private methods
@@ -481,16 +628,12 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   if (maybeTargetChange.has_value()) {
     const TargetChange &target_change = maybeTargetChange.value();
 
-    for (const DocumentKey &key : target_change.added_documents()) {
-      _syncedDocuments = _syncedDocuments.insert(key);
-    }
+    _syncedDocuments = _syncedDocuments.insert_all(target_change.added_documents());
     for (const DocumentKey &key : target_change.modified_documents()) {
       HARD_ASSERT(_syncedDocuments.find(key) != _syncedDocuments.end(),
                   "Modified document %s not found in view.", key.ToString());
     }
-    for (const DocumentKey &key : target_change.removed_documents()) {
-      _syncedDocuments = _syncedDocuments.erase(key);
-    }
+    _syncedDocuments = _syncedDocuments.erase_all(target_change.removed_documents());
 
     self.current = target_change.current();
   }
@@ -504,28 +647,29 @@ int GetDocumentViewChangeTypePosition(DocumentViewChange::Type changeType) {
   }
 
   // TODO(klimt): Do this incrementally so that it's not quadratic when updating many documents.
-  DocumentKeySet oldLimboDocuments = std::move(_limboDocuments);
-  _limboDocuments = DocumentKeySet{};
+  // The document set is in query order, so the keys are sorted before the set is built in one go.
+  std::vector<DocumentKey> limboKeys;
   for (FSTDocument *doc : *_documentSet) {
     if ([self shouldBeLimboDocumentKey:doc.key]) {
-      _limboDocuments = _limboDocuments.insert(doc.key);
+      limboKeys.push_back(doc.key);
     }
   }
+  std::sort(limboKeys.begin(), limboKeys.end());
+  DocumentKeySet oldLimboDocuments = std::move(_limboDocuments);
+  _limboDocuments = DocumentKeySet::FromSortedRange(limboKeys);
 
   // Diff the new limbo docs with the old limbo docs.
+  DocumentKeySet removed = oldLimboDocuments.erase_all(_limboDocuments);
+  DocumentKeySet added = _limboDocuments.erase_all(oldLimboDocuments);
   NSMutableArray<FSTLimboDocumentChange *> *changes =
-      [NSMutableArray arrayWithCapacity:(oldLimboDocuments.size() + _limboDocuments.size())];
-  for (const DocumentKey &key : oldLimboDocuments) {
-    if (!_limboDocuments.contains(key)) {
-      [changes addObject:[FSTLimboDocumentChange changeWithType:FSTLimboDocumentChangeTypeRemoved
-                                                            key:key]];
-    }
+      [NSMutableArray arrayWithCapacity:(removed.size() + added.size())];
+  for (const DocumentKey &key : removed) {
+    [changes addObject:[FSTLimboDocumentChange changeWithType:FSTLimboDocumentChangeTypeRemoved
+                                                          key:key]];
   }
-  for (const DocumentKey &key : _limboDocuments) {
-    if (!oldLimboDocuments.contains(key)) {
-      [changes addObject:[FSTLimboDocumentChange changeWithType:FSTLimboDocumentChangeTypeAdded
-                                                            key:key]];
-    }
+  for (const DocumentKey &key : added) {
+    [changes addObject:[FSTLimboDocumentChange changeWithType:FSTLimboDocumentChangeTypeAdded
+                                                          key:key]];
   }
   return changes;
 }
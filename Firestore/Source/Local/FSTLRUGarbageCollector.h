@@ -38,11 +38,11 @@ namespace local {
 
 struct LruParams {
   static LruParams Default() {
-    return LruParams{100 * 1024 * 1024, 10, 1000};
+    return LruParams{100 * 1024 * 1024, 10, 1000, 100};
   }
 
   static LruParams Disabled() {
-    return LruParams{api::Settings::CacheSizeUnlimited, 0, 0};
+    return LruParams{api::Settings::CacheSizeUnlimited, 0, 0, 0};
   }
 
   static LruParams WithCacheSize(int64_t cacheSize) {
@@ -54,17 +54,24 @@ struct LruParams {
   int64_t minBytesThreshold;
   int percentileToCollect;
   int maximumSequenceNumbersToCollect;
+  /**
+   * When collecting incrementally, the most sequence numbers collected by a single slice. Zero
+   * means that a collection isn't split up.
+   */
+  int maximumSequenceNumbersPerSlice;
 };
 
 struct LruResults {
   static LruResults DidNotRun() {
-    return LruResults{/* didRun= */ false, 0, 0, 0};
+    return LruResults{/* didRun= */ false, 0, 0, 0, /* hasMoreSlices= */ false};
   }
 
   bool didRun;
   int sequenceNumbersCollected;
   int targetsRemoved;
   int documentsRemoved;
+  /** Whether an incremental collection has slices left to run. */
+  bool hasMoreSlices;
 };
 
 }  // namespace local
@@ -158,4 +165,17 @@ namespace local = firebase::firestore::local;
 - (local::LruResults)collectWithLiveTargets:
     (const std::unordered_map<model::TargetId, FSTQueryData *> &)liveTargets;
 
+/**
+ * Runs one slice of an incremental collection, so that callers can yield to other work in
+ * between slices, each in a transaction of its own.
+ *
+ * The first slice decides whether to collect and which sequence numbers to collect, the same way
+ * `collectWithLiveTargets:` does, and splits them up into slices of at most
+ * `maximumSequenceNumbersPerSlice`. Each slice then removes the eligible targets and documents up
+ * through the highest sequence number of that slice. `hasMoreSlices` in the result tells whether
+ * this method should be called again to finish the collection.
+ */
+- (local::LruResults)collectSliceWithLiveTargets:
+    (const std::unordered_map<model::TargetId, FSTQueryData *> &)liveTargets;
+
 @end
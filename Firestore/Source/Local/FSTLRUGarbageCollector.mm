@@ -16,9 +16,11 @@
 
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 
+#include <algorithm>
 #include <chrono>  //NOLINT(build/c++11)
 #include <queue>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/Local/FSTPersistence.h"
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
@@ -73,6 +75,16 @@ class RollingSequenceNumberBuffer {
     return queue_.top();
   }
 
+  /** Returns the tracked sequence numbers in ascending order, emptying the buffer. */
+  std::vector<ListenSequenceNumber> TakeSortedValues() {
+    std::vector<ListenSequenceNumber> result(queue_.size());
+    for (auto it = result.rbegin(); it != result.rend(); ++it) {
+      *it = queue_.top();
+      queue_.pop();
+    }
+    return result;
+  }
+
   size_t size() const {
     return queue_.size();
   }
@@ -82,11 +94,19 @@ class RollingSequenceNumberBuffer {
   const size_t max_elements_;
 };
 
+/** A slice of an incremental collection. */
+struct Slice {
+  ListenSequenceNumber upperBound;
+  int sequenceNumbers;
+};
+
 }  // namespace
 
 @implementation FSTLRUGarbageCollector {
   __weak id<FSTLRUDelegate> _delegate;
   LruParams _params;
+  // The slices of the current incremental collection that have yet to run, the next one last.
+  std::vector<Slice> _pendingSlices;
 }
 
 - (instancetype)initWithDelegate:(id<FSTLRUDelegate>)delegate params:(LruParams)params {
@@ -100,9 +120,44 @@ class RollingSequenceNumberBuffer {
 
 - (LruResults)collectWithLiveTargets:
     (const std::unordered_map<TargetId, FSTQueryData *> &)liveTargets {
+  if (![self shouldCollect]) {
+    return LruResults::DidNotRun();
+  }
+  return [self runGCWithLiveTargets:liveTargets];
+}
+
+- (LruResults)collectSliceWithLiveTargets:
+    (const std::unordered_map<TargetId, FSTQueryData *> &)liveTargets {
+  if (_pendingSlices.empty()) {
+    if (![self shouldCollect]) {
+      return LruResults::DidNotRun();
+    }
+    [self planSlices];
+    if (_pendingSlices.empty()) {
+      return LruResults{/* didRun= */ true, 0, 0, 0, /* hasMoreSlices= */ false};
+    }
+  }
+
+  Slice slice = _pendingSlices.back();
+  _pendingSlices.pop_back();
+
+  Timestamp start = Timestamp::Now();
+  int numTargetsRemoved = [self removeQueriesUpThroughSequenceNumber:slice.upperBound
+                                                         liveQueries:liveTargets];
+  int numDocumentsRemoved = [self removeOrphanedDocumentsThroughSequenceNumber:slice.upperBound];
+  LOG_DEBUG("LRU Garbage Collection slice: removed %s targets and %s documents in %sms, %s slices "
+            "left",
+            numTargetsRemoved, numDocumentsRemoved, millisecondsBetween(start, Timestamp::Now()),
+            _pendingSlices.size());
+
+  return LruResults{/* didRun= */ true, slice.sequenceNumbers, numTargetsRemoved,
+                    numDocumentsRemoved, /* hasMoreSlices= */ !_pendingSlices.empty()};
+}
+
+- (BOOL)shouldCollect {
   if (_params.minBytesThreshold == api::Settings::CacheSizeUnlimited) {
     LOG_DEBUG("Garbage collection skipped; disabled");
-    return LruResults::DidNotRun();
+    return NO;
   }
 
   size_t currentSize = [self byteSize];
@@ -110,24 +165,75 @@ class RollingSequenceNumberBuffer {
     // Not enough on disk to warrant collection. Wait another timeout cycle.
     LOG_DEBUG("Garbage collection skipped; Cache size %s is lower than threshold %s", currentSize,
               _params.minBytesThreshold);
-    return LruResults::DidNotRun();
-  } else {
-    LOG_DEBUG("Running garbage collection on cache of size: %s", currentSize);
-    return [self runGCWithLiveTargets:liveTargets];
+    return NO;
   }
+
+  LOG_DEBUG("Running garbage collection on cache of size: %s", currentSize);
+  return YES;
+}
+
+/**
+ * Returns the sequence numbers to collect in ascending order: the configured percentile of all
+ * sequence numbers, capped at the configured max.
+ *
+ * Since no more than `maximumSequenceNumbersToCollect` are ever collected, the lowest ones can be
+ * picked while counting all of them in a single pass, rather than counting them before
+ * enumerating them again to find the lowest ones.
+ */
+- (std::vector<ListenSequenceNumber>)sequenceNumbersToCollect {
+  if (_params.maximumSequenceNumbersToCollect <= 0) {
+    return {};
+  }
+
+  size_t totalCount = 0;
+  RollingSequenceNumberBuffer buffer(_params.maximumSequenceNumbersToCollect);
+  [_delegate enumerateTargetsUsingCallback:[&](FSTQueryData *queryData) {
+    buffer.AddElement(queryData.sequenceNumber);
+    ++totalCount;
+  }];
+  [_delegate enumerateMutationsUsingCallback:[&](const DocumentKey &docKey,
+                                                 ListenSequenceNumber sequenceNumber) {
+    buffer.AddElement(sequenceNumber);
+    ++totalCount;
+  }];
+
+  std::vector<ListenSequenceNumber> lowest = buffer.TakeSortedValues();
+  // Same as `queryCountForPercentile:`. Never larger than the buffer, so no need to cap it.
+  auto count = static_cast<size_t>((_params.percentileToCollect / 100.0f) * totalCount);
+  if (count < lowest.size()) {
+    lowest.resize(count);
+  }
+  return lowest;
+}
+
+- (void)planSlices {
+  std::vector<ListenSequenceNumber> lowest = [self sequenceNumbersToCollect];
+
+  size_t perSlice = _params.maximumSequenceNumbersPerSlice > 0
+                        ? static_cast<size_t>(_params.maximumSequenceNumbersPerSlice)
+                        : lowest.size();
+  for (size_t begin = 0; begin < lowest.size(); begin += perSlice) {
+    size_t end = std::min(begin + perSlice, lowest.size());
+    ListenSequenceNumber upperBound = lowest[end - 1];
+    int count = static_cast<int>(end - begin);
+    // Sequence numbers can repeat, in which case the slice ending with a repeated one also
+    // collects the rest of them.
+    if (!_pendingSlices.empty() && _pendingSlices.back().upperBound == upperBound) {
+      _pendingSlices.back().sequenceNumbers += count;
+    } else {
+      _pendingSlices.push_back(Slice{upperBound, count});
+    }
+  }
+  std::reverse(_pendingSlices.begin(), _pendingSlices.end());
 }
 
 - (LruResults)runGCWithLiveTargets:
     (const std::unordered_map<TargetId, FSTQueryData *> &)liveTargets {
   Timestamp start = Timestamp::Now();
-  int sequenceNumbers = [self queryCountForPercentile:_params.percentileToCollect];
-  // Cap at the configured max
-  if (sequenceNumbers > _params.maximumSequenceNumbersToCollect) {
-    sequenceNumbers = _params.maximumSequenceNumbersToCollect;
-  }
-  Timestamp countedTargets = Timestamp::Now();
-
-  ListenSequenceNumber upperBound = [self sequenceNumberForQueryCount:sequenceNumbers];
+  std::vector<ListenSequenceNumber> toCollect = [self sequenceNumbersToCollect];
+  int sequenceNumbers = static_cast<int>(toCollect.size());
+  ListenSequenceNumber upperBound =
+      toCollect.empty() ? kFSTListenSequenceNumberInvalid : toCollect.back();
   Timestamp foundUpperBound = Timestamp::Now();
 
   int numTargetsRemoved = [self removeQueriesUpThroughSequenceNumber:upperBound
@@ -138,11 +244,8 @@ class RollingSequenceNumberBuffer {
   Timestamp removedDocuments = Timestamp::Now();
 
   std::string desc = "LRU Garbage Collection:\n";
-  absl::StrAppend(&desc, "\tCounted targets in ", millisecondsBetween(start, countedTargets),
-                  "ms\n");
   absl::StrAppend(&desc, "\tDetermined least recently used ", sequenceNumbers,
-                  " sequence numbers in ", millisecondsBetween(countedTargets, foundUpperBound),
-                  "ms\n");
+                  " sequence numbers in ", millisecondsBetween(start, foundUpperBound), "ms\n");
   absl::StrAppend(&desc, "\tRemoved ", numTargetsRemoved, " targets in ",
                   millisecondsBetween(foundUpperBound, removedTargets), "ms\n");
   absl::StrAppend(&desc, "\tRemoved ", numDocumentsRemoved, " documents in ",
@@ -150,7 +253,8 @@ class RollingSequenceNumberBuffer {
   absl::StrAppend(&desc, "Total duration: ", millisecondsBetween(start, removedDocuments), "ms");
   LOG_DEBUG(desc.c_str());
 
-  return LruResults{/* didRun= */ true, sequenceNumbers, numTargetsRemoved, numDocumentsRemoved};
+  return LruResults{/* didRun= */ true, sequenceNumbers, numTargetsRemoved, numDocumentsRemoved,
+                    /* hasMoreSlices= */ false};
 }
 
 - (int)queryCountForPercentile:(NSUInteger)percentile {
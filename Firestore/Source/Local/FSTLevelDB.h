@@ -16,14 +16,20 @@
 
 #import <Foundation/Foundation.h>
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
 
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
 #import "Firestore/Source/Local/FSTPersistence.h"
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "Firestore/core/src/firebase/firestore/local/startup_profile.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
@@ -31,8 +37,10 @@
 
 @class FSTLocalSerializer;
 
+namespace api = firebase::firestore::api;
 namespace core = firebase::firestore::core;
 namespace local = firebase::firestore::local;
+namespace model = firebase::firestore::model;
 namespace util = firebase::firestore::util;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -55,6 +63,27 @@ NS_ASSUME_NONNULL_BEGIN
                       lruParams:(local::LruParams)lruParams
                             ptr:(FSTLevelDB *_Nullable *_Nonnull)ptr;
 
+/**
+ * Like `dbWithDirectory:serializer:lruParams:ptr:` but additionally bounds the number of bytes of
+ * decoded documents that the remote document cache keeps in memory. Zero disables that cache.
+ */
++ (util::Status)dbWithDirectory:(util::Path)directory
+                     serializer:(FSTLocalSerializer *)serializer
+                      lruParams:(local::LruParams)lruParams
+         documentCacheSizeBytes:(size_t)documentCacheSizeBytes
+                            ptr:(FSTLevelDB *_Nullable *_Nonnull)ptr;
+
+/**
+ * Like `dbWithDirectory:serializer:lruParams:documentCacheSizeBytes:ptr:` but additionally tunes
+ * the options the underlying LevelDB database is opened with.
+ */
++ (util::Status)dbWithDirectory:(util::Path)directory
+                     serializer:(FSTLocalSerializer *)serializer
+                      lruParams:(local::LruParams)lruParams
+         documentCacheSizeBytes:(size_t)documentCacheSizeBytes
+              persistenceTuning:(const api::PersistenceTuning &)persistenceTuning
+                            ptr:(FSTLevelDB *_Nullable *_Nonnull)ptr;
+
 - (instancetype)init NS_UNAVAILABLE;
 
 /** Finds a suitable directory to serve as the root of all Firestore local storage. */
@@ -76,7 +105,70 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (const leveldb::ReadOptions)standardReadOptions;
 
-+ (util::Status)clearPersistence:(const core::DatabaseInfo &)databaseInfo;
+/**
+ * Deletes the database for the given database info, if there is one.
+ *
+ * With `deferDeletion`, the database directory is instead moved into a trash directory next to it
+ * and deleted on a background queue, so that this returns without waiting on the deletion of every
+ * file.
+ */
++ (util::Status)clearPersistence:(const core::DatabaseInfo &)databaseInfo
+                   deferDeletion:(BOOL)deferDeletion;
+
+/**
+ * Enables group commit: instead of being written to disk as it commits, each transaction is merged
+ * with the ones committed after it, and they are all written together once `window` has elapsed
+ * since the first of them committed. Until then, the changes of the merged transactions are
+ * visible to later transactions but are lost if the app crashes.
+ *
+ * Must be called on `queue`, and all transactions must subsequently run on it.
+ */
+- (void)enableGroupCommitWithWindow:(std::chrono::milliseconds)window
+                              queue:(std::shared_ptr<util::AsyncQueue>)queue;
+
+/** Writes any committed transactions that group commit is holding back to disk right away. */
+- (void)flushPendingCommits;
+
+/**
+ * Enables idle compaction: once transactions have deleted many rows from a table, such as when
+ * garbage collection removes documents or the mutation queue drains, the range of the table they
+ * were deleted from is compacted after transactions have stopped for a while. Otherwise the
+ * tombstones LevelDB leaves in place of the rows can slow down scans until LevelDB gets around
+ * to compacting them on its own.
+ *
+ * Must be called on `queue`, and all transactions must subsequently run on it.
+ */
+- (void)enableIdleCompactionWithQueue:(std::shared_ptr<util::AsyncQueue>)queue;
+
+/**
+ * Runs `block` on `queue` against a snapshot of the database, taken when the block starts, so that
+ * it doesn't wait for the worker queue: transactions run inside the block read from the snapshot,
+ * while those on the worker queue keep running and committing meanwhile. The block must not write.
+ *
+ * Returns NO without running the block if a snapshot wouldn't see all committed transactions,
+ * because group commit is holding some back, or if snapshot reads aren't supported on this
+ * platform. Must be called on the worker queue, outside of a transaction.
+ */
+- (BOOL)runSnapshotRead:(absl::string_view)label
+                onQueue:(dispatch_queue_t)queue
+                  block:(std::function<void()>)block;
+
+/**
+ * Imports the documents and queries of the bundle at `path`, built by `local::BundleWriter`, into
+ * the cache. The bundle is mapped into memory and written to LevelDB in large batches, without
+ * decoding the documents unless their collection has field indexes.
+ *
+ * Must not be called while a transaction is running. Since the cached documents change without
+ * going through the local store, the caller must make sure no queries are listening.
+ */
+- (util::Status)loadBundleAtPath:(const util::Path &)path
+                      databaseID:(const model::DatabaseId &)databaseID;
+
+/**
+ * How long opening the database, migrating it and loading its metadata took. The local store
+ * parts of the profile are left zero.
+ */
+@property(nonatomic, readonly) const local::StartupProfile &startupProfile;
 
 /** The native db pointer, allocated during start. */
 @property(nonatomic, assign, readonly) leveldb::DB *ptr;
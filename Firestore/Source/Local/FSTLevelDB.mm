@@ -16,32 +16,46 @@
 
 #import "Firestore/Source/Local/FSTLevelDB.h"
 
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #import "FIRFirestoreErrors.h"
+#import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_bundle_loader.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_compaction_tracker.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_mutation_queue.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_options.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_query_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
 #include "Firestore/core/src/firebase/firestore/local/listen_sequence.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/startup_profile.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/autoid.h"
 #include "Firestore/core/src/firebase/firestore/util/filesystem.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
@@ -52,40 +66,58 @@
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "leveldb/db.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 namespace util = firebase::firestore::util;
 using firebase::firestore::Error;
+using firebase::firestore::api::PersistenceTuning;
+using firebase::firestore::api::Settings;
 using firebase::firestore::auth::User;
 using firebase::firestore::core::DatabaseInfo;
 using firebase::firestore::local::ConvertStatus;
+using firebase::firestore::local::DescribeKey;
 using firebase::firestore::local::IndexManager;
+using firebase::firestore::local::LevelDbBundleLoader;
+using firebase::firestore::local::LevelDbCompactionTracker;
 using firebase::firestore::local::LevelDbDocumentMutationKey;
 using firebase::firestore::local::LevelDbDocumentTargetKey;
 using firebase::firestore::local::LevelDbIndexManager;
 using firebase::firestore::local::LevelDbMigrations;
 using firebase::firestore::local::LevelDbMutationKey;
 using firebase::firestore::local::LevelDbMutationQueue;
+using firebase::firestore::local::LevelDbOptions;
 using firebase::firestore::local::LevelDbQueryCache;
 using firebase::firestore::local::LevelDbRemoteDocumentCache;
+using firebase::firestore::local::LevelDbSnapshot;
+using firebase::firestore::local::LevelDbSnapshotScope;
 using firebase::firestore::local::LevelDbTransaction;
 using firebase::firestore::local::ListenSequence;
 using firebase::firestore::local::LruParams;
 using firebase::firestore::local::OrphanedDocumentCallback;
 using firebase::firestore::local::ReferenceSet;
 using firebase::firestore::local::RemoteDocumentCache;
+using firebase::firestore::local::StartupProfile;
 using firebase::firestore::local::TargetCallback;
+using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::CreateAutoId;
+using firebase::firestore::util::DelayedOperation;
+using firebase::firestore::util::DirectoryIterator;
+using firebase::firestore::util::MappedFile;
 using firebase::firestore::util::OrderedCode;
 using firebase::firestore::util::Path;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StatusOr;
 using firebase::firestore::util::StringFormat;
+using firebase::firestore::util::TimerId;
 using leveldb::DB;
 using leveldb::Options;
 using leveldb::ReadOptions;
@@ -93,6 +125,50 @@ using leveldb::WriteOptions;
 
 static const char *kReservedPathComponent = "firestore";
 
+/**
+ * The name of the directory, next to the database directory, that cleared databases are moved to
+ * before they are deleted in the background.
+ */
+static const char *kTrashPathComponent = "trash";
+
+/** Returns the serial queue on which the contents of trash directories are deleted. */
+static dispatch_queue_t TrashDeletionQueue() {
+  static dispatch_queue_t queue;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    queue = dispatch_queue_create("com.google.firebase.firestore.trash", DISPATCH_QUEUE_SERIAL);
+  });
+  return queue;
+}
+
+/** Deletes everything in the given trash directory, including what earlier clears left behind. */
+static void EmptyTrash(const Path &trashDir) {
+  std::vector<Path> entries;
+  auto iter = DirectoryIterator::Create(trashDir);
+  for (; iter->Valid(); iter->Next()) {
+    entries.push_back(iter->file());
+  }
+  for (const Path &entry : entries) {
+    Status status = util::RecursivelyDelete(entry);
+    if (!status.ok()) {
+      LOG_WARN("Could not delete cleared persistence at %s: %s", entry.ToUtf8String(),
+               status.ToString());
+    }
+  }
+}
+
+/**
+ * The number of changed keys past which a group of committed transactions is written to disk
+ * without waiting for the group commit window to elapse, to bound the memory the group takes.
+ */
+static const size_t kMaxGroupCommitChangedKeys = 1000;
+
+/**
+ * How long transactions must have stopped for before the ranges where many rows were deleted are
+ * compacted.
+ */
+static const std::chrono::milliseconds kIdleCompactionDelay{10 * 1000};
+
 @interface FSTLevelDB ()
 
 - (size_t)byteSize;
@@ -184,6 +260,15 @@ static const char *kReservedPathComponent = "firestore";
   [self writeSentinelForKey:key];
 }
 
+- (void)removeReferences:(const DocumentKeySet &)keys {
+  // Every key gets the same sequence number, so encode it only once.
+  std::string encodedSequenceNumber =
+      LevelDbDocumentTargetKey::EncodeSentinelValue([self currentSequenceNumber]);
+  for (const DocumentKey &key : keys) {
+    _db.currentTransaction->Put(LevelDbDocumentTargetKey::SentinelKey(key), encodedSequenceNumber);
+  }
+}
+
 - (BOOL)mutationQueuesContainKey:(const DocumentKey &)docKey {
   const std::set<std::string> &users = _db.users;
   const ResourcePath &path = docKey.path();
@@ -281,6 +366,16 @@ static const char *kReservedPathComponent = "firestore";
 @implementation FSTLevelDB {
   Path _directory;
   std::unique_ptr<LevelDbTransaction> _transaction;
+  // With group commit enabled, the merged transactions committed since the last write to disk.
+  std::unique_ptr<LevelDbTransaction> _pendingCommit;
+  std::chrono::milliseconds _groupCommitWindow;
+  std::shared_ptr<AsyncQueue> _groupCommitQueue;
+  DelayedOperation _groupCommitFlush;
+  LevelDbCompactionTracker _compactionTracker;
+  std::shared_ptr<AsyncQueue> _compactionQueue;
+  DelayedOperation _idleCompaction;
+  // Declared before `_ptr` so that the database is destroyed before the options it refers to.
+  std::unique_ptr<LevelDbOptions> _options;
   std::unique_ptr<leveldb::DB> _ptr;
   std::unique_ptr<LevelDbRemoteDocumentCache> _documentCache;
   std::unique_ptr<LevelDbIndexManager> _indexManager;
@@ -289,6 +384,11 @@ static const char *kReservedPathComponent = "firestore";
   std::unique_ptr<LevelDbQueryCache> _queryCache;
   std::set<std::string> _users;
   std::unique_ptr<LevelDbMutationQueue> _currentMutationQueue;
+  StartupProfile _startupProfile;
+  // The number of snapshot reads started but not yet finished on other threads.
+  std::mutex _snapshotReadsMutex;
+  std::condition_variable _snapshotReadsDone;
+  int _activeSnapshotReads;
 }
 
 /**
@@ -322,47 +422,132 @@ static const char *kReservedPathComponent = "firestore";
                                            lruParams:
                                                (firebase::firestore::local::LruParams)lruParams
                                                  ptr:(FSTLevelDB **)ptr {
+  return [self dbWithDirectory:std::move(directory)
+                    serializer:serializer
+                     lruParams:lruParams
+        documentCacheSizeBytes:Settings::DefaultDocumentCacheSizeBytes
+                           ptr:ptr];
+}
+
++ (firebase::firestore::util::Status)dbWithDirectory:(firebase::firestore::util::Path)directory
+                                          serializer:(FSTLocalSerializer *)serializer
+                                           lruParams:
+                                               (firebase::firestore::local::LruParams)lruParams
+                              documentCacheSizeBytes:(size_t)documentCacheSizeBytes
+                                                 ptr:(FSTLevelDB **)ptr {
+  return [self dbWithDirectory:std::move(directory)
+                     serializer:serializer
+                      lruParams:lruParams
+         documentCacheSizeBytes:documentCacheSizeBytes
+              persistenceTuning:PersistenceTuning{}
+                            ptr:ptr];
+}
+
++ (firebase::firestore::util::Status)dbWithDirectory:(firebase::firestore::util::Path)directory
+                                          serializer:(FSTLocalSerializer *)serializer
+                                           lruParams:
+                                               (firebase::firestore::local::LruParams)lruParams
+                              documentCacheSizeBytes:(size_t)documentCacheSizeBytes
+                                   persistenceTuning:(const PersistenceTuning &)tuning
+                                                 ptr:(FSTLevelDB **)ptr {
   Status status = [self ensureDirectory:directory];
   if (!status.ok()) return status;
 
-  StatusOr<std::unique_ptr<DB>> database = [self createDBWithDirectory:directory];
+  using Clock = std::chrono::steady_clock;
+  StartupProfile profile;
+  Clock::time_point stepStart = Clock::now();
+  auto endStep = [&](StartupProfile::Duration *duration) {
+    Clock::time_point now = Clock::now();
+    *duration = std::chrono::duration_cast<StartupProfile::Duration>(now - stepStart);
+    stepStart = now;
+  };
+
+  auto options = absl::make_unique<LevelDbOptions>(tuning);
+  StatusOr<std::unique_ptr<DB>> database = [self createDBWithDirectory:directory
+                                                               options:options->options()];
   if (!database.status().ok()) {
     return database.status();
   }
+  endStep(&profile.open_time);
 
   std::unique_ptr<DB> ldb = std::move(database.ValueOrDie());
   LevelDbMigrations::RunMigrations(ldb.get());
+  if (tuning.document_compression_enabled) {
+    LevelDbMigrations::EnsureDocumentDictionary(ldb.get());
+  }
+  absl::optional<std::string> documentDictionary =
+      LevelDbMigrations::ReadDocumentDictionary(ldb.get());
+  endStep(&profile.migration_time);
+
   LevelDbTransaction transaction(ldb.get(), "Start LevelDB");
   std::set<std::string> users = [self collectUserSet:&transaction];
   transaction.Commit();
   FSTLevelDB *db = [[self alloc] initWithLevelDB:std::move(ldb)
+                                         options:std::move(options)
                                            users:users
                                        directory:directory
                                       serializer:serializer
-                                       lruParams:lruParams];
+                                       lruParams:lruParams
+                          documentCacheSizeBytes:documentCacheSizeBytes
+                              documentDictionary:std::move(documentDictionary)
+                               compressDocuments:tuning.document_compression_enabled];
+  endStep(&profile.persistence_start_time);
+  db->_startupProfile = profile;
   *ptr = db;
   return Status::OK();
 }
 
-+ (Status)clearPersistence:(const DatabaseInfo &)databaseInfo {
++ (Status)clearPersistence:(const DatabaseInfo &)databaseInfo deferDeletion:(BOOL)deferDeletion {
   Path levelDBDir = [FSTLevelDB storageDirectoryForDatabaseInfo:databaseInfo
                                              documentsDirectory:[FSTLevelDB documentsDirectory]];
   LOG_DEBUG("Clearing persistence for path: %s", levelDBDir.ToUtf8String());
-  return util::RecursivelyDelete(levelDBDir);
+  if (!deferDeletion) {
+    return util::RecursivelyDelete(levelDBDir);
+  }
+
+  // Renaming takes the same time however large the database is, and leaves the way clear for a new
+  // database to be opened right away. The trash directory itself is never deleted, so that a clear
+  // can't race with the deletion of the trash of an earlier one.
+  Path trashDir = levelDBDir.Dirname().AppendUtf8(kTrashPathComponent);
+  Status status = util::RecursivelyCreateDir(trashDir);
+  if (status.ok()) {
+    status = util::Rename(levelDBDir, trashDir.AppendUtf8(CreateAutoId()));
+    if (status.code() == Error::NotFound) {
+      // There's no database to clear.
+      status = Status::OK();
+    }
+  }
+  if (!status.ok()) {
+    LOG_WARN("Could not move %s out of the way, deleting it in place: %s",
+             levelDBDir.ToUtf8String(), status.ToString());
+    return util::RecursivelyDelete(levelDBDir);
+  }
+
+  dispatch_async(TrashDeletionQueue(), ^{
+    EmptyTrash(trashDir);
+  });
+  return Status::OK();
 }
 
 - (instancetype)initWithLevelDB:(std::unique_ptr<leveldb::DB>)db
+                        options:(std::unique_ptr<LevelDbOptions>)options
                           users:(std::set<std::string>)users
                       directory:(firebase::firestore::util::Path)directory
                      serializer:(FSTLocalSerializer *)serializer
-                      lruParams:(firebase::firestore::local::LruParams)lruParams {
+                      lruParams:(firebase::firestore::local::LruParams)lruParams
+         documentCacheSizeBytes:(size_t)documentCacheSizeBytes
+             documentDictionary:(absl::optional<std::string>)documentDictionary
+              compressDocuments:(BOOL)compressDocuments {
   if (self = [super init]) {
     self.started = YES;
+    _options = std::move(options);
     _ptr = std::move(db);
     _directory = std::move(directory);
     _serializer = serializer;
     _queryCache = absl::make_unique<LevelDbQueryCache>(self, _serializer);
-    _documentCache = absl::make_unique<LevelDbRemoteDocumentCache>(self, _serializer);
+    _documentCache = absl::make_unique<LevelDbRemoteDocumentCache>(
+        self, _serializer, documentCacheSizeBytes, std::move(documentDictionary),
+        compressDocuments);
     _indexManager = absl::make_unique<LevelDbIndexManager>(self);
     _referenceDelegate = [[FSTLevelDBLRUDelegate alloc] initWithPersistence:self
                                                                   lruParams:lruParams];
@@ -459,10 +644,8 @@ static const char *kReservedPathComponent = "firestore";
 }
 
 /** Opens the database within the given directory. */
-+ (StatusOr<std::unique_ptr<DB>>)createDBWithDirectory:(const Path &)directory {
-  Options options;
-  options.create_if_missing = true;
-
++ (StatusOr<std::unique_ptr<DB>>)createDBWithDirectory:(const Path &)directory
+                                               options:(const Options &)options {
   DB *database = nullptr;
   leveldb::Status status = DB::Open(options, directory.ToUtf8String(), &database);
   if (!status.ok()) {
@@ -474,14 +657,61 @@ static const char *kReservedPathComponent = "firestore";
   return std::unique_ptr<DB>(database);
 }
 
+- (const StartupProfile &)startupProfile {
+  return _startupProfile;
+}
+
 - (LevelDbTransaction *)currentTransaction {
+  if (LevelDbSnapshot *snapshot = LevelDbSnapshot::current()) {
+    return snapshot->transaction();
+  }
   HARD_ASSERT(_transaction != nullptr, "Attempting to access transaction before one has started");
   return _transaction.get();
 }
 
+- (BOOL)runSnapshotRead:(absl::string_view)label
+                onQueue:(dispatch_queue_t)queue
+                  block:(std::function<void()>)block {
+  HARD_ASSERT(_transaction == nullptr, "Starting a snapshot read inside a transaction");
+  if (!LevelDbSnapshot::ScopesSupported() || _pendingCommit || !self.isStarted) {
+    return NO;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{_snapshotReadsMutex};
+    ++_activeSnapshotReads;
+  }
+  std::string name{label};
+  dispatch_async(queue, ^{
+    {
+      LevelDbSnapshot snapshot{self->_ptr.get(), name};
+      LevelDbSnapshotScope scope{&snapshot};
+      block();
+    }
+    std::lock_guard<std::mutex> lock{self->_snapshotReadsMutex};
+    if (--self->_activeSnapshotReads == 0) {
+      self->_snapshotReadsDone.notify_all();
+    }
+  });
+  return YES;
+}
+
+/**
+ * Blocks until all snapshot reads have finished, so that what they read through can be replaced
+ * or destroyed. No new ones start meanwhile, since they are only started on the worker queue.
+ */
+- (void)waitForSnapshotReads {
+  std::unique_lock<std::mutex> lock{_snapshotReadsMutex};
+  _snapshotReadsDone.wait(lock, [self] { return self->_activeSnapshotReads == 0; });
+}
+
 #pragma mark - Persistence Factory methods
 
 - (LevelDbMutationQueue *)mutationQueueForUser:(const User &)user {
+  // Starting the queue looks for the largest batch ID directly in the database, so any batches
+  // held back by group commit must be on disk first.
+  [self flushPendingCommits];
+  [self waitForSnapshotReads];
   _users.insert(user.uid());
   _currentMutationQueue.reset(new LevelDbMutationQueue(user, self, self.serializer));
   return _currentMutationQueue.get();
@@ -500,24 +730,146 @@ static const char *kReservedPathComponent = "firestore";
 }
 
 - (void)startTransaction:(absl::string_view)label {
+  // Inside a snapshot read, transactions read through the snapshot instead.
+  if (LevelDbSnapshot::current()) {
+    return;
+  }
   HARD_ASSERT(_transaction == nullptr, "Starting a transaction while one is already outstanding");
-  _transaction = absl::make_unique<LevelDbTransaction>(_ptr.get(), label);
+  if (_pendingCommit) {
+    // Continue the group, so that this transaction sees the changes not yet written to disk.
+    _transaction = std::move(_pendingCommit);
+  } else {
+    _transaction = absl::make_unique<LevelDbTransaction>(
+        _ptr.get(), label, LevelDbTransaction::DefaultReadOptions(), _options->write_options());
+  }
   [_referenceDelegate transactionWillStart];
 }
 
 - (void)commitTransaction {
+  if (LevelDbSnapshot::current()) {
+    return;
+  }
   HARD_ASSERT(_transaction != nullptr, "Committing a transaction before one is started");
   [_referenceDelegate transactionWillCommit];
-  _transaction->Commit();
-  _transaction.reset();
+  if (!_groupCommitQueue) {
+    _compactionTracker.RecordDeletes(_transaction->deletions());
+    _transaction->Commit();
+    _transaction.reset();
+    [self scheduleIdleCompaction];
+    return;
+  }
+
+  _pendingCommit = std::move(_transaction);
+  if (_pendingCommit->changed_keys() >= kMaxGroupCommitChangedKeys) {
+    [self flushPendingCommits];
+  } else if (!_groupCommitFlush) {
+    _groupCommitFlush =
+        _groupCommitQueue->EnqueueAfterDelay(_groupCommitWindow, TimerId::GroupCommitFlush, [self] {
+          self->_groupCommitFlush = DelayedOperation{};
+          [self flushPendingCommits];
+          [self scheduleIdleCompaction];
+        });
+  }
+  [self scheduleIdleCompaction];
+}
+
+- (void)enableGroupCommitWithWindow:(std::chrono::milliseconds)window
+                              queue:(std::shared_ptr<AsyncQueue>)queue {
+  HARD_ASSERT(window.count() > 0, "Group commit window must be positive");
+  _groupCommitWindow = window;
+  _groupCommitQueue = std::move(queue);
+}
+
+- (void)flushPendingCommits {
+  _groupCommitFlush.Cancel();
+  if (_pendingCommit) {
+    _compactionTracker.RecordDeletes(_pendingCommit->deletions());
+    _pendingCommit->Commit();
+    _pendingCommit.reset();
+  }
+}
+
+- (void)enableIdleCompactionWithQueue:(std::shared_ptr<AsyncQueue>)queue {
+  _compactionQueue = std::move(queue);
+}
+
+- (void)scheduleIdleCompaction {
+  if (!_compactionQueue || (!_idleCompaction && !_compactionTracker.compaction_due())) return;
+
+  // Push back a compaction already scheduled, so that it waits for transactions to stop.
+  _idleCompaction.Cancel();
+  _idleCompaction =
+      _compactionQueue->EnqueueAfterDelay(kIdleCompactionDelay, TimerId::IdleCompaction, [self] {
+        self->_idleCompaction = DelayedOperation{};
+        [self flushPendingCommits];
+        for (LevelDbCompactionTracker::KeyRange &range :
+             self->_compactionTracker.TakeRangesToCompact()) {
+          // Compacting a range can take a while, so let other work go first.
+          self->_compactionQueue->EnqueueBackground([self, range] {
+            if (!self.isStarted) return;
+            leveldb::Slice begin{range.begin};
+            leveldb::Slice end{range.end};
+            self->_ptr->CompactRange(&begin, &end);
+            LOG_DEBUG("Compacted deleted rows from %s to %s", DescribeKey(range.begin),
+                      DescribeKey(range.end));
+          });
+        }
+      });
+}
+
+- (Status)loadBundleAtPath:(const Path &)path databaseID:(const DatabaseId &)databaseID {
+  HARD_ASSERT(_transaction == nullptr, "Loading a bundle while a transaction is running");
+  [self flushPendingCommits];
+
+  StatusOr<std::unique_ptr<MappedFile>> file = MappedFile::Open(path);
+  if (!file.ok()) return file.status();
+
+  LevelDbBundleLoader loader{_ptr.get(), databaseID};
+  StatusOr<LevelDbBundleLoader::Result> loaded = loader.Load(file.ValueOrDie()->contents());
+  if (!loaded.ok()) return loaded.status();
+  const LevelDbBundleLoader::Result &result = loaded.ValueOrDie();
+
+  // The loader wrote the target metadata and sentinel rows behind the caches' backs.
+  _queryCache->Start();
+  [_referenceDelegate start];
+
+  if (!result.documents_to_index.empty()) {
+    self.run("Index bundled documents", [&]() {
+      for (const DocumentKey &key : result.documents_to_index) {
+        FSTMaybeDocument *document = _documentCache->Get(key);
+        if ([document isKindOfClass:[FSTDocument class]]) {
+          _indexManager->AddToFieldIndexes(key, static_cast<FSTDocument *>(document).data);
+        } else {
+          _indexManager->RemoveFromFieldIndexes(key);
+        }
+      }
+    });
+  }
+
+  LOG_DEBUG("Loaded %s documents and %s queries from bundle %s", result.document_count,
+            result.query_count, path.ToUtf8String());
+  return Status::OK();
 }
 
 - (void)shutdown {
   HARD_ASSERT(self.isStarted, "FSTLevelDB shutdown without start!");
+  [self waitForSnapshotReads];
+  [self flushPendingCommits];
+  _idleCompaction.Cancel();
   self.started = NO;
   _ptr.reset();
 }
 
+- (void)trimMemoryToBudget:(size_t)budgetBytes {
+  // Split the budget evenly: documents are read more often, but pending batches are replayed on
+  // every local read.
+  _documentCache->TrimMemory(budgetBytes / 2);
+  if (_currentMutationQueue) {
+    _currentMutationQueue->TrimMemory(budgetBytes / 2);
+  }
+  _indexManager->TrimMemory();
+}
+
 - (id<FSTReferenceDelegate>)referenceDelegate {
   return _referenceDelegate;
 }
@@ -16,6 +16,8 @@
 
 #import <Foundation/Foundation.h>
 
+#include <string>
+
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 
 @class FSTMaybeDocument;
@@ -44,11 +46,25 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)initWithRemoteSerializer:(FSTSerializerBeta *)remoteSerializer;
 
+/**
+ * Creates a serializer that, if `relativeDocumentNames` is true, stores the names of documents
+ * and the references in them relative to the database, which saves repeating the database in
+ * every document. Documents stored either way can be read back.
+ */
+- (instancetype)initWithRemoteSerializer:(FSTSerializerBeta *)remoteSerializer
+                   relativeDocumentNames:(BOOL)relativeDocumentNames;
+
 - (instancetype)init NS_UNAVAILABLE;
 
 /** Encodes an FSTMaybeDocument model to the equivalent protocol buffer for local storage. */
 - (FSTPBMaybeDocument *)encodedMaybeDocument:(FSTMaybeDocument *)document;
 
+/**
+ * Encodes an FSTMaybeDocument model for local storage as the bytes of the equivalent protocol
+ * buffer. A document that kept the bytes it was received in is stored without encoding it again.
+ */
+- (std::string)encodedMaybeDocumentBytes:(FSTMaybeDocument *)document;
+
 /** Decodes an FSTPBMaybeDocument proto to the equivalent model. */
 - (FSTMaybeDocument *)decodedMaybeDocument:(FSTPBMaybeDocument *)proto;
 
@@ -17,6 +17,7 @@
 #import "Firestore/Source/Local/FSTLocalSerializer.h"
 
 #include <cinttypes>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -32,32 +33,58 @@
 #import "Firestore/Source/Remote/FSTSerializerBeta.h"
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
+#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 
 using firebase::Timestamp;
+using firebase::firestore::local::LocalSerializer;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentState;
+using firebase::firestore::model::FieldValue;
 using firebase::firestore::model::ListenSequenceNumber;
-using firebase::firestore::model::ObjectValue;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
+using firebase::firestore::util::Counter;
+using firebase::firestore::util::MakeString;
+using firebase::firestore::util::MetricsRegistry;
 
 @interface FSTLocalSerializer ()
 
 @property(nonatomic, strong, readonly) FSTSerializerBeta *remoteSerializer;
 
+/** The serializer for the names and fields of documents, which may write relative names. */
+@property(nonatomic, strong, readonly) FSTSerializerBeta *documentSerializer;
+
 @end
 
 /** Serializer for values stored in the LocalStore. */
-@implementation FSTLocalSerializer
+@implementation FSTLocalSerializer {
+  /** What's removed from the names of documents kept encoded as received, if anything. */
+  std::string _documentNamePrefix;
+}
 
 - (instancetype)initWithRemoteSerializer:(FSTSerializerBeta *)remoteSerializer {
+  return [self initWithRemoteSerializer:remoteSerializer relativeDocumentNames:NO];
+}
+
+- (instancetype)initWithRemoteSerializer:(FSTSerializerBeta *)remoteSerializer
+                   relativeDocumentNames:(BOOL)relativeDocumentNames {
   self = [super init];
   if (self) {
     _remoteSerializer = remoteSerializer;
+    if (relativeDocumentNames) {
+      _documentSerializer =
+          [[FSTSerializerBeta alloc] initWithDatabaseID:[remoteSerializer databaseID]
+                                          relativeNames:YES];
+      _documentNamePrefix = MakeString([remoteSerializer encodedDatabaseID]) + "/";
+    } else {
+      _documentSerializer = remoteSerializer;
+    }
   }
   return self;
 }
@@ -88,7 +115,27 @@ using firebase::firestore::model::TargetId;
   return proto;
 }
 
+- (std::string)encodedMaybeDocumentBytes:(FSTMaybeDocument *)document {
+  if ([document isKindOfClass:[FSTDocument class]]) {
+    FSTDocument *existingDocument = (FSTDocument *)document;
+    NSData *encodedProto = existingDocument.encodedProto;
+    if (encodedProto != nil) {
+      absl::string_view documentBytes{static_cast<const char *>(encodedProto.bytes),
+                                      encodedProto.length};
+      return LocalSerializer::EncodeMaybeDocumentBytes(
+          documentBytes, existingDocument.hasCommittedMutations, _documentNamePrefix);
+    }
+  }
+
+  NSData *data = [[self encodedMaybeDocument:document] data];
+  return std::string{static_cast<const char *>(data.bytes), data.length};
+}
+
 - (FSTMaybeDocument *)decodedMaybeDocument:(FSTPBMaybeDocument *)proto {
+  static Counter &documentsDecoded =
+      MetricsRegistry::Default().GetCounter("local.documents_decoded");
+  documentsDecoded.Increment();
+
   switch (proto.documentTypeOneOfCase) {
     case FSTPBMaybeDocument_DocumentType_OneOfCase_Document:
       return [self decodedDocument:proto.document
@@ -111,12 +158,12 @@ using firebase::firestore::model::TargetId;
  * that it preserves the updateTime, which is considered an output only value by the server.
  */
 - (GCFSDocument *)encodedDocument:(FSTDocument *)document {
-  FSTSerializerBeta *remoteSerializer = self.remoteSerializer;
+  FSTSerializerBeta *documentSerializer = self.documentSerializer;
 
   GCFSDocument *proto = [GCFSDocument message];
-  proto.name = [remoteSerializer encodedDocumentKey:document.key];
-  proto.fields = [remoteSerializer encodedFields:document.data];
-  proto.updateTime = [remoteSerializer encodedVersion:document.version];
+  proto.name = [documentSerializer encodedDocumentKey:document.key];
+  proto.fields = [documentSerializer encodedFields:document.data];
+  proto.updateTime = [documentSerializer encodedVersion:document.version];
 
   return proto;
 }
@@ -126,23 +173,29 @@ using firebase::firestore::model::TargetId;
           withCommittedMutations:(BOOL)committedMutations {
   FSTSerializerBeta *remoteSerializer = self.remoteSerializer;
 
-  ObjectValue data = [remoteSerializer decodedFields:document.fields];
   DocumentKey key = [remoteSerializer decodedDocumentKey:document.name];
   SnapshotVersion version = [remoteSerializer decodedVersion:document.updateTime];
-  return [FSTDocument documentWithData:std::move(data)
-                                   key:std::move(key)
-                               version:version
-                                 state:committedMutations ? DocumentState::kCommittedMutations
-                                                          : DocumentState::kSynced];
+
+  // Most documents read from the cache are only examined by a query's filters, so defer decoding
+  // their fields until they're needed. The proto is the same one encodedDocument: would produce,
+  // so it also saves re-encoding the document if it's written back unchanged.
+  return [FSTDocument documentWithProto:document
+                                    key:std::move(key)
+                                version:version
+                                  state:committedMutations ? DocumentState::kCommittedMutations
+                                                           : DocumentState::kSynced
+                                decoder:^FieldValue(GCFSValue *value) {
+                                  return [remoteSerializer decodedFieldValue:value];
+                                }];
 }
 
 /** Encodes a NoDocument value to the equivalent proto. */
 - (FSTPBNoDocument *)encodedDeletedDocument:(FSTDeletedDocument *)document {
-  FSTSerializerBeta *remoteSerializer = self.remoteSerializer;
+  FSTSerializerBeta *documentSerializer = self.documentSerializer;
 
   FSTPBNoDocument *proto = [FSTPBNoDocument message];
-  proto.name = [remoteSerializer encodedDocumentKey:document.key];
-  proto.readTime = [remoteSerializer encodedVersion:document.version];
+  proto.name = [documentSerializer encodedDocumentKey:document.key];
+  proto.readTime = [documentSerializer encodedVersion:document.version];
   return proto;
 }
 
@@ -160,11 +213,11 @@ using firebase::firestore::model::TargetId;
 
 /** Encodes an UnknownDocument value to the equivalent proto. */
 - (FSTPBUnknownDocument *)encodedUnknownDocument:(FSTUnknownDocument *)document {
-  FSTSerializerBeta *remoteSerializer = self.remoteSerializer;
+  FSTSerializerBeta *documentSerializer = self.documentSerializer;
 
   FSTPBUnknownDocument *proto = [FSTPBUnknownDocument message];
-  proto.name = [remoteSerializer encodedDocumentKey:document.key];
-  proto.version = [remoteSerializer encodedVersion:document.version];
+  proto.name = [documentSerializer encodedDocumentKey:document.key];
+  proto.version = [documentSerializer encodedVersion:document.version];
   return proto;
 }
 
@@ -16,6 +16,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <functional>
 #include <vector>
 
 #import "Firestore/Source/Local/FSTLRUGarbageCollector.h"
@@ -23,11 +24,14 @@
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
 #include "Firestore/core/src/firebase/firestore/local/local_view_changes.h"
 #include "Firestore/core/src/firebase/firestore/local/local_write_result.h"
+#include "Firestore/core/src/firebase/firestore/local/pending_writes.h"
+#include "Firestore/core/src/firebase/firestore/local/startup_profile.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -101,6 +105,19 @@ NS_ASSUME_NONNULL_BEGIN
 /** Performs any initial startup actions required by the local store. */
 - (void)start;
 
+/**
+ * Like -start, but if `deferMutationQueue` is YES starting the mutation queue is left to
+ * -finishStart, or to the first operation that needs the queue, so that reads from the cache can
+ * be served sooner.
+ */
+- (void)startDeferringMutationQueue:(BOOL)deferMutationQueue;
+
+/** Starts the mutation queue if -startDeferringMutationQueue: left it unstarted. */
+- (void)finishStart;
+
+/** How long the steps of starting the local store took; the persistence steps are left zero. */
+@property(nonatomic, readonly) const local::StartupProfile &startupProfile;
+
 /**
  * Tells the FSTLocalStore that the currently authenticated user has changed.
  *
@@ -112,9 +129,23 @@ NS_ASSUME_NONNULL_BEGIN
 /** Accepts locally generated Mutations and commits them to storage. */
 - (local::LocalWriteResult)locallyWriteMutations:(std::vector<FSTMutation *> &&)mutations;
 
+/**
+ * Whether -locallyWriteMutations: merges a write into the last pending batch when both touch the
+ * same documents and the batch hasn't been handed to the remote store yet. The mutations to each
+ * document are combined where that doesn't change their effect, and the merged batch replaces the
+ * earlier one (see LocalWriteResult::merged_batch_id()). Defaults to NO.
+ */
+@property(nonatomic, assign, getter=isMutationCompactionEnabled) BOOL mutationCompactionEnabled;
+
 /** Returns the current value of a document with a given key, or nil if not found. */
 - (nullable FSTMaybeDocument *)readDocument:(const model::DocumentKey &)key;
 
+/**
+ * Returns the current values of the documents with the given keys, read in a single transaction.
+ * Documents that aren't found are reported as deleted at version zero.
+ */
+- (model::MaybeDocumentMap)readDocuments:(const model::DocumentKeySet &)keys;
+
 /**
  * Acknowledges the given batch.
  *
@@ -130,6 +161,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (model::MaybeDocumentMap)acknowledgeBatchWithResult:(FSTMutationBatchResult *)batchResult;
 
+/**
+ * Acknowledges several batches, in the order the backend acknowledged them, in a single
+ * transaction.
+ *
+ * @return The resulting (modified) documents of all the batches.
+ */
+- (model::MaybeDocumentMap)acknowledgeBatchesWithResults:
+    (const std::vector<FSTMutationBatchResult *> &)batchResults;
+
 /**
  * Removes mutations from the MutationQueue for the specified batch. LocalDocuments will be
  * recalculated.
@@ -138,6 +178,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (model::MaybeDocumentMap)rejectBatchID:(model::BatchId)batchID;
 
+/** Returns the backlog of mutation batches of the current user. */
+- (local::PendingWrites)pendingWrites;
+
+/**
+ * Sets a function to notify of the backlog of mutation batches of the current user after every
+ * write, acknowledgement, rejection and user change.
+ */
+- (void)setPendingWritesObserver:(std::function<void(const local::PendingWrites &)>)observer;
+
 /** Returns the last recorded stream token for the current user. */
 - (nullable NSData *)lastStreamToken;
 
@@ -163,6 +212,22 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (model::MaybeDocumentMap)applyRemoteEvent:(const remote::RemoteEvent &)remoteEvent;
 
+/**
+ * How far, in seconds of snapshot time, -applyRemoteEvent: lets a target move on before writing its
+ * new resume token even though none of its documents changed. Defaults to five minutes.
+ */
+@property(nonatomic, assign) int64_t resumeTokenMaxAgeSeconds;
+
+/**
+ * Whether -applyRemoteEvent: holds back the targets it would write with new resume tokens, so that
+ * -persistPendingTargets can write all of them at once. The held back targets are still used while
+ * they're active, and written when released. Defaults to NO.
+ */
+@property(nonatomic, assign, getter=isTargetPersistenceDeferred) BOOL targetPersistenceDeferred;
+
+/** Writes the targets held back by -applyRemoteEvent:, if any, in a single transaction. */
+- (void)persistPendingTargets;
+
 /**
  * Returns the keys of the documents that are associated with the given targetID in the remote
  * table.
@@ -181,6 +246,29 @@ NS_ASSUME_NONNULL_BEGIN
 /** Runs @a query against all the documents in the local store and returns the results. */
 - (model::DocumentMap)executeQuery:(FSTQuery *)query;
 
+/**
+ * Returns YES if -executeQuery: only reads from persistence for @a query, so that it can run in a
+ * snapshot read. Queries that could build a field index write to persistence, and those answered
+ * from their target's documents use the query cache, which is only safe to use on the worker queue.
+ */
+- (BOOL)canExecuteQueryInSnapshot:(FSTQuery *)query;
+
+/**
+ * Runs the collection query @a query against all the documents in the local store and returns one
+ * page of the results: the first @a pageSize documents in key order after @a startAfter, if given.
+ * The query's own limit and sort order are ignored.
+ */
+- (model::DocumentMap)executeQuery:(FSTQuery *)query
+                        startAfter:(const absl::optional<model::DocumentKey> &)startAfter
+                          pageSize:(size_t)pageSize;
+
+/**
+ * Whether -executeQuery: answers a collection query that has a target with a resume token from
+ * the documents of the target as of its snapshot, plus the documents read or mutated since,
+ * instead of scanning the whole collection. Defaults to NO.
+ */
+@property(nonatomic, assign, getter=isQueryFromTargetKeysEnabled) BOOL queryFromTargetKeysEnabled;
+
 /** Notify the local store of the changed views to locally pin / unpin documents. */
 - (void)notifyLocalViewChanges:(const std::vector<local::LocalViewChanges> &)viewChanges;
 
@@ -192,8 +280,23 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nullable FSTMutationBatch *)nextMutationBatchAfterBatchID:(model::BatchId)batchID;
 
+/**
+ * Gets up to `maxCount` mutation batches after the passed in batchId in the mutation queue, in a
+ * single transaction.
+ *
+ * @param batchID The batch to search after, or -1 to start with the first mutation in the queue.
+ * @param maxBytes The encoded size past which no more batches are read, or zero for no limit.
+ * @return the batches found, in order.
+ */
+- (std::vector<FSTMutationBatch *>)nextMutationBatchesAfterBatchID:(model::BatchId)batchID
+                                                          maxCount:(size_t)maxCount
+                                                          maxBytes:(size_t)maxBytes;
+
 - (local::LruResults)collectGarbage:(FSTLRUGarbageCollector *)garbageCollector;
 
+/** Runs a single slice of an incremental garbage collection, in a transaction of its own. */
+- (local::LruResults)collectGarbageSlice:(FSTLRUGarbageCollector *)garbageCollector;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -16,6 +16,8 @@
 
 #import "Firestore/Source/Local/FSTLocalStore.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <set>
 #include <unordered_map>
@@ -33,8 +35,10 @@
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/core/target_id_generator.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
 #include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
 #include "Firestore/core/src/firebase/firestore/local/local_view_changes.h"
 #include "Firestore/core/src/firebase/firestore/local/local_write_result.h"
@@ -42,33 +46,43 @@
 #include "Firestore/core/src/firebase/firestore/local/query_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/startup_profile.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
 #include "absl/memory/memory.h"
 #include "absl/types/optional.h"
 
 using firebase::Timestamp;
 using firebase::firestore::auth::User;
+using firebase::firestore::core::Query;
 using firebase::firestore::core::TargetIdGenerator;
+using firebase::firestore::local::DocumentKeyReference;
+using firebase::firestore::local::FieldIndexScan;
 using firebase::firestore::local::LocalDocumentsView;
 using firebase::firestore::local::LocalViewChanges;
 using firebase::firestore::local::LocalWriteResult;
 using firebase::firestore::local::LruResults;
 using firebase::firestore::local::MutationQueue;
+using firebase::firestore::local::PendingWrites;
 using firebase::firestore::local::QueryCache;
 using firebase::firestore::local::ReferenceSet;
 using firebase::firestore::local::RemoteDocumentCache;
+using firebase::firestore::local::StartupProfile;
 using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeyHash;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
 using firebase::firestore::model::DocumentVersionMap;
 using firebase::firestore::model::FieldMask;
 using firebase::firestore::model::FieldPath;
+using firebase::firestore::model::kBatchIdUnknown;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::MaybeDocumentMap;
 using firebase::firestore::model::ObjectValue;
@@ -81,12 +95,61 @@ using firebase::firestore::remote::TargetChange;
 NS_ASSUME_NONNULL_BEGIN
 
 /**
- * The maximum time to leave a resume token buffered without writing it out. This value is
+ * The default maximum time to leave a resume token buffered without writing it out. This value is
  * arbitrary: it's long enough to avoid several writes (possibly indefinitely if updates come more
  * frequently than this) but short enough that restarting after crashing will still have a pretty
  * recent resume token.
  */
-static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
+static const int64_t kDefaultResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
+
+/**
+ * The number of document updates of a remote event to read the cached versions of at once. Reading
+ * them a chunk at a time keeps a large initial sync from holding a second copy of every document
+ * it changes in memory.
+ */
+static const size_t kRemoteEventDocumentChunkSize = 1000;
+
+namespace {
+
+/**
+ * Returns mutations with the same effect as `earlier` followed by `later`, combining each of the
+ * later mutations with the last earlier one to the same document where possible.
+ */
+std::vector<FSTMutation *> CombineMutations(const std::vector<FSTMutation *> &earlier,
+                                            const std::vector<FSTMutation *> &later) {
+  std::vector<FSTMutation *> result = earlier;
+  std::unordered_map<DocumentKey, size_t, DocumentKeyHash> lastIndexByKey;
+  for (size_t i = 0; i < result.size(); ++i) {
+    lastIndexByKey[result[i].key] = i;
+  }
+
+  for (FSTMutation *mutation : later) {
+    auto found = lastIndexByKey.find(mutation.key);
+    if (found != lastIndexByKey.end()) {
+      // Nothing after the last mutation to a document touches it, so replacing that one in place
+      // keeps the order of the mutations to each document.
+      FSTMutation *combined = [result[found->second] mutationByCombiningWith:mutation];
+      if (combined) {
+        result[found->second] = combined;
+        continue;
+      }
+    }
+    lastIndexByKey[mutation.key] = result.size();
+    result.push_back(mutation);
+  }
+  return result;
+}
+
+bool ContainsTransforms(const std::vector<FSTMutation *> &mutations) {
+  for (FSTMutation *mutation : mutations) {
+    if ([mutation isKindOfClass:[FSTTransformMutation class]]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
 
 @interface FSTLocalStore ()
 
@@ -115,6 +178,26 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 
   /** Maps a targetID to data about its query. */
   std::unordered_map<TargetId, FSTQueryData *> _targetIDs;
+
+  /** The active targets whose data in `_targetIDs` should be, but hasn't yet been, written. */
+  std::set<TargetId> _pendingTargetIDs;
+
+  /** Whether the current mutation queue has been started. */
+  BOOL _mutationQueueStarted;
+
+  /** The ID of the last batch written through this local store for the current user. */
+  BatchId _lastWrittenBatchID;
+
+  /**
+   * The highest ID of any batch handed to the remote store. Batches up to this one may have been
+   * sent, so they're never merged with later writes.
+   */
+  BatchId _highestRetrievedBatchID;
+
+  StartupProfile _startupProfile;
+
+  /** Notified of the backlog of the mutation queue whenever it may have changed. */
+  std::function<void(const PendingWrites &)> _pendingWritesObserver;
 }
 
 - (instancetype)initWithPersistence:(id<FSTPersistence>)persistence
@@ -129,18 +212,62 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
     [_persistence.referenceDelegate addInMemoryPins:&_localViewReferences];
 
     _targetIDGenerator = TargetIdGenerator::QueryCacheTargetIdGenerator(0);
+    _lastWrittenBatchID = kBatchIdUnknown;
+    _highestRetrievedBatchID = kBatchIdUnknown;
+    _resumeTokenMaxAgeSeconds = kDefaultResumeTokenMaxAgeSeconds;
   }
   return self;
 }
 
 - (void)start {
-  [self startMutationQueue];
+  [self startDeferringMutationQueue:NO];
+}
+
+- (void)startDeferringMutationQueue:(BOOL)deferMutationQueue {
+  using Clock = std::chrono::steady_clock;
+
+  _startupProfile.mutation_queue_deferred = deferMutationQueue;
+  if (!deferMutationQueue) {
+    [self startMutationQueue];
+  }
+
+  Clock::time_point start = Clock::now();
   TargetId targetID = _queryCache->highest_target_id();
   _targetIDGenerator = TargetIdGenerator::QueryCacheTargetIdGenerator(targetID);
+  _startupProfile.local_store_start_time =
+      std::chrono::duration_cast<StartupProfile::Duration>(Clock::now() - start);
+}
+
+- (void)finishStart {
+  [self ensureMutationQueueStarted];
+}
+
+- (const StartupProfile &)startupProfile {
+  return _startupProfile;
 }
 
 - (void)startMutationQueue {
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point start = Clock::now();
   self.persistence.run("Start MutationQueue", [&]() { _mutationQueue->Start(); });
+  if (!_mutationQueueStarted) {
+    // Only the first start is part of starting up; later ones follow user changes.
+    _startupProfile.mutation_queue_start_time =
+        std::chrono::duration_cast<StartupProfile::Duration>(Clock::now() - start);
+    _mutationQueueStarted = YES;
+  }
+}
+
+/**
+ * Starts the mutation queue if its start was deferred. Reading mutation batches doesn't depend on
+ * the queue having started, but assigning batch IDs and tracking the stream token do, so this
+ * must be called, outside of any transaction, before operations that need either.
+ */
+- (void)ensureMutationQueueStarted {
+  if (!_mutationQueueStarted) {
+    [self startMutationQueue];
+  }
 }
 
 - (MaybeDocumentMap)userDidChange:(const User &)user {
@@ -152,10 +279,12 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   // The old one has a reference to the mutation queue, so nil it out first.
   _localDocuments.reset();
   _mutationQueue = [self.persistence mutationQueueForUser:user];
+  _lastWrittenBatchID = kBatchIdUnknown;
+  _highestRetrievedBatchID = kBatchIdUnknown;
 
   [self startMutationQueue];
 
-  return self.persistence.run("NewBatches", [&]() -> MaybeDocumentMap {
+  MaybeDocumentMap changes = self.persistence.run("NewBatches", [&]() -> MaybeDocumentMap {
     std::vector<FSTMutationBatch *> newBatches = _mutationQueue->AllMutationBatches();
 
     // Recreate our LocalDocumentsView using the new MutationQueue.
@@ -175,16 +304,19 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
     // Return the set of all (potentially) changed documents as the result of the user change.
     return _localDocuments->GetDocuments(changedKeys);
   });
+  [self notifyPendingWritesObserver];
+  return changes;
 }
 
 - (LocalWriteResult)locallyWriteMutations:(std::vector<FSTMutation *> &&)mutations {
+  [self ensureMutationQueueStarted];
   Timestamp localWriteTime = Timestamp::Now();
   DocumentKeySet keys;
   for (FSTMutation *mutation : mutations) {
     keys = keys.insert(mutation.key);
   }
 
-  return self.persistence.run("Locally write mutations", [&]() -> LocalWriteResult {
+  auto result = self.persistence.run("Locally write mutations", [&]() -> LocalWriteResult {
     // Load and apply all existing mutations. This lets us compute the current base state for
     // all non-idempotent transforms before applying any additional user-provided writes.
     MaybeDocumentMap existingDocuments = _localDocuments->GetDocuments(keys);
@@ -210,41 +342,129 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
       }
     }
 
+    BatchId mergedBatchID = kBatchIdUnknown;
+    FSTMutationBatch *toMerge =
+        baseMutations.empty() ? [self pendingBatchToMergeWithMutations:mutations] : nil;
+    if (toMerge) {
+      // The merged batch is applied to documents that already reflect the earlier batch, which is
+      // fine since without transforms reapplying its mutations changes nothing.
+      mutations = CombineMutations(toMerge.mutations, mutations);
+      _mutationQueue->RemoveMutationBatch(toMerge);
+      _localDocuments->RemoveOverlays(toMerge.keys);
+      mergedBatchID = toMerge.batchID;
+    }
+
     FSTMutationBatch *batch = _mutationQueue->AddMutationBatch(
         localWriteTime, std::move(baseMutations), std::move(mutations));
+    _localDocuments->AddBatchToOverlays(batch);
+    _lastWrittenBatchID = batch.batchID;
     MaybeDocumentMap changedDocuments = [batch applyToLocalDocumentSet:existingDocuments];
-    return LocalWriteResult{batch.batchID, std::move(changedDocuments)};
+    return LocalWriteResult{batch.batchID, mergedBatchID, std::move(changedDocuments)};
   });
+  [self notifyPendingWritesObserver];
+  return result;
+}
+
+/**
+ * Returns the pending batch that a write of the given mutations should be merged into, if
+ * mutation compaction is enabled and there is one: the last batch in the queue, if it was written
+ * in this session, hasn't been handed to the remote store, and touches the same documents. Batches
+ * with transforms are never merged.
+ */
+- (nullable FSTMutationBatch *)pendingBatchToMergeWithMutations:
+    (const std::vector<FSTMutation *> &)mutations {
+  if (!self.isMutationCompactionEnabled || _lastWrittenBatchID <= _highestRetrievedBatchID ||
+      ContainsTransforms(mutations)) {
+    return nil;
+  }
+
+  FSTMutationBatch *last = _mutationQueue->LookupMutationBatch(_lastWrittenBatchID);
+  if (!last || !last.baseMutations.empty() || ContainsTransforms(last.mutations)) {
+    return nil;
+  }
+
+  DocumentKeySet lastKeys = last.keys;
+  for (FSTMutation *mutation : mutations) {
+    if (lastKeys.contains(mutation.key)) {
+      return last;
+    }
+  }
+  return nil;
 }
 
 - (MaybeDocumentMap)acknowledgeBatchWithResult:(FSTMutationBatchResult *)batchResult {
-  return self.persistence.run("Acknowledge batch", [&]() -> MaybeDocumentMap {
+  [self ensureMutationQueueStarted];
+  MaybeDocumentMap changes = self.persistence.run("Acknowledge batch", [&]() -> MaybeDocumentMap {
     FSTMutationBatch *batch = batchResult.batch;
     _mutationQueue->AcknowledgeBatch(batch, batchResult.streamToken);
-    [self applyBatchResult:batchResult];
+    MaybeDocumentMap remoteDocs = [self applyBatchResult:batchResult];
     _mutationQueue->PerformConsistencyCheck();
 
-    return _localDocuments->GetDocuments(batch.keys);
+    // The remote documents were just read and updated, so only the batches still pending on
+    // them need to be applied to get their local view.
+    return _localDocuments->GetLocalViewOfDocuments(remoteDocs);
   });
+  [self notifyPendingWritesObserver];
+  return changes;
+}
+
+- (MaybeDocumentMap)acknowledgeBatchesWithResults:
+    (const std::vector<FSTMutationBatchResult *> &)batchResults {
+  [self ensureMutationQueueStarted];
+  MaybeDocumentMap changes = self.persistence.run("Acknowledge batches", [&]() -> MaybeDocumentMap {
+    MaybeDocumentMap remoteDocs;
+    for (FSTMutationBatchResult *batchResult : batchResults) {
+      _mutationQueue->AcknowledgeBatch(batchResult.batch, batchResult.streamToken);
+      for (const auto &kv : [self applyBatchResult:batchResult]) {
+        remoteDocs = remoteDocs.insert(kv.first, kv.second);
+      }
+    }
+    _mutationQueue->PerformConsistencyCheck();
+
+    return _localDocuments->GetLocalViewOfDocuments(remoteDocs);
+  });
+  [self notifyPendingWritesObserver];
+  return changes;
 }
 
 - (MaybeDocumentMap)rejectBatchID:(BatchId)batchID {
-  return self.persistence.run("Reject batch", [&]() -> MaybeDocumentMap {
+  [self ensureMutationQueueStarted];
+  MaybeDocumentMap changes = self.persistence.run("Reject batch", [&]() -> MaybeDocumentMap {
     FSTMutationBatch *toReject = _mutationQueue->LookupMutationBatch(batchID);
     HARD_ASSERT(toReject, "Attempt to reject nonexistent batch!");
 
     _mutationQueue->RemoveMutationBatch(toReject);
+    _localDocuments->RemoveOverlays(toReject.keys);
     _mutationQueue->PerformConsistencyCheck();
 
     return _localDocuments->GetDocuments(toReject.keys);
   });
+  [self notifyPendingWritesObserver];
+  return changes;
+}
+
+- (PendingWrites)pendingWrites {
+  [self ensureMutationQueueStarted];
+  return _mutationQueue->GetPendingWrites();
+}
+
+- (void)setPendingWritesObserver:(std::function<void(const PendingWrites &)>)observer {
+  _pendingWritesObserver = std::move(observer);
+}
+
+- (void)notifyPendingWritesObserver {
+  if (_pendingWritesObserver) {
+    _pendingWritesObserver(_mutationQueue->GetPendingWrites());
+  }
 }
 
 - (nullable NSData *)lastStreamToken {
+  [self ensureMutationQueueStarted];
   return _mutationQueue->GetLastStreamToken();
 }
 
 - (void)setLastStreamToken:(nullable NSData *)streamToken {
+  [self ensureMutationQueueStarted];
   self.persistence.run("Set stream token",
                        [&]() { _mutationQueue->SetLastStreamToken(streamToken); });
 }
@@ -254,6 +474,7 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 }
 
 - (MaybeDocumentMap)applyRemoteEvent:(const RemoteEvent &)remoteEvent {
+  FIRESTORE_TRACE_SPAN("-[FSTLocalStore applyRemoteEvent:]");
   return self.persistence.run("Apply remote event", [&]() -> MaybeDocumentMap {
     // TODO(gsoltis): move the sequence number into the reference delegate.
     ListenSequenceNumber sequenceNumber = self.persistence.currentSequenceNumber;
@@ -300,49 +521,35 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
         _targetIDs[targetID] = queryData;
 
         if ([self shouldPersistQueryData:queryData oldQueryData:oldQueryData change:change]) {
-          _queryCache->UpdateTarget(queryData);
+          if (self.targetPersistenceDeferred) {
+            _pendingTargetIDs.insert(targetID);
+          } else {
+            _queryCache->UpdateTarget(queryData);
+          }
         }
       }
     }
 
     MaybeDocumentMap changedDocs;
-    const DocumentKeySet &limboDocuments = remoteEvent.limbo_document_changes();
-    DocumentKeySet updatedKeys;
-    for (const auto &kv : remoteEvent.document_updates()) {
-      updatedKeys = updatedKeys.insert(kv.first);
-    }
-    // Each loop iteration only affects its "own" doc, so it's safe to get all the remote
-    // documents in advance in a single call.
-    MaybeDocumentMap existingDocs = _remoteDocumentCache->GetAll(updatedKeys);
-
-    for (const auto &kv : remoteEvent.document_updates()) {
-      const DocumentKey &key = kv.first;
-      FSTMaybeDocument *doc = kv.second;
-      FSTMaybeDocument *existingDoc = nil;
-      auto foundExisting = existingDocs.find(key);
-      if (foundExisting != existingDocs.end()) {
-        existingDoc = foundExisting->second;
-      }
-
-      // If a document update isn't authoritative, make sure we don't apply an old document version
-      // to the remote cache. We make an exception for SnapshotVersion.MIN which can happen for
-      // manufactured events (e.g. in the case of a limbo document resolution failing).
-      if (!existingDoc || doc.version == SnapshotVersion::None() ||
-          (authoritativeUpdates.contains(doc.key) && !existingDoc.hasPendingWrites) ||
-          doc.version >= existingDoc.version) {
-        _remoteDocumentCache->Add(doc);
-        changedDocs = changedDocs.insert(key, doc);
-      } else {
-        LOG_DEBUG("FSTLocalStore Ignoring outdated watch update for %s. "
-                  "Current version: %s  Watch version: %s",
-                  key.ToString(), existingDoc.version.timestamp().ToString(),
-                  doc.version.timestamp().ToString());
+    const auto &documentUpdates = remoteEvent.document_updates();
+    auto chunkBegin = documentUpdates.begin();
+    while (chunkBegin != documentUpdates.end()) {
+      // Each loop iteration only affects its "own" doc, so it's safe to get the remote documents
+      // of a whole chunk in advance in a single call.
+      auto chunkEnd = chunkBegin;
+      DocumentKeySet chunkKeys;
+      for (size_t i = 0; i < kRemoteEventDocumentChunkSize && chunkEnd != documentUpdates.end();
+           ++i, ++chunkEnd) {
+        chunkKeys = chunkKeys.insert(chunkEnd->first);
       }
 
-      // If this was a limbo resolution, make sure we mark when it was accessed.
-      if (limboDocuments.contains(key)) {
-        [self.persistence.referenceDelegate limboDocumentUpdated:key];
-      }
+      changedDocs = [self applyDocumentUpdatesFrom:chunkBegin
+                                                to:chunkEnd
+                                      existingDocs:_remoteDocumentCache->GetAll(chunkKeys)
+                              authoritativeUpdates:authoritativeUpdates
+                                       remoteEvent:remoteEvent
+                                       changedDocs:std::move(changedDocs)];
+      chunkBegin = chunkEnd;
     }
 
     // HACK: The only reason we allow omitting snapshot version is so we can synthesize remote
@@ -361,6 +568,50 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   });
 }
 
+/**
+ * Writes the document updates of remoteEvent in [begin, end) to the remote document cache, unless
+ * they're older than the cached versions in existingDocs, and returns changedDocs with the ones
+ * written added.
+ */
+- (MaybeDocumentMap)applyDocumentUpdatesFrom:(RemoteEvent::DocumentUpdates::const_iterator)begin
+                                          to:(RemoteEvent::DocumentUpdates::const_iterator)end
+                                existingDocs:(const MaybeDocumentMap &)existingDocs
+                        authoritativeUpdates:(const DocumentKeySet &)authoritativeUpdates
+                                 remoteEvent:(const RemoteEvent &)remoteEvent
+                                 changedDocs:(MaybeDocumentMap)changedDocs {
+  const DocumentKeySet &limboDocuments = remoteEvent.limbo_document_changes();
+  for (auto it = begin; it != end; ++it) {
+    const DocumentKey &key = it->first;
+    FSTMaybeDocument *doc = it->second;
+    FSTMaybeDocument *existingDoc = nil;
+    auto foundExisting = existingDocs.find(key);
+    if (foundExisting != existingDocs.end()) {
+      existingDoc = foundExisting->second;
+    }
+
+    // If a document update isn't authoritative, make sure we don't apply an old document version
+    // to the remote cache. We make an exception for SnapshotVersion.MIN which can happen for
+    // manufactured events (e.g. in the case of a limbo document resolution failing).
+    if (!existingDoc || doc.version == SnapshotVersion::None() ||
+        (authoritativeUpdates.contains(doc.key) && !existingDoc.hasPendingWrites) ||
+        doc.version >= existingDoc.version) {
+      _remoteDocumentCache->Add(doc, remoteEvent.snapshot_version());
+      changedDocs = changedDocs.insert(key, doc);
+    } else {
+      LOG_DEBUG("FSTLocalStore Ignoring outdated watch update for %s. "
+                "Current version: %s  Watch version: %s",
+                key.ToString(), existingDoc.version.timestamp().ToString(),
+                doc.version.timestamp().ToString());
+    }
+
+    // If this was a limbo resolution, make sure we mark when it was accessed.
+    if (limboDocuments.contains(key)) {
+      [self.persistence.referenceDelegate limboDocumentUpdated:key];
+    }
+  }
+  return changedDocs;
+}
+
 /**
  * Returns YES if the newQueryData should be persisted during an update of an active target.
  * QueryData should always be persisted when a target is being released and should not call this
@@ -387,7 +638,7 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   int64_t newSeconds = newQueryData.snapshotVersion.timestamp().seconds();
   int64_t oldSeconds = oldQueryData.snapshotVersion.timestamp().seconds();
   int64_t timeDelta = newSeconds - oldSeconds;
-  if (timeDelta >= kResumeTokenMaxAgeSeconds) return YES;
+  if (timeDelta >= self.resumeTokenMaxAgeSeconds) return YES;
 
   // Otherwise if the only thing that has changed about a target is its resume token then it's not
   // worth persisting. Note that the RemoteStore keeps an in-memory view of the currently active
@@ -400,13 +651,22 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 
 - (void)notifyLocalViewChanges:(const std::vector<LocalViewChanges> &)viewChanges {
   self.persistence.run("NotifyLocalViewChanges", [&]() {
+    // Merge the changes of all the views, so that the references are updated, and the reference
+    // delegate told about the removed documents, once for the whole round.
+    std::vector<DocumentKeyReference> added;
+    std::vector<DocumentKeyReference> removed;
+    DocumentKeySet removedKeys;
     for (const LocalViewChanges &viewChange : viewChanges) {
+      for (const DocumentKey &key : viewChange.added_keys()) {
+        added.emplace_back(key, viewChange.target_id());
+      }
       for (const DocumentKey &key : viewChange.removed_keys()) {
-        [self->_persistence.referenceDelegate removeReference:key];
+        removed.emplace_back(key, viewChange.target_id());
       }
-      _localViewReferences.AddReferences(viewChange.added_keys(), viewChange.target_id());
-      _localViewReferences.AddReferences(viewChange.removed_keys(), viewChange.target_id());
+      removedKeys = removedKeys.insert_all(viewChange.removed_keys());
     }
+    [self->_persistence.referenceDelegate removeReferences:removedKeys];
+    _localViewReferences.UpdateReferences(std::move(added), std::move(removed));
   });
 }
 
@@ -415,6 +675,22 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
       self.persistence.run("NextMutationBatchAfterBatchID", [&]() -> FSTMutationBatch * {
         return _mutationQueue->NextMutationBatchAfterBatchId(batchID);
       });
+  if (result) {
+    _highestRetrievedBatchID = std::max(_highestRetrievedBatchID, result.batchID);
+  }
+  return result;
+}
+
+- (std::vector<FSTMutationBatch *>)nextMutationBatchesAfterBatchID:(BatchId)batchID
+                                                          maxCount:(size_t)maxCount
+                                                          maxBytes:(size_t)maxBytes {
+  std::vector<FSTMutationBatch *> result = self.persistence.run(
+      "NextMutationBatchesAfterBatchID", [&]() -> std::vector<FSTMutationBatch *> {
+        return _mutationQueue->NextMutationBatchesAfterBatchId(batchID, maxCount, maxBytes);
+      });
+  if (!result.empty()) {
+    _highestRetrievedBatchID = std::max(_highestRetrievedBatchID, result.back().batchID);
+  }
   return result;
 }
 
@@ -424,6 +700,25 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   });
 }
 
+- (MaybeDocumentMap)readDocuments:(const DocumentKeySet &)keys {
+  return self.persistence.run("ReadDocuments", [&]() -> MaybeDocumentMap {
+    return _localDocuments->GetDocuments(keys);
+  });
+}
+
+- (void)persistPendingTargets {
+  if (_pendingTargetIDs.empty()) return;
+
+  self.persistence.run("Persist pending targets", [&]() {
+    for (TargetId targetID : _pendingTargetIDs) {
+      auto found = _targetIDs.find(targetID);
+      HARD_ASSERT(found != _targetIDs.end(), "Pending target %s isn't active", targetID);
+      _queryCache->UpdateTarget(found->second);
+    }
+  });
+  _pendingTargetIDs.clear();
+}
+
 - (FSTQueryData *)allocateQuery:(FSTQuery *)query {
   FSTQueryData *queryData = self.persistence.run("Allocate query", [&]() -> FSTQueryData * {
     FSTQueryData *cached = _queryCache->GetTarget(query);
@@ -474,28 +769,74 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
       [self.persistence.referenceDelegate removeReference:key];
     }
     _targetIDs.erase(targetID);
+    _pendingTargetIDs.erase(targetID);
     [self.persistence.referenceDelegate removeTarget:queryData];
   });
 }
 
 - (DocumentMap)executeQuery:(FSTQuery *)query {
   return self.persistence.run("ExecuteQuery", [&]() -> DocumentMap {
+    if (self.queryFromTargetKeysEnabled && [self canQueryFromTargetKeys:query]) {
+      FSTQueryData *queryData = _queryCache->GetTarget(query);
+      if (queryData && queryData.resumeToken.length > 0 &&
+          queryData.snapshotVersion != SnapshotVersion::None()) {
+        // The target's documents are persisted as they change, so they're at least as recent as
+        // its snapshot version (which may lag behind, see shouldPersistQueryData). Anything that
+        // could have joined the results since was read or mutated after that version.
+        return _localDocuments->GetDocumentsMatchingQuery(
+            query, _queryCache->GetMatchingKeys(queryData.targetID), queryData.snapshotVersion);
+      }
+    }
     return _localDocuments->GetDocumentsMatchingQuery(query);
   });
 }
 
+- (DocumentMap)executeQuery:(FSTQuery *)query
+                 startAfter:(const absl::optional<DocumentKey> &)startAfter
+                   pageSize:(size_t)pageSize {
+  return self.persistence.run("ExecuteQueryPage", [&]() -> DocumentMap {
+    return _localDocuments->GetDocumentsMatchingQueryPage(query, startAfter, pageSize);
+  });
+}
+
+- (BOOL)canExecuteQueryInSnapshot:(FSTQuery *)query {
+  if (self.queryFromTargetKeysEnabled && [self canQueryFromTargetKeys:query]) {
+    return NO;
+  }
+  return !FieldIndexScan::ForQuery(query.query).has_value();
+}
+
+/**
+ * Returns YES if the results of @a query could be derived from the documents of its target. Limit
+ * queries are excluded since documents leaving the results may need to be replaced by ones the
+ * target never had.
+ */
+- (BOOL)canQueryFromTargetKeys:(FSTQuery *)query {
+  return ![query isDocumentQuery] && ![query isCollectionGroupQuery] &&
+         query.limit == Query::kNoLimit;
+}
+
 - (DocumentKeySet)remoteDocumentKeysForTarget:(TargetId)targetID {
   return self.persistence.run("RemoteDocumentKeysForTarget", [&]() -> DocumentKeySet {
     return _queryCache->GetMatchingKeys(targetID);
   });
 }
 
-- (void)applyBatchResult:(FSTMutationBatchResult *)batchResult {
+/**
+ * Applies the acknowledged batch to the remote documents it wrote and removes it from the mutation
+ * queue.
+ *
+ * @return The remote documents of the batch's keys, after the batch was applied.
+ */
+- (MaybeDocumentMap)applyBatchResult:(FSTMutationBatchResult *)batchResult {
   FSTMutationBatch *batch = batchResult.batch;
   DocumentKeySet docKeys = batch.keys;
   const DocumentVersionMap &versions = batchResult.docVersions;
-  for (const DocumentKey &docKey : docKeys) {
-    FSTMaybeDocument *_Nullable remoteDoc = _remoteDocumentCache->Get(docKey);
+  const MaybeDocumentMap cachedDocs = _remoteDocumentCache->GetAll(docKeys);
+  MaybeDocumentMap remoteDocs = cachedDocs;
+  for (const auto &kv : cachedDocs) {
+    const DocumentKey &docKey = kv.first;
+    FSTMaybeDocument *_Nullable remoteDoc = kv.second;
     FSTMaybeDocument *_Nullable doc = remoteDoc;
 
     auto ackVersionIter = versions.find(docKey);
@@ -508,12 +849,15 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
         HARD_ASSERT(!remoteDoc, "Mutation batch %s applied to document %s resulted in nil.", batch,
                     remoteDoc);
       } else {
-        _remoteDocumentCache->Add(doc);
+        _remoteDocumentCache->Add(doc, batchResult.commitVersion);
+        remoteDocs = remoteDocs.insert(docKey, doc);
       }
     }
   }
 
   _mutationQueue->RemoveMutationBatch(batch);
+  _localDocuments->RemoveOverlays(docKeys);
+  return remoteDocs;
 }
 
 - (LruResults)collectGarbage:(FSTLRUGarbageCollector *)garbageCollector {
@@ -522,6 +866,12 @@ static const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
   });
 }
 
+- (LruResults)collectGarbageSlice:(FSTLRUGarbageCollector *)garbageCollector {
+  return self.persistence.run("Collect garbage slice", [&]() -> LruResults {
+    return [garbageCollector collectSliceWithLiveTargets:_targetIDs];
+  });
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
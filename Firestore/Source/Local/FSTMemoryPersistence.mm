@@ -45,6 +45,7 @@ using firebase::firestore::local::ReferenceSet;
 using firebase::firestore::local::TargetCallback;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeyHash;
+using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::TargetId;
 using firebase::firestore::util::Status;
@@ -133,6 +134,11 @@ NS_ASSUME_NONNULL_BEGIN
   self.started = NO;
 }
 
+- (void)trimMemoryToBudget:(size_t)budgetBytes {
+  // Everything held in memory is the only copy of the data, so none of it can be dropped. Garbage
+  // collection is what frees documents that are no longer needed.
+}
+
 - (id<FSTReferenceDelegate>)referenceDelegate {
   return _referenceDelegate;
 }
@@ -284,6 +290,13 @@ NS_ASSUME_NONNULL_BEGIN
   _sequenceNumbers[key] = self.currentSequenceNumber;
 }
 
+- (void)removeReferences:(const DocumentKeySet &)keys {
+  ListenSequenceNumber sequenceNumber = self.currentSequenceNumber;
+  for (const DocumentKey &key : keys) {
+    _sequenceNumbers[key] = sequenceNumber;
+  }
+}
+
 - (BOOL)mutationQueuesContainKey:(const DocumentKey &)key {
   const MutationQueues &queues = [_persistence mutationQueues];
   for (const auto &entry : queues) {
@@ -319,7 +332,8 @@ NS_ASSUME_NONNULL_BEGIN
 - (size_t)byteSize {
   // Note that this method is only used for testing because this delegate is only
   // used for testing. The algorithm here (loop through everything, serialize it
-  // and count bytes) is inefficient and inexact, but won't run in production.
+  // and count bytes) is inefficient and inexact, but won't run in production. The
+  // remote document cache, usually the largest, only serializes what changed.
   size_t count = 0;
   count += _persistence.queryCache->CalculateByteSize(_serializer);
   count += _persistence.remoteDocumentCache->CalculateByteSize(_serializer);
@@ -372,6 +386,10 @@ NS_ASSUME_NONNULL_BEGIN
   _orphaned->insert(key);
 }
 
+- (void)removeReferences:(const DocumentKeySet &)keys {
+  _orphaned->insert(keys.begin(), keys.end());
+}
+
 - (void)removeMutationReference:(const DocumentKey &)key {
   _orphaned->insert(key);
 }
@@ -23,6 +23,7 @@
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
@@ -73,6 +74,12 @@ NS_ASSUME_NONNULL_BEGIN
 /** Releases any resources held during eager shutdown. */
 - (void)shutdown;
 
+/**
+ * Drops what persistence keeps in memory only to save work, such as decoded copies of what it
+ * stores, until roughly `budgetBytes` of it remain. Called when the system is low on memory.
+ */
+- (void)trimMemoryToBudget:(size_t)budgetBytes;
+
 /**
  * Returns a MutationQueue representing the persisted mutations for the given user.
  *
@@ -146,6 +153,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)removeReference:(const model::DocumentKey &)key;
 
+/**
+ * Notify the delegate that the given documents were removed from targets, as one update rather than
+ * a call to -removeReference: per document.
+ */
+- (void)removeReferences:(const model::DocumentKeySet &)keys;
+
 /**
  * Notify the delegate that a document is no longer being mutated by the user.
  */
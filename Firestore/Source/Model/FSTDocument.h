@@ -16,6 +16,10 @@
 
 #import <Foundation/Foundation.h>
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
@@ -23,6 +27,7 @@
 #include "absl/types/optional.h"
 
 @class GCFSDocument;
+@class GCFSValue;
 @class FSTObjectValue;
 
 namespace firebase {
@@ -39,6 +44,12 @@ namespace model = firebase::firestore::model;
 
 NS_ASSUME_NONNULL_BEGIN
 
+/** Converts a single field value proto to the equivalent model. */
+typedef model::FieldValue (^FSTFieldValueDecoder)(GCFSValue *value);
+
+/** The values of the fields a document is sorted by, in sort order; nullopt if a field is unset. */
+typedef std::vector<absl::optional<model::FieldValue>> FSTDocumentSortKey;
+
 /**
  * The result of a lookup for a given path may be an existing document or a tombstone that marks
  * the path deleted.
@@ -67,7 +78,40 @@ NS_ASSUME_NONNULL_BEGIN
                            state:(model::DocumentState)state
                            proto:(GCFSDocument *)proto;
 
+/**
+ * Creates a document that keeps the bytes of the `google.firestore.v1.Document` it was decoded
+ * from, so that local persistence can store them without encoding the document again.
+ */
++ (instancetype)documentWithData:(model::ObjectValue)data
+                             key:(model::DocumentKey)key
+                         version:(model::SnapshotVersion)version
+                           state:(model::DocumentState)state
+                    encodedProto:(NSData *)encodedProto;
+
+/**
+ * Creates a document whose data is decoded from the fields of the given proto on demand.
+ * `fieldForPath:` only decodes the top-level field that contains the requested path, so documents
+ * that are only inspected by query filters and orderings are never fully decoded. The full
+ * ObjectValue is decoded (once) the first time `data` is accessed.
+ */
++ (instancetype)documentWithProto:(GCFSDocument *)proto
+                              key:(model::DocumentKey)key
+                          version:(model::SnapshotVersion)version
+                            state:(model::DocumentState)state
+                          decoder:(FSTFieldValueDecoder)decoder;
+
 - (absl::optional<model::FieldValue>)fieldForPath:(const model::FieldPath &)path;
+
+/**
+ * Returns the values of the given fields as a key for sorting this document. The document keeps
+ * the key it returned last, along with its `sortKeyID`, and returns it again when asked for the
+ * same ID, so sorting by the same fields repeatedly looks them up only once. Different lists of
+ * fields must therefore have different IDs.
+ */
+- (std::shared_ptr<const FSTDocumentSortKey>)sortKeyForFields:
+                                                 (const std::vector<model::FieldPath> &)fields
+                                                    sortKeyID:(uint64_t)sortKeyID;
+
 - (bool)hasLocalMutations;
 - (bool)hasCommittedMutations;
 
@@ -80,6 +124,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nullable, nonatomic, strong, readonly) GCFSDocument *proto;
 
+/**
+ * Memoized wire encoding of the document as received from the backend, for the same purpose as
+ * `proto`. Might be nil.
+ */
+@property(nullable, nonatomic, strong, readonly) NSData *encodedProto;
+
 @end
 
 @interface FSTDeletedDocument : FSTMaybeDocument
@@ -16,8 +16,13 @@
 
 #import "Firestore/Source/Model/FSTDocument.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
+#import "Firestore/Protos/objc/google/firestore/v1/Document.pbobjc.h"
 #import "Firestore/Source/Util/FSTClasses.h"
 
 #include "Firestore/core/src/firebase/firestore/model/document.h"
@@ -42,6 +47,15 @@ using firebase::firestore::model::SnapshotVersion;
 
 NS_ASSUME_NONNULL_BEGIN
 
+namespace {
+
+struct CachedSortKey {
+  uint64_t sort_key_id = 0;
+  FSTDocumentSortKey values;
+};
+
+}  // namespace
+
 @interface FSTMaybeDocument ()
 
 - (instancetype)initWithKey:(DocumentKey)key
@@ -85,6 +99,16 @@ NS_ASSUME_NONNULL_BEGIN
 @implementation FSTDocument {
   DocumentState _documentState;
   util::DelayedConstructor<ObjectValue> _data;
+
+  // Set only for documents created with documentWithProto:, whose _data is
+  // initialized on first access.
+  FSTFieldValueDecoder _Nullable _decoder;
+  std::once_flag _decodeOnce;
+  std::atomic<bool> _decoded;
+
+  // The sort key last returned by sortKeyForFields:sortKeyID:. Only accessed atomically, since
+  // views on different threads may sort the same document.
+  std::shared_ptr<const CachedSortKey> _sortKey;
 }
 
 + (instancetype)documentWithData:(ObjectValue)data
@@ -109,6 +133,30 @@ NS_ASSUME_NONNULL_BEGIN
                                      proto:proto];
 }
 
++ (instancetype)documentWithData:(ObjectValue)data
+                             key:(DocumentKey)key
+                         version:(SnapshotVersion)version
+                           state:(DocumentState)state
+                    encodedProto:(NSData *)encodedProto {
+  return [[FSTDocument alloc] initWithData:std::move(data)
+                                       key:std::move(key)
+                                   version:std::move(version)
+                                     state:state
+                              encodedProto:encodedProto];
+}
+
++ (instancetype)documentWithProto:(GCFSDocument *)proto
+                              key:(DocumentKey)key
+                          version:(SnapshotVersion)version
+                            state:(DocumentState)state
+                          decoder:(FSTFieldValueDecoder)decoder {
+  return [[FSTDocument alloc] initWithProto:proto
+                                        key:std::move(key)
+                                    version:std::move(version)
+                                      state:state
+                                    decoder:decoder];
+}
+
 - (instancetype)initWithData:(ObjectValue)data
                          key:(DocumentKey)key
                      version:(SnapshotVersion)version
@@ -136,6 +184,34 @@ NS_ASSUME_NONNULL_BEGIN
   return self;
 }
 
+- (instancetype)initWithData:(ObjectValue)data
+                         key:(DocumentKey)key
+                     version:(SnapshotVersion)version
+                       state:(DocumentState)state
+                encodedProto:(NSData *)encodedProto {
+  self = [super initWithKey:std::move(key) version:std::move(version)];
+  if (self) {
+    _data.Init(std::move(data));
+    _documentState = state;
+    _encodedProto = encodedProto;
+  }
+  return self;
+}
+
+- (instancetype)initWithProto:(GCFSDocument *)proto
+                          key:(DocumentKey)key
+                      version:(SnapshotVersion)version
+                        state:(DocumentState)state
+                      decoder:(FSTFieldValueDecoder)decoder {
+  self = [super initWithKey:std::move(key) version:std::move(version)];
+  if (self) {
+    _documentState = state;
+    _proto = proto;
+    _decoder = decoder;
+  }
+  return self;
+}
+
 - (bool)hasLocalMutations {
   return _documentState == DocumentState::kLocalMutations;
 }
@@ -149,9 +225,23 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (const ObjectValue &)data {
+  if (_decoder) {
+    std::call_once(_decodeOnce, [self] { [self decodeData]; });
+  }
   return *_data;
 }
 
+- (void)decodeData {
+  FSTFieldValueDecoder decoder = _decoder;
+  __block FieldValue::Map fields;
+  [_proto.fields enumerateKeysAndObjectsUsingBlock:^(NSString *_Nonnull key,
+                                                     GCFSValue *_Nonnull obj, BOOL *_Nonnull stop) {
+    fields = fields.insert(util::MakeString(key), decoder(obj));
+  }];
+  _data.Init(ObjectValue::FromMap(std::move(fields)));
+  _decoded = true;
+}
+
 - (BOOL)isEqual:(id)other {
   if (other == self) {
     return YES;
@@ -177,7 +267,38 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (absl::optional<FieldValue>)fieldForPath:(const FieldPath &)path {
-  return _data->Get(path);
+  if (!_decoder || _decoded || path.empty()) {
+    return self.data.Get(path);
+  }
+
+  // Decode just the top-level field that contains the path.
+  GCFSValue *proto = _proto.fields[util::MakeNSString(path.first_segment())];
+  if (!proto) {
+    return absl::nullopt;
+  }
+  FieldValue value = _decoder(proto);
+  if (path.size() == 1) {
+    return value;
+  } else if (value.type() != FieldValue::Type::Object) {
+    return absl::nullopt;
+  }
+  return ObjectValue(std::move(value)).Get(path.PopFirst());
+}
+
+- (std::shared_ptr<const FSTDocumentSortKey>)sortKeyForFields:(const std::vector<FieldPath> &)fields
+                                                    sortKeyID:(uint64_t)sortKeyID {
+  std::shared_ptr<const CachedSortKey> cached = std::atomic_load(&_sortKey);
+  if (!cached || cached->sort_key_id != sortKeyID) {
+    auto computed = std::make_shared<CachedSortKey>();
+    computed->sort_key_id = sortKeyID;
+    computed->values.reserve(fields.size());
+    for (const FieldPath &field : fields) {
+      computed->values.push_back([self fieldForPath:field]);
+    }
+    cached = std::move(computed);
+    std::atomic_store(&_sortKey, cached);
+  }
+  return std::shared_ptr<const FSTDocumentSortKey>(cached, &cached->values);
 }
 
 @end
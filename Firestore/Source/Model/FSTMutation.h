@@ -174,6 +174,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (const model::Precondition &)precondition;
 
+/**
+ * Returns a single mutation with the same effect as applying this mutation and then the given
+ * mutation to the same document, or nil if the two can't be combined. Mutations with transforms
+ * are never combined, and neither are mutations whose preconditions might not hold.
+ */
+- (nullable FSTMutation *)mutationByCombiningWith:(FSTMutation *)mutation;
+
 @end
 
 #pragma mark - FSTSetMutation
@@ -55,6 +55,10 @@ using firebase::firestore::util::Hash;
 
 NS_ASSUME_NONNULL_BEGIN
 
+@interface FSTPatchMutation ()
+- (ObjectValue)patchObjectValue:(ObjectValue)objectValue;
+@end
+
 #pragma mark - FSTMutationResult
 
 @implementation FSTMutationResult {
@@ -115,6 +119,60 @@ NS_ASSUME_NONNULL_BEGIN
   return _precondition;
 }
 
+- (nullable FSTMutation *)mutationByCombiningWith:(FSTMutation *)mutation {
+  HARD_ASSERT(mutation.key == self.key, "Can only combine mutations of the same document");
+
+  // Transforms are resolved on the backend against the write time, so they can't be folded into
+  // the mutations around them.
+  if ([self isKindOfClass:[FSTTransformMutation class]] ||
+      [mutation isKindOfClass:[FSTTransformMutation class]]) {
+    return nil;
+  }
+
+  // An unconditional set or delete replaces whatever came before it, as long as that couldn't
+  // have failed.
+  if ([mutation isKindOfClass:[FSTSetMutation class]] ||
+      [mutation isKindOfClass:[FSTDeleteMutation class]]) {
+    return mutation.precondition.IsNone() && self.precondition.IsNone() ? mutation : nil;
+  }
+
+  HARD_ASSERT([mutation isKindOfClass:[FSTPatchMutation class]], "Unknown mutation type: %s",
+              mutation);
+  FSTPatchMutation *patch = (FSTPatchMutation *)mutation;
+
+  // A patch that requires the document to exist always finds it after a set or another patch.
+  BOOL patchRequiresDocument = !patch.precondition.IsNone();
+  if (patchRequiresDocument && !(patch.precondition == Precondition::Exists(true))) {
+    return nil;
+  }
+
+  if ([self isKindOfClass:[FSTSetMutation class]]) {
+    FSTSetMutation *set = (FSTSetMutation *)self;
+    return [[FSTSetMutation alloc] initWithKey:self.key
+                                         value:[patch patchObjectValue:set.value]
+                                  precondition:self.precondition];
+
+  } else if ([self isKindOfClass:[FSTPatchMutation class]]) {
+    FSTPatchMutation *earlier = (FSTPatchMutation *)self;
+    std::set<FieldPath> fields{earlier.fieldMask->begin(), earlier.fieldMask->end()};
+    fields.insert(patch.fieldMask->begin(), patch.fieldMask->end());
+    return [[FSTPatchMutation alloc] initWithKey:self.key
+                                       fieldMask:FieldMask{std::move(fields)}
+                                           value:[patch patchObjectValue:earlier.value]
+                                    precondition:self.precondition];
+
+  } else {
+    // After a delete only a patch that doesn't require the document can apply, and it creates the
+    // document from just its own fields.
+    if (patchRequiresDocument || !self.precondition.IsNone()) {
+      return nil;
+    }
+    return [[FSTSetMutation alloc] initWithKey:self.key
+                                         value:[patch patchObjectValue:ObjectValue::Empty()]
+                                  precondition:Precondition::None()];
+  }
+}
+
 - (void)verifyKeyMatches:(nullable FSTMaybeDocument *)maybeDoc {
   if (maybeDoc) {
     HARD_ASSERT(maybeDoc.key == self.key, "Can only set a document with the same key");
@@ -308,18 +366,7 @@ NS_ASSUME_NONNULL_BEGIN
 }
 
 - (ObjectValue)patchObjectValue:(ObjectValue)objectValue {
-  ObjectValue result = std::move(objectValue);
-  for (const FieldPath &fieldPath : _fieldMask) {
-    if (!fieldPath.empty()) {
-      absl::optional<FieldValue> newValue = self.value.Get(fieldPath);
-      if (newValue) {
-        result = result.Set(fieldPath, *newValue);
-      } else {
-        result = result.Delete(fieldPath);
-      }
-    }
-  }
-  return result;
+  return objectValue.Patch(_fieldMask, self.value);
 }
 
 @end
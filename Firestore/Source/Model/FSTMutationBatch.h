@@ -92,6 +92,12 @@ NS_ASSUME_NONNULL_BEGIN
 /** Returns the set of unique keys referenced by all mutations in the batch. */
 - (model::DocumentKeySet)keys;
 
+/**
+ * Returns whether any of the user-provided mutations in this batch are for the given document.
+ * Looks the key up in an index of the batch rather than scanning its mutations.
+ */
+- (BOOL)hasMutationsForKey:(const model::DocumentKey &)documentKey;
+
 /** The unique ID of this mutation batch. */
 @property(nonatomic, assign, readonly) model::BatchId batchID;
 
@@ -17,6 +17,7 @@
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 
 #include <algorithm>
+#include <map>
 #include <utility>
 
 #import "FIRTimestamp.h"
@@ -44,10 +45,28 @@ using firebase::firestore::util::Hash;
 
 NS_ASSUME_NONNULL_BEGIN
 
+namespace {
+
+/** The positions of the base mutations and mutations of one document within a batch. */
+struct MutationIndices {
+  std::vector<size_t> base_mutations;
+  std::vector<size_t> mutations;
+};
+
+using MutationIndex = std::map<DocumentKey, MutationIndices>;
+
+}  // namespace
+
 @implementation FSTMutationBatch {
   Timestamp _localWriteTime;
   std::vector<FSTMutation *> _baseMutations;
   std::vector<FSTMutation *> _mutations;
+
+  /**
+   * The mutations of each document in the batch, in key order. Built on first use, since many
+   * batches are only read to be sent or removed.
+   */
+  MutationIndex _mutationIndex;
 }
 
 - (instancetype)initWithBatchID:(BatchId)batchID
@@ -104,6 +123,25 @@ NS_ASSUME_NONNULL_BEGIN
                                     objc::Description(_mutations)];
 }
 
+- (const MutationIndex &)mutationIndex {
+  // A batch is never empty, so an empty index is one that hasn't been built yet.
+  if (_mutationIndex.empty()) {
+    for (size_t i = 0; i < _baseMutations.size(); i++) {
+      _mutationIndex[_baseMutations[i].key].base_mutations.push_back(i);
+    }
+    for (size_t i = 0; i < _mutations.size(); i++) {
+      _mutationIndex[_mutations[i].key].mutations.push_back(i);
+    }
+  }
+  return _mutationIndex;
+}
+
+- (BOOL)hasMutationsForKey:(const DocumentKey &)documentKey {
+  const MutationIndex &index = [self mutationIndex];
+  auto found = index.find(documentKey);
+  return found != index.end() && !found->second.mutations.empty();
+}
+
 - (FSTMaybeDocument *_Nullable)applyToRemoteDocument:(FSTMaybeDocument *_Nullable)maybeDoc
                                          documentKey:(const DocumentKey &)documentKey
                                  mutationBatchResult:
@@ -116,12 +154,16 @@ NS_ASSUME_NONNULL_BEGIN
               "Mismatch between mutations length (%s) and results length (%s)", _mutations.size(),
               mutationBatchResult.mutationResults.size());
 
-  for (size_t i = 0; i < _mutations.size(); i++) {
+  const MutationIndex &index = [self mutationIndex];
+  auto found = index.find(documentKey);
+  if (found == index.end()) {
+    return maybeDoc;
+  }
+
+  for (size_t i : found->second.mutations) {
     FSTMutation *mutation = _mutations[i];
     FSTMutationResult *mutationResult = mutationBatchResult.mutationResults[i];
-    if (mutation.key == documentKey) {
-      maybeDoc = [mutation applyToRemoteDocument:maybeDoc mutationResult:mutationResult];
-    }
+    maybeDoc = [mutation applyToRemoteDocument:maybeDoc mutationResult:mutationResult];
   }
   return maybeDoc;
 }
@@ -132,45 +174,70 @@ NS_ASSUME_NONNULL_BEGIN
               "applyTo: key %s doesn't match maybeDoc key %s", documentKey.ToString(),
               maybeDoc.key.ToString());
 
+  const MutationIndex &index = [self mutationIndex];
+  auto found = index.find(documentKey);
+  if (found == index.end()) {
+    return maybeDoc;
+  }
+  return [self applyToLocalDocument:maybeDoc mutationIndices:found->second];
+}
+
+/** Applies the mutations at the given positions, which are all for the document `maybeDoc`. */
+- (FSTMaybeDocument *_Nullable)applyToLocalDocument:(FSTMaybeDocument *_Nullable)maybeDoc
+                                    mutationIndices:(const MutationIndices &)indices {
   // First, apply the base state. This allows us to apply non-idempotent transform against a
   // consistent set of values.
-  for (FSTMutation *mutation : _baseMutations) {
-    if (mutation.key == documentKey) {
-      maybeDoc = [mutation applyToLocalDocument:maybeDoc
-                                   baseDocument:maybeDoc
-                                 localWriteTime:self.localWriteTime];
-    }
+  for (size_t i : indices.base_mutations) {
+    maybeDoc = [_baseMutations[i] applyToLocalDocument:maybeDoc
+                                          baseDocument:maybeDoc
+                                        localWriteTime:self.localWriteTime];
   }
 
   FSTMaybeDocument *baseDoc = maybeDoc;
 
   // Second, apply all user-provided mutations.
-  for (FSTMutation *mutation : _mutations) {
-    if (mutation.key == documentKey) {
-      maybeDoc = [mutation applyToLocalDocument:maybeDoc
-                                   baseDocument:baseDoc
-                                 localWriteTime:self.localWriteTime];
-    }
+  for (size_t i : indices.mutations) {
+    maybeDoc = [_mutations[i] applyToLocalDocument:maybeDoc
+                                      baseDocument:baseDoc
+                                    localWriteTime:self.localWriteTime];
   }
   return maybeDoc;
 }
 
 - (MaybeDocumentMap)applyToLocalDocumentSet:(const MaybeDocumentMap &)documentSet {
-  // TODO(mrschmidt): This implementation is O(n^2). If we iterate through the mutations first (as
-  // done in `applyToLocalDocument:documentKey:`), we can reduce the complexity to O(n).
+  // Both the documents and the index are sorted by key, so a single merge pass over them finds the
+  // document each mutation applies to and copies the others along.
+  MaybeDocumentMap::Builder results;
+  auto doc = documentSet.begin();
+  auto docs_end = documentSet.end();
+  for (const auto &entry : [self mutationIndex]) {
+    const DocumentKey &key = entry.first;
+    if (entry.second.mutations.empty()) {
+      continue;
+    }
 
-  MaybeDocumentMap mutatedDocuments = documentSet;
-  for (FSTMutation *mutation : _mutations) {
-    const DocumentKey &key = mutation.key;
-    auto maybeDocument = mutatedDocuments.find(key);
-    FSTMaybeDocument *mutatedDocument = [self
-        applyToLocalDocument:(maybeDocument != mutatedDocuments.end() ? maybeDocument->second : nil)
-                 documentKey:key];
+    for (; doc != docs_end && doc->first < key; ++doc) {
+      results.push_back(doc->first, doc->second);
+    }
+
+    FSTMaybeDocument *_Nullable baseDoc = nil;
+    if (doc != docs_end && doc->first == key) {
+      baseDoc = doc->second;
+      ++doc;
+    }
+
+    FSTMaybeDocument *mutatedDocument = [self applyToLocalDocument:baseDoc
+                                                   mutationIndices:entry.second];
     if (mutatedDocument) {
-      mutatedDocuments = mutatedDocuments.insert(key, mutatedDocument);
+      results.push_back(key, mutatedDocument);
+    } else if (baseDoc) {
+      results.push_back(key, baseDoc);
     }
   }
-  return mutatedDocuments;
+  for (; doc != docs_end; ++doc) {
+    results.push_back(doc->first, doc->second);
+  }
+  return results.Build();
 }
 
 - (DocumentKeySet)keys {
@@ -18,6 +18,7 @@
 
 @class FIRDocumentReference;
 @class FIRSnapshotMetadata;
+@class FIRTimestamp;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -137,6 +138,63 @@ NS_SWIFT_NAME(DocumentSnapshot)
  */
 - (nullable id)objectForKeyedSubscript:(id)key;
 
+/**
+ * Retrieves an integer field from the document, without converting it to an `NSNumber`.
+ *
+ * @param field The field to retrieve, as an `NSString` or a `FIRFieldPath`.
+ * @return The value of the field, or 0 if the document or field doesn't exist or the field isn't
+ *     an integer.
+ */
+- (int64_t)int64ForField:(id)field NS_SWIFT_NAME(int64(_:));
+
+/**
+ * Retrieves a numeric field from the document, without converting it to an `NSNumber`. Integer
+ * fields are converted to doubles.
+ *
+ * @param field The field to retrieve, as an `NSString` or a `FIRFieldPath`.
+ * @return The value of the field, or 0 if the document or field doesn't exist or the field isn't
+ *     a number.
+ */
+- (double)doubleForField:(id)field NS_SWIFT_NAME(double(_:));
+
+/**
+ * Retrieves a string field from the document. Unlike `valueForField:`, this doesn't convert the
+ * maps the field is nested in.
+ *
+ * @param field The field to retrieve, as an `NSString` or a `FIRFieldPath`.
+ * @return The value of the field, or `nil` if the document or field doesn't exist or the field
+ *     isn't a string.
+ */
+- (nullable NSString *)stringForField:(id)field NS_SWIFT_NAME(string(_:));
+
+/**
+ * Retrieves a timestamp field from the document, as a `FIRTimestamp` whatever the
+ * `timestampsInSnapshotsEnabled` setting.
+ *
+ * Timestamps that have not yet been set to their final value are returned as `nil`.
+ *
+ * @param field The field to retrieve, as an `NSString` or a `FIRFieldPath`.
+ * @return The value of the field, or `nil` if the document or field doesn't exist or the field
+ *     isn't a timestamp.
+ */
+- (nullable FIRTimestamp *)timestampForField:(id)field NS_SWIFT_NAME(timestamp(_:));
+
+/**
+ * Retrieves a timestamp field from the document, as a `FIRTimestamp` whatever the
+ * `timestampsInSnapshotsEnabled` setting.
+ *
+ * @param field The field to retrieve, as an `NSString` or a `FIRFieldPath`.
+ * @param serverTimestampBehavior Configures how server timestamps that have not yet been set to
+ *     their final value are returned from the snapshot.
+ * @return The value of the field, or `nil` if the document or field doesn't exist or the field
+ *     isn't a timestamp.
+ */
+// clang-format off
+- (nullable FIRTimestamp *)timestampForField:(id)field
+                     serverTimestampBehavior:(FIRServerTimestampBehavior)serverTimestampBehavior
+    NS_SWIFT_NAME(timestamp(_:serverTimestampBehavior:));
+// clang-format on
+
 @end
 
 /**
@@ -270,6 +270,78 @@ addSnapshotListenerWithIncludeMetadataChanges:(BOOL)includeMetadataChanges
                     arrayContains:(id)value NS_SWIFT_NAME(whereField(_:arrayContains:));
 // clang-format on
 
+/**
+ * Creates and returns a new `FIRQuery` with the additional filter that documents must contain
+ * the specified field and the value must equal one of the values from the provided array.
+ *
+ * A query can have only one in filter, and it cannot be combined with an arrayContainsAny filter.
+ *
+ * @param field The name of the field to search.
+ * @param values The array that contains the values to match. It must be non-empty and contain at
+ *     most 10 values.
+ *
+ * @return The created `FIRQuery`.
+ */
+// clang-format off
+- (FIRQuery *)queryWhereField:(NSString *)field
+                           in:(NSArray *)values NS_SWIFT_NAME(whereField(_:in:));
+// clang-format on
+
+/**
+ * Creates and returns a new `FIRQuery` with the additional filter that documents must contain
+ * the specified field and the value must equal one of the values from the provided array.
+ *
+ * A query can have only one in filter, and it cannot be combined with an arrayContainsAny filter.
+ *
+ * @param path The path of the field to search.
+ * @param values The array that contains the values to match. It must be non-empty and contain at
+ *     most 10 values.
+ *
+ * @return The created `FIRQuery`.
+ */
+// clang-format off
+- (FIRQuery *)queryWhereFieldPath:(FIRFieldPath *)path
+                               in:(NSArray *)values NS_SWIFT_NAME(whereField(_:in:));
+// clang-format on
+
+/**
+ * Creates and returns a new `FIRQuery` with the additional filter that documents must contain
+ * the specified field, the value must be an array, and that array must contain at least one value
+ * from the provided array.
+ *
+ * A query can have only one arrayContains or arrayContainsAny filter, and an arrayContainsAny
+ * filter cannot be combined with an in filter.
+ *
+ * @param field The name of the field containing an array to search.
+ * @param values The array that contains the values to match. It must be non-empty and contain at
+ *     most 10 values.
+ *
+ * @return The created `FIRQuery`.
+ */
+// clang-format off
+- (FIRQuery *)queryWhereField:(NSString *)field
+             arrayContainsAny:(NSArray *)values NS_SWIFT_NAME(whereField(_:arrayContainsAny:));
+// clang-format on
+
+/**
+ * Creates and returns a new `FIRQuery` with the additional filter that documents must contain
+ * the specified field, the value must be an array, and that array must contain at least one value
+ * from the provided array.
+ *
+ * A query can have only one arrayContains or arrayContainsAny filter, and an arrayContainsAny
+ * filter cannot be combined with an in filter.
+ *
+ * @param path The path of the field containing an array to search.
+ * @param values The array that contains the values to match. It must be non-empty and contain at
+ *     most 10 values.
+ *
+ * @return The created `FIRQuery`.
+ */
+// clang-format off
+- (FIRQuery *)queryWhereFieldPath:(FIRFieldPath *)path
+                 arrayContainsAny:(NSArray *)values NS_SWIFT_NAME(whereField(_:arrayContainsAny:));
+// clang-format on
+
 /**
  * Creates and returns a new `FIRQuery` with the additional filter that documents must
  * satisfy the specified predicate.
@@ -30,6 +30,7 @@
 #include "Firestore/core/src/firebase/firestore/model/transform_operations.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 
+@class FSTDocument;
 @class FSTMaybeDocument;
 @class FSTMutation;
 @class FSTMutationBatch;
@@ -43,6 +44,7 @@
 @class GCFSDocumentMask;
 @class GCFSDocumentTransform_FieldTransform;
 @class GCFSListenResponse;
+@class GCFSRunQueryResponse;
 @class GCFSStructuredQuery_Filter;
 @class GCFSStructuredQuery_FieldFilter;
 @class GCFSStructuredQuery_UnaryFilter;
@@ -73,7 +75,19 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)init NS_UNAVAILABLE;
 
-- (instancetype)initWithDatabaseID:(model::DatabaseId)databaseID NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithDatabaseID:(model::DatabaseId)databaseID;
+
+/**
+ * Creates a serializer that, if `relativeNames` is true, writes the names of documents and
+ * references as `documents/{path}`, relative to the database, instead of fully qualified. That's
+ * only meaningful to a reader that knows the database, so it's meant for local storage. Every
+ * serializer reads both forms.
+ */
+- (instancetype)initWithDatabaseID:(model::DatabaseId)databaseID
+                     relativeNames:(BOOL)relativeNames NS_DESIGNATED_INITIALIZER;
+
+/** The database for which this serializer encodes keys and references. */
+- (const model::DatabaseId &)databaseID;
 
 - (GCFSValue *)encodedNull;
 - (GCFSValue *)encodedBool:(bool)value;
@@ -92,7 +106,8 @@ NS_ASSUME_NONNULL_BEGIN
 
 /**
  * Encodes the given document key as a fully qualified name. This includes the
- * databaseId associated with this FSTSerializerBeta and the key path.
+ * databaseId associated with this FSTSerializerBeta and the key path, unless the serializer writes
+ * relative names.
  */
 - (NSString *)encodedDocumentKey:(const model::DocumentKey &)key;
 - (model::DocumentKey)decodedDocumentKey:(NSString *)key;
@@ -142,6 +157,9 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (FSTMaybeDocument *)decodedMaybeDocumentFromBatch:(GCFSBatchGetDocumentsResponse *)response;
 
+/** Decodes the document in a RunQuery response, or returns nil if the response carries none. */
+- (nullable FSTDocument *)decodedDocumentFromRunQuery:(GCFSRunQueryResponse *)response;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -53,6 +53,7 @@
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/precondition.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/string_interner.h"
 #include "Firestore/core/src/firebase/firestore/model/transform_operations.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
@@ -62,6 +63,7 @@
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 
 namespace util = firebase::firestore::util;
@@ -88,6 +90,7 @@ using firebase::firestore::model::Precondition;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::ServerTimestampTransform;
 using firebase::firestore::model::SnapshotVersion;
+using firebase::firestore::model::StringInterner;
 using firebase::firestore::model::TargetId;
 using firebase::firestore::model::TransformOperation;
 using firebase::firestore::nanopb::ByteString;
@@ -104,18 +107,34 @@ using Operator = Filter::Operator;
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * The start of names relative to the database. Fully qualified names start with `projects/`, so
+ * the two can't be mistaken for each other, whatever the document's path.
+ */
+static NSString *const kRelativeNamePrefix = @"documents/";
+
 @implementation FSTSerializerBeta {
   DatabaseId _databaseID;
+  BOOL _relativeNames;
 }
 
 - (instancetype)initWithDatabaseID:(DatabaseId)databaseID {
+  return [self initWithDatabaseID:std::move(databaseID) relativeNames:NO];
+}
+
+- (instancetype)initWithDatabaseID:(DatabaseId)databaseID relativeNames:(BOOL)relativeNames {
   self = [super init];
   if (self) {
     _databaseID = std::move(databaseID);
+    _relativeNames = relativeNames;
   }
   return self;
 }
 
+- (const DatabaseId &)databaseID {
+  return _databaseID;
+}
+
 #pragma mark - SnapshotVersion <=> GPBTimestamp
 
 - (GPBTimestamp *)encodedTimestamp:(const Timestamp &)timestamp {
@@ -153,10 +172,16 @@ NS_ASSUME_NONNULL_BEGIN
 #pragma mark - DocumentKey <=> Key proto
 
 - (NSString *)encodedDocumentKey:(const DocumentKey &)key {
+  if (_relativeNames) {
+    return [self encodedRelativeName:key.path()];
+  }
   return [self encodedResourcePathForDatabaseID:_databaseID path:key.path()];
 }
 
 - (DocumentKey)decodedDocumentKey:(NSString *)name {
+  if ([name hasPrefix:kRelativeNamePrefix]) {
+    return DocumentKey{[self decodedRelativeName:name]};
+  }
   const ResourcePath path = [self decodedResourcePathWithDatabaseID:name];
   HARD_ASSERT(path[1] == _databaseID.project_id(),
               "Tried to deserialize key from different project.");
@@ -173,6 +198,16 @@ NS_ASSUME_NONNULL_BEGIN
                                 .CanonicalString());
 }
 
+- (NSString *)encodedRelativeName:(const ResourcePath &)path {
+  return [kRelativeNamePrefix stringByAppendingString:util::MakeNSString(path.CanonicalString())];
+}
+
+- (ResourcePath)decodedRelativeName:(NSString *)name {
+  const std::string relativeName = util::MakeString(name);
+  return ResourcePath::FromString(
+      absl::string_view{relativeName}.substr(kRelativeNamePrefix.length));
+}
+
 - (ResourcePath)decodedResourcePathWithDatabaseID:(NSString *)name {
   const ResourcePath path = ResourcePath::FromString(util::MakeString(name));
   HARD_ASSERT([self validQualifiedResourcePath:path], "Tried to deserialize invalid key %s",
@@ -270,7 +305,7 @@ NS_ASSUME_NONNULL_BEGIN
       return FieldValue::FromDouble(valueProto.doubleValue);
 
     case GCFSValue_ValueType_OneOfCase_StringValue:
-      return FieldValue::FromString(util::MakeString(valueProto.stringValue));
+      return StringInterner::Shared().Intern(util::MakeString(valueProto.stringValue));
 
     case GCFSValue_ValueType_OneOfCase_TimestampValue: {
       Timestamp value = [self decodedTimestamp:valueProto.timestampValue];
@@ -351,11 +386,17 @@ NS_ASSUME_NONNULL_BEGIN
               _databaseID.project_id(), _databaseID.database_id(), databaseID.project_id(),
               databaseID.database_id());
   GCFSValue *result = [GCFSValue message];
-  result.referenceValue = [self encodedResourcePathForDatabaseID:databaseID path:key.path()];
+  result.referenceValue = _relativeNames
+                              ? [self encodedRelativeName:key.path()]
+                              : [self encodedResourcePathForDatabaseID:databaseID path:key.path()];
   return result;
 }
 
 - (FieldValue)decodedReferenceValue:(NSString *)resourceName {
+  if ([resourceName hasPrefix:kRelativeNamePrefix]) {
+    const DocumentKey key{[self decodedRelativeName:resourceName]};
+    return FieldValue::FromReference(_databaseID, key);
+  }
   const ResourcePath path = [self decodedResourcePathWithDatabaseID:resourceName];
   const std::string &project = path[1];
   const std::string &database = path[3];
@@ -477,6 +518,25 @@ NS_ASSUME_NONNULL_BEGIN
   return [FSTDeletedDocument documentWithKey:key version:version hasCommittedMutations:NO];
 }
 
+#pragma mark - FSTDocument <= RunQueryResponse proto
+
+- (nullable FSTDocument *)decodedDocumentFromRunQuery:(GCFSRunQueryResponse *)response {
+  // Responses that only report progress, such as the number of skipped results, have no document.
+  if (!response.hasDocument) {
+    return nil;
+  }
+  const DocumentKey key = [self decodedDocumentKey:response.document.name];
+  ObjectValue value = [self decodedFields:response.document.fields];
+  SnapshotVersion version = [self decodedVersion:response.document.updateTime];
+  HARD_ASSERT(version != SnapshotVersion::None(), "Got a query result with no snapshot version");
+
+  return [FSTDocument documentWithData:value
+                                   key:key
+                               version:version
+                                 state:DocumentState::kSynced
+                                 proto:response.document];
+}
+
 #pragma mark - FSTMutation => GCFSWrite proto
 
 - (GCFSWrite *)encodedMutation:(FSTMutation *)mutation {
@@ -1001,6 +1061,10 @@ NS_ASSUME_NONNULL_BEGIN
       return GCFSStructuredQuery_FieldFilter_Operator_GreaterThan;
     case Filter::Operator::ArrayContains:
       return GCFSStructuredQuery_FieldFilter_Operator_ArrayContains;
+    case Filter::Operator::In:
+      return GCFSStructuredQuery_FieldFilter_Operator_In;
+    case Filter::Operator::ArrayContainsAny:
+      return GCFSStructuredQuery_FieldFilter_Operator_ArrayContainsAny;
     default:
       HARD_FAIL("Unhandled Filter::Operator: %s", filterOperator);
   }
@@ -1021,6 +1085,10 @@ NS_ASSUME_NONNULL_BEGIN
       return Filter::Operator::GreaterThan;
     case GCFSStructuredQuery_FieldFilter_Operator_ArrayContains:
       return Filter::Operator::ArrayContains;
+    case GCFSStructuredQuery_FieldFilter_Operator_In:
+      return Filter::Operator::In;
+    case GCFSStructuredQuery_FieldFilter_Operator_ArrayContainsAny:
+      return Filter::Operator::ArrayContainsAny;
     default:
       HARD_FAIL("Unhandled FieldFilter.operator: %s", filterOperator);
   }
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_BULK_WRITER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_BULK_WRITER_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/api/document_reference.h"
+#include "Firestore/core/src/firebase/firestore/objc/objc_class.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+OBJC_CLASS(FSTMutation);
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+class ParsedSetData;
+class ParsedUpdateData;
+
+}  // namespace core
+
+namespace api {
+
+class Firestore;
+
+/**
+ * Writes any number of documents by committing them as a series of write
+ * batches, for importing data.
+ *
+ * Writes are grouped into batches of up to `kMaxBatchSize` writes each, in the
+ * order they were added. At most `max_pending_batches` batches are handed to
+ * the client at a time; the rest wait in the writer until earlier batches
+ * have been committed, so that the mutation queue and the write stream only
+ * ever hold a bounded part of the import. Each batch is atomic, but the writes
+ * as a whole are not.
+ *
+ * Unlike WriteBatch, a BulkWriter can be used from any thread and keeps
+ * accepting writes after a flush.
+ */
+class BulkWriter {
+ public:
+  /** The most writes the backend accepts in a single commit. */
+  static constexpr size_t kMaxBatchSize = 500;
+
+  BulkWriter(std::shared_ptr<Firestore> firestore, size_t max_pending_batches);
+
+  void SetData(const DocumentReference& reference,
+               core::ParsedSetData&& set_data);
+  void UpdateData(const DocumentReference& reference,
+                  core::ParsedUpdateData&& update_data);
+  void DeleteData(const DocumentReference& reference);
+
+  /**
+   * Commits the writes added so far in a final, possibly partial batch, and
+   * invokes the callback once all of them have been committed. The callback
+   * gets the error of the first batch that failed since the writer was
+   * created, if any.
+   */
+  void Flush(util::StatusCallback callback);
+
+  /**
+   * Returns the number of writes added but not yet committed, including those
+   * waiting in the writer. Lets callers that produce writes faster than they
+   * are committed slow down.
+   */
+  size_t pending_write_count() const;
+
+  const std::shared_ptr<Firestore>& firestore() const {
+    return firestore_;
+  }
+
+ private:
+  struct State;
+
+  void AddMutations(std::vector<FSTMutation*>&& mutations);
+  void ValidateReference(const DocumentReference& reference) const;
+
+  std::shared_ptr<Firestore> firestore_;
+
+  // Shared with the callbacks of the batches in flight, which may run after
+  // the writer is gone.
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace api
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_BULK_WRITER_H_
@@ -0,0 +1,251 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/api/bulk_writer.h"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+
+#import "Firestore/Source/Core/FSTFirestoreClient.h"
+#import "Firestore/Source/Model/FSTMutation.h"
+
+#include "Firestore/core/src/firebase/firestore/api/firestore.h"
+#include "Firestore/core/src/firebase/firestore/api/input_validation.h"
+#include "Firestore/core/src/firebase/firestore/core/user_data.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+namespace firebase {
+namespace firestore {
+namespace api {
+
+using util::Status;
+using util::StatusCallback;
+
+constexpr size_t BulkWriter::kMaxBatchSize;
+
+struct BulkWriter::State : public std::enable_shared_from_this<State> {
+  struct Batch {
+    std::vector<FSTMutation*> mutations;
+    size_t write_count = 0;
+  };
+
+  struct FlushCallback {
+    /** The number of batches that must be finished first. */
+    size_t batch_count = 0;
+    StatusCallback callback;
+  };
+
+  State(std::shared_ptr<Firestore> firestore, size_t max_pending_batches)
+      : firestore{std::move(firestore)},
+        max_pending_batches{max_pending_batches} {
+  }
+
+  /** Adds the mutations of one write, closing the current batch if needed. */
+  void Add(std::vector<FSTMutation*>&& mutations);
+
+  void Flush(StatusCallback&& callback);
+
+  void OnBatchFinished(size_t write_count, const Status& status);
+
+  /** Moves the current batch, even if empty, to the batches to send. */
+  void CloseCurrentBatch();
+
+  /**
+   * Takes as many of the closed batches as there is room for in flight. Must
+   * be called with the mutex held.
+   */
+  std::vector<Batch> TakeBatchesToSend();
+
+  /** Hands the batches to the client. Must be called without the mutex. */
+  void Send(std::vector<Batch>&& batches);
+
+  std::shared_ptr<Firestore> firestore;
+  size_t max_pending_batches = 0;
+
+  mutable std::mutex mutex;
+  Batch current_batch;
+  std::deque<Batch> closed_batches;
+  size_t batches_in_flight = 0;
+
+  // Batches are committed in the order they are handed to the client, so
+  // counting the ones finished tells which flushes are done.
+  size_t batches_closed = 0;
+  size_t batches_finished = 0;
+
+  size_t writes_added = 0;
+  size_t writes_finished = 0;
+
+  Status first_error;
+  std::vector<FlushCallback> flush_callbacks;
+};
+
+void BulkWriter::State::Add(std::vector<FSTMutation*>&& mutations) {
+  std::vector<Batch> to_send;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    // The mutations of one write are never split across batches.
+    if (!current_batch.mutations.empty() &&
+        current_batch.mutations.size() + mutations.size() > kMaxBatchSize) {
+      CloseCurrentBatch();
+    }
+    std::move(mutations.begin(), mutations.end(),
+              std::back_inserter(current_batch.mutations));
+    current_batch.write_count++;
+    writes_added++;
+
+    if (current_batch.mutations.size() >= kMaxBatchSize) {
+      CloseCurrentBatch();
+    }
+    to_send = TakeBatchesToSend();
+  }
+  Send(std::move(to_send));
+}
+
+void BulkWriter::State::Flush(StatusCallback&& callback) {
+  std::vector<Batch> to_send;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    CloseCurrentBatch();
+    flush_callbacks.push_back(
+        FlushCallback{batches_closed, std::move(callback)});
+    to_send = TakeBatchesToSend();
+  }
+  Send(std::move(to_send));
+}
+
+void BulkWriter::State::OnBatchFinished(size_t write_count,
+                                        const Status& status) {
+  std::vector<Batch> to_send;
+  std::vector<StatusCallback> finished_callbacks;
+  Status error;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    batches_in_flight--;
+    batches_finished++;
+    writes_finished += write_count;
+    if (!status.ok() && first_error.ok()) {
+      first_error = status;
+    }
+    error = first_error;
+
+    auto finished = std::stable_partition(
+        flush_callbacks.begin(), flush_callbacks.end(),
+        [this](const FlushCallback& flush) {
+          return flush.batch_count > batches_finished;
+        });
+    for (auto iter = finished; iter != flush_callbacks.end(); ++iter) {
+      finished_callbacks.push_back(std::move(iter->callback));
+    }
+    flush_callbacks.erase(finished, flush_callbacks.end());
+
+    to_send = TakeBatchesToSend();
+  }
+
+  Send(std::move(to_send));
+  for (const StatusCallback& callback : finished_callbacks) {
+    if (callback) {
+      callback(error);
+    }
+  }
+}
+
+void BulkWriter::State::CloseCurrentBatch() {
+  closed_batches.push_back(std::move(current_batch));
+  current_batch = Batch{};
+  batches_closed++;
+}
+
+std::vector<BulkWriter::State::Batch> BulkWriter::State::TakeBatchesToSend() {
+  std::vector<Batch> result;
+  while (!closed_batches.empty() && batches_in_flight < max_pending_batches) {
+    result.push_back(std::move(closed_batches.front()));
+    closed_batches.pop_front();
+    batches_in_flight++;
+  }
+  return result;
+}
+
+void BulkWriter::State::Send(std::vector<Batch>&& batches) {
+  for (Batch& batch : batches) {
+    std::shared_ptr<State> self = shared_from_this();
+    size_t write_count = batch.write_count;
+    [firestore->client() writeMutations:std::move(batch.mutations)
+                               callback:[self, write_count](Status status) {
+                                 self->OnBatchFinished(write_count, status);
+                               }];
+  }
+}
+
+BulkWriter::BulkWriter(std::shared_ptr<Firestore> firestore,
+                       size_t max_pending_batches)
+    : firestore_{firestore} {
+  state_ = std::make_shared<State>(std::move(firestore),
+                                   std::max<size_t>(max_pending_batches, 1));
+}
+
+void BulkWriter::SetData(const DocumentReference& reference,
+                         core::ParsedSetData&& set_data) {
+  ValidateReference(reference);
+  AddMutations(std::move(set_data).ToMutations(reference.key(),
+                                               model::Precondition::None()));
+}
+
+void BulkWriter::UpdateData(const DocumentReference& reference,
+                            core::ParsedUpdateData&& update_data) {
+  ValidateReference(reference);
+  AddMutations(
+      std::move(update_data)
+          .ToMutations(reference.key(), model::Precondition::Exists(true)));
+}
+
+void BulkWriter::DeleteData(const DocumentReference& reference) {
+  ValidateReference(reference);
+  AddMutations({[[FSTDeleteMutation alloc]
+       initWithKey:reference.key()
+      precondition:model::Precondition::None()]});
+}
+
+void BulkWriter::Flush(StatusCallback callback) {
+  state_->Flush(std::move(callback));
+}
+
+size_t BulkWriter::pending_write_count() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->writes_added - state_->writes_finished;
+}
+
+void BulkWriter::AddMutations(std::vector<FSTMutation*>&& mutations) {
+  HARD_ASSERT(mutations.size() <= kMaxBatchSize,
+              "A single write produced %s mutations", mutations.size());
+  state_->Add(std::move(mutations));
+}
+
+void BulkWriter::ValidateReference(const DocumentReference& reference) const {
+  if (reference.firestore() != firestore_) {
+    ThrowInvalidArgument("Provided document reference is from a different "
+                         "Firestore instance.");
+  }
+}
+
+}  // namespace api
+}  // namespace firestore
+}  // namespace firebase
+
+NS_ASSUME_NONNULL_END
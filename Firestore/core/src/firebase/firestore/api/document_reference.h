@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_DOCUMENT_REFERENCE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_DOCUMENT_REFERENCE_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -79,6 +80,18 @@ class DocumentReference {
   void UpdateData(core::ParsedUpdateData&& updateData,
                   util::StatusCallback callback);
 
+  /**
+   * Like SetData, but gets the data by calling `parse` on the worker queue, in
+   * order with the other writes. If parsing fails with an invalid argument
+   * exception, the callback is given the error and nothing is written.
+   */
+  void SetData(std::function<core::ParsedSetData()> parse,
+               util::StatusCallback callback);
+
+  /** Like SetData, given a function that parses update data. */
+  void UpdateData(std::function<core::ParsedUpdateData()> parse,
+                  util::StatusCallback callback);
+
   void DeleteDocument(util::StatusCallback callback);
 
   void GetDocument(Source source, DocumentSnapshot::Listener&& callback);
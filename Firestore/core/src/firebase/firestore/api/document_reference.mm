@@ -109,6 +109,27 @@ void DocumentReference::UpdateData(core::ParsedUpdateData&& update_data,
             callback:std::move(callback)];
 }
 
+void DocumentReference::SetData(std::function<core::ParsedSetData()> parse,
+                                util::StatusCallback callback) {
+  DocumentKey key = key_;
+  [firestore_->client()
+      writeMutationsFromBlock:[parse, key] {
+        return parse().ToMutations(key, Precondition::None());
+      }
+                     callback:std::move(callback)];
+}
+
+void DocumentReference::UpdateData(
+    std::function<core::ParsedUpdateData()> parse,
+    util::StatusCallback callback) {
+  DocumentKey key = key_;
+  [firestore_->client()
+      writeMutationsFromBlock:[parse, key] {
+        return parse().ToMutations(key, Precondition::Exists(true));
+      }
+                     callback:std::move(callback)];
+}
+
 void DocumentReference::DeleteDocument(util::StatusCallback callback) {
   FSTDeleteMutation* mutation =
       [[FSTDeleteMutation alloc] initWithKey:key_
@@ -19,18 +19,24 @@
 
 #include <dispatch/dispatch.h>
 
+#include <functional>
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "Firestore/core/src/firebase/firestore/api/query_core.h"
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
+#include "Firestore/core/src/firebase/firestore/local/pending_writes.h"
+#include "Firestore/core/src/firebase/firestore/local/startup_profile.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_class.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor_callback.h"
 #include "absl/types/any.h"
@@ -48,8 +54,12 @@ namespace api {
 
 class CollectionReference;
 class DocumentReference;
+class DocumentSnapshot;
+class BulkWriter;
 class WriteBatch;
 
+enum class Source;
+
 class Firestore : public std::enable_shared_from_this<Firestore> {
  public:
   Firestore() = default;
@@ -84,6 +94,27 @@ class Firestore : public std::enable_shared_from_this<Firestore> {
   CollectionReference GetCollection(absl::string_view collection_path);
   DocumentReference GetDocument(absl::string_view document_path);
   WriteBatch GetBatch();
+
+  /**
+   * Reads the given documents all at once and invokes the callback with their
+   * snapshots, in the order of `references`.
+   *
+   * From the cache, all the documents are read in a single transaction, and
+   * the read fails if any of them isn't cached. Otherwise, they're looked up
+   * on the backend with a single request rather than listened to one at a
+   * time; if the backend can't be reached, `Source::Default` falls back to
+   * the cache.
+   */
+  void GetDocuments(
+      std::vector<DocumentReference> references,
+      Source source,
+      util::StatusOrCallback<std::vector<DocumentSnapshot>> callback);
+
+  /**
+   * Returns a writer for importing any number of documents, which commits
+   * them in batches with at most `max_pending_writes` of them in flight.
+   */
+  BulkWriter GetBulkWriter();
   FIRQuery* GetCollectionGroup(std::string collection_id);
 
   void RunTransaction(core::TransactionUpdateCallback update_callback,
@@ -95,6 +126,78 @@ class Firestore : public std::enable_shared_from_this<Firestore> {
   void EnableNetwork(util::StatusCallback callback);
   void DisableNetwork(util::StatusCallback callback);
 
+  /**
+   * Reports how long the steps of starting the local store took, once all of
+   * them have finished.
+   */
+  void GetStartupProfile(std::function<void(local::StartupProfile)> callback);
+
+  /**
+   * Returns the current values of the SDK's metrics, such as the work done in
+   * leveldb and the time operations wait on the worker queue. The metrics are
+   * shared by all Firestore instances in the process.
+   */
+  util::MetricsSnapshot GetStats() const;
+
+  /**
+   * Starts or stops recording the SDK's diagnostic messages into an in-memory
+   * log of recent ones, shared by all Firestore instances in the process.
+   */
+  void SetDiagnosticLogEnabled(bool enabled);
+
+  /**
+   * Returns the messages in the diagnostic log, oldest first, one per line.
+   */
+  std::string DumpDiagnosticLog() const;
+
+  /**
+   * Reads the documents matching the given queries from the local cache in
+   * the background, so that the first listen to one of them is served from
+   * memory rather than from disk. Does not delay other operations: each query
+   * is only read once no other work is waiting on the worker queue. The
+   * callback, if any, is invoked once all the queries have been read.
+   */
+  void PreloadQueries(std::vector<Query> queries,
+                      util::StatusCallback callback);
+
+  /**
+   * Frees memory in response to the system running low on it: trims the
+   * in-memory caches down to `Settings::memory_pressure_budget_bytes()` and
+   * runs garbage collection right away. Does nothing if the client hasn't
+   * started yet, since it won't have cached anything.
+   */
+  void HandleMemoryPressure();
+
+  /**
+   * Writes the resume tokens held back in memory if
+   * `Settings::target_persistence_interval_ms()` is positive, since the app
+   * may be terminated while in the background. Does nothing if the client
+   * hasn't started yet.
+   */
+  void HandleBackgrounding();
+
+  /**
+   * Reports how many writes, and how many bytes of them, are waiting in the
+   * local cache to be acknowledged by the backend. The counts are kept up to
+   * date as writes are made and acknowledged, so nothing is read to get them.
+   */
+  void GetPendingWrites(std::function<void(local::PendingWrites)> callback);
+
+  /**
+   * Lets writers throttle themselves before the backlog of pending writes
+   * slows down reads from the local cache, each of which applies the pending
+   * writes to the documents it reads.
+   *
+   * The listener is invoked with the backlog and `true` whenever the backlog
+   * reaches `threshold` in either amount, and with `false` whenever it drops
+   * back below it. A backlog that has already reached the threshold is
+   * reported right away. Setting a listener replaces the previous one; an
+   * empty listener removes it.
+   */
+  void SetPendingWritesListener(
+      local::PendingWrites threshold,
+      std::function<void(local::PendingWrites, bool)> listener);
+
  private:
   void EnsureClientConfigured();
   core::DatabaseInfo MakeDatabaseInfo() const;
@@ -25,15 +25,20 @@
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTLevelDB.h"
 
+#include "Firestore/core/src/firebase/firestore/api/bulk_writer.h"
 #include "Firestore/core/src/firebase/firestore/api/collection_reference.h"
 #include "Firestore/core/src/firebase/firestore/api/document_reference.h"
+#include "Firestore/core/src/firebase/firestore/api/document_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/api/input_validation.h"
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
+#include "Firestore/core/src/firebase/firestore/api/source.h"
 #include "Firestore/core/src/firebase/firestore/api/write_batch.h"
 #include "Firestore/core/src/firebase/firestore/auth/firebase_credentials_provider_apple.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/diagnostic_log.h"
 #include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
@@ -117,6 +122,53 @@ WriteBatch Firestore::GetBatch() {
   return WriteBatch(shared_from_this());
 }
 
+void Firestore::GetDocuments(
+    std::vector<DocumentReference> references,
+    Source source,
+    util::StatusOrCallback<std::vector<DocumentSnapshot>> callback) {
+  for (const DocumentReference& reference : references) {
+    if (reference.firestore().get() != this) {
+      ThrowInvalidArgument("Provided document reference is from a different "
+                           "Firestore instance.");
+    }
+  }
+
+  EnsureClientConfigured();
+  if (source == Source::Cache) {
+    [client_ getDocumentReferencesFromLocalCache:references
+                                        callback:std::move(callback)];
+    return;
+  }
+
+  bool cache_results = settings().one_shot_query_caching_enabled();
+  FSTFirestoreClient* client = client_;
+  util::StatusOrCallback<std::vector<DocumentSnapshot>> on_server_result;
+  if (source == Source::Default) {
+    on_server_result =
+        [client, references,
+         callback](util::StatusOr<std::vector<DocumentSnapshot>> result) {
+          if (!result.ok() && result.status().code() == Error::Unavailable) {
+            [client getDocumentReferencesFromLocalCache:references
+                                               callback:callback];
+          } else if (callback) {
+            callback(std::move(result));
+          }
+        };
+  } else {
+    on_server_result = std::move(callback);
+  }
+
+  [client getDocumentReferencesFromServer:references
+                             cacheResults:cache_results
+                                 callback:std::move(on_server_result)];
+}
+
+BulkWriter Firestore::GetBulkWriter() {
+  EnsureClientConfigured();
+  return BulkWriter(shared_from_this(),
+                    static_cast<size_t>(settings_.max_pending_writes()));
+}
+
 FIRQuery* Firestore::GetCollectionGroup(std::string collection_id) {
   EnsureClientConfigured();
 
@@ -151,6 +203,7 @@ void Firestore::ClearPersistence(util::StatusCallback callback) {
       }
     };
 
+    bool defer_deletion = false;
     {
       std::lock_guard<std::mutex> lock{mutex_};
       if (client_ && !client().isShutdown) {
@@ -159,9 +212,11 @@ void Firestore::ClearPersistence(util::StatusCallback callback) {
             "Persistence cannot be cleared while the client is running."));
         return;
       }
+      defer_deletion = settings_.deferred_persistence_deletion_enabled();
     }
 
-    Yield([FSTLevelDB clearPersistence:MakeDatabaseInfo()]);
+    Yield([FSTLevelDB clearPersistence:MakeDatabaseInfo()
+                         deferDeletion:defer_deletion]);
   });
 }
 
@@ -175,6 +230,57 @@ void Firestore::DisableNetwork(util::StatusCallback callback) {
   [client_ disableNetworkWithCallback:std::move(callback)];
 }
 
+void Firestore::GetStartupProfile(
+    std::function<void(local::StartupProfile)> callback) {
+  EnsureClientConfigured();
+  [client_ startupProfileWithCallback:std::move(callback)];
+}
+
+util::MetricsSnapshot Firestore::GetStats() const {
+  return util::MetricsRegistry::Default().Snapshot();
+}
+
+void Firestore::SetDiagnosticLogEnabled(bool enabled) {
+  util::DiagnosticLog::Default().set_enabled(enabled);
+}
+
+std::string Firestore::DumpDiagnosticLog() const {
+  return util::DiagnosticLog::Default().Dump();
+}
+
+void Firestore::PreloadQueries(std::vector<Query> queries,
+                               util::StatusCallback callback) {
+  EnsureClientConfigured();
+  [client_ preloadQueries:std::move(queries) callback:std::move(callback)];
+}
+
+void Firestore::HandleMemoryPressure() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (client_ && !client().isShutdown) {
+    [client_ handleMemoryPressure];
+  }
+}
+
+void Firestore::HandleBackgrounding() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (client_ && !client().isShutdown) {
+    [client_ handleBackgrounding];
+  }
+}
+
+void Firestore::GetPendingWrites(
+    std::function<void(local::PendingWrites)> callback) {
+  EnsureClientConfigured();
+  [client_ pendingWritesWithCallback:std::move(callback)];
+}
+
+void Firestore::SetPendingWritesListener(
+    local::PendingWrites threshold,
+    std::function<void(local::PendingWrites, bool)> listener) {
+  EnsureClientConfigured();
+  [client_ setPendingWritesThreshold:threshold listener:std::move(listener)];
+}
+
 void Firestore::EnsureClientConfigured() {
   std::lock_guard<std::mutex> lock{mutex_};
 
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_QUERY_CORE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_QUERY_CORE_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -29,6 +30,7 @@
 #include "Firestore/core/src/firebase/firestore/core/event_listener.h"
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
 #include "Firestore/core/src/firebase/firestore/core/listen_options.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_class.h"
 
@@ -48,6 +50,13 @@ class Firestore;
  */
 class Query {
  public:
+  /**
+   * Receives the documents read by `ProfileDocumentsFromCache` and the work
+   * reading them took.
+   */
+  using ProfileListener =
+      std::function<void(QuerySnapshot snapshot, local::QueryProfile profile)>;
+
   Query() = default;
 
   Query(FSTQuery* query, std::shared_ptr<Firestore> firestore);
@@ -71,6 +80,23 @@ class Query {
    */
   void GetDocuments(Source source, QuerySnapshot::Listener&& callback);
 
+  /**
+   * Reads the documents matching this query from the cache, like
+   * `GetDocuments(Source::Cache, ...)`, and reports how many documents and
+   * mutation batches the local store scanned to do so, how long decoding them
+   * took, and how long computing the view of the results took.
+   *
+   * @param callback a callback to execute once the documents have been read.
+   */
+  void ProfileDocumentsFromCache(ProfileListener&& callback);
+
+  /**
+   * Returns the work done by all the queries the Firestore instance of this
+   * query has executed against the cache so far, whether profiled or not.
+   * Snapshot listeners are not included.
+   */
+  local::QueryProfile AggregateProfile() const;
+
   /**
    * Attaches a listener for QuerySnapshot events.
    *
@@ -164,6 +190,8 @@ class Query {
 
  private:
   void ValidateNewFilter(const core::Filter& filter) const;
+  void ValidateDisjunctiveFilterElements(const model::FieldValue& field_value,
+                                         core::Filter::Operator op) const;
   void ValidateNewOrderByPath(const model::FieldPath& fieldPath) const;
   void ValidateOrderByField(const model::FieldPath& orderByField,
                             const model::FieldPath& inequalityField) const;
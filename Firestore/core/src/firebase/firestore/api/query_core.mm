@@ -27,7 +27,9 @@
 #include "Firestore/core/src/firebase/firestore/core/field_filter.h"
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "absl/algorithm/container.h"
+#include "absl/types/optional.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -54,6 +56,33 @@ using util::StatusOr;
 
 using Operator = Filter::Operator;
 
+namespace {
+
+/** Returns the name of `op` in the public API, for error messages. */
+const char* Describe(Operator op) {
+  switch (op) {
+    case Operator::LessThan:
+      return "lessThan";
+    case Operator::LessThanOrEqual:
+      return "lessThanOrEqual";
+    case Operator::Equal:
+      return "equal";
+    case Operator::GreaterThanOrEqual:
+      return "greaterThanOrEqual";
+    case Operator::GreaterThan:
+      return "greaterThan";
+    case Operator::ArrayContains:
+      return "arrayContains";
+    case Operator::In:
+      return "in";
+    case Operator::ArrayContainsAny:
+      return "arrayContainsAny";
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
 Query::Query(FSTQuery* query, std::shared_ptr<Firestore> firestore)
     : firestore_{std::move(firestore)}, query_{query} {
 }
@@ -78,6 +107,15 @@ void Query::GetDocuments(Source source, QuerySnapshot::Listener&& callback) {
     return;
   }
 
+  const Settings& settings = firestore_->settings();
+  if (source == Source::Server && settings.one_shot_server_queries_enabled()) {
+    [firestore_->client()
+        getDocumentsFromServer:*this
+                  cacheResults:settings.one_shot_query_caching_enabled()
+                      callback:std::move(callback)];
+    return;
+  }
+
   ListenOptions options(
       /*include_query_metadata_changes=*/true,
       /*include_document_metadata_changes=*/true,
@@ -134,6 +172,15 @@ void Query::GetDocuments(Source source, QuerySnapshot::Listener&& callback) {
   listener_unowned->Resolve(std::move(registration));
 }
 
+void Query::ProfileDocumentsFromCache(ProfileListener&& callback) {
+  [firestore_->client() profileDocumentsFromLocalCache:*this
+                                              callback:std::move(callback)];
+}
+
+local::QueryProfile Query::AggregateProfile() const {
+  return [firestore_->client() aggregateQueryProfile];
+}
+
 ListenerRegistration Query::AddSnapshotListener(
     ListenOptions options, QuerySnapshot::Listener&& user_listener) {
   // Convert from ViewSnapshots to QuerySnapshots.
@@ -187,10 +234,16 @@ Query Query::Filter(FieldPath field_path,
                     FieldValue field_value,
                     const std::function<std::string()>& type_describer) const {
   if (field_path.IsKeyFieldPath()) {
-    if (op == Filter::Operator::ArrayContains) {
+    if (op == Filter::Operator::ArrayContains ||
+        op == Filter::Operator::ArrayContainsAny) {
       ThrowInvalidArgument(
-          "Invalid query. You can't perform arrayContains queries on document "
-          "ID since document IDs are not arrays.");
+          "Invalid query. You can't perform %s queries on document ID since "
+          "document IDs are not arrays.",
+          Describe(op));
+    }
+    if (op == Filter::Operator::In) {
+      ThrowInvalidArgument(
+          "Invalid query. You can't perform in queries on document ID.");
     }
     if (field_value.type() == FieldValue::Type::String) {
       const std::string& document_key = field_value.string_value();
@@ -225,6 +278,10 @@ Query Query::Filter(FieldPath field_path,
     }
   }
 
+  if (op == Filter::Operator::In || op == Filter::Operator::ArrayContainsAny) {
+    ValidateDisjunctiveFilterElements(field_value, op);
+  }
+
   std::shared_ptr<FieldFilter> filter =
       FieldFilter::Create(field_path, op, field_value);
   ValidateNewFilter(*filter);
@@ -271,8 +328,47 @@ namespace {
 
 constexpr Operator kArrayOps[] = {
     Operator::ArrayContains,
+    Operator::ArrayContainsAny,
 };
 
+constexpr Operator kDisjunctiveOps[] = {
+    Operator::In,
+    Operator::ArrayContainsAny,
+};
+
+/** The maximum number of values an in or arrayContainsAny filter accepts. */
+constexpr size_t kMaxDisjunctiveValues = 10;
+
+}  // namespace
+
+void Query::ValidateDisjunctiveFilterElements(const FieldValue& field_value,
+                                              Operator op) const {
+  if (field_value.type() != FieldValue::Type::Array ||
+      field_value.array_value().empty()) {
+    ThrowInvalidArgument(
+        "Invalid Query. A non-empty array is required for '%s' filters.",
+        Describe(op));
+  }
+  if (field_value.array_value().size() > kMaxDisjunctiveValues) {
+    ThrowInvalidArgument("Invalid Query. '%s' filters support a maximum of "
+                         "%s elements in the value array.",
+                         Describe(op), kMaxDisjunctiveValues);
+  }
+
+  for (const FieldValue& value : field_value.array_value()) {
+    if (value.type() == FieldValue::Type::Null) {
+      ThrowInvalidArgument(
+          "Invalid Query. '%s' filters cannot contain 'null' in the value "
+          "array.",
+          Describe(op));
+    }
+    if (value.is_nan()) {
+      ThrowInvalidArgument(
+          "Invalid Query. '%s' filters cannot contain 'NaN' in the value "
+          "array.",
+          Describe(op));
+    }
+  }
 }
 
 void Query::ValidateNewFilter(const class Filter& filter) const {
@@ -302,10 +398,31 @@ void Query::ValidateNewFilter(const class Filter& filter) const {
       // the new filter conflicts with an existing one.
       Operator filter_op = field_filter.op();
       bool is_array_op = absl::c_linear_search(kArrayOps, filter_op);
+      bool is_disjunctive_op =
+          absl::c_linear_search(kDisjunctiveOps, filter_op);
+
+      absl::optional<Operator> conflicting_op;
+      if (is_disjunctive_op) {
+        conflicting_op = query().query.FindOperator(kDisjunctiveOps);
+      }
+      if (!conflicting_op && is_array_op) {
+        conflicting_op = query().query.FindOperator(kArrayOps);
+      }
 
-      if (is_array_op && [query_ hasArrayContainsFilter]) {
-        ThrowInvalidArgument("Invalid Query. Queries only support a single "
-                             "arrayContains filter.");
+      if (conflicting_op) {
+        if (*conflicting_op == Operator::ArrayContains &&
+            filter_op == Operator::ArrayContains) {
+          ThrowInvalidArgument("Invalid Query. Queries only support a single "
+                               "arrayContains filter.");
+        } else if (*conflicting_op == filter_op) {
+          ThrowInvalidArgument(
+              "Invalid Query. You cannot use more than one '%s' filter.",
+              Describe(filter_op));
+        } else {
+          ThrowInvalidArgument(
+              "Invalid Query. You cannot use '%s' filters with '%s' filters.",
+              Describe(filter_op), Describe(*conflicting_op));
+        }
       }
     }
   }
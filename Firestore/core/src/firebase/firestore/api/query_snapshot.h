@@ -20,6 +20,7 @@
 #include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/api/document_change.h"
 #include "Firestore/core/src/firebase/firestore/api/document_snapshot.h"
@@ -28,6 +29,7 @@
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_class.h"
+#include "absl/types/optional.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -88,6 +90,8 @@ class QuerySnapshot {
   /**
    * Iterates over the `DocumentChanges` representing the changes between
    * the prior snapshot and this one.
+   *
+   * The changes are computed on the first call and reused afterwards.
    */
   void ForEachChange(bool include_metadata_changes,
                      const std::function<void(DocumentChange)>& callback) const;
@@ -95,10 +99,20 @@ class QuerySnapshot {
   friend bool operator==(const QuerySnapshot& lhs, const QuerySnapshot& rhs);
 
  private:
+  /**
+   * Returns all the changes between the prior snapshot and this one, including
+   * metadata changes, in the order of `snapshot_.document_changes()`.
+   */
+  const std::vector<DocumentChange>& changes() const;
+
+  std::vector<DocumentChange> ComputeChanges() const;
+
   std::shared_ptr<Firestore> firestore_;
   objc::Handle<FSTQuery> internal_query_;
   core::ViewSnapshot snapshot_;
   SnapshotMetadata metadata_;
+
+  mutable absl::optional<std::vector<DocumentChange>> changes_;
 };
 
 }  // namespace api
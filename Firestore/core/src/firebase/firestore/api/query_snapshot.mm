@@ -16,7 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/api/query_snapshot.h"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/API/FIRDocumentChange+Internal.h"
 #import "Firestore/Source/API/FIRDocumentSnapshot+Internal.h"
@@ -42,6 +44,8 @@ namespace api {
 using api::Firestore;
 using core::DocumentViewChange;
 using core::ViewSnapshot;
+using model::DocumentComparator;
+using model::DocumentKey;
 using model::DocumentSet;
 
 QuerySnapshot::QuerySnapshot(std::shared_ptr<Firestore> firestore,
@@ -100,6 +104,71 @@ static DocumentChange::Type DocumentChangeTypeForChange(
   HARD_FAIL("Unknown DocumentViewChange::Type: %s", change.type());
 }
 
+namespace {
+
+/**
+ * Keeps track of which of a fixed number of positions are occupied, and
+ * counts the occupied positions before any given one in logarithmic time (a
+ * Fenwick tree).
+ */
+class PositionCounter {
+ public:
+  explicit PositionCounter(size_t size) : counts_(size + 1) {
+  }
+
+  void Occupy(size_t position) {
+    Add(position, 1);
+  }
+
+  void Vacate(size_t position) {
+    Add(position, -1);
+  }
+
+  /** Returns the number of occupied positions before `position`. */
+  size_t CountBefore(size_t position) const {
+    int count = 0;
+    for (size_t i = position; i > 0; i -= LowestBit(i)) {
+      count += counts_[i];
+    }
+    return static_cast<size_t>(count);
+  }
+
+ private:
+  static size_t LowestBit(size_t i) {
+    return i & (~i + 1);
+  }
+
+  void Add(size_t position, int delta) {
+    for (size_t i = position + 1; i < counts_.size(); i += LowestBit(i)) {
+      counts_[i] += delta;
+    }
+  }
+
+  std::vector<int> counts_;
+};
+
+/**
+ * The place of one version of a changed document among the documents of the
+ * old and the new snapshot.
+ */
+struct ChangedPosition {
+  FSTDocument* document;
+
+  /** The index of the change in `ViewSnapshot::document_changes()`. */
+  size_t change;
+
+  /** Whether `document` is the version from the old snapshot. */
+  bool old_version;
+
+  /**
+   * The index of `document` in the old snapshot if `old_version`, in the new
+   * snapshot otherwise.
+   */
+  size_t index;
+};
+
+}  // namespace
+
 void QuerySnapshot::ForEachChange(
     bool include_metadata_changes,
     const std::function<void(DocumentChange)>& callback) const {
@@ -109,63 +178,146 @@ void QuerySnapshot::ForEachChange(
                          "addSnapshotListener(includeMetadataChanges:true).");
   }
 
-  if (snapshot_.old_documents().empty()) {
+  // Metadata-only changes never move a document, so leaving them out doesn't
+  // affect the indices of the other changes.
+  const std::vector<DocumentViewChange>& view_changes =
+      snapshot_.document_changes();
+  const std::vector<DocumentChange>& changes = this->changes();
+  for (size_t i = 0; i != changes.size(); ++i) {
+    if (!include_metadata_changes &&
+        view_changes[i].type() == DocumentViewChange::Type::kMetadata) {
+      continue;
+    }
+    callback(changes[i]);
+  }
+}
+
+const std::vector<DocumentChange>& QuerySnapshot::changes() const {
+  if (!changes_) {
+    changes_ = ComputeChanges();
+  }
+  return *changes_;
+}
+
+std::vector<DocumentChange> QuerySnapshot::ComputeChanges() const {
+  const std::vector<DocumentViewChange>& view_changes =
+      snapshot_.document_changes();
+  DocumentComparator comparator = snapshot_.query().comparator;
+
+  std::vector<DocumentChange> result;
+  result.reserve(view_changes.size());
+
+  auto make_snapshot = [this](FSTDocument* doc) {
+    SnapshotMetadata metadata(
+        /*pending_writes=*/snapshot_.mutated_keys().contains(doc.key),
+        /*from_cache=*/snapshot_.from_cache());
+    return DocumentSnapshot(firestore_, doc.key, doc, metadata);
+  };
+
+  const DocumentSet& old_documents = snapshot_.old_documents();
+  if (old_documents.empty()) {
     // Special case the first snapshot because index calculation is easy and
     // fast. Also all changes on the first snapshot are adds so there are also
     // no metadata-only changes to filter out.
     FSTDocument* last_document = nil;
     size_t index = 0;
-    for (const DocumentViewChange& change : snapshot_.document_changes()) {
-      FSTDocument* doc = change.document();
-      SnapshotMetadata metadata(
-          /*pending_writes=*/snapshot_.mutated_keys().contains(doc.key),
-          /*from_cache=*/snapshot_.from_cache());
-      DocumentSnapshot document(firestore_, doc.key, doc, metadata);
-
+    for (const DocumentViewChange& change : view_changes) {
       HARD_ASSERT(change.type() == DocumentViewChange::Type::kAdded,
                   "Invalid event type for first snapshot");
-      HARD_ASSERT(!last_document ||
-                      util::Ascending(snapshot_.query().comparator.Compare(
-                          last_document, change.document())),
+      HARD_ASSERT(!last_document || util::Ascending(comparator.Compare(
+                                        last_document, change.document())),
                   "Got added events in wrong order");
+      last_document = change.document();
 
-      callback(DocumentChange(DocumentChange::Type::Added, std::move(document),
-                              DocumentChange::npos, index++));
+      result.emplace_back(DocumentChange::Type::Added,
+                          make_snapshot(change.document()),
+                          DocumentChange::npos, index++);
     }
+    return result;
+  }
 
-  } else {
-    // A DocumentSet that is updated incrementally as changes are applied to use
-    // to lookup the index of a document.
-    DocumentSet index_tracker = snapshot_.old_documents();
-    for (const DocumentViewChange& change : snapshot_.document_changes()) {
-      if (!include_metadata_changes &&
-          change.type() == DocumentViewChange::Type::kMetadata) {
-        continue;
-      }
-
-      FSTDocument* doc = change.document();
-      SnapshotMetadata metadata(
-          /*pending_writes=*/snapshot_.mutated_keys().contains(doc.key),
-          /*from_cache=*/snapshot_.from_cache());
-      DocumentSnapshot document(firestore_, doc.key, doc, metadata);
-
-      size_t old_index = DocumentChange::npos;
-      size_t new_index = DocumentChange::npos;
-      if (change.type() != DocumentViewChange::Type::kAdded) {
-        old_index = index_tracker.IndexOf(change.document().key);
-        HARD_ASSERT(old_index != DocumentSet::npos,
-                    "Index for document not found");
-        index_tracker = index_tracker.erase(change.document().key);
-      }
-      if (change.type() != DocumentViewChange::Type::kRemoved) {
-        index_tracker = index_tracker.insert(change.document());
-        new_index = index_tracker.IndexOf(change.document().key);
-      }
-
-      DocumentChange::Type type = DocumentChangeTypeForChange(change);
-      callback(DocumentChange(type, std::move(document), old_index, new_index));
+  // Applying the changes one after another to the old documents, each change
+  // vacates the position of the old version of its document, occupies the
+  // position of the new version, or both. Rather than maintaining the
+  // intermediate document sets, sort just the positions the changes touch.
+  // Every other document stays where it was throughout, so the index of a
+  // position at any point is the number of untouched documents before it plus
+  // the number of touched positions before it that are occupied at the time.
+  const DocumentSet& new_documents = snapshot_.documents();
+  std::vector<ChangedPosition> positions;
+  positions.reserve(view_changes.size() * 2);
+  for (size_t i = 0; i != view_changes.size(); ++i) {
+    const DocumentViewChange& change = view_changes[i];
+    const DocumentKey& key = change.document().key;
+    if (change.type() != DocumentViewChange::Type::kAdded) {
+      size_t index = old_documents.IndexOf(key);
+      HARD_ASSERT(index != DocumentSet::npos, "Index for document not found");
+      positions.push_back({old_documents.GetDocument(key), i, true, index});
     }
+    if (change.type() != DocumentViewChange::Type::kRemoved) {
+      size_t index = new_documents.IndexOf(key);
+      HARD_ASSERT(index != DocumentSet::npos, "Index for document not found");
+      positions.push_back({change.document(), i, false, index});
+    }
+  }
+
+  // Both versions of a document that didn't move compare the same; the order
+  // between them doesn't matter, since one is vacated before the other is
+  // occupied.
+  std::sort(positions.begin(), positions.end(),
+            [&comparator](const ChangedPosition& lhs,
+                          const ChangedPosition& rhs) {
+              util::ComparisonResult cmp =
+                  comparator.Compare(lhs.document, rhs.document);
+              if (cmp != util::ComparisonResult::Same) {
+                return util::Ascending(cmp);
+              }
+              return lhs.old_version && !rhs.old_version;
+            });
+
+  // An old version's index in the old documents counts the touched old
+  // versions before it, and a new version's index in the new documents counts
+  // the touched new versions before it; take those out to leave the untouched
+  // documents.
+  std::vector<size_t> untouched_before(positions.size());
+  std::vector<size_t> old_positions(view_changes.size());
+  std::vector<size_t> new_positions(view_changes.size());
+  PositionCounter occupied(positions.size());
+  size_t old_versions_seen = 0;
+  size_t new_versions_seen = 0;
+  for (size_t p = 0; p != positions.size(); ++p) {
+    const ChangedPosition& position = positions[p];
+    if (position.old_version) {
+      untouched_before[p] = position.index - old_versions_seen++;
+      old_positions[position.change] = p;
+      occupied.Occupy(p);
+    } else {
+      untouched_before[p] = position.index - new_versions_seen++;
+      new_positions[position.change] = p;
+    }
+  }
+
+  for (size_t i = 0; i != view_changes.size(); ++i) {
+    const DocumentViewChange& change = view_changes[i];
+
+    size_t old_index = DocumentChange::npos;
+    size_t new_index = DocumentChange::npos;
+    if (change.type() != DocumentViewChange::Type::kAdded) {
+      size_t p = old_positions[i];
+      occupied.Vacate(p);
+      old_index = untouched_before[p] + occupied.CountBefore(p);
+    }
+    if (change.type() != DocumentViewChange::Type::kRemoved) {
+      size_t p = new_positions[i];
+      new_index = untouched_before[p] + occupied.CountBefore(p);
+      occupied.Occupy(p);
+    }
+
+    DocumentChange::Type type = DocumentChangeTypeForChange(change);
+    result.emplace_back(type, make_snapshot(change.document()), old_index,
+                        new_index);
   }
+  return result;
 }
 
 }  // namespace api
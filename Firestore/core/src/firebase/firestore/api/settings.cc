@@ -28,10 +28,61 @@ constexpr bool Settings::DefaultPersistenceEnabled;
 constexpr int64_t Settings::DefaultCacheSizeBytes;
 constexpr int64_t Settings::MinimumCacheSizeBytes;
 constexpr bool Settings::DefaultTimestampsInSnapshotsEnabled;
+constexpr int64_t Settings::DefaultDocumentCacheSizeBytes;
+constexpr int64_t Settings::DefaultMemoryPressureBudgetBytes;
+constexpr int Settings::DefaultMaxPendingWrites;
+constexpr bool Settings::DefaultAdaptiveWritePipelineEnabled;
+constexpr bool Settings::DefaultWriteBatchCoalescingEnabled;
+constexpr bool Settings::DefaultWriteAckCoalescingEnabled;
+constexpr bool Settings::DefaultSeparateWatchChannelEnabled;
+constexpr bool Settings::DefaultSharedGrpcRuntimeEnabled;
+constexpr int32_t Settings::DefaultLimitPrefetchSize;
+constexpr bool Settings::DefaultSharedQueryExecutionEnabled;
+constexpr bool Settings::DefaultSnapshotBatchingEnabled;
+constexpr bool Settings::DefaultOneShotServerQueriesEnabled;
+constexpr bool Settings::DefaultOneShotQueryCachingEnabled;
+constexpr bool Settings::DefaultParallelViewComputationEnabled;
+constexpr bool Settings::DefaultLazyLocalStoreStartEnabled;
+constexpr bool Settings::DefaultQueryFromTargetKeysEnabled;
+constexpr bool Settings::DefaultMutationCompactionEnabled;
+constexpr bool Settings::DefaultTransactionPrefetchEnabled;
+constexpr bool Settings::DefaultDeferredUserDataParsingEnabled;
+constexpr bool Settings::DefaultSnapshotReadsEnabled;
+constexpr bool Settings::DefaultDeferredPersistenceDeletionEnabled;
+constexpr int32_t Settings::DefaultMaxConcurrentLimboResolutions;
+constexpr int64_t Settings::DefaultStreamIdleTimeoutMs;
+constexpr int64_t Settings::DefaultResumeTokenMaxAgeSeconds;
+constexpr int64_t Settings::DefaultTargetPersistenceIntervalMs;
 
 size_t Settings::Hash() const {
   return util::Hash(host_, ssl_enabled_, persistence_enabled_,
-                    timestamps_in_snapshots_enabled_, cache_size_bytes_);
+                    timestamps_in_snapshots_enabled_, cache_size_bytes_,
+                    document_cache_size_bytes_, memory_pressure_budget_bytes_,
+                    max_pending_writes_,
+                    adaptive_write_pipeline_enabled_,
+                    write_batch_coalescing_enabled_,
+                    write_ack_coalescing_enabled_,
+                    separate_watch_channel_enabled_,
+                    shared_grpc_runtime_enabled_, limit_prefetch_size_,
+                    shared_query_execution_enabled_,
+                    snapshot_batching_enabled_,
+                    one_shot_server_queries_enabled_,
+                    one_shot_query_caching_enabled_,
+                    parallel_view_computation_enabled_,
+                    lazy_local_store_start_enabled_,
+                    query_from_target_keys_enabled_,
+                    mutation_compaction_enabled_,
+                    transaction_prefetch_enabled_,
+                    deferred_user_data_parsing_enabled_,
+                    snapshot_reads_enabled_,
+                    deferred_persistence_deletion_enabled_,
+                    max_concurrent_limbo_resolutions_,
+                    watch_stream_backoff_policy_, write_stream_backoff_policy_,
+                    watch_stream_idle_timeout_ms_,
+                    write_stream_idle_timeout_ms_,
+                    resume_token_max_age_seconds_,
+                    target_persistence_interval_ms_, keepalive_policy_,
+                    compression_policy_, persistence_tuning_);
 }
 
 bool operator==(const Settings& lhs, const Settings& rhs) {
@@ -39,7 +90,58 @@ bool operator==(const Settings& lhs, const Settings& rhs) {
          lhs.persistence_enabled_ == rhs.persistence_enabled_ &&
          lhs.timestamps_in_snapshots_enabled_ ==
              rhs.timestamps_in_snapshots_enabled_ &&
-         lhs.cache_size_bytes_ == rhs.cache_size_bytes_;
+         lhs.cache_size_bytes_ == rhs.cache_size_bytes_ &&
+         lhs.document_cache_size_bytes_ == rhs.document_cache_size_bytes_ &&
+         lhs.memory_pressure_budget_bytes_ ==
+             rhs.memory_pressure_budget_bytes_ &&
+         lhs.max_pending_writes_ == rhs.max_pending_writes_ &&
+         lhs.adaptive_write_pipeline_enabled_ ==
+             rhs.adaptive_write_pipeline_enabled_ &&
+         lhs.write_batch_coalescing_enabled_ ==
+             rhs.write_batch_coalescing_enabled_ &&
+         lhs.write_ack_coalescing_enabled_ ==
+             rhs.write_ack_coalescing_enabled_ &&
+         lhs.separate_watch_channel_enabled_ ==
+             rhs.separate_watch_channel_enabled_ &&
+         lhs.shared_grpc_runtime_enabled_ ==
+             rhs.shared_grpc_runtime_enabled_ &&
+         lhs.limit_prefetch_size_ == rhs.limit_prefetch_size_ &&
+         lhs.shared_query_execution_enabled_ ==
+             rhs.shared_query_execution_enabled_ &&
+         lhs.snapshot_batching_enabled_ == rhs.snapshot_batching_enabled_ &&
+         lhs.one_shot_server_queries_enabled_ ==
+             rhs.one_shot_server_queries_enabled_ &&
+         lhs.one_shot_query_caching_enabled_ ==
+             rhs.one_shot_query_caching_enabled_ &&
+         lhs.parallel_view_computation_enabled_ ==
+             rhs.parallel_view_computation_enabled_ &&
+         lhs.lazy_local_store_start_enabled_ ==
+             rhs.lazy_local_store_start_enabled_ &&
+         lhs.query_from_target_keys_enabled_ ==
+             rhs.query_from_target_keys_enabled_ &&
+         lhs.mutation_compaction_enabled_ == rhs.mutation_compaction_enabled_ &&
+         lhs.transaction_prefetch_enabled_ ==
+             rhs.transaction_prefetch_enabled_ &&
+         lhs.deferred_user_data_parsing_enabled_ ==
+             rhs.deferred_user_data_parsing_enabled_ &&
+         lhs.snapshot_reads_enabled_ == rhs.snapshot_reads_enabled_ &&
+         lhs.deferred_persistence_deletion_enabled_ ==
+             rhs.deferred_persistence_deletion_enabled_ &&
+         lhs.max_concurrent_limbo_resolutions_ ==
+             rhs.max_concurrent_limbo_resolutions_ &&
+         lhs.watch_stream_backoff_policy_ == rhs.watch_stream_backoff_policy_ &&
+         lhs.write_stream_backoff_policy_ == rhs.write_stream_backoff_policy_ &&
+         lhs.watch_stream_idle_timeout_ms_ ==
+             rhs.watch_stream_idle_timeout_ms_ &&
+         lhs.write_stream_idle_timeout_ms_ ==
+             rhs.write_stream_idle_timeout_ms_ &&
+         lhs.resume_token_max_age_seconds_ ==
+             rhs.resume_token_max_age_seconds_ &&
+         lhs.target_persistence_interval_ms_ ==
+             rhs.target_persistence_interval_ms_ &&
+         lhs.keepalive_policy_ == rhs.keepalive_policy_ &&
+         lhs.compression_policy_ == rhs.compression_policy_ &&
+         lhs.persistence_tuning_ == rhs.persistence_tuning_;
 }
 
 }  // namespace api
@@ -20,10 +20,100 @@
 
 #include <string>
 
+#include "Firestore/core/src/firebase/firestore/remote/backoff_policy.h"
+#include "Firestore/core/src/firebase/firestore/remote/compression_policy.h"
+#include "Firestore/core/src/firebase/firestore/remote/keepalive_policy.h"
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+
 namespace firebase {
 namespace firestore {
 namespace api {
 
+/**
+ * Tuning for the on-disk cache used when persistence is enabled. A value of
+ * zero keeps the storage engine's default for that option.
+ */
+struct PersistenceTuning {
+  /** The number of bytes of uncompressed blocks kept in memory. */
+  int64_t block_cache_size_bytes = 0;
+
+  /**
+   * The number of bytes of writes buffered in memory before they are sorted
+   * into a file on disk.
+   */
+  int64_t write_buffer_size_bytes = 0;
+
+  /** The approximate number of bytes of data packed into each block. */
+  int64_t block_size_bytes = 0;
+
+  /**
+   * If positive, each file on disk carries a Bloom filter using this many bits
+   * per key, which lets most lookups of missing keys skip reading from disk.
+   */
+  int bloom_filter_bits_per_key = 0;
+
+  /** Whether blocks are compressed on disk. */
+  bool compression_enabled = true;
+
+  /**
+   * Whether cached documents are compressed with a dictionary sampled from the
+   * documents already cached, which captures the field names, values and
+   * resource name prefixes that recur across documents. Compressed documents
+   * stay readable after this is turned off, but not by SDK versions that
+   * predate document compression.
+   */
+  bool document_compression_enabled = false;
+
+  /**
+   * Whether cached documents name themselves, and the documents they
+   * reference, relative to the database rather than by their fully qualified
+   * names. Documents stored this way stay readable after this is turned off,
+   * but not by SDK versions that predate relative names.
+   */
+  bool relative_document_names_enabled = false;
+
+  /**
+   * Whether every write to disk waits until the data has reached stable
+   * storage. Otherwise, writes survive the app crashing, but the most recent
+   * ones may be lost if the device loses power or its operating system
+   * crashes.
+   */
+  bool sync_writes_enabled = false;
+
+  /**
+   * If positive, local transactions that commit within this many milliseconds
+   * of the oldest one not yet written to disk are written together, in a
+   * single write. Until that write happens, their changes are visible to the
+   * client but are lost if the app crashes, so at most this much time worth of
+   * committed changes can be lost. Zero writes each transaction to disk as it
+   * commits.
+   */
+  int64_t group_commit_window_ms = 0;
+
+  size_t Hash() const {
+    return util::Hash(block_cache_size_bytes, write_buffer_size_bytes,
+                      block_size_bytes, bloom_filter_bits_per_key,
+                      compression_enabled, document_compression_enabled,
+                      relative_document_names_enabled, sync_writes_enabled,
+                      group_commit_window_ms);
+  }
+};
+
+inline bool operator==(const PersistenceTuning& lhs,
+                       const PersistenceTuning& rhs) {
+  return lhs.block_cache_size_bytes == rhs.block_cache_size_bytes &&
+         lhs.write_buffer_size_bytes == rhs.write_buffer_size_bytes &&
+         lhs.block_size_bytes == rhs.block_size_bytes &&
+         lhs.bloom_filter_bits_per_key == rhs.bloom_filter_bits_per_key &&
+         lhs.compression_enabled == rhs.compression_enabled &&
+         lhs.document_compression_enabled ==
+             rhs.document_compression_enabled &&
+         lhs.relative_document_names_enabled ==
+             rhs.relative_document_names_enabled &&
+         lhs.sync_writes_enabled == rhs.sync_writes_enabled &&
+         lhs.group_commit_window_ms == rhs.group_commit_window_ms;
+}
+
 /**
  * Represents settings associated with a FirestoreClient.
  *
@@ -39,6 +129,31 @@ class Settings {
   static constexpr int64_t MinimumCacheSizeBytes = 1 * 1024 * 1024;
   static constexpr int64_t CacheSizeUnlimited = -1;
   static constexpr bool DefaultTimestampsInSnapshotsEnabled = true;
+  static constexpr int64_t DefaultDocumentCacheSizeBytes = 2 * 1024 * 1024;
+  static constexpr int64_t DefaultMemoryPressureBudgetBytes = 0;
+  static constexpr int DefaultMaxPendingWrites = 10;
+  static constexpr bool DefaultAdaptiveWritePipelineEnabled = false;
+  static constexpr bool DefaultWriteBatchCoalescingEnabled = false;
+  static constexpr bool DefaultWriteAckCoalescingEnabled = false;
+  static constexpr bool DefaultSeparateWatchChannelEnabled = false;
+  static constexpr bool DefaultSharedGrpcRuntimeEnabled = false;
+  static constexpr int32_t DefaultLimitPrefetchSize = 0;
+  static constexpr bool DefaultSharedQueryExecutionEnabled = false;
+  static constexpr bool DefaultSnapshotBatchingEnabled = false;
+  static constexpr bool DefaultOneShotServerQueriesEnabled = false;
+  static constexpr bool DefaultOneShotQueryCachingEnabled = true;
+  static constexpr bool DefaultParallelViewComputationEnabled = false;
+  static constexpr bool DefaultLazyLocalStoreStartEnabled = false;
+  static constexpr bool DefaultQueryFromTargetKeysEnabled = false;
+  static constexpr bool DefaultMutationCompactionEnabled = false;
+  static constexpr bool DefaultTransactionPrefetchEnabled = false;
+  static constexpr bool DefaultDeferredUserDataParsingEnabled = false;
+  static constexpr bool DefaultSnapshotReadsEnabled = false;
+  static constexpr bool DefaultDeferredPersistenceDeletionEnabled = false;
+  static constexpr int32_t DefaultMaxConcurrentLimboResolutions = 0;
+  static constexpr int64_t DefaultStreamIdleTimeoutMs = 60 * 1000;
+  static constexpr int64_t DefaultResumeTokenMaxAgeSeconds = 5 * 60;
+  static constexpr int64_t DefaultTargetPersistenceIntervalMs = 0;
 
   Settings() = default;
 
@@ -80,6 +195,374 @@ class Settings {
     return cache_size_bytes_ != CacheSizeUnlimited;
   }
 
+  /**
+   * The approximate number of bytes of decoded documents that persistence
+   * keeps in memory in front of the on-disk cache. Zero disables the cache.
+   */
+  void set_document_cache_size_bytes(int64_t value) {
+    document_cache_size_bytes_ = value;
+  }
+  int64_t document_cache_size_bytes() const {
+    return document_cache_size_bytes_;
+  }
+
+  /**
+   * The approximate number of bytes the in-memory caches are trimmed to when
+   * the system is low on memory. Zero, the default, empties them.
+   */
+  void set_memory_pressure_budget_bytes(int64_t value) {
+    memory_pressure_budget_bytes_ = value;
+  }
+  int64_t memory_pressure_budget_bytes() const {
+    return memory_pressure_budget_bytes_;
+  }
+
+  /**
+   * The maximum number of mutation batches the client sends to the backend
+   * before waiting for acknowledgements. With the adaptive write pipeline
+   * enabled this is an upper bound, and the client picks the actual depth
+   * based on how quickly writes are acknowledged.
+   */
+  void set_max_pending_writes(int value) {
+    max_pending_writes_ = value;
+  }
+  int max_pending_writes() const {
+    return max_pending_writes_;
+  }
+
+  void set_adaptive_write_pipeline_enabled(bool value) {
+    adaptive_write_pipeline_enabled_ = value;
+  }
+  bool adaptive_write_pipeline_enabled() const {
+    return adaptive_write_pipeline_enabled_;
+  }
+
+  /**
+   * Whether the client may send several pending mutation batches to the
+   * backend in a single request. The backend commits such a request
+   * atomically, so the batches in it succeed or fail together.
+   */
+  void set_write_batch_coalescing_enabled(bool value) {
+    write_batch_coalescing_enabled_ = value;
+  }
+  bool write_batch_coalescing_enabled() const {
+    return write_batch_coalescing_enabled_;
+  }
+
+  /**
+   * Whether write acknowledgements that arrive back to back are applied to the
+   * local store together, in a single transaction that raises a single round
+   * of snapshots, rather than one at a time.
+   */
+  void set_write_ack_coalescing_enabled(bool value) {
+    write_ack_coalescing_enabled_ = value;
+  }
+  bool write_ack_coalescing_enabled() const {
+    return write_ack_coalescing_enabled_;
+  }
+
+  /**
+   * Whether the watch stream gets a connection to the backend of its own,
+   * rather than sharing one with writes and document lookups, along with a
+   * thread of its own to poll for completed network operations. This keeps a
+   * large incoming snapshot from delaying writes, at the cost of an extra
+   * connection and thread.
+   */
+  void set_separate_watch_channel_enabled(bool value) {
+    separate_watch_channel_enabled_ = value;
+  }
+  bool separate_watch_channel_enabled() const {
+    return separate_watch_channel_enabled_;
+  }
+
+  /**
+   * Whether the instance shares its thread polling for completed network
+   * operations, and its connections to the backend, with the other instances
+   * in the process that enable this. Apps using several instances at once
+   * save a thread and, for instances using the same host, a connection per
+   * instance.
+   */
+  void set_shared_grpc_runtime_enabled(bool value) {
+    shared_grpc_runtime_enabled_ = value;
+  }
+  bool shared_grpc_runtime_enabled() const {
+    return shared_grpc_runtime_enabled_;
+  }
+
+  /**
+   * The number of documents past the limit that views of limit queries keep
+   * around, so that a document dropping out of a full limit query can be
+   * replaced without re-running the query against the local cache. Zero
+   * disables the buffer.
+   */
+  void set_limit_prefetch_size(int32_t value) {
+    limit_prefetch_size_ = value;
+  }
+  int32_t limit_prefetch_size() const {
+    return limit_prefetch_size_;
+  }
+
+  /**
+   * Whether a listener for a query whose results can be computed from those of
+   * a query that is already being listened to shares the target and view of
+   * that query, instead of getting its own.
+   */
+  void set_shared_query_execution_enabled(bool value) {
+    shared_query_execution_enabled_ = value;
+  }
+  bool shared_query_execution_enabled() const {
+    return shared_query_execution_enabled_;
+  }
+
+  /**
+   * Whether the snapshots raised to listeners by one round of changes, such as
+   * a remote event, are delivered to the callback queue together, in a single
+   * block, rather than in a block per listener. Each listener still gets its
+   * snapshots in order.
+   */
+  void set_snapshot_batching_enabled(bool value) {
+    snapshot_batching_enabled_ = value;
+  }
+  bool snapshot_batching_enabled() const {
+    return snapshot_batching_enabled_;
+  }
+
+  /**
+   * Whether getting the documents of a query from the server runs the query
+   * once on the backend, rather than listening to it until its results are
+   * current and then stopping.
+   */
+  void set_one_shot_server_queries_enabled(bool value) {
+    one_shot_server_queries_enabled_ = value;
+  }
+  bool one_shot_server_queries_enabled() const {
+    return one_shot_server_queries_enabled_;
+  }
+
+  /**
+   * Whether the results of queries run once on the backend are written to the
+   * local cache, as the results of listens are. Without caching, such reads
+   * leave the cache untouched, and the snapshots they return don't reflect
+   * pending writes.
+   */
+  void set_one_shot_query_caching_enabled(bool value) {
+    one_shot_query_caching_enabled_ = value;
+  }
+  bool one_shot_query_caching_enabled() const {
+    return one_shot_query_caching_enabled_;
+  }
+
+  /**
+   * Whether the changes a remote event makes to the views of many active
+   * queries are computed for those views concurrently, rather than one view
+   * after another. Snapshots are still raised in the same order.
+   */
+  void set_parallel_view_computation_enabled(bool value) {
+    parallel_view_computation_enabled_ = value;
+  }
+  bool parallel_view_computation_enabled() const {
+    return parallel_view_computation_enabled_;
+  }
+
+  /**
+   * Whether starting the mutation queue is deferred until after the queries
+   * issued right after launch have been served from the cache. Writes and the
+   * write stream still start it first if they need it sooner.
+   */
+  void set_lazy_local_store_start_enabled(bool value) {
+    lazy_local_store_start_enabled_ = value;
+  }
+  bool lazy_local_store_start_enabled() const {
+    return lazy_local_store_start_enabled_;
+  }
+
+  /**
+   * Whether a listen to a collection query that was listened to before is
+   * first served from the documents its target had as of its last snapshot,
+   * plus the documents read or written since, instead of from a scan of the
+   * whole collection.
+   */
+  void set_query_from_target_keys_enabled(bool value) {
+    query_from_target_keys_enabled_ = value;
+  }
+  bool query_from_target_keys_enabled() const {
+    return query_from_target_keys_enabled_;
+  }
+
+  /**
+   * Whether a write to documents that the last pending write also changed is
+   * merged into that write's batch while it has not been sent yet, so that
+   * repeated offline updates to a document are stored, replayed and uploaded
+   * as one.
+   */
+  void set_mutation_compaction_enabled(bool value) {
+    mutation_compaction_enabled_ = value;
+  }
+  bool mutation_compaction_enabled() const {
+    return mutation_compaction_enabled_;
+  }
+
+  /**
+   * Whether a transaction that is retried starts reading the documents its
+   * last attempt read as soon as it is retried, so that the update block
+   * doesn't wait for them one round trip at a time.
+   */
+  void set_transaction_prefetch_enabled(bool value) {
+    transaction_prefetch_enabled_ = value;
+  }
+  bool transaction_prefetch_enabled() const {
+    return transaction_prefetch_enabled_;
+  }
+
+  /**
+   * Whether the data given to document writes is parsed and validated on the
+   * worker queue rather than on the calling thread. Invalid data is then
+   * reported to the completion of the write instead of raising an exception,
+   * and collections nested in the data must not be changed until the write
+   * has been parsed.
+   */
+  void set_deferred_user_data_parsing_enabled(bool value) {
+    deferred_user_data_parsing_enabled_ = value;
+  }
+  bool deferred_user_data_parsing_enabled() const {
+    return deferred_user_data_parsing_enabled_;
+  }
+
+  /**
+   * Whether reads from the cache alone, such as gets with the cache source,
+   * run against a snapshot of persistence on a pool of reader threads instead
+   * of waiting behind writes and remote events on the worker queue. Each read
+   * sees persistence as it was at some point after the read was requested.
+   */
+  void set_snapshot_reads_enabled(bool value) {
+    snapshot_reads_enabled_ = value;
+  }
+  bool snapshot_reads_enabled() const {
+    return snapshot_reads_enabled_;
+  }
+
+  /**
+   * Whether clearing persistence moves the database out of the way and
+   * returns, deleting its files in the background, rather than deleting them
+   * before returning. Either way, the next client starts from an empty cache.
+   */
+  void set_deferred_persistence_deletion_enabled(bool value) {
+    deferred_persistence_deletion_enabled_ = value;
+  }
+  bool deferred_persistence_deletion_enabled() const {
+    return deferred_persistence_deletion_enabled_;
+  }
+
+  /**
+   * How many documents in limbo are looked up on the backend at a time. The
+   * others wait in line for one of the lookups to finish, so that a view with
+   * many documents in limbo doesn't open as many targets on the watch stream
+   * at once. Zero looks up all of them at once.
+   */
+  void set_max_concurrent_limbo_resolutions(int32_t value) {
+    max_concurrent_limbo_resolutions_ = value;
+  }
+  int32_t max_concurrent_limbo_resolutions() const {
+    return max_concurrent_limbo_resolutions_;
+  }
+
+  /** How the watch stream waits between attempts to reconnect. */
+  void set_watch_stream_backoff_policy(const remote::BackoffPolicy& value) {
+    watch_stream_backoff_policy_ = value;
+  }
+  const remote::BackoffPolicy& watch_stream_backoff_policy() const {
+    return watch_stream_backoff_policy_;
+  }
+
+  /** How the write stream waits between attempts to reconnect. */
+  void set_write_stream_backoff_policy(const remote::BackoffPolicy& value) {
+    write_stream_backoff_policy_ = value;
+  }
+  const remote::BackoffPolicy& write_stream_backoff_policy() const {
+    return write_stream_backoff_policy_;
+  }
+
+  /**
+   * How long the watch stream stays open once no queries are being listened
+   * to.
+   */
+  void set_watch_stream_idle_timeout_ms(int64_t value) {
+    watch_stream_idle_timeout_ms_ = value;
+  }
+  int64_t watch_stream_idle_timeout_ms() const {
+    return watch_stream_idle_timeout_ms_;
+  }
+
+  /**
+   * How long the write stream stays open once all pending writes have been
+   * acknowledged. Apps that write every so often can raise this to keep the
+   * stream open in between, rather than opening it again for each write.
+   */
+  void set_write_stream_idle_timeout_ms(int64_t value) {
+    write_stream_idle_timeout_ms_ = value;
+  }
+  int64_t write_stream_idle_timeout_ms() const {
+    return write_stream_idle_timeout_ms_;
+  }
+
+  /**
+   * How far, in seconds of snapshot time, a listened-to target can move on
+   * before its new resume token is written to the local cache even though
+   * none of its documents changed. A lower age lets a restarted app resume
+   * its listens from further along, at the cost of more writes.
+   */
+  void set_resume_token_max_age_seconds(int64_t value) {
+    resume_token_max_age_seconds_ = value;
+  }
+  int64_t resume_token_max_age_seconds() const {
+    return resume_token_max_age_seconds_;
+  }
+
+  /**
+   * If positive, the listened-to targets that get new resume tokens are only
+   * written to the local cache this often, all in a single write, and when
+   * the app moves to the background, rather than on each remote event. Until
+   * then, a restarted app resumes its listens from the tokens written before.
+   * Zero writes each target as soon as it changes.
+   */
+  void set_target_persistence_interval_ms(int64_t value) {
+    target_persistence_interval_ms_ = value;
+  }
+  int64_t target_persistence_interval_ms() const {
+    return target_persistence_interval_ms_;
+  }
+
+  /**
+   * How the connections to the backend are pinged. Streams kept open for
+   * long may need pings to keep the network from dropping them while quiet.
+   */
+  void set_keepalive_policy(const remote::KeepalivePolicy& value) {
+    keepalive_policy_ = value;
+  }
+  const remote::KeepalivePolicy& keepalive_policy() const {
+    return keepalive_policy_;
+  }
+
+  /**
+   * How the messages sent on the watch and write streams and in document
+   * lookups are compressed. Off by default; the backend decides on its own
+   * whether to compress the messages it sends back.
+   */
+  void set_compression_policy(const remote::CompressionPolicy& value) {
+    compression_policy_ = value;
+  }
+  const remote::CompressionPolicy& compression_policy() const {
+    return compression_policy_;
+  }
+
+  /** How the on-disk cache is tuned, if persistence is enabled. */
+  void set_persistence_tuning(const PersistenceTuning& value) {
+    persistence_tuning_ = value;
+  }
+  const PersistenceTuning& persistence_tuning() const {
+    return persistence_tuning_;
+  }
+
   friend bool operator==(const Settings& lhs, const Settings& rhs);
 
   size_t Hash() const;
@@ -90,6 +573,41 @@ class Settings {
   bool persistence_enabled_ = DefaultPersistenceEnabled;
   bool timestamps_in_snapshots_enabled_ = DefaultTimestampsInSnapshotsEnabled;
   int64_t cache_size_bytes_ = DefaultCacheSizeBytes;
+  int64_t document_cache_size_bytes_ = DefaultDocumentCacheSizeBytes;
+  int64_t memory_pressure_budget_bytes_ = DefaultMemoryPressureBudgetBytes;
+  int max_pending_writes_ = DefaultMaxPendingWrites;
+  bool adaptive_write_pipeline_enabled_ = DefaultAdaptiveWritePipelineEnabled;
+  bool write_batch_coalescing_enabled_ = DefaultWriteBatchCoalescingEnabled;
+  bool write_ack_coalescing_enabled_ = DefaultWriteAckCoalescingEnabled;
+  bool separate_watch_channel_enabled_ = DefaultSeparateWatchChannelEnabled;
+  bool shared_grpc_runtime_enabled_ = DefaultSharedGrpcRuntimeEnabled;
+  int32_t limit_prefetch_size_ = DefaultLimitPrefetchSize;
+  bool shared_query_execution_enabled_ = DefaultSharedQueryExecutionEnabled;
+  bool snapshot_batching_enabled_ = DefaultSnapshotBatchingEnabled;
+  bool one_shot_server_queries_enabled_ = DefaultOneShotServerQueriesEnabled;
+  bool one_shot_query_caching_enabled_ = DefaultOneShotQueryCachingEnabled;
+  bool parallel_view_computation_enabled_ =
+      DefaultParallelViewComputationEnabled;
+  bool lazy_local_store_start_enabled_ = DefaultLazyLocalStoreStartEnabled;
+  bool query_from_target_keys_enabled_ = DefaultQueryFromTargetKeysEnabled;
+  bool mutation_compaction_enabled_ = DefaultMutationCompactionEnabled;
+  bool transaction_prefetch_enabled_ = DefaultTransactionPrefetchEnabled;
+  bool deferred_user_data_parsing_enabled_ =
+      DefaultDeferredUserDataParsingEnabled;
+  bool snapshot_reads_enabled_ = DefaultSnapshotReadsEnabled;
+  bool deferred_persistence_deletion_enabled_ =
+      DefaultDeferredPersistenceDeletionEnabled;
+  int32_t max_concurrent_limbo_resolutions_ =
+      DefaultMaxConcurrentLimboResolutions;
+  remote::BackoffPolicy watch_stream_backoff_policy_;
+  remote::BackoffPolicy write_stream_backoff_policy_;
+  int64_t watch_stream_idle_timeout_ms_ = DefaultStreamIdleTimeoutMs;
+  int64_t write_stream_idle_timeout_ms_ = DefaultStreamIdleTimeoutMs;
+  int64_t resume_token_max_age_seconds_ = DefaultResumeTokenMaxAgeSeconds;
+  int64_t target_persistence_interval_ms_ = DefaultTargetPersistenceIntervalMs;
+  remote::KeepalivePolicy keepalive_policy_;
+  remote::CompressionPolicy compression_policy_;
+  PersistenceTuning persistence_tuning_;
 };
 
 }  // namespace api
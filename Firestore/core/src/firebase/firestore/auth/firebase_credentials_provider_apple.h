@@ -24,8 +24,10 @@
 
 #import <Foundation/Foundation.h>
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
+#include <string>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
@@ -51,6 +53,10 @@ namespace auth {
  * from the thread backing our internal worker queue and the callbacks from
  * FIRAuth will be executed on an arbitrary different thread.
  *
+ * Tokens are cached until shortly before they expire, so that starting a
+ * stream or sending a request rarely waits for FIRAuth. A cached token that is
+ * about to expire is refreshed in the background while it is still in use.
+ *
  * For non-Apple desktop build, this is right now just a stub.
  */
 class FirebaseCredentialsProvider : public CredentialsProvider {
@@ -76,6 +82,12 @@ class FirebaseCredentialsProvider : public CredentialsProvider {
   void InvalidateToken() override;
 
  private:
+  /**
+   * Requests a token from FIRAuth and caches it. `completion` may be null, as
+   * it is for a background refresh.
+   */
+  void FetchToken(bool force_refresh, TokenListener completion);
+
   /**
    * Most contents of the FirebaseCredentialProvider are kept in this
    * Contents object and pointed to with a shared pointer. Callbacks
@@ -105,6 +117,17 @@ class FirebaseCredentialsProvider : public CredentialsProvider {
     std::mutex mutex;
 
     bool force_refresh = false;
+
+    /**
+     * The last token fetched, valid while `cached_token_counter` matches
+     * `token_counter`. Empty if no token is cached.
+     */
+    std::string cached_token;
+    std::chrono::system_clock::time_point cached_token_expiry;
+    int cached_token_counter = 0;
+
+    /** Whether a background refresh of the cached token is outstanding. */
+    bool refresh_in_flight = false;
   };
 
   /**
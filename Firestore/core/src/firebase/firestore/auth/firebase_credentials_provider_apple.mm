@@ -25,10 +25,67 @@
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
 namespace auth {
+namespace {
+
+// Auth itself refreshes a token once it is this close to expiring, so a cached
+// token is not used past this point.
+constexpr std::chrono::minutes kMinCachedTokenLifetime{5};
+
+// How close to expiring a cached token gets before it's refreshed in the
+// background.
+constexpr std::chrono::minutes kTokenRefreshWindow{10};
+
+/**
+ * Returns the expiry of a Firebase ID token, read from the `exp` claim of its
+ * payload, or nullopt if the token isn't a JWT with one.
+ */
+absl::optional<std::chrono::system_clock::time_point> TokenExpiry(
+    NSString* token) {
+  NSArray<NSString*>* parts = [token componentsSeparatedByString:@"."];
+  if (parts.count != 3) {
+    return absl::nullopt;
+  }
+
+  // The payload is unpadded base64url.
+  NSMutableString* payload = [parts[1] mutableCopy];
+  [payload replaceOccurrencesOfString:@"-"
+                           withString:@"+"
+                              options:0
+                                range:NSMakeRange(0, payload.length)];
+  [payload replaceOccurrencesOfString:@"_"
+                           withString:@"/"
+                              options:0
+                                range:NSMakeRange(0, payload.length)];
+  while (payload.length % 4 != 0) {
+    [payload appendString:@"="];
+  }
+
+  NSData* json = [[NSData alloc] initWithBase64EncodedString:payload
+                                                     options:0];
+  if (!json) {
+    return absl::nullopt;
+  }
+  id claims = [NSJSONSerialization JSONObjectWithData:json
+                                              options:0
+                                                error:nil];
+  if (![claims isKindOfClass:[NSDictionary class]]) {
+    return absl::nullopt;
+  }
+  id exp = claims[@"exp"];
+  if (![exp isKindOfClass:[NSNumber class]]) {
+    return absl::nullopt;
+  }
+
+  return std::chrono::system_clock::time_point{
+      std::chrono::seconds{[exp longLongValue]}};
+}
+
+}  // namespace
 
 FirebaseCredentialsProvider::FirebaseCredentialsProvider(
     FIRApp* app, id<FIRAuthInterop> auth) {
@@ -80,9 +137,47 @@ void FirebaseCredentialsProvider::GetToken(TokenListener completion) {
   HARD_ASSERT(auth_listener_handle_,
               "GetToken cannot be called after listener removed.");
 
+  std::string cached_token;
+  User user;
+  bool refresh = false;
+  {
+    std::unique_lock<std::mutex> lock(contents_->mutex);
+    auto now = std::chrono::system_clock::now();
+    if (!contents_->force_refresh && !contents_->cached_token.empty() &&
+        contents_->cached_token_counter == contents_->token_counter &&
+        now < contents_->cached_token_expiry - kMinCachedTokenLifetime) {
+      cached_token = contents_->cached_token;
+      user = contents_->current_user;
+      refresh = !contents_->refresh_in_flight &&
+                now >= contents_->cached_token_expiry - kTokenRefreshWindow;
+      contents_->refresh_in_flight |= refresh;
+    }
+  }
+
+  if (cached_token.empty()) {
+    FetchToken(/*force_refresh=*/false, std::move(completion));
+    return;
+  }
+
+  completion(Token{std::move(cached_token), std::move(user)});
+  if (refresh) {
+    // Auth only refreshes a token shortly before it expires, which is later
+    // than this refresh is meant to happen.
+    FetchToken(/*force_refresh=*/true, nullptr);
+  }
+}
+
+void FirebaseCredentialsProvider::FetchToken(bool force_refresh,
+                                             TokenListener completion) {
   // Take note of the current value of the tokenCounter so that this method can
   // fail if there is a token change while the request is outstanding.
-  int initial_token_counter = contents_->token_counter;
+  int initial_token_counter;
+  {
+    std::unique_lock<std::mutex> lock(contents_->mutex);
+    initial_token_counter = contents_->token_counter;
+    force_refresh |= contents_->force_refresh;
+    contents_->force_refresh = false;
+  }
 
   std::weak_ptr<Contents> weak_contents = contents_;
   void (^get_token_callback)(NSString*, NSError*) = ^(
@@ -93,44 +188,65 @@ void FirebaseCredentialsProvider::GetToken(TokenListener completion) {
     }
 
     std::unique_lock<std::mutex> lock(contents->mutex);
+    if (!completion) {
+      contents->refresh_in_flight = false;
+    }
+
     if (initial_token_counter != contents->token_counter) {
       // Cancel the request since the user changed while the request was
       // outstanding so the response is likely for a previous user (which
       // user, we can't be sure).
-      completion(util::Status(Error::Aborted,
-                              "getToken aborted due to token change."));
-    } else {
-      if (error == nil) {
-        if (token != nil) {
-          completion(Token{util::MakeString(token), contents->current_user});
-        } else {
-          completion(Token::Unauthenticated());
-        }
+      if (completion) {
+        completion(util::Status(Error::Aborted,
+                                "getToken aborted due to token change."));
+      }
+      return;
+    }
+
+    if (error == nil && token != nil) {
+      absl::optional<std::chrono::system_clock::time_point> expiry =
+          TokenExpiry(token);
+      if (expiry) {
+        contents->cached_token = util::MakeString(token);
+        contents->cached_token_expiry = *expiry;
+        contents->cached_token_counter = initial_token_counter;
+      }
+    }
+    if (!completion) {
+      return;
+    }
+
+    if (error == nil) {
+      if (token != nil) {
+        completion(Token{util::MakeString(token), contents->current_user});
       } else {
-        Error error_code = Error::Unknown;
-        if (error.domain == FIRFirestoreErrorDomain) {
-          error_code = static_cast<Error>(error.code);
-        }
-        completion(util::Status(error_code,
-                                util::MakeString(error.localizedDescription)));
+        completion(Token::Unauthenticated());
+      }
+    } else {
+      Error error_code = Error::Unknown;
+      if (error.domain == FIRFirestoreErrorDomain) {
+        error_code = static_cast<Error>(error.code);
       }
+      completion(util::Status(error_code,
+                              util::MakeString(error.localizedDescription)));
     }
   };
 
   // TODO(wilhuff): Need a better abstraction over a missing auth provider.
   if (contents_->auth) {
-    [contents_->auth getTokenForcingRefresh:contents_->force_refresh
+    [contents_->auth getTokenForcingRefresh:force_refresh
                                withCallback:get_token_callback];
   } else {
     // If there's no Auth provider, call back immediately with a nil
     // (unauthenticated) token.
     get_token_callback(nil, nil);
   }
-  contents_->force_refresh = false;
 }
 
 void FirebaseCredentialsProvider::InvalidateToken() {
+  std::unique_lock<std::mutex> lock(contents_->mutex);
   contents_->force_refresh = true;
+  contents_->cached_token.clear();
 }
 
 void FirebaseCredentialsProvider::SetCredentialChangeListener(
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/array_contains_any_filter.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/algorithm/container.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::Document;
+using model::FieldPath;
+using model::FieldValue;
+
+using Operator = Filter::Operator;
+
+ArrayContainsAnyFilter::ArrayContainsAnyFilter(FieldPath field,
+                                               FieldValue value)
+    : FieldFilter(std::move(field),
+                  Operator::ArrayContainsAny,
+                  std::move(value)) {
+  HARD_ASSERT(this->value().type() == FieldValue::Type::Array,
+              "ArrayContainsAnyFilter expects an ArrayValue");
+}
+
+bool ArrayContainsAnyFilter::Matches(const Document& doc) const {
+  absl::optional<FieldValue> maybe_lhs = doc.field(field());
+  if (!maybe_lhs) return false;
+
+  const FieldValue& lhs = *maybe_lhs;
+  if (lhs.type() != FieldValue::Type::Array) return false;
+
+  // Like array-contains, elements only match values they're equal to.
+  const FieldValue::Array& contents = lhs.array_value();
+  return absl::c_any_of(value().array_value(), [&](const FieldValue& rhs) {
+    return absl::c_linear_search(contents, rhs);
+  });
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_ARRAY_CONTAINS_ANY_FILTER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_ARRAY_CONTAINS_ANY_FILTER_H_
+
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * A Filter that implements the array-contains-any operator: the field must be
+ * an array that contains at least one of the values of the array it's given.
+ */
+class ArrayContainsAnyFilter : public FieldFilter {
+ public:
+  ArrayContainsAnyFilter(model::FieldPath field, model::FieldValue value);
+
+  Type type() const override {
+    return Type::kArrayContainsAnyFilter;
+  }
+
+  bool Matches(const model::Document& doc) const override;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_ARRAY_CONTAINS_ANY_FILTER_H_
@@ -20,7 +20,9 @@
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/api/input_validation.h"
+#include "Firestore/core/src/firebase/firestore/core/array_contains_any_filter.h"
 #include "Firestore/core/src/firebase/firestore/core/array_contains_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/in_filter.h"
 #include "Firestore/core/src/firebase/firestore/core/key_field_filter.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
 #include "absl/algorithm/container.h"
@@ -52,6 +54,10 @@ const char* Describe(Filter::Operator op) {
       return ">";
     case Filter::Operator::ArrayContains:
       return "array_contains";
+    case Filter::Operator::In:
+      return "in";
+    case Filter::Operator::ArrayContainsAny:
+      return "array_contains_any";
   }
 
   UNREACHABLE();
@@ -65,8 +71,11 @@ std::shared_ptr<FieldFilter> FieldFilter::Create(FieldPath path,
   if (path.IsKeyFieldPath()) {
     HARD_ASSERT(value_rhs.type() == FieldValue::Type::Reference,
                 "Comparing on key, but filter value not a Reference.");
-    HARD_ASSERT(op != Filter::Operator::ArrayContains,
+    HARD_ASSERT(op != Filter::Operator::ArrayContains &&
+                    op != Filter::Operator::ArrayContainsAny,
                 "arrayContains queries don't make sense on document keys.");
+    HARD_ASSERT(op != Filter::Operator::In,
+                "in queries on document keys are not supported.");
     return std::make_shared<KeyFieldFilter>(std::move(path), op,
                                             std::move(value_rhs));
 
@@ -90,6 +99,13 @@ std::shared_ptr<FieldFilter> FieldFilter::Create(FieldPath path,
     return std::make_shared<ArrayContainsFilter>(std::move(path),
                                                  std::move(value_rhs));
 
+  } else if (op == Operator::In) {
+    return std::make_shared<InFilter>(std::move(path), std::move(value_rhs));
+
+  } else if (op == Operator::ArrayContainsAny) {
+    return std::make_shared<ArrayContainsAnyFilter>(std::move(path),
+                                                    std::move(value_rhs));
+
   } else {
     FieldFilter filter(std::move(path), op, std::move(value_rhs));
     return std::make_shared<FieldFilter>(std::move(filter));
@@ -149,7 +165,8 @@ size_t FieldFilter::Hash() const {
 }
 
 bool FieldFilter::IsInequality() const {
-  return op_ != Operator::Equal && op_ != Operator::ArrayContains;
+  return op_ != Operator::Equal && op_ != Operator::ArrayContains &&
+         op_ != Operator::In && op_ != Operator::ArrayContainsAny;
 }
 
 bool FieldFilter::Equals(const Filter& other) const {
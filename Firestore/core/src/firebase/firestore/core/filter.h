@@ -43,13 +43,17 @@ class Filter {
     GreaterThanOrEqual,
     GreaterThan,
     ArrayContains,
+    In,
+    ArrayContainsAny,
   };
 
   // For lack of RTTI, all subclasses must identify themselves so that
   // comparisons properly take type into account.
   enum class Type {
+    kArrayContainsAnyFilter,
     kArrayContainsFilter,
     kFieldFilter,
+    kInFilter,
     kKeyFieldFilter,
   };
 
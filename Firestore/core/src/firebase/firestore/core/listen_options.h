@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_LISTEN_OPTIONS_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_LISTEN_OPTIONS_H_
 
+#include <chrono>  // NOLINT(build/c++11)
+
 namespace firebase {
 namespace firestore {
 namespace core {
@@ -78,10 +80,28 @@ class ListenOptions {
     return wait_for_sync_when_online_;
   }
 
+  /**
+   * Returns a copy of these options that raises events at most once per
+   * `interval`. Snapshots arriving sooner than that after the last event are
+   * merged into a single event, raised once the interval has elapsed, so
+   * intermediate states are never seen.
+   */
+  ListenOptions WithMinEventInterval(std::chrono::milliseconds interval) const {
+    ListenOptions result = *this;
+    result.min_event_interval_ = interval;
+    return result;
+  }
+
+  /** The minimum time between events; zero if events are never held back. */
+  std::chrono::milliseconds min_event_interval() const {
+    return min_event_interval_;
+  }
+
  private:
   bool include_query_metadata_changes_ = false;
   bool include_document_metadata_changes_ = false;
   bool wait_for_sync_when_online_ = false;
+  std::chrono::milliseconds min_event_interval_{0};
 };
 
 }  // namespace core
@@ -82,6 +82,19 @@ bool Query::HasArrayContainsFilter() const {
   return false;
 }
 
+absl::optional<Filter::Operator> Query::FindOperator(
+    absl::Span<const Filter::Operator> ops) const {
+  for (const auto& filter : filters_) {
+    if (filter->IsAFieldFilter()) {
+      const auto& relation_filter = static_cast<const FieldFilter&>(*filter);
+      if (absl::c_linear_search(ops, relation_filter.op())) {
+        return relation_filter.op();
+      }
+    }
+  }
+  return absl::nullopt;
+}
+
 const Query::OrderByList& Query::order_bys() const {
   if (memoized_order_bys_.empty()) {
     const FieldPath* inequality_field = InequalityFilterField();
@@ -247,6 +260,34 @@ bool Query::MatchesBounds(const Document& doc) const {
   return true;
 }
 
+bool Query::Covers(const Query& other) const {
+  if (limit_ != kNoLimit || start_at_ || end_at_) return false;
+  if (path_ != other.path_ ||
+      !util::Equals(collection_group_, other.collection_group_)) {
+    return false;
+  }
+
+  for (const auto& filter : filters_) {
+    bool shared = absl::c_any_of(
+        other.filters_,
+        [&](const std::shared_ptr<Filter>& f) { return *f == *filter; });
+    if (!shared) return false;
+  }
+
+  // Documents that lack the field of an explicit order by don't match, so
+  // `other` must require the same fields.
+  for (const OrderBy& order_by : explicit_order_bys_) {
+    if (order_by.field().IsKeyFieldPath()) continue;
+
+    bool shared =
+        absl::c_any_of(other.explicit_order_bys_, [&](const OrderBy& o) {
+          return o.field() == order_by.field();
+        });
+    if (!shared) return false;
+  }
+  return true;
+}
+
 bool operator==(const Query& lhs, const Query& rhs) {
   return lhs.path() == rhs.path() &&
          util::Equals(lhs.collection_group(), rhs.collection_group()) &&
@@ -28,6 +28,8 @@
 #include "Firestore/core/src/firebase/firestore/core/order_by.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
 
 namespace firebase {
 namespace firestore {
@@ -112,6 +114,13 @@ class Query {
   /** Returns true if this Query has an array-contains filter already. */
   bool HasArrayContainsFilter() const;
 
+  /**
+   * Returns the operator of the first field filter on this Query whose
+   * operator is one of `ops`, or nullopt if there's none.
+   */
+  absl::optional<Filter::Operator> FindOperator(
+      absl::Span<const Filter::Operator> ops) const;
+
   /**
    * Returns the list of ordering constraints that were explicitly requested on
    * the query by the user.
@@ -191,7 +200,20 @@ class Query {
   /** Returns true if the document matches the constraints of this query. */
   bool Matches(const model::Document& doc) const;
 
+  /**
+   * Returns true if every document that matches `other` also matches this
+   * query, and this query returns all the documents that match it, so that the
+   * results of `other` can be computed from the results of this query.
+   *
+   * This is a conservative check: it only recognizes queries on the same path
+   * that impose all the constraints of this one and possibly more.
+   */
+  bool Covers(const Query& other) const;
+
  private:
+  // QueryMatcher shares the path and bounds checks with Matches.
+  friend class QueryMatcher;
+
   bool MatchesPathAndCollectionGroup(const model::Document& doc) const;
   bool MatchesFilters(const model::Document& doc) const;
   bool MatchesOrderBy(const model::Document& doc) const;
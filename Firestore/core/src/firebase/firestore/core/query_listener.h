@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_LISTENER_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_LISTENER_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <utility>
 
@@ -42,6 +43,8 @@ namespace core {
  */
 class QueryListener {
  public:
+  using Clock = std::chrono::steady_clock;
+
   static std::shared_ptr<QueryListener> Create(
       FSTQuery* query,
       ListenOptions options,
@@ -78,6 +81,10 @@ class QueryListener {
 
   FSTQuery* query() const;
 
+  const ListenOptions& options() const {
+    return options_;
+  }
+
   /** The last received view snapshot. */
   const absl::optional<ViewSnapshot>& snapshot() const {
     return snapshot_;
@@ -87,11 +94,23 @@ class QueryListener {
   virtual void OnError(util::Status error);
   virtual void OnOnlineStateChanged(model::OnlineState online_state);
 
+  /**
+   * If snapshots are being held back to keep events the minimum event interval
+   * apart, the time at which the event merging them is due.
+   */
+  absl::optional<Clock::time_point> pending_event_time() const;
+
+  /** Raises the event merging the snapshots being held back, if any. */
+  void RaisePendingEvent();
+
  private:
   bool ShouldRaiseInitialEvent(const ViewSnapshot& snapshot,
                                model::OnlineState online_state) const;
-  bool ShouldRaiseEvent(const ViewSnapshot& snapshot) const;
+  bool ShouldRaiseEvent(const ViewSnapshot& snapshot,
+                        const absl::optional<ViewSnapshot>& previous) const;
   void RaiseInitialEvent(const ViewSnapshot& snapshot);
+  void RaiseEvent(const ViewSnapshot& snapshot);
+  void CoalesceEvent(const ViewSnapshot& snapshot);
 
   objc::Handle<FSTQuery> query_;
   ListenOptions options_;
@@ -113,6 +132,16 @@ class QueryListener {
   model::OnlineState online_state_ = model::OnlineState::Unknown;
 
   absl::optional<ViewSnapshot> snapshot_;
+
+  /**
+   * The snapshots received since the last event, merged into one, and the
+   * snapshot received before them. Only set while an event is held back.
+   */
+  absl::optional<ViewSnapshot> pending_snapshot_;
+  absl::optional<ViewSnapshot> pending_base_snapshot_;
+
+  /** The earliest time at which the next event may be raised. */
+  Clock::time_point next_event_time_;
 };
 
 }  // namespace core
@@ -16,13 +16,18 @@
 
 #include "Firestore/core/src/firebase/firestore/core/query_listener.h"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
+#import "Firestore/Source/Core/FSTQuery.h"
+
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
 #include "absl/types/optional.h"
 
 NS_ASSUME_NONNULL_BEGIN
@@ -31,11 +36,67 @@ namespace firebase {
 namespace firestore {
 namespace core {
 
+using model::DocumentComparator;
 using model::OnlineState;
 using model::TargetId;
 using util::MakeStatus;
 using util::Status;
 
+namespace {
+
+int GetDocumentViewChangeTypePosition(DocumentViewChange::Type change_type) {
+  switch (change_type) {
+    case DocumentViewChange::Type::kRemoved:
+      return 0;
+    case DocumentViewChange::Type::kAdded:
+      return 1;
+    case DocumentViewChange::Type::kModified:
+    case DocumentViewChange::Type::kMetadata:
+      return 2;
+  }
+  UNREACHABLE();
+}
+
+/**
+ * Combines two consecutive snapshots into one that goes straight from the
+ * state before `first` to the state after `second`.
+ */
+ViewSnapshot MergeSnapshots(const ViewSnapshot& first,
+                            const ViewSnapshot& second) {
+  DocumentViewChangeSet change_set;
+  for (const ViewSnapshot* snapshot : {&first, &second}) {
+    for (DocumentViewChange change : snapshot->document_changes()) {
+      change_set.AddChange(std::move(change));
+    }
+  }
+
+  // Sort the changes the way views do: by type, then by the query order.
+  std::vector<DocumentViewChange> changes = change_set.GetChanges();
+  DocumentComparator comparator = second.query().comparator;
+  std::sort(changes.begin(), changes.end(),
+            [&](const DocumentViewChange& lhs, const DocumentViewChange& rhs) {
+              int lhs_position = GetDocumentViewChangeTypePosition(lhs.type());
+              int rhs_position = GetDocumentViewChangeTypePosition(rhs.type());
+              if (lhs_position != rhs_position) {
+                return lhs_position < rhs_position;
+              }
+              return util::Ascending(
+                  comparator.Compare(lhs.document(), rhs.document()));
+            });
+
+  // The sync state is a flag, so two changes to it cancel out.
+  return ViewSnapshot{second.query(),
+                      second.documents(),
+                      first.old_documents(),
+                      std::move(changes),
+                      second.mutated_keys(),
+                      second.from_cache(),
+                      first.sync_state_changed() != second.sync_state_changed(),
+                      second.excludes_metadata_changes()};
+}
+
+}  // namespace
+
 QueryListener::QueryListener(FSTQuery* query,
                              ListenOptions options,
                              ViewSnapshot::SharedListener&& listener)
@@ -49,6 +110,7 @@ FSTQuery* QueryListener::query() const {
 }
 
 void QueryListener::OnViewSnapshot(ViewSnapshot snapshot) {
+  FIRESTORE_TRACE_SPAN("QueryListener::OnViewSnapshot");
   HARD_ASSERT(
       !snapshot.document_changes().empty() || snapshot.sync_state_changed(),
       "We got a new snapshot with no changes?");
@@ -76,14 +138,50 @@ void QueryListener::OnViewSnapshot(ViewSnapshot snapshot) {
     if (ShouldRaiseInitialEvent(snapshot, online_state_)) {
       RaiseInitialEvent(snapshot);
     }
-  } else if (ShouldRaiseEvent(snapshot)) {
+  } else if (options_.min_event_interval().count() > 0) {
+    CoalesceEvent(snapshot);
+  } else if (ShouldRaiseEvent(snapshot, snapshot_)) {
     listener_->OnEvent(snapshot);
   }
 
   snapshot_ = std::move(snapshot);
 }
 
+void QueryListener::CoalesceEvent(const ViewSnapshot& snapshot) {
+  if (pending_snapshot_) {
+    pending_snapshot_ = MergeSnapshots(*pending_snapshot_, snapshot);
+  } else if (Clock::now() < next_event_time_) {
+    pending_snapshot_ = snapshot;
+    pending_base_snapshot_ = snapshot_;
+  } else if (ShouldRaiseEvent(snapshot, snapshot_)) {
+    RaiseEvent(snapshot);
+  }
+}
+
+absl::optional<QueryListener::Clock::time_point>
+QueryListener::pending_event_time() const {
+  if (!pending_snapshot_) return absl::nullopt;
+  return next_event_time_;
+}
+
+void QueryListener::RaisePendingEvent() {
+  if (!pending_snapshot_) return;
+
+  if (ShouldRaiseEvent(*pending_snapshot_, pending_base_snapshot_)) {
+    RaiseEvent(*pending_snapshot_);
+  }
+  pending_snapshot_.reset();
+  pending_base_snapshot_.reset();
+}
+
+void QueryListener::RaiseEvent(const ViewSnapshot& snapshot) {
+  listener_->OnEvent(snapshot);
+  next_event_time_ = Clock::now() + options_.min_event_interval();
+}
+
 void QueryListener::OnError(Status error) {
+  pending_snapshot_.reset();
+  pending_base_snapshot_.reset();
   listener_->OnEvent(std::move(error));
 }
 
@@ -121,7 +219,9 @@ bool QueryListener::ShouldRaiseInitialEvent(const ViewSnapshot& snapshot,
   return !snapshot.documents().empty() || online_state == OnlineState::Offline;
 }
 
-bool QueryListener::ShouldRaiseEvent(const ViewSnapshot& snapshot) const {
+bool QueryListener::ShouldRaiseEvent(
+    const ViewSnapshot& snapshot,
+    const absl::optional<ViewSnapshot>& previous) const {
   // We don't need to handle include_document_metadata_changes() here because
   // the Metadata only changes have already been stripped out if needed. At this
   // point the only changes we will see are the ones we should propagate.
@@ -130,8 +230,8 @@ bool QueryListener::ShouldRaiseEvent(const ViewSnapshot& snapshot) const {
   }
 
   bool has_pending_writes_changed =
-      snapshot_.has_value() &&
-      snapshot_.value().has_pending_writes() != snapshot.has_pending_writes();
+      previous.has_value() &&
+      previous.value().has_pending_writes() != snapshot.has_pending_writes();
   if (snapshot.sync_state_changed() || has_pending_writes_changed) {
     return options_.include_query_metadata_changes();
   }
@@ -150,6 +250,7 @@ void QueryListener::RaiseInitialEvent(const ViewSnapshot& snapshot) {
       snapshot.from_cache(), snapshot.excludes_metadata_changes());
   raised_initial_event_ = true;
   listener_->OnEvent(std::move(modified_snapshot));
+  next_event_time_ = Clock::now() + options_.min_event_interval();
 }
 
 }  // namespace core
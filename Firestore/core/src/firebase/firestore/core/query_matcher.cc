@@ -0,0 +1,224 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_matcher.h"
+
+#include <string>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/algorithm/container.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::Document;
+using model::FieldPath;
+using model::FieldValue;
+using model::ObjectValue;
+using util::ComparisonResult;
+
+using Operator = Filter::Operator;
+
+namespace {
+
+/**
+ * Returns the value at the given path in the document contents, or nullptr if
+ * there is none. Unlike `ObjectValue::Get`, does not copy the value.
+ */
+const FieldValue* FindField(const ObjectValue& data, const FieldPath& path) {
+  const FieldValue::Map* entries = &data.GetInternalValue();
+  const FieldValue* current = nullptr;
+  for (const std::string& segment : path) {
+    if (current) {
+      if (current->type() != FieldValue::Type::Object) return nullptr;
+      entries = &current->object_value();
+    }
+
+    const auto iter = entries->find(segment);
+    if (iter == entries->end()) return nullptr;
+    current = &iter->second;
+  }
+  return current;
+}
+
+}  // namespace
+
+QueryMatcher::Comparison::Comparison(Operator op, FieldValue value)
+    : value(std::move(value)) {
+  switch (this->value.type()) {
+    case FieldValue::Type::Null:
+      kind = ValueKind::kNull;
+      break;
+    case FieldValue::Type::Boolean:
+      kind = ValueKind::kBoolean;
+      break;
+    case FieldValue::Type::Integer:
+    case FieldValue::Type::Double:
+      kind = ValueKind::kNumber;
+      break;
+    case FieldValue::Type::String:
+      kind = ValueKind::kString;
+      break;
+    default:
+      kind = ValueKind::kOther;
+      break;
+  }
+
+  switch (op) {
+    case Operator::LessThan:
+      accepts_ascending = true;
+      break;
+    case Operator::LessThanOrEqual:
+      accepts_ascending = true;
+      accepts_same = true;
+      break;
+    case Operator::Equal:
+      accepts_same = true;
+      break;
+    case Operator::GreaterThanOrEqual:
+      accepts_descending = true;
+      accepts_same = true;
+      break;
+    case Operator::GreaterThan:
+      accepts_descending = true;
+      break;
+    default:
+      HARD_FAIL("Operator %s unsuitable for comparison", op);
+  }
+}
+
+bool QueryMatcher::Comparison::Matches(const FieldValue& lhs) const {
+  // Only compare types with matching backend order (such as double and int).
+  ComparisonResult result;
+  switch (kind) {
+    case ValueKind::kNull:
+      if (lhs.type() != FieldValue::Type::Null) return false;
+      result = ComparisonResult::Same;
+      break;
+
+    case ValueKind::kBoolean:
+      if (lhs.type() != FieldValue::Type::Boolean) return false;
+      result = util::Compare(lhs.boolean_value(), value.boolean_value());
+      break;
+
+    case ValueKind::kNumber:
+      if (!FieldValue::IsNumber(lhs.type())) return false;
+      result = lhs.CompareTo(value);
+      break;
+
+    case ValueKind::kString:
+      if (lhs.type() != FieldValue::Type::String) return false;
+      result = util::Compare(lhs.string_value(), value.string_value());
+      break;
+
+    case ValueKind::kOther:
+      if (!FieldValue::Comparable(lhs.type(), value.type())) return false;
+      result = lhs.CompareTo(value);
+      break;
+  }
+
+  switch (result) {
+    case ComparisonResult::Ascending:
+      return accepts_ascending;
+    case ComparisonResult::Same:
+      return accepts_same;
+    case ComparisonResult::Descending:
+      return accepts_descending;
+  }
+  UNREACHABLE();
+}
+
+bool QueryMatcher::FieldCheck::Matches(const FieldValue* value) const {
+  // Every constraint on a field requires the field to exist.
+  if (!value) return false;
+
+  for (const Comparison& comparison : comparisons) {
+    if (!comparison.Matches(*value)) return false;
+  }
+
+  if (!array_contains.empty()) {
+    if (value->type() != FieldValue::Type::Array) return false;
+
+    const FieldValue::Array& contents = value->array_value();
+    for (const FieldValue& element : array_contains) {
+      if (!absl::c_linear_search(contents, element)) return false;
+    }
+  }
+  return true;
+}
+
+QueryMatcher::QueryMatcher(Query query) : query_(std::move(query)) {
+  // order by key always matches
+  for (const OrderBy& order_by : query_.explicit_order_bys()) {
+    if (!order_by.field().IsKeyFieldPath()) {
+      CheckFor(order_by.field());
+    }
+  }
+
+  for (const std::shared_ptr<Filter>& filter : query_.filters()) {
+    switch (filter->type()) {
+      case Filter::Type::kFieldFilter: {
+        const auto& field_filter = static_cast<const FieldFilter&>(*filter);
+        CheckFor(field_filter.field())
+            .comparisons.emplace_back(field_filter.op(), field_filter.value());
+        break;
+      }
+
+      case Filter::Type::kArrayContainsFilter: {
+        const auto& field_filter = static_cast<const FieldFilter&>(*filter);
+        CheckFor(field_filter.field())
+            .array_contains.push_back(field_filter.value());
+        break;
+      }
+
+      default:
+        other_filters_.push_back(filter);
+        break;
+    }
+  }
+}
+
+QueryMatcher::FieldCheck& QueryMatcher::CheckFor(const FieldPath& field) {
+  auto found = absl::c_find_if(field_checks_, [&](const FieldCheck& check) {
+    return check.field == field;
+  });
+  if (found != field_checks_.end()) return *found;
+
+  field_checks_.emplace_back(field);
+  return field_checks_.back();
+}
+
+bool QueryMatcher::Matches(const Document& doc) const {
+  if (!query_.MatchesPathAndCollectionGroup(doc)) return false;
+
+  for (const FieldCheck& check : field_checks_) {
+    if (!check.Matches(FindField(doc.data(), check.field))) return false;
+  }
+
+  for (const auto& filter : other_filters_) {
+    if (!filter->Matches(doc)) return false;
+  }
+
+  return query_.MatchesBounds(doc);
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
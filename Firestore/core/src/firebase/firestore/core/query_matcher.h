@@ -0,0 +1,103 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_MATCHER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_MATCHER_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * A precompiled form of `Query::Matches`, meant to be built once per query and
+ * reused for every document the query is evaluated against.
+ *
+ * Compiling groups the field filters and order-by constraints of the query by
+ * the field they read, so that each field is looked up in a document only
+ * once, and picks a comparison specialized to the type of each filter value.
+ * Looking a field up does not copy its value.
+ *
+ * `Matches` always agrees with `Query::Matches` on the query the matcher was
+ * built from.
+ */
+class QueryMatcher {
+ public:
+  explicit QueryMatcher(Query query);
+
+  /** Returns true if the document matches the constraints of the query. */
+  bool Matches(const model::Document& doc) const;
+
+ private:
+  /** The kinds of filter values that get a specialized comparison. */
+  enum class ValueKind {
+    kNull,
+    kBoolean,
+    kNumber,
+    kString,
+    kOther,
+  };
+
+  /** A single relational filter on a field, e.g. `a < 5`. */
+  struct Comparison {
+    Comparison(Filter::Operator op, model::FieldValue value);
+
+    bool Matches(const model::FieldValue& lhs) const;
+
+    ValueKind kind;
+    model::FieldValue value;
+
+    // The comparison results for which the filter holds.
+    bool accepts_ascending = false;
+    bool accepts_same = false;
+    bool accepts_descending = false;
+  };
+
+  /** All the constraints of the query that read a given field. */
+  struct FieldCheck {
+    explicit FieldCheck(model::FieldPath field) : field(std::move(field)) {
+    }
+
+    bool Matches(const model::FieldValue* value) const;
+
+    model::FieldPath field;
+    std::vector<Comparison> comparisons;
+    std::vector<model::FieldValue> array_contains;
+  };
+
+  FieldCheck& CheckFor(const model::FieldPath& field);
+
+  Query query_;
+  std::vector<FieldCheck> field_checks_;
+
+  // Filters that cannot be compiled and are evaluated as they are.
+  std::vector<std::shared_ptr<Filter>> other_filters_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_MATCHER_H_
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_routing_index.h"
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/algorithm/container.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::ResourcePath;
+using model::TargetId;
+
+void QueryRoutingIndex::AddQuery(const Query& query, TargetId target_id) {
+  if (query.collection_group()) {
+    targets_by_collection_group_[*query.collection_group()].emplace_back(
+        query.path(), target_id);
+  } else {
+    targets_by_path_[query.path()].push_back(target_id);
+  }
+}
+
+void QueryRoutingIndex::RemoveQuery(const Query& query, TargetId target_id) {
+  if (query.collection_group()) {
+    auto found = targets_by_collection_group_.find(*query.collection_group());
+    HARD_ASSERT(found != targets_by_collection_group_.end(),
+                "Query for target %s is not indexed", target_id);
+
+    auto& entries = found->second;
+    auto entry = absl::c_find(entries, std::make_pair(query.path(), target_id));
+    HARD_ASSERT(entry != entries.end(), "Query for target %s is not indexed",
+                target_id);
+    entries.erase(entry);
+    if (entries.empty()) targets_by_collection_group_.erase(found);
+
+  } else {
+    auto found = targets_by_path_.find(query.path());
+    HARD_ASSERT(found != targets_by_path_.end(),
+                "Query for target %s is not indexed", target_id);
+
+    auto& target_ids = found->second;
+    auto entry = absl::c_find(target_ids, target_id);
+    HARD_ASSERT(entry != target_ids.end(), "Query for target %s is not indexed",
+                target_id);
+    target_ids.erase(entry);
+    if (target_ids.empty()) targets_by_path_.erase(found);
+  }
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
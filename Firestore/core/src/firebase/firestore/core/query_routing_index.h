@@ -0,0 +1,95 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_ROUTING_INDEX_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_ROUTING_INDEX_H_
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * Indexes the targets of active queries by the locations their queries read
+ * from, so that a changed document can be handed only to the targets whose
+ * query could contain it.
+ *
+ * Queries are keyed by their path, or by their collection group ID for
+ * collection group queries. Finding the targets for a document therefore costs
+ * a couple of lookups plus the number of candidate targets, however many
+ * queries there are in total. A candidate's query may still not match the
+ * document once its filters are applied.
+ */
+class QueryRoutingIndex {
+ public:
+  void AddQuery(const Query& query, model::TargetId target_id);
+
+  void RemoveQuery(const Query& query, model::TargetId target_id);
+
+  /**
+   * Calls `callback` with the ID of each target whose query could contain the
+   * document with the given key.
+   */
+  template <typename Callback>
+  void ForEachTarget(const model::DocumentKey& key,
+                     const Callback& callback) const {
+    const model::ResourcePath& path = key.path();
+
+    // Document queries are keyed by the document path and collection queries
+    // by the collection path, so neither lookup finds the other kind.
+    auto notify_targets_at = [&](const model::ResourcePath& location) {
+      auto found = targets_by_path_.find(location);
+      if (found == targets_by_path_.end()) return;
+      for (model::TargetId target_id : found->second) {
+        callback(target_id);
+      }
+    };
+    notify_targets_at(path);
+    notify_targets_at(path.PopLast());
+
+    auto found = targets_by_collection_group_.find(path[path.size() - 2]);
+    if (found == targets_by_collection_group_.end()) return;
+    for (const auto& entry : found->second) {
+      if (entry.first.IsPrefixOf(path)) {
+        callback(entry.second);
+      }
+    }
+  }
+
+ private:
+  // Pairs the parent path of a collection group query with its target.
+  using CollectionGroupEntry = std::pair<model::ResourcePath, model::TargetId>;
+
+  std::map<model::ResourcePath, std::vector<model::TargetId>> targets_by_path_;
+  std::unordered_map<std::string, std::vector<CollectionGroupEntry>>
+      targets_by_collection_group_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_QUERY_ROUTING_INDEX_H_
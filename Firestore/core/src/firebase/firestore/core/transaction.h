@@ -68,6 +68,21 @@ class Transaction {
   void Lookup(const std::vector<model::DocumentKey>& keys,
               LookupCallback&& callback);
 
+  /**
+   * Starts fetching the given documents from the backend, so that the first
+   * lookup of them in this transaction is answered by this read instead of
+   * waiting for a round trip of its own. Lookups of documents that aren't all
+   * prefetched, and later lookups of the same documents, go to the backend as
+   * usual.
+   *
+   * Meant for retries, which usually read the documents the failed attempt
+   * read. Must be called before the transaction's first lookup.
+   */
+  void Prefetch(const std::vector<model::DocumentKey>& keys);
+
+  /** Returns the keys of the documents read so far in this transaction. */
+  std::vector<model::DocumentKey> read_keys() const;
+
   /**
    * Stores mutation for the given key and set data, to be committed when
    * `Commit` is called.
@@ -113,6 +128,25 @@ class Transaction {
    */
   util::Status RecordVersion(FSTMaybeDocument* doc);
 
+  /** Fetches the given documents from the backend for `Lookup`. */
+  void ReadDocuments(const std::vector<model::DocumentKey>& keys,
+                     LookupCallback&& callback);
+
+  /**
+   * Answers a lookup from the prefetched documents, if they include all the
+   * given keys and none of them were handed out before. Returns false,
+   * without invoking the callback, otherwise.
+   */
+  bool LookupPrefetched(const std::vector<model::DocumentKey>& keys,
+                        LookupCallback& callback);
+
+  /**
+   * Invokes the callback with the prefetched documents once the prefetch has
+   * finished, or reads them from the backend if the prefetch failed.
+   */
+  void FinishPrefetchedLookup(const std::vector<model::DocumentKey>& keys,
+                              LookupCallback&& callback);
+
   /** Stores mutations to be written when `Commit` is called. */
   void WriteMutations(std::vector<FSTMutation*>&& mutations);
 
@@ -158,6 +192,10 @@ class Transaction {
                      model::SnapshotVersion,
                      model::DocumentKeyHash>
       read_versions_;
+
+  /** The documents requested by `Prefetch`, or null if there are none. */
+  struct PrefetchState;
+  std::shared_ptr<PrefetchState> prefetch_;
 };
 
 using TransactionResultCallback = util::StatusOrCallback<absl::any>;
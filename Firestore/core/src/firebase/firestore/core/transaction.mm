@@ -17,6 +17,8 @@
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 
 #include <algorithm>
+#include <mutex>  // NOLINT(build/c++11)
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 
@@ -87,24 +89,181 @@ void Transaction::Lookup(const std::vector<DocumentKey>& keys,
     return;
   }
 
-  datastore_->LookupDocuments(
-      keys, [this, callback](const std::vector<FSTMaybeDocument*>& documents,
-                             const Status& status) {
+  if (LookupPrefetched(keys, callback)) {
+    return;
+  }
+  ReadDocuments(keys, std::move(callback));
+}
+
+void Transaction::ReadDocuments(const std::vector<DocumentKey>& keys,
+                                LookupCallback&& callback) {
+  // Versions are recorded as documents stream in, rather than after the last
+  // one has arrived.
+  struct LookupState {
+    std::vector<FSTMaybeDocument*> documents;
+    Status record_error;
+  };
+  auto state = std::make_shared<LookupState>();
+  state->documents.reserve(keys.size());
+
+  datastore_->LookupDocumentsIncrementally(
+      keys,
+      [this, state](FSTMaybeDocument* doc) {
+        if (!state->record_error.ok()) {
+          return;
+        }
+        state->record_error = RecordVersion(doc);
+        state->documents.push_back(doc);
+      },
+      [state, callback](const Status& status) {
         if (!status.ok()) {
           callback({}, status);
           return;
         }
+        if (!state->record_error.ok()) {
+          callback({}, state->record_error);
+          return;
+        }
+
+        std::sort(state->documents.begin(), state->documents.end(),
+                  [](FSTMaybeDocument* lhs, FSTMaybeDocument* rhs) {
+                    return lhs.key < rhs.key;
+                  });
+        callback(state->documents, Status::OK());
+      });
+}
 
-        for (FSTMaybeDocument* doc : documents) {
-          Status record_error = RecordVersion(doc);
-          if (!record_error.ok()) {
-            callback({}, record_error);
-            return;
-          }
+/**
+ * Prefetched documents arrive on the worker queue while lookups come from the
+ * thread running the user's update block. The state outlives the transaction
+ * if documents the update block never read are still being fetched.
+ */
+struct Transaction::PrefetchState {
+  struct PrefetchedDocument {
+    /** The document read by the prefetch, or nil until it arrives. */
+    FSTMaybeDocument* _Nullable document = nil;
+
+    /** Whether a lookup was already answered with the document. */
+    bool taken = false;
+  };
+
+  std::mutex mutex;
+  std::unordered_map<DocumentKey, PrefetchedDocument, DocumentKeyHash>
+      documents;
+  bool pending = true;
+
+  /** Lookups to finish once the prefetch has finished. */
+  std::vector<std::function<void()>> waiters;
+};
+
+void Transaction::Prefetch(const std::vector<DocumentKey>& keys) {
+  HARD_ASSERT(!prefetch_, "A transaction can only be prefetched once");
+  if (keys.empty()) {
+    return;
+  }
+
+  auto state = std::make_shared<PrefetchState>();
+  for (const DocumentKey& key : keys) {
+    state->documents.emplace(key, PrefetchState::PrefetchedDocument{});
+  }
+  prefetch_ = state;
+
+  // A failed prefetch leaves the documents missing, which makes their lookups
+  // read them again.
+  datastore_->LookupDocumentsIncrementally(
+      keys,
+      [state](FSTMaybeDocument* doc) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        auto found = state->documents.find(doc.key);
+        if (found != state->documents.end()) {
+          found->second.document = doc;
+        }
+      },
+      [state](const Status&) {
+        std::vector<std::function<void()>> waiters;
+        {
+          std::lock_guard<std::mutex> lock(state->mutex);
+          state->pending = false;
+          waiters.swap(state->waiters);
         }
+        for (const auto& waiter : waiters) {
+          waiter();
+        }
+      });
+}
 
-        callback(documents, Status::OK());
+bool Transaction::LookupPrefetched(const std::vector<DocumentKey>& keys,
+                                   LookupCallback& callback) {
+  if (!prefetch_ || keys.empty()) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(prefetch_->mutex);
+    auto& documents = prefetch_->documents;
+    for (const DocumentKey& key : keys) {
+      auto found = documents.find(key);
+      if (found == documents.end() || found->second.taken) {
+        return false;
+      }
+    }
+    for (const DocumentKey& key : keys) {
+      documents[key].taken = true;
+    }
+
+    if (prefetch_->pending) {
+      // TODO(c++14): move into lambda.
+      prefetch_->waiters.push_back([this, keys, callback]() mutable {
+        FinishPrefetchedLookup(keys, std::move(callback));
       });
+      return true;
+    }
+  }
+
+  FinishPrefetchedLookup(keys, std::move(callback));
+  return true;
+}
+
+void Transaction::FinishPrefetchedLookup(const std::vector<DocumentKey>& keys,
+                                         LookupCallback&& callback) {
+  std::vector<FSTMaybeDocument*> documents;
+  documents.reserve(keys.size());
+  {
+    std::lock_guard<std::mutex> lock(prefetch_->mutex);
+    for (const DocumentKey& key : keys) {
+      FSTMaybeDocument* doc = prefetch_->documents[key].document;
+      if (doc) {
+        documents.push_back(doc);
+      }
+    }
+  }
+
+  if (documents.size() != keys.size()) {
+    ReadDocuments(keys, std::move(callback));
+    return;
+  }
+
+  for (FSTMaybeDocument* doc : documents) {
+    Status record_error = RecordVersion(doc);
+    if (!record_error.ok()) {
+      callback({}, record_error);
+      return;
+    }
+  }
+  std::sort(documents.begin(), documents.end(),
+            [](FSTMaybeDocument* lhs, FSTMaybeDocument* rhs) {
+              return lhs.key < rhs.key;
+            });
+  callback(documents, Status::OK());
+}
+
+std::vector<DocumentKey> Transaction::read_keys() const {
+  std::vector<DocumentKey> keys;
+  keys.reserve(read_versions_.size());
+  for (const auto& kv : read_versions_) {
+    keys.push_back(kv.first);
+  }
+  return keys;
 }
 
 void Transaction::WriteMutations(std::vector<FSTMutation*>&& mutations) {
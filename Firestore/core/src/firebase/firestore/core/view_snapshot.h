@@ -31,6 +31,7 @@
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_class.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/types/optional.h"
 
 OBJC_CLASS(FSTDocument);
 OBJC_CLASS(FSTQuery);
@@ -82,17 +83,41 @@ enum class SyncState { None = 0, Local, Synced };
  */
 class DocumentViewChangeSet {
  public:
+  DocumentViewChangeSet() = default;
+
+  /**
+   * Creates a change set in which every one of the given documents was added,
+   * as happens when a view starts out empty. The individual changes are only
+   * derived from the documents when they are asked for, in document order.
+   */
+  static DocumentViewChangeSet FromAddedDocuments(model::DocumentSet documents);
+
   /** Takes a new change and applies it to the set. */
   void AddChange(DocumentViewChange&& change);
 
   /** Returns the set of all changes tracked in this set. */
   std::vector<DocumentViewChange> GetChanges() const;
 
+  /**
+   * Returns true if the set was created from added documents and has taken no
+   * other changes since, in which case `GetChanges` lists the changes in the
+   * order of the documents.
+   */
+  bool all_added() const {
+    return added_documents_.has_value();
+  }
+
   std::string ToString() const;
 
  private:
   /** The set of all changes tracked so far, with redundant changes merged. */
   immutable::SortedMap<model::DocumentKey, DocumentViewChange> change_map_;
+
+  /**
+   * Set instead of `change_map_` while every change in the set is the
+   * addition of one of these documents.
+   */
+  absl::optional<model::DocumentSet> added_documents_;
 };
 
 /**
@@ -123,6 +148,16 @@ class ViewSnapshot {
                                            bool from_cache,
                                            bool excludes_metadata_changes);
 
+  /**
+   * Returns a view snapshot in which only whether the results are from the
+   * cache has changed: it shares the given documents as both its current and
+   * old documents and has no document changes.
+   */
+  static ViewSnapshot FromSyncStateChange(FSTQuery* query,
+                                          model::DocumentSet documents,
+                                          model::DocumentKeySet mutated_keys,
+                                          bool from_cache);
+
   /** The query this view is tracking the results for. */
   FSTQuery* query() const;
 
@@ -63,7 +63,23 @@ bool operator==(const DocumentViewChange& lhs, const DocumentViewChange& rhs) {
 
 // DocumentViewChangeSet
 
+DocumentViewChangeSet DocumentViewChangeSet::FromAddedDocuments(
+    DocumentSet documents) {
+  DocumentViewChangeSet result;
+  result.added_documents_ = std::move(documents);
+  return result;
+}
+
 void DocumentViewChangeSet::AddChange(DocumentViewChange&& change) {
+  if (added_documents_) {
+    // Track the added documents one by one from now on.
+    for (FSTDocument* doc : *added_documents_) {
+      change_map_ = change_map_.insert(
+          doc.key, DocumentViewChange{doc, DocumentViewChange::Type::kAdded});
+    }
+    added_documents_.reset();
+  }
+
   const DocumentKey& key = change.document().key;
   auto old_change_iter = change_map_.find(key);
   if (old_change_iter == change_map_.end()) {
@@ -128,6 +144,14 @@ void DocumentViewChangeSet::AddChange(DocumentViewChange&& change) {
 
 std::vector<DocumentViewChange> DocumentViewChangeSet::GetChanges() const {
   std::vector<DocumentViewChange> changes;
+  if (added_documents_) {
+    changes.reserve(added_documents_->size());
+    for (FSTDocument* doc : *added_documents_) {
+      changes.emplace_back(doc, DocumentViewChange::Type::kAdded);
+    }
+    return changes;
+  }
+
   for (const auto& kv : change_map_) {
     const DocumentViewChange& change = kv.second;
     changes.push_back(change);
@@ -136,6 +160,9 @@ std::vector<DocumentViewChange> DocumentViewChangeSet::GetChanges() const {
 }
 
 std::string DocumentViewChangeSet::ToString() const {
+  if (added_documents_) {
+    return util::ToString(GetChanges());
+  }
   return util::ToString(change_map_);
 }
 
@@ -177,6 +204,21 @@ ViewSnapshot ViewSnapshot::FromInitialDocuments(
                       /*sync_state_changed=*/true, excludes_metadata_changes};
 }
 
+ViewSnapshot ViewSnapshot::FromSyncStateChange(FSTQuery* query,
+                                               DocumentSet documents,
+                                               DocumentKeySet mutated_keys,
+                                               bool from_cache) {
+  DocumentSet old_documents = documents;
+  return ViewSnapshot{query,
+                      std::move(documents),
+                      std::move(old_documents),
+                      /*document_changes=*/{},
+                      std::move(mutated_keys),
+                      from_cache,
+                      /*sync_state_changed=*/true,
+                      /*excludes_metadata_changes=*/false};
+}
+
 FSTQuery* ViewSnapshot::query() const {
   return query_;
 }
@@ -42,19 +42,21 @@ namespace impl {
  * can resize itself while FixedArray cannot).
  *
  * Unlike std::array, FixedArray keeps track of its size and grows up to the
- * fixed_size limit. Inserting more elements than fixed_size will trigger an
+ * FixedSize limit. Inserting more elements than FixedSize will trigger an
  * assertion failure.
  *
  * ArraySortedMap does not actually contain its array: it contains a shared_ptr
  * to a FixedArray.
  *
  * @tparam T The type of an element in the array.
+ * @tparam FixedSize The capacity of the array.
  */
-template <typename T>
+template <typename T,
+          SortedMapBase::size_type FixedSize = SortedMapBase::kFixedSize>
 class FixedArray {
  public:
   using size_type = SortedMapBase::size_type;
-  using array_type = std::array<T, SortedMapBase::kFixedSize>;
+  using array_type = std::array<T, FixedSize>;
   using iterator = typename array_type::iterator;
   using const_iterator = typename array_type::const_iterator;
 
@@ -74,7 +76,7 @@ class FixedArray {
   void append(SourceIterator src_begin, SourceIterator src_end) {
     auto appending = static_cast<size_type>(src_end - src_begin);
     auto new_size = size_ + appending;
-    HARD_ASSERT(new_size <= SortedMapBase::kFixedSize);
+    HARD_ASSERT(new_size <= FixedSize);
 
     std::copy(src_begin, src_end, end());
     size_ = new_size;
@@ -85,7 +87,7 @@ class FixedArray {
    */
   void append(T&& value) {
     size_type new_size = size_ + 1;
-    HARD_ASSERT(new_size <= SortedMapBase::kFixedSize);
+    HARD_ASSERT(new_size <= FixedSize);
 
     *end() = std::move(value);
     size_ = new_size;
@@ -119,8 +121,13 @@ class FixedArray {
 /**
  * ArraySortedMap is a value type containing a map. It is immutable, but has
  * methods to efficiently create new maps that are mutations of it.
+ *
+ * @tparam FixedSize The maximum number of entries the map can hold.
  */
-template <typename K, typename V, typename C = util::Comparator<K>>
+template <typename K,
+          typename V,
+          typename C = util::Comparator<K>,
+          SortedMapBase::size_type FixedSize = SortedMapBase::kFixedSize>
 class ArraySortedMap : public SortedMapBase {
  public:
   /**
@@ -131,7 +138,7 @@ class ArraySortedMap : public SortedMapBase {
   /**
    * The type of the fixed-size array containing entries of value_type.
    */
-  using array_type = FixedArray<value_type>;
+  using array_type = FixedArray<value_type, FixedSize>;
   using const_iterator = typename array_type::const_iterator;
   using const_key_iterator = util::iterator_first<const_iterator>;
 
@@ -152,6 +159,21 @@ class ArraySortedMap : public SortedMapBase {
       : array_{SortedArray(entries, comparator)}, comparator_{comparator} {
   }
 
+  /**
+   * Creates an ArraySortedMap from a range of pairs that are already sorted by
+   * key, without duplicates, in the order defined by the comparator. The range
+   * must not be larger than FixedSize.
+   */
+  template <typename Range>
+  static ArraySortedMap FromSortedRange(const Range& range,
+                                        const C& comparator) {
+    auto array = std::make_shared<array_type>();
+    for (auto&& element : range) {
+      array->append(value_type{std::forward<decltype(element)>(element)});
+    }
+    return ArraySortedMap{std::move(array), comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return size() == 0;
@@ -239,9 +261,11 @@ class ArraySortedMap : public SortedMapBase {
    *     not found.
    */
   const_iterator find(const K& key) const {
-    return std::find_if(begin(), end(), [&](const std::pair<K, V>& kv) {
-      return util::Same(comparator_.Compare(key, kv.first));
-    });
+    const_iterator found = lower_bound(key);
+    if (found != end() && util::Same(comparator_.Compare(key, found->first))) {
+      return found;
+    }
+    return end();
   }
 
   /**
@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
 
+#include <cstdint>
+#include <iterator>
 #include <memory>
 #include <utility>
 
@@ -38,8 +40,11 @@ enum Color : unsigned int {
 
 /**
  * LlrbNode is a node in a TreeSortedMap.
+ *
+ * @tparam A The allocator used for the nodes of the tree. Its value_type is
+ *     irrelevant since it's always rebound to the internal node type.
  */
-template <typename K, typename V>
+template <typename K, typename V, typename A = std::allocator<std::pair<K, V>>>
 class LlrbNode : public SortedMapBase {
  public:
   using first_type = K;
@@ -49,7 +54,13 @@ class LlrbNode : public SortedMapBase {
    * The type of the entries stored in the map.
    */
   using value_type = std::pair<K, V>;
-  using const_iterator = LlrbNodeIterator<LlrbNode<K, V>>;
+  using const_iterator = LlrbNodeIterator<LlrbNode<K, V, A>>;
+
+  /**
+   * The height that no tree can exceed: a red-black tree of `n` nodes is at
+   * most `2 * lg(n + 1)` high, and node sizes are stored in 31 bits.
+   */
+  static constexpr size_t kMaxHeight = 2 * 31;
 
   /**
    * Constructs an empty node.
@@ -57,6 +68,16 @@ class LlrbNode : public SortedMapBase {
   LlrbNode() : LlrbNode{EmptyRep()} {
   }
 
+  /**
+   * Creates a tree containing the entries in the range [begin, end), which
+   * must already be sorted by key and must not contain duplicate keys.
+   *
+   * Unlike repeated calls to `insert`, this allocates each node exactly once
+   * and runs in O(N).
+   */
+  template <typename ForwardIterator>
+  static LlrbNode FromSortedRange(ForwardIterator begin, ForwardIterator end);
+
   /** Returns true if this is an empty node--a leaf node in the tree. */
   bool empty() const {
     return size() == 0;
@@ -100,6 +121,29 @@ class LlrbNode : public SortedMapBase {
   template <typename Comparator>
   LlrbNode erase(const K& key, const Comparator& comparator) const;
 
+  /**
+   * Sets/updates the given key-value pair in the tree rooted at this node,
+   * modifying in place any nodes that are referenced only by this tree. Nodes
+   * shared with other trees are copied before they're modified, so those trees
+   * are unaffected.
+   *
+   * Invalidates all iterators into this tree.
+   */
+  template <typename Comparator>
+  void InsertInPlace(const K& key,
+                     const V& value,
+                     const Comparator& comparator);
+
+  /**
+   * Removes the given key from the tree rooted at this node, modifying in place
+   * any nodes that are referenced only by this tree. See `InsertInPlace`.
+   *
+   * Entries are moved between nodes while the tree is rebalanced, so `key`
+   * must not refer to a key stored in this tree.
+   */
+  template <typename Comparator>
+  void EraseInPlace(const K& key, const Comparator& comparator);
+
   const LlrbNode& min() const {
     const LlrbNode* node = this;
     while (!node->left().empty()) {
@@ -148,7 +192,11 @@ class LlrbNode : public SortedMapBase {
     LlrbNode right_;
   };
 
-  explicit LlrbNode(Rep rep) : rep_{std::make_shared<Rep>(std::move(rep))} {
+  using RepAllocator =
+      typename std::allocator_traits<A>::template rebind_alloc<Rep>;
+
+  explicit LlrbNode(Rep rep)
+      : rep_{std::allocate_shared<Rep>(RepAllocator{}, std::move(rep))} {
   }
 
   explicit LlrbNode(const std::shared_ptr<Rep>& rep) : rep_{rep} {
@@ -212,13 +260,45 @@ class LlrbNode : public SortedMapBase {
     rep_->right_ = std::move(right);
   }
 
+  /**
+   * Ensures this node can be modified without affecting any other tree by
+   * replacing it with a copy if its Rep is shared. Empty nodes are always
+   * shared and are never modified: operations replace them instead.
+   */
+  void Unshare() {
+    if (!empty() && rep_.use_count() != 1) {
+      *this = Clone();
+    }
+  }
+
+  /**
+   * Returns the left child of this node, unshared so that it can be modified.
+   * This node must already be unshared.
+   */
+  LlrbNode& MutableLeft() {
+    rep_->left_.Unshare();
+    return rep_->left_;
+  }
+
+  /**
+   * Returns the right child of this node, unshared so that it can be modified.
+   * This node must already be unshared.
+   */
+  LlrbNode& MutableRight() {
+    rep_->right_.Unshare();
+    return rep_->right_;
+  }
+
+  template <typename ForwardIterator>
+  static LlrbNode BuildSorted(ForwardIterator* it,
+                              size_type size,
+                              size_type black_height);
+
   template <typename Comparator>
-  LlrbNode InnerInsert(const K& key,
-                       const V& value,
-                       const Comparator& comparator) const;
+  void InnerInsert(const K& key, const V& value, const Comparator& comparator);
 
   template <typename Comparator>
-  LlrbNode InnerErase(const K& key, const Comparator& comparator) const;
+  void InnerErase(const K& key, const Comparator& comparator);
 
   void FixUp();
   void FixRootColor();
@@ -238,105 +318,191 @@ class LlrbNode : public SortedMapBase {
   std::shared_ptr<Rep> rep_;
 };
 
-template <typename K, typename V>
+template <typename K, typename V, typename A>
+template <typename ForwardIterator>
+LlrbNode<K, V, A> LlrbNode<K, V, A>::FromSortedRange(ForwardIterator begin,
+                                                     ForwardIterator end) {
+  auto size = static_cast<size_type>(std::distance(begin, end));
+
+  // The tallest all-black tree that doesn't need more than `size` entries.
+  // Every 2-3 tree with this black height can hold at least 2^h - 1 and at
+  // most 3^h - 1 entries, which always covers `size`.
+  size_type black_height = 0;
+  while ((uint64_t{1} << (black_height + 1)) - 1 <= size) {
+    ++black_height;
+  }
+  return BuildSorted(&begin, size, black_height);
+}
+
+/**
+ * Builds a tree of `size` entries taken in order from `*it`, with every path
+ * from the root to a leaf passing through exactly `black_height` black nodes.
+ *
+ * Each level is shaped as a 2-3 tree: a 2-node is a single black node, and a
+ * 3-node is a black node with a red left child, which keeps the result
+ * left-leaning. Entries are consumed in-order so the iterator is only walked
+ * once.
+ */
+template <typename K, typename V, typename A>
+template <typename ForwardIterator>
+LlrbNode<K, V, A> LlrbNode<K, V, A>::BuildSorted(ForwardIterator* it,
+                                                 size_type size,
+                                                 size_type black_height) {
+  if (black_height == 0) {
+    return LlrbNode{};
+  }
+
+  // The largest number of entries a child subtree can hold.
+  uint64_t child_capacity = 1;
+  for (size_type i = 1; i < black_height; ++i) {
+    child_capacity *= 3;
+  }
+  child_capacity -= 1;
+
+  size_type child_height = black_height - 1;
+  if (size - 1 <= 2 * child_capacity) {
+    size_type remaining = size - 1;
+    LlrbNode left = BuildSorted(it, remaining - remaining / 2, child_height);
+    value_type entry{**it};
+    ++*it;
+    LlrbNode right = BuildSorted(it, remaining / 2, child_height);
+    return LlrbNode{Rep{std::move(entry), Color::Black, std::move(left),
+                        std::move(right)}};
+  }
+
+  size_type remaining = size - 2;
+  size_type third = remaining / 3;
+  size_type extra = remaining % 3;
+
+  LlrbNode left_left = BuildSorted(it, third + (extra > 0), child_height);
+  value_type left_entry{**it};
+  ++*it;
+  LlrbNode left_right = BuildSorted(it, third + (extra > 1), child_height);
+  LlrbNode left{Rep{std::move(left_entry), Color::Red, std::move(left_left),
+                    std::move(left_right)}};
+
+  value_type entry{**it};
+  ++*it;
+  LlrbNode right = BuildSorted(it, third, child_height);
+  return LlrbNode{
+      Rep{std::move(entry), Color::Black, std::move(left), std::move(right)}};
+}
+
+template <typename K, typename V, typename A>
 template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::insert(const K& key,
-                                      const V& value,
-                                      const Comparator& comparator) const {
-  LlrbNode root = InnerInsert(key, value, comparator);
-  root.FixRootColor();
+LlrbNode<K, V, A> LlrbNode<K, V, A>::insert(
+    const K& key, const V& value, const Comparator& comparator) const {
+  // The copy shares its Rep with this node, so every node on the path to the
+  // new entry is copied exactly once and this tree is left untouched.
+  LlrbNode root{*this};
+  root.InsertInPlace(key, value, comparator);
   return root;
 }
 
-template <typename K, typename V>
+template <typename K, typename V, typename A>
 template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::InnerInsert(const K& key,
-                                           const V& value,
-                                           const Comparator& comparator) const {
+LlrbNode<K, V, A> LlrbNode<K, V, A>::erase(
+    const K& key, const Comparator& comparator) const {
+  LlrbNode root{*this};
+  root.EraseInPlace(key, comparator);
+  return root;
+}
+
+template <typename K, typename V, typename A>
+template <typename Comparator>
+void LlrbNode<K, V, A>::InsertInPlace(const K& key,
+                                      const V& value,
+                                      const Comparator& comparator) {
+  Unshare();
+  InnerInsert(key, value, comparator);
+  FixRootColor();
+}
+
+template <typename K, typename V, typename A>
+template <typename Comparator>
+void LlrbNode<K, V, A>::EraseInPlace(const K& key,
+                                     const Comparator& comparator) {
+  Unshare();
+  InnerErase(key, comparator);
+  FixRootColor();
+}
+
+/**
+ * Inserts into the subtree rooted at this node, which must be empty or
+ * unshared.
+ */
+template <typename K, typename V, typename A>
+template <typename Comparator>
+void LlrbNode<K, V, A>::InnerInsert(const K& key,
+                                    const V& value,
+                                    const Comparator& comparator) {
   if (empty()) {
-    return LlrbNode{Rep{{key, value}, Color::Red, LlrbNode{}, LlrbNode{}}};
+    *this = LlrbNode{Rep{{key, value}, Color::Red, LlrbNode{}, LlrbNode{}}};
+    return;
   }
 
-  // Inserting is going to result in a copy but we can save some allocations by
-  // creating the copy once and fixing that up, rather than copying and
-  // re-copying the result.
-  LlrbNode result = Clone();
-
-  const K& this_key = this->key();
-  util::ComparisonResult cmp = comparator.Compare(this_key, key);
+  util::ComparisonResult cmp = comparator.Compare(this->key(), key);
   if (cmp == util::ComparisonResult::Descending) {
-    result.set_left(result.left().InnerInsert(key, value, comparator));
-    result.FixUp();
+    MutableLeft().InnerInsert(key, value, comparator);
+    FixUp();
 
   } else if (cmp == util::ComparisonResult::Ascending) {
-    result.set_right(result.right().InnerInsert(key, value, comparator));
-    result.FixUp();
+    MutableRight().InnerInsert(key, value, comparator);
+    FixUp();
 
   } else {
     // keys are equal so update the value.
-    result.set_value(value);
+    set_value(value);
   }
-  return result;
 }
 
-template <typename K, typename V>
-template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::erase(const K& key,
-                                     const Comparator& comparator) const {
-  LlrbNode root = InnerErase(key, comparator);
-  root.FixRootColor();
-  return root;
-}
-
-template <typename K, typename V>
+/**
+ * Erases from the subtree rooted at this node, which must be empty or
+ * unshared.
+ */
+template <typename K, typename V, typename A>
 template <typename Comparator>
-LlrbNode<K, V> LlrbNode<K, V>::InnerErase(const K& key,
-                                          const Comparator& comparator) const {
+void LlrbNode<K, V, A>::InnerErase(const K& key,
+                                   const Comparator& comparator) {
   if (empty()) {
-    // Empty node already frozen
-    return LlrbNode{};
+    return;
   }
 
-  LlrbNode n = Clone();
-
-  if (util::Ascending(comparator.Compare(key, n.key()))) {
-    if (!n.left().empty() && !n.left().red() && !n.left().left().red()) {
-      n.MoveRedLeft();
+  if (util::Ascending(comparator.Compare(key, this->key()))) {
+    if (!left().empty() && !left().red() && !left().left().red()) {
+      MoveRedLeft();
     }
-    n.set_left(n.left().InnerErase(key, comparator));
+    MutableLeft().InnerErase(key, comparator);
 
   } else {
-    if (n.left().red()) {
-      n.RotateRight();
+    if (left().red()) {
+      RotateRight();
     }
 
-    if (!n.right().empty() && !n.right().red() && !n.right().left().red()) {
-      n.MoveRedRight();
+    if (!right().empty() && !right().red() && !right().left().red()) {
+      MoveRedRight();
     }
 
-    if (util::Same(comparator.Compare(key, n.key()))) {
-      if (n.right().empty()) {
-        return LlrbNode{};
+    if (util::Same(comparator.Compare(key, this->key()))) {
+      if (right().empty()) {
+        *this = LlrbNode{};
+        return;
 
       } else {
-        // Move the minimum node from the right subtree in place of this node.
-        LlrbNode smallest = n.right().min();
-        LlrbNode new_right = n.right().Clone();
-        new_right.RemoveMin();
-
-        n.set_entry(smallest.entry());
-        n.set_right(std::move(new_right));
+        // Move the minimum entry from the right subtree in place of this
+        // node's entry.
+        set_entry(right().min().entry());
+        MutableRight().RemoveMin();
       }
     } else {
-      n.set_right(n.right().InnerErase(key, comparator));
+      MutableRight().InnerErase(key, comparator);
     }
   }
-  n.FixUp();
-  return n;
+  FixUp();
 }
 
-template <typename K, typename V>
-void LlrbNode<K, V>::FixUp() {
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::FixUp() {
   set_size(left().size() + 1 + right().size());
 
   if (right().red() && !left().red()) {
@@ -353,21 +519,18 @@ void LlrbNode<K, V>::FixUp() {
 /**
  * Fixes the root node so its color is always black.
  *
- * This change is safe because a red `root` must be a new root:
- *   * If the key is not found, InnerErase returns an existing root, but
- *     existing roots will already be black (by the invariant).
- *   * If the key is found, InnerErase returns a new root, which is safe to
- *     modify.
+ * This change is safe because a red root can only be the result of an update,
+ * which leaves the root unshared.
  */
-template <typename K, typename V>
-void LlrbNode<K, V>::FixRootColor() {
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::FixRootColor() {
   if (red()) {
     rep_->color_ = Color::Black;
   }
 }
 
-template <typename K, typename V>
-void LlrbNode<K, V>::RemoveMin() {
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::RemoveMin() {
   // If the left node is empty then the right node must be empty (because the
   // tree is left-leaning) and this node must be the minimum.
   if (left().empty()) {
@@ -379,26 +542,22 @@ void LlrbNode<K, V>::RemoveMin() {
     MoveRedLeft();
   }
 
-  LlrbNode new_left = left().Clone();
-  new_left.RemoveMin();
-  set_left(std::move(new_left));
+  MutableLeft().RemoveMin();
   FixUp();
 }
 
-template <typename K, typename V>
-void LlrbNode<K, V>::MoveRedLeft() {
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::MoveRedLeft() {
   FlipColor();
   if (right().left().red()) {
-    LlrbNode new_right = right().Clone();
-    new_right.RotateRight();
-    set_right(std::move(new_right));
+    MutableRight().RotateRight();
     RotateLeft();
     FlipColor();
   }
 }
 
-template <typename K, typename V>
-void LlrbNode<K, V>::MoveRedRight() {
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::MoveRedRight() {
   FlipColor();
   if (left().left().red()) {
     RotateRight();
@@ -414,8 +573,8 @@ void LlrbNode<K, V>::MoveRedRight() {
  *        / \      / \
  *       RL RR     L RL
  */
-template <typename K, typename V>
-void LlrbNode<K, V>::RotateLeft() {
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::RotateLeft() {
   LlrbNode new_left{
       Rep{std::move(rep_->entry_), Color::Red, left(), right().left()}};
 
@@ -433,8 +592,8 @@ void LlrbNode<K, V>::RotateLeft() {
  *  / \                  / \
  * LL LR                LR R
  */
-template <typename K, typename V>
-void LlrbNode<K, V>::RotateRight() {
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::RotateRight() {
   LlrbNode new_right{
       Rep{std::move(rep_->entry_), Color::Red, left().right(), right()}};
 
@@ -444,18 +603,18 @@ void LlrbNode<K, V>::RotateRight() {
   set_right(std::move(new_right));
 }
 
-template <typename K, typename V>
-void LlrbNode<K, V>::FlipColor() {
-  LlrbNode new_left = left().Clone();
-  new_left.set_color(left().OppositeColor());
+template <typename K, typename V, typename A>
+void LlrbNode<K, V, A>::FlipColor() {
+  // Both children are non-empty whenever colors are flipped, so they can
+  // always be modified once unshared.
+  LlrbNode& left = MutableLeft();
+  left.set_color(left.OppositeColor());
 
-  LlrbNode new_right = right().Clone();
-  new_right.set_color(right().OppositeColor());
+  LlrbNode& right = MutableRight();
+  right.set_color(right.OppositeColor());
 
   // Preserve contents_ and size_
   set_color(OppositeColor());
-  set_left(std::move(new_left));
-  set_right(std::move(new_right));
 }
 
 }  // namespace impl
@@ -17,8 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
 
+#include <algorithm>
+#include <cstddef>
 #include <iterator>
-#include <stack>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/immutable/llrb_node.h"
@@ -30,6 +31,48 @@ namespace firestore {
 namespace immutable {
 namespace impl {
 
+/**
+ * The stack of nodes kept by an LlrbNodeIterator. Since the height of the tree
+ * is bounded, the nodes are stored inline rather than on the heap, so that
+ * creating and copying iterators doesn't allocate.
+ */
+template <typename N>
+class LlrbNodeStack {
+ public:
+  LlrbNodeStack() = default;
+
+  LlrbNodeStack(const LlrbNodeStack& other) : size_{other.size_} {
+    std::copy(other.nodes_, other.nodes_ + size_, nodes_);
+  }
+
+  LlrbNodeStack& operator=(const LlrbNodeStack& other) {
+    size_ = other.size_;
+    std::copy(other.nodes_, other.nodes_ + size_, nodes_);
+    return *this;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  const N* top() const {
+    return nodes_[size_ - 1];
+  }
+
+  void push(const N* node) {
+    HARD_ASSERT(size_ < N::kMaxHeight, "Tree is higher than its bound");
+    nodes_[size_++] = node;
+  }
+
+  void pop() {
+    --size_;
+  }
+
+ private:
+  size_t size_ = 0;
+  const N* nodes_[N::kMaxHeight];
+};
+
 /**
  * A forward iterator for traversing LlrbNodes. LlrbNodes represent the nodes
  * in a tree implementing a sorted map so iterating with LlrbNodeIterator is
@@ -44,7 +87,8 @@ namespace impl {
  *
  * For an underlying tree of size `n`:
  *
- *   * LlrbNodeIterator uses `O(lg(n))` memory for its stack, and
+ *   * LlrbNodeIterator keeps a stack of up to `O(lg(n))` nodes, in storage
+ *     sized for the highest possible tree, and
  *   * incrementing an iterator is an `O(lg(n))` operation.
  *
  * ## Invalidation and Comparison
@@ -67,7 +111,7 @@ class LlrbNodeIterator {
   using node_type = N;
   using key_type = typename node_type::first_type;
 
-  using stack_type = std::stack<const node_type*>;
+  using stack_type = LlrbNodeStack<node_type>;
 
   using iterator_category = std::forward_iterator_tag;
   using value_type = typename node_type::value_type;
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_POOL_ALLOCATOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+
+#include "absl/base/config.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A per-thread cache of freed memory blocks that all have the same size.
+ *
+ * Blocks come from (and are eventually returned to) the global operator new,
+ * so a block allocated on one thread may safely be freed on another: it just
+ * ends up in the freeing thread's cache. Each cache holds at most
+ * kMaxCachedBlocks blocks and is released when its thread exits.
+ *
+ * On platforms without `thread_local` (e.g. iOS 8) no blocks are cached.
+ */
+template <size_t Size>
+class BlockCache {
+ public:
+  static void* Allocate() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+    State& state = state_;
+    if (state.head) {
+      FreeBlock* block = state.head;
+      state.head = block->next;
+      state.count--;
+      return block;
+    }
+#endif
+    return ::operator new(Size);
+  }
+
+  static void Deallocate(void* block) noexcept {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+    State& state = state_;
+    if (state.count < kMaxCachedBlocks && !state.released) {
+      // Ensure the cache is released at thread exit once it holds blocks.
+      static thread_local Releaser releaser;
+      (void)releaser;
+
+      state.head = new (block) FreeBlock{state.head};
+      state.count++;
+      return;
+    }
+#endif
+    ::operator delete(block);
+  }
+
+ private:
+  static constexpr size_t kMaxCachedBlocks = 256;
+
+  static_assert(Size >= sizeof(void*), "Blocks must be able to hold a pointer");
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  // Trivially destructible so that it remains usable while thread_local
+  // objects are being destroyed; the Releaser empties it instead.
+  struct State {
+    FreeBlock* head;
+    size_t count;
+    bool released;
+  };
+
+  struct Releaser {
+    ~Releaser() {
+      State& state = state_;
+      while (state.head) {
+        FreeBlock* block = state.head;
+        state.head = block->next;
+        ::operator delete(block);
+      }
+      state.count = 0;
+      state.released = true;
+    }
+  };
+
+  static thread_local State state_;
+#endif
+};
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+template <size_t Size>
+thread_local typename BlockCache<Size>::State BlockCache<Size>::state_{};
+#endif
+
+}  // namespace impl
+
+/**
+ * An allocator that recycles single-object allocations through a small
+ * per-thread cache instead of going to the system allocator every time.
+ *
+ * Persistent updates to a TreeSortedMap free and allocate roughly the same
+ * number of nodes, so with a PoolAllocator most node allocations are served
+ * from memory released by earlier updates. Pass it as the allocator parameter
+ * of SortedMap or TreeSortedMap to opt in.
+ */
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  PoolAllocator() noexcept = default;
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) noexcept {  // NOLINT(runtime/explicit)
+  }
+
+  T* allocate(size_t n) {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "PoolAllocator does not support over-aligned types");
+    if (n != 1) {
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    return static_cast<T*>(impl::BlockCache<BlockSize()>::Allocate());
+  }
+
+  void deallocate(T* ptr, size_t n) noexcept {
+    if (n != 1) {
+      ::operator delete(ptr);
+      return;
+    }
+    impl::BlockCache<BlockSize()>::Deallocate(ptr);
+  }
+
+  friend bool operator==(const PoolAllocator&, const PoolAllocator&) noexcept {
+    return true;
+  }
+
+  friend bool operator!=(const PoolAllocator&, const PoolAllocator&) noexcept {
+    return false;
+  }
+
+ private:
+  static constexpr size_t BlockSize() {
+    return sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T);
+  }
+};
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_POOL_ALLOCATOR_H_
@@ -17,7 +17,10 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
 
+#include <iterator>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/immutable/keys_view.h"
@@ -25,6 +28,8 @@
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map_iterator.h"
 #include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/range.h"
 #include "absl/base/attributes.h"
 
 namespace firebase {
@@ -34,21 +39,34 @@ namespace immutable {
 /**
  * SortedMap is a value type containing a map. It is immutable, but
  * has methods to efficiently create new maps that are mutations of it.
+ *
+ * @tparam A The allocator used for the nodes of large maps, which are stored
+ *     as trees. Maps that are updated often can use PoolAllocator to recycle
+ *     nodes instead of going to the system allocator on every update.
+ * @tparam FixedSize The largest number of entries stored in a flat sorted
+ *     array before the map switches to a tree. The array is allocated at its
+ *     full capacity and copied on every update, so larger thresholds trade
+ *     memory and update cost for faster lookups and iteration of mid-sized
+ *     maps.
  */
-template <typename K, typename V, typename C = util::Comparator<K>>
+template <typename K,
+          typename V,
+          typename C = util::Comparator<K>,
+          typename A = std::allocator<std::pair<K, V>>,
+          SortedMapBase::size_type FixedSize = SortedMapBase::kFixedSize>
 class SortedMap : public SortedMapBase {
  public:
   using key_type = K;
   using mapped_type = V;
   /** The type of the entries stored in the map. */
   using value_type = std::pair<K, V>;
-  using array_type = impl::ArraySortedMap<K, V, C>;
-  using tree_type = impl::TreeSortedMap<K, V, C>;
+  using array_type = impl::ArraySortedMap<K, V, C, FixedSize>;
+  using tree_type = impl::TreeSortedMap<K, V, C, A>;
 
   using const_iterator = impl::SortedMapIterator<
       value_type,
-      typename impl::FixedArray<value_type>::const_iterator,
-      typename impl::LlrbNode<K, V>::const_iterator>;
+      typename array_type::const_iterator,
+      typename impl::LlrbNode<K, V, A>::const_iterator>;
 
   using const_key_iterator = util::iterator_first<const_iterator>;
 
@@ -64,7 +82,7 @@ class SortedMap : public SortedMapBase {
    */
   SortedMap(std::initializer_list<value_type> entries,
             const C& comparator = {}) {
-    if (entries.size() <= kFixedSize) {
+    if (entries.size() <= FixedSize) {
       tag_ = Tag::Array;
       new (&array_) array_type{entries, comparator};
     } else {
@@ -72,6 +90,74 @@ class SortedMap : public SortedMapBase {
     }
   }
 
+  /**
+   * Creates a SortedMap containing the entries in the given range, which must
+   * already be sorted by key, without duplicates, in the order defined by the
+   * comparator.
+   *
+   * This is much cheaper than building up a map by repeated insertion: each
+   * entry is copied once and, for large maps, each tree node is allocated
+   * once.
+   */
+  template <typename Range>
+  static SortedMap FromSortedRange(const Range& range,
+                                   const C& comparator = {}) {
+    auto size = std::distance(std::begin(range), std::end(range));
+    if (size <= static_cast<decltype(size)>(FixedSize)) {
+      return SortedMap{array_type::FromSortedRange(range, comparator)};
+    } else {
+      return SortedMap{tree_type::FromSortedRange(range, comparator)};
+    }
+  }
+
+  /**
+   * Accumulates entries in ascending key order and then builds a SortedMap
+   * containing them, using `FromSortedRange`.
+   *
+   * This is useful when a map is built from the contents of another sorted
+   * container: appending to the Builder is cheap, whereas each call to
+   * `insert` copies part of the map.
+   */
+  class Builder {
+   public:
+    explicit Builder(const C& comparator = {}) : comparator_{comparator} {
+    }
+
+    /** Reserves space for the given number of entries. */
+    void reserve(size_type size) {
+      entries_.reserve(size);
+    }
+
+    /**
+     * Appends the given entry, whose key must sort after the keys of all
+     * entries appended so far.
+     */
+    void push_back(K key, V value) {
+      HARD_ASSERT(entries_.empty() ||
+                      util::Ascending(
+                          comparator_.Compare(entries_.back().first, key)),
+                  "Entries must be appended in ascending key order");
+      entries_.emplace_back(std::move(key), std::move(value));
+    }
+
+    /**
+     * Builds a SortedMap containing all the appended entries. The Builder is
+     * left empty and can be reused.
+     */
+    SortedMap Build() {
+      SortedMap result = FromSortedRange(
+          util::make_range(std::make_move_iterator(entries_.begin()),
+                           std::make_move_iterator(entries_.end())),
+          comparator_);
+      entries_.clear();
+      return result;
+    }
+
+   private:
+    std::vector<value_type> entries_;
+    C comparator_;
+  };
+
   SortedMap(const SortedMap& other) : tag_{other.tag_} {
     switch (tag_) {
       case Tag::Array:
@@ -172,14 +258,14 @@ class SortedMap : public SortedMapBase {
   ABSL_MUST_USE_RESULT SortedMap insert(const K& key, const V& value) const {
     switch (tag_) {
       case Tag::Array:
-        if (array_.size() >= kFixedSize) {
+        if (array_.size() >= FixedSize) {
           // Strictly speaking this conversion is more eager than it needs to
           // be since we could be replacing an existing key. However, the
           // benefit of using the array for small maps doesn't really depend on
           // exactly where this cut-off happens and just unconditionally
           // converting if the next insertion could overflow keeps things
           // simpler.
-          tree_type tree = tree_type::Create(array_, comparator());
+          tree_type tree = tree_type::FromSortedRange(array_, comparator());
           return SortedMap{tree.insert(key, value)};
         } else {
           return SortedMap{array_.insert(key, value)};
@@ -211,6 +297,51 @@ class SortedMap : public SortedMapBase {
     UNREACHABLE();
   }
 
+  /**
+   * Adds or updates a key-value pair in this map, modifying it in place.
+   *
+   * Unlike `insert`, this doesn't copy the parts of the map that are
+   * referenced only by this map, so applying a batch of updates to a copy of a
+   * map copies each affected node at most once rather than once per update.
+   * Parts still shared with other maps are copied before they're changed, so
+   * other maps never observe the update.
+   *
+   * Invalidates all iterators into this map.
+   */
+  void InsertInPlace(const K& key, const V& value) {
+    switch (tag_) {
+      case Tag::Array:
+        // Arrays are small enough that copying them on each update is cheap.
+        *this = insert(key, value);
+        return;
+      case Tag::Tree:
+        tree_.InsertInPlace(key, value);
+        return;
+    }
+    UNREACHABLE();
+  }
+
+  /**
+   * Removes a key from this map, modifying it in place. See `InsertInPlace`.
+   *
+   * `key` must not refer to a key stored in this map.
+   */
+  void EraseInPlace(const K& key) {
+    switch (tag_) {
+      case Tag::Array:
+        *this = erase(key);
+        return;
+      case Tag::Tree:
+        tree_.EraseInPlace(key);
+        if (tree_.empty()) {
+          // Flip back to the array representation for empty arrays.
+          *this = SortedMap{comparator()};
+        }
+        return;
+    }
+    UNREACHABLE();
+  }
+
   bool contains(const K& key) const {
     switch (tag_) {
       case Tag::Array:
@@ -346,15 +477,7 @@ class SortedMap : public SortedMapBase {
     return impl::KeysViewIn(*this, start_key, end_key, comparator());
   }
 
- private:
-  explicit SortedMap(array_type&& array)
-      : tag_{Tag::Array}, array_{std::move(array)} {
-  }
-
-  explicit SortedMap(tree_type&& tree)
-      : tag_{Tag::Tree}, tree_{std::move(tree)} {
-  }
-
+  /** Returns the comparator that defines the order of this map. */
   const C& comparator() const {
     switch (tag_) {
       case Tag::Array:
@@ -365,6 +488,15 @@ class SortedMap : public SortedMapBase {
     UNREACHABLE();
   }
 
+ private:
+  explicit SortedMap(array_type&& array)
+      : tag_{Tag::Array}, array_{std::move(array)} {
+  }
+
+  explicit SortedMap(tree_type&& tree)
+      : tag_{Tag::Tree}, tree_{std::move(tree)} {
+  }
+
   enum class Tag {
     Array,
     Tree,
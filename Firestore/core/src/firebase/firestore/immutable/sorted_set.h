@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_SET_H_
 
 #include <algorithm>
+#include <iterator>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
@@ -40,6 +41,28 @@ struct Empty {
   }
 };
 
+
+template <typename Range>
+SortedMapBase::size_type RangeSize(const Range& range) {
+  return static_cast<SortedMapBase::size_type>(
+      std::distance(std::begin(range), std::end(range)));
+}
+
+/**
+ * Returns true if changing `count` values of a set of `size` values is
+ * cheaper done by rebuilding the whole set than by `count` insertions or
+ * erasures, each of which copies a path of about log(size) nodes.
+ */
+inline bool PrefersRebuild(SortedMapBase::size_type size,
+                           SortedMapBase::size_type count) {
+  SortedMapBase::size_type depth = 1;
+  for (SortedMapBase::size_type remaining = size; remaining > 1;
+       remaining /= 2) {
+    ++depth;
+  }
+  return count * depth >= size;
+}
+
 }  // namespace impl
 
 template <typename K,
@@ -69,6 +92,21 @@ class SortedSet : public SortedContainer {
     }
   }
 
+  /**
+   * Creates a SortedSet containing the values in the given range, which must
+   * already be sorted, without duplicates, in the order defined by the
+   * comparator.
+   */
+  template <typename Range>
+  static SortedSet FromSortedRange(const Range& range,
+                                   const C& comparator = {}) {
+    typename M::Builder builder{comparator};
+    for (const K& value : range) {
+      builder.push_back(value, {});
+    }
+    return SortedSet{builder.Build()};
+  }
+
   bool empty() const {
     return map_.empty();
   }
@@ -85,6 +123,141 @@ class SortedSet : public SortedContainer {
     return SortedSet{map_.erase(key)};
   }
 
+  /**
+   * Adds the given value to this set in place. See
+   * `SortedMap::InsertInPlace`.
+   */
+  void InsertInPlace(const K& key) {
+    map_.InsertInPlace(key, {});
+  }
+
+  /**
+   * Removes the given value from this set in place. See
+   * `SortedMap::EraseInPlace`.
+   */
+  void EraseInPlace(const K& key) {
+    map_.EraseInPlace(key);
+  }
+
+  /**
+   * Returns a set containing the values of this set and the given values,
+   * which must be sorted, without duplicates, in the order defined by the
+   * comparator. Values already in this set are left as they are.
+   *
+   * When many values are added relative to the size of this set, both
+   * sequences are merged and the result is built once, which is linear in the
+   * size of the result instead of copying part of the tree for every value.
+   */
+  template <typename Range>
+  ABSL_MUST_USE_RESULT SortedSet insert_all(const Range& values) const {
+    size_type count = impl::RangeSize(values);
+    if (!impl::PrefersRebuild(size(), count)) {
+      SortedSet result = *this;
+      for (const K& value : values) {
+        result = result.insert(value);
+      }
+      return result;
+    }
+
+    const C& comparator = map_.comparator();
+    typename M::Builder builder{comparator};
+    builder.reserve(size() + count);
+
+    const_iterator existing = begin();
+    const_iterator existing_end = end();
+    for (const K& value : values) {
+      for (; existing != existing_end; ++existing) {
+        if (!util::Ascending(comparator.Compare(*existing, value))) break;
+        builder.push_back(*existing, {});
+      }
+      if (existing != existing_end &&
+          util::Same(comparator.Compare(*existing, value))) {
+        continue;
+      }
+      builder.push_back(value, {});
+    }
+    for (; existing != existing_end; ++existing) {
+      builder.push_back(*existing, {});
+    }
+    return SortedSet{builder.Build()};
+  }
+
+  /**
+   * Returns a set containing the values of this set except the given values,
+   * which must be sorted, without duplicates, in the order defined by the
+   * comparator. Values not in this set are ignored.
+   *
+   * As with `insert_all`, removing many values rebuilds the set once in linear
+   * time.
+   */
+  template <typename Range>
+  ABSL_MUST_USE_RESULT SortedSet erase_all(const Range& values) const {
+    if (!impl::PrefersRebuild(size(), impl::RangeSize(values))) {
+      SortedSet result = *this;
+      for (const K& value : values) {
+        result = result.erase(value);
+      }
+      return result;
+    }
+
+    const C& comparator = map_.comparator();
+    typename M::Builder builder{comparator};
+    builder.reserve(size());
+
+    auto removed = std::begin(values);
+    auto removed_end = std::end(values);
+    for (const K& value : *this) {
+      while (removed != removed_end &&
+             util::Ascending(comparator.Compare(*removed, value))) {
+        ++removed;
+      }
+      if (removed != removed_end &&
+          util::Same(comparator.Compare(*removed, value))) {
+        continue;
+      }
+      builder.push_back(value, {});
+    }
+    return SortedSet{builder.Build()};
+  }
+
+  /**
+   * Returns a set containing just the values of this set that are also among
+   * the given values, which must be sorted, without duplicates, in the order
+   * defined by the comparator.
+   *
+   * When there are few values relative to the size of this set, each is
+   * looked up in this set; otherwise both sequences are merged. Either way the
+   * result is built once.
+   */
+  template <typename Range>
+  ABSL_MUST_USE_RESULT SortedSet retain_all(const Range& values) const {
+    const C& comparator = map_.comparator();
+    typename M::Builder builder{comparator};
+
+    if (!impl::PrefersRebuild(size(), impl::RangeSize(values))) {
+      for (const K& value : values) {
+        if (contains(value)) {
+          builder.push_back(value, {});
+        }
+      }
+      return SortedSet{builder.Build()};
+    }
+
+    auto retained = std::begin(values);
+    auto retained_end = std::end(values);
+    for (const K& value : *this) {
+      while (retained != retained_end &&
+             util::Ascending(comparator.Compare(*retained, value))) {
+        ++retained;
+      }
+      if (retained == retained_end) break;
+      if (util::Same(comparator.Compare(*retained, value))) {
+        builder.push_back(value, {});
+      }
+    }
+    return SortedSet{builder.Build()};
+  }
+
   bool contains(const K& key) const {
     return map_.contains(key);
   }
@@ -146,9 +319,14 @@ class SortedSet : public SortedContainer {
   M map_;
 };
 
-template <typename K, typename C, typename V>
-SortedSet<K, C, V> MakeSortedSet(const SortedMap<K, V, C>& map) {
-  return SortedSet<K, C, V>{map};
+template <typename K,
+          typename C,
+          typename V,
+          typename A,
+          SortedMapBase::size_type FixedSize>
+SortedSet<K, C, V, SortedMap<K, V, C, A, FixedSize>> MakeSortedSet(
+    const SortedMap<K, V, C, A, FixedSize>& map) {
+  return SortedSet<K, C, V, SortedMap<K, V, C, A, FixedSize>>{map};
 }
 
 }  // namespace immutable
@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <cassert>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <utility>
 
@@ -37,8 +38,13 @@ namespace impl {
 /**
  * TreeSortedMap is a value type containing a map. It is immutable, but has
  * methods to efficiently create new maps that are mutations of it.
+ *
+ * @tparam A The allocator used for tree nodes. See PoolAllocator.
  */
-template <typename K, typename V, typename C = util::Comparator<K>>
+template <typename K,
+          typename V,
+          typename C = util::Comparator<K>,
+          typename A = std::allocator<std::pair<K, V>>>
 class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
   using ComparatorMember = util::CompressedMember<C>;
 
@@ -51,7 +57,7 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
   /**
    * The type of the node containing entries of value_type.
    */
-  using node_type = LlrbNode<K, V>;
+  using node_type = LlrbNode<K, V, A>;
   using const_iterator = typename node_type::const_iterator;
   using const_key_iterator = util::iterator_first<const_iterator>;
 
@@ -74,6 +80,18 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
     return TreeSortedMap{std::move(node), comparator};
   }
 
+  /**
+   * Creates a TreeSortedMap from a range of pairs that are already sorted by
+   * key, without duplicates, in the order defined by the comparator.
+   */
+  template <typename Range>
+  static TreeSortedMap FromSortedRange(const Range& range,
+                                       const C& comparator) {
+    return TreeSortedMap{node_type::FromSortedRange(std::begin(range),
+                                                    std::end(range)),
+                         comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return root_.empty();
@@ -116,6 +134,21 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
     return TreeSortedMap{root_.erase(key, comparator), comparator};
   }
 
+  /**
+   * Adds or updates a key-value pair in this map in place. See
+   * `SortedMap::InsertInPlace`.
+   */
+  void InsertInPlace(const K& key, const V& value) {
+    root_.InsertInPlace(key, value, this->comparator());
+  }
+
+  /**
+   * Removes a key from this map in place. See `SortedMap::EraseInPlace`.
+   */
+  void EraseInPlace(const K& key) {
+    root_.EraseInPlace(key, this->comparator());
+  }
+
   bool contains(const K& key) const {
     // Inline the tree traversal here to avoid building up the stack required
     // to construct a full iterator.
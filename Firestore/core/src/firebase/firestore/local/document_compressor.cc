@@ -0,0 +1,191 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/document_compressor.h"
+
+#include <zlib.h>
+
+#include <cstdint>
+#include <utility>
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/base/internal/endian.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using util::Status;
+using util::StatusOr;
+
+// A compressed row is made up of:
+//   * the marker byte;
+//   * the Adler-32 checksum of the dictionary, as 4 little-endian bytes;
+//   * the size of the encoded document, as a base-128 varint;
+//   * the raw deflate stream.
+constexpr char kCompressedMarker = '\0';
+constexpr size_t kChecksumSize = 4;
+
+// Raw deflate streams, without the zlib header and trailer, since the row
+// already records what's needed to check it.
+constexpr int kWindowBits = -15;
+constexpr int kMemLevel = 8;
+
+uint32_t Checksum(const std::string& dictionary) {
+  uLong checksum = adler32(0L, Z_NULL, 0);
+  return static_cast<uint32_t>(adler32(
+      checksum, reinterpret_cast<const Bytef*>(dictionary.data()),
+      static_cast<uInt>(dictionary.size())));
+}
+
+void WriteVarint(uint32_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+bool ReadVarint(absl::string_view* in, uint32_t* value) {
+  uint32_t result = 0;
+  for (int shift = 0; shift < 35 && !in->empty(); shift += 7) {
+    auto byte = static_cast<uint8_t>(in->front());
+    in->remove_prefix(1);
+    result |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+Status CorruptRow(const char* reason) {
+  return Status{Error::DataLoss,
+                std::string{"Compressed document is corrupt: "} + reason};
+}
+
+}  // namespace
+
+constexpr size_t DocumentCompressor::kMaxDictionarySize;
+
+std::string DocumentCompressor::TrainDictionary(
+    const std::vector<std::string>& samples) {
+  size_t count = 0;
+  size_t size = 0;
+  for (; count != samples.size(); ++count) {
+    if (size + samples[count].size() > kMaxDictionarySize) break;
+    size += samples[count].size();
+  }
+
+  std::string dictionary;
+  dictionary.reserve(size);
+  while (count != 0) {
+    dictionary += samples[--count];
+  }
+  return dictionary;
+}
+
+DocumentCompressor::DocumentCompressor(std::string dictionary)
+    : dictionary_{std::move(dictionary)} {
+  HARD_ASSERT(dictionary_.size() <= kMaxDictionarySize,
+              "Dictionary of %s bytes is too large", dictionary_.size());
+}
+
+bool DocumentCompressor::IsCompressed(absl::string_view row) {
+  return !row.empty() && row.front() == kCompressedMarker;
+}
+
+std::string DocumentCompressor::Compress(absl::string_view encoded) const {
+  z_stream stream{};
+  int result = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                            kWindowBits, kMemLevel, Z_DEFAULT_STRATEGY);
+  HARD_ASSERT(result == Z_OK, "deflateInit2 failed: %s", result);
+  if (!dictionary_.empty()) {
+    deflateSetDictionary(&stream,
+                         reinterpret_cast<const Bytef*>(dictionary_.data()),
+                         static_cast<uInt>(dictionary_.size()));
+  }
+
+  std::string row;
+  row.push_back(kCompressedMarker);
+  char checksum[kChecksumSize];
+  absl::little_endian::Store32(checksum, Checksum(dictionary_));
+  row.append(checksum, kChecksumSize);
+  WriteVarint(static_cast<uint32_t>(encoded.size()), &row);
+
+  size_t header_size = row.size();
+  uLong bound = deflateBound(&stream, static_cast<uLong>(encoded.size()));
+  row.resize(header_size + bound);
+
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(encoded.data()));
+  stream.avail_in = static_cast<uInt>(encoded.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&row[header_size]);
+  stream.avail_out = static_cast<uInt>(bound);
+  result = deflate(&stream, Z_FINISH);
+  HARD_ASSERT(result == Z_STREAM_END, "deflate failed: %s", result);
+  row.resize(header_size + stream.total_out);
+  deflateEnd(&stream);
+
+  if (row.size() >= encoded.size()) {
+    return std::string{encoded.data(), encoded.size()};
+  }
+  return row;
+}
+
+StatusOr<std::string> DocumentCompressor::Decompress(
+    absl::string_view row) const {
+  HARD_ASSERT(IsCompressed(row), "Row doesn't hold a compressed document");
+  row.remove_prefix(1);
+
+  if (row.size() < kChecksumSize) return CorruptRow("truncated header");
+  if (absl::little_endian::Load32(row.data()) != Checksum(dictionary_)) {
+    return CorruptRow("compressed with another dictionary");
+  }
+  row.remove_prefix(kChecksumSize);
+
+  uint32_t size = 0;
+  if (!ReadVarint(&row, &size)) return CorruptRow("truncated header");
+
+  z_stream stream{};
+  int result = inflateInit2(&stream, kWindowBits);
+  HARD_ASSERT(result == Z_OK, "inflateInit2 failed: %s", result);
+  if (!dictionary_.empty()) {
+    inflateSetDictionary(&stream,
+                         reinterpret_cast<const Bytef*>(dictionary_.data()),
+                         static_cast<uInt>(dictionary_.size()));
+  }
+
+  std::string encoded(size, '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(row.data()));
+  stream.avail_in = static_cast<uInt>(row.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&encoded[0]);
+  stream.avail_out = static_cast<uInt>(size);
+  result = inflate(&stream, Z_FINISH);
+  bool complete = result == Z_STREAM_END && stream.total_out == size;
+  inflateEnd(&stream);
+
+  if (!complete) return CorruptRow("invalid deflate stream");
+  return encoded;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
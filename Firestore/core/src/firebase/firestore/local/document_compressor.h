@@ -0,0 +1,85 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_COMPRESSOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_COMPRESSOR_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Compresses the encoded documents stored in the remote document cache, using
+ * deflate with a preset dictionary trained on the database's own documents.
+ *
+ * Field names, recurring string values and the resource name prefix of
+ * references repeat across rows far more than within a single row, so
+ * compressing each row on its own gains little. Seeding the compressor with a
+ * sample of other rows lets every row refer back to what they share.
+ *
+ * A compressed row starts with a zero byte, which never starts an encoded
+ * MaybeDocument (whose field numbers start at 1), so compressed and plain rows
+ * can be told apart and coexist in the same table.
+ */
+class DocumentCompressor {
+ public:
+  /** The largest dictionary deflate can make use of. */
+  static constexpr size_t kMaxDictionarySize = 32 * 1024;
+
+  /**
+   * Builds a dictionary out of the given encoded documents, keeping the
+   * earliest ones if they don't all fit. Deflate finds the end of the
+   * dictionary cheapest to refer to, so the earliest samples are placed last.
+   */
+  static std::string TrainDictionary(const std::vector<std::string>& samples);
+
+  explicit DocumentCompressor(std::string dictionary);
+
+  /** Returns true if the given row holds a compressed document. */
+  static bool IsCompressed(absl::string_view row);
+
+  /**
+   * Returns the row to store for the given encoded document: compressed if
+   * that makes it smaller, otherwise the encoded document as it is.
+   */
+  std::string Compress(absl::string_view encoded) const;
+
+  /**
+   * Returns the encoded document stored in the given compressed row, or an
+   * error if the row is corrupt or was compressed with another dictionary.
+   */
+  util::StatusOr<std::string> Decompress(absl::string_view row) const;
+
+  const std::string& dictionary() const {
+    return dictionary_;
+  }
+
+ private:
+  std::string dictionary_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_COMPRESSOR_H_
@@ -0,0 +1,350 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/filter.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+#include "absl/base/casts.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using core::FieldFilter;
+using core::Filter;
+using core::Query;
+using model::FieldPath;
+using model::FieldValue;
+using util::OrderedCode;
+using Type = FieldValue::Type;
+
+/**
+ * Labels written before each encoded value. The labels follow the relative
+ * order of FieldValue types. Types that are comparable with each other (like
+ * integers and doubles) share a label so that their values interleave.
+ */
+enum IndexValueLabel : uint64_t {
+  /** Marks the end of an array, map, or reference path. */
+  kEnd = 0,
+
+  /** Marks an additional entry in a map or path segment in a reference. */
+  kContinuation = 1,
+
+  kNull = 10,
+  kBoolean = 11,
+  kNumber = 12,
+  kTimestamp = 13,
+  kServerTimestamp = 14,
+  kString = 15,
+  kBlob = 16,
+  kReference = 17,
+  kGeoPoint = 18,
+  kArray = 19,
+  kObject = 20,
+};
+
+IndexValueLabel LabelForType(Type type) {
+  switch (type) {
+    case Type::Null:
+      return IndexValueLabel::kNull;
+    case Type::Boolean:
+      return IndexValueLabel::kBoolean;
+    case Type::Integer:
+    case Type::Double:
+      return IndexValueLabel::kNumber;
+    case Type::Timestamp:
+      return IndexValueLabel::kTimestamp;
+    case Type::ServerTimestamp:
+      return IndexValueLabel::kServerTimestamp;
+    case Type::String:
+      return IndexValueLabel::kString;
+    case Type::Blob:
+      return IndexValueLabel::kBlob;
+    case Type::Reference:
+      return IndexValueLabel::kReference;
+    case Type::GeoPoint:
+      return IndexValueLabel::kGeoPoint;
+    case Type::Array:
+      return IndexValueLabel::kArray;
+    case Type::Object:
+      return IndexValueLabel::kObject;
+  }
+
+  UNREACHABLE();
+}
+
+void WriteLabel(std::string* dest, IndexValueLabel label) {
+  OrderedCode::WriteNumIncreasing(dest, label);
+}
+
+/**
+ * Writes a double such that the unsigned byte-wise order of the output matches
+ * the numeric order of the input. NaN sorts before all other numbers and
+ * negative zero is written as positive zero, as in `util::Compare`.
+ */
+void WriteDouble(std::string* dest, double value) {
+  if (std::isnan(value)) {
+    OrderedCode::WriteNumIncreasing(dest, 0);
+    return;
+  }
+  if (value == 0) {
+    value = 0;
+  }
+
+  uint64_t bits = absl::bit_cast<uint64_t>(value);
+  if (bits & (uint64_t{1} << 63)) {
+    bits = ~bits;
+  } else {
+    bits |= uint64_t{1} << 63;
+  }
+  OrderedCode::WriteNumIncreasing(dest, bits);
+}
+
+void WriteTimestamp(std::string* dest, const firebase::Timestamp& value) {
+  OrderedCode::WriteSignedNumIncreasing(dest, value.seconds());
+  OrderedCode::WriteNumIncreasing(dest, value.nanoseconds());
+}
+
+void WriteValue(std::string* dest, const FieldValue& value) {
+  Type type = value.type();
+  WriteLabel(dest, LabelForType(type));
+
+  switch (type) {
+    case Type::Null:
+      break;
+
+    case Type::Boolean:
+      OrderedCode::WriteNumIncreasing(dest, value.boolean_value() ? 1 : 0);
+      break;
+
+    case Type::Integer:
+      WriteDouble(dest, static_cast<double>(value.integer_value()));
+      break;
+
+    case Type::Double:
+      WriteDouble(dest, value.double_value());
+      break;
+
+    case Type::Timestamp:
+      WriteTimestamp(dest, value.timestamp_value());
+      break;
+
+    case Type::ServerTimestamp:
+      WriteTimestamp(dest, value.server_timestamp_value().local_write_time());
+      break;
+
+    case Type::String:
+      OrderedCode::WriteString(dest, value.string_value());
+      break;
+
+    case Type::Blob: {
+      const nanopb::ByteString& blob = value.blob_value();
+      OrderedCode::WriteString(
+          dest, absl::string_view{reinterpret_cast<const char*>(blob.data()),
+                                  blob.size()});
+      break;
+    }
+
+    case Type::Reference: {
+      const FieldValue::Reference& reference = value.reference_value();
+      OrderedCode::WriteString(dest, reference.database_id().project_id());
+      OrderedCode::WriteString(dest, reference.database_id().database_id());
+      for (const std::string& segment : reference.key().path()) {
+        WriteLabel(dest, IndexValueLabel::kContinuation);
+        OrderedCode::WriteString(dest, segment);
+      }
+      WriteLabel(dest, IndexValueLabel::kEnd);
+      break;
+    }
+
+    case Type::GeoPoint:
+      WriteDouble(dest, value.geo_point_value().latitude());
+      WriteDouble(dest, value.geo_point_value().longitude());
+      break;
+
+    case Type::Array:
+      // Every element starts with a type label, all of which sort after End.
+      for (const FieldValue& element : value.array_value()) {
+        WriteValue(dest, element);
+      }
+      WriteLabel(dest, IndexValueLabel::kEnd);
+      break;
+
+    case Type::Object:
+      for (const auto& entry : value.object_value()) {
+        WriteLabel(dest, IndexValueLabel::kContinuation);
+        OrderedCode::WriteString(dest, entry.first);
+        WriteValue(dest, entry.second);
+      }
+      WriteLabel(dest, IndexValueLabel::kEnd);
+      break;
+  }
+}
+
+/**
+ * Returns the smallest encoded value that's comparable with the given value.
+ */
+std::string TypeLowerBound(const FieldValue& value) {
+  std::string result;
+  WriteLabel(&result, LabelForType(value.type()));
+  return result;
+}
+
+/**
+ * Returns an encoded value that sorts after all values comparable with the
+ * given value.
+ */
+std::string TypeUpperBound(const FieldValue& value) {
+  IndexValueLabel label = LabelForType(value.type());
+  if (label == IndexValueLabel::kTimestamp) {
+    // Server timestamps are comparable with (and sort after) timestamps.
+    label = IndexValueLabel::kServerTimestamp;
+  }
+
+  std::string result;
+  OrderedCode::WriteNumIncreasing(&result, label + 1);
+  return result;
+}
+
+}  // namespace
+
+std::string EncodeFieldIndexValue(const FieldValue& value) {
+  std::string result;
+  WriteValue(&result, value);
+  return result;
+}
+
+absl::optional<FieldIndexScan> FieldIndexScan::ForQuery(const Query& query) {
+  const FieldFilter* in = nullptr;
+  const FieldFilter* inequality = nullptr;
+
+  for (const std::shared_ptr<Filter>& filter : query.filters()) {
+    // Only plain field filters and `in` filters can be answered by a field
+    // index. Key filters and array filters are handled by scanning the
+    // collection.
+    if (filter->type() == Filter::Type::kInFilter) {
+      if (!in) {
+        in = static_cast<const FieldFilter*>(filter.get());
+      }
+      continue;
+    }
+    if (filter->type() != Filter::Type::kFieldFilter) continue;
+
+    const auto& field_filter = static_cast<const FieldFilter&>(*filter);
+    if (field_filter.op() == Filter::Operator::Equal) {
+      std::string encoded = EncodeFieldIndexValue(field_filter.value());
+      return FieldIndexScan{field_filter.field(),
+                            Range{encoded, encoded, /*upper_inclusive=*/true}};
+    } else if (!inequality) {
+      inequality = &field_filter;
+    }
+  }
+
+  // An `in` filter is the union of equality filters on each of its values.
+  // Scanning the value ranges in order merges them into one sorted result,
+  // without visiting the same entry twice for values that share an encoding.
+  if (in) {
+    std::vector<std::string> encoded_values;
+    for (const FieldValue& value : in->value().array_value()) {
+      encoded_values.push_back(EncodeFieldIndexValue(value));
+    }
+    std::sort(encoded_values.begin(), encoded_values.end());
+    encoded_values.erase(
+        std::unique(encoded_values.begin(), encoded_values.end()),
+        encoded_values.end());
+
+    std::vector<Range> ranges;
+    for (std::string& encoded : encoded_values) {
+      ranges.emplace_back(encoded, encoded, /*upper_inclusive=*/true);
+    }
+    return FieldIndexScan{in->field(), std::move(ranges)};
+  }
+
+  // Bounds are always inclusive because integers can share an encoding with
+  // their neighbors. Callers re-filter the results anyway.
+  if (inequality) {
+    const FieldValue& value = inequality->value();
+    switch (inequality->op()) {
+      case Filter::Operator::LessThan:
+      case Filter::Operator::LessThanOrEqual:
+        return FieldIndexScan{
+            inequality->field(),
+            Range{TypeLowerBound(value), EncodeFieldIndexValue(value),
+                  /*upper_inclusive=*/true}};
+
+      case Filter::Operator::GreaterThan:
+      case Filter::Operator::GreaterThanOrEqual:
+        return FieldIndexScan{
+            inequality->field(),
+            Range{EncodeFieldIndexValue(value), TypeUpperBound(value),
+                  /*upper_inclusive=*/false}};
+
+      default:
+        HARD_FAIL("Unexpected operator for inequality %s",
+                  inequality->ToString());
+    }
+  }
+
+  // Ordering by a field only matches documents that have that field, so a full
+  // scan of the field's index is still a (usually much smaller) superset.
+  for (const core::OrderBy& order_by : query.explicit_order_bys()) {
+    if (!order_by.field().IsKeyFieldPath()) {
+      return FieldIndexScan{
+          order_by.field(),
+          Range{"", absl::nullopt, /*upper_inclusive=*/false}};
+    }
+  }
+
+  return absl::nullopt;
+}
+
+bool FieldIndexScan::Contains(absl::string_view encoded_value) const {
+  for (const Range& range : ranges_) {
+    if (encoded_value < range.lower_bound()) {
+      // Later ranges only start after this one.
+      return false;
+    }
+    if (!range.IsPastUpperBound(encoded_value)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool FieldIndexScan::Range::IsPastUpperBound(
+    absl::string_view encoded_value) const {
+  if (!upper_bound_) return false;
+
+  int cmp = encoded_value.compare(*upper_bound_);
+  return upper_inclusive_ ? cmp > 0 : cmp >= 0;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_INDEX_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_INDEX_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Encodes the given value into a string whose lexicographic (byte-wise) order
+ * matches the order defined by `FieldValue::CompareTo`. Values that compare as
+ * the same (e.g. `1` and `1.0`) produce the same encoding.
+ *
+ * Integers are encoded as doubles so large integers may share an encoding with
+ * their neighbors. Consumers of an index built from these values must therefore
+ * treat index bounds as inclusive and re-filter the results.
+ */
+std::string EncodeFieldIndexValue(const model::FieldValue& value);
+
+/**
+ * Describes a scan over a single-field index that yields a superset of the
+ * documents matching a query.
+ *
+ * A scan consists of one or more ranges. The ranges are ordered by their lower
+ * bounds and don't overlap, so scanning them one after the other visits the
+ * entries of the index in order. Bounds are expressed in terms of values
+ * encoded by `EncodeFieldIndexValue`.
+ */
+class FieldIndexScan {
+ public:
+  /** A contiguous range of encoded values. */
+  class Range {
+   public:
+    Range(std::string lower_bound,
+          absl::optional<std::string> upper_bound,
+          bool upper_inclusive)
+        : lower_bound_(std::move(lower_bound)),
+          upper_bound_(std::move(upper_bound)),
+          upper_inclusive_(upper_inclusive) {
+    }
+
+    /** The inclusive lower bound of the range. */
+    const std::string& lower_bound() const {
+      return lower_bound_;
+    }
+
+    /**
+     * Returns true if the given encoded value sorts after the end of this
+     * range, indicating that the scan of the range is complete.
+     */
+    bool IsPastUpperBound(absl::string_view encoded_value) const;
+
+   private:
+    std::string lower_bound_;
+    absl::optional<std::string> upper_bound_;
+    bool upper_inclusive_ = false;
+  };
+
+  /**
+   * Returns a scan over a single-field index that can answer the given query,
+   * or `absl::nullopt` if the query has no suitable filter or ordering.
+   *
+   * Equality filters are preferred over `in` filters, which scan one range per
+   * value, then over inequality filters, which in turn are preferred over the
+   * first explicit ordering.
+   */
+  static absl::optional<FieldIndexScan> ForQuery(const core::Query& query);
+
+  /** The field whose index is scanned. */
+  const model::FieldPath& field_path() const {
+    return field_path_;
+  }
+
+  /** The ranges to scan, in index order. */
+  const std::vector<Range>& ranges() const {
+    return ranges_;
+  }
+
+  /** Returns true if the given encoded value falls within one of the ranges. */
+  bool Contains(absl::string_view encoded_value) const;
+
+ private:
+  FieldIndexScan(model::FieldPath field_path, std::vector<Range> ranges)
+      : field_path_(std::move(field_path)), ranges_(std::move(ranges)) {
+  }
+
+  FieldIndexScan(model::FieldPath field_path, Range range)
+      : field_path_(std::move(field_path)) {
+    ranges_.push_back(std::move(range));
+  }
+
+  model::FieldPath field_path_;
+  std::vector<Range> ranges_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_FIELD_INDEX_H_
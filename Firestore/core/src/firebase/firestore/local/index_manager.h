@@ -17,10 +17,17 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_INDEX_MANAGER_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -29,8 +36,14 @@ namespace local {
 /**
  * Represents a set of indexes that are used to execute queries efficiently.
  *
- * Currently the only index is a [collection id] => [parent path] index, used
- * to execute Collection Group queries.
+ * There are two kinds of indexes:
+ *
+ *   * A [collection id] => [parent path] index, used to execute Collection
+ *     Group queries.
+ *   * Single-field indexes of the form [collection path, field, value] =>
+ *     [document key], used to avoid scanning a whole collection to execute
+ *     filtered or ordered queries. These are built on demand, the first time a
+ *     collection is queried on a field.
  */
 class IndexManager {
  public:
@@ -56,6 +69,59 @@ class IndexManager {
    */
   virtual std::vector<model::ResourcePath> GetCollectionParents(
       const std::string& collection_id) = 0;
+
+  /**
+   * Returns true if an index on the given field has been built for the
+   * documents in the given collection.
+   */
+  virtual bool HasFieldIndex(const model::ResourcePath& collection_path,
+                             const model::FieldPath& field_path) = 0;
+
+  /**
+   * Registers an index on the given field for the documents in the given
+   * collection. The index is empty until populated with AddToFieldIndexes();
+   * callers are expected to do so for every document already in the
+   * collection before relying on the index.
+   *
+   * @return true if the index was registered, false if this IndexManager does
+   * not maintain field indexes.
+   */
+  virtual bool AddFieldIndex(const model::ResourcePath& collection_path,
+                             const model::FieldPath& field_path) = 0;
+
+  /**
+   * Updates the entries for the given document in all the field indexes on its
+   * collection, replacing any entries previously written for the document.
+   */
+  virtual void AddToFieldIndexes(const model::DocumentKey& key,
+                                 const model::ObjectValue& data) = 0;
+
+  /** Removes the entries for the given document from all field indexes. */
+  virtual void RemoveFromFieldIndexes(const model::DocumentKey& key) = 0;
+
+  /**
+   * Returns the keys of the documents in the given collection whose indexed
+   * values fall within the given scan. The result is a superset of the
+   * documents that match the query from which the scan was created.
+   *
+   * The index on `scan.field_path()` must have been added to the collection.
+   */
+  virtual model::DocumentKeySet GetDocumentsMatchingFieldIndex(
+      const model::ResourcePath& collection_path,
+      const FieldIndexScan& scan) = 0;
+
+  /**
+   * Visits the entries of the given collection's index whose values fall
+   * within the given scan, in the order of their encoded values and then of
+   * their document keys, until the visitor returns false.
+   *
+   * The index on `scan.field_path()` must have been added to the collection.
+   */
+  using FieldIndexVisitor = std::function<bool(
+      absl::string_view encoded_value, const model::DocumentKey& key)>;
+  virtual void ScanFieldIndex(const model::ResourcePath& collection_path,
+                              const FieldIndexScan& scan,
+                              const FieldIndexVisitor& visitor) = 0;
 };
 
 }  // namespace local
@@ -0,0 +1,528 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_bundle_loader.h"
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <utility>
+
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
+#include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/timestamp_internal.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "absl/strings/match.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DatabaseId;
+using model::DocumentKey;
+using model::ListenSequenceNumber;
+using model::ResourcePath;
+using model::SnapshotVersion;
+using model::TargetId;
+using nanopb::Reader;
+using nanopb::StringWriter;
+using util::Status;
+using util::StatusOr;
+using util::StringFormat;
+
+namespace {
+
+// The field numbers of the messages the bundle is made of, as described on
+// BundleWriter.
+constexpr uint32_t kBundleReadTimeTag = 1;
+constexpr uint32_t kBundleDocumentTag = 2;
+constexpr uint32_t kBundleQueryTag = 3;
+
+constexpr uint32_t kQueryCanonicalIdTag = 1;
+constexpr uint32_t kQueryTargetTag = 2;
+constexpr uint32_t kQueryDocumentPathTag = 3;
+
+struct TimestampProto {
+  int64_t seconds;
+  int32_t nanos;
+};
+
+TimestampProto ReadTimestampProto(Reader* reader) {
+  TimestampProto result{};
+  reader->ReadNestedMessage([&](Reader* fields) {
+    while (fields->ReadTag()) {
+      switch (fields->field_number()) {
+        case google_protobuf_Timestamp_seconds_tag:
+          result.seconds = fields->ReadInteger();
+          break;
+        case google_protobuf_Timestamp_nanos_tag:
+          result.nanos = static_cast<int32_t>(fields->ReadInteger());
+          break;
+        default:
+          fields->SkipField();
+      }
+    }
+  });
+  return result;
+}
+
+void WriteTimestampProto(StringWriter* writer,
+                         uint32_t field_number,
+                         const TimestampProto& timestamp) {
+  StringWriter fields;
+  if (timestamp.seconds != 0) {
+    fields.WriteTag(PB_WT_VARINT, google_protobuf_Timestamp_seconds_tag);
+    fields.WriteInteger(timestamp.seconds);
+  }
+  if (timestamp.nanos != 0) {
+    fields.WriteTag(PB_WT_VARINT, google_protobuf_Timestamp_nanos_tag);
+    fields.WriteInteger(timestamp.nanos);
+  }
+  writer->WriteTag(PB_WT_STRING, field_number);
+  writer->WriteString(fields.Release());
+}
+
+/**
+ * Reads the name of a document from its encoded `MaybeDocument`, skipping
+ * over everything else.
+ */
+std::string ReadDocumentName(Reader* reader) {
+  static_assert(firestore_client_NoDocument_name_tag ==
+                        google_firestore_v1_Document_name_tag &&
+                    firestore_client_UnknownDocument_name_tag ==
+                        google_firestore_v1_Document_name_tag,
+                "All kinds of documents must keep their name in one field");
+
+  std::string name;
+  while (reader->ReadTag()) {
+    switch (reader->field_number()) {
+      case firestore_client_MaybeDocument_no_document_tag:
+      case firestore_client_MaybeDocument_document_tag:
+      case firestore_client_MaybeDocument_unknown_document_tag:
+        reader->ReadNestedMessage([&](Reader* fields) {
+          while (fields->ReadTag()) {
+            if (fields->field_number() ==
+                google_firestore_v1_Document_name_tag) {
+              name = fields->ReadString();
+            } else {
+              fields->SkipField();
+            }
+          }
+        });
+        break;
+      default:
+        reader->SkipField();
+    }
+  }
+  return name;
+}
+
+}  // namespace
+
+BundleWriter::BundleWriter(const SnapshotVersion& read_time) {
+  const Timestamp& timestamp = read_time.timestamp();
+  WriteTimestampProto(&writer_, kBundleReadTimeTag,
+                      {timestamp.seconds(), timestamp.nanoseconds()});
+}
+
+void BundleWriter::AddDocument(absl::string_view encoded_document) {
+  writer_.WriteTag(PB_WT_STRING, kBundleDocumentTag);
+  writer_.WriteString(encoded_document);
+}
+
+void BundleWriter::AddQuery(absl::string_view canonical_id,
+                            absl::string_view encoded_target,
+                            const std::vector<DocumentKey>& documents) {
+  StringWriter query;
+  query.WriteTag(PB_WT_STRING, kQueryCanonicalIdTag);
+  query.WriteString(canonical_id);
+  query.WriteTag(PB_WT_STRING, kQueryTargetTag);
+  query.WriteString(encoded_target);
+  for (const DocumentKey& key : documents) {
+    query.WriteTag(PB_WT_STRING, kQueryDocumentPathTag);
+    query.WriteString(key.ToString());
+  }
+
+  writer_.WriteTag(PB_WT_STRING, kBundleQueryTag);
+  writer_.WriteString(query.Release());
+}
+
+std::string BundleWriter::Release() {
+  return writer_.Release();
+}
+
+LevelDbBundleLoader::LevelDbBundleLoader(leveldb::DB* db,
+                                         DatabaseId database_id)
+    : db_{db}, database_id_{std::move(database_id)} {
+  name_prefix_ =
+      StringFormat("projects/%s/databases/%s/documents/",
+                   database_id_.project_id(), database_id_.database_id());
+}
+
+StatusOr<LevelDbBundleLoader::Result> LevelDbBundleLoader::Load(
+    absl::string_view bundle) {
+  // Validate everything before writing anything, so that a bad bundle doesn't
+  // leave the cache half loaded. The documents are cheap to skip over again.
+  SnapshotVersion read_time = SnapshotVersion::None();
+  std::vector<BundledTarget> targets;
+  std::set<TargetId> target_ids;
+  Status status = Read(
+      bundle, &read_time,
+      [](const DocumentKey&, absl::string_view) { return Status::OK(); },
+      [&](BundledTarget&& target) -> Status {
+        if (!target_ids.insert(target.target_id).second) {
+          return Status{Error::InvalidArgument,
+                        StringFormat("Bundle has target %s more than once",
+                                     target.target_id)};
+        }
+
+        std::string value;
+        leveldb::Status found =
+            db_->Get(LevelDbTransaction::DefaultReadOptions(),
+                     LevelDbTargetKey::Key(target.target_id), &value);
+        if (found.ok()) {
+          return Status{Error::FailedPrecondition,
+                        StringFormat("Target %s is already in the cache",
+                                     target.target_id)};
+        } else if (!found.IsNotFound()) {
+          return ConvertStatus(found);
+        }
+
+        targets.push_back(std::move(target));
+        return Status::OK();
+      });
+  if (!status.ok()) return status;
+
+  Result result;
+  status = Read(
+      bundle, &read_time,
+      [&](const DocumentKey& key, absl::string_view encoded) -> Status {
+        Status added = AddDocument(key, encoded, read_time, &result);
+        if (!added.ok()) return added;
+        return FlushIfLarger(batch_size_bytes_);
+      },
+      [](BundledTarget&&) { return Status::OK(); });
+  if (!status.ok()) return status;
+
+  for (const BundledTarget& target : targets) {
+    AddTargetDocuments(target);
+    status = FlushIfLarger(batch_size_bytes_);
+    if (!status.ok()) return status;
+  }
+
+  // The targets and the metadata counting them go in the final batch, together.
+  for (const BundledTarget& target : targets) {
+    batch_.Put(LevelDbTargetKey::Key(target.target_id),
+               MakeSlice(target.encoded_target));
+    batch_.Put(LevelDbQueryTargetKey::Key(target.canonical_id,
+                                          target.target_id),
+               leveldb::Slice{});
+  }
+  if (!targets.empty()) {
+    status = UpdateTargetGlobal(targets);
+    if (!status.ok()) return status;
+  }
+  status = FlushIfLarger(0);
+  if (!status.ok()) return status;
+
+  result.query_count = targets.size();
+  return result;
+}
+
+template <typename DocumentCallback, typename TargetCallback>
+Status LevelDbBundleLoader::Read(absl::string_view bundle,
+                                 SnapshotVersion* read_time,
+                                 const DocumentCallback& on_document,
+                                 const TargetCallback& on_target) {
+  Reader reader{bundle};
+  Status status;
+  bool read_documents = false;
+
+  while (status.ok() && reader.ReadTag()) {
+    switch (reader.field_number()) {
+      case kBundleReadTimeTag: {
+        TimestampProto timestamp = ReadTimestampProto(&reader);
+        if (!reader.status().ok()) break;
+        if (read_documents) {
+          return Status{Error::InvalidArgument,
+                        "The read time of a bundle must precede its documents"};
+        }
+        if (timestamp.seconds < TimestampInternal::Min().seconds() ||
+            timestamp.seconds > TimestampInternal::Max().seconds() ||
+            timestamp.nanos < 0 || timestamp.nanos > 999999999) {
+          return Status{Error::InvalidArgument,
+                        "The read time of a bundle is out of range"};
+        }
+        *read_time =
+            SnapshotVersion{Timestamp{timestamp.seconds, timestamp.nanos}};
+        break;
+      }
+
+      case kBundleDocumentTag: {
+        read_documents = true;
+        std::string encoded = reader.ReadString();
+        if (!reader.status().ok()) break;
+
+        Reader document_reader{encoded};
+        std::string name = ReadDocumentName(&document_reader);
+        if (!document_reader.status().ok()) return document_reader.status();
+
+        StatusOr<DocumentKey> key = ParseDocumentName(name);
+        if (!key.ok()) return key.status();
+        status = on_document(key.ValueOrDie(), encoded);
+        break;
+      }
+
+      case kBundleQueryTag: {
+        BundledTarget target;
+        std::vector<std::string> paths;
+        reader.ReadNestedMessage([&](Reader* fields) {
+          while (fields->ReadTag()) {
+            switch (fields->field_number()) {
+              case kQueryCanonicalIdTag:
+                target.canonical_id = fields->ReadString();
+                break;
+              case kQueryTargetTag:
+                target.encoded_target = fields->ReadString();
+                break;
+              case kQueryDocumentPathTag:
+                paths.push_back(fields->ReadString());
+                break;
+              default:
+                fields->SkipField();
+            }
+          }
+        });
+        if (!reader.status().ok()) break;
+
+        Reader target_reader{target.encoded_target};
+        while (target_reader.ReadTag()) {
+          switch (target_reader.field_number()) {
+            case firestore_client_Target_target_id_tag:
+              target.target_id =
+                  static_cast<TargetId>(target_reader.ReadInteger());
+              break;
+            case firestore_client_Target_last_listen_sequence_number_tag:
+              target.sequence_number = target_reader.ReadInteger();
+              break;
+            default:
+              target_reader.SkipField();
+          }
+        }
+        if (!target_reader.status().ok()) return target_reader.status();
+        if (target.canonical_id.empty() || target.target_id <= 0) {
+          return Status{Error::InvalidArgument,
+                        "Bundled queries need a canonical ID and a target ID"};
+        }
+
+        for (const std::string& path : paths) {
+          StatusOr<DocumentKey> key = ParseDocumentPath(path);
+          if (!key.ok()) return key.status();
+          target.documents.push_back(std::move(key).ValueOrDie());
+        }
+        status = on_target(std::move(target));
+        break;
+      }
+
+      default:
+        reader.SkipField();
+    }
+  }
+
+  if (!reader.status().ok()) return reader.status();
+  return status;
+}
+
+StatusOr<DocumentKey> LevelDbBundleLoader::ParseDocumentPath(
+    absl::string_view path) const {
+  // ResourcePath::FromString asserts there are no empty segments.
+  if (path.find("//") == absl::string_view::npos) {
+    ResourcePath resource_path = ResourcePath::FromString(path);
+    if (DocumentKey::IsDocumentKey(resource_path)) {
+      return DocumentKey{std::move(resource_path)};
+    }
+  }
+  return Status{Error::InvalidArgument,
+                StringFormat("Invalid document path in bundle: %s", path)};
+}
+
+StatusOr<DocumentKey> LevelDbBundleLoader::ParseDocumentName(
+    absl::string_view name) const {
+  if (!absl::StartsWith(name, name_prefix_)) {
+    return Status{Error::InvalidArgument,
+                  StringFormat("Bundled document %s is not in database %s/%s",
+                               name, database_id_.project_id(),
+                               database_id_.database_id())};
+  }
+  name.remove_prefix(name_prefix_.size());
+  return ParseDocumentPath(name);
+}
+
+Status LevelDbBundleLoader::AddDocument(const DocumentKey& key,
+                                        absl::string_view encoded_document,
+                                        const SnapshotVersion& read_time,
+                                        Result* result) {
+  batch_.Put(LevelDbRemoteDocumentKey::Key(key), MakeSlice(encoded_document));
+  batch_.Put(LevelDbCollectionGroupDocumentKey::Key(key), leveldb::Slice{});
+
+  // Like LevelDbRemoteDocumentCache::Add, replace the row for the time the
+  // document was previously read at, if any.
+  std::string read_time_key = LevelDbDocumentReadTimeKey::Key(key);
+  std::string previous;
+  leveldb::Status found = db_->Get(LevelDbTransaction::DefaultReadOptions(),
+                                   read_time_key, &previous);
+  if (found.ok()) {
+    batch_.Delete(LevelDbRemoteDocumentReadTimeKey::Key(
+        key, LevelDbDocumentReadTimeKey::DecodeReadTime(previous)));
+  } else if (!found.IsNotFound()) {
+    return ConvertStatus(found);
+  }
+  batch_.Put(LevelDbRemoteDocumentReadTimeKey::Key(key, read_time),
+             leveldb::Slice{});
+  batch_.Put(read_time_key,
+             LevelDbDocumentReadTimeKey::EncodeReadTime(read_time));
+
+  if (HasFieldIndexes(key.path().PopLast())) {
+    result->documents_to_index.push_back(key);
+  }
+  result->document_count++;
+  return Status::OK();
+}
+
+void LevelDbBundleLoader::AddTargetDocuments(const BundledTarget& target) {
+  // Matches LevelDbQueryCache::AddMatchingKeys, with the reference to each
+  // document made at the target's sequence number.
+  std::string sentinel_value =
+      LevelDbDocumentTargetKey::EncodeSentinelValue(target.sequence_number);
+  for (const DocumentKey& key : target.documents) {
+    batch_.Put(LevelDbTargetDocumentKey::Key(target.target_id, key),
+               leveldb::Slice{});
+    batch_.Put(LevelDbDocumentTargetKey::Key(key, target.target_id),
+               leveldb::Slice{});
+    batch_.Put(LevelDbDocumentTargetKey::SentinelKey(key), sentinel_value);
+  }
+}
+
+bool LevelDbBundleLoader::HasFieldIndexes(const ResourcePath& collection) {
+  auto found = collections_.find(collection);
+  if (found != collections_.end()) {
+    return found->second;
+  }
+
+  // The first document seen in each collection also adds the collection to the
+  // collection parent index.
+  batch_.Put(LevelDbCollectionParentKey::Key(collection.last_segment(),
+                                             collection.PopLast()),
+             leveldb::Slice{});
+
+  std::string prefix = LevelDbFieldIndexKey::KeyPrefix(collection);
+  std::unique_ptr<leveldb::Iterator> it{
+      db_->NewIterator(LevelDbTransaction::FastScanReadOptions())};
+  it->Seek(prefix);
+  bool indexed = it->Valid() && absl::StartsWith(MakeStringView(it->key()),
+                                                 prefix);
+  collections_.emplace(collection, indexed);
+  return indexed;
+}
+
+Status LevelDbBundleLoader::FlushIfLarger(size_t min_bytes) {
+  // An empty batch still has a small header.
+  leveldb::WriteBatch empty;
+  if (batch_.ApproximateSize() <= empty.ApproximateSize() ||
+      batch_.ApproximateSize() < min_bytes) {
+    return Status::OK();
+  }
+
+  leveldb::Status status =
+      db_->Write(LevelDbTransaction::DefaultWriteOptions(), &batch_);
+  batch_.Clear();
+  return ConvertStatus(status);
+}
+
+Status LevelDbBundleLoader::UpdateTargetGlobal(
+    const std::vector<BundledTarget>& targets) {
+  std::string key = LevelDbTargetGlobalKey::Key();
+  std::string bytes;
+  leveldb::Status found =
+      db_->Get(LevelDbTransaction::DefaultReadOptions(), key, &bytes);
+  if (!found.ok() && !found.IsNotFound()) {
+    return ConvertStatus(found);
+  }
+
+  TargetId highest_target_id = 0;
+  ListenSequenceNumber highest_sequence_number = 0;
+  TimestampProto last_remote_snapshot_version{};
+  int32_t target_count = 0;
+
+  Reader reader{bytes};
+  while (reader.ReadTag()) {
+    switch (reader.field_number()) {
+      case firestore_client_TargetGlobal_highest_target_id_tag:
+        highest_target_id = static_cast<TargetId>(reader.ReadInteger());
+        break;
+      case firestore_client_TargetGlobal_highest_listen_sequence_number_tag:
+        highest_sequence_number = reader.ReadInteger();
+        break;
+      case firestore_client_TargetGlobal_last_remote_snapshot_version_tag:
+        last_remote_snapshot_version = ReadTimestampProto(&reader);
+        break;
+      case firestore_client_TargetGlobal_target_count_tag:
+        target_count = static_cast<int32_t>(reader.ReadInteger());
+        break;
+      default:
+        reader.SkipField();
+    }
+  }
+  if (!reader.status().ok()) return reader.status();
+
+  for (const BundledTarget& target : targets) {
+    highest_target_id = std::max(highest_target_id, target.target_id);
+    highest_sequence_number =
+        std::max(highest_sequence_number, target.sequence_number);
+  }
+  target_count += static_cast<int32_t>(targets.size());
+
+  StringWriter writer;
+  writer.WriteTag(PB_WT_VARINT,
+                  firestore_client_TargetGlobal_highest_target_id_tag);
+  writer.WriteInteger(highest_target_id);
+  if (highest_sequence_number != 0) {
+    writer.WriteTag(
+        PB_WT_VARINT,
+        firestore_client_TargetGlobal_highest_listen_sequence_number_tag);
+    writer.WriteInteger(highest_sequence_number);
+  }
+  if (last_remote_snapshot_version.seconds != 0 ||
+      last_remote_snapshot_version.nanos != 0) {
+    WriteTimestampProto(
+        &writer, firestore_client_TargetGlobal_last_remote_snapshot_version_tag,
+        last_remote_snapshot_version);
+  }
+  writer.WriteTag(PB_WT_VARINT, firestore_client_TargetGlobal_target_count_tag);
+  writer.WriteInteger(target_count);
+
+  batch_.Put(key, writer.Release());
+  return Status::OK();
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
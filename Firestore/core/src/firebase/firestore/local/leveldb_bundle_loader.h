@@ -0,0 +1,190 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_BUNDLE_LOADER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_BUNDLE_LOADER_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
+#include "leveldb/db.h"
+#include "leveldb/write_batch.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Builds a bundle: a set of documents, and optionally the queries they were
+ * fetched for, that `LevelDbBundleLoader` can import into the local cache in
+ * bulk, such as a seed dataset shipped with an app.
+ *
+ * A bundle is encoded as a protocol buffer message with the fields
+ *
+ *     google.protobuf.Timestamp read_time = 1;
+ *     repeated firestore.client.MaybeDocument documents = 2;
+ *     repeated BundledQuery queries = 3;
+ *
+ * where the documents are encoded as the remote document cache stores them,
+ * and
+ *
+ *     message BundledQuery {
+ *       // The canonical ID of the query the target listens to.
+ *       string canonical_id = 1;
+ *       firestore.client.Target target = 2;
+ *       // The slash-separated paths of the documents matching the target.
+ *       repeated string document_paths = 3;
+ *     }
+ *
+ * The read time is when the documents were read from the backend, and must
+ * precede them.
+ */
+class BundleWriter {
+ public:
+  explicit BundleWriter(const model::SnapshotVersion& read_time);
+
+  /** Adds a document, given as an encoded `firestore.client.MaybeDocument`. */
+  void AddDocument(absl::string_view encoded_document);
+
+  /**
+   * Adds the target listening to the query with the given canonical ID, given
+   * as an encoded `firestore.client.Target`, along with the keys of the
+   * documents matching it.
+   */
+  void AddQuery(absl::string_view canonical_id,
+                absl::string_view encoded_target,
+                const std::vector<model::DocumentKey>& documents);
+
+  /** Returns the encoded bundle, leaving this writer empty. */
+  std::string Release();
+
+ private:
+  nanopb::StringWriter writer_;
+};
+
+/**
+ * Imports bundles built by `BundleWriter` into a LevelDB database, writing
+ * the remote document cache, collection parent index and query cache rows
+ * directly in large write batches.
+ *
+ * Documents are stored exactly as encoded in the bundle, so importing one only
+ * requires reading its name. The rows of each query's target are written as
+ * `LevelDbQueryCache` would write them, and the target metadata is updated to
+ * account for them.
+ *
+ * The loader bypasses the in-memory state kept by the caches, so it must not
+ * run concurrently with transactions, and the query cache must reload its
+ * metadata afterwards.
+ */
+class LevelDbBundleLoader {
+ public:
+  /** The number of bytes of changes written to LevelDB at a time. */
+  static constexpr size_t kDefaultBatchSizeBytes = 4 * 1024 * 1024;
+
+  struct Result {
+    size_t document_count = 0;
+    size_t query_count = 0;
+
+    /**
+     * The documents which are in collections with field indexes, and need to
+     * be added to them by the caller. Adding documents to field indexes
+     * requires decoding them, which the loader otherwise avoids.
+     */
+    std::vector<model::DocumentKey> documents_to_index;
+  };
+
+  LevelDbBundleLoader(leveldb::DB* db, model::DatabaseId database_id);
+
+  void set_batch_size_bytes(size_t batch_size_bytes) {
+    batch_size_bytes_ = batch_size_bytes;
+  }
+
+  /**
+   * Imports the given bundle. The whole bundle is validated before anything is
+   * written, so a malformed bundle, one for another database or one with
+   * targets that are already in the cache is rejected without changing the
+   * cache. The rows of the targets and the target metadata are written
+   * together, last, so loading the same bundle again after being interrupted
+   * completes the import.
+   */
+  util::StatusOr<Result> Load(absl::string_view bundle);
+
+ private:
+  /** A target read from a bundle, along with the documents matching it. */
+  struct BundledTarget {
+    std::string canonical_id;
+    std::string encoded_target;
+    model::TargetId target_id = 0;
+    model::ListenSequenceNumber sequence_number = 0;
+    std::vector<model::DocumentKey> documents;
+  };
+
+  /**
+   * Reads the bundle, calling `on_document` with the key and encoding of each
+   * document and `on_target` with each target, in order. Stops at the first
+   * error or the first callback that returns a status that isn't ok.
+   */
+  template <typename DocumentCallback, typename TargetCallback>
+  util::Status Read(absl::string_view bundle,
+                    model::SnapshotVersion* read_time,
+                    const DocumentCallback& on_document,
+                    const TargetCallback& on_target);
+
+  util::StatusOr<model::DocumentKey> ParseDocumentPath(
+      absl::string_view path) const;
+  util::StatusOr<model::DocumentKey> ParseDocumentName(
+      absl::string_view name) const;
+
+  util::Status AddDocument(const model::DocumentKey& key,
+                           absl::string_view encoded_document,
+                           const model::SnapshotVersion& read_time,
+                           Result* result);
+  void AddTargetDocuments(const BundledTarget& target);
+
+  /** Whether any field indexes are defined on the given collection. */
+  bool HasFieldIndexes(const model::ResourcePath& collection);
+
+  /** Writes the batch if it holds at least `min_bytes` of changes. */
+  util::Status FlushIfLarger(size_t min_bytes);
+
+  /** Appends the updated target metadata row to the batch. */
+  util::Status UpdateTargetGlobal(const std::vector<BundledTarget>& targets);
+
+  leveldb::DB* db_ = nullptr;
+  model::DatabaseId database_id_;
+  std::string name_prefix_;
+  size_t batch_size_bytes_ = kDefaultBatchSizeBytes;
+
+  leveldb::WriteBatch batch_;
+  std::map<model::ResourcePath, bool> collections_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_BUNDLE_LOADER_H_
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_compaction_tracker.h"
+
+#include <iterator>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+constexpr size_t LevelDbCompactionTracker::kMinDeletesToCompact;
+
+void LevelDbCompactionTracker::RecordDeletes(
+    const std::vector<absl::string_view>& keys) {
+  // Keys are ordered by table first, so the keys of each table are adjacent.
+  auto run_begin = keys.begin();
+  while (run_begin != keys.end()) {
+    absl::string_view table = TablePrefix(*run_begin);
+    size_t deletes = 1;
+    auto run_end = std::next(run_begin);
+    while (run_end != keys.end() && !table.empty() &&
+           TablePrefix(*run_end) == table) {
+      ++run_end;
+      ++deletes;
+    }
+    absl::string_view last = *std::prev(run_end);
+
+    if (!table.empty()) {
+      auto found = by_table_.find(std::string{table});
+      if (found == by_table_.end()) {
+        DeletedRange deleted;
+        deleted.range = KeyRange{std::string{*run_begin}, std::string{last}};
+        deleted.deletes = deletes;
+        by_table_.emplace(std::string{table}, std::move(deleted));
+      } else {
+        DeletedRange& deleted = found->second;
+        if (*run_begin < deleted.range.begin) {
+          deleted.range.begin = std::string{*run_begin};
+        }
+        if (deleted.range.end < last) deleted.range.end = std::string{last};
+        deleted.deletes += deletes;
+      }
+    }
+    run_begin = run_end;
+  }
+}
+
+bool LevelDbCompactionTracker::compaction_due() const {
+  for (const auto& entry : by_table_) {
+    if (entry.second.deletes >= kMinDeletesToCompact) return true;
+  }
+  return false;
+}
+
+std::vector<LevelDbCompactionTracker::KeyRange>
+LevelDbCompactionTracker::TakeRangesToCompact() {
+  std::vector<KeyRange> result;
+  for (auto iter = by_table_.begin(); iter != by_table_.end();) {
+    if (iter->second.deletes >= kMinDeletesToCompact) {
+      result.push_back(std::move(iter->second.range));
+      iter = by_table_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  return result;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_COMPACTION_TRACKER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_COMPACTION_TRACKER_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Keeps track of the keys deleted from each table, so that the ranges where
+ * many rows were deleted, e.g. by garbage collection, can be compacted.
+ *
+ * LevelDB deletes a row by writing a tombstone over it, which scans have to
+ * step over until a compaction that covers the row drops both. Compactions
+ * LevelDB triggers on its own are driven by the amount written, so after a
+ * large delete the tombstones can linger for a long time.
+ */
+class LevelDbCompactionTracker {
+ public:
+  /** The number of deletes from a table that make compacting it worthwhile. */
+  static constexpr size_t kMinDeletesToCompact = 1000;
+
+  /** A range of keys to compact, including both ends. */
+  struct KeyRange {
+    std::string begin;
+    std::string end;
+  };
+
+  /** Records that the given keys, in order, were deleted. */
+  void RecordDeletes(const std::vector<absl::string_view>& keys);
+
+  /** Returns true if some table had enough deletes to compact it. */
+  bool compaction_due() const;
+
+  /**
+   * Returns the ranges spanning the deleted keys of each table that had
+   * enough of them, and forgets those deletes.
+   */
+  std::vector<KeyRange> TakeRangesToCompact();
+
+ private:
+  struct DeletedRange {
+    KeyRange range;
+    size_t deletes = 0;
+  };
+
+  /** The deleted range of each table, by the table's key prefix. */
+  std::map<std::string, DeletedRange> by_table_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_COMPACTION_TRACKER_H_
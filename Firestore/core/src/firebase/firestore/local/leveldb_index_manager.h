@@ -21,11 +21,15 @@
 #error "For now, this file must only be included by ObjC source files."
 #endif  // !defined(__OBJC__)
 
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 
 @class FSTLevelDB;
@@ -47,18 +51,72 @@ class LevelDbIndexManager : public IndexManager {
   std::vector<model::ResourcePath> GetCollectionParents(
       const std::string& collection_id) override;
 
+  bool HasFieldIndex(const model::ResourcePath& collection_path,
+                     const model::FieldPath& field_path) override;
+
+  bool AddFieldIndex(const model::ResourcePath& collection_path,
+                     const model::FieldPath& field_path) override;
+
+  void AddToFieldIndexes(const model::DocumentKey& key,
+                         const model::ObjectValue& data) override;
+
+  void RemoveFromFieldIndexes(const model::DocumentKey& key) override;
+
+  model::DocumentKeySet GetDocumentsMatchingFieldIndex(
+      const model::ResourcePath& collection_path,
+      const FieldIndexScan& scan) override;
+
+  void ScanFieldIndex(const model::ResourcePath& collection_path,
+                      const FieldIndexScan& scan,
+                      const FieldIndexVisitor& visitor) override;
+
+  /**
+   * Drops the in-memory copies of index entries, which are reloaded from
+   * persistence as needed.
+   */
+  void TrimMemory();
+
  private:
+  /**
+   * Returns the fields indexed for the given collection, reading them from
+   * persistence the first time the collection is seen.
+   */
+  const std::vector<model::FieldPath>& GetFieldIndexes(
+      const model::ResourcePath& collection_path);
+
   // This instance is owned by FSTLevelDB; avoid a retain cycle.
   __weak FSTLevelDB* db_;
 
   /**
    * An in-memory copy of the index entries we've already written since the SDK
-   * launched. Used to avoid re-writing the same entry repeatedly.
+   * launched, or read from persistence. Used to avoid re-writing the same entry
+   * repeatedly.
    *
-   * This is *NOT* a complete cache of what's in persistence and so can never
-   * be used to satisfy reads.
+   * The entries of a collection ID are only complete, and so can only be used
+   * to satisfy reads, once it's in `loaded_collection_ids_`.
    */
   MemoryCollectionParentIndex collection_parents_cache_;
+
+  /**
+   * The collection IDs whose parents have all been read from persistence into
+   * `collection_parents_cache_`. Parents are only ever added through this
+   * instance afterwards, so the cache stays complete for them.
+   */
+  std::unordered_set<std::string> loaded_collection_ids_;
+
+  /**
+   * Guards the collection parents cache, which reads run against a snapshot
+   * may fill off the worker queue.
+   */
+  std::mutex collection_parents_mutex_;
+
+  /**
+   * A cache of the fields indexed for each collection. Unlike
+   * collection_parents_cache_, each entry is complete once loaded because
+   * field indexes are only added through this instance.
+   */
+  std::map<model::ResourcePath, std::vector<model::FieldPath>>
+      field_indexes_cache_;
 };
 
 }  // namespace local
@@ -16,9 +16,11 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_index_manager.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
@@ -33,6 +35,11 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::FieldPath;
+using model::FieldValue;
+using model::ObjectValue;
 using model::ResourcePath;
 
 LevelDbIndexManager::LevelDbIndexManager(FSTLevelDB* db) : db_(db) {
@@ -42,7 +49,12 @@ void LevelDbIndexManager::AddToCollectionParentIndex(
     const ResourcePath& collection_path) {
   HARD_ASSERT(collection_path.size() % 2 == 1, "Expected a collection path.");
 
-  if (collection_parents_cache_.Add(collection_path)) {
+  bool added;
+  {
+    std::lock_guard<std::mutex> lock{collection_parents_mutex_};
+    added = collection_parents_cache_.Add(collection_path);
+  }
+  if (added) {
     std::string collection_id = collection_path.last_segment();
     ResourcePath parent_path = collection_path.PopLast();
 
@@ -55,6 +67,13 @@ void LevelDbIndexManager::AddToCollectionParentIndex(
 
 std::vector<ResourcePath> LevelDbIndexManager::GetCollectionParents(
     const std::string& collection_id) {
+  {
+    std::lock_guard<std::mutex> lock{collection_parents_mutex_};
+    if (loaded_collection_ids_.count(collection_id) != 0) {
+      return collection_parents_cache_.GetEntries(collection_id);
+    }
+  }
+
   std::vector<ResourcePath> results;
 
   auto index_iterator = db_.currentTransaction->NewIterator();
@@ -71,9 +90,162 @@ std::vector<ResourcePath> LevelDbIndexManager::GetCollectionParents(
 
     results.push_back(row_key.parent());
   }
+
+  std::lock_guard<std::mutex> lock{collection_parents_mutex_};
+  for (const ResourcePath& parent : results) {
+    collection_parents_cache_.Add(parent.Append(collection_id));
+  }
+  loaded_collection_ids_.insert(collection_id);
   return results;
 }
 
+const std::vector<FieldPath>& LevelDbIndexManager::GetFieldIndexes(
+    const ResourcePath& collection_path) {
+  auto found = field_indexes_cache_.find(collection_path);
+  if (found != field_indexes_cache_.end()) {
+    return found->second;
+  }
+
+  std::vector<FieldPath>& fields = field_indexes_cache_[collection_path];
+
+  auto index_iterator = db_.currentTransaction->NewIterator();
+  std::string index_prefix = LevelDbFieldIndexKey::KeyPrefix(collection_path);
+  LevelDbFieldIndexKey row_key;
+  for (index_iterator->Seek(index_prefix); index_iterator->Valid();
+       index_iterator->Next()) {
+    // Indexes on subcollections share the prefix but sort after the
+    // collection's own indexes.
+    if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
+        !row_key.Decode(index_iterator->key()) ||
+        row_key.collection() != collection_path) {
+      break;
+    }
+
+    fields.push_back(row_key.field_path());
+  }
+  return fields;
+}
+
+bool LevelDbIndexManager::HasFieldIndex(const ResourcePath& collection_path,
+                                        const FieldPath& field_path) {
+  const std::vector<FieldPath>& fields = GetFieldIndexes(collection_path);
+  return std::find(fields.begin(), fields.end(), field_path) != fields.end();
+}
+
+bool LevelDbIndexManager::AddFieldIndex(const ResourcePath& collection_path,
+                                        const FieldPath& field_path) {
+  HARD_ASSERT(collection_path.size() % 2 == 1, "Expected a collection path.");
+
+  if (!HasFieldIndex(collection_path, field_path)) {
+    std::string key = LevelDbFieldIndexKey::Key(collection_path, field_path);
+    std::string empty_buffer;
+    db_.currentTransaction->Put(key, empty_buffer);
+    field_indexes_cache_[collection_path].push_back(field_path);
+  }
+  return true;
+}
+
+void LevelDbIndexManager::AddToFieldIndexes(const DocumentKey& key,
+                                            const ObjectValue& data) {
+  const std::vector<FieldPath>& fields = GetFieldIndexes(key.path().PopLast());
+  if (fields.empty()) return;
+
+  RemoveFromFieldIndexes(key);
+
+  for (const FieldPath& field_path : fields) {
+    absl::optional<FieldValue> value = data.Get(field_path);
+    if (!value) continue;
+
+    std::string encoded_value = EncodeFieldIndexValue(*value);
+    std::string empty_buffer;
+    db_.currentTransaction->Put(
+        LevelDbFieldIndexEntryKey::Key(field_path, encoded_value, key),
+        empty_buffer);
+    db_.currentTransaction->Put(
+        LevelDbDocumentFieldIndexEntryKey::Key(key, field_path),
+        std::move(encoded_value));
+  }
+}
+
+void LevelDbIndexManager::RemoveFromFieldIndexes(const DocumentKey& key) {
+  if (GetFieldIndexes(key.path().PopLast()).empty()) return;
+
+  std::vector<std::string> to_delete;
+
+  auto index_iterator = db_.currentTransaction->NewIterator();
+  std::string index_prefix = LevelDbDocumentFieldIndexEntryKey::KeyPrefix(key);
+  LevelDbDocumentFieldIndexEntryKey row_key;
+  for (index_iterator->Seek(index_prefix); index_iterator->Valid();
+       index_iterator->Next()) {
+    // Entries for documents in subcollections share the prefix but sort after
+    // the document's own entries.
+    if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
+        !row_key.Decode(index_iterator->key()) ||
+        row_key.document_key() != key) {
+      break;
+    }
+
+    to_delete.push_back(LevelDbFieldIndexEntryKey::Key(
+        row_key.field_path(), index_iterator->value(), key));
+    to_delete.emplace_back(index_iterator->key());
+  }
+
+  for (const std::string& ldb_key : to_delete) {
+    db_.currentTransaction->Delete(ldb_key);
+  }
+}
+
+DocumentKeySet LevelDbIndexManager::GetDocumentsMatchingFieldIndex(
+    const ResourcePath& collection_path, const FieldIndexScan& scan) {
+  DocumentKeySet results;
+  ScanFieldIndex(collection_path, scan,
+                 [&results](absl::string_view, const DocumentKey& key) {
+                   results = results.insert(key);
+                   return true;
+                 });
+  return results;
+}
+
+void LevelDbIndexManager::ScanFieldIndex(const ResourcePath& collection_path,
+                                         const FieldIndexScan& scan,
+                                         const FieldIndexVisitor& visitor) {
+  HARD_ASSERT(HasFieldIndex(collection_path, scan.field_path()),
+              "No index on %s for collection %s",
+              scan.field_path().CanonicalString(),
+              collection_path.CanonicalString());
+
+  auto index_iterator = db_.currentTransaction->NewIterator();
+  std::string index_prefix =
+      LevelDbFieldIndexEntryKey::KeyPrefix(collection_path, scan.field_path());
+  LevelDbFieldIndexEntryKey row_key;
+
+  // The ranges are in index order and don't overlap, so visiting them one
+  // after the other keeps the entries in index order.
+  for (const FieldIndexScan::Range& range : scan.ranges()) {
+    for (index_iterator->Seek(LevelDbFieldIndexEntryKey::KeyPrefix(
+             collection_path, scan.field_path(), range.lower_bound()));
+         index_iterator->Valid(); index_iterator->Next()) {
+      if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
+          !row_key.Decode(index_iterator->key()) ||
+          range.IsPastUpperBound(row_key.encoded_value())) {
+        break;
+      }
+      if (!visitor(row_key.encoded_value(), row_key.document_key())) {
+        return;
+      }
+    }
+  }
+}
+
+void LevelDbIndexManager::TrimMemory() {
+  {
+    std::lock_guard<std::mutex> lock{collection_parents_mutex_};
+    collection_parents_cache_.Clear();
+    loaded_collection_ids_.clear();
+  }
+  field_indexes_cache_.clear();
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -16,11 +16,14 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 
+#include <deque>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
 #include "absl/base/attributes.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
@@ -36,8 +39,11 @@ namespace local {
 namespace {
 
 const char* kVersionGlobalTable = "version";
+const char* kMigrationProgressTable = "migration_progress";
+const char* kDocumentDictionaryTable = "document_dictionary";
 const char* kMutationsTable = "mutation";
 const char* kDocumentMutationsTable = "document_mutation";
+const char* kCollectionMutationsTable = "collection_mutation";
 const char* kMutationQueuesTable = "mutation_queue";
 const char* kTargetGlobalTable = "target_global";
 const char* kTargetsTable = "target";
@@ -46,6 +52,12 @@ const char* kTargetDocumentsTable = "target_document";
 const char* kDocumentTargetsTable = "document_target";
 const char* kRemoteDocumentsTable = "remote_document";
 const char* kCollectionParentsTable = "collection_parent";
+const char* kCollectionGroupDocumentsTable = "collection_group_document";
+const char* kRemoteDocumentReadTimesTable = "remote_document_read_time";
+const char* kDocumentReadTimesTable = "document_read_time";
+const char* kFieldIndexesTable = "field_index";
+const char* kFieldIndexEntriesTable = "field_index_entry";
+const char* kDocumentFieldIndexEntriesTable = "document_field_index_entry";
 
 /**
  * Labels for the components of keys. These serve to make keys self-describing.
@@ -96,6 +108,15 @@ enum ComponentLabel {
    */
   CollectionId = 14,
 
+  /** A component containing a field path, in canonical form. */
+  FieldPath = 15,
+
+  /** A component containing a field value, as encoded for a field index. */
+  IndexValue = 16,
+
+  /** A component containing the snapshot version a document was read at. */
+  ReadTime = 17,
+
   /**
    * A path segment describes just a single segment in a resource path. Path
    * segments that occur sequentially in a key represent successive segments in
@@ -170,6 +191,26 @@ class Reader {
     return ReadLabeledString(ComponentLabel::CollectionId);
   }
 
+  /**
+   * Reads a field path component from the key.
+   *
+   * If the read is unsuccessful or the field path is empty, returns an empty
+   * FieldPath and fails the Reader.
+   */
+  model::FieldPath ReadFieldPath();
+
+  std::string ReadIndexValue() {
+    return ReadLabeledString(ComponentLabel::IndexValue);
+  }
+
+  /**
+   * Reads a read time component from the key.
+   *
+   * If the read is unsuccessful or the nanoseconds are out of range, returns
+   * SnapshotVersion::None() and fails the Reader.
+   */
+  model::SnapshotVersion ReadReadTime();
+
   /**
    * Reads component labels and strings from the key until it finds a component
    * label other than ComponentLabel::PathSegment (or the key is exhausted).
@@ -191,6 +232,14 @@ class Reader {
    */
   DocumentKey ReadDocumentKey();
 
+  /**
+   * Like ReadResourcePath, but stores just views of the segments, pointing
+   * into the key where possible and into `unescaped` where not. Fails the
+   * Reader unless the segments form a valid document path.
+   */
+  void ReadDocumentPathView(std::vector<absl::string_view>* segments,
+                            std::deque<std::string>* unescaped);
+
   /**
    * Reads a terminator component from the key.
    *
@@ -408,6 +457,60 @@ DocumentKey Reader::ReadDocumentKey() {
   return DocumentKey{};
 }
 
+void Reader::ReadDocumentPathView(std::vector<absl::string_view>* segments,
+                                  std::deque<std::string>* unescaped) {
+  segments->clear();
+  unescaped->clear();
+  while (!empty()) {
+    leveldb::Slice saved_position = src_;
+    if (!ReadComponentLabelMatching(ComponentLabel::PathSegment)) {
+      src_ = saved_position;
+      break;
+    }
+
+    absl::string_view tmp = MakeStringView(src_);
+    absl::string_view segment;
+    if (OrderedCode::ReadStringView(&tmp, &segment)) {
+      src_ = MakeSlice(tmp);
+      segments->push_back(segment);
+    } else {
+      std::string decoded = ReadString();
+      if (!ok_) break;
+      unescaped->push_back(std::move(decoded));
+      segments->push_back(unescaped->back());
+    }
+  }
+
+  // Mirror the validation of ReadDocumentKey.
+  if (segments->empty() || segments->size() % 2 != 0) {
+    Fail();
+  }
+}
+
+model::SnapshotVersion Reader::ReadReadTime() {
+  if (!ReadComponentLabelMatching(ComponentLabel::ReadTime)) {
+    Fail();
+  }
+  int64_t seconds = ReadSignedNumIncreasing();
+  int32_t nanos = ReadInt32();
+  if (ok_ && nanos >= 0 && nanos < 1000000000) {
+    return model::SnapshotVersion{Timestamp{seconds, nanos}};
+  }
+
+  Fail();
+  return model::SnapshotVersion::None();
+}
+
+model::FieldPath Reader::ReadFieldPath() {
+  std::string canonical = ReadLabeledString(ComponentLabel::FieldPath);
+  if (ok_ && !canonical.empty()) {
+    return model::FieldPath::FromServerFormat(canonical);
+  }
+
+  Fail();
+  return model::FieldPath{};
+}
+
 /**
  * Returns a base64-encoded string for an invalid key, used for debug-friendly
  * description text.
@@ -485,6 +588,27 @@ std::string Reader::Describe() {
         absl::StrAppend(&description, " collection_id=", collection_id);
       }
 
+    } else if (label == ComponentLabel::FieldPath) {
+      model::FieldPath field_path = ReadFieldPath();
+      if (ok_) {
+        absl::StrAppend(&description,
+                        " field_path=", field_path.CanonicalString());
+      }
+
+    } else if (label == ComponentLabel::IndexValue) {
+      std::string value = ReadIndexValue();
+      if (ok_) {
+        absl::StrAppend(&description,
+                        " index_value=", absl::BytesToHexString(value));
+      }
+
+    } else if (label == ComponentLabel::ReadTime) {
+      model::SnapshotVersion read_time = ReadReadTime();
+      if (ok_) {
+        absl::StrAppend(&description,
+                        " read_time=", read_time.timestamp().ToString());
+      }
+
     } else {
       absl::StrAppend(&description, " unknown label=", static_cast<int>(label));
       Fail();
@@ -504,12 +628,26 @@ std::string Reader::Describe() {
 
 class Writer {
  public:
-  std::string result() const {
-    return dest_;
+  Writer() : dest_{&result_} {
+  }
+
+  /** Creates a Writer that appends to `dest` instead of to its own result. */
+  explicit Writer(std::string* dest) : dest_{dest} {
+  }
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  /**
+   * Returns the key written so far, taking ownership of it. Only valid for a
+   * Writer that doesn't append to a caller's string.
+   */
+  std::string result() {
+    return std::move(result_);
   }
 
   void WriteTerminator() {
-    OrderedCode::WriteSignedNumIncreasing(&dest_, ComponentLabel::Terminator);
+    OrderedCode::WriteSignedNumIncreasing(dest_, ComponentLabel::Terminator);
   }
 
   void WriteTableName(const char* table_name) {
@@ -536,6 +674,23 @@ class Writer {
     WriteLabeledString(ComponentLabel::CollectionId, collection_id);
   }
 
+  void WriteFieldPath(const model::FieldPath& field_path) {
+    WriteLabeledString(ComponentLabel::FieldPath,
+                       field_path.CanonicalString());
+  }
+
+  void WriteIndexValue(absl::string_view encoded_value) {
+    WriteLabeledString(ComponentLabel::IndexValue, encoded_value);
+  }
+
+  void WriteReadTime(const model::SnapshotVersion& read_time) {
+    WriteComponentLabel(ComponentLabel::ReadTime);
+    OrderedCode::WriteSignedNumIncreasing(dest_,
+                                          read_time.timestamp().seconds());
+    OrderedCode::WriteSignedNumIncreasing(dest_,
+                                          read_time.timestamp().nanoseconds());
+  }
+
   /**
    * For each segment in the given resource path writes a
    * ComponentLabel::PathSegment component label and a string containing the
@@ -544,14 +699,14 @@ class Writer {
   void WriteResourcePath(const ResourcePath& path) {
     for (const auto& segment : path) {
       WriteComponentLabel(ComponentLabel::PathSegment);
-      OrderedCode::WriteString(&dest_, segment);
+      OrderedCode::WriteString(dest_, segment);
     }
   }
 
  private:
   /** Writes a component label to the given key destination. */
   void WriteComponentLabel(ComponentLabel label) {
-    OrderedCode::WriteSignedNumIncreasing(&dest_, label);
+    OrderedCode::WriteSignedNumIncreasing(dest_, label);
   }
 
   /**
@@ -559,7 +714,7 @@ class Writer {
    */
   void WriteLabeledInt32(ComponentLabel label, int32_t value) {
     WriteComponentLabel(label);
-    OrderedCode::WriteSignedNumIncreasing(&dest_, value);
+    OrderedCode::WriteSignedNumIncreasing(dest_, value);
   }
 
   /**
@@ -568,10 +723,11 @@ class Writer {
    */
   void WriteLabeledString(ComponentLabel label, absl::string_view value) {
     WriteComponentLabel(label);
-    OrderedCode::WriteString(&dest_, value);
+    OrderedCode::WriteString(dest_, value);
   }
 
-  std::string dest_;
+  std::string result_;
+  std::string* dest_;
 };
 
 }  // namespace
@@ -593,6 +749,17 @@ std::string DescribeKey(const char* key) {
   return DescribeKey(leveldb::Slice{key});
 }
 
+absl::string_view TablePrefix(absl::string_view key) {
+  absl::string_view rest = key;
+  int64_t label = 0;
+  if (!OrderedCode::ReadSignedNumIncreasing(&rest, &label) ||
+      label != ComponentLabel::TableName ||
+      !OrderedCode::ReadString(&rest, nullptr)) {
+    return {};
+  }
+  return key.substr(0, key.size() - rest.size());
+}
+
 std::string LevelDbVersionKey::Key() {
   Writer writer;
   writer.WriteTableName(kVersionGlobalTable);
@@ -600,6 +767,38 @@ std::string LevelDbVersionKey::Key() {
   return writer.result();
 }
 
+std::string LevelDbMigrationProgressKey::Key() {
+  Writer writer;
+  writer.WriteTableName(kMigrationProgressTable);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbMigrationProgressKey::EncodeProgress(
+    int64_t version, int64_t scan, absl::string_view last_key) {
+  std::string encoded;
+  OrderedCode::WriteSignedNumIncreasing(&encoded, version);
+  OrderedCode::WriteSignedNumIncreasing(&encoded, scan);
+  OrderedCode::WriteString(&encoded, last_key);
+  return encoded;
+}
+
+bool LevelDbMigrationProgressKey::DecodeProgress(absl::string_view value,
+                                                 int64_t* version,
+                                                 int64_t* scan,
+                                                 std::string* last_key) {
+  return OrderedCode::ReadSignedNumIncreasing(&value, version) &&
+         OrderedCode::ReadSignedNumIncreasing(&value, scan) &&
+         OrderedCode::ReadString(&value, last_key) && value.empty();
+}
+
+std::string LevelDbDocumentDictionaryKey::Key() {
+  Writer writer;
+  writer.WriteTableName(kDocumentDictionaryTable);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
 std::string LevelDbMutationKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kMutationsTable);
@@ -676,6 +875,77 @@ bool LevelDbDocumentMutationKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+bool LevelDbPathView::HasPrefix(const ResourcePath& prefix) const {
+  if (prefix.size() > segments_.size()) return false;
+  for (size_t i = 0; i < prefix.size(); ++i) {
+    if (segments_[i] != prefix[i]) return false;
+  }
+  return true;
+}
+
+bool LevelDbPathView::Equals(const ResourcePath& path) const {
+  return path.size() == segments_.size() && HasPrefix(path);
+}
+
+ResourcePath LevelDbPathView::ToResourcePath() const {
+  return ResourcePath{segments_.begin(), segments_.end()};
+}
+
+bool LevelDbDocumentMutationKeyView::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kDocumentMutationsTable);
+  user_id_ = reader.ReadUserId();
+  reader.ReadDocumentPathView(&path_.segments_, &path_.unescaped_);
+  batch_id_ = reader.ReadBatchId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix(absl::string_view user_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::KeyPrefix(
+    absl::string_view user_id, const ResourcePath& collection_path) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  writer.WriteResourcePath(collection_path);
+  return writer.result();
+}
+
+std::string LevelDbCollectionMutationKey::Key(
+    absl::string_view user_id,
+    const ResourcePath& collection_path,
+    model::BatchId batch_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionMutationsTable);
+  writer.WriteUserId(user_id);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteBatchId(batch_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbCollectionMutationKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCollectionMutationsTable);
+  user_id_ = reader.ReadUserId();
+  collection_path_ = reader.ReadResourcePath();
+  batch_id_ = reader.ReadBatchId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbMutationQueueKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kMutationQueuesTable);
@@ -781,12 +1051,19 @@ std::string LevelDbTargetDocumentKey::KeyPrefix(model::TargetId target_id) {
 
 std::string LevelDbTargetDocumentKey::Key(model::TargetId target_id,
                                           const DocumentKey& document_key) {
-  Writer writer;
+  std::string result;
+  AppendKey(&result, target_id, document_key);
+  return result;
+}
+
+void LevelDbTargetDocumentKey::AppendKey(std::string* dest,
+                                         model::TargetId target_id,
+                                         const DocumentKey& document_key) {
+  Writer writer{dest};
   writer.WriteTableName(kTargetDocumentsTable);
   writer.WriteTargetId(target_id);
   writer.WriteResourcePath(document_key.path());
   writer.WriteTerminator();
-  return writer.result();
 }
 
 bool LevelDbTargetDocumentKey::Decode(absl::string_view key) {
@@ -814,12 +1091,19 @@ std::string LevelDbDocumentTargetKey::KeyPrefix(
 
 std::string LevelDbDocumentTargetKey::Key(const DocumentKey& document_key,
                                           model::TargetId target_id) {
-  Writer writer;
+  std::string result;
+  AppendKey(&result, document_key, target_id);
+  return result;
+}
+
+void LevelDbDocumentTargetKey::AppendKey(std::string* dest,
+                                         const DocumentKey& document_key,
+                                         model::TargetId target_id) {
+  Writer writer{dest};
   writer.WriteTableName(kDocumentTargetsTable);
   writer.WriteResourcePath(document_key.path());
   writer.WriteTargetId(target_id);
   writer.WriteTerminator();
-  return writer.result();
 }
 
 std::string LevelDbDocumentTargetKey::SentinelKey(
@@ -866,12 +1150,23 @@ std::string LevelDbRemoteDocumentKey::KeyPrefix(
   return writer.result();
 }
 
+std::string LevelDbRemoteDocumentKey::KeyPrefixEnd(
+    const ResourcePath& resource_path) {
+  return util::PrefixSuccessor(KeyPrefix(resource_path));
+}
+
 std::string LevelDbRemoteDocumentKey::Key(const DocumentKey& key) {
-  Writer writer;
+  std::string result;
+  AppendKey(&result, key);
+  return result;
+}
+
+void LevelDbRemoteDocumentKey::AppendKey(std::string* dest,
+                                         const DocumentKey& key) {
+  Writer writer{dest};
   writer.WriteTableName(kRemoteDocumentsTable);
   writer.WriteResourcePath(key.path());
   writer.WriteTerminator();
-  return writer.result();
 }
 
 bool LevelDbRemoteDocumentKey::Decode(absl::string_view key) {
@@ -882,6 +1177,14 @@ bool LevelDbRemoteDocumentKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+bool LevelDbRemoteDocumentKeyView::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kRemoteDocumentsTable);
+  reader.ReadDocumentPathView(&path_.segments_, &path_.unescaped_);
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbCollectionParentKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kCollectionParentsTable);
@@ -915,6 +1218,264 @@ bool LevelDbCollectionParentKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbCollectionGroupDocumentKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kCollectionGroupDocumentsTable);
+  return writer.result();
+}
+
+std::string LevelDbCollectionGroupDocumentKey::KeyPrefix(
+    absl::string_view collection_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionGroupDocumentsTable);
+  writer.WriteCollectionId(collection_id);
+  return writer.result();
+}
+
+std::string LevelDbCollectionGroupDocumentKey::Key(
+    const DocumentKey& document_key) {
+  std::string result;
+  AppendKey(&result, document_key);
+  return result;
+}
+
+void LevelDbCollectionGroupDocumentKey::AppendKey(
+    std::string* dest, const DocumentKey& document_key) {
+  const ResourcePath& path = document_key.path();
+  Writer writer{dest};
+  writer.WriteTableName(kCollectionGroupDocumentsTable);
+  writer.WriteCollectionId(path[path.size() - 2]);
+  writer.WriteResourcePath(path);
+  writer.WriteTerminator();
+}
+
+bool LevelDbCollectionGroupDocumentKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCollectionGroupDocumentsTable);
+  collection_id_ = reader.ReadCollectionId();
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbRemoteDocumentReadTimeKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentReadTimesTable);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentReadTimeKey::KeyPrefix(
+    const ResourcePath& collection) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentReadTimesTable);
+  writer.WriteResourcePath(collection);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentReadTimeKey::KeyPrefix(
+    const ResourcePath& collection, const model::SnapshotVersion& read_time) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentReadTimesTable);
+  writer.WriteResourcePath(collection);
+  writer.WriteReadTime(read_time);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentReadTimeKey::Key(
+    const DocumentKey& document_key, const model::SnapshotVersion& read_time) {
+  std::string result;
+  AppendKey(&result, document_key, read_time);
+  return result;
+}
+
+void LevelDbRemoteDocumentReadTimeKey::AppendKey(
+    std::string* dest, const DocumentKey& document_key,
+    const model::SnapshotVersion& read_time) {
+  Writer writer{dest};
+  writer.WriteTableName(kRemoteDocumentReadTimesTable);
+  writer.WriteResourcePath(document_key.path().PopLast());
+  writer.WriteReadTime(read_time);
+  writer.WriteResourcePath(document_key.path());
+  writer.WriteTerminator();
+}
+
+bool LevelDbRemoteDocumentReadTimeKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kRemoteDocumentReadTimesTable);
+  collection_ = reader.ReadResourcePath();
+  read_time_ = reader.ReadReadTime();
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbDocumentReadTimeKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kDocumentReadTimesTable);
+  return writer.result();
+}
+
+std::string LevelDbDocumentReadTimeKey::Key(const DocumentKey& document_key) {
+  std::string result;
+  AppendKey(&result, document_key);
+  return result;
+}
+
+void LevelDbDocumentReadTimeKey::AppendKey(std::string* dest,
+                                           const DocumentKey& document_key) {
+  Writer writer{dest};
+  writer.WriteTableName(kDocumentReadTimesTable);
+  writer.WriteResourcePath(document_key.path());
+  writer.WriteTerminator();
+}
+
+std::string LevelDbDocumentReadTimeKey::EncodeReadTime(
+    const model::SnapshotVersion& read_time) {
+  std::string encoded;
+  OrderedCode::WriteSignedNumIncreasing(&encoded,
+                                        read_time.timestamp().seconds());
+  OrderedCode::WriteSignedNumIncreasing(&encoded,
+                                        read_time.timestamp().nanoseconds());
+  return encoded;
+}
+
+model::SnapshotVersion LevelDbDocumentReadTimeKey::DecodeReadTime(
+    absl::string_view value) {
+  int64_t seconds;
+  int64_t nanos;
+  if (!OrderedCode::ReadSignedNumIncreasing(&value, &seconds) ||
+      !OrderedCode::ReadSignedNumIncreasing(&value, &nanos) ||
+      nanos < 0 || nanos >= 1000000000 || !value.empty()) {
+    HARD_FAIL("Failed to read the read time of a document");
+  }
+  return model::SnapshotVersion{
+      Timestamp{seconds, static_cast<int32_t>(nanos)}};
+}
+
+bool LevelDbDocumentReadTimeKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kDocumentReadTimesTable);
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbFieldIndexKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexesTable);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexKey::KeyPrefix(const ResourcePath& collection) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexesTable);
+  writer.WriteResourcePath(collection);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexKey::Key(const ResourcePath& collection,
+                                      const model::FieldPath& field_path) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexesTable);
+  writer.WriteResourcePath(collection);
+  writer.WriteFieldPath(field_path);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbFieldIndexKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kFieldIndexesTable);
+  collection_ = reader.ReadResourcePath();
+  field_path_ = reader.ReadFieldPath();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbFieldIndexEntryKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexEntriesTable);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexEntryKey::KeyPrefix(
+    const ResourcePath& collection, const model::FieldPath& field_path) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexEntriesTable);
+  writer.WriteResourcePath(collection);
+  writer.WriteFieldPath(field_path);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexEntryKey::KeyPrefix(
+    const ResourcePath& collection,
+    const model::FieldPath& field_path,
+    absl::string_view encoded_value) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexEntriesTable);
+  writer.WriteResourcePath(collection);
+  writer.WriteFieldPath(field_path);
+  writer.WriteIndexValue(encoded_value);
+  return writer.result();
+}
+
+std::string LevelDbFieldIndexEntryKey::Key(const model::FieldPath& field_path,
+                                           absl::string_view encoded_value,
+                                           const DocumentKey& document_key) {
+  Writer writer;
+  writer.WriteTableName(kFieldIndexEntriesTable);
+  writer.WriteResourcePath(document_key.path().PopLast());
+  writer.WriteFieldPath(field_path);
+  writer.WriteIndexValue(encoded_value);
+  writer.WriteResourcePath(document_key.path());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbFieldIndexEntryKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kFieldIndexEntriesTable);
+  collection_ = reader.ReadResourcePath();
+  field_path_ = reader.ReadFieldPath();
+  encoded_value_ = reader.ReadIndexValue();
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbDocumentFieldIndexEntryKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kDocumentFieldIndexEntriesTable);
+  return writer.result();
+}
+
+std::string LevelDbDocumentFieldIndexEntryKey::KeyPrefix(
+    const DocumentKey& document_key) {
+  Writer writer;
+  writer.WriteTableName(kDocumentFieldIndexEntriesTable);
+  writer.WriteResourcePath(document_key.path());
+  return writer.result();
+}
+
+std::string LevelDbDocumentFieldIndexEntryKey::Key(
+    const DocumentKey& document_key, const model::FieldPath& field_path) {
+  Writer writer;
+  writer.WriteTableName(kDocumentFieldIndexEntriesTable);
+  writer.WriteResourcePath(document_key.path());
+  writer.WriteFieldPath(field_path);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbDocumentFieldIndexEntryKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kDocumentFieldIndexEntriesTable);
+  document_key_ = reader.ReadDocumentKey();
+  field_path_ = reader.ReadFieldPath();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
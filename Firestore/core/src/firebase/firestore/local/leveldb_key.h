@@ -17,10 +17,15 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_KEY_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_KEY_H_
 
+#include <cstdint>
+#include <deque>
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "absl/strings/string_view.h"
 #include "leveldb/slice.h"
@@ -48,6 +53,12 @@ namespace local {
 //   - path: ResourcePath
 //   - batch_id: model::BatchId
 //
+// collection_mutations:
+//   - table_name: string = "collection_mutation"
+//   - user_id: string
+//   - collection: ResourcePath
+//   - batch_id: model::BatchId
+//
 // mutation_queues:
 //   - table_name: string = "mutation_queue"
 //   - user_id: string
@@ -82,6 +93,23 @@ namespace local {
 //   - table_name: string = "collection_parent"
 //   - collectionId: string
 //   - parent: ResourcePath
+//
+// field_indexes:
+//   - table_name: string = "field_index"
+//   - collection: ResourcePath
+//   - field_path: FieldPath
+//
+// field_index_entries:
+//   - table_name: string = "field_index_entry"
+//   - collection: ResourcePath
+//   - field_path: FieldPath
+//   - value: string (as encoded by EncodeFieldIndexValue)
+//   - path: ResourcePath
+//
+// document_field_index_entries:
+//   - table_name: string = "document_field_index_entry"
+//   - path: ResourcePath
+//   - field_path: FieldPath
 
 /**
  * Parses the given key and returns a human readable description of its
@@ -92,6 +120,58 @@ std::string DescribeKey(absl::string_view key);
 std::string DescribeKey(const std::string& key);
 std::string DescribeKey(const char* key);
 
+/**
+ * Returns the leading part of the given key that names its table, which all
+ * keys in the table share, or an empty view if the key doesn't start with a
+ * table name.
+ */
+absl::string_view TablePrefix(absl::string_view key);
+
+/**
+ * The path segments of a decoded key, as views into the key's bytes.
+ *
+ * Decoding a full ResourcePath allocates a string per segment. Callers that
+ * only compare a key's path against a known path or look at its length can
+ * use this view instead and materialize a ResourcePath or DocumentKey only
+ * for the rows they keep. Segments that contain escaped bytes are unescaped
+ * into storage owned by the view; reusing a view across decodes also reuses
+ * its storage.
+ *
+ * The segments remain valid until the next decode or until the key's bytes
+ * are released (e.g. by advancing the iterator that produced them).
+ */
+class LevelDbPathView {
+ public:
+  size_t size() const {
+    return segments_.size();
+  }
+
+  bool empty() const {
+    return segments_.empty();
+  }
+
+  absl::string_view operator[](size_t i) const {
+    return segments_[i];
+  }
+
+  /** Returns true if the given path is a prefix of (or equal to) this one. */
+  bool HasPrefix(const model::ResourcePath& prefix) const;
+
+  /** Returns true if this path has exactly the segments of the given path. */
+  bool Equals(const model::ResourcePath& path) const;
+
+  model::ResourcePath ToResourcePath() const;
+
+ private:
+  friend class LevelDbDocumentMutationKeyView;
+  friend class LevelDbRemoteDocumentKeyView;
+
+  std::vector<absl::string_view> segments_;
+
+  // A deque so that adding a segment doesn't move the earlier ones.
+  std::deque<std::string> unescaped_;
+};
+
 /** A key to a singleton row storing the version of the schema. */
 class LevelDbVersionKey {
  public:
@@ -101,6 +181,49 @@ class LevelDbVersionKey {
   static std::string Key();
 };
 
+/**
+ * A key to a singleton row recording how far the migration currently running
+ * has got, so that a migration that's interrupted can resume where it left
+ * off.
+ */
+class LevelDbMigrationProgressKey {
+ public:
+  /**
+   * Returns the key pointing to the singleton row storing migration progress.
+   */
+  static std::string Key();
+
+  /**
+   * Encodes the progress of the migration to the given schema version: the
+   * index of the table scan in progress within the migration and the last key
+   * that scan processed.
+   */
+  static std::string EncodeProgress(int64_t version,
+                                    int64_t scan,
+                                    absl::string_view last_key);
+
+  /**
+   * Decodes a value written by `EncodeProgress`.
+   *
+   * @return true if the value successfully decoded, false otherwise.
+   */
+  ABSL_MUST_USE_RESULT
+  static bool DecodeProgress(absl::string_view value,
+                             int64_t* version,
+                             int64_t* scan,
+                             std::string* last_key);
+};
+
+/**
+ * A key to a singleton row storing the dictionary that remote documents are
+ * compressed with, if document compression was ever enabled.
+ */
+class LevelDbDocumentDictionaryKey {
+ public:
+  /** Returns the key pointing to the singleton row storing the dictionary. */
+  static std::string Key();
+};
+
 /** A key in the mutations table. */
 class LevelDbMutationKey {
  public:
@@ -215,6 +338,120 @@ class LevelDbDocumentMutationKey {
   model::BatchId batch_id_;
 };
 
+/**
+ * Decodes keys in the document mutations index like
+ * LevelDbDocumentMutationKey, but without allocating the document path. See
+ * LevelDbPathView.
+ */
+class LevelDbDocumentMutationKeyView {
+ public:
+  /**
+   * Decodes the given complete key. The key's bytes must remain valid for as
+   * long as `path()` is used.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The user that owns the mutation batches. */
+  const std::string& user_id() const {
+    return user_id_;
+  }
+
+  /** The segments of the path to the document, as encoded in the key. */
+  const LevelDbPathView& path() const {
+    return path_;
+  }
+
+  /** Materializes the path to the document as a DocumentKey. */
+  model::DocumentKey document_key() const {
+    return model::DocumentKey{path_.ToResourcePath()};
+  }
+
+  /** The batch_id in which the document participates. */
+  model::BatchId batch_id() const {
+    return batch_id_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string user_id_;
+  LevelDbPathView path_;
+  model::BatchId batch_id_;
+};
+
+/**
+ * A key in the collection mutations index, which stores the batches that
+ * mutate documents in a collection. Only immediate children of the collection
+ * are considered, so the index can answer a collection query without scanning
+ * the entries for documents in subcollections.
+ */
+class LevelDbCollectionMutationKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * user_id.
+   */
+  static std::string KeyPrefix(absl::string_view user_id);
+
+  /**
+   * Creates a key prefix that points just before the first key for the
+   * user_id and collection. Note that the prefix also matches the keys for
+   * subcollections of the collection, which sort after the collection's own
+   * keys.
+   */
+  static std::string KeyPrefix(absl::string_view user_id,
+                               const model::ResourcePath& collection_path);
+
+  /**
+   * Creates a complete key that points to a specific user_id, collection, and
+   * batch_id.
+   */
+  static std::string Key(absl::string_view user_id,
+                         const model::ResourcePath& collection_path,
+                         model::BatchId batch_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The user that owns the mutation batches. */
+  const std::string& user_id() const {
+    return user_id_;
+  }
+
+  /** The collection containing the mutated documents. */
+  const model::ResourcePath& collection_path() const {
+    return collection_path_;
+  }
+
+  /** The batch_id in which the collection was mutated. */
+  model::BatchId batch_id() const {
+    return batch_id_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string user_id_;
+  model::ResourcePath collection_path_;
+  model::BatchId batch_id_;
+};
+
 /**
  * A key in the mutation_queues table.
  *
@@ -373,6 +610,14 @@ class LevelDbTargetDocumentKey {
   static std::string Key(model::TargetId target_id,
                          const model::DocumentKey& document_key);
 
+  /**
+   * Like `Key()`, but appends the key to `dest`, so that callers writing many
+   * rows can reuse one buffer instead of allocating a string per key.
+   */
+  static void AppendKey(std::string* dest,
+                        model::TargetId target_id,
+                        const model::DocumentKey& document_key);
+
   /**
    * Decodes the contents of a target document key, storing the decoded values
    * in this instance.
@@ -422,6 +667,11 @@ class LevelDbDocumentTargetKey {
   static std::string Key(const model::DocumentKey& document_key,
                          model::TargetId target_id);
 
+  /** Like `Key()`, but appends the key to `dest`. */
+  static void AppendKey(std::string* dest,
+                        const model::DocumentKey& document_key,
+                        model::TargetId target_id);
+
   /**
    * Creates a key that points to the sentinel row for the given document: a
    * document-target entry with a special, invalid target_id.
@@ -494,6 +744,10 @@ class LevelDbRemoteDocumentKey {
    */
   static std::string Key(const model::DocumentKey& document_key);
 
+  /** Like `Key()`, but appends the key to `dest`. */
+  static void AppendKey(std::string* dest,
+                        const model::DocumentKey& document_key);
+
   /**
    * Creates a key prefix that contains a part of a document path. Odd numbers
    * of segments create a collection key prefix, while an even number of
@@ -503,6 +757,13 @@ class LevelDbRemoteDocumentKey {
    */
   static std::string KeyPrefix(const model::ResourcePath& resource_path);
 
+  /**
+   * Creates a key that sorts after all keys starting with
+   * `KeyPrefix(resource_path)`. Seeking to this key from within a document's
+   * rows skips the document itself and all documents in its subcollections.
+   */
+  static std::string KeyPrefixEnd(const model::ResourcePath& resource_path);
+
   /**
    * Decodes the contents of a remote document key, storing the decoded values
    * in this instance. This can only decode complete document paths (i.e. the
@@ -525,6 +786,37 @@ class LevelDbRemoteDocumentKey {
   model::DocumentKey document_key_;
 };
 
+/**
+ * Decodes keys in the remote documents table like LevelDbRemoteDocumentKey,
+ * but without allocating the document path. See LevelDbPathView.
+ */
+class LevelDbRemoteDocumentKeyView {
+ public:
+  /**
+   * Decodes the contents of a complete remote document key. The key's bytes
+   * must remain valid for as long as `path()` is used.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The segments of the path to the document, as encoded in the key. */
+  const LevelDbPathView& path() const {
+    return path_;
+  }
+
+  /** Materializes the path to the document as a DocumentKey. */
+  model::DocumentKey document_key() const {
+    return model::DocumentKey{path_.ToResourcePath()};
+  }
+
+ private:
+  LevelDbPathView path_;
+};
+
 /**
  * A key in the collection parents index, which stores an association between a
  * Collection ID (e.g. 'messages') to a parent path (e.g. '/chats/123') that
@@ -578,6 +870,354 @@ class LevelDbCollectionParentKey {
   model::ResourcePath parent_;
 };
 
+/**
+ * A key in the collection group documents index, which has a row for every
+ * entry in the remote document cache, keyed by the ID of the collection that
+ * contains the document (e.g. 'messages') and then the document's path. The
+ * rows for a collection group are contiguous and sort in the same order as the
+ * remote document rows they refer to, so all the documents of a collection
+ * group query can be found with a single scan.
+ */
+class LevelDbCollectionGroupDocumentKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection_id.
+   */
+  static std::string KeyPrefix(absl::string_view collection_id);
+
+  /** Creates a complete key that points to a specific document. */
+  static std::string Key(const model::DocumentKey& document_key);
+
+  /** Like `Key()`, but appends the key to `dest`. */
+  static void AppendKey(std::string* dest,
+                        const model::DocumentKey& document_key);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection_id, as encoded in the key. */
+  const std::string& collection_id() const {
+    return collection_id_;
+  }
+
+  /** The document, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string collection_id_;
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key in the remote document read times index, which has a row for every
+ * entry in the remote document cache, keyed by the collection that contains
+ * the document, then the snapshot version at which the document was last
+ * written to the cache, then the document's path. The documents of a
+ * collection that were read at or after a given version can thus be found
+ * with a single scan. The values are empty.
+ */
+class LevelDbRemoteDocumentReadTimeKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection);
+
+  /**
+   * Creates a key prefix that points just before the first key for documents
+   * of the given collection read at `read_time`, and so after all the keys for
+   * documents read earlier.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection,
+                               const model::SnapshotVersion& read_time);
+
+  /** Creates a complete key that points to a specific document. */
+  static std::string Key(const model::DocumentKey& document_key,
+                         const model::SnapshotVersion& read_time);
+
+  /** Like `Key()`, but appends the key to `dest`. */
+  static void AppendKey(std::string* dest,
+                        const model::DocumentKey& document_key,
+                        const model::SnapshotVersion& read_time);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection that contains the document. */
+  const model::ResourcePath& collection() const {
+    return collection_;
+  }
+
+  /** The version at which the document was read. */
+  const model::SnapshotVersion& read_time() const {
+    return read_time_;
+  }
+
+  /** The document, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ResourcePath collection_;
+  model::DocumentKey document_key_;
+
+  // SnapshotVersion has no default constructor outside of Objective-C.
+  model::SnapshotVersion read_time_ = model::SnapshotVersion::None();
+};
+
+/**
+ * A key in the document read times table, an index from documents to their
+ * rows in the remote document read times index. The value of each row is the
+ * encoded read time, which allows the row in the read times index to be found
+ * and removed when the document is written again or removed.
+ */
+class LevelDbDocumentReadTimeKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a complete key that points to a specific document. */
+  static std::string Key(const model::DocumentKey& document_key);
+
+  /** Like `Key()`, but appends the key to `dest`. */
+  static void AppendKey(std::string* dest,
+                        const model::DocumentKey& document_key);
+
+  /** Encodes a read time in the format used for the values of this table. */
+  static std::string EncodeReadTime(const model::SnapshotVersion& read_time);
+
+  /** Decodes the value of a row, failing if it isn't a valid read time. */
+  static model::SnapshotVersion DecodeReadTime(absl::string_view value);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The document, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key in the field indexes table, a registry of the single-field indexes
+ * that have been built for a collection. An index is only consulted once its
+ * row exists, since only then is it known to cover every cached document in
+ * the collection.
+ */
+class LevelDbFieldIndexKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection);
+
+  /** Creates a complete key that points to a specific index. */
+  static std::string Key(const model::ResourcePath& collection,
+                         const model::FieldPath& field_path);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection whose documents are indexed. */
+  const model::ResourcePath& collection() const {
+    return collection_;
+  }
+
+  /** The field whose values are indexed. */
+  const model::FieldPath& field_path() const {
+    return field_path_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ResourcePath collection_;
+  model::FieldPath field_path_;
+};
+
+/**
+ * A key in the field index entries table, which stores one row for each
+ * document in an indexed collection that has a value for the indexed field.
+ * Rows sort by encoded value, so a range of values can be found with a single
+ * seek.
+ */
+class LevelDbFieldIndexEntryKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key of the index
+   * for the given field in the given collection.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection,
+                               const model::FieldPath& field_path);
+
+  /**
+   * Creates a key prefix that points just before the first key in the index
+   * whose encoded value is not less than `encoded_value`.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& collection,
+                               const model::FieldPath& field_path,
+                               absl::string_view encoded_value);
+
+  /** Creates a complete key that points to a specific index entry. */
+  static std::string Key(const model::FieldPath& field_path,
+                         absl::string_view encoded_value,
+                         const model::DocumentKey& document_key);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection whose documents are indexed. */
+  const model::ResourcePath& collection() const {
+    return collection_;
+  }
+
+  /** The field whose values are indexed. */
+  const model::FieldPath& field_path() const {
+    return field_path_;
+  }
+
+  /** The encoded value of the field in the document. */
+  const std::string& encoded_value() const {
+    return encoded_value_;
+  }
+
+  /** The document that has the value. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ResourcePath collection_;
+  model::FieldPath field_path_;
+  std::string encoded_value_;
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key in the document field index entries table, an index from documents to
+ * the field index entries that contain them. The value of each row is the
+ * encoded field value, which allows the matching field index entry to be found
+ * and removed when the document changes.
+ */
+class LevelDbDocumentFieldIndexEntryKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * document. Note that the prefix also matches documents in subcollections
+   * of the document, so callers must check the decoded document key.
+   */
+  static std::string KeyPrefix(const model::DocumentKey& document_key);
+
+  /** Creates a complete key that points to a specific document and field. */
+  static std::string Key(const model::DocumentKey& document_key,
+                         const model::FieldPath& field_path);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The document that has the value. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+  /** The field whose value is indexed. */
+  const model::FieldPath& field_path() const {
+    return field_path_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::DocumentKey document_key_;
+  model::FieldPath field_path_;
+};
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -16,18 +16,24 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/mutation.nanopb.h"
 #include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/local/document_compressor.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "absl/strings/match.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -64,12 +70,28 @@ namespace {
  *     has a sentinel row with a sequence number.
  *   * Migration 5 drops held write acks.
  *   * Migration 6 populates the collection_parents index.
+ *   * Migration 7 drops all field indexes. Versions that predate field indexes
+ *     don't maintain them, so any left behind by a downgrade may be stale.
+ *     Indexes are rebuilt on demand.
+ *   * Migration 8 populates the collection_mutations index.
+ *   * Migration 9 populates the collection_group_documents index.
+ *   * Migration 10 populates the remote_document_read_time index.
  */
-const LevelDbMigrations::SchemaVersion kSchemaVersion = 6;
+const LevelDbMigrations::SchemaVersion kSchemaVersion = 10;
+
+/**
+ * The number of bytes of pending changes past which a migration that visits
+ * every document or mutation writes them to disk before carrying on. These
+ * migrations are idempotent and only save the new schema version at the end,
+ * so one that's interrupted partway runs again, resuming from the last chunk
+ * written (see TableScan).
+ */
+const size_t kMigrationChunkBytes = 4 * 1024 * 1024;
 
 /**
  * Save the given version number as the current version of the schema of the
- * database.
+ * database. Since the migration to that version is then complete, any record
+ * of its progress is deleted at the same time.
  * @param version The version to save
  * @param transaction The transaction in which to save the new version number
  */
@@ -78,6 +100,119 @@ void SaveVersion(LevelDbMigrations::SchemaVersion version,
   std::string key = LevelDbVersionKey::Key();
   std::string version_string = std::to_string(version);
   transaction->Put(key, version_string);
+  transaction->Delete(LevelDbMigrationProgressKey::Key());
+}
+
+/** How far an interrupted migration had got. */
+struct MigrationProgress {
+  /** The schema version the migration was migrating to. */
+  int64_t version = 0;
+
+  /** The index, within the migration, of the table scan in progress. */
+  int64_t scan = 0;
+
+  /** The last key the scan processed. */
+  std::string last_key;
+};
+
+/**
+ * Reads the progress of the migration to the given version, if it was
+ * interrupted after writing a chunk.
+ */
+absl::optional<MigrationProgress> ReadMigrationProgress(
+    LevelDbTransaction* transaction, LevelDbMigrations::SchemaVersion version) {
+  std::string value;
+  if (!transaction->Get(LevelDbMigrationProgressKey::Key(), &value).ok()) {
+    return absl::nullopt;
+  }
+
+  MigrationProgress progress;
+  bool ok = LevelDbMigrationProgressKey::DecodeProgress(
+      value, &progress.version, &progress.scan, &progress.last_key);
+  HARD_ASSERT(ok, "Failed to decode migration progress");
+
+  // Progress of a migration to another version is left over from an
+  // interrupted migration that a downgrade abandoned.
+  if (progress.version != version) return absl::nullopt;
+  return progress;
+}
+
+/**
+ * Visits the rows of a table for a migration that may change rows as it goes,
+ * committing the changes in chunks so that they don't all have to be held in
+ * memory.
+ *
+ * Each chunk written also records the last key visited, so if the app is
+ * killed partway through, the migration picks up where it had got instead of
+ * visiting every row again. Where a migration scans several tables, each scan
+ * is given the index of its position in the migration, so that scans that
+ * already finished are skipped.
+ */
+class TableScan {
+ public:
+  TableScan(LevelDbTransaction* transaction,
+            LevelDbMigrations::SchemaVersion version,
+            int scan,
+            std::string prefix)
+      : transaction_(transaction),
+        version_(version),
+        scan_(scan),
+        prefix_(std::move(prefix)),
+        it_(transaction->NewIterator()) {
+    absl::optional<MigrationProgress> progress =
+        ReadMigrationProgress(transaction, version);
+    if (progress && progress->scan > scan) {
+      finished_ = true;
+    } else if (progress && progress->scan == scan) {
+      it_->Seek(progress->last_key);
+      if (it_->Valid() && it_->key() == progress->last_key) {
+        it_->Next();
+      }
+    } else {
+      it_->Seek(prefix_);
+    }
+  }
+
+  bool Valid() {
+    return !finished_ && it_->Valid() && absl::StartsWith(it_->key(), prefix_);
+  }
+
+  absl::string_view key() {
+    return it_->key();
+  }
+
+  /**
+   * Moves to the next row, first writing the changes made so far along with
+   * the progress of the scan if they're large enough.
+   */
+  void Next() {
+    if (transaction_->changed_bytes() >= kMigrationChunkBytes) {
+      transaction_->Put(
+          LevelDbMigrationProgressKey::Key(),
+          LevelDbMigrationProgressKey::EncodeProgress(version_, scan_,
+                                                      it_->key()));
+      transaction_->CommitChunkIfLarger(kMigrationChunkBytes);
+    }
+    it_->Next();
+  }
+
+ private:
+  LevelDbTransaction* transaction_;
+  LevelDbMigrations::SchemaVersion version_;
+  int scan_;
+  std::string prefix_;
+  std::unique_ptr<LevelDbTransaction::Iterator> it_;
+  bool finished_ = false;
+};
+
+/**
+ * Returns true if the migration to the given version was interrupted after
+ * writing at least one chunk, and so got past any steps it takes before
+ * scanning.
+ */
+bool IsResuming(leveldb::DB* db, LevelDbMigrations::SchemaVersion version) {
+  LevelDbTransaction transaction(db, "Read migration progress");
+  return ReadMigrationProgress(&transaction, version).has_value();
 }
 
 void DeleteEverythingWithPrefix(const std::string& prefix, leveldb::DB* db) {
@@ -181,6 +316,7 @@ void RemoveAcknowledgedMutations(leveldb::DB* db) {
                           mutation_queue.last_acknowledged_batch_id);
     RemoveMutationDocuments(&transaction, key.user_id(),
                             mutation_queue.last_acknowledged_batch_id);
+    transaction.CommitChunkIfLarger(kMigrationChunkBytes);
   }
 
   SaveVersion(5, &transaction);
@@ -202,6 +338,23 @@ model::ListenSequenceNumber GetHighestSequenceNumber(
   return target_global.highest_listen_sequence_number;
 }
 
+/**
+ * Reads the last remote snapshot version from the target global row.
+ */
+model::SnapshotVersion GetLastRemoteSnapshotVersion(
+    LevelDbTransaction* transaction) {
+  std::string bytes;
+  transaction->Get(LevelDbTargetGlobalKey::Key(), &bytes);
+
+  firestore_client_TargetGlobal target_global{};
+  Reader reader(bytes);
+  reader.ReadNanopbMessage(firestore_client_TargetGlobal_fields,
+                           &target_global);
+  const google_protobuf_Timestamp& version =
+      target_global.last_remote_snapshot_version;
+  return model::SnapshotVersion{Timestamp{version.seconds, version.nanos}};
+}
+
 /**
  * Given a document key, ensure it has a sentinel row. If it doesn't have one,
  * add it with the given value.
@@ -231,13 +384,10 @@ void EnsureSentinelRows(leveldb::DB* db) {
   std::string sentinel_value =
       LevelDbDocumentTargetKey::EncodeSentinelValue(sequence_number);
 
-  std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
-  auto it = transaction.NewIterator();
-  it->Seek(documents_prefix);
+  TableScan scan(&transaction, 4, 0, LevelDbRemoteDocumentKey::KeyPrefix());
   LevelDbRemoteDocumentKey document_key;
-  for (; it->Valid() && absl::StartsWith(it->key(), documents_prefix);
-       it->Next()) {
-    HARD_ASSERT(document_key.Decode(it->key()),
+  for (; scan.Valid(); scan.Next()) {
+    HARD_ASSERT(document_key.Decode(scan.key()),
                 "Failed to decode document key");
     EnsureSentinelRow(&transaction, document_key.document_key(),
                       sentinel_value);
@@ -275,13 +425,11 @@ void EnsureCollectionParentsIndex(leveldb::DB* db) {
   MemoryCollectionParentIndex cache;
 
   // Index existing remote documents.
-  std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
-  auto it = transaction.NewIterator();
-  it->Seek(documents_prefix);
+  TableScan documents(&transaction, 6, 0,
+                      LevelDbRemoteDocumentKey::KeyPrefix());
   LevelDbRemoteDocumentKey document_key;
-  for (; it->Valid() && absl::StartsWith(it->key(), documents_prefix);
-       it->Next()) {
-    HARD_ASSERT(document_key.Decode(it->key()),
+  for (; documents.Valid(); documents.Next()) {
+    HARD_ASSERT(document_key.Decode(documents.key()),
                 "Failed to decode document key");
 
     EnsureCollectionParentRow(&transaction, &cache,
@@ -289,13 +437,11 @@ void EnsureCollectionParentsIndex(leveldb::DB* db) {
   }
 
   // Index existing mutations.
-  std::string mutations_prefix = LevelDbDocumentMutationKey::KeyPrefix();
-  it = transaction.NewIterator();
-  it->Seek(mutations_prefix);
+  TableScan mutations(&transaction, 6, 1,
+                      LevelDbDocumentMutationKey::KeyPrefix());
   LevelDbDocumentMutationKey key;
-  for (; it->Valid() && absl::StartsWith(it->key(), mutations_prefix);
-       it->Next()) {
-    HARD_ASSERT(key.Decode(it->key()),
+  for (; mutations.Valid(); mutations.Next()) {
+    HARD_ASSERT(key.Decode(mutations.key()),
                 "Failed to decode document-mutation key");
 
     EnsureCollectionParentRow(&transaction, &cache, key.document_key());
@@ -305,6 +451,131 @@ void EnsureCollectionParentsIndex(leveldb::DB* db) {
   transaction.Commit();
 }
 
+/** Migration 7. */
+void ClearFieldIndexes(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbFieldIndexKey::KeyPrefix(), db);
+  DeleteEverythingWithPrefix(LevelDbFieldIndexEntryKey::KeyPrefix(), db);
+  DeleteEverythingWithPrefix(LevelDbDocumentFieldIndexEntryKey::KeyPrefix(),
+                             db);
+
+  LevelDbTransaction transaction(db, "Drop field indexes");
+  SaveVersion(7, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 8.
+ *
+ * Creates LevelDbCollectionMutationKey rows for all existing rows in the
+ * document mutations index. Any rows left behind by a downgrade to a version
+ * that didn't maintain the index are deleted first.
+ */
+void EnsureCollectionMutationsIndex(leveldb::DB* db) {
+  if (!IsResuming(db, 8)) {
+    DeleteEverythingWithPrefix(LevelDbCollectionMutationKey::KeyPrefix(), db);
+  }
+
+  LevelDbTransaction transaction(db, "Ensure Collection Mutations Index");
+
+  TableScan scan(&transaction, 8, 0, LevelDbDocumentMutationKey::KeyPrefix());
+  LevelDbDocumentMutationKey key;
+  std::string empty_buffer;
+  for (; scan.Valid(); scan.Next()) {
+    HARD_ASSERT(key.Decode(scan.key()),
+                "Failed to decode document-mutation key");
+
+    transaction.Put(LevelDbCollectionMutationKey::Key(
+                        key.user_id(), key.document_key().path().PopLast(),
+                        key.batch_id()),
+                    empty_buffer);
+  }
+
+  SaveVersion(8, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 9.
+ *
+ * Creates a LevelDbCollectionGroupDocumentKey row for every document in the
+ * remote document cache. Any rows left behind by a downgrade to a version that
+ * didn't maintain the index are deleted first.
+ */
+void EnsureCollectionGroupDocumentsIndex(leveldb::DB* db) {
+  if (!IsResuming(db, 9)) {
+    DeleteEverythingWithPrefix(LevelDbCollectionGroupDocumentKey::KeyPrefix(),
+                               db);
+  }
+
+  LevelDbTransaction transaction(db, "Ensure Collection Group Documents Index");
+
+  TableScan scan(&transaction, 9, 0, LevelDbRemoteDocumentKey::KeyPrefix());
+  LevelDbRemoteDocumentKey document_key;
+  std::string empty_buffer;
+  for (; scan.Valid(); scan.Next()) {
+    HARD_ASSERT(document_key.Decode(scan.key()),
+                "Failed to decode document key");
+
+    transaction.Put(
+        LevelDbCollectionGroupDocumentKey::Key(document_key.document_key()),
+        empty_buffer);
+  }
+
+  SaveVersion(9, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Migration 10.
+ *
+ * Creates the read time rows of every document in the remote document cache.
+ * The time at which existing documents were read isn't known, so the last
+ * remote snapshot version is used for all of them: no target has a later
+ * snapshot, so every target treats them as possibly changed since it was last
+ * in sync. Any rows left behind by a downgrade are deleted first.
+ */
+void EnsureRemoteDocumentReadTimes(leveldb::DB* db) {
+  if (!IsResuming(db, 10)) {
+    DeleteEverythingWithPrefix(LevelDbRemoteDocumentReadTimeKey::KeyPrefix(),
+                               db);
+    DeleteEverythingWithPrefix(LevelDbDocumentReadTimeKey::KeyPrefix(), db);
+  }
+
+  LevelDbTransaction transaction(db, "Ensure Remote Document Read Times");
+  model::SnapshotVersion read_time = GetLastRemoteSnapshotVersion(&transaction);
+  std::string encoded_read_time =
+      LevelDbDocumentReadTimeKey::EncodeReadTime(read_time);
+
+  TableScan scan(&transaction, 10, 0, LevelDbRemoteDocumentKey::KeyPrefix());
+  LevelDbRemoteDocumentKey document_key;
+  std::string empty_buffer;
+  for (; scan.Valid(); scan.Next()) {
+    HARD_ASSERT(document_key.Decode(scan.key()),
+                "Failed to decode document key");
+
+    const DocumentKey& key = document_key.document_key();
+    transaction.Put(LevelDbRemoteDocumentReadTimeKey::Key(key, read_time),
+                    empty_buffer);
+    transaction.Put(LevelDbDocumentReadTimeKey::Key(key), encoded_read_time);
+  }
+
+  SaveVersion(10, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * The number of bytes of consecutive documents sampled from each collection
+ * when training the document dictionary, before skipping to the next
+ * collection.
+ */
+constexpr size_t kDictionarySampleBytesPerCollection = 4 * 1024;
+
+/**
+ * The number of bytes of sampled documents below which no dictionary is
+ * trained yet.
+ */
+constexpr size_t kMinDictionarySampleBytes = 4 * 1024;
+
 }  // namespace
 
 LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
@@ -358,6 +629,72 @@ void LevelDbMigrations::RunMigrations(leveldb::DB* db,
   if (from_version < 6 && to_version >= 6) {
     EnsureCollectionParentsIndex(db);
   }
+
+  if (from_version < 7 && to_version >= 7) {
+    ClearFieldIndexes(db);
+  }
+
+  if (from_version < 8 && to_version >= 8) {
+    EnsureCollectionMutationsIndex(db);
+  }
+
+  if (from_version < 9 && to_version >= 9) {
+    EnsureCollectionGroupDocumentsIndex(db);
+  }
+
+  if (from_version < 10 && to_version >= 10) {
+    EnsureRemoteDocumentReadTimes(db);
+  }
+}
+
+void LevelDbMigrations::EnsureDocumentDictionary(leveldb::DB* db) {
+  if (ReadDocumentDictionary(db)) return;
+
+  LevelDbTransaction transaction(db, "Ensure document dictionary");
+  std::vector<std::string> samples;
+  size_t sample_bytes = 0;
+
+  std::string prefix = LevelDbRemoteDocumentKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  it->Seek(prefix);
+  LevelDbRemoteDocumentKey document_key;
+  while (it->Valid() && absl::StartsWith(it->key(), prefix) &&
+         sample_bytes < DocumentCompressor::kMaxDictionarySize) {
+    HARD_ASSERT(document_key.Decode(it->key()),
+                "Failed to decode document key");
+    ResourcePath collection = document_key.document_key().path().PopLast();
+    std::string collection_prefix =
+        LevelDbRemoteDocumentKey::KeyPrefix(collection);
+
+    size_t collection_bytes = 0;
+    for (; collection_bytes < kDictionarySampleBytesPerCollection &&
+           it->Valid() && absl::StartsWith(it->key(), collection_prefix);
+         it->Next()) {
+      samples.emplace_back(it->value());
+      collection_bytes += samples.back().size();
+    }
+    sample_bytes += collection_bytes;
+    it->Seek(LevelDbRemoteDocumentKey::KeyPrefixEnd(collection));
+  }
+
+  if (sample_bytes < kMinDictionarySampleBytes) return;
+
+  transaction.Put(LevelDbDocumentDictionaryKey::Key(),
+                  DocumentCompressor::TrainDictionary(samples));
+  transaction.Commit();
+}
+
+absl::optional<std::string> LevelDbMigrations::ReadDocumentDictionary(
+    leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Read document dictionary");
+  std::string dictionary;
+  Status status =
+      transaction.Get(LevelDbDocumentDictionaryKey::Key(), &dictionary);
+  if (status.IsNotFound()) return absl::nullopt;
+
+  HARD_ASSERT(status.ok(), "Failed to read document dictionary, error: '%s'",
+              status.ToString());
+  return dictionary;
 }
 
 }  // namespace local
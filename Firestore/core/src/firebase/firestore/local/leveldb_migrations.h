@@ -18,9 +18,11 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_MIGRATIONS_H_
 
 #include <cstdint>
+#include <string>
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 #include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
+#include "absl/types/optional.h"
 #include "leveldb/db.h"
 
 namespace firebase {
@@ -47,6 +49,24 @@ class LevelDbMigrations {
    * schema version
    */
   static void RunMigrations(leveldb::DB* db, SchemaVersion version);
+
+  /**
+   * Trains and saves the dictionary that remote documents are compressed with,
+   * unless the database already has one. The dictionary is sampled from the
+   * documents already in the cache, a few from each collection, so nothing is
+   * saved until the cache holds enough documents to be worth sampling; until
+   * then documents are stored uncompressed.
+   *
+   * Once saved, the dictionary never changes, since rows compressed with it
+   * can only be read back with it.
+   */
+  static void EnsureDocumentDictionary(leveldb::DB* db);
+
+  /**
+   * Returns the dictionary that remote documents are compressed with, if the
+   * database has one.
+   */
+  static absl::optional<std::string> ReadDocumentDictionary(leveldb::DB* db);
 };
 
 }  // namespace local
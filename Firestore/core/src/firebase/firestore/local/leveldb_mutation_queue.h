@@ -23,6 +23,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <mutex>  // NOLINT(build/c++11)
 #include <set>
 #include <string>
 #include <vector>
@@ -34,6 +35,7 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/lru_cache.h"
 #include "absl/strings/string_view.h"
 #include "leveldb/db.h"
 
@@ -66,6 +68,8 @@ class LevelDbMutationQueue : public MutationQueue {
 
   bool IsEmpty() override;
 
+  PendingWrites GetPendingWrites() override;
+
   void AcknowledgeBatch(FSTMutationBatch* batch,
                         NSData* _Nullable stream_token) override;
 
@@ -93,12 +97,21 @@ class LevelDbMutationQueue : public MutationQueue {
   FSTMutationBatch* _Nullable NextMutationBatchAfterBatchId(
       model::BatchId batch_id) override;
 
+  std::vector<FSTMutationBatch*> NextMutationBatchesAfterBatchId(
+      model::BatchId batch_id, size_t max_count, size_t max_bytes) override;
+
   void PerformConsistencyCheck() override;
 
   NSData* _Nullable GetLastStreamToken() override;
 
   void SetLastStreamToken(NSData* _Nullable stream_token) override;
 
+  /**
+   * Evicts the least recently read decoded batches from memory until at most
+   * roughly `budget_bytes` of them remain.
+   */
+  void TrimMemory(size_t budget_bytes);
+
  private:
   /**
    * Constructs a vector of matching batches, sorted by batchID to ensure that
@@ -118,7 +131,27 @@ class LevelDbMutationQueue : public MutationQueue {
   /** Parses the MutationQueue metadata from the given LevelDB row contents. */
   FSTPBMutationQueue* _Nullable MetadataForKey(const std::string& key);
 
-  FSTMutationBatch* ParseMutationBatch(absl::string_view encoded);
+  /**
+   * Recounts the batches in the queue and their size from its rows, and
+   * stores them in the metadata.
+   */
+  void CountPendingWrites();
+
+  /**
+   * A batch decoded from the encoded bytes of its leveldb row. Pending batches
+   * are replayed on top of the remote documents on every local read, so
+   * decoding them once per write instead of once per read saves a lot of work.
+   *
+   * The bytes double as the version of the entry: a cached batch is only
+   * reused if the row read from leveldb still has the same contents.
+   */
+  struct DecodedBatch {
+    std::string encoded;
+    FSTMutationBatch* batch;
+  };
+
+  FSTMutationBatch* ParseMutationBatch(model::BatchId batch_id,
+                                       absl::string_view encoded);
 
   // This instance is owned by FSTLevelDB; avoid a retain cycle.
   __weak FSTLevelDB* db_;
@@ -144,6 +177,11 @@ class LevelDbMutationQueue : public MutationQueue {
    * A write-through cache copy of the metadata describing the current queue.
    */
   FSTPBMutationQueue* _Nullable metadata_;
+
+  // Guarded by decoded_batches_mutex_, since snapshot reads decode batches
+  // off the worker queue.
+  std::mutex decoded_batches_mutex_;
+  util::LruCache<model::BatchId, DecodedBatch> decoded_batches_;
 };
 
 }  // namespace local
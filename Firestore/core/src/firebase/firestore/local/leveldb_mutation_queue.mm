@@ -17,7 +17,9 @@
 #include "Firestore/core/src/firebase/firestore/local/leveldb_mutation_queue.h"
 
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
@@ -49,6 +51,17 @@ using model::DocumentKeySet;
 using model::kBatchIdUnknown;
 using model::ResourcePath;
 
+namespace {
+
+/**
+ * The number of encoded bytes of mutation batches whose decoded form is kept
+ * by each queue. Pending writes are usually few and small, so this is enough
+ * to hold all of them in the common case.
+ */
+constexpr size_t kDecodedBatchesCacheSizeBytes = 1024 * 1024;
+
+}  // namespace
+
 BatchId LoadNextBatchIdFromDb(DB* db) {
   // TODO(gsoltis): implement Prev() and SeekToLast() on
   // LevelDbTransaction::Iterator, then port this to a transaction.
@@ -123,7 +136,8 @@ LevelDbMutationQueue::LevelDbMutationQueue(const User& user,
                                            FSTLocalSerializer* serializer)
     : db_(db),
       serializer_(serializer),
-      user_id_(user.is_authenticated() ? user.uid() : "") {
+      user_id_(user.is_authenticated() ? user.uid() : ""),
+      decoded_batches_(kDecodedBatchesCacheSizeBytes) {
 }
 
 void LevelDbMutationQueue::Start() {
@@ -135,6 +149,30 @@ void LevelDbMutationQueue::Start() {
     metadata = [FSTPBMutationQueue message];
   }
   metadata_ = metadata;
+
+  // The counters are missing from queues written before they were kept, and
+  // may be stale if a version that doesn't keep them wrote to the queue since.
+  // Either way they disagree with the queue being empty or not.
+  if ((metadata_.pendingBatchCount == 0) != IsEmpty()) {
+    CountPendingWrites();
+  }
+}
+
+void LevelDbMutationQueue::CountPendingWrites() {
+  std::string user_key = LevelDbMutationKey::KeyPrefix(user_id_);
+  int64_t batch_count = 0;
+  int64_t bytes = 0;
+
+  auto it = db_.currentTransaction->NewIterator();
+  for (it->Seek(user_key); it->Valid() && absl::StartsWith(it->key(), user_key);
+       it->Next()) {
+    ++batch_count;
+    bytes += static_cast<int64_t>(it->value().size());
+  }
+
+  metadata_.pendingBatchCount = batch_count;
+  metadata_.pendingBytes = bytes;
+  db_.currentTransaction->Put(mutation_queue_key(), metadata_);
 }
 
 bool LevelDbMutationQueue::IsEmpty() {
@@ -150,6 +188,13 @@ bool LevelDbMutationQueue::IsEmpty() {
   return empty;
 }
 
+PendingWrites LevelDbMutationQueue::GetPendingWrites() {
+  PendingWrites pending;
+  pending.batch_count = metadata_.pendingBatchCount;
+  pending.byte_size = metadata_.pendingBytes;
+  return pending;
+}
+
 void LevelDbMutationQueue::AcknowledgeBatch(FSTMutationBatch* batch,
                                             NSData* _Nullable stream_token) {
   SetLastStreamToken(stream_token);
@@ -167,8 +212,22 @@ FSTMutationBatch* LevelDbMutationQueue::AddMutationBatch(
                                  localWriteTime:local_write_time
                                   baseMutations:std::move(base_mutations)
                                       mutations:std::move(mutations)];
-  std::string key = mutation_batch_key(batch_id);
-  db_.currentTransaction->Put(key, [serializer_ encodedMutationBatch:batch]);
+  NSData* data = [[serializer_ encodedMutationBatch:batch] data];
+  std::string encoded{static_cast<const char*>(data.bytes), data.length};
+  db_.currentTransaction->Put(mutation_batch_key(batch_id), encoded);
+
+  metadata_.pendingBatchCount += 1;
+  metadata_.pendingBytes += static_cast<int64_t>(encoded.size());
+  db_.currentTransaction->Put(mutation_queue_key(), metadata_);
+
+  // The batch is about to be applied to every read of the documents it
+  // touches.
+  size_t cost = encoded.size();
+  {
+    std::lock_guard<std::mutex> lock{decoded_batches_mutex_};
+    decoded_batches_.Put(batch_id, DecodedBatch{std::move(encoded), batch},
+                         cost);
+  }
 
   // Store an empty value in the index which is equivalent to serializing a
   // GPBEmpty message. In the future if we wanted to store some other kind of
@@ -177,8 +236,15 @@ FSTMutationBatch* LevelDbMutationQueue::AddMutationBatch(
   std::string empty_buffer;
 
   for (FSTMutation* mutation : [batch mutations]) {
-    key = LevelDbDocumentMutationKey::Key(user_id_, mutation.key, batch_id);
-    db_.currentTransaction->Put(key, empty_buffer);
+    db_.currentTransaction->Put(
+        LevelDbDocumentMutationKey::Key(user_id_, mutation.key, batch_id),
+        empty_buffer);
+
+    // Multiple mutations in the same collection share a row.
+    db_.currentTransaction->Put(
+        LevelDbCollectionMutationKey::Key(
+            user_id_, mutation.key.path().PopLast(), batch_id),
+        empty_buffer);
 
     db_.indexManager->AddToCollectionParentIndex(mutation.key.path().PopLast());
   }
@@ -202,11 +268,23 @@ void LevelDbMutationQueue::RemoveMutationBatch(FSTMutationBatch* batch) {
               "Mutation batch %s not found; found %s", DescribeKey(key),
               DescribeKey(check_iterator->key()));
 
+  metadata_.pendingBatchCount -= 1;
+  metadata_.pendingBytes -=
+      static_cast<int64_t>(check_iterator->value().size());
+  db_.currentTransaction->Put(mutation_queue_key(), metadata_);
+
   db_.currentTransaction->Delete(key);
+  {
+    std::lock_guard<std::mutex> lock{decoded_batches_mutex_};
+    decoded_batches_.Erase(batch_id);
+  }
 
   for (FSTMutation* mutation : [batch mutations]) {
     key = LevelDbDocumentMutationKey::Key(user_id_, mutation.key, batch_id);
     db_.currentTransaction->Delete(key);
+    key = LevelDbCollectionMutationKey::Key(
+        user_id_, mutation.key.path().PopLast(), batch_id);
+    db_.currentTransaction->Delete(key);
     [db_.referenceDelegate removeMutationReference:mutation.key];
   }
 }
@@ -217,8 +295,12 @@ std::vector<FSTMutationBatch*> LevelDbMutationQueue::AllMutationBatches() {
   auto it = db_.currentTransaction->NewIterator();
   it->Seek(user_key);
   std::vector<FSTMutationBatch*> result;
+  LevelDbMutationKey row_key;
   for (; it->Valid() && absl::StartsWith(it->key(), user_key); it->Next()) {
-    result.push_back(ParseMutationBatch(it->value()));
+    bool decoded = row_key.Decode(it->key());
+    HARD_ASSERT(decoded, "Failed to decode mutation key %s",
+                DescribeKey(it->key()));
+    result.push_back(ParseMutationBatch(row_key.batch_id(), it->value()));
   }
   return result;
 }
@@ -232,7 +314,7 @@ LevelDbMutationQueue::AllMutationBatchesAffectingDocumentKeys(
   std::set<BatchId> batch_ids;
 
   auto index_iterator = db_.currentTransaction->NewIterator();
-  LevelDbDocumentMutationKey row_key;
+  LevelDbDocumentMutationKeyView row_key;
   for (const DocumentKey& document_key : document_keys) {
     std::string index_prefix =
         LevelDbDocumentMutationKey::KeyPrefix(user_id_, document_key.path());
@@ -251,7 +333,7 @@ LevelDbMutationQueue::AllMutationBatchesAffectingDocumentKeys(
       // contiguous in the table, allowing a break after any mismatch.
       if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
           !row_key.Decode(index_iterator->key()) ||
-          row_key.document_key() != document_key) {
+          !row_key.path().Equals(document_key.path())) {
         break;
       }
 
@@ -277,56 +359,31 @@ LevelDbMutationQueue::AllMutationBatchesAffectingQuery(FSTQuery* query) {
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
   const ResourcePath& query_path = query.path;
-  size_t immediate_children_path_length = query_path.size() + 1;
 
-  // TODO(mcg): Actually implement a single-collection query
-  //
-  // This is actually executing an ancestor query, traversing the whole subtree
-  // below the collection which can be horrifically inefficient for some
-  // structures. The right way to solve this is to implement the full value
-  // index, but that's not in the cards in the near future so this is the best
-  // we can do for the moment.
-  //
   // Since we don't yet index the actual properties in the mutations, our
   // current approach is to just return all mutation batches that affect
   // documents in the collection being queried.
   //
-  // Unlike allMutationBatchesAffectingDocumentKey, this iteration will scan the
-  // document-mutation index for more than a single document so the associated
-  // batchIDs will be neither necessarily unique nor in order. This means an
-  // efficient simultaneous scan isn't possible.
+  // The collection-mutation index has one row per batch for each collection
+  // the batch mutates, ordered by batch_id, so the batch_ids it yields are
+  // unique and in order. Rows for subcollections share the index prefix but
+  // sort after the collection's own rows, so the scan can stop at the first
+  // of them.
   std::string index_prefix =
-      LevelDbDocumentMutationKey::KeyPrefix(user_id_, query_path);
+      LevelDbCollectionMutationKey::KeyPrefix(user_id_, query_path);
   auto index_iterator = db_.currentTransaction->NewIterator();
   index_iterator->Seek(index_prefix);
 
-  LevelDbDocumentMutationKey row_key;
+  LevelDbCollectionMutationKey row_key;
 
-  // Collect up unique batchIDs encountered during a scan of the index. Use a
-  // set<BatchId> to accumulate batch IDs so they can be traversed in order in a
-  // scan of the main table.
-  //
-  // This method is faster than performing lookups of the keys with _db->Get and
-  // keeping a hash of batchIDs that have already been looked up. The
-  // performance difference is minor for small numbers of keys but > 30% faster
-  // for larger numbers of keys.
   std::set<BatchId> unique_batch_ids;
   for (; index_iterator->Valid(); index_iterator->Next()) {
     if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
-        !row_key.Decode(index_iterator->key())) {
+        !row_key.Decode(index_iterator->key()) ||
+        row_key.collection_path() != query_path) {
       break;
     }
 
-    // Rows with document keys more than one segment longer than the query path
-    // can't be matches. For example, a query on 'rooms' can't match the
-    // document /rooms/abc/messages/xyx.
-    // TODO(mcg): we'll need a different scanner when we implement ancestor
-    // queries.
-    if (row_key.document_key().path().size() !=
-        immediate_children_path_length) {
-      continue;
-    }
-
     unique_batch_ids.insert(row_key.batch_id());
   }
 
@@ -347,7 +404,7 @@ FSTMutationBatch* _Nullable LevelDbMutationQueue::LookupMutationBatch(
               batch_id, status.ToString());
   }
 
-  return ParseMutationBatch(value);
+  return ParseMutationBatch(batch_id, value);
 }
 
 FSTMutationBatch* _Nullable LevelDbMutationQueue::NextMutationBatchAfterBatchId(
@@ -371,7 +428,32 @@ FSTMutationBatch* _Nullable LevelDbMutationQueue::NextMutationBatchAfterBatchId(
 
   HARD_ASSERT(row_key.batch_id() >= next_batch_id,
               "Should have found mutation after %s", next_batch_id);
-  return ParseMutationBatch(it->value());
+  return ParseMutationBatch(row_key.batch_id(), it->value());
+}
+
+std::vector<FSTMutationBatch*>
+LevelDbMutationQueue::NextMutationBatchesAfterBatchId(BatchId batch_id,
+                                                      size_t max_count,
+                                                      size_t max_bytes) {
+  std::vector<FSTMutationBatch*> result;
+  size_t bytes_read = 0;
+
+  auto it = db_.currentTransaction->NewIterator();
+  LevelDbMutationKey row_key;
+  for (it->Seek(mutation_batch_key(batch_id + 1));
+       it->Valid() && result.size() < max_count &&
+       (max_bytes == 0 || bytes_read < max_bytes);
+       it->Next()) {
+    if (!row_key.Decode(it->key()) || row_key.user_id() != user_id_) {
+      // Out of the mutations table, or past the last mutation for this user.
+      break;
+    }
+
+    absl::string_view value = it->value();
+    bytes_read += value.size();
+    result.push_back(ParseMutationBatch(row_key.batch_id(), value));
+  }
+  return result;
 }
 
 void LevelDbMutationQueue::PerformConsistencyCheck() {
@@ -379,8 +461,8 @@ void LevelDbMutationQueue::PerformConsistencyCheck() {
     return;
   }
 
-  // Verify that there are no entries in the document-mutation index if the
-  // queue is empty.
+  // Verify that there are no entries in the document-mutation or
+  // collection-mutation indexes if the queue is empty.
   std::string index_prefix = LevelDbDocumentMutationKey::KeyPrefix(user_id_);
   auto index_iterator = db_.currentTransaction->NewIterator();
   index_iterator->Seek(index_prefix);
@@ -396,6 +478,16 @@ void LevelDbMutationQueue::PerformConsistencyCheck() {
     dangling_mutation_references.push_back(DescribeKey(index_iterator));
   }
 
+  index_prefix = LevelDbCollectionMutationKey::KeyPrefix(user_id_);
+  index_iterator->Seek(index_prefix);
+  for (; index_iterator->Valid(); index_iterator->Next()) {
+    if (!absl::StartsWith(index_iterator->key(), index_prefix)) {
+      break;
+    }
+
+    dangling_mutation_references.push_back(DescribeKey(index_iterator));
+  }
+
   HARD_ASSERT(
       dangling_mutation_references.empty(),
       "Document leak -- detected dangling mutation references when queue "
@@ -413,6 +505,11 @@ void LevelDbMutationQueue::SetLastStreamToken(NSData* _Nullable stream_token) {
   db_.currentTransaction->Put(mutation_queue_key(), metadata_);
 }
 
+void LevelDbMutationQueue::TrimMemory(size_t budget_bytes) {
+  std::lock_guard<std::mutex> lock{decoded_batches_mutex_};
+  decoded_batches_.Trim(budget_bytes);
+}
+
 std::vector<FSTMutationBatch*> LevelDbMutationQueue::AllMutationBatchesWithIds(
     const std::set<BatchId>& batch_ids) {
   std::vector<FSTMutationBatch*> result;
@@ -430,7 +527,8 @@ std::vector<FSTMutationBatch*> LevelDbMutationQueue::AllMutationBatchesWithIds(
                 DescribeKey(mutation_key), DescribeKey(mutation_iterator));
     }
 
-    result.push_back(ParseMutationBatch(mutation_iterator->value()));
+    result.push_back(
+        ParseMutationBatch(batch_id, mutation_iterator->value()));
   }
   return result;
 }
@@ -460,7 +558,15 @@ FSTPBMutationQueue* _Nullable LevelDbMutationQueue::MetadataForKey(
 }
 
 FSTMutationBatch* LevelDbMutationQueue::ParseMutationBatch(
-    absl::string_view encoded) {
+    BatchId batch_id, absl::string_view encoded) {
+  {
+    std::lock_guard<std::mutex> lock{decoded_batches_mutex_};
+    const DecodedBatch* cached = decoded_batches_.Get(batch_id);
+    if (cached && cached->encoded == encoded) {
+      return cached->batch;
+    }
+  }
+
   NSData* data = [[NSData alloc] initWithBytesNoCopy:(void*)encoded.data()
                                               length:encoded.size()
                                         freeWhenDone:NO];
@@ -471,7 +577,16 @@ FSTMutationBatch* LevelDbMutationQueue::ParseMutationBatch(
     HARD_FAIL("FSTPBMutationBatch failed to parse: %s", error);
   }
 
-  return [serializer_ decodedMutationBatch:proto];
+  FSTMutationBatch* batch = [serializer_ decodedMutationBatch:proto];
+  HARD_ASSERT(batch.batchID == batch_id,
+              "Read batch has ID (%s) instead of expected ID (%s).",
+              batch.batchID, batch_id);
+
+  std::string encoded_copy{encoded.data(), encoded.size()};
+  std::lock_guard<std::mutex> lock{decoded_batches_mutex_};
+  decoded_batches_.Put(batch_id, DecodedBatch{std::move(encoded_copy), batch},
+                       encoded.size());
+  return batch;
 }
 
 }  // namespace local
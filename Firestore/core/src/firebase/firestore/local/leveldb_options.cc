@@ -0,0 +1,61 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_options.h"
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+LevelDbOptions::LevelDbOptions(const api::PersistenceTuning& tuning) {
+  HARD_ASSERT(tuning.block_cache_size_bytes >= 0 &&
+                  tuning.write_buffer_size_bytes >= 0 &&
+                  tuning.block_size_bytes >= 0 &&
+                  tuning.bloom_filter_bits_per_key >= 0 &&
+                  tuning.group_commit_window_ms >= 0,
+              "Persistence tuning values must not be negative");
+
+  options_.create_if_missing = true;
+
+  if (tuning.block_cache_size_bytes > 0) {
+    block_cache_.reset(leveldb::NewLRUCache(
+        static_cast<size_t>(tuning.block_cache_size_bytes)));
+    options_.block_cache = block_cache_.get();
+  }
+  if (tuning.write_buffer_size_bytes > 0) {
+    options_.write_buffer_size =
+        static_cast<size_t>(tuning.write_buffer_size_bytes);
+  }
+  if (tuning.block_size_bytes > 0) {
+    options_.block_size = static_cast<size_t>(tuning.block_size_bytes);
+  }
+  if (tuning.bloom_filter_bits_per_key > 0) {
+    filter_policy_.reset(
+        leveldb::NewBloomFilterPolicy(tuning.bloom_filter_bits_per_key));
+    options_.filter_policy = filter_policy_.get();
+  }
+  if (!tuning.compression_enabled) {
+    options_.compression = leveldb::kNoCompression;
+  }
+
+  write_options_.sync = tuning.sync_writes_enabled;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
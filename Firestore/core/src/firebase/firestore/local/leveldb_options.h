@@ -0,0 +1,62 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_OPTIONS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_OPTIONS_H_
+
+#include <memory>
+
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
+#include "leveldb/cache.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/options.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * The options to open and write to a LevelDB database with, as configured by
+ * the given `PersistenceTuning`, along with the block cache and filter policy
+ * they point to, if any.
+ *
+ * Since the database refers to these until it's closed, a `LevelDbOptions`
+ * must outlive any database opened with its `options()`.
+ */
+class LevelDbOptions {
+ public:
+  explicit LevelDbOptions(const api::PersistenceTuning& tuning);
+
+  const leveldb::Options& options() const {
+    return options_;
+  }
+
+  const leveldb::WriteOptions& write_options() const {
+    return write_options_;
+  }
+
+ private:
+  leveldb::Options options_;
+  leveldb::WriteOptions write_options_;
+  std::unique_ptr<leveldb::Cache> block_cache_;
+  std::unique_ptr<const leveldb::FilterPolicy> filter_policy_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_OPTIONS_H_
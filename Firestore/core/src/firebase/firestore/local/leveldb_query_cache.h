@@ -23,7 +23,9 @@
 
 #import <Foundation/Foundation.h>
 
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 #include "Firestore/core/src/firebase/firestore/local/query_cache.h"
@@ -122,6 +124,19 @@ class LevelDbQueryCache : public QueryCache {
 
  private:
   void Save(FSTQueryData* query_data);
+
+  /**
+   * Reads all the targets for queries with the given canonical ID from
+   * LevelDB.
+   */
+  std::vector<FSTQueryData*> ReadTargets(const std::string& canonical_id);
+
+  /**
+   * Replaces the cached target with the same target ID as `query_data`, or
+   * adds it, if the targets for its canonical ID are cached.
+   */
+  void CacheTarget(FSTQueryData* query_data);
+
   bool UpdateMetadata(FSTQueryData* query_data);
   void SaveMetadata();
   /**
@@ -136,6 +151,15 @@ class LevelDbQueryCache : public QueryCache {
   /** A write-through cached copy of the metadata for the query cache. */
   FSTPBTargetGlobal* metadata_;
   model::SnapshotVersion last_remote_snapshot_version_;
+
+  /**
+   * A write-through cache of the targets for each canonical ID that GetTarget
+   * has looked up, so that listening to a query again doesn't read and decode
+   * its targets from LevelDB. Canonical IDs that haven't been looked up are
+   * missing rather than empty.
+   */
+  std::unordered_map<std::string, std::vector<FSTQueryData*>>
+      targets_by_canonical_id_;
 };
 
 }  // namespace local
@@ -16,8 +16,10 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_query_cache.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/Target.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
@@ -27,7 +29,6 @@
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
-#include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "absl/strings/match.h"
 
 namespace firebase {
@@ -39,7 +40,6 @@ using model::DocumentKeySet;
 using model::ListenSequenceNumber;
 using model::SnapshotVersion;
 using model::TargetId;
-using util::MakeString;
 using leveldb::Status;
 
 FSTPBTargetGlobal* LevelDbQueryCache::ReadMetadata(leveldb::DB* db) {
@@ -82,14 +82,17 @@ void LevelDbQueryCache::Start() {
               "ensures metadata existence");
   last_remote_snapshot_version_ =
       [serializer_ decodedVersion:metadata_.lastRemoteSnapshotVersion];
+
+  // Targets may have been written without going through this cache.
+  targets_by_canonical_id_.clear();
 }
 
 void LevelDbQueryCache::AddTarget(FSTQueryData* query_data) {
   Save(query_data);
+  CacheTarget(query_data);
 
-  NSString* canonical_id = query_data.query.canonicalID;
-  std::string index_key =
-      LevelDbQueryTargetKey::Key(MakeString(canonical_id), query_data.targetID);
+  std::string index_key = LevelDbQueryTargetKey::Key(
+      query_data.query.canonicalIDString, query_data.targetID);
   std::string empty_buffer;
   db_.currentTransaction->Put(index_key, empty_buffer);
 
@@ -100,6 +103,7 @@ void LevelDbQueryCache::AddTarget(FSTQueryData* query_data) {
 
 void LevelDbQueryCache::UpdateTarget(FSTQueryData* query_data) {
   Save(query_data);
+  CacheTarget(query_data);
 
   if (UpdateMetadata(query_data)) {
     SaveMetadata();
@@ -114,19 +118,48 @@ void LevelDbQueryCache::RemoveTarget(FSTQueryData* query_data) {
   std::string key = LevelDbTargetKey::Key(target_id);
   db_.currentTransaction->Delete(key);
 
-  std::string index_key = LevelDbQueryTargetKey::Key(
-      MakeString(query_data.query.canonicalID), target_id);
+  const std::string& canonical_id = query_data.query.canonicalIDString;
+  std::string index_key = LevelDbQueryTargetKey::Key(canonical_id, target_id);
   db_.currentTransaction->Delete(index_key);
 
+  auto cached = targets_by_canonical_id_.find(canonical_id);
+  if (cached != targets_by_canonical_id_.end()) {
+    std::vector<FSTQueryData*>& targets = cached->second;
+    targets.erase(std::remove_if(targets.begin(), targets.end(),
+                                 [&](FSTQueryData* target) {
+                                   return target.targetID == target_id;
+                                 }),
+                  targets.end());
+  }
+
   metadata_.targetCount--;
   SaveMetadata();
 }
 
 FSTQueryData* _Nullable LevelDbQueryCache::GetTarget(FSTQuery* query) {
+  const std::string& canonical_id = query.canonicalIDString;
+  auto cached = targets_by_canonical_id_.find(canonical_id);
+  if (cached == targets_by_canonical_id_.end()) {
+    cached = targets_by_canonical_id_
+                 .emplace(canonical_id, ReadTargets(canonical_id))
+                 .first;
+  }
+
+  // Canonical IDs are not required to be unique per target, so check that the
+  // query is actually equal to the requested query.
+  for (FSTQueryData* target : cached->second) {
+    if ([target.query isEqual:query]) {
+      return target;
+    }
+  }
+  return nil;
+}
+
+std::vector<FSTQueryData*> LevelDbQueryCache::ReadTargets(
+    const std::string& canonical_id) {
   // Scan the query-target index starting with a prefix starting with the given
   // query's canonicalID. Note that this is a scan rather than a get because
   // canonicalIDs are not required to be unique per target.
-  std::string canonical_id = MakeString(query.canonicalID);
   auto index_iterator = db_.currentTransaction->NewIterator();
   std::string index_prefix = LevelDbQueryTargetKey::KeyPrefix(canonical_id);
   index_iterator->Seek(index_prefix);
@@ -138,6 +171,7 @@ FSTQueryData* _Nullable LevelDbQueryCache::GetTarget(FSTQuery* query) {
   std::string target_prefix = LevelDbTargetKey::KeyPrefix();
   auto target_iterator = db_.currentTransaction->NewIterator();
 
+  std::vector<FSTQueryData*> result;
   LevelDbQueryTargetKey row_key;
   for (; index_iterator->Valid(); index_iterator->Next()) {
     // Only consider rows matching exactly the specific canonicalID of interest.
@@ -159,21 +193,36 @@ FSTQueryData* _Nullable LevelDbQueryCache::GetTarget(FSTQuery* query) {
                 DescribeKey(target_iterator));
     }
 
-    // Finally after finding a potential match, check that the query is actually
-    // equal to the requested query.
-    FSTQueryData* target = DecodeTarget(target_iterator->value());
-    if ([target.query isEqual:query]) {
-      return target;
-    }
+    result.push_back(DecodeTarget(target_iterator->value()));
   }
 
-  return nil;
+  return result;
+}
+
+void LevelDbQueryCache::CacheTarget(FSTQueryData* query_data) {
+  auto cached =
+      targets_by_canonical_id_.find(query_data.query.canonicalIDString);
+  if (cached == targets_by_canonical_id_.end()) {
+    return;
+  }
+
+  std::vector<FSTQueryData*>& targets = cached->second;
+  auto found = std::find_if(targets.begin(), targets.end(),
+                            [&](FSTQueryData* target) {
+                              return target.targetID == query_data.targetID;
+                            });
+  if (found != targets.end()) {
+    *found = query_data;
+  } else {
+    targets.push_back(query_data);
+  }
 }
 
 void LevelDbQueryCache::EnumerateTargets(const TargetCallback& callback) {
   // Enumerate all targets, give their sequence numbers.
   std::string target_prefix = LevelDbTargetKey::KeyPrefix();
-  auto it = db_.currentTransaction->NewIterator();
+  auto it = db_.currentTransaction->NewIterator(
+      LevelDbTransaction::OneOffScanReadOptions());
   it->Seek(target_prefix);
   for (; it->Valid() && absl::StartsWith(it->key(), target_prefix);
        it->Next()) {
@@ -187,7 +236,8 @@ int LevelDbQueryCache::RemoveTargets(
     const std::unordered_map<model::TargetId, FSTQueryData*>& live_targets) {
   int count = 0;
   std::string target_prefix = LevelDbTargetKey::KeyPrefix();
-  auto it = db_.currentTransaction->NewIterator();
+  auto it = db_.currentTransaction->NewIterator(
+      LevelDbTransaction::OneOffScanReadOptions());
   it->Seek(target_prefix);
   for (; it->Valid() && absl::StartsWith(it->key(), target_prefix);
        it->Next()) {
@@ -209,22 +259,30 @@ void LevelDbQueryCache::AddMatchingKeys(const DocumentKeySet& keys,
   // buffer (and the parser will see all default values).
   std::string empty_buffer;
 
+  LevelDbTransaction* transaction = db_.currentTransaction;
   for (const DocumentKey& key : keys) {
-    db_.currentTransaction->Put(LevelDbTargetDocumentKey::Key(target_id, key),
-                                empty_buffer);
-    db_.currentTransaction->Put(LevelDbDocumentTargetKey::Key(key, target_id),
-                                empty_buffer);
+    std::string* row_key = transaction->ClearedKeyBuffer();
+    LevelDbTargetDocumentKey::AppendKey(row_key, target_id, key);
+    transaction->Put(*row_key, empty_buffer);
+
+    row_key = transaction->ClearedKeyBuffer();
+    LevelDbDocumentTargetKey::AppendKey(row_key, key, target_id);
+    transaction->Put(*row_key, empty_buffer);
     [db_.referenceDelegate addReference:key];
   };
 }
 
 void LevelDbQueryCache::RemoveMatchingKeys(const DocumentKeySet& keys,
                                            TargetId target_id) {
+  LevelDbTransaction* transaction = db_.currentTransaction;
   for (const DocumentKey& key : keys) {
-    db_.currentTransaction->Delete(
-        LevelDbTargetDocumentKey::Key(target_id, key));
-    db_.currentTransaction->Delete(
-        LevelDbDocumentTargetKey::Key(key, target_id));
+    std::string* row_key = transaction->ClearedKeyBuffer();
+    LevelDbTargetDocumentKey::AppendKey(row_key, target_id, key);
+    transaction->Delete(*row_key);
+
+    row_key = transaction->ClearedKeyBuffer();
+    LevelDbDocumentTargetKey::AppendKey(row_key, key, target_id);
+    transaction->Delete(*row_key);
     [db_.referenceDelegate removeReference:key];
   }
 }
@@ -256,7 +314,9 @@ DocumentKeySet LevelDbQueryCache::GetMatchingKeys(TargetId target_id) {
   auto index_iterator = db_.currentTransaction->NewIterator();
   index_iterator->Seek(index_prefix);
 
-  DocumentKeySet result;
+  // Rows for a target are ordered by document key, so the set can be built in
+  // one pass once they've all been read.
+  std::vector<DocumentKey> result;
   LevelDbTargetDocumentKey row_key;
   for (; index_iterator->Valid(); index_iterator->Next()) {
     // TODO(gsoltis): could we use a StartsWith instead?
@@ -266,10 +326,10 @@ DocumentKeySet LevelDbQueryCache::GetMatchingKeys(TargetId target_id) {
       break;
     }
 
-    result = result.insert(row_key.document_key());
+    result.push_back(row_key.document_key());
   }
 
-  return result;
+  return DocumentKeySet::FromSortedRange(result);
 }
 
 bool LevelDbQueryCache::Contains(const DocumentKey& key) {
@@ -307,7 +367,8 @@ void LevelDbQueryCache::SetLastRemoteSnapshotVersion(SnapshotVersion version) {
 void LevelDbQueryCache::EnumerateOrphanedDocuments(
     const OrphanedDocumentCallback& callback) {
   std::string document_target_prefix = LevelDbDocumentTargetKey::KeyPrefix();
-  auto it = db_.currentTransaction->NewIterator();
+  auto it = db_.currentTransaction->NewIterator(
+      LevelDbTransaction::OneOffScanReadOptions());
   it->Seek(document_target_prefix);
   ListenSequenceNumber next_to_report = 0;
   DocumentKey key_to_report;
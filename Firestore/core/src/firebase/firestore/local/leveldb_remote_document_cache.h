@@ -21,14 +21,19 @@
 #error "For now, this file must only be included by ObjC source files."
 #endif  // !defined(__OBJC__)
 
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/local/document_compressor.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/lru_cache.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
 @class FSTLevelDB;
 @class FSTLocalSerializer;
@@ -44,22 +49,87 @@ namespace local {
 /** Cached Remote Documents backed by leveldb. */
 class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
  public:
-  LevelDbRemoteDocumentCache(FSTLevelDB* db, FSTLocalSerializer* serializer);
+  /**
+   * Creates a cache that keeps up to roughly `decoded_cache_size_bytes` of
+   * recently read documents in memory, saving repeated decoding.
+   *
+   * Rows compressed with `document_dictionary` can always be read back; new
+   * rows are only compressed if `compress_documents` is true.
+   */
+  LevelDbRemoteDocumentCache(
+      FSTLevelDB* db,
+      FSTLocalSerializer* serializer,
+      size_t decoded_cache_size_bytes,
+      absl::optional<std::string> document_dictionary = absl::nullopt,
+      bool compress_documents = false);
 
-  void Add(FSTMaybeDocument* document) override;
+  void Add(FSTMaybeDocument* document,
+           const model::SnapshotVersion& read_time) override;
   void Remove(const model::DocumentKey& key) override;
 
   FSTMaybeDocument* _Nullable Get(const model::DocumentKey& key) override;
   model::MaybeDocumentMap GetAll(const model::DocumentKeySet& keys) override;
   model::DocumentMap GetMatching(FSTQuery* query) override;
+  model::DocumentMap GetFirstMatching(
+      FSTQuery* query,
+      const absl::optional<model::DocumentKey>& start_after,
+      size_t limit) override;
+  model::DocumentMap GetReadSince(
+      FSTQuery* query, const model::SnapshotVersion& read_time) override;
+
+  /**
+   * Evicts the least recently read documents from memory until at most
+   * roughly `budget_bytes` of them remain.
+   */
+  void TrimMemory(size_t budget_bytes);
 
  private:
+  /**
+   * Scans the documents in the collection `query` is on, in key order,
+   * starting after `start_after` if given. If `limit` is given, only documents
+   * that match `query` are returned, up to `limit` of them.
+   */
+  model::DocumentMap ScanCollection(
+      FSTQuery* query,
+      const absl::optional<model::DocumentKey>& start_after,
+      absl::optional<size_t> limit);
+
+  /**
+   * Returns the documents in every collection with the given ID, found
+   * through the collection group documents index.
+   */
+  model::DocumentMap ScanCollectionGroup(const std::string& collection_id);
+
+  /**
+   * Deletes the rows recording the read time of the given document, if any.
+   */
+  void RemoveReadTime(const model::DocumentKey& key);
+
+  /**
+   * A previously decoded document along with the bytes it was decoded from.
+   * The bytes double as the version of the entry: a cached document is only
+   * reused if the row read from leveldb still has the same contents.
+   */
+  struct DecodedDocument {
+    std::string encoded;
+    FSTMaybeDocument* document;
+  };
+
   FSTMaybeDocument* DecodeMaybeDocument(absl::string_view encoded,
                                         const model::DocumentKey& key);
 
   // This instance is owned by FSTLevelDB; avoid a retain cycle.
   __weak FSTLevelDB* db_;
   FSTLocalSerializer* serializer_;
+
+  // Guarded by decoded_documents_mutex_, since snapshot reads decode
+  // documents off the worker queue.
+  std::mutex decoded_documents_mutex_;
+  util::LruCache<model::DocumentKey, DecodedDocument, model::DocumentKeyHash>
+      decoded_documents_;
+
+  absl::optional<DocumentCompressor> compressor_;
+  bool compress_documents_ = false;
 };
 
 }  // namespace local
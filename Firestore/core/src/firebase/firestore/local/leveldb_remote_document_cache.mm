@@ -18,7 +18,12 @@
 
 #import <Foundation/Foundation.h>
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <mutex>   // NOLINT(build/c++11)
 #include <string>
+#include <utility>
+#include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
@@ -27,13 +32,17 @@
 #import "Firestore/Source/Model/FSTDocument.h"
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/match.h"
 #include "leveldb/db.h"
 
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
 using firebase::firestore::model::MaybeDocumentMap;
+using firebase::firestore::model::SnapshotVersion;
 using leveldb::Status;
 
 namespace firebase {
@@ -41,21 +50,97 @@ namespace firestore {
 namespace local {
 
 LevelDbRemoteDocumentCache::LevelDbRemoteDocumentCache(
-    FSTLevelDB* db, FSTLocalSerializer* serializer)
-    : db_(db), serializer_(serializer) {
+    FSTLevelDB* db,
+    FSTLocalSerializer* serializer,
+    size_t decoded_cache_size_bytes,
+    absl::optional<std::string> document_dictionary,
+    bool compress_documents)
+    : db_(db),
+      serializer_(serializer),
+      decoded_documents_(decoded_cache_size_bytes) {
+  if (document_dictionary) {
+    compressor_.emplace(std::move(*document_dictionary));
+    compress_documents_ = compress_documents;
+  }
 }
 
-void LevelDbRemoteDocumentCache::Add(FSTMaybeDocument* document) {
-  std::string ldb_key = LevelDbRemoteDocumentKey::Key(document.key);
-  db_.currentTransaction->Put(ldb_key,
-                              [serializer_ encodedMaybeDocument:document]);
+void LevelDbRemoteDocumentCache::Add(FSTMaybeDocument* document,
+                                     const SnapshotVersion& read_time) {
+  std::string encoded = [serializer_ encodedMaybeDocumentBytes:document];
+  if (compress_documents_) {
+    encoded = compressor_->Compress(encoded);
+  }
+
+  // Each document takes several rows, so build their keys in the
+  // transaction's buffer rather than in a new string each.
+  LevelDbTransaction* transaction = db_.currentTransaction;
+  std::string* row_key = transaction->ClearedKeyBuffer();
+  LevelDbRemoteDocumentKey::AppendKey(row_key, document.key);
+  transaction->Put(*row_key, encoded);
+
+  row_key = transaction->ClearedKeyBuffer();
+  LevelDbCollectionGroupDocumentKey::AppendKey(row_key, document.key);
+  transaction->Put(*row_key, std::string{});
+
+  RemoveReadTime(document.key);
+  row_key = transaction->ClearedKeyBuffer();
+  LevelDbRemoteDocumentReadTimeKey::AppendKey(row_key, document.key, read_time);
+  transaction->Put(*row_key, std::string{});
+
+  row_key = transaction->ClearedKeyBuffer();
+  LevelDbDocumentReadTimeKey::AppendKey(row_key, document.key);
+  transaction->Put(*row_key,
+                   LevelDbDocumentReadTimeKey::EncodeReadTime(read_time));
+
+  // The document was just written so it's likely to be read again soon.
+  size_t cost = encoded.size();
+  {
+    std::lock_guard<std::mutex> lock{decoded_documents_mutex_};
+    decoded_documents_.Put(document.key,
+                           DecodedDocument{std::move(encoded), document}, cost);
+  }
 
   db_.indexManager->AddToCollectionParentIndex(document.key.path().PopLast());
+
+  if ([document isKindOfClass:[FSTDocument class]]) {
+    db_.indexManager->AddToFieldIndexes(
+        document.key, static_cast<FSTDocument*>(document).data);
+  } else {
+    db_.indexManager->RemoveFromFieldIndexes(document.key);
+  }
 }
 
 void LevelDbRemoteDocumentCache::Remove(const DocumentKey& key) {
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
   db_.currentTransaction->Delete(ldb_key);
+  db_.currentTransaction->Delete(LevelDbCollectionGroupDocumentKey::Key(key));
+  RemoveReadTime(key);
+  {
+    std::lock_guard<std::mutex> lock{decoded_documents_mutex_};
+    decoded_documents_.Erase(key);
+  }
+
+  db_.indexManager->RemoveFromFieldIndexes(key);
+}
+
+void LevelDbRemoteDocumentCache::RemoveReadTime(const DocumentKey& key) {
+  LevelDbTransaction* transaction = db_.currentTransaction;
+  std::string* row_key = transaction->ClearedKeyBuffer();
+  LevelDbDocumentReadTimeKey::AppendKey(row_key, key);
+  std::string value;
+  Status status = transaction->Get(*row_key, &value);
+  if (status.IsNotFound()) {
+    return;
+  }
+  HARD_ASSERT(status.ok(),
+              "Fetch read time for key (%s) failed with status: %s",
+              key.ToString(), status.ToString());
+  transaction->Delete(*row_key);
+
+  SnapshotVersion read_time = LevelDbDocumentReadTimeKey::DecodeReadTime(value);
+  row_key = transaction->ClearedKeyBuffer();
+  LevelDbRemoteDocumentReadTimeKey::AppendKey(row_key, key, read_time);
+  transaction->Delete(*row_key);
 }
 
 FSTMaybeDocument* _Nullable LevelDbRemoteDocumentCache::Get(
@@ -75,25 +160,103 @@ FSTMaybeDocument* _Nullable LevelDbRemoteDocumentCache::Get(
 
 MaybeDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const DocumentKeySet& keys) {
-  MaybeDocumentMap results;
+  // Document keys sort in the same order as their rows, so all the results can
+  // be gathered in a single forward pass over the table and then assembled
+  // into a map at once.
+  std::vector<std::pair<DocumentKey, FSTMaybeDocument*>> results;
+  results.reserve(keys.size());
 
-  LevelDbRemoteDocumentKey currentKey;
   auto it = db_.currentTransaction->NewIterator();
+  bool positioned = false;
 
   for (const DocumentKey& key : keys) {
-    it->Seek(LevelDbRemoteDocumentKey::Key(key));
-    if (!it->Valid() || !currentKey.Decode(it->key()) ||
-        currentKey.document_key() != key) {
-      results = results.insert(key, nil);
+    std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
+    if (!positioned) {
+      it->Seek(ldb_key);
+      positioned = true;
+    } else if (it->Valid() && it->key() < ldb_key) {
+      // Keys fetched together are frequently adjacent, in which case stepping
+      // to the next row is much cheaper than seeking from scratch.
+      it->Next();
+      if (it->Valid() && it->key() < ldb_key) {
+        it->Seek(ldb_key);
+      }
+    }
+
+    if (it->Valid() && it->key() == ldb_key) {
+      results.emplace_back(key, DecodeMaybeDocument(it->value(), key));
     } else {
-      results = results.insert(key, DecodeMaybeDocument(it->value(), key));
+      results.emplace_back(key, nil);
     }
   }
 
-  return results;
+  return MaybeDocumentMap::FromSortedRange(results);
 }
 
 DocumentMap LevelDbRemoteDocumentCache::GetMatching(FSTQuery* query) {
+  if ([query isCollectionGroupQuery]) {
+    return ScanCollectionGroup(*query.collectionGroup);
+  }
+  return ScanCollection(query, absl::nullopt, absl::nullopt);
+}
+
+DocumentMap LevelDbRemoteDocumentCache::GetFirstMatching(
+    FSTQuery* query,
+    const absl::optional<DocumentKey>& start_after,
+    size_t limit) {
+  return ScanCollection(query, start_after, limit);
+}
+
+DocumentMap LevelDbRemoteDocumentCache::GetReadSince(
+    FSTQuery* query, const SnapshotVersion& read_time) {
+  HARD_ASSERT(![query isCollectionGroupQuery] && ![query isDocumentQuery],
+              "GetReadSince only supports collection queries");
+
+  // The rows of the collection are ordered by read time, so those read since
+  // `read_time` are all at the end. Rows of subcollections come after them.
+  const model::ResourcePath& collection = query.path;
+  std::string index_prefix =
+      LevelDbRemoteDocumentReadTimeKey::KeyPrefix(collection);
+  auto index_iterator = db_.currentTransaction->NewIterator(
+      LevelDbTransaction::FastScanReadOptions());
+  index_iterator->Seek(
+      LevelDbRemoteDocumentReadTimeKey::KeyPrefix(collection, read_time));
+
+  std::vector<DocumentKey> keys;
+  LevelDbRemoteDocumentReadTimeKey row_key;
+  for (; index_iterator->Valid(); index_iterator->Next()) {
+    if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
+        !row_key.Decode(index_iterator->key()) ||
+        row_key.collection() != collection) {
+      break;
+    }
+    keys.push_back(row_key.document_key());
+  }
+
+  if (QueryProfile* profile = QueryProfile::current()) {
+    profile->documents_scanned += keys.size();
+  }
+
+  std::sort(keys.begin(), keys.end());
+  DocumentMap results;
+  for (const auto& kv : GetAll(DocumentKeySet::FromSortedRange(keys))) {
+    FSTMaybeDocument* maybe_doc = kv.second;
+    if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
+      results = results.insert(kv.first, static_cast<FSTDocument*>(maybe_doc));
+    }
+  }
+  return results;
+}
+
+void LevelDbRemoteDocumentCache::TrimMemory(size_t budget_bytes) {
+  std::lock_guard<std::mutex> lock{decoded_documents_mutex_};
+  decoded_documents_.Trim(budget_bytes);
+}
+
+DocumentMap LevelDbRemoteDocumentCache::ScanCollection(
+    FSTQuery* query,
+    const absl::optional<DocumentKey>& start_after,
+    absl::optional<size_t> limit) {
   HARD_ASSERT(
       ![query isCollectionGroupQuery],
       "CollectionGroup queries should be handled in LocalDocumentsView");
@@ -103,42 +266,128 @@ DocumentMap LevelDbRemoteDocumentCache::GetMatching(FSTQuery* query) {
   // Use the query path as a prefix for testing if a document matches the query.
   const model::ResourcePath& query_path = query.path;
   size_t immediate_children_path_length = query_path.size() + 1;
+  HARD_ASSERT(
+      !start_after || query_path.IsImmediateParentOf(start_after->path()),
+      "Can only start after a document in the queried collection");
 
   // Documents are ordered by key, so we can use a prefix scan to narrow down
-  // the documents we need to match the query against.
-  std::string start_key = LevelDbRemoteDocumentKey::KeyPrefix(query_path);
-  auto it = db_.currentTransaction->NewIterator();
+  // the documents we need to match the query against. Starting after a
+  // document skips both it and its subcollections.
+  std::string start_key =
+      start_after ? LevelDbRemoteDocumentKey::KeyPrefixEnd(start_after->path())
+                  : LevelDbRemoteDocumentKey::KeyPrefix(query_path);
+  auto it = db_.currentTransaction->NewIterator(
+      LevelDbTransaction::FastScanReadOptions());
   it->Seek(start_key);
 
-  LevelDbRemoteDocumentKey current_key;
-  for (; it->Valid() && current_key.Decode(it->key()); it->Next()) {
-    // The query is actually returning any path that starts with the query path
-    // prefix which may include documents in subcollections. For example, a
-    // query on 'rooms' will return rooms/abc/messages/xyx but we shouldn't
-    // match it. Fix this by discarding rows with document keys more than one
-    // segment longer than the query path.
-    const DocumentKey& document_key = current_key.document_key();
-    if (document_key.path().size() != immediate_children_path_length) {
+  // Decode just views of the path segments, since most rows are rejected
+  // before their DocumentKey would be needed.
+  LevelDbRemoteDocumentKeyView current_key;
+  while (it->Valid() && current_key.Decode(it->key()) &&
+         (!limit || results.size() < *limit)) {
+    const LevelDbPathView& path = current_key.path();
+    if (!path.HasPrefix(query_path)) {
+      break;
+    }
+
+    // The prefix scan also returns documents in subcollections. For example, a
+    // query on 'rooms' will see rooms/abc/messages/xyx but we shouldn't match
+    // it. Rather than walking these rows one by one, seek past everything
+    // nested under the direct child (rooms/abc) in one step.
+    if (path.size() != immediate_children_path_length) {
+      model::ResourcePath child_path =
+          query_path.Append(std::string{path[query_path.size()]});
+      it->Seek(LevelDbRemoteDocumentKey::KeyPrefixEnd(child_path));
       continue;
     }
 
+    if (QueryProfile* profile = QueryProfile::current()) {
+      profile->documents_scanned++;
+    }
+
+    DocumentKey document_key = current_key.document_key();
     FSTMaybeDocument* maybe_doc =
         DecodeMaybeDocument(it->value(), document_key);
-    if (!query_path.IsPrefixOf(maybe_doc.key.path())) {
+    if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
+      auto* doc = static_cast<FSTDocument*>(maybe_doc);
+      if (!limit || [query matchesDocument:doc]) {
+        results = results.insert(maybe_doc.key, doc);
+      }
+    }
+    it->Next();
+  }
+
+  return results;
+}
+
+DocumentMap LevelDbRemoteDocumentCache::ScanCollectionGroup(
+    const std::string& collection_id) {
+  // The index rows of the group are contiguous and in the same order as the
+  // documents they refer to, so their keys can be gathered in one scan and
+  // the documents then read in a single forward pass.
+  std::string index_prefix =
+      LevelDbCollectionGroupDocumentKey::KeyPrefix(collection_id);
+  auto index_iterator = db_.currentTransaction->NewIterator(
+      LevelDbTransaction::FastScanReadOptions());
+  index_iterator->Seek(index_prefix);
+
+  std::vector<DocumentKey> keys;
+  LevelDbCollectionGroupDocumentKey row_key;
+  for (; index_iterator->Valid(); index_iterator->Next()) {
+    if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
+        !row_key.Decode(index_iterator->key())) {
       break;
-    } else if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
-      results =
-          results.insert(maybe_doc.key, static_cast<FSTDocument*>(maybe_doc));
     }
+    keys.push_back(row_key.document_key());
+  }
+
+  if (QueryProfile* profile = QueryProfile::current()) {
+    profile->documents_scanned += keys.size();
   }
 
+  DocumentMap results;
+  for (const auto& kv : GetAll(DocumentKeySet::FromSortedRange(keys))) {
+    FSTMaybeDocument* maybe_doc = kv.second;
+    if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
+      results = results.insert(kv.first, static_cast<FSTDocument*>(maybe_doc));
+    }
+  }
   return results;
 }
 
 FSTMaybeDocument* LevelDbRemoteDocumentCache::DecodeMaybeDocument(
     absl::string_view encoded, const DocumentKey& key) {
-  NSData* data = [[NSData alloc] initWithBytesNoCopy:(void*)encoded.data()
-                                              length:encoded.size()
+  {
+    std::lock_guard<std::mutex> lock{decoded_documents_mutex_};
+    const DecodedDocument* cached = decoded_documents_.Get(key);
+    if (cached && cached->encoded == encoded) {
+      return cached->document;
+    }
+  }
+
+  using Clock = std::chrono::steady_clock;
+  QueryProfile* profile = QueryProfile::current();
+  Clock::time_point decode_start;
+  if (profile) {
+    decode_start = Clock::now();
+  }
+
+  // Keeps the decompressed bytes alive while they're parsed.
+  std::string decompressed;
+  absl::string_view proto_bytes = encoded;
+  if (DocumentCompressor::IsCompressed(encoded)) {
+    HARD_ASSERT(compressor_,
+                "Document %s is compressed but there's no dictionary",
+                key.ToString());
+    util::StatusOr<std::string> result = compressor_->Decompress(encoded);
+    HARD_ASSERT(result.ok(), "Failed to decompress document %s: %s",
+                key.ToString(), result.status().ToString());
+    decompressed = std::move(result.ValueOrDie());
+    proto_bytes = decompressed;
+  }
+
+  NSData* data = [[NSData alloc] initWithBytesNoCopy:(void*)proto_bytes.data()
+                                              length:proto_bytes.size()
                                         freeWhenDone:false];
 
   NSError* error;
@@ -152,6 +401,17 @@ FSTMaybeDocument* LevelDbRemoteDocumentCache::DecodeMaybeDocument(
   HARD_ASSERT(maybeDocument.key == key,
               "Read document has key (%s) instead of expected key (%s).",
               maybeDocument.key.ToString(), key.ToString());
+
+  if (profile) {
+    profile->decode_time += std::chrono::duration_cast<QueryProfile::Duration>(
+        Clock::now() - decode_start);
+  }
+
+  std::string encoded_copy{encoded.data(), encoded.size()};
+  std::lock_guard<std::mutex> lock{decoded_documents_mutex_};
+  decoded_documents_.Put(
+      key, DecodedDocument{std::move(encoded_copy), maybeDocument},
+      encoded.size());
   return maybeDocument;
 }
 
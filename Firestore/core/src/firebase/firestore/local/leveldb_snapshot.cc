@@ -0,0 +1,85 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_snapshot.h"
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/base/config.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+thread_local LevelDbSnapshot* current_snapshot = nullptr;
+#endif
+
+leveldb::ReadOptions ReadOptionsAt(const leveldb::Snapshot* snapshot) {
+  leveldb::ReadOptions options = LevelDbTransaction::DefaultReadOptions();
+  options.snapshot = snapshot;
+  return options;
+}
+
+}  // namespace
+
+LevelDbSnapshot::LevelDbSnapshot(leveldb::DB* db, absl::string_view label)
+    : db_{db},
+      snapshot_{db->GetSnapshot()},
+      transaction_{db, label, ReadOptionsAt(snapshot_)} {
+}
+
+LevelDbSnapshot::~LevelDbSnapshot() {
+  HARD_ASSERT(transaction_.changed_keys() == 0,
+              "Read-only transaction has pending changes: %s",
+              transaction_.ToString());
+  db_->ReleaseSnapshot(snapshot_);
+}
+
+LevelDbSnapshot* LevelDbSnapshot::current() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  return current_snapshot;
+#else
+  return nullptr;
+#endif
+}
+
+bool LevelDbSnapshot::ScopesSupported() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  return true;
+#else
+  return false;
+#endif
+}
+
+LevelDbSnapshotScope::LevelDbSnapshotScope(LevelDbSnapshot* snapshot) {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  previous_ = current_snapshot;
+  current_snapshot = snapshot;
+#else
+  (void)snapshot;
+#endif
+}
+
+LevelDbSnapshotScope::~LevelDbSnapshotScope() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  current_snapshot = previous_;
+#endif
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
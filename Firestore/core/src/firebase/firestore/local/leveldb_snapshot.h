@@ -0,0 +1,87 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SNAPSHOT_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SNAPSHOT_H_
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "absl/strings/string_view.h"
+#include "leveldb/db.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * A read-only transaction over a leveldb snapshot: all of its reads see the
+ * database as it was when the snapshot was taken, whatever transactions commit
+ * meanwhile. Since it leaves the database as it is, it can run on another
+ * thread while transactions keep running on the worker queue.
+ */
+class LevelDbSnapshot {
+ public:
+  LevelDbSnapshot(leveldb::DB* db, absl::string_view label);
+  ~LevelDbSnapshot();
+
+  LevelDbSnapshot(const LevelDbSnapshot&) = delete;
+  LevelDbSnapshot& operator=(const LevelDbSnapshot&) = delete;
+
+  /** The transaction to read through. Must not be written to. */
+  LevelDbTransaction* transaction() {
+    return &transaction_;
+  }
+
+  /**
+   * Returns the snapshot of the innermost LevelDbSnapshotScope active on this
+   * thread, or null if there is none. Always null on platforms without
+   * `thread_local`.
+   */
+  static LevelDbSnapshot* current();
+
+  /**
+   * Returns true if scopes take effect on this platform, so that snapshots can
+   * be read from threads other than the worker queue.
+   */
+  static bool ScopesSupported();
+
+ private:
+  leveldb::DB* db_ = nullptr;
+  const leveldb::Snapshot* snapshot_ = nullptr;
+  LevelDbTransaction transaction_;
+};
+
+/**
+ * Makes a LevelDbSnapshot the transaction persistence reads through on the
+ * current thread for the lifetime of this object. Scopes nest; the previous
+ * snapshot is restored when a scope ends.
+ */
+class LevelDbSnapshotScope {
+ public:
+  explicit LevelDbSnapshotScope(LevelDbSnapshot* snapshot);
+  ~LevelDbSnapshotScope();
+
+  LevelDbSnapshotScope(const LevelDbSnapshotScope&) = delete;
+  LevelDbSnapshotScope& operator=(const LevelDbSnapshotScope&) = delete;
+
+ private:
+  LevelDbSnapshot* previous_ = nullptr;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_SNAPSHOT_H_
@@ -16,9 +16,15 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "leveldb/write_batch.h"
@@ -34,11 +40,21 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+using util::Histogram;
+using util::MetricsRegistry;
+
 LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn)
-    : db_iter_(txn->db_->NewIterator(txn->read_options_)),
+    : Iterator(txn, txn->read_options_) {
+}
+
+LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn,
+                                       const ReadOptions& read_options)
+    : db_iter_(txn->db_->NewIterator(read_options)),
+      read_options_(read_options),
       last_version_(txn->version_),
+      last_chunks_committed_(txn->chunks_committed_),
       txn_(txn),
-      mutations_iter_(txn->mutations_.begin()),
+      change_index_(0),
       current_(),
       is_mutation_(false),
       // Iterator doesn't really point to anything yet, so is
@@ -47,7 +63,12 @@ LevelDbTransaction::Iterator::Iterator(LevelDbTransaction* txn)
 }
 
 void LevelDbTransaction::Iterator::UpdateCurrent() {
-  bool mutation_is_valid = mutations_iter_ != txn_->mutations_.end();
+  const std::vector<const LevelDbWriteBuffer::Change*>& changes =
+      txn_->changes_.Sorted();
+  while (change_index_ < changes.size() && changes[change_index_]->deleted) {
+    ++change_index_;
+  }
+  bool mutation_is_valid = change_index_ < changes.size();
   is_valid_ = mutation_is_valid || db_iter_->Valid();
 
   if (is_valid_) {
@@ -60,25 +81,35 @@ void LevelDbTransaction::Iterator::UpdateCurrent() {
       // than the current mutation key, we are looking at a mutation next. It's
       // either sooner in the iteration or directly shadowing the underlying
       // committed value in leveldb.
-      is_mutation_ = db_iter_->key().compare(mutations_iter_->first) >= 0;
+      is_mutation_ = db_iter_->key().compare(changes[change_index_]->key) >= 0;
     }
     if (is_mutation_) {
-      current_ = *mutations_iter_;
+      const LevelDbWriteBuffer::Change& change = *changes[change_index_];
+      current_ = {change.key, change.value};
     } else {
       current_ = {db_iter_->key().ToString(), db_iter_->value().ToString()};
+      txn_->stats_.bytes_read += current_.first.size() + current_.second.size();
     }
   }
 }
 
 void LevelDbTransaction::Iterator::Seek(const std::string& key) {
+  if (last_chunks_committed_ < txn_->chunks_committed_) {
+    // The changes written in the chunk are no longer pending, so look for them
+    // in a fresh view of leveldb.
+    db_iter_.reset(txn_->db_->NewIterator(read_options_));
+    last_chunks_committed_ = txn_->chunks_committed_;
+  }
   db_iter_->Seek(key);
+  txn_->stats_.iterator_steps++;
   HARD_ASSERT(db_iter_->status().ok(), "leveldb iterator reported an error: %s",
               db_iter_->status().ToString());
   for (; db_iter_->Valid() && IsDeleted(db_iter_->key()); db_iter_->Next()) {
+    txn_->stats_.iterator_steps++;
   }
   HARD_ASSERT(db_iter_->status().ok(), "leveldb iterator reported an error: %s",
               db_iter_->status().ToString());
-  mutations_iter_ = txn_->mutations_.lower_bound(key);
+  change_index_ = txn_->changes_.LowerBound(key);
   UpdateCurrent();
   last_version_ = txn_->version_;
 }
@@ -94,7 +125,9 @@ absl::string_view LevelDbTransaction::Iterator::value() {
 }
 
 bool LevelDbTransaction::Iterator::IsDeleted(leveldb::Slice slice) {
-  return txn_->deletions_.find(slice.ToString()) != txn_->deletions_.end();
+  const LevelDbWriteBuffer::Change* change =
+      txn_->changes_.Find(absl::string_view{slice.data(), slice.size()});
+  return change && change->deleted;
 }
 
 bool LevelDbTransaction::Iterator::SyncToTransaction() {
@@ -113,6 +146,7 @@ bool LevelDbTransaction::Iterator::SyncToTransaction() {
 void LevelDbTransaction::Iterator::AdvanceLDB() {
   do {
     db_iter_->Next();
+    txn_->stats_.iterator_steps++;
   } while (db_iter_->Valid() && IsDeleted(db_iter_->key()));
   HARD_ASSERT(db_iter_->status().ok(), "leveldb iterator reported an error: %s",
               db_iter_->status().ToString());
@@ -124,10 +158,10 @@ void LevelDbTransaction::Iterator::Next() {
   if (!advanced && is_valid_) {
     if (is_mutation_) {
       // A mutation might be shadowing leveldb. If so, advance both.
-      if (db_iter_->Valid() && db_iter_->key() == mutations_iter_->first) {
+      if (db_iter_->Valid() && db_iter_->key() == current_.first) {
         AdvanceLDB();
       }
-      ++mutations_iter_;
+      ++change_index_;
     } else {
       AdvanceLDB();
     }
@@ -140,11 +174,12 @@ LevelDbTransaction::LevelDbTransaction(DB* db,
                                        const ReadOptions& read_options,
                                        const WriteOptions& write_options)
     : db_(db),
-      mutations_(),
-      deletions_(),
       read_options_(read_options),
       write_options_(write_options),
       version_(0),
+      chunks_committed_(0),
+      changed_bytes_(0),
+      peak_changed_bytes_(0),
       label_(std::string{label}) {
 }
 
@@ -157,74 +192,175 @@ const ReadOptions& LevelDbTransaction::DefaultReadOptions() {
   return options;
 }
 
+const ReadOptions& LevelDbTransaction::FastScanReadOptions() {
+  static ReadOptions options = ([]() {
+    ReadOptions read_options;
+    read_options.verify_checksums = false;
+    return read_options;
+  })();
+  return options;
+}
+
+const ReadOptions& LevelDbTransaction::OneOffScanReadOptions() {
+  static ReadOptions options = ([]() {
+    ReadOptions read_options;
+    read_options.verify_checksums = false;
+    read_options.fill_cache = false;
+    return read_options;
+  })();
+  return options;
+}
+
 const WriteOptions& LevelDbTransaction::DefaultWriteOptions() {
   static WriteOptions options;
   return options;
 }
 
 void LevelDbTransaction::Put(std::string key, std::string value) {
-  deletions_.erase(key);
-  mutations_.emplace(std::make_pair(std::move(key), std::move(value)));
+  const LevelDbWriteBuffer::Change* existing = changes_.Find(key);
+  if (existing) {
+    changed_bytes_ -= key.size() + existing->value.size();
+  }
+  AddChangedBytes(key.size() + value.size());
+  changes_.Put(std::move(key), std::move(value));
   version_++;
 }
 
+void LevelDbTransaction::AddChangedBytes(size_t bytes) {
+  changed_bytes_ += bytes;
+  peak_changed_bytes_ = std::max(peak_changed_bytes_, changed_bytes_);
+}
+
 std::unique_ptr<LevelDbTransaction::Iterator>
 LevelDbTransaction::NewIterator() {
   return absl::make_unique<LevelDbTransaction::Iterator>(this);
 }
 
+std::unique_ptr<LevelDbTransaction::Iterator> LevelDbTransaction::NewIterator(
+    const ReadOptions& read_options) {
+  if (read_options.snapshot || !read_options_.snapshot) {
+    return absl::make_unique<LevelDbTransaction::Iterator>(this, read_options);
+  }
+
+  // Iterators read at the transaction's snapshot whatever options they use.
+  ReadOptions at_snapshot = read_options;
+  at_snapshot.snapshot = read_options_.snapshot;
+  return absl::make_unique<LevelDbTransaction::Iterator>(this, at_snapshot);
+}
+
 Status LevelDbTransaction::Get(absl::string_view key, std::string* value) {
-  std::string key_string(key);
-  if (deletions_.find(key_string) != deletions_.end()) {
-    return Status::NotFound(key_string + " is not present in the transaction");
+  const LevelDbWriteBuffer::Change* change = changes_.Find(key);
+  if (change && change->deleted) {
+    return Status::NotFound(std::string{key} +
+                            " is not present in the transaction");
+  } else if (change) {
+    *value = change->value;
+    return Status::OK();
   } else {
-    Mutations::iterator iter{mutations_.find(key_string)};
-    if (iter != mutations_.end()) {
-      *value = iter->second;
-      return Status::OK();
-    } else {
-      return db_->Get(read_options_, key_string, value);
+    stats_.reads++;
+    Status status = db_->Get(read_options_, MakeSlice(key), value);
+    if (status.ok()) {
+      stats_.bytes_read += value->size();
     }
+    return status;
   }
 }
 
 void LevelDbTransaction::Delete(absl::string_view key) {
-  std::string to_delete(key);
-  deletions_.insert(to_delete);
-  mutations_.erase(to_delete);
+  const LevelDbWriteBuffer::Change* existing = changes_.Find(key);
+  if (!existing || !existing->deleted) {
+    if (existing) {
+      changed_bytes_ -= key.size() + existing->value.size();
+    }
+    AddChangedBytes(key.size());
+    changes_.Delete(key);
+  }
   version_++;
 }
 
-void LevelDbTransaction::Commit() {
-  WriteBatch batch;
-  for (const auto& deletion : deletions_) {
-    batch.Delete(deletion);
+std::vector<absl::string_view> LevelDbTransaction::deletions() {
+  std::vector<absl::string_view> result;
+  for (const LevelDbWriteBuffer::Change* change : changes_.Sorted()) {
+    if (change->deleted) {
+      result.push_back(change->key);
+    }
   }
+  return result;
+}
 
-  for (const auto& entry : mutations_) {
-    batch.Put(entry.first, entry.second);
+void LevelDbTransaction::Commit() {
+  LOG_DEBUG("Committing transaction: %s", ToString());
+  WriteChanges();
+  LOG_DEBUG("Committed transaction %s with at most %s bytes pending", label_,
+            peak_changed_bytes_);
+  RecordStats();
+}
+
+void LevelDbTransaction::CommitChunkIfLarger(size_t max_bytes) {
+  if (changed_bytes_ < max_bytes) {
+    return;
   }
 
-  LOG_DEBUG("Committing transaction: %s", ToString());
+  LOG_DEBUG("Committing chunk of transaction: %s", ToString());
+  WriteChanges();
+  changes_.Clear();
+  changed_bytes_ = 0;
+  chunks_committed_++;
+  version_++;
+}
+
+void LevelDbTransaction::WriteChanges() {
+  // Writing the batch in key order keeps the inserts into leveldb's memtable
+  // sequential.
+  WriteBatch batch;
+  for (const LevelDbWriteBuffer::Change* change : changes_.Sorted()) {
+    if (change->deleted) {
+      batch.Delete(change->key);
+    } else {
+      batch.Put(change->key, change->value);
+    }
+  }
 
   Status status = db_->Write(write_options_, &batch);
   HARD_ASSERT(status.ok(), "Failed to commit transaction:\n%s\n Failed: %s",
               ToString(), status.ToString());
+  stats_.writes += changed_keys();
+  stats_.bytes_written += changed_bytes_;
+}
+
+void LevelDbTransaction::RecordStats() const {
+  static Histogram& reads =
+      MetricsRegistry::Default().GetHistogram("leveldb.transaction.reads");
+  static Histogram& bytes_read =
+      MetricsRegistry::Default().GetHistogram("leveldb.transaction.bytes_read");
+  static Histogram& writes =
+      MetricsRegistry::Default().GetHistogram("leveldb.transaction.writes");
+  static Histogram& bytes_written = MetricsRegistry::Default().GetHistogram(
+      "leveldb.transaction.bytes_written");
+  static Histogram& iterator_steps = MetricsRegistry::Default().GetHistogram(
+      "leveldb.transaction.iterator_steps");
+
+  reads.Record(stats_.reads);
+  bytes_read.Record(stats_.bytes_read);
+  writes.Record(stats_.writes);
+  bytes_written.Record(stats_.bytes_written);
+  iterator_steps.Record(stats_.iterator_steps);
 }
 
 std::string LevelDbTransaction::ToString() {
   std::string dest = absl::StrCat("<LevelDbTransaction ", label_, ": ");
-  size_t changes = deletions_.size() + mutations_.size();
+  size_t changes = changes_.size();
   size_t bytes = 0;  // accumulator for size of individual mutations.
   dest += std::to_string(changes) + " changes ";
   std::string items;  // accumulator for individual changes.
-  for (const auto& deletion : deletions_) {
+  for (absl::string_view deletion : deletions()) {
     absl::StrAppend(&items, "\n  - Delete ", DescribeKey(deletion));
   }
-  for (const auto& entry : mutations_) {
-    size_t change_bytes = entry.second.size();
+  for (const LevelDbWriteBuffer::Change* change : changes_.Sorted()) {
+    if (change->deleted) continue;
+    size_t change_bytes = change->value.size();
     bytes += change_bytes;
-    absl::StrAppend(&items, "\n  - Put ", DescribeKey(entry.first), " (",
+    absl::StrAppend(&items, "\n  - Put ", DescribeKey(change->key), " (",
                     change_bytes, " bytes)");
   }
   absl::StrAppend(&dest, "(", bytes, " bytes):", items, ">");
@@ -17,13 +17,14 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_TRANSACTION_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_TRANSACTION_H_
 
+#include <cstddef>
 #include <cstdint>
-#include <map>
 #include <memory>
-#include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "Firestore/core/src/firebase/firestore/local/leveldb_write_buffer.h"
 #include "absl/strings/string_view.h"
 #include "leveldb/db.h"
 
@@ -41,9 +42,6 @@ namespace local {
  * changes and committed values.
  */
 class LevelDbTransaction {
-  using Deletions = std::set<std::string>;
-  using Mutations = std::map<std::string, std::string>;
-
  public:
   /**
    * Iterator iterates over a merged view of pending changes from the
@@ -53,6 +51,12 @@ class LevelDbTransaction {
    public:
     explicit Iterator(LevelDbTransaction* txn);
 
+    /**
+     * Creates an iterator whose reads of committed values use `read_options`
+     * instead of the transaction's own.
+     */
+    Iterator(LevelDbTransaction* txn, const leveldb::ReadOptions& read_options);
+
     /**
      * Returns true if this iterator points to an entry
      */
@@ -88,8 +92,7 @@ class LevelDbTransaction {
     void AdvanceLDB();
 
     /**
-     * Returns true if the given slice matches a key present in the deletions_
-     * set.
+     * Returns true if the given slice matches a key the transaction deletes.
      */
     bool IsDeleted(leveldb::Slice slice);
 
@@ -108,18 +111,24 @@ class LevelDbTransaction {
     void UpdateCurrent();
 
     std::unique_ptr<leveldb::Iterator> db_iter_;
+    leveldb::ReadOptions read_options_;
 
     // The last observed version of the underlying transaction
     int32_t last_version_;
+    // The number of chunks the underlying transaction had committed when
+    // db_iter_ was created.
+    int32_t last_chunks_committed_;
     // The underlying transaction.
     LevelDbTransaction* txn_;
-    Mutations::iterator mutations_iter_;
+    // The index of the current or next change in the transaction's sorted
+    // changes.
+    size_t change_index_;
     // We save the current key and value so that once an iterator is Valid(), it
     // remains so at least until the next call to Seek() or Next(), even if the
     // underlying data is deleted.
     std::pair<std::string, std::string> current_;
-    // True if current_ represents an entry in the mutations_ map, rather than
-    // committed data.
+    // True if current_ represents a pending change, rather than committed
+    // data.
     bool is_mutation_;
     // True if the iterator pointed to a valid entry the last time Next() or
     // Seek() was called.
@@ -137,17 +146,54 @@ class LevelDbTransaction {
   LevelDbTransaction& operator=(const LevelDbTransaction& other) = delete;
 
   /**
-   * Returns a default set of ReadOptions
+   * Returns a default set of ReadOptions, which verify the checksums of all
+   * data read. Use these wherever corrupt data must be detected, e.g. for
+   * migrations and point lookups.
    */
   static const leveldb::ReadOptions& DefaultReadOptions();
 
+  /**
+   * Returns ReadOptions for iterators on hot read paths, such as query
+   * execution, that skip checksum verification. Blocks read are still cached.
+   */
+  static const leveldb::ReadOptions& FastScanReadOptions();
+
+  /**
+   * Returns ReadOptions for one-off scans over large parts of the database,
+   * such as garbage collection, that neither verify checksums nor fill the
+   * block cache, so that the scan does not evict the working set.
+   */
+  static const leveldb::ReadOptions& OneOffScanReadOptions();
+
   /**
    * Returns a default set of WriteOptions
    */
   static const leveldb::WriteOptions& DefaultWriteOptions();
 
   size_t changed_keys() const {
-    return mutations_.size() + deletions_.size();
+    return changes_.size();
+  }
+
+  /**
+   * Returns the keys the pending changes delete, in order. The keys are only
+   * valid until the next change.
+   */
+  std::vector<absl::string_view> deletions();
+
+  /**
+   * Returns the number of bytes the pending changes take: the sizes of the
+   * keys and values to put and of the keys to delete.
+   */
+  size_t changed_bytes() const {
+    return changed_bytes_;
+  }
+
+  /**
+   * Returns the largest `changed_bytes()` has been over the lifetime of this
+   * transaction.
+   */
+  size_t peak_changed_bytes() const {
+    return peak_changed_bytes_;
   }
 
   /**
@@ -163,9 +209,8 @@ class LevelDbTransaction {
    */
   void Put(absl::string_view key, GPBMessage* message) {
     NSData* data = [message data];
-    std::string key_string(key);
-    mutations_[key_string] = std::string((const char*)data.bytes, data.length);
-    version_++;
+    Put(std::string(key),
+        std::string((const char*)data.bytes, data.length));
   }
 #endif
 
@@ -175,6 +220,18 @@ class LevelDbTransaction {
    */
   void Put(std::string key, std::string value);
 
+  /**
+   * Returns an empty string owned by this transaction, for building a key
+   * (e.g. with `LevelDbRemoteDocumentKey::AppendKey`) before passing it to
+   * `Put`, `Get` or `Delete`. The string keeps its capacity from one call to
+   * the next, so writing many rows doesn't grow a fresh string for each key.
+   * Each call clears the string, so only use one at a time.
+   */
+  std::string* ClearedKeyBuffer() {
+    key_buffer_.clear();
+    return &key_buffer_;
+  }
+
   /**
    * Sets the contents of `value` to the latest known value for the given key,
    * including any pending mutations and `Status::OK` is returned. If the key
@@ -189,22 +246,63 @@ class LevelDbTransaction {
    */
   std::unique_ptr<Iterator> NewIterator();
 
+  /**
+   * Like `NewIterator()`, but reads committed values with the given
+   * `read_options`, e.g. `FastScanReadOptions()`. If the transaction reads
+   * from a snapshot, so does the iterator.
+   */
+  std::unique_ptr<Iterator> NewIterator(
+      const leveldb::ReadOptions& read_options);
+
   /**
    * Commits the transaction. All pending changes are written. The transaction
    * should not be used after calling this method.
    */
   void Commit();
 
+  /**
+   * If the pending changes take at least `max_bytes`, writes them to leveldb
+   * right away, in a single atomic write, and carries on with no pending
+   * changes. Existing iterators keep seeing the changes written.
+   *
+   * This bounds the memory a transaction that touches many rows takes, at the
+   * cost of atomicity: chunks written stay written even if the transaction
+   * never commits. Only use this for operations that are safe to split, such
+   * as idempotent migrations that record their completion at the end.
+   */
+  void CommitChunkIfLarger(size_t max_bytes);
+
   std::string ToString();
 
  private:
+  /** Writes all pending changes to leveldb in a single write. */
+  void WriteChanges();
+
+  void AddChangedBytes(size_t bytes);
+
+  /** Records the work this transaction did into the metrics. */
+  void RecordStats() const;
+
+  /** The work done in leveldb over the lifetime of this transaction. */
+  struct Stats {
+    uint64_t reads = 0;
+    uint64_t bytes_read = 0;
+    uint64_t writes = 0;
+    uint64_t bytes_written = 0;
+    uint64_t iterator_steps = 0;
+  };
+
   leveldb::DB* db_;
-  Mutations mutations_;
-  Deletions deletions_;
+  LevelDbWriteBuffer changes_;
   leveldb::ReadOptions read_options_;
   leveldb::WriteOptions write_options_;
   int32_t version_;
+  int32_t chunks_committed_;
+  size_t changed_bytes_;
+  size_t peak_changed_bytes_;
   std::string label_;
+  Stats stats_;
+  std::string key_buffer_;
 };
 
 /**
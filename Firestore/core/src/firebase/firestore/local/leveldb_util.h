@@ -19,6 +19,7 @@
 
 #include <string>
 
+#include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "absl/strings/string_view.h"
 #include "leveldb/slice.h"
@@ -38,6 +39,21 @@ inline absl::string_view MakeStringView(leveldb::Slice slice) {
   return absl::string_view{slice.data(), slice.size()};
 }
 
+/** Creates a Slice that refers to the bytes of a ByteString, without copying. */
+inline leveldb::Slice MakeSlice(const nanopb::ByteString& bytes) {
+  return leveldb::Slice{reinterpret_cast<const char*>(bytes.data()),
+                        bytes.size()};
+}
+
+/**
+ * Copies the bytes a Slice refers to, which only live as long as the LevelDB
+ * iterator or buffer they came from, into a ByteString. Copies of the result
+ * share the bytes.
+ */
+inline nanopb::ByteString MakeByteString(leveldb::Slice slice) {
+  return nanopb::ByteString{slice.data(), slice.size()};
+}
+
 /** Converts the given LevelDB status to a Firestore status. */
 util::Status ConvertStatus(const leveldb::Status& status);
 
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_write_buffer.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+bool KeyLess(const LevelDbWriteBuffer::Change* lhs,
+             const LevelDbWriteBuffer::Change* rhs) {
+  return lhs->key < rhs->key;
+}
+
+}  // namespace
+
+void LevelDbWriteBuffer::Put(std::string key, std::string value) {
+  auto found = index_.find(key);
+  Change* change = found != index_.end() ? found->second : Add(std::move(key));
+  change->value = std::move(value);
+  change->deleted = false;
+}
+
+void LevelDbWriteBuffer::Delete(absl::string_view key) {
+  auto found = index_.find(key);
+  Change* change =
+      found != index_.end() ? found->second : Add(std::string{key});
+  change->value.clear();
+  change->deleted = true;
+}
+
+LevelDbWriteBuffer::Change* LevelDbWriteBuffer::Add(std::string key) {
+  changes_.emplace_back();
+  Change* change = &changes_.back();
+  change->key = std::move(key);
+  index_.emplace(change->key, change);
+  return change;
+}
+
+const LevelDbWriteBuffer::Change* LevelDbWriteBuffer::Find(
+    absl::string_view key) const {
+  auto found = index_.find(key);
+  return found != index_.end() ? found->second : nullptr;
+}
+
+const std::vector<const LevelDbWriteBuffer::Change*>&
+LevelDbWriteBuffer::Sorted() {
+  size_t merged = sorted_.size();
+  if (merged == changes_.size()) {
+    return sorted_;
+  }
+
+  for (auto iter = changes_.begin() + merged; iter != changes_.end(); ++iter) {
+    sorted_.push_back(&*iter);
+  }
+  auto middle = sorted_.begin() + merged;
+  std::sort(middle, sorted_.end(), KeyLess);
+  // Changes are often added in key order, e.g. when writing the documents of
+  // a query result, in which case there's nothing to merge.
+  if (merged > 0 && KeyLess(*middle, *(middle - 1))) {
+    std::inplace_merge(sorted_.begin(), middle, sorted_.end(), KeyLess);
+  }
+  return sorted_;
+}
+
+size_t LevelDbWriteBuffer::LowerBound(absl::string_view key) {
+  const std::vector<const Change*>& sorted = Sorted();
+  auto found = std::lower_bound(
+      sorted.begin(), sorted.end(), key,
+      [](const Change* change, absl::string_view target) {
+        return absl::string_view{change->key} < target;
+      });
+  return static_cast<size_t>(found - sorted.begin());
+}
+
+void LevelDbWriteBuffer::Clear() {
+  index_.clear();
+  sorted_.clear();
+  changes_.clear();
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_WRITE_BUFFER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_WRITE_BUFFER_H_
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * The pending changes of a LevelDbTransaction: for each key changed, either
+ * the value to put or its deletion.
+ *
+ * Buffering a change appends it to a log that holds each key once, indexed by
+ * a hash table, rather than inserting into a tree. The key order needed to
+ * iterate over or write the changes is only established the first time it's
+ * needed after changes were added, by sorting the new changes and merging them
+ * into those already in order.
+ */
+class LevelDbWriteBuffer {
+ public:
+  struct Change {
+    std::string key;
+    std::string value;
+    bool deleted = false;
+  };
+
+  LevelDbWriteBuffer() = default;
+
+  LevelDbWriteBuffer(const LevelDbWriteBuffer&) = delete;
+  LevelDbWriteBuffer& operator=(const LevelDbWriteBuffer&) = delete;
+
+  /** Sets the change to the given key to putting `value`. */
+  void Put(std::string key, std::string value);
+
+  /** Sets the change to the given key to its deletion. */
+  void Delete(absl::string_view key);
+
+  /** Returns the change to the given key, or null if it hasn't changed. */
+  const Change* Find(absl::string_view key) const;
+
+  /** Returns the number of keys changed, including deleted ones. */
+  size_t size() const {
+    return changes_.size();
+  }
+
+  bool empty() const {
+    return changes_.empty();
+  }
+
+  /**
+   * Returns the changes in key order. The result is only valid until the next
+   * call to a non-const method.
+   */
+  const std::vector<const Change*>& Sorted();
+
+  /**
+   * Returns the index in `Sorted()` of the first change whose key is equal to
+   * or greater than `key`.
+   */
+  size_t LowerBound(absl::string_view key);
+
+  /** Discards all changes. */
+  void Clear();
+
+ private:
+  /** Appends a change to a key that hasn't changed yet. */
+  Change* Add(std::string key);
+
+  // A deque doesn't move its elements as it grows, so the index and the sorted
+  // view can point into it.
+  std::deque<Change> changes_;
+  absl::flat_hash_map<absl::string_view, Change*> index_;
+
+  // The first `sorted_.size()` changes, in key order. Changes added since are
+  // merged in by `Sorted()`.
+  std::vector<const Change*> sorted_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_WRITE_BUFFER_H_
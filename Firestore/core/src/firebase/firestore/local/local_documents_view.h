@@ -19,6 +19,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <unordered_map>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
@@ -27,6 +28,8 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "absl/types/optional.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -43,6 +46,13 @@ namespace local {
  * have a cached version in remoteDocumentCache or local mutations for the
  * document). The view is computed by applying the mutations in the
  * FSTMutationQueue to the FSTRemoteDocumentCache.
+ *
+ * The local view of each document with pending mutations is kept as an
+ * overlay, so that reading it again takes one lookup instead of replaying all
+ * its mutation batches. An overlay is used only while the remote document is
+ * the one it was computed from; the owner of the view must report the changes
+ * it makes to the mutation queue through `AddBatchToOverlays` and
+ * `RemoveOverlays`.
  */
 class LocalDocumentsView {
  public:
@@ -77,32 +87,136 @@ class LocalDocumentsView {
   model::MaybeDocumentMap GetLocalViewOfDocuments(
       const model::MaybeDocumentMap& base_docs);
 
-  /** Performs a query against the local view of all documents. */
+  /**
+   * Performs a query against the local view of all documents, recording the
+   * work done into the current QueryProfile, if any.
+   */
   model::DocumentMap GetDocumentsMatchingQuery(FSTQuery* query);
 
+  /**
+   * Performs a collection query whose remote results, as of `read_time`, were
+   * the documents with the given `remote_keys`, such as the documents of the
+   * query's target as of its snapshot version. Rather than the whole
+   * collection, only those documents, the documents of the collection read
+   * since and the documents with local mutations are read.
+   */
+  model::DocumentMap GetDocumentsMatchingQuery(
+      FSTQuery* query,
+      const model::DocumentKeySet& remote_keys,
+      const model::SnapshotVersion& read_time);
+
+  /**
+   * Returns one page of the results of a collection query: the first
+   * `page_size` documents in key order that match it in the local view, after
+   * `start_after` if given. The query's own limit and sort order are ignored.
+   *
+   * Reading a collection in pages, each starting after the last document of
+   * the previous one, holds only a page of documents in memory at a time.
+   */
+  model::DocumentMap GetDocumentsMatchingQueryPage(
+      FSTQuery* query,
+      const absl::optional<model::DocumentKey>& start_after,
+      size_t page_size);
+
+  /**
+   * Updates the overlays of the documents that `batch`, just added to the end
+   * of the mutation queue, changes.
+   */
+  void AddBatchToOverlays(FSTMutationBatch* batch);
+
+  /**
+   * Forgets the overlays of the given documents, such as when a batch that
+   * changed them is acknowledged or rejected.
+   */
+  void RemoveOverlays(const model::DocumentKeySet& keys);
+
  private:
-  /** Internal version of GetDocument that allows re-using batches. */
-  FSTMaybeDocument* _Nullable GetDocument(
+  /**
+   * The local view of a document with pending mutations, and the remote
+   * document it was computed from.
+   */
+  struct Overlay {
+    FSTMaybeDocument* _Nullable remote_doc;
+    FSTMaybeDocument* _Nullable local_view;
+  };
+
+  /**
+   * Returns the overlay of `key` if there is one computed from `remote_doc`,
+   * or null.
+   */
+  const Overlay* _Nullable FindOverlay(const model::DocumentKey& key,
+                                       FSTMaybeDocument* _Nullable remote_doc);
+
+  /**
+   * Returns the local view of `key` from its overlay if it's still current,
+   * otherwise by applying the mutations to it in `batches` to `remote_doc`.
+   */
+  FSTMaybeDocument* _Nullable GetLocalView(
       const model::DocumentKey& key,
+      FSTMaybeDocument* _Nullable remote_doc,
       const std::vector<FSTMutationBatch*>& batches);
 
   /**
-   * Returns the view of the given `docs` as they would appear after applying
-   * all mutations in the given `batches`.
+   * Applies the mutations to `key` in `batches` to `remote_doc`, which can be
+   * any superset of the batches affecting `key`, and remembers the result as
+   * the overlay of `key` if any of them did.
    */
-  model::MaybeDocumentMap ApplyLocalMutationsToDocuments(
-      const model::MaybeDocumentMap& docs,
+  FSTMaybeDocument* _Nullable ComputeLocalView(
+      const model::DocumentKey& key,
+      FSTMaybeDocument* _Nullable remote_doc,
       const std::vector<FSTMutationBatch*>& batches);
 
   /** Performs a simple document lookup for the given path. */
   model::DocumentMap GetDocumentsMatchingDocumentQuery(
       const model::ResourcePath& doc_path);
 
+  /**
+   * Queries the remote documents in every collection of the group at once and
+   * overlays mutations.
+   */
   model::DocumentMap GetDocumentsMatchingCollectionGroupQuery(FSTQuery* query);
 
-  /** Queries the remote documents and overlays mutations. */
+  /**
+   * Queries the remote documents and overlays mutations. If the query has a
+   * limit, only the documents that make it within the limit are returned.
+   */
   model::DocumentMap GetDocumentsMatchingCollectionQuery(FSTQuery* query);
 
+  /**
+   * Returns a superset of the remote documents matching the given collection
+   * query that, once `matching_batches` are applied, is sure to contain the
+   * query's results.
+   *
+   * If the query filters or orders by a field, the documents are looked up in
+   * an index on that field. The index is built from a scan of the collection
+   * the first time the collection is queried on the field. If the query has a
+   * limit and is ordered first by the indexed field, or by key when there's no
+   * index to use, the scan stops as soon as enough documents match.
+   */
+  model::DocumentMap GetRemoteDocumentsMatchingCollectionQuery(
+      FSTQuery* query, const std::vector<FSTMutationBatch*>& matching_batches);
+
+  /**
+   * Reads the remote documents that `scan` visits, in the order of the index,
+   * until `count` of them match the given query, which is ordered first by the
+   * indexed field. Documents whose values share an encoding are read together,
+   * since the index doesn't tell them apart, so the documents returned include
+   * the first `count` matches in the query's order.
+   */
+  model::DocumentMap GetFirstRemoteDocumentsMatchingFieldIndex(
+      FSTQuery* query, const FieldIndexScan& scan, size_t count);
+
+  /**
+   * Overlays the mutations in `matching_batches` onto `remote_docs`, a superset
+   * of the remote documents matching `query`, and returns the documents that
+   * match the query. If the query has a limit, only the documents that make it
+   * within the limit are returned.
+   */
+  model::DocumentMap ApplyMutationsToQueryResults(
+      FSTQuery* query,
+      const std::vector<FSTMutationBatch*>& matching_batches,
+      model::DocumentMap remote_docs);
+
   /**
    * It is possible that a `PatchMutation` can make a document match a query,
    * even if the version in the `RemoteDocumentCache` is not a match yet
@@ -119,6 +233,9 @@ class LocalDocumentsView {
   RemoteDocumentCache* remote_document_cache_;
   MutationQueue* mutation_queue_;
   IndexManager* index_manager_;
+
+  std::unordered_map<model::DocumentKey, Overlay, model::DocumentKeyHash>
+      overlays_;
 };
 
 }  // namespace local
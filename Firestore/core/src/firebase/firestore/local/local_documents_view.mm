@@ -16,21 +16,29 @@
 
 #import "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 #import "Firestore/Source/Model/FSTMutation.h"
 #import "Firestore/Source/Model/FSTMutationBatch.h"
 
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
+#include "absl/types/optional.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -44,39 +52,181 @@ using model::DocumentMap;
 using model::MaybeDocumentMap;
 using model::ResourcePath;
 using model::SnapshotVersion;
+using util::ComparisonResult;
 using util::MakeString;
 
+namespace {
+
+/** Returns whether the documents matching `query` are sorted by key alone. */
+bool IsOrderedByKey(FSTQuery* query) {
+  const core::Query::OrderByList& order_bys = query.sortOrders;
+  return order_bys.size() == 1 && order_bys[0].field().IsKeyFieldPath() &&
+         order_bys[0].ascending();
+}
+
+/**
+ * Returns whether the documents matching `query` are sorted first by the field
+ * that `scan` is over, in ascending order, like the entries of its index.
+ */
+bool IsOrderedByScannedField(FSTQuery* query, const FieldIndexScan& scan) {
+  const core::Query::OrderByList& order_bys = query.sortOrders;
+  return !order_bys.empty() && order_bys[0].field() == scan.field_path() &&
+         order_bys[0].ascending();
+}
+
+/** Returns the number of mutations in `batches`. */
+size_t CountMutations(const std::vector<FSTMutationBatch*>& batches) {
+  size_t count = 0;
+  for (FSTMutationBatch* batch : batches) {
+    count += [batch mutations].size();
+  }
+  return count;
+}
+
+/**
+ * Returns whether `key` is in the collection, or one of the collections of the
+ * collection group, that `query` is on.
+ */
+bool IsInQueryCollection(FSTQuery* query, const DocumentKey& key) {
+  if ([query isCollectionGroupQuery]) {
+    return key.HasCollectionId(*query.collectionGroup);
+  }
+  return query.path.IsImmediateParentOf(key.path());
+}
+
+/**
+ * Returns the documents among `docs` that match `query` and come first in its
+ * sort order, up to the query's limit. Keeps only that many documents around
+ * at a time, in a heap whose top is the last document kept.
+ */
+DocumentMap FirstMatchingDocuments(FSTQuery* query, const DocumentMap& docs) {
+  auto limit = static_cast<size_t>(query.limit);
+  model::DocumentComparator comparator = query.comparator;
+  auto comes_before = [&comparator](FSTDocument* lhs, FSTDocument* rhs) {
+    return comparator.Compare(lhs, rhs) == ComparisonResult::Ascending;
+  };
+
+  std::vector<FSTDocument*> heap;
+  for (const auto& kv : docs.underlying_map()) {
+    auto* doc = static_cast<FSTDocument*>(kv.second);
+    if (![query matchesDocument:doc]) {
+      continue;
+    }
+    if (heap.size() < limit) {
+      heap.push_back(doc);
+      std::push_heap(heap.begin(), heap.end(), comes_before);
+    } else if (!heap.empty() && comes_before(doc, heap.front())) {
+      std::pop_heap(heap.begin(), heap.end(), comes_before);
+      heap.back() = doc;
+      std::push_heap(heap.begin(), heap.end(), comes_before);
+    }
+  }
+
+  DocumentMap results;
+  for (FSTDocument* doc : heap) {
+    results = results.insert(doc.key, doc);
+  }
+  return results;
+}
+
+/**
+ * Returns whether `lhs` and `rhs` are the same remote state of a document.
+ * Watch never sends different contents of a document at the same version, so
+ * comparing the versions is enough, along with whether the state comes from
+ * an acknowledged write.
+ */
+bool IsSameRemoteDocument(FSTMaybeDocument* _Nullable lhs,
+                          FSTMaybeDocument* _Nullable rhs) {
+  if (lhs == rhs) {
+    return true;
+  }
+  if (!lhs || !rhs || [lhs class] != [rhs class]) {
+    return false;
+  }
+  return lhs.version == rhs.version &&
+         [lhs hasPendingWrites] == [rhs hasPendingWrites];
+}
+
+}  // namespace
+
 FSTMaybeDocument* _Nullable LocalDocumentsView::GetDocument(
     const DocumentKey& key) {
+  FSTMaybeDocument* _Nullable remote_doc = remote_document_cache_->Get(key);
+  if (const Overlay* overlay = FindOverlay(key, remote_doc)) {
+    return overlay->local_view;
+  }
+
   std::vector<FSTMutationBatch*> batches =
       mutation_queue_->AllMutationBatchesAffectingDocumentKey(key);
-  return GetDocument(key, batches);
+  return ComputeLocalView(key, remote_doc, batches);
 }
 
-FSTMaybeDocument* _Nullable LocalDocumentsView::GetDocument(
-    const DocumentKey& key, const std::vector<FSTMutationBatch*>& batches) {
-  FSTMaybeDocument* _Nullable document = remote_document_cache_->Get(key);
-  for (FSTMutationBatch* batch : batches) {
-    document = [batch applyToLocalDocument:document documentKey:key];
+void LocalDocumentsView::AddBatchToOverlays(FSTMutationBatch* batch) {
+  for (FSTMutation* mutation : [batch mutations]) {
+    const DocumentKey& key = mutation.key;
+    auto found = overlays_.find(key);
+    if (found == overlays_.end()) {
+      continue;
+    }
+
+    // A document with overlays from earlier batches only needs the new batch
+    // applied on top. Without one, the next read computes it from scratch.
+    Overlay& overlay = found->second;
+    overlay.local_view = [batch applyToLocalDocument:overlay.local_view
+                                         documentKey:key];
   }
+}
 
-  return document;
+void LocalDocumentsView::RemoveOverlays(const DocumentKeySet& keys) {
+  for (const DocumentKey& key : keys) {
+    overlays_.erase(key);
+  }
+}
+
+const LocalDocumentsView::Overlay* _Nullable LocalDocumentsView::FindOverlay(
+    const DocumentKey& key, FSTMaybeDocument* _Nullable remote_doc) {
+  auto found = overlays_.find(key);
+  if (found == overlays_.end() ||
+      !IsSameRemoteDocument(found->second.remote_doc, remote_doc)) {
+    return nullptr;
+  }
+  return &found->second;
 }
 
-MaybeDocumentMap LocalDocumentsView::ApplyLocalMutationsToDocuments(
-    const MaybeDocumentMap& docs,
+FSTMaybeDocument* _Nullable LocalDocumentsView::GetLocalView(
+    const DocumentKey& key,
+    FSTMaybeDocument* _Nullable remote_doc,
     const std::vector<FSTMutationBatch*>& batches) {
-  MaybeDocumentMap results;
+  if (const Overlay* overlay = FindOverlay(key, remote_doc)) {
+    return overlay->local_view;
+  }
+  return ComputeLocalView(key, remote_doc, batches);
+}
 
-  for (const auto& kv : docs) {
-    const DocumentKey& key = kv.first;
-    FSTMaybeDocument* local_view = kv.second;
-    for (FSTMutationBatch* batch : batches) {
+FSTMaybeDocument* _Nullable LocalDocumentsView::ComputeLocalView(
+    const DocumentKey& key,
+    FSTMaybeDocument* _Nullable remote_doc,
+    const std::vector<FSTMutationBatch*>& batches) {
+  static util::Counter& batches_replayed =
+      util::MetricsRegistry::Default().GetCounter(
+          "local.mutation_batches_replayed");
+
+  FSTMaybeDocument* _Nullable local_view = remote_doc;
+  bool mutated = false;
+  for (FSTMutationBatch* batch : batches) {
+    if ([batch hasMutationsForKey:key]) {
       local_view = [batch applyToLocalDocument:local_view documentKey:key];
+      batches_replayed.Increment();
+      mutated = true;
     }
-    results = results.insert(key, local_view);
   }
-  return results;
+
+  if (mutated) {
+    overlays_[key] = Overlay{remote_doc, local_view};
+  } else {
+    overlays_.erase(key);
+  }
+  return local_view;
 }
 
 MaybeDocumentMap LocalDocumentsView::GetDocuments(const DocumentKeySet& keys) {
@@ -90,20 +240,24 @@ MaybeDocumentMap LocalDocumentsView::GetDocuments(const DocumentKeySet& keys) {
  */
 MaybeDocumentMap LocalDocumentsView::GetLocalViewOfDocuments(
     const MaybeDocumentMap& base_docs) {
-  MaybeDocumentMap results;
-
-  DocumentKeySet all_keys;
+  // Only the documents without a current overlay need their batches read.
+  DocumentKeySet missing_keys;
   for (const auto& kv : base_docs) {
-    all_keys = all_keys.insert(kv.first);
+    if (!FindOverlay(kv.first, kv.second)) {
+      missing_keys = missing_keys.insert(kv.first);
+    }
+  }
+  std::vector<FSTMutationBatch*> batches;
+  if (!missing_keys.empty()) {
+    batches =
+        mutation_queue_->AllMutationBatchesAffectingDocumentKeys(missing_keys);
   }
-  std::vector<FSTMutationBatch*> batches =
-      mutation_queue_->AllMutationBatchesAffectingDocumentKeys(all_keys);
-
-  MaybeDocumentMap docs = ApplyLocalMutationsToDocuments(base_docs, batches);
 
-  for (const auto& kv : docs) {
+  MaybeDocumentMap::Builder results;
+  results.reserve(base_docs.size());
+  for (const auto& kv : base_docs) {
     const DocumentKey& key = kv.first;
-    FSTMaybeDocument* maybe_doc = kv.second;
+    FSTMaybeDocument* maybe_doc = GetLocalView(key, kv.second, batches);
 
     // TODO(http://b/32275378): Don't conflate missing / deleted.
     if (!maybe_doc) {
@@ -111,20 +265,112 @@ MaybeDocumentMap LocalDocumentsView::GetLocalViewOfDocuments(
                                               version:SnapshotVersion::None()
                                 hasCommittedMutations:NO];
     }
-    results = results.insert(key, maybe_doc);
+    results.push_back(key, maybe_doc);
   }
 
-  return results;
+  return results.Build();
 }
 
 DocumentMap LocalDocumentsView::GetDocumentsMatchingQuery(FSTQuery* query) {
+  DocumentMap results;
   if ([query isDocumentQuery]) {
-    return GetDocumentsMatchingDocumentQuery(query.path);
+    results = GetDocumentsMatchingDocumentQuery(query.path);
   } else if ([query isCollectionGroupQuery]) {
-    return GetDocumentsMatchingCollectionGroupQuery(query);
+    results = GetDocumentsMatchingCollectionGroupQuery(query);
   } else {
-    return GetDocumentsMatchingCollectionQuery(query);
+    results = GetDocumentsMatchingCollectionQuery(query);
+  }
+
+  if (QueryProfile* profile = QueryProfile::current()) {
+    profile->documents_matched += results.size();
+  }
+  return results;
+}
+
+DocumentMap LocalDocumentsView::GetDocumentsMatchingQuery(
+    FSTQuery* query,
+    const DocumentKeySet& remote_keys,
+    const SnapshotVersion& read_time) {
+  HARD_ASSERT(![query isDocumentQuery] && ![query isCollectionGroupQuery],
+              "Only collection queries can be answered from remote keys");
+
+  std::vector<FSTMutationBatch*> matching_batches =
+      mutation_queue_->AllMutationBatchesAffectingQuery(query);
+  if (QueryProfile* profile = QueryProfile::current()) {
+    profile->mutation_batches_scanned += matching_batches.size();
+    profile->documents_scanned += remote_keys.size();
   }
+
+  DocumentMap remote_docs =
+      remote_document_cache_->GetReadSince(query, read_time);
+  for (const auto& kv : remote_document_cache_->GetAll(remote_keys)) {
+    FSTMaybeDocument* maybe_doc = kv.second;
+    if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
+      remote_docs =
+          remote_docs.insert(kv.first, static_cast<FSTDocument*>(maybe_doc));
+    }
+  }
+
+  DocumentMap results = ApplyMutationsToQueryResults(query, matching_batches,
+                                                     std::move(remote_docs));
+  if (QueryProfile* profile = QueryProfile::current()) {
+    profile->documents_matched += results.size();
+  }
+  return results;
+}
+
+DocumentMap LocalDocumentsView::GetDocumentsMatchingQueryPage(
+    FSTQuery* query,
+    const absl::optional<DocumentKey>& start_after,
+    size_t page_size) {
+  HARD_ASSERT(![query isDocumentQuery] && ![query isCollectionGroupQuery],
+              "Only collection queries can be read in pages");
+
+  std::vector<FSTMutationBatch*> matching_batches =
+      mutation_queue_->AllMutationBatchesAffectingQuery(query);
+  if (QueryProfile* profile = QueryProfile::current()) {
+    profile->mutation_batches_scanned += matching_batches.size();
+  }
+
+  // Only documents after the start of the page can end up in it.
+  DocumentKeySet mutated_keys;
+  for (FSTMutationBatch* batch : matching_batches) {
+    for (FSTMutation* mutation : [batch mutations]) {
+      const DocumentKey& key = mutation.key;
+      if (IsInQueryCollection(query, key) &&
+          (!start_after || *start_after < key)) {
+        mutated_keys = mutated_keys.insert(key);
+      }
+    }
+  }
+
+  // Each mutated document can at most push one of the first remote documents
+  // out of the page, so reading that many more is enough to fill it.
+  DocumentMap results = remote_document_cache_->GetFirstMatching(
+      query, start_after, page_size + mutated_keys.size());
+  for (const auto& kv : remote_document_cache_->GetAll(mutated_keys)) {
+    const DocumentKey& key = kv.first;
+    FSTMaybeDocument* local_view =
+        GetLocalView(key, kv.second, matching_batches);
+    if ([local_view isKindOfClass:[FSTDocument class]] &&
+        [query matchesDocument:static_cast<FSTDocument*>(local_view)]) {
+      results = results.insert(key, static_cast<FSTDocument*>(local_view));
+    } else {
+      results = results.erase(key);
+    }
+  }
+
+  if (results.size() <= page_size) {
+    return results;
+  }
+  DocumentMap page;
+  for (const auto& kv : results.underlying_map()) {
+    if (page.size() == page_size) {
+      break;
+    }
+    page = page.insert(kv.first, static_cast<FSTDocument*>(kv.second));
+  }
+  return page;
 }
 
 DocumentMap LocalDocumentsView::GetDocumentsMatchingDocumentQuery(
@@ -144,62 +390,83 @@ model::DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionGroupQuery(
       query.path.empty(),
       "Currently we only support collection group queries at the root.");
 
+  // The remote document cache answers for every collection in the group at
+  // once. Mutations aren't indexed by collection ID, but there are few pending
+  // batches, so a single pass over all of them is cheaper than one index scan
+  // per collection in the group.
   const std::string& collection_id = *query.collectionGroup;
-  std::vector<ResourcePath> parents =
-      index_manager_->GetCollectionParents(collection_id);
-  DocumentMap results;
+  std::vector<FSTMutationBatch*> all_batches =
+      mutation_queue_->AllMutationBatches();
+  if (QueryProfile* profile = QueryProfile::current()) {
+    profile->mutation_batches_scanned += all_batches.size();
+  }
 
-  // Perform a collection query against each parent that contains the
-  // collection_id and aggregate the results.
-  for (const ResourcePath& parent : parents) {
-    FSTQuery* collection_query =
-        [query collectionQueryAtPath:parent.Append(collection_id)];
-    DocumentMap collection_results =
-        GetDocumentsMatchingCollectionQuery(collection_query);
-    for (const auto& kv : collection_results.underlying_map()) {
-      const DocumentKey& key = kv.first;
-      FSTDocument* doc = static_cast<FSTDocument*>(kv.second);
-      results = results.insert(key, doc);
+  std::vector<FSTMutationBatch*> matching_batches;
+  for (FSTMutationBatch* batch : all_batches) {
+    for (FSTMutation* mutation : [batch mutations]) {
+      if (mutation.key.HasCollectionId(collection_id)) {
+        matching_batches.push_back(batch);
+        break;
+      }
     }
   }
-  return results;
+
+  DocumentMap results = remote_document_cache_->GetMatching(query);
+  return ApplyMutationsToQueryResults(query, matching_batches,
+                                      std::move(results));
 }
 
 DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
     FSTQuery* query) {
-  DocumentMap results = remote_document_cache_->GetMatching(query);
   // Get locally persisted mutation batches.
   std::vector<FSTMutationBatch*> matchingBatches =
       mutation_queue_->AllMutationBatchesAffectingQuery(query);
+  if (QueryProfile* profile = QueryProfile::current()) {
+    profile->mutation_batches_scanned += matchingBatches.size();
+  }
+  DocumentMap results =
+      GetRemoteDocumentsMatchingCollectionQuery(query, matchingBatches);
+  return ApplyMutationsToQueryResults(query, matchingBatches,
+                                      std::move(results));
+}
 
-  results = AddMissingBaseDocuments(matchingBatches, std::move(results));
+DocumentMap LocalDocumentsView::ApplyMutationsToQueryResults(
+    FSTQuery* query,
+    const std::vector<FSTMutationBatch*>& matching_batches,
+    DocumentMap remote_docs) {
+  DocumentMap results =
+      AddMissingBaseDocuments(matching_batches, std::move(remote_docs));
 
-  for (FSTMutationBatch* batch : matchingBatches) {
+  // Only process documents belonging to the collection.
+  DocumentKeySet mutated_keys;
+  for (FSTMutationBatch* batch : matching_batches) {
     for (FSTMutation* mutation : [batch mutations]) {
-      // Only process documents belonging to the collection.
-      if (!query.path.IsImmediateParentOf(mutation.key.path())) {
-        continue;
+      if (IsInQueryCollection(query, mutation.key)) {
+        mutated_keys = mutated_keys.insert(mutation.key);
       }
+    }
+  }
 
-      const DocumentKey& key = mutation.key;
-      // base_doc may be nil for the documents that weren't yet written to the
-      // backend.
-      FSTMaybeDocument* base_doc = nil;
-      auto found = results.underlying_map().find(key);
-      if (found != results.underlying_map().end()) {
-        base_doc = found->second;
-      }
-      FSTMaybeDocument* mutated_doc =
-          [mutation applyToLocalDocument:base_doc
-                            baseDocument:base_doc
-                          localWriteTime:batch.localWriteTime];
-
-      if ([mutated_doc isKindOfClass:[FSTDocument class]]) {
-        results = results.insert(key, static_cast<FSTDocument*>(mutated_doc));
-      } else {
-        results = results.erase(key);
-      }
+  for (const DocumentKey& key : mutated_keys) {
+    // base_doc may be nil for the documents that weren't yet written to the
+    // backend.
+    FSTMaybeDocument* base_doc = nil;
+    auto found = results.underlying_map().find(key);
+    if (found != results.underlying_map().end()) {
+      base_doc = found->second;
     }
+    FSTMaybeDocument* mutated_doc =
+        GetLocalView(key, base_doc, matching_batches);
+
+    if ([mutated_doc isKindOfClass:[FSTDocument class]]) {
+      results = results.insert(key, static_cast<FSTDocument*>(mutated_doc));
+    } else {
+      results = results.erase(key);
+    }
+  }
+
+  if (query.limit != core::Query::kNoLimit) {
+    return FirstMatchingDocuments(query, results);
   }
 
   // Finally, filter out any documents that don't actually match the query. Note
@@ -218,6 +485,112 @@ DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
   return results;
 }
 
+DocumentMap LocalDocumentsView::GetRemoteDocumentsMatchingCollectionQuery(
+    FSTQuery* query, const std::vector<FSTMutationBatch*>& matching_batches) {
+  absl::optional<FieldIndexScan> scan = FieldIndexScan::ForQuery(query.query);
+  if (!scan) {
+    if (query.limit == core::Query::kNoLimit || !IsOrderedByKey(query)) {
+      return remote_document_cache_->GetMatching(query);
+    }
+
+    // Each mutation can at most push one of the first remote documents out of
+    // the results, so reading that many more is enough to fill the limit.
+    return remote_document_cache_->GetFirstMatching(
+        query, absl::nullopt,
+        static_cast<size_t>(query.limit) + CountMutations(matching_batches));
+  }
+
+  const ResourcePath& collection_path = query.path;
+  if (index_manager_->HasFieldIndex(collection_path, scan->field_path())) {
+    if (query.limit != core::Query::kNoLimit &&
+        IsOrderedByScannedField(query, *scan)) {
+      // Same as above: enough to fill the limit whatever the mutations do.
+      DocumentMap results = GetFirstRemoteDocumentsMatchingFieldIndex(
+          query, *scan,
+          static_cast<size_t>(query.limit) + CountMutations(matching_batches));
+
+      // Unlike keys, values change, so a mutation can move a document that
+      // wasn't read into the limit. Read those too, to apply the mutations to
+      // the same documents as when the whole collection is read.
+      DocumentKeySet mutated_keys;
+      for (FSTMutationBatch* batch : matching_batches) {
+        for (FSTMutation* mutation : [batch mutations]) {
+          if (IsInQueryCollection(query, mutation.key) &&
+              results.underlying_map().find(mutation.key) ==
+                  results.underlying_map().end()) {
+            mutated_keys = mutated_keys.insert(mutation.key);
+          }
+        }
+      }
+      for (const auto& kv : remote_document_cache_->GetAll(mutated_keys)) {
+        FSTMaybeDocument* maybe_doc = kv.second;
+        if ([maybe_doc isKindOfClass:[FSTDocument class]] &&
+            [query matchesDocument:static_cast<FSTDocument*>(maybe_doc)]) {
+          results =
+              results.insert(kv.first, static_cast<FSTDocument*>(maybe_doc));
+        }
+      }
+      return results;
+    }
+
+    DocumentKeySet keys =
+        index_manager_->GetDocumentsMatchingFieldIndex(collection_path, *scan);
+
+    if (QueryProfile* profile = QueryProfile::current()) {
+      profile->documents_scanned += keys.size();
+    }
+
+    DocumentMap results;
+    for (const auto& kv : remote_document_cache_->GetAll(keys)) {
+      FSTMaybeDocument* maybe_doc = kv.second;
+      if ([maybe_doc isKindOfClass:[FSTDocument class]]) {
+        results =
+            results.insert(kv.first, static_cast<FSTDocument*>(maybe_doc));
+      }
+    }
+    return results;
+  }
+
+  // Build the index from every document in the collection rather than just
+  // those returned for this query, so that it remains complete regardless of
+  // how much filtering GetMatching does.
+  DocumentMap results =
+      remote_document_cache_->GetMatching([FSTQuery queryWithPath:query.path]);
+  if (index_manager_->AddFieldIndex(collection_path, scan->field_path())) {
+    for (const auto& kv : results.underlying_map()) {
+      auto* doc = static_cast<FSTDocument*>(kv.second);
+      index_manager_->AddToFieldIndexes(kv.first, doc.data);
+    }
+  }
+  return results;
+}
+
+DocumentMap LocalDocumentsView::GetFirstRemoteDocumentsMatchingFieldIndex(
+    FSTQuery* query, const FieldIndexScan& scan, size_t count) {
+  QueryProfile* profile = QueryProfile::current();
+  DocumentMap results;
+  std::string last_value;
+  index_manager_->ScanFieldIndex(
+      query.path, scan,
+      [&](absl::string_view encoded_value, const DocumentKey& key) {
+        if (results.size() >= count && encoded_value != last_value) {
+          return false;
+        }
+        last_value.assign(encoded_value.data(), encoded_value.size());
+
+        if (profile) {
+          profile->documents_scanned++;
+        }
+        FSTMaybeDocument* maybe_doc = remote_document_cache_->Get(key);
+        if ([maybe_doc isKindOfClass:[FSTDocument class]] &&
+            [query matchesDocument:static_cast<FSTDocument*>(maybe_doc)]) {
+          results = results.insert(key, static_cast<FSTDocument*>(maybe_doc));
+        }
+        return true;
+      });
+  return results;
+}
+
 DocumentMap LocalDocumentsView::AddMissingBaseDocuments(
     const std::vector<FSTMutationBatch*>& matching_batches,
     DocumentMap existing_docs) {
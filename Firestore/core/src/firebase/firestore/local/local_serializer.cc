@@ -32,7 +32,9 @@
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "absl/strings/match.h"
 
 namespace firebase {
 namespace firestore {
@@ -49,11 +51,53 @@ using model::UnknownDocument;
 using nanopb::ByteString;
 using nanopb::CheckedSize;
 using nanopb::Reader;
+using nanopb::StringWriter;
 using nanopb::Writer;
 using remote::MakeArray;
 using util::Status;
 using util::StringFormat;
 
+namespace {
+
+/**
+ * Returns the given encoded Document with `prefix` removed from its name, or
+ * an empty string if the name doesn't start with `prefix` or isn't the first
+ * field, as it is in everything the backend sends. The rest of the document is
+ * copied as it is.
+ */
+std::string RemoveNamePrefix(absl::string_view document_bytes,
+                             absl::string_view prefix) {
+  Reader reader{document_bytes};
+  if (!reader.ReadTag() ||
+      reader.field_number() != google_firestore_v1_Document_name_tag ||
+      reader.wire_type() != PB_WT_STRING) {
+    return {};
+  }
+  std::string name = reader.ReadString();
+  if (!reader.status().ok() || name.size() <= prefix.size() ||
+      !absl::StartsWith(name, prefix)) {
+    return {};
+  }
+
+  // Encoding the name again finds where it ends, and makes sure it wasn't
+  // written with an unusually long length prefix.
+  StringWriter name_field;
+  name_field.WriteTag(PB_WT_STRING, google_firestore_v1_Document_name_tag);
+  name_field.WriteString(name);
+  std::string name_bytes = name_field.Release();
+  if (!absl::StartsWith(document_bytes, name_bytes)) return {};
+
+  StringWriter result;
+  result.WriteTag(PB_WT_STRING, google_firestore_v1_Document_name_tag);
+  result.WriteString(absl::string_view{name}.substr(prefix.size()));
+  std::string relative = result.Release();
+  document_bytes.remove_prefix(name_bytes.size());
+  relative.append(document_bytes.data(), document_bytes.size());
+  return relative;
+}
+
+}  // namespace
+
 firestore_client_MaybeDocument LocalSerializer::EncodeMaybeDocument(
     const MaybeDocument& maybe_doc) const {
   firestore_client_MaybeDocument result{};
@@ -96,6 +140,10 @@ std::unique_ptr<MaybeDocument> LocalSerializer::DecodeMaybeDocument(
     Reader* reader, const firestore_client_MaybeDocument& proto) const {
   if (!reader->status().ok()) return nullptr;
 
+  static util::Counter& documents_decoded =
+      util::MetricsRegistry::Default().GetCounter("local.documents_decoded");
+  documents_decoded.Increment();
+
   switch (proto.which_document_type) {
     case firestore_client_MaybeDocument_document_tag:
       return rpc_serializer_.DecodeDocument(reader, proto.document);
@@ -119,6 +167,27 @@ std::unique_ptr<MaybeDocument> LocalSerializer::DecodeMaybeDocument(
   UNREACHABLE();
 }
 
+std::string LocalSerializer::EncodeMaybeDocumentBytes(
+    absl::string_view document_bytes,
+    bool has_committed_mutations,
+    absl::string_view name_prefix) {
+  std::string relative_document;
+  if (!name_prefix.empty()) {
+    relative_document = RemoveNamePrefix(document_bytes, name_prefix);
+    if (!relative_document.empty()) document_bytes = relative_document;
+  }
+
+  nanopb::StringWriter writer;
+  writer.WriteTag(PB_WT_STRING, firestore_client_MaybeDocument_document_tag);
+  writer.WriteString(document_bytes);
+  if (has_committed_mutations) {
+    writer.WriteTag(PB_WT_VARINT,
+                    firestore_client_MaybeDocument_has_committed_mutations_tag);
+    writer.WriteBool(true);
+  }
+  return writer.Release();
+}
+
 google_firestore_v1_Document LocalSerializer::EncodeDocument(
     const Document& doc) const {
   google_firestore_v1_Document result{};
@@ -202,7 +271,8 @@ firestore_client_Target LocalSerializer::EncodeQueryData(
       query_data.snapshot_version().timestamp());
 
   // Force a copy because pb_release would otherwise double-free.
-  result.resume_token = nanopb::CopyBytesArray(query_data.resume_token().get());
+  result.resume_token = nanopb::AllocateBytesArray(
+      query_data.resume_token().data(), query_data.resume_token().size());
 
   const Query& query = query_data.query();
   if (query.IsDocumentQuery()) {
@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LOCAL_SERIALIZER_H_
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
@@ -34,6 +35,7 @@
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
 #include "Firestore/core/src/firebase/firestore/remote/serializer.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -65,7 +67,8 @@ class LocalSerializer {
   /**
    * Release memory allocated by the Encode* methods that return protos.
    *
-   * This essentially wraps calls to nanopb's pb_release() method.
+   * This essentially wraps calls to nanopb's pb_release() method. See
+   * remote::Serializer::FreeNanopbMessage() for use with a nanopb::Arena.
    */
   static void FreeNanopbMessage(const pb_field_t fields[], void* dest_struct) {
     remote::Serializer::FreeNanopbMessage(fields, dest_struct);
@@ -86,6 +89,20 @@ class LocalSerializer {
       nanopb::Reader* reader,
       const firestore_client_MaybeDocument& proto) const;
 
+  /**
+   * Encodes a MaybeDocument message for local storage around the bytes of an
+   * already encoded google_firestore_v1_Document, such as one received from
+   * the backend, without decoding and re-encoding its fields.
+   *
+   * If `name_prefix` is given, it's removed from the start of the document's
+   * name, so that `projects/{p}/databases/{d}/` leaves the name relative to
+   * the database, as `documents/{path}`.
+   */
+  static std::string EncodeMaybeDocumentBytes(
+      absl::string_view document_bytes,
+      bool has_committed_mutations,
+      absl::string_view name_prefix = {});
+
   /**
    * @brief Encodes a QueryData to the equivalent nanopb proto, representing a
    * ::firestore::proto::Target, for local storage.
@@ -20,6 +20,7 @@
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 
 namespace firebase {
@@ -33,11 +34,28 @@ class LocalWriteResult {
       : batch_id_(batch_id), changes_(std::move(changes)) {
   }
 
+  LocalWriteResult(model::BatchId batch_id,
+                   model::BatchId merged_batch_id,
+                   model::MaybeDocumentMap&& changes)
+      : batch_id_(batch_id),
+        merged_batch_id_(merged_batch_id),
+        changes_(std::move(changes)) {
+  }
+
   /** The batch ID of the local write. */
   model::BatchId batch_id() const {
     return batch_id_;
   }
 
+  /**
+   * The ID of an earlier pending batch that was merged into the batch of this
+   * write, or `kBatchIdUnknown` if there was none. The merged batch is gone,
+   * though its ID may have been reused for the new batch.
+   */
+  model::BatchId merged_batch_id() const {
+    return merged_batch_id_;
+  }
+
   /** The document changes resulting from the local write. */
   const model::MaybeDocumentMap& changes() const {
     return changes_;
@@ -45,6 +63,7 @@ class LocalWriteResult {
 
  private:
   model::BatchId batch_id_;
+  model::BatchId merged_batch_id_ = model::kBatchIdUnknown;
   model::MaybeDocumentMap changes_;
 };
 
@@ -28,6 +28,10 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::FieldPath;
+using model::ObjectValue;
 using model::ResourcePath;
 
 bool MemoryCollectionParentIndex::Add(const ResourcePath& collection_path) {
@@ -40,6 +44,10 @@ bool MemoryCollectionParentIndex::Add(const ResourcePath& collection_path) {
   return inserted;
 }
 
+void MemoryCollectionParentIndex::Clear() {
+  index_.clear();
+}
+
 std::vector<ResourcePath> MemoryCollectionParentIndex::GetEntries(
     const std::string& collection_id) const {
   std::vector<ResourcePath> result;
@@ -62,6 +70,32 @@ std::vector<ResourcePath> MemoryIndexManager::GetCollectionParents(
   return collection_parents_index_.GetEntries(collection_id);
 }
 
+bool MemoryIndexManager::HasFieldIndex(const ResourcePath&, const FieldPath&) {
+  return false;
+}
+
+bool MemoryIndexManager::AddFieldIndex(const ResourcePath&, const FieldPath&) {
+  return false;
+}
+
+void MemoryIndexManager::AddToFieldIndexes(const DocumentKey&,
+                                           const ObjectValue&) {
+}
+
+void MemoryIndexManager::RemoveFromFieldIndexes(const DocumentKey&) {
+}
+
+DocumentKeySet MemoryIndexManager::GetDocumentsMatchingFieldIndex(
+    const ResourcePath&, const FieldIndexScan&) {
+  HARD_FAIL("MemoryIndexManager does not maintain field indexes");
+}
+
+void MemoryIndexManager::ScanFieldIndex(const ResourcePath&,
+                                        const FieldIndexScan&,
+                                        const FieldIndexVisitor&) {
+  HARD_FAIL("MemoryIndexManager does not maintain field indexes");
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
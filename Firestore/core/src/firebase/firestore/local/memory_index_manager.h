@@ -42,11 +42,19 @@ class MemoryCollectionParentIndex {
   std::vector<model::ResourcePath> GetEntries(
       const std::string& collection_id) const;
 
+  /** Removes all entries. */
+  void Clear();
+
  private:
   std::unordered_map<std::string, std::set<model::ResourcePath>> index_;
 };
 
-/** An in-memory implementation of IndexManager. */
+/**
+ * An in-memory implementation of IndexManager.
+ *
+ * Field indexes are not maintained since scanning an in-memory collection is
+ * already cheap.
+ */
 class MemoryIndexManager : public IndexManager {
  public:
   void AddToCollectionParentIndex(
@@ -55,6 +63,25 @@ class MemoryIndexManager : public IndexManager {
   std::vector<model::ResourcePath> GetCollectionParents(
       const std::string& collection_id) override;
 
+  bool HasFieldIndex(const model::ResourcePath& collection_path,
+                     const model::FieldPath& field_path) override;
+
+  bool AddFieldIndex(const model::ResourcePath& collection_path,
+                     const model::FieldPath& field_path) override;
+
+  void AddToFieldIndexes(const model::DocumentKey& key,
+                         const model::ObjectValue& data) override;
+
+  void RemoveFromFieldIndexes(const model::DocumentKey& key) override;
+
+  model::DocumentKeySet GetDocumentsMatchingFieldIndex(
+      const model::ResourcePath& collection_path,
+      const FieldIndexScan& scan) override;
+
+  void ScanFieldIndex(const model::ResourcePath& collection_path,
+                      const FieldIndexScan& scan,
+                      const FieldIndexVisitor& visitor) override;
+
  private:
   MemoryCollectionParentIndex collection_parents_index_;
 };
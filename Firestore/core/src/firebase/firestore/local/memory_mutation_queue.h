@@ -23,6 +23,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <map>
 #include <set>
 #include <vector>
 
@@ -32,6 +33,7 @@
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 
 @class FSTLocalSerializer;
@@ -54,6 +56,11 @@ class MemoryMutationQueue : public MutationQueue {
 
   bool IsEmpty() override;
 
+  /**
+   * Batches held in memory aren't encoded, so only their number is reported.
+   */
+  PendingWrites GetPendingWrites() override;
+
   void AcknowledgeBatch(FSTMutationBatch* batch,
                         NSData* _Nullable stream_token) override;
 
@@ -83,6 +90,9 @@ class MemoryMutationQueue : public MutationQueue {
   FSTMutationBatch* _Nullable NextMutationBatchAfterBatchId(
       model::BatchId batch_id) override;
 
+  std::vector<FSTMutationBatch*> NextMutationBatchesAfterBatchId(
+      model::BatchId batch_id, size_t max_count, size_t max_bytes) override;
+
   void PerformConsistencyCheck() override;
 
   bool ContainsKey(const model::DocumentKey& key);
@@ -147,6 +157,13 @@ class MemoryMutationQueue : public MutationQueue {
 
   /** An ordered mapping between documents and the mutation batch IDs. */
   DocumentKeyReferenceSet batches_by_document_key_;
+
+  /**
+   * A mapping from collections to the IDs of the mutation batches that mutate
+   * immediate children of the collection.
+   */
+  std::map<model::ResourcePath, std::set<model::BatchId>>
+      batches_by_collection_;
 };
 
 }  // namespace local
@@ -16,7 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/local/memory_mutation_queue.h"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Protos/objc/firestore/local/Mutation.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
@@ -50,6 +52,12 @@ bool MemoryMutationQueue::IsEmpty() {
   return queue_.empty();
 }
 
+PendingWrites MemoryMutationQueue::GetPendingWrites() {
+  PendingWrites pending;
+  pending.batch_count = static_cast<int64_t>(queue_.size());
+  return pending;
+}
+
 void MemoryMutationQueue::AcknowledgeBatch(FSTMutationBatch* batch,
                                            NSData* _Nullable stream_token) {
   HARD_ASSERT(!queue_.empty(), "Cannot acknowledge batch on an empty queue");
@@ -95,10 +103,12 @@ FSTMutationBatch* MemoryMutationQueue::AddMutationBatch(
                                       mutations:std::move(mutations)];
   queue_.push_back(batch);
 
-  // Track references by document key and index collection parents.
+  // Track references by document key and collection, and index collection
+  // parents.
   for (FSTMutation* mutation : [batch mutations]) {
     batches_by_document_key_ = batches_by_document_key_.insert(
         DocumentKeyReference{mutation.key, batch_id});
+    batches_by_collection_[mutation.key.path().PopLast()].insert(batch_id);
 
     persistence_.indexManager->AddToCollectionParentIndex(
         mutation.key.path().PopLast());
@@ -108,13 +118,19 @@ FSTMutationBatch* MemoryMutationQueue::AddMutationBatch(
 }
 
 void MemoryMutationQueue::RemoveMutationBatch(FSTMutationBatch* batch) {
-  // Can only remove the first batch
+  // Can only remove the first or the last batch
   HARD_ASSERT(!queue_.empty(), "Trying to remove batch from empty queue");
-  FSTMutationBatch* head = queue_.front();
-  HARD_ASSERT(head.batchID == batch.batchID,
-              "Can only remove the first entry of the mutation queue");
-
-  queue_.erase(queue_.begin());
+  if (queue_.size() > 1 && queue_.back().batchID == batch.batchID) {
+    // Batch IDs in the queue have to stay contiguous for IndexOfBatchId, so
+    // the next batch reuses the ID.
+    queue_.pop_back();
+    next_batch_id_ = batch.batchID;
+  } else {
+    FSTMutationBatch* head = queue_.front();
+    HARD_ASSERT(head.batchID == batch.batchID,
+                "Can only remove the first or last entry of the mutation queue");
+    queue_.erase(queue_.begin());
+  }
 
   // Remove entries from the index too.
   for (FSTMutation* mutation : [batch mutations]) {
@@ -123,6 +139,14 @@ void MemoryMutationQueue::RemoveMutationBatch(FSTMutationBatch* batch) {
 
     DocumentKeyReference reference{key, batch.batchID};
     batches_by_document_key_ = batches_by_document_key_.erase(reference);
+
+    auto found = batches_by_collection_.find(key.path().PopLast());
+    if (found != batches_by_collection_.end()) {
+      found->second.erase(batch.batchID);
+      if (found->second.empty()) {
+        batches_by_collection_.erase(found);
+      }
+    }
   }
 }
 
@@ -166,42 +190,12 @@ MemoryMutationQueue::AllMutationBatchesAffectingQuery(FSTQuery* query) {
       ![query isCollectionGroupQuery],
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
-  // Use the query path as a prefix for testing if a document matches the query.
-  const ResourcePath& prefix = query.path;
-  size_t immediate_children_path_length = prefix.size() + 1;
-
-  // Construct a document reference for actually scanning the index. Unlike the
-  // prefix, the document key in this reference must have an even number of
-  // segments. The empty segment can be used as a suffix of the query path
-  // because it precedes all other segments in an ordered traversal.
-  ResourcePath start_path = query.path;
-  if (!DocumentKey::IsDocumentKey(start_path)) {
-    start_path = start_path.Append("");
+  auto found = batches_by_collection_.find(query.path);
+  if (found == batches_by_collection_.end()) {
+    return {};
   }
-  DocumentKeyReference start{DocumentKey{start_path}, 0};
-
-  // Find unique batchIDs referenced by all documents potentially matching the
-  // query.
-  std::set<BatchId> unique_batch_ids;
-  for (const auto& reference : batches_by_document_key_.values_from(start)) {
-    const ResourcePath& row_key_path = reference.key().path();
-    if (!prefix.IsPrefixOf(row_key_path)) {
-      break;
-    }
-
-    // Rows with document keys more than one segment longer than the query path
-    // can't be matches. For example, a query on 'rooms' can't match the
-    // document /rooms/abc/messages/xyx.
-    // TODO(mcg): we'll need a different scanner when we implement ancestor
-    // queries.
-    if (row_key_path.size() != immediate_children_path_length) {
-      continue;
-    }
-
-    unique_batch_ids.insert(reference.ref_id());
-  };
 
-  return AllMutationBatchesWithIds(unique_batch_ids);
+  return AllMutationBatchesWithIds(found->second);
 }
 
 FSTMutationBatch* _Nullable MemoryMutationQueue::NextMutationBatchAfterBatchId(
@@ -215,6 +209,17 @@ FSTMutationBatch* _Nullable MemoryMutationQueue::NextMutationBatchAfterBatchId(
   return queue_.size() > index ? queue_[index] : nil;
 }
 
+std::vector<FSTMutationBatch*>
+MemoryMutationQueue::NextMutationBatchesAfterBatchId(BatchId batch_id,
+                                                     size_t max_count,
+                                                     size_t) {
+  int raw_index = IndexOfBatchId(batch_id + 1);
+  size_t begin = raw_index < 0 ? 0 : static_cast<size_t>(raw_index);
+  begin = std::min(begin, queue_.size());
+  size_t end = begin + std::min(max_count, queue_.size() - begin);
+  return {queue_.begin() + begin, queue_.begin() + end};
+}
+
 FSTMutationBatch* _Nullable MemoryMutationQueue::LookupMutationBatch(
     BatchId batch_id) {
   if (queue_.empty()) {
@@ -233,7 +238,8 @@ FSTMutationBatch* _Nullable MemoryMutationQueue::LookupMutationBatch(
 
 void MemoryMutationQueue::PerformConsistencyCheck() {
   if (queue_.empty()) {
-    HARD_ASSERT(batches_by_document_key_.empty(),
+    HARD_ASSERT(batches_by_document_key_.empty() &&
+                    batches_by_collection_.empty(),
                 "Document leak -- detected dangling mutation references when "
                 "queue is empty.");
   }
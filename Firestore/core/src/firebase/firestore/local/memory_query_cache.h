@@ -28,7 +28,7 @@
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/local/query_cache.h"
-#include "Firestore/core/src/firebase/firestore/local/reference_set.h"
+#include "Firestore/core/src/firebase/firestore/local/target_key_index.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
@@ -109,10 +109,10 @@ class MemoryQueryCache : public QueryCache {
   objc::unordered_map<FSTQuery*, FSTQueryData*> queries_;
 
   /**
-   * A ordered bidirectional mapping between documents and the remote target
-   * IDs.
+   * A bidirectional mapping between documents and the remote target IDs,
+   * updated in place so that large target changes stay cheap.
    */
-  ReferenceSet references_;
+  TargetKeyIndex references_;
 };
 
 }  // namespace local
@@ -64,7 +64,7 @@ void MemoryQueryCache::UpdateTarget(FSTQueryData* query_data) {
 
 void MemoryQueryCache::RemoveTarget(FSTQueryData* query_data) {
   queries_.erase(query_data.query);
-  references_.RemoveReferences(query_data.targetID);
+  references_.RemoveTarget(query_data.targetID);
 }
 
 FSTQueryData* _Nullable MemoryQueryCache::GetTarget(FSTQuery* query) {
@@ -89,7 +89,7 @@ int MemoryQueryCache::RemoveTargets(
     if (query_data.sequenceNumber <= upper_bound) {
       if (live_targets.find(query_data.targetID) == live_targets.end()) {
         to_remove.push_back(query);
-        references_.RemoveReferences(query_data.targetID);
+        references_.RemoveTarget(query_data.targetID);
       }
     }
   }
@@ -102,7 +102,7 @@ int MemoryQueryCache::RemoveTargets(
 
 void MemoryQueryCache::AddMatchingKeys(const DocumentKeySet& keys,
                                        TargetId target_id) {
-  references_.AddReferences(keys, target_id);
+  references_.AddKeys(keys, target_id);
   for (const DocumentKey& key : keys) {
     [persistence_.referenceDelegate addReference:key];
   }
@@ -110,14 +110,14 @@ void MemoryQueryCache::AddMatchingKeys(const DocumentKeySet& keys,
 
 void MemoryQueryCache::RemoveMatchingKeys(const DocumentKeySet& keys,
                                           TargetId target_id) {
-  references_.RemoveReferences(keys, target_id);
+  references_.RemoveKeys(keys, target_id);
   for (const DocumentKey& key : keys) {
     [persistence_.referenceDelegate removeReference:key];
   }
 }
 
 DocumentKeySet MemoryQueryCache::GetMatchingKeys(TargetId target_id) {
-  return references_.ReferencedKeys(target_id);
+  return references_.MatchingKeys(target_id);
 }
 
 bool MemoryQueryCache::Contains(const DocumentKey& key) {
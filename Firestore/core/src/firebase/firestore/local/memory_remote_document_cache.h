@@ -21,13 +21,18 @@
 #error "For now, this file must only be included by ObjC source files."
 #endif  // !defined(__OBJC__)
 
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/types/optional.h"
 
 @class FSTLocalSerializer;
 @class FSTMaybeDocument;
@@ -45,22 +50,77 @@ class MemoryRemoteDocumentCache : public RemoteDocumentCache {
  public:
   explicit MemoryRemoteDocumentCache(FSTMemoryPersistence* persistence);
 
-  void Add(FSTMaybeDocument* document) override;
+  void Add(FSTMaybeDocument* document,
+           const model::SnapshotVersion& read_time) override;
   void Remove(const model::DocumentKey& key) override;
 
   FSTMaybeDocument* _Nullable Get(const model::DocumentKey& key) override;
   model::MaybeDocumentMap GetAll(const model::DocumentKeySet& keys) override;
   model::DocumentMap GetMatching(FSTQuery* query) override;
+  model::DocumentMap GetFirstMatching(
+      FSTQuery* query,
+      const absl::optional<model::DocumentKey>& start_after,
+      size_t limit) override;
+  model::DocumentMap GetReadSince(
+      FSTQuery* query, const model::SnapshotVersion& read_time) override;
 
   std::vector<model::DocumentKey> RemoveOrphanedDocuments(
       FSTMemoryLRUReferenceDelegate* reference_delegate,
       model::ListenSequenceNumber upper_bound);
 
+  /**
+   * Returns the encoded size of the cached entries plus an estimate of the
+   * size of their keys.
+   *
+   * The first call encodes every entry; later calls only encode the entries
+   * added since the previous call.
+   */
   size_t CalculateByteSize(FSTLocalSerializer* serializer);
 
  private:
-  /** Underlying cache of documents. */
-  model::MaybeDocumentMap docs_;
+  /**
+   * Returns the documents in every collection with the given ID, visiting the
+   * parents of the collection group recorded in the index manager.
+   */
+  model::DocumentMap GetMatchingCollectionGroup(
+      const std::string& collection_id);
+
+  /**
+   * Returns the cached entries whose parent is the given collection, or null
+   * if there are none.
+   */
+  const model::MaybeDocumentMap* _Nullable FindCollection(
+      const model::ResourcePath& collection_path) const;
+
+  /** Forgets the size of the entry for the given key, if it's known. */
+  void ForgetSize(const model::DocumentKey& key);
+
+  struct ResourcePathHash {
+    size_t operator()(const model::ResourcePath& path) const {
+      return path.Hash();
+    }
+  };
+
+  /**
+   * Underlying cache of documents, bucketed by the collection that contains
+   * them so that a collection query visits only the collection's own
+   * documents and none in its subcollections. Buckets are never empty.
+   */
+  std::unordered_map<model::ResourcePath,
+                     model::MaybeDocumentMap,
+                     ResourcePathHash>
+      collections_;
+
+  /**
+   * Once `CalculateByteSize` has been called, the sum and the individual
+   * sizes of the entries it has sized, and the keys of the entries added
+   * since, which it has yet to size.
+   */
+  bool sizing_ = false;
+  size_t byte_size_ = 0;
+  std::unordered_map<model::DocumentKey, size_t, model::DocumentKeyHash>
+      sizes_;
+  std::unordered_set<model::DocumentKey, model::DocumentKeyHash> unsized_;
 
   // This instance is owned by FSTMemoryPersistence; avoid a retain cycle.
   __weak FSTMemoryPersistence* persistence_;
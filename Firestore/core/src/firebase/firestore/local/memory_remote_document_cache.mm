@@ -16,11 +16,19 @@
 
 #include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
 
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
 #import "Firestore/Protos/objc/firestore/local/MaybeDocument.pbobjc.h"
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTMemoryPersistence.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 
+#include "Firestore/core/src/firebase/firestore/local/index_manager.h"
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 
 using firebase::firestore::model::DocumentKey;
@@ -28,6 +36,8 @@ using firebase::firestore::model::DocumentKeySet;
 using firebase::firestore::model::DocumentMap;
 using firebase::firestore::model::ListenSequenceNumber;
 using firebase::firestore::model::MaybeDocumentMap;
+using firebase::firestore::model::ResourcePath;
+using firebase::firestore::model::SnapshotVersion;
 
 namespace firebase {
 namespace firestore {
@@ -53,56 +63,142 @@ MemoryRemoteDocumentCache::MemoryRemoteDocumentCache(
   persistence_ = persistence;
 }
 
-void MemoryRemoteDocumentCache::Add(FSTMaybeDocument* document) {
-  docs_ = docs_.insert(document.key, document);
+void MemoryRemoteDocumentCache::Add(FSTMaybeDocument* document,
+                                    const SnapshotVersion&) {
+  const DocumentKey& key = document.key;
+  MaybeDocumentMap& docs = collections_[key.path().PopLast()];
+  docs = docs.insert(key, document);
+  if (sizing_) {
+    ForgetSize(key);
+    unsized_.insert(key);
+  }
 
-  persistence_.indexManager->AddToCollectionParentIndex(
-      document.key.path().PopLast());
+  persistence_.indexManager->AddToCollectionParentIndex(key.path().PopLast());
 }
 
 void MemoryRemoteDocumentCache::Remove(const DocumentKey& key) {
-  docs_ = docs_.erase(key);
+  if (sizing_) {
+    ForgetSize(key);
+    unsized_.erase(key);
+  }
+
+  auto found = collections_.find(key.path().PopLast());
+  if (found == collections_.end()) {
+    return;
+  }
+
+  found->second = found->second.erase(key);
+  if (found->second.empty()) {
+    collections_.erase(found);
+  }
 }
 
 FSTMaybeDocument* _Nullable MemoryRemoteDocumentCache::Get(
     const DocumentKey& key) {
-  auto found = docs_.find(key);
-  return found != docs_.end() ? found->second : nil;
+  const MaybeDocumentMap* docs = FindCollection(key.path().PopLast());
+  if (!docs) {
+    return nil;
+  }
+
+  auto found = docs->find(key);
+  return found != docs->end() ? found->second : nil;
 }
 
 MaybeDocumentMap MemoryRemoteDocumentCache::GetAll(const DocumentKeySet& keys) {
-  MaybeDocumentMap results;
+  MaybeDocumentMap::Builder results;
+  results.reserve(keys.size());
   for (const DocumentKey& key : keys) {
     // Make sure each key has a corresponding entry, which is null in case the
     // document is not found.
     // TODO(http://b/32275378): Don't conflate missing / deleted.
-    results = results.insert(key, Get(key));
+    results.push_back(key, Get(key));
   }
-  return results;
+  return results.Build();
 }
 
 DocumentMap MemoryRemoteDocumentCache::GetMatching(FSTQuery* query) {
+  if ([query isCollectionGroupQuery]) {
+    return GetMatchingCollectionGroup(*query.collectionGroup);
+  }
+  return GetFirstMatching(query, absl::nullopt,
+                          std::numeric_limits<size_t>::max());
+}
+
+DocumentMap MemoryRemoteDocumentCache::GetFirstMatching(
+    FSTQuery* query,
+    const absl::optional<DocumentKey>& start_after,
+    size_t limit) {
   HARD_ASSERT(
       ![query isCollectionGroupQuery],
       "CollectionGroup queries should be handled in LocalDocumentsView");
+  HARD_ASSERT(
+      !start_after || query.path.IsImmediateParentOf(start_after->path()),
+      "Can only start after a document in the queried collection");
 
   DocumentMap results;
+  const MaybeDocumentMap* docs = FindCollection(query.path);
+  if (!docs) {
+    return results;
+  }
 
-  // Documents are ordered by key, so we can use a prefix scan to narrow down
-  // the documents we need to match the query against.
-  DocumentKey prefix{query.path.Append("")};
-  for (auto it = docs_.lower_bound(prefix); it != docs_.end(); ++it) {
-    const DocumentKey& key = it->first;
-    if (!query.path.IsPrefixOf(key.path())) {
-      break;
+  // Only the direct children of the collection are in its bucket, already in
+  // key order.
+  QueryProfile* profile = QueryProfile::current();
+  auto it = docs->begin();
+  if (start_after) {
+    it = docs->lower_bound(*start_after);
+    if (it != docs->end() && it->first == *start_after) {
+      ++it;
     }
+  }
+  for (; it != docs->end() && results.size() < limit; ++it) {
     FSTMaybeDocument* maybeDoc = it->second;
     if (![maybeDoc isKindOfClass:[FSTDocument class]]) {
       continue;
     }
+    if (profile) {
+      profile->documents_scanned++;
+    }
     FSTDocument* doc = static_cast<FSTDocument*>(maybeDoc);
     if ([query matchesDocument:doc]) {
-      results = results.insert(key, doc);
+      results = results.insert(it->first, doc);
+    }
+  }
+  return results;
+}
+
+DocumentMap MemoryRemoteDocumentCache::GetReadSince(FSTQuery* query,
+                                                    const SnapshotVersion&) {
+  // Read times aren't tracked in memory, where scanning a collection is cheap
+  // anyway, so answer with every matching document.
+  return GetMatching(query);
+}
+
+DocumentMap MemoryRemoteDocumentCache::GetMatchingCollectionGroup(
+    const std::string& collection_id) {
+  std::vector<ResourcePath> parents =
+      persistence_.indexManager->GetCollectionParents(collection_id);
+  QueryProfile* profile = QueryProfile::current();
+  if (profile) {
+    profile->collection_parents_visited += parents.size();
+  }
+
+  DocumentMap results;
+  for (const ResourcePath& parent : parents) {
+    const MaybeDocumentMap* docs =
+        FindCollection(parent.Append(collection_id));
+    if (!docs) {
+      continue;
+    }
+
+    for (const auto& kv : *docs) {
+      if (![kv.second isKindOfClass:[FSTDocument class]]) {
+        continue;
+      }
+      if (profile) {
+        profile->documents_scanned++;
+      }
+      results = results.insert(kv.first, static_cast<FSTDocument*>(kv.second));
     }
   }
   return results;
@@ -112,27 +208,71 @@ std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
     FSTMemoryLRUReferenceDelegate* reference_delegate,
     ListenSequenceNumber upper_bound) {
   std::vector<DocumentKey> removed;
-  MaybeDocumentMap updated_docs = docs_;
-  for (const auto& kv : docs_) {
-    const DocumentKey& key = kv.first;
-    if (![reference_delegate isPinnedAtSequenceNumber:upper_bound
-                                             document:key]) {
-      updated_docs = updated_docs.erase(key);
-      removed.push_back(key);
+  for (auto bucket = collections_.begin(); bucket != collections_.end();) {
+    MaybeDocumentMap updated_docs = bucket->second;
+    for (const auto& kv : bucket->second) {
+      const DocumentKey& key = kv.first;
+      if (![reference_delegate isPinnedAtSequenceNumber:upper_bound
+                                               document:key]) {
+        updated_docs = updated_docs.erase(key);
+        removed.push_back(key);
+        if (sizing_) {
+          ForgetSize(key);
+          unsized_.erase(key);
+        }
+      }
+    }
+
+    if (updated_docs.empty()) {
+      bucket = collections_.erase(bucket);
+    } else {
+      bucket->second = std::move(updated_docs);
+      ++bucket;
     }
   }
-  docs_ = updated_docs;
+
+  // Report the removed documents in key order, as if they were in one map.
+  std::sort(removed.begin(), removed.end());
   return removed;
 }
 
 size_t MemoryRemoteDocumentCache::CalculateByteSize(
     FSTLocalSerializer* serializer) {
-  size_t count = 0;
-  for (const auto& kv : docs_) {
-    count += DocumentKeyByteSize(kv.first);
-    count += [[serializer encodedMaybeDocument:kv.second] serializedSize];
+  auto size_entry = [&](const DocumentKey& key, FSTMaybeDocument* document) {
+    size_t size = DocumentKeyByteSize(key) +
+                  [[serializer encodedMaybeDocument:document] serializedSize];
+    sizes_[key] = size;
+    byte_size_ += size;
+  };
+
+  if (!sizing_) {
+    sizing_ = true;
+    for (const auto& bucket : collections_) {
+      for (const auto& kv : bucket.second) {
+        size_entry(kv.first, kv.second);
+      }
+    }
+  } else {
+    for (const DocumentKey& key : unsized_) {
+      size_entry(key, Get(key));
+    }
   }
-  return count;
+  unsized_.clear();
+  return byte_size_;
+}
+
+void MemoryRemoteDocumentCache::ForgetSize(const DocumentKey& key) {
+  auto found = sizes_.find(key);
+  if (found != sizes_.end()) {
+    byte_size_ -= found->second;
+    sizes_.erase(found);
+  }
+}
+
+const MaybeDocumentMap* MemoryRemoteDocumentCache::FindCollection(
+    const ResourcePath& collection_path) const {
+  auto found = collections_.find(collection_path);
+  return found != collections_.end() ? &found->second : nullptr;
 }
 
 }  // namespace local
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/local/pending_writes.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
@@ -55,6 +56,12 @@ class MutationQueue {
   /** Returns true if this queue contains no mutation batches. */
   virtual bool IsEmpty() = 0;
 
+  /**
+   * Returns the number and size of the mutation batches in this queue, without
+   * reading them.
+   */
+  virtual PendingWrites GetPendingWrites() = 0;
+
   /** Acknowledges the given batch. */
   virtual void AcknowledgeBatch(FSTMutationBatch* batch,
                                 NSData* _Nullable stream_token) = 0;
@@ -79,6 +86,9 @@ class MutationQueue {
    *
    * + Removing applied mutations from the head of the queue
    * + Removing rejected mutations from anywhere in the queue
+   *
+   * The local store also removes the last batch in the queue when it merges
+   * the batch into a new one.
    */
   virtual void RemoveMutationBatch(FSTMutationBatch* batch) = 0;
 
@@ -150,6 +160,23 @@ class MutationQueue {
   virtual FSTMutationBatch* _Nullable NextMutationBatchAfterBatchId(
       model::BatchId batch_id) = 0;
 
+  /**
+   * Gets the unacknowledged mutation batches after the passed in batchId in
+   * the mutation queue, in order, reading them in a single pass.
+   *
+   * @param batch_id The batch to search after, or kBatchIdUnknown to start
+   * with the first mutation in the queue.
+   * @param max_count The maximum number of batches to return.
+   * @param max_bytes Once the encoded batches read add up to this size, no
+   * more are read, or zero for no limit. Ignored by queues that don't encode
+   * their batches.
+   *
+   * @return the batches found, which are fewer than `max_count` only if they
+   * ran out or reached `max_bytes`.
+   */
+  virtual std::vector<FSTMutationBatch*> NextMutationBatchesAfterBatchId(
+      model::BatchId batch_id, size_t max_count, size_t max_bytes) = 0;
+
   /**
    * Performs a consistency check, examining the mutation queue for any leaks,
    * if possible.
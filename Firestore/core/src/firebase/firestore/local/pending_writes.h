@@ -0,0 +1,64 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_PENDING_WRITES_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_PENDING_WRITES_H_
+
+#include <cstdint>
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * The backlog of a mutation queue: the writes that are waiting to be
+ * acknowledged by the backend.
+ */
+struct PendingWrites {
+  /** The number of mutation batches in the queue. */
+  int64_t batch_count = 0;
+
+  /**
+   * The total size in bytes of the encoded batches, or zero if the queue
+   * doesn't encode them.
+   */
+  int64_t byte_size = 0;
+
+  /**
+   * Returns true if either amount has reached the corresponding amount of
+   * `threshold`. Amounts of zero in `threshold` are ignored.
+   */
+  bool Reaches(const PendingWrites& threshold) const {
+    return (threshold.batch_count > 0 &&
+            batch_count >= threshold.batch_count) ||
+           (threshold.byte_size > 0 && byte_size >= threshold.byte_size);
+  }
+
+  friend bool operator==(const PendingWrites& lhs, const PendingWrites& rhs) {
+    return lhs.batch_count == rhs.batch_count &&
+           lhs.byte_size == rhs.byte_size;
+  }
+
+  friend bool operator!=(const PendingWrites& lhs, const PendingWrites& rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_PENDING_WRITES_H_
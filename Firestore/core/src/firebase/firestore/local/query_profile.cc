@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
+
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "absl/base/config.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+thread_local QueryProfile* current_profile = nullptr;
+#endif
+
+}  // namespace
+
+QueryProfile& QueryProfile::operator+=(const QueryProfile& other) {
+  documents_scanned += other.documents_scanned;
+  documents_matched += other.documents_matched;
+  mutation_batches_scanned += other.mutation_batches_scanned;
+  collection_parents_visited += other.collection_parents_visited;
+  decode_time += other.decode_time;
+  view_diff_time += other.view_diff_time;
+  return *this;
+}
+
+std::string QueryProfile::ToString() const {
+  using std::chrono::microseconds;
+  using std::chrono::duration_cast;
+
+  return util::StringFormat(
+      "QueryProfile(documents_scanned=%s, documents_matched=%s, "
+      "mutation_batches_scanned=%s, collection_parents_visited=%s, "
+      "decode_time=%sus, view_diff_time=%sus)",
+      documents_scanned, documents_matched, mutation_batches_scanned,
+      collection_parents_visited,
+      duration_cast<microseconds>(decode_time).count(),
+      duration_cast<microseconds>(view_diff_time).count());
+}
+
+QueryProfile* QueryProfile::current() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  return current_profile;
+#else
+  return nullptr;
+#endif
+}
+
+bool operator==(const QueryProfile& lhs, const QueryProfile& rhs) {
+  return lhs.documents_scanned == rhs.documents_scanned &&
+         lhs.documents_matched == rhs.documents_matched &&
+         lhs.mutation_batches_scanned == rhs.mutation_batches_scanned &&
+         lhs.collection_parents_visited == rhs.collection_parents_visited &&
+         lhs.decode_time == rhs.decode_time &&
+         lhs.view_diff_time == rhs.view_diff_time;
+}
+
+QueryProfileScope::QueryProfileScope(QueryProfile* profile) {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  previous_ = current_profile;
+  current_profile = profile;
+#else
+  (void)profile;
+#endif
+}
+
+QueryProfileScope::~QueryProfileScope() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  current_profile = previous_;
+#endif
+}
+
+void QueryProfileTotals::Add(const QueryProfile& profile) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  totals_ += profile;
+  ++query_count_;
+}
+
+QueryProfile QueryProfileTotals::Get() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return totals_;
+}
+
+size_t QueryProfileTotals::query_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return query_count_;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
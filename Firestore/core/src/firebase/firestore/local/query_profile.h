@@ -0,0 +1,118 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_PROFILE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_PROFILE_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * How much work executing a query against the local cache took.
+ *
+ * While a QueryProfileScope is active on the current thread, the local store
+ * records into its profile as it reads documents and mutation batches. Where
+ * a count is not meaningful for a given persistence implementation it stays
+ * zero.
+ */
+struct QueryProfile {
+  using Duration = std::chrono::nanoseconds;
+
+  /** The number of remote documents read from the cache. */
+  size_t documents_scanned = 0;
+
+  /** The number of documents in the results of the query. */
+  size_t documents_matched = 0;
+
+  /** The number of mutation batches read for the query. */
+  size_t mutation_batches_scanned = 0;
+
+  /** The number of parent paths a collection group query was run against. */
+  size_t collection_parents_visited = 0;
+
+  /** The time spent decoding documents read from the cache. */
+  Duration decode_time{0};
+
+  /** The time spent computing the view of the results. */
+  Duration view_diff_time{0};
+
+  /** Adds all the counts and times of `other` to this profile. */
+  QueryProfile& operator+=(const QueryProfile& other);
+
+  std::string ToString() const;
+
+  /**
+   * Returns the profile of the innermost QueryProfileScope active on this
+   * thread, or null if there is none. Always null on platforms without
+   * `thread_local`.
+   */
+  static QueryProfile* current();
+};
+
+bool operator==(const QueryProfile& lhs, const QueryProfile& rhs);
+
+inline bool operator!=(const QueryProfile& lhs, const QueryProfile& rhs) {
+  return !(lhs == rhs);
+}
+
+/**
+ * Makes a QueryProfile the one recorded into on the current thread for the
+ * lifetime of this object. Scopes nest; the previous profile is restored when
+ * a scope ends.
+ */
+class QueryProfileScope {
+ public:
+  explicit QueryProfileScope(QueryProfile* profile);
+  ~QueryProfileScope();
+
+  QueryProfileScope(const QueryProfileScope&) = delete;
+  QueryProfileScope& operator=(const QueryProfileScope&) = delete;
+
+ private:
+  QueryProfile* previous_ = nullptr;
+};
+
+/**
+ * Accumulates the profiles of many queries. Thread-safe, so that the totals
+ * can be read from any thread while queries run on the worker queue.
+ */
+class QueryProfileTotals {
+ public:
+  void Add(const QueryProfile& profile);
+
+  /** Returns the sum of all profiles added so far. */
+  QueryProfile Get() const;
+
+  /** Returns the number of profiles added so far. */
+  size_t query_count() const;
+
+ private:
+  mutable std::mutex mutex_;
+  QueryProfile totals_;
+  size_t query_count_ = 0;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_PROFILE_H_
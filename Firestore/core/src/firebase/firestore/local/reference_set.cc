@@ -16,6 +16,10 @@
 
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
 #include "Firestore/core/src/firebase/firestore/local/document_key_reference.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
@@ -27,6 +31,41 @@ namespace local {
 using model::DocumentKey;
 using model::DocumentKeySet;
 
+namespace {
+
+/**
+ * Returns references from the given ID to each of the given keys. Since they
+ * all have the same ID, they are sorted both by key and by ID.
+ */
+std::vector<DocumentKeyReference> MakeReferences(const DocumentKeySet& keys,
+                                                 int id) {
+  std::vector<DocumentKeyReference> references;
+  references.reserve(keys.size());
+  for (const DocumentKey& key : keys) {
+    references.emplace_back(key, id);
+  }
+  return references;
+}
+
+/**
+ * Sorts the references in the order defined by the comparator and drops
+ * duplicates, as `insert_all` and `erase_all` require.
+ */
+template <typename C>
+void SortUnique(std::vector<DocumentKeyReference>* references) {
+  C comparator;
+  std::sort(references->begin(), references->end(),
+            [&](const DocumentKeyReference& lhs,
+                const DocumentKeyReference& rhs) {
+              return comparator.Compare(lhs, rhs) ==
+                     util::ComparisonResult::Ascending;
+            });
+  references->erase(std::unique(references->begin(), references->end()),
+                    references->end());
+}
+
+}  // namespace
+
 void ReferenceSet::AddReference(const DocumentKey& key, int id) {
   DocumentKeyReference reference{key, id};
   by_key_ = by_key_.insert(reference);
@@ -34,9 +73,9 @@ void ReferenceSet::AddReference(const DocumentKey& key, int id) {
 }
 
 void ReferenceSet::AddReferences(const DocumentKeySet& keys, int id) {
-  for (const DocumentKey& key : keys) {
-    AddReference(key, id);
-  }
+  std::vector<DocumentKeyReference> references = MakeReferences(keys, id);
+  by_key_ = by_key_.insert_all(references);
+  by_id_ = by_id_.insert_all(references);
 }
 
 void ReferenceSet::RemoveReference(const DocumentKey& key, int id) {
@@ -45,30 +84,42 @@ void ReferenceSet::RemoveReference(const DocumentKey& key, int id) {
 
 void ReferenceSet::RemoveReferences(
     const firebase::firestore::model::DocumentKeySet& keys, int id) {
-  for (const DocumentKey& key : keys) {
-    RemoveReference(key, id);
-  }
+  std::vector<DocumentKeyReference> references = MakeReferences(keys, id);
+  by_key_ = by_key_.erase_all(references);
+  by_id_ = by_id_.erase_all(references);
+}
+
+void ReferenceSet::UpdateReferences(
+    std::vector<DocumentKeyReference> added,
+    std::vector<DocumentKeyReference> removed) {
+  SortUnique<DocumentKeyReference::ByKey>(&added);
+  SortUnique<DocumentKeyReference::ByKey>(&removed);
+  by_key_ = by_key_.insert_all(added).erase_all(removed);
+
+  SortUnique<DocumentKeyReference::ById>(&added);
+  SortUnique<DocumentKeyReference::ById>(&removed);
+  by_id_ = by_id_.insert_all(added).erase_all(removed);
 }
 
 DocumentKeySet ReferenceSet::RemoveReferences(int id) {
   DocumentKeyReference start{DocumentKey::Empty(), id};
   DocumentKeyReference end{DocumentKey::Empty(), id + 1};
 
-  DocumentKeySet removed{};
-
-  auto initial = by_id_;
-  for (const auto& reference : initial.values_in(start, end)) {
-    RemoveReference(reference);
-    removed = removed.insert(reference.key());
+  std::vector<DocumentKeyReference> references;
+  std::vector<DocumentKey> keys;
+  for (const auto& reference : by_id_.values_in(start, end)) {
+    references.push_back(reference);
+    keys.push_back(reference.key());
   }
-  return removed;
+
+  by_key_ = by_key_.erase_all(references);
+  by_id_ = by_id_.erase_all(references);
+  return DocumentKeySet::FromSortedRange(keys);
 }
 
 void ReferenceSet::RemoveAllReferences() {
-  auto initial = by_key_;
-  for (const DocumentKeyReference& reference : initial) {
-    RemoveReference(reference);
-  }
+  by_key_ = {};
+  by_id_ = {};
 }
 
 void ReferenceSet::RemoveReference(const DocumentKeyReference& reference) {
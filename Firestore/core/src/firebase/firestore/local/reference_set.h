@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_REFERENCE_SET_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_REFERENCE_SET_H_
 
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
 #include "Firestore/core/src/firebase/firestore/local/document_key_reference.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
@@ -55,7 +57,10 @@ class ReferenceSet {
   /** Adds a reference to the given document key for the given Id. */
   void AddReference(const model::DocumentKey& key, int id);
 
-  /** Add references to the given document keys for the given Id. */
+  /**
+   * Add references to the given document keys for the given Id. Adding many
+   * keys at once rebuilds the underlying sets in linear time.
+   */
   void AddReferences(const model::DocumentKeySet& keys, int id);
 
   /** Removes a reference to the given document key for the given Id. */
@@ -64,6 +69,14 @@ class ReferenceSet {
   /** Removes references to the given document keys for the given Id. */
   void RemoveReferences(const model::DocumentKeySet& keys, int id);
 
+  /**
+   * Adds the `added` references, which may be for any number of IDs, and then
+   * removes the `removed` ones. Each of the underlying sets is rebuilt once for
+   * all the additions and once for all the removals, rather than once per ID.
+   */
+  void UpdateReferences(std::vector<DocumentKeyReference> added,
+                        std::vector<DocumentKeyReference> removed);
+
   /** Clears all references with a given ID. Calls -removeReferenceToKey: for
    * each key removed. */
   model::DocumentKeySet RemoveReferences(int id);
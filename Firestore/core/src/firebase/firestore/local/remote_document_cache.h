@@ -26,7 +26,9 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/types/optional.h"
 
 @class FSTMaybeDocument;
 @class FSTQuery;
@@ -57,8 +59,11 @@ class RemoteDocumentCache {
    * entry for the key, it will be replaced.
    *
    * @param document A FSTDocument or FSTDeletedDocument to put in the cache.
+   * @param read_time The snapshot version at which the document was read from
+   * the backend, or the commit version of the write that produced it.
    */
-  virtual void Add(FSTMaybeDocument* document) = 0;
+  virtual void Add(FSTMaybeDocument* document,
+                   const model::SnapshotVersion& read_time) = 0;
 
   /** Removes the cached entry for the given key (no-op if no entry exists). */
   virtual void Remove(const model::DocumentKey& key) = 0;
@@ -89,10 +94,38 @@ class RemoteDocumentCache {
    *
    * Cached FSTDeletedDocument entries have no bearing on query results.
    *
+   * A collection group query is answered for every collection with the
+   * query's collection ID at once.
+   *
    * @param query The query to match documents against.
    * @return The set of matching documents.
    */
   virtual model::DocumentMap GetMatching(FSTQuery* query) = 0;
+
+  /**
+   * Returns the first `limit` cached FSTDocument entries in key order that
+   * match the given collection query, after `start_after` if given.
+   *
+   * Unlike `GetMatching`, every document returned matches `query`, so any
+   * matching document that isn't returned comes after all of those that are.
+   * The query's own limit and sort order are ignored.
+   */
+  virtual model::DocumentMap GetFirstMatching(
+      FSTQuery* query,
+      const absl::optional<model::DocumentKey>& start_after,
+      size_t limit) = 0;
+
+  /**
+   * Returns the cached FSTDocument entries of the collection the given
+   * collection query is on that were added to the cache with a read time at or
+   * after `read_time`.
+   *
+   * Implementations may return extra documents if convenient, up to all of
+   * those matching `query`. The results should be re-filtered by the consumer
+   * before presenting them to the user.
+   */
+  virtual model::DocumentMap GetReadSince(
+      FSTQuery* query, const model::SnapshotVersion& read_time) = 0;
 };
 
 }  // namespace local
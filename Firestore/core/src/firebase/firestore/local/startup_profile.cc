@@ -0,0 +1,43 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/startup_profile.h"
+
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+std::string StartupProfile::ToString() const {
+  using std::chrono::microseconds;
+  using std::chrono::duration_cast;
+
+  return util::StringFormat(
+      "StartupProfile(open_time=%sus, migration_time=%sus, "
+      "persistence_start_time=%sus, mutation_queue_start_time=%sus, "
+      "local_store_start_time=%sus, mutation_queue_deferred=%s)",
+      duration_cast<microseconds>(open_time).count(),
+      duration_cast<microseconds>(migration_time).count(),
+      duration_cast<microseconds>(persistence_start_time).count(),
+      duration_cast<microseconds>(mutation_queue_start_time).count(),
+      duration_cast<microseconds>(local_store_start_time).count(),
+      mutation_queue_deferred);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
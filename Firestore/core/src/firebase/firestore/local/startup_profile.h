@@ -0,0 +1,72 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_STARTUP_PROFILE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_STARTUP_PROFILE_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <string>
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * How long each step of starting the local store took, so that the time
+ * before the first query can be served from the cache can be broken down.
+ * Steps that don't apply to a given persistence implementation stay zero.
+ */
+struct StartupProfile {
+  using Duration = std::chrono::nanoseconds;
+
+  /** The time spent opening the LevelDB database. */
+  Duration open_time{0};
+
+  /** The time spent running schema migrations. */
+  Duration migration_time{0};
+
+  /**
+   * The time spent loading the persistence layer's metadata once the database
+   * is open: the set of users, the query cache and the reference delegate.
+   */
+  Duration persistence_start_time{0};
+
+  /** The time spent starting the mutation queue. */
+  Duration mutation_queue_start_time{0};
+
+  /** The time spent on the rest of starting the local store. */
+  Duration local_store_start_time{0};
+
+  /**
+   * Whether starting the mutation queue was deferred until after the local
+   * store could serve reads.
+   */
+  bool mutation_queue_deferred = false;
+
+  /** Returns the total time spent in all steps. */
+  Duration total_time() const {
+    return open_time + migration_time + persistence_start_time +
+           mutation_queue_start_time + local_store_start_time;
+  }
+
+  std::string ToString() const;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_STARTUP_PROFILE_H_
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/target_key_index.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::TargetId;
+using util::CompressedBitmap;
+
+void TargetKeyIndex::AddKeys(const DocumentKeySet& keys, TargetId target_id) {
+  if (keys.empty()) return;
+
+  CompressedBitmap& target_ids = by_target_[target_id];
+  for (const DocumentKey& key : keys) {
+    uint32_t id = Intern(key);
+    if (target_ids.Add(id)) {
+      ++entries_[id].target_count;
+    }
+  }
+}
+
+void TargetKeyIndex::RemoveKeys(const DocumentKeySet& keys,
+                                TargetId target_id) {
+  auto found = by_target_.find(target_id);
+  if (found == by_target_.end()) return;
+
+  CompressedBitmap& target_ids = found->second;
+  for (const DocumentKey& key : keys) {
+    auto id = ids_.find(key);
+    if (id != ids_.end() && target_ids.Remove(id->second)) {
+      Release(id->second);
+    }
+  }
+  if (target_ids.empty()) {
+    by_target_.erase(found);
+  }
+}
+
+DocumentKeySet TargetKeyIndex::RemoveTarget(TargetId target_id) {
+  auto found = by_target_.find(target_id);
+  if (found == by_target_.end()) return DocumentKeySet{};
+
+  CompressedBitmap target_ids = std::move(found->second);
+  by_target_.erase(found);
+
+  DocumentKeySet result = KeysWithIds(target_ids);
+  target_ids.ForEach([this](uint32_t id) { Release(id); });
+  return result;
+}
+
+DocumentKeySet TargetKeyIndex::MatchingKeys(TargetId target_id) const {
+  auto found = by_target_.find(target_id);
+  if (found == by_target_.end()) return DocumentKeySet{};
+
+  return KeysWithIds(found->second);
+}
+
+bool TargetKeyIndex::ContainsKey(const DocumentKey& key) const {
+  return ids_.find(key) != ids_.end();
+}
+
+uint32_t TargetKeyIndex::Intern(const DocumentKey& key) {
+  auto found = ids_.find(key);
+  if (found != ids_.end()) return found->second;
+
+  uint32_t id;
+  if (free_ids_.empty()) {
+    id = static_cast<uint32_t>(entries_.size());
+    entries_.emplace_back();
+  } else {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+  }
+  entries_[id].key = key;
+  ids_.emplace(key, id);
+  return id;
+}
+
+void TargetKeyIndex::Release(uint32_t id) {
+  Entry& entry = entries_[id];
+  HARD_ASSERT(entry.target_count > 0, "No count for key %s",
+              entry.key.ToString());
+
+  if (--entry.target_count == 0) {
+    ids_.erase(entry.key);
+    entry.key = DocumentKey{};
+    free_ids_.push_back(id);
+  }
+}
+
+DocumentKeySet TargetKeyIndex::KeysWithIds(const CompressedBitmap& ids) const {
+  // IDs are assigned in the order keys are first seen, not in key order.
+  std::vector<DocumentKey> keys;
+  keys.reserve(ids.size());
+  ids.ForEach([&](uint32_t id) { keys.push_back(entries_[id].key); });
+  std::sort(keys.begin(), keys.end());
+  return DocumentKeySet::FromSortedRange(keys);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_TARGET_KEY_INDEX_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_TARGET_KEY_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/compressed_bitmap.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * A mutable mapping between remote target IDs and the document keys that
+ * match them, used by the memory query cache.
+ *
+ * Every key that matches a target is interned to a dense 32-bit ID, and the
+ * keys of each target are kept as a CompressedBitmap of those IDs, found by
+ * hashing the target ID. With many targets over the same documents, each key
+ * is stored once instead of once per target, and membership costs a couple of
+ * bytes per key and target. Every key also has a count of the targets that
+ * match it, so that orphaned keys are found without visiting the targets.
+ */
+class TargetKeyIndex {
+ public:
+  /** Returns true if no target has any matching keys. */
+  bool empty() const {
+    return ids_.empty();
+  }
+
+  /** Adds the given keys to those matching the given target. */
+  void AddKeys(const model::DocumentKeySet& keys, model::TargetId target_id);
+
+  /** Removes the given keys from those matching the given target. */
+  void RemoveKeys(const model::DocumentKeySet& keys,
+                  model::TargetId target_id);
+
+  /**
+   * Removes all keys matching the given target and returns the keys that were
+   * removed.
+   */
+  model::DocumentKeySet RemoveTarget(model::TargetId target_id);
+
+  /** Returns the keys matching the given target. */
+  model::DocumentKeySet MatchingKeys(model::TargetId target_id) const;
+
+  /** Returns true if the given key matches any target. */
+  bool ContainsKey(const model::DocumentKey& key) const;
+
+ private:
+  struct Entry {
+    model::DocumentKey key;
+    size_t target_count = 0;
+  };
+
+  /** Returns the ID of the given key, assigning one if it has none. */
+  uint32_t Intern(const model::DocumentKey& key);
+
+  /**
+   * Decrements the target count of the key with the given ID, and frees the
+   * ID for reuse once no target matches the key.
+   */
+  void Release(uint32_t id);
+
+  /** Returns the keys with the given IDs, in key order. */
+  model::DocumentKeySet KeysWithIds(const util::CompressedBitmap& ids) const;
+
+  std::unordered_map<model::TargetId, util::CompressedBitmap> by_target_;
+  std::unordered_map<model::DocumentKey, uint32_t, model::DocumentKeyHash>
+      ids_;
+  // Indexed by ID; the entries of freed IDs have an empty key.
+  std::vector<Entry> entries_;
+  std::vector<uint32_t> free_ids_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_TARGET_KEY_INDEX_H_
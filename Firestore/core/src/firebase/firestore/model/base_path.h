@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <cctype>
 #include <initializer_list>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -27,6 +28,7 @@
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "absl/hash/hash.h"
 
 namespace firebase {
 namespace firestore {
@@ -40,6 +42,11 @@ namespace impl {
  * BasePath is reassignable and movable. Apart from those, all other mutating
  * operations return new independent instances.
  *
+ * The segments are kept in immutable storage that copies of a path share, and
+ * a path is a view of a range of that storage. This makes copying a path and
+ * deriving a parent or a suffix from it (as PopFirst and PopLast do) cheap and
+ * free of allocations. Appending segments creates new storage.
+ *
  * ## Subclassing Notes
  *
  * BasePath is strictly meant as a base class for concrete implementations. It
@@ -58,33 +65,33 @@ class BasePath {
 
   /** Returns i-th segment of the path. */
   const std::string& operator[](const size_t i) const {
-    HARD_ASSERT(i < segments_.size(), "index %s out of range", i);
-    return segments_[i];
+    HARD_ASSERT(i < size(), "index %s out of range", i);
+    return (*segments_)[begin_ + i];
   }
 
   /** Returns the first segment of the path. */
   const std::string& first_segment() const {
     HARD_ASSERT(!empty(), "Cannot call first_segment on empty path");
-    return segments_[0];
+    return (*segments_)[begin_];
   }
   /** Returns the last segment of the path. */
   const std::string& last_segment() const {
     HARD_ASSERT(!empty(), "Cannot call last_segment on empty path");
-    return segments_[size() - 1];
+    return (*segments_)[end_ - 1];
   }
 
   size_t size() const {
-    return segments_.size();
+    return end_ - begin_;
   }
   bool empty() const {
-    return segments_.empty();
+    return begin_ == end_;
   }
 
   const_iterator begin() const {
-    return segments_.begin();
+    return storage().begin() + begin_;
   }
   const_iterator end() const {
-    return segments_.end();
+    return storage().begin() + end_;
   }
 
   /**
@@ -92,12 +99,12 @@ class BasePath {
    * additional segment.
    */
   T Append(const std::string& segment) const {
-    auto appended = segments_;
+    SegmentsT appended = CopySegments(1);
     appended.push_back(segment);
     return T{std::move(appended)};
   }
   T Append(std::string&& segment) const {
-    auto appended = segments_;
+    SegmentsT appended = CopySegments(1);
     appended.push_back(std::move(segment));
     return T{std::move(appended)};
   }
@@ -107,7 +114,7 @@ class BasePath {
    * another path.
    */
   T Append(const T& path) const {
-    auto appended = segments_;
+    SegmentsT appended = CopySegments(path.size());
     appended.insert(appended.end(), path.begin(), path.end());
     return T{std::move(appended)};
   }
@@ -119,7 +126,7 @@ class BasePath {
   T PopFirst(const size_t n = 1) const {
     HARD_ASSERT(n <= size(), "Cannot call PopFirst(%s) on path of length %s", n,
                 size());
-    return T{begin() + n, end()};
+    return Slice(begin_ + n, end_);
   }
 
   /**
@@ -128,7 +135,7 @@ class BasePath {
    */
   T PopLast() const {
     HARD_ASSERT(!empty(), "Cannot call PopLast() on empty path");
-    return T{begin(), end() - 1};
+    return Slice(begin_, end_ - 1);
   }
 
   /**
@@ -151,25 +158,91 @@ class BasePath {
   }
 
   util::ComparisonResult CompareTo(const T& rhs) const {
-    return util::Compare(segments_, rhs.segments_);
+    if (segments_ == rhs.segments_ && begin_ == rhs.begin_ &&
+        end_ == rhs.end_) {
+      return util::ComparisonResult::Same;
+    }
+    return util::CompareContainer<BasePath>(*this, rhs);
   }
 
   size_t Hash() const {
-    return util::Hash(segments_);
+    return absl::Hash<BasePath>{}(*this);
+  }
+
+  /** Hashes the segments the same way as absl hashes a vector of them. */
+  template <typename H>
+  friend H AbslHashValue(H state, const BasePath& path) {
+    const std::string* data = path.storage().data() + path.begin_;
+    return H::combine(
+        H::combine_contiguous(std::move(state), data, path.size()),
+        path.size());
   }
 
  protected:
   BasePath() = default;
   template <typename IterT>
-  BasePath(const IterT begin, const IterT end) : segments_{begin, end} {
+  BasePath(const IterT begin, const IterT end)
+      : BasePath{SegmentsT{begin, end}} {
+  }
+  BasePath(std::initializer_list<std::string> list)
+      : BasePath{SegmentsT{list}} {
   }
-  BasePath(std::initializer_list<std::string> list) : segments_{list} {
+  explicit BasePath(SegmentsT&& segments) : end_{segments.size()} {
+    if (!segments.empty()) {
+      segments_ = std::make_shared<const SegmentsT>(std::move(segments));
+    }
+  }
+
+  BasePath(const BasePath& other) = default;
+  BasePath& operator=(const BasePath& other) = default;
+
+  // Leaves the moved-from path empty.
+  BasePath(BasePath&& other) noexcept
+      : segments_{std::move(other.segments_)},
+        begin_{other.begin_},
+        end_{other.end_} {
+    other.begin_ = 0;
+    other.end_ = 0;
   }
-  explicit BasePath(SegmentsT&& segments) : segments_{std::move(segments)} {
+  BasePath& operator=(BasePath&& other) noexcept {
+    segments_ = std::move(other.segments_);
+    begin_ = other.begin_;
+    end_ = other.end_;
+    other.begin_ = 0;
+    other.end_ = 0;
+    return *this;
   }
 
  private:
-  SegmentsT segments_;
+  /** The storage of the segments; empty storage if the path is empty. */
+  const SegmentsT& storage() const {
+    // Never destroyed, so that paths can be used during static destruction.
+    static const SegmentsT* empty_segments = new SegmentsT();
+    return segments_ ? *segments_ : *empty_segments;
+  }
+
+  /** Copies the segments of this path, leaving room for `extra` more. */
+  SegmentsT CopySegments(size_t extra) const {
+    SegmentsT result;
+    result.reserve(size() + extra);
+    result.assign(begin(), end());
+    return result;
+  }
+
+  /** Returns a path that shares this path's storage. */
+  T Slice(size_t begin, size_t end) const {
+    T result = static_cast<const T&>(*this);
+    result.begin_ = begin;
+    result.end_ = end;
+    if (begin == end) {
+      result.segments_.reset();
+    }
+    return result;
+  }
+
+  std::shared_ptr<const SegmentsT> segments_;
+  size_t begin_ = 0;
+  size_t end_ = 0;
 };
 
 }  // namespace impl
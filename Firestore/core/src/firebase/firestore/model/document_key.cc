@@ -19,6 +19,7 @@
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 
 namespace firebase {
 namespace firestore {
@@ -33,14 +34,27 @@ void AssertValidPath(const ResourcePath& path) {
 
 }  // namespace
 
+DocumentKey::Rep::Rep(ResourcePath&& resource_path)
+    : path{std::move(resource_path)} {
+  // Each segment takes at least its bytes and a two byte terminator.
+  size_t size = 0;
+  for (const std::string& segment : path) {
+    size += segment.size() + 2;
+  }
+  ordered.reserve(size);
+  for (const std::string& segment : path) {
+    util::OrderedCode::WriteString(&ordered, segment);
+  }
+}
+
 DocumentKey::DocumentKey(const ResourcePath& path)
-    : path_{std::make_shared<ResourcePath>(path)} {
-  AssertValidPath(*path_);
+    : DocumentKey{ResourcePath{path}} {
 }
 
 DocumentKey::DocumentKey(ResourcePath&& path)
-    : path_{std::make_shared<ResourcePath>(std::move(path))} {
-  AssertValidPath(*path_);
+    : rep_{std::make_shared<const Rep>(std::move(path))},
+      hash_{rep_->path.Hash()} {
+  AssertValidPath(rep_->path);
 }
 
 const DocumentKey& DocumentKey::Empty() {
@@ -49,7 +63,10 @@ const DocumentKey& DocumentKey::Empty() {
 }
 
 util::ComparisonResult DocumentKey::CompareTo(const DocumentKey& other) const {
-  return path().CompareTo(other.path());
+  if (rep_ == other.rep_) {
+    return util::ComparisonResult::Same;
+  }
+  return util::Compare(ordered(), other.ordered());
 }
 
 }  // namespace model
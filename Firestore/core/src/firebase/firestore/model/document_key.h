@@ -21,6 +21,7 @@
 #include <initializer_list>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
@@ -37,7 +38,9 @@ namespace model {
 class DocumentKey : public util::Comparable<DocumentKey> {
  public:
   /** Creates a "blank" document key not associated with any document. */
-  DocumentKey() : path_{std::make_shared<ResourcePath>()} {
+  DocumentKey()
+      : rep_{std::make_shared<const Rep>(ResourcePath{})},
+        hash_{rep_->path.Hash()} {
   }
 
   /** Creates a new document key containing a copy of the given path. */
@@ -67,10 +70,23 @@ class DocumentKey : public util::Comparable<DocumentKey> {
     return path.size() % 2 == 0;
   }
 
+  /**
+   * Orders keys by their paths, segment by segment, by comparing their
+   * encodings with a single `memcmp`.
+   */
   util::ComparisonResult CompareTo(const DocumentKey& other) const;
 
+  /**
+   * Returns the hash of the path, which is computed once when the key is
+   * created, so that keys are cheap to look up in hash containers.
+   */
   size_t Hash() const {
-    return util::Hash(ToString());
+    return rep_ ? hash_ : Empty().hash_;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H state, const DocumentKey& key) {
+    return H::combine(std::move(state), key.Hash());
   }
 
   std::string ToString() const {
@@ -79,7 +95,7 @@ class DocumentKey : public util::Comparable<DocumentKey> {
 
   /** The path to the document. */
   const ResourcePath& path() const {
-    return path_ ? *path_ : Empty().path();
+    return rep_ ? rep_->path : Empty().path();
   }
 
   /** Returns true if the document is in the specified collectionId. */
@@ -89,14 +105,33 @@ class DocumentKey : public util::Comparable<DocumentKey> {
   }
 
  private:
+  struct Rep {
+    explicit Rep(ResourcePath&& path);
+
+    ResourcePath path;
+
+    /**
+     * The segments of the path, each written with `OrderedCode::WriteString`,
+     * whose bytes compare the way the paths do: the encoded segments compare
+     * as the segments do, and a segment that's a prefix of another ends with
+     * a terminator that sorts before any byte the other one continues with.
+     */
+    std::string ordered;
+  };
+
+  const std::string& ordered() const {
+    return rep_ ? rep_->ordered : Empty().rep_->ordered;
+  }
+
   // This is an optimization to make passing DocumentKey around cheaper (it's
   // copied often).
-  std::shared_ptr<const ResourcePath> path_;
+  std::shared_ptr<const Rep> rep_;
+  size_t hash_ = 0;
 };
 
 struct DocumentKeyHash {
   size_t operator()(const DocumentKey& key) const {
-    return util::Hash(key.path());
+    return key.Hash();
   }
 };
 
@@ -19,9 +19,11 @@
 
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/immutable/pool_allocator.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/objc/objc_class.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "absl/base/attributes.h"
 
 OBJC_CLASS(FSTDocument);
@@ -34,8 +36,15 @@ namespace model {
 /**
  * Convenience type for a map of keys to MaybeDocuments, since they are so
  * common.
+ *
+ * These maps are rebuilt constantly while computing views, so their nodes are
+ * recycled through a PoolAllocator.
  */
-using MaybeDocumentMap = immutable::SortedMap<DocumentKey, FSTMaybeDocument*>;
+using MaybeDocumentMap = immutable::SortedMap<
+    DocumentKey,
+    FSTMaybeDocument*,
+    util::Comparator<DocumentKey>,
+    immutable::PoolAllocator<std::pair<DocumentKey, FSTMaybeDocument*>>>;
 
 /**
  * Convenience type for a map of keys to Documents, since they are so common.
@@ -63,6 +72,12 @@ class DocumentMap {
 
   ABSL_MUST_USE_RESULT DocumentMap erase(const DocumentKey& key) const;
 
+  /** Inserts in place. See `SortedMap::InsertInPlace`. */
+  void InsertInPlace(const DocumentKey& key, FSTDocument* value);
+
+  /** Erases in place. See `SortedMap::EraseInPlace`. */
+  void EraseInPlace(const DocumentKey& key);
+
   bool empty() const {
     return map_.empty();
   }
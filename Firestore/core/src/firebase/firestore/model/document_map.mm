@@ -34,6 +34,14 @@ DocumentMap::erase(const DocumentKey& key) const {
   return DocumentMap{map_.erase(key)};
 }
 
+void DocumentMap::InsertInPlace(const DocumentKey& key, FSTDocument* value) {
+  map_.InsertInPlace(key, value);
+}
+
+void DocumentMap::EraseInPlace(const DocumentKey& key) {
+  map_.EraseInPlace(key);
+}
+
 FSTDocument* GetFSTDocumentOrNil(FSTMaybeDocument* maybeDoc) {
   if ([maybeDoc isKindOfClass:[FSTDocument class]]) {
     return static_cast<FSTDocument*>(maybeDoc);
@@ -120,6 +120,9 @@ class DocumentSet : public immutable::SortedContainer {
    */
   DocumentSet erase(const DocumentKey& key) const;
 
+  /** A transient editing session for applying many changes at once. */
+  class Editor;
+
   friend bool operator==(const DocumentSet& lhs, const DocumentSet& rhs);
 
   std::string ToString() const;
@@ -152,6 +155,45 @@ inline bool operator!=(const DocumentSet& lhs, const DocumentSet& rhs) {
   return !(lhs == rhs);
 }
 
+/**
+ * A transient editing session over a DocumentSet, for applying a batch of
+ * changes at once.
+ *
+ * Each call to `DocumentSet::insert` or `erase` copies the path to the
+ * affected document in both of the set's trees. An Editor instead modifies
+ * in place the nodes it has already copied, so a batch of changes copies
+ * each node at most once. Nodes still shared with other DocumentSets are
+ * copied before they're modified, so the set the Editor started from is never
+ * affected.
+ */
+class DocumentSet::Editor {
+ public:
+  explicit Editor(DocumentSet set) : set_{std::move(set)} {
+  }
+
+  /** The set with all changes made so far. */
+  const DocumentSet& set() const {
+    return set_;
+  }
+
+  /** Adds the given document, replacing any with the same key. */
+  void insert(FSTDocument* _Nullable document);
+
+  /** Removes any document associated with the given key. */
+  void erase(const DocumentKey& key);
+
+  /**
+   * Returns the edited set. The Editor can continue to be used afterwards
+   * without affecting the returned set.
+   */
+  DocumentSet Build() const {
+    return set_;
+  }
+
+ private:
+  DocumentSet set_;
+};
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
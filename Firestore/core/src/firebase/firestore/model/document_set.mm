@@ -119,6 +119,28 @@ DocumentSet DocumentSet::erase(const DocumentKey& key) const {
   return {std::move(index), std::move(set)};
 }
 
+void DocumentSet::Editor::insert(FSTDocument* _Nullable document) {
+  if (!document) {
+    return;
+  }
+
+  // As in DocumentSet::insert, remove any prior mapping of the key first.
+  erase(document.key);
+
+  set_.index_.InsertInPlace(document.key, document);
+  set_.sorted_set_.InsertInPlace(document);
+}
+
+void DocumentSet::Editor::erase(const DocumentKey& key) {
+  FSTDocument* doc = set_.GetDocument(key);
+  if (!doc) {
+    return;
+  }
+
+  set_.index_.EraseInPlace(key);
+  set_.sorted_set_.EraseInPlace(doc);
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -32,7 +32,7 @@ namespace model {
 /**
  * A dot-separated path for navigating sub-objects within a document.
  *
- * Immutable; all instances are fully independent.
+ * Immutable; copies and parents of a path share the storage of its segments.
  */
 class FieldPath : public impl::BasePath<FieldPath>,
                   public util::Comparable<FieldPath> {
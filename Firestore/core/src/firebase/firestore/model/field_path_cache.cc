@@ -0,0 +1,85 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/field_path_cache.h"
+
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+namespace {
+
+/**
+ * An estimate of the bytes each cached path costs beyond its key: the
+ * bookkeeping of the underlying cache and the FieldPath itself.
+ */
+constexpr size_t kEntryOverhead = 96;
+
+/** An estimate of the bytes each segment of a cached path costs. */
+constexpr size_t kSegmentOverhead = 32;
+
+}  // namespace
+
+constexpr size_t FieldPathCache::kMaxLength;
+constexpr size_t FieldPathCache::kDefaultMaxBytes;
+
+FieldPathCache::FieldPathCache(size_t max_bytes) : paths_{max_bytes} {
+}
+
+FieldPathCache& FieldPathCache::Shared() {
+  static auto* shared = new FieldPathCache();
+  return *shared;
+}
+
+FieldPath FieldPathCache::FromDotSeparatedString(absl::string_view path) {
+  if (path.size() > kMaxLength) {
+    return FieldPath::FromDotSeparatedString(path);
+  }
+
+  std::string key{path};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (const FieldPath* found = paths_.Get(key)) {
+      return *found;
+    }
+  }
+
+  // Parse without holding the lock; invalid paths throw from here.
+  FieldPath result = FieldPath::FromDotSeparatedString(path);
+
+  // Each segment is a copy of part of the key.
+  size_t cost = 2 * key.size() + result.size() * kSegmentOverhead +
+                kEntryOverhead;
+  std::lock_guard<std::mutex> lock{mutex_};
+  paths_.Put(std::move(key), result, cost);
+  return result;
+}
+
+size_t FieldPathCache::size() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return paths_.size();
+}
+
+void FieldPathCache::Clear() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  paths_.Clear();
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
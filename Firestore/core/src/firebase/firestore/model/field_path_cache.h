@@ -0,0 +1,79 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_PATH_CACHE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_PATH_CACHE_H_
+
+#include <cstddef>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/util/lru_cache.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/**
+ * A bounded cache of the FieldPaths parsed from the dot-separated strings
+ * passed to the API, so that reading or querying the same fields over and
+ * over (say, from every snapshot a list view shows) doesn't split and validate
+ * the same strings again each time.
+ *
+ * Paths longer than kMaxLength are never cached, since they're unlikely to
+ * recur and would quickly evict the paths that do. The least recently used
+ * paths are evicted once the cache is over its size limit. Invalid paths
+ * aren't cached, so they're rejected every time.
+ *
+ * FieldPathCache is thread-safe.
+ */
+class FieldPathCache {
+ public:
+  /** The longest path string that will be cached. */
+  static constexpr size_t kMaxLength = 128;
+
+  /** The default limit on the approximate number of bytes the cache retains. */
+  static constexpr size_t kDefaultMaxBytes = 64 * 1024;
+
+  explicit FieldPathCache(size_t max_bytes = kDefaultMaxBytes);
+
+  /** Returns the cache shared by the whole API layer. */
+  static FieldPathCache& Shared();
+
+  /**
+   * Returns the same FieldPath as `FieldPath::FromDotSeparatedString`, parsing
+   * `path` only if it isn't in the cache.
+   */
+  FieldPath FromDotSeparatedString(absl::string_view path);
+
+  /** The number of paths currently in the cache. */
+  size_t size() const;
+
+  /** Empties the cache. */
+  void Clear();
+
+ private:
+  mutable std::mutex mutex_;
+  util::LruCache<std::string, FieldPath> paths_;
+};
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_PATH_CACHE_H_
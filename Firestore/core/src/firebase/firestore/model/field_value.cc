@@ -17,6 +17,7 @@
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <iostream>
 #include <memory>
@@ -58,37 +59,6 @@ const T& Cast(const BaseValue& rep) {
   return static_cast<const T&>(rep);
 }
 
-class NullValue : public FieldValue::BaseValue {
- public:
-  Type type() const override {
-    return Type::Null;
-  }
-
-  std::string ToString() const override {
-    return util::ToString(nullptr);
-  }
-
-  bool Equals(const BaseValue& other) const override {
-    if (type() != other.type()) return false;
-
-    // NullValue is the only instance of itself
-    return true;
-  }
-
-  ComparisonResult CompareTo(const BaseValue& other) const override {
-    ComparisonResult cmp = CompareTypes(other);
-    if (!util::Same(cmp)) return cmp;
-
-    // Null is only comparable with itself and is defined to be the same.
-    return ComparisonResult::Same;
-  }
-
-  size_t Hash() const override {
-    // std::hash is not defined for nullptr_t.
-    return util::Hash(static_cast<void*>(nullptr));
-  }
-};
-
 /**
  * A base class for implementing a "simple" field value type. Simple field
  * values:
@@ -138,76 +108,6 @@ class SimpleFieldValue : public FieldValue::BaseValue {
   ValueType value_;
 };
 
-class BooleanValue : public SimpleFieldValue<Type::Boolean, bool> {
- public:
-  using SimpleFieldValue::SimpleFieldValue;
-};
-
-template <Type type_enum, typename ValueType>
-class NumberValue : public SimpleFieldValue<type_enum, ValueType> {
- public:
-  using SimpleFieldValue<type_enum, ValueType>::SimpleFieldValue;
-
-  ComparisonResult CompareTo(const BaseValue& other) const override;
-};
-
-class IntegerValue : public NumberValue<Type::Integer, int64_t> {
- public:
-  using NumberValue<Type::Integer, int64_t>::NumberValue;
-};
-
-int64_t Integer(const BaseValue& rep) {
-  return Cast<IntegerValue>(rep).value();
-}
-
-class DoubleValue : public NumberValue<Type::Double, double> {
- public:
-  using NumberValue<Type::Double, double>::NumberValue;
-
-  bool Equals(const BaseValue& other) const override {
-    if (type() != other.type()) return false;
-
-    auto& other_value = Cast<DoubleValue>(other);
-    return util::DoubleBitwiseEquals(value(), other_value.value());
-  }
-
-  size_t Hash() const override {
-    return util::DoubleBitwiseHash(value());
-  }
-};
-
-double Double(const BaseValue& rep) {
-  return Cast<DoubleValue>(rep).value();
-}
-
-template <Type type_enum, typename ValueType>
-ComparisonResult NumberValue<type_enum, ValueType>::CompareTo(
-    const BaseValue& other) const {
-  ComparisonResult cmp = this->CompareTypes(other);
-  if (!util::Same(cmp)) return cmp;
-
-  Type this_type = this->type();
-  Type other_type = other.type();
-
-  if (this_type == other_type) {
-    if (this_type == Type::Integer) {
-      return Compare(Integer(*this), Integer(other));
-    } else {
-      return Compare(Double(*this), Double(other));
-    }
-
-  } else {
-    if (this_type == Type::Integer) {
-      // CompareMixedNumber only takes (double, int64_t) so reverse the argument
-      // order and then reverse the result.
-      return util::ReverseOrder(
-          util::CompareMixedNumber(Double(other), Integer(*this)));
-    } else {
-      return util::CompareMixedNumber(Double(*this), Integer(other));
-    }
-  }
-}
-
 // TODO(wilhuff): Use SimpleFieldValue as a base once we migrate to absl::Hash.
 //
 // This can't extend SimpleFieldValue because `util::Hash` is undefined for
@@ -426,6 +326,41 @@ class GeoPointValue : public BaseValue {
   GeoPoint value_;
 };
 
+/**
+ * Memoizes the hash of a container value, which would otherwise walk all of
+ * the container's nested values on every call. Containers are immutable, so
+ * racing threads can only ever compute and store the same value.
+ */
+class HashCache {
+ public:
+  template <typename F>
+  size_t Get(const F& compute) const {
+    size_t result = hash_.load(std::memory_order_relaxed);
+    if (result == kUnknown) {
+      result = compute();
+      // Remap the sentinel so that a computed hash is always remembered.
+      if (result == kUnknown) result = 1;
+      hash_.store(result, std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+  /**
+   * Returns true if the hashes of both values have been computed and they
+   * differ, which proves that the values are not equal.
+   */
+  bool KnownToDiffer(const HashCache& other) const {
+    size_t lhs = hash_.load(std::memory_order_relaxed);
+    size_t rhs = other.hash_.load(std::memory_order_relaxed);
+    return lhs != kUnknown && rhs != kUnknown && lhs != rhs;
+  }
+
+ private:
+  static constexpr size_t kUnknown = 0;
+
+  mutable std::atomic<size_t> hash_{kUnknown};
+};
+
 class ArrayContents : public FieldValue::BaseValue {
  public:
   explicit ArrayContents(FieldValue::Array value) : value_(std::move(value)) {
@@ -439,6 +374,7 @@ class ArrayContents : public FieldValue::BaseValue {
     if (type() != other.type()) return false;
 
     auto& other_value = Cast<ArrayContents>(other);
+    if (hash_.KnownToDiffer(other_value.hash_)) return false;
     return absl::c_equal(value_, other_value.value_);
   }
 
@@ -455,7 +391,7 @@ class ArrayContents : public FieldValue::BaseValue {
   }
 
   size_t Hash() const override {
-    return util::Hash(value_);
+    return hash_.Get([this] { return util::Hash(value_); });
   }
 
   const FieldValue::Array& value() const {
@@ -464,6 +400,7 @@ class ArrayContents : public FieldValue::BaseValue {
 
  private:
   FieldValue::Array value_;
+  HashCache hash_;
 };
 
 class MapContents : public FieldValue::BaseValue {
@@ -479,6 +416,7 @@ class MapContents : public FieldValue::BaseValue {
     if (type() != other.type()) return false;
 
     auto& other_value = Cast<MapContents>(other);
+    if (hash_.KnownToDiffer(other_value.hash_)) return false;
     return absl::c_equal(value_, other_value.value_);
   }
 
@@ -495,11 +433,13 @@ class MapContents : public FieldValue::BaseValue {
   }
 
   size_t Hash() const override {
-    size_t result = 0;
-    for (auto&& entry : value_) {
-      result = util::Hash(result, entry.first, entry.second);
-    }
-    return result;
+    return hash_.Get([this] {
+      size_t result = 0;
+      for (auto&& entry : value_) {
+        result = util::Hash(result, entry.first, entry.second);
+      }
+      return result;
+    });
   }
 
   const FieldValue::Map& value() const {
@@ -508,11 +448,13 @@ class MapContents : public FieldValue::BaseValue {
 
  private:
   FieldValue::Map value_;
+  HashCache hash_;
 };
 
 }  // namespace
 
-FieldValue::FieldValue() : FieldValue(std::make_shared<NullValue>()) {
+FieldValue::FieldValue(std::unique_ptr<BaseValue> rep) : type_{rep->type()} {
+  storage_.rep = rep.release();
 }
 
 bool FieldValue::Comparable(Type lhs, Type rhs) {
@@ -530,57 +472,57 @@ bool FieldValue::Comparable(Type lhs, Type rhs) {
 
 bool FieldValue::boolean_value() const {
   HARD_ASSERT(type() == Type::Boolean);
-  return Cast<BooleanValue>(*rep_).value();
+  return storage_.boolean_value;
 }
 
 int64_t FieldValue::integer_value() const {
   HARD_ASSERT(type() == Type::Integer);
-  return Cast<IntegerValue>(*rep_).value();
+  return storage_.integer_value;
 }
 
 double FieldValue::double_value() const {
   HARD_ASSERT(type() == Type::Double);
-  return Cast<DoubleValue>(*rep_).value();
+  return storage_.double_value;
 }
 
 Timestamp FieldValue::timestamp_value() const {
   HARD_ASSERT(type() == Type::Timestamp);
-  return Cast<TimestampValue>(*rep_).value();
+  return Cast<TimestampValue>(rep()).value();
 }
 
 const ServerTimestamp& FieldValue::server_timestamp_value() const {
   HARD_ASSERT(type() == Type::ServerTimestamp);
-  return Cast<ServerTimestampValue>(*rep_).value();
+  return Cast<ServerTimestampValue>(rep()).value();
 }
 
 const std::string& FieldValue::string_value() const {
   HARD_ASSERT(type() == Type::String);
-  return Cast<StringValue>(*rep_).value();
+  return Cast<StringValue>(rep()).value();
 }
 
 const ByteString& FieldValue::blob_value() const {
   HARD_ASSERT(type() == Type::Blob);
-  return Cast<BlobValue>(*rep_).value();
+  return Cast<BlobValue>(rep()).value();
 }
 
 const Reference& FieldValue::reference_value() const {
   HARD_ASSERT(type() == Type::Reference);
-  return Cast<ReferenceValue>(*rep_).value();
+  return Cast<ReferenceValue>(rep()).value();
 }
 
 const GeoPoint& FieldValue::geo_point_value() const {
   HARD_ASSERT(type() == Type::GeoPoint);
-  return Cast<GeoPointValue>(*rep_).value();
+  return Cast<GeoPointValue>(rep()).value();
 }
 
 const FieldValue::Array& FieldValue::array_value() const {
   HARD_ASSERT(type() == Type::Array);
-  return Cast<ArrayContents>(*rep_).value();
+  return Cast<ArrayContents>(rep()).value();
 }
 
 const FieldValue::Map& FieldValue::object_value() const {
   HARD_ASSERT(type() == Type::Object);
-  return Cast<MapContents>(*rep_).value();
+  return Cast<MapContents>(rep()).value();
 }
 
 // TODO(rsgowman): Reorder this file to match its header.
@@ -631,6 +573,93 @@ ObjectValue ObjectValue::Delete(const FieldPath& field_path) const {
   }
 }
 
+namespace {
+
+/**
+ * Applies the field paths in [begin, end) to `target`, as ObjectValue::Patch
+ * does. The paths all share their first `depth` segments, and `target` and
+ * `values` are the objects at that prefix. `values` is null if there is no
+ * object there.
+ *
+ * Sets `*set_any` if any field was set, rather than only deleted.
+ */
+FieldValue::Map PatchMap(FieldValue::Map target,
+                         const FieldValue::Map* values,
+                         FieldMask::const_iterator begin,
+                         FieldMask::const_iterator end,
+                         size_t depth,
+                         bool* set_any) {
+  // Paths are sorted segment by segment, so the paths into one field of
+  // `target` are adjacent, with the path to the field itself first.
+  while (begin != end) {
+    const std::string& name = (*begin)[depth];
+    auto group_end = begin;
+    while (group_end != end && (*group_end)[depth] == name) {
+      ++group_end;
+    }
+
+    const FieldValue* value = nullptr;
+    if (values) {
+      auto found = values->find(name);
+      if (found != values->end()) {
+        value = &found->second;
+      }
+    }
+
+    if (begin->size() == depth + 1) {
+      // The whole field is replaced, which leaves nothing for the paths nested
+      // in it to change.
+      if (value) {
+        target = target.insert(name, *value);
+        *set_any = true;
+      } else {
+        target = target.erase(name);
+      }
+
+    } else {
+      auto existing = target.find(name);
+      bool is_object = existing != target.end() &&
+                       existing->second.type() == Type::Object;
+      const FieldValue::Map* child_values =
+          value && value->type() == Type::Object
+              ? &value->object_value()
+              : nullptr;
+
+      bool child_set_any = false;
+      FieldValue::Map child =
+          PatchMap(is_object ? existing->second.object_value()
+                             : FieldValue::Map{},
+                   child_values, begin, group_end, depth + 1, &child_set_any);
+
+      // Like Delete, only deleting leaves a field that isn't an object as it
+      // is, whereas setting a nested field replaces it with an object.
+      if (is_object || child_set_any) {
+        target = target.insert(name, FieldValue::FromMap(std::move(child)));
+      }
+      *set_any = *set_any || child_set_any;
+    }
+
+    begin = group_end;
+  }
+  return target;
+}
+
+}  // namespace
+
+ObjectValue ObjectValue::Patch(const FieldMask& field_mask,
+                               const ObjectValue& values) const {
+  // Empty paths sort first and don't name a field.
+  auto begin = field_mask.begin();
+  while (begin != field_mask.end() && begin->empty()) {
+    ++begin;
+  }
+
+  bool set_any = false;
+  return ObjectValue::FromMap(PatchMap(fv_.object_value(),
+                                       &values.fv_.object_value(), begin,
+                                       field_mask.end(), 0, &set_any));
+}
+
 absl::optional<FieldValue> ObjectValue::Get(const FieldPath& field_path) const {
   const FieldValue* current = &this->fv_;
   for (const auto& path : field_path) {
@@ -687,15 +716,18 @@ FieldValue FieldValue::Null() {
 }
 
 FieldValue FieldValue::True() {
-  return FieldValue(std::make_shared<BooleanValue>(true));
+  return FromBoolean(true);
 }
 
 FieldValue FieldValue::False() {
-  return FieldValue(std::make_shared<BooleanValue>(false));
+  return FromBoolean(false);
 }
 
 FieldValue FieldValue::FromBoolean(bool value) {
-  return value ? True() : False();
+  FieldValue result;
+  result.type_ = Type::Boolean;
+  result.storage_.boolean_value = value;
+  return result;
 }
 
 FieldValue FieldValue::Nan() {
@@ -707,7 +739,10 @@ FieldValue FieldValue::EmptyObject() {
 }
 
 FieldValue FieldValue::FromInteger(int64_t value) {
-  return FieldValue(std::make_shared<IntegerValue>(value));
+  FieldValue result;
+  result.type_ = Type::Integer;
+  result.storage_.integer_value = value;
+  return result;
 }
 
 // We use a canonical NaN bit pattern that's common for both Objective-C and
@@ -729,63 +764,186 @@ FieldValue FieldValue::FromDouble(double value) {
     value = canonical_nan;
   }
 
-  return FieldValue(std::make_shared<DoubleValue>(value));
+  FieldValue result;
+  result.type_ = Type::Double;
+  result.storage_.double_value = value;
+  return result;
 }
 
 FieldValue FieldValue::FromTimestamp(const Timestamp& value) {
-  return FieldValue(std::make_shared<TimestampValue>(value));
+  return FieldValue(absl::make_unique<TimestampValue>(value));
 }
 
 FieldValue FieldValue::FromServerTimestamp(
     const Timestamp& local_write_time,
     absl::optional<FieldValue> previous_value) {
-  return FieldValue(std::make_shared<ServerTimestampValue>(
+  return FieldValue(absl::make_unique<ServerTimestampValue>(
       ServerTimestamp(local_write_time, std::move(previous_value))));
 }
 
 FieldValue FieldValue::FromString(const char* value) {
-  return FieldValue(std::make_shared<StringValue>(value));
+  return FieldValue(absl::make_unique<StringValue>(value));
 }
 
 FieldValue FieldValue::FromString(const std::string& value) {
-  return FieldValue(std::make_shared<StringValue>(value));
+  return FieldValue(absl::make_unique<StringValue>(value));
 }
 
 FieldValue FieldValue::FromString(std::string&& value) {
-  return FieldValue(std::make_shared<StringValue>(std::move(value)));
+  return FieldValue(absl::make_unique<StringValue>(std::move(value)));
 }
 
 FieldValue FieldValue::FromBlob(ByteString blob) {
-  return FieldValue(std::make_shared<BlobValue>(std::move(blob)));
+  return FieldValue(absl::make_unique<BlobValue>(std::move(blob)));
 }
 
 FieldValue FieldValue::FromReference(DatabaseId database_id, DocumentKey key) {
-  return FieldValue(std::make_shared<ReferenceValue>(
+  return FieldValue(absl::make_unique<ReferenceValue>(
       Reference(std::move(database_id), std::move(key))));
 }
 
 FieldValue FieldValue::FromGeoPoint(const GeoPoint& value) {
-  return FieldValue(std::make_shared<GeoPointValue>(value));
+  return FieldValue(absl::make_unique<GeoPointValue>(value));
 }
 
 FieldValue FieldValue::FromArray(const Array& value) {
-  return FieldValue(std::make_shared<ArrayContents>(value));
+  return FieldValue(absl::make_unique<ArrayContents>(value));
 }
 
 FieldValue FieldValue::FromArray(Array&& value) {
-  return FieldValue(std::make_shared<ArrayContents>(std::move(value)));
+  return FieldValue(absl::make_unique<ArrayContents>(std::move(value)));
 }
 
 FieldValue FieldValue::FromMap(const Map& value) {
-  return FieldValue(std::make_shared<MapContents>(value));
+  return FieldValue(absl::make_unique<MapContents>(value));
 }
 
 FieldValue FieldValue::FromMap(FieldValue::Map&& value) {
-  return FieldValue(std::make_shared<MapContents>(std::move(value)));
+  return FieldValue(absl::make_unique<MapContents>(std::move(value)));
+}
+
+size_t FieldValue::Hash() const {
+  switch (type_) {
+    case Type::Null:
+      // std::hash is not defined for nullptr_t.
+      return util::Hash(static_cast<void*>(nullptr));
+    case Type::Boolean:
+      return util::Hash(storage_.boolean_value);
+    case Type::Integer:
+      return util::Hash(storage_.integer_value);
+    case Type::Double:
+      return util::DoubleBitwiseHash(storage_.double_value);
+    case Type::String:
+      return util::Hash(Cast<StringValue>(rep()).value());
+    default:
+      return rep().Hash();
+  }
+}
+
+ComparisonResult FieldValue::CompareTo(const FieldValue& rhs) const {
+  Type this_type = type();
+  Type other_type = rhs.type();
+
+  // Values of types that aren't comparable are ordered by their types. Inline
+  // values are only comparable with other inline values.
+  if (!Comparable(this_type, other_type)) {
+    return Compare(this_type, other_type);
+  }
+
+  // Values interned or copied from one another share their contents.
+  if (!IsInline(this_type) && storage_.rep == rhs.storage_.rep) {
+    return ComparisonResult::Same;
+  }
+
+  switch (this_type) {
+    case Type::Null:
+      // Null is only comparable with itself and is defined to be the same.
+      return ComparisonResult::Same;
+
+    case Type::Boolean:
+      return Compare(storage_.boolean_value, rhs.storage_.boolean_value);
+
+    case Type::Integer:
+      if (other_type == Type::Integer) {
+        return Compare(storage_.integer_value, rhs.storage_.integer_value);
+      }
+      // CompareMixedNumber only takes (double, int64_t) so reverse the argument
+      // order and then reverse the result.
+      return util::ReverseOrder(util::CompareMixedNumber(
+          rhs.storage_.double_value, storage_.integer_value));
+
+    case Type::Double:
+      if (other_type == Type::Double) {
+        return Compare(storage_.double_value, rhs.storage_.double_value);
+      }
+      return util::CompareMixedNumber(storage_.double_value,
+                                      rhs.storage_.integer_value);
+
+    // The most common types outside of the inline ones are compared here
+    // directly instead of through `BaseValue::CompareTo`, which is virtual and
+    // checks the types again.
+    case Type::String:
+      return Compare(Cast<StringValue>(rep()).value(),
+                     Cast<StringValue>(rhs.rep()).value());
+
+    case Type::Timestamp:
+      if (other_type == Type::Timestamp) {
+        return Compare(Cast<TimestampValue>(rep()).value(),
+                       Cast<TimestampValue>(rhs.rep()).value());
+      }
+      // Server timestamps sort after all known timestamps.
+      return ComparisonResult::Ascending;
+
+    case Type::GeoPoint:
+      return Compare(Cast<GeoPointValue>(rep()).value(),
+                     Cast<GeoPointValue>(rhs.rep()).value());
+
+    default:
+      return rep().CompareTo(rhs.rep());
+  }
+}
+
+std::string FieldValue::ToString() const {
+  switch (type_) {
+    case Type::Null:
+      return util::ToString(nullptr);
+    case Type::Boolean:
+      return util::ToString(storage_.boolean_value);
+    case Type::Integer:
+      return util::ToString(storage_.integer_value);
+    case Type::Double:
+      return util::ToString(storage_.double_value);
+    default:
+      return rep().ToString();
+  }
 }
 
 bool operator==(const FieldValue& lhs, const FieldValue& rhs) {
-  return lhs.rep_->Equals(*rhs.rep_);
+  if (lhs.type() != rhs.type()) return false;
+  if (!FieldValue::IsInline(lhs.type()) &&
+      lhs.storage_.rep == rhs.storage_.rep) {
+    return true;
+  }
+
+  switch (lhs.type()) {
+    case Type::Null:
+      return true;
+    case Type::Boolean:
+      return lhs.storage_.boolean_value == rhs.storage_.boolean_value;
+    case Type::Integer:
+      return lhs.storage_.integer_value == rhs.storage_.integer_value;
+    case Type::Double:
+      return util::DoubleBitwiseEquals(lhs.storage_.double_value,
+                                       rhs.storage_.double_value);
+    case Type::String:
+      return Cast<StringValue>(lhs.rep()).value() ==
+             Cast<StringValue>(rhs.rep()).value();
+    case Type::Timestamp:
+      return Cast<TimestampValue>(lhs.rep()).value() ==
+             Cast<TimestampValue>(rhs.rep()).value();
+    default:
+      return lhs.rep().Equals(rhs.rep());
+  }
 }
 
 std::ostream& operator<<(std::ostream& os, const FieldValue& value) {
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_VALUE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_VALUE_H_
 
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <iosfwd>
@@ -48,6 +49,9 @@ class ObjectValue;
  * tagged-union class representing an immutable data value as stored in
  * Firestore. FieldValue represents all the different kinds of values
  * that can be stored in fields in a document.
+ *
+ * Nulls, booleans, integers and doubles are stored inline. All other values
+ * are stored in a reference counted BaseValue that's shared between copies.
  */
 class FieldValue {
  public:
@@ -80,13 +84,33 @@ class FieldValue {
     // position instead, see the doc comment above.
   };
 
-  FieldValue();
+  FieldValue() = default;
 
   FieldValue(ObjectValue object);  // NOLINT(runtime/explicit)
 
+  FieldValue(const FieldValue& other)
+      : type_{other.type_}, storage_(other.storage_) {
+    Retain();
+  }
+
+  FieldValue(FieldValue&& other) noexcept
+      : type_{other.type_}, storage_(other.storage_) {
+    other.type_ = Type::Null;
+  }
+
+  ~FieldValue() {
+    Release();
+  }
+
+  FieldValue& operator=(FieldValue other) noexcept {
+    std::swap(type_, other.type_);
+    std::swap(storage_, other.storage_);
+    return *this;
+  }
+
   /** Returns the true type for this value. */
   Type type() const {
-    return rep_->type();
+    return type_;
   }
 
   /**
@@ -161,14 +185,19 @@ class FieldValue {
   static FieldValue FromMap(const Map& value);
   static FieldValue FromMap(Map&& value);
 
-  size_t Hash() const {
-    return rep_->Hash();
-  }
+  size_t Hash() const;
 
-  util::ComparisonResult CompareTo(const FieldValue& rhs) const {
-    return rep_->CompareTo(*rhs.rep_);
+  /**
+   * Makes FieldValue usable in absl::Hash based containers. The hash of each
+   * kind of value is still defined by its representation's Hash().
+   */
+  template <typename H>
+  friend H AbslHashValue(H state, const FieldValue& value) {
+    return H::combine(std::move(state), value.Hash());
   }
 
+  util::ComparisonResult CompareTo(const FieldValue& rhs) const;
+
   /**
    * Checks if the two values are equal, returning false if the value is
    * perceptibly different in any regard.
@@ -190,9 +219,7 @@ class FieldValue {
    */
   friend bool operator==(const FieldValue& lhs, const FieldValue& rhs);
 
-  std::string ToString() const {
-    return rep_->ToString();
-  }
+  std::string ToString() const;
 
   friend std::ostream& operator<<(std::ostream& os, const FieldValue& value);
 
@@ -213,13 +240,53 @@ class FieldValue {
 
    protected:
     util::ComparisonResult CompareTypes(const BaseValue& other) const;
+
+   private:
+    friend class FieldValue;
+
+    // The number of FieldValues referring to this BaseValue.
+    mutable std::atomic<int32_t> ref_count_{1};
   };
 
  private:
-  explicit FieldValue(std::shared_ptr<BaseValue> rep) : rep_(std::move(rep)) {
+  explicit FieldValue(std::unique_ptr<BaseValue> rep);
+
+  /**
+   * Returns true if values of the given type are stored inline in the
+   * FieldValue rather than in a BaseValue.
+   */
+  static bool IsInline(Type type) {
+    return type == Type::Null || type == Type::Boolean ||
+           type == Type::Integer || type == Type::Double;
+  }
+
+  const BaseValue& rep() const {
+    return *storage_.rep;
+  }
+
+  void Retain() const {
+    if (!IsInline(type_)) {
+      storage_.rep->ref_count_.fetch_add(1, std::memory_order_relaxed);
+    }
   }
 
-  std::shared_ptr<BaseValue> rep_;
+  void Release() {
+    if (!IsInline(type_) &&
+        storage_.rep->ref_count_.fetch_sub(1, std::memory_order_acq_rel) ==
+            1) {
+      delete storage_.rep;
+    }
+  }
+
+  union Storage {
+    bool boolean_value;
+    int64_t integer_value;
+    double double_value;
+    BaseValue* rep;
+  };
+
+  Type type_ = Type::Null;
+  Storage storage_{};
 };
 
 /** A structured object value stored in Firestore. */
@@ -271,6 +338,17 @@ class ObjectValue : public util::Comparable<ObjectValue> {
    */
   ObjectValue Delete(const FieldPath& field_path) const;
 
+  /**
+   * Returns an ObjectValue with each field in `field_mask` set to its value in
+   * `values`, or deleted if `values` has no value for it.
+   *
+   * The result is the same as calling Set or Delete for each path of the mask
+   * in turn, but each nested object is rebuilt once, however many of its fields
+   * the mask covers.
+   */
+  ObjectValue Patch(const FieldMask& field_mask,
+                    const ObjectValue& values) const;
+
   /**
    * Returns a FieldMask built from all FieldPaths starting from this
    * ObjectValue, including paths from nested objects.
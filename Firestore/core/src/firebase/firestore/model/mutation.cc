@@ -158,17 +158,7 @@ ObjectValue PatchMutation::PatchDocument(const MaybeDocument* maybe_doc) const {
 }
 
 ObjectValue PatchMutation::PatchObject(ObjectValue obj) const {
-  for (const FieldPath& path : mask_) {
-    if (!path.empty()) {
-      absl::optional<FieldValue> new_value = value_.Get(path);
-      if (!new_value) {
-        obj = obj.Delete(path);
-      } else {
-        obj = obj.Set(path, *new_value);
-      }
-    }
-  }
-  return obj;
+  return obj.Patch(mask_, value_);
 }
 
 bool PatchMutation::equal_to(const Mutation& other) const {
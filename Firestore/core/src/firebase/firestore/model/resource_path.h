@@ -31,7 +31,8 @@ namespace model {
 
 /**
  * A slash-separated path for navigating resources (documents and collections)
- * within Firestore. Immutable; all instances are fully independent.
+ * within Firestore. Immutable; copies and parents of a path share the storage
+ * of its segments.
  */
 class ResourcePath : public impl::BasePath<ResourcePath>,
                      public util::Comparable<ResourcePath> {
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/string_interner.h"
+
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+namespace {
+
+/**
+ * An estimate of the bytes each pooled string costs beyond its contents: the
+ * key, the shared value, and the bookkeeping of the underlying cache.
+ */
+constexpr size_t kEntryOverhead = 96;
+
+}  // namespace
+
+constexpr size_t StringInterner::kMaxLength;
+constexpr size_t StringInterner::kDefaultMaxBytes;
+
+StringInterner::StringInterner(size_t max_bytes) : values_{max_bytes} {
+}
+
+StringInterner& StringInterner::Shared() {
+  static auto* shared = new StringInterner();
+  return *shared;
+}
+
+FieldValue StringInterner::Intern(absl::string_view value) {
+  if (value.size() > kMaxLength) {
+    return FieldValue::FromString(std::string{value});
+  }
+
+  std::string key{value};
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (const FieldValue* found = values_.Get(key)) {
+    return *found;
+  }
+
+  FieldValue result = FieldValue::FromString(key);
+  size_t cost = key.size() + kEntryOverhead;
+  values_.Put(std::move(key), result, cost);
+  return result;
+}
+
+size_t StringInterner::size() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return values_.size();
+}
+
+void StringInterner::Clear() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  values_.Clear();
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_STRING_INTERNER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_STRING_INTERNER_H_
+
+#include <cstddef>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/lru_cache.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/**
+ * A bounded pool of string FieldValues. Decoding the same short string through
+ * the pool yields FieldValues that share a single heap copy of the string, so
+ * values that recur across many documents (enum-like values, user IDs, and the
+ * like) are only stored once.
+ *
+ * Strings longer than kMaxLength are never pooled, since they're unlikely to
+ * recur and would quickly evict the strings that do. The least recently used
+ * strings are evicted once the pool is over its size limit.
+ *
+ * StringInterner is thread-safe.
+ */
+class StringInterner {
+ public:
+  /** The longest string that will be pooled. */
+  static constexpr size_t kMaxLength = 64;
+
+  /** The default limit on the approximate number of bytes the pool retains. */
+  static constexpr size_t kDefaultMaxBytes = 256 * 1024;
+
+  explicit StringInterner(size_t max_bytes = kDefaultMaxBytes);
+
+  /** Returns the pool shared by all serializers in the process. */
+  static StringInterner& Shared();
+
+  /**
+   * Returns a string FieldValue with the given contents, sharing its storage
+   * with any previously interned equal value that is still in the pool.
+   */
+  FieldValue Intern(absl::string_view value);
+
+  /** The number of strings currently in the pool. */
+  size_t size() const;
+
+  /**
+   * Empties the pool. Values already handed out remain valid, but are no
+   * longer shared with values interned later.
+   */
+  void Clear();
+
+ private:
+  mutable std::mutex mutex_;
+  util::LruCache<std::string, FieldValue> values_;
+};
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_STRING_INTERNER_H_
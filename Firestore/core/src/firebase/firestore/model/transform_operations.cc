@@ -16,18 +16,29 @@
 
 #include "Firestore/core/src/firebase/firestore/model/transform_operations.h"
 
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
-#include "absl/algorithm/container.h"
 
 namespace firebase {
 namespace firestore {
 namespace model {
 
+namespace {
+
+struct FieldValueHash {
+  size_t operator()(const FieldValue& value) const {
+    return value.Hash();
+  }
+};
+
+}  // namespace
+
 FieldValue ServerTimestampTransform::ApplyToLocalView(
     const absl::optional<FieldValue>& previous_value,
     const Timestamp& local_write_time) const {
@@ -117,20 +128,33 @@ FieldValue ArrayTransform::Apply(
     const absl::optional<FieldValue>& previous_value) const {
   FieldValue::Array result =
       ArrayTransform::CoercedFieldValuesArray(previous_value);
-  for (const FieldValue& element : elements_) {
-    auto pos = absl::c_find(result, element);
-    if (type_ == Type::ArrayUnion) {
-      if (pos == result.end()) {
+  if (type_ == Type::ArrayUnion) {
+    std::unordered_set<FieldValue, FieldValueHash> present(result.begin(),
+                                                           result.end());
+    for (const FieldValue& element : elements_) {
+      if (present.insert(element).second) {
         result.push_back(element);
       }
+    }
+    return FieldValue::FromArray(std::move(result));
+  }
+
+  HARD_ASSERT(type_ == Type::ArrayRemove);
+  // Each element removes the first occurrence of itself that's still left.
+  std::unordered_map<FieldValue, size_t, FieldValueHash> removals;
+  for (const FieldValue& element : elements_) {
+    ++removals[element];
+  }
+  FieldValue::Array kept;
+  for (FieldValue& value : result) {
+    auto found = removals.find(value);
+    if (found != removals.end() && found->second > 0) {
+      --found->second;
     } else {
-      HARD_ASSERT(type_ == Type::ArrayRemove);
-      if (pos != result.end()) {
-        result.erase(pos);
-      }
+      kept.push_back(std::move(value));
     }
   }
-  return FieldValue::FromArray(std::move(result));
+  return FieldValue::FromArray(std::move(kept));
 }
 
 namespace {
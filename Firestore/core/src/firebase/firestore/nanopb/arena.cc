@@ -0,0 +1,132 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
+
+#include <pb_decode.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
+#include "absl/base/config.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+namespace {
+
+// Every allocation is rounded up to this so that any nanopb struct can be
+// placed at the start of the next one.
+constexpr size_t kAlignment = alignof(std::max_align_t);
+
+size_t Align(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+thread_local Arena* current_arena = nullptr;
+#endif
+
+}  // namespace
+
+constexpr size_t Arena::kMinBlockSize;
+constexpr size_t Arena::kMaxBlockSize;
+
+void* Arena::Allocate(size_t size) {
+  if (size == 0) return nullptr;
+
+  size = Align(size);
+  if (static_cast<size_t>(end_ - next_) < size) {
+    // Grow geometrically so small operations stay small and large ones make
+    // few blocks. Oversized requests get a block of their own.
+    size_t block_size = std::min(kMaxBlockSize,
+                                 std::max(kMinBlockSize, capacity_));
+    block_size = std::max(block_size, size);
+
+    // operator new[] for char only guarantees fundamental alignment, which is
+    // exactly kAlignment.
+    blocks_.emplace_back(new char[block_size]);
+    next_ = blocks_.back().get();
+    end_ = next_ + block_size;
+    capacity_ += block_size;
+  }
+
+  void* result = next_;
+  next_ += size;
+  std::memset(result, 0, size);
+  return result;
+}
+
+pb_bytes_array_t* Arena::MakeBytesArray(const void* data, size_t size) {
+  if (size == 0) return nullptr;
+
+  pb_size_t pb_size = CheckedSize(size);
+
+  // Like nanopb::MakeBytesArray, reserve room for a null terminator.
+  auto result = static_cast<pb_bytes_array_t*>(
+      Allocate(PB_BYTES_ARRAY_T_ALLOCSIZE(pb_size + 1)));
+  result->size = pb_size;
+  std::memcpy(result->bytes, data, pb_size);
+  return result;
+}
+
+Arena* Arena::current() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  return current_arena;
+#else
+  return nullptr;
+#endif
+}
+
+ArenaScope::ArenaScope(Arena* arena) {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  previous_ = current_arena;
+  current_arena = arena;
+#else
+  (void)arena;
+#endif
+}
+
+ArenaScope::~ArenaScope() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  current_arena = previous_;
+#endif
+}
+
+void* AllocateArray(size_t count, size_t size) {
+  if (Arena* arena = Arena::current()) {
+    return arena->Allocate(count * size);
+  }
+  return std::calloc(count, size);
+}
+
+pb_bytes_array_t* AllocateBytesArray(const void* data, size_t size) {
+  if (Arena* arena = Arena::current()) {
+    return arena->MakeBytesArray(data, size);
+  }
+  return nanopb::MakeBytesArray(data, size);
+}
+
+void ReleaseMessage(const pb_field_t fields[], void* dest_struct) {
+  if (Arena::current()) return;
+  pb_release(fields, dest_struct);
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
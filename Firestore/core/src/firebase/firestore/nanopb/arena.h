@@ -0,0 +1,128 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
+
+#include <pb.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+/**
+ * A bump allocator for the nanopb structs built while encoding one operation
+ * (e.g. a single document or mutation batch).
+ *
+ * Encoding a document otherwise makes a separate heap allocation for every
+ * string and repeated field, and releasing it walks the field descriptors to
+ * free each one. While an ArenaScope is active on the current thread, the
+ * Serializer and LocalSerializer Encode* methods allocate from the scope's
+ * arena instead, FreeNanopbMessage() on their results does nothing, and all
+ * the memory is released at once when the Arena is destroyed.
+ *
+ * Messages decoded by nanopb::Reader::ReadNanopbMessage() are still allocated
+ * by nanopb itself and must be released with Reader::FreeNanopbMessage().
+ *
+ * An Arena is not thread-safe.
+ */
+class Arena {
+ public:
+  Arena() = default;
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /**
+   * Returns `size` zero-initialized bytes, suitably aligned for any nanopb
+   * struct, that remain valid until this Arena is destroyed. Returns null if
+   * `size` is zero.
+   */
+  void* Allocate(size_t size);
+
+  /**
+   * Like `nanopb::MakeBytesArray`, creates a null-terminated copy of the given
+   * bytes, but allocated from this Arena. Returns null if `size` is zero.
+   */
+  pb_bytes_array_t* MakeBytesArray(const void* data, size_t size);
+
+  /** Returns the total size of the blocks this Arena has allocated. */
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  /**
+   * Returns the Arena of the innermost ArenaScope active on this thread, or
+   * null if there is none. Always null on platforms without `thread_local`.
+   */
+  static Arena* current();
+
+ private:
+  friend class ArenaScope;
+
+  static constexpr size_t kMinBlockSize = 1024;
+  static constexpr size_t kMaxBlockSize = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* next_ = nullptr;
+  char* end_ = nullptr;
+  size_t capacity_ = 0;
+};
+
+/**
+ * Makes an Arena the target of nanopb allocations on the current thread for
+ * the lifetime of this object. Scopes nest; the previous Arena is restored
+ * when a scope ends.
+ */
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena* arena);
+  ~ArenaScope();
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+ private:
+  Arena* previous_ = nullptr;
+};
+
+/**
+ * Returns `count` zero-initialized elements of `size` bytes, from the current
+ * Arena if there is one and from `calloc` otherwise.
+ */
+void* AllocateArray(size_t count, size_t size);
+
+/**
+ * Creates a null-terminated copy of the given bytes, from the current Arena if
+ * there is one and from `malloc` otherwise. Returns null if `size` is zero.
+ */
+pb_bytes_array_t* AllocateBytesArray(const void* data, size_t size);
+
+/**
+ * Releases a message built with the allocators above: calls `pb_release`
+ * unless an Arena is current, in which case the Arena owns the memory.
+ */
+void ReleaseMessage(const pb_field_t fields[], void* dest_struct);
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
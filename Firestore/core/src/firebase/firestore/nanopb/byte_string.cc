@@ -18,6 +18,7 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <new>
 #include <ostream>
 
 #include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
@@ -31,12 +32,12 @@ namespace nanopb {
 
 ByteString::ByteString(const pb_bytes_array_t* bytes) {
   if (bytes != nullptr) {
-    bytes_ = MakeBytesArray(bytes->bytes, bytes->size);
+    rep_ = CopyRep(bytes->bytes, bytes->size);
   }
 }
 
 ByteString::ByteString(const void* value, size_t size)
-    : bytes_(MakeBytesArray(value, size)) {
+    : rep_(CopyRep(value, size)) {
 }
 
 ByteString::ByteString(absl::string_view value)
@@ -47,8 +48,10 @@ ByteString::ByteString(std::initializer_list<uint8_t> value)
     : ByteString(value.begin(), value.size()) {
 }
 
-ByteString::ByteString(const ByteString& other)
-    : ByteString(other.data(), other.size()) {
+ByteString::ByteString(const ByteString& other) : rep_(other.rep_) {
+  if (rep_) {
+    rep_->ref_count.fetch_add(1, std::memory_order_relaxed);
+  }
 }
 
 ByteString::ByteString(ByteString&& other) noexcept {
@@ -56,29 +59,84 @@ ByteString::ByteString(ByteString&& other) noexcept {
 }
 
 ByteString::~ByteString() {
-  std::free(bytes_);
+  Unref();
 }
 
 /* static */ ByteString ByteString::Take(pb_bytes_array_t* bytes) {
-  return ByteString{bytes, 0};
+  return ByteString{bytes ? new (std::malloc(sizeof(Rep))) Rep{bytes} : nullptr,
+                    0};
+}
+
+/* static */ ByteString::Rep* ByteString::CopyRep(const void* value,
+                                                  size_t size) {
+  if (size == 0) return nullptr;
+
+  pb_size_t pb_size = CheckedSize(size);
+
+  // Like `MakeBytesArray`, allocates an extra byte for a null terminator.
+  void* memory =
+      std::malloc(sizeof(Rep) + PB_BYTES_ARRAY_T_ALLOCSIZE(pb_size + 1));
+  auto bytes = reinterpret_cast<pb_bytes_array_t*>(static_cast<char*>(memory) +
+                                                   sizeof(Rep));
+  bytes->size = pb_size;
+  std::memcpy(bytes->bytes, value, pb_size);
+  bytes->bytes[pb_size] = '\0';
+
+  return new (memory) Rep{bytes};
+}
+
+bool ByteString::OwnsBytesInline() const {
+  return reinterpret_cast<const char*>(rep_->bytes) ==
+         reinterpret_cast<const char*>(rep_) + sizeof(Rep);
+}
+
+void ByteString::Unref() {
+  if (rep_ == nullptr ||
+      rep_->ref_count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+
+  if (!OwnsBytesInline()) {
+    std::free(rep_->bytes);
+  }
+  rep_->~Rep();
+  std::free(rep_);
 }
 
 const uint8_t* ByteString::data() const {
   static const uint8_t kEmpty[] = "";
-  return bytes_ ? bytes_->bytes : kEmpty;
+  return rep_ ? rep_->bytes->bytes : kEmpty;
 }
 
 pb_bytes_array_t* ByteString::release() {
-  pb_bytes_array_t* result = bytes_;
-  bytes_ = nullptr;
+  if (rep_ == nullptr) {
+    return nullptr;
+  }
+
+  pb_bytes_array_t* result = nullptr;
+  bool sole_owner = rep_->ref_count.load(std::memory_order_acquire) == 1;
+  if (sole_owner && !OwnsBytesInline()) {
+    // Nothing else refers to the array, so the caller can have it.
+    result = rep_->bytes;
+    rep_->~Rep();
+    std::free(rep_);
+  } else {
+    result = MakeBytesArray(rep_->bytes->bytes, rep_->bytes->size);
+    Unref();
+  }
+
+  rep_ = nullptr;
   return result;
 }
 
 void swap(ByteString& lhs, ByteString& rhs) noexcept {
-  std::swap(lhs.bytes_, rhs.bytes_);
+  std::swap(lhs.rep_, rhs.rep_);
 }
 
 util::ComparisonResult ByteString::CompareTo(const ByteString& rhs) const {
+  if (rep_ == rhs.rep_) {
+    return util::ComparisonResult::Same;
+  }
   return util::Compare(MakeStringView(*this), MakeStringView(rhs));
 }
 
@@ -23,6 +23,7 @@
 
 #include <pb.h>
 
+#include <atomic>
 #include <cstdint>
 #include <initializer_list>
 #include <iosfwd>
@@ -39,8 +40,12 @@ namespace nanopb {
 
 /**
  * An immutable string-like object backed by a nanopb byte array. `ByteString`
- * owns its memory, has deep copy semantics, and creates a copy of any input
- * given to its constructors.
+ * owns its memory and creates a copy of any input given to its constructors.
+ *
+ * Copies of a `ByteString` share its backing byte array, which is reference
+ * counted, so resume tokens and blobs can be passed around and stored without
+ * copying their bytes. Since the bytes are never modified, the only operation
+ * that has to copy them is `release`, and only if the array is shared.
  *
  * `ByteString` is similar in spirit to `com.google.protobuf.ByteString`. It
  * serves mostly the same purpose: it's a holder of a byte array that's
@@ -102,11 +107,11 @@ class ByteString : public util::Comparable<ByteString> {
   const uint8_t* data() const;
 
   size_t size() const {
-    return bytes_ ? bytes_->size : 0;
+    return rep_ ? rep_->bytes->size : 0;
   }
 
   bool empty() const {
-    return bytes_ == nullptr || bytes_->size == 0;
+    return size() == 0;
   }
 
   const uint8_t* begin() const {
@@ -127,12 +132,13 @@ class ByteString : public util::Comparable<ByteString> {
    * or `begin()` and `end()`, which handle this nullability for you.
    */
   const pb_bytes_array_t* get() const {
-    return bytes_;
+    return rep_ ? rep_->bytes : nullptr;
   }
 
   /**
    * Releases ownership of the backing byte array, and returns it to the caller.
-   * The backing byte array is set to null.
+   * If other copies of this `ByteString` share the array, returns a copy of it
+   * instead. The backing byte array is set to null.
    *
    * This value may be null because nanopb (and protobuf generally) treat null
    * and empty byte arrays as equivalent. Assigning a null value to a nanopb
@@ -152,14 +158,32 @@ class ByteString : public util::Comparable<ByteString> {
 
  private:
   /**
-   * Private constructor directly assigns to bytes_. The extra integer tag
+   * The backing byte array along with the number of `ByteString`s sharing it.
+   * Copied bytes are allocated in the same block as the `Rep`; taken ones are
+   * freed separately.
+   */
+  struct Rep {
+    explicit Rep(pb_bytes_array_t* bytes) : bytes{bytes} {
+    }
+
+    std::atomic<int> ref_count{1};
+    pb_bytes_array_t* bytes = nullptr;
+  };
+
+  /**
+   * Private constructor directly assigns to rep_. The extra integer tag
    * helps disambiguate this constructor from the public constructor that takes
    * `const pb_bytes_array_t*`.
    */
-  explicit ByteString(pb_bytes_array_t* bytes, int) : bytes_{bytes} {
+  explicit ByteString(Rep* rep, int) : rep_{rep} {
   }
 
-  pb_bytes_array_t* bytes_ = nullptr;
+  static Rep* CopyRep(const void* value, size_t size);
+  bool OwnsBytesInline() const;
+  void Unref();
+
+  // Null for an empty `ByteString` that doesn't have a backing byte array.
+  Rep* rep_ = nullptr;
 };
 
 }  // namespace nanopb
@@ -85,8 +85,19 @@ inline ByteString MakeByteString(NSData* value) {
   return ByteString::Take(MakeBytesArray(value.bytes, size));
 }
 
+/**
+ * Creates an `NSData` that shares the bytes of the given `ByteString` instead
+ * of copying them.
+ */
 inline NSData* MakeNSData(const ByteString& str) {
-  return [[NSData alloc] initWithBytes:str.data() length:str.size()];
+  ByteString shared = str;
+  return [[NSData alloc]
+      initWithBytesNoCopy:const_cast<uint8_t*>(shared.data())
+                   length:shared.size()
+              deallocator:^(void*, NSUInteger) {
+                // Keeps the bytes alive as long as the `NSData` is.
+                (void)shared;
+              }];
 }
 #endif
 
@@ -16,6 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
 namespace firebase {
 namespace firestore {
 namespace nanopb {
@@ -23,6 +26,7 @@ namespace nanopb {
 using nanopb::ByteString;
 
 using firebase::firestore::util::Status;
+using firebase::firestore::util::StringFormat;
 
 Reader::Reader(const ByteString& bytes) : Reader(bytes.data(), bytes.size()) {
 }
@@ -51,6 +55,92 @@ void Reader::FreeNanopbMessage(const pb_field_t fields[], void* dest_struct) {
   pb_release(fields, dest_struct);
 }
 
+bool Reader::ReadTag() {
+  if (!status_.ok()) return false;
+
+  bool eof = false;
+  if (!pb_decode_tag(&stream_, &last_tag_.wire_type, &last_tag_.field_number,
+                     &eof)) {
+    if (!eof) Fail(PB_GET_ERROR(&stream_));
+    return false;
+  }
+  return true;
+}
+
+bool Reader::RequireWireType(pb_wire_type_t wire_type) {
+  if (!status_.ok()) return false;
+
+  if (last_tag_.wire_type != wire_type) {
+    Fail(StringFormat("Input proto bytes cannot be parsed (mismatch between "
+                      "the wiretype and the field number (tag)): field %s",
+                      last_tag_.field_number));
+    return false;
+  }
+  return true;
+}
+
+bool Reader::ReadBool() {
+  return ReadInteger() != 0;
+}
+
+int64_t Reader::ReadInteger() {
+  if (!RequireWireType(PB_WT_VARINT)) return 0;
+
+  uint64_t varint = 0;
+  if (!pb_decode_varint(&stream_, &varint)) {
+    Fail(PB_GET_ERROR(&stream_));
+    return 0;
+  }
+  return static_cast<int64_t>(varint);
+}
+
+double Reader::ReadDouble() {
+  if (!RequireWireType(PB_WT_64BIT)) return 0;
+
+  double result = 0;
+  static_assert(sizeof(result) == sizeof(uint64_t), "double must be 64 bits");
+  if (!pb_decode_fixed64(&stream_, &result)) {
+    Fail(PB_GET_ERROR(&stream_));
+    return 0;
+  }
+  return result;
+}
+
+std::string Reader::ReadString() {
+  std::string result;
+  ReadDelimited([&](pb_istream_t* substream) {
+    result.resize(substream->bytes_left);
+    if (!pb_read(substream, reinterpret_cast<pb_byte_t*>(&result[0]),
+                 result.size())) {
+      Fail(PB_GET_ERROR(substream));
+      result.clear();
+    }
+  });
+  return result;
+}
+
+ByteString Reader::ReadBytes() {
+  ByteStringWriter writer;
+  ReadDelimited([&](pb_istream_t* substream) {
+    size_t size = substream->bytes_left;
+    writer.Reserve(size);
+    if (!pb_read(substream, writer.pos(), size)) {
+      Fail(PB_GET_ERROR(substream));
+      return;
+    }
+    writer.SetSize(size);
+  });
+  return writer.Release();
+}
+
+void Reader::SkipField() {
+  if (!status_.ok()) return;
+
+  if (!pb_skip_field(&stream_, last_tag_.wire_type)) {
+    Fail(PB_GET_ERROR(&stream_));
+  }
+}
+
 }  // namespace nanopb
 }  // namespace firestore
 }  // namespace firebase
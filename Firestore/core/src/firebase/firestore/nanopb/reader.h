@@ -21,6 +21,7 @@
 #include <pb_decode.h>
 
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
@@ -67,6 +68,14 @@ class Reader {
    */
   explicit Reader(absl::string_view);
 
+  /**
+   * Creates a new Reader, based on the given nanopb pb_istream_t. Note that
+   * a shallow copy will be taken. (Non-null pointers within this struct must
+   * remain valid for the lifetime of this Reader.)
+   */
+  explicit Reader(pb_istream_t stream) : stream_(stream) {
+  }
+
   /**
    * Reads a nanopb message from the input stream.
    *
@@ -91,6 +100,44 @@ class Reader {
    */
   void FreeNanopbMessage(const pb_field_t fields[], void* dest_struct);
 
+  /**
+   * Reads the tag of the next field in the message, which `field_number()` and
+   * `wire_type()` then describe. This allows decoding a message one field at a
+   * time as an alternative to ReadNanopbMessage(), without materializing the
+   * nanopb struct.
+   *
+   * After each call that returns true, the caller must consume the field with
+   * exactly one of the ReadX methods or SkipField().
+   *
+   * @return false at the end of the message or if an error occurred.
+   */
+  bool ReadTag();
+
+  uint32_t field_number() const {
+    return last_tag_.field_number;
+  }
+
+  pb_wire_type_t wire_type() const {
+    return last_tag_.wire_type;
+  }
+
+  bool ReadBool();
+  int64_t ReadInteger();
+  double ReadDouble();
+  std::string ReadString();
+  ByteString ReadBytes();
+
+  /**
+   * Reads a nested message, calling `read_fields` with a Reader limited to the
+   * nested message's bytes. `read_fields` is typically a loop over ReadTag().
+   * Any fields `read_fields` leaves unread are skipped.
+   */
+  template <typename F>
+  void ReadNestedMessage(const F& read_fields);
+
+  /** Skips over the value of the field whose tag was just read. */
+  void SkipField();
+
   util::Status status() const {
     return status_;
   }
@@ -112,19 +159,58 @@ class Reader {
   }
 
  private:
+  struct Tag {
+    pb_wire_type_t wire_type;
+    uint32_t field_number;
+  };
+
   /**
-   * Creates a new Reader, based on the given nanopb pb_istream_t. Note that
-   * a shallow copy will be taken. (Non-null pointers within this struct must
-   * remain valid for the lifetime of this Reader.)
+   * Fails this Reader, returning false, unless the field whose tag was just
+   * read has the given wire type.
    */
-  explicit Reader(pb_istream_t stream) : stream_(stream) {
-  }
+  bool RequireWireType(pb_wire_type_t wire_type);
+
+  /**
+   * Reads a length-delimited value, passing a substream limited to the value's
+   * bytes to `read`.
+   */
+  template <typename F>
+  void ReadDelimited(const F& read);
 
   util::Status status_ = util::Status::OK();
 
   pb_istream_t stream_;
+  Tag last_tag_{};
 };
 
+template <typename F>
+void Reader::ReadDelimited(const F& read) {
+  if (!RequireWireType(PB_WT_STRING)) return;
+
+  pb_istream_t substream;
+  if (!pb_make_string_substream(&stream_, &substream)) {
+    Fail(PB_GET_ERROR(&stream_));
+    return;
+  }
+
+  read(&substream);
+
+  // Closing the substream skips any unread bytes and advances this stream.
+  if (!pb_close_string_substream(&stream_, &substream)) {
+    Fail(PB_GET_ERROR(&stream_));
+  }
+}
+
+template <typename F>
+void Reader::ReadNestedMessage(const F& read_fields) {
+  ReadDelimited([&](pb_istream_t* substream) {
+    Reader nested{*substream};
+    read_fields(&nested);
+    *substream = nested.stream_;
+    status_.Update(nested.status());
+  });
+}
+
 }  // namespace nanopb
 }  // namespace firestore
 }  // namespace firebase
@@ -35,6 +35,48 @@ void Writer::WriteNanopbMessage(const pb_field_t fields[],
   }
 }
 
+void Writer::WriteTag(pb_wire_type_t wire_type, uint32_t field_number) {
+  if (!pb_encode_tag(&stream_, wire_type, field_number)) {
+    HARD_FAIL(PB_GET_ERROR(&stream_));
+  }
+}
+
+void Writer::WriteInteger(int64_t value) {
+  if (!pb_encode_varint(&stream_, static_cast<uint64_t>(value))) {
+    HARD_FAIL(PB_GET_ERROR(&stream_));
+  }
+}
+
+void Writer::WriteDouble(double value) {
+  static_assert(sizeof(value) == sizeof(uint64_t), "double must be 64 bits");
+  if (!pb_encode_fixed64(&stream_, &value)) {
+    HARD_FAIL(PB_GET_ERROR(&stream_));
+  }
+}
+
+void Writer::WriteString(absl::string_view value) {
+  if (!pb_encode_string(&stream_,
+                        reinterpret_cast<const pb_byte_t*>(value.data()),
+                        value.size())) {
+    HARD_FAIL(PB_GET_ERROR(&stream_));
+  }
+}
+
+void Writer::WriteLength(size_t size) {
+  if (!pb_encode_varint(&stream_, size)) {
+    HARD_FAIL(PB_GET_ERROR(&stream_));
+  }
+}
+
+size_t Writer::VarintSize(uint64_t value) {
+  size_t result = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++result;
+  }
+  return result;
+}
+
 namespace {
 
 constexpr size_t kMinBufferSize = 4;
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -45,6 +46,40 @@ class Writer {
    */
   void WriteNanopbMessage(const pb_field_t fields[], const void* src_struct);
 
+  /**
+   * Writes a field tag. Together with the WriteX methods below, this allows
+   * encoding a message field by field, without first building the equivalent
+   * nanopb struct. Each tag must be followed by exactly one value of the
+   * matching wire type.
+   */
+  void WriteTag(pb_wire_type_t wire_type, uint32_t field_number);
+
+  /** Writes a varint, encoding negative values as int64 does (10 bytes). */
+  void WriteInteger(int64_t value);
+
+  void WriteBool(bool value) {
+    WriteInteger(value ? 1 : 0);
+  }
+
+  void WriteDouble(double value);
+
+  /** Writes a length-delimited string or bytes value. */
+  void WriteString(absl::string_view value);
+
+  /**
+   * Writes the length prefix of a nested message, whose `size` bytes of
+   * contents the caller must write next.
+   */
+  void WriteLength(size_t size);
+
+  /** Returns the number of bytes needed to encode the given varint. */
+  static size_t VarintSize(uint64_t value);
+
+  /** Returns the number of bytes needed to encode the given field tag. */
+  static size_t TagSize(uint32_t field_number) {
+    return VarintSize(static_cast<uint64_t>(field_number) << 3);
+  }
+
  protected:
   /**
    * Creates a new Writer, with a default-initialized pb_ostream_t.
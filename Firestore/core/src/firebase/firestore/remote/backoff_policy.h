@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BACKOFF_POLICY_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BACKOFF_POLICY_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/** How a stream waits between attempts to reconnect to the backend. */
+struct BackoffPolicy {
+  enum class Jitter {
+    /**
+     * Each delay is the base delay plus or minus up to half of it, and the
+     * base delay grows by `backoff_factor` after each attempt.
+     */
+    Proportional,
+
+    /**
+     * Each delay is picked at random between `initial_delay` and
+     * `backoff_factor` times the previous delay. Clients that failed at the
+     * same moment drift apart after a few attempts instead of retrying in
+     * lockstep.
+     */
+    Decorrelated,
+  };
+
+  /** The multiplier applied to the delay after each attempt. */
+  double backoff_factor = 1.5;
+
+  /**
+   * The base delay of the first retry. Defaults to 1s according to
+   * https://cloud.google.com/apis/design/errors.
+   */
+  std::chrono::milliseconds initial_delay{std::chrono::seconds(1)};
+
+  /** The base delay after which no further backoff is performed. */
+  std::chrono::milliseconds max_delay{std::chrono::seconds(60)};
+
+  Jitter jitter = Jitter::Proportional;
+
+  /**
+   * Whether the delay goes back to zero when the device regains network
+   * connectivity, so that a stream backing off while the network was down
+   * reconnects right away.
+   */
+  bool reset_on_network_available = false;
+
+  size_t Hash() const {
+    return util::Hash(backoff_factor, initial_delay.count(), max_delay.count(),
+                      static_cast<int>(jitter), reset_on_network_available);
+  }
+};
+
+inline bool operator==(const BackoffPolicy& lhs, const BackoffPolicy& rhs) {
+  return lhs.backoff_factor == rhs.backoff_factor &&
+         lhs.initial_delay == rhs.initial_delay &&
+         lhs.max_delay == rhs.max_delay && lhs.jitter == rhs.jitter &&
+         lhs.reset_on_network_available == rhs.reset_on_network_available;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BACKOFF_POLICY_H_
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+uint64_t Fnv1a64(absl::string_view value) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : value) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+uint64_t SplitMix64(uint64_t value) {
+  value += 0x9E3779B97F4A7C15ULL;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+  return value ^ (value >> 31);
+}
+
+}  // namespace
+
+BloomFilter::BloomFilter(std::vector<uint8_t> bitmap,
+                         int32_t padding,
+                         int32_t hash_count)
+    : bitmap_{std::move(bitmap)}, hash_count_{hash_count} {
+  HARD_ASSERT(padding >= 0 && padding < 8,
+              "Invalid Bloom filter padding: %s", padding);
+  HARD_ASSERT(hash_count >= 0, "Invalid Bloom filter hash count: %s",
+              hash_count);
+  if (bitmap_.empty()) {
+    HARD_ASSERT(padding == 0,
+                "Expected padding of 0 for an empty Bloom filter, got %s",
+                padding);
+  } else {
+    HARD_ASSERT(hash_count > 0,
+                "Expected a positive hash count for a non-empty Bloom filter");
+  }
+
+  bit_count_ = static_cast<int32_t>(bitmap_.size() * 8) - padding;
+}
+
+bool BloomFilter::MightContain(absl::string_view value) const {
+  if (bit_count_ == 0) {
+    return false;
+  }
+
+  uint64_t h1 = Fnv1a64(value);
+  uint64_t h2 = SplitMix64(h1);
+  auto bit_count = static_cast<uint64_t>(bit_count_);
+  for (int32_t i = 0; i < hash_count_; ++i) {
+    uint64_t index = (h1 + static_cast<uint64_t>(i) * h2) % bit_count;
+    if (!IsBitSet(index)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BloomFilter::IsBitSet(uint64_t index) const {
+  uint8_t byte = bitmap_[index / 8];
+  return (byte & (1 << (index % 8))) != 0;
+}
+
+bool operator==(const BloomFilter& lhs, const BloomFilter& rhs) {
+  return lhs.bit_count() == rhs.bit_count() &&
+         lhs.hash_count() == rhs.hash_count() && lhs.bitmap() == rhs.bitmap();
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A read-only Bloom filter over strings, as sent along with an existence
+ * filter to describe the documents that still match a target.
+ *
+ * The filter consists of a bitmap whose last byte may carry `padding` unused
+ * high bits, and of the number of hash functions, `hash_count`, applied to
+ * each value. The hash functions are derived by double hashing: the `i`th bit
+ * probed for a value is `(h1 + i * h2) % bit_count`, where `h1` is the 64-bit
+ * FNV-1a hash of the value and `h2` is `h1` passed through the SplitMix64
+ * finalizer. Bit `n` is stored in byte `n / 8` at position `n % 8`, counting
+ * from the least significant bit.
+ */
+class BloomFilter {
+ public:
+  BloomFilter() = default;
+  BloomFilter(std::vector<uint8_t> bitmap, int32_t padding, int32_t hash_count);
+
+  /** The number of usable bits in the bitmap. */
+  int32_t bit_count() const {
+    return bit_count_;
+  }
+
+  int32_t hash_count() const {
+    return hash_count_;
+  }
+
+  const std::vector<uint8_t>& bitmap() const {
+    return bitmap_;
+  }
+
+  /**
+   * Returns false if `value` was definitely not added to the filter, true if
+   * it might have been. An empty filter contains nothing.
+   */
+  bool MightContain(absl::string_view value) const;
+
+ private:
+  bool IsBitSet(uint64_t index) const;
+
+  std::vector<uint8_t> bitmap_;
+  int32_t bit_count_ = 0;
+  int32_t hash_count_ = 0;
+};
+
+bool operator==(const BloomFilter& lhs, const BloomFilter& rhs);
+
+inline bool operator!=(const BloomFilter& lhs, const BloomFilter& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
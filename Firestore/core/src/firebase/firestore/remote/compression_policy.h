@@ -0,0 +1,66 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_COMPRESSION_POLICY_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_COMPRESSION_POLICY_H_
+
+#include <cstddef>
+
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * How the messages the client sends on the watch and write streams, and in
+ * document lookups, are compressed.
+ *
+ * Compressing a message costs CPU time on both ends, so it pays off mostly
+ * for large messages sent over slow or metered networks.
+ */
+struct CompressionPolicy {
+  enum class Algorithm {
+    None,
+    Gzip,
+    Deflate,
+  };
+
+  Algorithm algorithm = Algorithm::None;
+
+  /** Messages smaller than this many bytes are sent uncompressed. */
+  size_t min_message_bytes = 1024;
+
+  bool enabled() const {
+    return algorithm != Algorithm::None;
+  }
+
+  size_t Hash() const {
+    return util::Hash(static_cast<int>(algorithm), min_message_bytes);
+  }
+};
+
+inline bool operator==(const CompressionPolicy& lhs,
+                       const CompressionPolicy& rhs) {
+  return lhs.algorithm == rhs.algorithm &&
+         lhs.min_message_bytes == rhs.min_message_bytes;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_COMPRESSION_POLICY_H_
@@ -40,6 +40,12 @@ void ConnectivityMonitor::MaybeInvokeCallbacks(NetworkStatus new_status) {
   }
 }
 
+void ConnectivityMonitor::InvokeForegroundCallbacks() {
+  for (auto& callback : foreground_callbacks_) {
+    callback();
+  }
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
@@ -65,6 +65,15 @@ class ConnectivityMonitor {
   }
   // TODO(varconst): RemoveCallback.
 
+  /**
+   * Adds a callback invoked on the worker queue whenever the app returns to
+   * the foreground, where supported. Connections left idle while the app was
+   * in the background are unlikely to still be usable by then.
+   */
+  void AddForegroundCallback(std::function<void()>&& callback) {
+    foreground_callbacks_.push_back(std::move(callback));
+  }
+
  protected:
   // The status may be retrieved asynchronously.
   void SetInitialStatus(NetworkStatus new_status);
@@ -72,6 +81,8 @@ class ConnectivityMonitor {
   // Invokes callbacks only if the status changed.
   void MaybeInvokeCallbacks(NetworkStatus new_status);
 
+  void InvokeForegroundCallbacks();
+
   const std::shared_ptr<util::AsyncQueue>& queue() {
     return worker_queue_;
   }
@@ -79,6 +90,7 @@ class ConnectivityMonitor {
  private:
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   std::vector<Callback> callbacks_;
+  std::vector<std::function<void()>> foreground_callbacks_;
   absl::optional<NetworkStatus> status_;
 };
 
@@ -18,6 +18,7 @@
 
 #if defined(__APPLE__)
 
+#import <Foundation/Foundation.h>
 #include <SystemConfiguration/SystemConfiguration.h>
 #include <dispatch/dispatch.h>
 #include <netinet/in.h>
@@ -68,6 +69,13 @@ void OnReachabilityChangedCallback(SCNetworkReachabilityRef /*unused*/,
                                    SCNetworkReachabilityFlags flags,
                                    void* raw_this);
 
+#if TARGET_OS_IOS || TARGET_OS_TV
+// The value of `UIApplicationWillEnterForegroundNotification`, spelled out to
+// avoid linking against UIKit.
+NSString* const kWillEnterForegroundNotification =
+    @"UIApplicationWillEnterForegroundNotification";
+#endif
+
 }  // namespace
 
 /**
@@ -112,9 +120,16 @@ class ConnectivityMonitorApple : public ConnectivityMonitor {
       LOG_DEBUG("Couldn't set reachability queue");
       return;
     }
+
+    ObserveForeground(executor->dispatch_queue());
   }
 
   ~ConnectivityMonitorApple() {
+    if (foreground_observer_) {
+      [[NSNotificationCenter defaultCenter]
+          removeObserver:foreground_observer_];
+    }
+
     if (reachability_) {
       bool success =
           SCNetworkReachabilitySetDispatchQueue(reachability_, nullptr);
@@ -132,7 +147,27 @@ class ConnectivityMonitorApple : public ConnectivityMonitor {
   }
 
  private:
+  void ObserveForeground(dispatch_queue_t dispatch_queue) {
+#if TARGET_OS_IOS || TARGET_OS_TV
+    // Like reachability callbacks, notifications are delivered on the worker
+    // queue's dispatch queue.
+    NSOperationQueue* operation_queue = [[NSOperationQueue alloc] init];
+    operation_queue.underlyingQueue = dispatch_queue;
+    foreground_observer_ = [[NSNotificationCenter defaultCenter]
+        addObserverForName:kWillEnterForegroundNotification
+                    object:nil
+                     queue:operation_queue
+                usingBlock:^(NSNotification*) {
+                  queue()->ExecuteBlocking(
+                      [this] { InvokeForegroundCallbacks(); });
+                }];
+#else
+    (void)dispatch_queue;
+#endif
+  }
+
   SCNetworkReachabilityRef reachability_ = nil;
+  id<NSObject> foreground_observer_ = nil;
 };
 
 namespace {
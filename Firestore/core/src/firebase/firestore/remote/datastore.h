@@ -32,8 +32,12 @@
 #include "Firestore/core/src/firebase/firestore/auth/token.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/remote/backoff_policy.h"
+#include "Firestore/core/src/firebase/firestore/remote/compression_policy.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_call.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_runtime.h"
+#include "Firestore/core/src/firebase/firestore/remote/keepalive_policy.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/write_stream.h"
@@ -42,6 +46,7 @@
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "grpcpp/completion_queue.h"
 #include "grpcpp/support/status.h"
 
@@ -73,14 +78,35 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   using LookupCallback = std::function<void(
       const std::vector<FSTMaybeDocument*>&, const util::Status&)>;
   using CommitCallback = std::function<void(const util::Status&)>;
+  using LookupDocumentCallback = std::function<void(FSTMaybeDocument*)>;
+  using LookupFinishedCallback = std::function<void(const util::Status&)>;
+  using RunQueryCallback = std::function<void(const std::vector<FSTDocument*>&,
+                                              const util::Status&)>;
 
+  /**
+   * If `separate_watch_channel` is true, the watch stream uses a gRPC channel,
+   * completion queue and polling thread of its own rather than sharing them
+   * with writes and lookups.
+   *
+   * If `shared_runtime` is given, writes, lookups and (unless separate) the
+   * watch stream go through its completion queue and channels instead of ones
+   * belonging to this `Datastore`.
+   */
   Datastore(const core::DatabaseInfo& database_info,
             const std::shared_ptr<util::AsyncQueue>& worker_queue,
-            auth::CredentialsProvider* credentials);
+            auth::CredentialsProvider* credentials,
+            bool separate_watch_channel = false,
+            std::shared_ptr<GrpcRuntime> shared_runtime = nullptr);
 
   virtual ~Datastore() {
   }
 
+  /**
+   * Returns the `GrpcRuntime` shared by all the `Datastore`s in the process
+   * that opt into sharing one, creating it on first use.
+   */
+  static std::shared_ptr<GrpcRuntime> SharedGrpcRuntime();
+
   /** Starts polling the gRPC completion queue. */
   void Start();
   /** Cancels any pending gRPC calls and drains the gRPC completion queue. */
@@ -99,11 +125,73 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   virtual std::shared_ptr<WriteStream> CreateWriteStream(
       WriteStreamCallback* callback);
 
+  /** How streams created afterwards by `CreateWatchStream` back off. */
+  void set_watch_stream_backoff_policy(const BackoffPolicy& policy) {
+    watch_stream_backoff_policy_ = policy;
+  }
+  /** How streams created afterwards by `CreateWriteStream` back off. */
+  void set_write_stream_backoff_policy(const BackoffPolicy& policy) {
+    write_stream_backoff_policy_ = policy;
+  }
+
+  /**
+   * How long streams created afterwards by `CreateWatchStream` stay open
+   * after they are marked idle.
+   */
+  void set_watch_stream_idle_timeout(util::AsyncQueue::Milliseconds timeout) {
+    watch_stream_idle_timeout_ = timeout;
+  }
+  /**
+   * How long streams created afterwards by `CreateWriteStream` stay open
+   * after they are marked idle.
+   */
+  void set_write_stream_idle_timeout(util::AsyncQueue::Milliseconds timeout) {
+    write_stream_idle_timeout_ = timeout;
+  }
+
+  /**
+   * Sets how the connections to the backend are pinged. Call before creating
+   * any streams or calls.
+   */
+  void set_keepalive_policy(const KeepalivePolicy& policy) {
+    grpc_connection_.set_keepalive_policy(policy);
+  }
+
+  /**
+   * Sets how the messages sent on streams and in document lookups are
+   * compressed. Call before creating any streams or calls.
+   */
+  void set_compression_policy(const CompressionPolicy& policy) {
+    grpc_connection_.set_compression_policy(policy);
+  }
+
   void CommitMutations(const std::vector<FSTMutation*>& mutations,
                        CommitCallback&& callback);
+  /**
+   * Looks up the given documents and invokes `callback` with all of them,
+   * sorted by key, once the last one has arrived.
+   */
   void LookupDocuments(const std::vector<model::DocumentKey>& keys,
                        LookupCallback&& callback);
 
+  /**
+   * Looks up the given documents, invoking `on_document` with each one as
+   * soon as the backend's response for it arrives, in the order the backend
+   * sends them. `on_finish` is invoked once all documents have been delivered
+   * or the lookup fails; after a failure, documents delivered so far should be
+   * discarded.
+   */
+  void LookupDocumentsIncrementally(const std::vector<model::DocumentKey>& keys,
+                                    LookupDocumentCallback&& on_document,
+                                    LookupFinishedCallback&& on_finish);
+
+  /**
+   * Runs the query once on the backend, without a watch target, and invokes
+   * `callback` with the results, in query order, once the last one has
+   * arrived.
+   */
+  void RunQuery(FSTQuery* query, RunQueryCallback&& callback);
+
   /** Returns true if the given error is a gRPC ABORTED error. */
   static bool IsAbortedError(const util::Status& status);
 
@@ -143,7 +231,9 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   Datastore(const core::DatabaseInfo& database_info,
             const std::shared_ptr<util::AsyncQueue>& worker_queue,
             auth::CredentialsProvider* credentials,
-            std::unique_ptr<ConnectivityMonitor> connectivity_monitor);
+            std::unique_ptr<ConnectivityMonitor> connectivity_monitor,
+            bool separate_watch_channel = false,
+            std::shared_ptr<GrpcRuntime> shared_runtime = nullptr);
 
   /** Test-only method */
   grpc::CompletionQueue* grpc_queue() {
@@ -160,7 +250,8 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   }
 
  private:
-  void PollGrpcQueue();
+  void PollGrpcQueue(util::Executor* executor,
+                     grpc::CompletionQueue* grpc_queue);
 
   void CommitMutationsWithCredentials(
       const auth::Token& token,
@@ -170,10 +261,12 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   void LookupDocumentsWithCredentials(
       const auth::Token& token,
       const std::vector<model::DocumentKey>& keys,
-      LookupCallback&& callback);
-  void OnLookupDocumentsResponse(
-      const util::StatusOr<std::vector<grpc::ByteBuffer>>& result,
-      const LookupCallback& callback);
+      LookupDocumentCallback&& on_document,
+      LookupFinishedCallback&& on_finish);
+
+  void RunQueryWithCredentials(const auth::Token& token,
+                               FSTQuery* query,
+                               RunQueryCallback&& callback);
 
   using OnCredentials = std::function<void(const util::StatusOr<auth::Token>&)>;
   void ResumeRpcWithCredentials(const OnCredentials& on_token);
@@ -192,16 +285,27 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   auth::CredentialsProvider* credentials_ = nullptr;
 
+  // If set, its completion queue and polling executor are used instead of
+  // `grpc_queue_` and `rpc_executor_`.
+  std::shared_ptr<GrpcRuntime> shared_runtime_;
   // A separate executor dedicated to polling gRPC completion queue (which is
   // shared for all spawned gRPC streams and calls).
   std::unique_ptr<util::Executor> rpc_executor_;
   grpc::CompletionQueue grpc_queue_;
+  // Only used if the watch stream is kept separate from other traffic.
+  std::unique_ptr<util::Executor> watch_rpc_executor_;
+  std::unique_ptr<grpc::CompletionQueue> watch_grpc_queue_;
   // TODO(varconst): move `ConnectivityMonitor` to `FSTFirestoreClient`.
   std::unique_ptr<ConnectivityMonitor> connectivity_monitor_;
   GrpcConnection grpc_connection_;
 
   std::vector<std::unique_ptr<GrpcCall>> active_calls_;
   bridge::DatastoreSerializer serializer_bridge_;
+
+  BackoffPolicy watch_stream_backoff_policy_;
+  BackoffPolicy write_stream_backoff_policy_;
+  absl::optional<util::AsyncQueue::Milliseconds> watch_stream_idle_timeout_;
+  absl::optional<util::AsyncQueue::Milliseconds> write_stream_idle_timeout_;
 };
 
 }  // namespace remote
@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
 
+#include <map>
+#include <memory>
 #include <unordered_set>
 #include <utility>
 
@@ -30,6 +32,7 @@
 #include "Firestore/core/src/firebase/firestore/remote/connectivity_monitor.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_runtime.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_streaming_reader.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_unary_call.h"
@@ -38,6 +41,7 @@
 #include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
@@ -60,10 +64,10 @@ namespace {
 
 const auto kRpcNameCommit = "/google.firestore.v1.Firestore/Commit";
 const auto kRpcNameLookup = "/google.firestore.v1.Firestore/BatchGetDocuments";
+const auto kRpcNameRunQuery = "/google.firestore.v1.Firestore/RunQuery";
 
-std::unique_ptr<Executor> CreateExecutor() {
-  auto queue = dispatch_queue_create("com.google.firebase.firestore.rpc",
-                                     DISPATCH_QUEUE_SERIAL);
+std::unique_ptr<Executor> CreateExecutor(const char* label) {
+  auto queue = dispatch_queue_create(label, DISPATCH_QUEUE_SERIAL);
   return absl::make_unique<ExecutorLibdispatch>(queue);
 }
 
@@ -91,29 +95,73 @@ void LogGrpcCallFinished(absl::string_view rpc_name,
 
 Datastore::Datastore(const DatabaseInfo& database_info,
                      const std::shared_ptr<AsyncQueue>& worker_queue,
-                     CredentialsProvider* credentials)
-    : Datastore{database_info, worker_queue, credentials,
-                ConnectivityMonitor::Create(worker_queue)} {
+                     CredentialsProvider* credentials,
+                     bool separate_watch_channel,
+                     std::shared_ptr<GrpcRuntime> shared_runtime)
+    : Datastore{database_info,
+                worker_queue,
+                credentials,
+                ConnectivityMonitor::Create(worker_queue),
+                separate_watch_channel,
+                std::move(shared_runtime)} {
 }
 
 Datastore::Datastore(const DatabaseInfo& database_info,
                      const std::shared_ptr<AsyncQueue>& worker_queue,
                      CredentialsProvider* credentials,
-                     std::unique_ptr<ConnectivityMonitor> connectivity_monitor)
+                     std::unique_ptr<ConnectivityMonitor> connectivity_monitor,
+                     bool separate_watch_channel,
+                     std::shared_ptr<GrpcRuntime> shared_runtime)
     : worker_queue_{NOT_NULL(worker_queue)},
       credentials_{credentials},
-      rpc_executor_{CreateExecutor()},
+      shared_runtime_{std::move(shared_runtime)},
+      rpc_executor_{shared_runtime_
+                        ? nullptr
+                        : CreateExecutor("com.google.firebase.firestore.rpc")},
+      watch_rpc_executor_{
+          separate_watch_channel
+              ? CreateExecutor("com.google.firebase.firestore.rpc.watch")
+              : nullptr},
+      watch_grpc_queue_{separate_watch_channel
+                            ? absl::make_unique<grpc::CompletionQueue>()
+                            : nullptr},
       connectivity_monitor_{std::move(connectivity_monitor)},
-      grpc_connection_{database_info, worker_queue, &grpc_queue_,
-                       connectivity_monitor_.get()},
+      grpc_connection_{database_info,
+                       worker_queue,
+                       shared_runtime_ ? shared_runtime_->grpc_queue()
+                                       : &grpc_queue_,
+                       connectivity_monitor_.get(),
+                       separate_watch_channel,
+                       watch_grpc_queue_.get()},
       serializer_bridge_{database_info} {
   if (!database_info.ssl_enabled()) {
     GrpcConnection::UseInsecureChannel(database_info.host());
   }
+  if (shared_runtime_) {
+    grpc_connection_.set_shared_runtime(shared_runtime_.get());
+  }
+}
+
+std::shared_ptr<GrpcRuntime> Datastore::SharedGrpcRuntime() {
+  // Never destroyed: instances may be shut down in any order, and the polling
+  // thread has nothing left to do once the process exits.
+  static auto* runtime = new std::shared_ptr<GrpcRuntime>{
+      std::make_shared<GrpcRuntime>(
+          CreateExecutor("com.google.firebase.firestore.rpc.shared"))};
+  return *runtime;
 }
 
 void Datastore::Start() {
-  rpc_executor_->Execute([this] { PollGrpcQueue(); });
+  // The shared runtime polls its own queue.
+  if (rpc_executor_) {
+    rpc_executor_->Execute(
+        [this] { PollGrpcQueue(rpc_executor_.get(), &grpc_queue_); });
+  }
+  if (watch_rpc_executor_) {
+    watch_rpc_executor_->Execute([this] {
+      PollGrpcQueue(watch_rpc_executor_.get(), watch_grpc_queue_.get());
+    });
+  }
 }
 
 void Datastore::Shutdown() {
@@ -128,19 +176,29 @@ void Datastore::Shutdown() {
   // been called and all submitted tags have been extracted. Without this call,
   // `rpc_executor_` will never finish.
   grpc_queue_.Shutdown();
-  // Drain the executor to make sure it extracted all the operations from gRPC
-  // completion queue.
-  rpc_executor_->ExecuteBlocking([] {});
+  if (watch_grpc_queue_) {
+    watch_grpc_queue_->Shutdown();
+  }
+  // Drain the executors to make sure they extracted all the operations from
+  // gRPC completion queues. Finishing the calls above already waited for their
+  // operations to come off the shared queue, if any.
+  if (rpc_executor_) {
+    rpc_executor_->ExecuteBlocking([] {});
+  }
+  if (watch_rpc_executor_) {
+    watch_rpc_executor_->ExecuteBlocking([] {});
+  }
 }
 
-void Datastore::PollGrpcQueue() {
-  HARD_ASSERT(rpc_executor_->IsCurrentExecutor(),
+void Datastore::PollGrpcQueue(Executor* executor,
+                              grpc::CompletionQueue* grpc_queue) {
+  HARD_ASSERT(executor->IsCurrentExecutor(),
               "PollGrpcQueue should only be called on the "
               "dedicated Datastore executor");
 
   void* tag = nullptr;
   bool ok = false;
-  while (grpc_queue_.Next(&tag, &ok)) {
+  while (grpc_queue->Next(&tag, &ok)) {
     auto completion = static_cast<GrpcCompletion*>(tag);
     // While it's valid in principle, we never deliberately pass a null pointer
     // to gRPC completion queue and expect it back. This assertion might be
@@ -152,16 +210,24 @@ void Datastore::PollGrpcQueue() {
 
 std::shared_ptr<WatchStream> Datastore::CreateWatchStream(
     WatchStreamCallback* callback) {
-  return std::make_shared<WatchStream>(worker_queue_, credentials_,
-                                       serializer_bridge_.GetSerializer(),
-                                       &grpc_connection_, callback);
+  auto stream = std::make_shared<WatchStream>(
+      worker_queue_, credentials_, serializer_bridge_.GetSerializer(),
+      &grpc_connection_, callback, watch_stream_backoff_policy_);
+  if (watch_stream_idle_timeout_) {
+    stream->set_idle_timeout(*watch_stream_idle_timeout_);
+  }
+  return stream;
 }
 
 std::shared_ptr<WriteStream> Datastore::CreateWriteStream(
     WriteStreamCallback* callback) {
-  return std::make_shared<WriteStream>(worker_queue_, credentials_,
-                                       serializer_bridge_.GetSerializer(),
-                                       &grpc_connection_, callback);
+  auto stream = std::make_shared<WriteStream>(
+      worker_queue_, credentials_, serializer_bridge_.GetSerializer(),
+      &grpc_connection_, callback, write_stream_backoff_policy_);
+  if (write_stream_idle_timeout_) {
+    stream->set_idle_timeout(*write_stream_idle_timeout_);
+  }
+  return stream;
 }
 
 void Datastore::CommitMutations(const std::vector<FSTMutation*>& mutations,
@@ -191,6 +257,10 @@ void Datastore::CommitMutationsWithCredentials(
   GrpcUnaryCall* call = call_owning.get();
   active_calls_.push_back(std::move(call_owning));
 
+  static util::Counter& requests_sent =
+      util::MetricsRegistry::Default().GetCounter("remote.write_requests_sent");
+  requests_sent.Increment();
+
   call->Start(
       // TODO(c++14): move into lambda.
       [this, call, callback](const StatusOr<grpc::ByteBuffer>& result) {
@@ -206,22 +276,51 @@ void Datastore::CommitMutationsWithCredentials(
 
 void Datastore::LookupDocuments(const std::vector<DocumentKey>& keys,
                                 LookupCallback&& callback) {
+  // Sort by key.
+  auto results = std::make_shared<std::map<DocumentKey, FSTMaybeDocument*>>();
+
+  LookupDocumentsIncrementally(
+      keys,
+      [results](FSTMaybeDocument* doc) { (*results)[doc.key] = doc; },
+      // TODO(c++14): move into lambda.
+      [results, callback](const Status& status) {
+        if (!status.ok()) {
+          callback({}, status);
+          return;
+        }
+
+        std::vector<FSTMaybeDocument*> docs;
+        docs.reserve(results->size());
+        for (const auto& kv : *results) {
+          docs.push_back(kv.second);
+        }
+        callback(docs, status);
+      });
+}
+
+void Datastore::LookupDocumentsIncrementally(
+    const std::vector<DocumentKey>& keys,
+    LookupDocumentCallback&& on_document,
+    LookupFinishedCallback&& on_finish) {
   ResumeRpcWithCredentials(
       // TODO(c++14): move into lambda.
-      [this, keys, callback](const StatusOr<Token>& maybe_credentials) mutable {
+      [this, keys, on_document,
+       on_finish](const StatusOr<Token>& maybe_credentials) mutable {
         if (!maybe_credentials.ok()) {
-          callback({}, maybe_credentials.status());
+          on_finish(maybe_credentials.status());
           return;
         }
         LookupDocumentsWithCredentials(maybe_credentials.ValueOrDie(), keys,
-                                       std::move(callback));
+                                       std::move(on_document),
+                                       std::move(on_finish));
       });
 }
 
 void Datastore::LookupDocumentsWithCredentials(
     const Token& token,
     const std::vector<DocumentKey>& keys,
-    LookupCallback&& callback) {
+    LookupDocumentCallback&& on_document,
+    LookupFinishedCallback&& on_finish) {
   grpc::ByteBuffer message = serializer_bridge_.ToByteBuffer(
       serializer_bridge_.CreateLookupRequest(keys));
 
@@ -231,31 +330,86 @@ void Datastore::LookupDocumentsWithCredentials(
   GrpcStreamingReader* call = call_owning.get();
   active_calls_.push_back(std::move(call_owning));
 
+  // Once a response fails to parse, the rest of them are dropped and the
+  // error is reported when the call finishes.
+  auto parse_status = std::make_shared<Status>();
+
   // TODO(c++14): move into lambda.
-  call->Start([this, call, callback](
-                  const StatusOr<std::vector<grpc::ByteBuffer>>& result) {
-    LogGrpcCallFinished("BatchGetDocuments", call, result.status());
-    HandleCallStatus(result.status());
+  call->Start(
+      [this, parse_status, on_document](const grpc::ByteBuffer& response) {
+        if (!parse_status->ok()) {
+          return;
+        }
+        FSTMaybeDocument* doc =
+            serializer_bridge_.ToMaybeDocument(response, parse_status.get());
+        if (parse_status->ok()) {
+          on_document(doc);
+        }
+      },
+      [this, call, parse_status, on_finish](const Status& status) {
+        LogGrpcCallFinished("BatchGetDocuments", call, status);
+        HandleCallStatus(status);
 
-    OnLookupDocumentsResponse(result, callback);
+        on_finish(status.ok() ? *parse_status : status);
 
-    RemoveGrpcCall(call);
-  });
+        RemoveGrpcCall(call);
+      });
 }
 
-void Datastore::OnLookupDocumentsResponse(
-    const StatusOr<std::vector<grpc::ByteBuffer>>& result,
-    const LookupCallback& callback) {
-  if (!result.ok()) {
-    callback({}, result.status());
-    return;
-  }
+void Datastore::RunQuery(FSTQuery* query, RunQueryCallback&& callback) {
+  ResumeRpcWithCredentials(
+      // TODO(c++14): move into lambda.
+      [this, query, callback](const StatusOr<Token>& maybe_credentials) mutable {
+        if (!maybe_credentials.ok()) {
+          callback({}, maybe_credentials.status());
+          return;
+        }
+        RunQueryWithCredentials(maybe_credentials.ValueOrDie(), query,
+                                std::move(callback));
+      });
+}
+
+void Datastore::RunQueryWithCredentials(const Token& token,
+                                        FSTQuery* query,
+                                        RunQueryCallback&& callback) {
+  grpc::ByteBuffer message = serializer_bridge_.ToByteBuffer(
+      serializer_bridge_.CreateRunQueryRequest(query));
+
+  std::unique_ptr<GrpcStreamingReader> call_owning =
+      grpc_connection_.CreateStreamingReader(kRpcNameRunQuery, token,
+                                             std::move(message));
+  GrpcStreamingReader* call = call_owning.get();
+  active_calls_.push_back(std::move(call_owning));
+
+  // The backend sends the results in query order.
+  auto results = std::make_shared<std::vector<FSTDocument*>>();
+  auto parse_status = std::make_shared<Status>();
+
+  // TODO(c++14): move into lambda.
+  call->Start(
+      [this, results, parse_status](const grpc::ByteBuffer& response) {
+        if (!parse_status->ok()) {
+          return;
+        }
+        FSTDocument* doc =
+            serializer_bridge_.ToDocument(response, parse_status.get());
+        if (doc) {
+          results->push_back(doc);
+        }
+      },
+      [this, call, results, parse_status, callback](const Status& status) {
+        LogGrpcCallFinished("RunQuery", call, status);
+        HandleCallStatus(status);
+
+        Status result = status.ok() ? *parse_status : status;
+        if (result.ok()) {
+          callback(*results, result);
+        } else {
+          callback({}, result);
+        }
 
-  Status parse_status;
-  std::vector<grpc::ByteBuffer> responses = std::move(result).ValueOrDie();
-  std::vector<FSTMaybeDocument*> docs =
-      serializer_bridge_.MergeLookupResponses(responses, &parse_status);
-  callback(docs, parse_status);
+        RemoveGrpcCall(call);
+      });
 }
 
 void Datastore::ResumeRpcWithCredentials(const OnCredentials& on_credentials) {
@@ -17,6 +17,11 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_EXISTENCE_FILTER_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_EXISTENCE_FILTER_H_
 
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+#include "absl/types/optional.h"
+
 namespace firebase {
 namespace firestore {
 namespace remote {
@@ -27,16 +32,31 @@ class ExistenceFilter {
   explicit ExistenceFilter(int count) : count_{count} {
   }
 
+  ExistenceFilter(int count, absl::optional<BloomFilter> unchanged_names)
+      : count_{count}, unchanged_names_{std::move(unchanged_names)} {
+  }
+
   int count() const {
     return count_;
   }
 
+  /**
+   * A Bloom filter over the paths of the documents that still match the
+   * target, if the backend sent one. It lets the client tell which of its
+   * documents were removed when `count` doesn't match.
+   */
+  const absl::optional<BloomFilter>& unchanged_names() const {
+    return unchanged_names_;
+  }
+
  private:
   int count_ = 0;
+  absl::optional<BloomFilter> unchanged_names_;
 };
 
 inline bool operator==(const ExistenceFilter& lhs, const ExistenceFilter& rhs) {
-  return lhs.count() == rhs.count();
+  return lhs.count() == rhs.count() &&
+         lhs.unchanged_names() == rhs.unchanged_names();
 }
 
 }  // namespace remote
@@ -32,24 +32,46 @@ using firebase::firestore::util::AsyncQueue;
 using firebase::firestore::util::TimerId;
 namespace chr = std::chrono;
 
+namespace {
+
+BackoffPolicy MakePolicy(double backoff_factor,
+                         AsyncQueue::Milliseconds initial_delay,
+                         AsyncQueue::Milliseconds max_delay) {
+  BackoffPolicy policy;
+  policy.backoff_factor = backoff_factor;
+  policy.initial_delay = initial_delay;
+  policy.max_delay = max_delay;
+  return policy;
+}
+
+}  // namespace
+
 ExponentialBackoff::ExponentialBackoff(const std::shared_ptr<AsyncQueue>& queue,
                                        TimerId timer_id,
                                        double backoff_factor,
                                        Milliseconds initial_delay,
                                        Milliseconds max_delay)
+    : ExponentialBackoff{queue, timer_id,
+                         MakePolicy(backoff_factor, initial_delay, max_delay)} {
+}
+
+ExponentialBackoff::ExponentialBackoff(const std::shared_ptr<AsyncQueue>& queue,
+                                       TimerId timer_id,
+                                       const BackoffPolicy& policy)
     : queue_{queue},
       timer_id_{timer_id},
-      backoff_factor_{backoff_factor},
-      initial_delay_{initial_delay},
-      max_delay_{max_delay},
+      backoff_factor_{policy.backoff_factor},
+      jitter_{policy.jitter},
+      initial_delay_{chr::duration_cast<Milliseconds>(policy.initial_delay)},
+      max_delay_{chr::duration_cast<Milliseconds>(policy.max_delay)},
       last_attempt_time_{chr::steady_clock::now()} {
   HARD_ASSERT(queue, "Queue can't be null");
 
-  HARD_ASSERT(backoff_factor >= 1.0, "Backoff factor must be at least 1");
+  HARD_ASSERT(backoff_factor_ >= 1.0, "Backoff factor must be at least 1");
 
-  HARD_ASSERT(initial_delay.count() >= 0, "Delays must be non-negative");
-  HARD_ASSERT(max_delay.count() >= 0, "Delays must be non-negative");
-  HARD_ASSERT(initial_delay <= max_delay,
+  HARD_ASSERT(initial_delay_.count() >= 0, "Delays must be non-negative");
+  HARD_ASSERT(max_delay_.count() >= 0, "Delays must be non-negative");
+  HARD_ASSERT(initial_delay_ <= max_delay_,
               "Initial delay can't be greater than max delay");
 }
 
@@ -77,25 +99,52 @@ void ExponentialBackoff::BackoffAndRun(AsyncQueue::Operation&& operation) {
         desired_delay_with_jitter.count(), delay_so_far.count());
   }
 
+  // Operations are move-only, so the operation waits in `pending_operation_`
+  // rather than in the lambda (which can't take ownership of it until C++14).
+  pending_operation_ = std::move(operation);
   delayed_operation_ =
-      queue_->EnqueueAfterDelay(remaining_delay, timer_id_, [this, operation] {
+      queue_->EnqueueAfterDelay(remaining_delay, timer_id_, [this] {
         last_attempt_time_ = chr::steady_clock::now();
-        operation();
+        // The operation may call `BackoffAndRun` again.
+        AsyncQueue::Operation to_run = std::move(pending_operation_);
+        to_run();
       });
 
-  // Apply backoff factor to determine next delay, but ensure it is within
-  // bounds.
-  current_base_ = ClampDelay(
-      chr::duration_cast<Milliseconds>(current_base_ * backoff_factor_));
+  current_base_ = GetNextBase();
 }
 
 ExponentialBackoff::Milliseconds ExponentialBackoff::GetDelayWithJitter() {
+  if (jitter_ == BackoffPolicy::Jitter::Decorrelated) {
+    // The base delay is random already.
+    return Milliseconds::zero();
+  }
+
   std::uniform_real_distribution<double> distribution;
   double random_double = distribution(secure_random_);
   return chr::duration_cast<Milliseconds>((random_double - 0.5) *
                                           current_base_);
 }
 
+ExponentialBackoff::Milliseconds ExponentialBackoff::GetNextBase() {
+  if (jitter_ == BackoffPolicy::Jitter::Proportional) {
+    // Apply backoff factor to determine next delay, but ensure it is within
+    // bounds.
+    return ClampDelay(
+        chr::duration_cast<Milliseconds>(current_base_ * backoff_factor_));
+  }
+
+  // Pick the next delay between the initial delay and `backoff_factor_` times
+  // the current one, so that clients that started out in lockstep don't stay
+  // that way.
+  double lower = static_cast<double>(initial_delay_.count());
+  double upper =
+      static_cast<double>(std::max(current_base_, initial_delay_).count()) *
+      backoff_factor_;
+  std::uniform_real_distribution<double> distribution{lower, upper};
+  auto next = static_cast<Milliseconds::rep>(distribution(secure_random_));
+  return ClampDelay(Milliseconds{next});
+}
+
 ExponentialBackoff::Milliseconds ExponentialBackoff::ClampDelay(
     Milliseconds delay) const {
   if (delay < initial_delay_) {
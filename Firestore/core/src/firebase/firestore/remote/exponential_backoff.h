@@ -20,6 +20,7 @@
 #include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 
+#include "Firestore/core/src/firebase/firestore/remote/backoff_policy.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 
@@ -38,6 +39,9 @@ namespace remote {
  * added to the base delay. This prevents clients from accidentally
  * synchronizing their delays causing spikes of load to the backend.
  *
+ * With `BackoffPolicy::Jitter::Decorrelated`, each delay is instead picked at
+ * random between the initial delay and `backoff_factor` times the previous
+ * delay.
  */
 class ExponentialBackoff {
  public:
@@ -61,6 +65,10 @@ class ExponentialBackoff {
                      util::AsyncQueue::Milliseconds initial_delay,
                      util::AsyncQueue::Milliseconds max_delay);
 
+  ExponentialBackoff(const std::shared_ptr<util::AsyncQueue>& queue,
+                     util::TimerId timer_id,
+                     const BackoffPolicy& policy);
+
   /**
    * Resets the backoff delay.
    *
@@ -90,6 +98,7 @@ class ExponentialBackoff {
   /** Cancels any pending backoff operation scheduled via `BackoffAndRun`. */
   void Cancel() {
     delayed_operation_.Cancel();
+    pending_operation_ = nullptr;
   }
 
  private:
@@ -97,13 +106,17 @@ class ExponentialBackoff {
 
   // Returns a random value in the range [-current_base_/2, current_base_/2].
   Milliseconds GetDelayWithJitter();
+  // Returns the base delay to use after `current_base_`.
+  Milliseconds GetNextBase();
   Milliseconds ClampDelay(Milliseconds delay) const;
 
   std::shared_ptr<util::AsyncQueue> queue_;
   const util::TimerId timer_id_;
   util::DelayedOperation delayed_operation_;
+  util::AsyncQueue::Operation pending_operation_;
 
   const double backoff_factor_;
+  const BackoffPolicy::Jitter jitter_;
   Milliseconds current_base_{0};
   const Milliseconds initial_delay_;
   const Milliseconds max_delay_;
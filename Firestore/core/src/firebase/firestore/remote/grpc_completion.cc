@@ -16,15 +16,29 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/util/diagnostic_log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
+
 namespace firebase {
 namespace firestore {
 namespace remote {
 
 using util::AsyncQueue;
 
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+// Completions that sit in the worker queue for longer than this are logged, to
+// help spot when the worker queue, rather than the network, is the bottleneck.
+constexpr std::chrono::milliseconds kSlowCompletionThreshold{100};
+
+}  // namespace
+
 GrpcCompletion::GrpcCompletion(
     Type type,
     const std::shared_ptr<util::AsyncQueue>& worker_queue,
@@ -40,38 +54,121 @@ void GrpcCompletion::Cancel() {
 void GrpcCompletion::WaitUntilOffQueue() {
   worker_queue_->VerifyIsCurrentQueue();
 
-  EnsureValidFuture();
-  return off_queue_future_.wait();
+  std::unique_lock<std::mutex> lock{off_queue_mutex_};
+  off_queue_signal_.wait(lock, [this] { return off_queue_; });
 }
 
 std::future_status GrpcCompletion::WaitUntilOffQueue(
     std::chrono::milliseconds timeout) {
   worker_queue_->VerifyIsCurrentQueue();
 
-  EnsureValidFuture();
-  return off_queue_future_.wait_for(timeout);
-}
-
-void GrpcCompletion::EnsureValidFuture() {
-  if (!off_queue_future_.valid()) {
-    off_queue_future_ = off_queue_.get_future();
-  }
+  std::unique_lock<std::mutex> lock{off_queue_mutex_};
+  bool off_queue =
+      off_queue_signal_.wait_for(lock, timeout, [this] { return off_queue_; });
+  return off_queue ? std::future_status::ready : std::future_status::timeout;
 }
 
 void GrpcCompletion::Complete(bool ok) {
   // This mechanism allows `GrpcStream` to know when the completion is off the
   // gRPC completion queue (and thus no longer requires the underlying gRPC
   // objects to be valid).
-  off_queue_.set_value();
+  {
+    std::lock_guard<std::mutex> lock{off_queue_mutex_};
+    off_queue_ = true;
+  }
+  off_queue_signal_.notify_all();
+
+  clock::time_point completed_at = clock::now();
+  worker_queue_->Enqueue([this, ok, completed_at] {
+    auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(
+        clock::now() - completed_at);
+    if (delay > kSlowCompletionThreshold) {
+      LOG_DIAGNOSTIC(
+          "gRPC completion of type %s waited %s ms for the worker queue",
+          static_cast<int>(type_), delay.count());
+    }
 
-  worker_queue_->Enqueue([this, ok] {
     if (callback_) {
       callback_(ok, this);
     }
-    delete this;
+    Recycle();
   });
 }
 
+void GrpcCompletion::Recycle() {
+  if (pool_) {
+    // `Release` drops the completion's reference to the pool.
+    std::shared_ptr<GrpcCompletionPool> pool = pool_;
+    pool->Release(this);
+  } else {
+    delete this;
+  }
+}
+
+constexpr size_t GrpcCompletionPool::kDefaultMaxFreeCompletions;
+
+GrpcCompletionPool::GrpcCompletionPool(size_t max_free_completions)
+    : max_free_completions_{max_free_completions} {
+}
+
+GrpcCompletionPool::~GrpcCompletionPool() = default;
+
+GrpcCompletion* GrpcCompletionPool::Acquire(
+    GrpcCompletion::Type type,
+    const std::shared_ptr<AsyncQueue>& worker_queue,
+    GrpcCompletion::Callback&& callback) {
+  static util::Counter& allocated =
+      util::MetricsRegistry::Default().GetCounter(
+          "remote.grpc_completions_allocated");
+  static util::Counter& reused = util::MetricsRegistry::Default().GetCounter(
+      "remote.grpc_completions_reused");
+
+  std::unique_ptr<GrpcCompletion> completion;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (!free_.empty()) {
+      completion = std::move(free_.back());
+      free_.pop_back();
+    }
+  }
+
+  if (completion) {
+    reused.Increment();
+    completion->type_ = type;
+    completion->worker_queue_ = worker_queue;
+    completion->callback_ = std::move(callback);
+  } else {
+    allocated.Increment();
+    completion.reset(
+        new GrpcCompletion{type, worker_queue, std::move(callback)});
+  }
+  completion->pool_ = shared_from_this();
+  return completion.release();
+}
+
+size_t GrpcCompletionPool::free_count() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return free_.size();
+}
+
+void GrpcCompletionPool::Release(GrpcCompletion* completion) {
+  std::unique_ptr<GrpcCompletion> owned{completion};
+
+  // Drop whatever the completion holds on to right away, rather than when it's
+  // reused.
+  owned->callback_ = nullptr;
+  owned->worker_queue_.reset();
+  owned->pool_.reset();
+  owned->message_.Clear();
+  owned->status_ = grpc::Status{};
+  owned->off_queue_ = false;
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (free_.size() < max_free_completions_) {
+    free_.push_back(std::move(owned));
+  }
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
@@ -17,20 +17,26 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_COMPLETION_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_COMPLETION_H_
 
-#include <chrono>  // NOLINT(build/c++11)
-#include <functional>
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
 #include <future>  // NOLINT(build/c++11)
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/unique_function.h"
 #include "grpcpp/support/byte_buffer.h"
 
 namespace firebase {
 namespace firestore {
 namespace remote {
 
+class GrpcCompletionPool;
+
 /**
  * A completion for a gRPC asynchronous operation that runs an arbitrary
  * callback.
@@ -49,7 +55,8 @@ namespace remote {
  * gRPC operation.
  *
  * `GrpcCompletion` is "self-owned"; `GrpcCompletion` deletes itself in its
- * `Complete` method.
+ * `Complete` method, or, if it was acquired from a `GrpcCompletionPool`,
+ * returns itself to the pool.
  *
  * `GrpcCompletion` expects all gRPC objects pertaining to the current stream to
  * remain valid until the `GrpcCompletion` comes back from the gRPC completion
@@ -69,12 +76,15 @@ class GrpcCompletion {
    *
    * The `GrpcCompletion` pointer will always point to `this`.
    */
-  using Callback = std::function<void(bool, const GrpcCompletion*)>;
+  using Callback = util::UniqueFunction<void(bool, const GrpcCompletion*)>;
 
   GrpcCompletion(Type type,
                  const std::shared_ptr<util::AsyncQueue>& worker_queue,
                  Callback&& callback);
 
+  GrpcCompletion(const GrpcCompletion&) = delete;
+  GrpcCompletion& operator=(const GrpcCompletion&) = delete;
+
   /**
    * Marks the `GrpcCompletion` as having come back from the gRPC completion
    * queue and puts notifying the observing stream on the Firestore async queue.
@@ -115,10 +125,16 @@ class GrpcCompletion {
   }
 
  private:
+  friend class GrpcCompletionPool;
+
+  // Deletes this completion, or returns it to the pool it came from.
+  void Recycle();
+
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   Callback callback_;
-
-  void EnsureValidFuture();
+  // Only set while the completion is in use; free completions don't keep the
+  // pool alive.
+  std::shared_ptr<GrpcCompletionPool> pool_;
 
   // Note that even though `grpc::GenericClientAsyncReaderWriter::Write` takes
   // the byte buffer by const reference, it expects the buffer's lifetime to
@@ -128,12 +144,62 @@ class GrpcCompletion {
   grpc::ByteBuffer message_;
   grpc::Status status_;
 
-  std::promise<void> off_queue_;
-  std::future<void> off_queue_future_;
+  // Unlike a promise, these can be reset when the completion is reused.
+  std::mutex off_queue_mutex_;
+  std::condition_variable off_queue_signal_;
+  bool off_queue_ = false;
 
   Type type_{};
 };
 
+/**
+ * A free list of `GrpcCompletion`s, shared by the streams and calls of
+ * a `GrpcConnection`, so that reading or writing a message reuses the
+ * completion (and the buffer it reads messages into) of a previous operation
+ * instead of allocating a new one.
+ *
+ * Completions acquired from the pool keep it alive until they come back to it,
+ * so the pool may be released before all its completions are done.
+ *
+ * The number of completions allocated and reused are reported as the
+ * "remote.grpc_completions_allocated" and "remote.grpc_completions_reused"
+ * counters of the default `MetricsRegistry`.
+ */
+class GrpcCompletionPool
+    : public std::enable_shared_from_this<GrpcCompletionPool> {
+ public:
+  /**
+   * The default number of free completions kept, which covers the operations
+   * in flight on a few streams at once.
+   */
+  static constexpr size_t kDefaultMaxFreeCompletions = 32;
+
+  explicit GrpcCompletionPool(
+      size_t max_free_completions = kDefaultMaxFreeCompletions);
+  ~GrpcCompletionPool();
+
+  /**
+   * Returns a completion like `new GrpcCompletion{...}` would, reusing a free
+   * one if possible.
+   */
+  GrpcCompletion* Acquire(GrpcCompletion::Type type,
+                          const std::shared_ptr<util::AsyncQueue>& worker_queue,
+                          GrpcCompletion::Callback&& callback);
+
+  size_t free_count() const;
+
+ private:
+  friend class GrpcCompletion;
+
+  // Takes back a completion that has finished, deleting it if the pool is
+  // full.
+  void Release(GrpcCompletion* completion);
+
+  const size_t max_free_completions_ = 0;
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<GrpcCompletion>> free_;
+};
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
@@ -50,6 +50,11 @@ namespace {
 const char* const kXGoogAPIClientHeader = "x-goog-api-client";
 const char* const kGoogleCloudResourcePrefix = "google-cloud-resource-prefix";
 
+// gRPC reuses connections between channels created with identical arguments.
+// Channels other than the first carry this otherwise meaningless argument to
+// make sure they get a connection of their own.
+const char* const kChannelIndexArg = "firestore.channel_index";
+
 std::string MakeString(absl::string_view view) {
   return view.data() ? std::string{view.data(), view.size()} : std::string{};
 }
@@ -124,10 +129,14 @@ GrpcConnection::GrpcConnection(
     const DatabaseInfo& database_info,
     const std::shared_ptr<util::AsyncQueue>& worker_queue,
     grpc::CompletionQueue* grpc_queue,
-    ConnectivityMonitor* connectivity_monitor)
+    ConnectivityMonitor* connectivity_monitor,
+    bool separate_watch_channel,
+    grpc::CompletionQueue* watch_grpc_queue)
     : database_info_{&database_info},
       worker_queue_{NOT_NULL(worker_queue)},
       grpc_queue_{NOT_NULL(grpc_queue)},
+      watch_grpc_queue_{watch_grpc_queue ? watch_grpc_queue : grpc_queue},
+      separate_watch_channel_{separate_watch_channel},
       connectivity_monitor_{NOT_NULL(connectivity_monitor)} {
   RegisterConnectivityMonitor();
 }
@@ -172,25 +181,69 @@ std::unique_ptr<grpc::ClientContext> GrpcConnection::CreateContext(
   return context;
 }
 
-void GrpcConnection::EnsureActiveStub() {
+size_t GrpcConnection::ApplyCompression(grpc::ClientContext* context) const {
+  switch (compression_policy_.algorithm) {
+    case CompressionPolicy::Algorithm::None:
+      return 0;
+    case CompressionPolicy::Algorithm::Gzip:
+      context->set_compression_algorithm(GRPC_COMPRESS_GZIP);
+      break;
+    case CompressionPolicy::Algorithm::Deflate:
+      context->set_compression_algorithm(GRPC_COMPRESS_DEFLATE);
+      break;
+  }
+  return compression_policy_.min_message_bytes;
+}
+
+grpc::GenericStub* GrpcConnection::EnsureActiveStub(StreamKind kind) {
+  size_t index = separate_watch_channel_ && kind == StreamKind::Watch ? 1 : 0;
+  ChannelAndStub& entry = channels_[index];
+
   // TODO(varconst): find out in which cases a gRPC channel might shut down.
   // This might be overkill.
-  if (!grpc_channel_ || grpc_channel_->GetState(/*try_to_connect=*/false) ==
+  if (!entry.channel || entry.channel->GetState(/*try_to_connect=*/false) ==
                             GRPC_CHANNEL_SHUTDOWN) {
     LOG_DEBUG("Creating Firestore stub.");
-    grpc_channel_ = CreateChannel();
-    grpc_stub_ = absl::make_unique<grpc::GenericStub>(grpc_channel_);
+    entry.channel = CreateOrShareChannel(index);
+    entry.stub = absl::make_unique<grpc::GenericStub>(entry.channel);
   }
+  return entry.stub.get();
 }
 
-std::shared_ptr<grpc::Channel> GrpcConnection::CreateChannel() const {
+std::shared_ptr<grpc::Channel> GrpcConnection::CreateOrShareChannel(
+    size_t index) const {
+  if (!shared_runtime_) {
+    return CreateChannel(index);
+  }
+
+  // Channels only differ by host, index and keepalive arguments, so those
+  // identify the channels that can be shared.
+  std::string key = StringFormat("%s|%s|%s", database_info_->host(), index,
+                                 keepalive_policy_.Hash());
+  return shared_runtime_->FindOrCreateChannel(
+      key, [this, index] { return CreateChannel(index); });
+}
+
+std::shared_ptr<grpc::Channel> GrpcConnection::CreateChannel(
+    size_t index) const {
   const std::string& host = database_info_->host();
 
   grpc::ChannelArguments args;
   // Ensure gRPC recovers from a dead connection. (Not typically necessary, as
   // the OS will usually notify gRPC when a connection dies. But not always.
-  // This acts as a failsafe.)
-  args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS, 30 * 1000);
+  // This acts as a failsafe.) Pings also keep idle streams from being dropped
+  // by the network between the client and the backend.
+  args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS,
+              static_cast<int>(keepalive_policy_.time.count()));
+  args.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS,
+              static_cast<int>(keepalive_policy_.timeout.count()));
+  args.SetInt(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA,
+              keepalive_policy_.max_pings_without_data);
+  args.SetInt(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS,
+              keepalive_policy_.permit_without_calls ? 1 : 0);
+  if (index > 0) {
+    args.SetInt(kChannelIndexArg, static_cast<int>(index));
+  }
 
   const HostConfig* host_config = Config().find(host);
   if (!host_config) {
@@ -220,26 +273,31 @@ std::shared_ptr<grpc::Channel> GrpcConnection::CreateChannel() const {
 
 std::unique_ptr<GrpcStream> GrpcConnection::CreateStream(
     absl::string_view rpc_name,
+    StreamKind kind,
     const Token& token,
     GrpcStreamObserver* observer) {
-  EnsureActiveStub();
+  grpc::GenericStub* stub = EnsureActiveStub(kind);
+  grpc::CompletionQueue* queue =
+      kind == StreamKind::Watch ? watch_grpc_queue_ : grpc_queue_;
 
   auto context = CreateContext(token);
-  auto call =
-      grpc_stub_->PrepareCall(context.get(), MakeString(rpc_name), grpc_queue_);
-  return absl::make_unique<GrpcStream>(std::move(context), std::move(call),
-                                       worker_queue_, this, observer);
+  size_t min_compressed_bytes = ApplyCompression(context.get());
+  auto call = stub->PrepareCall(context.get(), MakeString(rpc_name), queue);
+  auto result = absl::make_unique<GrpcStream>(
+      std::move(context), std::move(call), worker_queue_, this, observer);
+  result->set_min_compressed_message_bytes(min_compressed_bytes);
+  return result;
 }
 
 std::unique_ptr<GrpcUnaryCall> GrpcConnection::CreateUnaryCall(
     absl::string_view rpc_name,
     const Token& token,
     const grpc::ByteBuffer& message) {
-  EnsureActiveStub();
+  grpc::GenericStub* stub = EnsureActiveStub(StreamKind::Write);
 
   auto context = CreateContext(token);
-  auto call = grpc_stub_->PrepareUnaryCall(context.get(), MakeString(rpc_name),
-                                           message, grpc_queue_);
+  auto call = stub->PrepareUnaryCall(context.get(), MakeString(rpc_name),
+                                     message, grpc_queue_);
   return absl::make_unique<GrpcUnaryCall>(std::move(context), std::move(call),
                                           worker_queue_, this, message);
 }
@@ -248,18 +306,35 @@ std::unique_ptr<GrpcStreamingReader> GrpcConnection::CreateStreamingReader(
     absl::string_view rpc_name,
     const Token& token,
     const grpc::ByteBuffer& message) {
-  EnsureActiveStub();
+  grpc::GenericStub* stub = EnsureActiveStub(StreamKind::Write);
 
   auto context = CreateContext(token);
+  size_t min_compressed_bytes = ApplyCompression(context.get());
   auto call =
-      grpc_stub_->PrepareCall(context.get(), MakeString(rpc_name), grpc_queue_);
-  return absl::make_unique<GrpcStreamingReader>(
+      stub->PrepareCall(context.get(), MakeString(rpc_name), grpc_queue_);
+  auto result = absl::make_unique<GrpcStreamingReader>(
       std::move(context), std::move(call), worker_queue_, this, message);
+  result->set_min_compressed_message_bytes(min_compressed_bytes);
+  return result;
+}
+
+void GrpcConnection::PrewarmChannels() {
+  LOG_DEBUG("Prewarming Firestore channels.");
+  EnsureActiveStub(StreamKind::Write);
+  if (separate_watch_channel_) {
+    EnsureActiveStub(StreamKind::Watch);
+  }
+
+  for (ChannelAndStub& entry : channels_) {
+    if (entry.channel) {
+      entry.channel->GetState(/*try_to_connect=*/true);
+    }
+  }
 }
 
 void GrpcConnection::RegisterConnectivityMonitor() {
   connectivity_monitor_->AddCallback(
-      [this](ConnectivityMonitor::NetworkStatus /*ignored*/) {
+      [this](ConnectivityMonitor::NetworkStatus status) {
         // Calls may unregister themselves on finish, so make a protective copy.
         auto calls = active_calls_;
         for (GrpcCall* call : calls) {
@@ -271,8 +346,21 @@ void GrpcConnection::RegisterConnectivityMonitor() {
         // connection before eventually failing. Note that gRPC Objective-C
         // client does the same thing:
         // https://github.com/grpc/grpc/blob/fe11db09575f2dfbe1f88cd44bd417acc168e354/src/objective-c/GRPCClient/private/GRPCHost.m#L309-L314
-        grpc_channel_.reset();
+        for (ChannelAndStub& entry : channels_) {
+          entry.channel.reset();
+        }
+
+        // Streams restarted by the observers above first fetch a token, which
+        // the new connection's handshakes can overlap with.
+        if (status != ConnectivityMonitor::NetworkStatus::Unavailable) {
+          PrewarmChannels();
+          for (auto& callback : network_available_callbacks_) {
+            callback();
+          }
+        }
       });
+
+  connectivity_monitor_->AddForegroundCallback([this] { PrewarmChannels(); });
 }
 
 void GrpcConnection::Register(GrpcCall* call) {
@@ -17,21 +17,28 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_CONNECTION_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_CONNECTION_H_
 
+#include <array>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/warnings.h"
 
 #include "Firestore/core/src/firebase/firestore/auth/token.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/remote/compression_policy.h"
 #include "Firestore/core/src/firebase/firestore/remote/connectivity_monitor.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_call.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_runtime.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_stream_observer.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_streaming_reader.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_unary_call.h"
+#include "Firestore/core/src/firebase/firestore/remote/keepalive_policy.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "absl/strings/string_view.h"
 #include "grpcpp/channel.h"
@@ -52,13 +59,28 @@ namespace remote {
 /**
  * Creates and owns gRPC objects (channel and stub) necessary to produce a
  * `GrpcStream`.
+ *
+ * By default, all streams and calls share a single channel, and thus a single
+ * HTTP/2 connection. If `separate_watch_channel` is true, the watch stream
+ * gets a channel of its own, so that a large snapshot being streamed down
+ * doesn't hold up writes and lookups behind it. Likewise, if
+ * `watch_grpc_queue` is given, the watch stream's operations complete on that
+ * queue rather than on `grpc_queue`, so that each can be polled separately.
  */
 class GrpcConnection {
  public:
+  /** Identifies the kind of traffic a stream carries. */
+  enum class StreamKind {
+    Watch,
+    Write,
+  };
+
   GrpcConnection(const core::DatabaseInfo& database_info,
                  const std::shared_ptr<util::AsyncQueue>& worker_queue,
                  grpc::CompletionQueue* grpc_queue,
-                 ConnectivityMonitor* connectivity_monitor);
+                 ConnectivityMonitor* connectivity_monitor,
+                 bool separate_watch_channel = false,
+                 grpc::CompletionQueue* watch_grpc_queue = nullptr);
 
   void Shutdown();
 
@@ -69,9 +91,11 @@ class GrpcConnection {
   // PORTING NOTE: unlike Web client, the created stream is not open and has to
   // be started manually.
   std::unique_ptr<GrpcStream> CreateStream(absl::string_view rpc_name,
+                                           StreamKind kind,
                                            const auth::Token& token,
                                            GrpcStreamObserver* observer);
 
+  /** Unary calls and streaming reads travel with write traffic. */
   std::unique_ptr<GrpcUnaryCall> CreateUnaryCall(
       absl::string_view rpc_name,
       const auth::Token& token,
@@ -85,6 +109,53 @@ class GrpcConnection {
   void Register(GrpcCall* call);
   void Unregister(GrpcCall* call);
 
+  /** The completions that the streams and calls of this connection reuse. */
+  const std::shared_ptr<GrpcCompletionPool>& completion_pool() const {
+    return completion_pool_;
+  }
+
+  /**
+   * Starts connecting the channels that streams and calls will use, so that
+   * the TLS and HTTP/2 handshakes can proceed while streams wait for tokens.
+   * Called whenever the network comes back or the app returns to the
+   * foreground.
+   */
+  void PrewarmChannels();
+
+  /**
+   * Adds a callback invoked on the worker queue whenever the network becomes
+   * available again, once the calls that were active when it changed have been
+   * finished.
+   */
+  void AddNetworkAvailableCallback(std::function<void()>&& callback) {
+    network_available_callbacks_.push_back(std::move(callback));
+  }
+
+  /**
+   * Sets how the channels ping the backend. Only affects channels created
+   * afterwards, so should be called before creating any streams or calls.
+   */
+  void set_keepalive_policy(const KeepalivePolicy& policy) {
+    keepalive_policy_ = policy;
+  }
+
+  /**
+   * Sets how the messages sent on the watch and write streams and in document
+   * lookups are compressed. Only affects streams and calls created afterwards.
+   */
+  void set_compression_policy(const CompressionPolicy& policy) {
+    compression_policy_ = policy;
+  }
+
+  /**
+   * Makes the connection take its channels from the pool of `runtime`, so that
+   * connections to the same host share them. Call before creating any streams
+   * or calls.
+   */
+  void set_shared_runtime(GrpcRuntime* runtime) {
+    shared_runtime_ = runtime;
+  }
+
   /**
    * Don't use SSL, send all traffic unencrypted. Call before creating any
    * streams or calls.
@@ -102,20 +173,37 @@ class GrpcConnection {
  private:
   std::unique_ptr<grpc::ClientContext> CreateContext(
       const auth::Token& credential) const;
-  std::shared_ptr<grpc::Channel> CreateChannel() const;
-  void EnsureActiveStub();
+  struct ChannelAndStub {
+    std::shared_ptr<grpc::Channel> channel;
+    std::unique_ptr<grpc::GenericStub> stub;
+  };
+
+  // Returns the minimum size of the messages to compress, if the call using
+  // `context` should compress messages.
+  size_t ApplyCompression(grpc::ClientContext* context) const;
+
+  std::shared_ptr<grpc::Channel> CreateChannel(size_t index) const;
+  std::shared_ptr<grpc::Channel> CreateOrShareChannel(size_t index) const;
+  grpc::GenericStub* EnsureActiveStub(StreamKind kind);
 
   void RegisterConnectivityMonitor();
 
   const core::DatabaseInfo* database_info_ = nullptr;
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   grpc::CompletionQueue* grpc_queue_ = nullptr;
+  grpc::CompletionQueue* watch_grpc_queue_ = nullptr;
 
-  std::shared_ptr<grpc::Channel> grpc_channel_;
-  std::unique_ptr<grpc::GenericStub> grpc_stub_;
+  bool separate_watch_channel_ = false;
+  std::array<ChannelAndStub, 2> channels_;
+  KeepalivePolicy keepalive_policy_;
+  CompressionPolicy compression_policy_;
+  GrpcRuntime* shared_runtime_ = nullptr;
+  std::shared_ptr<GrpcCompletionPool> completion_pool_ =
+      std::make_shared<GrpcCompletionPool>();
 
   ConnectivityMonitor* connectivity_monitor_ = nullptr;
   std::vector<GrpcCall*> active_calls_;
+  std::vector<std::function<void()>> network_available_callbacks_;
 };
 
 }  // namespace remote
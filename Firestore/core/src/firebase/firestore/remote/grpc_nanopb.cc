@@ -0,0 +1,83 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_nanopb.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_util.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using util::Status;
+
+ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer)
+    : reader_{MakeStream(buffer.Length())} {
+  grpc::Status status = buffer.Dump(&slices_);
+  if (!status.ok()) {
+    Status error{Error::Internal,
+                 "Trying to convert an invalid grpc::ByteBuffer"};
+    error.CausedBy(ConvertStatus(status));
+    reader_.set_status(error);
+  }
+}
+
+pb_istream_t ByteBufferReader::MakeStream(size_t length) {
+  pb_istream_t stream{};
+  stream.callback = &ByteBufferReader::Read;
+  stream.state = this;
+  stream.bytes_left = length;
+  return stream;
+}
+
+bool ByteBufferReader::Read(pb_istream_t* stream,
+                            pb_byte_t* buf,
+                            size_t count) {
+  auto* self = static_cast<ByteBufferReader*>(stream->state);
+
+  while (count > 0) {
+    if (self->slice_index_ == self->slices_.size()) {
+      return false;
+    }
+
+    const grpc::Slice& slice = self->slices_[self->slice_index_];
+    size_t available = slice.size() - self->slice_offset_;
+    size_t chunk = std::min(available, count);
+
+    // nanopb passes a null buffer when skipping over bytes.
+    if (buf != nullptr) {
+      std::memcpy(buf, slice.begin() + self->slice_offset_, chunk);
+      buf += chunk;
+    }
+    count -= chunk;
+
+    self->slice_offset_ += chunk;
+    if (self->slice_offset_ == slice.size()) {
+      ++self->slice_index_;
+      self->slice_offset_ = 0;
+    }
+  }
+  return true;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_NANOPB_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_NANOPB_H_
+
+#include <pb.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A `nanopb::Reader` over the contents of a `grpc::ByteBuffer`.
+ *
+ * The reader consumes the buffer's slices in place rather than first
+ * flattening them into a contiguous copy, so a large message received from
+ * the network is only copied when individual fields are decoded out of it.
+ *
+ * The slices are referenced, not copied, so the memory stays valid for the
+ * lifetime of this object even if the `ByteBuffer` is destroyed.
+ */
+class ByteBufferReader {
+ public:
+  explicit ByteBufferReader(const grpc::ByteBuffer& buffer);
+
+  ByteBufferReader(const ByteBufferReader&) = delete;
+  ByteBufferReader& operator=(const ByteBufferReader&) = delete;
+
+  nanopb::Reader* reader() {
+    return &reader_;
+  }
+
+ private:
+  /** Implements the `pb_istream_t` callback, copying `count` bytes to `buf`. */
+  static bool Read(pb_istream_t* stream, pb_byte_t* buf, size_t count);
+
+  pb_istream_t MakeStream(size_t length);
+
+  std::vector<grpc::Slice> slices_;
+  size_t slice_index_ = 0;
+  size_t slice_offset_ = 0;
+
+  nanopb::Reader reader_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_NANOPB_H_
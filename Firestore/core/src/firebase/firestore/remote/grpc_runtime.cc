@@ -0,0 +1,69 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_runtime.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+GrpcRuntime::GrpcRuntime(std::unique_ptr<util::Executor> poller)
+    : poller_{std::move(poller)} {
+  poller_->Execute([this] { PollGrpcQueue(); });
+}
+
+GrpcRuntime::~GrpcRuntime() {
+  // `grpc::CompletionQueue::Next` only returns `false` once `Shutdown` has been
+  // called and all submitted tags have been extracted.
+  grpc_queue_.Shutdown();
+  poller_->ExecuteBlocking([] {});
+}
+
+std::shared_ptr<grpc::Channel> GrpcRuntime::FindOrCreateChannel(
+    const std::string& key,
+    const std::function<std::shared_ptr<grpc::Channel>()>& create) {
+  std::lock_guard<std::mutex> lock{mutex_};
+
+  std::weak_ptr<grpc::Channel>& entry = channels_[key];
+  std::shared_ptr<grpc::Channel> channel = entry.lock();
+  if (!channel ||
+      channel->GetState(/*try_to_connect=*/false) == GRPC_CHANNEL_SHUTDOWN) {
+    channel = create();
+    entry = channel;
+  }
+  return channel;
+}
+
+void GrpcRuntime::PollGrpcQueue() {
+  HARD_ASSERT(poller_->IsCurrentExecutor(),
+              "PollGrpcQueue should only be called on the polling executor");
+
+  void* tag = nullptr;
+  bool ok = false;
+  while (grpc_queue_.Next(&tag, &ok)) {
+    HARD_ASSERT(tag, "gRPC queue returned a null tag");
+    static_cast<GrpcCompletion*>(tag)->Complete(ok);
+  }
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_RUNTIME_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_RUNTIME_H_
+
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "grpcpp/channel.h"
+#include "grpcpp/completion_queue.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * gRPC resources shared by the `Datastore`s of several Firestore instances: a
+ * completion queue along with the executor that polls it, and a pool of
+ * channels, so that instances talking to the same host don't each need a
+ * polling thread and a connection of their own.
+ *
+ * Completed operations are still handed to the worker queue of the instance
+ * that started them, so instances don't block each other beyond the polling
+ * itself.
+ */
+class GrpcRuntime {
+ public:
+  /** Starts polling the completion queue on `poller`. */
+  explicit GrpcRuntime(std::unique_ptr<util::Executor> poller);
+
+  /**
+   * Shuts down the completion queue and waits until it is drained. All calls
+   * made through the runtime must have finished by then.
+   */
+  ~GrpcRuntime();
+
+  grpc::CompletionQueue* grpc_queue() {
+    return &grpc_queue_;
+  }
+
+  /**
+   * Returns the channel last created for `key`, as long as some connection
+   * still uses it and it hasn't shut down; otherwise, creates a new one with
+   * `create`. Connections that would create identical channels should use the
+   * same key.
+   */
+  std::shared_ptr<grpc::Channel> FindOrCreateChannel(
+      const std::string& key,
+      const std::function<std::shared_ptr<grpc::Channel>()>& create);
+
+  GrpcRuntime(const GrpcRuntime&) = delete;
+  GrpcRuntime& operator=(const GrpcRuntime&) = delete;
+
+ private:
+  void PollGrpcQueue();
+
+  std::unique_ptr<util::Executor> poller_;
+  grpc::CompletionQueue grpc_queue_;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::weak_ptr<grpc::Channel>> channels_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_RUNTIME_H_
@@ -21,7 +21,7 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_util.h"
-#include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/diagnostic_log.h"
 
 namespace firebase {
 namespace firestore {
@@ -43,8 +43,8 @@ using Type = GrpcCompletion::Type;
 //
 // `GrpcStream` owns the gRPC objects (such as `grpc::ClientContext`) that must
 // be valid until all `GrpcCompletion`s issued by this stream come back from the
-// gRPC completion queue. `GrpcCompletion`s contain an `std::promise` that is
-// fulfilled once the completion is taken off the gRPC completion queue, and
+// gRPC completion queue. `GrpcCompletion`s are signaled once the completion is
+// taken off the gRPC completion queue, and
 // `GrpcCompletion::WaitUntilOffQueue` allows blocking on this. `GrpcStream`
 // holds non-owning pointers to all the completions that it issued (and removes
 // pointers to completions once they ran). `GrpcStream::Finish` and
@@ -69,6 +69,12 @@ absl::optional<BufferedWrite> BufferedWriter::TryStartWrite() {
   has_active_write_ = true;
   BufferedWrite message = std::move(queue_.front());
   queue_.pop();
+
+  // Another write is certain to follow this one, so there's no need to flush
+  // this one on its own.
+  if (!queue_.empty()) {
+    message.options.set_buffer_hint();
+  }
   return std::move(message);
 }
 
@@ -92,12 +98,13 @@ GrpcStream::GrpcStream(
       call_{std::move(NOT_NULL(call))},
       worker_queue_{NOT_NULL(worker_queue)},
       grpc_connection_{NOT_NULL(grpc_connection)},
+      completion_pool_{grpc_connection->completion_pool()},
       observer_{NOT_NULL(observer)} {
   grpc_connection_->Register(this);
 }
 
 GrpcStream::~GrpcStream() {
-  LOG_DEBUG("GrpcStream('%s'): destroying stream", this);
+  LOG_DIAGNOSTIC("GrpcStream('%s'): destroying stream", this);
   HARD_ASSERT(completions_.empty(),
               "GrpcStream is being destroyed without proper shutdown");
   MaybeUnregister();
@@ -135,15 +142,27 @@ void GrpcStream::Read() {
 }
 
 void GrpcStream::Write(grpc::ByteBuffer&& message) {
-  MaybeWrite(buffered_writer_.EnqueueWrite(std::move(message)));
+  grpc::WriteOptions options = MakeWriteOptions(message);
+  MaybeWrite(buffered_writer_.EnqueueWrite(std::move(message), options));
 }
 
 void GrpcStream::WriteLast(grpc::ByteBuffer&& message) {
-  grpc::WriteOptions options;
+  grpc::WriteOptions options = MakeWriteOptions(message);
   options.set_last_message();
   MaybeWrite(buffered_writer_.EnqueueWrite(std::move(message), options));
 }
 
+grpc::WriteOptions GrpcStream::MakeWriteOptions(
+    const grpc::ByteBuffer& message) const {
+  grpc::WriteOptions options;
+  // Compressing small messages costs more time than sending the few bytes
+  // saved.
+  if (message.Length() < min_compressed_message_bytes_) {
+    options.set_no_compression();
+  }
+  return options;
+}
+
 void GrpcStream::MaybeWrite(absl::optional<BufferedWrite> maybe_write) {
   if (!maybe_write) {
     return;
@@ -158,14 +177,15 @@ void GrpcStream::MaybeWrite(absl::optional<BufferedWrite> maybe_write) {
 }
 
 void GrpcStream::FinishImmediately() {
-  LOG_DEBUG("GrpcStream('%s'): finishing without notifying observers", this);
+  LOG_DIAGNOSTIC("GrpcStream('%s'): finishing without notifying observers",
+                 this);
 
   Shutdown();
   UnsetObserver();
 }
 
 void GrpcStream::FinishAndNotify(const Status& status) {
-  LOG_DEBUG("GrpcStream('%s'): finishing and notifying observers", this);
+  LOG_DIAGNOSTIC("GrpcStream('%s'): finishing and notifying observers", this);
 
   Shutdown();
 
@@ -179,8 +199,9 @@ void GrpcStream::FinishAndNotify(const Status& status) {
 }
 
 void GrpcStream::Shutdown() {
-  LOG_DEBUG("GrpcStream('%s'): shutting down; completions: %s, is finished: %s",
-            this, completions_.size(), is_grpc_call_finished_);
+  LOG_DIAGNOSTIC(
+      "GrpcStream('%s'): shutting down; completions: %s, is finished: %s",
+      this, completions_.size(), is_grpc_call_finished_);
 
   MaybeUnregister();
 
@@ -214,7 +235,7 @@ void GrpcStream::MaybeUnregister() {
 }
 
 void GrpcStream::FinishGrpcCall(const OnSuccess& callback) {
-  LOG_DEBUG("GrpcStream('%s'): finishing the underlying call", this);
+  LOG_DIAGNOSTIC("GrpcStream('%s'): finishing the underlying call", this);
 
   HARD_ASSERT(!is_grpc_call_finished_, "FinishGrpcCall called twice");
   is_grpc_call_finished_ = true;
@@ -227,8 +248,8 @@ void GrpcStream::FinishGrpcCall(const OnSuccess& callback) {
 }
 
 void GrpcStream::FastFinishCompletionsBlocking() {
-  LOG_DEBUG("GrpcStream('%s'): fast finishing %s completion(s)", this,
-            completions_.size());
+  LOG_DIAGNOSTIC("GrpcStream('%s'): fast finishing %s completion(s)", this,
+                 completions_.size());
 
   // TODO(varconst): reset buffered_writer_? Should not be necessary, because it
   // should never be called again after a call to Finish.
@@ -256,8 +277,9 @@ bool GrpcStream::WriteAndFinish(grpc::ByteBuffer&& message) {
 }
 
 bool GrpcStream::TryLastWrite(grpc::ByteBuffer&& message) {
+  grpc::WriteOptions options = MakeWriteOptions(message);
   absl::optional<BufferedWrite> maybe_write =
-      buffered_writer_.EnqueueWrite(std::move(message));
+      buffered_writer_.EnqueueWrite(std::move(message), options);
   // Only bother with the last write if there is no active write at the moment.
   if (!maybe_write) {
     return false;
@@ -266,7 +288,7 @@ bool GrpcStream::TryLastWrite(grpc::ByteBuffer&& message) {
   BufferedWrite last_write = std::move(maybe_write).value();
   GrpcCompletion* completion = NewCompletion(Type::Write, {});
   *completion->message() = last_write.message;
-  call_->WriteLast(*completion->message(), grpc::WriteOptions{}, completion);
+  call_->WriteLast(*completion->message(), last_write.options, completion);
 
   // Empirically, the write normally takes less than a millisecond to finish
   // (both with and without network connection), and never more than several
@@ -336,15 +358,15 @@ GrpcCompletion* GrpcStream::NewCompletion(Type tag,
         } else {
           // Use the same error-handling for all operations; all errors are
           // unrecoverable.
-          LOG_DEBUG("GrpcStream('%s'): operation of type %s failed", this,
-                    completion->type());
+          LOG_DIAGNOSTIC("GrpcStream('%s'): operation of type %s failed",
+                         this, completion->type());
           OnOperationFailed();
         }
       };
 
   // For lifetime details, see `GrpcCompletion` class comment.
   auto* completion =
-      new GrpcCompletion{tag, worker_queue_, std::move(decorated)};
+      completion_pool_->Acquire(tag, worker_queue_, std::move(decorated));
   completions_.push_back(completion);
   return completion;
 }
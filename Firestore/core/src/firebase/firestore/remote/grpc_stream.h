@@ -69,6 +69,12 @@ struct BufferedWrite {
  *
  * `BufferedWriter` does not store any of the operations it creates.
  *
+ * When more writes are queued behind the one being made active, the active
+ * write is issued with a buffer hint, which lets gRPC hold on to it and send
+ * it out together with the writes that follow instead of flushing each one to
+ * the wire separately. The last write of such a burst doesn't carry the hint
+ * and flushes all of them.
+ *
  * This class exists to help Firestore streams adhere to the gRPC requirement
  * that only one write operation may be active at any given time.
  */
@@ -169,6 +175,14 @@ class GrpcStream : public GrpcCall {
     return observer_ == nullptr;
   }
 
+  /**
+   * If the call compresses messages, sends the ones smaller than `bytes`
+   * uncompressed anyway. Call before the stream is started.
+   */
+  void set_min_compressed_message_bytes(size_t bytes) {
+    min_compressed_message_bytes_ = bytes;
+  }
+
   /**
    * Returns the metadata received from the server.
    *
@@ -185,6 +199,7 @@ class GrpcStream : public GrpcCall {
   void Read();
   void MaybeWrite(absl::optional<internal::BufferedWrite> maybe_write);
   bool TryLastWrite(grpc::ByteBuffer&& message);
+  grpc::WriteOptions MakeWriteOptions(const grpc::ByteBuffer& message) const;
 
   void Shutdown();
   void UnsetObserver() {
@@ -231,12 +246,16 @@ class GrpcStream : public GrpcCall {
 
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   GrpcConnection* grpc_connection_ = nullptr;
+  // Outlives `grpc_connection_`, which is unset once the stream is finished.
+  std::shared_ptr<GrpcCompletionPool> completion_pool_;
 
   GrpcStreamObserver* observer_ = nullptr;
   internal::BufferedWriter buffered_writer_;
 
   std::vector<GrpcCompletion*> completions_;
 
+  size_t min_compressed_message_bytes_ = 0;
+
   // gRPC asserts that a call is finished exactly once.
   bool is_grpc_call_finished_ = false;
 };
@@ -44,7 +44,25 @@ GrpcStreamingReader::GrpcStreamingReader(
 }
 
 void GrpcStreamingReader::Start(Callback&& callback) {
-  callback_ = std::move(callback);
+  // TODO(c++14): move into lambda.
+  Start(
+      [this](const grpc::ByteBuffer& message) {
+        // Accumulate responses
+        responses_.push_back(message);
+      },
+      [this, callback](const Status& status) {
+        if (status.ok()) {
+          callback(responses_);
+        } else {
+          callback(status);
+        }
+      });
+}
+
+void GrpcStreamingReader::Start(MessageCallback&& on_message,
+                                FinishCallback&& on_finish) {
+  on_message_ = std::move(on_message);
+  on_finish_ = std::move(on_finish);
   stream_->Start();
 }
 
@@ -63,20 +81,16 @@ void GrpcStreamingReader::OnStreamStart() {
 }
 
 void GrpcStreamingReader::OnStreamRead(const grpc::ByteBuffer& message) {
-  // Accumulate responses
-  responses_.push_back(message);
+  on_message_(message);
 }
 
 void GrpcStreamingReader::OnStreamFinish(const util::Status& status) {
-  HARD_ASSERT(callback_,
+  HARD_ASSERT(on_finish_,
               "Received an event from stream after callback was unset");
   // Invoking the callback may end this reader's lifetime.
-  auto callback = std::move(callback_);
-  if (status.ok()) {
-    callback(responses_);
-  } else {
-    callback(status);
-  }
+  auto on_finish = std::move(on_finish_);
+  on_message_ = {};
+  on_finish(status);
 }
 
 }  // namespace remote
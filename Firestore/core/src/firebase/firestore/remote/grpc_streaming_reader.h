@@ -42,12 +42,15 @@ class GrpcConnection;
 
 /**
  * Sends a single request to the server, reads one or more streaming server
- * responses, and invokes the given callback with the accumulated responses.
+ * responses, and either invokes the given callback with the accumulated
+ * responses or hands over each response as soon as it arrives.
  */
 class GrpcStreamingReader : public GrpcCall, public GrpcStreamObserver {
  public:
   using ResponsesT = std::vector<grpc::ByteBuffer>;
   using Callback = std::function<void(const util::StatusOr<ResponsesT>&)>;
+  using MessageCallback = std::function<void(const grpc::ByteBuffer&)>;
+  using FinishCallback = std::function<void(const util::Status&)>;
 
   GrpcStreamingReader(
       std::unique_ptr<grpc::ClientContext> context,
@@ -63,6 +66,14 @@ class GrpcStreamingReader : public GrpcCall, public GrpcStreamObserver {
    */
   void Start(Callback&& callback);
 
+  /**
+   * Starts the call without accumulating the results: `on_message` will be
+   * invoked with each response as it arrives, and `on_finish` will be invoked
+   * once the call finishes, successfully or not. `on_message` must not destroy
+   * this `GrpcStreamingReader`; `on_finish` may.
+   */
+  void Start(MessageCallback&& on_message, FinishCallback&& on_finish);
+
   /**
    * If the call is in progress, attempts to cancel the call; otherwise, it's
    * a no-op. Cancellation is done on best-effort basis; however:
@@ -77,6 +88,11 @@ class GrpcStreamingReader : public GrpcCall, public GrpcStreamObserver {
 
   void FinishAndNotify(const util::Status& status) override;
 
+  /** See `GrpcStream::set_min_compressed_message_bytes`. */
+  void set_min_compressed_message_bytes(size_t bytes) {
+    stream_->set_min_compressed_message_bytes(bytes);
+  }
+
   /**
    * Returns the metadata received from the server.
    *
@@ -100,7 +116,8 @@ class GrpcStreamingReader : public GrpcCall, public GrpcStreamObserver {
   std::unique_ptr<GrpcStream> stream_;
   grpc::ByteBuffer request_;
 
-  Callback callback_;
+  MessageCallback on_message_;
+  FinishCallback on_finish_;
   ResponsesT responses_;
 };
 
@@ -39,7 +39,8 @@ GrpcUnaryCall::GrpcUnaryCall(
       call_{std::move(call)},
       request_{request},
       worker_queue_{worker_queue},
-      grpc_connection_{grpc_connection} {
+      grpc_connection_{grpc_connection},
+      completion_pool_{grpc_connection->completion_pool()} {
   grpc_connection_->Register(this);
 }
 
@@ -54,7 +55,7 @@ void GrpcUnaryCall::Start(Callback&& callback) {
   call_->StartCall();
 
   // For lifetime details, see `GrpcCompletion` class comment.
-  finish_completion_ = new GrpcCompletion(
+  finish_completion_ = completion_pool_->Acquire(
       Type::Finish, worker_queue_,
       [this](bool /*ignored_ok*/, const GrpcCompletion* completion) {
         // Ignoring ok, status should contain all the relevant information.
@@ -102,6 +102,7 @@ class GrpcUnaryCall : public GrpcCall {
 
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   GrpcConnection* grpc_connection_ = nullptr;
+  std::shared_ptr<GrpcCompletionPool> completion_pool_;
 
   GrpcCompletion* finish_completion_ = nullptr;
   Callback callback_;
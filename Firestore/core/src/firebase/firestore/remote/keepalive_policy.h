@@ -0,0 +1,70 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_KEEPALIVE_POLICY_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_KEEPALIVE_POLICY_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * How the connections to the backend send HTTP/2 pings to detect that they
+ * died, and to keep the network path to the backend from dropping them while
+ * streams are open but quiet.
+ */
+struct KeepalivePolicy {
+  /** How long a connection goes without activity before it is pinged. */
+  std::chrono::milliseconds time{std::chrono::seconds(30)};
+
+  /**
+   * How long a ping may go unanswered before the connection is considered
+   * dead.
+   */
+  std::chrono::milliseconds timeout{std::chrono::seconds(20)};
+
+  /**
+   * The number of pings sent in a row while no data is being sent, after
+   * which pings stop until there is. Zero keeps pinging a quiet stream for as
+   * long as it is open.
+   */
+  int max_pings_without_data = 2;
+
+  /** Whether connections are pinged even while no calls are active. */
+  bool permit_without_calls = false;
+
+  size_t Hash() const {
+    return util::Hash(time.count(), timeout.count(), max_pings_without_data,
+                      permit_without_calls);
+  }
+};
+
+inline bool operator==(const KeepalivePolicy& lhs,
+                       const KeepalivePolicy& rhs) {
+  return lhs.time == rhs.time && lhs.timeout == rhs.timeout &&
+         lhs.max_pings_without_data == rhs.max_pings_without_data &&
+         lhs.permit_without_calls == rhs.permit_without_calls;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_KEEPALIVE_POLICY_H_
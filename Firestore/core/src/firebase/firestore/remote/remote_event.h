@@ -25,7 +25,6 @@
 
 #import <Foundation/Foundation.h>
 
-#include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -36,7 +35,9 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "absl/container/inlined_vector.h"
 
 @class FSTMaybeDocument;
 @class FSTQueryData;
@@ -195,6 +196,13 @@ class TargetState {
    */
   TargetChange ToTargetChange() const;
 
+  /**
+   * The number of documents added to the target less the number removed from
+   * it since the last snapshot. Cheaper than counting the documents in
+   * `ToTargetChange()`.
+   */
+  int DocumentCountDelta() const;
+
   /** Resets the document changes and sets `HasPendingChanges` to false. */
   void ClearPendingChanges();
 
@@ -242,12 +250,14 @@ class TargetState {
  */
 class RemoteEvent {
  public:
+  using DocumentUpdates = std::unordered_map<model::DocumentKey,
+                                             FSTMaybeDocument*,
+                                             model::DocumentKeyHash>;
+
   RemoteEvent(model::SnapshotVersion snapshot_version,
               std::unordered_map<model::TargetId, TargetChange> target_changes,
               std::unordered_set<model::TargetId> target_mismatches,
-              std::unordered_map<model::DocumentKey,
-                                 FSTMaybeDocument*,
-                                 model::DocumentKeyHash> document_updates,
+              DocumentUpdates document_updates,
               model::DocumentKeySet limbo_document_changes)
       : snapshot_version_{snapshot_version},
         target_changes_{std::move(target_changes)},
@@ -279,10 +289,7 @@ class RemoteEvent {
    * A set of which documents have changed or been deleted, along with the doc's
    * new values (if not deleted).
    */
-  const std::unordered_map<model::DocumentKey,
-                           FSTMaybeDocument*,
-                           model::DocumentKeyHash>&
-  document_updates() const {
+  const DocumentUpdates& document_updates() const {
     return document_updates_;
   }
 
@@ -297,10 +304,7 @@ class RemoteEvent {
   model::SnapshotVersion snapshot_version_;
   std::unordered_map<model::TargetId, TargetChange> target_changes_;
   std::unordered_set<model::TargetId> target_mismatches_;
-  std::unordered_map<model::DocumentKey,
-                     FSTMaybeDocument*,
-                     model::DocumentKeyHash>
-      document_updates_;
+  DocumentUpdates document_updates_;
   model::DocumentKeySet limbo_document_changes_;
 };
 
@@ -325,7 +329,9 @@ class WatchChangeAggregator {
 
   /**
    * Handles existence filters and synthesizes deletes for filter mismatches.
-   * Targets that are invalidated by filter mismatches are added to
+   * If the filter carries a Bloom filter of the documents that still match,
+   * the documents missing from it are removed from the target instead. Targets
+   * that are invalidated by filter mismatches are added to
    * `pending_target_resets_`.
    */
   void HandleExistenceFilter(
@@ -381,6 +387,13 @@ class WatchChangeAggregator {
    */
   int GetCurrentDocumentCountForTarget(model::TargetId target_id);
 
+  /**
+   * Removes from the target all documents that the LocalStore considers to be
+   * part of it but that are definitely not in `unchanged_names`.
+   */
+  void FilterRemovedDocuments(const BloomFilter& unchanged_names,
+                             model::TargetId target_id);
+
   // PORTING NOTE: this method exists only for consistency with other platforms;
   // in C++, it's pretty much unnecessary.
   TargetState& EnsureTargetState(model::TargetId target_id);
@@ -424,9 +437,13 @@ class WatchChangeAggregator {
                      model::DocumentKeyHash>
       pending_document_updates_;
 
-  /** A mapping of document keys to their set of target IDs. */
+  /**
+   * A mapping of document keys to their set of target IDs. Most documents
+   * belong to only one or two targets, so the IDs are kept inline as an
+   * unordered list without duplicates.
+   */
   std::unordered_map<model::DocumentKey,
-                     std::set<model::TargetId>,
+                     absl::InlinedVector<model::TargetId, 2>,
                      model::DocumentKeyHash>
       pending_document_target_mappings_;
 
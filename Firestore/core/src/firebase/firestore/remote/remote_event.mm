@@ -16,12 +16,16 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/Core/FSTQuery.h"
 #import "Firestore/Source/Local/FSTQueryData.h"
 #import "Firestore/Source/Model/FSTDocument.h"
 
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+
 using firebase::firestore::core::DocumentViewChange;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
@@ -32,6 +36,23 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
+namespace {
+
+template <typename List>
+void AddTargetId(List* target_ids, TargetId target_id) {
+  if (std::find(target_ids->begin(), target_ids->end(), target_id) ==
+      target_ids->end()) {
+    target_ids->push_back(target_id);
+  }
+}
+
+DocumentKeySet ToDocumentKeySet(std::vector<DocumentKey>* keys) {
+  std::sort(keys->begin(), keys->end());
+  return DocumentKeySet::FromSortedRange(*keys);
+}
+
+}  // namespace
+
 // TargetChange
 
 bool operator==(const TargetChange& lhs, const TargetChange& rhs) {
@@ -55,9 +76,11 @@ void TargetState::UpdateResumeToken(NSData* resume_token) {
 }
 
 TargetChange TargetState::ToTargetChange() const {
-  DocumentKeySet added_documents;
-  DocumentKeySet modified_documents;
-  DocumentKeySet removed_documents;
+  // Collect and sort the keys first: building each set from a sorted range is
+  // much cheaper than inserting keys into it one by one.
+  std::vector<DocumentKey> added_documents;
+  std::vector<DocumentKey> modified_documents;
+  std::vector<DocumentKey> removed_documents;
 
   for (const auto& entry : document_changes_) {
     const DocumentKey& document_key = entry.first;
@@ -65,22 +88,35 @@ TargetChange TargetState::ToTargetChange() const {
 
     switch (change_type) {
       case DocumentViewChange::Type::kAdded:
-        added_documents = added_documents.insert(document_key);
+        added_documents.push_back(document_key);
         break;
       case DocumentViewChange::Type::kModified:
-        modified_documents = modified_documents.insert(document_key);
+        modified_documents.push_back(document_key);
         break;
       case DocumentViewChange::Type::kRemoved:
-        removed_documents = removed_documents.insert(document_key);
+        removed_documents.push_back(document_key);
         break;
       default:
         HARD_FAIL("Encountered invalid change type: %s", change_type);
     }
   }
 
-  return TargetChange{resume_token(), current(), std::move(added_documents),
-                      std::move(modified_documents),
-                      std::move(removed_documents)};
+  return TargetChange{resume_token(), current(),
+                      ToDocumentKeySet(&added_documents),
+                      ToDocumentKeySet(&modified_documents),
+                      ToDocumentKeySet(&removed_documents)};
+}
+
+int TargetState::DocumentCountDelta() const {
+  int delta = 0;
+  for (const auto& entry : document_changes_) {
+    if (entry.second == DocumentViewChange::Type::kAdded) {
+      ++delta;
+    } else if (entry.second == DocumentViewChange::Type::kRemoved) {
+      --delta;
+    }
+  }
+  return delta;
 }
 
 void TargetState::ClearPendingChanges() {
@@ -237,8 +273,20 @@ void WatchChangeAggregator::HandleExistenceFilter(
     } else {
       int current_size = GetCurrentDocumentCountForTarget(target_id);
       if (current_size != expected_count) {
-        // Existence filter mismatch: We reset the mapping and raise a new
-        // snapshot with `isFromCache:true`.
+        // Existence filter mismatch: if the backend told us which documents
+        // still match, drop the ones that don't and see if that accounts for
+        // the difference.
+        const absl::optional<BloomFilter>& unchanged_names =
+            existence_filter.filter().unchanged_names();
+        if (unchanged_names) {
+          FilterRemovedDocuments(*unchanged_names, target_id);
+          if (GetCurrentDocumentCountForTarget(target_id) == expected_count) {
+            return;
+          }
+        }
+
+        // Otherwise, we reset the mapping and raise a new snapshot with
+        // `isFromCache:true`.
         ResetTarget(target_id);
         pending_target_resets_.insert(target_id);
       }
@@ -248,6 +296,7 @@ void WatchChangeAggregator::HandleExistenceFilter(
 
 RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
     const SnapshotVersion& snapshot_version) {
+  FIRESTORE_TRACE_SPAN("WatchChangeAggregator::CreateRemoteEvent");
   std::unordered_map<TargetId, TargetChange> target_changes;
 
   for (auto& entry : target_states_) {
@@ -331,7 +380,7 @@ void WatchChangeAggregator::AddDocumentToTarget(TargetId target_id,
   target_state.AddDocumentChange(document.key, change_type);
 
   pending_document_updates_[document.key] = document;
-  pending_document_target_mappings_[document.key].insert(target_id);
+  AddTargetId(&pending_document_target_mappings_[document.key], target_id);
 }
 
 void WatchChangeAggregator::RemoveDocumentFromTarget(
@@ -350,13 +399,24 @@ void WatchChangeAggregator::RemoveDocumentFromTarget(
     // snapshot, so we can just ignore the change.
     target_state.RemoveDocumentChange(key);
   }
-  pending_document_target_mappings_[key].insert(target_id);
+  AddTargetId(&pending_document_target_mappings_[key], target_id);
 
   if (updated_document) {
     pending_document_updates_[key] = updated_document;
   }
 }
 
+void WatchChangeAggregator::FilterRemovedDocuments(
+    const BloomFilter& unchanged_names, TargetId target_id) {
+  DocumentKeySet existing_keys =
+      target_metadata_provider_->GetRemoteKeysForTarget(target_id);
+  for (const DocumentKey& key : existing_keys) {
+    if (!unchanged_names.MightContain(key.path().CanonicalString())) {
+      RemoveDocumentFromTarget(target_id, key, nil);
+    }
+  }
+}
+
 void WatchChangeAggregator::RemoveTarget(TargetId target_id) {
   target_states_.erase(target_id);
 }
@@ -364,10 +424,8 @@ void WatchChangeAggregator::RemoveTarget(TargetId target_id) {
 int WatchChangeAggregator::GetCurrentDocumentCountForTarget(
     TargetId target_id) {
   TargetState& target_state = EnsureTargetState(target_id);
-  TargetChange target_change = target_state.ToTargetChange();
   return target_metadata_provider_->GetRemoteKeysForTarget(target_id).size() +
-         target_change.added_documents().size() -
-         target_change.removed_documents().size();
+         target_state.DocumentCountDelta();
 }
 
 void WatchChangeAggregator::RecordPendingTargetRequest(TargetId target_id) {
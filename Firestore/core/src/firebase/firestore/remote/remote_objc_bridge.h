@@ -30,6 +30,7 @@
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "grpcpp/support/byte_buffer.h"
@@ -64,9 +65,7 @@ bool IsLoggingEnabled();
  */
 class WatchStreamSerializer {
  public:
-  explicit WatchStreamSerializer(FSTSerializerBeta* serializer)
-      : serializer_{serializer} {
-  }
+  explicit WatchStreamSerializer(FSTSerializerBeta* serializer);
 
   GCFSListenRequest* CreateWatchRequest(FSTQueryData* query) const;
   GCFSListenRequest* CreateUnwatchRequest(model::TargetId target_id) const;
@@ -82,12 +81,44 @@ class WatchStreamSerializer {
   std::unique_ptr<WatchChange> ToWatchChange(GCFSListenResponse* proto) const;
   model::SnapshotVersion ToSnapshotVersion(GCFSListenResponse* proto) const;
 
+  /**
+   * Decodes a response straight from the bytes on the wire with nanopb, which
+   * is equivalent to `ToWatchChange(ParseResponse(message))` but never builds
+   * the Objective-C protos. Writes the version that `ToSnapshotVersion` would
+   * return to `out_version`.
+   *
+   * If decoding fails, will return null and write information on the error to
+   * `out_status`. Otherwise, sets `out_status` to ok.
+   */
+  std::unique_ptr<WatchChange> DecodeResponse(
+      const grpc::ByteBuffer& message,
+      model::SnapshotVersion* out_version,
+      util::Status* out_status) const;
+
   /** Creates a pretty-printed description of the proto for debugging. */
   static NSString* Describe(GCFSListenRequest* request);
   static NSString* Describe(GCFSListenResponse* request);
 
  private:
+  std::unique_ptr<WatchChange> DecodeWatchChange(
+      nanopb::Reader* reader,
+      const google_firestore_v1_ListenResponse& response,
+      const grpc::ByteBuffer& message) const;
+  std::unique_ptr<WatchChange> DecodeTargetChange(
+      const google_firestore_v1_TargetChange& change) const;
+  std::unique_ptr<WatchChange> DecodeDocumentChange(
+      nanopb::Reader* reader,
+      const google_firestore_v1_DocumentChange& change,
+      const grpc::ByteBuffer& message) const;
+  std::unique_ptr<WatchChange> DecodeDocumentDelete(
+      nanopb::Reader* reader,
+      const google_firestore_v1_DocumentDelete& change) const;
+  std::unique_ptr<WatchChange> DecodeDocumentRemove(
+      nanopb::Reader* reader,
+      const google_firestore_v1_DocumentRemove& change) const;
+
   FSTSerializerBeta* serializer_;
+  Serializer nanopb_serializer_;
 };
 
 /**
@@ -154,15 +185,24 @@ class DatastoreSerializer {
   static grpc::ByteBuffer ToByteBuffer(GCFSBatchGetDocumentsRequest* request);
 
   /**
-   * Merges results of the streaming read together. The array is sorted by the
-   * document key.
+   * Decodes a single response of the streaming read. Returns nil and sets
+   * `out_status` if the response can't be parsed.
    */
-  std::vector<FSTMaybeDocument*> MergeLookupResponses(
-      const std::vector<grpc::ByteBuffer>& responses,
-      util::Status* out_status) const;
+  FSTMaybeDocument* ToMaybeDocument(const grpc::ByteBuffer& response,
+                                    util::Status* out_status) const;
   FSTMaybeDocument* ToMaybeDocument(
       GCFSBatchGetDocumentsResponse* response) const;
 
+  GCFSRunQueryRequest* CreateRunQueryRequest(FSTQuery* query) const;
+  static grpc::ByteBuffer ToByteBuffer(GCFSRunQueryRequest* request);
+
+  /**
+   * Decodes a single response of a RunQuery call. Returns nil if the response
+   * has no document, and also sets `out_status` if it can't be parsed.
+   */
+  FSTDocument* ToDocument(const grpc::ByteBuffer& response,
+                          util::Status* out_status) const;
+
   FSTSerializerBeta* GetSerializer() {
     return serializer_;
   }
@@ -16,17 +16,23 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
 
+#include <cstdlib>
 #include <iomanip>
-#include <map>
 #include <sstream>
 #include <vector>
 
 #import "Firestore/Source/API/FIRFirestore+Internal.h"
+#import "Firestore/Source/Model/FSTDocument.h"
 
+#include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_nanopb.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "absl/memory/memory.h"
 #include "grpcpp/support/status.h"
 
 namespace firebase {
@@ -35,9 +41,13 @@ namespace remote {
 namespace bridge {
 
 using core::DatabaseInfo;
+using model::Document;
 using model::DocumentKey;
+using model::DocumentState;
 using model::TargetId;
 using model::SnapshotVersion;
+using nanopb::ByteString;
+using nanopb::Reader;
 using util::MakeString;
 using util::MakeNSError;
 using util::Status;
@@ -61,21 +71,27 @@ std::string ToHexString(const grpc::ByteBuffer& buffer) {
   return output.str();
 }
 
-NSData* ConvertToNsData(const grpc::ByteBuffer& buffer, NSError** out_error) {
-  std::vector<grpc::Slice> slices;
-  grpc::Status status = buffer.Dump(&slices);
+// Returns the contents of `buffer` as `NSData`. When the buffer consists of
+// a single slice, as most responses do, the returned data points directly into
+// that slice instead of copying it, so `slices` must outlive the returned data.
+NSData* ConvertToNsData(const grpc::ByteBuffer& buffer,
+                        std::vector<grpc::Slice>* slices,
+                        NSError** out_error) {
+  grpc::Status status = buffer.Dump(slices);
   if (!status.ok()) {
     *out_error = MakeNSError(Status{
         Error::Internal, "Trying to convert an invalid grpc::ByteBuffer"});
     return nil;
   }
 
-  if (slices.size() == 1) {
-    return [NSData dataWithBytes:slices.front().begin()
-                          length:slices.front().size()];
+  if (slices->size() == 1) {
+    const grpc::Slice& slice = slices->front();
+    return [NSData dataWithBytesNoCopy:const_cast<uint8_t*>(slice.begin())
+                                length:slice.size()
+                          freeWhenDone:NO];
   } else {
     NSMutableData* data = [NSMutableData dataWithCapacity:buffer.Length()];
-    for (const auto& slice : slices) {
+    for (const auto& slice : *slices) {
       [data appendBytes:slice.begin() length:slice.size()];
     }
     return data;
@@ -91,7 +107,10 @@ grpc::ByteBuffer ConvertToByteBuffer(NSData* data) {
 template <typename Proto>
 Proto* ToProto(const grpc::ByteBuffer& message, Status* out_status) {
   NSError* error = nil;
-  NSData* data = ConvertToNsData(message, &error);
+  // Parsing copies every field out of `data`, so nothing refers to `slices`
+  // once it returns.
+  std::vector<grpc::Slice> slices;
+  NSData* data = ConvertToNsData(message, &slices, &error);
   if (!error) {
     Proto* proto = [Proto parseFromData:data error:&error];
     if (!error) {
@@ -111,6 +130,36 @@ Proto* ToProto(const grpc::ByteBuffer& message, Status* out_status) {
   return nil;
 }
 
+// Returns NSData that shares the bytes, or nil if there are none.
+NSData* ReleaseToNSData(ByteString bytes) {
+  if (bytes.get() == nullptr) {
+    return nil;
+  }
+  return MakeNSData(bytes);
+}
+
+std::vector<TargetId> MakeTargetIds(const int32_t* target_ids,
+                                    pb_size_t count) {
+  return std::vector<TargetId>(target_ids, target_ids + count);
+}
+
+WatchTargetChangeState DecodeTargetChangeState(
+    google_firestore_v1_TargetChange_TargetChangeType state) {
+  switch (state) {
+    case google_firestore_v1_TargetChange_TargetChangeType_NO_CHANGE:
+      return WatchTargetChangeState::NoChange;
+    case google_firestore_v1_TargetChange_TargetChangeType_ADD:
+      return WatchTargetChangeState::Added;
+    case google_firestore_v1_TargetChange_TargetChangeType_REMOVE:
+      return WatchTargetChangeState::Removed;
+    case google_firestore_v1_TargetChange_TargetChangeType_CURRENT:
+      return WatchTargetChangeState::Current;
+    case google_firestore_v1_TargetChange_TargetChangeType_RESET:
+      return WatchTargetChangeState::Reset;
+  }
+  HARD_FAIL("Unexpected TargetChange.state: %s", state);
+}
+
 }  // namespace
 
 bool IsLoggingEnabled() {
@@ -119,6 +168,10 @@ bool IsLoggingEnabled() {
 
 // WatchStreamSerializer
 
+WatchStreamSerializer::WatchStreamSerializer(FSTSerializerBeta* serializer)
+    : serializer_{serializer}, nanopb_serializer_{serializer.databaseID} {
+}
+
 GCFSListenRequest* WatchStreamSerializer::CreateWatchRequest(
     FSTQueryData* query) const {
   GCFSListenRequest* request = [GCFSListenRequest message];
@@ -156,6 +209,160 @@ SnapshotVersion WatchStreamSerializer::ToSnapshotVersion(
   return [serializer_ versionFromListenResponse:proto];
 }
 
+std::unique_ptr<WatchChange> WatchStreamSerializer::DecodeResponse(
+    const grpc::ByteBuffer& message,
+    SnapshotVersion* out_version,
+    Status* out_status) const {
+  ByteBufferReader buffer_reader{message};
+  Reader* reader = buffer_reader.reader();
+
+  google_firestore_v1_ListenResponse response{};
+  reader->ReadNanopbMessage(google_firestore_v1_ListenResponse_fields,
+                            &response);
+
+  std::unique_ptr<WatchChange> change;
+  if (reader->status().ok()) {
+    change = DecodeWatchChange(reader, response, message);
+    *out_version = Serializer::DecodeVersion(reader, response);
+  }
+  reader->FreeNanopbMessage(google_firestore_v1_ListenResponse_fields,
+                            &response);
+
+  if (!reader->status().ok()) {
+    std::string error_description =
+        StringFormat("Unable to parse response from the server.\n"
+                     "Underlying error: %s\n"
+                     "Expected class: google.firestore.v1.ListenResponse\n"
+                     "Received value: %s\n",
+                     reader->status().ToString(), ToHexString(message));
+    *out_status = {Error::Internal, error_description};
+    return nullptr;
+  }
+
+  *out_status = Status::OK();
+  return change;
+}
+
+std::unique_ptr<WatchChange> WatchStreamSerializer::DecodeWatchChange(
+    Reader* reader,
+    const google_firestore_v1_ListenResponse& response,
+    const grpc::ByteBuffer& message) const {
+  switch (response.which_response_type) {
+    case google_firestore_v1_ListenResponse_target_change_tag:
+      return DecodeTargetChange(response.target_change);
+
+    case google_firestore_v1_ListenResponse_document_change_tag:
+      return DecodeDocumentChange(reader, response.document_change, message);
+
+    case google_firestore_v1_ListenResponse_document_delete_tag:
+      return DecodeDocumentDelete(reader, response.document_delete);
+
+    case google_firestore_v1_ListenResponse_document_remove_tag:
+      return DecodeDocumentRemove(reader, response.document_remove);
+
+    case google_firestore_v1_ListenResponse_filter_tag: {
+      ExistenceFilter existence_filter{response.filter.count};
+      return absl::make_unique<ExistenceFilterWatchChange>(
+          existence_filter, response.filter.target_id);
+    }
+
+    default:
+      reader->Fail(StringFormat("Unknown WatchChange.changeType %s",
+                                response.which_response_type));
+      return nullptr;
+  }
+}
+
+std::unique_ptr<WatchChange> WatchStreamSerializer::DecodeTargetChange(
+    const google_firestore_v1_TargetChange& change) const {
+  WatchTargetChangeState state =
+      DecodeTargetChangeState(change.target_change_type);
+  std::vector<TargetId> target_ids =
+      MakeTargetIds(change.target_ids, change.target_ids_count);
+
+  NSData* resume_token = [NSData data];
+  if (change.resume_token != nullptr) {
+    resume_token = [NSData dataWithBytes:change.resume_token->bytes
+                                  length:change.resume_token->size];
+  }
+
+  return absl::make_unique<WatchTargetChange>(
+      state, std::move(target_ids), resume_token,
+      Serializer::DecodeStatus(change.cause));
+}
+
+std::unique_ptr<WatchChange> WatchStreamSerializer::DecodeDocumentChange(
+    Reader* reader,
+    const google_firestore_v1_DocumentChange& change,
+    const grpc::ByteBuffer& message) const {
+  std::unique_ptr<Document> document =
+      nanopb_serializer_.DecodeDocument(reader, change.document);
+  if (!reader->status().ok()) {
+    return nullptr;
+  }
+  HARD_ASSERT(document->version() != SnapshotVersion::None(),
+              "Got a document change with no snapshot version");
+
+  // The document may soon be stored in local persistence. Keep its encoded
+  // form, copied out of the message without decoding it again, so that it
+  // can be stored as it is.
+  ByteBufferReader bytes_reader{message};
+  ByteString encoded_document =
+      Serializer::ReadDocumentChangeBytes(bytes_reader.reader());
+  NSData* encoded_proto = nil;
+  if (bytes_reader.reader()->status().ok()) {
+    encoded_proto = ReleaseToNSData(std::move(encoded_document));
+  }
+
+  DocumentKey key = document->key();
+  FSTMaybeDocument* maybe_document =
+      [FSTDocument documentWithData:document->data()
+                                key:key
+                            version:document->version()
+                              state:DocumentState::kSynced
+                       encodedProto:encoded_proto];
+  return absl::make_unique<DocumentWatchChange>(
+      MakeTargetIds(change.target_ids, change.target_ids_count),
+      MakeTargetIds(change.removed_target_ids, change.removed_target_ids_count),
+      std::move(key), maybe_document);
+}
+
+std::unique_ptr<WatchChange> WatchStreamSerializer::DecodeDocumentDelete(
+    Reader* reader, const google_firestore_v1_DocumentDelete& change) const {
+  DocumentKey key = nanopb_serializer_.DecodeKey(
+      reader, Serializer::DecodeString(change.document));
+  // Note that version might be unset in which case we use
+  // SnapshotVersion::None()
+  SnapshotVersion version =
+      Serializer::DecodeSnapshotVersion(reader, change.read_time);
+  if (!reader->status().ok()) {
+    return nullptr;
+  }
+
+  FSTMaybeDocument* document =
+      [FSTDeletedDocument documentWithKey:key
+                                  version:version
+                    hasCommittedMutations:NO];
+  return absl::make_unique<DocumentWatchChange>(
+      std::vector<TargetId>{},
+      MakeTargetIds(change.removed_target_ids, change.removed_target_ids_count),
+      std::move(key), document);
+}
+
+std::unique_ptr<WatchChange> WatchStreamSerializer::DecodeDocumentRemove(
+    Reader* reader, const google_firestore_v1_DocumentRemove& change) const {
+  DocumentKey key = nanopb_serializer_.DecodeKey(
+      reader, Serializer::DecodeString(change.document));
+  if (!reader->status().ok()) {
+    return nullptr;
+  }
+
+  return absl::make_unique<DocumentWatchChange>(
+      std::vector<TargetId>{},
+      MakeTargetIds(change.removed_target_ids, change.removed_target_ids_count),
+      std::move(key), nil);
+}
+
 NSString* WatchStreamSerializer::Describe(GCFSListenRequest* request) {
   return [request description];
 }
@@ -272,26 +479,13 @@ grpc::ByteBuffer DatastoreSerializer::ToByteBuffer(
   return ConvertToByteBuffer([request data]);
 }
 
-std::vector<FSTMaybeDocument*> DatastoreSerializer::MergeLookupResponses(
-    const std::vector<grpc::ByteBuffer>& responses, Status* out_status) const {
-  // Sort by key.
-  std::map<DocumentKey, FSTMaybeDocument*> results;
-
-  for (const auto& response : responses) {
-    auto* proto = ToProto<GCFSBatchGetDocumentsResponse>(response, out_status);
-    if (!out_status->ok()) {
-      return {};
-    }
-    FSTMaybeDocument* doc = [serializer_ decodedMaybeDocumentFromBatch:proto];
-    results[doc.key] = doc;
-  }
-
-  std::vector<FSTMaybeDocument*> docs;
-  docs.reserve(results.size());
-  for (const auto& kv : results) {
-    docs.push_back(kv.second);
+FSTMaybeDocument* DatastoreSerializer::ToMaybeDocument(
+    const grpc::ByteBuffer& response, Status* out_status) const {
+  auto* proto = ToProto<GCFSBatchGetDocumentsResponse>(response, out_status);
+  if (!out_status->ok()) {
+    return nil;
   }
-  return docs;
+  return ToMaybeDocument(proto);
 }
 
 FSTMaybeDocument* DatastoreSerializer::ToMaybeDocument(
@@ -299,6 +493,30 @@ FSTMaybeDocument* DatastoreSerializer::ToMaybeDocument(
   return [serializer_ decodedMaybeDocumentFromBatch:response];
 }
 
+GCFSRunQueryRequest* DatastoreSerializer::CreateRunQueryRequest(
+    FSTQuery* query) const {
+  GCFSTarget_QueryTarget* target = [serializer_ encodedQueryTarget:query];
+
+  GCFSRunQueryRequest* request = [GCFSRunQueryRequest message];
+  request.parent = target.parent;
+  request.structuredQuery = target.structuredQuery;
+  return request;
+}
+
+grpc::ByteBuffer DatastoreSerializer::ToByteBuffer(
+    GCFSRunQueryRequest* request) {
+  return ConvertToByteBuffer([request data]);
+}
+
+FSTDocument* DatastoreSerializer::ToDocument(const grpc::ByteBuffer& response,
+                                             Status* out_status) const {
+  auto* proto = ToProto<GCFSRunQueryResponse>(response, out_status);
+  if (!out_status->ok()) {
+    return nil;
+  }
+  return [serializer_ decodedDocumentFromRunQuery:proto];
+}
+
 }  // namespace bridge
 }  // namespace remote
 }  // namespace firestore
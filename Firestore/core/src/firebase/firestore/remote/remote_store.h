@@ -23,6 +23,7 @@
 
 #import <Foundation/Foundation.h>
 
+#include <deque>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -36,6 +37,7 @@
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
+#include "Firestore/core/src/firebase/firestore/remote/write_pipeline_window.h"
 #include "Firestore/core/src/firebase/firestore/remote/write_stream.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
@@ -85,6 +87,14 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)applySuccessfulWriteWithResult:
     (FSTMutationBatchResult*)batchResult;  // NOLINT(readability/casting)
 
+/**
+ * Applies the results of several successful writes of mutation batches, in
+ * the order they were acknowledged, as a single change: the local store is
+ * updated in one transaction and views emit one round of snapshots.
+ */
+- (void)applySuccessfulWritesWithResults:
+    (const std::vector<FSTMutationBatchResult*>&)batchResults;
+
 /**
  * Rejects the batch, removing the batch from the mutation queue, recomputing
  * the local view of any documents affected by the batch and then, emitting
@@ -113,10 +123,21 @@ class RemoteStore : public TargetMetadataProvider,
                     public WatchStreamCallback,
                     public WriteStreamCallback {
  public:
+  /**
+   * @param write_pipeline_window Decides how many mutation batches may be in
+   *     flight on the write stream at once.
+   * @param coalesce_write_batches Whether contiguous mutation batches may be
+   *     sent together in a single `WriteRequest`.
+   * @param coalesce_write_acks Whether write acknowledgements that arrive back
+   *     to back are handed to the sync engine together.
+   */
   RemoteStore(FSTLocalStore* local_store,
               std::shared_ptr<Datastore> datastore,
               const std::shared_ptr<util::AsyncQueue>& worker_queue,
-              std::function<void(model::OnlineState)> online_state_handler);
+              std::function<void(model::OnlineState)> online_state_handler,
+              WritePipelineWindow write_pipeline_window = {},
+              bool coalesce_write_batches = false,
+              bool coalesce_write_acks = false);
 
   void set_sync_engine(id<FSTRemoteSyncer> sync_engine) {
     sync_engine_ = sync_engine;
@@ -220,6 +241,13 @@ class RemoteStore : public TargetMetadataProvider,
    */
   bool CanAddToWritePipeline() const;
 
+  /**
+   * Sends the writes in `write_pipeline_` starting at index `first` to the
+   * write stream, packing contiguous batches into a single request if
+   * coalescing is enabled.
+   */
+  void SendWriteRequests(size_t first);
+
   void StartWriteStream();
 
   /**
@@ -228,6 +256,13 @@ class RemoteStore : public TargetMetadataProvider,
    */
   bool ShouldStartWriteStream() const;
 
+  /**
+   * Hands the write acknowledgements held back for coalescing to the sync
+   * engine. Anything that may depend on the acknowledged batches being applied,
+   * such as another event from the backend, calls this first.
+   */
+  void ApplyPendingWriteAcks();
+
   void HandleHandshakeError(const util::Status& status);
   void HandleWriteError(const util::Status& status);
 
@@ -278,9 +313,9 @@ class RemoteStore : public TargetMetadataProvider,
   std::unique_ptr<WatchChangeAggregator> watch_change_aggregator_;
 
   /**
-   * A list of up to `kMaxPendingWrites` writes that we have fetched from the
-   * `LocalStore` via `FillWritePipeline` and have or will send to the write
-   * stream.
+   * A list of up to `write_pipeline_window_.size()` writes that we have fetched
+   * from the `LocalStore` via `FillWritePipeline` and have or will send to the
+   * write stream.
    *
    * Whenever `write_pipeline_` is not empty, the `RemoteStore` will attempt to
    * start or restart the write stream. When the stream is established, the
@@ -295,6 +330,37 @@ class RemoteStore : public TargetMetadataProvider,
    * the `write_pipeline_` as we receive responses.
    */
   std::vector<FSTMutationBatch*> write_pipeline_;
+
+  WritePipelineWindow write_pipeline_window_;
+
+  bool coalesce_write_batches_ = false;
+
+  /**
+   * The number of batches from the front of `write_pipeline_` carried by each
+   * request that has been sent on the current write stream, in order. A
+   * response from the backend acknowledges all batches of the oldest request.
+   */
+  std::deque<size_t> write_request_batch_counts_;
+
+  /**
+   * Batches up to and including this ID are sent in requests of their own,
+   * even when coalescing. This is set when a coalesced request fails
+   * permanently so that the offending batch can be singled out on retry.
+   */
+  model::BatchId isolate_through_batch_id_ = model::kBatchIdUnknown;
+
+  std::shared_ptr<util::AsyncQueue> worker_queue_;
+
+  bool coalesce_write_acks_ = false;
+
+  /**
+   * The results of the batches acknowledged by the backend that haven't been
+   * handed to the sync engine yet, in order. They're applied together once the
+   * operations already waiting on the worker queue, which may include more
+   * acknowledgements, have run.
+   */
+  std::vector<FSTMutationBatchResult*> pending_write_acks_;
+  util::DelayedOperation write_ack_flush_;
 };
 
 }  // namespace remote
@@ -48,26 +48,48 @@ using firebase::firestore::remote::WatchChangeAggregator;
 using firebase::firestore::remote::WatchTargetChange;
 using firebase::firestore::remote::WatchTargetChangeState;
 using firebase::firestore::util::AsyncQueue;
+using firebase::firestore::util::TimerId;
 using firebase::firestore::util::Status;
 
 namespace firebase {
 namespace firestore {
 namespace remote {
 
+namespace {
+
 /**
- * The maximum number of pending writes to allow.
- * TODO(b/35853402): Negotiate this value with the backend.
+ * The maximum number of writes the backend accepts in a single request. A
+ * coalesced request never carries more than this, though a single batch is
+ * always sent as is.
  */
-constexpr int kMaxPendingWrites = 10;
+constexpr size_t kMaxWritesPerRequest = 500;
+
+/**
+ * Whether the given write stream error indicates the backend is overloaded and
+ * that the client should send fewer writes at once.
+ */
+bool IsBackpressure(const Status& status) {
+  return status.code() == Error::ResourceExhausted ||
+         status.code() == Error::Unavailable;
+}
+
+}  // namespace
 
 RemoteStore::RemoteStore(
     FSTLocalStore* local_store,
     std::shared_ptr<Datastore> datastore,
     const std::shared_ptr<AsyncQueue>& worker_queue,
-    std::function<void(model::OnlineState)> online_state_handler)
+    std::function<void(model::OnlineState)> online_state_handler,
+    WritePipelineWindow write_pipeline_window,
+    bool coalesce_write_batches,
+    bool coalesce_write_acks)
     : local_store_{local_store},
       datastore_{std::move(datastore)},
-      online_state_tracker_{worker_queue, std::move(online_state_handler)} {
+      online_state_tracker_{worker_queue, std::move(online_state_handler)},
+      write_pipeline_window_{std::move(write_pipeline_window)},
+      coalesce_write_batches_{coalesce_write_batches},
+      worker_queue_{worker_queue},
+      coalesce_write_acks_{coalesce_write_acks} {
   datastore_->Start();
 
   // Create streams (but note they're not started yet)
@@ -108,6 +130,9 @@ void RemoteStore::DisableNetwork() {
 }
 
 void RemoteStore::DisableNetworkInternal() {
+  // The acknowledged batches are done with; don't let them be sent again.
+  ApplyPendingWriteAcks();
+
   watch_stream_->Stop();
   write_stream_->Stop();
 
@@ -116,6 +141,7 @@ void RemoteStore::DisableNetworkInternal() {
               write_pipeline_.size());
     write_pipeline_.clear();
   }
+  write_request_batch_counts_.clear();
 
   CleanUpWatchStreamState();
 }
@@ -205,13 +231,20 @@ void RemoteStore::CleanUpWatchStreamState() {
 }
 
 void RemoteStore::OnWatchStreamOpen() {
-  // Restore any existing watches.
+  // Restore any existing watches. See `SendWatchRequest`; the requests are
+  // sent together so the stream can encode them in bulk.
+  std::vector<FSTQueryData*> queries;
+  queries.reserve(listen_targets_.size());
   for (const auto& kv : listen_targets_) {
-    SendWatchRequest(kv.second);
+    watch_change_aggregator_->RecordPendingTargetRequest(kv.first);
+    queries.push_back(kv.second);
   }
+  watch_stream_->WatchQueries(queries);
 }
 
 void RemoteStore::OnWatchStreamClose(const Status& status) {
+  ApplyPendingWriteAcks();
+
   if (status.ok()) {
     // Graceful stop (due to Stop() or idle timeout). Make sure that's
     // desirable.
@@ -236,6 +269,10 @@ void RemoteStore::OnWatchStreamClose(const Status& status) {
 
 void RemoteStore::OnWatchStreamChange(const WatchChange& change,
                                       const SnapshotVersion& snapshot_version) {
+  // Watch may already reflect the acknowledged writes, and user callbacks for
+  // writes are raised before the listen events for them.
+  ApplyPendingWriteAcks();
+
   // Mark the connection as Online because we got a message from the server.
   online_state_tracker_.UpdateState(OnlineState::Online);
 
@@ -354,20 +391,46 @@ void RemoteStore::ProcessTargetError(const WatchTargetChange& change) {
 // Write Stream
 
 void RemoteStore::FillWritePipeline() {
-  BatchId last_batch_id_retrieved = write_pipeline_.empty()
-                                        ? kBatchIdUnknown
-                                        : write_pipeline_.back().batchID;
-  while (CanAddToWritePipeline()) {
-    FSTMutationBatch* batch =
-        [local_store_ nextMutationBatchAfterBatchID:last_batch_id_retrieved];
-    if (!batch) {
-      if (write_pipeline_.empty()) {
-        write_stream_->MarkIdle();
+  BatchId last_batch_id_retrieved = kBatchIdUnknown;
+  if (!write_pipeline_.empty()) {
+    last_batch_id_retrieved = write_pipeline_.back().batchID;
+  } else if (!pending_write_acks_.empty()) {
+    // The acknowledged batches are still in the mutation queue until their
+    // acknowledgements are applied.
+    last_batch_id_retrieved = pending_write_acks_.back().batch.batchID;
+  }
+  size_t first_added = write_pipeline_.size();
+  if (CanAddToWritePipeline()) {
+    // Read all the batches that fit in the pipeline in one pass over the
+    // mutation queue.
+    size_t free_slots = static_cast<size_t>(write_pipeline_window_.size()) -
+                        write_pipeline_.size();
+    std::vector<FSTMutationBatch*> batches =
+        [local_store_ nextMutationBatchesAfterBatchID:last_batch_id_retrieved
+                                             maxCount:free_slots
+                                             maxBytes:0];
+    if (batches.empty() && write_pipeline_.empty()) {
+      write_stream_->MarkIdle();
+    }
+    for (FSTMutationBatch* batch : batches) {
+      // Sending may close the pipeline; the batches left over are read again
+      // next time.
+      if (!CanAddToWritePipeline()) {
+        break;
+      }
+      if (coalesce_write_batches_) {
+        // Hold off sending so that everything fetched here can go out
+        // together.
+        write_pipeline_.push_back(batch);
+      } else {
+        AddToWritePipeline(batch);
       }
-      break;
     }
-    AddToWritePipeline(batch);
-    last_batch_id_retrieved = batch.batchID;
+  }
+
+  if (coalesce_write_batches_ && first_added < write_pipeline_.size() &&
+      write_stream_->IsOpen() && write_stream_->handshake_complete()) {
+    SendWriteRequests(first_added);
   }
 
   if (ShouldStartWriteStream()) {
@@ -376,7 +439,9 @@ void RemoteStore::FillWritePipeline() {
 }
 
 bool RemoteStore::CanAddToWritePipeline() const {
-  return CanUseNetwork() && write_pipeline_.size() < kMaxPendingWrites;
+  return CanUseNetwork() &&
+         write_pipeline_.size() <
+             static_cast<size_t>(write_pipeline_window_.size());
 }
 
 void RemoteStore::AddToWritePipeline(FSTMutationBatch* batch) {
@@ -386,7 +451,51 @@ void RemoteStore::AddToWritePipeline(FSTMutationBatch* batch) {
   write_pipeline_.push_back(batch);
 
   if (write_stream_->IsOpen() && write_stream_->handshake_complete()) {
-    write_stream_->WriteMutations(batch.mutations);
+    SendWriteRequests(write_pipeline_.size() - 1);
+  }
+}
+
+void RemoteStore::SendWriteRequests(size_t first) {
+  WritePipelineWindow::clock::time_point now =
+      WritePipelineWindow::clock::now();
+
+  size_t i = first;
+  while (i < write_pipeline_.size()) {
+    FSTMutationBatch* batch = write_pipeline_[i];
+    size_t end = i + 1;
+    size_t write_count = batch.mutations.size();
+
+    if (coalesce_write_batches_ &&
+        batch.batchID > isolate_through_batch_id_) {
+      while (end < write_pipeline_.size()) {
+        size_t next_count = write_pipeline_[end].mutations.size();
+        if (write_count + next_count > kMaxWritesPerRequest) {
+          break;
+        }
+        write_count += next_count;
+        ++end;
+      }
+    }
+
+    for (size_t j = i; j < end; ++j) {
+      write_pipeline_window_.RecordWrite(now);
+    }
+    write_request_batch_counts_.push_back(end - i);
+
+    if (end - i == 1) {
+      write_stream_->WriteMutations(batch.mutations);
+    } else {
+      std::vector<FSTMutation*> mutations;
+      mutations.reserve(write_count);
+      for (size_t j = i; j < end; ++j) {
+        const std::vector<FSTMutation*>& batch_mutations =
+            write_pipeline_[j].mutations;
+        mutations.insert(mutations.end(), batch_mutations.begin(),
+                         batch_mutations.end());
+      }
+      write_stream_->WriteMutations(mutations);
+    }
+    i = end;
   }
 }
 
@@ -409,10 +518,11 @@ void RemoteStore::OnWriteStreamHandshakeComplete() {
   // Record the stream token.
   [local_store_ setLastStreamToken:write_stream_->GetLastStreamToken()];
 
-  // Send the write pipeline now that the stream is established.
-  for (FSTMutationBatch* write : write_pipeline_) {
-    write_stream_->WriteMutations(write.mutations);
-  }
+  // Send the write pipeline now that the stream is established. Anything sent
+  // on a previous stream won't be acknowledged there anymore.
+  write_pipeline_window_.Reset();
+  write_request_batch_counts_.clear();
+  SendWriteRequests(0);
 }
 
 void RemoteStore::OnWriteStreamMutationResult(
@@ -422,22 +532,82 @@ void RemoteStore::OnWriteStreamMutationResult(
   // to the first write in our write pipeline.
   HARD_ASSERT(!write_pipeline_.empty(), "Got result for empty write pipeline");
 
-  FSTMutationBatch* batch = write_pipeline_.front();
-  write_pipeline_.erase(write_pipeline_.begin());
+  // The request may have carried several batches, all of which were committed
+  // at the same version.
+  size_t batch_count = 1;
+  if (!write_request_batch_counts_.empty()) {
+    batch_count = write_request_batch_counts_.front();
+    write_request_batch_counts_.pop_front();
+  }
+  HARD_ASSERT(batch_count <= write_pipeline_.size(),
+              "Got result for %s batches but only %s are pending", batch_count,
+              write_pipeline_.size());
 
-  FSTMutationBatchResult* batchResult = [FSTMutationBatchResult
-      resultWithBatch:batch
-        commitVersion:commit_version
-      mutationResults:std::move(mutation_results)
-          streamToken:write_stream_->GetLastStreamToken()];
-  [sync_engine_ applySuccessfulWriteWithResult:batchResult];
+  std::vector<FSTMutationBatch*> batches{
+      write_pipeline_.begin(), write_pipeline_.begin() + batch_count};
+  write_pipeline_.erase(write_pipeline_.begin(),
+                        write_pipeline_.begin() + batch_count);
+
+  WritePipelineWindow::clock::time_point now =
+      WritePipelineWindow::clock::now();
+  NSData* stream_token = write_stream_->GetLastStreamToken();
+  auto results_begin = mutation_results.begin();
+  for (FSTMutationBatch* batch : batches) {
+    write_pipeline_window_.RecordAck(now);
+
+    std::vector<FSTMutationResult*> batch_results;
+    if (batch_count == 1) {
+      batch_results = std::move(mutation_results);
+    } else {
+      size_t remaining = mutation_results.end() - results_begin;
+      HARD_ASSERT(batch.mutations.size() <= remaining,
+                  "Coalesced write response has too few results");
+      auto results_end = results_begin + batch.mutations.size();
+      batch_results.assign(results_begin, results_end);
+      results_begin = results_end;
+    }
+
+    FSTMutationBatchResult* batchResult =
+        [FSTMutationBatchResult resultWithBatch:batch
+                                  commitVersion:commit_version
+                                mutationResults:std::move(batch_results)
+                                    streamToken:stream_token];
+    if (coalesce_write_acks_) {
+      pending_write_acks_.push_back(batchResult);
+    } else {
+      [sync_engine_ applySuccessfulWriteWithResult:batchResult];
+    }
+  }
+
+  if (coalesce_write_acks_ && !write_ack_flush_) {
+    write_ack_flush_ = worker_queue_->EnqueueAfterDelay(
+        AsyncQueue::Milliseconds::zero(), TimerId::WriteAckCoalescing, [this] {
+          write_ack_flush_ = {};
+          ApplyPendingWriteAcks();
+        });
+  }
 
   // It's possible that with the completion of this mutation another slot has
   // freed up.
   FillWritePipeline();
 }
 
+void RemoteStore::ApplyPendingWriteAcks() {
+  write_ack_flush_.Cancel();
+  write_ack_flush_ = {};
+  if (pending_write_acks_.empty()) {
+    return;
+  }
+
+  std::vector<FSTMutationBatchResult*> batch_results;
+  std::swap(batch_results, pending_write_acks_);
+  [sync_engine_ applySuccessfulWritesWithResults:batch_results];
+}
+
 void RemoteStore::OnWriteStreamClose(const Status& status) {
+  // A failed write is rejected only after the writes acknowledged before it.
+  ApplyPendingWriteAcks();
+
   if (status.ok()) {
     // Graceful stop (due to Stop() or idle timeout). Make sure that's
     // desirable.
@@ -492,12 +662,28 @@ void RemoteStore::HandleHandshakeError(const Status& status) {
 void RemoteStore::HandleWriteError(const Status& status) {
   HARD_ASSERT(!status.ok(), "Handling write error with status OK.");
 
+  // Backpressure is transient, so the writes will be retried below, but with
+  // fewer of them in flight.
+  if (IsBackpressure(status)) {
+    write_pipeline_window_.RecordBackpressure();
+  }
+
   // Only handle permanent errors here. If it's transient, just let the retry
   // logic kick in.
   if (!Datastore::IsPermanentWriteError(status)) {
     return;
   }
 
+  // A coalesced request fails as a whole, so there's no telling which of its
+  // batches was at fault. Resend them one per request to find out.
+  if (!write_request_batch_counts_.empty() &&
+      write_request_batch_counts_.front() > 1) {
+    size_t batch_count = write_request_batch_counts_.front();
+    isolate_through_batch_id_ = write_pipeline_[batch_count - 1].batchID;
+    write_stream_->InhibitBackoff();
+    return;
+  }
+
   // If this was a permanent error, the request itself was the problem so it's
   // not going to succeed if we resend it.
   FSTMutationBatch* batch = write_pipeline_.front();
@@ -25,16 +25,20 @@
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
 #include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/filter.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/string_interner.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
@@ -44,6 +48,7 @@
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
 #include "absl/base/casts.h"
 #include "absl/memory/memory.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -51,6 +56,8 @@ namespace remote {
 
 using firebase::Timestamp;
 using firebase::TimestampInternal;
+using firebase::firestore::core::FieldFilter;
+using firebase::firestore::core::Filter;
 using firebase::firestore::core::Query;
 using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DeleteMutation;
@@ -69,7 +76,9 @@ using firebase::firestore::model::Precondition;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::SetMutation;
 using firebase::firestore::model::SnapshotVersion;
+using firebase::firestore::model::StringInterner;
 using firebase::firestore::nanopb::ByteString;
+using firebase::firestore::nanopb::ByteStringWriter;
 using firebase::firestore::nanopb::CheckedSize;
 using firebase::firestore::nanopb::Reader;
 using firebase::firestore::nanopb::Writer;
@@ -77,7 +86,7 @@ using firebase::firestore::util::Status;
 using firebase::firestore::util::StringFormat;
 
 pb_bytes_array_t* Serializer::EncodeString(const std::string& str) {
-  return nanopb::MakeBytesArray(str);
+  return nanopb::AllocateBytesArray(str.data(), str.size());
 }
 
 std::string Serializer::DecodeString(const pb_bytes_array_t* str) {
@@ -164,6 +173,380 @@ FieldValue::Map DecodeMapValue(Reader* reader,
   return result;
 }
 
+google_protobuf_Timestamp ReadTimestampProto(Reader* reader) {
+  google_protobuf_Timestamp result{};
+  reader->ReadNestedMessage([&](Reader* fields) {
+    while (fields->ReadTag()) {
+      switch (fields->field_number()) {
+        case google_protobuf_Timestamp_seconds_tag:
+          result.seconds = fields->ReadInteger();
+          break;
+        case google_protobuf_Timestamp_nanos_tag:
+          result.nanos = static_cast<int32_t>(fields->ReadInteger());
+          break;
+        default:
+          fields->SkipField();
+      }
+    }
+  });
+  return result;
+}
+
+google_type_LatLng ReadLatLngProto(Reader* reader) {
+  google_type_LatLng result{};
+  reader->ReadNestedMessage([&](Reader* fields) {
+    while (fields->ReadTag()) {
+      switch (fields->field_number()) {
+        case google_type_LatLng_latitude_tag:
+          result.latitude = fields->ReadDouble();
+          break;
+        case google_type_LatLng_longitude_tag:
+          result.longitude = fields->ReadDouble();
+          break;
+        default:
+          fields->SkipField();
+      }
+    }
+  });
+  return result;
+}
+
+/**
+ * Reads a MapValue.FieldsEntry or Document.FieldsEntry message, which share
+ * the same layout.
+ */
+FieldValue::Map::value_type ReadFieldsEntry(Reader* reader) {
+  static_assert(google_firestore_v1_MapValue_FieldsEntry_key_tag ==
+                        google_firestore_v1_Document_FieldsEntry_key_tag &&
+                    google_firestore_v1_MapValue_FieldsEntry_value_tag ==
+                        google_firestore_v1_Document_FieldsEntry_value_tag,
+                "MapValue and Document entries must have the same layout");
+
+  std::string key;
+  absl::optional<FieldValue> value;
+  reader->ReadNestedMessage([&](Reader* fields) {
+    while (fields->ReadTag()) {
+      switch (fields->field_number()) {
+        case google_firestore_v1_MapValue_FieldsEntry_key_tag:
+          key = fields->ReadString();
+          break;
+        case google_firestore_v1_MapValue_FieldsEntry_value_tag:
+          fields->ReadNestedMessage([&](Reader* value_reader) {
+            value = Serializer::ReadFieldValue(value_reader);
+          });
+          break;
+        default:
+          fields->SkipField();
+      }
+    }
+  });
+
+  if (!value) {
+    // Matches DecodeFieldValue's handling of an empty Value message.
+    reader->Fail("Invalid type while decoding FieldValue: 0");
+    return {};
+  }
+  return FieldValue::Map::value_type{std::move(key), *std::move(value)};
+}
+
+FieldValue::Array ReadArrayValue(Reader* reader) {
+  FieldValue::Array result;
+  reader->ReadNestedMessage([&](Reader* fields) {
+    while (fields->ReadTag()) {
+      if (fields->field_number() == google_firestore_v1_ArrayValue_values_tag) {
+        fields->ReadNestedMessage([&](Reader* value_reader) {
+          result.push_back(Serializer::ReadFieldValue(value_reader));
+        });
+      } else {
+        fields->SkipField();
+      }
+    }
+  });
+  return result;
+}
+
+FieldValue::Map ReadMapValue(Reader* reader) {
+  FieldValue::Map result;
+  reader->ReadNestedMessage([&](Reader* fields) {
+    while (fields->ReadTag()) {
+      if (fields->field_number() == google_firestore_v1_MapValue_fields_tag) {
+        FieldValue::Map::value_type kv = ReadFieldsEntry(fields);
+        result = result.insert(std::move(kv.first), std::move(kv.second));
+      } else {
+        fields->SkipField();
+      }
+    }
+  });
+  return result;
+}
+
+/**
+ * The encoded sizes of the nested messages within a message, recorded in the
+ * order in which they're written. A sizing pass fills this in so that the
+ * encoding pass can write each nested message's length before its contents
+ * without sizing the contents again.
+ */
+class MessageSizes {
+ public:
+  /**
+   * Computes the size of a nested message with the given field number whose
+   * contents are sized by `contents_size`, recording the contents' size.
+   */
+  template <typename F>
+  size_t SizeNested(uint32_t field_number, const F& contents_size) {
+    size_t slot = sizes_.size();
+    sizes_.push_back(0);
+    size_t size = contents_size();
+    sizes_[slot] = size;
+    return DelimitedSize(field_number, size);
+  }
+
+  /**
+   * Writes a nested message with the given field number whose contents are
+   * written by `write_contents`, using the next recorded size.
+   */
+  template <typename F>
+  void WriteNested(Writer* writer,
+                   uint32_t field_number,
+                   const F& write_contents) {
+    HARD_ASSERT(next_ < sizes_.size(), "Nested message was not sized");
+    writer->WriteTag(PB_WT_STRING, field_number);
+    writer->WriteLength(sizes_[next_++]);
+    write_contents();
+  }
+
+  static size_t DelimitedSize(uint32_t field_number, size_t size) {
+    return Writer::TagSize(field_number) + Writer::VarintSize(size) + size;
+  }
+
+ private:
+  std::vector<size_t> sizes_;
+  size_t next_ = 0;
+};
+
+size_t IntegerSize(uint32_t field_number, int64_t value) {
+  return Writer::TagSize(field_number) +
+         Writer::VarintSize(static_cast<uint64_t>(value));
+}
+
+size_t DoubleSize(uint32_t field_number) {
+  return Writer::TagSize(field_number) + sizeof(double);
+}
+
+// Timestamp fields follow proto3 rules, omitting zeros.
+size_t TimestampSize(const Timestamp& timestamp) {
+  size_t result = 0;
+  if (timestamp.seconds() != 0) {
+    result += IntegerSize(google_protobuf_Timestamp_seconds_tag,
+                          timestamp.seconds());
+  }
+  if (timestamp.nanoseconds() != 0) {
+    result += IntegerSize(google_protobuf_Timestamp_nanos_tag,
+                          timestamp.nanoseconds());
+  }
+  return result;
+}
+
+void WriteTimestamp(Writer* writer, const Timestamp& timestamp) {
+  if (timestamp.seconds() != 0) {
+    writer->WriteTag(PB_WT_VARINT, google_protobuf_Timestamp_seconds_tag);
+    writer->WriteInteger(timestamp.seconds());
+  }
+  if (timestamp.nanoseconds() != 0) {
+    writer->WriteTag(PB_WT_VARINT, google_protobuf_Timestamp_nanos_tag);
+    writer->WriteInteger(timestamp.nanoseconds());
+  }
+}
+
+size_t ValueSize(const FieldValue& value, MessageSizes* sizes);
+void WriteValue(Writer* writer, const FieldValue& value, MessageSizes* sizes);
+
+/**
+ * Sizes the entries of a MapValue or Document, which share the same layout,
+ * as the repeated field with the given number.
+ */
+size_t FieldsSize(uint32_t field_number,
+                  const FieldValue::Map& fields,
+                  MessageSizes* sizes) {
+  size_t result = 0;
+  for (const auto& kv : fields) {
+    result += sizes->SizeNested(field_number, [&] {
+      return MessageSizes::DelimitedSize(
+                 google_firestore_v1_MapValue_FieldsEntry_key_tag,
+                 kv.first.size()) +
+             sizes->SizeNested(
+                 google_firestore_v1_MapValue_FieldsEntry_value_tag,
+                 [&] { return ValueSize(kv.second, sizes); });
+    });
+  }
+  return result;
+}
+
+void WriteFields(Writer* writer,
+                 uint32_t field_number,
+                 const FieldValue::Map& fields,
+                 MessageSizes* sizes) {
+  for (const auto& kv : fields) {
+    sizes->WriteNested(writer, field_number, [&] {
+      writer->WriteTag(PB_WT_STRING,
+                       google_firestore_v1_MapValue_FieldsEntry_key_tag);
+      writer->WriteString(kv.first);
+      sizes->WriteNested(
+          writer, google_firestore_v1_MapValue_FieldsEntry_value_tag,
+          [&] { WriteValue(writer, kv.second, sizes); });
+    });
+  }
+}
+
+size_t ValueSize(const FieldValue& value, MessageSizes* sizes) {
+  switch (value.type()) {
+    case FieldValue::Type::Null:
+      return IntegerSize(google_firestore_v1_Value_null_value_tag,
+                         google_protobuf_NullValue_NULL_VALUE);
+
+    case FieldValue::Type::Boolean:
+      return IntegerSize(google_firestore_v1_Value_boolean_value_tag,
+                         value.boolean_value());
+
+    case FieldValue::Type::Integer:
+      return IntegerSize(google_firestore_v1_Value_integer_value_tag,
+                         value.integer_value());
+
+    case FieldValue::Type::Double:
+      return DoubleSize(google_firestore_v1_Value_double_value_tag);
+
+    case FieldValue::Type::Timestamp:
+      return sizes->SizeNested(
+          google_firestore_v1_Value_timestamp_value_tag,
+          [&] { return TimestampSize(value.timestamp_value()); });
+
+    case FieldValue::Type::ServerTimestamp:
+      // TODO(rsgowman): Implement
+      abort();
+
+    case FieldValue::Type::String:
+      return MessageSizes::DelimitedSize(
+          google_firestore_v1_Value_string_value_tag,
+          value.string_value().size());
+
+    case FieldValue::Type::Blob:
+      return MessageSizes::DelimitedSize(
+          google_firestore_v1_Value_bytes_value_tag, value.blob_value().size());
+
+    case FieldValue::Type::Reference:
+      // TODO(rsgowman): Implement
+      abort();
+
+    case FieldValue::Type::GeoPoint:
+      // Both coordinates are always written, so that -0.0 survives.
+      return sizes->SizeNested(
+          google_firestore_v1_Value_geo_point_value_tag, [] {
+            return DoubleSize(google_type_LatLng_latitude_tag) +
+                   DoubleSize(google_type_LatLng_longitude_tag);
+          });
+
+    case FieldValue::Type::Array:
+      return sizes->SizeNested(
+          google_firestore_v1_Value_array_value_tag, [&] {
+            size_t result = 0;
+            for (const FieldValue& element : value.array_value()) {
+              result += sizes->SizeNested(
+                  google_firestore_v1_ArrayValue_values_tag,
+                  [&] { return ValueSize(element, sizes); });
+            }
+            return result;
+          });
+
+    case FieldValue::Type::Object:
+      return sizes->SizeNested(google_firestore_v1_Value_map_value_tag, [&] {
+        return FieldsSize(google_firestore_v1_MapValue_fields_tag,
+                          value.object_value(), sizes);
+      });
+  }
+  UNREACHABLE();
+}
+
+void WriteValue(Writer* writer, const FieldValue& value, MessageSizes* sizes) {
+  switch (value.type()) {
+    case FieldValue::Type::Null:
+      writer->WriteTag(PB_WT_VARINT, google_firestore_v1_Value_null_value_tag);
+      writer->WriteInteger(google_protobuf_NullValue_NULL_VALUE);
+      return;
+
+    case FieldValue::Type::Boolean:
+      writer->WriteTag(PB_WT_VARINT,
+                       google_firestore_v1_Value_boolean_value_tag);
+      writer->WriteBool(value.boolean_value());
+      return;
+
+    case FieldValue::Type::Integer:
+      writer->WriteTag(PB_WT_VARINT,
+                       google_firestore_v1_Value_integer_value_tag);
+      writer->WriteInteger(value.integer_value());
+      return;
+
+    case FieldValue::Type::Double:
+      writer->WriteTag(PB_WT_64BIT, google_firestore_v1_Value_double_value_tag);
+      writer->WriteDouble(value.double_value());
+      return;
+
+    case FieldValue::Type::Timestamp:
+      sizes->WriteNested(
+          writer, google_firestore_v1_Value_timestamp_value_tag,
+          [&] { WriteTimestamp(writer, value.timestamp_value()); });
+      return;
+
+    case FieldValue::Type::ServerTimestamp:
+      // TODO(rsgowman): Implement
+      abort();
+
+    case FieldValue::Type::String:
+      writer->WriteTag(PB_WT_STRING,
+                       google_firestore_v1_Value_string_value_tag);
+      writer->WriteString(value.string_value());
+      return;
+
+    case FieldValue::Type::Blob:
+      writer->WriteTag(PB_WT_STRING, google_firestore_v1_Value_bytes_value_tag);
+      writer->WriteString(nanopb::MakeStringView(value.blob_value()));
+      return;
+
+    case FieldValue::Type::Reference:
+      // TODO(rsgowman): Implement
+      abort();
+
+    case FieldValue::Type::GeoPoint:
+      sizes->WriteNested(
+          writer, google_firestore_v1_Value_geo_point_value_tag, [&] {
+            const GeoPoint& geo_point = value.geo_point_value();
+            writer->WriteTag(PB_WT_64BIT, google_type_LatLng_latitude_tag);
+            writer->WriteDouble(geo_point.latitude());
+            writer->WriteTag(PB_WT_64BIT, google_type_LatLng_longitude_tag);
+            writer->WriteDouble(geo_point.longitude());
+          });
+      return;
+
+    case FieldValue::Type::Array:
+      sizes->WriteNested(
+          writer, google_firestore_v1_Value_array_value_tag, [&] {
+            for (const FieldValue& element : value.array_value()) {
+              sizes->WriteNested(writer,
+                                 google_firestore_v1_ArrayValue_values_tag,
+                                 [&] { WriteValue(writer, element, sizes); });
+            }
+          });
+      return;
+
+    case FieldValue::Type::Object:
+      sizes->WriteNested(writer, google_firestore_v1_Value_map_value_tag, [&] {
+        WriteFields(writer, google_firestore_v1_MapValue_fields_tag,
+                    value.object_value(), sizes);
+      });
+      return;
+  }
+  UNREACHABLE();
+}
+
 /**
  * Creates the prefix for a fully qualified resource path, without a local path
  * on the end.
@@ -257,7 +640,7 @@ Serializer::Serializer(model::DatabaseId database_id)
 
 void Serializer::FreeNanopbMessage(const pb_field_t fields[],
                                    void* dest_struct) {
-  pb_release(fields, dest_struct);
+  nanopb::ReleaseMessage(fields, dest_struct);
 }
 
 google_firestore_v1_Value Serializer::EncodeFieldValue(
@@ -303,8 +686,8 @@ google_firestore_v1_Value Serializer::EncodeFieldValue(
     case FieldValue::Type::Blob:
       result.which_value_type = google_firestore_v1_Value_bytes_value_tag;
       // Copy the blob so that pb_release can do the right thing.
-      result.bytes_value =
-          nanopb::CopyBytesArray(field_value.blob_value().get());
+      result.bytes_value = nanopb::AllocateBytesArray(
+          field_value.blob_value().data(), field_value.blob_value().size());
       return result;
 
     case FieldValue::Type::Reference:
@@ -329,6 +712,13 @@ google_firestore_v1_Value Serializer::EncodeFieldValue(
   UNREACHABLE();
 }
 
+void Serializer::WriteFieldValue(ByteStringWriter* writer,
+                                 const FieldValue& field_value) {
+  MessageSizes sizes;
+  writer->Reserve(writer->size() + ValueSize(field_value, &sizes));
+  WriteValue(writer, field_value, &sizes);
+}
+
 FieldValue Serializer::DecodeFieldValue(Reader* reader,
                                         const google_firestore_v1_Value& msg) {
   switch (msg.which_value_type) {
@@ -360,7 +750,7 @@ FieldValue Serializer::DecodeFieldValue(Reader* reader,
     }
 
     case google_firestore_v1_Value_string_value_tag:
-      return FieldValue::FromString(DecodeString(msg.string_value));
+      return StringInterner::Shared().Intern(DecodeString(msg.string_value));
 
     case google_firestore_v1_Value_bytes_value_tag:
       return FieldValue::FromBlob(ByteString(msg.bytes_value));
@@ -390,6 +780,137 @@ FieldValue Serializer::DecodeFieldValue(Reader* reader,
   UNREACHABLE();
 }
 
+FieldValue Serializer::ReadFieldValue(Reader* reader) {
+  // Value is a oneof, so the last value field on the wire wins.
+  absl::optional<FieldValue> result;
+  while (reader->ReadTag()) {
+    switch (reader->field_number()) {
+      case google_firestore_v1_Value_null_value_tag:
+        if (reader->ReadInteger() != google_protobuf_NullValue_NULL_VALUE) {
+          reader->Fail(
+              "Input proto bytes cannot be parsed (invalid null value)");
+        }
+        result = FieldValue::Null();
+        break;
+
+      case google_firestore_v1_Value_boolean_value_tag:
+        result = FieldValue::FromBoolean(reader->ReadBool());
+        break;
+
+      case google_firestore_v1_Value_integer_value_tag:
+        result = FieldValue::FromInteger(reader->ReadInteger());
+        break;
+
+      case google_firestore_v1_Value_double_value_tag:
+        result = FieldValue::FromDouble(reader->ReadDouble());
+        break;
+
+      case google_firestore_v1_Value_timestamp_value_tag:
+        result = FieldValue::FromTimestamp(
+            DecodeTimestamp(reader, ReadTimestampProto(reader)));
+        break;
+
+      case google_firestore_v1_Value_string_value_tag:
+        result = StringInterner::Shared().Intern(reader->ReadString());
+        break;
+
+      case google_firestore_v1_Value_bytes_value_tag:
+        result = FieldValue::FromBlob(reader->ReadBytes());
+        break;
+
+      case google_firestore_v1_Value_reference_value_tag:
+        // TODO(b/74243929): Implement remaining types.
+        HARD_FAIL("Unhandled message field number (tag): %i.",
+                  reader->field_number());
+
+      case google_firestore_v1_Value_geo_point_value_tag:
+        result = FieldValue::FromGeoPoint(
+            DecodeGeoPoint(reader, ReadLatLngProto(reader)));
+        break;
+
+      case google_firestore_v1_Value_array_value_tag:
+        result = FieldValue::FromArray(ReadArrayValue(reader));
+        break;
+
+      case google_firestore_v1_Value_map_value_tag:
+        result = FieldValue::FromMap(ReadMapValue(reader));
+        break;
+
+      default:
+        reader->SkipField();
+    }
+  }
+
+  if (!reader->status().ok()) return FieldValue::Null();
+  if (!result) {
+    reader->Fail("Invalid type while decoding FieldValue: 0");
+    return FieldValue::Null();
+  }
+  return *std::move(result);
+}
+
+std::unique_ptr<Document> Serializer::ReadDocument(Reader* reader) const {
+  std::string name;
+  FieldValue::Map fields;
+  google_protobuf_Timestamp update_time{};
+  while (reader->ReadTag()) {
+    switch (reader->field_number()) {
+      case google_firestore_v1_Document_name_tag:
+        name = reader->ReadString();
+        break;
+
+      case google_firestore_v1_Document_fields_tag: {
+        FieldValue::Map::value_type kv = ReadFieldsEntry(reader);
+        if (kv.first.empty()) {
+          reader->Fail(
+              "Invalid message: Empty key while decoding a Map field value.");
+        }
+        fields = fields.insert(std::move(kv.first), std::move(kv.second));
+        break;
+      }
+
+      case google_firestore_v1_Document_update_time_tag:
+        update_time = ReadTimestampProto(reader);
+        break;
+
+      default:
+        // Document.create_time is ignored, as in DecodeDocument.
+        reader->SkipField();
+    }
+  }
+
+  SnapshotVersion version = DecodeSnapshotVersion(reader, update_time);
+  DocumentKey key = DecodeKey(reader, name);
+  if (!reader->status().ok()) return nullptr;
+
+  return absl::make_unique<Document>(ObjectValue::FromMap(std::move(fields)),
+                                     std::move(key), std::move(version),
+                                     DocumentState::kSynced);
+}
+
+ByteString Serializer::ReadDocumentChangeBytes(Reader* reader) {
+  ByteString result;
+  while (reader->ReadTag()) {
+    if (reader->field_number() !=
+        google_firestore_v1_ListenResponse_document_change_tag) {
+      reader->SkipField();
+      continue;
+    }
+
+    reader->ReadNestedMessage([&result](Reader* change) {
+      while (change->ReadTag()) {
+        if (change->field_number() ==
+            google_firestore_v1_DocumentChange_document_tag) {
+          result = change->ReadBytes();
+        } else {
+          change->SkipField();
+        }
+      }
+    });
+  }
+  return result;
+}
+
 std::string Serializer::EncodeKey(const DocumentKey& key) const {
   return EncodeResourceName(database_id_, key.path());
 }
@@ -449,6 +970,26 @@ google_firestore_v1_Document Serializer::EncodeDocument(
   return result;
 }
 
+void Serializer::WriteDocument(ByteStringWriter* writer,
+                               const DocumentKey& key,
+                               const ObjectValue& value) const {
+  std::string name = EncodeKey(key);
+  const FieldValue::Map& fields = value.GetInternalValue();
+
+  MessageSizes sizes;
+  size_t size =
+      MessageSizes::DelimitedSize(google_firestore_v1_Document_name_tag,
+                                  name.size()) +
+      FieldsSize(google_firestore_v1_Document_fields_tag, fields, &sizes);
+  writer->Reserve(writer->size() + size);
+
+  writer->WriteTag(PB_WT_STRING, google_firestore_v1_Document_name_tag);
+  writer->WriteString(name);
+  WriteFields(writer, google_firestore_v1_Document_fields_tag, fields, &sizes);
+
+  // As in EncodeDocument, skip the output-only create_time and update_time.
+}
+
 std::unique_ptr<model::MaybeDocument> Serializer::DecodeMaybeDocument(
     Reader* reader,
     const google_firestore_v1_BatchGetDocumentsResponse& response) const {
@@ -708,6 +1249,105 @@ model::FieldMask Serializer::DecodeDocumentMask(
   return model::FieldMask(std::move(fields));
 }
 
+namespace {
+
+google_firestore_v1_StructuredQuery_FieldReference EncodeFieldReference(
+    const FieldPath& field_path) {
+  google_firestore_v1_StructuredQuery_FieldReference result{};
+  result.field_path = Serializer::EncodeString(field_path.CanonicalString());
+  return result;
+}
+
+google_firestore_v1_StructuredQuery_FieldFilter_Operator
+EncodeFieldFilterOperator(Filter::Operator op) {
+  switch (op) {
+    case Filter::Operator::LessThan:
+      return google_firestore_v1_StructuredQuery_FieldFilter_Operator_LESS_THAN;
+    case Filter::Operator::LessThanOrEqual:
+      return google_firestore_v1_StructuredQuery_FieldFilter_Operator_LESS_THAN_OR_EQUAL;
+    case Filter::Operator::Equal:
+      return google_firestore_v1_StructuredQuery_FieldFilter_Operator_EQUAL;
+    case Filter::Operator::GreaterThanOrEqual:
+      return google_firestore_v1_StructuredQuery_FieldFilter_Operator_GREATER_THAN_OR_EQUAL;
+    case Filter::Operator::GreaterThan:
+      return google_firestore_v1_StructuredQuery_FieldFilter_Operator_GREATER_THAN;
+    case Filter::Operator::ArrayContains:
+      return google_firestore_v1_StructuredQuery_FieldFilter_Operator_ARRAY_CONTAINS;
+    case Filter::Operator::In:
+      return google_firestore_v1_StructuredQuery_FieldFilter_Operator_IN;
+    case Filter::Operator::ArrayContainsAny:
+      return google_firestore_v1_StructuredQuery_FieldFilter_Operator_ARRAY_CONTAINS_ANY;
+  }
+  UNREACHABLE();
+}
+
+/**
+ * Encodes a single filter, using a unary filter for equality with null or NaN
+ * like the backend expects.
+ */
+google_firestore_v1_StructuredQuery_Filter EncodeSingularFilter(
+    const FieldFilter& filter) {
+  google_firestore_v1_StructuredQuery_Filter result{};
+
+  if (filter.op() == Filter::Operator::Equal &&
+      (filter.value().is_null() || filter.value().is_nan())) {
+    result.which_filter_type =
+        google_firestore_v1_StructuredQuery_Filter_unary_filter_tag;
+    result.unary_filter.op =
+        filter.value().is_null()
+            ? google_firestore_v1_StructuredQuery_UnaryFilter_Operator_IS_NULL
+            : google_firestore_v1_StructuredQuery_UnaryFilter_Operator_IS_NAN;
+    result.unary_filter.which_operand_type =
+        google_firestore_v1_StructuredQuery_UnaryFilter_field_tag;
+    result.unary_filter.field = EncodeFieldReference(filter.field());
+    return result;
+  }
+
+  result.which_filter_type =
+      google_firestore_v1_StructuredQuery_Filter_field_filter_tag;
+  result.field_filter.field = EncodeFieldReference(filter.field());
+  result.field_filter.op = EncodeFieldFilterOperator(filter.op());
+  result.field_filter.value = Serializer::EncodeFieldValue(filter.value());
+  return result;
+}
+
+/**
+ * Encodes the filters of a query, combining them with an AND composite filter
+ * unless there's only one.
+ */
+google_firestore_v1_StructuredQuery_Filter EncodeFilters(
+    const Query::FilterList& filters) {
+  std::vector<google_firestore_v1_StructuredQuery_Filter> protos;
+  for (const auto& filter : filters) {
+    if (filter->IsAFieldFilter()) {
+      protos.push_back(
+          EncodeSingularFilter(static_cast<const FieldFilter&>(*filter)));
+    }
+  }
+  if (protos.size() == 1) {
+    return protos[0];
+  }
+
+  google_firestore_v1_StructuredQuery_Filter result{};
+  result.which_filter_type =
+      google_firestore_v1_StructuredQuery_Filter_composite_filter_tag;
+  google_firestore_v1_StructuredQuery_CompositeFilter& composite =
+      result.composite_filter;
+  composite.op =
+      google_firestore_v1_StructuredQuery_CompositeFilter_Operator_AND;
+
+  pb_size_t count = CheckedSize(protos.size());
+  composite.filters_count = count;
+  composite.filters =
+      MakeArray<google_firestore_v1_StructuredQuery_Filter>(count);
+  for (pb_size_t i = 0; i < count; ++i) {
+    composite.filters[i] = protos[i];
+  }
+  return result;
+}
+
+}  // namespace
+
 google_firestore_v1_Target_QueryTarget Serializer::EncodeQueryTarget(
     const core::Query& query) const {
   google_firestore_v1_Target_QueryTarget result{};
@@ -741,8 +1381,7 @@ google_firestore_v1_Target_QueryTarget Serializer::EncodeQueryTarget(
 
   // Encode the filters.
   if (!query.filters().empty()) {
-    // TODO(rsgowman): Implement
-    abort();
+    result.structured_query.where = EncodeFilters(query.filters());
   }
 
   // TODO(rsgowman): Encode the orders.
@@ -842,6 +1481,33 @@ Timestamp Serializer::DecodeTimestamp(
   return Timestamp{timestamp_proto.seconds, timestamp_proto.nanos};
 }
 
+SnapshotVersion Serializer::DecodeVersion(
+    nanopb::Reader* reader,
+    const google_firestore_v1_ListenResponse& listen_response) {
+  // We have only reached a consistent snapshot for the entire stream if there
+  // is a read_time set and it applies to all targets (i.e. the list of targets
+  // is empty). The backend is guaranteed to send such responses.
+  if (listen_response.which_response_type !=
+      google_firestore_v1_ListenResponse_target_change_tag) {
+    return SnapshotVersion::None();
+  }
+
+  const google_firestore_v1_TargetChange& change =
+      listen_response.target_change;
+  if (change.target_ids_count != 0) {
+    return SnapshotVersion::None();
+  }
+  return DecodeSnapshotVersion(reader, change.read_time);
+}
+
+Status Serializer::DecodeStatus(const google_rpc_Status& status_proto) {
+  if (status_proto.code == 0) {
+    return Status::OK();
+  }
+  return Status{static_cast<Error>(status_proto.code),
+                DecodeString(status_proto.message)};
+}
+
 /* static */
 google_type_LatLng Serializer::EncodeGeoPoint(const GeoPoint& geo_point_value) {
   google_type_LatLng result{};
@@ -36,6 +36,7 @@
 #include "Firestore/core/src/firebase/firestore/model/mutation.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
@@ -53,9 +54,13 @@ class LocalSerializer;
 
 namespace remote {
 
+/**
+ * Allocates a zero-initialized array for a repeated nanopb field, from the
+ * current nanopb::Arena if there is one.
+ */
 template <typename T>
 T* MakeArray(pb_size_t count) {
-  return reinterpret_cast<T*>(calloc(count, sizeof(T)));
+  return reinterpret_cast<T*>(nanopb::AllocateArray(count, sizeof(T)));
 }
 
 /**
@@ -68,6 +73,8 @@ T* MakeArray(pb_size_t count) {
  *
  * For encoded messages, FreeNanopbMessage() must be called on the returned
  * nanopb proto buffer or a memory leak will occur.
+ * Alternatively, encode within a nanopb::ArenaScope to release all the protos
+ * built for an operation at once.
  *
  * All errors that occur during serialization are fatal.
  *
@@ -117,7 +124,9 @@ class Serializer {
   /**
    * Release memory allocated by the Encode* methods that return protos.
    *
-   * This essentially wraps calls to nanopb's pb_release() method.
+   * This essentially wraps calls to nanopb's pb_release() method. While a
+   * nanopb::ArenaScope is active the Encode* methods allocate from its Arena,
+   * and this does nothing.
    */
   static void FreeNanopbMessage(const pb_field_t fields[], void* dest_struct);
 
@@ -127,6 +136,17 @@ class Serializer {
   static google_firestore_v1_Value EncodeFieldValue(
       const model::FieldValue& field_value);
 
+  /**
+   * Encodes the given FieldValue as a google_firestore_v1_Value message,
+   * writing straight into `writer` instead of building the nanopb struct.
+   *
+   * The sizes of all nested messages are computed in one pass over the value
+   * up front, so the value is walked exactly twice regardless of how deeply it
+   * nests, and `writer` is presized to fit the whole message.
+   */
+  static void WriteFieldValue(nanopb::ByteStringWriter* writer,
+                              const model::FieldValue& field_value);
+
   /**
    * @brief Converts from nanopb proto to the model FieldValue format.
    */
@@ -137,6 +157,16 @@ class Serializer {
   static model::FieldValue DecodeFieldValue(
       nanopb::Reader* reader, const google_firestore_v1_Value& proto);
 
+  /**
+   * Reads a FieldValue from a Reader positioned over the bytes of an encoded
+   * google_firestore_v1_Value message.
+   *
+   * Unlike DecodeFieldValue, this builds the model directly while reading the
+   * wire format. It never allocates the intermediate nanopb structs, so it
+   * needs no FreeNanopbMessage() call.
+   */
+  static model::FieldValue ReadFieldValue(nanopb::Reader* reader);
+
   /**
    * Encodes the given document key as a fully qualified name. This includes the
    * databaseId associated with this Serializer and the key path.
@@ -156,6 +186,14 @@ class Serializer {
   google_firestore_v1_Document EncodeDocument(
       const model::DocumentKey& key, const model::ObjectValue& value) const;
 
+  /**
+   * Encodes the Document as EncodeDocument does, writing straight into
+   * `writer`. See WriteFieldValue.
+   */
+  void WriteDocument(nanopb::ByteStringWriter* writer,
+                     const model::DocumentKey& key,
+                     const model::ObjectValue& value) const;
+
   /**
    * @brief Converts from nanopb proto to the model Document format.
    */
@@ -189,6 +227,22 @@ class Serializer {
   std::unique_ptr<model::Document> DecodeDocument(
       nanopb::Reader* reader, const google_firestore_v1_Document& proto) const;
 
+  /**
+   * Reads a Document from a Reader positioned over the bytes of an encoded
+   * google_firestore_v1_Document message. This is equivalent to reading the
+   * nanopb message and calling DecodeDocument, but without the intermediate
+   * nanopb structs. See ReadFieldValue.
+   */
+  std::unique_ptr<model::Document> ReadDocument(nanopb::Reader* reader) const;
+
+  /**
+   * Reads the still encoded google_firestore_v1_Document out of a Reader
+   * positioned over the bytes of a ListenResponse that holds a document
+   * change, without decoding the document. Returns an empty ByteString for
+   * any other response.
+   */
+  static nanopb::ByteString ReadDocumentChangeBytes(nanopb::Reader* reader);
+
   static google_protobuf_Timestamp EncodeVersion(
       const model::SnapshotVersion& version);
 
@@ -201,6 +255,21 @@ class Serializer {
   static Timestamp DecodeTimestamp(
       nanopb::Reader* reader, const google_protobuf_Timestamp& timestamp_proto);
 
+  /**
+   * Decodes the version of the snapshot that a watch stream response brings
+   * the client up to. Only a target change that applies to all targets carries
+   * one; for any other response, returns SnapshotVersion::None().
+   */
+  static model::SnapshotVersion DecodeVersion(
+      nanopb::Reader* reader,
+      const google_firestore_v1_ListenResponse& listen_response);
+
+  /**
+   * Converts the error that caused a watch target change into a Status, which
+   * is OK if there was no error.
+   */
+  static util::Status DecodeStatus(const google_rpc_Status& status_proto);
+
   static core::Query DecodeQueryTarget(
       nanopb::Reader* reader,
       const google_firestore_v1_Target_QueryTarget& proto);
@@ -22,6 +22,7 @@
 
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
 #include "Firestore/core/src/firebase/firestore/auth/token.h"
+#include "Firestore/core/src/firebase/firestore/remote/backoff_policy.h"
 #include "Firestore/core/src/firebase/firestore/remote/exponential_backoff.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
@@ -45,7 +46,7 @@ namespace remote {
  *   - Exponential backoff on failure (independent of the gRPC mechanism)
  *   - Authentication via CredentialsProvider
  *   - Dispatching all callbacks into the shared Firestore async queue
- *   - Closing idle streams after 60 seconds of inactivity
+ *   - Closing idle streams after 60 seconds (by default) of inactivity
  *
  * Subclasses of `Stream`:
  *
@@ -123,7 +124,8 @@ class Stream : public GrpcStreamObserver,
          auth::CredentialsProvider* credentials_provider,
          GrpcConnection* grpc_connection,
          util::TimerId backoff_timer_id,
-         util::TimerId idle_timer_id);
+         util::TimerId idle_timer_id,
+         const BackoffPolicy& backoff_policy = BackoffPolicy{});
 
   /**
    * Starts the stream. Only allowed if `IsStarted` returns false. The stream is
@@ -170,16 +172,23 @@ class Stream : public GrpcStreamObserver,
 
   /**
    * Marks this stream as idle. If no further actions are performed on the
-   * stream for one minute, the stream will automatically close itself and
-   * notify the stream's `OnClose` handler with Status::OK. The stream will then
-   * be in a non-started state, requiring the caller to start the stream again
-   * before further use.
+   * stream for the idle timeout, the stream will automatically close itself
+   * and notify the stream's `OnClose` handler with Status::OK. The stream will
+   * then be in a non-started state, requiring the caller to start the stream
+   * again before further use.
    *
    * Only streams that are in state 'Open' can be marked idle, as all other
    * states imply pending network operations.
    */
   void MarkIdle();
 
+  /**
+   * Sets how long the stream stays open after it is marked idle. Defaults to
+   * one minute. A longer timeout keeps the stream open for apps that use it
+   * every so often, at the cost of holding the connection open in between.
+   */
+  void set_idle_timeout(util::AsyncQueue::Milliseconds idle_timeout);
+
   /**
    * Marks the stream as active again, preventing auto-closing of the stream.
    * Can be called from any state -- if the stream is not in state `Open`, this
@@ -198,6 +207,17 @@ class Stream : public GrpcStreamObserver,
   void Write(grpc::ByteBuffer&& message);
   std::string GetDebugDescription() const;
 
+  /**
+   * Closes the stream because a response from the server couldn't be handled,
+   * for subclasses that handle responses after `NotifyStreamResponse` has
+   * returned.
+   */
+  void CloseDueToResponseError(const util::Status& status);
+
+  const std::shared_ptr<util::AsyncQueue>& worker_queue() const {
+    return worker_queue_;
+  }
+
   ExponentialBackoff backoff_;
 
  private:
@@ -216,6 +236,9 @@ class Stream : public GrpcStreamObserver,
   void Close(const util::Status& status);
   void HandleErrorStatus(const util::Status& status);
 
+  void ObserveNetwork();
+  void OnNetworkAvailable();
+
   void RequestCredentials();
   void ResumeStartWithCredentials(
       const util::StatusOr<auth::Token>& maybe_token);
@@ -232,8 +255,12 @@ class Stream : public GrpcStreamObserver,
   GrpcConnection* grpc_connection_ = nullptr;
 
   util::TimerId idle_timer_id_{};
+  util::AsyncQueue::Milliseconds idle_timeout_;
   util::DelayedOperation idleness_timer_;
 
+  bool reset_backoff_on_network_available_ = false;
+  bool observing_network_ = false;
+
   // Used to prevent auth if the stream happens to be restarted before token is
   // received.
   int close_count_ = 0;
@@ -40,14 +40,7 @@ using util::StringFormat;
 
 namespace {
 
-/**
- * Initial backoff time after an error.
- * Set to 1s according to https://cloud.google.com/apis/design/errors.
- */
-const double kBackoffFactor = 1.5;
-const AsyncQueue::Milliseconds kBackoffInitialDelay{std::chrono::seconds(1)};
-const AsyncQueue::Milliseconds kBackoffMaxDelay{std::chrono::seconds(60)};
-/** The time a stream stays open after it is marked idle. */
+/** The default time a stream stays open after it is marked idle. */
 const AsyncQueue::Milliseconds kIdleTimeout{std::chrono::seconds(60)};
 
 }  // namespace
@@ -56,13 +49,16 @@ Stream::Stream(const std::shared_ptr<AsyncQueue>& worker_queue,
                CredentialsProvider* credentials_provider,
                GrpcConnection* grpc_connection,
                TimerId backoff_timer_id,
-               TimerId idle_timer_id)
-    : backoff_{worker_queue, backoff_timer_id, kBackoffFactor,
-               kBackoffInitialDelay, kBackoffMaxDelay},
+               TimerId idle_timer_id,
+               const BackoffPolicy& backoff_policy)
+    : backoff_{worker_queue, backoff_timer_id, backoff_policy},
       credentials_provider_{credentials_provider},
       worker_queue_{worker_queue},
       grpc_connection_{grpc_connection},
-      idle_timer_id_{idle_timer_id} {
+      idle_timer_id_{idle_timer_id},
+      idle_timeout_{kIdleTimeout},
+      reset_backoff_on_network_available_{
+          backoff_policy.reset_on_network_available} {
 }
 
 // Check state
@@ -82,6 +78,10 @@ bool Stream::IsStarted() const {
 void Stream::Start() {
   EnsureOnQueue();
 
+  if (reset_backoff_on_network_available_ && !observing_network_) {
+    ObserveNetwork();
+  }
+
   if (state_ == State::Error) {
     BackoffAndTryRestarting();
     return;
@@ -165,6 +165,33 @@ void Stream::BackoffAndTryRestarting() {
   });
 }
 
+void Stream::ObserveNetwork() {
+  observing_network_ = true;
+
+  // The connection outlives the stream, so make sure it doesn't try to access
+  // a deleted object.
+  std::weak_ptr<Stream> weak_this{shared_from_this()};
+  grpc_connection_->AddNetworkAvailableCallback([weak_this] {
+    auto strong_this = weak_this.lock();
+    if (strong_this) {
+      strong_this->OnNetworkAvailable();
+    }
+  });
+}
+
+void Stream::OnNetworkAvailable() {
+  EnsureOnQueue();
+
+  LOG_DEBUG("%s network available, resetting backoff", GetDebugDescription());
+  backoff_.Reset();
+
+  // Don't wait out a delay that was picked while the network was down.
+  if (state_ == State::Backoff) {
+    state_ = State::Error;
+    BackoffAndTryRestarting();
+  }
+}
+
 void Stream::InhibitBackoff() {
   EnsureOnQueue();
 
@@ -183,10 +210,15 @@ void Stream::MarkIdle() {
 
   if (IsOpen() && !idleness_timer_) {
     idleness_timer_ = worker_queue_->EnqueueAfterDelay(
-        kIdleTimeout, idle_timer_id_, [this] { Stop(); });
+        idle_timeout_, idle_timer_id_, [this] { Stop(); });
   }
 }
 
+void Stream::set_idle_timeout(AsyncQueue::Milliseconds idle_timeout) {
+  HARD_ASSERT(idle_timeout.count() >= 0, "Idle timeout must be non-negative");
+  idle_timeout_ = idle_timeout;
+}
+
 void Stream::CancelIdleCheck() {
   EnsureOnQueue();
   idleness_timer_.Cancel();
@@ -207,14 +239,20 @@ void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
 
   Status read_status = NotifyStreamResponse(message);
   if (!read_status.ok()) {
-    grpc_stream_->FinishImmediately();
-    // Don't expect gRPC to produce status -- since the error happened on the
-    // client, we have all the information we need.
-    OnStreamFinish(read_status);
-    return;
+    CloseDueToResponseError(read_status);
   }
 }
 
+void Stream::CloseDueToResponseError(const Status& status) {
+  EnsureOnQueue();
+  HARD_ASSERT(IsStarted(), "Response error for a stopped stream.");
+
+  grpc_stream_->FinishImmediately();
+  // Don't expect gRPC to produce status -- since the error happened on the
+  // client, we have all the information we need.
+  OnStreamFinish(status);
+}
+
 // Stopping
 
 void Stream::Stop() {
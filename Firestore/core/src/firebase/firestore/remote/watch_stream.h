@@ -21,11 +21,15 @@
 #error "This header only supports Objective-C++"
 #endif  // !defined(__OBJC__)
 
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/backoff_policy.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
 #include "Firestore/core/src/firebase/firestore/remote/stream.h"
@@ -85,7 +89,8 @@ class WatchStream : public Stream {
               auth::CredentialsProvider* credentials_provider,
               FSTSerializerBeta* serializer,
               GrpcConnection* grpc_connection,
-              WatchStreamCallback* callback);
+              WatchStreamCallback* callback,
+              const BackoffPolicy& backoff_policy = BackoffPolicy{});
 
   /**
    * Registers interest in the results of the given query. If the query includes
@@ -95,6 +100,15 @@ class WatchStream : public Stream {
    */
   virtual /*virtual for tests only*/ void WatchQuery(FSTQueryData* query);
 
+  /**
+   * Registers interest in the results of all of the given queries, as if by
+   * calling `WatchQuery` for each, in order. When there are many queries, as
+   * when restoring listens after the stream reconnects, the requests are
+   * encoded concurrently and then written to the stream back to back.
+   */
+  virtual /*virtual for tests only*/ void WatchQueries(
+      const std::vector<FSTQueryData*>& queries);
+
   /**
    * Unregisters interest in the results of the query associated with the given
    * `target_id`.
@@ -103,6 +117,15 @@ class WatchStream : public Stream {
       model::TargetId target_id);
 
  private:
+  /** A `ListenResponse` decoded off the worker queue. */
+  struct DecodedResponse {
+    util::Status status;
+    // Only parsed when logging is enabled.
+    GCFSListenResponse* proto = nil;
+    std::unique_ptr<WatchChange> change;
+    model::SnapshotVersion snapshot_version;
+  };
+
   std::unique_ptr<GrpcStream> CreateGrpcStream(
       GrpcConnection* grpc_connection, const auth::Token& token) override;
   void TearDown(GrpcStream* grpc_stream) override;
@@ -115,8 +138,39 @@ class WatchStream : public Stream {
     return "WatchStream";
   }
 
+  static DecodedResponse Decode(const bridge::WatchStreamSerializer& serializer,
+                                const grpc::ByteBuffer& message);
+
+  /** Decodes the given message on a background thread. */
+  void DecodeConcurrently(const grpc::ByteBuffer& message);
+
+  /**
+   * Accepts a response decoded by `DecodeConcurrently` and passes on any
+   * responses that are now next in line.
+   */
+  void OnResponseDecoded(int generation,
+                         uint64_t sequence,
+                         DecodedResponse response);
+
+  util::Status DeliverResponse(const DecodedResponse& response);
+
   bridge::WatchStreamSerializer serializer_bridge_;
   WatchStreamCallback* callback_;
+
+  /**
+   * Large responses are decoded concurrently, but must still be passed on in
+   * the order they arrived. Each one gets a sequence number, and responses
+   * that finish decoding early wait in `decoded_responses_` for their turn.
+   */
+  uint64_t next_decode_sequence_ = 0;
+  uint64_t next_delivery_sequence_ = 0;
+  std::map<uint64_t, DecodedResponse> decoded_responses_;
+
+  /**
+   * Incremented whenever the stream closes so that responses decoded for a
+   * previous instance of the stream are dropped.
+   */
+  int decode_generation_ = 0;
 };
 
 }  // namespace remote
@@ -16,9 +16,15 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
 
+#include <dispatch/dispatch.h>
+
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
 
 #import "Firestore/Protos/objc/google/firestore/v1/Firestore.pbobjc.h"
 
@@ -33,13 +39,34 @@ using util::AsyncQueue;
 using util::TimerId;
 using util::Status;
 
+namespace {
+
+/**
+ * Below this many requests, encoding them one by one on the worker queue is
+ * cheaper than farming them out.
+ */
+constexpr size_t kMinConcurrentWatchRequests = 8;
+
+/**
+ * Responses smaller than this are decoded right on the worker queue, unless
+ * larger responses ahead of them are still being decoded.
+ */
+constexpr size_t kMinConcurrentDecodeBytes = 16 * 1024;
+
+}  // namespace
+
 WatchStream::WatchStream(const std::shared_ptr<AsyncQueue>& async_queue,
                          CredentialsProvider* credentials_provider,
                          FSTSerializerBeta* serializer,
                          GrpcConnection* grpc_connection,
-                         WatchStreamCallback* callback)
-    : Stream{async_queue, credentials_provider, grpc_connection,
-             TimerId::ListenStreamConnectionBackoff, TimerId::ListenStreamIdle},
+                         WatchStreamCallback* callback,
+                         const BackoffPolicy& backoff_policy)
+    : Stream{async_queue,
+             credentials_provider,
+             grpc_connection,
+             TimerId::ListenStreamConnectionBackoff,
+             TimerId::ListenStreamIdle,
+             backoff_policy},
       serializer_bridge_{serializer},
       callback_{NOT_NULL(callback)} {
 }
@@ -53,6 +80,41 @@ void WatchStream::WatchQuery(FSTQueryData* query) {
   Write(serializer_bridge_.ToByteBuffer(request));
 }
 
+void WatchStream::WatchQueries(const std::vector<FSTQueryData*>& queries) {
+  EnsureOnQueue();
+
+  if (queries.size() < kMinConcurrentWatchRequests) {
+    for (FSTQueryData* query : queries) {
+      WatchQuery(query);
+    }
+    return;
+  }
+
+  // Encoding only reads the queries and the serializer, so it's safe to do
+  // from several threads at once. `dispatch_apply` doesn't return until all
+  // requests are encoded, so nothing here outlives this call.
+  std::vector<GCFSListenRequest*> requests(queries.size());
+  std::vector<grpc::ByteBuffer> buffers(queries.size());
+  const bridge::WatchStreamSerializer* serializer = &serializer_bridge_;
+  FSTQueryData* const* queries_in = queries.data();
+  GCFSListenRequest* __strong* requests_out = requests.data();
+  grpc::ByteBuffer* buffers_out = buffers.data();
+  dispatch_apply(
+      queries.size(), dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0),
+      ^(size_t i) {
+        GCFSListenRequest* request =
+            serializer->CreateWatchRequest(queries_in[i]);
+        buffers_out[i] = bridge::WatchStreamSerializer::ToByteBuffer(request);
+        requests_out[i] = request;
+      });
+
+  for (size_t i = 0; i != buffers.size(); ++i) {
+    LOG_DEBUG("%s watch: %s", GetDebugDescription(),
+              serializer_bridge_.Describe(requests[i]));
+    Write(std::move(buffers[i]));
+  }
+}
+
 void WatchStream::UnwatchTargetId(TargetId target_id) {
   EnsureOnQueue();
 
@@ -66,7 +128,8 @@ void WatchStream::UnwatchTargetId(TargetId target_id) {
 std::unique_ptr<GrpcStream> WatchStream::CreateGrpcStream(
     GrpcConnection* grpc_connection, const Token& token) {
   return grpc_connection->CreateStream("/google.firestore.v1.Firestore/Listen",
-                                       token, this);
+                                       GrpcConnection::StreamKind::Watch, token,
+                                       this);
 }
 
 void WatchStream::TearDown(GrpcStream* grpc_stream) {
@@ -78,28 +141,116 @@ void WatchStream::NotifyStreamOpen() {
 }
 
 Status WatchStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
-  Status status;
-  GCFSListenResponse* response =
-      serializer_bridge_.ParseResponse(message, &status);
-  if (!status.ok()) {
-    return status;
+  FIRESTORE_TRACE_SPAN("WatchStream::NotifyStreamResponse");
+  static util::Counter& bytes_received =
+      util::MetricsRegistry::Default().GetCounter(
+          "remote.watch_bytes_received");
+  bytes_received.Increment(message.Length());
+
+  bool decodes_pending = next_decode_sequence_ != next_delivery_sequence_;
+  if (decodes_pending || message.Length() >= kMinConcurrentDecodeBytes) {
+    DecodeConcurrently(message);
+    return Status::OK();
+  }
+
+  return DeliverResponse(Decode(serializer_bridge_, message));
+}
+
+WatchStream::DecodedResponse WatchStream::Decode(
+    const bridge::WatchStreamSerializer& serializer,
+    const grpc::ByteBuffer& message) {
+  DecodedResponse result;
+  result.change = serializer.DecodeResponse(message, &result.snapshot_version,
+                                            &result.status);
+
+  // The Objective-C proto is only needed to describe the response in the log.
+  if (result.status.ok() && bridge::IsLoggingEnabled()) {
+    Status parse_status;
+    result.proto = serializer.ParseResponse(message, &parse_status);
+  }
+  return result;
+}
+
+void WatchStream::DecodeConcurrently(const grpc::ByteBuffer& message) {
+  uint64_t sequence = next_decode_sequence_++;
+  int generation = decode_generation_;
+
+  // The block may outlive the stream, so it holds its own copies of everything
+  // it needs. Copying a `ByteBuffer` only adds references to its slices.
+  std::weak_ptr<Stream> weak_this{shared_from_this()};
+  std::shared_ptr<AsyncQueue> queue = worker_queue();
+  bridge::WatchStreamSerializer serializer = serializer_bridge_;
+  grpc::ByteBuffer buffer = message;
+
+  dispatch_async(
+      dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        auto decoded = std::make_shared<DecodedResponse>(
+            WatchStream::Decode(serializer, buffer));
+        queue->EnqueueRelaxed([weak_this, generation, sequence, decoded] {
+          auto strong_this = weak_this.lock();
+          if (!strong_this) {
+            return;
+          }
+          static_cast<WatchStream*>(strong_this.get())
+              ->OnResponseDecoded(generation, sequence, std::move(*decoded));
+        });
+      });
+}
+
+void WatchStream::OnResponseDecoded(int generation,
+                                    uint64_t sequence,
+                                    DecodedResponse response) {
+  EnsureOnQueue();
+  if (generation != decode_generation_) {
+    return;
+  }
+
+  decoded_responses_.emplace(sequence, std::move(response));
+  while (true) {
+    auto next = decoded_responses_.find(next_delivery_sequence_);
+    if (next == decoded_responses_.end()) {
+      break;
+    }
+    DecodedResponse ready = std::move(next->second);
+    decoded_responses_.erase(next);
+    ++next_delivery_sequence_;
+
+    Status status = DeliverResponse(ready);
+    if (!status.ok()) {
+      CloseDueToResponseError(status);
+    }
+    // The callback may have closed the stream.
+    if (generation != decode_generation_) {
+      return;
+    }
+  }
+}
+
+Status WatchStream::DeliverResponse(const DecodedResponse& response) {
+  FIRESTORE_TRACE_SPAN("WatchStream::DeliverResponse");
+  if (!response.status.ok()) {
+    return response.status;
   }
 
   if (bridge::IsLoggingEnabled()) {
     LOG_DEBUG("%s response: %s", GetDebugDescription(),
-              serializer_bridge_.Describe(response));
+              serializer_bridge_.Describe(response.proto));
   }
 
   // A successful response means the stream is healthy.
   backoff_.Reset();
 
-  callback_->OnWatchStreamChange(
-      *serializer_bridge_.ToWatchChange(response),
-      serializer_bridge_.ToSnapshotVersion(response));
+  callback_->OnWatchStreamChange(*response.change, response.snapshot_version);
   return Status::OK();
 }
 
 void WatchStream::NotifyStreamClose(const Status& status) {
+  // Anything still being decoded belongs to the stream that just closed.
+  ++decode_generation_;
+  next_decode_sequence_ = 0;
+  next_delivery_sequence_ = 0;
+  decoded_responses_.clear();
+
   callback_->OnWatchStreamClose(status);
 }
 
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/write_pipeline_window.h"
+
+#include <algorithm>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+constexpr int WritePipelineWindow::kDefaultMaxSize;
+constexpr int WritePipelineWindow::kInitialSize;
+
+WritePipelineWindow::WritePipelineWindow(int max_size, bool adaptive)
+    : max_size_{max_size}, adaptive_{adaptive} {
+  HARD_ASSERT(max_size >= 1, "Write pipeline size must be at least 1, got %s",
+              max_size);
+  size_ = adaptive ? std::min(kInitialSize, max_size) : max_size;
+}
+
+void WritePipelineWindow::RecordWrite(clock::time_point now) {
+  if (!adaptive_) {
+    return;
+  }
+
+  send_times_.push_back(now);
+}
+
+void WritePipelineWindow::RecordAck(clock::time_point now) {
+  // Writes sent before the last `Reset` are resent, and recorded again, once
+  // the stream is reestablished, so there's normally a send time to pair with.
+  if (!adaptive_ || send_times_.empty()) {
+    return;
+  }
+
+  clock::duration latency = now - send_times_.front();
+  send_times_.pop_front();
+
+  min_latency_ = std::min(min_latency_, latency);
+  if (latency <= 2 * min_latency_ && size_ < max_size_) {
+    ++size_;
+  }
+}
+
+void WritePipelineWindow::RecordBackpressure() {
+  if (!adaptive_) {
+    return;
+  }
+
+  size_ = std::max(1, size_ / 2);
+}
+
+void WritePipelineWindow::Reset() {
+  send_times_.clear();
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WRITE_PIPELINE_WINDOW_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WRITE_PIPELINE_WINDOW_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <deque>
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * Decides how many mutation batches `RemoteStore` may have in flight on the
+ * write stream at once.
+ *
+ * In fixed mode the window is always `max_size`. In adaptive mode the window
+ * starts at `kInitialSize` (or `max_size`, if smaller) and:
+ *
+ *   - grows by one whenever a write is acknowledged within twice the fastest
+ *     round trip seen so far, i.e. while the backend keeps up;
+ *   - halves whenever the backend signals backpressure.
+ *
+ * The window never drops below one or exceeds `max_size`.
+ */
+class WritePipelineWindow {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /** The depth of the pipeline when not otherwise configured. */
+  static constexpr int kDefaultMaxSize = 10;
+
+  /** The size an adaptive window starts at. */
+  static constexpr int kInitialSize = 10;
+
+  /** Creates a fixed window of `kDefaultMaxSize`. */
+  WritePipelineWindow() : WritePipelineWindow(kDefaultMaxSize, false) {
+  }
+
+  WritePipelineWindow(int max_size, bool adaptive);
+
+  /** The number of batches that may currently be in flight. */
+  int size() const {
+    return size_;
+  }
+
+  int max_size() const {
+    return max_size_;
+  }
+
+  bool adaptive() const {
+    return adaptive_;
+  }
+
+  /** Records that a batch was sent on the write stream at `now`. */
+  void RecordWrite(clock::time_point now);
+
+  /**
+   * Records that the oldest in-flight batch was acknowledged at `now`,
+   * potentially growing the window.
+   */
+  void RecordAck(clock::time_point now);
+
+  /** Records that the backend pushed back, shrinking the window. */
+  void RecordBackpressure();
+
+  /**
+   * Forgets about batches in flight, e.g. because the write stream was
+   * restarted and they will be sent again. The window size is kept.
+   */
+  void Reset();
+
+ private:
+  int max_size_ = 0;
+  bool adaptive_ = false;
+  int size_ = 0;
+
+  std::deque<clock::time_point> send_times_;
+  clock::duration min_latency_ = clock::duration::max();
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WRITE_PIPELINE_WINDOW_H_
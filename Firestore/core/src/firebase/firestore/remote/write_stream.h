@@ -27,6 +27,7 @@
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/remote/backoff_policy.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
 #include "Firestore/core/src/firebase/firestore/remote/stream.h"
@@ -103,7 +104,8 @@ class WriteStream : public Stream {
               auth::CredentialsProvider* credentials_provider,
               FSTSerializerBeta* serializer,
               GrpcConnection* grpc_connection,
-              WriteStreamCallback* callback);
+              WriteStreamCallback* callback,
+              const BackoffPolicy& backoff_policy = BackoffPolicy{});
 
   void SetLastStreamToken(NSData* token);
   /**
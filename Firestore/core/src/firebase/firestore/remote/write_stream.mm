@@ -18,6 +18,7 @@
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 
 #import "Firestore/Protos/objc/google/firestore/v1/Firestore.pbobjc.h"
@@ -36,9 +37,14 @@ WriteStream::WriteStream(const std::shared_ptr<AsyncQueue>& async_queue,
                          CredentialsProvider* credentials_provider,
                          FSTSerializerBeta* serializer,
                          GrpcConnection* grpc_connection,
-                         WriteStreamCallback* callback)
-    : Stream{async_queue, credentials_provider, grpc_connection,
-             TimerId::WriteStreamConnectionBackoff, TimerId::WriteStreamIdle},
+                         WriteStreamCallback* callback,
+                         const BackoffPolicy& backoff_policy)
+    : Stream{async_queue,
+             credentials_provider,
+             grpc_connection,
+             TimerId::WriteStreamConnectionBackoff,
+             TimerId::WriteStreamIdle,
+             backoff_policy},
       serializer_bridge_{serializer},
       callback_{NOT_NULL(callback)} {
 }
@@ -76,12 +82,17 @@ void WriteStream::WriteMutations(const std::vector<FSTMutation*>& mutations) {
   LOG_DEBUG("%s write request: %s", GetDebugDescription(),
             serializer_bridge_.Describe(request));
   Write(serializer_bridge_.ToByteBuffer(request));
+
+  static util::Counter& requests_sent =
+      util::MetricsRegistry::Default().GetCounter("remote.write_requests_sent");
+  requests_sent.Increment();
 }
 
 std::unique_ptr<GrpcStream> WriteStream::CreateGrpcStream(
     GrpcConnection* grpc_connection, const Token& token) {
   return grpc_connection->CreateStream("/google.firestore.v1.Firestore/Write",
-                                       token, this);
+                                       GrpcConnection::StreamKind::Write, token,
+                                       this);
 }
 
 void WriteStream::TearDown(GrpcStream* grpc_stream) {
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+#include "Firestore/core/src/firebase/firestore/util/config.h"
+#include "absl/base/config.h"
+
+// Counting needs thread-local state, so that each thread only sees its own
+// allocations.
+#if defined(FIRESTORE_COUNT_ALLOCATIONS) && defined(ABSL_HAVE_THREAD_LOCAL)
+#define FIRESTORE_ALLOCATION_COUNTING 1
+#endif
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+#if defined(FIRESTORE_ALLOCATION_COUNTING)
+
+// Trivially constructible and destructible, so that they are usable during
+// static initialization and after thread-local destruction.
+thread_local uint64_t thread_allocations = 0;
+thread_local uint64_t thread_allocated_bytes = 0;
+
+#endif  // defined(FIRESTORE_ALLOCATION_COUNTING)
+
+uint64_t ThreadAllocations() {
+#if defined(FIRESTORE_ALLOCATION_COUNTING)
+  return thread_allocations;
+#else
+  return 0;
+#endif
+}
+
+uint64_t ThreadAllocatedBytes() {
+#if defined(FIRESTORE_ALLOCATION_COUNTING)
+  return thread_allocated_bytes;
+#else
+  return 0;
+#endif
+}
+
+}  // namespace
+
+bool AllocationCountingEnabled() {
+#if defined(FIRESTORE_ALLOCATION_COUNTING)
+  return true;
+#else
+  return false;
+#endif
+}
+
+AllocationCounter::AllocationCounter() {
+  Reset();
+}
+
+uint64_t AllocationCounter::allocations() const {
+  return ThreadAllocations() - start_allocations_;
+}
+
+uint64_t AllocationCounter::allocated_bytes() const {
+  return ThreadAllocatedBytes() - start_bytes_;
+}
+
+void AllocationCounter::Reset() {
+  start_allocations_ = ThreadAllocations();
+  start_bytes_ = ThreadAllocatedBytes();
+}
+
+#if defined(FIRESTORE_ALLOCATION_COUNTING)
+
+namespace {
+
+/** Allocates `size` bytes the way the default `operator new` does. */
+void* CountedAllocate(std::size_t size, bool throw_on_failure) {
+  ++thread_allocations;
+  thread_allocated_bytes += size;
+
+  if (size == 0) {
+    size = 1;
+  }
+  while (true) {
+    void* result = std::malloc(size);
+    if (result) {
+      return result;
+    }
+
+    std::new_handler handler = std::get_new_handler();
+    if (handler) {
+      handler();
+    } else if (throw_on_failure) {
+      throw std::bad_alloc();
+    } else {
+      return nullptr;
+    }
+  }
+}
+
+}  // namespace
+
+#endif  // defined(FIRESTORE_ALLOCATION_COUNTING)
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#if defined(FIRESTORE_ALLOCATION_COUNTING)
+
+// Replacements for the global allocation functions. They are defined in this
+// file so that linking anything that reads the counts also links them.
+
+void* operator new(std::size_t size) {
+  return firebase::firestore::util::CountedAllocate(size, true);
+}
+
+void* operator new[](std::size_t size) {
+  return firebase::firestore::util::CountedAllocate(size, true);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return firebase::firestore::util::CountedAllocate(size, false);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return firebase::firestore::util::CountedAllocate(size, false);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+#endif  // defined(__cpp_sized_deallocation)
+
+#endif  // defined(FIRESTORE_ALLOCATION_COUNTING)
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ALLOCATION_COUNTER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * Returns true if this build counts heap allocations, which it does when
+ * configured with the CMake option `FIRESTORE_COUNT_ALLOCATIONS`.
+ *
+ * In that mode the global `operator new` and `operator delete` are replaced
+ * with versions that count every allocation made through them. Allocations
+ * made directly with `malloc`, as nanopb does, are not counted.
+ */
+bool AllocationCountingEnabled();
+
+/**
+ * Counts the heap allocations made by the current thread from its
+ * construction on, so that tests can check allocation budgets of hot paths and
+ * benchmarks can report allocations per operation:
+ *
+ *     AllocationCounter counter;
+ *     DecodeDocument(bytes);
+ *     EXPECT_LE(counter.allocations(), 12u);
+ *
+ * Always counts zero unless `AllocationCountingEnabled()`.
+ */
+class AllocationCounter {
+ public:
+  AllocationCounter();
+
+  /** The number of allocations made since construction or `Reset()`. */
+  uint64_t allocations() const;
+
+  /** The number of bytes requested by those allocations. */
+  uint64_t allocated_bytes() const;
+
+  void Reset();
+
+ private:
+  uint64_t start_allocations_ = 0;
+  uint64_t start_bytes_ = 0;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ALLOCATION_COUNTER_H_
@@ -16,18 +16,104 @@
 
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <string>
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/util/diagnostic_log.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
 #include "absl/memory/memory.h"
 
 namespace firebase {
 namespace firestore {
 namespace util {
 
+namespace {
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+const char* TimerIdLabel(TimerId timer_id) {
+  switch (timer_id) {
+    case TimerId::All:
+      return "All";
+    case TimerId::ListenStreamIdle:
+      return "ListenStreamIdle";
+    case TimerId::ListenStreamConnectionBackoff:
+      return "ListenStreamConnectionBackoff";
+    case TimerId::WriteStreamIdle:
+      return "WriteStreamIdle";
+    case TimerId::WriteStreamConnectionBackoff:
+      return "WriteStreamConnectionBackoff";
+    case TimerId::OnlineStateTimeout:
+      return "OnlineStateTimeout";
+    case TimerId::GarbageCollectionDelay:
+      return "GarbageCollectionDelay";
+    case TimerId::GroupCommitFlush:
+      return "GroupCommitFlush";
+    case TimerId::ListenerEventCoalescing:
+      return "ListenerEventCoalescing";
+    case TimerId::IdleCompaction:
+      return "IdleCompaction";
+    case TimerId::WriteAckCoalescing:
+      return "WriteAckCoalescing";
+    case TimerId::TargetPersistence:
+      return "TargetPersistence";
+  }
+  UNREACHABLE();
+}
+
+// The leeway of timers that only do housekeeping or give up on connections is
+// a fraction of their usual delay; timers that hold back work someone is
+// waiting on get none.
+Executor::Milliseconds DefaultTimerLeeway(TimerId timer_id) {
+  using Milliseconds = Executor::Milliseconds;
+  switch (timer_id) {
+    case TimerId::ListenStreamIdle:
+    case TimerId::WriteStreamIdle:
+      return Milliseconds{1000};
+    case TimerId::ListenStreamConnectionBackoff:
+    case TimerId::WriteStreamConnectionBackoff:
+      return Milliseconds{100};
+    case TimerId::OnlineStateTimeout:
+      return Milliseconds{500};
+    case TimerId::GarbageCollectionDelay:
+    case TimerId::IdleCompaction:
+    case TimerId::TargetPersistence:
+      return Milliseconds{5000};
+    case TimerId::All:
+    case TimerId::GroupCommitFlush:
+    case TimerId::ListenerEventCoalescing:
+    case TimerId::WriteAckCoalescing:
+      return Milliseconds{0};
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
+struct AsyncQueue::InstrumentedOperation {
+  void operator()() const {
+    if (counts_as_pending) {
+      --queue->pending_operations_count_;
+    }
+    queue->ExecuteInstrumented(label, due, operation);
+  }
+
+  AsyncQueue* queue;
+  const char* label;
+  Clock::time_point due;
+  Operation operation;
+  // Whether the operation was put on the executor by `EnqueueRelaxed`, and is
+  // counted by `pending_operations_count_` until it starts.
+  bool counts_as_pending;
+};
+
 AsyncQueue::AsyncQueue(std::unique_ptr<Executor> executor)
     : executor_{std::move(executor)} {
   is_operation_in_progress_ = false;
+  pending_operations_count_ = 0;
 }
 
 // TODO(varconst): assert in destructor that the queue is empty.
@@ -59,18 +145,127 @@ void AsyncQueue::ExecuteBlocking(const Operation& operation) {
   is_operation_in_progress_ = false;
 }
 
-void AsyncQueue::Enqueue(const Operation& operation) {
+void AsyncQueue::Enqueue(Operation&& operation) {
+  Enqueue(nullptr, std::move(operation));
+}
+
+void AsyncQueue::Enqueue(const char* label, Operation&& operation) {
   VerifySequentialOrder();
-  EnqueueRelaxed(operation);
+  EnqueueRelaxed(label, std::move(operation));
+}
+
+void AsyncQueue::EnqueueRelaxed(Operation&& operation) {
+  EnqueueRelaxed(nullptr, std::move(operation));
 }
 
-void AsyncQueue::EnqueueRelaxed(const Operation& operation) {
-  executor_->Execute(Wrap(operation));
+void AsyncQueue::EnqueueRelaxed(const char* label, Operation&& operation) {
+  static Histogram& queue_depth =
+      MetricsRegistry::Default().GetHistogram("async_queue.depth");
+
+  int depth = ++pending_operations_count_;
+  queue_depth.Record(static_cast<uint64_t>(depth));
+
+  executor_->Execute(InstrumentedOperation{this, label, Clock::now(),
+                                           std::move(operation), true});
+}
+
+void AsyncQueue::ExecuteInstrumented(const char* label,
+                                     Clock::time_point enqueued,
+                                     const Operation& operation) {
+  static Histogram& wait_histogram =
+      MetricsRegistry::Default().GetHistogram("async_queue.wait_micros");
+
+  Clock::time_point start = Clock::now();
+  // A delayed operation run early in tests may start before it is due.
+  microseconds wait_time =
+      start > enqueued ? duration_cast<microseconds>(start - enqueued)
+                       : microseconds{0};
+  wait_histogram.Record(static_cast<uint64_t>(wait_time.count()));
+
+  ExecuteBlocking(operation);
+  if (!instrumentation_enabled_) {
+    return;
+  }
+
+  auto run_time = duration_cast<microseconds>(Clock::now() - start);
+  RunTimeHistogram(nullptr).Record(static_cast<uint64_t>(run_time.count()));
+  if (label) {
+    RunTimeHistogram(label).Record(static_cast<uint64_t>(run_time.count()));
+  }
+
+  if (run_time >= long_task_threshold_) {
+    LOG_DIAGNOSTIC(
+        "Operation %s ran on the queue for %s us after waiting %s us",
+        label ? label : "(unlabeled)", run_time.count(), wait_time.count());
+    if (long_task_listener_) {
+      OperationTiming timing;
+      timing.label = label;
+      timing.wait_time = wait_time;
+      timing.run_time = run_time;
+      long_task_listener_(timing);
+    }
+  }
+}
+
+Histogram& AsyncQueue::RunTimeHistogram(const char* label) {
+  Histogram*& histogram = run_time_histograms_[label];
+  if (!histogram) {
+    std::string name = "async_queue.run_micros";
+    if (label) {
+      name += ".";
+      name += label;
+    }
+    histogram = &MetricsRegistry::Default().GetHistogram(name);
+  }
+  return *histogram;
+}
+
+void AsyncQueue::EnableInstrumentation(microseconds threshold,
+                                       LongTaskListener listener) {
+  VerifyIsCurrentQueue();
+  instrumentation_enabled_ = true;
+  long_task_threshold_ = threshold;
+  long_task_listener_ = std::move(listener);
+}
+
+void AsyncQueue::EnqueueBackground(Operation&& operation) {
+  std::lock_guard<std::mutex> lock{background_mutex_};
+  background_operations_.push_back(
+      BackgroundOperation{std::move(operation), Clock::now()});
+  if (!is_background_lane_scheduled_) {
+    is_background_lane_scheduled_ = true;
+    executor_->Execute([this] { RunNextBackgroundOperation(); });
+  }
+}
+
+void AsyncQueue::RunNextBackgroundOperation() {
+  // Any regular operation enqueued before this point is already on the
+  // executor, so going to the back of the executor lets all of them run first.
+  if (pending_operations_count_ > 0) {
+    executor_->Execute([this] { RunNextBackgroundOperation(); });
+    return;
+  }
+
+  BackgroundOperation next;
+  {
+    std::lock_guard<std::mutex> lock{background_mutex_};
+    next = std::move(background_operations_.front());
+    background_operations_.pop_front();
+  }
+
+  ExecuteInstrumented("Background", next.enqueued, next.operation);
+
+  std::lock_guard<std::mutex> lock{background_mutex_};
+  if (background_operations_.empty()) {
+    is_background_lane_scheduled_ = false;
+  } else {
+    executor_->Execute([this] { RunNextBackgroundOperation(); });
+  }
 }
 
 DelayedOperation AsyncQueue::EnqueueAfterDelay(const Milliseconds delay,
                                                const TimerId timer_id,
-                                               const Operation& operation) {
+                                               Operation&& operation) {
   VerifyIsCurrentExecutor();
 
   // While not necessarily harmful, we currently don't expect to have multiple
@@ -79,16 +274,34 @@ DelayedOperation AsyncQueue::EnqueueAfterDelay(const Milliseconds delay,
   HARD_ASSERT(!IsScheduled(timer_id),
               "Attempted to schedule multiple operations with id %s", timer_id);
 
-  Executor::TaggedOperation tagged{static_cast<int>(timer_id), Wrap(operation)};
+  const auto found = timer_leeways_.find(timer_id);
+  const Milliseconds leeway = found != timer_leeways_.end()
+                                  ? found->second
+                                  : DefaultTimerLeeway(timer_id);
+
+  Executor::TaggedOperation tagged{
+      static_cast<int>(timer_id), leeway,
+      Wrap(TimerIdLabel(timer_id), Clock::now() + delay, std::move(operation))};
   return executor_->Schedule(delay, std::move(tagged));
 }
 
-AsyncQueue::Operation AsyncQueue::Wrap(const Operation& operation) {
+void AsyncQueue::SetTimerLeeway(const TimerId timer_id,
+                                const Milliseconds leeway) {
+  VerifyIsCurrentExecutor();
+  HARD_ASSERT(leeway.count() >= 0, "Timer leeway must not be negative");
+  timer_leeways_[timer_id] = leeway;
+}
+
+Executor::Operation AsyncQueue::Wrap(const char* label,
+                                     Clock::time_point due,
+                                     Operation&& operation) {
+  static_assert(
+      Executor::Operation::StoresInline<InstrumentedOperation>(),
+      "Operations put on the executor by AsyncQueue must not allocate");
+
   // Decorator pattern: wrap `operation` into a call to `ExecuteBlocking` to
   // ensure that it doesn't spawn any nested operations.
-
-  // Note: can't move `operation` into lambda until C++14.
-  return [this, operation] { ExecuteBlocking(operation); };
+  return InstrumentedOperation{this, label, due, std::move(operation), false};
 }
 
 void AsyncQueue::VerifySequentialOrder() const {
@@ -102,9 +315,9 @@ void AsyncQueue::VerifySequentialOrder() const {
 
 // Test-only functions
 
-void AsyncQueue::EnqueueBlocking(const Operation& operation) {
+void AsyncQueue::EnqueueBlocking(Operation&& operation) {
   VerifySequentialOrder();
-  executor_->ExecuteBlocking(Wrap(operation));
+  executor_->ExecuteBlocking(Wrap(nullptr, Clock::now(), std::move(operation)));
 }
 
 bool AsyncQueue::IsScheduled(const TimerId timer_id) const {
@@ -19,15 +19,22 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT(build/c++11)
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <unordered_map>
 
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/unique_function.h"
 
 namespace firebase {
 namespace firestore {
 namespace util {
 
+class Histogram;
+
 /**
  * Well-known "timer" ids used when scheduling delayed operations on the
  * AsyncQueue. These ids can then be used from tests to check for the
@@ -57,7 +64,39 @@ enum class TimerId {
   /**
    * A timer used to periodically attempt LRU Garbage collection
    */
-  GarbageCollectionDelay
+  GarbageCollectionDelay,
+
+  /**
+   * A timer used to write local transactions that were committed as a group
+   * to disk once the group commit window has elapsed.
+   */
+  GroupCommitFlush,
+
+  /**
+   * A timer used by the event manager to raise the events that query listeners
+   * held back to respect their minimum event interval.
+   */
+  ListenerEventCoalescing,
+
+  /**
+   * A timer used to compact the parts of LevelDB where many rows were deleted
+   * once transactions have stopped for a while. Each transaction that commits
+   * in the meantime pushes it back.
+   */
+  IdleCompaction,
+
+  /**
+   * A timer used by the remote store to apply the write acknowledgements that
+   * arrived back to back together, once the operations already waiting on the
+   * queue have run.
+   */
+  WriteAckCoalescing,
+
+  /**
+   * A timer used by the client to periodically write the targets whose
+   * resume tokens the local store holds back in memory.
+   */
+  TargetPersistence
 };
 
 // A serial queue that executes given operations asynchronously, one at a time.
@@ -69,6 +108,10 @@ enum class TimerId {
 // normally cannot enqueue other operations for immediate execution (but see
 // `EnqueueRelaxed`).
 //
+// Operations put on the queue with `EnqueueBackground` form a separate lane
+// of lower priority work: they are FIFO-ordered among themselves, but each one
+// only runs once there are no regular operations waiting to run.
+//
 // `AsyncQueue` methods have particular expectations about whether they must be
 // invoked on the queue or not; check "preconditions" section in comments on
 // each method.
@@ -77,7 +120,9 @@ enum class TimerId {
 // and must *not* be used in regular code.
 class AsyncQueue {
  public:
-  using Operation = Executor::Operation;
+  // Operations are move-only, and ones capturing up to a few pointers and
+  // shared pointers are enqueued without allocating.
+  using Operation = UniqueFunction<void()>;
   using Milliseconds = Executor::Milliseconds;
 
   explicit AsyncQueue(std::unique_ptr<Executor> executor);
@@ -95,10 +140,29 @@ class AsyncQueue {
   // be called by a previously enqueued operation when it is run (as a special
   // case, destructors invoked when an enqueued operation has run and is being
   // destroyed may invoke `Enqueue`).
-  void Enqueue(const Operation& operation);
+  void Enqueue(Operation&& operation);
+
+  // Like `Enqueue`, but tags the `operation` with a `label` identifying the
+  // caller, which instrumentation reports the operation under. `label` must
+  // outlive the operation, such as a string literal.
+  void Enqueue(const char* label, Operation&& operation);
 
   // Like `Enqueue`, but without applying any prerequisite checks.
-  void EnqueueRelaxed(const Operation& operation);
+  void EnqueueRelaxed(Operation&& operation);
+  void EnqueueRelaxed(const char* label, Operation&& operation);
+
+  // Puts the `operation` on the background lane, to be executed once all
+  // operations put on the queue with `Enqueue` or `EnqueueRelaxed` (including
+  // the ones enqueued later) have run, while maintaining FIFO order among
+  // background operations. Use this for housekeeping (such as garbage
+  // collection) that shouldn't delay work a user is waiting on.
+  //
+  // Once a background operation starts, it runs to completion, so long-running
+  // work should be split into several operations.
+  //
+  // Unlike `Enqueue`, `EnqueueBackground` may be called by an operation that is
+  // currently running on the queue.
+  void EnqueueBackground(Operation&& operation);
 
   // Puts the `operation` on the queue to be executed `delay` milliseconds from
   // now, and returns a handle that allows to cancel the operation (provided it
@@ -114,7 +178,17 @@ class AsyncQueue {
   // queue.
   DelayedOperation EnqueueAfterDelay(Milliseconds delay,
                                      TimerId timer_id,
-                                     const Operation& operation);
+                                     Operation&& operation);
+
+  // Sets how much later than their due time operations tagged with `timer_id`
+  // may run, overriding the default leeway for `timer_id`. Where the executor
+  // supports it, timers due within each other's leeway are run in a single
+  // wakeup, which matters on battery-powered devices. Operations that are
+  // already scheduled keep the leeway they were scheduled with.
+  //
+  // Precondition: `SetTimerLeeway` is being invoked asynchronously on the
+  // queue.
+  void SetTimerLeeway(TimerId timer_id, Milliseconds leeway);
 
   // Direct execution
 
@@ -136,13 +210,38 @@ class AsyncQueue {
     return executor_.get();
   }
 
+  // Instrumentation
+
+  // How long an operation waited on the queue before it started, and how long
+  // it ran.
+  struct OperationTiming {
+    // The label the operation was enqueued with, the name of its `TimerId` if
+    // it was delayed, or null.
+    const char* label = nullptr;
+    std::chrono::microseconds wait_time{0};
+    std::chrono::microseconds run_time{0};
+  };
+
+  using LongTaskListener = std::function<void(const OperationTiming&)>;
+
+  // Starts recording how long each operation runs, into histograms of the
+  // default `MetricsRegistry` named "async_queue.run_micros" and, for labeled
+  // operations, "async_queue.run_micros.<label>". Operations that run for at
+  // least `threshold` are reported to `listener` on the queue once they
+  // finish, so that whatever starves the operations behind them can be found.
+  //
+  // Precondition: `EnableInstrumentation` is being invoked asynchronously on
+  // the queue.
+  void EnableInstrumentation(std::chrono::microseconds threshold,
+                             LongTaskListener listener);
+
   // Test-only interface follows
   // TODO(varconst): move the test-only interface into a helper object that is
   // a friend of AsyncQueue and delegates its public methods to private methods
   // on AsyncQueue.
 
   // Like `Enqueue`, but blocks until the `operation` is complete.
-  void EnqueueBlocking(const Operation& operation);
+  void EnqueueBlocking(Operation&& operation);
 
   // Checks whether an operation tagged with `timer_id` is currently scheduled
   // for execution in the future.
@@ -156,7 +255,37 @@ class AsyncQueue {
   void RunScheduledOperationsUntil(TimerId last_timer_id);
 
  private:
-  Operation Wrap(const Operation& operation);
+  using Clock = std::chrono::steady_clock;
+
+  // An operation waiting on the background lane.
+  struct BackgroundOperation {
+    Operation operation;
+    Clock::time_point enqueued;
+  };
+
+  // An operation on the executor that runs an `Operation` through
+  // `ExecuteInstrumented`.
+  struct InstrumentedOperation;
+
+  // Wraps `operation`, which is due to run at `due`, into a call to
+  // `ExecuteInstrumented`.
+  Executor::Operation Wrap(const char* label,
+                           Clock::time_point due,
+                           Operation&& operation);
+
+  // Runs `operation` like `ExecuteBlocking`, recording the time since it was
+  // `enqueued` (or became due) and, if instrumentation is enabled, the time it
+  // ran for. `label` may be null.
+  void ExecuteInstrumented(const char* label,
+                           Clock::time_point enqueued,
+                           const Operation& operation);
+
+  // Returns the histogram of the run times of operations with `label`.
+  Histogram& RunTimeHistogram(const char* label);
+
+  // Runs the oldest background operation, unless there are regular operations
+  // waiting to run, in which case it goes to the back of the queue instead.
+  void RunNextBackgroundOperation();
 
   // Asserts that the current invocation happens asynchronously on the queue.
   void VerifyIsCurrentExecutor() const;
@@ -164,6 +293,24 @@ class AsyncQueue {
 
   std::atomic<bool> is_operation_in_progress_;
   std::unique_ptr<Executor> executor_;
+
+  // The number of operations put on the executor by `EnqueueRelaxed` that
+  // haven't started running yet.
+  std::atomic<int> pending_operations_count_;
+
+  std::mutex background_mutex_;
+  std::deque<BackgroundOperation> background_operations_;
+  // Whether a call to `RunNextBackgroundOperation` is on the executor.
+  bool is_background_lane_scheduled_ = false;
+
+  // Instrumentation state, only accessed on the queue.
+  bool instrumentation_enabled_ = false;
+  std::chrono::microseconds long_task_threshold_{0};
+  LongTaskListener long_task_listener_;
+  std::unordered_map<const char*, Histogram*> run_time_histograms_;
+
+  // Leeways set by `SetTimerLeeway`, only accessed on the queue.
+  std::map<TimerId, Milliseconds> timer_leeways_;
 };
 
 }  // namespace util
@@ -16,10 +16,13 @@
 
 #include "Firestore/core/src/firebase/firestore/util/autoid.h"
 
-#include <random>
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
+#include "absl/base/config.h"
 
 namespace firebase {
 namespace firestore {
@@ -31,7 +34,66 @@ const int kAutoIdLength = 20;
 const char kAutoIdAlphabet[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
 
-SecureRandom shared_random;
+// The trailing null terminator isn't part of the alphabet.
+constexpr int kAlphabetSize = sizeof(kAutoIdAlphabet) - 1;
+
+// Random bytes at or above this are discarded, so that taking the rest modulo
+// `kAlphabetSize` picks every character with the same probability.
+constexpr int kAcceptedByteLimit = 256 - 256 % kAlphabetSize;
+
+// Hands out the characters of IDs from a buffer of random bytes, which it
+// refills a block at a time rather than drawing from `SecureRandom` for every
+// character.
+class AutoIdGenerator {
+ public:
+  void Append(std::string* auto_id) {
+    for (int i = 0; i < kAutoIdLength;) {
+      if (next_ == kBufferSize) {
+        random_.Fill(buffer_, kBufferSize);
+        next_ = 0;
+      }
+
+      uint8_t byte = buffer_[next_++];
+      if (byte < kAcceptedByteLimit) {
+        auto_id->push_back(kAutoIdAlphabet[byte % kAlphabetSize]);
+        ++i;
+      }
+    }
+  }
+
+ private:
+  // Enough for about 50 IDs.
+  static constexpr size_t kBufferSize = 1024;
+
+  SecureRandom random_;
+  uint8_t buffer_[kBufferSize] = {};
+  size_t next_ = kBufferSize;
+};
+
+constexpr size_t AutoIdGenerator::kBufferSize;
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+
+// Each thread has a generator of its own, so threads creating documents in
+// bulk don't contend on it.
+template <typename F>
+void WithGenerator(const F& f) {
+  thread_local AutoIdGenerator generator;
+  f(&generator);
+}
+
+#else
+
+template <typename F>
+void WithGenerator(const F& f) {
+  static auto* mutex = new std::mutex();
+  static auto* generator = new AutoIdGenerator();
+
+  std::lock_guard<std::mutex> lock{*mutex};
+  f(generator);
+}
+
+#endif  // defined(ABSL_HAVE_THREAD_LOCAL)
 
 }  // namespace
 
@@ -39,18 +101,23 @@ std::string CreateAutoId() {
   std::string auto_id;
   auto_id.reserve(kAutoIdLength);
 
-  // -2 here because:
-  //   * sizeof(kAutoIdAlphabet) includes the trailing null terminator
-  //   * uniform_int_distribution is inclusive on both sizes
-  std::uniform_int_distribution<int> letters(0, sizeof(kAutoIdAlphabet) - 2);
-
-  for (int i = 0; i < kAutoIdLength; i++) {
-    int rand_index = letters(shared_random);
-    auto_id.append(1, kAutoIdAlphabet[rand_index]);
-  }
+  WithGenerator(
+      [&](AutoIdGenerator* generator) { generator->Append(&auto_id); });
   return auto_id;
 }
 
+std::vector<std::string> CreateAutoIds(size_t count) {
+  std::vector<std::string> auto_ids(count);
+
+  WithGenerator([&](AutoIdGenerator* generator) {
+    for (std::string& auto_id : auto_ids) {
+      auto_id.reserve(kAutoIdLength);
+      generator->Append(&auto_id);
+    }
+  });
+  return auto_ids;
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/compressed_bitmap.h"
+
+#include <algorithm>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+uint64_t BitFor(uint16_t low) {
+  return uint64_t{1} << (low % 64);
+}
+
+}  // namespace
+
+constexpr size_t CompressedBitmap::kMaxArraySize;
+constexpr size_t CompressedBitmap::kMinBitmapSize;
+constexpr size_t CompressedBitmap::kWordsPerBitmap;
+
+bool CompressedBitmap::Add(uint32_t value) {
+  auto high = static_cast<uint16_t>(value >> 16);
+  auto chunk = FindChunk(high);
+  if (chunk == chunks_.end() || chunk->high != high) {
+    chunk = chunks_.emplace(chunk, high);
+  }
+
+  if (!AddToChunk(&*chunk, static_cast<uint16_t>(value))) return false;
+  ++size_;
+  return true;
+}
+
+bool CompressedBitmap::Remove(uint32_t value) {
+  auto high = static_cast<uint16_t>(value >> 16);
+  auto chunk = FindChunk(high);
+  if (chunk == chunks_.end() || chunk->high != high) return false;
+
+  if (!RemoveFromChunk(&*chunk, static_cast<uint16_t>(value))) return false;
+  --size_;
+  if (chunk->size == 0) {
+    chunks_.erase(chunk);
+  }
+  return true;
+}
+
+bool CompressedBitmap::Contains(uint32_t value) const {
+  auto high = static_cast<uint16_t>(value >> 16);
+  auto chunk = FindChunk(high);
+  if (chunk == chunks_.end() || chunk->high != high) return false;
+
+  return ChunkContains(*chunk, static_cast<uint16_t>(value));
+}
+
+bool CompressedBitmap::AddToChunk(Chunk* chunk, uint16_t low) {
+  if (chunk->dense()) {
+    uint64_t& word = chunk->words[low / 64];
+    if (word & BitFor(low)) return false;
+    word |= BitFor(low);
+    ++chunk->size;
+    return true;
+  }
+
+  std::vector<uint16_t>& values = chunk->values;
+  auto found = std::lower_bound(values.begin(), values.end(), low);
+  if (found != values.end() && *found == low) return false;
+  values.insert(found, low);
+  ++chunk->size;
+
+  if (values.size() > kMaxArraySize) {
+    chunk->words.assign(kWordsPerBitmap, 0);
+    for (uint16_t value : values) {
+      chunk->words[value / 64] |= BitFor(value);
+    }
+    std::vector<uint16_t>{}.swap(values);
+  }
+  return true;
+}
+
+bool CompressedBitmap::RemoveFromChunk(Chunk* chunk, uint16_t low) {
+  if (!chunk->dense()) {
+    std::vector<uint16_t>& values = chunk->values;
+    auto found = std::lower_bound(values.begin(), values.end(), low);
+    if (found == values.end() || *found != low) return false;
+    values.erase(found);
+    --chunk->size;
+    return true;
+  }
+
+  uint64_t& word = chunk->words[low / 64];
+  if (!(word & BitFor(low))) return false;
+  word &= ~BitFor(low);
+  --chunk->size;
+
+  if (chunk->size < kMinBitmapSize) {
+    chunk->values.reserve(chunk->size);
+    for (size_t i = 0; i != chunk->words.size(); ++i) {
+      for (uint64_t bits = chunk->words[i]; bits != 0; bits &= bits - 1) {
+        uint64_t lowest = bits & (~bits + 1);
+        int bit = Bits::Log2FloorNonZero64(lowest);
+        chunk->values.push_back(static_cast<uint16_t>(i * 64 + bit));
+      }
+    }
+    std::vector<uint64_t>{}.swap(chunk->words);
+  }
+  return true;
+}
+
+bool CompressedBitmap::ChunkContains(const Chunk& chunk, uint16_t low) {
+  if (chunk.dense()) {
+    return (chunk.words[low / 64] & BitFor(low)) != 0;
+  }
+  return std::binary_search(chunk.values.begin(), chunk.values.end(), low);
+}
+
+std::vector<CompressedBitmap::Chunk>::iterator CompressedBitmap::FindChunk(
+    uint16_t high) {
+  return std::lower_bound(
+      chunks_.begin(), chunks_.end(), high,
+      [](const Chunk& chunk, uint16_t high) { return chunk.high < high; });
+}
+
+std::vector<CompressedBitmap::Chunk>::const_iterator
+CompressedBitmap::FindChunk(uint16_t high) const {
+  return std::lower_bound(
+      chunks_.begin(), chunks_.end(), high,
+      [](const Chunk& chunk, uint16_t high) { return chunk.high < high; });
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
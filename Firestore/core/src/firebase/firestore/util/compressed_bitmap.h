@@ -0,0 +1,130 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_COMPRESSED_BITMAP_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_COMPRESSED_BITMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/bits.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * A set of 32-bit integers, stored in the style of a roaring bitmap.
+ *
+ * The values are split into chunks of 2^16 by their high 16 bits. A chunk with
+ * few values stores their low 16 bits in a sorted array, at two bytes per
+ * value; a chunk with many values stores a bitmap of 2^16 bits instead, which
+ * is never larger than the array would be. Sets of small, densely assigned IDs
+ * therefore take a small fraction of the memory of a node-based set.
+ */
+class CompressedBitmap {
+ public:
+  /** Adds the value to the set. Returns false if it was already present. */
+  bool Add(uint32_t value);
+
+  /** Removes the value from the set. Returns false if it wasn't present. */
+  bool Remove(uint32_t value);
+
+  bool Contains(uint32_t value) const;
+
+  /** The number of values in the set. */
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  /** Calls `callback` with each value in the set, in ascending order. */
+  template <typename Callback>
+  void ForEach(const Callback& callback) const;
+
+ private:
+  /** The number of values above which a chunk switches to a bitmap. */
+  static constexpr size_t kMaxArraySize = 4096;
+
+  /**
+   * The number of values below which a chunk switches back to an array. It's
+   * lower than kMaxArraySize so that alternately adding and removing a value
+   * doesn't convert the chunk every time.
+   */
+  static constexpr size_t kMinBitmapSize = kMaxArraySize / 2;
+
+  static constexpr size_t kWordsPerBitmap = (1 << 16) / 64;
+
+  struct Chunk {
+    explicit Chunk(uint16_t high) : high(high) {
+    }
+
+    bool dense() const {
+      return !words.empty();
+    }
+
+    uint16_t high;
+    uint32_t size = 0;
+    // The sorted low bits of the values, while the chunk isn't dense.
+    std::vector<uint16_t> values;
+    // A bit for each possible low half, once the chunk is dense.
+    std::vector<uint64_t> words;
+  };
+
+  static bool AddToChunk(Chunk* chunk, uint16_t low);
+  static bool RemoveFromChunk(Chunk* chunk, uint16_t low);
+  static bool ChunkContains(const Chunk& chunk, uint16_t low);
+
+  std::vector<Chunk>::iterator FindChunk(uint16_t high);
+  std::vector<Chunk>::const_iterator FindChunk(uint16_t high) const;
+
+  // Sorted by `high`.
+  std::vector<Chunk> chunks_;
+  size_t size_ = 0;
+};
+
+template <typename Callback>
+void CompressedBitmap::ForEach(const Callback& callback) const {
+  for (const Chunk& chunk : chunks_) {
+    uint32_t base = static_cast<uint32_t>(chunk.high) << 16;
+    if (!chunk.dense()) {
+      for (uint16_t low : chunk.values) {
+        callback(base | low);
+      }
+      continue;
+    }
+
+    for (size_t i = 0; i != chunk.words.size(); ++i) {
+      uint64_t word = chunk.words[i];
+      while (word != 0) {
+        uint64_t lowest = word & (~word + 1);
+        int bit = Bits::Log2FloorNonZero64(lowest);
+        callback(base | static_cast<uint32_t>(i * 64 + bit));
+        word ^= lowest;
+      }
+    }
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_COMPRESSED_BITMAP_H_
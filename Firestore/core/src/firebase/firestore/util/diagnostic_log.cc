@@ -0,0 +1,237 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/diagnostic_log.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace internal {
+
+namespace {
+
+constexpr size_t kFormatWord = 0;
+constexpr size_t kTimestampWord = 1;
+constexpr size_t kTypesWord = 2;
+constexpr size_t kFirstValueWord = 3;
+
+constexpr int kTypeBits = 4;
+constexpr int kFirstTypeBit = 8;
+
+int64_t NowMicros() {
+  namespace chr = std::chrono;
+  return chr::duration_cast<chr::microseconds>(
+             chr::system_clock::now().time_since_epoch())
+      .count();
+}
+
+size_t ArgCount(uint64_t types_word) {
+  return static_cast<size_t>(types_word & 0xff);
+}
+
+DiagnosticArgType ArgType(uint64_t types_word, size_t arg) {
+  int shift = kFirstTypeBit + static_cast<int>(arg) * kTypeBits;
+  return static_cast<DiagnosticArgType>((types_word >> shift) & 0xf);
+}
+
+size_t WordsForBytes(size_t bytes) {
+  return (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+}
+
+}  // namespace
+
+DiagnosticRecordEncoder::DiagnosticRecordEncoder(const char* format)
+    : size_{kFirstValueWord} {
+  words_[kFormatWord] = reinterpret_cast<uintptr_t>(format);
+  words_[kTimestampWord] = static_cast<uint64_t>(NowMicros());
+}
+
+bool DiagnosticRecordEncoder::AddType(DiagnosticArgType type) {
+  size_t arg = ArgCount(words_[kTypesWord]);
+  if (arg == DiagnosticLog::kMaxArgs) {
+    return false;
+  }
+
+  int shift = kFirstTypeBit + static_cast<int>(arg) * kTypeBits;
+  words_[kTypesWord] |= static_cast<uint64_t>(type) << shift;
+  words_[kTypesWord] += 1;
+  return true;
+}
+
+void DiagnosticRecordEncoder::AddWord(DiagnosticArgType type, uint64_t value) {
+  if (size_ == words_.size() || !AddType(type)) {
+    return;
+  }
+  words_[size_++] = value;
+}
+
+void DiagnosticRecordEncoder::AddDouble(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  AddWord(DiagnosticArgType::kDouble, bits);
+}
+
+void DiagnosticRecordEncoder::AddString(absl::string_view value) {
+  // The length takes a word of its own.
+  if (size_ == words_.size()) {
+    return;
+  }
+
+  size_t capacity = (words_.size() - size_ - 1) * sizeof(uint64_t);
+  size_t length = std::min(value.size(), capacity);
+  DiagnosticArgType type = length == value.size()
+                               ? DiagnosticArgType::kString
+                               : DiagnosticArgType::kTruncatedString;
+  if (!AddType(type)) {
+    return;
+  }
+
+  words_[size_++] = length;
+  if (length > 0) {
+    std::memcpy(&words_[size_], value.data(), length);
+    size_ += WordsForBytes(length);
+  }
+}
+
+DiagnosticLogRecord DecodeDiagnosticRecord(
+    const std::array<uint64_t, kDiagnosticRecordWords>& words) {
+  std::vector<std::string> texts;
+  size_t index = kFirstValueWord;
+  uint64_t types = words[kTypesWord];
+  for (size_t arg = 0; arg < ArgCount(types); ++arg) {
+    uint64_t value = words[index++];
+    switch (ArgType(types, arg)) {
+      case DiagnosticArgType::kBool:
+        texts.push_back(value ? "true" : "false");
+        break;
+      case DiagnosticArgType::kSigned:
+        texts.push_back(absl::StrCat(static_cast<int64_t>(value)));
+        break;
+      case DiagnosticArgType::kUnsigned:
+        texts.push_back(absl::StrCat(value));
+        break;
+      case DiagnosticArgType::kDouble: {
+        double number;
+        std::memcpy(&number, &value, sizeof(number));
+        texts.push_back(absl::StrCat(number));
+        break;
+      }
+      case DiagnosticArgType::kPointer:
+        texts.push_back(absl::StrCat(absl::Hex{value}));
+        break;
+      case DiagnosticArgType::kString:
+      case DiagnosticArgType::kTruncatedString: {
+        auto bytes = reinterpret_cast<const char*>(&words[index]);
+        std::string text{bytes, static_cast<size_t>(value)};
+        if (ArgType(types, arg) == DiagnosticArgType::kTruncatedString) {
+          text += "...";
+        }
+        texts.push_back(std::move(text));
+        index += WordsForBytes(value);
+        break;
+      }
+    }
+  }
+
+  std::vector<absl::string_view> pieces{texts.begin(), texts.end()};
+  auto format = reinterpret_cast<const char*>(words[kFormatWord]);
+
+  DiagnosticLogRecord result;
+  result.timestamp_micros = static_cast<int64_t>(words[kTimestampWord]);
+  result.message = StringFormatPieces(format, pieces.data(),
+                                      pieces.data() + pieces.size());
+  return result;
+}
+
+}  // namespace internal
+
+constexpr size_t DiagnosticLog::kDefaultCapacity;
+constexpr size_t DiagnosticLog::kMaxArgs;
+
+DiagnosticLog::DiagnosticLog(size_t capacity) : capacity_{1} {
+  while (capacity_ < capacity) {
+    capacity_ *= 2;
+  }
+  slots_.reset(new Slot[capacity_]);
+}
+
+DiagnosticLog& DiagnosticLog::Default() {
+  // Never destroyed, so that messages can be recorded during static
+  // destruction.
+  static DiagnosticLog* log = new DiagnosticLog();
+  return *log;
+}
+
+void DiagnosticLog::Append(
+    const std::array<uint64_t, internal::kDiagnosticRecordWords>& words) {
+  uint64_t index = next_index_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots_[index & (capacity_ - 1)];
+
+  // A sequence lock: Decode skips a slot whose sequence changes while it is
+  // being copied, or that holds some other message than the expected one.
+  slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < words.size(); ++i) {
+    slot.words[i].store(words[i], std::memory_order_relaxed);
+  }
+  slot.sequence.store(index * 2 + 2, std::memory_order_release);
+}
+
+std::vector<DiagnosticLogRecord> DiagnosticLog::Decode() const {
+  uint64_t end = next_index_.load(std::memory_order_acquire);
+  uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+
+  std::vector<DiagnosticLogRecord> result;
+  for (uint64_t index = begin; index != end; ++index) {
+    const Slot& slot = slots_[index & (capacity_ - 1)];
+    uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != index * 2 + 2) {
+      continue;
+    }
+
+    std::array<uint64_t, internal::kDiagnosticRecordWords> words;
+    for (size_t i = 0; i < words.size(); ++i) {
+      words[i] = slot.words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+      continue;
+    }
+
+    result.push_back(internal::DecodeDiagnosticRecord(words));
+  }
+  return result;
+}
+
+std::string DiagnosticLog::Dump() const {
+  std::string result;
+  for (const DiagnosticLogRecord& record : Decode()) {
+    absl::StrAppend(&result, record.timestamp_micros, " ", record.message,
+                    "\n");
+  }
+  return result;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
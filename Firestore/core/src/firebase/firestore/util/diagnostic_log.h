@@ -0,0 +1,264 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_DIAGNOSTIC_LOG_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_DIAGNOSTIC_LOG_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+// Records a message into the default diagnostic log if it is enabled, and
+// logs it as LOG_DEBUG would. Arguments may be evaluated twice.
+//
+// Unlike LOG_DEBUG, the message is not formatted when it is recorded: the
+// record keeps a pointer to the format and the raw values of the arguments,
+// so recording is cheap enough to leave on in production.
+//
+// @param format A string literal suitable for use with `util::StringFormat`.
+// @param ... Up to `DiagnosticLog::kMaxArgs` arguments, each a bool, a number,
+//     an enum, a pointer, or a string.
+#define LOG_DIAGNOSTIC(...)                                       \
+  do {                                                            \
+    namespace _util = firebase::firestore::util;                  \
+    _util::DiagnosticLog& _log = _util::DiagnosticLog::Default(); \
+    if (_log.enabled()) {                                         \
+      _log.Record(__VA_ARGS__);                                   \
+    }                                                             \
+    LOG_DEBUG(__VA_ARGS__);                                       \
+  } while (0)
+
+/** A message decoded from a diagnostic log. */
+struct DiagnosticLogRecord {
+  /** When the message was recorded, in microseconds since the Unix epoch. */
+  int64_t timestamp_micros = 0;
+
+  std::string message;
+};
+
+namespace internal {
+
+/** The number of 64-bit words a diagnostic log record takes up. */
+constexpr size_t kDiagnosticRecordWords = 16;
+
+/** The kinds of values a diagnostic log record can hold. */
+enum class DiagnosticArgType : uint8_t {
+  kBool = 1,
+  kSigned,
+  kUnsigned,
+  kDouble,
+  kPointer,
+  kString,
+  kTruncatedString,
+};
+
+/**
+ * Encodes a message into the words of a diagnostic log record:
+ *
+ *   * word 0 holds the address of the format, which identifies it;
+ *   * word 1 holds the timestamp;
+ *   * word 2 holds the number of arguments in its low byte and the type of
+ *     each argument in the 4-bit groups above it;
+ *   * the remaining words hold the values of the arguments. A string takes a
+ *     word for its length followed by its bytes, truncated to the space left.
+ *
+ * Arguments that do not fit are dropped.
+ */
+class DiagnosticRecordEncoder {
+ public:
+  explicit DiagnosticRecordEncoder(const char* format);
+
+  void Add(bool value) {
+    AddWord(DiagnosticArgType::kBool, value ? 1 : 0);
+  }
+
+  template <typename T,
+            typename std::enable_if<std::is_integral<T>{} &&
+                                        std::is_signed<T>{},
+                                    int>::type = 0>
+  void Add(T value) {
+    AddWord(DiagnosticArgType::kSigned,
+            static_cast<uint64_t>(static_cast<int64_t>(value)));
+  }
+
+  template <typename T,
+            typename std::enable_if<std::is_integral<T>{} &&
+                                        std::is_unsigned<T>{} &&
+                                        !std::is_same<T, bool>{},
+                                    int>::type = 0>
+  void Add(T value) {
+    AddWord(DiagnosticArgType::kUnsigned, static_cast<uint64_t>(value));
+  }
+
+  template <typename T,
+            typename std::enable_if<std::is_enum<T>{}, int>::type = 0>
+  void Add(T value) {
+    Add(static_cast<typename std::underlying_type<T>::type>(value));
+  }
+
+  template <typename T,
+            typename std::enable_if<std::is_floating_point<T>{}, int>::type = 0>
+  void Add(T value) {
+    AddDouble(static_cast<double>(value));
+  }
+
+  void Add(std::nullptr_t) {
+    AddString("null");
+  }
+
+  void Add(const char* value) {
+    AddString(value == nullptr ? "null" : value);
+  }
+
+  void Add(const std::string& value) {
+    AddString(value);
+  }
+
+  void Add(absl::string_view value) {
+    AddString(value);
+  }
+
+  template <typename T,
+            typename std::enable_if<
+                !std::is_same<typename std::remove_cv<T>::type, char>{},
+                int>::type = 0>
+  void Add(T* value) {
+    AddWord(DiagnosticArgType::kPointer, reinterpret_cast<uintptr_t>(value));
+  }
+
+  const std::array<uint64_t, kDiagnosticRecordWords>& words() const {
+    return words_;
+  }
+
+ private:
+  bool AddType(DiagnosticArgType type);
+  void AddWord(DiagnosticArgType type, uint64_t value);
+  void AddDouble(double value);
+  void AddString(absl::string_view value);
+
+  std::array<uint64_t, kDiagnosticRecordWords> words_{};
+  size_t size_ = 0;
+};
+
+DiagnosticLogRecord DecodeDiagnosticRecord(
+    const std::array<uint64_t, kDiagnosticRecordWords>& words);
+
+}  // namespace internal
+
+/**
+ * A fixed-size, in-memory log of recent diagnostic messages, meant to be left
+ * on in production and dumped when investigating a problem.
+ *
+ * Recording a message only copies the address of its format and the raw
+ * values of its arguments into the next slot of a ring buffer; the message is
+ * formatted only when the log is decoded. Once the buffer is full, each new
+ * message overwrites the oldest one.
+ *
+ * Messages can be recorded from any thread without locking. A message that is
+ * being overwritten while the log is decoded is left out of the result.
+ */
+class DiagnosticLog {
+ public:
+  /** The number of messages the default log keeps. */
+  static constexpr size_t kDefaultCapacity = 4096;
+
+  /** The most arguments a message can have. */
+  static constexpr size_t kMaxArgs = 8;
+
+  /**
+   * Creates a disabled log that keeps the last `capacity` messages, rounded
+   * up to a power of two.
+   */
+  explicit DiagnosticLog(size_t capacity = kDefaultCapacity);
+
+  /**
+   * The log that LOG_DIAGNOSTIC records into, shared by all Firestore
+   * instances in the process.
+   */
+  static DiagnosticLog& Default();
+
+  bool enabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  void set_enabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  /**
+   * Records a message, whether or not the log is enabled.
+   *
+   * @param format A string literal suitable for use with `util::StringFormat`.
+   *     Only its address is kept, so it must outlive the log.
+   */
+  template <typename... Args>
+  void Record(const char* format, const Args&... args) {
+    static_assert(sizeof...(Args) <= kMaxArgs,
+                  "Too many arguments for a diagnostic log message");
+
+    internal::DiagnosticRecordEncoder encoder{format};
+    int expand[] = {0, (encoder.Add(args), 0)...};
+    (void)expand;
+    Append(encoder.words());
+  }
+
+  /** Formats the messages still in the log, oldest first. */
+  std::vector<DiagnosticLogRecord> Decode() const;
+
+  /**
+   * Formats the messages still in the log, oldest first, one per line, each
+   * preceded by its timestamp.
+   */
+  std::string Dump() const;
+
+ private:
+  struct Slot {
+    // Odd while the slot is being written; otherwise twice the index of the
+    // message in it, plus two.
+    std::atomic<uint64_t> sequence{0};
+    std::array<std::atomic<uint64_t>, internal::kDiagnosticRecordWords> words;
+  };
+
+  void Append(const std::array<uint64_t, internal::kDiagnosticRecordWords>&
+                  words);
+
+  size_t capacity_ = 0;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> next_index_{0};
+  std::atomic<bool> enabled_{false};
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_DIAGNOSTIC_LOG_H_
@@ -22,6 +22,7 @@
 #include <string>
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/util/unique_function.h"
 #include "absl/types/optional.h"
 
 namespace firebase {
@@ -74,19 +75,32 @@ class DelayedOperation {
 class Executor {
  public:
   using Tag = int;
-  using Operation = std::function<void()>;
+  // Operations are move-only. Their inline storage leaves room for wrapping
+  // a `UniqueFunction<void()>` along with up to 32 bytes of bookkeeping (as
+  // `AsyncQueue` does) without allocating.
+  using Operation =
+      UniqueFunction<void(), sizeof(UniqueFunction<void()>) + 32>;
   using Milliseconds = std::chrono::milliseconds;
 
   // Operations scheduled for future execution have an opaque tag. The value of
   // the tag is ignored by the executor but can be used to find operations with
   // a given tag after they are scheduled.
+  //
+  // `leeway` is how much later than its due time the operation may run, which
+  // lets executors that support it wake up once for timers due close together.
   struct TaggedOperation {
     TaggedOperation() {
     }
     TaggedOperation(const Tag tag, Operation&& operation)
         : tag{tag}, operation{std::move(operation)} {
     }
+    TaggedOperation(const Tag tag,
+                    const Milliseconds leeway,
+                    Operation&& operation)
+        : tag{tag}, leeway{leeway}, operation{std::move(operation)} {
+    }
     Tag tag = 0;
+    Milliseconds leeway{0};
     Operation operation;
   };
 
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/executor_batching.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+// Runs the operations held back by a batch, in order.
+class BatchOperation {
+ public:
+  explicit BatchOperation(std::vector<Executor::Operation>&& operations)
+      : operations_{std::move(operations)} {
+  }
+
+  void operator()() {
+    for (Executor::Operation& operation : operations_) {
+      operation();
+    }
+  }
+
+ private:
+  std::vector<Executor::Operation> operations_;
+};
+
+}  // namespace
+
+ExecutorBatching::ExecutorBatching(std::shared_ptr<Executor> executor)
+    : executor_{std::move(executor)} {
+  HARD_ASSERT(executor_, "ExecutorBatching requires an executor");
+}
+
+void ExecutorBatching::BeginBatch() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++open_batches_;
+}
+
+void ExecutorBatching::EndBatch() {
+  std::vector<Operation> batch;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    HARD_ASSERT(open_batches_ > 0, "EndBatch called without BeginBatch");
+    if (--open_batches_ > 0 || batch_.empty()) {
+      return;
+    }
+    batch.swap(batch_);
+  }
+
+  if (batch.size() == 1) {
+    executor_->Execute(std::move(batch.front()));
+  } else {
+    executor_->Execute(BatchOperation{std::move(batch)});
+  }
+}
+
+void ExecutorBatching::Execute(Operation&& operation) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (open_batches_ > 0) {
+      batch_.push_back(std::move(operation));
+      return;
+    }
+  }
+  executor_->Execute(std::move(operation));
+}
+
+void ExecutorBatching::ExecuteBlocking(Operation&& operation) {
+  executor_->ExecuteBlocking(std::move(operation));
+}
+
+DelayedOperation ExecutorBatching::Schedule(Milliseconds delay,
+                                            TaggedOperation&& tagged) {
+  return executor_->Schedule(delay, std::move(tagged));
+}
+
+bool ExecutorBatching::IsCurrentExecutor() const {
+  return executor_->IsCurrentExecutor();
+}
+
+std::string ExecutorBatching::CurrentExecutorName() const {
+  return executor_->CurrentExecutorName();
+}
+
+std::string ExecutorBatching::Name() const {
+  return executor_->Name();
+}
+
+bool ExecutorBatching::IsScheduled(Tag tag) const {
+  return executor_->IsScheduled(tag);
+}
+
+absl::optional<Executor::TaggedOperation> ExecutorBatching::PopFromSchedule() {
+  return executor_->PopFromSchedule();
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
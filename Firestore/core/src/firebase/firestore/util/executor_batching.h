@@ -0,0 +1,78 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_BATCHING_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_BATCHING_H_
+
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+// An executor that runs operations on another executor, except that while a
+// batch is open, the operations passed to `Execute` are held back and then run,
+// in FIFO order, by a single operation on the other executor once the batch is
+// closed.
+//
+// This turns a burst of operations, such as the snapshots raised by one remote
+// event to many listeners, into a single hop to an executor that is expensive
+// to hop to, such as the main queue.
+class ExecutorBatching : public Executor {
+ public:
+  explicit ExecutorBatching(std::shared_ptr<Executor> executor);
+
+  // Opens a batch, unless one is already open, in which case the batch only
+  // closes once `EndBatch` has been called as many times as `BeginBatch`.
+  void BeginBatch();
+  // Closes the batch and runs the operations it held back, if any.
+  void EndBatch();
+
+  void Execute(Operation&& operation) override;
+  // Runs the operation right away on the other executor, even if a batch is
+  // open, so the caller mustn't rely on it running after the operations held
+  // back by the batch.
+  void ExecuteBlocking(Operation&& operation) override;
+
+  DelayedOperation Schedule(Milliseconds delay,
+                            TaggedOperation&& tagged) override;
+
+  bool IsCurrentExecutor() const override;
+  std::string CurrentExecutorName() const override;
+  std::string Name() const override;
+
+  bool IsScheduled(Tag tag) const override;
+  absl::optional<TaggedOperation> PopFromSchedule() override;
+
+ private:
+  std::shared_ptr<Executor> executor_;
+
+  std::mutex mutex_;
+  int open_batches_ = 0;
+  std::vector<Operation> batch_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_BATCHING_H_
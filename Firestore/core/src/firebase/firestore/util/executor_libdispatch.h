@@ -18,7 +18,6 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_LIBDISPATCH_H_
 
 #include <chrono>  // NOLINT(build/c++11)
-#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -44,10 +43,10 @@ namespace internal {
 // Generic wrapper over `dispatch_async_f`, providing `dispatch_async`-like
 // interface: accepts an arbitrary invocable object in place of an Objective-C
 // block.
-void DispatchAsync(dispatch_queue_t queue, std::function<void()>&& work);
+void DispatchAsync(dispatch_queue_t queue, Executor::Operation&& work);
 
 // Similar to `DispatchAsync` but wraps `dispatch_sync_f`.
-void DispatchSync(dispatch_queue_t queue, std::function<void()> work);
+void DispatchSync(dispatch_queue_t queue, Executor::Operation work);
 
 }  // namespace internal
 
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/util/executor_libdispatch.h"
 
+#include <algorithm>
 #include <atomic>
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -47,19 +48,19 @@ absl::string_view GetCurrentQueueLabel() {
 
 namespace internal {
 
-void DispatchAsync(const dispatch_queue_t queue, std::function<void()>&& work) {
+void DispatchAsync(const dispatch_queue_t queue, Executor::Operation&& work) {
   // Dynamically allocate the function to make sure the object is valid by the
   // time libdispatch gets to it.
-  const auto wrap = new std::function<void()>{std::move(work)};
+  const auto wrap = new Executor::Operation{std::move(work)};
 
   dispatch_async_f(queue, wrap, [](void* const raw_work) {
-    const auto unwrap = static_cast<std::function<void()>*>(raw_work);
+    const auto unwrap = static_cast<Executor::Operation*>(raw_work);
     (*unwrap)();
     delete unwrap;
   });
 }
 
-void DispatchSync(const dispatch_queue_t queue, std::function<void()> work) {
+void DispatchSync(const dispatch_queue_t queue, Executor::Operation work) {
   HARD_ASSERT(
       GetCurrentQueueLabel() != GetQueueLabel(queue),
       "Calling DispatchSync on the current queue will lead to a deadlock.");
@@ -67,7 +68,7 @@ void DispatchSync(const dispatch_queue_t queue, std::function<void()> work) {
   // Unlike dispatch_async_f, dispatch_sync_f blocks until the work passed to it
   // is done, so passing a reference to a local variable is okay.
   dispatch_sync_f(queue, &work, [](void* const raw_work) {
-    const auto unwrap = static_cast<std::function<void()>*>(raw_work);
+    const auto unwrap = static_cast<Executor::Operation*>(raw_work);
     (*unwrap)();
   });
 }
@@ -90,34 +91,47 @@ void RunSynchronized(const ExecutorLibdispatch* const executor, Work&& work) {
 
 }  // namespace
 
-// Represents a "busy" time slot on the schedule.
+// Represents a timer on the schedule, backed by a one-shot dispatch source.
 //
-// Since libdispatch doesn't provide a way to cancel a scheduled operation, once
-// a slot is created, it will always stay in the schedule until the time is
-// past. Consequently, it is more useful to think of a time slot than
-// a particular scheduled operation -- by the time the slot comes, operation may
-// or may not be there (imagine getting to a meeting and finding out it's been
-// canceled).
+// Unlike `dispatch_after`, a dispatch source can be canceled, so a time slot
+// stops being a timer as soon as it's taken off the schedule, whether its
+// operation has run, has been force-run or has been canceled. This matters
+// because idle timers are canceled and rescheduled all the time, and each of
+// them would otherwise still wake up the device when it would have been due.
 //
-// Precondition: all member functions, including the constructor, are *only*
-// invoked on the Firestore queue.
+// Each time slot may run up to its operation's leeway later than its target
+// time. When it's armed, it's aligned with the earliest timer already on the
+// schedule that's due within that window, if any, so that both run in the same
+// wakeup; libdispatch can coalesce it further with timers outside Firestore
+// within the leeway that remains.
+//
+// Precondition: all member functions, except the constructor and `Cancel`, are
+// *only* invoked on the Firestore queue.
 //
 //   Ownership:
 //
-// - `TimeSlot` is exclusively owned by libdispatch;
+// - `TimeSlot` is exclusively owned by its dispatch source: it's deleted by the
+//   source's cancellation handler, which libdispatch runs on the queue once the
+//   source has been canceled and its event handler can no longer run;
 // - `ExecutorLibdispatch` contains non-owning pointers to `TimeSlot`s;
 // - invariant: if the executor contains a pointer to a `TimeSlot`, it is
-//   a valid object. It is achieved because when libdispatch invokes
-//   a `TimeSlot`, it always removes it from the executor before deleting it.
-//   The reverse is not true: a canceled time slot is removed from the executor,
-//   but won't be destroyed until its original due time is past.
+//   a valid object. It is achieved because a `TimeSlot` is always removed from
+//   the executor before its source is canceled (except by the destructor of
+//   the executor, which doesn't outlive the pointers).
 
 class TimeSlot {
  public:
+  using TimePoint = std::chrono::time_point<std::chrono::steady_clock,
+                                            Executor::Milliseconds>;
+
   TimeSlot(ExecutorLibdispatch* executor,
            Executor::Milliseconds delay,
            Executor::TaggedOperation&& operation);
 
+  // Starts the timer, aligning it with the earliest of the `scheduled` slots
+  // that's due within this slot's leeway.
+  void Arm(const std::vector<TimeSlot*>& scheduled);
+
   // Returns the operation that was scheduled for this time slot and turns the
   // slot into a no-op.
   Executor::TaggedOperation Unschedule();
@@ -133,23 +147,31 @@ class TimeSlot {
     done_ = true;
   }
 
+  // Stops the timer; the time slot is deleted on the queue afterwards.
+  // Thread-safe.
+  void Cancel() {
+    dispatch_source_cancel(source_);
+  }
+
   static void InvokedByLibdispatch(void* const raw_self);
+  static void CanceledByLibdispatch(void* const raw_self);
 
  private:
   void Execute();
   void RemoveFromSchedule();
 
-  using TimePoint = std::chrono::time_point<std::chrono::steady_clock,
-                                            Executor::Milliseconds>;
-
   ExecutorLibdispatch* const executor_;
   const TimePoint target_time_;  // Used for sorting
+  // When the timer is set to fire, between `target_time_` and `target_time_`
+  // plus the leeway.
+  TimePoint deadline_;
   Executor::TaggedOperation tagged_;
+  dispatch_source_t source_;
 
   // True if the operation has either been run or canceled.
   //
   // Note on thread-safety: this variable is accessed both from the dispatch
-  // queue and in the destructor, which may run on any queue.
+  // queue and in the destructor of the executor, which may run on any queue.
   std::atomic<bool> done_;
 };
 
@@ -160,10 +182,42 @@ TimeSlot::TimeSlot(ExecutorLibdispatch* const executor,
       target_time_{std::chrono::time_point_cast<Executor::Milliseconds>(
                        std::chrono::steady_clock::now()) +
                    delay},
-      tagged_{std::move(operation)} {
+      deadline_{target_time_},
+      tagged_{std::move(operation)},
+      source_{dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0,
+                                     executor->dispatch_queue())} {
   // Only assignment of std::atomic is atomic; initialization in its constructor
   // isn't
   done_ = false;
+
+  dispatch_set_context(source_, this);
+  dispatch_source_set_event_handler_f(source_, TimeSlot::InvokedByLibdispatch);
+  dispatch_source_set_cancel_handler_f(source_,
+                                       TimeSlot::CanceledByLibdispatch);
+}
+
+void TimeSlot::Arm(const std::vector<TimeSlot*>& scheduled) {
+  const TimePoint latest = target_time_ + tagged_.leeway;
+  TimePoint aligned = latest;
+  bool found = false;
+  for (const TimeSlot* other : scheduled) {
+    if (other->deadline_ >= target_time_ && other->deadline_ <= aligned) {
+      aligned = other->deadline_;
+      found = true;
+    }
+  }
+  deadline_ = found ? aligned : target_time_;
+
+  namespace chr = std::chrono;
+  const auto now = chr::steady_clock::now();
+  const auto delay = std::max(chr::duration_cast<chr::nanoseconds>(
+                                  deadline_ - now),
+                              chr::nanoseconds{0});
+  const auto leeway = chr::duration_cast<chr::nanoseconds>(latest - deadline_);
+  dispatch_source_set_timer(source_,
+                            dispatch_time(DISPATCH_TIME_NOW, delay.count()),
+                            DISPATCH_TIME_FOREVER, leeway.count());
+  dispatch_resume(source_);
 }
 
 Executor::TaggedOperation TimeSlot::Unschedule() {
@@ -176,7 +230,13 @@ Executor::TaggedOperation TimeSlot::Unschedule() {
 void TimeSlot::InvokedByLibdispatch(void* const raw_self) {
   auto const self = static_cast<TimeSlot*>(raw_self);
   self->Execute();
-  delete self;
+  // The timer is one-shot; canceling it gets the time slot deleted, even if it
+  // was already off the schedule.
+  self->Cancel();
+}
+
+void TimeSlot::CanceledByLibdispatch(void* const raw_self) {
+  delete static_cast<TimeSlot*>(raw_self);
 }
 
 void TimeSlot::Execute() {
@@ -205,14 +265,16 @@ ExecutorLibdispatch::ExecutorLibdispatch(const dispatch_queue_t dispatch_queue)
 
 ExecutorLibdispatch::~ExecutorLibdispatch() {
   // Turn any operations that might still be in the queue into no-ops, lest
-  // they try to access `ExecutorLibdispatch` after it gets destroyed. Because
-  // the queue is serial, by the time libdispatch gets to the newly-enqueued
-  // work, the pending operations that might have been in progress would have
-  // already finished.
+  // they try to access `ExecutorLibdispatch` after it gets destroyed, and stop
+  // their timers. Because the queue is serial, by the time libdispatch gets to
+  // the newly-enqueued work, the pending operations that might have been in
+  // progress would have already finished.
   // Note: this is thread-safe, because the underlying variable `done_` is
-  // atomic. `RunSynchronized` may result in a deadlock.
+  // atomic and canceling a dispatch source is thread-safe. `RunSynchronized`
+  // may result in a deadlock.
   for (auto slot : schedule_) {
     slot->MarkDone();
+    slot->Cancel();
   }
 }
 
@@ -235,20 +297,19 @@ void ExecutorLibdispatch::ExecuteBlocking(Operation&& operation) {
 
 DelayedOperation ExecutorLibdispatch::Schedule(const Milliseconds delay,
                                                TaggedOperation&& operation) {
-  namespace chr = std::chrono;
-  const dispatch_time_t delay_ns = dispatch_time(
-      DISPATCH_TIME_NOW, chr::duration_cast<chr::nanoseconds>(delay).count());
-
-  // Ownership is fully transferred to libdispatch -- because it's impossible
-  // to truly cancel work after it's been dispatched, libdispatch is
-  // guaranteed to outlive the executor, and it's possible for work to be
-  // invoked by libdispatch after the executor is destroyed. Executor only
-  // stores an observer pointer to the operation.
-
+  // Ownership is fully transferred to libdispatch -- the time slot is deleted
+  // by its dispatch source once the source is canceled, which may happen after
+  // the executor is destroyed. Executor only stores an observer pointer to the
+  // operation.
+  //
+  // The timer is armed on the queue, so that the slot is on the schedule by the
+  // time it fires, and so that it can be aligned with the other timers on the
+  // schedule.
   auto const time_slot = new TimeSlot{this, delay, std::move(operation)};
-  dispatch_after_f(delay_ns, dispatch_queue(), time_slot,
-                   TimeSlot::InvokedByLibdispatch);
-  RunSynchronized(this, [this, time_slot] { schedule_.push_back(time_slot); });
+  RunSynchronized(this, [this, time_slot] {
+    time_slot->Arm(schedule_);
+    schedule_.push_back(time_slot);
+  });
   return DelayedOperation{[this, time_slot] {
     // `time_slot` might be destroyed by the time cancellation function runs.
     // Therefore, don't access any methods on `time_slot`, only use it as
@@ -266,6 +327,7 @@ void ExecutorLibdispatch::RemoveFromSchedule(const TimeSlot* const to_remove) {
     // it after it was force-run, for example.
     if (found != schedule_.end()) {
       (*found)->MarkDone();
+      (*found)->Cancel();
       schedule_.erase(found);
     }
   });
@@ -41,8 +41,8 @@ ExecutorStd::ExecutorStd() {
   // before the worker thread is started.
   // See [this thread](https://stackoverflow.com/questions/25609858) for context
   // on the constructor.
-  current_id_ = 0;
   shutting_down_ = false;
+  worker_waiting_ = false;
   worker_thread_ = std::thread{&ExecutorStd::PollingThread, this};
 }
 
@@ -55,7 +55,11 @@ ExecutorStd::~ExecutorStd() {
 }
 
 void ExecutorStd::Execute(Operation&& operation) {
-  PushOnSchedule(std::move(operation), Immediate());
+  immediate_operations_.Push(std::move(operation));
+  // Only contend on the schedule's lock if the worker thread might be asleep.
+  if (worker_waiting_) {
+    schedule_.Wake();
+  }
 }
 
 DelayedOperation ExecutorStd::Schedule(const Milliseconds delay,
@@ -74,42 +78,44 @@ DelayedOperation ExecutorStd::Schedule(const Milliseconds delay,
 }
 
 void ExecutorStd::TryCancel(const Id operation_id) {
-  schedule_.RemoveIf(
-      [operation_id](const Entry& e) { return e.id == operation_id; });
+  schedule_.Remove(operation_id);
 }
 
 ExecutorStd::Id ExecutorStd::PushOnSchedule(Operation&& operation,
                                             const TimePoint when,
                                             const Tag tag) {
-  // Note: operations scheduled for immediate execution don't actually need an
-  // id. This could be tweaked to reuse the same id for all such operations.
-  const auto id = NextId();
-  schedule_.Push(Entry{std::move(operation), id, tag}, when);
-  return id;
+  return schedule_.Push(Entry{std::move(operation), tag}, when);
 }
 
 void ExecutorStd::PollingThread() {
   while (!shutting_down_) {
-    Entry entry = schedule_.PopBlocking();
-    if (entry.tagged.operation) {
-      entry.tagged.operation();
+    absl::optional<Operation> immediate = immediate_operations_.Pop();
+    if (immediate) {
+      if (*immediate) {
+        (*immediate)();
+      }
+      continue;
+    }
+
+    // Announce the intention to sleep before checking for immediate operations
+    // one last time (within `PopBlockingUnless`), so that any operation pushed
+    // concurrently is either noticed by the check or followed by a wake up.
+    worker_waiting_ = true;
+    absl::optional<Entry> entry = schedule_.PopBlockingUnless(
+        [this] { return !immediate_operations_.empty(); });
+    worker_waiting_ = false;
+
+    if (entry && entry->tagged.operation) {
+      entry->tagged.operation();
     }
   }
 }
 
 void ExecutorStd::UnblockQueue() {
   // Put a no-op for immediate execution on the queue to ensure that
-  // `schedule_.PopBlocking` returns, and worker thread can notice that shutdown
-  // is in progress.
-  schedule_.Push(Entry{[] {}, /*id=*/0}, Immediate());
-}
-
-ExecutorStd::Id ExecutorStd::NextId() {
-  // The wrap around after ~4 billion operations is explicitly ignored. Even if
-  // an instance of `ExecutorStd` runs long enough to get `current_id_` to
-  // overflow, it's extremely unlikely that any object still holds a reference
-  // that is old enough to cause a conflict.
-  return current_id_++;
+  // `schedule_.PopBlockingUnless` returns, and worker thread can notice that
+  // shutdown is in progress.
+  Execute([] {});
 }
 
 bool ExecutorStd::IsCurrentExecutor() const {
@@ -19,12 +19,15 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
 #include <condition_variable>  // NOLINT(build/c++11)
-#include <deque>
+#include <cstdint>
 #include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -44,27 +47,36 @@ namespace async {
 // becomes available. It correctly handles entries being asynchronously added or
 // removed from the schedule.
 //
+// Entries are kept in a binary heap, so pushing and popping an entry takes
+// logarithmic time. Removing an entry by the handle returned from `Push`
+// doesn't search for the entry: it is dropped from the heap lazily, once it
+// reaches the top or once removed entries make up most of the heap.
+//
 // The details of time management are completely concealed within the class.
 // Once an entry is scheduled, there is no way to reschedule or even retrieve
 // the time.
 template <typename T>
 class Schedule {
   // Internal invariants:
-  // - entries are always in sorted order, leftmost entry is always the most
-  //   due;
+  // - `heap_` holds the due time and handle of every scheduled entry, and
+  //   possibly of entries that have since been removed; the top of the heap is
+  //   always the most due entry that is still scheduled;
+  // - `entries_` holds the values of exactly the entries that are scheduled;
   // - each operation modifying the queue notifies the condition variable `cv_`.
  public:
   using Duration = std::chrono::milliseconds;
   using Clock = std::chrono::steady_clock;
   // Entries are scheduled using absolute time.
   using TimePoint = std::chrono::time_point<Clock, Duration>;
+  // Identifies an entry pushed on the schedule; never reused.
+  using Handle = uint64_t;
 
   // Schedules an entry for the specified time due. `due` may be in the past.
-  void Push(const T& value, const TimePoint due) {
-    InsertPreservingOrder(Entry{value, due});
+  Handle Push(const T& value, const TimePoint due) {
+    return PushLocked(T{value}, due);
   }
-  void Push(T&& value, const TimePoint due) {
-    InsertPreservingOrder(Entry{std::move(value), due});
+  Handle Push(T&& value, const TimePoint due) {
+    return PushLocked(std::move(value), due);
   }
 
   // If the queue contains at least one entry for which the scheduled time is
@@ -75,7 +87,7 @@ class Schedule {
     std::lock_guard<std::mutex> lock{mutex_};
 
     if (HasDueLocked()) {
-      return ExtractLocked(scheduled_.begin());
+      return ExtractLocked(heap_.front().handle);
     }
     return {};
   }
@@ -85,17 +97,35 @@ class Schedule {
   // most overdue from the queue and returns it. The function will
   // attempt to minimize both the waiting time and busy waiting.
   T PopBlocking() {
+    return PopBlockingUnless([] { return false; }).value();
+  }
+
+  // Like `PopBlocking`, but gives up and returns an empty `optional` as soon as
+  // `interrupted` returns true. `interrupted` is evaluated with the internal
+  // mutex locked, so whatever makes it true must be followed by a call to
+  // `Wake` for the change to be noticed.
+  template <typename Pred>
+  absl::optional<T> PopBlockingUnless(const Pred interrupted) {
     std::unique_lock<std::mutex> lock{mutex_};
 
     while (true) {
-      cv_.wait(lock, [this] { return !scheduled_.empty(); });
+      cv_.wait(lock, [this, &interrupted] {
+        return !entries_.empty() || interrupted();
+      });
+      if (interrupted()) {
+        return {};
+      }
 
       // To minimize busy waiting, sleep until either the nearest entry in the
       // future either changes, or else becomes due.
-      const auto until = scheduled_.front().due;
-      cv_.wait_until(lock, until, [this, until] {
-        return scheduled_.empty() || scheduled_.front().due != until;
+      const auto until = heap_.front().due;
+      cv_.wait_until(lock, until, [this, until, &interrupted] {
+        return entries_.empty() || heap_.front().due != until ||
+               interrupted();
       });
+      if (interrupted()) {
+        return {};
+      }
       // There are 3 possibilities why `wait_until` has returned:
       // - `wait_until` has timed out, in which case the current time is at
       //   least `until`, so there must be an overdue entry;
@@ -108,19 +138,37 @@ class Schedule {
       //   to #2.
 
       if (HasDueLocked()) {
-        return ExtractLocked(scheduled_.begin());
+        return ExtractLocked(heap_.front().handle);
       }
     }
   }
 
+  // Wakes up a thread blocked in `PopBlockingUnless`, so that it reevaluates
+  // its predicate.
+  void Wake() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    cv_.notify_one();
+  }
+
   bool empty() const {
     std::lock_guard<std::mutex> lock{mutex_};
-    return scheduled_.empty();
+    return entries_.empty();
   }
 
   size_t size() const {
     std::lock_guard<std::mutex> lock{mutex_};
-    return scheduled_.size();
+    return entries_.size();
+  }
+
+  // Removes the entry with the given handle from the queue and returns it. If
+  // the entry has already been popped or removed, returns an empty `optional`.
+  absl::optional<T> Remove(const Handle handle) {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    if (entries_.find(handle) == entries_.end()) {
+      return {};
+    }
+    return ExtractLocked(handle);
   }
 
   // Removes the first entry satisfying predicate from the queue and returns it.
@@ -128,15 +176,24 @@ class Schedule {
   // to entries in order according to their scheduled time.
   //
   // Note that this function doesn't take into account whether the removed entry
-  // is past its due time.
+  // is past its due time. Unlike `Remove`, it takes linear time or worse.
   template <typename Pred>
   absl::optional<T> RemoveIf(const Pred pred) {
     std::lock_guard<std::mutex> lock{mutex_};
 
-    for (auto iter = scheduled_.begin(), end = scheduled_.end(); iter != end;
-         ++iter) {
-      if (pred(iter->value)) {
-        return ExtractLocked(iter);
+    std::vector<HeapEntry> in_order;
+    in_order.reserve(entries_.size());
+    for (const auto& kv : entries_) {
+      in_order.push_back(HeapEntry{kv.second.due, kv.first});
+    }
+    std::sort(in_order.begin(), in_order.end(),
+              [](const HeapEntry& lhs, const HeapEntry& rhs) {
+                return HeapEntry::Later(rhs, lhs);
+              });
+
+    for (const HeapEntry& candidate : in_order) {
+      if (pred(entries_.find(candidate.handle)->second.value)) {
+        return ExtractLocked(candidate.handle);
       }
     }
     return {};
@@ -146,56 +203,171 @@ class Schedule {
   template <typename Pred>
   bool Contains(const Pred pred) const {
     std::lock_guard<std::mutex> lock{mutex_};
-    return std::any_of(scheduled_.begin(), scheduled_.end(),
-                       [&pred](const Entry& s) { return pred(s.value); });
+    return std::any_of(
+        entries_.begin(), entries_.end(),
+        [&pred](const typename EntryMap::value_type& kv) {
+          return pred(kv.second.value);
+        });
   }
 
  private:
   struct Entry {
-    bool operator<(const Entry& rhs) const {
-      return due < rhs.due;
+    T value;
+    TimePoint due;
+  };
+  using EntryMap = std::unordered_map<Handle, Entry>;
+
+  struct HeapEntry {
+    // Whether `lhs` is due after `rhs`; handles increase with every push, so
+    // they break ties in FIFO order. Ordering the heap by this puts the most
+    // due entry on top.
+    static bool Later(const HeapEntry& lhs, const HeapEntry& rhs) {
+      return lhs.due != rhs.due ? lhs.due > rhs.due : lhs.handle > rhs.handle;
     }
 
-    T value;
     TimePoint due;
+    Handle handle;
   };
-  // All removals are on the front, but most insertions are expected to be on
-  // the back.
-  using Container = std::deque<Entry>;
-  using Iterator = typename Container::iterator;
 
-  void InsertPreservingOrder(Entry&& new_entry) {
+  // Removed entries are only dropped from all of the heap at once when they
+  // outnumber the entries still scheduled, and the heap has at least this many
+  // entries.
+  static constexpr size_t kMinHeapSizeToCompact = 64;
+
+  Handle PushLocked(T&& value, const TimePoint due) {
     std::lock_guard<std::mutex> lock{mutex_};
 
-    const auto insertion_point =
-        std::upper_bound(scheduled_.begin(), scheduled_.end(), new_entry);
-    scheduled_.insert(insertion_point, std::move(new_entry));
+    const Handle handle = next_handle_++;
+    entries_.emplace(handle, Entry{std::move(value), due});
+    heap_.push_back(HeapEntry{due, handle});
+    std::push_heap(heap_.begin(), heap_.end(), &HeapEntry::Later);
 
     cv_.notify_one();
+    return handle;
   }
 
   // This function expects the mutex to be already locked.
   bool HasDueLocked() const {
     namespace chr = std::chrono;
     const auto now = chr::time_point_cast<Duration>(Clock::now());
-    return !scheduled_.empty() && now >= scheduled_.front().due;
+    return !entries_.empty() && now >= heap_.front().due;
   }
 
   // This function expects the mutex to be already locked.
-  T ExtractLocked(const Iterator where) {
-    HARD_ASSERT(!scheduled_.empty(),
-                "Trying to pop an entry from an empty queue.");
-
-    T result = std::move(where->value);
-    scheduled_.erase(where);
+  T ExtractLocked(const Handle handle) {
+    const auto found = entries_.find(handle);
+    HARD_ASSERT(found != entries_.end(),
+                "Trying to pop an entry that isn't scheduled.");
+
+    T result = std::move(found->second.value);
+    entries_.erase(found);
+    PruneLocked();
     cv_.notify_one();
 
     return result;
   }
 
+  // Restores the invariant that the top of the heap is scheduled, and drops
+  // removed entries from the heap if they have piled up.
+  //
+  // This function expects the mutex to be already locked.
+  void PruneLocked() {
+    const auto removed = [this](const HeapEntry& e) {
+      return entries_.find(e.handle) == entries_.end();
+    };
+
+    if (heap_.size() >= kMinHeapSizeToCompact &&
+        heap_.size() > 2 * entries_.size()) {
+      heap_.erase(std::remove_if(heap_.begin(), heap_.end(), removed),
+                  heap_.end());
+      std::make_heap(heap_.begin(), heap_.end(), &HeapEntry::Later);
+      return;
+    }
+
+    while (!heap_.empty() && removed(heap_.front())) {
+      std::pop_heap(heap_.begin(), heap_.end(), &HeapEntry::Later);
+      heap_.pop_back();
+    }
+  }
+
   mutable std::mutex mutex_;
   std::condition_variable cv_;
-  Container scheduled_;
+  EntryMap entries_;
+  std::vector<HeapEntry> heap_;
+  Handle next_handle_ = 0;
+};
+
+// An unbounded multi-producer, single-consumer FIFO queue that doesn't take
+// any locks. Any number of threads may `Push` concurrently, but only a single
+// thread at a time may `Pop` or check for `empty`.
+//
+// This is an intrusive linked list in the style of Dmitry Vyukov's MPSC queue:
+// producers atomically swap themselves in as the new head and then link the
+// previous head to their node, while the consumer follows the links from the
+// tail. The list always contains at least one node whose value has already
+// been consumed (initially, a placeholder), and which the tail points to.
+//
+// Between the swap and the link, a new entry is not yet visible to the
+// consumer, and neither is any entry pushed after it. This can only make the
+// queue appear empty for a moment while a push is in progress; once `Push`
+// returns, the entry is guaranteed to be visible.
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_{new Node{}}, tail_{head_.load()} {
+  }
+
+  ~MpscQueue() {
+    while (tail_) {
+      Node* next = tail_->next.load();
+      delete tail_;
+      tail_ = next;
+    }
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  void Push(T&& value) {
+    auto node = new Node{std::move(value)};
+    Node* previous = head_.exchange(node, std::memory_order_acq_rel);
+    // Sequentially consistent so that a consumer about to go to sleep either
+    // sees the new entry or is seen to be sleeping by the producer.
+    previous->next.store(node);
+  }
+
+  // Removes the oldest entry from the queue and returns it. If the queue is
+  // empty, returns an empty `optional`.
+  absl::optional<T> Pop() {
+    Node* next = tail_->next.load();
+    if (!next) {
+      return {};
+    }
+
+    T result = std::move(next->value);
+    delete tail_;
+    tail_ = next;
+    return result;
+  }
+
+  bool empty() const {
+    return tail_->next.load() == nullptr;
+  }
+
+ private:
+  struct Node {
+    Node() = default;
+    explicit Node(T&& value) : value{std::move(value)} {
+    }
+
+    T value;
+    std::atomic<Node*> next{nullptr};
+  };
+
+  // The most recently pushed node; modified by producers.
+  std::atomic<Node*> head_;
+  // The most recently consumed node; modified by the consumer only.
+  Node* tail_ = nullptr;
 };
 
 }  // namespace async
@@ -221,9 +393,9 @@ class ExecutorStd : public Executor {
   absl::optional<TaggedOperation> PopFromSchedule() override;
 
   using TimePoint = async::Schedule<Operation>::TimePoint;
-  // To allow canceling operations, each scheduled operation is assigned
-  // a monotonically increasing identifier.
-  using Id = unsigned int;
+  // To allow canceling operations, each scheduled operation is identified by
+  // the handle the schedule assigned to it.
+  using Id = async::Schedule<Operation>::Handle;
 
   // If the operation hasn't yet been run, it will be removed from the queue.
   // Otherwise, this function is a no-op.
@@ -233,24 +405,13 @@ class ExecutorStd : public Executor {
 
   void PollingThread();
   void UnblockQueue();
-  Id NextId();
-
-  // As a convention, assign the epoch time to all operations scheduled for
-  // immediate execution. Note that it means that an immediate operation is
-  // always scheduled before any delayed operation, even in the corner case when
-  // the immediate operation was scheduled after a delayed operation was due
-  // (but hasn't yet run).
-  static TimePoint Immediate() {
-    return TimePoint{};
-  }
 
   struct Entry {
     Entry() {
     }
-    Entry(Operation&& operation,
-          const ExecutorStd::Id id,
-          const ExecutorStd::Tag tag = kNoTag)
-        : tagged{tag, std::move(operation)}, id{id} {
+    explicit Entry(Operation&& operation,
+                   const ExecutorStd::Tag tag = kNoTag)
+        : tagged{tag, std::move(operation)} {
     }
 
     bool IsImmediate() const {
@@ -259,17 +420,21 @@ class ExecutorStd : public Executor {
 
     static constexpr Tag kNoTag = -1;
     TaggedOperation tagged;
-    Id id = 0;
   };
-  // Operations scheduled for immediate execution are also put on the schedule
-  // (with due time set to `Immediate`).
+  // Operations scheduled for immediate execution are put on a queue of their
+  // own, so that producers don't contend on the lock guarding the schedule of
+  // delayed operations. An immediate operation always runs before any delayed
+  // operation, even in the corner case when the immediate operation was
+  // scheduled after a delayed operation was due (but hasn't yet run).
+  async::MpscQueue<Operation> immediate_operations_;
   async::Schedule<Entry> schedule_;
+  // Whether the worker thread is (or is about to be) blocked on `schedule_`,
+  // in which case pushing an immediate operation has to wake it up.
+  std::atomic<bool> worker_waiting_{false};
 
   std::thread worker_thread_;
   // Used to stop the worker thread.
   std::atomic<bool> shutting_down_{false};
-
-  std::atomic<Id> current_id_{0};
 };
 
 }  // namespace util
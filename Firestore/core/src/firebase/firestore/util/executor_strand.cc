@@ -0,0 +1,256 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/executor_strand.h"
+
+#include <atomic>
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <future>  // NOLINT(build/c++11)
+#include <mutex>   // NOLINT(build/c++11)
+#include <sstream>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+// A strand gives up its worker after running this many operations in a row,
+// so that the other strands and the parallel work on the pool get to run.
+constexpr int kMaxOperationsPerTurn = 16;
+
+std::string ThreadIdToString(const std::thread::id thread_id) {
+  std::ostringstream stream;
+  stream << thread_id;
+  return stream.str();
+}
+
+std::string NextStrandName() {
+  static std::atomic<int> next_id{0};
+  return "ExecutorStrand-" + std::to_string(next_id++);
+}
+
+}  // namespace
+
+class ExecutorStrand::State : public std::enable_shared_from_this<State> {
+ public:
+  State(ThreadPool* pool, std::string name)
+      : pool_{pool}, name_{std::move(name)} {
+  }
+
+  const std::string& name() const {
+    return name_;
+  }
+
+  async::Schedule<TaggedOperation>& schedule() {
+    return schedule_;
+  }
+  const async::Schedule<TaggedOperation>& schedule() const {
+    return schedule_;
+  }
+
+  void Execute(Operation&& operation) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (shutting_down_) {
+        return;
+      }
+      operations_.push_back(std::move(operation));
+      if (turn_scheduled_) {
+        return;
+      }
+      turn_scheduled_ = true;
+    }
+    ScheduleTurn();
+  }
+
+  // Moves the delayed operations that are due to the back of the strand, in
+  // the order they are due.
+  void EnqueueDueOperations() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      if (shutting_down_) {
+        return;
+      }
+      for (auto due = schedule_.PopIfDue(); due; due = schedule_.PopIfDue()) {
+        operations_.push_back(std::move(due->operation));
+      }
+      if (operations_.empty() || turn_scheduled_) {
+        return;
+      }
+      turn_scheduled_ = true;
+    }
+    ScheduleTurn();
+  }
+
+  bool IsCurrent() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return running_thread_ == std::this_thread::get_id();
+  }
+
+  void ShutDown() {
+    std::deque<Operation> discarded;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      shutting_down_ = true;
+      if (running_thread_ != std::this_thread::get_id()) {
+        finished_.wait(lock,
+                       [this] { return running_thread_ == std::thread::id{}; });
+      }
+      discarded.swap(operations_);
+    }
+    // Destroying the operations may enqueue more operations, which are
+    // ignored, so the lock must not be held.
+  }
+
+ private:
+  void ScheduleTurn() {
+    std::shared_ptr<State> self = shared_from_this();
+    pool_->Submit([self] { self->RunTurn(); });
+  }
+
+  // Runs the operations on the strand, in order, on the current worker, until
+  // there are none left or it's time to let other work run.
+  void RunTurn() {
+    for (int i = 0;; ++i) {
+      Operation operation;
+      {
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (shutting_down_ || operations_.empty()) {
+          turn_scheduled_ = false;
+          return;
+        }
+        if (i == kMaxOperationsPerTurn) {
+          break;
+        }
+        operation = std::move(operations_.front());
+        operations_.pop_front();
+        running_thread_ = std::this_thread::get_id();
+      }
+
+      operation();
+      // Destructors invoked by destroying the operation still run on the
+      // strand.
+      operation = nullptr;
+
+      {
+        std::lock_guard<std::mutex> lock{mutex_};
+        running_thread_ = std::thread::id{};
+      }
+      finished_.notify_all();
+    }
+
+    // Another turn is still scheduled as far as `Execute` is concerned.
+    ScheduleTurn();
+  }
+
+  ThreadPool* pool_ = nullptr;
+  const std::string name_;
+  async::Schedule<TaggedOperation> schedule_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable finished_;
+  std::deque<Operation> operations_;
+  // Whether an operation running `RunTurn` is on the pool or running.
+  bool turn_scheduled_ = false;
+  bool shutting_down_ = false;
+  // The worker running an operation on the strand, if any.
+  std::thread::id running_thread_;
+};
+
+ExecutorStrand::ExecutorStrand(std::shared_ptr<ThreadPool> pool)
+    : pool_{std::move(pool)},
+      state_{std::make_shared<State>(pool_.get(), NextStrandName())} {
+  HARD_ASSERT(pool_, "ExecutorStrand requires a thread pool");
+}
+
+ExecutorStrand::~ExecutorStrand() {
+  state_->ShutDown();
+}
+
+void ExecutorStrand::Execute(Operation&& operation) {
+  state_->Execute(std::move(operation));
+}
+
+void ExecutorStrand::ExecuteBlocking(Operation&& operation) {
+  std::promise<void> signal_finished;
+  Execute([&] {
+    operation();
+    signal_finished.set_value();
+  });
+  signal_finished.get_future().wait();
+}
+
+DelayedOperation ExecutorStrand::Schedule(const Milliseconds delay,
+                                          TaggedOperation&& tagged) {
+  // As in `ExecutorStd`, negative delays would allow reordering immediate
+  // operations.
+  HARD_ASSERT(delay.count() >= 0, "Schedule: delay cannot be negative");
+
+  namespace chr = std::chrono;
+  const auto due =
+      chr::time_point_cast<Milliseconds>(chr::steady_clock::now()) + delay;
+  const auto handle = state_->schedule().Push(std::move(tagged), due);
+
+  // The pool can't cancel the timer, so it only checks the strand's own
+  // schedule, which canceled and popped operations are removed from.
+  std::weak_ptr<State> weak_state = state_;
+  pool_->SubmitAt(due, [weak_state] {
+    std::shared_ptr<State> state = weak_state.lock();
+    if (state) {
+      state->EnqueueDueOperations();
+    }
+  });
+
+  return DelayedOperation{
+      [this, handle] { state_->schedule().Remove(handle); }};
+}
+
+bool ExecutorStrand::IsCurrentExecutor() const {
+  return state_->IsCurrent();
+}
+
+std::string ExecutorStrand::CurrentExecutorName() const {
+  if (IsCurrentExecutor()) {
+    return Name();
+  }
+  return ThreadIdToString(std::this_thread::get_id());
+}
+
+std::string ExecutorStrand::Name() const {
+  return state_->name();
+}
+
+bool ExecutorStrand::IsScheduled(const Tag tag) const {
+  return state_->schedule().Contains(
+      [&tag](const TaggedOperation& operation) { return operation.tag == tag; });
+}
+
+absl::optional<Executor::TaggedOperation> ExecutorStrand::PopFromSchedule() {
+  return state_->schedule().RemoveIf(
+      [](const TaggedOperation&) { return true; });
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_STRAND_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_STRAND_H_
+
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/thread_pool.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+// A serial queue that executes provided operations on the workers of
+// a `ThreadPool`, one at a time and in FIFO order, like `ExecutorStd` does on
+// its dedicated thread.
+//
+// A strand doesn't tie up a worker while it has nothing to run, so any number
+// of strands (such as the one under an `AsyncQueue`) can share a pool with
+// parallel work submitted to the pool directly.
+//
+// Whichever worker runs an operation, each operation observes the effects of
+// the operations that ran before it on the strand.
+class ExecutorStrand : public Executor {
+ public:
+  explicit ExecutorStrand(std::shared_ptr<ThreadPool> pool);
+
+  // Operations that haven't started yet are discarded. Unless invoked by an
+  // operation on the strand, waits for the operation that is running, if any,
+  // to finish.
+  ~ExecutorStrand();
+
+  void Execute(Operation&& operation) override;
+  // Precondition: the caller isn't a worker of the underlying pool, which might
+  // be the only worker able to run the strand.
+  void ExecuteBlocking(Operation&& operation) override;
+
+  DelayedOperation Schedule(Milliseconds delay,
+                            TaggedOperation&& tagged) override;
+
+  bool IsCurrentExecutor() const override;
+  std::string CurrentExecutorName() const override;
+  std::string Name() const override;
+
+  bool IsScheduled(Tag tag) const override;
+  absl::optional<TaggedOperation> PopFromSchedule() override;
+
+  const std::shared_ptr<ThreadPool>& pool() const {
+    return pool_;
+  }
+
+ private:
+  // The state of the strand, shared with the operations it submits to the
+  // pool, which may outlive the strand.
+  class State;
+
+  std::shared_ptr<ThreadPool> pool_;
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_EXECUTOR_STRAND_H_
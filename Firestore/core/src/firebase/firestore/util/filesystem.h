@@ -23,6 +23,7 @@
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -61,6 +62,18 @@ Status RecursivelyCreateDir(const Path& path);
  */
 Status RecursivelyDelete(const Path& path);
 
+/**
+ * Atomically renames the file or directory at `from_path` to `to_path`, whose
+ * parent directory must already exist. Both paths must be on the same volume.
+ *
+ * Typical return codes include:
+ *   * Ok - The path was renamed.
+ *   * NotFound - Nothing exists at `from_path`, or the parent of `to_path`
+ *     doesn't exist.
+ *   * Other system-defined errors if something already exists at `to_path`.
+ */
+Status Rename(const Path& from_path, const Path& to_path);
+
 /**
  * Returns system-defined best directory in which to create temporary files.
  * Typical return values are like `/tmp` on UNIX systems. Clients should create
@@ -86,6 +99,36 @@ StatusOr<int64_t> FileSize(const Path& path);
  */
 StatusOr<std::string> ReadFile(const Path& path);
 
+/**
+ * A read-only view of the contents of a file. Where the platform supports it,
+ * the file is memory-mapped, so that its contents are paged in as they are read
+ * rather than copied into memory up front.
+ */
+class MappedFile {
+ public:
+  /**
+   * On success, opens the file at the given `path` and returns a view of its
+   * contents.
+   */
+  static StatusOr<std::unique_ptr<MappedFile>> Open(const Path& path);
+
+  virtual ~MappedFile() {
+  }
+
+  /** The contents of the file, valid for the lifetime of this instance. */
+  absl::string_view contents() const {
+    return contents_;
+  }
+
+ protected:
+  MappedFile() = default;
+
+  MappedFile(const MappedFile& other) = delete;
+  MappedFile& operator=(const MappedFile& other) = delete;
+
+  absl::string_view contents_;
+};
+
 /**
  * Implements an iterator over the contents of a directory. Initializes to the
  * first entry in the directory.
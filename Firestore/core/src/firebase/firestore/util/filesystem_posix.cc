@@ -17,11 +17,14 @@
 #include "Firestore/core/src/firebase/firestore/util/filesystem.h"
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <cerrno>
+#include <cstdio>
 #include <deque>
 #include <string>
 
@@ -70,6 +73,15 @@ Status IsDirectory(const Path& path) {
   return Status::OK();
 }
 
+Status Rename(const Path& from_path, const Path& to_path) {
+  if (::rename(from_path.c_str(), to_path.c_str())) {
+    return Status::FromErrno(
+        errno, StringFormat("Could not rename %s to %s",
+                            from_path.ToUtf8String(), to_path.ToUtf8String()));
+  }
+  return Status::OK();
+}
+
 #if !defined(__APPLE__)
 // See filesystem_apple.mm for an alternative implementation.
 Path TempDir() {
@@ -105,6 +117,61 @@ StatusOr<int64_t> FileSize(const Path& path) {
   }
 }
 
+namespace {
+
+class MappedFilePosix : public MappedFile {
+ public:
+  MappedFilePosix(void* address, size_t length)
+      : address_{address}, length_{length} {
+    contents_ = absl::string_view{static_cast<const char*>(address), length};
+  }
+
+  ~MappedFilePosix() override {
+    if (address_) {
+      ::munmap(address_, length_);
+    }
+  }
+
+ private:
+  void* address_ = nullptr;
+  size_t length_ = 0;
+};
+
+}  // namespace
+
+StatusOr<std::unique_ptr<MappedFile>> MappedFile::Open(const Path& path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return Status::FromErrno(
+        errno, StringFormat("Could not open file %s", path.ToUtf8String()));
+  }
+
+  struct stat st {};
+  if (::fstat(fd, &st)) {
+    Status status = Status::FromErrno(
+        errno, StringFormat("Failed to stat file: %s", path.ToUtf8String()));
+    ::close(fd);
+    return status;
+  }
+
+  // Empty files can't be mapped, but there's nothing to read from them anyway.
+  auto length = static_cast<size_t>(st.st_size);
+  void* address = nullptr;
+  if (length > 0) {
+    address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+      Status status = Status::FromErrno(
+          errno, StringFormat("Could not map file %s", path.ToUtf8String()));
+      ::close(fd);
+      return status;
+    }
+  }
+
+  // The mapping outlives the descriptor.
+  ::close(fd);
+  return {std::unique_ptr<MappedFile>{new MappedFilePosix(address, length)}};
+}
+
 namespace detail {
 
 Status CreateDir(const Path& path) {
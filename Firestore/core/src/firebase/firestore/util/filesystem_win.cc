@@ -22,6 +22,7 @@
 
 #include <cerrno>
 #include <string>
+#include <utility>
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
@@ -45,6 +46,16 @@ Status IsDirectory(const Path& path) {
   return Status{Error::FailedPrecondition, path.ToUtf8String()};
 }
 
+Status Rename(const Path& from_path, const Path& to_path) {
+  if (!::MoveFileExW(from_path.c_str(), to_path.c_str(), 0)) {
+    DWORD error = ::GetLastError();
+    return Status::FromLastError(
+        error, StringFormat("Could not rename %s to %s",
+                            from_path.ToUtf8String(), to_path.ToUtf8String()));
+  }
+  return Status::OK();
+}
+
 Path TempDir() {
   // Returns a null-terminated string with a trailing backslash.
   wchar_t buffer[MAX_PATH + 1];
@@ -69,6 +80,30 @@ StatusOr<int64_t> FileSize(const Path& path) {
   return result.QuadPart;
 }
 
+namespace {
+
+// Reads the whole file up front rather than mapping it.
+class MappedFileWin : public MappedFile {
+ public:
+  explicit MappedFileWin(std::string data) : data_{std::move(data)} {
+    contents_ = data_;
+  }
+
+ private:
+  std::string data_;
+};
+
+}  // namespace
+
+StatusOr<std::unique_ptr<MappedFile>> MappedFile::Open(const Path& path) {
+  StatusOr<std::string> data = ReadFile(path);
+  if (!data.ok()) {
+    return data.status();
+  }
+  return {std::unique_ptr<MappedFile>{
+      new MappedFileWin(std::move(data).ValueOrDie())}};
+}
+
 namespace detail {
 
 Status CreateDir(const Path& path) {
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_LRU_CACHE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_LRU_CACHE_H_
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * A cache of key/value pairs bounded by the total cost of its entries. When
+ * adding an entry pushes the total cost over the limit, the least recently
+ * used entries are evicted.
+ *
+ * Callers choose what the cost of an entry means; typically it's an estimate
+ * of the number of bytes the entry holds on to.
+ *
+ * LruCache is not thread-safe.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class LruCache {
+ public:
+  /**
+   * Creates a cache holding entries whose costs add up to at most `max_cost`.
+   * A `max_cost` of zero creates a cache that never stores anything.
+   */
+  explicit LruCache(size_t max_cost) : max_cost_(max_cost) {
+  }
+
+  /**
+   * Returns a pointer to the value cached for the given key, or nullptr if
+   * there's no such entry. A hit marks the entry as most recently used.
+   *
+   * The returned pointer is valid until the next modification of the cache.
+   */
+  const V* Get(const K& key) {
+    auto found = index_.find(key);
+    if (found == index_.end()) return nullptr;
+
+    entries_.splice(entries_.begin(), entries_, found->second);
+    return &found->second->value;
+  }
+
+  /**
+   * Adds the given entry to the cache, replacing any existing entry for the
+   * key, then evicts least recently used entries until the cache is within its
+   * cost limit. Entries that cost more than the limit on their own are not
+   * stored.
+   */
+  void Put(K key, V value, size_t cost) {
+    Erase(key);
+    if (cost > max_cost_) return;
+
+    entries_.push_front(Entry{std::move(key), std::move(value), cost});
+    index_.emplace(entries_.front().key, entries_.begin());
+    cost_ += cost;
+
+    while (cost_ > max_cost_) {
+      EraseEntry(std::prev(entries_.end()));
+    }
+  }
+
+  /** Removes the entry for the given key, if any. */
+  void Erase(const K& key) {
+    auto found = index_.find(key);
+    if (found != index_.end()) {
+      EraseEntry(found->second);
+    }
+  }
+
+  /**
+   * Evicts least recently used entries until the cache costs at most
+   * `max_cost`. The cache's own limit is unchanged, so it may grow back to it.
+   */
+  void Trim(size_t max_cost) {
+    while (cost_ > max_cost) {
+      EraseEntry(std::prev(entries_.end()));
+    }
+  }
+
+  /** Removes all entries from the cache. */
+  void Clear() {
+    index_.clear();
+    entries_.clear();
+    cost_ = 0;
+  }
+
+  /** The number of entries in the cache. */
+  size_t size() const {
+    return index_.size();
+  }
+
+  /** The sum of the costs of all entries in the cache. */
+  size_t cost() const {
+    return cost_;
+  }
+
+  size_t max_cost() const {
+    return max_cost_;
+  }
+
+ private:
+  struct Entry {
+    K key;
+    V value;
+    size_t cost;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  void EraseEntry(typename EntryList::iterator entry) {
+    cost_ -= entry->cost;
+    index_.erase(entry->key);
+    entries_.erase(entry);
+  }
+
+  size_t max_cost_ = 0;
+  size_t cost_ = 0;
+
+  // Ordered from most to least recently used.
+  EntryList entries_;
+  std::unordered_map<K, typename EntryList::iterator, Hash> index_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_LRU_CACHE_H_
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
+
+#include "Firestore/core/src/firebase/firestore/util/bits.h"
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+bool operator==(const HistogramSnapshot& lhs, const HistogramSnapshot& rhs) {
+  return lhs.buckets == rhs.buckets && lhs.count == rhs.count &&
+         lhs.sum == rhs.sum && lhs.max == rhs.max;
+}
+
+Histogram::Histogram() : count_{0}, sum_{0}, max_{0} {
+  for (std::atomic<uint64_t>& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Histogram::Record(uint64_t value) {
+  size_t bucket = value == 0 ? 0 : Bits::Log2FloorNonZero64(value) + 1;
+  buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+
+  uint64_t max = max_.load(std::memory_order_relaxed);
+  while (value > max &&
+         !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+  // Values recorded while the snapshot is taken may be only partly included,
+  // which is fine for statistics.
+  HistogramSnapshot result;
+  for (size_t i = 0; i < buckets_.size(); ++i) {
+    result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+  }
+  result.count = count_.load(std::memory_order_relaxed);
+  result.sum = sum_.load(std::memory_order_relaxed);
+  result.max = max_.load(std::memory_order_relaxed);
+  return result;
+}
+
+MetricsRegistry& MetricsRegistry::Default() {
+  // Never destroyed, so that metrics can be updated during static destruction.
+  static MetricsRegistry* registry = new MetricsRegistry();
+  return *registry;
+}
+
+Counter& MetricsRegistry::GetCounter(const std::string& name) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  std::unique_ptr<Counter>& counter = counters_[name];
+  if (!counter) {
+    counter = absl::make_unique<Counter>();
+  }
+  return *counter;
+}
+
+Histogram& MetricsRegistry::GetHistogram(const std::string& name) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  std::unique_ptr<Histogram>& histogram = histograms_[name];
+  if (!histogram) {
+    histogram = absl::make_unique<Histogram>();
+  }
+  return *histogram;
+}
+
+MetricsSnapshot MetricsRegistry::Snapshot() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  MetricsSnapshot result;
+  for (const auto& kv : counters_) {
+    result.counters[kv.first] = kv.second->value();
+  }
+  for (const auto& kv : histograms_) {
+    result.histograms[kv.first] = kv.second->Snapshot();
+  }
+  return result;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_METRICS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/** A count that only goes up. Can be updated from any thread. */
+class Counter {
+ public:
+  void Increment(uint64_t amount = 1) {
+    value_.fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  uint64_t value() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * The number of buckets of a histogram: one for zero and one for each bit
+ * length of a non-zero value.
+ */
+constexpr size_t kHistogramBucketCount = 65;
+
+/** The distribution of the values a histogram recorded up to some point. */
+struct HistogramSnapshot {
+  /**
+   * The number of values recorded in each bucket. Bucket 0 holds the zeros,
+   * and bucket `i` above it the values in [2^(i-1), 2^i).
+   */
+  std::array<uint64_t, kHistogramBucketCount> buckets{};
+
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t max = 0;
+};
+
+bool operator==(const HistogramSnapshot& lhs, const HistogramSnapshot& rhs);
+
+/**
+ * Records the distribution of some value, such as a size or a duration, in
+ * buckets whose bounds grow by powers of two. Can be updated from any thread.
+ */
+class Histogram {
+ public:
+  Histogram();
+
+  void Record(uint64_t value);
+
+  HistogramSnapshot Snapshot() const;
+
+ private:
+  std::array<std::atomic<uint64_t>, kHistogramBucketCount> buckets_;
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+};
+
+/** The values of all the metrics of a registry at some point. */
+struct MetricsSnapshot {
+  std::map<std::string, uint64_t> counters;
+  std::map<std::string, HistogramSnapshot> histograms;
+};
+
+/**
+ * Keeps named counters and histograms that instrumented code updates, so that
+ * a snapshot of all of them can be taken at any time.
+ *
+ * Metrics are created the first time they are asked for and live as long as
+ * the registry, so hot code can look a metric up once and keep a reference to
+ * it.
+ */
+class MetricsRegistry {
+ public:
+  /**
+   * The registry the SDK records its metrics into, shared by all Firestore
+   * instances in the process.
+   */
+  static MetricsRegistry& Default();
+
+  Counter& GetCounter(const std::string& name);
+  Histogram& GetHistogram(const std::string& name);
+
+  MetricsSnapshot Snapshot() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Counter>> counters_;
+  std::map<std::string, std::unique_ptr<Histogram>> histograms_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_METRICS_H_
@@ -18,6 +18,7 @@
 
 #include "Firestore/core/src/firebase/firestore/util/bits.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/base/internal/bits.h"
 #include "absl/base/internal/endian.h"
 #include "absl/base/internal/unaligned_access.h"
 #include "absl/base/port.h"
@@ -28,6 +29,12 @@
        "ABSL_IS_LITTLE_ENDIAN must be defined"
 #endif
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #define UNALIGNED_LOAD32 ABSL_INTERNAL_UNALIGNED_LOAD32
 #define UNALIGNED_LOAD64 ABSL_INTERNAL_UNALIGNED_LOAD64
 #define UNALIGNED_STORE32 ABSL_INTERNAL_UNALIGNED_STORE32
@@ -134,6 +141,39 @@ inline static const char* SkipToNextSpecialByte(const char* start,
   static_assert(kEscape1 == 0, "bit fiddling needs readjusting");
   static_assert((kEscape2 & 0xff) == 255, "bit fiddling needs readjusting");
   const char* p = start;
+
+  // Where available, first scan 16 bytes at a time with SIMD compares. Most
+  // path segments contain no special bytes at all, so this usually runs to
+  // within 16 bytes of the end and leaves the tail to the loops below.
+#if defined(__SSE2__)
+  const __m128i zeros = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi8(static_cast<char>(0xff));
+  while (p + 16 <= limit) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i special =
+        _mm_or_si128(_mm_cmpeq_epi8(v, zeros), _mm_cmpeq_epi8(v, ones));
+    int mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return p + absl::base_internal::CountTrailingZerosNonZero32(
+                     static_cast<uint32_t>(mask));
+    }
+    p += 16;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const uint8x16_t one = vdupq_n_u8(1);
+  const uint8x16_t two = vdupq_n_u8(2);
+  while (p + 16 <= limit) {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    // The same (x + 1) < 2 test as IsSpecialByte, on every lane.
+    uint8x16_t special = vcltq_u8(vaddq_u8(v, one), two);
+    if (vmaxvq_u8(special) != 0) {
+      // The 8 byte loop below pinpoints the special byte.
+      break;
+    }
+    p += 16;
+  }
+#endif
+
   while (p + 8 <= limit) {
     // Find out if any of the next 8 bytes are either 0 or 255 (our
     // two characters that require special handling).  We do this using
@@ -353,6 +393,22 @@ bool OrderedCode::ReadString(absl::string_view* src, std::string* result) {
   return ReadStringInternal(src, result);
 }
 
+bool OrderedCode::ReadStringView(absl::string_view* src,
+                                 absl::string_view* result) {
+  if (src->size() < 2) return false;
+
+  const char* start = src->data();
+  const char* limit = start + src->size() - 1;
+  const char* p = SkipToNextSpecialByte(start, limit);
+  if (p >= limit || p[0] != kEscape1 || p[1] != kSeparator) {
+    return false;
+  }
+
+  *result = absl::string_view{start, static_cast<size_t>(p - start)};
+  src->remove_prefix(static_cast<size_t>(p - start) + 2);
+  return true;
+}
+
 bool OrderedCode::ReadNumIncreasing(absl::string_view* src, uint64_t* result) {
   if (src->empty()) {
     return false;  // Not enough bytes
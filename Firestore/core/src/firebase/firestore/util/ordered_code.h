@@ -88,6 +88,16 @@ class OrderedCode {
   // otherwise.
 
   static bool ReadString(absl::string_view* src, std::string* result);
+
+  /**
+   * Like ReadString, but for the common case where the encoded string needed
+   * no escaping: sets "*result" to a view of the string's bytes within "*src"
+   * rather than copying them. Returns false, leaving "*src" untouched, if the
+   * next item isn't a string or contains escaped bytes (in which case
+   * ReadString must be used instead).
+   */
+  static bool ReadStringView(absl::string_view* src,
+                             absl::string_view* result);
   static bool ReadNumIncreasing(absl::string_view* src, uint64_t* result);
   static bool ReadSignedNumIncreasing(absl::string_view* src, int64_t* result);
 
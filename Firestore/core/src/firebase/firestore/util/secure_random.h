@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SECURE_RANDOM_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SECURE_RANDOM_H_
 
+#include <cstddef>
 #include <cstdint>
 
 #include <limits>
@@ -51,6 +52,12 @@ class SecureRandom {
 
   result_type operator()();
 
+  /**
+   * Fills the `size` bytes at `buffer` with pseudorandom bytes, which is much
+   * cheaper than calling the generator for every four of them.
+   */
+  void Fill(void* buffer, size_t size);
+
   /** Returns a uniformly distributed pseudorandom integer in [0, n). */
   inline result_type Uniform(result_type n) {
     // Divides the range into buckets of size n plus leftovers.
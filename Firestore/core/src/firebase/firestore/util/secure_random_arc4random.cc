@@ -30,6 +30,10 @@ SecureRandom::result_type SecureRandom::operator()() {
   return arc4random();
 }
 
+void SecureRandom::Fill(void* buffer, size_t size) {
+  arc4random_buf(buffer, size);
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
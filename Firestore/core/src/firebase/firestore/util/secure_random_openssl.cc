@@ -29,14 +29,18 @@ namespace util {
 
 SecureRandom::result_type SecureRandom::operator()() {
   result_type result;
-  int rc = RAND_bytes(reinterpret_cast<uint8_t*>(&result), sizeof(result));
+  Fill(&result, sizeof(result));
+  return result;
+}
+
+void SecureRandom::Fill(void* buffer, size_t size) {
+  int rc = RAND_bytes(static_cast<uint8_t*>(buffer), static_cast<int>(size));
   if (rc <= 0) {
     // OpenSSL's RAND_bytes can fail if there's not enough entropy. BoringSSL
     // won't fail this way.
     ERR_print_errors_fp(stderr);
     abort();
   }
-  return result;
 }
 
 }  // namespace util
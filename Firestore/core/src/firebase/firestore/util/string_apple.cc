@@ -21,6 +21,7 @@
 #include <string>
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/utf16.h"
 
 namespace firebase {
 namespace firestore {
@@ -32,6 +33,20 @@ std::string MakeString(CFStringRef str) {
     return {};
   }
 
+  // CoreFoundation only stores strings in 8-bit form when every character is
+  // ASCII, and hands them out directly, so the bytes can be copied as is.
+  const char* c_str = CFStringGetCStringPtr(str, kCFStringEncodingUTF8);
+  if (c_str) {
+    return std::string(c_str, static_cast<size_t>(num_chars));
+  }
+
+  // Strings stored as UTF-16 can be transcoded without asking CoreFoundation
+  // for the size of the result first.
+  const UniChar* chars = CFStringGetCharactersPtr(str);
+  if (chars) {
+    return Utf16ToUtf8(chars, static_cast<size_t>(num_chars));
+  }
+
   // In the first pass figure the size required. The size does not include the
   // null terminator.
   CFRange range{0, num_chars};
@@ -24,15 +24,15 @@ namespace internal {
 static const char* kMissing = "<missing>";
 static const char* kInvalid = "<invalid>";
 
-std::string StringFormatPieces(
-    const char* format, std::initializer_list<absl::string_view> pieces) {
+std::string StringFormatPieces(const char* format,
+                               const absl::string_view* pieces_begin,
+                               const absl::string_view* pieces_end) {
   std::string result;
 
   const char* format_iter = format;
   const char* format_end = format + strlen(format);
 
-  auto pieces_iter = pieces.begin();
-  auto pieces_end = pieces.end();
+  const absl::string_view* pieces_iter = pieces_begin;
   auto append_next_piece = [&](std::string* dest) {
     if (pieces_iter == pieces_end) {
       dest->append(kMissing);
@@ -35,7 +35,13 @@ namespace util {
 namespace internal {
 
 std::string StringFormatPieces(const char* format,
-                               std::initializer_list<absl::string_view> pieces);
+                               const absl::string_view* pieces_begin,
+                               const absl::string_view* pieces_end);
+
+inline std::string StringFormatPieces(
+    const char* format, std::initializer_list<absl::string_view> pieces) {
+  return StringFormatPieces(format, pieces.begin(), pieces.end());
+}
 
 /**
  * Explicit ranking for formatting choices. Only useful as an implementation
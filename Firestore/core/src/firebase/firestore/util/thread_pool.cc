@@ -0,0 +1,205 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+// The state of a `ParallelFor` call shared with the operations it submits,
+// which may outlive the call.
+struct ParallelForState {
+  ParallelForState(size_t count, const std::function<void(size_t)>* body)
+      : count{count}, body{body} {
+    next = 0;
+    finished = 0;
+  }
+
+  // Calls `body` with unclaimed indices until there are none left.
+  void Run() {
+    for (size_t i = next++; i < count; i = next++) {
+      (*body)(i);
+      if (++finished == count) {
+        std::lock_guard<std::mutex> lock{mutex};
+        done.notify_all();
+      }
+    }
+  }
+
+  const size_t count;
+  // Only dereferenced for claimed indices, so only while `ParallelFor` waits.
+  const std::function<void(size_t)>* const body;
+  std::atomic<size_t> next;
+  std::atomic<size_t> finished;
+  std::mutex mutex;
+  std::condition_variable done;
+};
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t thread_count) {
+  // As in `ExecutorStd`, atomics must be initialized before the threads start.
+  queued_count_ = 0;
+  next_worker_ = 0;
+  shutting_down_ = false;
+
+  thread_count = std::max<size_t>(thread_count, 1);
+  for (size_t i = 0; i != thread_count; ++i) {
+    workers_.push_back(absl::make_unique<Worker>());
+  }
+  for (size_t i = 0; i != thread_count; ++i) {
+    workers_[i]->thread = std::thread{&ThreadPool::PollingThread, this, i};
+    workers_[i]->id = workers_[i]->thread.get_id();
+  }
+  timer_thread_ = std::thread{&ThreadPool::TimerThread, this};
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{sleep_mutex_};
+    shutting_down_ = true;
+  }
+  wake_.notify_all();
+  timers_.Wake();
+
+  timer_thread_.join();
+  for (const auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+size_t ThreadPool::DefaultThreadCount() {
+  // `hardware_concurrency` returns 0 if the number isn't known.
+  return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+void ThreadPool::Submit(Operation&& operation) {
+  size_t index = CurrentWorkerIndex();
+  if (index == workers_.size()) {
+    index = next_worker_++ % workers_.size();
+  }
+  {
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock{worker.mutex};
+    worker.operations.push_back(std::move(operation));
+  }
+  {
+    std::lock_guard<std::mutex> lock{sleep_mutex_};
+    ++queued_count_;
+  }
+  wake_.notify_one();
+}
+
+void ThreadPool::SubmitAt(TimePoint due, Operation&& operation) {
+  timers_.Push(std::move(operation), due);
+}
+
+void ThreadPool::ParallelFor(size_t count,
+                             const std::function<void(size_t)>& body) {
+  if (count == 0) {
+    return;
+  }
+
+  auto state = std::make_shared<ParallelForState>(count, &body);
+  size_t helpers = std::min(count, workers_.size()) - 1;
+  for (size_t i = 0; i != helpers; ++i) {
+    Submit([state] { state->Run(); });
+  }
+  state->Run();
+
+  // The helpers still running claimed their last index before the caller ran
+  // out of indices; wait for them to finish.
+  std::unique_lock<std::mutex> lock{state->mutex};
+  state->done.wait(lock, [&] { return state->finished == count; });
+}
+
+bool ThreadPool::IsWorkerThread() const {
+  return CurrentWorkerIndex() != workers_.size();
+}
+
+size_t ThreadPool::CurrentWorkerIndex() const {
+  // Pools have few enough threads for a linear search to be cheaper than
+  // a thread-local variable, which not all supported platforms provide.
+  std::thread::id current = std::this_thread::get_id();
+  for (size_t i = 0; i != workers_.size(); ++i) {
+    if (workers_[i]->id == current) {
+      return i;
+    }
+  }
+  return workers_.size();
+}
+
+bool ThreadPool::TryPop(size_t index, Operation* operation) {
+  {
+    Worker& own = *workers_[index];
+    std::lock_guard<std::mutex> lock{own.mutex};
+    if (!own.operations.empty()) {
+      *operation = std::move(own.operations.back());
+      own.operations.pop_back();
+      --queued_count_;
+      return true;
+    }
+  }
+
+  for (size_t i = 1; i != workers_.size(); ++i) {
+    Worker& victim = *workers_[(index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock{victim.mutex};
+    if (!victim.operations.empty()) {
+      *operation = std::move(victim.operations.front());
+      victim.operations.pop_front();
+      --queued_count_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::PollingThread(size_t index) {
+  Operation operation;
+  while (!shutting_down_) {
+    if (TryPop(index, &operation)) {
+      operation();
+      operation = nullptr;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock{sleep_mutex_};
+    wake_.wait(lock, [this] { return shutting_down_ || queued_count_ > 0; });
+  }
+}
+
+void ThreadPool::TimerThread() {
+  while (!shutting_down_) {
+    absl::optional<Operation> due =
+        timers_.PopBlockingUnless([this] { return shutting_down_.load(); });
+    if (due) {
+      Submit(std::move(*due));
+    }
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
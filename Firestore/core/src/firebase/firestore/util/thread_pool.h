@@ -0,0 +1,127 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_THREAD_POOL_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+// A pool of worker threads that run operations in parallel, in no particular
+// order.
+//
+// Each worker has a deque of its own: operations submitted by a worker go to
+// the back of its deque, and the worker runs the most recently submitted one
+// first, while its data is still in cache. Operations submitted from other
+// threads are spread across the workers. A worker that runs out of operations
+// steals the oldest operation of another worker before going to sleep.
+//
+// The pool doesn't provide any ordering guarantees; use `ExecutorStrand` to
+// run operations on the pool one at a time, in order.
+class ThreadPool {
+ public:
+  using Operation = Executor::Operation;
+  using TimePoint = async::Schedule<Operation>::TimePoint;
+
+  // Starts `thread_count` workers (at least one), as well as a thread that
+  // submits delayed operations once they are due.
+  explicit ThreadPool(size_t thread_count = DefaultThreadCount());
+
+  // Operations that haven't started yet are discarded. Waits for the
+  // operations that are running to finish.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // One worker per hardware thread.
+  static size_t DefaultThreadCount();
+
+  size_t thread_count() const {
+    return workers_.size();
+  }
+
+  // Puts the `operation` on the pool to be run by any worker.
+  void Submit(Operation&& operation);
+
+  // Submits the `operation` once `due` has passed. The pool doesn't support
+  // canceling delayed operations; have the operation check whether it's still
+  // wanted instead.
+  void SubmitAt(TimePoint due, Operation&& operation);
+
+  // Calls `body` with each index in `[0, count)` in parallel, and returns once
+  // all the calls have finished. The calling thread takes part in the work, so
+  // `ParallelFor` may be called by an operation running on the pool (or on a
+  // strand on top of it) without deadlocking, even with a single worker.
+  void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+  // Returns whether the caller is run by one of the workers of this pool.
+  bool IsWorkerThread() const;
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Operation> operations;
+    std::thread thread;
+    // Kept apart from `thread`, which joining it modifies.
+    std::thread::id id;
+  };
+
+  void PollingThread(size_t index);
+  void TimerThread();
+
+  // Returns the index of the worker running on the current thread, or
+  // `thread_count()` if the current thread isn't a worker of this pool.
+  size_t CurrentWorkerIndex() const;
+
+  // Pops an operation from the back of the deque of the worker with the given
+  // `index`, or else steals one from the front of another worker's deque.
+  bool TryPop(size_t index, Operation* operation);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // The number of operations in the deques of all workers, which is only
+  // increased with `sleep_mutex_` locked so that workers about to go to sleep
+  // can't miss an operation.
+  std::atomic<size_t> queued_count_;
+  std::atomic<size_t> next_worker_;
+  std::atomic<bool> shutting_down_;
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+
+  async::Schedule<Operation> timers_;
+  std::thread timer_thread_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_THREAD_POOL_H_
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+
+#include <atomic>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+std::atomic<TraceSink*> trace_sink{nullptr};
+
+}  // namespace
+
+void CallbackTraceSink::BeginSpan(const TraceSpan&) {
+}
+
+void CallbackTraceSink::EndSpan(const TraceSpan& span,
+                                TraceClock::time_point end) {
+  if (callback_) {
+    callback_(span.name(), span.start(), end);
+  }
+}
+
+void SetTraceSink(TraceSink* sink) {
+  trace_sink.store(sink, std::memory_order_release);
+}
+
+TraceSpan::TraceSpan(const char* name)
+    : name_{name}, sink_{trace_sink.load(std::memory_order_acquire)} {
+  if (sink_) {
+    start_ = TraceClock::now();
+    sink_->BeginSpan(*this);
+  }
+}
+
+TraceSpan::~TraceSpan() {
+  if (sink_) {
+    sink_->EndSpan(*this, TraceClock::now());
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
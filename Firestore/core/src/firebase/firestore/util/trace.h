@@ -0,0 +1,129 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+using TraceClock = std::chrono::steady_clock;
+
+class TraceSpan;
+
+/**
+ * Receives the spans traced while it is installed through `SetTraceSink`.
+ * Spans are reported on the thread that runs them, so implementations must be
+ * thread-safe.
+ */
+class TraceSink {
+ public:
+  virtual ~TraceSink() = default;
+
+  virtual void BeginSpan(const TraceSpan& span) = 0;
+
+  /**
+   * Called when `span` ends. `span` is the same object `BeginSpan` was called
+   * with, so its address identifies it until then.
+   */
+  virtual void EndSpan(const TraceSpan& span, TraceClock::time_point end) = 0;
+};
+
+/** A sink that reports each span to a callback once it ends. */
+class CallbackTraceSink : public TraceSink {
+ public:
+  using Callback = std::function<void(const char* name,
+                                      TraceClock::time_point start,
+                                      TraceClock::time_point end)>;
+
+  explicit CallbackTraceSink(Callback callback)
+      : callback_{std::move(callback)} {
+  }
+
+  void BeginSpan(const TraceSpan& span) override;
+  void EndSpan(const TraceSpan& span, TraceClock::time_point end) override;
+
+ private:
+  Callback callback_;
+};
+
+#if defined(__APPLE__)
+/**
+ * Creates a sink that records each span as an os_signpost interval, for
+ * Instruments, or returns null if the OS doesn't support signposts.
+ */
+std::unique_ptr<TraceSink> CreateSignpostTraceSink();
+#endif  // defined(__APPLE__)
+
+/**
+ * Installs the sink that spans are reported to, or removes it if null. The
+ * sink is not owned and must outlive every span started while it is
+ * installed. Without a sink, a span costs only a check that there isn't one.
+ */
+void SetTraceSink(TraceSink* sink);
+
+/**
+ * Measures the time from its construction to its destruction as a named span,
+ * with monotonic timestamps. Use `FIRESTORE_TRACE_SPAN` rather than creating
+ * spans directly, so that tracing can be compiled out.
+ */
+class TraceSpan {
+ public:
+  /** `name` must outlive the span, such as a string literal. */
+  explicit TraceSpan(const char* name);
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  const char* name() const {
+    return name_;
+  }
+
+  TraceClock::time_point start() const {
+    return start_;
+  }
+
+ private:
+  const char* name_ = nullptr;
+
+  // The sink installed when the span started, if any, so that a span is
+  // always reported to the sink that saw it begin.
+  TraceSink* sink_ = nullptr;
+  TraceClock::time_point start_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+// Traces the rest of the enclosing scope as a span with the given name. At
+// most one span can be started per scope. Defining FIRESTORE_DISABLE_TRACING
+// removes all spans at compile time.
+#if defined(FIRESTORE_DISABLE_TRACING)
+#define FIRESTORE_TRACE_SPAN(name) static_cast<void>(0)
+#else
+#define FIRESTORE_TRACE_SPAN(name) \
+  ::firebase::firestore::util::TraceSpan _firestore_trace_span { name }
+#endif  // defined(FIRESTORE_DISABLE_TRACING)
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_H_
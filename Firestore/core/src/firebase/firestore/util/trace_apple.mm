@@ -0,0 +1,73 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+
+#if defined(__APPLE__)
+
+#import <Foundation/Foundation.h>
+#include <os/log.h>
+#include <os/signpost.h>
+
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+// os_signpost requires the interval name to be a literal, so every span is
+// an interval with this name, described by the name of the span.
+#define FIRESTORE_SIGNPOST_NAME "Firestore"
+
+class API_AVAILABLE(ios(12.0), macos(10.14), tvos(12.0)) SignpostTraceSink
+    : public TraceSink {
+ public:
+  SignpostTraceSink()
+      : log_{os_log_create("com.google.firebase.firestore", "Tracing")} {
+  }
+
+  void BeginSpan(const TraceSpan& span) override {
+    os_signpost_id_t span_id = os_signpost_id_make_with_pointer(log_, &span);
+    os_signpost_interval_begin(log_, span_id, FIRESTORE_SIGNPOST_NAME,
+                               "%{public}s", span.name());
+  }
+
+  void EndSpan(const TraceSpan& span, TraceClock::time_point) override {
+    os_signpost_id_t span_id = os_signpost_id_make_with_pointer(log_, &span);
+    os_signpost_interval_end(log_, span_id, FIRESTORE_SIGNPOST_NAME,
+                             "%{public}s", span.name());
+  }
+
+ private:
+  os_log_t log_;
+};
+
+}  // namespace
+
+std::unique_ptr<TraceSink> CreateSignpostTraceSink() {
+  if (@available(iOS 12.0, macOS 10.14, tvOS 12.0, *)) {
+    return absl::make_unique<SignpostTraceSink>();
+  }
+  return nullptr;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // defined(__APPLE__)
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_UNIQUE_FUNCTION_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_UNIQUE_FUNCTION_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+template <typename Signature, std::size_t InlineSize = 6 * sizeof(void*)>
+class UniqueFunction;
+
+// UniqueFunction<R(Args...)> is a move-only replacement for
+// std::function<R(Args...)>.
+//
+// Unlike std::function, UniqueFunction never copies the callable it wraps, so
+// the callable may itself be move-only, and moving a UniqueFunction never
+// allocates. Callables of up to `InlineSize` bytes (that are no more aligned
+// than a pointer and can be moved without throwing) are stored inline; larger
+// ones are stored on the heap. The default `InlineSize` fits a lambda
+// capturing several pointers and shared pointers.
+//
+// `InlineSize` can be increased for UniqueFunctions that routinely wrap other
+// UniqueFunctions, so that the wrapped function can be stored inline as well.
+template <typename R, typename... Args, std::size_t InlineSize>
+class UniqueFunction<R(Args...), InlineSize> {
+  // Callables stored on the heap are stored as a pointer to them.
+  static_assert(InlineSize >= sizeof(void*),
+                "UniqueFunction must have room for at least a pointer");
+
+  using Storage =
+      typename std::aligned_storage<InlineSize, alignof(void*)>::type;
+
+  // Whether `F` can be invoked with `Args` and returns something convertible
+  // to `R`.
+  template <typename F, typename = void>
+  struct IsCallable : std::false_type {};
+
+  template <typename F>
+  struct IsCallable<
+      F,
+      typename std::enable_if<std::is_convertible<
+          decltype(std::declval<F&>()(std::declval<Args>()...)),
+          R>::value>::type> : std::true_type {};
+
+ public:
+  UniqueFunction() noexcept {
+  }
+
+  UniqueFunction(std::nullptr_t) noexcept {  // NOLINT(runtime/explicit)
+  }
+
+  /**
+   * Wraps the given callable. Like std::function, a null function pointer or
+   * an empty UniqueFunction (of any `InlineSize`) results in an empty
+   * UniqueFunction.
+   */
+  template <typename F,
+            typename D = typename std::decay<F>::type,
+            typename std::enable_if<!std::is_same<D, UniqueFunction>::value &&
+                                        IsCallable<D>::value,
+                                    int>::type = 0>
+  UniqueFunction(F&& f) {  // NOLINT(runtime/explicit)
+    if (!IsNull(f)) {
+      Init<D>(std::forward<F>(f));
+    }
+  }
+
+  UniqueFunction(UniqueFunction&& other) noexcept {
+    MoveFrom(&other);
+  }
+
+  UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      MoveFrom(&other);
+    }
+    return *this;
+  }
+
+  UniqueFunction& operator=(std::nullptr_t) noexcept {
+    Reset();
+    return *this;
+  }
+
+  UniqueFunction(const UniqueFunction&) = delete;
+  UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+  ~UniqueFunction() {
+    Reset();
+  }
+
+  explicit operator bool() const noexcept {
+    return ops_ != nullptr;
+  }
+
+  /**
+   * Invokes the wrapped callable, which may modify its state (like a mutable
+   * lambda).
+   *
+   * Precondition: this UniqueFunction is not empty.
+   */
+  R operator()(Args... args) const {
+    HARD_ASSERT(ops_, "Invoked an empty UniqueFunction");
+    return ops_->invoke(&storage_, std::forward<Args>(args)...);
+  }
+
+  /** Returns whether a callable of type `F` is stored without allocating. */
+  template <typename F>
+  static constexpr bool StoresInline() {
+    return sizeof(F) <= InlineSize && alignof(F) <= alignof(Storage) &&
+           std::is_nothrow_move_constructible<F>::value;
+  }
+
+ private:
+  // The operations on a type-erased callable, filled in for each type of
+  // callable and each way of storing it.
+  struct Ops {
+    R (*invoke)(void* storage, Args&&... args);
+    // Move-constructs the callable in `to` from the one in `from`, then
+    // destroys the one in `from`.
+    void (*relocate)(void* from, void* to);
+    void (*destroy)(void* storage);
+  };
+
+  template <typename F>
+  struct InlineOps {
+    static F* Get(void* storage) {
+      return static_cast<F*>(storage);
+    }
+    static R Invoke(void* storage, Args&&... args) {
+      return (*Get(storage))(std::forward<Args>(args)...);
+    }
+    static void Relocate(void* from, void* to) {
+      new (to) F(std::move(*Get(from)));
+      Get(from)->~F();
+    }
+    static void Destroy(void* storage) {
+      Get(storage)->~F();
+    }
+    static const Ops* Table() {
+      static const Ops ops = {&Invoke, &Relocate, &Destroy};
+      return &ops;
+    }
+  };
+
+  template <typename F>
+  struct HeapOps {
+    static F*& Get(void* storage) {
+      return *static_cast<F**>(storage);
+    }
+    static R Invoke(void* storage, Args&&... args) {
+      return (*Get(storage))(std::forward<Args>(args)...);
+    }
+    static void Relocate(void* from, void* to) {
+      new (to) F*(Get(from));
+    }
+    static void Destroy(void* storage) {
+      delete Get(storage);
+    }
+    static const Ops* Table() {
+      static const Ops ops = {&Invoke, &Relocate, &Destroy};
+      return &ops;
+    }
+  };
+
+  template <typename F>
+  static bool IsNull(const F&) {
+    return false;
+  }
+  template <typename F>
+  static bool IsNull(F* f) {
+    return f == nullptr;
+  }
+  template <std::size_t OtherInlineSize>
+  static bool IsNull(const UniqueFunction<R(Args...), OtherInlineSize>& f) {
+    return !f;
+  }
+
+  template <typename D, typename F>
+  typename std::enable_if<StoresInline<D>()>::type Init(F&& f) {
+    new (&storage_) D(std::forward<F>(f));
+    ops_ = InlineOps<D>::Table();
+  }
+
+  template <typename D, typename F>
+  typename std::enable_if<!StoresInline<D>()>::type Init(F&& f) {
+    new (&storage_) D*(new D(std::forward<F>(f)));
+    ops_ = HeapOps<D>::Table();
+  }
+
+  void MoveFrom(UniqueFunction* other) noexcept {
+    if (other->ops_) {
+      other->ops_->relocate(&other->storage_, &storage_);
+      ops_ = other->ops_;
+      other->ops_ = nullptr;
+    }
+  }
+
+  void Reset() noexcept {
+    if (ops_) {
+      const Ops* ops = ops_;
+      ops_ = nullptr;
+      ops->destroy(&storage_);
+    }
+  }
+
+  mutable Storage storage_;
+  const Ops* ops_ = nullptr;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_UNIQUE_FUNCTION_H_
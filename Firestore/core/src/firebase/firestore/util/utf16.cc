@@ -0,0 +1,111 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/utf16.h"
+
+#include <cstring>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+// Set in a word of four UTF-16 code units if any of them isn't ASCII.
+constexpr uint64_t kNonAsciiMask = 0xFF80FF80FF80FF80ULL;
+
+bool IsHighSurrogate(uint32_t unit) {
+  return unit >= 0xD800 && unit <= 0xDBFF;
+}
+
+bool IsLowSurrogate(uint32_t unit) {
+  return unit >= 0xDC00 && unit <= 0xDFFF;
+}
+
+// Converts the given UTF-16 code units to UTF-8 and returns the number of
+// bytes the result takes up. Only writes the result to `out` if `kWrite`, so
+// that the same code can compute the size of the result first.
+template <bool kWrite>
+size_t TranscodeToUtf8(const uint16_t* units, size_t count, char* out) {
+  size_t size = 0;
+  size_t i = 0;
+  while (i < count) {
+    if (count - i >= 4) {
+      uint64_t word;
+      std::memcpy(&word, units + i, sizeof(word));
+      if ((word & kNonAsciiMask) == 0) {
+        if (kWrite) {
+          for (size_t j = 0; j != 4; ++j) {
+            out[size + j] = static_cast<char>(units[i + j]);
+          }
+        }
+        size += 4;
+        i += 4;
+        continue;
+      }
+    }
+
+    uint32_t code_point = units[i++];
+    if (IsHighSurrogate(code_point) && i < count && IsLowSurrogate(units[i])) {
+      uint32_t low = units[i++];
+      code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+    } else if (IsHighSurrogate(code_point) || IsLowSurrogate(code_point)) {
+      code_point = 0xFFFD;
+    }
+
+    if (code_point < 0x80) {
+      if (kWrite) {
+        out[size] = static_cast<char>(code_point);
+      }
+      size += 1;
+    } else if (code_point < 0x800) {
+      if (kWrite) {
+        out[size] = static_cast<char>(0xC0 | (code_point >> 6));
+        out[size + 1] = static_cast<char>(0x80 | (code_point & 0x3F));
+      }
+      size += 2;
+    } else if (code_point < 0x10000) {
+      if (kWrite) {
+        out[size] = static_cast<char>(0xE0 | (code_point >> 12));
+        out[size + 1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out[size + 2] = static_cast<char>(0x80 | (code_point & 0x3F));
+      }
+      size += 3;
+    } else {
+      if (kWrite) {
+        out[size] = static_cast<char>(0xF0 | (code_point >> 18));
+        out[size + 1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        out[size + 2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out[size + 3] = static_cast<char>(0x80 | (code_point & 0x3F));
+      }
+      size += 4;
+    }
+  }
+  return size;
+}
+
+}  // namespace
+
+std::string Utf16ToUtf8(const uint16_t* units, size_t count) {
+  std::string result(TranscodeToUtf8<false>(units, count, nullptr), '\0');
+  if (!result.empty()) {
+    TranscodeToUtf8<true>(units, count, &result[0]);
+  }
+  return result;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_UTF16_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_UTF16_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * Converts `count` UTF-16 code units to UTF-8, replacing unpaired surrogates
+ * with U+FFFD.
+ *
+ * Runs of ASCII characters are checked and copied four at a time, which makes
+ * this considerably faster than decoding every code point for the mostly-ASCII
+ * strings that field names and values tend to be.
+ */
+std::string Utf16ToUtf8(const uint16_t* units, size_t count);
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_UTF16_H_
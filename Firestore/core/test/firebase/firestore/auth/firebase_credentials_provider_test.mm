@@ -20,6 +20,7 @@
 #import <FirebaseCore/FIRApp.h>
 
 #include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <future>  // NOLINT(build/c++11)
 #include <memory>
 
@@ -34,6 +35,7 @@
 @property(nonatomic, nullable, strong, readonly) NSString* token;
 @property(nonatomic, nullable, strong, readonly) NSString* uid;
 @property(nonatomic, readonly) BOOL forceRefreshTriggered;
+@property(nonatomic, readonly) int tokenRequests;
 - (instancetype)initWithToken:(nullable NSString*)token
                           uid:(nullable NSString*)uid NS_DESIGNATED_INITIALIZER;
 - (instancetype)init NS_UNAVAILABLE;
@@ -61,6 +63,7 @@
 - (void)getTokenForcingRefresh:(BOOL)forceRefresh
                   withCallback:(nonnull FIRTokenCallback)callback {
   _forceRefreshTriggered = forceRefresh;
+  _tokenRequests++;
   callback(self.token, nil);
 }
 
@@ -69,6 +72,24 @@
 namespace firebase {
 namespace firestore {
 namespace auth {
+namespace {
+
+/** Creates an unsigned JWT that expires `lifetime` from now. */
+NSString* MakeJwt(std::chrono::seconds lifetime) {
+  auto expiry = std::chrono::system_clock::now() + lifetime;
+  int64_t exp = std::chrono::duration_cast<std::chrono::seconds>(
+                    expiry.time_since_epoch())
+                    .count();
+  NSData* claims = [[NSString stringWithFormat:@"{\"exp\":%@}", @(exp)]
+      dataUsingEncoding:NSUTF8StringEncoding];
+  NSString* payload = [claims base64EncodedStringWithOptions:0];
+  payload = [payload stringByReplacingOccurrencesOfString:@"=" withString:@""];
+  payload = [payload stringByReplacingOccurrencesOfString:@"+" withString:@"-"];
+  payload = [payload stringByReplacingOccurrencesOfString:@"/" withString:@"_"];
+  return [NSString stringWithFormat:@"eyJhbGciOiJub25lIn0.%@.", payload];
+}
+
+}  // namespace
 
 // Simulates the case where Firebase/Firestore is installed in the project but
 // Firebase/Auth is not available.
@@ -153,6 +174,68 @@ TEST(FirebaseCredentialsProviderTest, InvalidateToken) {
   });
 }
 
+TEST(FirebaseCredentialsProviderTest, ReusesCachedToken) {
+  FIRApp* app = testutil::AppForUnitTesting();
+  NSString* jwt = MakeJwt(std::chrono::hours(1));
+  FSTAuthFake* auth = [[FSTAuthFake alloc] initWithToken:jwt uid:@"fake uid"];
+  FirebaseCredentialsProvider credentials_provider(app, auth);
+
+  for (int i = 0; i < 2; ++i) {
+    credentials_provider.GetToken([jwt](util::StatusOr<Token> result) {
+      EXPECT_TRUE(result.ok());
+      const Token& token = result.ValueOrDie();
+      EXPECT_EQ(util::MakeString(jwt), token.token());
+      EXPECT_EQ("fake uid", token.user().uid());
+    });
+  }
+  EXPECT_EQ(1, auth.tokenRequests);
+}
+
+TEST(FirebaseCredentialsProviderTest, RefreshesTokenCloseToExpiry) {
+  FIRApp* app = testutil::AppForUnitTesting();
+  NSString* jwt = MakeJwt(std::chrono::minutes(8));
+  FSTAuthFake* auth = [[FSTAuthFake alloc] initWithToken:jwt uid:@"fake uid"];
+  FirebaseCredentialsProvider credentials_provider(app, auth);
+
+  credentials_provider.GetToken([](util::StatusOr<Token>) {});
+  EXPECT_EQ(1, auth.tokenRequests);
+  EXPECT_FALSE(auth.forceRefreshTriggered);
+
+  // The cached token is still used, but refreshed in the background.
+  credentials_provider.GetToken([jwt](util::StatusOr<Token> result) {
+    EXPECT_TRUE(result.ok());
+    EXPECT_EQ(util::MakeString(jwt), result.ValueOrDie().token());
+  });
+  EXPECT_EQ(2, auth.tokenRequests);
+  EXPECT_TRUE(auth.forceRefreshTriggered);
+}
+
+TEST(FirebaseCredentialsProviderTest, DoesNotReuseExpiringToken) {
+  FIRApp* app = testutil::AppForUnitTesting();
+  FSTAuthFake* auth =
+      [[FSTAuthFake alloc] initWithToken:MakeJwt(std::chrono::minutes(2))
+                                     uid:@"fake uid"];
+  FirebaseCredentialsProvider credentials_provider(app, auth);
+
+  credentials_provider.GetToken([](util::StatusOr<Token>) {});
+  credentials_provider.GetToken([](util::StatusOr<Token>) {});
+  EXPECT_EQ(2, auth.tokenRequests);
+}
+
+TEST(FirebaseCredentialsProviderTest, InvalidateTokenDropsCachedToken) {
+  FIRApp* app = testutil::AppForUnitTesting();
+  FSTAuthFake* auth =
+      [[FSTAuthFake alloc] initWithToken:MakeJwt(std::chrono::hours(1))
+                                     uid:@"fake uid"];
+  FirebaseCredentialsProvider credentials_provider(app, auth);
+
+  credentials_provider.GetToken([](util::StatusOr<Token>) {});
+  credentials_provider.InvalidateToken();
+  credentials_provider.GetToken([](util::StatusOr<Token>) {});
+  EXPECT_EQ(2, auth.tokenRequests);
+  EXPECT_TRUE(auth.forceRefreshTriggered);
+}
+
 }  // namespace auth
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_matcher.h"
+
+#include <cmath>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/bound.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::Document;
+using model::FieldValue;
+using testutil::Array;
+using testutil::Doc;
+using testutil::Filter;
+using testutil::Map;
+using testutil::OrderBy;
+using testutil::Ref;
+using testutil::Resource;
+
+namespace {
+
+std::vector<Document> SampleDocuments() {
+  return {
+      *Doc("coll/a", 0, Map("sort", 1, "name", "alpha")),
+      *Doc("coll/b", 0, Map("sort", 2.5, "name", "beta", "flag", true)),
+      *Doc("coll/c", 0, Map("sort", "two", "tags", Array(1, "x"))),
+      *Doc("coll/d", 0, Map("sort", nullptr, "flag", false)),
+      *Doc("coll/e", 0, Map("sort", NAN, "nested", Map("sort", 3))),
+      *Doc("coll/f", 0, Map("nested", Map("sort", 1, "name", "zeta"))),
+      *Doc("coll/g", 0, Map("tags", Array("x", "y"), "sort", 3)),
+      *Doc("coll/g/sub/h", 0, Map("sort", 1)),
+      *Doc("other/i", 0, Map("sort", 1)),
+  };
+}
+
+void ExpectSameResults(const Query& query) {
+  QueryMatcher matcher(query);
+  for (const Document& doc : SampleDocuments()) {
+    EXPECT_EQ(query.Matches(doc), matcher.Matches(doc))
+        << doc.key().ToString();
+  }
+}
+
+}  // namespace
+
+TEST(QueryMatcherTest, MatchesLikeQueryOnPaths) {
+  ExpectSameResults(Query(Resource("coll")));
+  ExpectSameResults(Query(Resource("coll/a")));
+  ExpectSameResults(Query(Resource("coll/g/sub")));
+  ExpectSameResults(Query(Resource(""), "sub"));
+}
+
+TEST(QueryMatcherTest, MatchesLikeQueryOnFilters) {
+  Query base = Query(Resource("coll"));
+  for (const char* op : {"<", "<=", "==", ">=", ">"}) {
+    ExpectSameResults(base.AddingFilter(Filter("sort", op, 2)));
+    ExpectSameResults(base.AddingFilter(Filter("sort", op, 1.0)));
+    ExpectSameResults(base.AddingFilter(Filter("name", op, "beta")));
+    ExpectSameResults(base.AddingFilter(Filter("flag", op, true)));
+    ExpectSameResults(base.AddingFilter(Filter("nested.sort", op, 1)));
+  }
+  ExpectSameResults(base.AddingFilter(Filter("sort", "==", nullptr)));
+  ExpectSameResults(base.AddingFilter(Filter("sort", "==", NAN)));
+  ExpectSameResults(base.AddingFilter(Filter("tags", "array_contains", "x")));
+  ExpectSameResults(
+      base.AddingFilter(Filter("__name__", ">=", Ref("project", "coll/c"))));
+}
+
+TEST(QueryMatcherTest, MatchesLikeQueryOnCombinedConstraints) {
+  Query base = Query(Resource("coll"));
+  ExpectSameResults(base.AddingFilter(Filter("sort", ">", 1))
+                        .AddingFilter(Filter("sort", "<=", 3)));
+  ExpectSameResults(base.AddingFilter(Filter("tags", "array_contains", "x"))
+                        .AddingFilter(Filter("sort", ">=", 3)));
+  ExpectSameResults(base.AddingOrderBy(OrderBy("flag")));
+  ExpectSameResults(base.AddingOrderBy(OrderBy("nested.name", "desc"))
+                        .AddingFilter(Filter("nested.sort", "==", 1)));
+  ExpectSameResults(base.AddingOrderBy(OrderBy("sort"))
+                        .StartingAt(Bound({FieldValue::FromInteger(1)}, false))
+                        .EndingAt(Bound({FieldValue::FromInteger(3)}, true)));
+}
+
+TEST(QueryMatcherTest, RequiresOrderByFieldsToExist) {
+  Query query = Query(Resource("coll")).AddingOrderBy(OrderBy("flag"));
+  QueryMatcher matcher(query);
+
+  EXPECT_FALSE(matcher.Matches(*Doc("coll/a", 0, Map("sort", 1))));
+  EXPECT_TRUE(matcher.Matches(*Doc("coll/b", 0, Map("flag", nullptr))));
+}
+
+TEST(QueryMatcherTest, AppliesAllFiltersOnTheSameField) {
+  Query query = Query(Resource("coll"))
+                    .AddingFilter(Filter("sort", ">", 1))
+                    .AddingFilter(Filter("sort", "<", 3));
+  QueryMatcher matcher(query);
+
+  EXPECT_FALSE(matcher.Matches(*Doc("coll/a", 0, Map("sort", 1))));
+  EXPECT_TRUE(matcher.Matches(*Doc("coll/b", 0, Map("sort", 2))));
+  EXPECT_FALSE(matcher.Matches(*Doc("coll/c", 0, Map("sort", 3))));
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/query_routing_index.h"
+
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::TargetId;
+using testutil::Filter;
+using testutil::Key;
+using testutil::Resource;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
+
+namespace {
+
+std::vector<TargetId> TargetsFor(const QueryRoutingIndex& index,
+                                 const char* key) {
+  std::vector<TargetId> result;
+  index.ForEachTarget(Key(key),
+                      [&](TargetId target_id) { result.push_back(target_id); });
+  return result;
+}
+
+}  // namespace
+
+TEST(QueryRoutingIndexTest, RoutesToQueriesOnTheParentCollection) {
+  QueryRoutingIndex index;
+  index.AddQuery(Query(Resource("coll")), 1);
+  index.AddQuery(Query(Resource("coll")).AddingFilter(Filter("a", "==", 1)), 2);
+  index.AddQuery(Query(Resource("other")), 3);
+  index.AddQuery(Query(Resource("coll/doc/sub")), 4);
+
+  EXPECT_THAT(TargetsFor(index, "coll/doc"), UnorderedElementsAre(1, 2));
+  EXPECT_THAT(TargetsFor(index, "other/doc"), ElementsAre(3));
+  EXPECT_THAT(TargetsFor(index, "coll/doc/sub/doc"), ElementsAre(4));
+  EXPECT_THAT(TargetsFor(index, "unrelated/doc"), IsEmpty());
+}
+
+TEST(QueryRoutingIndexTest, RoutesToDocumentQueries) {
+  QueryRoutingIndex index;
+  index.AddQuery(Query(Resource("coll/doc")), 1);
+  index.AddQuery(Query(Resource("coll")), 2);
+
+  EXPECT_THAT(TargetsFor(index, "coll/doc"), UnorderedElementsAre(1, 2));
+  EXPECT_THAT(TargetsFor(index, "coll/other"), ElementsAre(2));
+}
+
+TEST(QueryRoutingIndexTest, RoutesToCollectionGroupQueries) {
+  QueryRoutingIndex index;
+  index.AddQuery(Query(Resource(""), "group"), 1);
+  index.AddQuery(Query(Resource("coll/doc"), "group"), 2);
+
+  EXPECT_THAT(TargetsFor(index, "group/doc"), ElementsAre(1));
+  EXPECT_THAT(TargetsFor(index, "coll/doc/group/doc"),
+              UnorderedElementsAre(1, 2));
+  EXPECT_THAT(TargetsFor(index, "coll/other/group/doc"), ElementsAre(1));
+  EXPECT_THAT(TargetsFor(index, "group/doc/sub/doc"), IsEmpty());
+}
+
+TEST(QueryRoutingIndexTest, StopsRoutingToRemovedQueries) {
+  QueryRoutingIndex index;
+  Query query = Query(Resource("coll"));
+  Query group_query = Query(Resource(""), "coll");
+  index.AddQuery(query, 1);
+  index.AddQuery(query, 2);
+  index.AddQuery(group_query, 3);
+
+  index.RemoveQuery(query, 1);
+  EXPECT_THAT(TargetsFor(index, "coll/doc"), UnorderedElementsAre(2, 3));
+
+  index.RemoveQuery(query, 2);
+  index.RemoveQuery(group_query, 3);
+  EXPECT_THAT(TargetsFor(index, "coll/doc"), IsEmpty());
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -32,8 +32,10 @@ namespace core {
 using model::Document;
 using model::FieldValue;
 using model::ResourcePath;
+using testutil::Array;
 using testutil::Doc;
 using testutil::Filter;
+using testutil::OrderBy;
 using testutil::Resource;
 
 TEST(QueryTest, MatchesBasedOnDocumentKey) {
@@ -100,6 +102,46 @@ TEST(QueryTest, PrimitiveValueFilter) {
   EXPECT_FALSE(query2.Matches(doc5));
 }
 
+TEST(QueryTest, InFilter) {
+  Query query = Query(Resource("collection"))
+                    .AddingFilter(Filter("zip", "in", Array(12345, "x", 1.5)));
+
+  Document doc1 =
+      *Doc("collection/1", 0, {{"zip", FieldValue::FromDouble(12345.0)}});
+  Document doc2 =
+      *Doc("collection/2", 0, {{"zip", FieldValue::FromString("x")}});
+  Document doc3 =
+      *Doc("collection/3", 0, {{"zip", FieldValue::FromInteger(54321)}});
+  Document doc4 = *Doc("collection/4", 0, {{"zip", Array(12345)}});
+  Document doc5 =
+      *Doc("collection/5", 0, {{"code", FieldValue::FromDouble(1.5)}});
+
+  EXPECT_TRUE(query.Matches(doc1));
+  EXPECT_TRUE(query.Matches(doc2));
+  EXPECT_FALSE(query.Matches(doc3));
+  EXPECT_FALSE(query.Matches(doc4));
+  EXPECT_FALSE(query.Matches(doc5));
+}
+
+TEST(QueryTest, ArrayContainsAnyFilter) {
+  Query query = Query(Resource("collection"))
+                    .AddingFilter(Filter("zips", "array-contains-any",
+                                         Array(12345, "x")));
+
+  Document doc1 = *Doc("collection/1", 0, {{"zips", Array(1, 12345)}});
+  Document doc2 = *Doc("collection/2", 0, {{"zips", Array("y", "x")}});
+  Document doc3 = *Doc("collection/3", 0, {{"zips", Array(54321)}});
+  Document doc4 =
+      *Doc("collection/4", 0, {{"zips", FieldValue::FromInteger(12345)}});
+  Document doc5 = *Doc("collection/5", 0, {{"zips", Array(Array(12345))}});
+
+  EXPECT_TRUE(query.Matches(doc1));
+  EXPECT_TRUE(query.Matches(doc2));
+  EXPECT_FALSE(query.Matches(doc3));
+  EXPECT_FALSE(query.Matches(doc4));
+  EXPECT_FALSE(query.Matches(doc5));
+}
+
 TEST(QueryTest, NanFilter) {
   Query query =
       Query(Resource("collection")).AddingFilter(Filter("sort", "==", NAN));
@@ -120,6 +162,35 @@ TEST(QueryTest, NanFilter) {
   EXPECT_FALSE(query.Matches(doc5));
 }
 
+TEST(QueryTest, CoversQueriesWithMoreConstraints) {
+  Query base = Query(Resource("collection"));
+  Query filtered = base.AddingFilter(Filter("a", "==", 1));
+
+  EXPECT_TRUE(base.Covers(base));
+  EXPECT_TRUE(base.Covers(filtered));
+  EXPECT_TRUE(base.Covers(filtered.WithLimit(5)));
+  EXPECT_TRUE(base.Covers(base.AddingOrderBy(OrderBy("b"))));
+  EXPECT_TRUE(filtered.Covers(filtered.AddingFilter(Filter("b", ">", 2))));
+  EXPECT_TRUE(base.AddingOrderBy(OrderBy("b"))
+                  .Covers(base.AddingOrderBy(OrderBy("b", "desc"))));
+
+  EXPECT_FALSE(filtered.Covers(base));
+  EXPECT_FALSE(filtered.Covers(base.AddingFilter(Filter("a", "==", 2))));
+  EXPECT_FALSE(base.AddingOrderBy(OrderBy("b")).Covers(base));
+  EXPECT_FALSE(base.Covers(Query(Resource("other"))));
+  EXPECT_FALSE(base.Covers(Query(Resource(""), "collection")));
+}
+
+TEST(QueryTest, DoesNotCoverQueriesFromPartialResults) {
+  Query base = Query(Resource("collection")).AddingOrderBy(OrderBy("a"));
+  Bound bound({FieldValue::FromInteger(1)}, true);
+
+  EXPECT_FALSE(base.WithLimit(10).Covers(base));
+  EXPECT_FALSE(base.WithLimit(10).Covers(base.WithLimit(5)));
+  EXPECT_FALSE(base.StartingAt(bound).Covers(base.StartingAt(bound)));
+  EXPECT_FALSE(base.EndingAt(bound).Covers(base));
+}
+
 }  // namespace core
 }  // namespace firestore
 }  // namespace firebase
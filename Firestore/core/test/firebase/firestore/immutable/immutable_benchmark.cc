@@ -0,0 +1,259 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/append_only_list.h"
+#include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
+#include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/secure_random.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace {
+
+using model::DocumentKey;
+using model::FieldValue;
+
+template <typename K>
+K MakeKey(int64_t i);
+
+template <>
+DocumentKey MakeKey<DocumentKey>(int64_t i) {
+  return DocumentKey::FromSegments({"rooms", absl::StrCat("room", i)});
+}
+
+template <>
+FieldValue MakeKey<FieldValue>(int64_t i) {
+  return FieldValue::FromInteger(i);
+}
+
+/** Returns `size` distinct keys in random order. */
+template <typename K>
+std::vector<K> Keys(int64_t size) {
+  std::vector<K> result;
+  result.reserve(static_cast<size_t>(size));
+  for (int64_t i = 0; i < size; ++i) {
+    result.push_back(MakeKey<K>(i));
+  }
+
+  util::SecureRandom rnd;
+  std::shuffle(result.begin(), result.end(), rnd);
+  return result;
+}
+
+template <typename Map>
+using KeyType = typename Map::value_type::first_type;
+
+template <typename Map>
+Map MakeMap(const std::vector<KeyType<Map>>& keys) {
+  Map result;
+  for (const auto& key : keys) {
+    result = result.insert(key, 0);
+  }
+  return result;
+}
+
+template <typename Map>
+void BM_MapInsert(benchmark::State& state) {
+  auto keys = Keys<KeyType<Map>>(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(MakeMap<Map>(keys));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+void BM_MapErase(benchmark::State& state) {
+  auto keys = Keys<KeyType<Map>>(state.range(0));
+  Map map = MakeMap<Map>(keys);
+
+  for (auto _ : state) {
+    Map erased = map;
+    for (const auto& key : keys) {
+      erased = erased.erase(key);
+    }
+    benchmark::DoNotOptimize(erased);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+void BM_MapFind(benchmark::State& state) {
+  auto keys = Keys<KeyType<Map>>(state.range(0));
+  Map map = MakeMap<Map>(keys);
+
+  for (auto _ : state) {
+    for (const auto& key : keys) {
+      benchmark::DoNotOptimize(map.find(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+void BM_MapLowerBound(benchmark::State& state) {
+  auto keys = Keys<KeyType<Map>>(state.range(0));
+  Map map = MakeMap<Map>(keys);
+
+  for (auto _ : state) {
+    for (const auto& key : keys) {
+      benchmark::DoNotOptimize(map.lower_bound(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+void BM_MapIterate(benchmark::State& state) {
+  Map map = MakeMap<Map>(Keys<KeyType<Map>>(state.range(0)));
+
+  for (auto _ : state) {
+    for (const auto& entry : map) {
+      benchmark::DoNotOptimize(entry);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Measures copying a map and then modifying the copy, which is how most
+ * callers derive new maps from existing ones.
+ */
+template <typename Map>
+void BM_MapCopyAndInsert(benchmark::State& state) {
+  Map map = MakeMap<Map>(Keys<KeyType<Map>>(state.range(0)));
+  auto extra = MakeKey<KeyType<Map>>(state.range(0));
+
+  for (auto _ : state) {
+    Map copy = map;
+    benchmark::DoNotOptimize(copy.insert(extra, 0));
+  }
+}
+
+template <typename Set>
+void BM_SetInsert(benchmark::State& state) {
+  auto keys = Keys<typename Set::value_type>(state.range(0));
+
+  for (auto _ : state) {
+    Set set;
+    for (const auto& key : keys) {
+      set = set.insert(key);
+    }
+    benchmark::DoNotOptimize(set);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Set>
+void BM_SetIterate(benchmark::State& state) {
+  Set set;
+  for (const auto& key : Keys<typename Set::value_type>(state.range(0))) {
+    set = set.insert(key);
+  }
+
+  for (auto _ : state) {
+    for (const auto& value : set) {
+      benchmark::DoNotOptimize(value);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_AppendOnlyListPushBack(benchmark::State& state) {
+  for (auto _ : state) {
+    AppendOnlyList<int64_t> list;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      list = list.push_back(i);
+    }
+    benchmark::DoNotOptimize(list);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_AppendOnlyListIterate(benchmark::State& state) {
+  AppendOnlyList<int64_t> list;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    list = list.push_back(i);
+  }
+
+  for (auto _ : state) {
+    for (int64_t value : list) {
+      benchmark::DoNotOptimize(value);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * ArraySortedMap can't hold more than kFixedSize entries, and
+ * BM_MapCopyAndInsert adds one more.
+ */
+void ArraySizes(benchmark::internal::Benchmark* b) {
+  b->Arg(10)->Arg(SortedMapBase::kFixedSize - 1);
+}
+
+void Sizes(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(10)->Range(10, 1000 * 1000);
+}
+
+using DocumentKeyArrayMap = impl::ArraySortedMap<DocumentKey, int>;
+using DocumentKeyTreeMap = impl::TreeSortedMap<DocumentKey, int>;
+using DocumentKeyMap = SortedMap<DocumentKey, int>;
+using FieldValueArrayMap = impl::ArraySortedMap<FieldValue, int>;
+using FieldValueTreeMap = impl::TreeSortedMap<FieldValue, int>;
+using FieldValueMap = SortedMap<FieldValue, int>;
+
+#define MAP_BENCHMARKS(Map, Sizes)                                             \
+  BENCHMARK_TEMPLATE(BM_MapInsert, Map)->Apply(Sizes);                         \
+  BENCHMARK_TEMPLATE(BM_MapErase, Map)->Apply(Sizes);                          \
+  BENCHMARK_TEMPLATE(BM_MapFind, Map)->Apply(Sizes);                           \
+  BENCHMARK_TEMPLATE(BM_MapLowerBound, Map)->Apply(Sizes);                     \
+  BENCHMARK_TEMPLATE(BM_MapIterate, Map)->Apply(Sizes);                        \
+  BENCHMARK_TEMPLATE(BM_MapCopyAndInsert, Map)->Apply(Sizes)
+
+MAP_BENCHMARKS(DocumentKeyArrayMap, ArraySizes);
+MAP_BENCHMARKS(DocumentKeyTreeMap, Sizes);
+MAP_BENCHMARKS(DocumentKeyMap, Sizes);
+MAP_BENCHMARKS(FieldValueArrayMap, ArraySizes);
+MAP_BENCHMARKS(FieldValueTreeMap, Sizes);
+MAP_BENCHMARKS(FieldValueMap, Sizes);
+
+using DocumentKeySortedSet = SortedSet<DocumentKey>;
+using FieldValueSortedSet = SortedSet<FieldValue>;
+
+BENCHMARK_TEMPLATE(BM_SetInsert, DocumentKeySortedSet)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_SetIterate, DocumentKeySortedSet)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_SetInsert, FieldValueSortedSet)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_SetIterate, FieldValueSortedSet)->Apply(Sizes);
+
+BENCHMARK(BM_AppendOnlyListPushBack)->Apply(Sizes);
+BENCHMARK(BM_AppendOnlyListIterate)->Apply(Sizes);
+
+}  // namespace
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
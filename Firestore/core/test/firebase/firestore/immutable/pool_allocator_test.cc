@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/pool_allocator.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/test/firebase/firestore/immutable/testing.h"
+#include "absl/base/config.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+
+using IntMap = SortedMap<int,
+                         int,
+                         util::Comparator<int>,
+                         PoolAllocator<std::pair<int, int>>>;
+
+TEST(PoolAllocatorTest, AllocatesDistinctBlocks) {
+  PoolAllocator<std::string> allocator;
+  std::string* a = allocator.allocate(1);
+  std::string* b = allocator.allocate(1);
+  EXPECT_NE(a, b);
+
+  allocator.deallocate(a, 1);
+  allocator.deallocate(b, 1);
+}
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+TEST(PoolAllocatorTest, RecyclesFreedBlocks) {
+  PoolAllocator<std::string> allocator;
+  std::string* a = allocator.allocate(1);
+  allocator.deallocate(a, 1);
+
+  std::string* b = allocator.allocate(1);
+  EXPECT_EQ(a, b);
+  allocator.deallocate(b, 1);
+}
+#endif  // defined(ABSL_HAVE_THREAD_LOCAL)
+
+TEST(PoolAllocatorTest, AllocatesArrays) {
+  PoolAllocator<int> allocator;
+  int* values = allocator.allocate(10);
+  for (int i = 0; i < 10; ++i) {
+    values[i] = i;
+  }
+  allocator.deallocate(values, 10);
+}
+
+TEST(PoolAllocatorTest, WorksWithSharedPointers) {
+  std::shared_ptr<std::string> value = std::allocate_shared<std::string>(
+      PoolAllocator<std::string>{}, "value");
+  EXPECT_EQ("value", *value);
+}
+
+TEST(PoolAllocatorTest, BacksSortedMaps) {
+  std::vector<int> values = Shuffled(Sequence(200));
+
+  IntMap map;
+  for (int value : values) {
+    map = map.insert(value, value);
+  }
+  EXPECT_SEQ_EQ(Pairs(Sequence(200)), map);
+
+  for (int value : values) {
+    map = map.erase(value);
+  }
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(PoolAllocatorTest, BlocksCanBeFreedOnOtherThreads) {
+  IntMap map = ToMap<IntMap>(Sequence(100));
+
+  std::thread thread([&map] {
+    for (int i = 0; i < 100; ++i) {
+      map = map.erase(i);
+    }
+  });
+  thread.join();
+
+  EXPECT_TRUE(map.empty());
+  map = ToMap<IntMap>(Sequence(100));
+  EXPECT_EQ(100u, map.size());
+}
+
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
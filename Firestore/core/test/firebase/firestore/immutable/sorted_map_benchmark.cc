@@ -0,0 +1,118 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/secure_random.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace {
+
+/**
+ * Maps keyed by field name, like FieldValue::Map, that only differ in the size
+ * at which they switch from a flat array to a tree. A FixedSize of zero always
+ * uses the tree.
+ */
+template <SortedMapBase::size_type FixedSize>
+using FieldMap = SortedMap<std::string,
+                           int,
+                           util::Comparator<std::string>,
+                           std::allocator<std::pair<std::string, int>>,
+                           FixedSize>;
+
+constexpr SortedMapBase::size_type kTreeOnly = 0;
+constexpr SortedMapBase::size_type kLargeArray = 256;
+
+std::vector<std::string> FieldNames(int64_t size) {
+  std::vector<std::string> result;
+  for (int64_t i = 0; i < size; ++i) {
+    result.push_back(absl::StrCat("field_", i));
+  }
+
+  util::SecureRandom rnd;
+  std::shuffle(result.begin(), result.end(), rnd);
+  return result;
+}
+
+template <typename Map>
+Map MakeMap(const std::vector<std::string>& keys) {
+  Map result;
+  for (const std::string& key : keys) {
+    result = result.insert(key, 0);
+  }
+  return result;
+}
+
+template <SortedMapBase::size_type FixedSize>
+void BM_SortedMapInsert(benchmark::State& state) {
+  std::vector<std::string> keys = FieldNames(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(MakeMap<FieldMap<FixedSize>>(keys));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <SortedMapBase::size_type FixedSize>
+void BM_SortedMapFind(benchmark::State& state) {
+  std::vector<std::string> keys = FieldNames(state.range(0));
+  auto map = MakeMap<FieldMap<FixedSize>>(keys);
+
+  for (auto _ : state) {
+    for (const std::string& key : keys) {
+      benchmark::DoNotOptimize(map.find(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <SortedMapBase::size_type FixedSize>
+void BM_SortedMapIterate(benchmark::State& state) {
+  auto map = MakeMap<FieldMap<FixedSize>>(FieldNames(state.range(0)));
+
+  for (auto _ : state) {
+    for (const auto& entry : map) {
+      benchmark::DoNotOptimize(entry);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void Sizes(benchmark::internal::Benchmark* b) {
+  for (int size : {4, 8, 16, 25, 32, 48, 64, 96, 128, 192, 256}) {
+    b->Arg(size);
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_SortedMapInsert, kTreeOnly)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_SortedMapInsert, kLargeArray)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_SortedMapFind, kTreeOnly)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_SortedMapFind, kLargeArray)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_SortedMapIterate, kTreeOnly)->Apply(Sizes);
+BENCHMARK_TEMPLATE(BM_SortedMapIterate, kLargeArray)->Apply(Sizes);
+
+}  // namespace
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
@@ -28,8 +28,10 @@
 #include <type_traits>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/pool_allocator.h"
 #include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 
@@ -68,7 +70,16 @@ class SortedMapTest : public ::testing::Test {
 // NOLINTNEXTLINE: must be a typedef for the gtest macros
 typedef ::testing::Types<SortedMap<int, int>,
                          impl::ArraySortedMap<int, int>,
-                         impl::TreeSortedMap<int, int>>
+                         impl::TreeSortedMap<int, int>,
+                         SortedMap<int,
+                                   int,
+                                   util::Comparator<int>,
+                                   PoolAllocator<std::pair<int, int>>>,
+                         SortedMap<int,
+                                   int,
+                                   util::Comparator<int>,
+                                   std::allocator<std::pair<int, int>>,
+                                   4>>
     TestedTypes;
 TYPED_TEST_CASE(SortedMapTest, TestedTypes);
 
@@ -123,6 +134,72 @@ TYPED_TEST(SortedMapTest, Increasing) {
   ASSERT_EQ(Pairs(empty), Collect(map));
 }
 
+TEST(SortedMapTest, FromSortedRange) {
+  using IntMap = SortedMap<int, int>;
+  for (int size : {0, 1, 10, 25, 26, 100}) {
+    std::vector<std::pair<int, int>> entries = Pairs(Sequence(size));
+    IntMap map = IntMap::FromSortedRange(entries);
+
+    ASSERT_EQ(static_cast<size_t>(size), map.size());
+    ASSERT_EQ(entries, Collect(map));
+    for (int i = 0; i < size; ++i) {
+      ASSERT_TRUE(Found(map, i, i));
+    }
+    ASSERT_TRUE(NotFound(map, size));
+
+    // The result can be modified like any other map.
+    IntMap modified = map.insert(-1, -1);
+    ASSERT_EQ(static_cast<size_t>(size + 1), modified.size());
+    ASSERT_TRUE(Found(modified, -1, -1));
+    ASSERT_EQ(entries, Collect(modified.erase(-1)));
+  }
+}
+
+TEST(SortedMapTest, Builder) {
+  using IntMap = SortedMap<int, int>;
+  for (int size : {0, 1, 25, 26, 100}) {
+    IntMap::Builder builder;
+    builder.reserve(static_cast<SizeType>(size));
+    for (int i = 0; i < size; ++i) {
+      builder.push_back(i, i * 2);
+    }
+    IntMap map = builder.Build();
+
+    ASSERT_EQ(static_cast<size_t>(size), map.size());
+    for (int i = 0; i < size; ++i) {
+      ASSERT_TRUE(Found(map, i, i * 2));
+    }
+
+    // The builder is empty after building.
+    ASSERT_TRUE(builder.Build().empty());
+  }
+}
+
+TEST(SortedMapTest, InPlaceUpdates) {
+  using IntMap = SortedMap<int, int>;
+  IntMap map;
+  std::vector<IntMap> snapshots;
+  for (int i : Shuffled(Sequence(100))) {
+    snapshots.push_back(map);
+    map.InsertInPlace(i, i);
+  }
+  EXPECT_SEQ_EQ(Pairs(Sequence(100)), map);
+
+  for (int i : Shuffled(Sequence(100))) {
+    snapshots.push_back(map);
+    map.EraseInPlace(i);
+  }
+  EXPECT_TRUE(map.empty());
+
+  // Each snapshot is unaffected by later updates.
+  for (size_t i = 0; i < snapshots.size(); ++i) {
+    SizeType expected = i < 100 ? i : 200 - i;
+    ASSERT_EQ(expected, snapshots[i].size());
+    ASSERT_EQ(expected, static_cast<SizeType>(std::distance(
+                            snapshots[i].begin(), snapshots[i].end())));
+  }
+}
+
 TYPED_TEST(SortedMapTest, Overwrite) {
   TypeParam map = TypeParam().insert(10, 10).insert(10, 8);
 
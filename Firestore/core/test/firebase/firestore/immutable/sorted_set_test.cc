@@ -109,6 +109,71 @@ TEST(SortedSetTest, CanBeConstructedFromSortedMap) {
   ASSERT_TRUE(NotFound(map, 2));
 }
 
+TEST(SortedSetTest, FromSortedRange) {
+  std::vector<int> all = Sequence(kLargeNumber);
+  SortedSet<int> set = SortedSet<int>::FromSortedRange(all);
+
+  ASSERT_EQ(all.size(), set.size());
+  ASSERT_SEQ_EQ(all, set);
+  ASSERT_EQ(ToSet(Shuffled(all)), set);
+}
+
+TEST(SortedSetTest, InsertAll) {
+  std::vector<int> evens = Sequence(0, kLargeNumber, 2);
+  SortedSet<int> set = SortedSet<int>::FromSortedRange(evens);
+
+  // Few values are inserted one by one.
+  SortedSet<int> one_more = set.insert_all(std::vector<int>{1});
+  ASSERT_EQ(evens.size() + 1, one_more.size());
+  ASSERT_TRUE(one_more.contains(1));
+  ASSERT_FALSE(set.contains(1));
+
+  // Many values, some already present, are merged.
+  std::vector<int> all = Sequence(kLargeNumber);
+  SortedSet<int> merged = set.insert_all(all);
+  ASSERT_SEQ_EQ(all, merged);
+  ASSERT_EQ(evens.size(), set.size());
+
+  ASSERT_SEQ_EQ(all, SortedSet<int>{}.insert_all(all));
+  ASSERT_EQ(set, set.insert_all(std::vector<int>{}));
+}
+
+TEST(SortedSetTest, EraseAll) {
+  std::vector<int> all = Sequence(kLargeNumber);
+  SortedSet<int> set = SortedSet<int>::FromSortedRange(all);
+
+  // Few values are erased one by one.
+  SortedSet<int> one_less = set.erase_all(std::vector<int>{1});
+  ASSERT_EQ(all.size() - 1, one_less.size());
+  ASSERT_FALSE(one_less.contains(1));
+  ASSERT_TRUE(set.contains(1));
+
+  // Many values, some not present, are removed in one pass.
+  SortedSet<int> evens = set.erase_all(Sequence(1, kLargeNumber * 2, 2));
+  ASSERT_SEQ_EQ(Sequence(0, kLargeNumber, 2), evens);
+  ASSERT_EQ(all.size(), set.size());
+
+  ASSERT_TRUE(set.erase_all(all).empty());
+}
+
+TEST(SortedSetTest, RetainAll) {
+  std::vector<int> all = Sequence(kLargeNumber);
+  SortedSet<int> set = SortedSet<int>::FromSortedRange(all);
+
+  // Few values are looked up one by one.
+  SortedSet<int> two = set.retain_all(std::vector<int>{1, 3, kLargeNumber});
+  ASSERT_SEQ_EQ((std::vector<int>{1, 3}), two);
+  ASSERT_EQ(all.size(), set.size());
+
+  // Many values, some not present, are merged.
+  SortedSet<int> odds = set.retain_all(Sequence(1, kLargeNumber * 2, 2));
+  ASSERT_SEQ_EQ(Sequence(1, kLargeNumber, 2), odds);
+
+  ASSERT_EQ(set, set.retain_all(all));
+  ASSERT_TRUE(set.retain_all(std::vector<int>{}).empty());
+  ASSERT_TRUE(SortedSet<int>{}.retain_all(all).empty());
+}
+
 TEST(SortedSetTest, Iterator) {
   std::vector<int> all = Sequence(kLargeNumber);
   SortedSet<int> set = ToSet(Shuffled(all));
@@ -17,6 +17,7 @@
 #include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
 
 #include <algorithm>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 #include "Firestore/core/test/firebase/firestore/immutable/testing.h"
@@ -29,6 +30,28 @@ namespace impl {
 
 using IntMap = TreeSortedMap<int, int>;
 
+namespace {
+
+/**
+ * Verifies that the tree rooted at the given node is a valid left-leaning
+ * red-black tree and returns its black height, or -1 if it's invalid.
+ */
+int BlackHeight(const IntMap::node_type& node) {
+  if (node.empty()) return 0;
+
+  if (node.right().red()) return -1;
+  if (node.red() && node.left().red()) return -1;
+  if (node.size() != node.left().size() + 1 + node.right().size()) return -1;
+
+  int left = BlackHeight(node.left());
+  int right = BlackHeight(node.right());
+  if (left < 0 || left != right) return -1;
+
+  return left + (node.red() ? 0 : 1);
+}
+
+}  // namespace
+
 TEST(TreeSortedMap, EmptySize) {
   IntMap map;
   EXPECT_TRUE(map.empty());
@@ -230,6 +253,127 @@ TEST(TreeSortedMap, InitializerIsSorted) {
   EXPECT_TRUE(std::is_sorted(map.begin(), map.end()));
 }
 
+TEST(TreeSortedMap, FromSortedRangeIsBalanced) {
+  for (int size = 0; size < 300; ++size) {
+    std::vector<IntMap::value_type> entries = Pairs(Sequence(size));
+    IntMap map = IntMap::FromSortedRange(entries, {});
+
+    ASSERT_EQ(static_cast<size_t>(size), map.size());
+    ASSERT_EQ(entries, Collect(map));
+    ASSERT_FALSE(map.root().red());
+    ASSERT_LE(0, BlackHeight(map.root())) << "size " << size;
+  }
+}
+
+TEST(TreeSortedMap, FromSortedRangeSupportsModification) {
+  std::vector<int> values = Sequence(0, 200, 2);
+  IntMap map = IntMap::FromSortedRange(Pairs(values), {});
+
+  for (int i : Shuffled(Sequence(200))) {
+    map = map.insert(i, i);
+    ASSERT_LE(0, BlackHeight(map.root()));
+  }
+  EXPECT_SEQ_EQ(Pairs(Sequence(200)), map);
+
+  for (int i : Shuffled(Sequence(200))) {
+    map = map.erase(i);
+    ASSERT_LE(0, BlackHeight(map.root()));
+  }
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(TreeSortedMap, InPlaceUpdatesAreBalanced) {
+  IntMap map;
+  for (int i : Shuffled(Sequence(200))) {
+    map.InsertInPlace(i, i);
+    ASSERT_FALSE(map.root().red());
+    ASSERT_LE(0, BlackHeight(map.root()));
+  }
+  EXPECT_SEQ_EQ(Pairs(Sequence(200)), map);
+
+  for (int i : Shuffled(Sequence(200))) {
+    map.EraseInPlace(i);
+    ASSERT_FALSE(map.root().red());
+    ASSERT_LE(0, BlackHeight(map.root()));
+  }
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(TreeSortedMap, InPlaceUpdatesDoNotAffectCopies) {
+  std::vector<int> values = Sequence(0, 200, 2);
+  IntMap original = IntMap::FromSortedRange(Pairs(values), {});
+
+  IntMap inserted = original;
+  for (int i : Shuffled(Sequence(1, 200, 2))) {
+    IntMap before = inserted;
+    inserted.InsertInPlace(i, i);
+    ASSERT_EQ(before.size() + 1, inserted.size());
+    ASSERT_TRUE(NotFound(before, i));
+  }
+  EXPECT_SEQ_EQ(Pairs(Sequence(200)), inserted);
+
+  IntMap erased = inserted;
+  for (int i : Shuffled(Sequence(200))) {
+    erased.EraseInPlace(i);
+  }
+  EXPECT_TRUE(erased.empty());
+
+  EXPECT_SEQ_EQ(Pairs(values), original);
+  EXPECT_SEQ_EQ(Pairs(Sequence(200)), inserted);
+  EXPECT_LE(0, BlackHeight(original.root()));
+  EXPECT_LE(0, BlackHeight(inserted.root()));
+}
+
+TEST(TreeSortedMap, InPlaceUpdatesReuseUnsharedNodes) {
+  IntMap original = IntMap::FromSortedRange(Pairs(Sequence(100)), {});
+
+  IntMap map = original;
+  map.InsertInPlace(100, 100);
+  const IntMap::value_type* root = &map.root().entry();
+  EXPECT_NE(&original.root().entry(), root);
+
+  // Rotations move entries between nodes but the root node itself survives.
+  for (int i = 101; i < 200; ++i) {
+    map.InsertInPlace(i, i);
+    ASSERT_EQ(root, &map.root().entry());
+  }
+  for (int i = 0; i < 150; ++i) {
+    map.EraseInPlace(i);
+    ASSERT_EQ(root, &map.root().entry());
+  }
+
+  EXPECT_SEQ_EQ(Pairs(Sequence(150, 200)), map);
+  EXPECT_SEQ_EQ(Pairs(Sequence(100)), original);
+}
+
+TEST(TreeSortedMap, IteratorCopiesAdvanceIndependently) {
+  IntMap map = IntMap::FromSortedRange(Pairs(Sequence(1000)), {});
+
+  auto iter = map.lower_bound(500);
+  auto copy = iter;
+  for (int i = 500; i < 1000; ++i) {
+    ASSERT_EQ(i, iter->first);
+    ++iter;
+  }
+  EXPECT_TRUE(iter == map.end());
+  EXPECT_EQ(500, copy->first);
+
+  copy = map.begin();
+  EXPECT_EQ(0, copy->first);
+  EXPECT_TRUE(iter == map.end());
+}
+
+TEST(TreeSortedMap, IteratesOverLargeMaps) {
+  // The iterator's stack is sized for the highest possible tree, so it never
+  // runs out of room, however many entries there are.
+  IntMap map;
+  for (int i = 0; i < 100000; ++i) {
+    map = map.insert(i, i);
+  }
+
+  EXPECT_SEQ_EQ(Pairs(Sequence(100000)), map);
+}
+
 }  // namespace impl
 }  // namespace immutable
 }  // namespace firestore
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/document_compressor.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+// Stands in for an encoded document: the same resource name prefix and field
+// names in every document, with varying values.
+std::string Document(int index) {
+  return absl::StrCat(
+      "\x12projects/project/databases/(default)/documents/rooms/room", index,
+      "/messages/message", index, "\x0a\x04text\x12\x0fHello, world #", index,
+      "\x0a\x06author\x12\x05user", index % 7,
+      "\x0a\x09timestamp\x12\x08", 1500000000 + index);
+}
+
+}  // namespace
+
+TEST(DocumentCompressorTest, RoundTripsDocuments) {
+  std::vector<std::string> samples;
+  for (int i = 0; i != 20; ++i) {
+    samples.push_back(Document(i));
+  }
+  DocumentCompressor compressor{DocumentCompressor::TrainDictionary(samples)};
+
+  for (int i = 100; i != 110; ++i) {
+    std::string encoded = Document(i);
+    ASSERT_FALSE(DocumentCompressor::IsCompressed(encoded));
+
+    std::string row = compressor.Compress(encoded);
+    ASSERT_TRUE(DocumentCompressor::IsCompressed(row));
+    EXPECT_LT(row.size(), encoded.size() / 2);
+
+    util::StatusOr<std::string> decompressed = compressor.Decompress(row);
+    ASSERT_TRUE(decompressed.ok()) << decompressed.status().ToString();
+    EXPECT_EQ(decompressed.ValueOrDie(), encoded);
+  }
+}
+
+TEST(DocumentCompressorTest, LeavesIncompressibleDocumentsAsTheyAre) {
+  DocumentCompressor compressor{""};
+
+  std::string encoded = "\x12\x03xyz";
+  EXPECT_EQ(compressor.Compress(encoded), encoded);
+}
+
+TEST(DocumentCompressorTest, TrainsDictionaryWithinSizeLimit) {
+  std::vector<std::string> samples{
+      "first", "second",
+      std::string(DocumentCompressor::kMaxDictionarySize, 'x')};
+  EXPECT_EQ(DocumentCompressor::TrainDictionary(samples), "secondfirst");
+}
+
+TEST(DocumentCompressorTest, RejectsRowsFromOtherDictionaries) {
+  DocumentCompressor compressor{Document(1) + Document(2)};
+  DocumentCompressor other{Document(3) + Document(4)};
+
+  std::string row = compressor.Compress(Document(5));
+  ASSERT_TRUE(DocumentCompressor::IsCompressed(row));
+  EXPECT_FALSE(other.Decompress(row).ok());
+
+  std::string truncated = row.substr(0, row.size() - 2);
+  EXPECT_FALSE(compressor.Decompress(truncated).ok());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
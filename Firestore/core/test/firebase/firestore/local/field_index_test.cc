@@ -0,0 +1,243 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/field_index.h"
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using core::Query;
+using model::FieldValue;
+using testutil::Array;
+using testutil::BlobValue;
+using testutil::Field;
+using testutil::Filter;
+using testutil::Map;
+using testutil::OrderBy;
+using testutil::Ref;
+using testutil::Value;
+
+namespace {
+
+std::string Encode(const FieldValue& value) {
+  return EncodeFieldIndexValue(value);
+}
+
+bool InScan(const FieldIndexScan& scan, const FieldValue& value) {
+  return scan.Contains(Encode(value));
+}
+
+}  // namespace
+
+TEST(FieldIndexTest, EncodingPreservesOrder) {
+  // Each group sorts before the next; values within a group compare equal.
+  std::vector<std::vector<FieldValue>> groups = {
+      {Value(nullptr)},
+      {Value(false)},
+      {Value(true)},
+      {Value(std::numeric_limits<double>::quiet_NaN())},
+      {Value(-std::numeric_limits<double>::infinity())},
+      {Value(std::numeric_limits<int64_t>::min())},
+      {Value(-1.5)},
+      {Value(-1), Value(-1.0)},
+      {Value(-0.0), Value(0.0), Value(0)},
+      {Value(std::numeric_limits<double>::min())},
+      {Value(1), Value(1.0)},
+      {Value(1.5)},
+      {Value(2)},
+      {Value(std::numeric_limits<double>::infinity())},
+      {Value(Timestamp(-1, 0))},
+      {Value(Timestamp(0, 0))},
+      {Value(Timestamp(0, 1))},
+      {Value(Timestamp(1, 0))},
+      {FieldValue::FromServerTimestamp(Timestamp(0, 0))},
+      {FieldValue::FromServerTimestamp(Timestamp(1, 0))},
+      {Value("")},
+      {Value("a")},
+      {Value(std::string("a\0b", 3))},
+      {Value("ab")},
+      {Value("b")},
+      {BlobValue()},
+      {BlobValue(0)},
+      {BlobValue(0, 1)},
+      {BlobValue(255)},
+      {Ref("p/d", "c/a")},
+      {Ref("p/d", "c/a/sub/a")},
+      {Ref("p/d", "c/b")},
+      {Ref("p/e", "c/a")},
+      {Ref("q/d", "c/a")},
+      {Value(GeoPoint(-90, 0))},
+      {Value(GeoPoint(0, -180))},
+      {Value(GeoPoint(0, 0))},
+      {Value(GeoPoint(90, 180))},
+      {Array()},
+      {Array(nullptr)},
+      {Array(1, 2)},
+      {Array(1.0, 2.0, 3)},
+      {Array(1, "a")},
+      {Array(2)},
+      {Value(Map())},
+      {Value(Map("a", 1))},
+      {Value(Map("a", 1, "b", 1))},
+      {Value(Map("a", 2))},
+      {Value(Map("b", 0))},
+  };
+
+  for (size_t i = 0; i < groups.size(); ++i) {
+    for (const FieldValue& left : groups[i]) {
+      for (size_t j = 0; j < groups.size(); ++j) {
+        for (const FieldValue& right : groups[j]) {
+          std::string encoded_left = Encode(left);
+          std::string encoded_right = Encode(right);
+          if (i < j) {
+            EXPECT_LT(encoded_left, encoded_right)
+                << left.ToString() << " vs " << right.ToString();
+          } else if (i == j) {
+            EXPECT_EQ(encoded_left, encoded_right)
+                << left.ToString() << " vs " << right.ToString();
+          } else {
+            EXPECT_GT(encoded_left, encoded_right)
+                << left.ToString() << " vs " << right.ToString();
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(FieldIndexTest, NoScanForUnfilteredQueries) {
+  EXPECT_FALSE(FieldIndexScan::ForQuery(testutil::Query("coll")));
+  EXPECT_FALSE(FieldIndexScan::ForQuery(
+      testutil::Query("coll").AddingOrderBy(OrderBy("__name__"))));
+  EXPECT_FALSE(FieldIndexScan::ForQuery(
+      testutil::Query("coll").AddingFilter(Filter("a", "array_contains", 1))));
+  EXPECT_FALSE(FieldIndexScan::ForQuery(testutil::Query("coll").AddingFilter(
+      Filter("a", "array_contains_any", Array(1, 2)))));
+}
+
+TEST(FieldIndexTest, EqualityScan) {
+  Query query = testutil::Query("coll")
+                    .AddingFilter(Filter("a", ">", 1))
+                    .AddingFilter(Filter("b", "==", 2));
+  absl::optional<FieldIndexScan> scan = FieldIndexScan::ForQuery(query);
+  ASSERT_TRUE(scan);
+
+  // Equality filters are more selective so they're preferred.
+  EXPECT_EQ(Field("b"), scan->field_path());
+  EXPECT_TRUE(InScan(*scan, Value(2)));
+  EXPECT_TRUE(InScan(*scan, Value(2.0)));
+  EXPECT_FALSE(InScan(*scan, Value(1)));
+  EXPECT_FALSE(InScan(*scan, Value(3)));
+  EXPECT_FALSE(InScan(*scan, Value("2")));
+}
+
+TEST(FieldIndexTest, InScan) {
+  Query query = testutil::Query("coll")
+                    .AddingFilter(Filter("a", ">", 1))
+                    .AddingFilter(Filter("b", "in", Array(3, "x", 1, 1.0)));
+  absl::optional<FieldIndexScan> scan = FieldIndexScan::ForQuery(query);
+  ASSERT_TRUE(scan);
+
+  EXPECT_EQ(Field("b"), scan->field_path());
+  EXPECT_TRUE(InScan(*scan, Value(1)));
+  EXPECT_TRUE(InScan(*scan, Value(3.0)));
+  EXPECT_TRUE(InScan(*scan, Value("x")));
+  EXPECT_FALSE(InScan(*scan, Value(2)));
+  EXPECT_FALSE(InScan(*scan, Value(4)));
+  EXPECT_FALSE(InScan(*scan, Value("y")));
+
+  // One point range per distinct value, in index order.
+  const std::vector<FieldIndexScan::Range>& ranges = scan->ranges();
+  ASSERT_EQ(3u, ranges.size());
+  EXPECT_EQ(Encode(Value(1)), ranges[0].lower_bound());
+  EXPECT_EQ(Encode(Value(3)), ranges[1].lower_bound());
+  EXPECT_EQ(Encode(Value("x")), ranges[2].lower_bound());
+}
+
+TEST(FieldIndexTest, EqualityScanIsPreferredOverInScan) {
+  Query query = testutil::Query("coll")
+                    .AddingFilter(Filter("a", "in", Array(1, 2)))
+                    .AddingFilter(Filter("b", "==", 2));
+  absl::optional<FieldIndexScan> scan = FieldIndexScan::ForQuery(query);
+  ASSERT_TRUE(scan);
+
+  EXPECT_EQ(Field("b"), scan->field_path());
+  EXPECT_EQ(1u, scan->ranges().size());
+}
+
+TEST(FieldIndexTest, LessThanScan) {
+  Query query = testutil::Query("coll").AddingFilter(Filter("a", "<", 2));
+  absl::optional<FieldIndexScan> scan = FieldIndexScan::ForQuery(query);
+  ASSERT_TRUE(scan);
+
+  EXPECT_EQ(Field("a"), scan->field_path());
+  EXPECT_TRUE(InScan(*scan, Value(std::numeric_limits<double>::quiet_NaN())));
+  EXPECT_TRUE(InScan(*scan, Value(-100)));
+  EXPECT_TRUE(InScan(*scan, Value(1.5)));
+  // Bounds are inclusive; the query filters out the boundary value itself.
+  EXPECT_TRUE(InScan(*scan, Value(2)));
+  EXPECT_FALSE(InScan(*scan, Value(3)));
+  EXPECT_FALSE(InScan(*scan, Value(true)));
+  EXPECT_FALSE(InScan(*scan, Value("a")));
+}
+
+TEST(FieldIndexTest, GreaterThanScan) {
+  Query query = testutil::Query("coll").AddingFilter(Filter("a", ">=", "b"));
+  absl::optional<FieldIndexScan> scan = FieldIndexScan::ForQuery(query);
+  ASSERT_TRUE(scan);
+
+  EXPECT_EQ(Field("a"), scan->field_path());
+  EXPECT_TRUE(InScan(*scan, Value("b")));
+  EXPECT_TRUE(InScan(*scan, Value("zzz")));
+  EXPECT_FALSE(InScan(*scan, Value("a")));
+  EXPECT_FALSE(InScan(*scan, Value(10)));
+  EXPECT_FALSE(InScan(*scan, BlobValue()));
+}
+
+TEST(FieldIndexTest, TimestampScanIncludesServerTimestamps) {
+  Query query = testutil::Query("coll").AddingFilter(
+      Filter("a", ">", Value(Timestamp(1, 0))));
+  absl::optional<FieldIndexScan> scan = FieldIndexScan::ForQuery(query);
+  ASSERT_TRUE(scan);
+
+  EXPECT_TRUE(InScan(*scan, Value(Timestamp(2, 0))));
+  EXPECT_TRUE(InScan(*scan, FieldValue::FromServerTimestamp(Timestamp(0, 0))));
+  EXPECT_FALSE(InScan(*scan, Value(Timestamp(0, 0))));
+  EXPECT_FALSE(InScan(*scan, Value("")));
+}
+
+TEST(FieldIndexTest, OrderByScan) {
+  Query query = testutil::Query("coll").AddingOrderBy(OrderBy("a", "desc"));
+  absl::optional<FieldIndexScan> scan = FieldIndexScan::ForQuery(query);
+  ASSERT_TRUE(scan);
+
+  EXPECT_EQ(Field("a"), scan->field_path());
+  EXPECT_TRUE(InScan(*scan, Value(nullptr)));
+  EXPECT_TRUE(InScan(*scan, Value(Map("z", 1))));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
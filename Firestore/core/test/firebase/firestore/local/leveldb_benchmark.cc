@@ -0,0 +1,435 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks of the LevelDB persistence layer at realistic scale, reading and
+// writing rows with the same keys and encodings as the remote document cache,
+// the mutation queue and the query cache.
+//
+// Run with `--benchmark_format=json` (or `--benchmark_out=<file>`) to get
+// results that can be compared across releases.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "leveldb/db.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::DatabaseId;
+using model::DocumentKey;
+using model::FieldValue;
+using model::MaybeDocument;
+using model::Mutation;
+using model::MutationBatch;
+using model::ResourcePath;
+using nanopb::Reader;
+using nanopb::StringWriter;
+using util::Path;
+
+constexpr model::TargetId kTargetId = 1;
+const char* const kUserId = "user";
+
+/** A LevelDB database in a fresh temporary directory, deleted afterwards. */
+class BenchmarkDb {
+ public:
+  BenchmarkDb()
+      : dir_{Path::JoinUtf8(util::TempDir(),
+                            absl::StrCat("firestore_leveldb_benchmark_",
+                                         reinterpret_cast<uintptr_t>(this)))} {
+    util::Status status = util::RecursivelyDelete(dir_);
+    HARD_ASSERT(status.ok(), "Failed to clean %s", dir_.ToUtf8String());
+
+    leveldb::Options options;
+    options.create_if_missing = true;
+    leveldb::DB* db = nullptr;
+    leveldb::Status opened =
+        leveldb::DB::Open(options, dir_.ToUtf8String(), &db);
+    HARD_ASSERT(opened.ok(), "Failed to open %s: %s", dir_.ToUtf8String(),
+                opened.ToString());
+    db_.reset(db);
+  }
+
+  ~BenchmarkDb() {
+    db_.reset();
+    util::RecursivelyDelete(dir_).IgnoreError();
+  }
+
+  leveldb::DB* get() {
+    return db_.get();
+  }
+
+ private:
+  Path dir_;
+  std::unique_ptr<leveldb::DB> db_;
+};
+
+/**
+ * Creates the data for a document with `field_count` fields of mixed types,
+ * so that the size of documents can be varied.
+ */
+FieldValue::Map MakeDocumentData(int64_t index, int64_t field_count) {
+  FieldValue::Map fields;
+  for (int64_t i = 0; i < field_count; ++i) {
+    switch (i % 4) {
+      case 0:
+        fields = fields.insert(absl::StrCat("name", i),
+                               FieldValue::FromString(absl::StrCat(
+                                   "a moderately long string value ", index)));
+        break;
+      case 1:
+        fields = fields.insert(absl::StrCat("count", i),
+                               FieldValue::FromInteger(index * i));
+        break;
+      case 2:
+        fields = fields.insert(absl::StrCat("score", i),
+                               FieldValue::FromDouble(0.5 * index));
+        break;
+      default:
+        fields = fields.insert(
+            absl::StrCat("tags", i),
+            FieldValue::FromArray({FieldValue::FromString("red"),
+                                   FieldValue::FromInteger(index),
+                                   FieldValue::True()}));
+        break;
+    }
+  }
+  return fields;
+}
+
+std::string DocumentPath(int64_t index) {
+  return absl::StrCat("docs/doc", index);
+}
+
+std::string EncodeDocument(const LocalSerializer& serializer,
+                           int64_t index,
+                           int64_t field_count) {
+  auto doc = testutil::Doc(DocumentPath(index), /*version=*/1,
+                           MakeDocumentData(index, field_count));
+  firestore_client_MaybeDocument proto = serializer.EncodeMaybeDocument(*doc);
+
+  StringWriter writer;
+  writer.WriteNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+  LocalSerializer::FreeNanopbMessage(firestore_client_MaybeDocument_fields,
+                                     &proto);
+  return writer.Release();
+}
+
+std::unique_ptr<MaybeDocument> DecodeDocument(
+    const LocalSerializer& serializer, absl::string_view bytes) {
+  Reader reader{bytes};
+  firestore_client_MaybeDocument proto{};
+  reader.ReadNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+  std::unique_ptr<MaybeDocument> doc =
+      serializer.DecodeMaybeDocument(&reader, proto);
+  reader.FreeNanopbMessage(firestore_client_MaybeDocument_fields, &proto);
+  HARD_ASSERT(reader.status().ok(), "Failed to decode document");
+  return doc;
+}
+
+/** Writes `doc_count` documents of `field_count` fields in one transaction. */
+void WriteDocuments(leveldb::DB* db,
+                    const LocalSerializer& serializer,
+                    int64_t doc_count,
+                    int64_t field_count) {
+  LevelDbTransaction transaction{db, "WriteDocuments"};
+  for (int64_t i = 0; i < doc_count; ++i) {
+    transaction.Put(
+        LevelDbRemoteDocumentKey::Key(testutil::Key(DocumentPath(i))),
+        EncodeDocument(serializer, i, field_count));
+    transaction.CommitChunkIfLarger(16 * 1024 * 1024);
+  }
+  transaction.Commit();
+}
+
+/** Writes the documents of the batch that sets `doc_count` documents. */
+void BM_WriteRemoteDocuments(benchmark::State& state) {
+  remote::Serializer rpc_serializer{DatabaseId{"p", "d"}};
+  LocalSerializer serializer{rpc_serializer};
+  BenchmarkDb db;
+  int64_t doc_count = state.range(0);
+  int64_t field_count = state.range(1);
+
+  for (auto _ : state) {
+    WriteDocuments(db.get(), serializer, doc_count, field_count);
+  }
+  state.SetItemsProcessed(state.iterations() * doc_count);
+}
+BENCHMARK(BM_WriteRemoteDocuments)
+    ->RangeMultiplier(10)
+    ->Ranges({{1000, 100000}, {4, 64}})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Scans and decodes a whole collection of the remote document cache, as a
+ * collection query does.
+ */
+void BM_ScanRemoteDocuments(benchmark::State& state) {
+  remote::Serializer rpc_serializer{DatabaseId{"p", "d"}};
+  LocalSerializer serializer{rpc_serializer};
+  BenchmarkDb db;
+  int64_t doc_count = state.range(0);
+  WriteDocuments(db.get(), serializer, doc_count, state.range(1));
+
+  ResourcePath collection = testutil::Resource("docs");
+  std::string prefix = LevelDbRemoteDocumentKey::KeyPrefix(collection);
+  for (auto _ : state) {
+    LevelDbTransaction transaction{db.get(), "ScanRemoteDocuments"};
+    auto it =
+        transaction.NewIterator(LevelDbTransaction::FastScanReadOptions());
+    int64_t found = 0;
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+         it->Next()) {
+      benchmark::DoNotOptimize(DecodeDocument(serializer, it->value()));
+      ++found;
+    }
+    HARD_ASSERT(found == doc_count, "Scanned %s documents", found);
+  }
+  state.SetItemsProcessed(state.iterations() * doc_count);
+}
+BENCHMARK(BM_ScanRemoteDocuments)
+    ->RangeMultiplier(32)
+    ->Ranges({{1 << 10, 1 << 20}, {4, 16}})
+    ->Unit(benchmark::kMillisecond);
+
+/** Looks up and decodes 100 documents by key, as a batch of writes does. */
+void BM_GetRemoteDocuments(benchmark::State& state) {
+  remote::Serializer rpc_serializer{DatabaseId{"p", "d"}};
+  LocalSerializer serializer{rpc_serializer};
+  BenchmarkDb db;
+  int64_t doc_count = state.range(0);
+  WriteDocuments(db.get(), serializer, doc_count, /*field_count=*/8);
+
+  constexpr int64_t kLookups = 100;
+  std::vector<std::string> keys;
+  for (int64_t i = 0; i < kLookups; ++i) {
+    // Spread the lookups across the whole table.
+    int64_t index = (i * 7919) % doc_count;
+    keys.push_back(
+        LevelDbRemoteDocumentKey::Key(testutil::Key(DocumentPath(index))));
+  }
+
+  std::string value;
+  for (auto _ : state) {
+    LevelDbTransaction transaction{db.get(), "GetRemoteDocuments"};
+    for (const std::string& key : keys) {
+      leveldb::Status status = transaction.Get(key, &value);
+      HARD_ASSERT(status.ok(), "Missing document");
+      benchmark::DoNotOptimize(DecodeDocument(serializer, value));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kLookups);
+}
+BENCHMARK(BM_GetRemoteDocuments)
+    ->RangeMultiplier(32)
+    ->Range(1 << 10, 1 << 20)
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * Reads and decodes all the pending batches of the mutation queue, as
+ * replaying them over a local view does. Each batch sets `mutation_count`
+ * documents.
+ */
+void BM_ReadMutationQueue(benchmark::State& state) {
+  remote::Serializer rpc_serializer{DatabaseId{"p", "d"}};
+  LocalSerializer serializer{rpc_serializer};
+  BenchmarkDb db;
+  int64_t batch_count = state.range(0);
+  int64_t mutation_count = state.range(1);
+
+  {
+    LevelDbTransaction transaction{db.get(), "WriteMutationQueue"};
+    for (int64_t batch_id = 1; batch_id <= batch_count; ++batch_id) {
+      std::vector<std::unique_ptr<Mutation>> mutations;
+      for (int64_t i = 0; i < mutation_count; ++i) {
+        int64_t index = batch_id * mutation_count + i;
+        mutations.push_back(testutil::SetMutation(
+            DocumentPath(index), MakeDocumentData(index, 8)));
+      }
+      MutationBatch batch{static_cast<int>(batch_id), Timestamp::Now(),
+                          std::move(mutations)};
+
+      firestore_client_WriteBatch proto =
+          serializer.EncodeMutationBatch(batch);
+      StringWriter writer;
+      writer.WriteNanopbMessage(firestore_client_WriteBatch_fields, &proto);
+      LocalSerializer::FreeNanopbMessage(firestore_client_WriteBatch_fields,
+                                         &proto);
+      transaction.Put(
+          LevelDbMutationKey::Key(kUserId, static_cast<int>(batch_id)),
+          writer.Release());
+    }
+    transaction.Commit();
+  }
+
+  std::string prefix = LevelDbMutationKey::KeyPrefix(kUserId);
+  for (auto _ : state) {
+    LevelDbTransaction transaction{db.get(), "ReadMutationQueue"};
+    auto it = transaction.NewIterator();
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+         it->Next()) {
+      Reader reader{it->value()};
+      firestore_client_WriteBatch proto{};
+      reader.ReadNanopbMessage(firestore_client_WriteBatch_fields, &proto);
+      MutationBatch batch = serializer.DecodeMutationBatch(&reader, proto);
+      reader.FreeNanopbMessage(firestore_client_WriteBatch_fields, &proto);
+      HARD_ASSERT(reader.status().ok(), "Failed to decode mutation batch");
+      benchmark::DoNotOptimize(&batch);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * batch_count);
+}
+BENCHMARK(BM_ReadMutationQueue)
+    ->RangeMultiplier(10)
+    ->Ranges({{1, 1000}, {1, 10}})
+    ->Unit(benchmark::kMicrosecond);
+
+/** Reads the keys of all the documents matching a target. */
+void BM_ScanTargetDocuments(benchmark::State& state) {
+  BenchmarkDb db;
+  int64_t doc_count = state.range(0);
+
+  {
+    LevelDbTransaction transaction{db.get(), "WriteTargetDocuments"};
+    for (int64_t i = 0; i < doc_count; ++i) {
+      DocumentKey key = testutil::Key(DocumentPath(i));
+      transaction.Put(LevelDbTargetDocumentKey::Key(kTargetId, key), "");
+      transaction.Put(LevelDbDocumentTargetKey::Key(key, kTargetId), "");
+      transaction.CommitChunkIfLarger(16 * 1024 * 1024);
+    }
+    transaction.Commit();
+  }
+
+  std::string prefix = LevelDbTargetDocumentKey::KeyPrefix(kTargetId);
+  for (auto _ : state) {
+    LevelDbTransaction transaction{db.get(), "ScanTargetDocuments"};
+    auto it =
+        transaction.NewIterator(LevelDbTransaction::FastScanReadOptions());
+    LevelDbTargetDocumentKey row_key;
+    int64_t found = 0;
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+         it->Next()) {
+      bool decoded = row_key.Decode(it->key());
+      HARD_ASSERT(decoded, "Invalid target document key");
+      benchmark::DoNotOptimize(row_key.document_key());
+      ++found;
+    }
+    HARD_ASSERT(found == doc_count, "Scanned %s keys", found);
+  }
+  state.SetItemsProcessed(state.iterations() * doc_count);
+}
+BENCHMARK(BM_ScanTargetDocuments)
+    ->RangeMultiplier(32)
+    ->Range(1 << 10, 1 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Buffers the rows of a remote event that adds `doc_count` documents to a
+ * target, looking up the previous read time of each document first as the
+ * remote document cache does, without committing them.
+ */
+void BM_BufferRemoteEventWrites(benchmark::State& state) {
+  BenchmarkDb db;
+  int64_t doc_count = state.range(0);
+  std::string document(512, 'x');
+
+  std::vector<DocumentKey> keys;
+  for (int64_t i = 0; i < doc_count; ++i) {
+    keys.push_back(testutil::Key(DocumentPath(i)));
+  }
+
+  std::string read_time;
+  for (auto _ : state) {
+    LevelDbTransaction transaction{db.get(), "BufferRemoteEventWrites"};
+    for (const DocumentKey& key : keys) {
+      std::string read_time_key = LevelDbDocumentReadTimeKey::Key(key);
+      benchmark::DoNotOptimize(transaction.Get(read_time_key, &read_time));
+      transaction.Put(LevelDbRemoteDocumentKey::Key(key), document);
+      transaction.Put(std::move(read_time_key), "read time");
+      transaction.Put(LevelDbTargetDocumentKey::Key(kTargetId, key), "");
+      transaction.Put(LevelDbDocumentTargetKey::Key(key, kTargetId), "");
+    }
+    benchmark::DoNotOptimize(transaction.changed_keys());
+  }
+  state.SetItemsProcessed(state.iterations() * doc_count);
+}
+BENCHMARK(BM_BufferRemoteEventWrites)
+    ->RangeMultiplier(8)
+    ->Range(1 << 10, 1 << 16)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Scans the keys of a target whose rows were all written earlier in the same
+ * transaction, as a query run right after a remote event does.
+ */
+void BM_ScanBufferedTargetDocuments(benchmark::State& state) {
+  BenchmarkDb db;
+  int64_t doc_count = state.range(0);
+
+  LevelDbTransaction transaction{db.get(), "ScanBufferedTargetDocuments"};
+  for (int64_t i = 0; i < doc_count; ++i) {
+    DocumentKey key = testutil::Key(DocumentPath(i));
+    transaction.Put(LevelDbTargetDocumentKey::Key(kTargetId, key), "");
+    transaction.Put(LevelDbDocumentTargetKey::Key(key, kTargetId), "");
+  }
+
+  std::string prefix = LevelDbTargetDocumentKey::KeyPrefix(kTargetId);
+  for (auto _ : state) {
+    auto it =
+        transaction.NewIterator(LevelDbTransaction::FastScanReadOptions());
+    int64_t found = 0;
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+         it->Next()) {
+      ++found;
+    }
+    HARD_ASSERT(found == doc_count, "Scanned %s keys", found);
+  }
+  state.SetItemsProcessed(state.iterations() * doc_count);
+}
+BENCHMARK(BM_ScanBufferedTargetDocuments)
+    ->RangeMultiplier(8)
+    ->Range(1 << 10, 1 << 16)
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,357 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_bundle_loader.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
+#include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::DatabaseId;
+using model::DocumentKey;
+using model::SnapshotVersion;
+using nanopb::Reader;
+using nanopb::StringWriter;
+using testutil::Key;
+using testutil::Version;
+using util::Path;
+
+const char* const kDocumentPrefix = "projects/p/databases/d/documents/";
+
+std::string EncodeDocument(const std::string& path, bool exists = true) {
+  StringWriter document;
+  document.WriteTag(PB_WT_STRING, google_firestore_v1_Document_name_tag);
+  document.WriteString(kDocumentPrefix + path);
+
+  StringWriter writer;
+  writer.WriteTag(PB_WT_STRING,
+                  exists ? firestore_client_MaybeDocument_document_tag
+                         : firestore_client_MaybeDocument_no_document_tag);
+  writer.WriteString(document.Release());
+  return writer.Release();
+}
+
+std::string EncodeTarget(model::TargetId target_id,
+                         model::ListenSequenceNumber sequence_number) {
+  StringWriter writer;
+  writer.WriteTag(PB_WT_VARINT, firestore_client_Target_target_id_tag);
+  writer.WriteInteger(target_id);
+  writer.WriteTag(PB_WT_VARINT,
+                  firestore_client_Target_last_listen_sequence_number_tag);
+  writer.WriteInteger(sequence_number);
+  return writer.Release();
+}
+
+struct TargetGlobal {
+  int64_t highest_target_id;
+  int64_t highest_listen_sequence_number;
+  int64_t last_remote_snapshot_seconds;
+  int64_t target_count;
+};
+
+std::string EncodeTargetGlobal(const TargetGlobal& global) {
+  StringWriter version;
+  version.WriteTag(PB_WT_VARINT, google_protobuf_Timestamp_seconds_tag);
+  version.WriteInteger(global.last_remote_snapshot_seconds);
+
+  StringWriter writer;
+  writer.WriteTag(PB_WT_VARINT,
+                  firestore_client_TargetGlobal_highest_target_id_tag);
+  writer.WriteInteger(global.highest_target_id);
+  writer.WriteTag(
+      PB_WT_VARINT,
+      firestore_client_TargetGlobal_highest_listen_sequence_number_tag);
+  writer.WriteInteger(global.highest_listen_sequence_number);
+  writer.WriteTag(
+      PB_WT_STRING,
+      firestore_client_TargetGlobal_last_remote_snapshot_version_tag);
+  writer.WriteString(version.Release());
+  writer.WriteTag(PB_WT_VARINT, firestore_client_TargetGlobal_target_count_tag);
+  writer.WriteInteger(global.target_count);
+  return writer.Release();
+}
+
+TargetGlobal DecodeTargetGlobal(const std::string& bytes) {
+  TargetGlobal result{};
+  Reader reader{bytes};
+  while (reader.ReadTag()) {
+    switch (reader.field_number()) {
+      case firestore_client_TargetGlobal_highest_target_id_tag:
+        result.highest_target_id = reader.ReadInteger();
+        break;
+      case firestore_client_TargetGlobal_highest_listen_sequence_number_tag:
+        result.highest_listen_sequence_number = reader.ReadInteger();
+        break;
+      case firestore_client_TargetGlobal_last_remote_snapshot_version_tag:
+        reader.ReadNestedMessage([&](Reader* fields) {
+          while (fields->ReadTag()) {
+            if (fields->field_number() ==
+                google_protobuf_Timestamp_seconds_tag) {
+              result.last_remote_snapshot_seconds = fields->ReadInteger();
+            } else {
+              fields->SkipField();
+            }
+          }
+        });
+        break;
+      case firestore_client_TargetGlobal_target_count_tag:
+        result.target_count = reader.ReadInteger();
+        break;
+      default:
+        reader.SkipField();
+    }
+  }
+  EXPECT_TRUE(reader.status().ok());
+  return result;
+}
+
+}  // namespace
+
+class LevelDbBundleLoaderTest : public testing::Test {
+ public:
+  LevelDbBundleLoaderTest()
+      : dir_{Path::JoinUtf8(util::TempDir(),
+                            absl::StrCat("firestore_bundle_loader_test_",
+                                         reinterpret_cast<uintptr_t>(this)))} {
+    EXPECT_TRUE(util::RecursivelyDelete(dir_).ok());
+
+    leveldb::Options options;
+    options.create_if_missing = true;
+    leveldb::DB* db = nullptr;
+    EXPECT_TRUE(leveldb::DB::Open(options, dir_.ToUtf8String(), &db).ok());
+    db_.reset(db);
+  }
+
+  ~LevelDbBundleLoaderTest() override {
+    db_.reset();
+    util::RecursivelyDelete(dir_).IgnoreError();
+  }
+
+ protected:
+  util::StatusOr<LevelDbBundleLoader::Result> Load(const std::string& bundle) {
+    LevelDbBundleLoader loader{db_.get(), DatabaseId{"p", "d"}};
+    loader.set_batch_size_bytes(batch_size_bytes_);
+    return loader.Load(bundle);
+  }
+
+  bool Has(const std::string& key) {
+    std::string value;
+    return Get(key, &value);
+  }
+
+  bool Get(const std::string& key, std::string* value) {
+    return db_->Get(LevelDbTransaction::DefaultReadOptions(), key, value).ok();
+  }
+
+  void Put(const std::string& key, const std::string& value) {
+    ASSERT_TRUE(
+        db_->Put(LevelDbTransaction::DefaultWriteOptions(), key, value).ok());
+  }
+
+  std::map<std::string, std::string> Contents() {
+    std::map<std::string, std::string> result;
+    std::unique_ptr<leveldb::Iterator> it{
+        db_->NewIterator(LevelDbTransaction::DefaultReadOptions())};
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      result[it->key().ToString()] = it->value().ToString();
+    }
+    return result;
+  }
+
+  Path dir_;
+  std::unique_ptr<leveldb::DB> db_;
+  size_t batch_size_bytes_ = LevelDbBundleLoader::kDefaultBatchSizeBytes;
+};
+
+TEST_F(LevelDbBundleLoaderTest, LoadsDocumentsAsEncoded) {
+  SnapshotVersion read_time = Version(1000);
+  BundleWriter writer{read_time};
+  std::string room = EncodeDocument("rooms/eros");
+  std::string missing = EncodeDocument("rooms/eros/messages/1", false);
+  writer.AddDocument(room);
+  writer.AddDocument(missing);
+
+  auto result = Load(writer.Release());
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(2, result.ValueOrDie().document_count);
+  EXPECT_EQ(0, result.ValueOrDie().query_count);
+  EXPECT_TRUE(result.ValueOrDie().documents_to_index.empty());
+
+  std::string value;
+  ASSERT_TRUE(Get(LevelDbRemoteDocumentKey::Key(Key("rooms/eros")), &value));
+  EXPECT_EQ(room, value);
+  ASSERT_TRUE(Get(
+      LevelDbRemoteDocumentKey::Key(Key("rooms/eros/messages/1")), &value));
+  EXPECT_EQ(missing, value);
+
+  EXPECT_TRUE(Has(LevelDbCollectionGroupDocumentKey::Key(Key("rooms/eros"))));
+  EXPECT_TRUE(Has(LevelDbRemoteDocumentReadTimeKey::Key(Key("rooms/eros"),
+                                                         read_time)));
+  ASSERT_TRUE(Get(LevelDbDocumentReadTimeKey::Key(Key("rooms/eros")), &value));
+  EXPECT_EQ(read_time, LevelDbDocumentReadTimeKey::DecodeReadTime(value));
+
+  EXPECT_TRUE(
+      Has(LevelDbCollectionParentKey::Key("rooms", model::ResourcePath{})));
+  EXPECT_TRUE(Has(LevelDbCollectionParentKey::Key(
+      "messages", model::ResourcePath{"rooms", "eros"})));
+}
+
+TEST_F(LevelDbBundleLoaderTest, ReplacesPreviousReadTimes) {
+  BundleWriter first{Version(1000)};
+  first.AddDocument(EncodeDocument("rooms/eros"));
+  ASSERT_TRUE(Load(first.Release()).ok());
+
+  BundleWriter second{Version(2000)};
+  second.AddDocument(EncodeDocument("rooms/eros"));
+  ASSERT_TRUE(Load(second.Release()).ok());
+
+  EXPECT_FALSE(Has(LevelDbRemoteDocumentReadTimeKey::Key(Key("rooms/eros"),
+                                                          Version(1000))));
+  EXPECT_TRUE(Has(LevelDbRemoteDocumentReadTimeKey::Key(Key("rooms/eros"),
+                                                         Version(2000))));
+}
+
+TEST_F(LevelDbBundleLoaderTest, LoadsQueries) {
+  Put(LevelDbTargetGlobalKey::Key(),
+      EncodeTargetGlobal(TargetGlobal{4, 10, 500, 2}));
+
+  BundleWriter writer{Version(1000)};
+  writer.AddDocument(EncodeDocument("rooms/eros"));
+  writer.AddDocument(EncodeDocument("rooms/other"));
+  std::string target = EncodeTarget(6, 42);
+  writer.AddQuery("rooms|f:|ob:__name__asc", target,
+                  {Key("rooms/eros"), Key("rooms/other")});
+
+  auto result = Load(writer.Release());
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(1, result.ValueOrDie().query_count);
+
+  std::string value;
+  ASSERT_TRUE(Get(LevelDbTargetKey::Key(6), &value));
+  EXPECT_EQ(target, value);
+  EXPECT_TRUE(Has(LevelDbQueryTargetKey::Key("rooms|f:|ob:__name__asc", 6)));
+  for (const char* path : {"rooms/eros", "rooms/other"}) {
+    EXPECT_TRUE(Has(LevelDbTargetDocumentKey::Key(6, Key(path))));
+    EXPECT_TRUE(Has(LevelDbDocumentTargetKey::Key(Key(path), 6)));
+    ASSERT_TRUE(Get(LevelDbDocumentTargetKey::SentinelKey(Key(path)), &value));
+    EXPECT_EQ(42, LevelDbDocumentTargetKey::DecodeSentinelValue(value));
+  }
+
+  ASSERT_TRUE(Get(LevelDbTargetGlobalKey::Key(), &value));
+  TargetGlobal global = DecodeTargetGlobal(value);
+  EXPECT_EQ(6, global.highest_target_id);
+  EXPECT_EQ(42, global.highest_listen_sequence_number);
+  EXPECT_EQ(500, global.last_remote_snapshot_seconds);
+  EXPECT_EQ(3, global.target_count);
+}
+
+TEST_F(LevelDbBundleLoaderTest, WritesInBatches) {
+  batch_size_bytes_ = 1;
+
+  BundleWriter writer{Version(1000)};
+  std::vector<DocumentKey> keys;
+  for (int i = 0; i < 100; i++) {
+    std::string path = absl::StrCat("rooms/", i);
+    writer.AddDocument(EncodeDocument(path));
+    keys.push_back(Key(path));
+  }
+  writer.AddQuery("rooms", EncodeTarget(2, 1), keys);
+
+  auto result = Load(writer.Release());
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(100, result.ValueOrDie().document_count);
+  for (const DocumentKey& key : keys) {
+    EXPECT_TRUE(Has(LevelDbRemoteDocumentKey::Key(key)));
+    EXPECT_TRUE(Has(LevelDbTargetDocumentKey::Key(2, key)));
+  }
+  EXPECT_TRUE(Has(LevelDbTargetKey::Key(2)));
+}
+
+TEST_F(LevelDbBundleLoaderTest, ReportsDocumentsToAddToFieldIndexes) {
+  Put(LevelDbFieldIndexKey::Key(model::ResourcePath{"rooms"},
+                                testutil::Field("name")),
+      "");
+
+  BundleWriter writer{Version(1000)};
+  writer.AddDocument(EncodeDocument("rooms/eros"));
+  writer.AddDocument(EncodeDocument("rooms/eros/messages/1"));
+
+  auto result = Load(writer.Release());
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(std::vector<DocumentKey>{Key("rooms/eros")},
+            result.ValueOrDie().documents_to_index);
+}
+
+TEST_F(LevelDbBundleLoaderTest, RejectsBadBundlesWithoutWriting) {
+  Put(LevelDbTargetKey::Key(3), EncodeTarget(3, 1));
+  std::map<std::string, std::string> before = Contents();
+
+  BundleWriter other_database{Version(1000)};
+  other_database.AddDocument(EncodeDocument("rooms/eros"));
+  std::string document = EncodeDocument("rooms/eros");
+  document.replace(document.find("databases/d"), 11, "databases/e");
+  other_database.AddDocument(document);
+  EXPECT_EQ(Error::InvalidArgument,
+            Load(other_database.Release()).status().code());
+
+  BundleWriter collection{Version(1000)};
+  collection.AddDocument(EncodeDocument("rooms"));
+  EXPECT_EQ(Error::InvalidArgument, Load(collection.Release()).status().code());
+
+  BundleWriter existing_target{Version(1000)};
+  existing_target.AddDocument(EncodeDocument("rooms/eros"));
+  existing_target.AddQuery("rooms", EncodeTarget(3, 1), {Key("rooms/eros")});
+  EXPECT_EQ(Error::FailedPrecondition,
+            Load(existing_target.Release()).status().code());
+
+  BundleWriter duplicate_target{Version(1000)};
+  duplicate_target.AddQuery("rooms", EncodeTarget(4, 1), {});
+  duplicate_target.AddQuery("rooms", EncodeTarget(4, 1), {});
+  EXPECT_EQ(Error::InvalidArgument,
+            Load(duplicate_target.Release()).status().code());
+
+  BundleWriter valid{Version(1000)};
+  valid.AddDocument(EncodeDocument("rooms/eros"));
+  std::string truncated = valid.Release();
+  truncated.resize(truncated.size() - 3);
+  EXPECT_FALSE(Load(truncated).ok());
+
+  EXPECT_EQ(before, Contents());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_compaction_tracker.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+constexpr size_t kMinDeletes = LevelDbCompactionTracker::kMinDeletesToCompact;
+
+std::string DocKey(size_t i) {
+  return LevelDbRemoteDocumentKey::Key(
+      testutil::Key(absl::StrCat("coll/doc", 1000000 + i)));
+}
+
+// Returns views of the given keys, in order.
+std::vector<absl::string_view> InOrder(const std::set<std::string>& keys) {
+  return {keys.begin(), keys.end()};
+}
+
+}  // namespace
+
+TEST(LevelDbCompactionTrackerTest, WaitsForEnoughDeletes) {
+  LevelDbCompactionTracker tracker;
+  EXPECT_FALSE(tracker.compaction_due());
+
+  std::set<std::string> keys;
+  for (size_t i = 0; i != kMinDeletes - 1; ++i) {
+    keys.insert(DocKey(i));
+  }
+  tracker.RecordDeletes(InOrder(keys));
+  EXPECT_FALSE(tracker.compaction_due());
+  EXPECT_TRUE(tracker.TakeRangesToCompact().empty());
+
+  tracker.RecordDeletes({DocKey(kMinDeletes + 5)});
+  EXPECT_TRUE(tracker.compaction_due());
+
+  std::vector<LevelDbCompactionTracker::KeyRange> ranges =
+      tracker.TakeRangesToCompact();
+  ASSERT_EQ(ranges.size(), 1u);
+  EXPECT_EQ(ranges[0].begin, DocKey(0));
+  EXPECT_EQ(ranges[0].end, DocKey(kMinDeletes + 5));
+
+  EXPECT_FALSE(tracker.compaction_due());
+  EXPECT_TRUE(tracker.TakeRangesToCompact().empty());
+}
+
+TEST(LevelDbCompactionTrackerTest, KeepsTablesApart) {
+  LevelDbCompactionTracker tracker;
+
+  std::set<std::string> keys;
+  for (size_t i = 0; i != kMinDeletes; ++i) {
+    keys.insert(DocKey(i));
+  }
+  keys.insert(LevelDbTargetKey::Key(1));
+  keys.insert(LevelDbTargetKey::Key(7));
+  tracker.RecordDeletes(InOrder(keys));
+
+  // Only the documents had enough deletes; the targets wait for more.
+  std::vector<LevelDbCompactionTracker::KeyRange> ranges =
+      tracker.TakeRangesToCompact();
+  ASSERT_EQ(ranges.size(), 1u);
+  EXPECT_EQ(ranges[0].begin, DocKey(0));
+  EXPECT_EQ(ranges[0].end, DocKey(kMinDeletes - 1));
+
+  keys.clear();
+  for (int i = 10; i != 10 + static_cast<int>(kMinDeletes); ++i) {
+    keys.insert(LevelDbTargetKey::Key(i));
+  }
+  tracker.RecordDeletes(InOrder(keys));
+
+  ranges = tracker.TakeRangesToCompact();
+  ASSERT_EQ(ranges.size(), 1u);
+  EXPECT_EQ(ranges[0].begin, LevelDbTargetKey::Key(1));
+  EXPECT_EQ(ranges[0].end,
+            LevelDbTargetKey::Key(10 + static_cast<int>(kMinDeletes) - 1));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -16,12 +16,19 @@
 
 #include "Firestore/core/test/firebase/firestore/local/index_manager_test.h"
 
+#include <string>
+#include <vector>
+
 #import "Firestore/Example/Tests/Local/FSTPersistenceTestHelpers.h"
+#import "Firestore/Source/Local/FSTLevelDB.h"
 #import "Firestore/Source/Local/FSTPersistence.h"
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_index_manager.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "absl/memory/memory.h"
 #include "gtest/gtest.h"
+#include "leveldb/db.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -42,6 +49,39 @@ INSTANTIATE_TEST_CASE_P(LevelDbIndexManagerTest,
                         IndexManagerTest,
                         ::testing::Values(PersistenceFactory));
 
+TEST(LevelDbIndexManagerTest, ReadsCollectionParentsWrittenBefore) {
+  using model::ResourcePath;
+
+  FSTLevelDB* db = [FSTPersistenceTestHelpers levelDBPersistence];
+  // Entries written by an earlier run of the SDK.
+  db.ptr->Put(leveldb::WriteOptions(),
+              LevelDbCollectionParentKey::Key("messages",
+                                              ResourcePath{"rooms", "foo"}),
+              "");
+
+  IndexManager* index_manager = db.indexManager;
+  db.run("ReadsCollectionParentsWrittenBefore", [&]() {
+    EXPECT_EQ(index_manager->GetCollectionParents("messages"),
+              std::vector<ResourcePath>{(ResourcePath{"rooms", "foo"})});
+
+    // Entries added once the collection ID was read are served from memory.
+    index_manager->AddToCollectionParentIndex(
+        ResourcePath{"rooms", "bar", "messages"});
+    EXPECT_EQ(index_manager->GetCollectionParents("messages"),
+              (std::vector<ResourcePath>{ResourcePath{"rooms", "bar"},
+                                         ResourcePath{"rooms", "foo"}}));
+  });
+
+  static_cast<LevelDbIndexManager*>(index_manager)->TrimMemory();
+  db.run("ReadsCollectionParentsAfterTrim", [&]() {
+    EXPECT_EQ(index_manager->GetCollectionParents("messages"),
+              (std::vector<ResourcePath>{ResourcePath{"rooms", "bar"},
+                                         ResourcePath{"rooms", "foo"}}));
+  });
+
+  [db shutdown];
+}
+
 NS_ASSUME_NONNULL_END
 
 }  // namespace local
@@ -0,0 +1,318 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks of building and decoding the LevelDB keys that every seek and
+// scan of the remote document cache, the mutation queue and the query cache
+// goes through. Each benchmark takes the number of nested collections in the
+// document paths, so `/1` is a top level document like `rooms/<id>` and `/4`
+// is `rooms/<id>/messages/<id>/reactions/<id>/users/<id>`.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/autoid.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::BatchId;
+using model::DocumentKey;
+using model::ResourcePath;
+using model::TargetId;
+
+// Enough distinct keys that the benchmarks don't just encode the same bytes
+// over and over.
+constexpr size_t kKeyCount = 256;
+
+// A user ID as issued by Firebase Auth.
+const char kUserId[] = "kPpMw2ZxAYQbXGbF8DU5nqJwhT53";
+
+constexpr BatchId kBatchId = 4711;
+constexpr TargetId kTargetId = 42;
+
+std::vector<DocumentKey> DocumentKeys(int64_t depth) {
+  std::vector<DocumentKey> result;
+  for (size_t i = 0; i < kKeyCount; ++i) {
+    std::vector<std::string> segments;
+    for (int64_t level = 0; level < depth; ++level) {
+      segments.push_back(absl::StrCat("collection_", level));
+      segments.push_back(util::CreateAutoId());
+    }
+    result.push_back(DocumentKey{ResourcePath{std::move(segments)}});
+  }
+  return result;
+}
+
+// Canonical IDs of queries over the collections containing the documents.
+std::vector<std::string> CanonicalIds(const std::vector<DocumentKey>& keys) {
+  std::vector<std::string> result;
+  for (const DocumentKey& key : keys) {
+    result.push_back(absl::StrCat(key.path().PopLast().CanonicalString(),
+                                  "|f:timestamp>1546300800|ob:timestampdesc"));
+  }
+  return result;
+}
+
+void Depths(benchmark::internal::Benchmark* b) {
+  for (int depth = 1; depth <= 4; ++depth) {
+    b->Arg(depth);
+  }
+}
+
+void BM_RemoteDocumentKey(benchmark::State& state) {
+  std::vector<DocumentKey> keys = DocumentKeys(state.range(0));
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        LevelDbRemoteDocumentKey::Key(keys[i++ % kKeyCount]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RemoteDocumentKey)->Apply(Depths);
+
+void BM_RemoteDocumentAppendKey(benchmark::State& state) {
+  std::vector<DocumentKey> keys = DocumentKeys(state.range(0));
+
+  std::string buffer;
+  size_t i = 0;
+  for (auto _ : state) {
+    buffer.clear();
+    LevelDbRemoteDocumentKey::AppendKey(&buffer, keys[i++ % kKeyCount]);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RemoteDocumentAppendKey)->Apply(Depths);
+
+void BM_RemoteDocumentKeyPrefix(benchmark::State& state) {
+  std::vector<DocumentKey> keys = DocumentKeys(state.range(0));
+  std::vector<ResourcePath> collections;
+  for (const DocumentKey& key : keys) {
+    collections.push_back(key.path().PopLast());
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        LevelDbRemoteDocumentKey::KeyPrefix(collections[i++ % kKeyCount]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RemoteDocumentKeyPrefix)->Apply(Depths);
+
+void BM_RemoteDocumentKeyDecode(benchmark::State& state) {
+  std::vector<std::string> encoded;
+  for (const DocumentKey& key : DocumentKeys(state.range(0))) {
+    encoded.push_back(LevelDbRemoteDocumentKey::Key(key));
+  }
+
+  LevelDbRemoteDocumentKey key;
+  size_t i = 0;
+  for (auto _ : state) {
+    bool ok = key.Decode(encoded[i++ % kKeyCount]);
+    HARD_ASSERT(ok);
+    benchmark::DoNotOptimize(key.document_key());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RemoteDocumentKeyDecode)->Apply(Depths);
+
+void BM_RemoteDocumentKeyViewDecode(benchmark::State& state) {
+  std::vector<std::string> encoded;
+  for (const DocumentKey& key : DocumentKeys(state.range(0))) {
+    encoded.push_back(LevelDbRemoteDocumentKey::Key(key));
+  }
+
+  LevelDbRemoteDocumentKeyView key;
+  size_t i = 0;
+  for (auto _ : state) {
+    bool ok = key.Decode(encoded[i++ % kKeyCount]);
+    HARD_ASSERT(ok);
+    benchmark::DoNotOptimize(key.path());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RemoteDocumentKeyViewDecode)->Apply(Depths);
+
+void BM_DocumentMutationKey(benchmark::State& state) {
+  std::vector<DocumentKey> keys = DocumentKeys(state.range(0));
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LevelDbDocumentMutationKey::Key(
+        kUserId, keys[i++ % kKeyCount], kBatchId));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DocumentMutationKey)->Apply(Depths);
+
+void BM_DocumentMutationKeyPrefix(benchmark::State& state) {
+  std::vector<DocumentKey> keys = DocumentKeys(state.range(0));
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LevelDbDocumentMutationKey::KeyPrefix(
+        kUserId, keys[i++ % kKeyCount].path()));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DocumentMutationKeyPrefix)->Apply(Depths);
+
+void BM_DocumentMutationKeyDecode(benchmark::State& state) {
+  std::vector<std::string> encoded;
+  for (const DocumentKey& key : DocumentKeys(state.range(0))) {
+    encoded.push_back(LevelDbDocumentMutationKey::Key(kUserId, key, kBatchId));
+  }
+
+  LevelDbDocumentMutationKey key;
+  size_t i = 0;
+  for (auto _ : state) {
+    bool ok = key.Decode(encoded[i++ % kKeyCount]);
+    HARD_ASSERT(ok);
+    benchmark::DoNotOptimize(key.batch_id());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DocumentMutationKeyDecode)->Apply(Depths);
+
+void BM_DocumentMutationKeyViewDecode(benchmark::State& state) {
+  std::vector<std::string> encoded;
+  for (const DocumentKey& key : DocumentKeys(state.range(0))) {
+    encoded.push_back(LevelDbDocumentMutationKey::Key(kUserId, key, kBatchId));
+  }
+
+  LevelDbDocumentMutationKeyView key;
+  size_t i = 0;
+  for (auto _ : state) {
+    bool ok = key.Decode(encoded[i++ % kKeyCount]);
+    HARD_ASSERT(ok);
+    benchmark::DoNotOptimize(key.batch_id());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DocumentMutationKeyViewDecode)->Apply(Depths);
+
+void BM_TargetDocumentKey(benchmark::State& state) {
+  std::vector<DocumentKey> keys = DocumentKeys(state.range(0));
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        LevelDbTargetDocumentKey::Key(kTargetId, keys[i++ % kKeyCount]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TargetDocumentKey)->Apply(Depths);
+
+void BM_TargetDocumentAppendKey(benchmark::State& state) {
+  std::vector<DocumentKey> keys = DocumentKeys(state.range(0));
+
+  std::string buffer;
+  size_t i = 0;
+  for (auto _ : state) {
+    buffer.clear();
+    LevelDbTargetDocumentKey::AppendKey(&buffer, kTargetId,
+                                        keys[i++ % kKeyCount]);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TargetDocumentAppendKey)->Apply(Depths);
+
+void BM_TargetDocumentKeyPrefix(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LevelDbTargetDocumentKey::KeyPrefix(kTargetId));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TargetDocumentKeyPrefix);
+
+void BM_TargetDocumentKeyDecode(benchmark::State& state) {
+  std::vector<std::string> encoded;
+  for (const DocumentKey& key : DocumentKeys(state.range(0))) {
+    encoded.push_back(LevelDbTargetDocumentKey::Key(kTargetId, key));
+  }
+
+  LevelDbTargetDocumentKey key;
+  size_t i = 0;
+  for (auto _ : state) {
+    bool ok = key.Decode(encoded[i++ % kKeyCount]);
+    HARD_ASSERT(ok);
+    benchmark::DoNotOptimize(key.document_key());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TargetDocumentKeyDecode)->Apply(Depths);
+
+void BM_QueryTargetKey(benchmark::State& state) {
+  std::vector<std::string> canonical_ids =
+      CanonicalIds(DocumentKeys(state.range(0)));
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LevelDbQueryTargetKey::Key(
+        canonical_ids[i++ % kKeyCount], kTargetId));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueryTargetKey)->Apply(Depths);
+
+void BM_QueryTargetKeyPrefix(benchmark::State& state) {
+  std::vector<std::string> canonical_ids =
+      CanonicalIds(DocumentKeys(state.range(0)));
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        LevelDbQueryTargetKey::KeyPrefix(canonical_ids[i++ % kKeyCount]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueryTargetKeyPrefix)->Apply(Depths);
+
+void BM_QueryTargetKeyDecode(benchmark::State& state) {
+  std::vector<std::string> encoded;
+  for (const std::string& canonical_id :
+       CanonicalIds(DocumentKeys(state.range(0)))) {
+    encoded.push_back(LevelDbQueryTargetKey::Key(canonical_id, kTargetId));
+  }
+
+  LevelDbQueryTargetKey key;
+  size_t i = 0;
+  for (auto _ : state) {
+    bool ok = key.Decode(encoded[i++ % kKeyCount]);
+    HARD_ASSERT(ok);
+    benchmark::DoNotOptimize(key.target_id());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueryTargetKeyDecode)->Apply(Depths);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -24,6 +24,7 @@
 
 using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
 
 namespace firebase {
@@ -46,6 +47,22 @@ std::string DocMutationKey(absl::string_view user_id,
   return LevelDbDocumentMutationKey::Key(user_id, testutil::Key(key), batch_id);
 }
 
+std::string CollectionMutationKey(absl::string_view user_id,
+                                  absl::string_view collection,
+                                  model::BatchId batch_id) {
+  return LevelDbCollectionMutationKey::Key(
+      user_id, testutil::Resource(collection), batch_id);
+}
+
+std::string CollectionGroupDocKey(absl::string_view key) {
+  return LevelDbCollectionGroupDocumentKey::Key(testutil::Key(key));
+}
+
+std::string ReadTimeKey(absl::string_view key, int64_t version) {
+  return LevelDbRemoteDocumentReadTimeKey::Key(testutil::Key(key),
+                                               testutil::Version(version));
+}
+
 std::string TargetDocKey(TargetId target_id, absl::string_view key) {
   return LevelDbTargetDocumentKey::Key(target_id, testutil::Key(key));
 }
@@ -54,6 +71,20 @@ std::string DocTargetKey(absl::string_view key, TargetId target_id) {
   return LevelDbDocumentTargetKey::Key(testutil::Key(key), target_id);
 }
 
+std::string FieldIndexEntryKey(absl::string_view field,
+                               absl::string_view encoded_value,
+                               absl::string_view key) {
+  return LevelDbFieldIndexEntryKey::Key(testutil::Field(field), encoded_value,
+                                        testutil::Key(key));
+}
+
+std::string FieldIndexEntryKeyPrefix(absl::string_view collection,
+                                     absl::string_view field,
+                                     absl::string_view encoded_value) {
+  return LevelDbFieldIndexEntryKey::KeyPrefix(
+      testutil::Resource(collection), testutil::Field(field), encoded_value);
+}
+
 }  // namespace
 
 /**
@@ -66,6 +97,34 @@ std::string DocTargetKey(absl::string_view key, TargetId target_id) {
 #define AssertExpectedKeyDescription(expected_description, key) \
   ASSERT_EQ((expected_description), DescribeKey(key))
 
+TEST(LevelDbMigrationProgressKeyTest, Description) {
+  AssertExpectedKeyDescription("[migration_progress:]",
+                               LevelDbMigrationProgressKey::Key());
+}
+
+TEST(LevelDbDocumentDictionaryKeyTest, Description) {
+  AssertExpectedKeyDescription("[document_dictionary:]",
+                               LevelDbDocumentDictionaryKey::Key());
+}
+
+TEST(LevelDbMigrationProgressKeyTest, EncodeDecodeProgress) {
+  std::string last_key = LevelDbMutationKey::Key("user", 42);
+  std::string encoded =
+      LevelDbMigrationProgressKey::EncodeProgress(9, 1, last_key);
+
+  int64_t version = 0;
+  int64_t scan = 0;
+  std::string decoded_key;
+  ASSERT_TRUE(LevelDbMigrationProgressKey::DecodeProgress(
+      encoded, &version, &scan, &decoded_key));
+  ASSERT_EQ(9, version);
+  ASSERT_EQ(1, scan);
+  ASSERT_EQ(last_key, decoded_key);
+
+  ASSERT_FALSE(LevelDbMigrationProgressKey::DecodeProgress(
+      encoded.substr(0, 2), &version, &scan, &decoded_key));
+}
+
 TEST(LevelDbMutationKeyTest, Prefixing) {
   auto tableKey = LevelDbMutationKey::KeyPrefix();
   auto emptyUserKey = LevelDbMutationKey::KeyPrefix("");
@@ -168,6 +227,33 @@ TEST(LevelDbDocumentMutationKeyTest, EncodeDecodeCycle) {
   }
 }
 
+TEST(LevelDbDocumentMutationKeyTest, DecodesViews) {
+  LevelDbDocumentMutationKeyView key;
+  std::string user("foo");
+
+  // The second key contains escaped bytes, which can't be viewed in place.
+  std::vector<DocumentKey> document_keys{
+      testutil::Key("a/b"), testutil::Key("a/b/c/d"),
+      DocumentKey::FromSegments({"a", std::string("b\0\xff", 3)})};
+
+  for (auto&& document_key : document_keys) {
+    auto encoded = LevelDbDocumentMutationKey::Key(user, document_key, 42);
+
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(user, key.user_id());
+    ASSERT_TRUE(key.path().Equals(document_key.path()));
+    ASSERT_FALSE(key.path().Equals(document_key.path().PopLast()));
+    ASSERT_TRUE(key.path().HasPrefix(document_key.path().PopLast()));
+    ASSERT_EQ(document_key, key.document_key());
+    ASSERT_EQ(42, key.batch_id());
+  }
+
+  std::string prefix = LevelDbDocumentMutationKey::KeyPrefix(
+      user, testutil::Resource("a/b"));
+  ASSERT_FALSE(key.Decode(prefix));
+}
+
 TEST(LevelDbDocumentMutationKeyTest, Ordering) {
   // Different user:
   ASSERT_LT(DocMutationKey("1", "foo/bar", 0),
@@ -208,6 +294,56 @@ TEST(LevelDbDocumentMutationKeyTest, Description) {
       "[document_mutation: user_id=user1 path=foo/bar batch_id=42]", key);
 }
 
+TEST(LevelDbCollectionMutationKeyTest, Prefixing) {
+  auto tableKey = LevelDbCollectionMutationKey::KeyPrefix();
+  auto fooUserKey = LevelDbCollectionMutationKey::KeyPrefix("foo");
+  auto fooCollectionKey = LevelDbCollectionMutationKey::KeyPrefix(
+      "foo", testutil::Resource("coll"));
+
+  ASSERT_TRUE(absl::StartsWith(fooUserKey, tableKey));
+  ASSERT_TRUE(absl::StartsWith(fooCollectionKey, fooUserKey));
+  ASSERT_TRUE(absl::StartsWith(CollectionMutationKey("foo", "coll", 2),
+                               fooCollectionKey));
+  ASSERT_FALSE(absl::StartsWith(CollectionMutationKey("foo", "coll2", 2),
+                                fooCollectionKey));
+}
+
+TEST(LevelDbCollectionMutationKeyTest, EncodeDecodeCycle) {
+  LevelDbCollectionMutationKey key;
+  const std::string user("foo");
+
+  std::vector<std::string> collections{"a", "a/b/c", "a/b/c/d/e"};
+  for (auto&& collection : collections) {
+    auto encoded = CollectionMutationKey(user, collection, 42);
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(user, key.user_id());
+    ASSERT_EQ(testutil::Resource(collection), key.collection_path());
+    ASSERT_EQ(42, key.batch_id());
+  }
+}
+
+TEST(LevelDbCollectionMutationKeyTest, Ordering) {
+  // Different batch_id:
+  ASSERT_LT(CollectionMutationKey("u", "coll", 1),
+            CollectionMutationKey("u", "coll", 2));
+  ASSERT_LT(CollectionMutationKey("u", "coll", 2),
+            CollectionMutationKey("u", "coll", 100));
+
+  // A collection's own rows sort before those of its subcollections, which
+  // sort before those of the next collection.
+  ASSERT_LT(CollectionMutationKey("u", "coll", 100),
+            CollectionMutationKey("u", "coll/a/sub", 1));
+  ASSERT_LT(CollectionMutationKey("u", "coll/a/sub", 1),
+            CollectionMutationKey("u", "coll2", 1));
+}
+
+TEST(LevelDbCollectionMutationKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[collection_mutation: user_id=user1 path=foo/bar/baz batch_id=42]",
+      CollectionMutationKey("user1", "foo/bar/baz", 42));
+}
+
 TEST(LevelDbTargetGlobalKeyTest, EncodeDecodeCycle) {
   LevelDbTargetGlobalKey key;
 
@@ -338,6 +474,22 @@ TEST(RemoteDocumentKeyTest, Ordering) {
   ASSERT_LT(RemoteDocKey("foo/bar"), RemoteDocKey("foo/bar/suffix/key"));
 }
 
+TEST(RemoteDocumentKeyTest, KeyPrefixEnd) {
+  auto end =
+      LevelDbRemoteDocumentKey::KeyPrefixEnd(testutil::Resource("foo/bar"));
+
+  // The document and everything in its subcollections sort before the end.
+  ASSERT_LT(RemoteDocKey("foo/bar"), end);
+  ASSERT_LT(RemoteDocKey("foo/bar/baz/quu"), end);
+  ASSERT_LT(RemoteDocKey("foo/bar/baz/quu/a/b"), end);
+
+  // Siblings, including those that have foo/bar as a string prefix, don't.
+  ASSERT_GT(RemoteDocKey("foo/bar2"), end);
+  ASSERT_GT(RemoteDocKey(std::string("foo/bar\0", 8)), end);
+  ASSERT_GT(RemoteDocKey("foo/bas"), end);
+  ASSERT_LT(RemoteDocKey("foo/baq"), RemoteDocKeyPrefix("foo/bar"));
+}
+
 TEST(RemoteDocumentKeyTest, EncodeDecodeCycle) {
   LevelDbRemoteDocumentKey key;
 
@@ -350,12 +502,321 @@ TEST(RemoteDocumentKeyTest, EncodeDecodeCycle) {
   }
 }
 
+TEST(RemoteDocumentKeyTest, DecodesViews) {
+  LevelDbRemoteDocumentKeyView key;
+
+  std::vector<std::string> paths{"foo/bar", "foo/bar2", "foo/bar/baz/quux"};
+  for (auto&& path : paths) {
+    auto encoded = RemoteDocKey(path);
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(testutil::Resource(path).size(), key.path().size());
+    ASSERT_EQ("foo", key.path()[0]);
+    ASSERT_TRUE(key.path().HasPrefix(testutil::Resource("foo")));
+    ASSERT_FALSE(key.path().HasPrefix(testutil::Resource("bar")));
+    ASSERT_EQ(testutil::Key(path), key.document_key());
+  }
+
+  // Collection paths aren't valid document keys.
+  ASSERT_FALSE(
+      key.Decode(LevelDbRemoteDocumentKey::KeyPrefix(testutil::Resource("a"))));
+}
+
 TEST(RemoteDocumentKeyTest, Description) {
   AssertExpectedKeyDescription(
       "[remote_document: path=foo/bar/baz/quux]",
       LevelDbRemoteDocumentKey::Key(testutil::Key("foo/bar/baz/quux")));
 }
 
+TEST(CollectionGroupDocumentKeyTest, EncodeDecodeCycle) {
+  LevelDbCollectionGroupDocumentKey key;
+
+  std::vector<std::string> paths{"messages/m", "rooms/a/messages/m",
+                                  "rooms/a/messages/m/x/y"};
+  for (auto&& path : paths) {
+    auto encoded = CollectionGroupDocKey(path);
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(testutil::Key(path).path().PopLast().last_segment(),
+              key.collection_id());
+    ASSERT_EQ(testutil::Key(path), key.document_key());
+  }
+}
+
+TEST(CollectionGroupDocumentKeyTest, Prefixing) {
+  auto table_key = LevelDbCollectionGroupDocumentKey::KeyPrefix();
+  auto messages_key = LevelDbCollectionGroupDocumentKey::KeyPrefix("messages");
+
+  ASSERT_TRUE(absl::StartsWith(messages_key, table_key));
+  ASSERT_TRUE(
+      absl::StartsWith(CollectionGroupDocKey("messages/m"), messages_key));
+  ASSERT_TRUE(absl::StartsWith(CollectionGroupDocKey("rooms/a/messages/m"),
+                               messages_key));
+  ASSERT_FALSE(
+      absl::StartsWith(CollectionGroupDocKey("messages2/m"), messages_key));
+  ASSERT_FALSE(absl::StartsWith(CollectionGroupDocKey("messages/m/x/y"),
+                                messages_key));
+}
+
+TEST(CollectionGroupDocumentKeyTest, Ordering) {
+  // Within a collection group, rows sort like the documents' own rows.
+  ASSERT_LT(CollectionGroupDocKey("a/b/messages/m"),
+            CollectionGroupDocKey("messages/m"));
+  ASSERT_LT(CollectionGroupDocKey("messages/m"),
+            CollectionGroupDocKey("rooms/a/messages/m"));
+  ASSERT_LT(CollectionGroupDocKey("rooms/a/messages/m"),
+            CollectionGroupDocKey("rooms/b/messages/a"));
+}
+
+TEST(CollectionGroupDocumentKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[collection_group_document: collection_id=baz path=foo/bar/baz/quux]",
+      CollectionGroupDocKey("foo/bar/baz/quux"));
+}
+
+TEST(RemoteDocumentReadTimeKeyTest, EncodeDecodeCycle) {
+  LevelDbRemoteDocumentReadTimeKey key;
+
+  std::vector<std::string> paths{"messages/m", "rooms/a/messages/m"};
+  for (auto&& path : paths) {
+    auto encoded = ReadTimeKey(path, 1234567);
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(testutil::Key(path).path().PopLast(), key.collection());
+    ASSERT_EQ(testutil::Version(1234567), key.read_time());
+    ASSERT_EQ(testutil::Key(path), key.document_key());
+  }
+}
+
+TEST(RemoteDocumentReadTimeKeyTest, Prefixing) {
+  auto table_key = LevelDbRemoteDocumentReadTimeKey::KeyPrefix();
+  auto messages_key =
+      LevelDbRemoteDocumentReadTimeKey::KeyPrefix(testutil::Resource("m"));
+  auto since_key = LevelDbRemoteDocumentReadTimeKey::KeyPrefix(
+      testutil::Resource("m"), testutil::Version(2));
+
+  ASSERT_TRUE(absl::StartsWith(messages_key, table_key));
+  ASSERT_TRUE(absl::StartsWith(ReadTimeKey("m/a", 1), messages_key));
+  ASSERT_FALSE(absl::StartsWith(ReadTimeKey("m2/a", 1), messages_key));
+
+  // Rows of subcollections share the prefix, but not the read time prefix.
+  ASSERT_TRUE(absl::StartsWith(ReadTimeKey("m/a/x/y", 2), messages_key));
+  ASSERT_FALSE(absl::StartsWith(ReadTimeKey("m/a/x/y", 2), since_key));
+
+  ASSERT_TRUE(absl::StartsWith(ReadTimeKey("m/a", 2), since_key));
+  ASSERT_FALSE(absl::StartsWith(ReadTimeKey("m/a", 3), since_key));
+}
+
+TEST(RemoteDocumentReadTimeKeyTest, Ordering) {
+  // Within a collection, rows sort by read time before document.
+  auto since_key = LevelDbRemoteDocumentReadTimeKey::KeyPrefix(
+      testutil::Resource("m"), testutil::Version(2));
+  ASSERT_LT(ReadTimeKey("m/z", 1), since_key);
+  ASSERT_LT(since_key, ReadTimeKey("m/a", 2));
+  ASSERT_LT(ReadTimeKey("m/a", 2), ReadTimeKey("m/b", 2));
+  ASSERT_LT(ReadTimeKey("m/b", 2), ReadTimeKey("m/a", 3));
+  ASSERT_LT(ReadTimeKey("m/a", 3), ReadTimeKey("m/a", 1000000));
+
+  // Rows of subcollections come after all the rows of the collection.
+  ASSERT_LT(ReadTimeKey("m/a", 1000000), ReadTimeKey("m/a/x/y", 1));
+}
+
+TEST(RemoteDocumentReadTimeKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[remote_document_read_time: path=foo read_time=Timestamp(seconds=1, "
+      "nanoseconds=2000) path=foo/bar]",
+      ReadTimeKey("foo/bar", 1000002));
+}
+
+TEST(DocumentReadTimeKeyTest, EncodeDecodeCycle) {
+  LevelDbDocumentReadTimeKey key;
+
+  auto encoded = LevelDbDocumentReadTimeKey::Key(testutil::Key("foo/bar"));
+  ASSERT_TRUE(key.Decode(encoded));
+  ASSERT_EQ(testutil::Key("foo/bar"), key.document_key());
+
+  std::vector<int64_t> versions{0, 1, 1000000, 1234567890123};
+  for (int64_t version : versions) {
+    std::string value =
+        LevelDbDocumentReadTimeKey::EncodeReadTime(testutil::Version(version));
+    ASSERT_EQ(testutil::Version(version),
+              LevelDbDocumentReadTimeKey::DecodeReadTime(value));
+  }
+}
+
+TEST(FieldIndexKeyTest, EncodeDecodeCycle) {
+  LevelDbFieldIndexKey key;
+
+  auto encoded = LevelDbFieldIndexKey::Key(testutil::Resource("foo/bar/baz"),
+                                           testutil::Field("a.b"));
+  bool ok = key.Decode(encoded);
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(testutil::Resource("foo/bar/baz"), key.collection());
+  ASSERT_EQ(testutil::Field("a.b"), key.field_path());
+}
+
+TEST(FieldIndexKeyTest, Prefixing) {
+  auto collection_prefix =
+      LevelDbFieldIndexKey::KeyPrefix(testutil::Resource("foo"));
+
+  ASSERT_TRUE(absl::StartsWith(
+      LevelDbFieldIndexKey::Key(testutil::Resource("foo"),
+                                testutil::Field("a")),
+      collection_prefix));
+  ASSERT_FALSE(absl::StartsWith(
+      LevelDbFieldIndexKey::Key(testutil::Resource("foo2"),
+                                testutil::Field("a")),
+      collection_prefix));
+
+  // Indexes on subcollections must sort after the collection's own indexes.
+  ASSERT_LT(LevelDbFieldIndexKey::Key(testutil::Resource("foo"),
+                                      testutil::Field("z")),
+            LevelDbFieldIndexKey::Key(testutil::Resource("foo/bar/baz"),
+                                      testutil::Field("a")));
+}
+
+TEST(FieldIndexKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[field_index: path=foo field_path=a.b]",
+      LevelDbFieldIndexKey::Key(testutil::Resource("foo"),
+                                testutil::Field("a.b")));
+}
+
+TEST(FieldIndexEntryKeyTest, EncodeDecodeCycle) {
+  LevelDbFieldIndexEntryKey key;
+
+  std::string value{"\x00value\xff", 7};
+  auto encoded = FieldIndexEntryKey("a.b", value, "foo/bar");
+  bool ok = key.Decode(encoded);
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(testutil::Resource("foo"), key.collection());
+  ASSERT_EQ(testutil::Field("a.b"), key.field_path());
+  ASSERT_EQ(value, key.encoded_value());
+  ASSERT_EQ(testutil::Key("foo/bar"), key.document_key());
+}
+
+TEST(FieldIndexEntryKeyTest, Prefixing) {
+  auto index_prefix = LevelDbFieldIndexEntryKey::KeyPrefix(
+      testutil::Resource("foo"), testutil::Field("a"));
+
+  ASSERT_TRUE(absl::StartsWith(FieldIndexEntryKey("a", "x", "foo/bar"),
+                               index_prefix));
+  ASSERT_TRUE(absl::StartsWith(FieldIndexEntryKey("a", "x", "foo/bar"),
+                               FieldIndexEntryKeyPrefix("foo", "a", "x")));
+
+  // Entries for other fields and for subcollections are outside the index.
+  ASSERT_FALSE(absl::StartsWith(FieldIndexEntryKey("ab", "x", "foo/bar"),
+                                index_prefix));
+  ASSERT_FALSE(absl::StartsWith(FieldIndexEntryKey("a", "x", "foo/bar/baz/qux"),
+                                index_prefix));
+
+  // A prefix of a value doesn't convert into a prefix of the key.
+  ASSERT_FALSE(absl::StartsWith(FieldIndexEntryKey("a", "xy", "foo/bar"),
+                                FieldIndexEntryKeyPrefix("foo", "a", "x")));
+}
+
+TEST(FieldIndexEntryKeyTest, Ordering) {
+  // Entries sort by value, then document.
+  ASSERT_LT(FieldIndexEntryKey("a", "x", "foo/bar"),
+            FieldIndexEntryKey("a", "xy", "foo/bar"));
+  ASSERT_LT(FieldIndexEntryKey("a", "x", "foo/baz"),
+            FieldIndexEntryKey("a", "y", "foo/bar"));
+  ASSERT_LT(FieldIndexEntryKey("a", "x", "foo/bar"),
+            FieldIndexEntryKey("a", "x", "foo/baz"));
+
+  // Seeking to a value prefix lands before all entries with that value.
+  ASSERT_LT(FieldIndexEntryKeyPrefix("foo", "a", "x"),
+            FieldIndexEntryKey("a", "x", "foo/bar"));
+  ASSERT_LT(FieldIndexEntryKey("a", "w", "foo/bar"),
+            FieldIndexEntryKeyPrefix("foo", "a", "x"));
+  ASSERT_LT(FieldIndexEntryKeyPrefix("foo", "a", ""),
+            FieldIndexEntryKey("a", "", "foo/bar"));
+}
+
+TEST(FieldIndexEntryKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[field_index_entry: path=foo field_path=a index_value=0a0b "
+      "path=foo/bar]",
+      FieldIndexEntryKey("a", "\x0a\x0b", "foo/bar"));
+}
+
+TEST(DocumentFieldIndexEntryKeyTest, EncodeDecodeCycle) {
+  LevelDbDocumentFieldIndexEntryKey key;
+
+  auto encoded = LevelDbDocumentFieldIndexEntryKey::Key(
+      testutil::Key("foo/bar"), testutil::Field("a.b"));
+  bool ok = key.Decode(encoded);
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(testutil::Key("foo/bar"), key.document_key());
+  ASSERT_EQ(testutil::Field("a.b"), key.field_path());
+}
+
+TEST(DocumentFieldIndexEntryKeyTest, Ordering) {
+  auto doc_prefix =
+      LevelDbDocumentFieldIndexEntryKey::KeyPrefix(testutil::Key("foo/bar"));
+
+  // A document's own entries sort before those of documents in its
+  // subcollections.
+  auto own = LevelDbDocumentFieldIndexEntryKey::Key(testutil::Key("foo/bar"),
+                                                    testutil::Field("z"));
+  auto nested = LevelDbDocumentFieldIndexEntryKey::Key(
+      testutil::Key("foo/bar/baz/qux"), testutil::Field("a"));
+  ASSERT_TRUE(absl::StartsWith(own, doc_prefix));
+  ASSERT_TRUE(absl::StartsWith(nested, doc_prefix));
+  ASSERT_LT(own, nested);
+}
+
+TEST(DocumentFieldIndexEntryKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[document_field_index_entry: path=foo/bar field_path=a.b]",
+      LevelDbDocumentFieldIndexEntryKey::Key(testutil::Key("foo/bar"),
+                                             testutil::Field("a.b")));
+}
+
+TEST(TablePrefixTest, SharedByKeysOfOneTable) {
+  std::string prefix = LevelDbRemoteDocumentKey::KeyPrefix();
+  ASSERT_EQ(TablePrefix(RemoteDocKey("foo/bar")), prefix);
+  ASSERT_EQ(TablePrefix(RemoteDocKey("foo/bar/baz/qux")), prefix);
+  ASSERT_EQ(TablePrefix(prefix), prefix);
+
+  ASSERT_NE(TablePrefix(LevelDbTargetKey::Key(42)), prefix);
+  ASSERT_TRUE(absl::StartsWith(LevelDbTargetKey::Key(42),
+                               TablePrefix(LevelDbTargetKey::Key(42))));
+  ASSERT_EQ(TablePrefix(""), "");
+  ASSERT_EQ(TablePrefix("not a key"), "");
+}
+
+TEST(AppendKeyTest, AppendsTheKey) {
+  DocumentKey document_key = testutil::Key("foo/bar");
+  SnapshotVersion read_time = testutil::Version(42);
+
+  std::string buffer = "prefix";
+  LevelDbRemoteDocumentKey::AppendKey(&buffer, document_key);
+  ASSERT_EQ(buffer, "prefix" + LevelDbRemoteDocumentKey::Key(document_key));
+
+  buffer.clear();
+  LevelDbCollectionGroupDocumentKey::AppendKey(&buffer, document_key);
+  ASSERT_EQ(buffer, LevelDbCollectionGroupDocumentKey::Key(document_key));
+
+  buffer.clear();
+  LevelDbRemoteDocumentReadTimeKey::AppendKey(&buffer, document_key,
+                                              read_time);
+  ASSERT_EQ(buffer,
+            LevelDbRemoteDocumentReadTimeKey::Key(document_key, read_time));
+
+  buffer.clear();
+  LevelDbDocumentReadTimeKey::AppendKey(&buffer, document_key);
+  ASSERT_EQ(buffer, LevelDbDocumentReadTimeKey::Key(document_key));
+
+  buffer.clear();
+  LevelDbTargetDocumentKey::AppendKey(&buffer, 42, document_key);
+  ASSERT_EQ(buffer, LevelDbTargetDocumentKey::Key(42, document_key));
+
+  buffer.clear();
+  LevelDbDocumentTargetKey::AppendKey(&buffer, document_key, 42);
+  ASSERT_EQ(buffer, LevelDbDocumentTargetKey::Key(document_key, 42));
+}
+
 #undef AssertExpectedKeyDescription
 
 }  // namespace local
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_options.h"
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+TEST(LevelDbOptionsTest, DefaultTuningKeepsLevelDbDefaults) {
+  LevelDbOptions tuned{api::PersistenceTuning{}};
+  const leveldb::Options& options = tuned.options();
+  leveldb::Options defaults;
+
+  EXPECT_TRUE(options.create_if_missing);
+  EXPECT_EQ(options.block_cache, nullptr);
+  EXPECT_EQ(options.write_buffer_size, defaults.write_buffer_size);
+  EXPECT_EQ(options.block_size, defaults.block_size);
+  EXPECT_EQ(options.filter_policy, nullptr);
+  EXPECT_EQ(options.compression, defaults.compression);
+  EXPECT_FALSE(tuned.write_options().sync);
+}
+
+TEST(LevelDbOptionsTest, AppliesTuning) {
+  api::PersistenceTuning tuning;
+  tuning.block_cache_size_bytes = 32 * 1024 * 1024;
+  tuning.write_buffer_size_bytes = 8 * 1024 * 1024;
+  tuning.block_size_bytes = 16 * 1024;
+  tuning.bloom_filter_bits_per_key = 10;
+  tuning.compression_enabled = false;
+  tuning.sync_writes_enabled = true;
+
+  LevelDbOptions tuned{tuning};
+  const leveldb::Options& options = tuned.options();
+
+  EXPECT_TRUE(options.create_if_missing);
+  EXPECT_NE(options.block_cache, nullptr);
+  EXPECT_EQ(options.write_buffer_size, 8u * 1024 * 1024);
+  EXPECT_EQ(options.block_size, 16u * 1024);
+  EXPECT_NE(options.filter_policy, nullptr);
+  EXPECT_EQ(options.compression, leveldb::kNoCompression);
+  EXPECT_TRUE(tuned.write_options().sync);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
 
+#include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
@@ -31,6 +32,22 @@ TEST(LevelDbUtilTest, ConvertsStatus) {
             ConvertStatus(leveldb::Status::IOError("")).code());
 }
 
+TEST(LevelDbUtilTest, SlicesReferToByteStrings) {
+  nanopb::ByteString bytes{"foo"};
+  leveldb::Slice slice = MakeSlice(bytes);
+
+  EXPECT_EQ(slice.data(), reinterpret_cast<const char*>(bytes.data()));
+  EXPECT_EQ(slice.size(), 3u);
+}
+
+TEST(LevelDbUtilTest, ByteStringsCopySlices) {
+  std::string value{"foo"};
+  nanopb::ByteString bytes = MakeByteString(leveldb::Slice{value});
+  value[0] = 'b';
+
+  EXPECT_EQ(bytes, nanopb::ByteString{"foo"});
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
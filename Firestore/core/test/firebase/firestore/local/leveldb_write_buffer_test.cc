@@ -0,0 +1,114 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/leveldb_write_buffer.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using Change = LevelDbWriteBuffer::Change;
+
+// Returns the keys of the buffer's changes in the order `Sorted()` returns
+// them, with a "-" in front of deleted ones.
+std::vector<std::string> SortedKeys(LevelDbWriteBuffer* buffer) {
+  std::vector<std::string> result;
+  for (const Change* change : buffer->Sorted()) {
+    result.push_back((change->deleted ? "-" : "") + change->key);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(LevelDbWriteBufferTest, FindsTheLatestChange) {
+  LevelDbWriteBuffer buffer;
+  EXPECT_EQ(buffer.Find("a"), nullptr);
+
+  buffer.Put("a", "1");
+  ASSERT_NE(buffer.Find("a"), nullptr);
+  EXPECT_EQ(buffer.Find("a")->value, "1");
+  EXPECT_FALSE(buffer.Find("a")->deleted);
+
+  buffer.Put("a", "2");
+  EXPECT_EQ(buffer.Find("a")->value, "2");
+
+  buffer.Delete("a");
+  EXPECT_TRUE(buffer.Find("a")->deleted);
+  EXPECT_EQ(buffer.Find("a")->value, "");
+
+  buffer.Delete("b");
+  EXPECT_TRUE(buffer.Find("b")->deleted);
+  EXPECT_EQ(buffer.size(), 2u);
+}
+
+TEST(LevelDbWriteBufferTest, SortsChangesAddedOutOfOrder) {
+  LevelDbWriteBuffer buffer;
+  buffer.Put("c", "");
+  buffer.Put("a", "");
+  buffer.Delete("b");
+  EXPECT_EQ(SortedKeys(&buffer), (std::vector<std::string>{"a", "-b", "c"}));
+
+  // Changes added after sorting are merged with the sorted ones.
+  buffer.Put("b", "");
+  buffer.Put("d", "");
+  buffer.Put("aa", "");
+  buffer.Delete("c");
+  EXPECT_EQ(SortedKeys(&buffer),
+            (std::vector<std::string>{"a", "aa", "b", "-c", "d"}));
+
+  buffer.Put("e", "");
+  EXPECT_EQ(SortedKeys(&buffer),
+            (std::vector<std::string>{"a", "aa", "b", "-c", "d", "e"}));
+}
+
+TEST(LevelDbWriteBufferTest, FindsLowerBounds) {
+  LevelDbWriteBuffer buffer;
+  buffer.Put("b", "");
+  buffer.Put("d", "");
+  EXPECT_EQ(buffer.LowerBound("a"), 0u);
+  EXPECT_EQ(buffer.LowerBound("b"), 0u);
+  EXPECT_EQ(buffer.LowerBound("c"), 1u);
+  EXPECT_EQ(buffer.LowerBound("e"), 2u);
+
+  buffer.Put("a", "");
+  EXPECT_EQ(buffer.LowerBound("b"), 1u);
+}
+
+TEST(LevelDbWriteBufferTest, Clears) {
+  LevelDbWriteBuffer buffer;
+  buffer.Put("a", "1");
+  buffer.Sorted();
+  buffer.Put("b", "2");
+  buffer.Clear();
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.Find("a"), nullptr);
+  EXPECT_TRUE(buffer.Sorted().empty());
+
+  buffer.Put("c", "3");
+  EXPECT_EQ(SortedKeys(&buffer), (std::vector<std::string>{"c"}));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -32,6 +32,7 @@
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/model/unknown_document.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
 #include "Firestore/core/src/firebase/firestore/remote/serializer.h"
@@ -286,6 +287,61 @@ TEST_F(LocalSerializerTest, EncodesDocumentAsMaybeDocument) {
   ExpectRoundTrip(doc, maybe_doc_proto, doc.type());
 }
 
+TEST_F(LocalSerializerTest, WrapsEncodedDocumentAsMaybeDocument) {
+  ::firestore::client::MaybeDocument maybe_doc_proto;
+  ::google::firestore::v1::Document* doc_proto =
+      maybe_doc_proto.mutable_document();
+  doc_proto->set_name("projects/p/databases/d/documents/some/path");
+  ::google::firestore::v1::Value value_proto;
+  value_proto.set_string_value("bar");
+  doc_proto->mutable_fields()->insert({"foo", value_proto});
+  doc_proto->mutable_update_time()->set_nanos(42000);
+
+  ByteString doc_bytes = ProtobufSerialize(*doc_proto);
+  std::string encoded = local::LocalSerializer::EncodeMaybeDocumentBytes(
+      nanopb::MakeStringView(doc_bytes), /*has_committed_mutations=*/false);
+  auto actual = ProtobufParse<::firestore::client::MaybeDocument>(
+      ByteString{absl::string_view{encoded}});
+  EXPECT_TRUE(msg_diff.Compare(maybe_doc_proto, actual)) << message_differences;
+
+  maybe_doc_proto.set_has_committed_mutations(true);
+  encoded = local::LocalSerializer::EncodeMaybeDocumentBytes(
+      nanopb::MakeStringView(doc_bytes), /*has_committed_mutations=*/true);
+  actual = ProtobufParse<::firestore::client::MaybeDocument>(
+      ByteString{absl::string_view{encoded}});
+  EXPECT_TRUE(msg_diff.Compare(maybe_doc_proto, actual)) << message_differences;
+}
+
+TEST_F(LocalSerializerTest, WrapsEncodedDocumentWithRelativeName) {
+  ::google::firestore::v1::Document doc_proto;
+  doc_proto.set_name("projects/p/databases/d/documents/some/path");
+  ::google::firestore::v1::Value value_proto;
+  value_proto.set_reference_value("projects/p/databases/d/documents/a/b");
+  doc_proto.mutable_fields()->insert({"foo", value_proto});
+  doc_proto.mutable_update_time()->set_nanos(42000);
+
+  ::firestore::client::MaybeDocument maybe_doc_proto;
+  *maybe_doc_proto.mutable_document() = doc_proto;
+  maybe_doc_proto.mutable_document()->set_name("documents/some/path");
+
+  ByteString doc_bytes = ProtobufSerialize(doc_proto);
+  std::string encoded = local::LocalSerializer::EncodeMaybeDocumentBytes(
+      nanopb::MakeStringView(doc_bytes), /*has_committed_mutations=*/false,
+      "projects/p/databases/d/");
+  auto actual = ProtobufParse<::firestore::client::MaybeDocument>(
+      ByteString{absl::string_view{encoded}});
+  EXPECT_TRUE(msg_diff.Compare(maybe_doc_proto, actual)) << message_differences;
+
+  // Documents from other databases keep their full name.
+  encoded = local::LocalSerializer::EncodeMaybeDocumentBytes(
+      nanopb::MakeStringView(doc_bytes), /*has_committed_mutations=*/false,
+      "projects/p/databases/other/");
+  actual = ProtobufParse<::firestore::client::MaybeDocument>(
+      ByteString{absl::string_view{encoded}});
+  maybe_doc_proto.mutable_document()->set_name(doc_proto.name());
+  EXPECT_TRUE(msg_diff.Compare(maybe_doc_proto, actual)) << message_differences;
+}
+
 TEST_F(LocalSerializerTest, EncodesNoDocumentAsMaybeDocument) {
   NoDocument no_doc = *DeletedDoc("some/path", /*version=*/42);
 
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/query_profile.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "absl/base/config.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using std::chrono::milliseconds;
+
+TEST(QueryProfileTest, AddsCountsAndTimes) {
+  QueryProfile first;
+  first.documents_scanned = 10;
+  first.documents_matched = 2;
+  first.decode_time = milliseconds(3);
+
+  QueryProfile second;
+  second.documents_scanned = 5;
+  second.mutation_batches_scanned = 1;
+  second.collection_parents_visited = 4;
+  second.view_diff_time = milliseconds(1);
+
+  first += second;
+  EXPECT_EQ(15u, first.documents_scanned);
+  EXPECT_EQ(2u, first.documents_matched);
+  EXPECT_EQ(1u, first.mutation_batches_scanned);
+  EXPECT_EQ(4u, first.collection_parents_visited);
+  EXPECT_EQ(milliseconds(3), first.decode_time);
+  EXPECT_EQ(milliseconds(1), first.view_diff_time);
+}
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+TEST(QueryProfileTest, ScopesNest) {
+  EXPECT_EQ(nullptr, QueryProfile::current());
+
+  QueryProfile outer;
+  QueryProfile inner;
+  {
+    QueryProfileScope outer_scope(&outer);
+    EXPECT_EQ(&outer, QueryProfile::current());
+    {
+      QueryProfileScope inner_scope(&inner);
+      EXPECT_EQ(&inner, QueryProfile::current());
+    }
+    EXPECT_EQ(&outer, QueryProfile::current());
+  }
+  EXPECT_EQ(nullptr, QueryProfile::current());
+}
+#endif
+
+TEST(QueryProfileTest, TotalsAccumulateProfiles) {
+  QueryProfileTotals totals;
+  EXPECT_EQ(QueryProfile{}, totals.Get());
+  EXPECT_EQ(0u, totals.query_count());
+
+  QueryProfile profile;
+  profile.documents_scanned = 3;
+  profile.documents_matched = 1;
+  totals.Add(profile);
+  totals.Add(profile);
+
+  QueryProfile expected;
+  expected.documents_scanned = 6;
+  expected.documents_matched = 2;
+  EXPECT_EQ(expected, totals.Get());
+  EXPECT_EQ(2u, totals.query_count());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
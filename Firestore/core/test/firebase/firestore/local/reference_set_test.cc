@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 
+#include <string>
+
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 
@@ -26,6 +28,7 @@ namespace firestore {
 namespace local {
 
 using model::DocumentKey;
+using model::DocumentKeySet;
 
 TEST(ReferenceSetTest, AddOrRemoveReferences) {
   DocumentKey key = testutil::Key("foo/bar");
@@ -79,6 +82,55 @@ TEST(ReferenceSetTest, RemoteAllReferencesForTargetId) {
   EXPECT_FALSE(referenceSet.ContainsKey(key3));
 }
 
+TEST(ReferenceSetTest, AddOrRemoveManyReferences) {
+  DocumentKeySet keys;
+  for (int i = 0; i < 100; ++i) {
+    keys = keys.insert(testutil::Key("foo/" + std::to_string(i)));
+  }
+  DocumentKey other = testutil::Key("foo/other");
+
+  ReferenceSet referenceSet{};
+  referenceSet.AddReference(other, 1);
+  referenceSet.AddReferences(keys, 1);
+  referenceSet.AddReferences(keys, 2);
+  EXPECT_EQ(201u, referenceSet.size());
+  EXPECT_EQ(keys.insert(other), referenceSet.ReferencedKeys(1));
+  EXPECT_EQ(keys, referenceSet.ReferencedKeys(2));
+
+  referenceSet.RemoveReferences(keys, 1);
+  EXPECT_EQ(DocumentKeySet{other}, referenceSet.ReferencedKeys(1));
+  EXPECT_EQ(keys, referenceSet.ReferencedKeys(2));
+
+  EXPECT_EQ(keys, referenceSet.RemoveReferences(2));
+  EXPECT_EQ(1u, referenceSet.size());
+  EXPECT_TRUE(referenceSet.ContainsKey(other));
+  EXPECT_FALSE(referenceSet.ContainsKey(*keys.begin()));
+
+  referenceSet.RemoveAllReferences();
+  EXPECT_TRUE(referenceSet.empty());
+}
+
+TEST(ReferenceSetTest, UpdatesReferencesForManyIds) {
+  DocumentKey a = testutil::Key("foo/a");
+  DocumentKey b = testutil::Key("foo/b");
+  DocumentKey c = testutil::Key("foo/c");
+
+  ReferenceSet referenceSet{};
+  referenceSet.AddReference(a, 1);
+  referenceSet.AddReference(b, 2);
+
+  // Unsorted, spanning several IDs, and with a duplicate.
+  referenceSet.UpdateReferences({{c, 2}, {a, 3}, {c, 1}, {c, 2}},
+                                {{b, 2}, {a, 1}, {b, 5}});
+  EXPECT_EQ(3u, referenceSet.size());
+  EXPECT_EQ(DocumentKeySet{c}, referenceSet.ReferencedKeys(1));
+  EXPECT_EQ(DocumentKeySet{c}, referenceSet.ReferencedKeys(2));
+  EXPECT_EQ(DocumentKeySet{a}, referenceSet.ReferencedKeys(3));
+  EXPECT_TRUE(referenceSet.ContainsKey(a));
+  EXPECT_FALSE(referenceSet.ContainsKey(b));
+  EXPECT_TRUE(referenceSet.ContainsKey(c));
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/target_key_index.h"
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DocumentKey;
+using model::DocumentKeySet;
+
+TEST(TargetKeyIndexTest, AddOrRemoveKeys) {
+  DocumentKey key = testutil::Key("foo/bar");
+
+  TargetKeyIndex index;
+  EXPECT_TRUE(index.empty());
+  EXPECT_FALSE(index.ContainsKey(key));
+
+  index.AddKeys(DocumentKeySet{key}, 1);
+  EXPECT_TRUE(index.ContainsKey(key));
+  EXPECT_FALSE(index.empty());
+
+  index.AddKeys(DocumentKeySet{key}, 2);
+  index.AddKeys(DocumentKeySet{key}, 2);
+  EXPECT_TRUE(index.ContainsKey(key));
+
+  index.RemoveKeys(DocumentKeySet{key}, 1);
+  EXPECT_TRUE(index.ContainsKey(key));
+
+  index.RemoveKeys(DocumentKeySet{key}, 3);
+  EXPECT_TRUE(index.ContainsKey(key));
+
+  index.RemoveKeys(DocumentKeySet{key}, 2);
+  EXPECT_FALSE(index.ContainsKey(key));
+  EXPECT_TRUE(index.empty());
+}
+
+TEST(TargetKeyIndexTest, ReturnsMatchingKeysInOrder) {
+  DocumentKey key1 = testutil::Key("foo/bar");
+  DocumentKey key2 = testutil::Key("foo/baz");
+  DocumentKey key3 = testutil::Key("foo/blah");
+
+  TargetKeyIndex index;
+  index.AddKeys(DocumentKeySet{key3, key1}, 1);
+  index.AddKeys(DocumentKeySet{key2}, 1);
+  index.AddKeys(DocumentKeySet{key2}, 2);
+
+  EXPECT_EQ((DocumentKeySet{key1, key2, key3}), index.MatchingKeys(1));
+  EXPECT_EQ(DocumentKeySet{key2}, index.MatchingKeys(2));
+  EXPECT_EQ(DocumentKeySet{}, index.MatchingKeys(3));
+}
+
+TEST(TargetKeyIndexTest, RemovesAllKeysForTarget) {
+  DocumentKey key1 = testutil::Key("foo/bar");
+  DocumentKey key2 = testutil::Key("foo/baz");
+  DocumentKey key3 = testutil::Key("foo/blah");
+
+  TargetKeyIndex index;
+  index.AddKeys(DocumentKeySet{key1, key2}, 1);
+  index.AddKeys(DocumentKeySet{key3}, 2);
+
+  EXPECT_EQ((DocumentKeySet{key1, key2}), index.RemoveTarget(1));
+  EXPECT_FALSE(index.ContainsKey(key1));
+  EXPECT_FALSE(index.ContainsKey(key2));
+  EXPECT_TRUE(index.ContainsKey(key3));
+  EXPECT_EQ(DocumentKeySet{}, index.MatchingKeys(1));
+  EXPECT_EQ(DocumentKeySet{}, index.RemoveTarget(1));
+}
+
+TEST(TargetKeyIndexTest, ReusesIdsOfRemovedKeys) {
+  DocumentKey key1 = testutil::Key("foo/bar");
+  DocumentKey key2 = testutil::Key("foo/baz");
+  DocumentKey key3 = testutil::Key("foo/blah");
+
+  TargetKeyIndex index;
+  index.AddKeys(DocumentKeySet{key1, key2}, 1);
+  index.RemoveKeys(DocumentKeySet{key1}, 1);
+  index.AddKeys(DocumentKeySet{key3}, 2);
+
+  EXPECT_EQ(DocumentKeySet{key2}, index.MatchingKeys(1));
+  EXPECT_EQ(DocumentKeySet{key3}, index.MatchingKeys(2));
+  EXPECT_FALSE(index.ContainsKey(key1));
+
+  index.AddKeys(DocumentKeySet{key1}, 2);
+  EXPECT_EQ((DocumentKeySet{key1, key3}), index.MatchingKeys(2));
+  EXPECT_EQ(DocumentKeySet{key2}, index.MatchingKeys(1));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+namespace {
+
+/** How DocumentKeyHash used to hash: over the segments, on every call. */
+struct SegmentsHash {
+  size_t operator()(const DocumentKey& key) const {
+    return util::Hash(key.path());
+  }
+};
+
+std::vector<DocumentKey> MakeKeys(int64_t count) {
+  std::vector<DocumentKey> result;
+  for (int64_t i = 0; i < count; ++i) {
+    result.push_back(DocumentKey::FromPathString(
+        absl::StrCat("projects/app/rooms/room", i % 16, "/messages/", i)));
+  }
+  return result;
+}
+
+template <typename Hasher>
+void BM_HashDocumentKey(benchmark::State& state) {
+  std::vector<DocumentKey> keys = MakeKeys(1024);
+  Hasher hasher;
+
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hasher(keys[index++ % keys.size()]));
+  }
+}
+BENCHMARK_TEMPLATE(BM_HashDocumentKey, DocumentKeyHash);
+BENCHMARK_TEMPLATE(BM_HashDocumentKey, SegmentsHash);
+
+/**
+ * Mirrors the bookkeeping WatchChangeAggregator does for each document
+ * change once it is tracking a target's documents: updates the document's
+ * pending state and checks whether the document already changed.
+ */
+template <typename Hasher>
+void BM_AggregateDocumentChanges(benchmark::State& state) {
+  std::vector<DocumentKey> keys = MakeKeys(state.range(0));
+  std::unordered_map<DocumentKey, int, Hasher> pending_updates;
+  std::unordered_set<DocumentKey, Hasher> changed;
+  for (const DocumentKey& key : keys) {
+    pending_updates[key] = 0;
+    changed.insert(key);
+  }
+
+  for (auto _ : state) {
+    for (const DocumentKey& key : keys) {
+      ++pending_updates[key];
+      benchmark::DoNotOptimize(changed.count(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_AggregateDocumentChanges, DocumentKeyHash)
+    ->Range(16, 16 << 10);
+BENCHMARK_TEMPLATE(BM_AggregateDocumentChanges, SegmentsHash)
+    ->Range(16, 16 << 10);
+
+/** How DocumentKey used to compare: over the segments of the paths. */
+struct SegmentsLess {
+  bool operator()(const DocumentKey& lhs, const DocumentKey& rhs) const {
+    return lhs.path() < rhs.path();
+  }
+};
+
+/** Compares distinct keys that share the first segments, as in a map. */
+template <typename Less>
+void BM_CompareDocumentKeys(benchmark::State& state) {
+  std::vector<DocumentKey> keys = MakeKeys(1024);
+  Less less;
+
+  size_t index = 0;
+  for (auto _ : state) {
+    const DocumentKey& lhs = keys[index % keys.size()];
+    const DocumentKey& rhs = keys[(index + 16) % keys.size()];
+    benchmark::DoNotOptimize(less(lhs, rhs));
+    ++index;
+  }
+}
+BENCHMARK_TEMPLATE(BM_CompareDocumentKeys, std::less<DocumentKey>);
+BENCHMARK_TEMPLATE(BM_CompareDocumentKeys, SegmentsLess);
+
+/** Builds a key from a path string, which now includes encoding it. */
+void BM_MakeDocumentKey(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        DocumentKey::FromPathString("projects/app/rooms/room1/messages/42"));
+  }
+}
+BENCHMARK(BM_MakeDocumentKey);
+
+}  // namespace
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
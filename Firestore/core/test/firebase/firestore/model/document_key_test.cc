@@ -23,6 +23,7 @@
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/hash/hash.h"
 #include "gtest/gtest.h"
 
 using firebase::firestore::testutil::Key;
@@ -83,6 +84,19 @@ TEST(DocumentKey, CopyAndMove) {
   EXPECT_EQ(path_string, key.path().CanonicalString());
 }
 
+TEST(DocumentKey, Hash) {
+  DocumentKey key = Key("rooms/firestore/messages/1");
+  EXPECT_EQ(key.Hash(), Key("rooms/firestore/messages/1").Hash());
+  EXPECT_NE(key.Hash(), Key("rooms/firestore/messages/2").Hash());
+  EXPECT_EQ(key.Hash(), key.path().Hash());
+  EXPECT_EQ(key.Hash(), DocumentKeyHash{}(key));
+  EXPECT_EQ(absl::Hash<DocumentKey>{}(key),
+            absl::Hash<DocumentKey>{}(Key("rooms/firestore/messages/1")));
+
+  DocumentKey moved = std::move(key);
+  EXPECT_EQ(DocumentKey{}.Hash(), key.Hash());  // NOLINT: use after move
+}
+
 TEST(DocumentKey, Constructor_StaticFactory) {
   const auto key_from_segments =
       DocumentKey::FromSegments({"rooms", "firestore", "messages", "1"});
@@ -159,6 +173,29 @@ TEST(DocumentKey, Comparator) {
   EXPECT_EQ(comparator.Compare(abcd, xyzw), util::ComparisonResult::Ascending);
 }
 
+TEST(DocumentKey, ComparesLikeItsPath) {
+  // Segments that are prefixes of each other, or contain the bytes the
+  // encoding escapes.
+  std::vector<std::string> segments{"",   "a",    std::string("a\0", 2),
+                                    "a0", "a\xff", std::string("\0", 1),
+                                    "ab", "b",    "\xff\xff"};
+  std::vector<DocumentKey> keys;
+  for (const std::string& first : segments) {
+    for (const std::string& second : segments) {
+      keys.push_back(DocumentKey::FromSegments({first, second}));
+      keys.push_back(DocumentKey::FromSegments({first, second, "c", "d"}));
+      keys.push_back(DocumentKey::FromSegments({first + second, "c"}));
+    }
+  }
+
+  for (const DocumentKey& lhs : keys) {
+    for (const DocumentKey& rhs : keys) {
+      EXPECT_EQ(lhs.CompareTo(rhs), lhs.path().CompareTo(rhs.path()))
+          << lhs.ToString() << " vs " << rhs.ToString();
+    }
+  }
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/field_path_cache.h"
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+TEST(FieldPathCache, ParsesLikeFieldPath) {
+  FieldPathCache cache;
+  EXPECT_EQ(cache.FromDotSeparatedString("foo"), FieldPath{"foo"});
+  EXPECT_EQ(cache.FromDotSeparatedString("foo.bar"), (FieldPath{"foo", "bar"}));
+  EXPECT_EQ(cache.FromDotSeparatedString("foo.bar"), (FieldPath{"foo", "bar"}));
+  EXPECT_EQ(2u, cache.size());
+}
+
+TEST(FieldPathCache, DoesNotCacheLongPaths) {
+  FieldPathCache cache;
+  std::string path(FieldPathCache::kMaxLength + 1, 'x');
+
+  EXPECT_EQ(cache.FromDotSeparatedString(path), FieldPath{path});
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(FieldPathCache, EvictsLeastRecentlyUsedPaths) {
+  FieldPathCache cache{1024};
+  (void)cache.FromDotSeparatedString("first");
+
+  for (int i = 0; i < 100; ++i) {
+    (void)cache.FromDotSeparatedString(absl::StrCat("field", i, ".nested"));
+  }
+
+  EXPECT_LT(cache.size(), 100u);
+  EXPECT_EQ(cache.FromDotSeparatedString("first"), FieldPath{"first"});
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 
@@ -113,6 +114,83 @@ BENCHMARK(BM_FieldValueStringFill)
     ->Arg(1 << 9)
     ->Arg(1 << 10);
 
+void BM_FieldValueStringCompare(benchmark::State& state) {
+  SecureRandom rnd;
+  auto len = static_cast<size_t>(state.range(0));
+  std::string str = RandomString(&rnd, len);
+
+  // Separately allocated values with equal contents, so that the comparison
+  // can't take the shortcut for shared contents.
+  FieldValue lhs = FieldValue::FromString(str);
+  FieldValue rhs = FieldValue::FromString(str);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs.CompareTo(rhs));
+  }
+}
+BENCHMARK(BM_FieldValueStringCompare)
+    ->Arg(1 << 2)
+    ->Arg(1 << 4)
+    ->Arg(1 << 6)
+    ->Arg(1 << 8)
+    ->Arg(1 << 10);
+
+void BM_FieldValueStringEquals(benchmark::State& state) {
+  SecureRandom rnd;
+  auto len = static_cast<size_t>(state.range(0));
+  std::string str = RandomString(&rnd, len);
+
+  FieldValue lhs = FieldValue::FromString(str);
+  FieldValue rhs = FieldValue::FromString(str);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs == rhs);
+  }
+}
+BENCHMARK(BM_FieldValueStringEquals)
+    ->Arg(1 << 2)
+    ->Arg(1 << 4)
+    ->Arg(1 << 6)
+    ->Arg(1 << 8)
+    ->Arg(1 << 10);
+
+void BM_FieldValueTimestampCompare(benchmark::State& state) {
+  FieldValue lhs = FieldValue::FromTimestamp(Timestamp(42, 1000));
+  FieldValue rhs = FieldValue::FromTimestamp(Timestamp(42, 2000));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs.CompareTo(rhs));
+  }
+}
+BENCHMARK(BM_FieldValueTimestampCompare);
+
+// Sorts values of mixed types, as ordering query results by a field does.
+void BM_FieldValueSort(benchmark::State& state) {
+  const int kValues = 1024;
+  SecureRandom rnd;
+
+  std::vector<FieldValue> input;
+  std::generate_n(std::back_inserter(input), kValues, [&]() -> FieldValue {
+    auto choice = rnd.Uniform(10);
+    if (choice < 3) {
+      return FieldValue::FromInteger(rnd.Uniform(1000));
+    } else if (choice < 8) {
+      return FieldValue::FromString(RandomString(&rnd, 16));
+    } else if (choice < 9) {
+      return FieldValue::FromDouble(rnd.Uniform(1000) / 7.0);
+    } else {
+      return FieldValue::FromTimestamp(Timestamp(rnd.Uniform(1000), 0));
+    }
+  });
+
+  for (auto _ : state) {
+    std::vector<FieldValue> values = input;
+    std::sort(values.begin(), values.end());
+  }
+  state.SetItemsProcessed(state.iterations() * kValues);
+}
+BENCHMARK(BM_FieldValueSort);
+
 using UserType = absl::variant<int64_t, double, std::string, Timestamp>;
 struct FromValueVisitor {
   FieldValue operator()(int64_t value) {
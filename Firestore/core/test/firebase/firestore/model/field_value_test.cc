@@ -23,12 +23,16 @@
 #include <chrono>  // NOLINT(build/c++11)
 #include <climits>
 #include <cmath>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/util/allocation_counter.h"
 #include "Firestore/core/test/firebase/firestore/testutil/equals_tester.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "Firestore/core/test/firebase/firestore/testutil/time_testing.h"
 #include "absl/base/casts.h"
+#include "absl/strings/str_cat.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -202,6 +206,52 @@ TEST(FieldValueTest, DeletesNestedKeys) {
   EXPECT_EQ(ObjectValue::Empty(), mod);
 }
 
+TEST(FieldValueTest, PatchesNestedFields) {
+  ObjectValue old = WrapObject("a", Map("b", 1, "c", Map("d", 2, "e", 3)),
+                               "f", 4, "g", 5);
+  ObjectValue values =
+      WrapObject("a", Map("b", 10, "c", Map("e", 30, "x", 40)), "h", 6);
+  FieldMask mask{Field("a.b"), Field("a.c.d"), Field("a.c.e"), Field("a.c.x"),
+                 Field("f"),   Field("g.y"),   Field("h"),     Field("i.j")};
+
+  ObjectValue mod = old.Patch(mask, values);
+  EXPECT_EQ(WrapObject("a", Map("b", 10, "c", Map("e", 30, "x", 40)), "g", 5,
+                       "h", 6),
+            mod);
+  EXPECT_EQ(WrapObject("a", Map("b", 1, "c", Map("d", 2, "e", 3)), "f", 4,
+                       "g", 5),
+            old);
+}
+
+TEST(FieldValueTest, PatchesLikeSetAndDelete) {
+  std::vector<ObjectValue> objects = {
+      ObjectValue::Empty(),
+      WrapObject("a", 1),
+      WrapObject("a", Map("b", 1, "c", 2), "d", 3),
+      WrapObject("a", Map("b", Map("c", 1)), "e", Map()),
+  };
+  std::vector<FieldMask> masks = {
+      FieldMask{Field("a")},
+      FieldMask{Field("a"), Field("a.b")},
+      FieldMask{Field("a.b"), Field("a.c"), Field("d")},
+      FieldMask{Field("a.b.c"), Field("a.z"), Field("e.f")},
+  };
+
+  for (const ObjectValue& old : objects) {
+    for (const ObjectValue& values : objects) {
+      for (const FieldMask& mask : masks) {
+        ObjectValue expected = old;
+        for (const FieldPath& path : mask) {
+          absl::optional<FieldValue> value = values.Get(path);
+          expected = value ? expected.Set(path, *value) : expected.Delete(path);
+        }
+        EXPECT_EQ(expected, old.Patch(mask, values))
+            << old << " patched with " << values << " at " << mask.ToString();
+      }
+    }
+  }
+}
+
 #if defined(_WIN32)
 #define timegm _mkgmtime
 
@@ -678,6 +728,41 @@ TEST(FieldValue, Copy) {
   EXPECT_EQ(FieldValue::Null(), clone);
 }
 
+TEST(FieldValue, CopiesShareHeapValues) {
+  FieldValue copy;
+  const std::string* contents = nullptr;
+  {
+    FieldValue original = FieldValue::FromString("a string too long for SSO");
+    contents = &original.string_value();
+
+    copy = original;
+    EXPECT_EQ(contents, &copy.string_value());
+  }
+
+  // The copy keeps the shared value alive after the original is destroyed.
+  EXPECT_EQ(contents, &copy.string_value());
+  EXPECT_EQ("a string too long for SSO", copy.string_value());
+
+  FieldValue moved = std::move(copy);
+  EXPECT_EQ(contents, &moved.string_value());
+}
+
+TEST(FieldValue, HashesOfContainersAreStable) {
+  FieldValue object = WrapObject("a", Array(1, "b"), "c", Map("d", 2.0));
+  FieldValue same = WrapObject("a", Array(1, "b"), "c", Map("d", 2.0));
+  FieldValue different = WrapObject("a", Array(1, "b"), "c", Map("d", 3.0));
+
+  size_t hash = object.Hash();
+  EXPECT_EQ(hash, object.Hash());
+  EXPECT_EQ(hash, same.Hash());
+  EXPECT_NE(hash, different.Hash());
+
+  // Equality still holds once hashes have been computed on both sides.
+  EXPECT_EQ(object, same);
+  EXPECT_NE(object, different);
+  EXPECT_EQ(Array(1, "b"), Array(1, "b"));
+}
+
 TEST(FieldValue, CompareMixedType) {
   const FieldValue null_value = FieldValue::Null();
   const FieldValue true_value = FieldValue::True();
@@ -737,6 +822,26 @@ TEST(FieldValue, IsSmallish) {
   EXPECT_LE(sizeof(FieldValue), 2 * sizeof(int64_t));
 }
 
+TEST(FieldValue, BuildsSmallObjectsWithinAllocationBudget) {
+  if (!util::AllocationCountingEnabled()) return;
+
+  std::vector<std::string> names;
+  for (int i = 0; i < 10; ++i) {
+    names.push_back(absl::StrCat("field", i));
+  }
+
+  // Decoding a document builds its fields this way, so every allocation added
+  // here is paid for each document a query reads.
+  util::AllocationCounter counter;
+  FieldValue::Map fields;
+  for (int i = 0; i < 10; ++i) {
+    fields = fields.insert(names[i], FieldValue::FromInteger(i));
+  }
+  ObjectValue object = ObjectValue::FromMap(std::move(fields));
+
+  EXPECT_LE(counter.allocations(), 12u);
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
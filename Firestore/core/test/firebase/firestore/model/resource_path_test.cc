@@ -18,8 +18,11 @@
 
 #include <initializer_list>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/util/allocation_counter.h"
+#include "absl/hash/hash.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
@@ -72,6 +75,55 @@ TEST(ResourcePath, Comparison) {
   EXPECT_TRUE(ab > a);
 }
 
+TEST(ResourcePath, Hash) {
+  const ResourcePath abc{"a", "b", "c"};
+  EXPECT_EQ(abc.Hash(), ResourcePath({"a", "b", "c"}).Hash());
+  EXPECT_EQ(abc.Hash(), absl::Hash<ResourcePath>{}(abc));
+
+  // Segment boundaries are part of the hash.
+  EXPECT_NE(abc.Hash(), ResourcePath({"ab", "c"}).Hash());
+  EXPECT_NE(abc.Hash(), ResourcePath({"a", "b"}).Hash());
+  EXPECT_NE(ResourcePath{}.Hash(), ResourcePath({""}).Hash());
+}
+
+TEST(ResourcePath, DerivedPathsShareSegments) {
+  const ResourcePath path{"rooms", "eros", "messages", "1"};
+
+  util::AllocationCounter counter;
+  ResourcePath parent = path.PopLast();
+  ResourcePath suffix = parent.PopFirst(2);
+  EXPECT_EQ(0u, counter.allocations());
+
+  EXPECT_EQ(ResourcePath({"rooms", "eros", "messages"}), parent);
+  EXPECT_EQ(ResourcePath({"messages"}), suffix);
+  EXPECT_EQ(ResourcePath({"messages"}).Hash(), suffix.Hash());
+  EXPECT_EQ("messages", suffix.first_segment());
+  EXPECT_EQ("messages", suffix.last_segment());
+  EXPECT_EQ(ResourcePath{}, suffix.PopLast());
+  EXPECT_EQ(ResourcePath{}.Hash(), suffix.PopLast().Hash());
+
+  // Appending to a derived path leaves the original alone.
+  EXPECT_EQ(ResourcePath({"rooms", "eros", "messages", "2"}),
+            parent.Append("2"));
+  EXPECT_EQ(ResourcePath({"messages", "rooms"}),
+            suffix.Append(ResourcePath{"rooms"}));
+  EXPECT_EQ(ResourcePath({"rooms", "eros", "messages", "1"}), path);
+}
+
+TEST(ResourcePath, MovedFromPathIsEmpty) {
+  ResourcePath path{"rooms", "eros"};
+  ResourcePath parent = path.PopLast();
+  ResourcePath moved = std::move(parent);
+
+  EXPECT_EQ(ResourcePath{"rooms"}, moved);
+  EXPECT_TRUE(parent.empty());  // NOLINT: use after move intended
+  EXPECT_EQ(parent.begin(), parent.end());
+
+  parent = std::move(moved);
+  EXPECT_EQ(ResourcePath{"rooms"}, parent);
+  EXPECT_TRUE(moved.empty());  // NOLINT: use after move intended
+}
+
 TEST(ResourcePath, Parsing) {
   const auto parse = [](const std::pair<std::string, size_t> expected) {
     const auto path = ResourcePath::FromString(expected.first);
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/string_interner.h"
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+TEST(StringInterner, SharesEqualStrings) {
+  StringInterner pool;
+  FieldValue first = pool.Intern("a string too long for SSO");
+  FieldValue second = pool.Intern(std::string{"a string too long for SSO"});
+
+  EXPECT_EQ(FieldValue::Type::String, first.type());
+  EXPECT_EQ(FieldValue::FromString("a string too long for SSO"), first);
+  EXPECT_EQ(&first.string_value(), &second.string_value());
+  EXPECT_EQ(1u, pool.size());
+
+  FieldValue other = pool.Intern("another string too long for SSO");
+  EXPECT_NE(first, other);
+  EXPECT_EQ(2u, pool.size());
+}
+
+TEST(StringInterner, DoesNotPoolLongStrings) {
+  StringInterner pool;
+  std::string value(StringInterner::kMaxLength + 1, 'x');
+
+  FieldValue first = pool.Intern(value);
+  FieldValue second = pool.Intern(value);
+  EXPECT_EQ(first, second);
+  EXPECT_NE(&first.string_value(), &second.string_value());
+  EXPECT_EQ(0u, pool.size());
+}
+
+TEST(StringInterner, EvictsLeastRecentlyUsedStrings) {
+  StringInterner pool{1024};
+  FieldValue first = pool.Intern("first");
+
+  for (int i = 0; i < 100; ++i) {
+    (void)pool.Intern(absl::StrCat("value", i));
+  }
+  EXPECT_LT(pool.size(), 100u);
+
+  // Values already handed out remain valid after eviction.
+  EXPECT_EQ("first", first.string_value());
+  EXPECT_EQ(FieldValue::FromString("first"), pool.Intern("first"));
+}
+
+TEST(StringInterner, ClearEmptiesPool) {
+  StringInterner pool;
+  FieldValue first = pool.Intern("value");
+
+  pool.Clear();
+  EXPECT_EQ(0u, pool.size());
+  EXPECT_EQ("value", first.string_value());
+
+  FieldValue second = pool.Intern("value");
+  EXPECT_NE(&first.string_value(), &second.string_value());
+}
+
+TEST(StringInterner, SharedPoolIsShared) {
+  EXPECT_EQ(&StringInterner::Shared(), &StringInterner::Shared());
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "absl/base/config.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+TEST(ArenaTest, AllocatesZeroedAlignedMemory) {
+  Arena arena;
+  for (size_t size : {1, 3, 8, 17, 100}) {
+    auto bytes = static_cast<uint8_t*>(arena.Allocate(size));
+    ASSERT_NE(bytes, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(bytes) % alignof(std::max_align_t),
+              0u);
+    for (size_t i = 0; i < size; ++i) {
+      EXPECT_EQ(bytes[i], 0);
+    }
+    std::memset(bytes, 0xff, size);
+  }
+}
+
+TEST(ArenaTest, ReturnsNullForEmptyAllocations) {
+  Arena arena;
+  EXPECT_EQ(arena.Allocate(0), nullptr);
+  EXPECT_EQ(arena.MakeBytesArray("", 0), nullptr);
+  EXPECT_EQ(arena.capacity(), 0u);
+}
+
+TEST(ArenaTest, GrowsForLargeAllocations) {
+  Arena arena;
+  arena.Allocate(16);
+  size_t initial = arena.capacity();
+  EXPECT_GT(initial, 0u);
+
+  std::string large(initial * 4, 'x');
+  pb_bytes_array_t* bytes = arena.MakeBytesArray(large.data(), large.size());
+  EXPECT_GE(arena.capacity(), initial + large.size());
+  ASSERT_EQ(bytes->size, large.size());
+  EXPECT_EQ(std::memcmp(bytes->bytes, large.data(), large.size()), 0);
+  EXPECT_EQ(bytes->bytes[large.size()], '\0');
+}
+
+TEST(ArenaTest, ScopesNest) {
+  EXPECT_EQ(Arena::current(), nullptr);
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  Arena outer;
+  Arena inner;
+  {
+    ArenaScope outer_scope{&outer};
+    EXPECT_EQ(Arena::current(), &outer);
+    {
+      ArenaScope inner_scope{&inner};
+      EXPECT_EQ(Arena::current(), &inner);
+    }
+    EXPECT_EQ(Arena::current(), &outer);
+  }
+  EXPECT_EQ(Arena::current(), nullptr);
+#endif
+}
+
+TEST(ArenaTest, AllocatorsUseTheCurrentArena) {
+  // Without an arena these come from the heap and must be freed individually.
+  void* array = AllocateArray(4, sizeof(int64_t));
+  pb_bytes_array_t* bytes = AllocateBytesArray("abc", 3);
+  ASSERT_NE(array, nullptr);
+  ASSERT_NE(bytes, nullptr);
+  std::free(array);
+  std::free(bytes);
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  Arena arena;
+  ArenaScope scope{&arena};
+  AllocateArray(4, sizeof(int64_t));
+  pb_bytes_array_t* arena_bytes = AllocateBytesArray("abc", 3);
+  EXPECT_GT(arena.capacity(), 0u);
+  EXPECT_EQ(std::string(reinterpret_cast<char*>(arena_bytes->bytes), 3), "abc");
+#endif
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
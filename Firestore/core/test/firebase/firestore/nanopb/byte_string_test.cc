@@ -137,6 +137,55 @@ TEST(ByteStringTest, Release) {
   std::free(released);
 }
 
+TEST(ByteStringTest, CopiesShareBytes) {
+  ByteString original{"foo"};
+  ByteString copy = original;
+  EXPECT_EQ(copy.get(), original.get());
+
+  ByteString assigned;
+  assigned = copy;
+  EXPECT_EQ(assigned.get(), original.get());
+
+  // The bytes outlive the original.
+  original = ByteString{};
+  EXPECT_THAT(copy, BytesEq("foo"));
+  EXPECT_THAT(assigned, BytesEq("foo"));
+}
+
+TEST(ByteStringTest, MovesLeaveTheSourceEmpty) {
+  ByteString original{"foo"};
+  const pb_bytes_array_t* bytes = original.get();
+
+  ByteString moved = std::move(original);
+  EXPECT_EQ(moved.get(), bytes);
+  EXPECT_EQ(original.get(), nullptr);  // NOLINT(bugprone-use-after-move)
+}
+
+TEST(ByteStringTest, ReleasesTakenBytesWithoutCopying) {
+  auto original =
+      static_cast<pb_bytes_array_t*>(malloc(PB_BYTES_ARRAY_T_ALLOCSIZE(3)));
+  memcpy(original->bytes, "foo", 3);
+  original->size = 3;
+
+  ByteString wrapper = ByteString::Take(original);
+  EXPECT_EQ(wrapper.release(), original);
+
+  std::free(original);
+}
+
+TEST(ByteStringTest, ReleaseCopiesSharedBytes) {
+  ByteString value{"foo"};
+  ByteString copy = value;
+
+  pb_bytes_array_t* released = value.release();
+  EXPECT_EQ(value.get(), nullptr);
+  EXPECT_NE(released, copy.get());
+  EXPECT_EQ(memcmp(released->bytes, "foo", 3), 0);
+  EXPECT_THAT(copy, BytesEq("foo"));
+
+  std::free(released);
+}
+
 TEST(ByteStringTest, Comparison) {
   ByteString abc{"abc"};
   ByteString def{"def"};
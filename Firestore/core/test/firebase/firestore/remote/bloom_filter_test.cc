@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+/** A 61-bit filter with 5 hashes holding "coll/doc1" through "coll/doc3". */
+BloomFilter ThreeDocumentFilter() {
+  return BloomFilter{{0x05, 0x26, 0x0A, 0x48, 0x54, 0x00, 0x60, 0x00}, 3, 5};
+}
+
+}  // namespace
+
+TEST(BloomFilterTest, EmptyFilterContainsNothing) {
+  BloomFilter filter;
+  EXPECT_EQ(filter.bit_count(), 0);
+  EXPECT_FALSE(filter.MightContain(""));
+  EXPECT_FALSE(filter.MightContain("coll/doc1"));
+
+  BloomFilter explicitly_empty{{}, 0, 0};
+  EXPECT_FALSE(explicitly_empty.MightContain("coll/doc1"));
+}
+
+TEST(BloomFilterTest, BitCountExcludesPadding) {
+  EXPECT_EQ(ThreeDocumentFilter().bit_count(), 61);
+  EXPECT_EQ((BloomFilter{{0xFF, 0xFF}, 7, 1}.bit_count()), 9);
+}
+
+TEST(BloomFilterTest, ContainsAddedValues) {
+  BloomFilter filter = ThreeDocumentFilter();
+  EXPECT_TRUE(filter.MightContain("coll/doc1"));
+  EXPECT_TRUE(filter.MightContain("coll/doc2"));
+  EXPECT_TRUE(filter.MightContain("coll/doc3"));
+}
+
+TEST(BloomFilterTest, DoesNotContainOtherValues) {
+  BloomFilter filter = ThreeDocumentFilter();
+  for (int i = 4; i <= 11; ++i) {
+    EXPECT_FALSE(filter.MightContain(absl::StrCat("coll/doc", i)));
+  }
+}
+
+TEST(BloomFilterTest, IgnoresPaddingBits) {
+  // Only the lowest bit is in use, so every value hashes to it.
+  EXPECT_TRUE((BloomFilter{{0x01}, 7, 3}.MightContain("coll/doc1")));
+  EXPECT_FALSE((BloomFilter{{0xFE}, 7, 3}.MightContain("coll/doc1")));
+}
+
+TEST(BloomFilterTest, Equality) {
+  EXPECT_EQ(ThreeDocumentFilter(), ThreeDocumentFilter());
+  EXPECT_NE(ThreeDocumentFilter(),
+            (BloomFilter{{0x05, 0x26, 0x0A, 0x48, 0x54, 0x00, 0x60, 0x00}, 3,
+                         4}));
+  EXPECT_NE(ThreeDocumentFilter(),
+            (BloomFilter{{0x05, 0x26, 0x0A, 0x48, 0x54, 0x00, 0x60, 0x00}, 2,
+                         5}));
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -243,6 +243,37 @@ TEST_F(DatastoreTest, LookupDocumentsTwoSuccessfulReads) {
 
 // gRPC errors
 
+TEST_F(DatastoreTest, LookupDocumentsIncrementallyDeliversEachDocument) {
+  std::vector<std::string> delivered_keys;
+  bool done = false;
+  Status resulting_status;
+  datastore->LookupDocumentsIncrementally(
+      {},
+      [&](FSTMaybeDocument* doc) {
+        delivered_keys.push_back(doc.key.ToString());
+      },
+      [&](const Status& status) {
+        done = true;
+        resulting_status = status;
+      });
+  // Make sure Auth has a chance to run.
+  worker_queue->EnqueueBlocking([] {});
+
+  ForceFinishAnyTypeOrder({{Type::Write, Ok},
+                           {Type::Read, MakeFakeDocument("foo/2")},
+                           {Type::Read, MakeFakeDocument("foo/1")},
+                           /*Read after last*/ {Type::Read, Error}});
+
+  // Documents are delivered in the order they arrive, before the call ends.
+  EXPECT_FALSE(done);
+  EXPECT_EQ(delivered_keys, (std::vector<std::string>{"foo/2", "foo/1"}));
+
+  ForceFinish({{Type::Finish, grpc::Status::OK}});
+
+  EXPECT_TRUE(done);
+  EXPECT_TRUE(resulting_status.ok());
+}
+
 TEST_F(DatastoreTest, CommitMutationsError) {
   bool done = false;
   Status resulting_status;
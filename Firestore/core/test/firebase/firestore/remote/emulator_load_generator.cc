@@ -0,0 +1,748 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A load generator that drives concurrent writers and listeners against the
+// Firestore emulator, through the gRPC layer the SDK uses, and reports
+// throughput, latency and resource usage.
+//
+// Start the emulator with `scripts/run_firestore_emulator.sh start`, then run
+// for example:
+//
+//   firebase_firestore_remote_emulator_load_generator
+//       --writers=8 --listeners=4 --duration=600 --leveldb_dir=/tmp/load
+//
+// Each writer commits one document at a time to a collection unique to the
+// run, and each listener watches that collection. Every document carries the
+// time it was sent, so listeners can measure how long a write takes to show
+// up in a snapshot. If `--leveldb_dir` is given, the documents the first
+// listener receives are stored in a LevelDB remote document cache, encoded
+// the way the SDK stores them, so that its size can be tracked over a soak.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
+#include "Firestore/core/src/firebase/firestore/auth/token.h"
+#include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_options.h"
+#include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/precondition.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/remote/connectivity_monitor.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_nanopb.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_stream.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_stream_observer.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_unary_call.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/autoid.h"
+#include "Firestore/core/src/firebase/firestore/util/bits.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "Firestore/core/test/firebase/firestore/util/create_noop_connectivity_monitor.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+#include "grpcpp/completion_queue.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
+#include "leveldb/db.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using auth::Token;
+using core::DatabaseInfo;
+using local::LevelDbOptions;
+using local::LevelDbRemoteDocumentKey;
+using local::LocalSerializer;
+using model::DatabaseId;
+using model::Document;
+using model::DocumentKey;
+using model::FieldPath;
+using model::FieldValue;
+using model::ObjectValue;
+using model::Precondition;
+using model::ResourcePath;
+using model::SetMutation;
+using nanopb::ByteString;
+using nanopb::ByteStringWriter;
+using nanopb::Reader;
+using util::AsyncQueue;
+using util::Bits;
+using util::ExecutorStd;
+using util::Path;
+using util::Status;
+using util::StatusOr;
+using util::StringFormat;
+
+const char* const kRpcNameCommit = "/google.firestore.v1.Firestore/Commit";
+const char* const kRpcNameListen = "/google.firestore.v1.Firestore/Listen";
+
+const char* const kSentMicrosField = "sent_micros";
+
+struct Options {
+  std::string host = "localhost:8080";
+  std::string project_id = "load-generator";
+  int writers = 4;
+  int listeners = 4;
+  int duration_seconds = 60;
+  int report_interval_seconds = 10;
+  int payload_bytes = 256;
+
+  // If not empty, documents received by the first listener are stored in a
+  // LevelDB database under this directory.
+  std::string leveldb_dir;
+};
+
+void PrintUsage(const char* program) {
+  std::fprintf(stderr,
+               "Usage: %s [--host=HOST:PORT] [--project=ID] [--writers=N] "
+               "[--listeners=M]\n"
+               "    [--duration=SECONDS] [--report_interval=SECONDS] "
+               "[--payload_bytes=N]\n"
+               "    [--leveldb_dir=DIR]\n"
+               "The host defaults to $FIRESTORE_EMULATOR_HOST, or "
+               "localhost:8080.\n",
+               program);
+}
+
+bool ParseInt(absl::string_view value, int min, int* result) {
+  return absl::SimpleAtoi(value, result) && *result >= min;
+}
+
+// Parses `--name=value` flags. Returns false on any unknown or malformed flag.
+bool ParseOptions(int argc, char** argv, Options* options) {
+  const char* emulator_host = std::getenv("FIRESTORE_EMULATOR_HOST");
+  if (emulator_host && *emulator_host) {
+    options->host = emulator_host;
+  }
+
+  for (int i = 1; i < argc; ++i) {
+    absl::string_view arg = argv[i];
+    size_t equals = arg.find('=');
+    if (!absl::StartsWith(arg, "--") || equals == absl::string_view::npos) {
+      return false;
+    }
+    absl::string_view name = arg.substr(2, equals - 2);
+    absl::string_view value = arg.substr(equals + 1);
+
+    bool ok = true;
+    if (name == "host") {
+      options->host = std::string{value};
+    } else if (name == "project") {
+      options->project_id = std::string{value};
+    } else if (name == "writers") {
+      ok = ParseInt(value, 0, &options->writers);
+    } else if (name == "listeners") {
+      ok = ParseInt(value, 0, &options->listeners);
+    } else if (name == "duration") {
+      ok = ParseInt(value, 1, &options->duration_seconds);
+    } else if (name == "report_interval") {
+      ok = ParseInt(value, 1, &options->report_interval_seconds);
+    } else if (name == "payload_bytes") {
+      ok = ParseInt(value, 0, &options->payload_bytes);
+    } else if (name == "leveldb_dir") {
+      options->leveldb_dir = std::string{value};
+    } else {
+      ok = false;
+    }
+    if (!ok) return false;
+  }
+  return !options->host.empty() && !options->project_id.empty();
+}
+
+// StringFormat only substitutes `%s`; numbers that need a precision go
+// through `snprintf`.
+std::string FormatDouble(const char* format, double value) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), format, value);
+  return buffer;
+}
+
+int64_t NowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * Counts latencies in buckets with a relative precision of 1/8: values below
+ * 8 get a bucket each, and each power of two above that is split into 8
+ * buckets. Unlike keeping every sample, the memory used doesn't grow over a
+ * soak, so it doesn't skew the memory high-water mark being measured.
+ */
+class LatencyHistogram {
+ public:
+  void Record(int64_t micros) {
+    uint64_t value = micros > 0 ? static_cast<uint64_t>(micros) : 0;
+    ++buckets_[BucketFor(value)];
+    ++count_;
+    max_ = std::max(max_, value);
+  }
+
+  void Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i != kBucketCount; ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    max_ = std::max(max_, other.max_);
+  }
+
+  uint64_t count() const {
+    return count_;
+  }
+
+  /**
+   * Returns an upper bound of the value below which `fraction` of the
+   * recorded values fall.
+   */
+  uint64_t Percentile(double fraction) const {
+    if (count_ == 0) return 0;
+
+    auto rank = static_cast<uint64_t>(fraction * static_cast<double>(count_));
+    rank = std::max<uint64_t>(1, std::min(rank, count_));
+    uint64_t seen = 0;
+    for (size_t i = 0; i != kBucketCount; ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        return std::min(BucketUpperBound(i), max_);
+      }
+    }
+    return max_;
+  }
+
+  /** Formats the usual percentiles, in milliseconds. */
+  std::string ToString() const {
+    if (count_ == 0) return "n/a";
+    return StringFormat("p50 %s p90 %s p99 %s max %s ms", Millis(0.5),
+                        Millis(0.9), Millis(0.99), Millis(1.0));
+  }
+
+ private:
+  static constexpr size_t kSubBucketBits = 3;
+  static constexpr size_t kSubBuckets = 1 << kSubBucketBits;
+  static constexpr size_t kBucketCount =
+      kSubBuckets + (64 - kSubBucketBits) * kSubBuckets;
+
+  static size_t BucketFor(uint64_t value) {
+    if (value < kSubBuckets) return static_cast<size_t>(value);
+
+    auto exponent = static_cast<size_t>(Bits::Log2FloorNonZero64(value));
+    size_t shift = exponent - kSubBucketBits;
+    size_t sub_bucket = static_cast<size_t>(value >> shift) - kSubBuckets;
+    return kSubBuckets + shift * kSubBuckets + sub_bucket;
+  }
+
+  static uint64_t BucketUpperBound(size_t bucket) {
+    if (bucket < kSubBuckets) return bucket;
+
+    size_t shift = (bucket - kSubBuckets) / kSubBuckets;
+    uint64_t sub_bucket = (bucket - kSubBuckets) % kSubBuckets;
+    uint64_t lower = (kSubBuckets + sub_bucket) << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+  }
+
+  std::string Millis(double fraction) const {
+    return FormatDouble("%.3g",
+                        static_cast<double>(Percentile(fraction)) / 1000.0);
+  }
+
+  std::array<uint64_t, kBucketCount> buckets_{};
+  uint64_t count_ = 0;
+  uint64_t max_ = 0;
+};
+
+struct Stats {
+  void Merge(const Stats& other) {
+    writes += other.writes;
+    write_failures += other.write_failures;
+    snapshot_changes += other.snapshot_changes;
+    commit_latency.Merge(other.commit_latency);
+    snapshot_latency.Merge(other.snapshot_latency);
+  }
+
+  uint64_t writes = 0;
+  uint64_t write_failures = 0;
+  uint64_t snapshot_changes = 0;
+  LatencyHistogram commit_latency;
+  LatencyHistogram snapshot_latency;
+};
+
+/** Returns the peak resident set size of the process, in bytes. */
+int64_t MaxResidentBytes() {
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+  return static_cast<int64_t>(usage.ru_maxrss);
+#else
+  // Linux reports kilobytes.
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+/** Returns the total size of the files directly in `dir`, in bytes. */
+int64_t DirectoryBytes(const Path& dir) {
+  int64_t total = 0;
+  std::unique_ptr<util::DirectoryIterator> iter =
+      util::DirectoryIterator::Create(dir);
+  for (; iter->Valid(); iter->Next()) {
+    // Files come and go as LevelDB compacts.
+    StatusOr<int64_t> size = util::FileSize(iter->file());
+    if (size.ok()) total += size.ValueOrDie();
+  }
+  return total;
+}
+
+std::string Mebibytes(int64_t bytes) {
+  return FormatDouble("%.1f MiB",
+                      static_cast<double>(bytes) / (1024.0 * 1024.0));
+}
+
+grpc::ByteBuffer MakeByteBuffer(const pb_field_t fields[], const void* src) {
+  ByteStringWriter writer;
+  writer.WriteNanopbMessage(fields, src);
+  ByteString bytes = writer.Release();
+  grpc::Slice slice{bytes.data(), bytes.size()};
+  return grpc::ByteBuffer{&slice, 1};
+}
+
+class LoadGenerator;
+
+/** Forwards the events of a listener's watch stream to the generator. */
+class Listener : public GrpcStreamObserver {
+ public:
+  Listener(LoadGenerator* generator, int id) : generator_{generator}, id_{id} {
+  }
+
+  void Start(GrpcConnection* connection) {
+    stream_ = connection->CreateStream(
+        kRpcNameListen, GrpcConnection::StreamKind::Watch,
+        Token::Unauthenticated(), this);
+    stream_->Start();
+  }
+
+  void OnStreamStart() override;
+  void OnStreamRead(const grpc::ByteBuffer& message) override;
+  void OnStreamFinish(const Status& status) override;
+
+ private:
+  LoadGenerator* generator_ = nullptr;
+  int id_ = 0;
+  std::unique_ptr<GrpcStream> stream_;
+};
+
+/**
+ * Runs the writers and listeners. Everything but `Run` happens on the worker
+ * queue, where the gRPC layer delivers its callbacks.
+ */
+class LoadGenerator {
+ public:
+  explicit LoadGenerator(const Options& options)
+      : options_{options},
+        database_id_{options.project_id, DatabaseId::kDefault},
+        database_name_{StringFormat("projects/%s/databases/%s",
+                                    database_id_.project_id(),
+                                    database_id_.database_id())},
+        run_id_{util::CreateAutoId()},
+        collection_{ResourcePath::FromString(
+            StringFormat("load_generator/%s/docs", run_id_))},
+        serializer_{database_id_},
+        payload_(static_cast<size_t>(options.payload_bytes), 'x'),
+        worker_queue_{
+            std::make_shared<AsyncQueue>(absl::make_unique<ExecutorStd>())},
+        connectivity_monitor_{util::CreateNoOpConnectivityMonitor()} {
+  }
+
+  /** Runs the load for the configured duration. Returns an exit code. */
+  int Run();
+
+  grpc::ByteBuffer MakeListenRequest() const;
+  void OnListenResponse(int listener, const grpc::ByteBuffer& message);
+  void OnListenerFinished(int listener, const Status& status);
+
+ private:
+  Status OpenLevelDb();
+
+  void CommitNext(int writer);
+  grpc::ByteBuffer MakeCommitRequest(int writer, int64_t sequence) const;
+  void RemoveCall(GrpcUnaryCall* call);
+
+  void PollGrpcQueue();
+  void Report(const char* label, const Stats& stats, double seconds);
+  void Shutdown();
+
+  Options options_;
+  DatabaseId database_id_;
+  std::string database_name_;
+  std::string run_id_;
+  ResourcePath collection_;
+  Serializer serializer_;
+  std::string payload_;
+
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  grpc::CompletionQueue grpc_queue_;
+  std::thread polling_thread_;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor_;
+  std::unique_ptr<GrpcConnection> connection_;
+
+  std::unique_ptr<leveldb::DB> db_;
+  std::unique_ptr<LevelDbOptions> db_options_;
+  Path db_path_;
+
+  // Only accessed on the worker queue.
+  bool stopping_ = false;
+  std::vector<std::unique_ptr<GrpcUnaryCall>> active_calls_;
+  std::vector<std::unique_ptr<Listener>> listeners_;
+  std::vector<int64_t> write_sequences_;
+  Stats interval_stats_;
+  Status first_error_;
+};
+
+void Listener::OnStreamStart() {
+  stream_->Write(generator_->MakeListenRequest());
+}
+
+void Listener::OnStreamRead(const grpc::ByteBuffer& message) {
+  generator_->OnListenResponse(id_, message);
+}
+
+void Listener::OnStreamFinish(const Status& status) {
+  generator_->OnListenerFinished(id_, status);
+}
+
+int LoadGenerator::Run() {
+  if (!options_.leveldb_dir.empty()) {
+    Status status = OpenLevelDb();
+    if (!status.ok()) {
+      std::fprintf(stderr, "Failed to open LevelDB: %s\n",
+                   status.ToString().c_str());
+      return 1;
+    }
+  }
+
+  GrpcConnection::UseInsecureChannel(options_.host);
+  DatabaseInfo database_info{database_id_, "load_generator", options_.host,
+                             /*ssl_enabled=*/false};
+  polling_thread_ = std::thread{[this] { PollGrpcQueue(); }};
+
+  std::printf("Running %d writers and %d listeners against %s for %ds\n",
+              options_.writers, options_.listeners, options_.host.c_str(),
+              options_.duration_seconds);
+
+  // Listeners start first, so that their initial (empty) snapshots are out of
+  // the way when the writes begin.
+  worker_queue_->EnqueueBlocking([&] {
+    connection_ = absl::make_unique<GrpcConnection>(
+        database_info, worker_queue_, &grpc_queue_,
+        connectivity_monitor_.get());
+    for (int i = 0; i != options_.listeners; ++i) {
+      listeners_.push_back(absl::make_unique<Listener>(this, i));
+      listeners_.back()->Start(connection_.get());
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+
+  worker_queue_->EnqueueBlocking([&] {
+    write_sequences_.resize(static_cast<size_t>(options_.writers));
+    for (int i = 0; i != options_.writers; ++i) {
+      CommitNext(i);
+    }
+  });
+
+  Stats total;
+  auto start = std::chrono::steady_clock::now();
+  auto interval_start = start;
+  auto end = start + std::chrono::seconds(options_.duration_seconds);
+  auto interval = std::chrono::seconds(options_.report_interval_seconds);
+  while (true) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= end) break;
+    std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(
+        interval - (now - interval_start), end - now));
+
+    now = std::chrono::steady_clock::now();
+    Stats stats;
+    worker_queue_->EnqueueBlocking(
+        [&] { std::swap(stats, interval_stats_); });
+    total.Merge(stats);
+
+    std::chrono::duration<double> elapsed = now - interval_start;
+    std::chrono::duration<double> since_start = now - start;
+    Report(FormatDouble("%4.0fs", since_start.count()).c_str(), stats,
+           elapsed.count());
+    interval_start = now;
+  }
+
+  Stats stats;
+  worker_queue_->EnqueueBlocking([&] { std::swap(stats, interval_stats_); });
+  total.Merge(stats);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  Report("total", total, elapsed.count());
+
+  Status first_error;
+  worker_queue_->EnqueueBlocking([&] {
+    first_error = first_error_;
+    Shutdown();
+  });
+  grpc_queue_.Shutdown();
+  polling_thread_.join();
+  db_.reset();
+
+  if (!first_error.ok()) {
+    std::fprintf(stderr, "Failed: %s\n", first_error.ToString().c_str());
+    return 1;
+  }
+  if (options_.writers > 0 && total.writes == 0) {
+    std::fprintf(stderr, "Failed: no writes were acknowledged\n");
+    return 1;
+  }
+  return 0;
+}
+
+Status LoadGenerator::OpenLevelDb() {
+  db_path_ = Path::FromUtf8(options_.leveldb_dir).AppendUtf8(run_id_);
+  Status status = util::RecursivelyCreateDir(db_path_);
+  if (!status.ok()) return status;
+
+  db_options_ = absl::make_unique<LevelDbOptions>(api::PersistenceTuning{});
+  leveldb::DB* db = nullptr;
+  leveldb::Status opened = leveldb::DB::Open(
+      db_options_->options(), db_path_.ToUtf8String(), &db);
+  if (!opened.ok()) {
+    return Status{Error::Internal, opened.ToString()};
+  }
+  db_.reset(db);
+  return Status::OK();
+}
+
+void LoadGenerator::CommitNext(int writer) {
+  if (stopping_) return;
+
+  int64_t sequence = ++write_sequences_[static_cast<size_t>(writer)];
+  std::unique_ptr<GrpcUnaryCall> call_owning = connection_->CreateUnaryCall(
+      kRpcNameCommit, Token::Unauthenticated(),
+      MakeCommitRequest(writer, sequence));
+  GrpcUnaryCall* call = call_owning.get();
+  active_calls_.push_back(std::move(call_owning));
+
+  int64_t started = NowMicros();
+  call->Start(
+      [this, call, writer, started](const StatusOr<grpc::ByteBuffer>& result) {
+        if (result.ok()) {
+          ++interval_stats_.writes;
+          interval_stats_.commit_latency.Record(NowMicros() - started);
+          RemoveCall(call);
+          CommitNext(writer);
+          return;
+        }
+
+        // The writer stops rather than retrying in a tight loop against an
+        // emulator that isn't there.
+        ++interval_stats_.write_failures;
+        LOG_WARN("Writer %s stopped: %s", writer, result.status().ToString());
+        if (first_error_.ok()) first_error_ = result.status();
+        RemoveCall(call);
+      });
+}
+
+grpc::ByteBuffer LoadGenerator::MakeCommitRequest(int writer,
+                                                  int64_t sequence) const {
+  DocumentKey key{collection_.Append(StringFormat("w%s-%s", writer, sequence))};
+  ObjectValue data = ObjectValue::FromMap({
+      {"writer", FieldValue::FromInteger(writer)},
+      {"sequence", FieldValue::FromInteger(sequence)},
+      {kSentMicrosField, FieldValue::FromInteger(NowMicros())},
+      {"payload", FieldValue::FromString(payload_)},
+  });
+  SetMutation mutation{std::move(key), std::move(data), Precondition::None()};
+
+  google_firestore_v1_CommitRequest request{};
+  request.database = Serializer::EncodeString(database_name_);
+  request.writes_count = 1;
+  request.writes = MakeArray<google_firestore_v1_Write>(1);
+  request.writes[0] = serializer_.EncodeMutation(mutation);
+
+  grpc::ByteBuffer result =
+      MakeByteBuffer(google_firestore_v1_CommitRequest_fields, &request);
+  Serializer::FreeNanopbMessage(google_firestore_v1_CommitRequest_fields,
+                                &request);
+  return result;
+}
+
+void LoadGenerator::RemoveCall(GrpcUnaryCall* call) {
+  auto found = std::find_if(
+      active_calls_.begin(), active_calls_.end(),
+      [call](const std::unique_ptr<GrpcUnaryCall>& active) {
+        return active.get() == call;
+      });
+  if (found != active_calls_.end()) {
+    active_calls_.erase(found);
+  }
+}
+
+grpc::ByteBuffer LoadGenerator::MakeListenRequest() const {
+  google_firestore_v1_ListenRequest request{};
+  request.database = Serializer::EncodeString(database_name_);
+  request.which_target_change =
+      google_firestore_v1_ListenRequest_add_target_tag;
+
+  google_firestore_v1_Target& target = request.add_target;
+  target.which_target_type = google_firestore_v1_Target_query_tag;
+  target.target_type.query =
+      serializer_.EncodeQueryTarget(core::Query{collection_});
+  target.target_id = 1;
+
+  grpc::ByteBuffer result =
+      MakeByteBuffer(google_firestore_v1_ListenRequest_fields, &request);
+  Serializer::FreeNanopbMessage(google_firestore_v1_ListenRequest_fields,
+                                &request);
+  return result;
+}
+
+void LoadGenerator::OnListenResponse(int listener,
+                                     const grpc::ByteBuffer& message) {
+  if (stopping_) return;
+
+  ByteBufferReader message_reader{message};
+  ByteString document_bytes =
+      Serializer::ReadDocumentChangeBytes(message_reader.reader());
+  if (!message_reader.reader()->status().ok() || document_bytes.size() == 0) {
+    // Target changes and the like.
+    return;
+  }
+
+  Reader reader{document_bytes};
+  std::unique_ptr<Document> document = serializer_.ReadDocument(&reader);
+  if (!reader.status().ok()) {
+    LOG_WARN("Listener %s failed to decode a document: %s", listener,
+             reader.status().ToString());
+    return;
+  }
+
+  ++interval_stats_.snapshot_changes;
+  absl::optional<FieldValue> sent =
+      document->field(FieldPath{kSentMicrosField});
+  if (sent && sent->type() == FieldValue::Type::Integer) {
+    interval_stats_.snapshot_latency.Record(NowMicros() -
+                                            sent->integer_value());
+  }
+
+  if (db_ && listener == 0) {
+    std::string name_prefix = database_name_ + "/";
+    db_->Put(db_options_->write_options(),
+             LevelDbRemoteDocumentKey::Key(document->key()),
+             LocalSerializer::EncodeMaybeDocumentBytes(
+                 absl::string_view{
+                     reinterpret_cast<const char*>(document_bytes.data()),
+                     document_bytes.size()},
+                 /*has_committed_mutations=*/false, name_prefix));
+  }
+}
+
+void LoadGenerator::OnListenerFinished(int listener, const Status& status) {
+  if (stopping_) return;
+
+  LOG_WARN("Listener %s stopped: %s", listener, status.ToString());
+  if (first_error_.ok()) {
+    first_error_ = status.ok() ? Status{Error::Unavailable,
+                                        "Watch stream closed by the server"}
+                               : status;
+  }
+}
+
+void LoadGenerator::PollGrpcQueue() {
+  void* tag = nullptr;
+  bool ok = false;
+  while (grpc_queue_.Next(&tag, &ok)) {
+    static_cast<GrpcCompletion*>(tag)->Complete(ok);
+  }
+}
+
+void LoadGenerator::Report(const char* label,
+                           const Stats& stats,
+                           double seconds) {
+  std::string leveldb_size =
+      db_ ? Mebibytes(DirectoryBytes(db_path_)) : std::string{"n/a"};
+  std::printf(
+      "[%s] writes %" PRIu64 " (%.1f/s, %" PRIu64 " failed) | commit %s | "
+      "snapshot changes %" PRIu64 ", latency %s | max rss %s | leveldb %s\n",
+      label, stats.writes,
+      seconds > 0 ? static_cast<double>(stats.writes) / seconds : 0.0,
+      stats.write_failures, stats.commit_latency.ToString().c_str(),
+      stats.snapshot_changes, stats.snapshot_latency.ToString().c_str(),
+      Mebibytes(MaxResidentBytes()).c_str(), leveldb_size.c_str());
+  std::fflush(stdout);
+}
+
+void LoadGenerator::Shutdown() {
+  stopping_ = true;
+  // Finishes all the calls and streams without notifying their observers.
+  connection_->Shutdown();
+  active_calls_.clear();
+  listeners_.clear();
+  connection_.reset();
+}
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+int main(int argc, char** argv) {
+  firebase::firestore::remote::Options options;
+  if (!firebase::firestore::remote::ParseOptions(argc, argv, &options)) {
+    firebase::firestore::remote::PrintUsage(argv[0]);
+    return 2;
+  }
+  firebase::firestore::remote::LoadGenerator generator{options};
+  return generator.Run();
+}
@@ -86,6 +86,36 @@ TEST_F(ExponentialBackoffTest, SequentialCallsToBackoffAndRun) {
   EXPECT_TRUE(WaitForTestToFinish());
 }
 
+TEST_F(ExponentialBackoffTest, DecorrelatedJitterSchedulesOperations) {
+  BackoffPolicy policy;
+  policy.backoff_factor = 3;
+  policy.initial_delay = chr::seconds{5};
+  policy.max_delay = chr::seconds{30};
+  policy.jitter = BackoffPolicy::Jitter::Decorrelated;
+  ExponentialBackoff decorrelated{queue, timer_id, policy};
+
+  queue->EnqueueBlocking([&] {
+    decorrelated.BackoffAndRun([] {});
+    decorrelated.BackoffAndRun([] {});
+    decorrelated.BackoffAndRun([&] { signal_finished(); });
+  });
+
+  queue->RunScheduledOperationsUntil(timer_id);
+  EXPECT_TRUE(WaitForTestToFinish());
+}
+
+TEST_F(ExponentialBackoffTest, ResetRunsNextOperationWithoutDelay) {
+  queue->EnqueueBlocking([&] {
+    backoff.BackoffAndRun([] {});
+    backoff.BackoffAndRun([] {});
+    backoff.Reset();
+    backoff.BackoffAndRun([&] { signal_finished(); });
+  });
+
+  // Unlike above, the operation runs without the timer being forced.
+  EXPECT_TRUE(WaitForTestToFinish());
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using util::AsyncQueue;
+using util::ExecutorStd;
+using util::MetricsRegistry;
+using Type = GrpcCompletion::Type;
+
+class GrpcCompletionPoolTest : public testing::Test {
+ public:
+  GrpcCompletionPoolTest()
+      : worker_queue{std::make_shared<AsyncQueue>(
+            absl::make_unique<ExecutorStd>())} {
+  }
+
+  // Takes the `completion` off the (imaginary) gRPC completion queue and waits
+  // for its callback to run.
+  void Complete(GrpcCompletion* completion) {
+    completion->Complete(true);
+    worker_queue->EnqueueBlocking([] {});
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue;
+};
+
+TEST_F(GrpcCompletionPoolTest, ReusesFinishedCompletions) {
+  auto pool = std::make_shared<GrpcCompletionPool>();
+  auto& allocated =
+      MetricsRegistry::Default().GetCounter("remote.grpc_completions_allocated");
+  auto& reused =
+      MetricsRegistry::Default().GetCounter("remote.grpc_completions_reused");
+  uint64_t allocated_before = allocated.value();
+  uint64_t reused_before = reused.value();
+
+  int calls = 0;
+  GrpcCompletion* first = pool->Acquire(
+      Type::Read, worker_queue,
+      [&](bool ok, const GrpcCompletion*) { calls += ok ? 1 : 0; });
+  Complete(first);
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(pool->free_count(), 1u);
+
+  GrpcCompletion* second = pool->Acquire(
+      Type::Write, worker_queue,
+      [&](bool ok, const GrpcCompletion*) { calls += ok ? 10 : 0; });
+  EXPECT_EQ(second, first);
+  EXPECT_EQ(second->type(), Type::Write);
+  EXPECT_EQ(pool->free_count(), 0u);
+  Complete(second);
+  EXPECT_EQ(calls, 11);
+
+  EXPECT_EQ(allocated.value() - allocated_before, 1u);
+  EXPECT_EQ(reused.value() - reused_before, 1u);
+}
+
+TEST_F(GrpcCompletionPoolTest, KeepsAtMostTheMaximumNumberOfCompletions) {
+  auto pool = std::make_shared<GrpcCompletionPool>(1);
+
+  GrpcCompletion* first = pool->Acquire(Type::Read, worker_queue, {});
+  GrpcCompletion* second = pool->Acquire(Type::Read, worker_queue, {});
+  Complete(first);
+  Complete(second);
+
+  EXPECT_EQ(pool->free_count(), 1u);
+}
+
+TEST_F(GrpcCompletionPoolTest, CompletionsOutliveThePool) {
+  auto pool = std::make_shared<GrpcCompletionPool>();
+  std::weak_ptr<GrpcCompletionPool> weak_pool = pool;
+
+  bool called = false;
+  GrpcCompletion* completion = pool->Acquire(
+      Type::Finish, worker_queue,
+      [&](bool, const GrpcCompletion*) { called = true; });
+  pool.reset();
+  EXPECT_FALSE(weak_pool.expired());
+
+  Complete(completion);
+  EXPECT_TRUE(called);
+  EXPECT_TRUE(weak_pool.expired());
+}
+
+TEST_F(GrpcCompletionPoolTest, ReusedCompletionsCanBeWaitedOn) {
+  auto pool = std::make_shared<GrpcCompletionPool>();
+  Complete(pool->Acquire(Type::Read, worker_queue, {}));
+
+  GrpcCompletion* completion = pool->Acquire(Type::Read, worker_queue, {});
+  worker_queue->EnqueueBlocking([&] {
+    EXPECT_EQ(completion->WaitUntilOffQueue(std::chrono::milliseconds(1)),
+              std::future_status::timeout);
+  });
+  Complete(completion);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -55,6 +55,10 @@ class FakeConnectivityMonitor : public ConnectivityMonitor {
   void set_status(NetworkStatus new_status) {
     MaybeInvokeCallbacks(new_status);
   }
+
+  void EnterForeground() {
+    InvokeForegroundCallbacks();
+  }
 };
 
 bool IsConnectivityChange(const Status& status) {
@@ -185,6 +189,62 @@ TEST_F(GrpcConnectionTest, ConnectivityChangeWithSeveralActiveCalls) {
   EXPECT_EQ(changes_count, 3);
 }
 
+TEST_F(GrpcConnectionTest, ReturningToForegroundKeepsActiveCalls) {
+  ConnectivityObserver observer;
+
+  std::unique_ptr<GrpcStream> stream = tester.CreateStream(&observer);
+  stream->Start();
+
+  tester.KeepPollingGrpcQueue();
+  worker_queue->EnqueueBlocking(
+      [&] { connectivity_monitor->EnterForeground(); });
+  EXPECT_EQ(observer.connectivity_change_count(), 0);
+
+  SetNetworkStatus(NetworkStatus::Unavailable);
+  EXPECT_EQ(observer.connectivity_change_count(), 1);
+}
+
+TEST_F(GrpcConnectionTest, NotifiesWhenNetworkBecomesAvailable) {
+  int available_count = 0;
+  worker_queue->EnqueueBlocking([&] {
+    tester.grpc_connection()->AddNetworkAvailableCallback(
+        [&] { ++available_count; });
+  });
+
+  SetNetworkStatus(NetworkStatus::Unavailable);
+  EXPECT_EQ(available_count, 0);
+
+  SetNetworkStatus(NetworkStatus::Available);
+  EXPECT_EQ(available_count, 1);
+
+  SetNetworkStatus(NetworkStatus::AvailableViaCellular);
+  EXPECT_EQ(available_count, 2);
+}
+
+TEST_F(GrpcConnectionTest, CompressesStreamsAndLookupsWhenEnabled) {
+  ConnectivityObserver observer;
+  std::unique_ptr<GrpcStream> uncompressed = tester.CreateStream(&observer);
+  EXPECT_EQ(uncompressed->context()->compression_algorithm(),
+            GRPC_COMPRESS_NONE);
+
+  CompressionPolicy policy;
+  policy.algorithm = CompressionPolicy::Algorithm::Gzip;
+  tester.grpc_connection()->set_compression_policy(policy);
+
+  std::unique_ptr<GrpcStream> stream = tester.CreateStream(&observer);
+  EXPECT_EQ(stream->context()->compression_algorithm(), GRPC_COMPRESS_GZIP);
+  std::unique_ptr<GrpcStreamingReader> reader = tester.CreateStreamingReader();
+  EXPECT_EQ(reader->context()->compression_algorithm(), GRPC_COMPRESS_GZIP);
+  std::unique_ptr<GrpcUnaryCall> unary_call = tester.CreateUnaryCall();
+  EXPECT_EQ(unary_call->context()->compression_algorithm(),
+            GRPC_COMPRESS_NONE);
+
+  uncompressed->FinishImmediately();
+  stream->FinishImmediately();
+  reader->FinishImmediately();
+  unary_call->FinishImmediately();
+}
+
 TEST_F(GrpcConnectionTest, ShutdownFastFinishesActiveCalls) {
   class NoFinishObserver : public GrpcStreamObserver {
    public:
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_nanopb.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "absl/memory/memory.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/slice.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using model::FieldValue;
+using nanopb::ByteString;
+using nanopb::ByteStringWriter;
+
+namespace {
+
+FieldValue MakeValue() {
+  return FieldValue::FromMap({
+      {"a", FieldValue::FromString("a string long enough to span slices")},
+      {"b", FieldValue::FromArray({FieldValue::FromInteger(42),
+                                   FieldValue::FromDouble(1.5)})},
+      {"c", FieldValue::True()},
+  });
+}
+
+ByteString Encode(const FieldValue& value) {
+  ByteStringWriter writer;
+  Serializer::WriteFieldValue(&writer, value);
+  return writer.Release();
+}
+
+/** Splits `bytes` into a ByteBuffer with slices of at most `slice_size`. */
+grpc::ByteBuffer MakeByteBuffer(const ByteString& bytes, size_t slice_size) {
+  std::vector<grpc::Slice> slices;
+  for (size_t i = 0; i < bytes.size(); i += slice_size) {
+    size_t size = std::min(slice_size, bytes.size() - i);
+    slices.emplace_back(bytes.data() + i, size);
+  }
+  return grpc::ByteBuffer{slices.data(), slices.size()};
+}
+
+}  // namespace
+
+TEST(ByteBufferReaderTest, ReadsSingleSlice) {
+  FieldValue value = MakeValue();
+  ByteString bytes = Encode(value);
+  grpc::ByteBuffer buffer = MakeByteBuffer(bytes, bytes.size());
+
+  ByteBufferReader reader{buffer};
+  FieldValue actual = Serializer::ReadFieldValue(reader.reader());
+  EXPECT_TRUE(reader.reader()->status().ok());
+  EXPECT_EQ(value, actual);
+}
+
+TEST(ByteBufferReaderTest, ReadsAcrossSliceBoundaries) {
+  FieldValue value = MakeValue();
+  ByteString bytes = Encode(value);
+
+  for (size_t slice_size = 1; slice_size < bytes.size(); ++slice_size) {
+    grpc::ByteBuffer buffer = MakeByteBuffer(bytes, slice_size);
+
+    ByteBufferReader reader{buffer};
+    FieldValue actual = Serializer::ReadFieldValue(reader.reader());
+    EXPECT_TRUE(reader.reader()->status().ok()) << "slice size " << slice_size;
+    EXPECT_EQ(value, actual) << "slice size " << slice_size;
+  }
+}
+
+TEST(ByteBufferReaderTest, OutlivesTheByteBuffer) {
+  FieldValue value = MakeValue();
+  ByteString bytes = Encode(value);
+
+  auto buffer = absl::make_unique<grpc::ByteBuffer>(MakeByteBuffer(bytes, 7));
+  ByteBufferReader reader{*buffer};
+  buffer.reset();
+
+  EXPECT_EQ(value, Serializer::ReadFieldValue(reader.reader()));
+}
+
+TEST(ByteBufferReaderTest, FailsOnTruncatedInput) {
+  ByteString bytes = Encode(MakeValue());
+  ByteString truncated{bytes.data(), bytes.size() - 1};
+  grpc::ByteBuffer buffer = MakeByteBuffer(truncated, 5);
+
+  ByteBufferReader reader{buffer};
+  Serializer::ReadFieldValue(reader.reader());
+  EXPECT_FALSE(reader.reader()->status().ok());
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
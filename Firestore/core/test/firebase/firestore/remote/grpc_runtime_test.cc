@@ -0,0 +1,109 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_runtime.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "absl/memory/memory.h"
+#include "grpcpp/alarm.h"
+#include "grpcpp/create_channel.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using util::AsyncQueue;
+using util::ExecutorStd;
+
+namespace {
+
+std::shared_ptr<grpc::Channel> CreateTestChannel() {
+  return grpc::CreateChannel("localhost:1",
+                             grpc::InsecureChannelCredentials());
+}
+
+}  // namespace
+
+class GrpcRuntimeTest : public testing::Test {
+ public:
+  GrpcRuntimeTest()
+      : worker_queue{std::make_shared<AsyncQueue>(
+            absl::make_unique<ExecutorStd>())},
+        runtime{absl::make_unique<ExecutorStd>()} {
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue;
+  GrpcRuntime runtime;
+};
+
+TEST_F(GrpcRuntimeTest, SharesChannelsWithTheSameKey) {
+  int created = 0;
+  auto create = [&] {
+    ++created;
+    return CreateTestChannel();
+  };
+
+  auto first = runtime.FindOrCreateChannel("host|0", create);
+  auto second = runtime.FindOrCreateChannel("host|0", create);
+  auto other = runtime.FindOrCreateChannel("host|1", create);
+
+  EXPECT_EQ(first, second);
+  EXPECT_NE(first, other);
+  EXPECT_EQ(created, 2);
+}
+
+TEST_F(GrpcRuntimeTest, RecreatesChannelsNoLongerInUse) {
+  int created = 0;
+  auto create = [&] {
+    ++created;
+    return CreateTestChannel();
+  };
+
+  runtime.FindOrCreateChannel("host|0", create);
+  auto channel = runtime.FindOrCreateChannel("host|0", create);
+
+  EXPECT_EQ(created, 2);
+  EXPECT_EQ(runtime.FindOrCreateChannel("host|0", create), channel);
+  EXPECT_EQ(created, 2);
+}
+
+TEST_F(GrpcRuntimeTest, CompletesOperationsOnTheWorkerQueue) {
+  std::promise<bool> done;
+  auto completion = new GrpcCompletion(
+      GrpcCompletion::Type::Finish, worker_queue,
+      [&](bool ok, const GrpcCompletion*) {
+        worker_queue->VerifyIsCurrentQueue();
+        done.set_value(ok);
+      });
+
+  grpc::Alarm alarm;
+  alarm.Set(runtime.grpc_queue(), gpr_now(GPR_CLOCK_MONOTONIC), completion);
+
+  auto result = done.get_future();
+  ASSERT_EQ(result.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+  EXPECT_TRUE(result.get());
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -163,6 +163,43 @@ class GrpcStreamTest : public testing::Test {
   std::unique_ptr<GrpcStream> stream;
 };
 
+// BufferedWriter
+
+TEST(BufferedWriterTest, StartsWriteImmediatelyIfNoneIsActive) {
+  internal::BufferedWriter writer;
+  auto write = writer.EnqueueWrite(MakeByteBuffer("foo"));
+  ASSERT_TRUE(write);
+  EXPECT_EQ(ByteBufferToString(write->message), "foo");
+  EXPECT_FALSE(write->options.get_buffer_hint());
+
+  EXPECT_FALSE(writer.EnqueueWrite(MakeByteBuffer("bar")));
+  auto next = writer.DequeueNextWrite();
+  ASSERT_TRUE(next);
+  EXPECT_EQ(ByteBufferToString(next->message), "bar");
+  EXPECT_FALSE(next->options.get_buffer_hint());
+
+  EXPECT_FALSE(writer.DequeueNextWrite());
+}
+
+TEST(BufferedWriterTest, HintsToBufferAllButLastQueuedWrite) {
+  internal::BufferedWriter writer;
+  ASSERT_TRUE(writer.EnqueueWrite(MakeByteBuffer("a")));
+  EXPECT_FALSE(writer.EnqueueWrite(MakeByteBuffer("b")));
+  EXPECT_FALSE(writer.EnqueueWrite(MakeByteBuffer("c")));
+
+  auto b = writer.DequeueNextWrite();
+  ASSERT_TRUE(b);
+  EXPECT_EQ(ByteBufferToString(b->message), "b");
+  EXPECT_TRUE(b->options.get_buffer_hint());
+
+  auto c = writer.DequeueNextWrite();
+  ASSERT_TRUE(c);
+  EXPECT_EQ(ByteBufferToString(c->message), "c");
+  EXPECT_FALSE(c->options.get_buffer_hint());
+
+  EXPECT_FALSE(writer.DequeueNextWrite());
+}
+
 // API usage
 
 TEST_F(GrpcStreamTest, FinishIsIdempotent) {
@@ -16,6 +16,7 @@
 
 #include <initializer_list>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -184,6 +185,36 @@ TEST_F(GrpcStreamingReaderTest, TwoSuccessfulReads) {
   EXPECT_EQ(ByteBufferToString(responses[1]), std::string{"bar"});
 }
 
+TEST_F(GrpcStreamingReaderTest, DeliversResponsesAsTheyArrive) {
+  std::vector<std::string> messages;
+  worker_queue->EnqueueBlocking([&] {
+    reader->Start(
+        [&](const grpc::ByteBuffer& message) {
+          messages.push_back(ByteBufferToString(message));
+        },
+        [&](const Status& result) { status = result; });
+  });
+
+  ForceFinishAnyTypeOrder({
+      {Type::Write, CompletionResult::Ok},
+      {Type::Read, MakeByteBuffer("foo")},
+  });
+  worker_queue->EnqueueBlocking([] {});
+  EXPECT_EQ(messages, std::vector<std::string>{"foo"});
+  EXPECT_FALSE(status.has_value());
+
+  ForceFinishAnyTypeOrder({
+      {Type::Read, MakeByteBuffer("bar")},
+      /*Read after last*/ {Type::Read, CompletionResult::Error},
+  });
+  ForceFinish({{Type::Finish, grpc::Status::OK}});
+
+  ASSERT_TRUE(status.has_value());
+  EXPECT_EQ(status.value(), Status::OK());
+  EXPECT_EQ(messages, (std::vector<std::string>{"foo", "bar"}));
+  EXPECT_TRUE(responses.empty());
+}
+
 TEST_F(GrpcStreamingReaderTest, FinishWhileReading) {
   StartReader();
 
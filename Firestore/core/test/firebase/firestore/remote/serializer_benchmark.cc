@@ -0,0 +1,448 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/util/allocation_counter.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using model::DatabaseId;
+using model::Document;
+using model::DocumentKey;
+using model::FieldValue;
+using model::MaybeDocument;
+using model::ObjectValue;
+using nanopb::ByteString;
+using nanopb::ByteStringWriter;
+using nanopb::Reader;
+using util::AllocationCounter;
+using util::AllocationCountingEnabled;
+
+/**
+ * Reports the heap allocations made per iteration, when the build counts
+ * them (see allocation_counter.h).
+ */
+void SetAllocationCounters(benchmark::State& state,
+                           const AllocationCounter& counter) {
+  if (!AllocationCountingEnabled()) return;
+
+  state.counters["allocs"] = benchmark::Counter(
+      counter.allocations(), benchmark::Counter::kAvgIterations);
+  state.counters["alloc_bytes"] = benchmark::Counter(
+      counter.allocated_bytes(), benchmark::Counter::kAvgIterations);
+}
+
+/**
+ * Creates a document resembling a typical watch DocumentChange payload: a mix
+ * of scalar fields, a nested map, and an array, `size` times over.
+ */
+ObjectValue MakeDocumentData(int64_t size) {
+  FieldValue::Map fields;
+  for (int64_t i = 0; i < size; ++i) {
+    FieldValue::Map nested;
+    nested = nested.insert("city", FieldValue::FromString("Springfield"));
+    nested = nested.insert("zip", FieldValue::FromInteger(12345 + i));
+
+    fields = fields.insert(absl::StrCat("name", i),
+                           FieldValue::FromString(absl::StrCat("user", i)));
+    fields = fields.insert(absl::StrCat("score", i),
+                           FieldValue::FromDouble(0.5 * i));
+    fields = fields.insert(absl::StrCat("address", i),
+                           FieldValue::FromMap(std::move(nested)));
+    fields = fields.insert(absl::StrCat("tags", i),
+                           FieldValue::FromArray({FieldValue::FromString("a"),
+                                                  FieldValue::FromString("b"),
+                                                  FieldValue::True()}));
+  }
+  return ObjectValue::FromMap(std::move(fields));
+}
+
+ByteString EncodeDocument(const Serializer& serializer, int64_t size) {
+  google_firestore_v1_Document proto = serializer.EncodeDocument(
+      testutil::Key("rooms/eros"), MakeDocumentData(size));
+
+  ByteStringWriter writer;
+  writer.WriteNanopbMessage(google_firestore_v1_Document_fields, &proto);
+  Serializer::FreeNanopbMessage(google_firestore_v1_Document_fields, &proto);
+  return writer.Release();
+}
+
+/** Decodes into nanopb structs, converts them, then frees them. */
+void BM_DecodeDocument(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  ByteString bytes = EncodeDocument(serializer, state.range(0));
+
+  AllocationCounter counter;
+  for (auto _ : state) {
+    Reader reader{bytes};
+    google_firestore_v1_Document proto{};
+    reader.ReadNanopbMessage(google_firestore_v1_Document_fields, &proto);
+    std::unique_ptr<Document> doc = serializer.DecodeDocument(&reader, proto);
+    reader.FreeNanopbMessage(google_firestore_v1_Document_fields, &proto);
+    benchmark::DoNotOptimize(doc);
+  }
+  SetAllocationCounters(state, counter);
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_DecodeDocument)->Range(1, 256);
+
+/** Builds the model directly from the wire format. */
+void BM_ReadDocument(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  ByteString bytes = EncodeDocument(serializer, state.range(0));
+
+  AllocationCounter counter;
+  for (auto _ : state) {
+    Reader reader{bytes};
+    std::unique_ptr<Document> doc = serializer.ReadDocument(&reader);
+    benchmark::DoNotOptimize(doc);
+  }
+  SetAllocationCounters(state, counter);
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_ReadDocument)->Range(1, 256);
+
+/** Builds nanopb structs, encodes them with nanopb, then frees them. */
+void BM_EncodeDocument(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  DocumentKey key = testutil::Key("rooms/eros");
+  ObjectValue data = MakeDocumentData(state.range(0));
+
+  for (auto _ : state) {
+    google_firestore_v1_Document proto = serializer.EncodeDocument(key, data);
+    ByteStringWriter writer;
+    writer.WriteNanopbMessage(google_firestore_v1_Document_fields, &proto);
+    Serializer::FreeNanopbMessage(google_firestore_v1_Document_fields, &proto);
+    benchmark::DoNotOptimize(writer.Release());
+  }
+}
+BENCHMARK(BM_EncodeDocument)->Range(1, 256);
+
+/** Sizes the document once, then writes it into a presized buffer. */
+void BM_WriteDocument(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  DocumentKey key = testutil::Key("rooms/eros");
+  ObjectValue data = MakeDocumentData(state.range(0));
+
+  for (auto _ : state) {
+    ByteStringWriter writer;
+    serializer.WriteDocument(&writer, key, data);
+    benchmark::DoNotOptimize(writer.Release());
+  }
+}
+BENCHMARK(BM_WriteDocument)->Range(1, 256);
+
+// Corpora of documents each stressing one part of the encoding. Every
+// benchmark below runs once per corpus, labeled with its name, and reports
+// its throughput in bytes of the encoded document.
+
+enum Corpus {
+  kFlat,
+  kNested,
+  kLargeArray,
+  kBlob,
+  kTimestampsAndReferences,
+};
+
+const char* CorpusName(int64_t corpus) {
+  switch (corpus) {
+    case kFlat:
+      return "flat";
+    case kNested:
+      return "nested";
+    case kLargeArray:
+      return "large_array";
+    case kBlob:
+      return "blob";
+    case kTimestampsAndReferences:
+      return "timestamps_and_references";
+  }
+  return "unknown";
+}
+
+ObjectValue MakeCorpusDocumentData(int64_t corpus) {
+  FieldValue::Map fields;
+  switch (corpus) {
+    case kFlat:
+      // Many small scalar fields, as in a typical table-like document.
+      for (int i = 0; i < 200; ++i) {
+        fields = fields.insert(
+            absl::StrCat("string", i),
+            FieldValue::FromString(absl::StrCat("value", i)));
+        fields = fields.insert(absl::StrCat("integer", i),
+                               FieldValue::FromInteger(i * 1000003));
+        fields = fields.insert(absl::StrCat("double", i),
+                               FieldValue::FromDouble(i / 7.0));
+      }
+      break;
+
+    case kNested: {
+      // A chain of maps 50 levels deep, each with a few siblings.
+      FieldValue value = FieldValue::FromString("leaf");
+      for (int depth = 0; depth < 50; ++depth) {
+        FieldValue::Map level;
+        level = level.insert("child", value);
+        level = level.insert("depth", FieldValue::FromInteger(depth));
+        level = level.insert("name", FieldValue::FromString("level"));
+        value = FieldValue::FromMap(std::move(level));
+      }
+      fields = fields.insert("root", std::move(value));
+      break;
+    }
+
+    case kLargeArray: {
+      std::vector<FieldValue> values;
+      for (int i = 0; i < 5000; ++i) {
+        values.push_back(FieldValue::FromInteger(i));
+      }
+      fields =
+          fields.insert("values", FieldValue::FromArray(std::move(values)));
+      break;
+    }
+
+    case kBlob: {
+      std::vector<uint8_t> bytes(256 * 1024);
+      for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(i * 31);
+      }
+      fields = fields.insert(
+          "blob", FieldValue::FromBlob(ByteString(bytes.data(), bytes.size())));
+      break;
+    }
+
+    case kTimestampsAndReferences: {
+      DatabaseId database_id{"p", "d"};
+      for (int i = 0; i < 200; ++i) {
+        fields = fields.insert(
+            absl::StrCat("timestamp", i),
+            FieldValue::FromTimestamp(Timestamp{1500000000 + i, i * 1000}));
+        fields = fields.insert(
+            absl::StrCat("reference", i),
+            FieldValue::FromReference(
+                database_id,
+                testutil::Key(absl::StrCat("rooms/room", i, "/messages/m"))));
+      }
+      break;
+    }
+  }
+  return ObjectValue::FromMap(std::move(fields));
+}
+
+void CorpusArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->DenseRange(kFlat, kTimestampsAndReferences);
+}
+
+ByteString EncodeCorpusDocument(const Serializer& serializer, int64_t corpus) {
+  ByteStringWriter writer;
+  serializer.WriteDocument(&writer, testutil::Key("rooms/eros"),
+                           MakeCorpusDocumentData(corpus));
+  return writer.Release();
+}
+
+/** Encodes through nanopb structs. */
+void BM_EncodeCorpusDocument(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  DocumentKey key = testutil::Key("rooms/eros");
+  ObjectValue data = MakeCorpusDocumentData(state.range(0));
+  size_t size = EncodeCorpusDocument(serializer, state.range(0)).size();
+
+  for (auto _ : state) {
+    google_firestore_v1_Document proto = serializer.EncodeDocument(key, data);
+    ByteStringWriter writer;
+    writer.WriteNanopbMessage(google_firestore_v1_Document_fields, &proto);
+    Serializer::FreeNanopbMessage(google_firestore_v1_Document_fields, &proto);
+    benchmark::DoNotOptimize(writer.Release());
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+  state.SetLabel(CorpusName(state.range(0)));
+}
+BENCHMARK(BM_EncodeCorpusDocument)->Apply(CorpusArguments);
+
+/** Encodes straight into a presized buffer. */
+void BM_WriteCorpusDocument(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  DocumentKey key = testutil::Key("rooms/eros");
+  ObjectValue data = MakeCorpusDocumentData(state.range(0));
+  size_t size = EncodeCorpusDocument(serializer, state.range(0)).size();
+
+  for (auto _ : state) {
+    ByteStringWriter writer;
+    serializer.WriteDocument(&writer, key, data);
+    benchmark::DoNotOptimize(writer.Release());
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+  state.SetLabel(CorpusName(state.range(0)));
+}
+BENCHMARK(BM_WriteCorpusDocument)->Apply(CorpusArguments);
+
+/** Decodes a document found by a lookup, through nanopb structs. */
+void BM_DecodeMaybeDocument(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+
+  google_firestore_v1_BatchGetDocumentsResponse response{};
+  response.which_result =
+      google_firestore_v1_BatchGetDocumentsResponse_found_tag;
+  response.found = serializer.EncodeDocument(
+      testutil::Key("rooms/eros"), MakeCorpusDocumentData(state.range(0)));
+  response.found.update_time =
+      Serializer::EncodeVersion(testutil::Version(1000));
+  response.read_time = Serializer::EncodeVersion(testutil::Version(2000));
+
+  ByteStringWriter writer;
+  writer.WriteNanopbMessage(
+      google_firestore_v1_BatchGetDocumentsResponse_fields, &response);
+  Serializer::FreeNanopbMessage(
+      google_firestore_v1_BatchGetDocumentsResponse_fields, &response);
+  ByteString bytes = writer.Release();
+
+  for (auto _ : state) {
+    Reader reader{bytes};
+    google_firestore_v1_BatchGetDocumentsResponse proto{};
+    reader.ReadNanopbMessage(
+        google_firestore_v1_BatchGetDocumentsResponse_fields, &proto);
+    std::unique_ptr<MaybeDocument> doc =
+        serializer.DecodeMaybeDocument(&reader, proto);
+    reader.FreeNanopbMessage(
+        google_firestore_v1_BatchGetDocumentsResponse_fields, &proto);
+    benchmark::DoNotOptimize(doc);
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+  state.SetLabel(CorpusName(state.range(0)));
+}
+BENCHMARK(BM_DecodeMaybeDocument)->Apply(CorpusArguments);
+
+/** Decodes a document through nanopb structs. */
+void BM_DecodeCorpusDocument(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  ByteString bytes = EncodeCorpusDocument(serializer, state.range(0));
+
+  AllocationCounter counter;
+  for (auto _ : state) {
+    Reader reader{bytes};
+    google_firestore_v1_Document proto{};
+    reader.ReadNanopbMessage(google_firestore_v1_Document_fields, &proto);
+    std::unique_ptr<Document> doc = serializer.DecodeDocument(&reader, proto);
+    reader.FreeNanopbMessage(google_firestore_v1_Document_fields, &proto);
+    benchmark::DoNotOptimize(doc);
+  }
+  SetAllocationCounters(state, counter);
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+  state.SetLabel(CorpusName(state.range(0)));
+}
+BENCHMARK(BM_DecodeCorpusDocument)->Apply(CorpusArguments);
+
+/** Decodes a document straight from the wire format. */
+void BM_ReadCorpusDocument(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  ByteString bytes = EncodeCorpusDocument(serializer, state.range(0));
+
+  AllocationCounter counter;
+  for (auto _ : state) {
+    Reader reader{bytes};
+    std::unique_ptr<Document> doc = serializer.ReadDocument(&reader);
+    benchmark::DoNotOptimize(doc);
+  }
+  SetAllocationCounters(state, counter);
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+  state.SetLabel(CorpusName(state.range(0)));
+}
+BENCHMARK(BM_ReadCorpusDocument)->Apply(CorpusArguments);
+
+ByteString EncodeCorpusValue(int64_t corpus) {
+  ByteStringWriter writer;
+  ObjectValue data = MakeCorpusDocumentData(corpus);
+  Serializer::WriteFieldValue(&writer,
+                              FieldValue::FromMap(data.GetInternalValue()));
+  return writer.Release();
+}
+
+/** Decodes a map value through nanopb structs. */
+void BM_DecodeFieldValue(benchmark::State& state) {
+  ByteString bytes = EncodeCorpusValue(state.range(0));
+
+  for (auto _ : state) {
+    Reader reader{bytes};
+    google_firestore_v1_Value proto{};
+    reader.ReadNanopbMessage(google_firestore_v1_Value_fields, &proto);
+    FieldValue value = Serializer::DecodeFieldValue(&reader, proto);
+    reader.FreeNanopbMessage(google_firestore_v1_Value_fields, &proto);
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+  state.SetLabel(CorpusName(state.range(0)));
+}
+BENCHMARK(BM_DecodeFieldValue)->Apply(CorpusArguments);
+
+/** Decodes a map value straight from the wire format. */
+void BM_ReadFieldValue(benchmark::State& state) {
+  ByteString bytes = EncodeCorpusValue(state.range(0));
+
+  for (auto _ : state) {
+    Reader reader{bytes};
+    FieldValue value = Serializer::ReadFieldValue(&reader);
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+  state.SetLabel(CorpusName(state.range(0)));
+}
+BENCHMARK(BM_ReadFieldValue)->Apply(CorpusArguments);
+
+/** Encodes a set mutation of the whole document, as a write does. */
+void BM_EncodeMutation(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  std::unique_ptr<model::SetMutation> mutation = testutil::SetMutation(
+      "rooms/eros",
+      MakeCorpusDocumentData(state.range(0)).GetInternalValue());
+
+  size_t size = 0;
+  for (auto _ : state) {
+    google_firestore_v1_Write proto = serializer.EncodeMutation(*mutation);
+    ByteStringWriter writer;
+    writer.WriteNanopbMessage(google_firestore_v1_Write_fields, &proto);
+    Serializer::FreeNanopbMessage(google_firestore_v1_Write_fields, &proto);
+    ByteString bytes = writer.Release();
+    size = bytes.size();
+    benchmark::DoNotOptimize(bytes);
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+  state.SetLabel(CorpusName(state.range(0)));
+}
+BENCHMARK(BM_EncodeMutation)->Apply(CorpusArguments);
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -39,6 +39,7 @@
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
 #include "Firestore/core/src/firebase/firestore/timestamp_internal.h"
@@ -47,6 +48,7 @@
 #include "Firestore/core/test/firebase/firestore/nanopb/nanopb_testing.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "Firestore/core/test/firebase/firestore/util/status_testing.h"
+#include "absl/base/config.h"
 #include "absl/types/optional.h"
 #include "google/protobuf/stubs/common.h"
 #include "google/protobuf/util/message_differencer.h"
@@ -66,6 +68,8 @@ using model::MaybeDocument;
 using model::NoDocument;
 using model::ObjectValue;
 using model::SnapshotVersion;
+using nanopb::Arena;
+using nanopb::ArenaScope;
 using nanopb::ByteString;
 using nanopb::ByteStringWriter;
 using nanopb::ProtobufParse;
@@ -130,6 +134,12 @@ class SerializerTest : public ::testing::Test {
 
     ASSERT_NOT_OK(reader.status());
     EXPECT_EQ(status.code(), reader.status().code());
+
+    // The streaming decoder must reject the same inputs.
+    Reader stream_reader(bytes);
+    Serializer::ReadFieldValue(&stream_reader);
+    ASSERT_NOT_OK(stream_reader.status());
+    EXPECT_EQ(status.code(), stream_reader.status().code());
   }
 
   void ExpectFailedStatusDuringMaybeDocumentDecode(Status status,
@@ -266,6 +276,12 @@ class SerializerTest : public ::testing::Test {
     auto actual_proto = ProtobufParse<v1::Value>(bytes);
 
     EXPECT_TRUE(msg_diff.Compare(proto, actual_proto)) << message_differences;
+
+    ByteStringWriter writer;
+    Serializer::WriteFieldValue(&writer, model);
+    auto written_proto = ProtobufParse<v1::Value>(writer.Release());
+
+    EXPECT_TRUE(msg_diff.Compare(proto, written_proto)) << message_differences;
   }
 
   void ExpectDeserializationRoundTrip(const FieldValue& model,
@@ -283,6 +299,12 @@ class SerializerTest : public ::testing::Test {
     EXPECT_OK(reader.status());
     EXPECT_EQ(type, actual_model.type());
     EXPECT_EQ(model, actual_model);
+
+    Reader stream_reader(bytes);
+    FieldValue streamed_model = Serializer::ReadFieldValue(&stream_reader);
+    EXPECT_OK(stream_reader.status());
+    EXPECT_EQ(type, streamed_model.type());
+    EXPECT_EQ(model, streamed_model);
   }
 
   void ExpectSerializationRoundTrip(
@@ -313,6 +335,13 @@ class SerializerTest : public ::testing::Test {
 
     EXPECT_TRUE(msg_diff.Compare(proto_copy.found(), actual_proto))
         << message_differences;
+
+    ByteStringWriter writer;
+    serializer.WriteDocument(&writer, key, value);
+    auto written_proto = ProtobufParse<v1::Document>(writer.Release());
+
+    EXPECT_TRUE(msg_diff.Compare(proto_copy.found(), written_proto))
+        << message_differences;
   }
 
   void ExpectDeserializationRoundTrip(
@@ -340,6 +369,16 @@ class SerializerTest : public ::testing::Test {
       case MaybeDocument::Type::Document: {
         Document* actual_doc_model = static_cast<Document*>(actual_model.get());
         EXPECT_EQ(value, actual_doc_model->data());
+
+        ByteString found_bytes = ProtobufSerialize(proto.found());
+        Reader stream_reader(found_bytes);
+        std::unique_ptr<Document> streamed_doc =
+            serializer.ReadDocument(&stream_reader);
+        EXPECT_OK(stream_reader.status());
+        ASSERT_NE(nullptr, streamed_doc);
+        EXPECT_EQ(key, streamed_doc->key());
+        EXPECT_EQ(version, streamed_doc->version());
+        EXPECT_EQ(value, streamed_doc->data());
         break;
       }
       case MaybeDocument::Type::NoDocument:
@@ -600,6 +639,49 @@ TEST_F(SerializerTest, EncodesNestedObjects) {
   ExpectRoundTrip(model, proto, FieldValue::Type::Object);
 }
 
+TEST_F(SerializerTest, WritesFieldValuesIntoPresizedBuffer) {
+  FieldValue model = FieldValue::FromMap({
+      {"array", FieldValue::FromArray(
+                    {FieldValue::FromInteger(1), FieldValue::FromString("two"),
+                     FieldValue::FromMap(
+                         {{"three", FieldValue::FromDouble(3.0)}})})},
+      {"nested",
+       FieldValue::FromMap(
+           {{"deepest",
+             FieldValue::FromArray(
+                 {FieldValue::FromTimestamp(Timestamp{1234, 5678}),
+                  FieldValue::FromString(std::string(300, 'x'))})}})},
+  });
+
+  ByteStringWriter writer;
+  Serializer::WriteFieldValue(&writer, model);
+
+  // Any mistake in sizing would have forced the buffer to grow.
+  EXPECT_EQ(writer.capacity(), writer.size());
+  EXPECT_EQ(EncodeFieldValue(&serializer, model).size(), writer.size());
+}
+
+TEST_F(SerializerTest, EncodesFieldValuesIntoArena) {
+  FieldValue model = FieldValue::FromMap({
+      {"array", FieldValue::FromArray({
+                    FieldValue::FromString("one"),
+                    FieldValue::FromBlob(ByteString{1, 2}),
+                })},
+      {"nested", FieldValue::FromMap({{"n", FieldValue::FromInteger(3)}})},
+  });
+  ByteString expected = EncodeFieldValue(&serializer, model);
+
+  Arena arena;
+  {
+    ArenaScope scope{&arena};
+    // FreeNanopbMessage does nothing here; the arena releases everything.
+    EXPECT_EQ(expected, EncodeFieldValue(&serializer, model));
+  }
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  EXPECT_GT(arena.capacity(), 0u);
+#endif
+}
+
 TEST_F(SerializerTest, EncodesFieldValuesWithRepeatedEntries) {
   // Technically, serialized Value protos can contain multiple values. (The last
   // one "wins".) However, well-behaved proto emitters (such as libprotobuf)
@@ -656,6 +738,10 @@ TEST_F(SerializerTest, EncodesFieldValuesWithRepeatedEntries) {
   FieldValue expected_model = FieldValue::FromInteger(42);
   EXPECT_EQ(FieldValue::Type::Integer, actual_model.type());
   EXPECT_EQ(expected_model, actual_model);
+
+  Reader stream_reader(bytes);
+  EXPECT_EQ(expected_model, Serializer::ReadFieldValue(&stream_reader));
+  EXPECT_OK(stream_reader.status());
 }
 
 TEST_F(SerializerTest, BadNullValue) {
@@ -807,6 +893,10 @@ TEST_F(SerializerTest, BadFieldValueTagWithOtherValidTagsPresent) {
   FieldValue expected_model = FieldValue::FromBoolean(true);
   EXPECT_EQ(FieldValue::Type::Boolean, actual_model.type());
   EXPECT_EQ(expected_model, actual_model);
+
+  Reader stream_reader(bytes);
+  EXPECT_EQ(expected_model, Serializer::ReadFieldValue(&stream_reader));
+  EXPECT_OK(stream_reader.status());
 }
 
 TEST_F(SerializerTest, IncompleteFieldValue) {
@@ -961,6 +1051,88 @@ TEST_F(SerializerTest, DecodeMaybeDocWithoutFoundOrMissingSetShouldFail) {
       Status(Error::DataLoss, "ignored"), bytes);
 }
 
+TEST_F(SerializerTest, DecodesListenResponseVersion) {
+  v1::ListenResponse proto;
+  v1::TargetChange* change = proto.mutable_target_change();
+  change->set_target_change_type(v1::TargetChange::NO_CHANGE);
+  change->mutable_read_time()->set_seconds(1234);
+  change->mutable_read_time()->set_nanos(5678);
+
+  ByteString bytes = ProtobufSerialize(proto);
+  Reader reader(bytes);
+  google_firestore_v1_ListenResponse nanopb_proto{};
+  reader.ReadNanopbMessage(google_firestore_v1_ListenResponse_fields,
+                           &nanopb_proto);
+  SnapshotVersion version = Serializer::DecodeVersion(&reader, nanopb_proto);
+  reader.FreeNanopbMessage(google_firestore_v1_ListenResponse_fields,
+                           &nanopb_proto);
+
+  EXPECT_OK(reader.status());
+  EXPECT_EQ((SnapshotVersion{{1234, 5678}}), version);
+}
+
+TEST_F(SerializerTest, DecodesNoVersionForTargetSpecificChanges) {
+  v1::ListenResponse proto;
+  v1::TargetChange* change = proto.mutable_target_change();
+  change->set_target_change_type(v1::TargetChange::CURRENT);
+  change->add_target_ids(1);
+  change->mutable_read_time()->set_seconds(1234);
+
+  ByteString bytes = ProtobufSerialize(proto);
+  Reader reader(bytes);
+  google_firestore_v1_ListenResponse nanopb_proto{};
+  reader.ReadNanopbMessage(google_firestore_v1_ListenResponse_fields,
+                           &nanopb_proto);
+  SnapshotVersion version = Serializer::DecodeVersion(&reader, nanopb_proto);
+  reader.FreeNanopbMessage(google_firestore_v1_ListenResponse_fields,
+                           &nanopb_proto);
+
+  EXPECT_OK(reader.status());
+  EXPECT_EQ(SnapshotVersion::None(), version);
+}
+
+TEST_F(SerializerTest, ReadsDocumentChangeBytes) {
+  v1::ListenResponse proto;
+  v1::DocumentChange* change = proto.mutable_document_change();
+  change->add_target_ids(1);
+  v1::Document* document = change->mutable_document();
+  document->set_name(serializer.EncodeKey(Key("one/two")));
+  document->mutable_update_time()->set_seconds(1234);
+  change->add_removed_target_ids(2);
+
+  ByteString bytes = ProtobufSerialize(proto);
+  Reader reader(bytes);
+  ByteString document_bytes = Serializer::ReadDocumentChangeBytes(&reader);
+
+  EXPECT_OK(reader.status());
+  EXPECT_EQ(ProtobufSerialize(*document), document_bytes);
+}
+
+TEST_F(SerializerTest, ReadsNoDocumentBytesFromOtherResponses) {
+  v1::ListenResponse proto;
+  proto.mutable_filter()->set_count(3);
+
+  ByteString bytes = ProtobufSerialize(proto);
+  Reader reader(bytes);
+  ByteString document_bytes = Serializer::ReadDocumentChangeBytes(&reader);
+
+  EXPECT_OK(reader.status());
+  EXPECT_TRUE(document_bytes.empty());
+}
+
+TEST_F(SerializerTest, DecodesStatus) {
+  google_rpc_Status proto{};
+  EXPECT_OK(Serializer::DecodeStatus(proto));
+
+  proto.code = static_cast<int32_t>(Error::PermissionDenied);
+  proto.message = Serializer::EncodeString("denied");
+  Status status = Serializer::DecodeStatus(proto);
+  Serializer::FreeNanopbMessage(google_rpc_Status_fields, &proto);
+
+  EXPECT_EQ(Error::PermissionDenied, status.code());
+  EXPECT_EQ("denied", status.error_message());
+}
+
 // TODO(rsgowman): Test [en|de]coding multiple protos into the same output
 // vector.
 
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/write_pipeline_window.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using Clock = WritePipelineWindow::clock;
+using std::chrono::milliseconds;
+
+namespace {
+
+/** Sends one write at `start` and acknowledges it after `latency`. */
+void RoundTrip(WritePipelineWindow* window,
+               Clock::time_point start,
+               milliseconds latency) {
+  window->RecordWrite(start);
+  window->RecordAck(start + latency);
+}
+
+}  // namespace
+
+TEST(WritePipelineWindowTest, FixedWindowNeverChanges) {
+  WritePipelineWindow window{25, false};
+  EXPECT_EQ(window.size(), 25);
+
+  Clock::time_point now = Clock::now();
+  RoundTrip(&window, now, milliseconds(10));
+  RoundTrip(&window, now, milliseconds(10));
+  EXPECT_EQ(window.size(), 25);
+
+  window.RecordBackpressure();
+  EXPECT_EQ(window.size(), 25);
+}
+
+TEST(WritePipelineWindowTest, AdaptiveWindowStartsAtInitialSize) {
+  EXPECT_EQ(WritePipelineWindow(100, true).size(),
+            WritePipelineWindow::kInitialSize);
+  EXPECT_EQ(WritePipelineWindow(3, true).size(), 3);
+}
+
+TEST(WritePipelineWindowTest, GrowsWhileAcksAreFast) {
+  WritePipelineWindow window{12, true};
+  Clock::time_point now = Clock::now();
+
+  RoundTrip(&window, now, milliseconds(100));
+  EXPECT_EQ(window.size(), 11);
+  RoundTrip(&window, now, milliseconds(150));
+  EXPECT_EQ(window.size(), 12);
+
+  // Capped at the maximum.
+  RoundTrip(&window, now, milliseconds(100));
+  EXPECT_EQ(window.size(), 12);
+}
+
+TEST(WritePipelineWindowTest, DoesNotGrowOnSlowAcks) {
+  WritePipelineWindow window{100, true};
+  Clock::time_point now = Clock::now();
+
+  RoundTrip(&window, now, milliseconds(100));
+  EXPECT_EQ(window.size(), 11);
+  RoundTrip(&window, now, milliseconds(500));
+  EXPECT_EQ(window.size(), 11);
+}
+
+TEST(WritePipelineWindowTest, MatchesAcksToWritesInOrder) {
+  WritePipelineWindow window{100, true};
+  Clock::time_point now = Clock::now();
+
+  window.RecordWrite(now);
+  window.RecordWrite(now + milliseconds(900));
+  window.RecordAck(now + milliseconds(1000));  // 1000ms round trip
+  window.RecordAck(now + milliseconds(1100));  // 200ms round trip
+  EXPECT_EQ(window.size(), 12);
+
+  window.RecordWrite(now + milliseconds(2000));
+  window.RecordAck(now + milliseconds(3000));  // 1000ms round trip
+  EXPECT_EQ(window.size(), 12);
+}
+
+TEST(WritePipelineWindowTest, HalvesOnBackpressure) {
+  WritePipelineWindow window{100, true};
+
+  window.RecordBackpressure();
+  EXPECT_EQ(window.size(), 5);
+  window.RecordBackpressure();
+  EXPECT_EQ(window.size(), 2);
+  window.RecordBackpressure();
+  EXPECT_EQ(window.size(), 1);
+  window.RecordBackpressure();
+  EXPECT_EQ(window.size(), 1);
+}
+
+TEST(WritePipelineWindowTest, ResetForgetsWritesInFlight) {
+  WritePipelineWindow window{100, true};
+  Clock::time_point now = Clock::now();
+
+  window.RecordWrite(now);
+  window.Reset();
+  window.RecordAck(now + milliseconds(100));
+  EXPECT_EQ(window.size(), WritePipelineWindow::kInitialSize);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -276,6 +276,10 @@ inline core::Filter::Operator OperatorFromString(absl::string_view s) {
     return core::Filter::Operator::GreaterThanOrEqual;
   } else if (s == "array_contains" || s == "array-contains") {
     return core::Filter::Operator::ArrayContains;
+  } else if (s == "in") {
+    return core::Filter::Operator::In;
+  } else if (s == "array_contains_any" || s == "array-contains-any") {
+    return core::Filter::Operator::ArrayContainsAny;
   } else {
     HARD_FAIL("Unknown operator: %s", s);
   }
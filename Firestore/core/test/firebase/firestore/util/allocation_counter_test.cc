@@ -0,0 +1,70 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/allocation_counter.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+TEST(AllocationCounterTest, CountsAllocationsOfTheCurrentThread) {
+  AllocationCounter counter;
+  std::unique_ptr<int> one{new int{1}};
+  std::unique_ptr<int[]> many{new int[16]};
+
+  if (AllocationCountingEnabled()) {
+    EXPECT_EQ(2u, counter.allocations());
+    EXPECT_EQ(17 * sizeof(int), counter.allocated_bytes());
+  } else {
+    EXPECT_EQ(0u, counter.allocations());
+    EXPECT_EQ(0u, counter.allocated_bytes());
+  }
+}
+
+TEST(AllocationCounterTest, ResetStartsCountingAgain) {
+  AllocationCounter counter;
+  std::vector<int> values(100);
+  counter.Reset();
+
+  EXPECT_EQ(0u, counter.allocations());
+  values.clear();
+  values.shrink_to_fit();
+  EXPECT_EQ(0u, counter.allocations());
+}
+
+TEST(AllocationCounterTest, IgnoresOtherThreads) {
+  std::vector<std::unique_ptr<int>> values;
+  std::thread thread{[&values] {
+    for (int i = 0; i < 10; ++i) {
+      values.emplace_back(new int{i});
+    }
+  }};
+  // Starting the thread allocates on this thread.
+  AllocationCounter counter;
+  thread.join();
+
+  EXPECT_EQ(0u, counter.allocations());
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -19,6 +19,7 @@
 #include <chrono>  // NOLINT(build/c++11)
 #include <future>  // NOLINT(build/c++11)
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "absl/memory/memory.h"
@@ -61,6 +62,38 @@ TEST_P(AsyncQueueTest, EnqueueRelaxedWorksFromWithinEnqueue) {
   EXPECT_TRUE(WaitForTestToFinish());
 }
 
+TEST_P(AsyncQueueTest, BackgroundOperationsYieldToRegularOperations) {
+  std::string steps;
+
+  queue.Enqueue([&] {
+    // Queue everything from the queue to ensure nothing runs before
+    // everything is enqueued.
+    queue.EnqueueBackground([&] {
+      steps += '3';
+      queue.EnqueueRelaxed([&steps] { steps += '4'; });
+    });
+    queue.EnqueueRelaxed([&steps] { steps += '1'; });
+    queue.EnqueueBackground([&] {
+      steps += '5';
+      signal_finished();
+    });
+    queue.EnqueueRelaxed([&steps] { steps += '2'; });
+  });
+
+  EXPECT_TRUE(WaitForTestToFinish());
+  EXPECT_EQ(steps, "12345");
+}
+
+TEST_P(AsyncQueueTest, BackgroundOperationsRunAsPartOfTheQueue) {
+  queue.EnqueueBackground([&] {
+    EXPECT_NO_THROW(queue.VerifyIsCurrentQueue());
+    EXPECT_ANY_THROW(queue.Enqueue([] {}));
+    signal_finished();
+  });
+
+  EXPECT_TRUE(WaitForTestToFinish());
+}
+
 TEST_P(AsyncQueueTest, EnqueueBlocking) {
   bool finished = false;
   queue.EnqueueBlocking([&] { finished = true; });
@@ -183,6 +216,42 @@ TEST_P(AsyncQueueTest, CanManuallyDrainSpecificDelayedOperationsForTesting) {
   EXPECT_EQ(steps, "1234");
 }
 
+TEST_P(AsyncQueueTest, ReportsLongTasksWithTheirLabels) {
+  std::vector<std::string> labels;
+  queue.EnqueueBlocking([&] {
+    queue.EnableInstrumentation(
+        std::chrono::microseconds(0),
+        [&labels](const AsyncQueue::OperationTiming& timing) {
+          if (timing.label) {
+            labels.push_back(timing.label);
+          }
+        });
+    queue.EnqueueAfterDelay(AsyncQueue::Milliseconds(10000), kTimerId1, [] {});
+  });
+
+  queue.Enqueue("First", [] {});
+  queue.Enqueue("Second", [] {});
+  // Once this has run, so have the listeners of the operations before it.
+  queue.EnqueueBlocking([] {});
+  queue.RunScheduledOperationsUntil(kTimerId1);
+
+  EXPECT_EQ(labels, (std::vector<std::string>{
+                        "First", "Second", "ListenStreamConnectionBackoff"}));
+}
+
+TEST_P(AsyncQueueTest, OnlyReportsTasksOverTheThreshold) {
+  int long_tasks = 0;
+  queue.EnqueueBlocking([&] {
+    queue.EnableInstrumentation(
+        std::chrono::hours(1),
+        [&long_tasks](const AsyncQueue::OperationTiming&) { ++long_tasks; });
+  });
+
+  queue.Enqueue("Short", [] {});
+  queue.EnqueueBlocking([] {});
+  EXPECT_EQ(long_tasks, 0);
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
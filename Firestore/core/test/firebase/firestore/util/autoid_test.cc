@@ -17,10 +17,14 @@
 #include "Firestore/core/src/firebase/firestore/util/autoid.h"
 
 #include <cctype>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 
 using firebase::firestore::util::CreateAutoId;
+using firebase::firestore::util::CreateAutoIds;
 
 TEST(AutoId, IsSane) {
   for (int i = 0; i < 50; i++) {
@@ -34,3 +38,20 @@ TEST(AutoId, IsSane) {
     }
   }
 }
+
+TEST(AutoId, BatchesAreSaneAndDistinct) {
+  std::vector<std::string> auto_ids = CreateAutoIds(500);
+  ASSERT_EQ(500u, auto_ids.size());
+
+  std::set<std::string> distinct;
+  for (const std::string& auto_id : auto_ids) {
+    EXPECT_EQ(20u, auto_id.length());
+    for (char c : auto_id) {
+      EXPECT_TRUE(isalpha(c) || isdigit(c)) << "in \"" << auto_id << "\"";
+    }
+    distinct.insert(auto_id);
+  }
+  EXPECT_EQ(500u, distinct.size());
+
+  EXPECT_TRUE(CreateAutoIds(0).empty());
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/compressed_bitmap.h"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+std::vector<uint32_t> Values(const CompressedBitmap& bitmap) {
+  std::vector<uint32_t> result;
+  bitmap.ForEach([&](uint32_t value) { result.push_back(value); });
+  return result;
+}
+
+}  // namespace
+
+TEST(CompressedBitmapTest, AddsAndRemovesValues) {
+  CompressedBitmap bitmap;
+  EXPECT_TRUE(bitmap.empty());
+  EXPECT_FALSE(bitmap.Contains(7));
+
+  EXPECT_TRUE(bitmap.Add(7));
+  EXPECT_FALSE(bitmap.Add(7));
+  EXPECT_TRUE(bitmap.Add(0x10003));
+  EXPECT_TRUE(bitmap.Contains(7));
+  EXPECT_TRUE(bitmap.Contains(0x10003));
+  EXPECT_FALSE(bitmap.Contains(3));
+  EXPECT_EQ(bitmap.size(), 2u);
+
+  EXPECT_FALSE(bitmap.Remove(3));
+  EXPECT_TRUE(bitmap.Remove(7));
+  EXPECT_FALSE(bitmap.Remove(7));
+  EXPECT_FALSE(bitmap.Contains(7));
+  EXPECT_EQ(bitmap.size(), 1u);
+
+  EXPECT_TRUE(bitmap.Remove(0x10003));
+  EXPECT_TRUE(bitmap.empty());
+}
+
+TEST(CompressedBitmapTest, IteratesInAscendingOrder) {
+  CompressedBitmap bitmap;
+  for (uint32_t value : {0xFFFFFFFFu, 5u, 0x20000u, 0u, 70000u, 6u}) {
+    bitmap.Add(value);
+  }
+
+  EXPECT_EQ(Values(bitmap),
+            (std::vector<uint32_t>{0u, 5u, 6u, 70000u, 0x20000u,
+                                   0xFFFFFFFFu}));
+}
+
+TEST(CompressedBitmapTest, KeepsValuesAcrossDenseConversions) {
+  CompressedBitmap bitmap;
+  std::set<uint32_t> expected;
+
+  // Enough values in a chunk to be stored as bits, then few enough that
+  // it goes back to an array.
+  for (uint32_t i = 0; i != 10000; ++i) {
+    uint32_t value = 0x30000 + (i * 7) % 0x10000;
+    EXPECT_EQ(bitmap.Add(value), expected.insert(value).second);
+  }
+  EXPECT_EQ(bitmap.size(), expected.size());
+  EXPECT_EQ(Values(bitmap),
+            std::vector<uint32_t>(expected.begin(), expected.end()));
+
+  for (uint32_t i = 0; i != 9500; ++i) {
+    uint32_t value = 0x30000 + (i * 7) % 0x10000;
+    EXPECT_EQ(bitmap.Remove(value), expected.erase(value) != 0);
+  }
+  EXPECT_EQ(bitmap.size(), expected.size());
+  EXPECT_EQ(Values(bitmap),
+            std::vector<uint32_t>(expected.begin(), expected.end()));
+
+  for (uint32_t value : expected) {
+    EXPECT_TRUE(bitmap.Contains(value));
+    EXPECT_FALSE(bitmap.Contains(value + 1));
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
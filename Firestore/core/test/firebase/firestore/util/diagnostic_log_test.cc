@@ -0,0 +1,138 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/diagnostic_log.h"
+
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+using testing::ElementsAre;
+using testing::HasSubstr;
+
+namespace {
+
+enum class Color { kRed = 3 };
+
+std::vector<std::string> Messages(const DiagnosticLog& log) {
+  std::vector<std::string> result;
+  for (const DiagnosticLogRecord& record : log.Decode()) {
+    result.push_back(record.message);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(DiagnosticLogTest, FormatsArgumentsWhenDecoded) {
+  DiagnosticLog log;
+  int value = 0;
+  log.Record("empty");
+  log.Record("%s %s %s %s", true, -42, 42u, 0.5);
+  log.Record("%s and %s", "literal", std::string{"string"});
+  log.Record("color %s", Color::kRed);
+  log.Record("pointer %s", &value);
+  log.Record("%s%%", nullptr);
+
+  EXPECT_THAT(Messages(log),
+              ElementsAre("empty", "true -42 42 0.5", "literal and string",
+                          "color 3", StringFormat("pointer %s", &value),
+                          "null%"));
+}
+
+TEST(DiagnosticLogTest, TruncatesLongStrings) {
+  DiagnosticLog log;
+  std::string long_string(1000, 'a');
+  log.Record("%s %s", long_string, 1);
+
+  std::vector<std::string> messages = Messages(log);
+  ASSERT_EQ(1u, messages.size());
+  EXPECT_THAT(messages[0], HasSubstr("aaaa... <missing>"));
+  EXPECT_LT(messages[0].size(), 200u);
+}
+
+TEST(DiagnosticLogTest, KeepsTheMostRecentMessages) {
+  DiagnosticLog log{4};
+  for (int i = 0; i < 10; ++i) {
+    log.Record("message %s", i);
+  }
+
+  EXPECT_THAT(Messages(log), ElementsAre("message 6", "message 7",
+                                         "message 8", "message 9"));
+}
+
+TEST(DiagnosticLogTest, RoundsCapacityUpToAPowerOfTwo) {
+  EXPECT_EQ(1u, DiagnosticLog{0}.capacity());
+  EXPECT_EQ(8u, DiagnosticLog{5}.capacity());
+  EXPECT_EQ(DiagnosticLog::kDefaultCapacity, DiagnosticLog{}.capacity());
+}
+
+TEST(DiagnosticLogTest, DumpsTimestampedLines) {
+  DiagnosticLog log;
+  log.Record("first");
+  log.Record("second");
+
+  std::vector<DiagnosticLogRecord> records = log.Decode();
+  ASSERT_EQ(2u, records.size());
+  EXPECT_LE(records[0].timestamp_micros, records[1].timestamp_micros);
+  EXPECT_EQ(absl::StrCat(records[0].timestamp_micros, " first\n",
+                         records[1].timestamp_micros, " second\n"),
+            log.Dump());
+}
+
+TEST(DiagnosticLogTest, MacroRecordsOnlyWhenEnabled) {
+  DiagnosticLog& log = DiagnosticLog::Default();
+  ASSERT_FALSE(log.enabled());
+  size_t before = log.Decode().size();
+
+  LOG_DIAGNOSTIC("disabled %s", 1);
+  EXPECT_EQ(before, log.Decode().size());
+
+  log.set_enabled(true);
+  LOG_DIAGNOSTIC("enabled %s", 2);
+  log.set_enabled(false);
+  std::vector<std::string> messages = Messages(log);
+  EXPECT_EQ("enabled 2", messages.back());
+}
+
+TEST(DiagnosticLogTest, RecordsFromManyThreads) {
+  DiagnosticLog log{4096};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&log, i] {
+      for (int j = 0; j < 1000; ++j) {
+        log.Record("thread %s message %s", i, j);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(4000u, log.Decode().size());
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/executor_batching.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/test/firebase/firestore/util/executor_test.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+std::unique_ptr<Executor> ExecutorFactory() {
+  return absl::make_unique<ExecutorBatching>(std::make_shared<ExecutorStd>());
+}
+
+// Counts the operations it's asked to execute, including the ones that
+// `ExecuteBlocking` executes.
+class CountingExecutor : public ExecutorStd {
+ public:
+  void Execute(Operation&& operation) override {
+    ++executed;
+    ExecutorStd::Execute(std::move(operation));
+  }
+
+  int executed = 0;
+};
+
+}  // namespace
+
+INSTANTIATE_TEST_CASE_P(ExecutorTestBatching,
+                        ExecutorTest,
+                        ::testing::Values(ExecutorFactory));
+
+TEST(ExecutorBatchingTest, HoldsBackOperationsUntilBatchEnds) {
+  auto underlying = std::make_shared<CountingExecutor>();
+  ExecutorBatching executor{underlying};
+
+  std::vector<int> ran;
+  executor.BeginBatch();
+  for (int i = 0; i != 5; ++i) {
+    executor.Execute([&ran, i] { ran.push_back(i); });
+  }
+  EXPECT_EQ(underlying->executed, 0);
+  underlying->ExecuteBlocking([] {});
+  EXPECT_TRUE(ran.empty());
+
+  executor.EndBatch();
+  EXPECT_EQ(underlying->executed, 2);
+  underlying->ExecuteBlocking([] {});
+  EXPECT_EQ(ran, (std::vector<int>{0, 1, 2, 3, 4}));
+}
+
+TEST(ExecutorBatchingTest, ClosesNestedBatchesWithTheOutermost) {
+  auto underlying = std::make_shared<CountingExecutor>();
+  ExecutorBatching executor{underlying};
+
+  std::vector<int> ran;
+  executor.BeginBatch();
+  executor.Execute([&ran] { ran.push_back(1); });
+  executor.BeginBatch();
+  executor.Execute([&ran] { ran.push_back(2); });
+  executor.EndBatch();
+  EXPECT_EQ(underlying->executed, 0);
+  underlying->ExecuteBlocking([] {});
+  EXPECT_TRUE(ran.empty());
+
+  executor.EndBatch();
+  executor.Execute([&ran] { ran.push_back(3); });
+  EXPECT_EQ(underlying->executed, 3);
+  underlying->ExecuteBlocking([] {});
+  EXPECT_EQ(ran, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(ExecutorBatchingTest, SkipsEmptyBatches) {
+  auto underlying = std::make_shared<CountingExecutor>();
+  ExecutorBatching executor{underlying};
+
+  executor.BeginBatch();
+  executor.EndBatch();
+  EXPECT_EQ(underlying->executed, 0);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -101,6 +101,29 @@ TEST_F(ExecutorLibdispatchOnlyTests,
   std::this_thread::sleep_for(chr::milliseconds(500));
 }
 
+TEST_F(ExecutorLibdispatchOnlyTests, TimerIsAlignedWithTimerDueWithinLeeway) {
+  const auto start = chr::steady_clock::now();
+  chr::steady_clock::time_point second_ran_at;
+  int ran = 0;
+  auto finish = [&] {
+    if (++ran == 2) {
+      signal_finished();
+    }
+  };
+
+  executor->Schedule(chr::milliseconds(50), {Executor::Tag{1}, finish});
+  executor->Schedule(chr::milliseconds(20),
+                     {Executor::Tag{2}, chr::milliseconds(100), [&] {
+                        second_ran_at = chr::steady_clock::now();
+                        finish();
+                      }});
+
+  EXPECT_TRUE(WaitForTestToFinish());
+  // The second timer could have run 20ms in, but waits to run in the same
+  // wakeup as the first one.
+  EXPECT_GE(second_ran_at - start, chr::milliseconds(50));
+}
+
 }  // namespace internal
 }  // namespace util
 }  // namespace firestore
@@ -19,8 +19,10 @@
 #include <chrono>  // NOLINT(build/c++11)
 #include <cstdlib>
 #include <future>  // NOLINT(build/c++11)
+#include <memory>
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/executor_std.h"
 #include "Firestore/core/test/firebase/firestore/util/async_tests_util.h"
@@ -32,6 +34,7 @@ namespace firestore {
 namespace util {
 
 namespace chr = std::chrono;
+using async::MpscQueue;
 using async::Schedule;
 
 class ScheduleTest : public ::testing::Test {
@@ -105,6 +108,53 @@ TEST_F(ScheduleTest, RemoveIf) {
   EXPECT_TRUE(schedule.empty());
 }
 
+TEST_F(ScheduleTest, Remove) {
+  const auto one = schedule.Push(1, start_time);
+  const auto two = schedule.Push(2, start_time);
+  const auto three = schedule.Push(3, now() + chr::minutes(1));
+  EXPECT_NE(one, two);
+
+  EXPECT_EQ(schedule.Remove(two).value(), 2);
+  EXPECT_FALSE(schedule.Remove(two).has_value());
+  EXPECT_EQ(schedule.size(), 2u);
+
+  EXPECT_EQ(schedule.Remove(one).value(), 1);
+  EXPECT_FALSE(schedule.PopIfDue().has_value());
+  EXPECT_EQ(schedule.Remove(three).value(), 3);
+  EXPECT_TRUE(schedule.empty());
+}
+
+TEST_F(ScheduleTest, RemoveKeepsOrderOfRemainingEntries) {
+  std::vector<ScheduleT::Handle> handles;
+  for (int i = 0; i < 1000; ++i) {
+    handles.push_back(
+        schedule.Push(i, start_time + chr::milliseconds(i % 10)));
+  }
+  // Remove most entries, so that the removed entries are compacted away.
+  for (int i = 0; i < 1000; ++i) {
+    if (i % 7 != 0) {
+      EXPECT_EQ(schedule.Remove(handles[i]).value(), i);
+    }
+  }
+  EXPECT_EQ(schedule.size(), 143u);
+
+  std::this_thread::sleep_for(chr::milliseconds(10));
+  std::vector<int> values;
+  while (!schedule.empty()) {
+    values.push_back(schedule.PopIfDue().value());
+  }
+
+  std::vector<int> expected;
+  for (int due = 0; due < 10; ++due) {
+    for (int i = 0; i < 1000; i += 7) {
+      if (i % 10 == due) {
+        expected.push_back(i);
+      }
+    }
+  }
+  EXPECT_EQ(values, expected);
+}
+
 TEST_F(ScheduleTest, Ordering) {
   schedule.Push(11, start_time + chr::milliseconds(5));
   schedule.Push(1, start_time);
@@ -225,6 +275,76 @@ TEST_F(ScheduleTest, PopBlockingIsNotAffectedByIrrelevantRemovals) {
   ABORT_ON_TIMEOUT(future);
 }
 
+// MpscQueue tests
+
+TEST(MpscQueueTest, PopsInFifoOrder) {
+  MpscQueue<int> queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.Pop().has_value());
+
+  queue.Push(3);
+  queue.Push(1);
+  queue.Push(2);
+  EXPECT_FALSE(queue.empty());
+
+  EXPECT_EQ(queue.Pop().value(), 3);
+  EXPECT_EQ(queue.Pop().value(), 1);
+  queue.Push(4);
+  EXPECT_EQ(queue.Pop().value(), 2);
+  EXPECT_EQ(queue.Pop().value(), 4);
+  EXPECT_FALSE(queue.Pop().has_value());
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpscQueueTest, DestroysUnconsumedEntries) {
+  auto value = std::make_shared<int>(1);
+  {
+    MpscQueue<std::shared_ptr<int>> queue;
+    queue.Push(std::shared_ptr<int>{value});
+    queue.Push(std::shared_ptr<int>{value});
+    EXPECT_EQ(value.use_count(), 3);
+  }
+  EXPECT_EQ(value.use_count(), 1);
+}
+
+TEST(MpscQueueTest, PreservesOrderOfEachProducer) {
+  constexpr int kProducers = 4;
+  constexpr int kValuesPerProducer = 10000;
+
+  MpscQueue<int> queue;
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer != kProducers; ++producer) {
+    producers.emplace_back([&queue, producer] {
+      for (int i = 0; i != kValuesPerProducer; ++i) {
+        queue.Push(producer * kValuesPerProducer + i);
+      }
+    });
+  }
+
+  std::vector<int> next_expected(kProducers, 0);
+  int consumed = 0;
+  const auto start_time = now();
+  while (consumed != kProducers * kValuesPerProducer) {
+    absl::optional<int> value = queue.Pop();
+    if (!value) {
+      if (now() - start_time >= kTimeout) {
+        Abort();
+      }
+      continue;
+    }
+
+    int producer = *value / kValuesPerProducer;
+    EXPECT_EQ(*value % kValuesPerProducer, next_expected[producer]);
+    next_expected[producer] = *value % kValuesPerProducer + 1;
+    ++consumed;
+  }
+  EXPECT_TRUE(queue.empty());
+
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+}
+
 // ExecutorStd tests
 
 namespace {
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/executor_strand.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/test/firebase/firestore/util/async_queue_test.h"
+#include "Firestore/core/test/firebase/firestore/util/async_tests_util.h"
+#include "Firestore/core/test/firebase/firestore/util/executor_test.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+const std::shared_ptr<ThreadPool>& SharedPool() {
+  static auto* pool = new std::shared_ptr<ThreadPool>{
+      std::make_shared<ThreadPool>(4)};
+  return *pool;
+}
+
+std::unique_ptr<Executor> ExecutorFactory() {
+  return absl::make_unique<ExecutorStrand>(SharedPool());
+}
+
+}  // namespace
+
+INSTANTIATE_TEST_CASE_P(ExecutorTestStrand,
+                        ExecutorTest,
+                        ::testing::Values(ExecutorFactory));
+
+INSTANTIATE_TEST_CASE_P(AsyncQueueStrand,
+                        AsyncQueueTest,
+                        ::testing::Values(ExecutorFactory));
+
+TEST(ExecutorStrandTest, RunsOperationsOneAtATimeInOrder) {
+  auto pool = std::make_shared<ThreadPool>(4);
+  ExecutorStrand strand{pool};
+
+  std::atomic<int> running{0};
+  std::vector<int> order;
+  std::promise<void> done;
+  for (int i = 0; i != 100; ++i) {
+    strand.Execute([&, i] {
+      EXPECT_EQ(++running, 1);
+      order.push_back(i);
+      --running;
+      if (i == 99) {
+        done.set_value();
+      }
+    });
+  }
+
+  ABORT_ON_TIMEOUT(done.get_future());
+  ASSERT_EQ(order.size(), 100u);
+  for (int i = 0; i != 100; ++i) {
+    EXPECT_EQ(order[i], i);
+  }
+}
+
+TEST(ExecutorStrandTest, StrandsOnTheSamePoolRunInParallel) {
+  auto pool = std::make_shared<ThreadPool>(2);
+  ExecutorStrand first{pool};
+  ExecutorStrand second{pool};
+
+  // Each strand waits for the other one to start, which only finishes if they
+  // run at the same time.
+  std::promise<void> first_started;
+  std::promise<void> second_started;
+  std::shared_future<void> first_future = first_started.get_future();
+  std::shared_future<void> second_future = second_started.get_future();
+
+  first.Execute([&] {
+    first_started.set_value();
+    EXPECT_EQ(second_future.wait_for(kTimeout), std::future_status::ready);
+  });
+  second.Execute([&] {
+    second_started.set_value();
+    EXPECT_EQ(first_future.wait_for(kTimeout), std::future_status::ready);
+  });
+
+  first.ExecuteBlocking([] {});
+  second.ExecuteBlocking([] {});
+}
+
+TEST(ExecutorStrandTest, OperationsCanRunParallelWorkOnThePool) {
+  auto pool = std::make_shared<ThreadPool>(1);
+  ExecutorStrand strand{pool};
+
+  std::vector<int> squares(50);
+  strand.ExecuteBlocking([&] {
+    pool->ParallelFor(squares.size(), [&](size_t i) {
+      squares[i] = static_cast<int>(i * i);
+    });
+  });
+
+  for (size_t i = 0; i != squares.size(); ++i) {
+    EXPECT_EQ(squares[i], static_cast<int>(i * i));
+  }
+}
+
+TEST(ExecutorStrandTest, DestructorDiscardsPendingOperations) {
+  auto pool = std::make_shared<ThreadPool>(1);
+  std::atomic<bool> ran{false};
+  {
+    ExecutorStrand strand{pool};
+    strand.Schedule(std::chrono::milliseconds(1),
+                    {1, [&] { ran = true; }});
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(ran);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -248,6 +248,25 @@ TEST(FilesystemTest, RecursivelyDeletePreservesPeers) {
   EXPECT_OK(RecursivelyDelete(root_dir));
 }
 
+TEST(FilesystemTest, Rename) {
+  Path root_dir = Path::JoinUtf8(TempDir(), TestFilename());
+  Path from_dir = Path::JoinUtf8(root_dir, "from");
+  Path to_dir = Path::JoinUtf8(root_dir, "to");
+  ASSERT_NOT_FOUND(Rename(from_dir, to_dir));
+
+  ASSERT_OK(RecursivelyCreateDir(from_dir));
+  WriteStringToFile(Path::JoinUtf8(from_dir, "file"), "contents");
+
+  ASSERT_OK(Rename(from_dir, to_dir));
+  EXPECT_NOT_FOUND(IsDirectory(from_dir));
+  EXPECT_OK(IsDirectory(to_dir));
+  StatusOr<std::string> contents = ReadFile(Path::JoinUtf8(to_dir, "file"));
+  ASSERT_OK(contents.status());
+  EXPECT_EQ("contents", contents.ValueOrDie());
+
+  EXPECT_OK(RecursivelyDelete(root_dir));
+}
+
 TEST(FilesystemTest, FileSize) {
   Path file = Path::JoinUtf8(TempDir(), TestFilename());
   ASSERT_NOT_FOUND(FileSize(file).status());
@@ -280,6 +299,24 @@ TEST(FilesystemTest, ReadFile) {
   ASSERT_EQ(result.ValueOrDie(), "foobar");
 }
 
+TEST(FilesystemTest, MappedFile) {
+  Path file = Path::JoinUtf8(TempDir(), TestFilename());
+  ASSERT_FALSE(MappedFile::Open(file).ok());
+
+  Touch(file);
+  StatusOr<std::unique_ptr<MappedFile>> result = MappedFile::Open(file);
+  ASSERT_OK(result.status());
+  ASSERT_TRUE(result.ValueOrDie()->contents().empty());
+
+  std::string text = "foo" + std::string(10000, 'b') + "ar";
+  WriteStringToFile(file, text);
+  result = MappedFile::Open(file);
+  ASSERT_OK(result.status());
+  ASSERT_EQ(result.ValueOrDie()->contents(), text);
+
+  EXPECT_OK(RecursivelyDelete(file));
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
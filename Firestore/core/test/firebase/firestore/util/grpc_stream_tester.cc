@@ -34,6 +34,7 @@ using auth::User;
 using model::DatabaseId;
 using remote::ConnectivityMonitor;
 using remote::GrpcCompletion;
+using remote::GrpcConnection;
 using remote::GrpcStream;
 using remote::GrpcStreamingReader;
 using remote::GrpcStreamObserver;
@@ -222,7 +223,8 @@ void GrpcStreamTester::Shutdown() {
 
 std::unique_ptr<GrpcStream> GrpcStreamTester::CreateStream(
     GrpcStreamObserver* observer) {
-  return grpc_connection_.CreateStream("", Token{"", User{}}, observer);
+  return grpc_connection_.CreateStream(
+      "", GrpcConnection::StreamKind::Write, Token{"", User{}}, observer);
 }
 
 std::unique_ptr<GrpcStreamingReader> GrpcStreamTester::CreateStreamingReader() {
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/lru_cache.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+using Cache = LruCache<std::string, int>;
+
+TEST(LruCacheTest, GetReturnsNullWhenEmpty) {
+  Cache cache(10);
+  EXPECT_EQ(nullptr, cache.Get("a"));
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(0u, cache.cost());
+}
+
+TEST(LruCacheTest, PutAndGet) {
+  Cache cache(10);
+  cache.Put("a", 1, 2);
+  cache.Put("b", 2, 3);
+
+  ASSERT_NE(nullptr, cache.Get("a"));
+  EXPECT_EQ(1, *cache.Get("a"));
+  ASSERT_NE(nullptr, cache.Get("b"));
+  EXPECT_EQ(2, *cache.Get("b"));
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(5u, cache.cost());
+}
+
+TEST(LruCacheTest, PutReplacesExistingEntry) {
+  Cache cache(10);
+  cache.Put("a", 1, 2);
+  cache.Put("a", 2, 5);
+
+  ASSERT_NE(nullptr, cache.Get("a"));
+  EXPECT_EQ(2, *cache.Get("a"));
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_EQ(5u, cache.cost());
+}
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsed) {
+  Cache cache(3);
+  cache.Put("a", 1, 1);
+  cache.Put("b", 2, 1);
+  cache.Put("c", 3, 1);
+
+  // Touching "a" makes "b" the least recently used entry.
+  ASSERT_NE(nullptr, cache.Get("a"));
+  cache.Put("d", 4, 1);
+
+  EXPECT_NE(nullptr, cache.Get("a"));
+  EXPECT_EQ(nullptr, cache.Get("b"));
+  EXPECT_NE(nullptr, cache.Get("c"));
+  EXPECT_NE(nullptr, cache.Get("d"));
+  EXPECT_EQ(3u, cache.cost());
+}
+
+TEST(LruCacheTest, EvictsUntilWithinCost) {
+  Cache cache(4);
+  cache.Put("a", 1, 1);
+  cache.Put("b", 2, 1);
+  cache.Put("c", 3, 1);
+  cache.Put("d", 4, 3);
+
+  EXPECT_EQ(nullptr, cache.Get("a"));
+  EXPECT_EQ(nullptr, cache.Get("b"));
+  EXPECT_NE(nullptr, cache.Get("c"));
+  EXPECT_NE(nullptr, cache.Get("d"));
+  EXPECT_EQ(4u, cache.cost());
+}
+
+TEST(LruCacheTest, DoesNotStoreEntriesCostingMoreThanLimit) {
+  Cache cache(4);
+  cache.Put("a", 1, 1);
+  cache.Put("a", 2, 5);
+
+  EXPECT_EQ(nullptr, cache.Get("a"));
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(0u, cache.cost());
+}
+
+TEST(LruCacheTest, ZeroCostLimitDisablesCache) {
+  Cache cache(0);
+  cache.Put("a", 1, 1);
+  EXPECT_EQ(nullptr, cache.Get("a"));
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(LruCacheTest, Erase) {
+  Cache cache(10);
+  cache.Put("a", 1, 2);
+  cache.Put("b", 2, 3);
+
+  cache.Erase("a");
+  cache.Erase("missing");
+  EXPECT_EQ(nullptr, cache.Get("a"));
+  EXPECT_NE(nullptr, cache.Get("b"));
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_EQ(3u, cache.cost());
+}
+
+TEST(LruCacheTest, TrimEvictsLeastRecentlyUsed) {
+  Cache cache(10);
+  cache.Put("a", 1, 2);
+  cache.Put("b", 2, 3);
+  cache.Put("c", 3, 4);
+  cache.Get("a");
+
+  cache.Trim(6);
+  EXPECT_EQ(nullptr, cache.Get("b"));
+  EXPECT_NE(nullptr, cache.Get("a"));
+  EXPECT_NE(nullptr, cache.Get("c"));
+  EXPECT_EQ(6u, cache.cost());
+
+  // The cache may grow back to its own limit.
+  cache.Put("d", 4, 4);
+  EXPECT_EQ(10u, cache.cost());
+  EXPECT_EQ(10u, cache.max_cost());
+}
+
+TEST(LruCacheTest, Clear) {
+  Cache cache(10);
+  cache.Put("a", 1, 2);
+  cache.Put("b", 2, 3);
+
+  cache.Clear();
+  EXPECT_EQ(nullptr, cache.Get("a"));
+  EXPECT_EQ(nullptr, cache.Get("b"));
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(0u, cache.cost());
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/metrics.h"
+
+#include <cstdint>
+#include <limits>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+TEST(MetricsTest, CounterAddsIncrements) {
+  Counter counter;
+  EXPECT_EQ(0u, counter.value());
+
+  counter.Increment();
+  counter.Increment(4);
+  EXPECT_EQ(5u, counter.value());
+}
+
+TEST(MetricsTest, HistogramBucketsByPowersOfTwo) {
+  Histogram histogram;
+  histogram.Record(0);
+  histogram.Record(1);
+  histogram.Record(2);
+  histogram.Record(3);
+  histogram.Record(4);
+  histogram.Record(std::numeric_limits<uint64_t>::max());
+
+  HistogramSnapshot snapshot = histogram.Snapshot();
+  EXPECT_EQ(1u, snapshot.buckets[0]);
+  EXPECT_EQ(1u, snapshot.buckets[1]);
+  EXPECT_EQ(2u, snapshot.buckets[2]);
+  EXPECT_EQ(1u, snapshot.buckets[3]);
+  EXPECT_EQ(1u, snapshot.buckets[64]);
+  EXPECT_EQ(6u, snapshot.count);
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(), snapshot.max);
+}
+
+TEST(MetricsTest, HistogramSumsValues) {
+  Histogram histogram;
+  EXPECT_EQ(HistogramSnapshot{}, histogram.Snapshot());
+
+  histogram.Record(10);
+  histogram.Record(30);
+
+  HistogramSnapshot snapshot = histogram.Snapshot();
+  EXPECT_EQ(2u, snapshot.count);
+  EXPECT_EQ(40u, snapshot.sum);
+  EXPECT_EQ(30u, snapshot.max);
+}
+
+TEST(MetricsTest, RegistryReturnsTheSameMetricForAName) {
+  MetricsRegistry registry;
+  Counter& counter = registry.GetCounter("counter");
+  EXPECT_EQ(&counter, &registry.GetCounter("counter"));
+  EXPECT_NE(&counter, &registry.GetCounter("other"));
+
+  Histogram& histogram = registry.GetHistogram("histogram");
+  EXPECT_EQ(&histogram, &registry.GetHistogram("histogram"));
+}
+
+TEST(MetricsTest, RegistrySnapshotsAllMetrics) {
+  MetricsRegistry registry;
+  registry.GetCounter("reads").Increment(3);
+  registry.GetCounter("writes");
+  registry.GetHistogram("bytes").Record(7);
+
+  MetricsSnapshot snapshot = registry.Snapshot();
+  ASSERT_EQ(2u, snapshot.counters.size());
+  EXPECT_EQ(3u, snapshot.counters["reads"]);
+  EXPECT_EQ(0u, snapshot.counters["writes"]);
+  ASSERT_EQ(1u, snapshot.histograms.size());
+  EXPECT_EQ(7u, snapshot.histograms["bytes"].sum);
+}
+
+TEST(MetricsTest, CountsUpdatesFromManyThreads) {
+  MetricsRegistry registry;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&registry] {
+      for (int j = 0; j < 1000; ++j) {
+        registry.GetCounter("counter").Increment();
+        registry.GetHistogram("histogram").Record(1);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  MetricsSnapshot snapshot = registry.Snapshot();
+  EXPECT_EQ(4000u, snapshot.counters["counter"]);
+  EXPECT_EQ(4000u, snapshot.histograms["histogram"].count);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
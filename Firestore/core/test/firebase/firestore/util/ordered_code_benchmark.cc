@@ -15,6 +15,10 @@
  */
 
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+
+#include <string>
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 #include "benchmark/benchmark.h"
 
@@ -61,3 +65,82 @@ BENCHMARK(BM_SkipToNextSpecialByte)
     ->Arg(1 << 9)
     ->Arg(1 << 10)
     ->Arg(1 << 15);
+
+namespace {
+
+/** Returns a random 20 character ID like those created by `collection.add`. */
+std::string AutoId(SecureRandom* rnd) {
+  static const char kChars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+  std::string id;
+  for (int i = 0; i < 20; ++i) {
+    id.push_back(kChars[rnd->Uniform(sizeof(kChars) - 1)]);
+  }
+  return id;
+}
+
+/**
+ * Returns `count` document paths of the given number of segments, alternating
+ * short collection IDs with auto IDs, e.g. "rooms/<id>/messages/<id>".
+ */
+std::vector<std::vector<std::string>> DocumentPaths(int64_t segments,
+                                                    int count) {
+  SecureRandom rnd;
+  std::vector<std::vector<std::string>> paths(count);
+  for (auto& path : paths) {
+    for (int64_t i = 0; i < segments; ++i) {
+      path.push_back(i % 2 == 0 ? "messages" : AutoId(&rnd));
+    }
+  }
+  return paths;
+}
+
+}  // namespace
+
+/** Encodes document paths the way LevelDbRemoteDocumentKey does. */
+static void BM_WriteDocumentPath(benchmark::State& state) {
+  const int kValues = 1024;
+  auto paths = DocumentPaths(state.range(0), kValues);
+
+  int index = 0;
+  int64_t total_bytes = 0;
+  for (auto _ : state) {
+    std::string dest;
+    for (const std::string& segment : paths[index++ % kValues]) {
+      OrderedCode::WriteString(&dest, segment);
+    }
+    total_bytes += static_cast<int64_t>(dest.size());
+    benchmark::DoNotOptimize(dest);
+  }
+  state.SetBytesProcessed(total_bytes);
+}
+BENCHMARK(BM_WriteDocumentPath)->Arg(2)->Arg(4)->Arg(8);
+
+/** Decodes document paths the way LevelDbRemoteDocumentKey does. */
+static void BM_ReadDocumentPath(benchmark::State& state) {
+  const int kValues = 1024;
+  std::vector<std::string> encoded;
+  for (const auto& path : DocumentPaths(state.range(0), kValues)) {
+    std::string dest;
+    for (const std::string& segment : path) {
+      OrderedCode::WriteString(&dest, segment);
+    }
+    encoded.push_back(dest);
+  }
+
+  int index = 0;
+  int64_t total_bytes = 0;
+  for (auto _ : state) {
+    absl::string_view src = encoded[index++ % kValues];
+    total_bytes += static_cast<int64_t>(src.size());
+
+    std::string segment;
+    while (!src.empty()) {
+      segment.clear();
+      OrderedCode::ReadString(&src, &segment);
+      benchmark::DoNotOptimize(segment);
+    }
+  }
+  state.SetBytesProcessed(total_bytes);
+}
+BENCHMARK(BM_ReadDocumentPath)->Arg(2)->Arg(4)->Arg(8);
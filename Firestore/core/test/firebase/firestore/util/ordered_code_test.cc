@@ -415,6 +415,40 @@ TEST(OrderedCodeString, Infinity) {
   EXPECT_EQ(value, parsed);
 }
 
+TEST(OrderedCodeString, ReadStringView) {
+  std::string encoding;
+  OrderedCode::WriteString(&encoding, "rooms");
+  OrderedCode::WriteString(&encoding, std::string("a\0b", 3));
+  OrderedCode::WriteString(&encoding, "");
+
+  absl::string_view s = encoding;
+  absl::string_view view;
+  ASSERT_TRUE(OrderedCode::ReadStringView(&s, &view));
+  EXPECT_EQ("rooms", view);
+  EXPECT_EQ(encoding.data(), view.data());
+
+  // Strings with escaped bytes can't be viewed in place.
+  absl::string_view before = s;
+  EXPECT_FALSE(OrderedCode::ReadStringView(&s, &view));
+  EXPECT_EQ(before, s);
+
+  std::string parsed;
+  ASSERT_TRUE(OrderedCode::ReadString(&s, &parsed));
+  EXPECT_EQ(std::string("a\0b", 3), parsed);
+
+  ASSERT_TRUE(OrderedCode::ReadStringView(&s, &view));
+  EXPECT_EQ("", view);
+  EXPECT_TRUE(s.empty());
+
+  // Not a string at all.
+  encoding.clear();
+  OrderedCode::WriteInfinity(&encoding);
+  s = encoding;
+  EXPECT_FALSE(OrderedCode::ReadStringView(&s, &view));
+  s = absl::string_view{"abc"};
+  EXPECT_FALSE(OrderedCode::ReadStringView(&s, &view));
+}
+
 TEST(OrderedCodeString, EncodeDecode) {
   SecureRandom rnd;
   for (int i = 0; i < 1; ++i) {
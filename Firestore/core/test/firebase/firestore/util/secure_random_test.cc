@@ -55,3 +55,16 @@ TEST(SecureRandomTest, OneIn) {
   EXPECT_LT(50, count) << count;
   EXPECT_GT(150, count) << count;
 }
+
+TEST(SecureRandomTest, Fill) {
+  SecureRandom rng;
+  uint8_t bytes[1000] = {};
+  rng.Fill(bytes, sizeof(bytes));
+
+  int zeros = 0;
+  for (uint8_t byte : bytes) {
+    if (byte == 0) zeros++;
+  }
+  // Practically, zeros should be close to 4.
+  EXPECT_GT(30, zeros) << zeros;
+}
@@ -42,3 +42,13 @@ static void BM_MakeStringView(benchmark::State& state) {
   }
 }
 BENCHMARK(BM_MakeStringView);
+
+static void BM_MakeStringFromUtf16(benchmark::State& state) {
+  // Non-ASCII characters make NSString store the string as UTF-16.
+  NSString* source = [NSString stringWithUTF8String:"héllo wörld"];
+  for (auto _ : state) {
+    std::string actual = MakeString(source);
+    (void)actual;
+  }
+}
+BENCHMARK(BM_MakeStringFromUtf16);
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/thread_pool.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <future>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/test/firebase/firestore/util/async_tests_util.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace chr = std::chrono;
+
+TEST(ThreadPoolTest, RunsSubmittedOperations) {
+  ThreadPool pool{4};
+  EXPECT_EQ(pool.thread_count(), 4u);
+  EXPECT_FALSE(pool.IsWorkerThread());
+
+  std::atomic<int> remaining{1000};
+  std::promise<void> done;
+  for (int i = 0; i != 1000; ++i) {
+    pool.Submit([&] {
+      EXPECT_TRUE(pool.IsWorkerThread());
+      if (--remaining == 0) {
+        done.set_value();
+      }
+    });
+  }
+
+  ABORT_ON_TIMEOUT(done.get_future());
+}
+
+TEST(ThreadPoolTest, OperationsCanSubmitMoreOperations) {
+  ThreadPool pool{2};
+
+  std::atomic<int> remaining{64};
+  std::promise<void> done;
+  std::function<void(int)> split = [&](int depth) {
+    if (depth == 0) {
+      if (--remaining == 0) {
+        done.set_value();
+      }
+      return;
+    }
+    pool.Submit([&split, depth] { split(depth - 1); });
+    pool.Submit([&split, depth] { split(depth - 1); });
+  };
+  pool.Submit([&] { split(6); });
+
+  ABORT_ON_TIMEOUT(done.get_future());
+}
+
+TEST(ThreadPoolTest, SubmitsDelayedOperationsOnceDue) {
+  ThreadPool pool{1};
+
+  auto start = now();
+  std::promise<void> done;
+  pool.SubmitAt(start + chr::milliseconds(10), [&] {
+    EXPECT_GE(now() - start, chr::milliseconds(10));
+    done.set_value();
+  });
+
+  ABORT_ON_TIMEOUT(done.get_future());
+}
+
+TEST(ThreadPoolTest, ParallelForCallsBodyWithEachIndex) {
+  ThreadPool pool{4};
+
+  std::vector<std::atomic<int>> calls(1000);
+  for (auto& count : calls) {
+    count = 0;
+  }
+  pool.ParallelFor(calls.size(), [&](size_t i) { ++calls[i]; });
+
+  for (const auto& count : calls) {
+    EXPECT_EQ(count, 1);
+  }
+
+  pool.ParallelFor(0, [](size_t) { FAIL(); });
+}
+
+TEST(ThreadPoolTest, ParallelForCanBeNestedOnASingleWorker) {
+  ThreadPool pool{1};
+
+  std::atomic<int> sum{0};
+  std::promise<void> done;
+  pool.Submit([&] {
+    pool.ParallelFor(10, [&](size_t i) {
+      pool.ParallelFor(10, [&](size_t j) { sum += static_cast<int>(i * j); });
+    });
+    done.set_value();
+  });
+
+  ABORT_ON_TIMEOUT(done.get_future());
+  EXPECT_EQ(sum, 45 * 45);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
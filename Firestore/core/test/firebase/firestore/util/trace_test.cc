@@ -0,0 +1,100 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+struct RecordedSpan {
+  std::string name;
+  TraceClock::time_point start;
+  TraceClock::time_point end;
+};
+
+class TraceTest : public testing::Test {
+ public:
+  TraceTest()
+      : sink_{[this](const char* name, TraceClock::time_point start,
+                     TraceClock::time_point end) {
+          spans_.push_back(RecordedSpan{name, start, end});
+        }} {
+  }
+
+  ~TraceTest() override {
+    SetTraceSink(nullptr);
+  }
+
+ protected:
+  CallbackTraceSink sink_;
+  std::vector<RecordedSpan> spans_;
+};
+
+}  // namespace
+
+TEST_F(TraceTest, ReportsNothingWithoutSink) {
+  { TraceSpan span{"Untraced"}; }
+  EXPECT_TRUE(spans_.empty());
+}
+
+TEST_F(TraceTest, ReportsSpansInTheOrderTheyEnd) {
+  SetTraceSink(&sink_);
+  {
+    TraceSpan outer{"Outer"};
+    { TraceSpan inner{"Inner"}; }
+  }
+
+  ASSERT_EQ(2u, spans_.size());
+  EXPECT_EQ("Inner", spans_[0].name);
+  EXPECT_EQ("Outer", spans_[1].name);
+  EXPECT_LE(spans_[1].start, spans_[0].start);
+  EXPECT_LE(spans_[0].start, spans_[0].end);
+  EXPECT_LE(spans_[0].end, spans_[1].end);
+}
+
+TEST_F(TraceTest, ReportsSpanToTheSinkItStartedWith) {
+  SetTraceSink(&sink_);
+  {
+    TraceSpan span{"Started"};
+    SetTraceSink(nullptr);
+  }
+  { TraceSpan span{"NotStarted"}; }
+
+  ASSERT_EQ(1u, spans_.size());
+  EXPECT_EQ("Started", spans_[0].name);
+}
+
+#if !defined(FIRESTORE_DISABLE_TRACING)
+TEST_F(TraceTest, MacroTracesEnclosingScope) {
+  SetTraceSink(&sink_);
+  { FIRESTORE_TRACE_SPAN("Scope"); }
+
+  ASSERT_EQ(1u, spans_.size());
+  EXPECT_EQ("Scope", spans_[0].name);
+}
+#endif  // !defined(FIRESTORE_DISABLE_TRACING)
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/unique_function.h"
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/allocation_counter.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+int Twice(int value) {
+  return value * 2;
+}
+
+struct Counter {
+  int operator()() {
+    return ++count;
+  }
+
+  int count = 0;
+};
+
+// A callable that can only be moved.
+struct MoveOnly {
+  explicit MoveOnly(std::string value)
+      : value{absl::make_unique<std::string>(std::move(value))} {
+  }
+
+  std::string operator()() const {
+    return *value;
+  }
+
+  std::unique_ptr<std::string> value;
+};
+
+// Counts the live instances of a callable.
+struct Counted {
+  explicit Counted(int* live) : live{live} {
+    ++*live;
+  }
+  Counted(Counted&& other) noexcept : live{other.live} {
+    ++*live;
+  }
+  ~Counted() {
+    --*live;
+  }
+
+  void operator()() const {
+  }
+
+  int* live;
+  // Too large to be stored inline by a UniqueFunction with room for just a
+  // pointer.
+  std::array<char, 16> padding{};
+};
+
+}  // namespace
+
+TEST(UniqueFunctionTest, EmptyByDefault) {
+  UniqueFunction<void()> empty;
+  EXPECT_FALSE(empty);
+
+  UniqueFunction<void()> null{nullptr};
+  EXPECT_FALSE(null);
+
+  int (*null_pointer)(int) = nullptr;
+  UniqueFunction<int(int)> from_null_pointer{null_pointer};
+  EXPECT_FALSE(from_null_pointer);
+}
+
+TEST(UniqueFunctionTest, InvokesCallables) {
+  UniqueFunction<int(int)> lambda{[](int value) { return value + 1; }};
+  EXPECT_TRUE(lambda);
+  EXPECT_EQ(lambda(1), 2);
+
+  UniqueFunction<int(int)> pointer{&Twice};
+  EXPECT_EQ(pointer(3), 6);
+
+  std::function<int(int)> function = &Twice;
+  UniqueFunction<int(int)> from_function{function};
+  EXPECT_EQ(from_function(4), 8);
+}
+
+TEST(UniqueFunctionTest, InvokesMutableCallables) {
+  UniqueFunction<int()> counter{Counter{}};
+  EXPECT_EQ(counter(), 1);
+  EXPECT_EQ(counter(), 2);
+}
+
+TEST(UniqueFunctionTest, WrapsMoveOnlyCallables) {
+  UniqueFunction<std::string()> function{MoveOnly{"moved"}};
+
+  UniqueFunction<std::string()> moved{std::move(function)};
+  EXPECT_FALSE(function);  // NOLINT(bugprone-use-after-move)
+  EXPECT_EQ(moved(), "moved");
+}
+
+TEST(UniqueFunctionTest, StoresSmallCallablesInline) {
+  auto shared = std::make_shared<int>(1);
+  auto small = [shared] { return *shared; };
+  using Function = UniqueFunction<int()>;
+  static_assert(Function::StoresInline<decltype(small)>(),
+                "Small lambdas should be stored inline");
+
+  AllocationCounter counter;
+  Function function{small};
+  Function moved{std::move(function)};
+  function = std::move(moved);
+  EXPECT_EQ(function(), 1);
+  EXPECT_EQ(counter.allocations(), 0u);
+}
+
+TEST(UniqueFunctionTest, StoresLargeCallablesOnTheHeap) {
+  std::array<int, 64> values{};
+  values[63] = 42;
+  auto large = [values] { return values[63]; };
+  using Function = UniqueFunction<int()>;
+  static_assert(!Function::StoresInline<decltype(large)>(),
+                "Large lambdas can't be stored inline");
+
+  AllocationCounter counter;
+  Function function{large};
+  Function moved{std::move(function)};
+  EXPECT_EQ(moved(), 42);
+  if (AllocationCountingEnabled()) {
+    // Only wrapping allocates; moving transfers the allocation.
+    EXPECT_EQ(counter.allocations(), 1u);
+  }
+}
+
+TEST(UniqueFunctionTest, WrapsSmallerUniqueFunctionsInline) {
+  using Small = UniqueFunction<int()>;
+  using Large = UniqueFunction<int(), sizeof(Small) + 8>;
+  static_assert(Large::StoresInline<Small>(),
+                "A UniqueFunction with room for another should store it "
+                "inline");
+
+  Large empty{Small{}};
+  EXPECT_FALSE(empty);
+
+  AllocationCounter counter;
+  Large wrapped{Small{[] { return 7; }}};
+  EXPECT_EQ(wrapped(), 7);
+  EXPECT_EQ(counter.allocations(), 0u);
+}
+
+TEST(UniqueFunctionTest, DestroysCallables) {
+  int live = 0;
+  {
+    UniqueFunction<void()> function{Counted{&live}};
+    EXPECT_EQ(live, 1);
+
+    UniqueFunction<void()> moved{std::move(function)};
+    EXPECT_EQ(live, 1);
+
+    moved = nullptr;
+    EXPECT_EQ(live, 0);
+
+    moved = Counted{&live};
+    EXPECT_EQ(live, 1);
+  }
+  EXPECT_EQ(live, 0);
+
+  {
+    using Function = UniqueFunction<void(), sizeof(void*)>;
+    static_assert(!Function::StoresInline<Counted>(),
+                  "Counted should be stored on the heap");
+    Function on_heap{Counted{&live}};
+    Function moved{std::move(on_heap)};
+    EXPECT_EQ(live, 1);
+  }
+  EXPECT_EQ(live, 0);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/utf16.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+std::string Convert(const std::vector<uint16_t>& units) {
+  return Utf16ToUtf8(units.data(), units.size());
+}
+
+}  // namespace
+
+TEST(Utf16Test, ConvertsEmptyStrings) {
+  EXPECT_EQ(Utf16ToUtf8(nullptr, 0), "");
+}
+
+TEST(Utf16Test, ConvertsAscii) {
+  // Long enough for several words of ASCII, plus a few leftover characters.
+  std::string ascii{"The quick brown fox jumps over the lazy dog"};
+  std::vector<uint16_t> units{ascii.begin(), ascii.end()};
+  EXPECT_EQ(Convert(units), ascii);
+
+  EXPECT_EQ(Convert({'a', 0, 'b'}), std::string("a\0b", 3));
+}
+
+TEST(Utf16Test, ConvertsEveryEncodedLength) {
+  EXPECT_EQ(Convert({0x7F}), "\x7F");
+  EXPECT_EQ(Convert({0xE6}), u8"æ");
+  EXPECT_EQ(Convert({0x7FF}), "\xDF\xBF");
+  EXPECT_EQ(Convert({0x800}), "\xE0\xA0\x80");
+  EXPECT_EQ(Convert({0x253B}), u8"┻");
+  EXPECT_EQ(Convert({0xFFFF}), "\xEF\xBF\xBF");
+  // U+1F600, as a surrogate pair.
+  EXPECT_EQ(Convert({0xD83D, 0xDE00}), "\xF0\x9F\x98\x80");
+  // U+10FFFF, the largest code point.
+  EXPECT_EQ(Convert({0xDBFF, 0xDFFF}), "\xF4\x8F\xBF\xBF");
+}
+
+TEST(Utf16Test, ConvertsAsciiMixedWithOtherCharacters) {
+  // "(╯°□°）╯︵ ┻━┻"
+  std::vector<uint16_t> units{0x28,   0x256F, 0xB0,   0x25A1, 0xB0,
+                              0xFF09, 0x256F, 0xFE35, 0x20,   0x253B,
+                              0x2501, 0x253B};
+  EXPECT_EQ(Convert(units), u8"(╯°□°）╯︵ "
+                            u8"┻━┻");
+
+  EXPECT_EQ(Convert({'a', 'b', 'c', 0xE6, 'd', 'e', 'f', 'g', 'h'}),
+            u8"abcædefgh");
+}
+
+TEST(Utf16Test, ReplacesUnpairedSurrogates) {
+  const std::string replacement{"\xEF\xBF\xBD"};
+
+  EXPECT_EQ(Convert({0xD83D}), replacement);
+  EXPECT_EQ(Convert({0xDE00}), replacement);
+  EXPECT_EQ(Convert({0xD83D, 'a'}), replacement + "a");
+  EXPECT_EQ(Convert({0xDE00, 0xD83D}), replacement + replacement);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -17,6 +17,38 @@
 #import "FIRAuthInteropFake.h"
 #import "FUNContext.h"
 
+/** Counts the tokens fetched from it, and lets the signed-in user change. */
+@interface FUNCountingAuthInteropFake : FIRAuthInteropFake
+@property(nonatomic) NSUInteger fetchCount;
+@property(nonatomic, copy, nullable) NSString *currentUserID;
+@end
+
+@implementation FUNCountingAuthInteropFake
+
+- (void)getTokenForcingRefresh:(BOOL)forceRefresh withCallback:(FIRTokenCallback)callback {
+  self.fetchCount++;
+  [super getTokenForcingRefresh:forceRefresh withCallback:callback];
+}
+
+- (nullable NSString *)getUserID {
+  return self.currentUserID;
+}
+
+@end
+
+/** Returns an unsigned JWT that expires the given time from now. */
+static NSString *FUNTokenExpiringIn(NSTimeInterval interval) {
+  NSTimeInterval expiration = [NSDate date].timeIntervalSince1970 + interval;
+  NSData *claims = [NSJSONSerialization dataWithJSONObject:@{@"exp" : @((long long)expiration)}
+                                                   options:0
+                                                     error:NULL];
+  NSString *payload = [claims base64EncodedStringWithOptions:0];
+  payload = [payload stringByReplacingOccurrencesOfString:@"=" withString:@""];
+  payload = [payload stringByReplacingOccurrencesOfString:@"+" withString:@"-"];
+  payload = [payload stringByReplacingOccurrencesOfString:@"/" withString:@"_"];
+  return [NSString stringWithFormat:@"header.%@.signature", payload];
+}
+
 @interface FUNContextProviderTests : XCTestCase
 @end
 
@@ -70,4 +102,67 @@
   [self waitForExpectations:@[ expectation ] timeout:0.1];
 }
 
+- (NSString *)authTokenFromProvider:(FUNContextProvider *)provider {
+  __block NSString *authToken = nil;
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Got a context."];
+  [provider getContext:^(FUNContext *_Nullable context, NSError *_Nullable error) {
+    XCTAssertNil(error);
+    authToken = context.authToken;
+    [expectation fulfill];
+  }];
+  [self waitForExpectations:@[ expectation ] timeout:0.1];
+  return authToken;
+}
+
+- (void)testContextReusesUnexpiredAuthToken {
+  NSString *token = FUNTokenExpiringIn(60 * 60);
+  FUNCountingAuthInteropFake *auth = [[FUNCountingAuthInteropFake alloc] initWithToken:token
+                                                                                userID:nil
+                                                                                 error:nil];
+  auth.currentUserID = @"userID";
+  FUNContextProvider *provider = [[FUNContextProvider alloc] initWithAuth:(id<FIRAuthInterop>)auth];
+
+  XCTAssertEqualObjects([self authTokenFromProvider:provider], token);
+  XCTAssertEqualObjects([self authTokenFromProvider:provider], token);
+  XCTAssertEqual(auth.fetchCount, 1u);
+}
+
+- (void)testContextRefreshesAuthTokenAboutToExpire {
+  // Still usable, but within the refresh window.
+  NSString *token = FUNTokenExpiringIn(2 * 60);
+  FUNCountingAuthInteropFake *auth = [[FUNCountingAuthInteropFake alloc] initWithToken:token
+                                                                                userID:nil
+                                                                                 error:nil];
+  FUNContextProvider *provider = [[FUNContextProvider alloc] initWithAuth:(id<FIRAuthInterop>)auth];
+
+  XCTAssertEqualObjects([self authTokenFromProvider:provider], token);
+  XCTAssertEqualObjects([self authTokenFromProvider:provider], token);
+  XCTAssertEqual(auth.fetchCount, 2u);
+}
+
+- (void)testContextFetchesAuthTokenForNewUser {
+  NSString *token = FUNTokenExpiringIn(60 * 60);
+  FUNCountingAuthInteropFake *auth = [[FUNCountingAuthInteropFake alloc] initWithToken:token
+                                                                                userID:nil
+                                                                                 error:nil];
+  auth.currentUserID = @"user1";
+  FUNContextProvider *provider = [[FUNContextProvider alloc] initWithAuth:(id<FIRAuthInterop>)auth];
+
+  [self authTokenFromProvider:provider];
+  auth.currentUserID = @"user2";
+  [self authTokenFromProvider:provider];
+  XCTAssertEqual(auth.fetchCount, 2u);
+}
+
+- (void)testContextDoesNotCacheAuthTokenWithoutExpiration {
+  FUNCountingAuthInteropFake *auth = [[FUNCountingAuthInteropFake alloc] initWithToken:@"token"
+                                                                                userID:nil
+                                                                                 error:nil];
+  FUNContextProvider *provider = [[FUNContextProvider alloc] initWithAuth:(id<FIRAuthInterop>)auth];
+
+  XCTAssertEqualObjects([self authTokenFromProvider:provider], @"token");
+  XCTAssertEqualObjects([self authTokenFromProvider:provider], @"token");
+  XCTAssertEqual(auth.fetchCount, 2u);
+}
+
 @end
@@ -61,6 +61,8 @@ NSString *const kFUNDefaultRegion = @"us-central1";
   FUNSerializer *_serializer;
   // A factory for getting the metadata to include with function calls.
   FUNContextProvider *_contextProvider;
+  // The queue that payloads are encoded on, off the calling thread.
+  dispatch_queue_t _encodingQueue;
   // For testing only. If this is set, functions will be called against it instead of Firebase.
   NSString *_emulatorOrigin;
 }
@@ -130,6 +132,8 @@ NSString *const kFUNDefaultRegion = @"us-central1";
     _region = [region copy];
     _serializer = [[FUNSerializer alloc] init];
     _contextProvider = [[FUNContextProvider alloc] initWithAuth:auth];
+    _encodingQueue =
+        dispatch_queue_create("com.google.firebase.functions.encoding", DISPATCH_QUEUE_CONCURRENT);
     _emulatorOrigin = nil;
   }
   return self;
@@ -162,54 +166,92 @@ NSString *const kFUNDefaultRegion = @"us-central1";
              timeout:(NSTimeInterval)timeout
           completion:(void (^)(FIRHTTPSCallableResult *_Nullable result,
                                NSError *_Nullable error))completion {
-  [_contextProvider getContext:^(FUNContext *_Nullable context, NSError *_Nullable error) {
+  // Invalid names are thrown on the caller's thread.
+  NSURL *url = [NSURL URLWithString:[self URLWithName:name]];
+
+  // Encode the payload in the background while the context is gathered, so that neither the
+  // caller nor the request waits for one after the other.
+  dispatch_group_t group = dispatch_group_create();
+
+  __block NSData *payload = nil;
+  __block NSError *encodingError = nil;
+  FUNSerializer *serializer = _serializer;
+  dispatch_group_async(group, _encodingQueue, ^{
+    NSError *error = nil;
+    payload = [FIRFunctions payloadWithObject:data serializer:serializer error:&error];
+    encodingError = error;
+  });
+
+  __block FUNContext *context = nil;
+  __block NSError *contextError = nil;
+  dispatch_group_enter(group);
+  [_contextProvider getContext:^(FUNContext *_Nullable result, NSError *_Nullable error) {
+    context = result;
+    contextError = error;
+    dispatch_group_leave(group);
+  }];
+
+  dispatch_group_notify(group, _encodingQueue, ^{
+    NSError *error = contextError ?: encodingError;
     if (error) {
       if (completion) {
-        completion(nil, error);
+        dispatch_async(dispatch_get_main_queue(), ^{
+          completion(nil, error);
+        });
       }
       return;
     }
-    return [self callFunction:name
-                   withObject:data
-                      timeout:timeout
-                      context:context
-                   completion:completion];
-  }];
+    [self callFunctionAtURL:url
+                    payload:payload
+                    timeout:timeout
+                    context:context
+                 completion:completion];
+  });
 }
 
-- (void)callFunction:(NSString *)name
-          withObject:(nullable id)data
-             timeout:(NSTimeInterval)timeout
-             context:(FUNContext *)context
-          completion:(void (^)(FIRHTTPSCallableResult *_Nullable result,
-                               NSError *_Nullable error))completion {
-  NSURL *url = [NSURL URLWithString:[self URLWithName:name]];
-  NSURLRequest *request = [NSURLRequest requestWithURL:url
-                                           cachePolicy:NSURLRequestUseProtocolCachePolicy
-                                       timeoutInterval:timeout];
-  GTMSessionFetcher *fetcher = [_fetcherService fetcherWithRequest:request];
-
+/**
+ * Encodes the data of a call as the JSON body of its request. Data that can't be encoded is
+ * reported as an invalid argument error, since this runs off the caller's thread.
+ */
++ (nullable NSData *)payloadWithObject:(nullable id)data
+                            serializer:(FUNSerializer *)serializer
+                                 error:(NSError **)error {
   NSMutableDictionary *body = [NSMutableDictionary dictionary];
   // Encode the data in the body.
   if (!data) {
     data = [NSNull null];
   }
-  id encoded = [_serializer encode:data];
+  id encoded = nil;
+  @try {
+    encoded = [serializer encode:data];
+  } @catch (NSException *exception) {
+    if (![exception.name isEqualToString:NSInvalidArgumentException]) {
+      @throw;
+    }
+    NSDictionary *userInfo = @{NSLocalizedDescriptionKey : exception.reason ?: @"Invalid data."};
+    *error = [NSError errorWithDomain:FIRFunctionsErrorDomain
+                                 code:FIRFunctionsErrorCodeInvalidArgument
+                             userInfo:userInfo];
+    return nil;
+  }
   if (!encoded) {
     FUNThrowInvalidArgument(@"FIRFunctions data encoded as nil. This should not happen.");
   }
   body[@"data"] = encoded;
 
-  NSError *error = nil;
-  NSData *payload = [NSJSONSerialization dataWithJSONObject:body options:0 error:&error];
-  if (error) {
-    if (completion) {
-      dispatch_async(dispatch_get_main_queue(), ^{
-        completion(nil, error);
-      });
-    }
-    return;
-  }
+  return [NSJSONSerialization dataWithJSONObject:body options:0 error:error];
+}
+
+- (void)callFunctionAtURL:(NSURL *)url
+                  payload:(NSData *)payload
+                  timeout:(NSTimeInterval)timeout
+                  context:(FUNContext *)context
+               completion:(void (^)(FIRHTTPSCallableResult *_Nullable result,
+                                    NSError *_Nullable error))completion {
+  NSURLRequest *request = [NSURLRequest requestWithURL:url
+                                           cachePolicy:NSURLRequestUseProtocolCachePolicy
+                                       timeoutInterval:timeout];
+  GTMSessionFetcher *fetcher = [_fetcherService fetcherWithRequest:request];
   fetcher.bodyData = payload;
 
   // Set the headers.
@@ -38,6 +38,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)initWithAuth:(nullable id<FIRAuthInterop>)auth NS_DESIGNATED_INITIALIZER;
 
+/**
+ * Gets the metadata for a call. The auth token is cached while it's valid, and refreshed in the
+ * background shortly before it expires, so the completion is usually called synchronously.
+ */
 - (void)getContext:(void (^)(FUNContext *_Nullable context, NSError *_Nullable error))completion;
 
 @end
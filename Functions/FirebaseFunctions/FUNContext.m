@@ -21,6 +21,53 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+// A cached auth token is only used while it has at least this long left before it expires.
+static const NSTimeInterval kFUNAuthTokenMinimumLifetime = 60;
+
+// Once a cached auth token is this close to expiring, a new one is fetched in the background.
+static const NSTimeInterval kFUNAuthTokenRefreshWindow = 5 * 60;
+
+typedef void (^FUNAuthTokenCallback)(NSString *_Nullable token, NSError *_Nullable error);
+
+/**
+ * Returns when a Firebase Auth ID token expires, as given by the `exp` claim of the JWT, or nil if
+ * the token can't be parsed.
+ */
+static NSDate *_Nullable FUNExpirationDateForAuthToken(NSString *token) {
+  NSArray<NSString *> *parts = [token componentsSeparatedByString:@"."];
+  if (parts.count != 3) {
+    return nil;
+  }
+
+  // The payload is unpadded base64url.
+  NSMutableString *payload = [parts[1] mutableCopy];
+  [payload replaceOccurrencesOfString:@"-"
+                           withString:@"+"
+                              options:0
+                                range:NSMakeRange(0, payload.length)];
+  [payload replaceOccurrencesOfString:@"_"
+                           withString:@"/"
+                              options:0
+                                range:NSMakeRange(0, payload.length)];
+  while (payload.length % 4 != 0) {
+    [payload appendString:@"="];
+  }
+  NSData *data = [[NSData alloc] initWithBase64EncodedString:payload options:0];
+  if (!data) {
+    return nil;
+  }
+
+  id claims = [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+  if (![claims isKindOfClass:[NSDictionary class]]) {
+    return nil;
+  }
+  id expiration = claims[@"exp"];
+  if (![expiration isKindOfClass:[NSNumber class]]) {
+    return nil;
+  }
+  return [NSDate dateWithTimeIntervalSince1970:[expiration doubleValue]];
+}
+
 @interface FUNContext ()
 
 - (instancetype)initWithAuthToken:(NSString *_Nullable)authToken
@@ -45,6 +92,16 @@ NS_ASSUME_NONNULL_BEGIN
 @interface FUNContextProvider () {
   id<FIRAuthInterop> _auth;
   FUNInstanceIDProxy *_instanceIDProxy;
+
+  // The last auth token fetched, the user it was fetched for and when it expires. The token is
+  // only reused if its expiration date is known. Guarded by @synchronized(self).
+  NSString *_Nullable _cachedAuthToken;
+  NSString *_Nullable _cachedAuthTokenUserID;
+  NSDate *_Nullable _cachedAuthTokenExpirationDate;
+
+  // The callbacks waiting for the auth token fetch in flight, or nil if there is none. Guarded by
+  // @synchronized(self).
+  NSMutableArray<FUNAuthTokenCallback> *_Nullable _pendingAuthTokenCallbacks;
 }
 @end
 
@@ -64,31 +121,91 @@ NS_ASSUME_NONNULL_BEGIN
   return [_instanceIDProxy token];
 }
 
+- (FUNContext *)contextWithAuthToken:(nullable NSString *)authToken {
+  return [[FUNContext alloc] initWithAuthToken:authToken instanceIDToken:[self instanceIDToken]];
+}
+
 - (void)getContext:(void (^)(FUNContext *_Nullable context, NSError *_Nullable error))completion {
   // If auth isn't included, call the completion handler and return.
   if (_auth == nil) {
     // With no auth, just populate instanceIDToken and call the completion handler.
-    NSString *instanceIDToken = [self instanceIDToken];
-    FUNContext *context = [[FUNContext alloc] initWithAuthToken:nil
-                                                instanceIDToken:instanceIDToken];
-    completion(context, nil);
+    completion([self contextWithAuthToken:nil], nil);
     return;
   }
 
-  // Auth exists, get the auth token.
+  // Auth exists. Reuse the last auth token while it's valid, so that calls don't wait for Auth.
+  NSDate *expirationDate = nil;
+  NSString *cachedToken = [self cachedAuthTokenWithExpirationDate:&expirationDate];
+  if (cachedToken) {
+    // Fetch the next token ahead of time, so that no call has to wait for it either.
+    if ([expirationDate timeIntervalSinceNow] < kFUNAuthTokenRefreshWindow) {
+      [self fetchAuthToken:nil];
+    }
+    completion([self contextWithAuthToken:cachedToken], nil);
+    return;
+  }
+
+  [self fetchAuthToken:^(NSString *_Nullable token, NSError *_Nullable error) {
+    if (error) {
+      completion(nil, error);
+      return;
+    }
+    completion([self contextWithAuthToken:token], nil);
+  }];
+}
+
+/**
+ * Returns the cached auth token if it was fetched for the current user and doesn't expire soon,
+ * along with its expiration date.
+ */
+- (nullable NSString *)cachedAuthTokenWithExpirationDate:(NSDate **)expirationDate {
+  NSString *userID = [_auth getUserID];
+  @synchronized(self) {
+    BOOL sameUser = userID == _cachedAuthTokenUserID || [userID isEqual:_cachedAuthTokenUserID];
+    if (!_cachedAuthTokenExpirationDate || !sameUser ||
+        [_cachedAuthTokenExpirationDate timeIntervalSinceNow] < kFUNAuthTokenMinimumLifetime) {
+      return nil;
+    }
+    *expirationDate = _cachedAuthTokenExpirationDate;
+    return _cachedAuthToken;
+  }
+}
+
+/**
+ * Gets an auth token from Auth and caches it. Calls made while a fetch is in flight wait for that
+ * fetch rather than starting another.
+ */
+- (void)fetchAuthToken:(nullable FUNAuthTokenCallback)callback {
+  @synchronized(self) {
+    BOOL fetching = _pendingAuthTokenCallbacks != nil;
+    if (!fetching) {
+      _pendingAuthTokenCallbacks = [NSMutableArray array];
+    }
+    if (callback) {
+      [_pendingAuthTokenCallbacks addObject:callback];
+    }
+    if (fetching) {
+      return;
+    }
+  }
+
+  NSString *userID = [_auth getUserID];
   [_auth getTokenForcingRefresh:NO
                    withCallback:^(NSString *_Nullable token, NSError *_Nullable error) {
-                     if (error) {
-                       completion(nil, error);
-                       return;
+                     NSArray<FUNAuthTokenCallback> *callbacks;
+                     @synchronized(self) {
+                       callbacks = self->_pendingAuthTokenCallbacks;
+                       self->_pendingAuthTokenCallbacks = nil;
+                       if (!error) {
+                         self->_cachedAuthToken = [token copy];
+                         self->_cachedAuthTokenUserID = [userID copy];
+                         self->_cachedAuthTokenExpirationDate =
+                             token ? FUNExpirationDateForAuthToken(token) : nil;
+                       }
+                     }
+                     for (FUNAuthTokenCallback pending in callbacks) {
+                       pending(token, error);
                      }
-
-                     // Get the instance id token.
-                     NSString *_Nullable instanceIDToken = [self instanceIDToken];
-
-                     FUNContext *context = [[FUNContext alloc] initWithAuthToken:token
-                                                                 instanceIDToken:instanceIDToken];
-                     completion(context, nil);
                    }];
 }
 
@@ -18,21 +18,54 @@
 
 @implementation GDTDataFuture
 
-- (instancetype)initWithFileURL:(NSURL *)fileURL {
+- (instancetype)init {
   self = [super init];
+  if (self) {
+    _byteRange = NSMakeRange(NSNotFound, 0);
+  }
+  return self;
+}
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL {
+  self = [self init];
   if (self) {
     _fileURL = fileURL;
   }
   return self;
 }
 
+- (instancetype)initWithFileURL:(NSURL *)fileURL byteRange:(NSRange)byteRange {
+  self = [self initWithFileURL:fileURL];
+  if (self) {
+    _byteRange = byteRange;
+  }
+  return self;
+}
+
+- (NSData *)data {
+  if (_originalData) {
+    return _originalData;
+  }
+  if (!_fileURL) {
+    return nil;
+  }
+  if (_byteRange.location == NSNotFound) {
+    return [NSData dataWithContentsOfURL:_fileURL];
+  }
+  NSFileHandle *fileHandle = [NSFileHandle fileHandleForReadingFromURL:_fileURL error:nil];
+  [fileHandle seekToFileOffset:_byteRange.location];
+  NSData *data = [fileHandle readDataOfLength:_byteRange.length];
+  [fileHandle closeFile];
+  return data.length == _byteRange.length ? data : nil;
+}
+
 - (BOOL)isEqual:(id)object {
   return [self hash] == [object hash];
 }
 
 - (NSUInteger)hash {
   // In reality, only one of these should be populated.
-  return [_fileURL hash] ^ [_originalData hash];
+  return [_fileURL hash] ^ [_originalData hash] ^ _byteRange.location ^ (_byteRange.length << 1);
 }
 
 #pragma mark - NSSecureCoding
@@ -43,6 +76,12 @@ static NSString *kGDTDataFutureFileURLKey = @"GDTDataFutureFileURLKey";
 /** Coding key for _data ivar. */
 static NSString *kGDTDataFutureDataKey = @"GDTDataFutureDataKey";
 
+/** Coding key for the location of the _byteRange ivar. */
+static NSString *kGDTDataFutureByteRangeLocationKey = @"GDTDataFutureByteRangeLocationKey";
+
+/** Coding key for the length of the _byteRange ivar. */
+static NSString *kGDTDataFutureByteRangeLengthKey = @"GDTDataFutureByteRangeLengthKey";
+
 + (BOOL)supportsSecureCoding {
   return YES;
 }
@@ -50,6 +89,10 @@ static NSString *kGDTDataFutureDataKey = @"GDTDataFutureDataKey";
 - (void)encodeWithCoder:(nonnull NSCoder *)aCoder {
   [aCoder encodeObject:_fileURL forKey:kGDTDataFutureFileURLKey];
   [aCoder encodeObject:_originalData forKey:kGDTDataFutureDataKey];
+  if (_byteRange.location != NSNotFound) {
+    [aCoder encodeInt64:(int64_t)_byteRange.location forKey:kGDTDataFutureByteRangeLocationKey];
+    [aCoder encodeInt64:(int64_t)_byteRange.length forKey:kGDTDataFutureByteRangeLengthKey];
+  }
 }
 
 - (nullable instancetype)initWithCoder:(nonnull NSCoder *)aDecoder {
@@ -57,6 +100,11 @@ static NSString *kGDTDataFutureDataKey = @"GDTDataFutureDataKey";
   if (self) {
     _fileURL = [aDecoder decodeObjectOfClass:[NSURL class] forKey:kGDTDataFutureFileURLKey];
     _originalData = [aDecoder decodeObjectOfClass:[NSData class] forKey:kGDTDataFutureDataKey];
+    if ([aDecoder containsValueForKey:kGDTDataFutureByteRangeLocationKey]) {
+      _byteRange = NSMakeRange(
+          (NSUInteger)[aDecoder decodeInt64ForKey:kGDTDataFutureByteRangeLocationKey],
+          (NSUInteger)[aDecoder decodeInt64ForKey:kGDTDataFutureByteRangeLengthKey]);
+    }
   }
   return self;
 }
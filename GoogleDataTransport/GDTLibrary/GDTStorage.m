@@ -42,7 +42,29 @@ static NSString *GDTStoragePath() {
   return storagePath;
 }
 
-@implementation GDTStorage
+/** The size after which an event log file isn't appended to anymore. Log files are deleted once
+ * all of their events have been removed, so smaller files free disk space sooner.
+ */
+static const unsigned long long kGDTMaxLogFileSize = 256 * 1024;
+
+/** The types of the records of the journal. Each record is one of these bytes, followed by the
+ * length of the keyed archive of the stored event as 4 little-endian bytes and the archive.
+ */
+typedef NS_ENUM(uint8_t, GDTJournalRecordType) {
+  GDTJournalRecordTypeStore = 1,
+  GDTJournalRecordTypeRemove = 2,
+};
+
+@implementation GDTStorage {
+  /** The event log file that events are appended to. */
+  NSFileHandle *_currentLogFile;
+
+  /** The path of the event log file that events are appended to. */
+  NSString *_currentLogFilePath;
+
+  /** The size of the event log file that events are appended to. */
+  unsigned long long _currentLogFileSize;
+}
 
 + (NSString *)archivePath {
   static NSString *archivePath;
@@ -53,6 +75,15 @@ static NSString *GDTStoragePath() {
   return archivePath;
 }
 
++ (NSString *)journalPath {
+  static NSString *journalPath;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    journalPath = [GDTStoragePath() stringByAppendingPathComponent:@"GDTStorageJournal"];
+  });
+  return journalPath;
+}
+
 + (instancetype)sharedInstance {
   static GDTStorage *sharedStorage;
   static dispatch_once_t onceToken;
@@ -68,6 +99,7 @@ static NSString *GDTStoragePath() {
     _storageQueue = dispatch_queue_create("com.google.GDTStorage", DISPATCH_QUEUE_SERIAL);
     _targetToEventSet = [[NSMutableDictionary alloc] init];
     _storedEvents = [[NSMutableOrderedSet alloc] init];
+    _logFileToEventCount = [[NSMutableDictionary alloc] init];
     _uploadCoordinator = [GDTUploadCoordinator sharedInstance];
   }
   return self;
@@ -91,11 +123,13 @@ static NSString *GDTStoragePath() {
     id<GDTPrioritizer> prioritizer = [GDTRegistrar sharedInstance].targetToPrioritizer[@(target)];
     GDTAssert(prioritizer, @"There's no prioritizer registered for the given target.");
 
-    // Write the transport bytes to disk, get a filename.
+    // Append the transport bytes to the event log, get where they were written.
     GDTAssert(event.dataObjectTransportBytes, @"The event should have been serialized to bytes");
-    NSURL *eventFile = [self saveEventBytesToDisk:event.dataObjectTransportBytes
-                                        eventHash:event.hash];
-    GDTDataFuture *dataFuture = [[GDTDataFuture alloc] initWithFileURL:eventFile];
+    NSRange byteRange;
+    NSURL *logFile = [self appendEventBytesToLog:event.dataObjectTransportBytes
+                                       byteRange:&byteRange];
+    GDTDataFuture *dataFuture = [[GDTDataFuture alloc] initWithFileURL:logFile
+                                                             byteRange:byteRange];
     GDTStoredEvent *storedEvent = [event storedEventWithDataFuture:dataFuture];
 
     // Add event to tracking collections.
@@ -109,9 +143,9 @@ static NSString *GDTStoragePath() {
       [self.uploadCoordinator forceUploadForTarget:target];
     }
 
-    // If running in the background, save state to disk and end the associated background task.
+    // If running in the background, journal the event and end the associated background task.
     if (bgID != GDTBackgroundIdentifierInvalid) {
-      [NSKeyedArchiver archiveRootObject:self toFile:[GDTStorage archivePath]];
+      [self appendJournalRecord:GDTJournalRecordTypeStore event:storedEvent];
       [[GDTApplication sharedApplication] endBackgroundTask:bgID];
     }
   });
@@ -122,16 +156,15 @@ static NSString *GDTStoragePath() {
   dispatch_async(_storageQueue, ^{
     for (GDTStoredEvent *event in eventsToRemove) {
       // Remove from disk, first and foremost.
-      NSError *error;
-      if (event.dataFuture.fileURL) {
-        NSURL *fileURL = event.dataFuture.fileURL;
-        [[NSFileManager defaultManager] removeItemAtURL:fileURL error:&error];
-        GDTAssert(error == nil, @"There was an error removing an event file: %@", error);
-      }
+      [self removeEventBytesFromDisk:event];
 
       // Remove from the tracking collections.
       [self.storedEvents removeObject:event];
       [self.targetToEventSet[event.target] removeObject:event];
+
+      if (self->_runningInBackground) {
+        [self appendJournalRecord:GDTJournalRecordTypeRemove event:event];
+      }
     }
   });
 }
@@ -150,29 +183,182 @@ static NSString *GDTStoragePath() {
   }
 }
 
-/** Saves the event's dataObjectTransportBytes to a file using NSData mechanisms.
+/** Appends the event's dataObjectTransportBytes to the current event log file, starting a new one
+ * if there's none or it has grown too large.
  *
  * @note This method should only be called from a method within a block on _storageQueue to maintain
  * thread safety.
  *
  * @param transportBytes The transport bytes of the event.
- * @param eventHash The hash value of the event.
- * @return The filename
+ * @param byteRange Set to the range of bytes of the log file holding the transport bytes.
+ * @return The URL of the log file.
+ */
+- (NSURL *)appendEventBytesToLog:(NSData *)transportBytes byteRange:(NSRange *)byteRange {
+  if (!_currentLogFile || _currentLogFileSize >= kGDTMaxLogFileSize) {
+    [self closeCurrentLogFile];
+    NSString *logFile = [NSString stringWithFormat:@"events-%@", [NSUUID UUID].UUIDString];
+    _currentLogFilePath = [GDTStoragePath() stringByAppendingPathComponent:logFile];
+    if (![[NSFileManager defaultManager] createFileAtPath:_currentLogFilePath
+                                                 contents:nil
+                                               attributes:nil]) {
+      GDTLogError(GDTMCEFileWriteError, @"An event log file could not be created: %@",
+                  _currentLogFilePath);
+    }
+    _currentLogFile = [NSFileHandle fileHandleForWritingAtPath:_currentLogFilePath];
+    _currentLogFileSize = 0;
+  }
+
+  NSString *logFilePath = _currentLogFilePath;
+  *byteRange = NSMakeRange((NSUInteger)_currentLogFileSize, transportBytes.length);
+  @try {
+    [_currentLogFile writeData:transportBytes];
+    _currentLogFileSize += transportBytes.length;
+  } @catch (NSException *exception) {
+    GDTLogError(GDTMCEFileWriteError, @"An event couldn't be written to %@: %@", logFilePath,
+                exception);
+    // Whatever part of the event was written can't be told apart from the next event.
+    [self closeCurrentLogFile];
+  }
+  NSUInteger eventCount = _logFileToEventCount[logFilePath].unsignedIntegerValue;
+  _logFileToEventCount[logFilePath] = @(eventCount + 1);
+  return [NSURL fileURLWithPath:logFilePath];
+}
+
+- (void)closeCurrentLogFile {
+  [_currentLogFile closeFile];
+  _currentLogFile = nil;
+  _currentLogFilePath = nil;
+  _currentLogFileSize = 0;
+}
+
+/** Removes the event's transport bytes from disk. Events appended to a log file are removed by
+ * deleting the whole file along with the last of its events.
+ *
+ * @note This method should only be called from a method within a block on _storageQueue to maintain
+ * thread safety.
+ *
+ * @param event The event to remove.
+ */
+- (void)removeEventBytesFromDisk:(GDTStoredEvent *)event {
+  NSURL *fileURL = event.dataFuture.fileURL;
+  if (!fileURL) {
+    return;
+  }
+  if (event.dataFuture.byteRange.location != NSNotFound) {
+    if (![_storedEvents containsObject:event]) {
+      return;
+    }
+    NSString *logFilePath = fileURL.path;
+    NSUInteger eventCount = _logFileToEventCount[logFilePath].unsignedIntegerValue;
+    if (eventCount > 1) {
+      _logFileToEventCount[logFilePath] = @(eventCount - 1);
+      return;
+    }
+    [_logFileToEventCount removeObjectForKey:logFilePath];
+    if ([logFilePath isEqualToString:_currentLogFilePath]) {
+      [self closeCurrentLogFile];
+    }
+  }
+  NSError *error;
+  [[NSFileManager defaultManager] removeItemAtURL:fileURL error:&error];
+  GDTAssert(error == nil, @"There was an error removing an event file: %@", error);
+}
+
+/** Counts the stored events held by each event log file.
+ *
+ * @note This method should only be called from a method within a block on _storageQueue to maintain
+ * thread safety.
  */
-- (NSURL *)saveEventBytesToDisk:(NSData *)transportBytes eventHash:(NSUInteger)eventHash {
-  NSString *storagePath = GDTStoragePath();
-  NSString *event = [NSString stringWithFormat:@"event-%lu", (unsigned long)eventHash];
-  NSURL *eventFilePath = [NSURL fileURLWithPath:[storagePath stringByAppendingPathComponent:event]];
+- (void)countEventsInLogFiles {
+  [_logFileToEventCount removeAllObjects];
+  for (GDTStoredEvent *event in _storedEvents) {
+    NSString *logFilePath = event.dataFuture.fileURL.path;
+    if (logFilePath && event.dataFuture.byteRange.location != NSNotFound) {
+      _logFileToEventCount[logFilePath] =
+          @(_logFileToEventCount[logFilePath].unsignedIntegerValue + 1);
+    }
+  }
+}
+
+/** Appends a record of the event being stored or removed to the journal.
+ *
+ * @note This method should only be called from a method within a block on _storageQueue to maintain
+ * thread safety.
+ *
+ * @param type Whether the event was stored or removed.
+ * @param event The event.
+ */
+- (void)appendJournalRecord:(GDTJournalRecordType)type event:(GDTStoredEvent *)event {
+  NSData *eventData = [NSKeyedArchiver archivedDataWithRootObject:event];
+  uint8_t recordType = type;
+  uint32_t length = CFSwapInt32HostToLittle((uint32_t)eventData.length);
+  NSMutableData *record = [NSMutableData dataWithBytes:&recordType length:sizeof(recordType)];
+  [record appendBytes:&length length:sizeof(length)];
+  [record appendData:eventData];
+
+  NSString *journalPath = [GDTStorage journalPath];
+  if (![[NSFileManager defaultManager] fileExistsAtPath:journalPath]) {
+    [[NSFileManager defaultManager] createFileAtPath:journalPath contents:nil attributes:nil];
+  }
+  NSFileHandle *journal = [NSFileHandle fileHandleForWritingAtPath:journalPath];
+  @try {
+    [journal seekToEndOfFile];
+    [journal writeData:record];
+  } @catch (NSException *exception) {
+    GDTLogError(GDTMCEFileWriteError, @"The storage journal couldn't be written: %@", exception);
+  }
+  [journal closeFile];
+}
 
-  GDTAssert(![[NSFileManager defaultManager] fileExistsAtPath:eventFilePath.path],
-            @"An event shouldn't already exist at this path: %@", eventFilePath.path);
+/** Applies the records of the journal to the tracking collections.
+ *
+ * @note This method should only be called from a method within a block on _storageQueue to maintain
+ * thread safety.
+ */
+- (void)replayJournal {
+  NSData *journal = [NSData dataWithContentsOfFile:[GDTStorage journalPath]];
+  const NSUInteger headerLength = sizeof(uint8_t) + sizeof(uint32_t);
+  NSUInteger offset = 0;
+  while (offset + headerLength <= journal.length) {
+    uint8_t recordType;
+    uint32_t length;
+    [journal getBytes:&recordType range:NSMakeRange(offset, sizeof(recordType))];
+    [journal getBytes:&length range:NSMakeRange(offset + sizeof(recordType), sizeof(length))];
+    length = CFSwapInt32LittleToHost(length);
+    offset += headerLength;
+    if (offset + length > journal.length) {
+      // The last record was cut short.
+      break;
+    }
+    NSData *eventData = [journal subdataWithRange:NSMakeRange(offset, length)];
+    offset += length;
 
-  BOOL writingSuccess = [transportBytes writeToURL:eventFilePath atomically:YES];
-  if (!writingSuccess) {
-    GDTLogError(GDTMCEFileWriteError, @"An event file could not be written: %@", eventFilePath);
+    GDTStoredEvent *event = [NSKeyedUnarchiver unarchiveObjectWithData:eventData];
+    if (![event isKindOfClass:[GDTStoredEvent class]]) {
+      continue;
+    }
+    if (recordType == GDTJournalRecordTypeStore) {
+      if (![_storedEvents containsObject:event]) {
+        [self addEventToTrackingCollections:event];
+      }
+    } else if (recordType == GDTJournalRecordTypeRemove) {
+      [_storedEvents removeObject:event];
+      [_targetToEventSet[event.target] removeObject:event];
+    }
   }
+  [self countEventsInLogFiles];
+}
 
-  return eventFilePath;
+/** Saves the singleton to disk. The journal starts over, since the archive includes everything the
+ * journal recorded.
+ */
+- (void)archiveToDisk {
+  // Anything stored or removed between removing the journal and the singleton being encoded is
+  // in both, and replaying the journal on top of the archive doesn't change it.
+  dispatch_sync(_storageQueue, ^{
+    [[NSFileManager defaultManager] removeItemAtPath:[GDTStorage journalPath] error:nil];
+  });
+  [NSKeyedArchiver archiveRootObject:self toFile:[GDTStorage archivePath]];
 }
 
 /** Adds the event to internal tracking collections.
@@ -194,12 +380,15 @@ static NSString *GDTStoragePath() {
 
 - (void)appWillForeground:(GDTApplication *)app {
   [NSKeyedUnarchiver unarchiveObjectWithFile:[GDTStorage archivePath]];
+  dispatch_async(_storageQueue, ^{
+    [self replayJournal];
+  });
   self->_runningInBackground = NO;
 }
 
 - (void)appWillBackground:(GDTApplication *)app {
   self->_runningInBackground = YES;
-  [NSKeyedArchiver archiveRootObject:self toFile:[GDTStorage archivePath]];
+  [self archiveToDisk];
   // Create an immediate background task to run until the end of the current queue of work.
   __block GDTBackgroundIdentifier bgID = [app beginBackgroundTaskWithExpirationHandler:^{
     [app endBackgroundTask:bgID];
@@ -210,7 +399,7 @@ static NSString *GDTStoragePath() {
 }
 
 - (void)appWillTerminate:(GDTApplication *)application {
-  [NSKeyedArchiver archiveRootObject:self toFile:[GDTStorage archivePath]];
+  [self archiveToDisk];
 }
 
 #pragma mark - NSSecureCoding
@@ -240,6 +429,7 @@ static NSString *const kGDTStorageUploadCoordinatorKey = @"GDTStorageUploadCoord
     sharedInstance->_uploadCoordinator =
         [aDecoder decodeObjectOfClass:[GDTUploadCoordinator class]
                                forKey:kGDTStorageUploadCoordinatorKey];
+    [sharedInstance countEventsInLogFiles];
   });
   return sharedInstance;
 }
@@ -32,6 +32,12 @@ NS_ASSUME_NONNULL_BEGIN
 /** All the events that have been stored. */
 @property(readonly, nonatomic) NSMutableOrderedSet<GDTStoredEvent *> *storedEvents;
 
+/** A map of the paths of the event log files to the number of stored events they still hold. A
+ * log file is deleted once none of its events are stored anymore.
+ */
+@property(readonly, nonatomic)
+    NSMutableDictionary<NSString *, NSNumber *> *logFileToEventCount;
+
 /** The upload coordinator instance used by this storage instance. */
 @property(nonatomic) GDTUploadCoordinator *uploadCoordinator;
 
@@ -46,6 +52,21 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (NSString *)archivePath;
 
+/** Returns the path to the journal of the events stored and removed while running in the
+ * background since the singleton was last saved to disk. Replaying it on top of the keyed archive
+ * restores the current state, so stores don't need to save the whole singleton again.
+ *
+ * @return File path to the journal.
+ */
++ (NSString *)journalPath;
+
+/** Stops appending events to the current event log file, so that the next event starts a new one.
+ *
+ * @note This method should only be called from a method within a block on storageQueue to maintain
+ * thread safety.
+ */
+- (void)closeCurrentLogFile;
+
 @end
 
 NS_ASSUME_NONNULL_END
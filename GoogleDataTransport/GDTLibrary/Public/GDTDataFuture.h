@@ -30,6 +30,11 @@ NS_ASSUME_NONNULL_BEGIN
 /** If not nil, this data future was instantiated with this NSData instance. */
 @property(nullable, readonly, nonatomic) NSData *originalData;
 
+/** The range of bytes of the file at fileURL holding the data, or {NSNotFound, 0} if the data is
+ * the whole file.
+ */
+@property(readonly, nonatomic) NSRange byteRange;
+
 /** Initializes an instance with the given the fileURL.
  *
  * @param fileURL The fileURL containing the data to return in -data.
@@ -37,6 +42,14 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (instancetype)initWithFileURL:(NSURL *)fileURL;
 
+/** Initializes an instance with the given range of bytes of the file at fileURL.
+ *
+ * @param fileURL The fileURL of the file holding the data to return in -data.
+ * @param byteRange The range of bytes of the file holding the data.
+ * @return An instance of this class.
+ */
+- (instancetype)initWithFileURL:(NSURL *)fileURL byteRange:(NSRange)byteRange;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -24,8 +24,14 @@
   dispatch_sync(self.storageQueue, ^{
     [self.targetToEventSet removeAllObjects];
     [self.storedEvents removeAllObjects];
+    [self closeCurrentLogFile];
+    for (NSString *logFilePath in self.logFileToEventCount) {
+      [[NSFileManager defaultManager] removeItemAtPath:logFilePath error:nil];
+    }
+    [self.logFileToEventCount removeAllObjects];
     NSError *error;
     [[NSFileManager defaultManager] removeItemAtPath:[GDTStorage archivePath] error:&error];
+    [[NSFileManager defaultManager] removeItemAtPath:[GDTStorage journalPath] error:nil];
   });
 }
 
@@ -53,7 +53,7 @@
 
   // In real usage, you'd create an instance of whatever request proto your server needs.
   for (GDTStoredEvent *event in package.events) {
-    NSData *fileData = [NSData dataWithContentsOfURL:event.dataFuture.fileURL];
+    NSData *fileData = event.dataFuture.data;
     NSAssert(fileData, @"An event file shouldn't be empty");
     [uploadData appendData:fileData];
   }
@@ -33,4 +33,24 @@
   XCTAssertTrue([GDTDataFuture supportsSecureCoding]);
 }
 
+/** Tests reading a range of bytes of a file, and encoding and decoding the range. */
+- (void)testByteRange {
+  NSString *filePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"GDTDataFutureTest"];
+  [[@"firstsecond" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:filePath atomically:YES];
+  NSURL *fileURL = [NSURL fileURLWithPath:filePath];
+
+  GDTDataFuture *dataFuture = [[GDTDataFuture alloc] initWithFileURL:fileURL
+                                                           byteRange:NSMakeRange(5, 6)];
+  XCTAssertEqualObjects(dataFuture.data, [@"second" dataUsingEncoding:NSUTF8StringEncoding]);
+  XCTAssertNotEqualObjects(dataFuture, [[GDTDataFuture alloc] initWithFileURL:fileURL]);
+
+  NSData *archiveData = [NSKeyedArchiver archivedDataWithRootObject:dataFuture];
+  GDTDataFuture *decodedDataFuture = [NSKeyedUnarchiver unarchiveObjectWithData:archiveData];
+  XCTAssertEqual(decodedDataFuture.byteRange.location, 5);
+  XCTAssertEqual(decodedDataFuture.byteRange.length, 6);
+  XCTAssertEqualObjects(decodedDataFuture, dataFuture);
+
+  [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+}
+
 @end
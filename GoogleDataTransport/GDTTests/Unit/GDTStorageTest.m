@@ -192,26 +192,58 @@ static NSInteger target = 1337;
     XCTAssertEqual([GDTStorage sharedInstance].storedEvents.count, 3);
     XCTAssertEqual([GDTStorage sharedInstance].targetToEventSet[@(target)].count, 3);
 
-    NSURL *event1File = storedEvent1.dataFuture.fileURL;
-    XCTAssertNotNil(event1File);
-    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:event1File.path]);
+    // The events are appended to the same log file.
+    NSURL *eventFile = storedEvent1.dataFuture.fileURL;
+    XCTAssertNotNil(eventFile);
+    XCTAssertEqualObjects(storedEvent2.dataFuture.fileURL, eventFile);
+    XCTAssertEqualObjects(storedEvent3.dataFuture.fileURL, eventFile);
+    XCTAssertEqualObjects(storedEvent1.dataFuture.data,
+                          [@"testString1" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqualObjects(storedEvent2.dataFuture.data,
+                          [@"testString2" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertEqualObjects(storedEvent3.dataFuture.data,
+                          [@"testString3" dataUsingEncoding:NSUTF8StringEncoding]);
+    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:eventFile.path]);
     NSError *error;
-    XCTAssertTrue([[NSFileManager defaultManager] removeItemAtURL:event1File error:&error]);
+    XCTAssertTrue([[NSFileManager defaultManager] removeItemAtURL:eventFile error:&error]);
     XCTAssertNil(error, @"There was an error deleting the eventFile: %@", error);
+  });
+}
 
-    NSURL *event2File = storedEvent2.dataFuture.fileURL;
-    XCTAssertNotNil(event2File);
-    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:event2File.path]);
-    error = nil;
-    XCTAssertTrue([[NSFileManager defaultManager] removeItemAtURL:event2File error:&error]);
-    XCTAssertNil(error, @"There was an error deleting the eventFile: %@", error);
+/** Tests that a log file is only deleted once all of its events have been removed. */
+- (void)testLogFileIsKeptUntilAllOfItsEventsAreRemoved {
+  GDTStorage *storage = [GDTStorage sharedInstance];
+  __block GDTStoredEvent *storedEvent1, *storedEvent2;
 
-    NSURL *event3File = storedEvent3.dataFuture.fileURL;
-    XCTAssertNotNil(event3File);
-    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:event3File.path]);
-    error = nil;
-    XCTAssertTrue([[NSFileManager defaultManager] removeItemAtURL:event3File error:&error]);
-    XCTAssertNil(error, @"There was an error deleting the eventFile: %@", error);
+  // events are autoreleased, and the pool needs to drain.
+  @autoreleasepool {
+    GDTEvent *event = [[GDTEvent alloc] initWithMappingID:@"404" target:target];
+    event.dataObjectTransportBytes = [@"testString1" dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertNoThrow([storage storeEvent:event]);
+    dispatch_sync(storage.storageQueue, ^{
+      storedEvent1 = [storage.storedEvents lastObject];
+    });
+
+    event = [[GDTEvent alloc] initWithMappingID:@"100" target:target];
+    event.dataObjectTransportBytes = [@"testString2" dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertNoThrow([storage storeEvent:event]);
+    dispatch_sync(storage.storageQueue, ^{
+      storedEvent2 = [storage.storedEvents lastObject];
+    });
+  }
+  NSURL *eventFile = storedEvent1.dataFuture.fileURL;
+
+  [storage removeEvents:[NSSet setWithObject:storedEvent1]];
+  dispatch_sync(storage.storageQueue, ^{
+    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:eventFile.path]);
+    XCTAssertEqualObjects(storedEvent2.dataFuture.data,
+                          [@"testString2" dataUsingEncoding:NSUTF8StringEncoding]);
+  });
+
+  [storage removeEvents:[NSSet setWithObject:storedEvent2]];
+  dispatch_sync(storage.storageQueue, ^{
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:eventFile.path]);
+    XCTAssertEqual(storage.storedEvents.count, 0);
   });
 }
 
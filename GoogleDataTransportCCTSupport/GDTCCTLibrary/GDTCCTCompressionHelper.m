@@ -0,0 +1,82 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import "GDTCCTLibrary/Private/GDTCCTCompressionHelper.h"
+
+#import <zlib.h>
+
+/** The windowBits value that makes zlib use the gzip format: the largest window, plus 16. */
+static const int kGDTCCTGzipWindowBits = MAX_WBITS + 16;
+
+/** The size of the chunks that data is decompressed into. */
+static const NSUInteger kGDTCCTInflateChunkSize = 16 * 1024;
+
+@implementation GDTCCTCompressionHelper
+
++ (nullable NSData *)gzippedData:(NSData *)data {
+  if (data.length > UINT_MAX) {
+    return nil;
+  }
+  z_stream stream;
+  memset(&stream, 0, sizeof(z_stream));
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, kGDTCCTGzipWindowBits, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return nil;
+  }
+
+  // The bound covers deflate's own output; the gzip header and trailer take up to 18 more bytes.
+  NSMutableData *compressedData =
+      [NSMutableData dataWithLength:deflateBound(&stream, (uLong)data.length) + 18];
+  stream.next_in = (Bytef *)data.bytes;
+  stream.avail_in = (uInt)data.length;
+  stream.next_out = (Bytef *)compressedData.mutableBytes;
+  stream.avail_out = (uInt)compressedData.length;
+  int result = deflate(&stream, Z_FINISH);
+  deflateEnd(&stream);
+  if (result != Z_STREAM_END) {
+    return nil;
+  }
+  compressedData.length = stream.total_out;
+  return compressedData;
+}
+
++ (nullable NSData *)gunzippedData:(NSData *)data {
+  if (data.length > UINT_MAX) {
+    return nil;
+  }
+  z_stream stream;
+  memset(&stream, 0, sizeof(z_stream));
+  if (inflateInit2(&stream, kGDTCCTGzipWindowBits) != Z_OK) {
+    return nil;
+  }
+
+  NSMutableData *decompressedData = [NSMutableData dataWithCapacity:data.length * 2];
+  stream.next_in = (Bytef *)data.bytes;
+  stream.avail_in = (uInt)data.length;
+  int result = Z_OK;
+  while (result == Z_OK) {
+    NSUInteger offset = decompressedData.length;
+    decompressedData.length = offset + kGDTCCTInflateChunkSize;
+    stream.next_out = (Bytef *)decompressedData.mutableBytes + offset;
+    stream.avail_out = (uInt)kGDTCCTInflateChunkSize;
+    result = inflate(&stream, Z_NO_FLUSH);
+    decompressedData.length = offset + (kGDTCCTInflateChunkSize - stream.avail_out);
+  }
+  inflateEnd(&stream);
+  return result == Z_STREAM_END ? decompressedData : nil;
+}
+
+@end
@@ -114,11 +114,9 @@ gdt_cct_LogEvent GDTCCTConstructLogEvent(GDTStoredEvent *event) {
   logEvent.has_timezone_offset_seconds = 1;
   // TODO: Read network_connection_info from the custom params dict.
 
-  NSError *error;
-  NSData *extensionBytes = [NSData dataWithContentsOfURL:event.dataFuture.fileURL
-                                                 options:0
-                                                   error:&error];
-  NSCAssert(error == nil, @"There was an error reading extension bytes from disk: %@", error);
+  NSData *extensionBytes = event.dataFuture.data;
+  NSCAssert(extensionBytes, @"There was an error reading extension bytes from disk: %@",
+            event.dataFuture.fileURL);
   logEvent.source_extension = GDTCCTEncodeData(extensionBytes);  // read bytes from the file.
   return logEvent;
 }
@@ -23,6 +23,12 @@
 
 const static int64_t kMillisPerDay = 8.64e+7;
 
+/** The default maximum number of events in an upload package. */
+const static NSUInteger kGDTCCTDefaultMaxEventsPerPackage = 500;
+
+/** The default maximum number of bytes of event data in an upload package. */
+const static unsigned long long kGDTCCTDefaultMaxBytesPerPackage = 512 * 1024;
+
 @implementation GDTCCTPrioritizer
 
 + (void)load {
@@ -44,6 +50,8 @@ const static int64_t kMillisPerDay = 8.64e+7;
   if (self) {
     _queue = dispatch_queue_create("com.google.GDTCCTPrioritizer", DISPATCH_QUEUE_SERIAL);
     _events = [[NSMutableSet alloc] init];
+    _maxEventsPerPackage = kGDTCCTDefaultMaxEventsPerPackage;
+    _maxBytesPerPackage = kGDTCCTDefaultMaxBytesPerPackage;
   }
   return self;
 }
@@ -62,7 +70,7 @@ const static int64_t kMillisPerDay = 8.64e+7;
     NSSet<GDTStoredEvent *> *logEventsThatWillBeSent;
     // A high priority event effectively flushes all events to be sent.
     if ((conditions & GDTUploadConditionHighPriority) == GDTUploadConditionHighPriority) {
-      package.events = self.events;
+      package.events = [self eventsFittingInPackage:self.events];
       return;
     }
 
@@ -86,7 +94,7 @@ const static int64_t kMillisPerDay = 8.64e+7;
       logEventsThatWillBeSent =
           [logEventsThatWillBeSent setByAddingObjectsFromSet:[self logEventsOkToSendDaily]];
     }
-    package.events = logEventsThatWillBeSent;
+    package.events = [self eventsFittingInPackage:logEventsThatWillBeSent];
   });
   return package;
 }
@@ -170,6 +178,59 @@ NSNumber *GDTCCTQosTierFromGDTEventQosTier(GDTEventQoS qosTier) {
       }];
 }
 
+/** Returns the number of bytes of data of the event.
+ *
+ * @param event The event.
+ * @return The number of bytes of data of the event.
+ */
+FOUNDATION_STATIC_INLINE
+unsigned long long GDTCCTEventDataLength(GDTStoredEvent *event) {
+  GDTDataFuture *dataFuture = event.dataFuture;
+  if (dataFuture.originalData) {
+    return dataFuture.originalData.length;
+  }
+  if (dataFuture.byteRange.location != NSNotFound) {
+    return dataFuture.byteRange.length;
+  }
+  NSDictionary *attributes =
+      [[NSFileManager defaultManager] attributesOfItemAtPath:dataFuture.fileURL.path error:nil];
+  return attributes.fileSize;
+}
+
+/** Returns the oldest of the given events that fit in an upload package.
+ *
+ * @note This should be called from a thread safe method.
+ * @param events The events that are ok to upload.
+ * @return The events to upload in the package.
+ */
+- (NSSet<GDTStoredEvent *> *)eventsFittingInPackage:(NSSet<GDTStoredEvent *> *)events {
+  if (events.count <= 1) {
+    return [events copy];
+  }
+  NSArray<GDTStoredEvent *> *sortedEvents = [events.allObjects
+      sortedArrayUsingComparator:^NSComparisonResult(GDTStoredEvent *event1,
+                                                     GDTStoredEvent *event2) {
+        int64_t time1 = event1.clockSnapshot.timeMillis;
+        int64_t time2 = event2.clockSnapshot.timeMillis;
+        return time1 < time2 ? NSOrderedAscending
+                             : (time1 > time2 ? NSOrderedDescending : NSOrderedSame);
+      }];
+  NSMutableSet<GDTStoredEvent *> *packageEvents = [[NSMutableSet alloc] init];
+  unsigned long long packageBytes = 0;
+  for (GDTStoredEvent *event in sortedEvents) {
+    if (packageEvents.count >= self.maxEventsPerPackage) {
+      break;
+    }
+    unsigned long long eventBytes = GDTCCTEventDataLength(event);
+    if (packageEvents.count > 0 && packageBytes + eventBytes > self.maxBytesPerPackage) {
+      break;
+    }
+    [packageEvents addObject:event];
+    packageBytes += eventBytes;
+  }
+  return packageEvents;
+}
+
 #pragma mark - GDTUploadPackageProtocol
 
 - (void)packageDelivered:(GDTUploadPackage *)package successful:(BOOL)successful {
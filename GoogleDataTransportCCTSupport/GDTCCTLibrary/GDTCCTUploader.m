@@ -23,6 +23,7 @@
 #import <nanopb/pb_decode.h>
 #import <nanopb/pb_encode.h>
 
+#import "GDTCCTLibrary/Private/GDTCCTCompressionHelper.h"
 #import "GDTCCTLibrary/Private/GDTCCTNanopbHelpers.h"
 #import "GDTCCTLibrary/Private/GDTCCTPrioritizer.h"
 
@@ -115,6 +116,11 @@
         };
     self->_currentUploadPackage = package;
     NSData *requestProtoData = [self constructRequestProtoFromPackage:(GDTUploadPackage *)package];
+    NSData *gzippedData = [GDTCCTCompressionHelper gzippedData:requestProtoData];
+    if (gzippedData && gzippedData.length < requestProtoData.length) {
+      [request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+      requestProtoData = gzippedData;
+    }
     self.currentTask = [self.uploaderSession uploadTaskWithRequest:request
                                                           fromData:requestProtoData
                                                  completionHandler:completionHandler];
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** Compresses and decompresses the payloads uploaded to the CCT backend. */
+@interface GDTCCTCompressionHelper : NSObject
+
+/** Compresses the given data with gzip.
+ *
+ * @param data The data to compress.
+ * @return The gzip-compressed data, or nil if it couldn't be compressed.
+ */
++ (nullable NSData *)gzippedData:(NSData *)data;
+
+/** Decompresses the given gzip-compressed data.
+ *
+ * @param data The data to decompress.
+ * @return The decompressed data, or nil if it isn't valid gzip-compressed data.
+ */
++ (nullable NSData *)gunzippedData:(NSData *)data;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -33,6 +33,14 @@ NS_ASSUME_NONNULL_BEGIN
 /** The most recent attempted upload of daily uploaded logs. */
 @property(nonatomic) GDTClock *timeOfLastDailyUpload;
 
+/** The maximum number of events in an upload package. The oldest events are sent first. */
+@property(nonatomic) NSUInteger maxEventsPerPackage;
+
+/** The maximum number of bytes of event data in an upload package, before compression. A package
+ * always includes at least one event, even if its data is larger.
+ */
+@property(nonatomic) unsigned long long maxBytesPerPackage;
+
 /** Creates and/or returns the singleton instance of this class.
  *
  * @return The singleton instance of this class.
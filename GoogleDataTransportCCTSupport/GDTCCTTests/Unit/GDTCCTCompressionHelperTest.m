@@ -0,0 +1,59 @@
+/*
+ * Copyright 2019 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "GDTCCTLibrary/Private/GDTCCTCompressionHelper.h"
+
+@interface GDTCCTCompressionHelperTest : XCTestCase
+
+@end
+
+@implementation GDTCCTCompressionHelperTest
+
+/** Tests that compressed data decompresses to the original data. */
+- (void)testCompressionRoundTrips {
+  NSMutableData *data = [[NSMutableData alloc] init];
+  for (int i = 0; i < 10000; i++) {
+    [data appendData:[[NSString stringWithFormat:@"event %d;", i % 100]
+                         dataUsingEncoding:NSUTF8StringEncoding]];
+  }
+  NSData *gzippedData = [GDTCCTCompressionHelper gzippedData:data];
+  XCTAssertNotNil(gzippedData);
+  XCTAssertLessThan(gzippedData.length, data.length);
+
+  // gzip streams start with the bytes 0x1f 0x8b.
+  const uint8_t *bytes = gzippedData.bytes;
+  XCTAssertEqual(bytes[0], 0x1f);
+  XCTAssertEqual(bytes[1], 0x8b);
+
+  XCTAssertEqualObjects([GDTCCTCompressionHelper gunzippedData:gzippedData], data);
+}
+
+/** Tests compressing empty data. */
+- (void)testCompressingEmptyData {
+  NSData *gzippedData = [GDTCCTCompressionHelper gzippedData:[NSData data]];
+  XCTAssertNotNil(gzippedData);
+  XCTAssertEqualObjects([GDTCCTCompressionHelper gunzippedData:gzippedData], [NSData data]);
+}
+
+/** Tests that data that isn't gzip-compressed isn't decompressed. */
+- (void)testDecompressingInvalidData {
+  NSData *data = [@"not gzip" dataUsingEncoding:NSUTF8StringEncoding];
+  XCTAssertNil([GDTCCTCompressionHelper gunzippedData:data]);
+}
+
+@end
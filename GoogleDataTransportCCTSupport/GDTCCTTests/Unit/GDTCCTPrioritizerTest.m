@@ -137,4 +137,33 @@
   XCTAssertTrue([package.events containsObject:telemetryEvent]);
 }
 
+/** Tests that upload packages are bounded by event count and bytes, oldest events first. */
+- (void)testPackagesAreBounded {
+  GDTCCTPrioritizer *prioritizer = [[GDTCCTPrioritizer alloc] init];
+  NSMutableArray<GDTStoredEvent *> *events = [[NSMutableArray alloc] init];
+  for (int i = 0; i < 5; i++) {
+    GDTStoredEvent *event = [_generator generateStoredEvent:GDTEventQosDefault];
+    [event.clockSnapshot setValue:@(1000 + i) forKeyPath:@"timeMillis"];
+    [[NSData dataWithBytes:"0123456789" length:10] writeToURL:event.dataFuture.fileURL
+                                                   atomically:YES];
+    [events addObject:event];
+    [prioritizer prioritizeEvent:event];
+  }
+
+  prioritizer.maxEventsPerPackage = 3;
+  GDTUploadPackage *package = [prioritizer uploadPackageWithConditions:GDTUploadConditionWifiData];
+  NSArray<GDTStoredEvent *> *oldestEvents = [events subarrayWithRange:NSMakeRange(0, 3)];
+  XCTAssertEqualObjects(package.events, [NSSet setWithArray:oldestEvents]);
+
+  prioritizer.maxBytesPerPackage = 25;
+  package = [prioritizer uploadPackageWithConditions:GDTUploadConditionHighPriority];
+  oldestEvents = [events subarrayWithRange:NSMakeRange(0, 2)];
+  XCTAssertEqualObjects(package.events, [NSSet setWithArray:oldestEvents]);
+
+  // An event larger than the limit is still sent on its own.
+  prioritizer.maxBytesPerPackage = 5;
+  package = [prioritizer uploadPackageWithConditions:GDTUploadConditionWifiData];
+  XCTAssertEqualObjects(package.events, [NSSet setWithObject:events[0]]);
+}
+
 @end